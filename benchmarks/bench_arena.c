@@ -0,0 +1,82 @@
+/**
+ * @file bench_arena.c
+ * @brief Benchmark for heap vs arena allocation of parsed Patient resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Parses the same Patient document repeatedly, either through the heap
+ * (fhir_patient_parse + fhir_patient_destroy) or through an arena
+ * (fhir_patient_parse_with_arena, with one fhir_arena_reset per batch), and
+ * reports throughput and fhir_* allocation counts. cJSON allocations are the
+ * same in both modes and are not included in the counts.
+ *
+ * Build and run from the project root:
+ *   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -Isrc/fast_fhir/ext \
+ *      $(python3-config --includes) benchmarks/bench_arena.c \
+ *      src/fast_fhir/ext/resources/fhir_patient.c \
+ *      src/fast_fhir/ext/common/fhir_resource_base.c \
+ *      src/fast_fhir/ext/common/fhir_common.c \
+ *      -lcjson -o bench_arena && ./bench_arena
+ */
+
+#include "common/fhir_common.h"
+#include "resources/fhir_patient.h"
+#include <stdio.h>
+#include <time.h>
+
+#define ITERATIONS 100000
+#define BATCH_SIZE 1000
+
+static const char* g_patient_json =
+    "{\"resourceType\": \"Patient\", \"id\": \"bench-patient\", \"active\": true,"
+    " \"gender\": \"female\", \"birthDate\": \"1974-12-25\","
+    " \"deceasedDateTime\": \"2015-02-14T13:42:00+10:00\","
+    " \"identifier\": [{\"system\": \"urn:oid:1.2.36.146.595.217.0.1\", \"value\": \"12345\"},"
+    "                  {\"system\": \"urn:mrn\", \"value\": \"MRN-0001\"}]}";
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double bench_heap(void) {
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        FHIRPatient* patient = fhir_patient_parse(g_patient_json);
+        fhir_patient_destroy(patient);
+    }
+    return (now_ns() - start) / ITERATIONS;
+}
+
+static double bench_arena(FHIRArenaStats* batch_stats) {
+    FHIRArena* arena = fhir_arena_create(0);
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        fhir_patient_parse_with_arena(arena, g_patient_json);
+        if ((i + 1) % BATCH_SIZE == 0) {
+            fhir_arena_get_stats(arena, batch_stats);
+            fhir_arena_reset(arena);
+        }
+    }
+    double elapsed = (now_ns() - start) / ITERATIONS;
+    fhir_arena_destroy(arena);
+    return elapsed;
+}
+
+int main(void) {
+    FHIRArenaStats stats;
+    double heap_ns = bench_heap();
+    double arena_ns = bench_arena(&stats);
+
+    size_t per_resource = stats.allocation_count / BATCH_SIZE;
+    printf("%-8s %14s %16s %18s\n", "mode", "ns/resource", "resources/s", "malloc+free/batch");
+    printf("%-8s %14.1f %16.0f %18zu\n", "heap", heap_ns, 1e9 / heap_ns,
+           per_resource * BATCH_SIZE * 2);
+    printf("%-8s %14.1f %16.0f %18zu\n", "arena", arena_ns, 1e9 / arena_ns,
+           stats.block_count * 2);
+    printf("\nfhir_* allocations per resource: %zu; arena bytes per batch of %d: %zu\n",
+           per_resource, BATCH_SIZE, stats.bytes_used);
+    printf("speedup: %.2fx\n", heap_ns / arena_ns);
+    return 0;
+}
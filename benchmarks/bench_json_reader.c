@@ -0,0 +1,202 @@
+/**
+ * @file bench_json_reader.c
+ * @brief Throughput of the JSON parser backends in common/fhir_json_reader.c
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Parses every line of an NDJSON file (or a synthetic Bulk Data export of
+ * Observations and Patients when no file is given) with each supported
+ * backend and reports GB/s for stage 1 alone (structural index) and for the
+ * full parse into cJSON trees, next to cJSON_ParseWithLength.
+ *
+ * Build and run from the project root:
+ *   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -Isrc/fast_fhir/ext \
+ *      benchmarks/bench_json_reader.c src/fast_fhir/ext/common/fhir_json_reader.c \
+ *      src/fast_fhir/ext/common/fhir_common.c \
+ *      -lcjson -lpthread -o bench_json_reader && ./bench_json_reader [file.ndjson]
+ */
+
+#include "common/fhir_json_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SYNTHETIC_LINES 20000
+#define MIN_BYTES (64u * 1024u * 1024u)
+
+typedef struct {
+    char* text;
+    size_t length;
+    size_t* starts;
+    size_t line_count;
+    size_t max_line;
+} Corpus;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bool append(Corpus* corpus, size_t* capacity, const char* line, size_t length) {
+    if (corpus->length + length + 1 > *capacity) {
+        size_t new_capacity = (*capacity ? *capacity : 1 << 20);
+        while (corpus->length + length + 1 > new_capacity) new_capacity *= 2;
+        char* text = realloc(corpus->text, new_capacity);
+        if (!text) return false;
+        corpus->text = text;
+        *capacity = new_capacity;
+    }
+    memcpy(corpus->text + corpus->length, line, length);
+    corpus->length += length;
+    corpus->text[corpus->length++] = '\n';
+    return true;
+}
+
+static bool build_synthetic(Corpus* corpus) {
+    size_t capacity = 0;
+    char line[1024];
+    for (int i = 0; i < SYNTHETIC_LINES; i++) {
+        int length;
+        if (i % 4 == 0) {
+            length = snprintf(line, sizeof(line),
+                "{\"resourceType\":\"Patient\",\"id\":\"pat-%d\",\"meta\":{\"lastUpdated\":\"2024-01-01T00:00:00Z\"},"
+                "\"identifier\":[{\"system\":\"urn:oid:1.2.36.146.595.217.0.1\",\"value\":\"MRN%08d\"}],"
+                "\"active\":true,\"name\":[{\"use\":\"official\",\"family\":\"Family%d\",\"given\":[\"Given\",\"M\"]}],"
+                "\"gender\":\"%s\",\"birthDate\":\"19%02d-0%d-1%d\",\"address\":[{\"line\":[\"%d Main St\"],"
+                "\"city\":\"Springfield\",\"postalCode\":\"%05d\"}]}",
+                i, i, i % 500, i % 2 ? "female" : "male", i % 100, 1 + i % 9, i % 10, i, i % 99999);
+        } else {
+            length = snprintf(line, sizeof(line),
+                "{\"resourceType\":\"Observation\",\"id\":\"obs-%d\",\"status\":\"final\","
+                "\"category\":[{\"coding\":[{\"system\":\"http://terminology.hl7.org/CodeSystem/observation-category\","
+                "\"code\":\"vital-signs\"}]}],\"code\":{\"coding\":[{\"system\":\"http://loinc.org\",\"code\":\"8867-4\","
+                "\"display\":\"Heart rate\"}],\"text\":\"Heart \\\"rate\\\"\"},\"subject\":{\"reference\":\"Patient/pat-%d\"},"
+                "\"effectiveDateTime\":\"2024-0%d-1%dT10:%02d:00Z\",\"valueQuantity\":{\"value\":%d.%d,"
+                "\"unit\":\"beats/minute\",\"system\":\"http://unitsofmeasure.org\",\"code\":\"/min\"}}",
+                i, i - i % 4, 1 + i % 9, i % 10, i % 60, 50 + i % 70, i % 10);
+        }
+        if (!append(corpus, &capacity, line, (size_t)length)) return false;
+    }
+    return true;
+}
+
+static bool load_file(Corpus* corpus, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    size_t capacity = 0;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    bool ok = true;
+    while (ok && (length = getline(&line, &line_capacity, file)) != -1) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+        if (length > 0) ok = append(corpus, &capacity, line, (size_t)length);
+    }
+    free(line);
+    fclose(file);
+    return ok && corpus->length > 0;
+}
+
+static bool index_lines(Corpus* corpus) {
+    size_t count = 0;
+    for (size_t i = 0; i < corpus->length; i++) {
+        if (corpus->text[i] == '\n') count++;
+    }
+    corpus->starts = malloc((count + 1) * sizeof(size_t));
+    if (!corpus->starts) return false;
+
+    size_t start = 0;
+    for (size_t i = 0; i < corpus->length; i++) {
+        if (corpus->text[i] != '\n') continue;
+        corpus->starts[corpus->line_count++] = start;
+        if (i - start > corpus->max_line) corpus->max_line = i - start;
+        start = i + 1;
+    }
+    corpus->starts[corpus->line_count] = corpus->length;
+    return true;
+}
+
+static size_t line_length(const Corpus* corpus, size_t line) {
+    return corpus->starts[line + 1] - corpus->starts[line] - 1;
+}
+
+/* ========================================================================== */
+/* Benchmark Driver                                                           */
+/* ========================================================================== */
+
+static double bench_stage1(const Corpus* corpus, FHIRJSONBackend backend, size_t passes, uint32_t* index) {
+    size_t capacity = corpus->max_line + 64;
+    size_t total = 0;
+    double start = now_ns();
+    for (size_t pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < corpus->line_count; i++) {
+            size_t count = 0;
+            fhir_json_structural_index(backend, corpus->text + corpus->starts[i],
+                                       line_length(corpus, i), index, capacity, &count);
+            total += count;
+        }
+    }
+    double elapsed = now_ns() - start;
+    if (total == 0) printf("(empty index)\n");
+    return elapsed;
+}
+
+static double bench_parse(const Corpus* corpus, FHIRJSONBackend backend, size_t passes, size_t* failures) {
+    *failures = 0;
+    double start = now_ns();
+    for (size_t pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < corpus->line_count; i++) {
+            cJSON* json = fhir_json_parse_with_backend(backend, corpus->text + corpus->starts[i],
+                                                       line_length(corpus, i));
+            if (!json) (*failures)++;
+            cJSON_Delete(json);
+        }
+    }
+    return now_ns() - start;
+}
+
+int main(int argc, char** argv) {
+    Corpus corpus = {0};
+    bool loaded = argc > 1 ? load_file(&corpus, argv[1]) : build_synthetic(&corpus);
+    if (!loaded || !index_lines(&corpus)) {
+        fprintf(stderr, "failed to load %s\n", argc > 1 ? argv[1] : "synthetic corpus");
+        return 1;
+    }
+
+    size_t json_bytes = corpus.length - corpus.line_count;
+    size_t passes = MIN_BYTES / json_bytes + 1;
+    uint32_t* index = malloc((corpus.max_line + 64) * sizeof(uint32_t));
+    if (!index) return 1;
+
+    printf("%zu lines, %.1f MB per pass, %zu passes; selected backend: %s\n\n",
+           corpus.line_count, json_bytes / 1e6, passes, fhir_json_backend_name(fhir_json_get_backend()));
+    printf("%-8s %14s %14s %12s %10s\n", "backend", "stage1 GB/s", "parse GB/s", "docs/s", "failures");
+
+    double cjson_ns = 0.0;
+    for (int b = FHIR_JSON_BACKEND_CJSON; b < FHIR_JSON_BACKEND_COUNT; b++) {
+        FHIRJSONBackend backend = (FHIRJSONBackend)b;
+        if (!fhir_json_backend_supported(backend)) continue;
+
+        size_t failures;
+        double parse_ns = bench_parse(&corpus, backend, passes, &failures);
+        double bytes = (double)json_bytes * (double)passes;
+        double docs = (double)corpus.line_count * (double)passes;
+        if (backend == FHIR_JSON_BACKEND_CJSON) {
+            cjson_ns = parse_ns;
+            printf("%-8s %14s %14.2f %12.0f %10zu\n", fhir_json_backend_name(backend), "-",
+                   bytes / parse_ns, docs * 1e9 / parse_ns, failures);
+        } else {
+            double stage1_ns = bench_stage1(&corpus, backend, passes, index);
+            printf("%-8s %14.2f %14.2f %12.0f %10zu   (%.2fx cjson)\n", fhir_json_backend_name(backend),
+                   bytes / stage1_ns, bytes / parse_ns, docs * 1e9 / parse_ns, failures,
+                   cjson_ns / parse_ns);
+        }
+    }
+
+    free(index);
+    free(corpus.starts);
+    free(corpus.text);
+    return 0;
+}
@@ -0,0 +1,649 @@
+/**
+ * @file bench_suite.c
+ * @brief Native microbenchmarks of the C hot paths with baseline comparison
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Times validators, Patient from_json/to_json/write_json, validation,
+ * Bundle parsing, registry dispatch, clone, equals and hashing directly in
+ * C, over a generated corpus shaped like Synthea output (identifiers with
+ * type codings, US Core extensions, names, telecom, geolocated addresses),
+ * so interpreter overhead does not hide the C-level costs.
+ *
+ * Each case reports the median ns/op of several timed samples, plus the
+ * allocations and bytes per op from a separate counting pass: fhir_*
+ * allocations come from the allocation accounting in fhir_common (heap and
+ * arena allocations on every thread), cJSON allocations are counted through
+ * cJSON_InitHooks. Allocation counts are
+ * deterministic, so any increase is reported as a regression; times are
+ * compared with a tolerance.
+ *
+ * Usage:
+ *   bench_suite [--json results.json] [--baseline baseline.json]
+ *               [--tolerance percent] [--corpus resources]
+ *               [--min-time-ms ms] [--filter substring]
+ *
+ * Store a baseline with --json and pass it as --baseline on a later run;
+ * the exit status is 1 if any case regressed. The CMake target is
+ * bench_suite (run with `make benchmark_c`); to build by hand from the
+ * project root:
+ *   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -Isrc/fast_fhir/ext \
+ *      -Isrc/fast_fhir/ext/common $(python3-config --includes) benchmarks/bench_suite.c \
+ *      src/fast_fhir/ext/fhir_bundle_parallel.c src/fast_fhir/ext/resources/fhir_patient.c \
+ *      src/fast_fhir/ext/common/fhir_common.c src/fast_fhir/ext/common/fhir_resource_base.c \
+ *      src/fast_fhir/ext/common/fhir_json_writer.c src/fast_fhir/ext/common/fhir_json_reader.c \
+ *      src/fast_fhir/ext/common/fhir_base64.c src/fast_fhir/ext/common/fhir_hash.c \
+ *      src/fast_fhir/ext/common/fhir_binary.c src/fast_fhir/ext/fhir_datatypes.c \
+ *      -lcjson -lpthread -lm -o bench_suite && ./bench_suite
+ */
+
+#include "common/fhir_common.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_json_writer.h"
+#include "fhir_bundle_parallel.h"
+#include "resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_CORPUS_SIZE 1000
+#define DEFAULT_MIN_TIME_MS 300
+#define DEFAULT_TOLERANCE_PERCENT 10.0
+#define SAMPLE_COUNT 5
+
+/* ========================================================================== */
+/* Corpus                                                                     */
+/* ========================================================================== */
+
+typedef struct {
+    char** patient_json;        // One Synthea-style Patient per entry
+    size_t* patient_length;
+    FHIRPatient** patients;     // Parsed and materialized
+    FHIRPatient** clones;       // Equal copies, for equals
+    const char** ids;
+    const char** dates;
+    const char** datetimes;
+    const char** codes;
+    char* bundle_json;          // Collection Bundle of every Patient
+    size_t bundle_length;
+    size_t count;
+    size_t bytes;
+} Corpus;
+
+static const char* const g_given[] = {"Maria", "James", "Aiko", "Olu", "Sven", "Priya", "Luis", "Hana"};
+static const char* const g_family[] = {"Rodriguez", "Smith", "Tanaka", "Adeyemi", "Larsen", "Patel", "Garcia"};
+static const char* const g_city[] = {"Boston", "Worcester", "Springfield", "Lowell", "Cambridge", "Quincy"};
+static const char* const g_resource_names[] = {"Patient", "Observation", "Encounter", "Condition",
+                                               "MedicationRequest", "Procedure", "Practitioner"};
+
+static uint64_t g_seed = 0x9E3779B97F4A7C15ull;
+
+static uint32_t next_random(void) {
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 7;
+    g_seed ^= g_seed << 17;
+    return (uint32_t)(g_seed >> 16);
+}
+
+#define PICK(array) (array[next_random() % (sizeof(array) / sizeof(array[0]))])
+
+static char* synthea_patient(size_t index, size_t* length) {
+    char id[64];
+    snprintf(id, sizeof(id), "%08x-%04x-4%03x-a%03x-%012zx", next_random(), next_random() & 0xFFFF,
+             next_random() & 0xFFF, next_random() & 0xFFF, index);
+    const char* given = PICK(g_given);
+    const char* family = PICK(g_family);
+    bool female = next_random() % 2;
+    int year = 1930 + (int)(next_random() % 90);
+    int month = 1 + (int)(next_random() % 12);
+    int day = 1 + (int)(next_random() % 28);
+    bool deceased = next_random() % 8 == 0;
+    char deceased_member[96] = "";
+    if (deceased) {
+        snprintf(deceased_member, sizeof(deceased_member), "\"deceasedDateTime\":\"%d-%02d-%02dT%02d:%02d:00-05:00\",",
+                 year + 60 + (int)(next_random() % 20), month, day, (int)(next_random() % 24),
+                 (int)(next_random() % 60));
+    }
+
+    char buffer[4096];
+    int written = snprintf(buffer, sizeof(buffer),
+        "{\"resourceType\":\"Patient\",\"id\":\"%s\","
+        "\"meta\":{\"profile\":[\"http://hl7.org/fhir/us/core/StructureDefinition/us-core-patient\"]},"
+        "\"extension\":[{\"url\":\"http://hl7.org/fhir/us/core/StructureDefinition/us-core-birthsex\","
+        "\"valueCode\":\"%s\"},{\"url\":\"http://hl7.org/fhir/StructureDefinition/patient-mothersMaidenName\","
+        "\"valueString\":\"%s\"}],"
+        "\"identifier\":[{\"system\":\"https://github.com/synthetichealth/synthea\",\"value\":\"%s\"},"
+        "{\"type\":{\"coding\":[{\"system\":\"http://terminology.hl7.org/CodeSystem/v2-0203\",\"code\":\"MR\"}]},"
+        "\"system\":\"http://hospital.smarthealthit.org\",\"value\":\"%s\"},"
+        "{\"type\":{\"coding\":[{\"system\":\"http://terminology.hl7.org/CodeSystem/v2-0203\",\"code\":\"SS\"}]},"
+        "\"system\":\"http://hl7.org/fhir/sid/us-ssn\",\"value\":\"999-%02u-%04u\"}],"
+        "\"name\":[{\"use\":\"official\",\"family\":\"%s%zu\",\"given\":[\"%s%zu\"],\"prefix\":[\"%s\"]}],"
+        "\"telecom\":[{\"system\":\"phone\",\"value\":\"555-%03u-%04u\",\"use\":\"home\"}],"
+        "\"gender\":\"%s\",\"birthDate\":\"%d-%02d-%02d\",%s"
+        "\"address\":[{\"extension\":[{\"url\":\"http://hl7.org/fhir/StructureDefinition/geolocation\","
+        "\"extension\":[{\"url\":\"latitude\",\"valueDecimal\":42.%06u},{\"url\":\"longitude\",\"valueDecimal\":-71.%06u}]}],"
+        "\"line\":[\"%u %s Street\"],\"city\":\"%s\",\"state\":\"MA\",\"postalCode\":\"0%04u\",\"country\":\"US\"}],"
+        "\"maritalStatus\":{\"coding\":[{\"system\":\"http://terminology.hl7.org/CodeSystem/v3-MaritalStatus\","
+        "\"code\":\"M\"}],\"text\":\"M\"},\"multipleBirthBoolean\":false,"
+        "\"communication\":[{\"language\":{\"coding\":[{\"system\":\"urn:ietf:bcp:47\",\"code\":\"en-US\"}]}}]}",
+        id, female ? "F" : "M", PICK(g_family), id, id, next_random() % 100, next_random() % 10000,
+        family, index % 1000, given, index % 1000, female ? "Mrs." : "Mr.", next_random() % 1000,
+        next_random() % 10000, female ? "female" : "male", year, month, day, deceased_member,
+        next_random() % 1000000, next_random() % 1000000, 1 + next_random() % 999, PICK(g_family),
+        PICK(g_city), next_random() % 10000);
+    if (written < 0 || (size_t)written >= sizeof(buffer)) {
+        return NULL;
+    }
+    *length = (size_t)written;
+    return fhir_strdup(buffer);
+}
+
+static bool build_corpus(Corpus* corpus, size_t count) {
+    memset(corpus, 0, sizeof(*corpus));
+    corpus->count = count;
+    corpus->patient_json = fhir_calloc(count, sizeof(char*));
+    corpus->patient_length = fhir_calloc(count, sizeof(size_t));
+    corpus->patients = fhir_calloc(count, sizeof(FHIRPatient*));
+    corpus->clones = fhir_calloc(count, sizeof(FHIRPatient*));
+    corpus->ids = fhir_calloc(count, sizeof(char*));
+    corpus->dates = fhir_calloc(count, sizeof(char*));
+    corpus->datetimes = fhir_calloc(count, sizeof(char*));
+    corpus->codes = fhir_calloc(count, sizeof(char*));
+    if (!corpus->patient_json || !corpus->patient_length || !corpus->patients || !corpus->clones ||
+        !corpus->ids || !corpus->dates || !corpus->datetimes || !corpus->codes) {
+        return false;
+    }
+
+    static const char* const datetimes[] = {"2015-02-07T13:28:17-05:00", "2023-11-30T08:00:00Z",
+                                            "2019-06-01T23:59:59.123+02:00", "2001-01-01T00:00:00Z"};
+    static const char* const codes[] = {"final", "amended", "entered-in-error", "in progress"};
+    size_t capacity = 0;
+    for (size_t i = 0; i < count; i++) {
+        corpus->patient_json[i] = synthea_patient(i, &corpus->patient_length[i]);
+        if (!corpus->patient_json[i]) return false;
+        corpus->bytes += corpus->patient_length[i];
+        capacity += corpus->patient_length[i] + 64;
+
+        // Materialize every lazy field up front, so timed and counted passes
+        // never allocate into the shared corpus
+        FHIRPatient* patient = fhir_patient_parse(corpus->patient_json[i]);
+        FHIRWriter writer;
+        if (!patient || !fhir_writer_init_buffer(&writer, 0)) return false;
+        bool written = fhir_patient_write_json(patient, &writer);
+        fhir_writer_cleanup(&writer);
+        corpus->patients[i] = patient;
+        corpus->clones[i] = fhir_patient_clone(patient);
+        if (!written || !corpus->clones[i]) return false;
+
+        corpus->ids[i] = patient->base.id;
+        corpus->dates[i] = patient->birth_date ? patient->birth_date->value : "1970-01-01";
+        corpus->datetimes[i] = datetimes[i % 4];
+        corpus->codes[i] = codes[i % 4];
+    }
+
+    static const char prefix[] = "{\"resourceType\":\"Bundle\",\"type\":\"collection\",\"entry\":[";
+    corpus->bundle_json = fhir_malloc(capacity + sizeof(prefix) + 4);
+    if (!corpus->bundle_json) return false;
+    size_t length = 0;
+    memcpy(corpus->bundle_json, prefix, sizeof(prefix) - 1);
+    length = sizeof(prefix) - 1;
+    for (size_t i = 0; i < count; i++) {
+        length += (size_t)sprintf(corpus->bundle_json + length, "%s{\"resource\":%s}", i ? "," : "",
+                                  corpus->patient_json[i]);
+    }
+    length += (size_t)sprintf(corpus->bundle_json + length, "]}");
+    corpus->bundle_length = length;
+    return true;
+}
+
+static void free_corpus(Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        if (corpus->patient_json) fhir_free(corpus->patient_json[i]);
+        if (corpus->patients) fhir_patient_destroy(corpus->patients[i]);
+        if (corpus->clones) fhir_patient_destroy(corpus->clones[i]);
+    }
+    fhir_free(corpus->patient_json);
+    fhir_free(corpus->patient_length);
+    fhir_free(corpus->patients);
+    fhir_free(corpus->clones);
+    fhir_free(corpus->ids);
+    fhir_free(corpus->dates);
+    fhir_free(corpus->datetimes);
+    fhir_free(corpus->codes);
+    fhir_free(corpus->bundle_json);
+}
+
+/* ========================================================================== */
+/* Cases                                                                      */
+/* ========================================================================== */
+
+// One pass over the corpus; returns the number of ops performed
+typedef size_t (*BenchPass)(const Corpus* corpus);
+
+typedef struct {
+    const char* name;
+    BenchPass pass;
+} BenchCase;
+
+static volatile size_t g_sink;
+
+// Allocation counters of the counting pass
+static bool g_counting;
+static size_t g_cjson_allocations;
+static size_t g_cjson_bytes;
+
+static size_t pass_validate_id(const Corpus* corpus) {
+    size_t valid = 0;
+    for (size_t i = 0; i < corpus->count; i++) valid += fhir_validate_id(corpus->ids[i]);
+    g_sink += valid;
+    return corpus->count;
+}
+
+static size_t pass_validate_date(const Corpus* corpus) {
+    size_t valid = 0;
+    for (size_t i = 0; i < corpus->count; i++) valid += fhir_validate_date(corpus->dates[i]);
+    g_sink += valid;
+    return corpus->count;
+}
+
+static size_t pass_validate_datetime(const Corpus* corpus) {
+    size_t valid = 0;
+    for (size_t i = 0; i < corpus->count; i++) valid += fhir_validate_datetime(corpus->datetimes[i]);
+    g_sink += valid;
+    return corpus->count;
+}
+
+static size_t pass_validate_code(const Corpus* corpus) {
+    size_t valid = 0;
+    for (size_t i = 0; i < corpus->count; i++) valid += fhir_validate_code(corpus->codes[i]);
+    g_sink += valid;
+    return corpus->count;
+}
+
+static size_t pass_patient_from_json(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        FHIRPatient* patient = fhir_patient_parse(corpus->patient_json[i]);
+        g_sink += patient != NULL;
+        fhir_patient_destroy(patient);
+    }
+    return corpus->count;
+}
+
+static size_t pass_patient_to_json(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        cJSON* json = fhir_patient_to_json(corpus->patients[i]);
+        g_sink += json != NULL;
+        cJSON_Delete(json);
+    }
+    return corpus->count;
+}
+
+static size_t pass_patient_write_json(const Corpus* corpus) {
+    FHIRWriter writer;
+    if (!fhir_writer_init_buffer(&writer, 0)) return 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        fhir_writer_reset(&writer);
+        g_sink += fhir_patient_write_json(corpus->patients[i], &writer);
+    }
+    fhir_writer_cleanup(&writer);
+    return corpus->count;
+}
+
+static size_t pass_patient_validate(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        fhir_resource_invalidate_validation(&corpus->patients[i]->base);
+        g_sink += fhir_resource_validate(&corpus->patients[i]->base);
+    }
+    return corpus->count;
+}
+
+static size_t pass_bundle_parse(const Corpus* corpus) {
+    cJSON* json = fhir_json_parse(corpus->bundle_json, corpus->bundle_length);
+    FHIRParallelBundle* bundle = json ? fhir_parse_bundle_parallel(json, 1) : NULL;
+    size_t entries = bundle ? bundle->entry_count : 0;
+
+    fhir_parallel_bundle_free(bundle);
+    cJSON_Delete(json);
+    return entries;
+}
+
+static size_t pass_registry_lookup(const Corpus* corpus) {
+    size_t count = sizeof(g_resource_names) / sizeof(g_resource_names[0]);
+    for (size_t i = 0; i < corpus->count; i++) {
+        g_sink += (size_t)fhir_resource_type_from_string(g_resource_names[i % count]);
+    }
+    return corpus->count;
+}
+
+static size_t pass_registry_create(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        FHIRResourceBase* resource = fhir_resource_create_by_type(FHIR_RESOURCE_TYPE_PATIENT, corpus->ids[i]);
+        g_sink += resource != NULL;
+        fhir_resource_release(resource);
+    }
+    return corpus->count;
+}
+
+static size_t pass_patient_clone(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        FHIRResourceBase* clone = fhir_resource_clone(&corpus->patients[i]->base);
+        g_sink += clone != NULL;
+        fhir_resource_release(clone);
+    }
+    return corpus->count;
+}
+
+static size_t pass_patient_equals(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        g_sink += fhir_resource_equals(&corpus->patients[i]->base, &corpus->clones[i]->base);
+    }
+    return corpus->count;
+}
+
+static size_t pass_patient_hash(const Corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        g_sink += (size_t)fhir_patient_hash(corpus->patients[i]);
+    }
+    return corpus->count;
+}
+
+static const BenchCase g_cases[] = {
+    {"validate.id", pass_validate_id},
+    {"validate.date", pass_validate_date},
+    {"validate.datetime", pass_validate_datetime},
+    {"validate.code", pass_validate_code},
+    {"patient.from_json", pass_patient_from_json},
+    {"patient.to_json", pass_patient_to_json},
+    {"patient.write_json", pass_patient_write_json},
+    {"patient.validate", pass_patient_validate},
+    {"bundle.parse", pass_bundle_parse},
+    {"registry.type_lookup", pass_registry_lookup},
+    {"registry.create", pass_registry_create},
+    {"patient.clone", pass_patient_clone},
+    {"patient.equals", pass_patient_equals},
+    {"patient.hash", pass_patient_hash},
+};
+
+#define CASE_COUNT (sizeof(g_cases) / sizeof(g_cases[0]))
+
+/* ========================================================================== */
+/* Measurement                                                                */
+/* ========================================================================== */
+
+typedef struct {
+    const char* name;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    size_t ops;                 // Ops timed over all samples
+} BenchResult;
+
+static void* counting_malloc(size_t size) {
+    if (g_counting) {
+        g_cjson_allocations++;
+        g_cjson_bytes += size;
+    }
+    return malloc(size);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static bool measure(const BenchCase* bench, const Corpus* corpus, double min_time_ms, BenchResult* result) {
+    result->name = bench->name;
+    result->ops = 0;
+
+    // Warm caches and the allocator before timing
+    if (bench->pass(corpus) == 0) {
+        return false;
+    }
+
+    double samples[SAMPLE_COUNT];
+    double sample_ns = min_time_ms * 1e6 / SAMPLE_COUNT;
+    for (int s = 0; s < SAMPLE_COUNT; s++) {
+        size_t ops = 0;
+        double start = now_ns();
+        double elapsed;
+        do {
+            ops += bench->pass(corpus);
+            elapsed = now_ns() - start;
+        } while (elapsed < sample_ns);
+        samples[s] = elapsed / (double)ops;
+        result->ops += ops;
+    }
+    qsort(samples, SAMPLE_COUNT, sizeof(double), compare_doubles);
+    result->ns_per_op = samples[SAMPLE_COUNT / 2];
+
+    // Count one pass; heap bytes are the allocator's usable sizes
+    g_cjson_allocations = g_cjson_bytes = 0;
+    fhir_memory_stats_set_enabled(true);
+    fhir_memory_stats_reset();
+    g_counting = true;
+    size_t ops = bench->pass(corpus);
+    g_counting = false;
+    fhir_memory_stats_set_enabled(false);
+
+    FHIRMemoryStats stats;
+    fhir_memory_get_stats(&stats);
+    result->allocs_per_op = (double)(stats.allocations + stats.arena_allocations + g_cjson_allocations) / (double)ops;
+    result->bytes_per_op = (double)(stats.bytes_allocated + g_cjson_bytes) / (double)ops;
+    return true;
+}
+
+/* ========================================================================== */
+/* Reporting                                                                  */
+/* ========================================================================== */
+
+static bool write_results(const char* path, const Corpus* corpus, const BenchResult* results, size_t count) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "bench_suite: cannot write %s\n", path);
+        return false;
+    }
+
+    FHIRWriter writer;
+    bool written = fhir_writer_init_fd(&writer, fileno(file));
+    fhir_writer_begin_object(&writer);
+    fhir_writer_member_string(&writer, "suite", "fast-fhir-c");
+    fhir_writer_key(&writer, "corpus");
+    fhir_writer_begin_object(&writer);
+    fhir_writer_member_int(&writer, "resources", (int64_t)corpus->count);
+    fhir_writer_member_int(&writer, "bytes", (int64_t)corpus->bytes);
+    fhir_writer_end_object(&writer);
+    fhir_writer_key(&writer, "results");
+    fhir_writer_begin_array(&writer);
+    for (size_t i = 0; i < count; i++) {
+        fhir_writer_begin_object(&writer);
+        fhir_writer_member_string(&writer, "name", results[i].name);
+        fhir_writer_key(&writer, "ns_per_op");
+        fhir_writer_double(&writer, results[i].ns_per_op);
+        fhir_writer_key(&writer, "allocs_per_op");
+        fhir_writer_double(&writer, results[i].allocs_per_op);
+        fhir_writer_key(&writer, "bytes_per_op");
+        fhir_writer_double(&writer, results[i].bytes_per_op);
+        fhir_writer_member_int(&writer, "ops", (int64_t)results[i].ops);
+        fhir_writer_end_object(&writer);
+    }
+    fhir_writer_end_array(&writer);
+    fhir_writer_end_object(&writer);
+    written = written && fhir_writer_end_line(&writer) && fhir_writer_finish(&writer);
+    fhir_writer_cleanup(&writer);
+    fclose(file);
+    return written;
+}
+
+static char* read_file(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char* text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (text && fread(text, 1, (size_t)size, file) != (size_t)size) {
+        free(text);
+        text = NULL;
+    }
+    fclose(file);
+    if (text) {
+        text[size] = '\0';
+        *length = (size_t)size;
+    }
+    return text;
+}
+
+static double member_number(const cJSON* object, const char* key) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(object, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : -1;
+}
+
+// Compare against a stored run; returns the number of regressions, or -1
+static int compare_baseline(const char* path, const Corpus* corpus, const BenchResult* results, size_t count,
+                            double tolerance) {
+    size_t length = 0;
+    char* text = read_file(path, &length);
+    cJSON* baseline = text ? fhir_json_parse(text, length) : NULL;
+    free(text);
+    const cJSON* entries = cJSON_GetObjectItemCaseSensitive(baseline, "results");
+    if (!cJSON_IsArray(entries)) {
+        fprintf(stderr, "bench_suite: cannot read baseline %s\n", path);
+        cJSON_Delete(baseline);
+        return -1;
+    }
+
+    // The corpus generator is deterministic, so allocation counts are only
+    // comparable over a corpus of the same size
+    const cJSON* base_corpus = cJSON_GetObjectItemCaseSensitive(baseline, "corpus");
+    bool same_corpus = member_number(base_corpus, "resources") == (double)corpus->count;
+    if (!same_corpus) {
+        printf("\nbaseline corpus differs; comparing times only\n");
+    }
+
+    int regressions = 0;
+    printf("\n%-22s %12s %12s %8s %10s %10s  %s\n", "case", "base ns/op", "ns/op", "change", "base alloc",
+           "allocs", "status");
+    for (size_t i = 0; i < count; i++) {
+        const cJSON* entry = NULL;
+        const cJSON* candidate;
+        cJSON_ArrayForEach(candidate, entries) {
+            const cJSON* name = cJSON_GetObjectItemCaseSensitive(candidate, "name");
+            if (cJSON_IsString(name) && strcmp(name->valuestring, results[i].name) == 0) {
+                entry = candidate;
+                break;
+            }
+        }
+        if (!entry) {
+            printf("%-22s %12s %12.1f %8s %10s %10.1f  new\n", results[i].name, "-", results[i].ns_per_op, "-",
+                   "-", results[i].allocs_per_op);
+            continue;
+        }
+
+        double base_ns = member_number(entry, "ns_per_op");
+        double base_allocs = member_number(entry, "allocs_per_op");
+        double change = base_ns > 0 ? (results[i].ns_per_op / base_ns - 1.0) * 100.0 : 0.0;
+        bool slower = change > tolerance;
+        bool more_allocs = same_corpus && base_allocs >= 0 && results[i].allocs_per_op > base_allocs + 0.01;
+        regressions += slower || more_allocs;
+        printf("%-22s %12.1f %12.1f %+7.1f%% %10.1f %10.1f  %s\n", results[i].name, base_ns,
+               results[i].ns_per_op, change, base_allocs, results[i].allocs_per_op,
+               more_allocs ? "REGRESSION (allocations)" : slower ? "REGRESSION (time)" : "ok");
+    }
+    cJSON_Delete(baseline);
+    return regressions;
+}
+
+/* ========================================================================== */
+/* Driver                                                                     */
+/* ========================================================================== */
+
+static void usage(void) {
+    fprintf(stderr, "usage: bench_suite [--json path] [--baseline path] [--tolerance percent]\n"
+                    "                   [--corpus resources] [--min-time-ms ms] [--filter substring]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    const char* filter = NULL;
+    double tolerance = DEFAULT_TOLERANCE_PERCENT;
+    double min_time_ms = DEFAULT_MIN_TIME_MS;
+    size_t corpus_size = DEFAULT_CORPUS_SIZE;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            usage();
+            return 2;
+        }
+        if (strcmp(argv[i], "--json") == 0) json_path = value;
+        else if (strcmp(argv[i], "--baseline") == 0) baseline_path = value;
+        else if (strcmp(argv[i], "--filter") == 0) filter = value;
+        else if (strcmp(argv[i], "--tolerance") == 0) tolerance = atof(value);
+        else if (strcmp(argv[i], "--min-time-ms") == 0) min_time_ms = atof(value);
+        else if (strcmp(argv[i], "--corpus") == 0) corpus_size = (size_t)strtoul(value, NULL, 10);
+        else {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (corpus_size == 0) {
+        usage();
+        return 2;
+    }
+
+    cJSON_Hooks hooks = {counting_malloc, free};
+    cJSON_InitHooks(&hooks);
+    fhir_patient_register();
+
+    Corpus corpus;
+    if (!build_corpus(&corpus, corpus_size)) {
+        fprintf(stderr, "bench_suite: failed to build the corpus\n");
+        free_corpus(&corpus);
+        return 1;
+    }
+    printf("corpus: %zu Synthea-style Patients, %zu bytes\n\n", corpus.count, corpus.bytes);
+    printf("%-22s %12s %12s %12s\n", "case", "ns/op", "allocs/op", "bytes/op");
+
+    BenchResult results[CASE_COUNT];
+    size_t result_count = 0;
+    int status = 0;
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        if (filter && !strstr(g_cases[i].name, filter)) continue;
+
+        BenchResult* result = &results[result_count];
+        if (!measure(&g_cases[i], &corpus, min_time_ms, result)) {
+            fprintf(stderr, "bench_suite: %s failed\n", g_cases[i].name);
+            status = 1;
+            continue;
+        }
+        printf("%-22s %12.1f %12.1f %12.1f\n", result->name, result->ns_per_op, result->allocs_per_op,
+               result->bytes_per_op);
+        result_count++;
+    }
+
+    if (json_path && !write_results(json_path, &corpus, results, result_count)) {
+        status = 1;
+    }
+    if (baseline_path) {
+        int regressions = compare_baseline(baseline_path, &corpus, results, result_count, tolerance);
+        if (regressions != 0) {
+            status = 1;
+        }
+        if (regressions > 0) {
+            printf("\n%d case(s) regressed beyond %.1f%% or allocate more\n", regressions, tolerance);
+        }
+    }
+
+    free_corpus(&corpus);
+    return status;
+}
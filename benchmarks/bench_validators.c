@@ -0,0 +1,93 @@
+/**
+ * @file bench_validators.c
+ * @brief Microbenchmark for the FHIR primitive validators in common/fhir_common.c
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Compares the per-call cost of the previous POSIX regex validators (compiled
+ * on every call) with the single-pass validators now in fhir_common.c.
+ *
+ * Build and run from the project root:
+ *   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -Isrc/fast_fhir/ext \
+ *      benchmarks/bench_validators.c src/fast_fhir/ext/common/fhir_common.c \
+ *      -lcjson -o bench_validators && ./bench_validators
+ */
+
+#include "common/fhir_common.h"
+#include <regex.h>
+#include <stdio.h>
+#include <time.h>
+
+#define ITERATIONS 200000
+
+/* ========================================================================== */
+/* Previous Regex Validators (before)                                         */
+/* ========================================================================== */
+
+static bool regex_match(const char* pattern, const char* value) {
+    if (fhir_string_is_empty(value)) return false;
+
+    regex_t regex;
+    int result = regcomp(&regex, pattern, REG_EXTENDED);
+    if (result != 0) return false;
+
+    result = regexec(&regex, value, 0, NULL, 0);
+    regfree(&regex);
+
+    return result == 0;
+}
+
+static bool regex_validate_id(const char* id) {
+    return regex_match("^[A-Za-z0-9\\-\\.]{1,64}$", id);
+}
+
+static bool regex_validate_date(const char* date) {
+    return regex_match("^[0-9]{4}-[0-9]{2}-[0-9]{2}$", date);
+}
+
+static bool regex_validate_datetime(const char* datetime) {
+    return regex_match("^[0-9]{4}-[0-9]{2}-[0-9]{2}T[0-9]{2}:[0-9]{2}:[0-9]{2}", datetime);
+}
+
+static bool regex_validate_code(const char* code) {
+    return regex_match("^[^\\s]+(\\s[^\\s]+)*$", code);
+}
+
+/* ========================================================================== */
+/* Benchmark Driver                                                           */
+/* ========================================================================== */
+
+typedef bool (*ValidatorFunc)(const char* value);
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double time_per_call_ns(ValidatorFunc validator, const char* value) {
+    volatile int sink = 0;
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink += validator(value);
+    }
+    (void)sink;
+    return (now_ns() - start) / ITERATIONS;
+}
+
+static void run_case(const char* name, const char* value, ValidatorFunc before, ValidatorFunc after) {
+    double before_ns = time_per_call_ns(before, value);
+    double after_ns = time_per_call_ns(after, value);
+    printf("%-10s %-28s %10.1f ns %10.1f ns %8.1fx\n", name, value, before_ns, after_ns,
+           before_ns / after_ns);
+}
+
+int main(void) {
+    printf("%-10s %-28s %13s %13s %9s\n", "validator", "input", "regex", "single-pass", "speedup");
+    run_case("id", "example-patient.123", regex_validate_id, fhir_validate_id);
+    run_case("date", "1990-01-15", regex_validate_date, fhir_validate_date);
+    run_case("datetime", "2023-01-01T10:30:45.123Z", regex_validate_datetime,
+             fhir_validate_datetime);
+    run_case("code", "in progress", regex_validate_code, fhir_validate_code);
+    return 0;
+}
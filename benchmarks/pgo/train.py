@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+PGO training workload for the optimized build
+
+Replays the bundled corpus (corpus.ndjson: Synthea-shaped Patients with
+Encounters, Observations, Conditions and MedicationRequests, plus a small
+provider directory) through the paths the C extensions serve in
+production: Bulk Data NDJSON batches, Bundle streaming, chunked async
+ingestion, FHIRPath and search index extraction, Patient matching and the
+interval, spatial and directory indexes. scripts/build_pgo.py runs it
+against an instrumented build so profiles reflect a realistic mix of
+resource types rather than a single synthetic one.
+
+Usage: python benchmarks/pgo/train.py [--rounds N] [--threads N]
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, '..', '..')
+
+# In-place extension builds land inside the package
+sys.path.insert(0, os.path.join(ROOT, 'src'))
+
+from fast_fhir import fast_parser
+from fast_fhir.fast_parser import FastFHIRParser
+
+CORPUS = os.path.join(HERE, 'corpus.ndjson')
+
+FHIRPATHS = [
+    "Patient.name.where(use = 'official').family",
+    "Patient.identifier.where(type.coding.code = 'MR').value",
+    "Observation.code.coding.where(system = 'http://loinc.org').code",
+    "Observation.valueQuantity.value",
+    "Encounter.period.start | Condition.onsetDateTime",
+    "subject.reference",
+]
+
+
+def load_corpus():
+    """Read the corpus as raw lines and parsed resources."""
+    with open(CORPUS, 'rb') as handle:
+        lines = [line for line in handle.read().splitlines() if line.strip()]
+    return lines, [json.loads(line) for line in lines]
+
+
+def make_bundle(resources):
+    """Wrap resources in a transaction Bundle."""
+    return json.dumps({
+        'resourceType': 'Bundle',
+        'type': 'transaction',
+        'entry': [{'fullUrl': f"urn:uuid:{resource['id']}",
+                   'resource': resource,
+                   'request': {'method': 'PUT', 'url': f"{resource['resourceType']}/{resource['id']}"}}
+                  for resource in resources],
+    }).encode('utf-8')
+
+
+async def stream_chunks(parser, body, format, chunk_size):
+    """Feed a body in chunks while consuming the parsed resources."""
+    stream = parser.stream_parser(format, threads=2)
+
+    async def produce():
+        for offset in range(0, len(body), chunk_size):
+            await stream.feed(body[offset:offset + chunk_size])
+        await stream.close()
+
+    producer = asyncio.ensure_future(produce())
+    count = sum([1 async for _ in stream])
+    await producer
+    return count
+
+
+def train(rounds, threads):
+    """Run every workload; returns (name, seconds, items) per workload."""
+    parser = FastFHIRParser()
+    lines, resources = load_corpus()
+    ndjson = b'\n'.join(lines) + b'\n'
+    bundle = make_bundle(resources)
+    by_type = {}
+    for resource in resources:
+        by_type.setdefault(resource['resourceType'], []).append(resource)
+    documents = [line.decode('utf-8') for line in lines]
+    directory = [resource for resource in resources if resource['resourceType'] in
+                 ('Organization', 'OrganizationAffiliation', 'Location', 'Practitioner', 'PractitionerRole')]
+
+    workloads = [
+        ('parse_ndjson', lambda: sum(len(batch) for batch, _ in
+                                     parser.parse_ndjson(ndjson, threads=threads, batch_size=256))),
+        ('iter_bundle', lambda: sum(1 for _ in parser.iter_bundle(bundle))),
+        ('parse', lambda: sum(1 for document, resource in zip(documents, resources)
+                              if resource['resourceType'] in parser.RESOURCE_TYPES
+                              and parser.parse(document) is not None)),
+        ('stream_bundle', lambda: asyncio.run(stream_chunks(parser, bundle, 'bundle', 8192))),
+        ('stream_ndjson', lambda: asyncio.run(stream_chunks(parser, ndjson, 'ndjson', 8192))),
+        ('evaluate_paths', lambda: len(parser.evaluate_paths(FHIRPATHS, documents))),
+        ('extract_search_index', lambda: sum(len(parser.extract_search_index(document))
+                                             for document in documents)),
+        ('interval_index', lambda: len(parser.build_interval_index(by_type['Encounter']))),
+        ('spatial_index', lambda: len(parser.build_spatial_index(by_type['Location']))),
+        ('directory_index', lambda: len(parser.build_directory_index(directory)
+                                        .find_practitioners(organization='Organization/org-0001',
+                                                            include_children=True))),
+    ]
+    if fast_parser.HAS_C_MATCH:
+        workloads.append(('find_duplicate_patients',
+                          lambda: len(parser.find_duplicate_patients(ndjson, threads=threads))))
+
+    results = []
+    for name, workload in workloads:
+        start = time.perf_counter()
+        items = 0
+        for _ in range(rounds):
+            items += workload()
+        results.append((name, time.perf_counter() - start, items))
+    return results
+
+
+def main():
+    arguments = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    arguments.add_argument('--rounds', type=int, default=20, help='Passes over the corpus per workload')
+    arguments.add_argument('--threads', type=int, default=2, help='C worker threads for batch workloads')
+    options = arguments.parse_args()
+
+    # Profiles only come from the compiled extensions
+    if not fast_parser.HAS_C_EXTENSION:
+        sys.exit("train.py: fhir_parser_c extension not built; run `python setup.py build_ext --inplace` first")
+
+    print(f"Training on {CORPUS} ({options.rounds} rounds)")
+    for name, seconds, items in train(options.rounds, options.threads):
+        print(f"  {name:<24} {seconds * 1000:9.1f} ms  {items:8d} items")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Build the optimized (LTO + PGO) variant of Fast-FHIR.
+
+Extensions (default): build the C extensions in place with LTO and
+instrumentation, run benchmarks/pgo/train.py over the bundled corpus,
+then rebuild them with the collected profiles. With --wheel the final
+build is a wheel in dist/, the artifact the release workflow publishes.
+
+Native suite (--bench): build bench_suite plainly and record a baseline,
+then build it with LTO and instrumentation, train it (`make pgo_train`),
+rebuild it with the profiles and compare against the baseline, so the
+gain of the optimized variant is measured on every case.
+
+Usage: python scripts/build_pgo.py [--wheel] [--bench] [--rounds N]
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+CMAKE_SOURCE = os.path.join(ROOT, 'src', 'fast_fhir', 'ext')
+
+
+def run_command(cmd, description, env=None, check=True):
+    """Run a command with its output streamed; exit on failure unless check is off."""
+    print(f"\n==> {description}")
+    print('    ' + ' '.join(cmd))
+    result = subprocess.run(cmd, cwd=ROOT, env=env)
+    if check and result.returncode != 0:
+        print(f"ERROR: {description} failed (exit status {result.returncode})")
+        sys.exit(result.returncode)
+    return result.returncode
+
+
+def reset_dir(path):
+    """Remove a directory and create it empty."""
+    shutil.rmtree(path, ignore_errors=True)
+    os.makedirs(path)
+
+
+def merge_profiles(profile_dir):
+    """Merge clang's raw profiles into merged.profdata; GCC reads .gcda files as they are."""
+    raw = glob.glob(os.path.join(profile_dir, '*.profraw'))
+    if raw:
+        profdata = shutil.which('llvm-profdata') or 'llvm-profdata'
+        run_command([profdata, 'merge', '-output=' + os.path.join(profile_dir, 'merged.profdata')] + raw,
+                    "Merging clang profiles")
+    elif not glob.glob(os.path.join(profile_dir, '**', '*.gcda'), recursive=True):
+        print(f"ERROR: training wrote no profiles to {profile_dir}")
+        sys.exit(1)
+
+
+def clean_setuptools_build():
+    """Drop setuptools objects so each phase recompiles with its own flags."""
+    for path in glob.glob(os.path.join(ROOT, 'build', 'temp.*')) + glob.glob(os.path.join(ROOT, 'build', 'lib.*')):
+        shutil.rmtree(path, ignore_errors=True)
+
+
+def build_extensions(args):
+    """Instrument, train and rebuild the Python C extensions."""
+    profile_dir = os.path.join(ROOT, 'build', 'pgo-profiles')
+    reset_dir(profile_dir)
+    env = dict(os.environ, FAST_FHIR_PGO_DIR=profile_dir)
+    if args.lto:
+        env['FAST_FHIR_LTO'] = '1'
+
+    clean_setuptools_build()
+    env['FAST_FHIR_PGO'] = 'generate'
+    run_command([sys.executable, 'setup.py', 'build_ext', '--inplace', '--force'],
+                "Building instrumented extensions", env)
+    run_command([sys.executable, os.path.join('benchmarks', 'pgo', 'train.py'), '--rounds', str(args.rounds)],
+                "Training on the bundled corpus", env)
+    merge_profiles(profile_dir)
+
+    # Same object paths as the instrumented build, so GCC finds each profile
+    clean_setuptools_build()
+    env['FAST_FHIR_PGO'] = 'use'
+    if args.wheel:
+        run_command([sys.executable, '-m', 'build', '--wheel'], "Building optimized wheel", env)
+    else:
+        run_command([sys.executable, 'setup.py', 'build_ext', '--inplace', '--force'],
+                    "Building optimized extensions", env)
+
+
+def bench_native(args):
+    """Measure the optimized native build against a plain Release build."""
+    baseline_dir = os.path.join(ROOT, 'build', 'pgo-baseline')
+    optimized_dir = os.path.join(ROOT, 'build', 'pgo-native')
+    profile_dir = os.path.join(optimized_dir, 'profiles')
+    baseline = os.path.join(baseline_dir, 'bench_results.json')
+    reset_dir(baseline_dir)
+    reset_dir(optimized_dir)
+
+    run_command(['cmake', '-S', CMAKE_SOURCE, '-B', baseline_dir, '-DCMAKE_BUILD_TYPE=Release'],
+                "Configuring baseline build")
+    run_command(['cmake', '--build', baseline_dir, '--target', 'bench_suite', '-j', str(os.cpu_count() or 1)],
+                "Building baseline bench_suite")
+    run_command([os.path.join(baseline_dir, 'bench_suite'), '--json', baseline],
+                "Recording baseline timings")
+
+    # One build directory for both phases: GCC matches profiles by object path
+    configure = ['cmake', '-S', CMAKE_SOURCE, '-B', optimized_dir, '-DCMAKE_BUILD_TYPE=Release',
+                 '-DFHIR_PGO_DIR=' + profile_dir, '-DFHIR_ENABLE_LTO=' + ('ON' if args.lto else 'OFF')]
+    run_command(configure + ['-DFHIR_PGO=generate'], "Configuring instrumented build")
+    run_command(['cmake', '--build', optimized_dir, '--target', 'pgo_train', '-j', str(os.cpu_count() or 1)],
+                "Building and training instrumented bench_suite")
+    merge_profiles(profile_dir)
+
+    run_command(configure + ['-DFHIR_PGO=use'], "Configuring optimized build")
+    run_command(['cmake', '--build', optimized_dir, '--target', 'bench_suite', '-j', str(os.cpu_count() or 1)],
+                "Building optimized bench_suite")
+    # bench_suite exits with 1 when a case regressed; LTO and PGO can trade
+    # one case for others, so report it rather than hide it
+    status = run_command([os.path.join(optimized_dir, 'bench_suite'),
+                          '--json', os.path.join(optimized_dir, 'bench_results.json'),
+                          '--baseline', baseline, '--tolerance', str(args.tolerance)],
+                         "Comparing optimized build against baseline", check=False)
+    if status != 0:
+        print("\nERROR: the optimized build is slower than the baseline on the cases marked above")
+        sys.exit(status)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the LTO + PGO optimized variant of Fast-FHIR")
+    parser.add_argument('--wheel', action='store_true', help="Build the optimized wheel into dist/")
+    parser.add_argument('--bench', action='store_true',
+                        help="Build the native benchmark suite plainly and optimized, and compare them")
+    parser.add_argument('--rounds', type=int, default=20, help="Passes over the training corpus")
+    parser.add_argument('--tolerance', type=float, default=10, help="Allowed slowdown in percent for --bench")
+    parser.add_argument('--no-lto', dest='lto', action='store_false', help="PGO only, without LTO")
+    args = parser.parse_args()
+
+    if args.bench:
+        bench_native(args)
+    else:
+        build_extensions(args)
+    print("\nSUCCESS: optimized build completed")
+
+
+if __name__ == "__main__":
+    main()
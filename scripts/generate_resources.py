@@ -5,16 +5,21 @@ Automatically generates C header and implementation files for FHIR resources
 following OOP principles and best practices.
 """
 
+import json
 import os
 import re
+import sys
 from typing import Dict, List, Tuple
 
-# Resource definitions with their key fields and characteristics
+# Resource definitions with their key fields and characteristics, used when
+# no StructureDefinitions are given. choice_types lists (name, [type codes])
+# for each name[x] element.
 RESOURCES = {
     "PractitionerRole": {
         "category": "foundation",
         "description": "A specific set of Roles/Locations/specialties/services that a practitioner may perform",
         "key_fields": [
+            ("identifier", "FHIRIdentifier**", "Identifiers for a role/location"),
             ("active", "FHIRBoolean*", "Whether this practitioner role record is in active use"),
             ("period", "FHIRPeriod*", "The period during which the practitioner is authorized to perform in these role(s)"),
             ("practitioner", "FHIRReference*", "Practitioner that is able to provide the defined services"),
@@ -29,18 +34,17 @@ RESOURCES = {
             ("availability", "FHIRAvailability**", "Times the practitioner is available or performing this role"),
             ("endpoint", "FHIRReference**", "Technical endpoints providing access to services operated for the practitioner")
         ],
-        "enums": [
-            ("active_status", ["active", "inactive"])
-        ],
-        "required_fields": ["practitioner", "organization"],
+        "enums": [],
+        "required_fields": [],
         "choice_types": [],
-        "arrays": ["code", "specialty", "location", "healthcare_service", "contact", "characteristic", "communication", "availability", "endpoint"]
+        "arrays": ["identifier", "code", "specialty", "location", "healthcare_service", "contact", "characteristic", "communication", "availability", "endpoint"]
     },
     
     "Organization": {
         "category": "foundation", 
         "description": "A formally or informally recognized grouping of people or organizations",
         "key_fields": [
+            ("identifier", "FHIRIdentifier**", "Identifies this organization across multiple systems"),
             ("active", "FHIRBoolean*", "Whether the organization's record is still in active use"),
             ("type", "FHIRCodeableConcept**", "Kind of organization"),
             ("name", "FHIRString*", "Name used for the organization"),
@@ -54,13 +58,14 @@ RESOURCES = {
         "enums": [],
         "required_fields": [],
         "choice_types": [],
-        "arrays": ["type", "alias", "contact", "endpoint", "qualification"]
+        "arrays": ["identifier", "type", "alias", "contact", "endpoint", "qualification"]
     },
     
     "Location": {
         "category": "foundation",
         "description": "Details and position information for a physical place",
         "key_fields": [
+            ("identifier", "FHIRIdentifier**", "Unique code or number identifying the location to its users"),
             ("status", "FHIRLocationStatus", "active | suspended | inactive"),
             ("operational_status", "FHIRCoding*", "The operational status covers operation values most relevant to beds"),
             ("name", "FHIRString*", "Name of the location as used by humans"),
@@ -70,13 +75,14 @@ RESOURCES = {
             ("type", "FHIRCodeableConcept**", "Type of function performed"),
             ("contact", "FHIRExtendedContactDetail**", "Official contact details for the location"),
             ("address", "FHIRAddress*", "Physical location"),
-            ("physical_type", "FHIRCodeableConcept*", "Physical form of the location"),
+            ("form", "FHIRCodeableConcept*", "Physical form of the location"),
             ("position", "FHIRLocationPosition*", "The absolute geographic location"),
             ("managing_organization", "FHIRReference*", "Organization responsible for provisioning and upkeep"),
             ("part_of", "FHIRReference*", "Another Location this one is physically a part of"),
             ("characteristic", "FHIRCodeableConcept**", "Collection of characteristics (attributes)"),
             ("hours_of_operation", "FHIRAvailability**", "What days/times during a week is this location usually open"),
-            ("virtual_service", "FHIRVirtualServiceDetail**", "Connection details of a virtual service")
+            ("virtual_service", "FHIRVirtualServiceDetail**", "Connection details of a virtual service"),
+            ("endpoint", "FHIRReference**", "Technical endpoints providing access to services operated for the location")
         ],
         "enums": [
             ("status", ["active", "suspended", "inactive"]),
@@ -84,22 +90,681 @@ RESOURCES = {
         ],
         "required_fields": [],
         "choice_types": [],
-        "arrays": ["alias", "type", "contact", "characteristic", "hours_of_operation", "virtual_service"]
+        "arrays": ["identifier", "alias", "type", "contact", "characteristic", "hours_of_operation",
+                   "virtual_service", "endpoint"]
     }
 }
 
-def generate_header_file(resource_name: str, resource_info: Dict) -> str:
+# Output directory for generated resource files
+RESOURCE_DIR = "src/fast_fhir/ext/resources"
+
+# JSON members accepted by every Resource / DomainResource
+BASE_JSON_MEMBERS = [
+    "resourceType", "id", "meta", "implicitRules", "language",
+    "text", "contained", "extension", "modifierExtension"
+]
+
+# JSON member names of hand-written resources that use the generated dispatch
+JSON_MEMBERS = {
+    "Patient": [
+        "identifier", "active", "name", "telecom", "gender", "birthDate",
+        "deceasedBoolean", "deceasedDateTime", "address", "maritalStatus",
+        "multipleBirthBoolean", "multipleBirthInteger", "photo", "contact",
+        "communication", "generalPractitioner", "managingOrganization", "link"
+    ]
+}
+
+# Concrete FHIR R5 resource types, mapped onto FHIRResourceType constants
+R5_RESOURCE_TYPES = [
+    "Account", "ActivityDefinition", "ActorDefinition",
+    "AdministrableProductDefinition", "AdverseEvent", "AllergyIntolerance",
+    "Appointment", "AppointmentResponse", "ArtifactAssessment", "AuditEvent", "Basic",
+    "Binary", "BiologicallyDerivedProduct", "BiologicallyDerivedProductDispense",
+    "BodyStructure", "Bundle", "CapabilityStatement", "CarePlan", "CareTeam",
+    "ChargeItem", "ChargeItemDefinition", "Citation", "Claim", "ClaimResponse",
+    "ClinicalImpression", "ClinicalUseDefinition", "CodeSystem", "Communication",
+    "CommunicationRequest", "CompartmentDefinition", "Composition", "ConceptMap",
+    "Condition", "ConditionDefinition", "Consent", "Contract", "Coverage",
+    "CoverageEligibilityRequest", "CoverageEligibilityResponse", "DetectedIssue",
+    "Device", "DeviceDefinition", "DeviceDispense", "DeviceMetric", "DeviceRequest",
+    "DeviceUsage", "DiagnosticReport", "DocumentReference", "Encounter",
+    "EncounterHistory", "Endpoint", "EnrollmentRequest", "EnrollmentResponse",
+    "EpisodeOfCare", "EventDefinition", "Evidence", "EvidenceReport",
+    "EvidenceVariable", "ExampleScenario", "ExplanationOfBenefit",
+    "FamilyMemberHistory", "Flag", "FormularyItem", "GenomicStudy", "Goal",
+    "GraphDefinition", "Group", "GuidanceResponse", "HealthcareService",
+    "ImagingSelection", "ImagingStudy", "Immunization", "ImmunizationEvaluation",
+    "ImmunizationRecommendation", "ImplementationGuide", "Ingredient", "InsurancePlan",
+    "InventoryItem", "InventoryReport", "Invoice", "Library", "Linkage", "List",
+    "Location", "ManufacturedItemDefinition", "Measure", "MeasureReport", "Medication",
+    "MedicationAdministration", "MedicationDispense", "MedicationKnowledge",
+    "MedicationRequest", "MedicationStatement", "MedicinalProductDefinition",
+    "MessageDefinition", "MessageHeader", "MolecularSequence", "NamingSystem",
+    "NutritionIntake", "NutritionOrder", "NutritionProduct", "Observation",
+    "ObservationDefinition", "OperationDefinition", "OperationOutcome", "Organization",
+    "OrganizationAffiliation", "PackagedProductDefinition", "Parameters", "Patient",
+    "PaymentNotice", "PaymentReconciliation", "Permission", "Person", "PlanDefinition",
+    "Practitioner", "PractitionerRole", "Procedure", "Provenance", "Questionnaire",
+    "QuestionnaireResponse", "RegulatedAuthorization", "RelatedPerson",
+    "RequestOrchestration", "Requirements", "ResearchStudy", "ResearchSubject",
+    "RiskAssessment", "Schedule", "SearchParameter", "ServiceRequest", "Slot",
+    "Specimen", "SpecimenDefinition", "StructureDefinition", "StructureMap",
+    "Subscription", "SubscriptionStatus", "SubscriptionTopic", "Substance",
+    "SubstanceDefinition", "SubstanceNucleicAcid", "SubstancePolymer",
+    "SubstanceProtein", "SubstanceReferenceInformation", "SubstanceSourceMaterial",
+    "SupplyDelivery", "SupplyRequest", "Task", "TerminologyCapabilities", "TestPlan",
+    "TestReport", "TestScript", "Transport", "ValueSet", "VerificationResult",
+    "VisionPrescription"
+]
+
+# Output path of the generated resource type name lookup
+RESOURCE_TYPE_LOOKUP_PATH = "src/fast_fhir/ext/common/fhir_resource_type_lookup.h"
+
+def to_camel_case(name: str) -> str:
+    """Convert a snake_case field name to its FHIR JSON member name."""
+    head, *tail = name.split("_")
+    return head + "".join(part.title() for part in tail)
+
+def to_macro_case(name: str) -> str:
+    """Convert a CamelCase or camelCase name to MACRO_CASE."""
+    return re.sub(r"(?<=[a-z0-9])(?=[A-Z])", "_", name).upper()
+
+def get_json_members(resource_name: str, resource_info: Dict = None) -> List[str]:
+    """Get the JSON member names handled by a resource's from_json."""
+    if resource_name in JSON_MEMBERS:
+        members = JSON_MEMBERS[resource_name]
+    else:
+        members = [to_camel_case(field) for field, _, _ in resource_info["key_fields"]]
+    
+    result = []
+    for member in BASE_JSON_MEMBERS + members:
+        if member not in result:
+            result.append(member)
+    return result
+
+def generate_member_lookup(members: List[str], constant, unknown: str, indent: str,
+                           length: str = "strlen(key)") -> str:
+    """Generate a switch over key length, then one distinguishing character.
+    
+    Each candidate is confirmed with a single memcmp, so a lookup costs one
+    strlen (or none when the caller passes a known length), at most two jumps
+    and one comparison.
+    """
+    by_length: Dict[int, List[str]] = {}
+    for member in members:
+        by_length.setdefault(len(member), []).append(member)
+    
+    def compare(member: str, pad: str) -> str:
+        return (f'{pad}if (memcmp(key, "{member}", {len(member)}) == 0) '
+                f'return {constant(member)};\n')
+    
+    code = f"{indent}switch ({length}) {{\n"
+    for length in sorted(by_length):
+        group = by_length[length]
+        code += f"{indent}    case {length}:\n"
+        if len(group) == 1:
+            code += compare(group[0], indent + "        ")
+            code += f"{indent}        break;\n"
+            continue
+        
+        # Pick the position that splits the group into the most buckets
+        position = max(range(length), key=lambda i: len({m[i] for m in group}))
+        buckets: Dict[str, List[str]] = {}
+        for member in group:
+            buckets.setdefault(member[position], []).append(member)
+        
+        code += f"{indent}        switch (key[{position}]) {{\n"
+        for char in sorted(buckets):
+            code += f"{indent}            case '{char}':\n"
+            for member in buckets[char]:
+                code += compare(member, indent + "                ")
+            code += f"{indent}                break;\n"
+        code += f"{indent}        }}\n"
+        code += f"{indent}        break;\n"
+    code += f"{indent}}}\n"
+    code += f"{indent}return {unknown};\n"
+    return code
+
+def generate_members_header(resource_name: str, members: List[str]) -> str:
+    """Generate the single-pass JSON member dispatch header for a resource."""
+    
+    lower = resource_name.lower()
+    macro = to_macro_case(resource_name)
+    enum_type = f"FHIR{resource_name}Member"
+    header_guard = f"FHIR_{macro}_MEMBERS_H"
+    constant = lambda member: f"FHIR_{macro}_MEMBER_{to_macro_case(member)}"
+    unknown = f"FHIR_{macro}_MEMBER_UNKNOWN"
+    
+    header = f'''/**
+ * @file fhir_{lower}_members.h
+ * @brief Single-pass JSON member dispatch for the FHIR R5 {resource_name} resource
+ * @version 0.1.0
+ * @date 2024-01-01
+ * 
+ * Generated by scripts/generate_resources.py --members; do not edit.
+ * 
+ * from_json walks the object's members once and maps each key to a slot,
+ * instead of one case-insensitive cJSON_GetObjectItem scan per field.
+ */
+
+#ifndef {header_guard}
+#define {header_guard}
+
+#include "../common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <string.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+
+/**
+ * @brief {resource_name} JSON members
+ */
+typedef enum {{
+'''
+    for member in members:
+        header += f"    {constant(member)},\n"
+    header += f'''    FHIR_{macro}_MEMBER_COUNT,
+    {unknown} = FHIR_{macro}_MEMBER_COUNT
+}} {enum_type};
+
+/**
+ * @brief Map a JSON member name to its {enum_type} (case-sensitive)
+ * @param key Member name
+ * @return Member or {unknown}
+ */
+static inline {enum_type} fhir_{lower}_member_lookup(const char* key) {{
+'''
+    header += generate_member_lookup(members, constant, unknown, "    ")
+    header += f'''}}
+
+/**
+ * @brief Collect the members of a {resource_name} JSON object in one pass
+ * 
+ * Recognized members are stored in items by {enum_type} (later duplicates
+ * win); names of unrecognized members are recorded on the resource.
+ * 
+ * @param json JSON object
+ * @param items Output member table, zero-initialized by the caller
+ * @param self Resource receiving unknown member names
+ * @return true on success, false on allocation failure
+ */
+static inline bool fhir_{lower}_scan_members(const cJSON* json,
+                                              const cJSON* items[FHIR_{macro}_MEMBER_COUNT],
+                                              FHIRResourceBase* self) {{
+    const cJSON* member;
+    cJSON_ArrayForEach(member, json) {{
+        if (!member->string) continue;
+        
+        {enum_type} index = fhir_{lower}_member_lookup(member->string);
+        if (index != {unknown}) {{
+            items[index] = member;
+        }} else if (!fhir_resource_add_unknown_member(self, member->string)) {{
+            return false;
+        }}
+    }}
+    return true;
+}}
+
+#ifdef __cplusplus
+}}
+#endif
+
+#endif /* {header_guard} */
+'''
+    return header
+
+def create_members_header(resource_name: str, resource_info: Dict = None):
+    """Create the member dispatch header for a resource."""
+    
+    os.makedirs(RESOURCE_DIR, exist_ok=True)
+    members = get_json_members(resource_name, resource_info)
+    path = f"{RESOURCE_DIR}/fhir_{resource_name.lower()}_members.h"
+    
+    with open(path, 'w') as f:
+        f.write(generate_members_header(resource_name, members))
+    
+    print(f"✓ Created {path}")
+
+def generate_resource_type_lookup_header(resource_types: List[str]) -> str:
+    """Generate the resource type name to FHIRResourceType lookup header."""
+    
+    constant = lambda name: f"FHIR_RESOURCE_TYPE_{to_macro_case(name)}"
+    
+    header = '''/**
+ * @file fhir_resource_type_lookup.h
+ * @brief Resource type name to FHIRResourceType lookup for all FHIR R5 resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ * 
+ * Generated by scripts/generate_resources.py --resource-types; do not edit.
+ * 
+ * Replaces a strcmp against every registered name with a switch on the name
+ * length and one distinguishing character, confirmed by a single memcmp.
+ */
+
+#ifndef FHIR_RESOURCE_TYPE_LOOKUP_H
+#define FHIR_RESOURCE_TYPE_LOOKUP_H
+
+#include "fhir_resource_base.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map a resource type name to its FHIRResourceType (case-sensitive)
+ * @param key Type name, not necessarily NUL-terminated
+ * @param length Length of key in bytes
+ * @return Resource type or FHIR_RESOURCE_TYPE_UNKNOWN
+ */
+static inline FHIRResourceType fhir_resource_type_lookup(const char* key, size_t length) {
+'''
+    header += generate_member_lookup(resource_types, constant, "FHIR_RESOURCE_TYPE_UNKNOWN",
+                                     "    ", length="length")
+    header += '''}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_RESOURCE_TYPE_LOOKUP_H */
+'''
+    return header
+
+def create_resource_type_lookup_header():
+    """Create the resource type name lookup header."""
+    
+    os.makedirs(os.path.dirname(RESOURCE_TYPE_LOOKUP_PATH), exist_ok=True)
+    with open(RESOURCE_TYPE_LOOKUP_PATH, 'w') as f:
+        f.write(generate_resource_type_lookup_header(R5_RESOURCE_TYPES))
+    
+    print(f"✓ Created {RESOURCE_TYPE_LOOKUP_PATH}")
+
+# Output directory of the data type schemas shared by generated codecs
+DATATYPE_SCHEMA_DIR = "src/fast_fhir/ext"
+
+# FHIR primitive types: schema kind and C wrapper struct
+PRIMITIVE_TYPES = {
+    "boolean": ("BOOLEAN", "FHIRBoolean"),
+    "integer": ("INTEGER", "FHIRInteger"),
+    "unsignedInt": ("UNSIGNED", "FHIRUnsignedInt"),
+    "positiveInt": ("UNSIGNED", "FHIRPositiveInt"),
+    "decimal": ("DECIMAL", "FHIRDecimal"),
+    "string": ("STRING", "FHIRString"),
+    "integer64": ("STRING", "FHIRString"),  # A JSON string in R5
+    "id": ("STRING", "FHIRString"),
+    "code": ("STRING", "FHIRCode"),
+    "uri": ("STRING", "FHIRUri"),
+    "url": ("STRING", "FHIRUrl"),
+    "canonical": ("STRING", "FHIRCanonical"),
+    "oid": ("STRING", "FHIROid"),
+    "uuid": ("STRING", "FHIRUuid"),
+    "markdown": ("STRING", "FHIRMarkdown"),
+    "base64Binary": ("STRING", "FHIRBase64Binary"),
+    "time": ("STRING", "FHIRTime"),
+    "date": ("DATE_TIME", "FHIRDate"),
+    "dateTime": ("DATE_TIME", "FHIRDateTime"),
+    "instant": ("DATE_TIME", "FHIRInstant"),
+}
+
+# Complex types with a struct in fhir_datatypes.h, mapped to the schema they
+# use; elements of any other type (backbone elements, ExtendedContactDetail,
+# Availability, ...) are kept as a cJSON copy
+COMPLEX_TYPES = {
+    "Coding": "Coding", "CodeableConcept": "CodeableConcept", "Quantity": "Quantity",
+    "Age": "Quantity", "Count": "Quantity", "Distance": "Quantity", "Duration": "Quantity",
+    "SimpleQuantity": "Quantity", "Period": "Period", "Identifier": "Identifier",
+    "Reference": "Reference", "HumanName": "HumanName", "ContactPoint": "ContactPoint",
+    "Address": "Address"
+}
+
+# Members of the fhir_datatypes.h structs: (JSON key, kind, flags, element type).
+# Identifier.type and Identifier.assigner have no usable C member and are not read.
+DATATYPE_SCHEMAS = {
+    "Coding": [
+        ("system", "TEXT", "", None), ("version", "TEXT", "", None), ("code", "TEXT", "", None),
+        ("display", "TEXT", "", None), ("userSelected", "FLAG", "", None)
+    ],
+    "CodeableConcept": [
+        ("coding", "COMPLEX", "ARRAY", "Coding"), ("text", "TEXT", "", None)
+    ],
+    "Quantity": [
+        ("value", "NUMBER", "", None), ("comparator", "TEXT", "", None), ("unit", "TEXT", "", None),
+        ("system", "TEXT", "", None), ("code", "TEXT", "", None)
+    ],
+    "Period": [
+        ("start", "DATE_TIME", "", None), ("end", "DATE_TIME", "", None)
+    ],
+    "Identifier": [
+        ("use", "TEXT", "", None), ("system", "TEXT", "", None), ("value", "TEXT", "", None),
+        ("period", "COMPLEX", "", "Period")
+    ],
+    "Reference": [
+        ("reference", "TEXT", "", None), ("type", "TEXT", "", None),
+        ("identifier", "COMPLEX", "", "Identifier"), ("display", "TEXT", "", None)
+    ],
+    "HumanName": [
+        ("use", "TEXT", "", None), ("text", "TEXT", "", None), ("family", "TEXT", "ARRAY|SINGLE", None),
+        ("given", "TEXT", "ARRAY", None), ("prefix", "TEXT", "ARRAY", None),
+        ("suffix", "TEXT", "ARRAY", None), ("period", "COMPLEX", "", "Period")
+    ],
+    "ContactPoint": [
+        ("system", "TEXT", "", None), ("value", "TEXT", "", None), ("use", "TEXT", "", None),
+        ("rank", "COUNT", "", None), ("period", "COMPLEX", "", "Period")
+    ],
+    "Address": [
+        ("use", "TEXT", "", None), ("type", "TEXT", "", None), ("text", "TEXT", "", None),
+        ("line", "TEXT", "ARRAY", None), ("city", "TEXT", "", None), ("district", "TEXT", "", None),
+        ("state", "TEXT", "", None), ("postalCode", "TEXT", "", None), ("country", "TEXT", "", None),
+        ("period", "COMPLEX", "", "Period")
+    ]
+}
+
+# Element names that cannot be C (or C++) identifiers as they are
+C_RESERVED = {
+    "auto", "bool", "break", "case", "char", "class", "const", "continue", "default", "delete",
+    "do", "double", "else", "enum", "extern", "false", "float", "for", "friend", "goto", "if",
+    "inline", "int", "long", "namespace", "new", "operator", "private", "protected", "public",
+    "register", "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+    "template", "this", "true", "typedef", "union", "unsigned", "virtual", "void", "volatile",
+    "while"
+}
+
+def to_field_name(key: str) -> str:
+    """Convert a JSON member name to its C struct member name."""
+    name = re.sub(r"(?<=[a-z0-9])(?=[A-Z])", "_", key).lower()
+    return name + "_" if name in C_RESERVED else name
+
+def make_field(key: str, type_code: str, array: bool, required: bool, choice: int,
+               description: str, enum: Tuple[str, List[str]] = None) -> Dict:
+    """Describe one generated struct member and how the codec reads it."""
+    field = {"key": key, "name": to_field_name(key), "array": array,
+             "required": required and not choice, "choice": choice,
+             "description": description, "schema": None, "enum": None}
+    if enum and not array:
+        field.update(kind="CODE", c_type=enum[0], enum=enum)
+    elif type_code in PRIMITIVE_TYPES:
+        kind, c_type = PRIMITIVE_TYPES[type_code]
+        field.update(kind=kind, c_type=c_type + "*")
+    elif type_code in COMPLEX_TYPES:
+        schema = COMPLEX_TYPES[type_code]
+        field.update(kind="COMPLEX", c_type=f"FHIR{schema}*", schema=schema)
+    else:
+        # One cJSON value holds the whole array of a repeating element
+        field.update(kind="JSON", c_type="cJSON*", array=False)
+    return field
+
+def enum_type_name(resource_name: str, field_name: str) -> str:
+    return f"FHIR{resource_name}{''.join(part.title() for part in field_name.split('_'))}"
+
+def builtin_fields(resource_name: str, resource_info: Dict) -> List[Dict]:
+    """Build the field model of a resource from the RESOURCES table."""
+    type_codes = {}
+    for code, (_, c_type) in PRIMITIVE_TYPES.items():
+        type_codes.setdefault(c_type, code)
+    for code, schema in COMPLEX_TYPES.items():
+        type_codes.setdefault(f"FHIR{schema}", code)
+    enums = dict(resource_info.get("enums", []))
+    
+    fields = []
+    for name, c_type, description in resource_info["key_fields"]:
+        base_type = c_type.rstrip("*")
+        enum = (enum_type_name(resource_name, name), enums[name]) if name in enums else None
+        fields.append(make_field(to_camel_case(name), type_codes.get(base_type, base_type),
+                                 name in resource_info.get("arrays", []),
+                                 name in resource_info.get("required_fields", []), 0,
+                                 description, enum))
+    
+    for choice, (name, choice_types) in enumerate(resource_info.get("choice_types", []), 1):
+        for type_code in choice_types:
+            fields.append(make_field(to_camel_case(name) + type_code[0].upper() + type_code[1:],
+                                     type_code, False, False, choice, f"{name}[x] as {type_code}"))
+    return fields
+
+def load_structure_definitions(path: str) -> Dict[str, Dict]:
+    """Read resource StructureDefinitions from a Bundle (profiles-resources.json),
+    a single StructureDefinition or a directory of them."""
+    if os.path.isdir(path):
+        paths = [os.path.join(path, name) for name in sorted(os.listdir(path)) if name.endswith(".json")]
+    else:
+        paths = [path]
+    
+    documents = []
+    for document_path in paths:
+        with open(document_path) as f:
+            document = json.load(f)
+        if document.get("resourceType") == "Bundle":
+            documents.extend(entry.get("resource", {}) for entry in document.get("entry", []))
+        else:
+            documents.append(document)
+    
+    definitions = {}
+    for definition in documents:
+        if (definition.get("resourceType") != "StructureDefinition" or
+                definition.get("kind") != "resource" or definition.get("abstract") or
+                definition.get("derivation") != "specialization"):
+            continue
+        elements = (definition.get("snapshot") or definition.get("differential") or {}).get("element", [])
+        definitions[definition["type"]] = {
+            "description": (definition.get("description") or definition["type"]).split("\n")[0].strip(),
+            "elements": elements
+        }
+    return definitions
+
+def definition_fields(resource_name: str, definition: Dict) -> List[Dict]:
+    """Build the field model of a resource from its StructureDefinition.
+    
+    Only top-level elements become struct members; backbone elements and
+    data types without a C struct are kept as cJSON. Codes listed in the
+    RESOURCES enums of the resource become C enumerations.
+    """
+    enums = dict(RESOURCES.get(resource_name, {}).get("enums", []))
+    fields = []
+    choice = 0
+    for element in definition["elements"]:
+        parts = element.get("path", "").split(".")
+        if len(parts) != 2 or parts[1] in BASE_JSON_MEMBERS or element.get("max") == "0":
+            continue
+        
+        name = parts[1]
+        array = element.get("max", "1") not in ("0", "1")
+        required = element.get("min", 0) > 0
+        description = element.get("short", "")
+        type_codes = [t.get("code") for t in element.get("type", [])]
+        
+        if name.endswith("[x]"):
+            choice += 1
+            for type_code in type_codes:
+                fields.append(make_field(name[:-3] + type_code[0].upper() + type_code[1:],
+                                         type_code, array, False, choice, description))
+            continue
+        
+        type_code = type_codes[0] if len(type_codes) == 1 and "contentReference" not in element else None
+        field_name = to_field_name(name)
+        enum = None
+        if field_name in enums and type_code == "code":
+            enum = (enum_type_name(resource_name, field_name), enums[field_name])
+        fields.append(make_field(name, type_code, array, required, 0, description, enum))
+    return fields
+
+def resource_models(definitions_path: str = None, names: List[str] = None) -> Dict[str, Dict]:
+    """Collect the resources to generate, from StructureDefinitions when given."""
+    models = {}
+    if definitions_path:
+        definitions = load_structure_definitions(definitions_path)
+        for resource_name in names or sorted(RESOURCES):
+            if resource_name not in definitions:
+                raise SystemExit(f"No StructureDefinition for {resource_name} in {definitions_path}")
+            definition = definitions[resource_name]
+            models[resource_name] = {"description": definition["description"],
+                                     "fields": definition_fields(resource_name, definition)}
+    else:
+        for resource_name in names or RESOURCES:
+            resource_info = RESOURCES[resource_name]
+            models[resource_name] = {"description": resource_info["description"],
+                                     "fields": builtin_fields(resource_name, resource_info)}
+    return models
+
+def schema_flags(field: Dict) -> str:
+    flags = []
+    if field["array"]:
+        flags.append("FHIR_SCHEMA_ARRAY")
+    if field["required"]:
+        flags.append("FHIR_SCHEMA_REQUIRED")
+    if field.get("single"):
+        flags.append("FHIR_SCHEMA_SINGLE")
+    return " | ".join(flags) or "0"
+
+def generate_schema_table(struct: str, table: str, fields: List[Dict], codes_prefix: str) -> str:
+    """Generate the FHIRSchemaField table of a struct."""
+    code = ""
+    for field in fields:
+        if field["kind"] == "CODE":
+            values = ", ".join(f'"{value}"' for value in field["enum"][1])
+            code += f'static const char* const {codes_prefix}_{field["name"]}_codes[] = {{{values}}};\n'
+    if code:
+        code += "\n"
+    
+    code += f"static const FHIRSchemaField {table}[] = {{\n"
+    for field in fields:
+        code += f'    {{ .key = "{field["key"]}", .kind = FHIR_SCHEMA_{field["kind"]}, .flags = {schema_flags(field)}'
+        if field["choice"]:
+            code += f', .choice = {field["choice"]}'
+        code += f',\n      .offset = offsetof({struct}, {field["name"]})'
+        if field["array"]:
+            code += f', .count_offset = offsetof({struct}, {field["name"]}_count)'
+        if field["schema"]:
+            code += f',\n      .schema = &fhir_{field["schema"].lower()}_schema'
+        if field["kind"] == "CODE":
+            codes = f'{codes_prefix}_{field["name"]}_codes'
+            code += f',\n      .codes = {codes}, .code_count = sizeof({codes}) / sizeof({codes}[0])'
+        code += " },\n"
+    code += "};\n"
+    return code
+
+def generate_schema_lookup(function: str, fields: List[Dict], field_constant, base_members: List[str]) -> str:
+    """Generate the key lookup of a schema; base members map to FHIR_SCHEMA_MEMBER_BASE."""
+    keys = [field["key"] for field in fields]
+    constants = {field["key"]: field_constant(field) for field in fields}
+    members = keys + [member for member in base_members if member not in constants]
+    constant = lambda member: constants.get(member, "FHIR_SCHEMA_MEMBER_BASE")
+    
+    code = f"static int {function}(const char* key, size_t length) {{\n"
+    code += generate_member_lookup(members, constant, "FHIR_SCHEMA_MEMBER_UNKNOWN", "    ", length="length")
+    code += "}\n"
+    return code
+
+def datatype_fields(type_name: str) -> List[Dict]:
+    """Field model of a fhir_datatypes.h struct."""
+    fields = []
+    for key, kind, flags, schema in DATATYPE_SCHEMAS[type_name]:
+        fields.append({"key": key, "name": to_field_name(key), "kind": kind, "schema": schema,
+                       "array": "ARRAY" in flags, "single": "SINGLE" in flags,
+                       "required": False, "choice": 0, "enum": None})
+    return fields
+
+def generate_datatype_schemas_header() -> str:
+    """Generate the declarations of the data type schemas."""
+    header = '''/**
+ * @file fhir_datatype_schemas.h
+ * @brief Codec schemas of the complex data types in fhir_datatypes.h
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ */
+
+#ifndef FHIR_DATATYPE_SCHEMAS_H
+#define FHIR_DATATYPE_SCHEMAS_H
+
+#include "common/fhir_schema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+'''
+    for type_name in DATATYPE_SCHEMAS:
+        header += f"extern const FHIRSchema fhir_{type_name.lower()}_schema;\n"
+    header += '''
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_DATATYPE_SCHEMAS_H */
+'''
+    return header
+
+def generate_datatype_schemas_source() -> str:
+    """Generate the field tables and key lookups of the data type schemas."""
+    source = '''/**
+ * @file fhir_datatype_schemas.c
+ * @brief Codec schemas of the complex data types in fhir_datatypes.h
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ */
+
+#include "fhir_datatype_schemas.h"
+#include "fhir_datatypes.h"
+#include <stddef.h>
+#include <string.h>
+'''
+    for type_name in DATATYPE_SCHEMAS:
+        lower = type_name.lower()
+        fields = datatype_fields(type_name)
+        source += f'''
+/* ========================================================================== */
+/* {type_name:<75}*/
+/* ========================================================================== */
+
+'''
+        table = generate_schema_table(f"FHIR{type_name}", f"g_{lower}_fields", fields, f"g_{lower}")
+        source += table + "\n"
+        index = {field["key"]: i for i, field in enumerate(fields)}
+        source += generate_schema_lookup(f"fhir_{lower}_field_lookup", fields,
+                                         lambda field: str(index[field["key"]]), ["id", "extension"])
+        source += f'''
+const FHIRSchema fhir_{lower}_schema = {{
+    .name = "{type_name}",
+    .size = sizeof(FHIR{type_name}),
+    .fields = g_{lower}_fields,
+    .field_count = sizeof(g_{lower}_fields) / sizeof(g_{lower}_fields[0]),
+    .lookup = fhir_{lower}_field_lookup
+}};
+'''
+    return source
+
+def create_datatype_schemas():
+    """Create the data type schema files shared by generated codecs."""
+    for name, content in (("fhir_datatype_schemas.h", generate_datatype_schemas_header()),
+                          ("fhir_datatype_schemas.c", generate_datatype_schemas_source())):
+        path = f"{DATATYPE_SCHEMA_DIR}/{name}"
+        with open(path, 'w') as f:
+            f.write(content)
+        print(f"✓ Created {path}")
+
+def generate_header_file(resource_name: str, model: Dict) -> str:
     """Generate C header file for a resource."""
     
+    lower = resource_name.lower()
     header_guard = f"FHIR_{resource_name.upper()}_H"
     
     header = f'''/**
- * @file fhir_{resource_name.lower()}.h
+ * @file fhir_{lower}.h
  * @brief FHIR R5 {resource_name} resource C interface with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
- * 
- * {resource_info["description"]}
+ *
+ * {model["description"]}
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
  */
 
 #ifndef {header_guard}
@@ -116,34 +781,38 @@ extern "C" {{
 
 '''
     
-    # Add enumerations
-    for enum_name, values in resource_info.get("enums", []):
-        enum_type = f"FHIR{resource_name}{enum_name.title().replace('_', '')}"
+    # Add enumerations; 0 means the element is absent
+    for field in model["fields"]:
+        if field["kind"] != "CODE":
+            continue
+        enum_type, values = field["enum"]
+        prefix = f"FHIR_{to_macro_case(resource_name)}_{field['name'].upper()}"
         header += f'''/**
- * @brief {resource_name} {enum_name} enumeration
+ * @brief {resource_name} {field["key"]} codes ({prefix}_NONE when absent)
  */
 typedef enum {{
+    {prefix}_NONE = 0,
 '''
-        for i, value in enumerate(values):
-            header += f'    {enum_type.upper()}_{value.upper().replace("-", "_")} = {i},\n'
+        for value in values:
+            header += f'    {prefix}_{value.upper().replace("-", "_")},\n'
         header += f'}} {enum_type};\n\n'
     
     # Add resource structure
     header += f'''/**
  * @brief FHIR R5 {resource_name} resource structure
- * 
- * {resource_info["description"]}
+ *
+ * {model["description"]}
  */
 FHIR_RESOURCE_DEFINE({resource_name})
     // {resource_name}-specific fields
 '''
     
-    for field_name, field_type, description in resource_info["key_fields"]:
-        if field_name in resource_info.get("arrays", []):
-            header += f'    {field_type} {field_name};\n'
-            header += f'    size_t {field_name}_count;\n'
+    for field in model["fields"]:
+        if field["array"]:
+            header += f'    {field["c_type"]}* {field["name"]};\n'
+            header += f'    size_t {field["name"]}_count;\n'
         else:
-            header += f'    {field_type} {field_name};\n'
+            header += f'    {field["c_type"]} {field["name"]};\n'
         header += f'    \n'
     
     header += '};\n\n'
@@ -158,20 +827,20 @@ FHIR_RESOURCE_DEFINE({resource_name})
  * @param id Resource identifier (required)
  * @return Pointer to new {resource_name} or NULL on failure
  */
-FHIR{resource_name}* fhir_{resource_name.lower()}_create(const char* id);
+FHIR{resource_name}* fhir_{lower}_create(const char* id);
 
 /**
  * @brief Destroy {resource_name} resource (virtual destructor)
  * @param self {resource_name} to destroy
  */
-void fhir_{resource_name.lower()}_destroy(FHIR{resource_name}* self);
+void fhir_{lower}_destroy(FHIR{resource_name}* self);
 
 /**
  * @brief Clone {resource_name} resource (virtual clone)
  * @param self {resource_name} to clone
  * @return Cloned {resource_name} or NULL on failure
  */
-FHIR{resource_name}* fhir_{resource_name.lower()}_clone(const FHIR{resource_name}* self);
+FHIR{resource_name}* fhir_{lower}_clone(const FHIR{resource_name}* self);
 
 /* ========================================================================== */
 /* {resource_name} Serialization Methods                                     */
@@ -182,7 +851,7 @@ FHIR{resource_name}* fhir_{resource_name.lower()}_clone(const FHIR{resource_name
  * @param self {resource_name} to convert
  * @return JSON object or NULL on failure
  */
-cJSON* fhir_{resource_name.lower()}_to_json(const FHIR{resource_name}* self);
+cJSON* fhir_{lower}_to_json(const FHIR{resource_name}* self);
 
 /**
  * @brief Load {resource_name} from JSON (virtual method)
@@ -190,14 +859,14 @@ cJSON* fhir_{resource_name.lower()}_to_json(const FHIR{resource_name}* self);
  * @param json JSON object
  * @return true on success, false on failure
  */
-bool fhir_{resource_name.lower()}_from_json(FHIR{resource_name}* self, const cJSON* json);
+bool fhir_{lower}_from_json(FHIR{resource_name}* self, const cJSON* json);
 
 /**
  * @brief Parse {resource_name} from JSON string
  * @param json_string JSON string
  * @return New {resource_name} or NULL on failure
  */
-FHIR{resource_name}* fhir_{resource_name.lower()}_parse(const char* json_string);
+FHIR{resource_name}* fhir_{lower}_parse(const char* json_string);
 
 /* ========================================================================== */
 /* {resource_name} Validation Methods                                        */
@@ -208,7 +877,22 @@ FHIR{resource_name}* fhir_{resource_name.lower()}_parse(const char* json_string)
  * @param self {resource_name} to validate
  * @return true if valid, false otherwise
  */
-bool fhir_{resource_name.lower()}_validate(const FHIR{resource_name}* self);
+bool fhir_{lower}_validate(const FHIR{resource_name}* self);
+
+/**
+ * @brief Check if two {resource_name}s are equal (virtual method)
+ * @param self First {resource_name}
+ * @param other Second {resource_name}
+ * @return true if equal, false otherwise
+ */
+bool fhir_{lower}_equals(const FHIR{resource_name}* self, const FHIR{resource_name}* other);
+
+/**
+ * @brief Convert {resource_name} to string representation (virtual method)
+ * @param self {resource_name} to convert
+ * @return String representation (must be freed by caller)
+ */
+char* fhir_{lower}_to_string(const FHIR{resource_name}* self);
 
 /* ========================================================================== */
 /* {resource_name}-Specific Methods                                          */
@@ -219,98 +903,155 @@ bool fhir_{resource_name.lower()}_validate(const FHIR{resource_name}* self);
  * @param self {resource_name} to check
  * @return true if active, false otherwise
  */
-bool fhir_{resource_name.lower()}_is_active(const FHIR{resource_name}* self);
+bool fhir_{lower}_is_active(const FHIR{resource_name}* self);
 
 /**
  * @brief Get {resource_name} display name (virtual method)
  * @param self {resource_name} to get name from
  * @return Display name or NULL
  */
-const char* fhir_{resource_name.lower()}_get_display_name(const FHIR{resource_name}* self);
+const char* fhir_{lower}_get_display_name(const FHIR{resource_name}* self);
 
 /**
  * @brief Register {resource_name} resource type
  * @return true on success, false on failure
  */
-bool fhir_{resource_name.lower()}_register(void);
+bool fhir_{lower}_register(void);
 
 #ifdef __cplusplus
 }}
 #endif
 
-#endif /* {header_guard} */'''
+#endif /* {header_guard} */
+'''
     
     return header
 
-def generate_implementation_file(resource_name: str, resource_info: Dict) -> str:
+def generate_is_active(resource_name: str, fields: List[Dict]) -> str:
+    """Body of is_active: the active flag, else an "active" status code."""
+    by_key = {field["key"]: field for field in fields}
+    active = by_key.get("active")
+    if active and active["kind"] == "BOOLEAN" and not active["array"]:
+        return "    return self && self->active && self->active->value;\n"
+    status = by_key.get("status")
+    if status and status["kind"] == "CODE" and "active" in status["enum"][1]:
+        return f"    return self && self->status == FHIR_{to_macro_case(resource_name)}_STATUS_ACTIVE;\n"
+    return f"    // {resource_name} has no active flag or status, so a record is always in use\n" \
+           "    return self != NULL;\n"
+
+def generate_display_name(resource_name: str, fields: List[Dict]) -> str:
+    """Body of get_display_name: the name element when there is a single string one."""
+    name = next((field for field in fields if field["key"] == "name"), None)
+    code = "    if (!self) return NULL;\n    \n"
+    if name and name["kind"] == "STRING" and not name["array"]:
+        code += '''    if (self->name && self->name->value) {
+        return self->name->value;
+    }
+
+'''
+    code += f'    return "{resource_name}";\n'
+    return code
+
+def generate_implementation_file(resource_name: str, model: Dict) -> str:
     """Generate C implementation file for a resource."""
     
+    lower = resource_name.lower()
+    macro = to_macro_case(resource_name)
+    fields = model["fields"]
+    field_constant = lambda field: f"FHIR_{macro}_FIELD_{field['name'].upper()}"
+    
     impl = f'''/**
- * @file fhir_{resource_name.lower()}.c
+ * @file fhir_{lower}.c
  * @brief FHIR R5 {resource_name} resource C implementation with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ *
+ * The codec is the field table below run by common/fhir_schema.c: one pass
+ * over the JSON members with a generated key switch, each value allocated
+ * at its exact size.
  */
 
-#include "fhir_{resource_name.lower()}.h"
+#include "fhir_{lower}.h"
 #include "../common/fhir_common.h"
-#include <stdlib.h>
-#include <string.h>
+#include "../common/fhir_json_reader.h"
+#include "../common/fhir_schema.h"
+#include "../fhir_datatype_schemas.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ========================================================================== */
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT({resource_name}, {resource_name.lower()})
+FHIR_RESOURCE_VTABLE_INIT({resource_name}, {lower}, {macro})
+
+/* ========================================================================== */
+/* {f"{resource_name} Schema":<75}*/
+/* ========================================================================== */
+
+typedef enum {{
+'''
+    for field in fields:
+        impl += f"    {field_constant(field)},\n"
+    impl += f"}} FHIR{resource_name}Field;\n\n"
+    impl += generate_schema_table(f"FHIR{resource_name}", f"g_{lower}_fields", fields, f"g_{lower}")
+    impl += "\n"
+    impl += generate_schema_lookup(f"fhir_{lower}_field_lookup", fields, field_constant, BASE_JSON_MEMBERS)
+    impl += f'''
+static const FHIRSchema g_{lower}_schema = {{
+    .name = "{resource_name}",
+    .size = sizeof(FHIR{resource_name}),
+    .fields = g_{lower}_fields,
+    .field_count = sizeof(g_{lower}_fields) / sizeof(g_{lower}_fields[0]),
+    .lookup = fhir_{lower}_field_lookup
+}};
 
 /* ========================================================================== */
 /* {resource_name} Factory and Lifecycle Methods                             */
 /* ========================================================================== */
 
-FHIR{resource_name}* fhir_{resource_name.lower()}_create(const char* id) {{
+FHIR{resource_name}* fhir_{lower}_create(const char* id) {{
     if (!fhir_validate_id(id)) {{
         FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Invalid ID format", "id");
         return NULL;
     }}
     
-    FHIR{resource_name}* {resource_name.lower()} = fhir_calloc(1, sizeof(FHIR{resource_name}));
-    if (!{resource_name.lower()}) {{
+    FHIR{resource_name}* {lower} = fhir_resource_alloc(&{resource_name}_vtable);
+    if (!{lower}) {{
         return NULL;
     }}
     
-    if (!fhir_resource_base_init(&{resource_name.lower()}->base, &{resource_name}_vtable, 
-                                FHIR_RESOURCE_TYPE_{resource_name.upper()}, id)) {{
-        fhir_free({resource_name.lower()});
+    if (!fhir_resource_base_init(&{lower}->base, &{resource_name}_vtable,
+                                FHIR_RESOURCE_TYPE_{macro}, id)) {{
+        fhir_resource_free(&{resource_name}_vtable, {lower});
         return NULL;
     }}
     
-    // Initialize {resource_name}-specific defaults
-    // Add default initialization here
-    
-    return {resource_name.lower()};
+    return {lower};
 }}
 
-void fhir_{resource_name.lower()}_destroy(FHIR{resource_name}* self) {{
+void fhir_{lower}_destroy(FHIR{resource_name}* self) {{
     if (!self) return;
     
-    // Free {resource_name}-specific fields
-    // Add field cleanup here
-    
-    // Free base resource
+    fhir_schema_clear(&g_{lower}_schema, self);
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&{resource_name}_vtable, self);
 }}
 
-FHIR{resource_name}* fhir_{resource_name.lower()}_clone(const FHIR{resource_name}* self) {{
+FHIR{resource_name}* fhir_{lower}_clone(const FHIR{resource_name}* self) {{
     if (!self) return NULL;
     
-    FHIR{resource_name}* clone = fhir_{resource_name.lower()}_create(self->base.id);
+    FHIR{resource_name}* clone = fhir_{lower}_create(self->base.id);
     if (!clone) return NULL;
     
-    // Clone {resource_name}-specific fields
-    // Add field cloning here
+    if (!fhir_schema_copy(&g_{lower}_schema, clone, self)) {{
+        fhir_{lower}_destroy(clone);
+        return NULL;
+    }}
     
     return clone;
 }}
@@ -319,7 +1060,7 @@ FHIR{resource_name}* fhir_{resource_name.lower()}_clone(const FHIR{resource_name
 /* {resource_name} Serialization Methods                                     */
 /* ========================================================================== */
 
-cJSON* fhir_{resource_name.lower()}_to_json(const FHIR{resource_name}* self) {{
+cJSON* fhir_{lower}_to_json(const FHIR{resource_name}* self) {{
     if (!self) {{
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "{resource_name} is NULL");
         return NULL;
@@ -333,43 +1074,31 @@ cJSON* fhir_{resource_name.lower()}_to_json(const FHIR{resource_name}* self) {{
     
     // Add resource type and id
     if (!fhir_json_add_string(json, "resourceType", "{resource_name}") ||
-        !fhir_json_add_string(json, "id", self->base.id)) {{
+        !fhir_json_add_string(json, "id", self->base.id) ||
+        !fhir_schema_to_json(&g_{lower}_schema, self, json)) {{
         cJSON_Delete(json);
         return NULL;
     }}
     
-    // Add {resource_name}-specific fields
-    // Add field serialization here
-    
     return json;
 }}
 
-bool fhir_{resource_name.lower()}_from_json(FHIR{resource_name}* self, const cJSON* json) {{
+bool fhir_{lower}_from_json(FHIR{resource_name}* self, const cJSON* json) {{
     if (!self || !json) {{
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
         return false;
     }}
     
-    // Validate resource type
-    const char* resource_type = fhir_json_get_string(json, "resourceType");
-    if (!resource_type || strcmp(resource_type, "{resource_name}") != 0) {{
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
-        return false;
-    }}
-    
-    // Parse {resource_name}-specific fields
-    // Add field parsing here
-    
-    return true;
+    return fhir_schema_load_resource(&g_{lower}_schema, self, json);
 }}
 
-FHIR{resource_name}* fhir_{resource_name.lower()}_parse(const char* json_string) {{
+FHIR{resource_name}* fhir_{lower}_parse(const char* json_string) {{
     if (!json_string) {{
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "JSON string is NULL");
         return NULL;
     }}
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {{
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -382,27 +1111,27 @@ FHIR{resource_name}* fhir_{resource_name.lower()}_parse(const char* json_string)
         return NULL;
     }}
     
-    FHIR{resource_name}* {resource_name.lower()} = fhir_{resource_name.lower()}_create(id);
-    if (!{resource_name.lower()}) {{
+    FHIR{resource_name}* {lower} = fhir_{lower}_create(id);
+    if (!{lower}) {{
         cJSON_Delete(json);
         return NULL;
     }}
     
-    if (!fhir_{resource_name.lower()}_from_json({resource_name.lower()}, json)) {{
-        fhir_{resource_name.lower()}_destroy({resource_name.lower()});
+    if (!fhir_{lower}_from_json({lower}, json)) {{
+        fhir_{lower}_destroy({lower});
         cJSON_Delete(json);
         return NULL;
     }}
     
     cJSON_Delete(json);
-    return {resource_name.lower()};
+    return {lower};
 }}
 
 /* ========================================================================== */
 /* {resource_name} Validation Methods                                        */
 /* ========================================================================== */
 
-bool fhir_{resource_name.lower()}_validate(const FHIR{resource_name}* self) {{
+bool fhir_{lower}_validate(const FHIR{resource_name}* self) {{
     if (!self) return false;
     
     // Validate base resource
@@ -410,59 +1139,66 @@ bool fhir_{resource_name.lower()}_validate(const FHIR{resource_name}* self) {{
         return false;
     }}
     
-    // Validate required fields
-'''
+    return fhir_schema_validate(&g_{lower}_schema, self);
+}}
+
+bool fhir_{lower}_equals(const FHIR{resource_name}* self, const FHIR{resource_name}* other) {{
+    if (self == other) return true;
+    if (!self || !other) return false;
     
-    for field in resource_info.get("required_fields", []):
-        impl += f'''    if (!self->{field}) {{
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "{field}");
-        return false;
-    }}
+    if (fhir_strcmp(self->base.id, other->base.id) != 0) return false;
+    return fhir_schema_equals(&g_{lower}_schema, self, other);
+}}
+
+char* fhir_{lower}_to_string(const FHIR{resource_name}* self) {{
+    if (!self) return NULL;
     
-'''
+    const char* display_name = fhir_{lower}_get_display_name(self);
+    
+    char* result = fhir_malloc(256);
+    if (!result) return NULL;
+    
+    snprintf(result, 256, "{resource_name}(id=%s, name=%s, active=%s)",
+             self->base.id ? self->base.id : "unknown",
+             display_name ? display_name : "unknown",
+             fhir_{lower}_is_active(self) ? "true" : "false");
     
-    impl += f'''    return true;
+    return result;
 }}
 
 /* ========================================================================== */
 /* {resource_name}-Specific Methods                                          */
 /* ========================================================================== */
 
-bool fhir_{resource_name.lower()}_is_active(const FHIR{resource_name}* self) {{
-    if (!self || !self->active) return false;
-    return self->active->value;
-}}
+bool fhir_{lower}_is_active(const FHIR{resource_name}* self) {{
+{generate_is_active(resource_name, fields)}}}
 
-const char* fhir_{resource_name.lower()}_get_display_name(const FHIR{resource_name}* self) {{
-    if (!self) return NULL;
-    
-    // Return appropriate display name based on resource type
-    // Implementation depends on resource-specific fields
-    return "{resource_name} Display Name"; // Placeholder
-}}
+const char* fhir_{lower}_get_display_name(const FHIR{resource_name}* self) {{
+{generate_display_name(resource_name, fields)}}}
 
-bool fhir_{resource_name.lower()}_register(void) {{
+bool fhir_{lower}_register(void) {{
     FHIRResourceRegistration registration = {{
-        .type = FHIR_RESOURCE_TYPE_{resource_name.upper()},
+        .type = FHIR_RESOURCE_TYPE_{macro},
         .name = "{resource_name}",
         .vtable = &{resource_name}_vtable,
-        .factory = (FHIRResourceFactory)fhir_{resource_name.lower()}_create
+        .factory = (FHIRResourceFactory)fhir_{lower}_create
     }};
     
     return fhir_resource_register_type(&registration);
-}}'''
+}}
+'''
     
     return impl
 
-def create_resource_files(resource_name: str, resource_info: Dict):
+def create_resource_files(resource_name: str, model: Dict):
     """Create header and implementation files for a resource."""
     
     # Create directories if they don't exist
-    os.makedirs("src/fhir/ext/resources", exist_ok=True)
+    os.makedirs(RESOURCE_DIR, exist_ok=True)
     
     # Generate header file
-    header_content = generate_header_file(resource_name, resource_info)
-    header_path = f"src/fhir/ext/resources/fhir_{resource_name.lower()}.h"
+    header_content = generate_header_file(resource_name, model)
+    header_path = f"{RESOURCE_DIR}/fhir_{resource_name.lower()}.h"
     
     with open(header_path, 'w') as f:
         f.write(header_content)
@@ -470,8 +1206,8 @@ def create_resource_files(resource_name: str, resource_info: Dict):
     print(f"✓ Created {header_path}")
     
     # Generate implementation file
-    impl_content = generate_implementation_file(resource_name, resource_info)
-    impl_path = f"src/fhir/ext/resources/fhir_{resource_name.lower()}.c"
+    impl_content = generate_implementation_file(resource_name, model)
+    impl_path = f"{RESOURCE_DIR}/fhir_{resource_name.lower()}.c"
     
     with open(impl_path, 'w') as f:
         f.write(impl_content)
@@ -482,18 +1218,40 @@ def main():
     """Generate all resource files."""
     print("=== FHIR Resource Generator ===\n")
     
-    for resource_name, resource_info in RESOURCES.items():
+    # --members [Name ...] only regenerates member dispatch headers
+    if len(sys.argv) > 1 and sys.argv[1] == "--members":
+        for resource_name in sys.argv[2:] or list(JSON_MEMBERS):
+            create_members_header(resource_name, RESOURCES.get(resource_name))
+        return
+    
+    # --resource-types only regenerates the resource type name lookup
+    if len(sys.argv) > 1 and sys.argv[1] == "--resource-types":
+        create_resource_type_lookup_header()
+        return
+    
+    # [--codecs] [--definitions profiles-resources.json] [Name ...] generates
+    # resources and their codecs, from StructureDefinitions when given and
+    # from RESOURCES otherwise
+    args = [arg for arg in sys.argv[1:] if arg != "--codecs"]
+    definitions_path = None
+    if "--definitions" in args:
+        position = args.index("--definitions")
+        if position + 1 >= len(args):
+            raise SystemExit("--definitions needs a StructureDefinition file or directory")
+        definitions_path = args[position + 1]
+        del args[position:position + 2]
+    
+    create_datatype_schemas()
+    print()
+    for resource_name, model in resource_models(definitions_path, args).items():
         print(f"Generating {resource_name}...")
-        create_resource_files(resource_name, resource_info)
+        create_resource_files(resource_name, model)
         print()
     
     print("🎉 All resource files generated successfully!")
     print("\nNext steps:")
-    print("1. Review generated files and customize as needed")
-    print("2. Implement resource-specific logic in the placeholder sections")
-    print("3. Add comprehensive tests for each resource")
-    print("4. Update CMakeLists.txt to include new resources")
-    print("5. Build and test the complete system")
+    print("1. Add new resources to CMakeLists.txt")
+    print("2. Build and run the tests")
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    main()
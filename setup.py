@@ -1,7 +1,9 @@
 """Setup script for Fast-FHIR with high-performance C extensions."""
 
 from setuptools import setup, Extension, find_packages
+import os
 import platform
+import sysconfig
 
 # Get cJSON library flags
 try:
@@ -35,32 +37,356 @@ if platform.system() == 'Darwin':
     # Fix macOS universal build issues
     extra_compile_args.extend(['-Wno-error=unused-command-line-argument-hard-error-in-future'])
     # Don't force architecture - let Python decide
-    import sysconfig
     if 'arm64' in sysconfig.get_platform():
         extra_compile_args.extend(['-arch', 'arm64'])
     elif 'x86_64' in sysconfig.get_platform():
         extra_compile_args.extend(['-arch', 'x86_64'])
 
+# Optimized build variant, driven by scripts/build_pgo.py: FAST_FHIR_LTO=1
+# links each extension with link-time optimization, so the fhir_json_get_*
+# helpers and resource vtable calls inline across its sources;
+# FAST_FHIR_PGO=generate instruments the extensions and FAST_FHIR_PGO=use
+# rebuilds them with the profiles written to FAST_FHIR_PGO_DIR
+extra_link_args = []
+if os.environ.get('FAST_FHIR_LTO'):
+    extra_compile_args.append('-flto')
+    extra_link_args.extend(['-O3', '-flto'])
+pgo_phase = os.environ.get('FAST_FHIR_PGO', '')
+pgo_dir = os.path.abspath(os.environ.get('FAST_FHIR_PGO_DIR', os.path.join('build', 'pgo-profiles')))
+pgo_clang = 'clang' in (os.environ.get('CC') or sysconfig.get_config_var('CC') or '')
+if pgo_phase == 'generate':
+    pgo_flags = ['-fprofile-generate=' + pgo_dir]
+    if not pgo_clang:
+        # Worker pools update the counters from several threads
+        pgo_flags.append('-fprofile-update=atomic')
+elif pgo_phase == 'use':
+    if pgo_clang:
+        pgo_flags = ['-fprofile-use=' + os.path.join(pgo_dir, 'merged.profdata')]
+    else:
+        pgo_flags = ['-fprofile-use=' + pgo_dir, '-fprofile-correction', '-Wno-missing-profile']
+elif pgo_phase:
+    raise SystemExit(f"FAST_FHIR_PGO must be 'generate' or 'use', not {pgo_phase!r}")
+else:
+    pgo_flags = []
+extra_compile_args.extend(pgo_flags)
+extra_link_args.extend(pgo_flags)
+
+# The NDJSON reader decompresses gzip input with zlib, and zstd input when
+# libzstd is found
+ndjson_libraries = libraries + ['pthread', 'z']
+ndjson_macros = []
+try:
+    import pkgconfig
+    if pkgconfig.exists('libzstd'):
+        ndjson_libraries.append('zstd')
+        ndjson_macros.append(('FHIR_HAVE_ZSTD', '1'))
+except ImportError:
+    pass
+
 # Define the C extensions
+# Each feature binding is its own fast_fhir.fhir_*_c module. The parser keeps
+# the cores that work on its ParsedDocument trees as it parses them: Bundle
+# streaming (iter_bundle_entries, BundleFeed), FHIRPath (CompiledPath,
+# evaluate_paths), search parameter extraction (extract_search_index) and
+# structure validation (parse_validated)
 fhir_parser_c = Extension(
     'fast_fhir.fhir_parser_c',
-    sources=['src/fast_fhir/ext/fhir_parser.c'],
+    sources=[
+        'src/fast_fhir/ext/fhir_parser.c',
+        'src/fast_fhir/ext/fhir_bundle_stream.c',
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/fhir_path.c',
+        'src/fast_fhir/ext/fhir_search_index.c',
+        'src/fast_fhir/ext/fhir_structure_rules.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
     include_dirs=include_dirs,
     library_dirs=library_dirs,
-    libraries=libraries,
-    extra_compile_args=extra_compile_args
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_lazy_c = Extension(
+    'fast_fhir.fhir_lazy_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_lazy_python.c',
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_interval_c = Extension(
+    'fast_fhir.fhir_interval_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_interval_python.c',
+        'src/fast_fhir/ext/fhir_interval_index.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_spatial_c = Extension(
+    'fast_fhir.fhir_spatial_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_spatial_python.c',
+        'src/fast_fhir/ext/fhir_spatial_index.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_timeseries_c = Extension(
+    'fast_fhir.fhir_timeseries_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_timeseries_python.c',
+        'src/fast_fhir/ext/fhir_timeseries.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_directory_c = Extension(
+    'fast_fhir.fhir_directory_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_directory_python.c',
+        'src/fast_fhir/ext/fhir_directory_index.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_ndjson_c = Extension(
+    'fast_fhir.fhir_ndjson_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_ndjson_python.c',
+        'src/fast_fhir/ext/fhir_ndjson.c',
+        'src/fast_fhir/ext/fhir_decompress.c',
+        'src/fast_fhir/ext/fhir_bundle_parallel.c',
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/resources/fhir_patient.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=ndjson_libraries,
+    define_macros=ndjson_macros,
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_match_c = Extension(
+    'fast_fhir.fhir_match_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_match_python.c',
+        'src/fast_fhir/ext/fhir_match_index.c',
+        'src/fast_fhir/ext/fhir_ndjson.c',
+        'src/fast_fhir/ext/fhir_decompress.c',
+        'src/fast_fhir/ext/resources/fhir_patient.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=ndjson_libraries,
+    define_macros=ndjson_macros,
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_terminology_c = Extension(
+    'fast_fhir.fhir_terminology_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_terminology_python.c',
+        'src/fast_fhir/ext/fhir_terminology.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_arrow_c = Extension(
+    'fast_fhir.fhir_arrow_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_arrow_python.c',
+        'src/fast_fhir/ext/fhir_arrow.c',
+        'src/fast_fhir/ext/fhir_observation_columns.c',
+        'src/fast_fhir/ext/fhir_ndjson.c',
+        'src/fast_fhir/ext/fhir_decompress.c',
+        'src/fast_fhir/ext/resources/fhir_patient.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=ndjson_libraries,
+    define_macros=ndjson_macros,
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_store_c = Extension(
+    'fast_fhir.fhir_store_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_store_python.c',
+        'src/fast_fhir/ext/fhir_store.c',
+        'src/fast_fhir/ext/fhir_batch.c',
+        'src/fast_fhir/ext/fhir_ndjson.c',
+        'src/fast_fhir/ext/fhir_decompress.c',
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/resources/fhir_patient.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=ndjson_libraries,
+    define_macros=ndjson_macros,
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_canonical_c = Extension(
+    'fast_fhir.fhir_canonical_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_canonical_python.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_patch_c = Extension(
+    'fast_fhir.fhir_patch_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_patch_python.c',
+        'src/fast_fhir/ext/fhir_patch.c',
+        'src/fast_fhir/ext/fhir_path.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_transaction_c = Extension(
+    'fast_fhir.fhir_transaction_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_transaction_python.c',
+        'src/fast_fhir/ext/fhir_bundle_parallel.c',
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
+)
+
+fhir_diagnostics_c = Extension(
+    'fast_fhir.fhir_diagnostics_c',
+    sources=[
+        'src/fast_fhir/ext/fhir_diagnostics_python.c',
+        'src/fast_fhir/ext/common/fhir_resource_base.c',
+        'src/fast_fhir/ext/common/fhir_hash.c',
+        'src/fast_fhir/ext/common/fhir_binary.c',
+        'src/fast_fhir/ext/common/fhir_json_writer.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
+    ],
+    include_dirs=include_dirs,
+    library_dirs=library_dirs,
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_datatypes_c = Extension(
     'fast_fhir.fhir_datatypes_c',
     sources=[
         'src/fast_fhir/ext/fhir_datatypes.c',
-        'src/fast_fhir/ext/fhir_datatypes_python.c'
+        'src/fast_fhir/ext/fhir_datatypes_python.c',
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
     ],
     include_dirs=include_dirs,
     library_dirs=library_dirs,
-    libraries=libraries,
-    extra_compile_args=extra_compile_args
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_foundation_c = Extension(
@@ -68,12 +394,17 @@ fhir_foundation_c = Extension(
     sources=[
         'src/fast_fhir/ext/fhir_foundation.c',
         'src/fast_fhir/ext/fhir_foundation_python.c',
-        'src/fast_fhir/ext/fhir_datatypes.c'  # Foundation depends on datatypes
+        'src/fast_fhir/ext/fhir_python_json.c',
+        'src/fast_fhir/ext/fhir_datatypes.c',  # Foundation depends on datatypes
+        'src/fast_fhir/ext/common/fhir_json_reader.c',
+        'src/fast_fhir/ext/common/fhir_base64.c',
+        'src/fast_fhir/ext/common/fhir_common.c'
     ],
     include_dirs=include_dirs,
     library_dirs=library_dirs,
-    libraries=libraries,
-    extra_compile_args=extra_compile_args
+    libraries=libraries + ['pthread'],
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_clinical_c = Extension(
@@ -87,7 +418,8 @@ fhir_clinical_c = Extension(
     include_dirs=include_dirs,
     library_dirs=library_dirs,
     libraries=libraries,
-    extra_compile_args=extra_compile_args
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_medication_c = Extension(
@@ -101,7 +433,8 @@ fhir_medication_c = Extension(
     include_dirs=include_dirs,
     library_dirs=library_dirs,
     libraries=libraries,
-    extra_compile_args=extra_compile_args
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_workflow_c = Extension(
@@ -115,7 +448,8 @@ fhir_workflow_c = Extension(
     include_dirs=include_dirs,
     library_dirs=library_dirs,
     libraries=libraries,
-    extra_compile_args=extra_compile_args
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_specialized_c = Extension(
@@ -129,7 +463,8 @@ fhir_specialized_c = Extension(
     include_dirs=include_dirs,
     library_dirs=library_dirs,
     libraries=libraries,
-    extra_compile_args=extra_compile_args
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 fhir_new_resources_c = Extension(
@@ -143,7 +478,8 @@ fhir_new_resources_c = Extension(
     include_dirs=include_dirs,
     library_dirs=library_dirs,
     libraries=libraries,
-    extra_compile_args=extra_compile_args
+    extra_compile_args=extra_compile_args,
+    extra_link_args=extra_link_args
 )
 
 # Determine if we should build C extensions
@@ -158,7 +494,6 @@ elif not include_dirs or not library_dirs:
     build_c_extensions = False
 
 # Allow disabling C extensions via environment variable
-import os
 if os.environ.get('FAST_FHIR_DISABLE_C_EXTENSIONS'):
     print("C extensions disabled via environment variable")
     build_c_extensions = False
@@ -173,6 +508,48 @@ if build_c_extensions:
         # Check which C files actually exist and can compile
         if os.path.exists('src/fast_fhir/ext/fhir_parser.c'):
             available_extensions.append(fhir_parser_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_lazy_python.c'):
+            available_extensions.append(fhir_lazy_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_interval_python.c'):
+            available_extensions.append(fhir_interval_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_spatial_python.c'):
+            available_extensions.append(fhir_spatial_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_timeseries_python.c'):
+            available_extensions.append(fhir_timeseries_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_directory_python.c'):
+            available_extensions.append(fhir_directory_c)
+        
+        if os.path.exists('src/fast_fhir/ext/fhir_ndjson.c'):
+            available_extensions.append(fhir_ndjson_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_terminology.c'):
+            available_extensions.append(fhir_terminology_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_arrow.c'):
+            available_extensions.append(fhir_arrow_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_store.c'):
+            available_extensions.append(fhir_store_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_match_python.c'):
+            available_extensions.append(fhir_match_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_canonical_python.c'):
+            available_extensions.append(fhir_canonical_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_patch_python.c'):
+            available_extensions.append(fhir_patch_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_transaction_python.c'):
+            available_extensions.append(fhir_transaction_c)
+
+        if os.path.exists('src/fast_fhir/ext/fhir_diagnostics_python.c'):
+            available_extensions.append(fhir_diagnostics_c)
         
         if os.path.exists('src/fast_fhir/ext/fhir_datatypes.c'):
             available_extensions.append(fhir_datatypes_c)
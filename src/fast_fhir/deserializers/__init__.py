@@ -27,6 +27,7 @@ try:
         FHIRCareProvisionDeserializer,
         FHIRDeserializationError,
         deserialize_care_provision_resource,
+        deserialize_many,
         deserialize_care_plan,
         deserialize_care_team,
         deserialize_goal,
@@ -165,6 +166,7 @@ __all__ = [
     
     # Care provision convenience functions
     'deserialize_care_provision_resource',
+    'deserialize_many',
     'deserialize_care_plan',
     'deserialize_care_team', 
     'deserialize_goal',
@@ -1,10 +1,11 @@
 """
 FHIR R5 Care Provision Resource Deserializers
-Converts JSON strings to FHIR resource objects using Pydantic validation
+Converts JSON strings to FHIR resource objects, validating their structure in C
+(fhir_parser_c.parse_validated) with Pydantic as an opt-in strict mode
 """
 
 import json
-from typing import Union, Dict, Any, Optional, Type, TypeVar
+from typing import Union, Dict, Any, Optional, Type, TypeVar, Iterable, List, Tuple
 from datetime import datetime
 
 try:
@@ -21,6 +22,15 @@ except ImportError as e:
     CarePlanModel = CareTeamModel = GoalModel = ServiceRequestModel = None
     NutritionOrderModel = RiskAssessmentModel = VisionPrescriptionModel = None
 
+try:
+    from .. import fhir_parser_c
+    HAS_C_VALIDATION = hasattr(fhir_parser_c, 'parse_validated')
+except ImportError:
+    HAS_C_VALIDATION = False
+
+# JSON text accepted without decoding; the C extension reads bytes-like objects in place
+_JSON_TEXT_TYPES = (str, bytes, bytearray, memoryview)
+
 # Import the actual FHIR resource classes
 from ..resources.care_plan import CarePlan, CarePlanStatus, CarePlanIntent, CarePlanActivity, CarePlanActivityDetail
 from ..resources.care_team import CareTeam, CareTeamStatus, CareTeamParticipant
@@ -48,17 +58,19 @@ class FHIRDeserializationError(Exception):
 class FHIRCareProvisionDeserializer:
     """
     Deserializer for FHIR R5 Care Provision resources
-    Uses Pydantic for validation and converts to native FHIR resource objects
+    Parses and validates JSON strings in C and converts to native FHIR resource objects
     """
     
-    def __init__(self, use_pydantic_validation: bool = True):
+    def __init__(self, use_pydantic_validation: bool = False, use_c_validation: bool = True):
         """
         Initialize the deserializer
         
         Args:
-            use_pydantic_validation: Whether to use Pydantic validation (requires pydantic package)
+            use_pydantic_validation: Whether to also run strict Pydantic validation (requires pydantic package)
+            use_c_validation: Whether to parse and validate JSON strings with the fhir_parser_c extension
         """
         self.use_pydantic_validation = use_pydantic_validation and HAS_PYDANTIC and PYDANTIC_CARE_PROVISION_MODELS_AVAILABLE
+        self.use_c_validation = use_c_validation and HAS_C_VALIDATION
         
         # Resource type mapping (only if Pydantic models are available)
         if PYDANTIC_CARE_PROVISION_MODELS_AVAILABLE:
@@ -89,7 +101,7 @@ class FHIRCareProvisionDeserializer:
         Deserialize JSON data to a FHIR Care Provision resource
         
         Args:
-            json_data: JSON string or dictionary containing FHIR resource data
+            json_data: JSON string, bytes-like object or dictionary containing FHIR resource data
             
         Returns:
             FHIR resource object
@@ -98,9 +110,12 @@ class FHIRCareProvisionDeserializer:
             FHIRDeserializationError: If deserialization fails
         """
         try:
-            # Parse JSON if string
-            if isinstance(json_data, str):
-                data = json.loads(json_data)
+            # Parse JSON if text or bytes; the C path also checks required members, codes and JSON kinds
+            if isinstance(json_data, _JSON_TEXT_TYPES):
+                if self.use_c_validation:
+                    data = fhir_parser_c.parse_validated(json_data)
+                else:
+                    data = json.loads(bytes(json_data) if isinstance(json_data, memoryview) else json_data)
             else:
                 data = json_data
             
@@ -127,6 +142,93 @@ class FHIRCareProvisionDeserializer:
         except Exception as e:
             raise FHIRDeserializationError(f"Deserialization failed: {e}")
     
+    def deserialize_many(self, source: Union[str, bytes, memoryview, Iterable[Union[str, bytes, Dict[str, Any]]]],
+                         resource_type: Optional[str] = None,
+                         threads: Optional[int] = None) -> Tuple[List[Any], List[Dict[str, Any]]]:
+        """
+        Deserialize many FHIR Care Provision resources in one call
+        
+        JSON text is parsed and validated in a single C call on a worker pool
+        with the GIL released; only the conversion to resource objects runs in Python.
+        
+        Args:
+            source: NDJSON buffer or JSON array (str or bytes-like), or an iterable of JSON strings/bytes or dictionaries
+            resource_type: Expected resource type of every resource (optional)
+            threads: Worker threads for parsing (None or 0 = all CPUs)
+            
+        Returns:
+            Tuple (resources, errors). resources is aligned with the input and holds None
+            where a resource failed; each error is a dict with index, line (NDJSON only),
+            code, message and field.
+        """
+        if not isinstance(source, _JSON_TEXT_TYPES):
+            source = list(source)
+        
+        text_only = isinstance(source, _JSON_TEXT_TYPES) or all(isinstance(item, _JSON_TEXT_TYPES) for item in source)
+        if self.use_c_validation and text_only:
+            try:
+                documents, errors = fhir_parser_c.parse_validated_many(source, resource_type, threads or 0)
+            except ValueError as e:
+                raise FHIRDeserializationError(f"Deserialization failed: {e}")
+        else:
+            documents, errors = self._load_many(source, resource_type)
+        
+        resources = []
+        for index, data in enumerate(documents):
+            if data is None:
+                resources.append(None)
+                continue
+            if resource_type and isinstance(data, dict) and "resourceType" not in data:
+                data["resourceType"] = resource_type
+            try:
+                resources.append(self.deserialize(data))
+            except FHIRDeserializationError as e:
+                resources.append(None)
+                errors.append(self._batch_error(index, None, "Deserialization failed", str(e)))
+        
+        errors.sort(key=lambda error: error["index"])
+        return resources, errors
+    
+    def _load_many(self, source: Union[str, bytes, List[Any]],
+                   resource_type: Optional[str]) -> Tuple[List[Any], List[Dict[str, Any]]]:
+        """Split and parse a batch in Python when the C extension is unavailable or items are dicts"""
+        if isinstance(source, _JSON_TEXT_TYPES):
+            text = source if isinstance(source, str) else bytes(source).decode("utf-8")
+            if text.lstrip().startswith("["):
+                try:
+                    items = [(item, None) for item in json.loads(text)]
+                except json.JSONDecodeError as e:
+                    raise FHIRDeserializationError(f"Invalid JSON: {e}")
+            else:
+                items = [(line, number) for number, line in enumerate(text.split("\n"), 1) if line.strip()]
+        else:
+            items = [(item, None) for item in source]
+        
+        documents, errors = [], []
+        for index, (item, line) in enumerate(items):
+            try:
+                if isinstance(item, memoryview):
+                    item = bytes(item)
+                data = json.loads(item) if isinstance(item, _JSON_TEXT_TYPES) else item
+            except json.JSONDecodeError:
+                documents.append(None)
+                errors.append(self._batch_error(index, line, "Invalid JSON", "Invalid JSON"))
+                continue
+            if resource_type and isinstance(data, dict) and data.get("resourceType") != resource_type:
+                documents.append(None)
+                errors.append(self._batch_error(index, line, "Invalid resource type",
+                                                f"Resource type mismatch: expected {resource_type}, got {data.get('resourceType')}",
+                                                "resourceType"))
+                continue
+            documents.append(data)
+        return documents, errors
+    
+    @staticmethod
+    def _batch_error(index: int, line: Optional[int], code: str, message: str,
+                     field: Optional[str] = None) -> Dict[str, Any]:
+        """Build one structured deserialize_many error"""
+        return {"index": index, "line": line, "code": code, "message": message, "field": field}
+    
     def _convert_to_fhir_resource(self, resource_type: str, data: Dict[str, Any]) -> Any:
         """Convert validated data to FHIR resource object"""
         
@@ -677,13 +779,13 @@ class FHIRCareProvisionDeserializer:
 
 # Convenience functions
 def deserialize_care_provision_resource(json_data: Union[str, Dict[str, Any]], 
-                                       use_pydantic_validation: bool = True) -> Union[CarePlan, CareTeam, Goal, ServiceRequest, NutritionOrder, RiskAssessment, VisionPrescription]:
+                                       use_pydantic_validation: bool = False) -> Union[CarePlan, CareTeam, Goal, ServiceRequest, NutritionOrder, RiskAssessment, VisionPrescription]:
     """
     Convenience function to deserialize a FHIR Care Provision resource
     
     Args:
-        json_data: JSON string or dictionary containing FHIR resource data
-        use_pydantic_validation: Whether to use Pydantic validation
+        json_data: JSON string, bytes-like object or dictionary containing FHIR resource data
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         FHIR resource object
@@ -692,7 +794,7 @@ def deserialize_care_provision_resource(json_data: Union[str, Dict[str, Any]],
     return deserializer.deserialize(json_data)
 
 
-def deserialize_care_plan(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> CarePlan:
+def deserialize_care_plan(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> CarePlan:
     """Deserialize CarePlan from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, CarePlan):
@@ -700,7 +802,7 @@ def deserialize_care_plan(json_data: Union[str, Dict[str, Any]], use_pydantic_va
     return resource
 
 
-def deserialize_care_team(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> CareTeam:
+def deserialize_care_team(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> CareTeam:
     """Deserialize CareTeam from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, CareTeam):
@@ -708,7 +810,7 @@ def deserialize_care_team(json_data: Union[str, Dict[str, Any]], use_pydantic_va
     return resource
 
 
-def deserialize_goal(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> Goal:
+def deserialize_goal(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> Goal:
     """Deserialize Goal from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, Goal):
@@ -716,7 +818,7 @@ def deserialize_goal(json_data: Union[str, Dict[str, Any]], use_pydantic_validat
     return resource
 
 
-def deserialize_service_request(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> ServiceRequest:
+def deserialize_service_request(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> ServiceRequest:
     """Deserialize ServiceRequest from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, ServiceRequest):
@@ -724,7 +826,7 @@ def deserialize_service_request(json_data: Union[str, Dict[str, Any]], use_pydan
     return resource
 
 
-def deserialize_nutrition_order(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> NutritionOrder:
+def deserialize_nutrition_order(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> NutritionOrder:
     """Deserialize NutritionOrder from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, NutritionOrder):
@@ -732,7 +834,7 @@ def deserialize_nutrition_order(json_data: Union[str, Dict[str, Any]], use_pydan
     return resource
 
 
-def deserialize_risk_assessment(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> RiskAssessment:
+def deserialize_risk_assessment(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> RiskAssessment:
     """Deserialize RiskAssessment from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, RiskAssessment):
@@ -740,7 +842,7 @@ def deserialize_risk_assessment(json_data: Union[str, Dict[str, Any]], use_pydan
     return resource
 
 
-def deserialize_vision_prescription(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = True) -> VisionPrescription:
+def deserialize_vision_prescription(json_data: Union[str, Dict[str, Any]], use_pydantic_validation: bool = False) -> VisionPrescription:
     """Deserialize VisionPrescription from JSON"""
     resource = deserialize_care_provision_resource(json_data, use_pydantic_validation)
     if not isinstance(resource, VisionPrescription):
@@ -748,11 +850,31 @@ def deserialize_vision_prescription(json_data: Union[str, Dict[str, Any]], use_p
     return resource
 
 
+def deserialize_many(source: Union[str, bytes, memoryview, Iterable[Union[str, bytes, Dict[str, Any]]]],
+                     resource_type: Optional[str] = None, threads: Optional[int] = None,
+                     use_pydantic_validation: bool = False) -> Tuple[List[Any], List[Dict[str, Any]]]:
+    """
+    Convenience function to deserialize many FHIR Care Provision resources in one call
+    
+    Args:
+        source: NDJSON buffer or JSON array (str or bytes-like), or an iterable of JSON strings/bytes or dictionaries
+        resource_type: Expected resource type of every resource (optional)
+        threads: Worker threads for parsing (None or 0 = all CPUs)
+        use_pydantic_validation: Whether to also run strict Pydantic validation
+        
+    Returns:
+        Tuple (resources, errors), see FHIRCareProvisionDeserializer.deserialize_many
+    """
+    deserializer = FHIRCareProvisionDeserializer(use_pydantic_validation=use_pydantic_validation)
+    return deserializer.deserialize_many(source, resource_type, threads)
+
+
 # Export all public functions and classes
 __all__ = [
     'FHIRDeserializationError',
     'FHIRCareProvisionDeserializer',
     'deserialize_care_provision_resource',
+    'deserialize_many',
     'deserialize_care_plan',
     'deserialize_care_team',
     'deserialize_goal',
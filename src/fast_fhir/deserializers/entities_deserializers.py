@@ -21,6 +21,12 @@ except ImportError as e:
     OrganizationModel = LocationModel = HealthcareServiceModel = None
     EndpointModel = DeviceModel = SubstanceModel = OrganizationAffiliationModel = None
 
+try:
+    from .. import fhir_parser_c
+    HAS_C_VALIDATION = hasattr(fhir_parser_c, 'parse_validated')
+except ImportError:
+    HAS_C_VALIDATION = False
+
 # Import the actual FHIR resource classes
 try:
     from ..resources.organization import Organization
@@ -99,17 +105,19 @@ class FHIREntitiesDeserializationError(Exception):
 class FHIREntitiesDeserializer:
     """
     Deserializer for FHIR R5 Entities resources
-    Uses Pydantic for validation and converts to native FHIR resource objects
+    Parses and validates JSON strings in C and converts to native FHIR resource objects
     """
     
-    def __init__(self, use_pydantic_validation: bool = True):
+    def __init__(self, use_pydantic_validation: bool = False, use_c_validation: bool = True):
         """
         Initialize the deserializer
         
         Args:
-            use_pydantic_validation: Whether to use Pydantic for validation
+            use_pydantic_validation: Whether to also run strict Pydantic validation
+            use_c_validation: Whether to parse and validate JSON strings with the fhir_parser_c extension
         """
         self.use_pydantic_validation = use_pydantic_validation and HAS_PYDANTIC
+        self.use_c_validation = use_c_validation and HAS_C_VALIDATION
         
         # Resource type mapping
         self.resource_map = {
@@ -131,7 +139,7 @@ class FHIREntitiesDeserializer:
         Deserialize a FHIR entities resource from JSON
         
         Args:
-            json_data: JSON string or dictionary containing FHIR resource
+            json_data: JSON string, bytes-like object or dictionary containing FHIR resource
             resource_type: Optional resource type hint
             
         Returns:
@@ -141,9 +149,12 @@ class FHIREntitiesDeserializer:
             FHIREntitiesDeserializationError: If deserialization fails
         """
         try:
-            # Parse JSON if string
-            if isinstance(json_data, str):
-                data = json.loads(json_data)
+            # Parse JSON if text or bytes; the C path also checks required members, codes and JSON kinds
+            if isinstance(json_data, (str, bytes, bytearray, memoryview)):
+                if self.use_c_validation:
+                    data = fhir_parser_c.parse_validated(json_data, resource_type)
+                else:
+                    data = json.loads(bytes(json_data) if isinstance(json_data, memoryview) else json_data)
             else:
                 data = json_data.copy()
             
@@ -303,35 +314,35 @@ class FHIREntitiesDeserializer:
 
 # Convenience functions for direct use
 def deserialize_organization(json_data: Union[str, Dict[str, Any]], 
-                           use_pydantic_validation: bool = True) -> Organization:
+                           use_pydantic_validation: bool = False) -> Organization:
     """Convenience function to deserialize an Organization resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_organization(json_data)
 
 
 def deserialize_location(json_data: Union[str, Dict[str, Any]], 
-                        use_pydantic_validation: bool = True) -> Location:
+                        use_pydantic_validation: bool = False) -> Location:
     """Convenience function to deserialize a Location resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_location(json_data)
 
 
 def deserialize_healthcare_service(json_data: Union[str, Dict[str, Any]], 
-                                  use_pydantic_validation: bool = True) -> HealthcareService:
+                                  use_pydantic_validation: bool = False) -> HealthcareService:
     """Convenience function to deserialize a HealthcareService resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_healthcare_service(json_data)
 
 
 def deserialize_endpoint(json_data: Union[str, Dict[str, Any]], 
-                        use_pydantic_validation: bool = True) -> Endpoint:
+                        use_pydantic_validation: bool = False) -> Endpoint:
     """Convenience function to deserialize an Endpoint resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_endpoint(json_data)
 
 
 def deserialize_device(json_data: Union[str, Dict[str, Any]], 
-                      use_pydantic_validation: bool = True) -> Device:
+                      use_pydantic_validation: bool = False) -> Device:
     """Convenience function to deserialize a Device resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_device(json_data)
@@ -341,35 +352,35 @@ def deserialize_device(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_substance(json_data: Union[str, Dict[str, Any]], 
-                         use_pydantic_validation: bool = True) -> Substance:
+                         use_pydantic_validation: bool = False) -> Substance:
     """Convenience function to deserialize a Substance resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_substance(json_data)
 
 
 def deserialize_organization_affiliation(json_data: Union[str, Dict[str, Any]], 
-                                       use_pydantic_validation: bool = True) -> OrganizationAffiliation:
+                                       use_pydantic_validation: bool = False) -> OrganizationAffiliation:
     """Convenience function to deserialize an OrganizationAffiliation resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_organization_affiliation(json_data)
 
 
 def deserialize_biologically_derived_product(json_data: Union[str, Dict[str, Any]], 
-                                           use_pydantic_validation: bool = True) -> BiologicallyDerivedProduct:
+                                           use_pydantic_validation: bool = False) -> BiologicallyDerivedProduct:
     """Convenience function to deserialize a BiologicallyDerivedProduct resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_biologically_derived_product(json_data)
 
 
 def deserialize_nutrition_product(json_data: Union[str, Dict[str, Any]], 
-                                 use_pydantic_validation: bool = True) -> NutritionProduct:
+                                 use_pydantic_validation: bool = False) -> NutritionProduct:
     """Convenience function to deserialize a NutritionProduct resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_nutrition_product(json_data)
 
 
 def deserialize_device_metric(json_data: Union[str, Dict[str, Any]], 
-                             use_pydantic_validation: bool = True) -> DeviceMetric:
+                             use_pydantic_validation: bool = False) -> DeviceMetric:
     """Convenience function to deserialize a DeviceMetric resource"""
     deserializer = FHIREntitiesDeserializer(use_pydantic_validation)
     return deserializer.deserialize_device_metric(json_data)
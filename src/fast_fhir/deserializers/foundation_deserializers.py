@@ -21,6 +21,12 @@ except ImportError as e:
     PatientModel = PractitionerModel = PractitionerRoleModel = None
     EncounterModel = PersonModel = RelatedPersonModel = GroupModel = None
 
+try:
+    from .. import fhir_parser_c
+    HAS_C_VALIDATION = hasattr(fhir_parser_c, 'parse_validated')
+except ImportError:
+    HAS_C_VALIDATION = False
+
 # Import the actual FHIR resource classes (these would need to be implemented)
 try:
     from ..resources.patient import Patient
@@ -143,17 +149,19 @@ class FHIRFoundationDeserializationError(Exception):
 class FHIRFoundationDeserializer:
     """
     Deserializer for FHIR R5 Foundation resources
-    Uses Pydantic for validation and converts to native FHIR resource objects
+    Parses and validates JSON strings in C and converts to native FHIR resource objects
     """
     
-    def __init__(self, use_pydantic_validation: bool = True):
+    def __init__(self, use_pydantic_validation: bool = False, use_c_validation: bool = True):
         """
         Initialize the deserializer
         
         Args:
-            use_pydantic_validation: Whether to use Pydantic for validation
+            use_pydantic_validation: Whether to also run strict Pydantic validation
+            use_c_validation: Whether to parse and validate JSON strings with the fhir_parser_c extension
         """
         self.use_pydantic_validation = use_pydantic_validation and HAS_PYDANTIC and PYDANTIC_FOUNDATION_MODELS_AVAILABLE
+        self.use_c_validation = use_c_validation and HAS_C_VALIDATION
         
         # Resource type mapping (handle case where Pydantic models are None)
         if PYDANTIC_FOUNDATION_MODELS_AVAILABLE:
@@ -184,7 +192,7 @@ class FHIRFoundationDeserializer:
         Deserialize a FHIR foundation resource from JSON
         
         Args:
-            json_data: JSON string or dictionary containing FHIR resource
+            json_data: JSON string, bytes-like object or dictionary containing FHIR resource
             resource_type: Optional resource type hint
             
         Returns:
@@ -194,9 +202,12 @@ class FHIRFoundationDeserializer:
             FHIRFoundationDeserializationError: If deserialization fails
         """
         try:
-            # Parse JSON if string
-            if isinstance(json_data, str):
-                data = json.loads(json_data)
+            # Parse JSON if text or bytes; the C path also checks required members, codes and JSON kinds
+            if isinstance(json_data, (str, bytes, bytearray, memoryview)):
+                if self.use_c_validation:
+                    data = fhir_parser_c.parse_validated(json_data, resource_type)
+                else:
+                    data = json.loads(bytes(json_data) if isinstance(json_data, memoryview) else json_data)
             else:
                 data = json_data.copy()
             
@@ -332,13 +343,13 @@ class FHIRFoundationDeserializer:
 
 # Convenience functions for direct use
 def deserialize_patient(json_data: Union[str, Dict[str, Any]], 
-                       use_pydantic_validation: bool = True) -> Patient:
+                       use_pydantic_validation: bool = False) -> Patient:
     """
     Convenience function to deserialize a Patient resource
     
     Args:
         json_data: JSON string or dictionary containing Patient resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         Patient resource object
@@ -348,13 +359,13 @@ def deserialize_patient(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_practitioner(json_data: Union[str, Dict[str, Any]], 
-                           use_pydantic_validation: bool = True) -> Practitioner:
+                           use_pydantic_validation: bool = False) -> Practitioner:
     """
     Convenience function to deserialize a Practitioner resource
     
     Args:
         json_data: JSON string or dictionary containing Practitioner resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         Practitioner resource object
@@ -364,13 +375,13 @@ def deserialize_practitioner(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_practitioner_role(json_data: Union[str, Dict[str, Any]], 
-                                 use_pydantic_validation: bool = True) -> PractitionerRole:
+                                 use_pydantic_validation: bool = False) -> PractitionerRole:
     """
     Convenience function to deserialize a PractitionerRole resource
     
     Args:
         json_data: JSON string or dictionary containing PractitionerRole resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         PractitionerRole resource object
@@ -380,13 +391,13 @@ def deserialize_practitioner_role(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_encounter(json_data: Union[str, Dict[str, Any]], 
-                         use_pydantic_validation: bool = True) -> Encounter:
+                         use_pydantic_validation: bool = False) -> Encounter:
     """
     Convenience function to deserialize an Encounter resource
     
     Args:
         json_data: JSON string or dictionary containing Encounter resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         Encounter resource object
@@ -396,13 +407,13 @@ def deserialize_encounter(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_person(json_data: Union[str, Dict[str, Any]], 
-                      use_pydantic_validation: bool = True) -> Person:
+                      use_pydantic_validation: bool = False) -> Person:
     """
     Convenience function to deserialize a Person resource
     
     Args:
         json_data: JSON string or dictionary containing Person resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         Person resource object
@@ -412,13 +423,13 @@ def deserialize_person(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_related_person(json_data: Union[str, Dict[str, Any]], 
-                              use_pydantic_validation: bool = True) -> RelatedPerson:
+                              use_pydantic_validation: bool = False) -> RelatedPerson:
     """
     Convenience function to deserialize a RelatedPerson resource
     
     Args:
         json_data: JSON string or dictionary containing RelatedPerson resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         RelatedPerson resource object
@@ -428,13 +439,13 @@ def deserialize_related_person(json_data: Union[str, Dict[str, Any]],
 
 
 def deserialize_group(json_data: Union[str, Dict[str, Any]], 
-                     use_pydantic_validation: bool = True) -> Group:
+                     use_pydantic_validation: bool = False) -> Group:
     """
     Convenience function to deserialize a Group resource
     
     Args:
         json_data: JSON string or dictionary containing Group resource
-        use_pydantic_validation: Whether to use Pydantic validation
+        use_pydantic_validation: Whether to also run strict Pydantic validation
         
     Returns:
         Group resource object
@@ -0,0 +1,434 @@
+/**
+ * @file fhir_base64.c
+ * @brief Streaming base64 encode/decode with AVX2 and NEON kernels
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_base64.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FHIR_BASE64_AVX2 1
+#define FHIR_BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FHIR_BASE64_NEON 1
+#endif
+
+#define INVALID 0xFF
+
+static const char g_alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Sextet + 1 of each alphabet character; the zero default marks everything else
+static const uint8_t g_decode[256] = {
+    ['A'] = 1, ['B'] = 2, ['C'] = 3, ['D'] = 4, ['E'] = 5, ['F'] = 6, ['G'] = 7, ['H'] = 8,
+    ['I'] = 9, ['J'] = 10, ['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15, ['P'] = 16,
+    ['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20, ['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24,
+    ['Y'] = 25, ['Z'] = 26, ['a'] = 27, ['b'] = 28, ['c'] = 29, ['d'] = 30, ['e'] = 31, ['f'] = 32,
+    ['g'] = 33, ['h'] = 34, ['i'] = 35, ['j'] = 36, ['k'] = 37, ['l'] = 38, ['m'] = 39, ['n'] = 40,
+    ['o'] = 41, ['p'] = 42, ['q'] = 43, ['r'] = 44, ['s'] = 45, ['t'] = 46, ['u'] = 47, ['v'] = 48,
+    ['w'] = 49, ['x'] = 50, ['y'] = 51, ['z'] = 52, ['0'] = 53, ['1'] = 54, ['2'] = 55, ['3'] = 56,
+    ['4'] = 57, ['5'] = 58, ['6'] = 59, ['7'] = 60, ['8'] = 61, ['9'] = 62, ['+'] = 63, ['/'] = 64
+};
+
+// Sextet of c, or INVALID
+static inline uint8_t sextet(uint8_t c) {
+    return (uint8_t)(g_decode[c] - 1);
+}
+
+/* ========================================================================== */
+/* Kernels                                                                    */
+/* ========================================================================== */
+
+#if defined(FHIR_BASE64_AVX2)
+static FHIRAtomicInt g_avx2;    // 0 = not yet checked, 1 = unsupported, 2 = supported
+
+static bool use_avx2(void) {
+    int state = fhir_atomic_load(&g_avx2);
+    if (state == 0) {
+        __builtin_cpu_init();
+        state = __builtin_cpu_supports("avx2") ? 2 : 1;
+        fhir_atomic_store(&g_avx2, state);
+    }
+    return state == 2;
+}
+
+/**
+ * Translate and pack 32 characters per iteration: nibble lookups flag
+ * non-alphabet bytes and select the offset to each sextet, multiply-adds
+ * merge four sextets into three bytes. Stops before the first block that
+ * holds anything but alphabet characters.
+ */
+FHIR_BASE64_TARGET_AVX2
+static size_t decode_avx2(const uint8_t* in, size_t length, uint8_t* out) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack_shuffle = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+    size_t used = 0;
+    while (length - used >= 32) {
+        __m256i str = _mm256_loadu_si256((const __m256i*)(in + used));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) break;
+
+        __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack_shuffle);
+        str = _mm256_permutevar8x32_epi32(str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+        uint8_t* dest = out + used / 4 * 3;
+        _mm_storeu_si128((__m128i*)dest, _mm256_castsi256_si128(str));
+        _mm_storel_epi64((__m128i*)(dest + 16), _mm256_extracti128_si256(str, 1));
+        used += 32;
+    }
+    return used;
+}
+
+/**
+ * Encode 24 bytes per iteration: each 128-bit lane takes 12 bytes, a
+ * shuffle lines up the 6-bit fields and multiplies shift them into place,
+ * and a 16-entry table maps sextet ranges to their ASCII offsets.
+ */
+FHIR_BASE64_TARGET_AVX2
+static size_t encode_avx2(const uint8_t* in, size_t length, char* out) {
+    const __m256i spread = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shift_lut = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t used = 0;
+    // The upper lane loads 16 bytes from offset 12, so 28 must be readable
+    while (length - used >= 28) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(in + used));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(in + used + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, spread);
+
+        __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        __m256i result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, range), indices);
+
+        _mm256_storeu_si256((__m256i*)(out + used / 3 * 4), result);
+        used += 24;
+    }
+    return used;
+}
+#endif
+
+#if defined(FHIR_BASE64_NEON)
+static inline uint8x16_t neon_sextets(uint8x16_t c, uint8x16_t* invalid) {
+    uint8x16_t upper = vsubq_u8(c, vdupq_n_u8('A'));
+    uint8x16_t lower = vsubq_u8(c, vdupq_n_u8('a'));
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t is_upper = vcltq_u8(upper, vdupq_n_u8(26));
+    uint8x16_t is_lower = vcltq_u8(lower, vdupq_n_u8(26));
+    uint8x16_t is_digit = vcltq_u8(digit, vdupq_n_u8(10));
+    uint8x16_t is_plus = vceqq_u8(c, vdupq_n_u8('+'));
+    uint8x16_t is_slash = vceqq_u8(c, vdupq_n_u8('/'));
+
+    uint8x16_t value = vandq_u8(upper, is_upper);
+    value = vorrq_u8(value, vandq_u8(vaddq_u8(lower, vdupq_n_u8(26)), is_lower));
+    value = vorrq_u8(value, vandq_u8(vaddq_u8(digit, vdupq_n_u8(52)), is_digit));
+    value = vorrq_u8(value, vandq_u8(vdupq_n_u8(62), is_plus));
+    value = vorrq_u8(value, vandq_u8(vdupq_n_u8(63), is_slash));
+
+    uint8x16_t valid = vorrq_u8(vorrq_u8(is_upper, is_lower), vorrq_u8(is_digit, vorrq_u8(is_plus, is_slash)));
+    *invalid = vorrq_u8(*invalid, vmvnq_u8(valid));
+    return value;
+}
+
+// 64 characters per iteration; vld4/vst3 do the quad (de)interleaving
+static size_t decode_neon(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t used = 0;
+    while (length - used >= 64) {
+        uint8x16x4_t chars = vld4q_u8(in + used);
+        uint8x16_t invalid = vdupq_n_u8(0);
+        uint8x16_t a = neon_sextets(chars.val[0], &invalid);
+        uint8x16_t b = neon_sextets(chars.val[1], &invalid);
+        uint8x16_t c = neon_sextets(chars.val[2], &invalid);
+        uint8x16_t d = neon_sextets(chars.val[3], &invalid);
+        if (vmaxvq_u8(invalid)) break;
+
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(out + used / 4 * 3, bytes);
+        used += 64;
+    }
+    return used;
+}
+
+// 48 bytes per iteration; the alphabet is one 64-entry table lookup
+static size_t encode_neon(const uint8_t* in, size_t length, char* out) {
+    const uint8_t* alphabet = (const uint8_t*)g_alphabet;
+    uint8x16x4_t table = {{
+        vld1q_u8(alphabet), vld1q_u8(alphabet + 16), vld1q_u8(alphabet + 32), vld1q_u8(alphabet + 48)
+    }};
+    uint8x16_t mask = vdupq_n_u8(0x3f);
+
+    size_t used = 0;
+    while (length - used >= 48) {
+        uint8x16x3_t bytes = vld3q_u8(in + used);
+        uint8x16x4_t chars;
+        chars.val[0] = vshrq_n_u8(bytes.val[0], 2);
+        chars.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[0], 4), vshrq_n_u8(bytes.val[1], 4)), mask);
+        chars.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[1], 2), vshrq_n_u8(bytes.val[2], 6)), mask);
+        chars.val[3] = vandq_u8(bytes.val[2], mask);
+        for (int i = 0; i < 4; i++) {
+            chars.val[i] = vqtbl4q_u8(table, chars.val[i]);
+        }
+        vst4q_u8((uint8_t*)out + used / 3 * 4, chars);
+        used += 48;
+    }
+    return used;
+}
+#endif
+
+// Decode whole quads of alphabet characters; returns the characters consumed
+static size_t decode_quads(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t used = 0;
+#if defined(FHIR_BASE64_AVX2)
+    if (use_avx2()) used = decode_avx2(in, length, out);
+#elif defined(FHIR_BASE64_NEON)
+    used = decode_neon(in, length, out);
+#endif
+    while (length - used >= 4) {
+        uint32_t a = sextet(in[used]);
+        uint32_t b = sextet(in[used + 1]);
+        uint32_t c = sextet(in[used + 2]);
+        uint32_t d = sextet(in[used + 3]);
+        if ((a | b | c | d) > 63) break;
+        uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+        uint8_t* dest = out + used / 4 * 3;
+        dest[0] = (uint8_t)(bits >> 16);
+        dest[1] = (uint8_t)(bits >> 8);
+        dest[2] = (uint8_t)bits;
+        used += 4;
+    }
+    return used;
+}
+
+// Encode whole 3-byte groups; returns the bytes consumed
+static size_t encode_groups(const uint8_t* in, size_t length, char* out) {
+    size_t used = 0;
+#if defined(FHIR_BASE64_AVX2)
+    if (use_avx2()) used = encode_avx2(in, length, out);
+#elif defined(FHIR_BASE64_NEON)
+    used = encode_neon(in, length, out);
+#endif
+    while (length - used >= 3) {
+        uint32_t bits = ((uint32_t)in[used] << 16) | ((uint32_t)in[used + 1] << 8) | in[used + 2];
+        char* dest = out + used / 3 * 4;
+        dest[0] = g_alphabet[bits >> 18];
+        dest[1] = g_alphabet[(bits >> 12) & 0x3f];
+        dest[2] = g_alphabet[(bits >> 6) & 0x3f];
+        dest[3] = g_alphabet[bits & 0x3f];
+        used += 3;
+    }
+    return used;
+}
+
+/* ========================================================================== */
+/* Sizes                                                                      */
+/* ========================================================================== */
+
+size_t fhir_base64_encoded_length(size_t length) {
+    return (length + 2) / 3 * 4;
+}
+
+size_t fhir_base64_decoded_max_length(size_t length) {
+    return (length + 3) / 4 * 3;
+}
+
+const char* fhir_base64_backend(void) {
+#if defined(FHIR_BASE64_AVX2)
+    return use_avx2() ? "avx2" : "scalar";
+#elif defined(FHIR_BASE64_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+/* ========================================================================== */
+/* Decoding                                                                   */
+/* ========================================================================== */
+
+void fhir_base64_decoder_init(FHIRBase64Decoder* decoder) {
+    if (decoder) memset(decoder, 0, sizeof(*decoder));
+}
+
+static bool emit(FHIRBase64Decoder* decoder, const uint8_t* bytes, size_t count,
+                 uint8_t* out, size_t capacity, size_t* written) {
+    if (capacity - *written < count) {
+        decoder->failed = true;
+        return false;
+    }
+    memcpy(out + *written, bytes, count);
+    *written += count;
+    return true;
+}
+
+bool fhir_base64_decoder_update(FHIRBase64Decoder* decoder, const char* text, size_t length,
+                                uint8_t* out, size_t capacity, size_t* written) {
+    *written = 0;
+    if (!decoder || (!text && length) || decoder->failed) {
+        if (decoder) decoder->failed = true;
+        return false;
+    }
+
+    const uint8_t* p = (const uint8_t*)text;
+    const uint8_t* end = p + length;
+    while (p < end) {
+        // Between quads, hand whole runs of alphabet characters to the kernels
+        if (decoder->pending == 0 && decoder->padding == 0) {
+            size_t chars = (size_t)(end - p);
+            size_t room = (capacity - *written) / 3 * 4;
+            size_t used = decode_quads(p, chars < room ? chars : room, out + *written);
+            p += used;
+            *written += used / 4 * 3;
+            if (p == end) break;
+        }
+
+        uint8_t c = *p++;
+        uint8_t value = sextet(c);
+        if (value != INVALID) {
+            if (decoder->padding) goto invalid;
+            decoder->bits = (decoder->bits << 6) | value;
+            if (++decoder->pending == 4) {
+                uint8_t bytes[3] = {
+                    (uint8_t)(decoder->bits >> 16), (uint8_t)(decoder->bits >> 8), (uint8_t)decoder->bits
+                };
+                decoder->pending = 0;
+                decoder->bits = 0;
+                if (!emit(decoder, bytes, 3, out, capacity, written)) return false;
+            }
+        } else if (c == '=') {
+            // "xx==" and "xxx=" end the data; the quad's low bits are padding
+            if (decoder->pending < 2 || decoder->pending + decoder->padding >= 4) goto invalid;
+            if (decoder->pending + ++decoder->padding == 4) {
+                uint32_t bits = decoder->bits << (6 * (4 - decoder->pending));
+                uint8_t bytes[2] = {(uint8_t)(bits >> 16), (uint8_t)(bits >> 8)};
+                size_t count = decoder->pending - 1u;
+                decoder->pending = 0;
+                decoder->bits = 0;
+                if (!emit(decoder, bytes, count, out, capacity, written)) return false;
+            }
+        } else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            goto invalid;
+        }
+    }
+    return true;
+
+invalid:
+    decoder->failed = true;
+    return false;
+}
+
+bool fhir_base64_decoder_finish(const FHIRBase64Decoder* decoder) {
+    return decoder && !decoder->failed && decoder->pending == 0;
+}
+
+bool fhir_base64_decode(const char* text, size_t length, uint8_t* out, size_t capacity, size_t* written) {
+    if (!written || (!out && capacity)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    FHIRBase64Decoder decoder;
+    fhir_base64_decoder_init(&decoder);
+    if (!fhir_base64_decoder_update(&decoder, text, length, out, capacity, written) ||
+        !fhir_base64_decoder_finish(&decoder)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid base64 data or output buffer too small");
+        return false;
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Encoding                                                                   */
+/* ========================================================================== */
+
+void fhir_base64_encoder_init(FHIRBase64Encoder* encoder) {
+    if (encoder) memset(encoder, 0, sizeof(*encoder));
+}
+
+size_t fhir_base64_encoder_update(FHIRBase64Encoder* encoder, const uint8_t* data, size_t length, char* out) {
+    if (!encoder || !data || !out) return 0;
+
+    size_t written = 0;
+    // Complete the group left over from the previous call first
+    if (encoder->count > 0) {
+        uint8_t group[3];
+        memcpy(group, encoder->pending, encoder->count);
+        size_t take = 3u - encoder->count;
+        if (length < take) {
+            memcpy(encoder->pending + encoder->count, data, length);
+            encoder->count = (uint8_t)(encoder->count + length);
+            return 0;
+        }
+        memcpy(group + encoder->count, data, take);
+        encode_groups(group, 3, out);
+        data += take;
+        length -= take;
+        written = 4;
+        encoder->count = 0;
+    }
+
+    size_t used = encode_groups(data, length, out + written);
+    written += used / 3 * 4;
+    encoder->count = (uint8_t)(length - used);
+    memcpy(encoder->pending, data + used, encoder->count);
+    return written;
+}
+
+size_t fhir_base64_encoder_finish(FHIRBase64Encoder* encoder, char* out) {
+    if (!encoder || !out || encoder->count == 0) return 0;
+
+    uint32_t bits = (uint32_t)encoder->pending[0] << 16;
+    if (encoder->count == 2) bits |= (uint32_t)encoder->pending[1] << 8;
+    out[0] = g_alphabet[bits >> 18];
+    out[1] = g_alphabet[(bits >> 12) & 0x3f];
+    out[2] = encoder->count == 2 ? g_alphabet[(bits >> 6) & 0x3f] : '=';
+    out[3] = '=';
+    encoder->count = 0;
+    return 4;
+}
+
+size_t fhir_base64_encode(const uint8_t* data, size_t length, char* out) {
+    FHIRBase64Encoder encoder;
+    fhir_base64_encoder_init(&encoder);
+    size_t written = fhir_base64_encoder_update(&encoder, data, length, out);
+    return written + fhir_base64_encoder_finish(&encoder, out + written);
+}
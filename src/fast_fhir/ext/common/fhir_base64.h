@@ -0,0 +1,161 @@
+/**
+ * @file fhir_base64.h
+ * @brief Streaming base64 encode/decode for FHIR base64Binary values
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Binary.data and Attachment.data carry whole documents (PDFs, DICOM
+ * previews) as base64 text, so these routines write straight into a caller
+ * buffer and can be fed the text in chunks. Runs of alphabet characters are
+ * translated 32 (AVX2, selected at runtime) or 64 (NEON) characters at a
+ * time; whitespace, padding and the tail go through a scalar state machine.
+ *
+ * The decoder accepts the standard alphabet with '=' padding, as FHIR
+ * base64Binary requires, and skips the whitespace the FHIR regex allows
+ * between quads (space, tab, CR, LF).
+ */
+
+#ifndef FHIR_BASE64_H
+#define FHIR_BASE64_H
+
+#include "fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Sizes                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Number of characters encoding length bytes produces (with padding)
+ * @param length Number of input bytes
+ * @return Encoded length, excluding any NUL terminator
+ */
+size_t fhir_base64_encoded_length(size_t length);
+
+/**
+ * @brief Upper bound on the bytes decoding length characters produces
+ *
+ * Also bounds one fhir_base64_decoder_update call with that many
+ * characters, including the quad carried over from the previous call.
+ *
+ * @param length Number of input characters
+ * @return Maximum decoded length
+ */
+size_t fhir_base64_decoded_max_length(size_t length);
+
+/**
+ * @brief Name of the decode/encode kernel in use ("avx2", "neon" or "scalar")
+ * @return Static name
+ */
+const char* fhir_base64_backend(void);
+
+/* ========================================================================== */
+/* Decoding                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Incremental decoder state
+ */
+typedef struct {
+    uint32_t bits;          /**< Sextets of the current quad, most recent lowest */
+    uint8_t pending;        /**< Sextets in bits (0-3) */
+    uint8_t padding;        /**< '=' characters seen; nonzero once the data has ended */
+    bool failed;            /**< Invalid input or a full output buffer */
+} FHIRBase64Decoder;
+
+/**
+ * @brief Initialize a decoder
+ * @param decoder Decoder to initialize
+ */
+void fhir_base64_decoder_init(FHIRBase64Decoder* decoder);
+
+/**
+ * @brief Decode the next chunk of base64 text
+ *
+ * Chunks may split quads anywhere. Once a call fails the decoder stays failed.
+ *
+ * @param decoder Decoder
+ * @param text Base64 text (need not be NUL-terminated)
+ * @param length Length of text
+ * @param out Output buffer
+ * @param capacity Bytes available in out; fhir_base64_decoded_max_length(length) always suffices
+ * @param written Output number of bytes written to out
+ * @return true on success, false on invalid input or if out is too small
+ */
+bool fhir_base64_decoder_update(FHIRBase64Decoder* decoder, const char* text, size_t length,
+                                uint8_t* out, size_t capacity, size_t* written);
+
+/**
+ * @brief Check that the text fed to a decoder ended on a quad boundary
+ * @param decoder Decoder
+ * @return true if every update succeeded and no partial quad is left
+ */
+bool fhir_base64_decoder_finish(const FHIRBase64Decoder* decoder);
+
+/**
+ * @brief Decode a complete base64 value
+ * @param text Base64 text (need not be NUL-terminated)
+ * @param length Length of text
+ * @param out Output buffer
+ * @param capacity Bytes available in out; fhir_base64_decoded_max_length(length) always suffices
+ * @param written Output number of bytes written to out
+ * @return true on success, false with FHIR_ERROR_INVALID_ARGUMENT otherwise
+ */
+bool fhir_base64_decode(const char* text, size_t length, uint8_t* out, size_t capacity, size_t* written);
+
+/* ========================================================================== */
+/* Encoding                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Incremental encoder state
+ */
+typedef struct {
+    uint8_t pending[2];     /**< Input bytes not yet forming a full group */
+    uint8_t count;          /**< Bytes in pending (0-2) */
+} FHIRBase64Encoder;
+
+/**
+ * @brief Initialize an encoder
+ * @param encoder Encoder to initialize
+ */
+void fhir_base64_encoder_init(FHIRBase64Encoder* encoder);
+
+/**
+ * @brief Encode the next chunk of bytes
+ * @param encoder Encoder
+ * @param data Input bytes
+ * @param length Number of input bytes
+ * @param out Output buffer of at least fhir_base64_encoded_length(length) characters
+ * @return Number of characters written (not NUL-terminated)
+ */
+size_t fhir_base64_encoder_update(FHIRBase64Encoder* encoder, const uint8_t* data, size_t length, char* out);
+
+/**
+ * @brief Flush the last partial group with padding
+ * @param encoder Encoder
+ * @param out Output buffer of at least 4 characters
+ * @return Number of characters written (0 or 4)
+ */
+size_t fhir_base64_encoder_finish(FHIRBase64Encoder* encoder, char* out);
+
+/**
+ * @brief Encode a complete value
+ * @param data Input bytes
+ * @param length Number of input bytes
+ * @param out Output buffer of at least fhir_base64_encoded_length(length) characters
+ * @return Number of characters written (not NUL-terminated)
+ */
+size_t fhir_base64_encode(const uint8_t* data, size_t length, char* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_BASE64_H */
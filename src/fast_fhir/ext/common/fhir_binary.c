@@ -0,0 +1,569 @@
+/**
+ * @file fhir_binary.c
+ * @brief Compact binary encoding implementation
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_binary.h"
+#include <string.h>
+
+#define FHIR_BINARY_INITIAL_CAPACITY 256
+#define FHIR_BINARY_INITIAL_SLOTS 64
+
+/* ========================================================================== */
+/* Byte Helpers                                                               */
+/* ========================================================================== */
+
+static void store_u16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void store_u32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t load_u16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t load_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint32_t hash_bytes(const char* value, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)value[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* ========================================================================== */
+/* Writer                                                                     */
+/* ========================================================================== */
+
+static bool writer_fail(FHIRBinaryWriter* writer, FHIRErrorCode code, const char* message) {
+    if (!writer->failed) {
+        writer->failed = true;
+        FHIR_SET_ERROR(code, message);
+    }
+    return false;
+}
+
+// Grow a buffer to hold at least needed bytes; returns the buffer or NULL (old buffer kept)
+static void* writer_grow(FHIRBinaryWriter* writer, void* buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return buffer;
+
+    size_t grown = *capacity ? *capacity : FHIR_BINARY_INITIAL_CAPACITY;
+    while (grown < needed) grown *= 2;
+    void* data = fhir_realloc(buffer, grown);
+    if (!data) {
+        writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow binary output buffer");
+        return NULL;
+    }
+    *capacity = grown;
+    return data;
+}
+
+static void write_bytes(FHIRBinaryWriter* writer, const void* data, size_t length) {
+    if (writer->failed) return;
+
+    uint8_t* body = writer_grow(writer, writer->body, &writer->body_capacity, writer->body_length + length);
+    if (!body) return;
+    writer->body = body;
+    memcpy(writer->body + writer->body_length, data, length);
+    writer->body_length += length;
+}
+
+static void write_varint(FHIRBinaryWriter* writer, uint64_t value) {
+    uint8_t bytes[10];
+    size_t length = 0;
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        bytes[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    write_bytes(writer, bytes, length);
+}
+
+static void write_key(FHIRBinaryWriter* writer, uint32_t field, FHIRBinaryWireType wire_type) {
+    write_varint(writer, ((uint64_t)field << 3) | wire_type);
+}
+
+static bool string_table_rehash(FHIRBinaryWriter* writer, size_t slot_capacity) {
+    uint32_t* slots = fhir_calloc(slot_capacity, sizeof(uint32_t));
+    if (!slots) {
+        return writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow binary string table");
+    }
+    for (size_t i = 0; i < writer->string_count; i++) {
+        const char* value = writer->strings + writer->offsets[i];
+        size_t slot = hash_bytes(value, strlen(value)) & (slot_capacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (slot_capacity - 1);
+        slots[slot] = (uint32_t)i + 1;
+    }
+    fhir_free(writer->slots);
+    writer->slots = slots;
+    writer->slot_capacity = slot_capacity;
+    return true;
+}
+
+// Index of value in the string table, adding it on first use
+static uint32_t intern_string(FHIRBinaryWriter* writer, const char* value) {
+    size_t length = strlen(value);
+    uint32_t hash = hash_bytes(value, length);
+    size_t mask = writer->slot_capacity - 1;
+
+    size_t slot = hash & mask;
+    while (writer->slots[slot]) {
+        uint32_t index = writer->slots[slot] - 1;
+        const char* existing = writer->strings + writer->offsets[index];
+        if (strncmp(existing, value, length) == 0 && existing[length] == '\0') {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (writer->string_bytes + length + 1 > UINT32_MAX || writer->string_count >= UINT32_MAX - 1) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Binary string table is full");
+        return FHIR_BINARY_NO_STRING;
+    }
+    char* strings = writer_grow(writer, writer->strings, &writer->string_capacity,
+                                writer->string_bytes + length + 1);
+    if (!strings) return FHIR_BINARY_NO_STRING;
+    writer->strings = strings;
+    uint32_t* offsets = writer_grow(writer, writer->offsets, &writer->offset_capacity,
+                                    (writer->string_count + 1) * sizeof(uint32_t));
+    if (!offsets) return FHIR_BINARY_NO_STRING;
+    writer->offsets = offsets;
+
+    uint32_t index = (uint32_t)writer->string_count++;
+    writer->offsets[index] = (uint32_t)writer->string_bytes;
+    memcpy(writer->strings + writer->string_bytes, value, length + 1);
+    writer->string_bytes += length + 1;
+    writer->slots[slot] = index + 1;
+
+    // Keep the table at most half full
+    if (writer->string_count * 2 > writer->slot_capacity) {
+        string_table_rehash(writer, writer->slot_capacity * 2);
+    }
+    return index;
+}
+
+bool fhir_binary_writer_init(FHIRBinaryWriter* writer, int resource_type, const char* id) {
+    if (!writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    memset(writer, 0, sizeof(FHIRBinaryWriter));
+    writer->resource_type = (uint16_t)resource_type;
+    writer->id = FHIR_BINARY_NO_STRING;
+
+    writer->slots = fhir_calloc(FHIR_BINARY_INITIAL_SLOTS, sizeof(uint32_t));
+    if (!writer->slots) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate binary string table");
+        return false;
+    }
+    writer->slot_capacity = FHIR_BINARY_INITIAL_SLOTS;
+
+    if (id) {
+        writer->id = intern_string(writer, id);
+    }
+    return !writer->failed;
+}
+
+void fhir_binary_writer_cleanup(FHIRBinaryWriter* writer) {
+    if (!writer) return;
+
+    fhir_free(writer->body);
+    fhir_free(writer->strings);
+    fhir_free(writer->offsets);
+    fhir_free(writer->slots);
+    memset(writer, 0, sizeof(FHIRBinaryWriter));
+}
+
+uint8_t* fhir_binary_writer_finish(FHIRBinaryWriter* writer, size_t* length) {
+    if (!writer || !length) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    if (writer->failed) return NULL;
+    if (writer->depth != 0) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Unclosed binary message");
+        return NULL;
+    }
+    if (writer->body_length > UINT32_MAX) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Binary resource is too large");
+        return NULL;
+    }
+
+    size_t offsets_size = writer->string_count * sizeof(uint32_t);
+    size_t size = FHIR_BINARY_HEADER_SIZE + offsets_size + writer->string_bytes + writer->body_length;
+    uint8_t* data = fhir_malloc(size);
+    if (!data) {
+        writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate binary resource");
+        return NULL;
+    }
+
+    memcpy(data, FHIR_BINARY_MAGIC, 4);
+    data[4] = FHIR_BINARY_VERSION;
+    data[5] = writer->flags;
+    store_u16(data + 6, writer->resource_type);
+    store_u32(data + 8, writer->id);
+    store_u32(data + 12, (uint32_t)writer->string_count);
+    store_u32(data + 16, (uint32_t)writer->string_bytes);
+    store_u32(data + 20, (uint32_t)writer->body_length);
+
+    uint8_t* out = data + FHIR_BINARY_HEADER_SIZE;
+    for (size_t i = 0; i < writer->string_count; i++, out += 4) {
+        store_u32(out, writer->offsets[i]);
+    }
+    if (writer->string_bytes) memcpy(out, writer->strings, writer->string_bytes);
+    out += writer->string_bytes;
+    if (writer->body_length) memcpy(out, writer->body, writer->body_length);
+
+    *length = size;
+    return data;
+}
+
+void fhir_binary_write_uint(FHIRBinaryWriter* writer, uint32_t field, uint64_t value) {
+    write_key(writer, field, FHIR_BINARY_WIRE_VARINT);
+    write_varint(writer, value);
+}
+
+void fhir_binary_write_bool(FHIRBinaryWriter* writer, uint32_t field, bool value) {
+    fhir_binary_write_uint(writer, field, value ? 1 : 0);
+}
+
+void fhir_binary_write_double(FHIRBinaryWriter* writer, uint32_t field, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[8];
+    store_u32(bytes, (uint32_t)bits);
+    store_u32(bytes + 4, (uint32_t)(bits >> 32));
+
+    write_key(writer, field, FHIR_BINARY_WIRE_DOUBLE);
+    write_bytes(writer, bytes, sizeof(bytes));
+}
+
+void fhir_binary_write_string(FHIRBinaryWriter* writer, uint32_t field, const char* value) {
+    if (!value || writer->failed) return;
+
+    uint32_t index = intern_string(writer, value);
+    write_key(writer, field, FHIR_BINARY_WIRE_STRING);
+    write_varint(writer, index);
+}
+
+void fhir_binary_begin_message(FHIRBinaryWriter* writer, uint32_t field) {
+    if (writer->failed) return;
+    if (writer->depth >= FHIR_BINARY_MAX_DEPTH) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Binary nesting too deep");
+        return;
+    }
+
+    // Length is patched by fhir_binary_end_message
+    static const uint8_t placeholder[4] = {0};
+    write_key(writer, field, FHIR_BINARY_WIRE_MESSAGE);
+    writer->messages[writer->depth++] = writer->body_length;
+    write_bytes(writer, placeholder, sizeof(placeholder));
+}
+
+void fhir_binary_end_message(FHIRBinaryWriter* writer) {
+    if (writer->failed) return;
+    if (writer->depth == 0) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "No open binary message");
+        return;
+    }
+
+    size_t start = writer->messages[--writer->depth];
+    size_t length = writer->body_length - start - 4;
+    if (length > UINT32_MAX) {
+        writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Binary message is too large");
+        return;
+    }
+    store_u32(writer->body + start, (uint32_t)length);
+}
+
+static void write_json_value(FHIRBinaryWriter* writer, const cJSON* item);
+
+static void write_json_children(FHIRBinaryWriter* writer, const cJSON* container, bool with_keys) {
+    const cJSON* child;
+    cJSON_ArrayForEach(child, container) {
+        if (with_keys) {
+            fhir_binary_write_string(writer, FHIR_BINARY_JSON_KEY, child->string ? child->string : "");
+        }
+        write_json_value(writer, child);
+    }
+}
+
+static void write_json_value(FHIRBinaryWriter* writer, const cJSON* item) {
+    if (cJSON_IsObject(item) || cJSON_IsArray(item)) {
+        bool is_object = cJSON_IsObject(item);
+        fhir_binary_begin_message(writer, is_object ? FHIR_BINARY_JSON_OBJECT : FHIR_BINARY_JSON_ARRAY);
+        write_json_children(writer, item, is_object);
+        fhir_binary_end_message(writer);
+    } else if (cJSON_IsBool(item)) {
+        fhir_binary_write_bool(writer, FHIR_BINARY_JSON_BOOL, cJSON_IsTrue(item));
+    } else if (cJSON_IsNumber(item)) {
+        fhir_binary_write_double(writer, FHIR_BINARY_JSON_NUMBER, item->valuedouble);
+    } else if (cJSON_IsString(item)) {
+        fhir_binary_write_string(writer, FHIR_BINARY_JSON_STRING, item->valuestring);
+    } else {
+        fhir_binary_write_uint(writer, FHIR_BINARY_JSON_NULL, 0);
+    }
+}
+
+bool fhir_binary_write_json_members(FHIRBinaryWriter* writer, const cJSON* object) {
+    if (!writer || !cJSON_IsObject(object)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    write_json_children(writer, object, true);
+    return !writer->failed;
+}
+
+/* ========================================================================== */
+/* Reader                                                                     */
+/* ========================================================================== */
+
+static bool malformed(void) {
+    FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed binary resource");
+    return false;
+}
+
+bool fhir_binary_open(FHIRBinaryDocument* document, const void* data, size_t length) {
+    if (!document || !data) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const uint8_t* bytes = data;
+    if (length < FHIR_BINARY_HEADER_SIZE || memcmp(bytes, FHIR_BINARY_MAGIC, 4) != 0) {
+        return malformed();
+    }
+    if (bytes[4] != FHIR_BINARY_VERSION) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Unsupported binary format version");
+        return false;
+    }
+
+    uint32_t string_count = load_u32(bytes + 12);
+    uint32_t string_bytes = load_u32(bytes + 16);
+    uint32_t body_length = load_u32(bytes + 20);
+    uint64_t size = (uint64_t)FHIR_BINARY_HEADER_SIZE + (uint64_t)string_count * 4 + string_bytes + body_length;
+    if (size > length) {
+        return malformed();
+    }
+    // Every string ends inside the table once the table ends with a NUL
+    if (string_count > 0 &&
+        (string_bytes == 0 || bytes[FHIR_BINARY_HEADER_SIZE + (size_t)string_count * 4 + string_bytes - 1] != '\0')) {
+        return malformed();
+    }
+
+    document->data = bytes;
+    document->size = (size_t)size;
+    document->flags = bytes[5];
+    document->resource_type = load_u16(bytes + 6);
+    document->id = load_u32(bytes + 8);
+    document->string_count = string_count;
+    document->offsets = bytes + FHIR_BINARY_HEADER_SIZE;
+    document->strings = (const char*)document->offsets + (size_t)string_count * 4;
+    document->string_bytes = string_bytes;
+    document->body = (const uint8_t*)document->strings + string_bytes;
+    document->body_length = body_length;
+
+    if (document->id != FHIR_BINARY_NO_STRING && !fhir_binary_get_string(document, document->id)) {
+        return malformed();
+    }
+    return true;
+}
+
+const char* fhir_binary_get_string(const FHIRBinaryDocument* document, uint32_t index) {
+    if (!document || index >= document->string_count) return NULL;
+
+    uint32_t offset = load_u32(document->offsets + (size_t)index * 4);
+    return offset < document->string_bytes ? document->strings + offset : NULL;
+}
+
+const char* fhir_binary_get_id(const FHIRBinaryDocument* document) {
+    return document ? fhir_binary_get_string(document, document->id) : NULL;
+}
+
+void fhir_binary_reader_init(FHIRBinaryReader* reader, const FHIRBinaryDocument* document) {
+    memset(reader, 0, sizeof(FHIRBinaryReader));
+    reader->document = document;
+    reader->position = document->body;
+    reader->end = document->body + document->body_length;
+}
+
+static bool read_varint(FHIRBinaryReader* reader, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->position >= reader->end) return false;
+        uint8_t byte = *reader->position++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool reader_fail(FHIRBinaryReader* reader) {
+    reader->failed = true;
+    reader->position = reader->end;
+    return malformed();
+}
+
+bool fhir_binary_reader_next(FHIRBinaryReader* reader) {
+    if (!reader || reader->failed || reader->position >= reader->end) return false;
+
+    uint64_t key;
+    if (!read_varint(reader, &key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX) {
+        return reader_fail(reader);
+    }
+    reader->field = (uint32_t)(key >> 3);
+    reader->wire_type = (FHIRBinaryWireType)(key & 7);
+
+    switch (reader->wire_type) {
+        case FHIR_BINARY_WIRE_VARINT:
+            if (!read_varint(reader, &reader->uint_value)) return reader_fail(reader);
+            return true;
+
+        case FHIR_BINARY_WIRE_STRING: {
+            uint64_t index;
+            if (!read_varint(reader, &index) || index > UINT32_MAX) return reader_fail(reader);
+            reader->string_value = fhir_binary_get_string(reader->document, (uint32_t)index);
+            if (!reader->string_value) return reader_fail(reader);
+            return true;
+        }
+
+        case FHIR_BINARY_WIRE_DOUBLE: {
+            if (reader->end - reader->position < 8) return reader_fail(reader);
+            uint64_t bits = load_u32(reader->position) | ((uint64_t)load_u32(reader->position + 4) << 32);
+            memcpy(&reader->double_value, &bits, sizeof(bits));
+            reader->position += 8;
+            return true;
+        }
+
+        case FHIR_BINARY_WIRE_MESSAGE: {
+            if (reader->end - reader->position < 4) return reader_fail(reader);
+            uint32_t length = load_u32(reader->position);
+            reader->position += 4;
+            if ((size_t)(reader->end - reader->position) < length) return reader_fail(reader);
+            reader->message = reader->position;
+            reader->message_length = length;
+            reader->position += length;
+            return true;
+        }
+
+        default:
+            return reader_fail(reader);
+    }
+}
+
+bool fhir_binary_reader_find(FHIRBinaryReader* reader, uint32_t field) {
+    while (fhir_binary_reader_next(reader)) {
+        if (reader->field == field) return true;
+    }
+    return false;
+}
+
+void fhir_binary_reader_enter(const FHIRBinaryReader* reader, FHIRBinaryReader* child) {
+    memset(child, 0, sizeof(FHIRBinaryReader));
+    child->document = reader->document;
+    if (reader->wire_type == FHIR_BINARY_WIRE_MESSAGE) {
+        child->position = reader->message;
+        child->end = reader->message + reader->message_length;
+    }
+}
+
+static cJSON* read_json_value(FHIRBinaryReader* reader, int depth);
+
+// Fill an object or array from the fields of a message
+static bool read_json_children(FHIRBinaryReader* reader, cJSON* container, int depth) {
+    bool is_object = cJSON_IsObject(container);
+    while (fhir_binary_reader_next(reader)) {
+        const char* key = NULL;
+        if (is_object) {
+            if (reader->field != FHIR_BINARY_JSON_KEY || reader->wire_type != FHIR_BINARY_WIRE_STRING) {
+                return reader_fail(reader);
+            }
+            key = reader->string_value;
+            if (!fhir_binary_reader_next(reader)) return reader_fail(reader);
+        }
+
+        cJSON* value = read_json_value(reader, depth);
+        if (!value) return false;
+        if (is_object) {
+            cJSON_AddItemToObject(container, key, value);
+        } else {
+            cJSON_AddItemToArray(container, value);
+        }
+    }
+    return !reader->failed;
+}
+
+static cJSON* read_json_value(FHIRBinaryReader* reader, int depth) {
+    cJSON* value = NULL;
+    switch (reader->field) {
+        case FHIR_BINARY_JSON_NULL:
+            value = cJSON_CreateNull();
+            break;
+        case FHIR_BINARY_JSON_BOOL:
+            value = cJSON_CreateBool(reader->uint_value != 0);
+            break;
+        case FHIR_BINARY_JSON_NUMBER:
+            if (reader->wire_type != FHIR_BINARY_WIRE_DOUBLE) break;
+            value = cJSON_CreateNumber(reader->double_value);
+            break;
+        case FHIR_BINARY_JSON_STRING:
+            if (reader->wire_type != FHIR_BINARY_WIRE_STRING) break;
+            value = cJSON_CreateString(reader->string_value);
+            break;
+        case FHIR_BINARY_JSON_OBJECT:
+        case FHIR_BINARY_JSON_ARRAY: {
+            if (reader->wire_type != FHIR_BINARY_WIRE_MESSAGE || depth >= FHIR_BINARY_MAX_DEPTH) break;
+            value = reader->field == FHIR_BINARY_JSON_OBJECT ? cJSON_CreateObject() : cJSON_CreateArray();
+            FHIRBinaryReader child;
+            fhir_binary_reader_enter(reader, &child);
+            if (value && !read_json_children(&child, value, depth + 1)) {
+                cJSON_Delete(value);
+                return NULL;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (!value) {
+        reader_fail(reader);
+    }
+    return value;
+}
+
+cJSON* fhir_binary_to_json(const FHIRBinaryDocument* document) {
+    if (!document || !(document->flags & FHIR_BINARY_FLAG_JSON)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Not a JSON binary document");
+        return NULL;
+    }
+
+    cJSON* json = cJSON_CreateObject();
+    if (!json) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate JSON object");
+        return NULL;
+    }
+    FHIRBinaryReader reader;
+    fhir_binary_reader_init(&reader, document);
+    if (!read_json_children(&reader, json, 1)) {
+        cJSON_Delete(json);
+        return NULL;
+    }
+    return json;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file fhir_binary.h
+ * @brief Compact binary encoding for cached FHIR resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * A versioned tag-length-value format with an interned string table. Every
+ * distinct string of a resource is stored once, NUL-terminated, and fields
+ * refer to it by index, so repeated codes and systems cost a byte or two.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header    "FHRB", version u8, flags u8, resource type u16, id string u32,
+ *             string count u32, string bytes u32, body bytes u32
+ *   offsets   u32 per string, relative to the start of the string data
+ *   strings   NUL-terminated UTF-8
+ *   body      fields: varint key (field << 3 | wire type), then the value
+ *
+ * Resources encode their own fields through the vtable's to_binary method;
+ * field numbers are per resource type and unknown fields are skipped on
+ * read, so old readers accept newer documents. Types without to_binary are
+ * stored as their JSON tree (FHIR_BINARY_FLAG_JSON).
+ *
+ * A document can be read in place (e.g. from an mmap'ed cache file): the
+ * reader hands out string pointers into the buffer and never allocates.
+ */
+
+#ifndef FHIR_BINARY_H
+#define FHIR_BINARY_H
+
+#include "fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Format                                                                     */
+/* ========================================================================== */
+
+#define FHIR_BINARY_MAGIC "FHRB"
+#define FHIR_BINARY_VERSION 1
+#define FHIR_BINARY_HEADER_SIZE 24
+#define FHIR_BINARY_MAX_DEPTH 64
+
+/** String index of an absent string (e.g. a resource without an id) */
+#define FHIR_BINARY_NO_STRING UINT32_MAX
+
+/** Header flag: the body is the resource's JSON tree (see FHIRBinaryJSONField) */
+#define FHIR_BINARY_FLAG_JSON 0x01
+
+/**
+ * @brief How a field value is stored
+ */
+typedef enum {
+    FHIR_BINARY_WIRE_VARINT = 0,    /**< LEB128 unsigned integer (bools, enums, counts) */
+    FHIR_BINARY_WIRE_STRING = 1,    /**< Varint index into the string table */
+    FHIR_BINARY_WIRE_DOUBLE = 2,    /**< 8-byte IEEE 754 value */
+    FHIR_BINARY_WIRE_MESSAGE = 3    /**< u32 length, then nested fields */
+} FHIRBinaryWireType;
+
+/**
+ * @brief Field numbers of the generic JSON encoding
+ *
+ * An object is a run of KEY fields each followed by one value field; an
+ * array is a run of value fields.
+ */
+typedef enum {
+    FHIR_BINARY_JSON_KEY = 1,
+    FHIR_BINARY_JSON_NULL,
+    FHIR_BINARY_JSON_BOOL,
+    FHIR_BINARY_JSON_NUMBER,
+    FHIR_BINARY_JSON_STRING,
+    FHIR_BINARY_JSON_OBJECT,
+    FHIR_BINARY_JSON_ARRAY
+} FHIRBinaryJSONField;
+
+/* ========================================================================== */
+/* Writer                                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Binary document writer
+ *
+ * Lives in caller storage. Like FHIRWriter, the first failure is sticky, so
+ * an encoder can issue a run of calls and check fhir_binary_writer_finish.
+ */
+typedef struct FHIRBinaryWriter {
+    uint8_t* body;                  /**< Encoded fields */
+    size_t body_length;
+    size_t body_capacity;
+    char* strings;                  /**< String data, NUL-terminated entries */
+    size_t string_bytes;
+    size_t string_capacity;
+    uint32_t* offsets;              /**< Start of each string in strings */
+    size_t string_count;
+    size_t offset_capacity;
+    uint32_t* slots;                /**< Open-addressing string table (index + 1, 0 = empty) */
+    size_t slot_capacity;
+    size_t messages[FHIR_BINARY_MAX_DEPTH];  /**< Body offset of each open message length */
+    int depth;
+    uint16_t resource_type;
+    uint8_t flags;
+    uint32_t id;                    /**< String index of the resource id */
+    bool failed;
+} FHIRBinaryWriter;
+
+/**
+ * @brief Initialize a writer for one resource
+ * @param writer Writer to initialize
+ * @param resource_type Resource type stored in the header
+ * @param id Resource id stored in the header (can be NULL)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_binary_writer_init(FHIRBinaryWriter* writer, int resource_type, const char* id);
+
+/**
+ * @brief Free the writer's buffers
+ * @param writer Writer instance
+ */
+void fhir_binary_writer_cleanup(FHIRBinaryWriter* writer);
+
+/**
+ * @brief Assemble the document
+ *
+ * The returned buffer is released with fhir_free; the writer still needs
+ * fhir_binary_writer_cleanup.
+ *
+ * @param writer Writer instance
+ * @param length Output document length
+ * @return Document or NULL if any write failed or a message is still open
+ */
+uint8_t* fhir_binary_writer_finish(FHIRBinaryWriter* writer, size_t* length);
+
+/**
+ * @brief Write an unsigned integer field
+ * @param writer Writer instance
+ * @param field Field number (> 0)
+ * @param value Value
+ */
+void fhir_binary_write_uint(FHIRBinaryWriter* writer, uint32_t field, uint64_t value);
+
+/**
+ * @brief Write a boolean field
+ * @param writer Writer instance
+ * @param field Field number (> 0)
+ * @param value Value
+ */
+void fhir_binary_write_bool(FHIRBinaryWriter* writer, uint32_t field, bool value);
+
+/**
+ * @brief Write a double field
+ * @param writer Writer instance
+ * @param field Field number (> 0)
+ * @param value Value
+ */
+void fhir_binary_write_double(FHIRBinaryWriter* writer, uint32_t field, double value);
+
+/**
+ * @brief Write a string field through the string table
+ * @param writer Writer instance
+ * @param field Field number (> 0)
+ * @param value NUL-terminated string (NULL writes nothing)
+ */
+void fhir_binary_write_string(FHIRBinaryWriter* writer, uint32_t field, const char* value);
+
+/**
+ * @brief Open a nested message field
+ * @param writer Writer instance
+ * @param field Field number (> 0)
+ */
+void fhir_binary_begin_message(FHIRBinaryWriter* writer, uint32_t field);
+
+/**
+ * @brief Close the innermost open message
+ * @param writer Writer instance
+ */
+void fhir_binary_end_message(FHIRBinaryWriter* writer);
+
+/**
+ * @brief Write the members of a JSON object with the generic JSON encoding
+ * @param writer Writer instance
+ * @param object JSON object
+ * @return true on success, false on failure
+ */
+bool fhir_binary_write_json_members(FHIRBinaryWriter* writer, const cJSON* object);
+
+/* ========================================================================== */
+/* Reader                                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Validated view of an encoded document (does not own the buffer)
+ */
+typedef struct {
+    const uint8_t* data;        /**< Start of the document */
+    size_t size;                /**< Document size (the buffer may hold more) */
+    uint8_t flags;
+    int resource_type;
+    uint32_t id;                /**< String index of the id or FHIR_BINARY_NO_STRING */
+    uint32_t string_count;
+    const uint8_t* offsets;     /**< string_count little-endian u32 offsets */
+    const char* strings;
+    uint32_t string_bytes;
+    const uint8_t* body;
+    uint32_t body_length;
+} FHIRBinaryDocument;
+
+/**
+ * @brief Cursor over the fields of a body or a nested message
+ *
+ * reader->failed distinguishes malformed input from the end of the fields
+ * when fhir_binary_reader_next returns false.
+ */
+typedef struct {
+    const FHIRBinaryDocument* document;
+    const uint8_t* position;
+    const uint8_t* end;
+    uint32_t field;                 /**< Field number of the current value */
+    FHIRBinaryWireType wire_type;
+    uint64_t uint_value;            /**< VARINT value */
+    double double_value;            /**< DOUBLE value */
+    const char* string_value;       /**< STRING value, points into the document */
+    const uint8_t* message;         /**< MESSAGE content */
+    size_t message_length;
+    bool failed;
+} FHIRBinaryReader;
+
+/**
+ * @brief Check a document's header and tables without decoding its fields
+ * @param document Output view
+ * @param data Buffer starting with a document
+ * @param length Bytes available in data
+ * @return true on success, false on failure (FHIR_ERROR_PARSE_FAILED)
+ */
+bool fhir_binary_open(FHIRBinaryDocument* document, const void* data, size_t length);
+
+/**
+ * @brief Get a string of the string table
+ * @param document Document view
+ * @param index String index
+ * @return String inside the document, or NULL if index is out of range
+ */
+const char* fhir_binary_get_string(const FHIRBinaryDocument* document, uint32_t index);
+
+/**
+ * @brief Get the resource id stored in the header
+ * @param document Document view
+ * @return Id inside the document, or NULL if the resource has none
+ */
+const char* fhir_binary_get_id(const FHIRBinaryDocument* document);
+
+/**
+ * @brief Start reading the body of a document
+ * @param reader Reader to initialize
+ * @param document Document view (must outlive the reader)
+ */
+void fhir_binary_reader_init(FHIRBinaryReader* reader, const FHIRBinaryDocument* document);
+
+/**
+ * @brief Advance to the next field
+ *
+ * Nested messages are skipped as a whole; use fhir_binary_reader_enter to
+ * read their fields.
+ *
+ * @param reader Reader instance
+ * @return true if a field was read, false at the end or on malformed input
+ */
+bool fhir_binary_reader_next(FHIRBinaryReader* reader);
+
+/**
+ * @brief Advance to the next field with a given number
+ * @param reader Reader instance
+ * @param field Field number to find
+ * @return true if found, false otherwise
+ */
+bool fhir_binary_reader_find(FHIRBinaryReader* reader, uint32_t field);
+
+/**
+ * @brief Read the fields of the current MESSAGE value
+ * @param reader Reader positioned on a MESSAGE field
+ * @param child Output reader over the message content
+ */
+void fhir_binary_reader_enter(const FHIRBinaryReader* reader, FHIRBinaryReader* child);
+
+/**
+ * @brief Rebuild the JSON tree of a FHIR_BINARY_FLAG_JSON document
+ * @param document Document view
+ * @return JSON object (caller must cJSON_Delete) or NULL on failure
+ */
+cJSON* fhir_binary_to_json(const FHIRBinaryDocument* document);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_BINARY_H */
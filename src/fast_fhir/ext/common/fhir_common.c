@@ -8,21 +8,47 @@
  * used across all FHIR resource implementations.
  */
 
+// clock_gettime and pthread keys under -std=c99
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "fhir_common.h"
+#include "fhir_resource_base.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <ctype.h>
 #include <errno.h>
-#include <regex.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef FHIR_USDT
+#include <sys/sdt.h>
+#endif
+
+#if FHIR_MEMORY_STATS
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define FHIR_USABLE_SIZE(ptr) malloc_size(ptr)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define FHIR_USABLE_SIZE(ptr) _msize(ptr)
+#else
+#include <malloc.h>
+#define FHIR_USABLE_SIZE(ptr) malloc_usable_size(ptr)
+#endif
+#endif
 
 /* ========================================================================== */
 /* Global Variables                                                           */
 /* ========================================================================== */
 
-static FHIRError g_last_error = {0};
-static FHIRLogLevel g_log_level = FHIR_LOG_LEVEL_INFO;
+// Per-thread so concurrent parsers never overwrite each other's errors
+static FHIR_THREAD_LOCAL FHIRError g_last_error = {0};
+FHIRAtomicInt fhir_log_level = FHIR_LOG_LEVEL_INFO;
 
 /* ========================================================================== */
 /* Error Handling Implementation                                              */
@@ -32,29 +58,34 @@ const FHIRError* fhir_get_last_error(void) {
     return g_last_error.code != FHIR_ERROR_NONE ? &g_last_error : NULL;
 }
 
+// Bounded copy into a fixed buffer (text may alias it when re-raising the last error)
+static const char* copy_error_text(char* buffer, size_t capacity, const char* text) {
+    size_t len = strlen(text);
+    if (len >= capacity) {
+        len = capacity - 1;
+    }
+    memmove(buffer, text, len);
+    buffer[len] = '\0';
+    return buffer;
+}
+
 void fhir_set_error(FHIRErrorCode code, const char* message, const char* field, 
                    const char* file, int line) {
-    // Clear previous error
-    fhir_clear_error();
-    
     g_last_error.code = code;
-    
-    if (message) {
-        g_last_error.message = fhir_strdup(message);
-    }
-    
-    if (field) {
-        g_last_error.field = fhir_strdup(field);
-    }
-    
+    g_last_error.message = message ? copy_error_text(g_last_error.message_buffer,
+                                                     FHIR_ERROR_MESSAGE_MAX, message) : NULL;
+    g_last_error.field = field ? copy_error_text(g_last_error.field_buffer,
+                                                 FHIR_ERROR_FIELD_MAX, field) : NULL;
     g_last_error.file = file;
     g_last_error.line = line;
 }
 
 void fhir_clear_error(void) {
-    free(g_last_error.message);
-    free(g_last_error.field);
-    memset(&g_last_error, 0, sizeof(FHIRError));
+    g_last_error.code = FHIR_ERROR_NONE;
+    g_last_error.message = NULL;
+    g_last_error.field = NULL;
+    g_last_error.file = NULL;
+    g_last_error.line = 0;
 }
 
 const char* fhir_error_code_to_string(FHIRErrorCode code) {
@@ -68,11 +99,384 @@ const char* fhir_error_code_to_string(FHIRErrorCode code) {
         case FHIR_ERROR_VALIDATION_FAILED: return "Validation failed";
         case FHIR_ERROR_PARSE_FAILED: return "Parse failed";
         case FHIR_ERROR_SERIALIZE_FAILED: return "Serialize failed";
+        case FHIR_ERROR_IO: return "I/O error";
         case FHIR_ERROR_UNKNOWN: return "Unknown error";
         default: return "Invalid error code";
     }
 }
 
+/* ========================================================================== */
+/* Memory Accounting Implementation                                           */
+/* ========================================================================== */
+
+typedef struct {
+    FHIRAtomicLong allocations;
+    FHIRAtomicLong frees;
+    FHIRAtomicLong arena_allocations;
+    FHIRAtomicLong bytes_allocated;
+    FHIRAtomicLong bytes_freed;
+    FHIRAtomicLong live_bytes;
+    FHIRAtomicLong peak_bytes;
+} FHIRMemoryCounters;
+
+typedef struct {
+    FHIRAtomicLong allocations;
+    FHIRAtomicLong bytes_allocated;
+} FHIRMemoryTypeCounters;
+
+static FHIRAtomicInt g_memory_enabled;
+static FHIRMemoryCounters g_memory;
+static FHIRMemoryTypeCounters g_memory_types[FHIR_RESOURCE_TYPE_COUNT];
+static FHIR_THREAD_LOCAL FHIRMemoryStats g_thread_memory;
+static FHIR_THREAD_LOCAL int g_memory_type;
+
+static inline bool memory_counting(void) {
+#if FHIR_MEMORY_STATS
+    return fhir_atomic_load_relaxed(&g_memory_enabled) != 0;
+#else
+    return false;
+#endif
+}
+
+static size_t memory_usable_size(void* ptr) {
+#if FHIR_MEMORY_STATS
+    return FHIR_USABLE_SIZE(ptr);
+#else
+    (void)ptr;
+    return 0;
+#endif
+}
+
+static void memory_attribute(long long bytes) {
+    int type = g_memory_type;
+    if (type > FHIR_RESOURCE_TYPE_UNKNOWN && type < FHIR_RESOURCE_TYPE_COUNT) {
+        fhir_atomic_fetch_add_relaxed(&g_memory_types[type].allocations, 1);
+        fhir_atomic_fetch_add_relaxed(&g_memory_types[type].bytes_allocated, bytes);
+    }
+}
+
+static void memory_count_alloc(void* ptr, bool attribute) {
+    if (!ptr || !memory_counting()) return;
+    
+    long long size = (long long)memory_usable_size(ptr);
+    FHIRMemoryStats* thread = &g_thread_memory;
+    thread->allocations++;
+    thread->bytes_allocated += (size_t)size;
+    thread->live_bytes += size;
+    if (thread->live_bytes > thread->peak_bytes) {
+        thread->peak_bytes = thread->live_bytes;
+    }
+    
+    fhir_atomic_fetch_add_relaxed(&g_memory.allocations, 1);
+    fhir_atomic_fetch_add_relaxed(&g_memory.bytes_allocated, size);
+    long long live = fhir_atomic_fetch_add_relaxed(&g_memory.live_bytes, size) + size;
+    long long peak = fhir_atomic_load_relaxed(&g_memory.peak_bytes);
+    while (live > peak && !fhir_atomic_compare_exchange(&g_memory.peak_bytes, &peak, live)) {
+    }
+    if (attribute) {
+        memory_attribute(size);
+    }
+}
+
+static void memory_count_free(size_t usable_size) {
+    long long size = (long long)usable_size;
+    FHIRMemoryStats* thread = &g_thread_memory;
+    thread->frees++;
+    thread->bytes_freed += usable_size;
+    thread->live_bytes -= size;
+    
+    fhir_atomic_fetch_add_relaxed(&g_memory.frees, 1);
+    fhir_atomic_fetch_add_relaxed(&g_memory.bytes_freed, size);
+    fhir_atomic_fetch_add_relaxed(&g_memory.live_bytes, -size);
+}
+
+static void memory_count_arena(size_t size) {
+    if (!memory_counting()) return;
+    
+    g_thread_memory.arena_allocations++;
+    fhir_atomic_fetch_add_relaxed(&g_memory.arena_allocations, 1);
+    memory_attribute((long long)size);
+}
+
+// libc allocation with accounting; attribute is false for pool memory shared by all types
+static void* heap_malloc(size_t size, bool attribute) {
+    void* ptr = malloc(size);
+    memory_count_alloc(ptr, attribute);
+    return ptr;
+}
+
+static void* heap_calloc(size_t count, size_t size, bool attribute) {
+    void* ptr = calloc(count, size);
+    memory_count_alloc(ptr, attribute);
+    return ptr;
+}
+
+static void* heap_realloc(void* ptr, size_t size) {
+    if (!memory_counting()) {
+        return realloc(ptr, size);
+    }
+    
+    // The old block may be gone after realloc, so size it first
+    size_t old_size = ptr ? memory_usable_size(ptr) : 0;
+    void* new_ptr = realloc(ptr, size);
+    if (new_ptr) {
+        if (ptr) {
+            memory_count_free(old_size);
+        }
+        memory_count_alloc(new_ptr, true);
+    }
+    return new_ptr;
+}
+
+static void heap_free(void* ptr) {
+    if (ptr && memory_counting()) {
+        memory_count_free(memory_usable_size(ptr));
+    }
+    free(ptr);
+}
+
+bool fhir_memory_stats_set_enabled(bool enabled) {
+#if FHIR_MEMORY_STATS
+    bool previous = fhir_atomic_load_relaxed(&g_memory_enabled) != 0;
+    fhir_atomic_store(&g_memory_enabled, enabled ? 1 : 0);
+    return previous;
+#else
+    (void)enabled;
+    return false;
+#endif
+}
+
+bool fhir_memory_stats_enabled(void) {
+    return memory_counting();
+}
+
+void fhir_memory_get_stats(FHIRMemoryStats* stats) {
+    if (!stats) return;
+    
+    stats->allocations = (size_t)fhir_atomic_load_relaxed(&g_memory.allocations);
+    stats->frees = (size_t)fhir_atomic_load_relaxed(&g_memory.frees);
+    stats->arena_allocations = (size_t)fhir_atomic_load_relaxed(&g_memory.arena_allocations);
+    stats->bytes_allocated = (size_t)fhir_atomic_load_relaxed(&g_memory.bytes_allocated);
+    stats->bytes_freed = (size_t)fhir_atomic_load_relaxed(&g_memory.bytes_freed);
+    stats->live_bytes = fhir_atomic_load_relaxed(&g_memory.live_bytes);
+    stats->peak_bytes = fhir_atomic_load_relaxed(&g_memory.peak_bytes);
+}
+
+void fhir_memory_get_thread_stats(FHIRMemoryStats* stats) {
+    if (stats) {
+        *stats = g_thread_memory;
+    }
+}
+
+bool fhir_memory_get_type_stats(int resource_type, FHIRMemoryTypeStats* stats) {
+    if (!stats || resource_type <= FHIR_RESOURCE_TYPE_UNKNOWN || resource_type >= FHIR_RESOURCE_TYPE_COUNT) {
+        return false;
+    }
+    
+    stats->allocations = (size_t)fhir_atomic_load_relaxed(&g_memory_types[resource_type].allocations);
+    stats->bytes_allocated = (size_t)fhir_atomic_load_relaxed(&g_memory_types[resource_type].bytes_allocated);
+    return true;
+}
+
+void fhir_memory_stats_reset(void) {
+    fhir_atomic_store(&g_memory.allocations, 0);
+    fhir_atomic_store(&g_memory.frees, 0);
+    fhir_atomic_store(&g_memory.arena_allocations, 0);
+    fhir_atomic_store(&g_memory.bytes_allocated, 0);
+    fhir_atomic_store(&g_memory.bytes_freed, 0);
+    fhir_atomic_store(&g_memory.peak_bytes, fhir_atomic_load_relaxed(&g_memory.live_bytes));
+    for (size_t i = 0; i < FHIR_RESOURCE_TYPE_COUNT; i++) {
+        fhir_atomic_store(&g_memory_types[i].allocations, 0);
+        fhir_atomic_store(&g_memory_types[i].bytes_allocated, 0);
+    }
+    
+    int64_t live = g_thread_memory.live_bytes;
+    memset(&g_thread_memory, 0, sizeof(FHIRMemoryStats));
+    g_thread_memory.live_bytes = live;
+    g_thread_memory.peak_bytes = live;
+}
+
+int fhir_memory_set_type(int resource_type) {
+    int previous = g_memory_type;
+    g_memory_type = resource_type;
+    return previous;
+}
+
+/* ========================================================================== */
+/* Arena Allocation Implementation                                            */
+/* ========================================================================== */
+
+// Allocations are aligned like malloc and preceded by their size for fhir_realloc
+#define FHIR_ARENA_ALIGNMENT 16
+#define FHIR_ARENA_HEADER_SIZE sizeof(size_t)
+
+typedef struct FHIRArenaBlock {
+    struct FHIRArenaBlock* next;
+    size_t capacity;
+    size_t used;
+    // Data follows, aligned to FHIR_ARENA_ALIGNMENT
+} FHIRArenaBlock;
+
+#define FHIR_ARENA_BLOCK_DATA_OFFSET \
+    ((sizeof(FHIRArenaBlock) + FHIR_ARENA_ALIGNMENT - 1) & ~(size_t)(FHIR_ARENA_ALIGNMENT - 1))
+
+struct FHIRArena {
+    FHIRArenaBlock* blocks;     // Newest block first
+    size_t block_size;
+    FHIRArenaStats stats;
+};
+
+static FHIR_THREAD_LOCAL FHIRArena* g_current_arena = NULL;
+
+static char* arena_block_data(FHIRArenaBlock* block) {
+    return (char*)block + FHIR_ARENA_BLOCK_DATA_OFFSET;
+}
+
+static FHIRArenaBlock* arena_add_block(FHIRArena* arena, size_t capacity) {
+    FHIRArenaBlock* block = heap_malloc(FHIR_ARENA_BLOCK_DATA_OFFSET + capacity, false);
+    if (!block) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate arena block");
+        return NULL;
+    }
+    
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->stats.block_count++;
+    arena->stats.bytes_reserved += capacity;
+    return block;
+}
+
+FHIRArena* fhir_arena_create(size_t block_size) {
+    FHIRArena* arena = heap_calloc(1, sizeof(FHIRArena), false);
+    if (!arena) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate arena");
+        return NULL;
+    }
+    
+    arena->block_size = block_size ? block_size : FHIR_ARENA_DEFAULT_BLOCK_SIZE;
+    if (!arena_add_block(arena, arena->block_size)) {
+        heap_free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+void* fhir_arena_alloc(FHIRArena* arena, size_t size) {
+    if (!arena || size == 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arena allocation");
+        return NULL;
+    }
+    
+    size_t needed = FHIR_ARENA_HEADER_SIZE + size + FHIR_ARENA_ALIGNMENT;
+    FHIRArenaBlock* block = arena->blocks;
+    
+    if (!block || block->capacity - block->used < needed) {
+        if (needed > arena->block_size) {
+            // Oversized requests get a dedicated block behind the current one,
+            // which stays at the head for later small allocations
+            block = arena_add_block(arena, needed);
+            if (!block) {
+                return NULL;
+            }
+            if (block->next) {
+                arena->blocks = block->next;
+                block->next = arena->blocks->next;
+                arena->blocks->next = block;
+            }
+        } else {
+            block = arena_add_block(arena, arena->block_size);
+            if (!block) {
+                return NULL;
+            }
+        }
+    }
+    
+    char* data = arena_block_data(block);
+    size_t offset = (block->used + FHIR_ARENA_HEADER_SIZE + FHIR_ARENA_ALIGNMENT - 1) &
+                    ~(size_t)(FHIR_ARENA_ALIGNMENT - 1);
+    memcpy(data + offset - FHIR_ARENA_HEADER_SIZE, &size, sizeof(size));
+    
+    arena->stats.bytes_used += offset + size - block->used;
+    arena->stats.allocation_count++;
+    block->used = offset + size;
+    return data + offset;
+}
+
+void fhir_arena_reset(FHIRArena* arena) {
+    if (!arena) return;
+    
+    // Keep one default-sized block for reuse and free the rest
+    FHIRArenaBlock* kept = NULL;
+    while (arena->blocks) {
+        FHIRArenaBlock* block = arena->blocks;
+        arena->blocks = block->next;
+        if (!kept && block->capacity == arena->block_size) {
+            kept = block;
+        } else {
+            heap_free(block);
+        }
+    }
+    
+    memset(&arena->stats, 0, sizeof(FHIRArenaStats));
+    if (kept) {
+        kept->used = 0;
+        kept->next = NULL;
+        arena->blocks = kept;
+        arena->stats.block_count = 1;
+        arena->stats.bytes_reserved = kept->capacity;
+    }
+}
+
+void fhir_arena_destroy(FHIRArena* arena) {
+    if (!arena) return;
+    
+    if (g_current_arena == arena) {
+        g_current_arena = NULL;
+    }
+    
+    while (arena->blocks) {
+        FHIRArenaBlock* block = arena->blocks;
+        arena->blocks = block->next;
+        heap_free(block);
+    }
+    heap_free(arena);
+}
+
+bool fhir_arena_owns(const FHIRArena* arena, const void* ptr) {
+    if (!arena || !ptr) return false;
+    
+    const char* p = (const char*)ptr;
+    for (FHIRArenaBlock* block = arena->blocks; block; block = block->next) {
+        const char* data = arena_block_data(block);
+        if (p >= data && p < data + block->used) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void fhir_arena_get_stats(const FHIRArena* arena, FHIRArenaStats* stats) {
+    if (!stats) return;
+    
+    if (arena) {
+        *stats = arena->stats;
+    } else {
+        memset(stats, 0, sizeof(FHIRArenaStats));
+    }
+}
+
+FHIRArena* fhir_arena_set_current(FHIRArena* arena) {
+    FHIRArena* previous = g_current_arena;
+    g_current_arena = arena;
+    return previous;
+}
+
+FHIRArena* fhir_arena_get_current(void) {
+    return g_current_arena;
+}
+
 /* ========================================================================== */
 /* Memory Management Implementation                                           */
 /* ========================================================================== */
@@ -84,7 +488,7 @@ char* fhir_strdup(const char* str) {
     }
     
     size_t len = strlen(str) + 1;
-    char* dup = malloc(len);
+    char* dup = fhir_malloc(len);
     if (!dup) {
         FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate memory for string");
         return NULL;
@@ -100,7 +504,15 @@ void* fhir_malloc(size_t size) {
         return NULL;
     }
     
-    void* ptr = malloc(size);
+    if (g_current_arena) {
+        void* ptr = fhir_arena_alloc(g_current_arena, size);
+        if (ptr) {
+            memory_count_arena(size);
+        }
+        return ptr;
+    }
+    
+    void* ptr = heap_malloc(size, true);
     if (!ptr) {
         FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate memory");
     }
@@ -110,11 +522,24 @@ void* fhir_malloc(size_t size) {
 
 void* fhir_realloc(void* ptr, size_t size) {
     if (size == 0) {
-        free(ptr);
+        fhir_free(ptr);
         return NULL;
     }
     
-    void* new_ptr = realloc(ptr, size);
+    if (g_current_arena && (!ptr || fhir_arena_owns(g_current_arena, ptr))) {
+        void* new_ptr = fhir_arena_alloc(g_current_arena, size);
+        if (new_ptr && ptr) {
+            size_t old_size;
+            memcpy(&old_size, (char*)ptr - FHIR_ARENA_HEADER_SIZE, sizeof(old_size));
+            memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+        }
+        if (new_ptr) {
+            memory_count_arena(size);
+        }
+        return new_ptr;
+    }
+    
+    void* new_ptr = heap_realloc(ptr, size);
     if (!new_ptr) {
         FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to reallocate memory");
     }
@@ -128,7 +553,20 @@ void* fhir_calloc(size_t count, size_t size) {
         return NULL;
     }
     
-    void* ptr = calloc(count, size);
+    if (g_current_arena) {
+        if (count > SIZE_MAX / size) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Allocation size overflow");
+            return NULL;
+        }
+        void* ptr = fhir_arena_alloc(g_current_arena, count * size);
+        if (ptr) {
+            memset(ptr, 0, count * size);
+            memory_count_arena(count * size);
+        }
+        return ptr;
+    }
+    
+    void* ptr = heap_calloc(count, size, true);
     if (!ptr) {
         FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate memory");
     }
@@ -137,7 +575,478 @@ void* fhir_calloc(size_t count, size_t size) {
 }
 
 void fhir_free(void* ptr) {
-    free(ptr);
+    // Arena memory is reclaimed by fhir_arena_reset/destroy
+    if (g_current_arena && fhir_arena_owns(g_current_arena, ptr)) {
+        return;
+    }
+    heap_free(ptr);
+}
+
+/* ========================================================================== */
+/* Object Pool Implementation                                                 */
+/* ========================================================================== */
+
+#define FHIR_POOL_MAX 64
+#define FHIR_POOL_BATCH (FHIR_OBJECT_POOL_CACHE_SIZE / 2)
+
+// A free object's first bytes link it into a list
+typedef struct FHIRPoolObject {
+    struct FHIRPoolObject* next;
+} FHIRPoolObject;
+
+typedef struct {
+    FHIRObjectPool* pool;
+    FHIRAtomicInt lock;         // Spinlock; critical sections move one batch
+    FHIRPoolObject* head;       // Shared free list
+    size_t count;
+    FHIRAtomicLong heap_allocations;
+} FHIRPoolShared;
+
+typedef struct {
+    FHIRPoolObject* head;
+    size_t count;
+} FHIRPoolCache;
+
+// Pools are assigned table slots on first use and keep them for the process
+static FHIRPoolShared g_pools[FHIR_POOL_MAX];
+static FHIRAtomicInt g_pool_count;
+static FHIRAtomicInt g_pool_table_lock;
+static FHIR_THREAD_LOCAL FHIRPoolCache g_pool_caches[FHIR_POOL_MAX];
+static FHIR_THREAD_LOCAL bool g_pool_caches_registered;
+static pthread_key_t g_pool_cache_key;
+static pthread_once_t g_pool_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void pool_lock(FHIRAtomicInt* lock) {
+    int expected = 0;
+    while (!fhir_atomic_compare_exchange(lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void pool_unlock(FHIRAtomicInt* lock) {
+    fhir_atomic_store(lock, 0);
+}
+
+static int pool_register(FHIRObjectPool* pool) {
+    pool_lock(&g_pool_table_lock);
+    int slot = fhir_atomic_load_relaxed(&pool->slot);
+    if (slot == 0) {
+        // Pools past the table size, or too small to hold a link, stay unpooled (-1)
+        int count = fhir_atomic_load_relaxed(&g_pool_count);
+        slot = -1;
+        if (count < FHIR_POOL_MAX && pool->object_size >= sizeof(FHIRPoolObject)) {
+            g_pools[count].pool = pool;
+            fhir_atomic_store(&g_pool_count, count + 1);
+            slot = count + 1;
+        }
+        fhir_atomic_store(&pool->slot, slot);
+    }
+    pool_unlock(&g_pool_table_lock);
+    return slot - 1;
+}
+
+static inline int pool_index(FHIRObjectPool* pool) {
+    int slot = fhir_atomic_load(&pool->slot);
+    if (slot == 0) {
+        return pool_register(pool);
+    }
+    return slot > 0 ? slot - 1 : -1;
+}
+
+// Move all but keep objects from a thread cache to the shared list
+static void pool_flush_cache(int index, size_t keep) {
+    FHIRPoolCache* cache = &g_pool_caches[index];
+    if (cache->count <= keep) return;
+
+    size_t moved = cache->count - keep;
+    FHIRPoolObject* first = cache->head;
+    FHIRPoolObject* last = first;
+    for (size_t i = 1; i < moved; i++) {
+        last = last->next;
+    }
+    cache->head = last->next;
+    cache->count = keep;
+
+    FHIRPoolShared* shared = &g_pools[index];
+    pool_lock(&shared->lock);
+    last->next = shared->head;
+    shared->head = first;
+    shared->count += moved;
+    pool_unlock(&shared->lock);
+}
+
+static void pool_release_caches(void* unused) {
+    (void)unused;
+    int count = fhir_atomic_load(&g_pool_count);
+    for (int i = 0; i < count; i++) {
+        pool_flush_cache(i, 0);
+    }
+    g_pool_caches_registered = false;
+}
+
+static void pool_create_cache_key(void) {
+    pthread_key_create(&g_pool_cache_key, pool_release_caches);
+}
+
+// Caches are handed to the shared lists when their thread exits
+static void pool_register_caches(void) {
+    pthread_once(&g_pool_cache_key_once, pool_create_cache_key);
+    pthread_setspecific(g_pool_cache_key, g_pool_caches);
+    g_pool_caches_registered = true;
+}
+
+static void pool_refill_cache(int index) {
+    FHIRPoolShared* shared = &g_pools[index];
+    pool_lock(&shared->lock);
+    FHIRPoolObject* first = shared->head;
+    FHIRPoolObject* last = first;
+    size_t taken = 0;
+    if (first) {
+        taken = 1;
+        while (taken < FHIR_POOL_BATCH && last->next) {
+            last = last->next;
+            taken++;
+        }
+        shared->head = last->next;
+        shared->count -= taken;
+    }
+    pool_unlock(&shared->lock);
+
+    if (taken) {
+        if (!g_pool_caches_registered) {
+            pool_register_caches();
+        }
+        last->next = NULL;
+        g_pool_caches[index].head = first;
+        g_pool_caches[index].count = taken;
+    }
+}
+
+static size_t pool_free_list(FHIRPoolObject* object) {
+    size_t count = 0;
+    while (object) {
+        FHIRPoolObject* next = object->next;
+        heap_free(object);
+        object = next;
+        count++;
+    }
+    return count;
+}
+
+void* fhir_pool_alloc(FHIRObjectPool* pool) {
+    if (!pool) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Pool is NULL");
+        return NULL;
+    }
+
+#if FHIR_OBJECT_POOLS
+    int index = g_current_arena ? -1 : pool_index(pool);
+    if (index >= 0) {
+        FHIRPoolCache* cache = &g_pool_caches[index];
+        if (!cache->head) {
+            pool_refill_cache(index);
+        }
+        FHIRPoolObject* object = cache->head;
+        if (object) {
+            cache->head = object->next;
+            cache->count--;
+            memset(object, 0, pool->object_size);
+            return object;
+        }
+
+        void* fresh = heap_calloc(1, pool->object_size, true);
+        if (!fresh) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate memory");
+            return NULL;
+        }
+        fhir_atomic_fetch_add_relaxed(&g_pools[index].heap_allocations, 1);
+        return fresh;
+    }
+#endif
+    return fhir_calloc(1, pool->object_size);
+}
+
+void fhir_pool_free(FHIRObjectPool* pool, void* object) {
+    if (!object) return;
+
+#if FHIR_OBJECT_POOLS
+    // Arena memory is reclaimed by fhir_arena_reset/destroy
+    if (g_current_arena && fhir_arena_owns(g_current_arena, object)) {
+        return;
+    }
+
+    int index = pool ? pool_index(pool) : -1;
+    if (index >= 0) {
+        if (!g_pool_caches_registered) {
+            pool_register_caches();
+        }
+        FHIRPoolCache* cache = &g_pool_caches[index];
+        if (cache->count >= FHIR_OBJECT_POOL_CACHE_SIZE) {
+            pool_flush_cache(index, FHIR_OBJECT_POOL_CACHE_SIZE - FHIR_POOL_BATCH);
+        }
+        FHIRPoolObject* node = object;
+        node->next = cache->head;
+        cache->head = node;
+        cache->count++;
+        return;
+    }
+#else
+    (void)pool;
+#endif
+    fhir_free(object);
+}
+
+size_t fhir_pool_trim(void) {
+    size_t released = 0;
+    int count = fhir_atomic_load(&g_pool_count);
+    for (int i = 0; i < count; i++) {
+        FHIRPoolShared* shared = &g_pools[i];
+        FHIRPoolCache* cache = &g_pool_caches[i];
+
+        pool_lock(&shared->lock);
+        FHIRPoolObject* list = shared->head;
+        shared->head = NULL;
+        shared->count = 0;
+        pool_unlock(&shared->lock);
+
+        size_t objects = pool_free_list(list) + pool_free_list(cache->head);
+        cache->head = NULL;
+        cache->count = 0;
+        released += objects * shared->pool->object_size;
+    }
+    return released;
+}
+
+void fhir_pool_get_stats(FHIRObjectPool* pool, FHIRObjectPoolStats* stats) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(FHIRObjectPoolStats));
+    int slot = pool ? fhir_atomic_load(&pool->slot) : 0;
+    if (slot <= 0) return;
+
+    FHIRPoolShared* shared = &g_pools[slot - 1];
+    stats->heap_allocations = (size_t)fhir_atomic_load_relaxed(&shared->heap_allocations);
+    pool_lock(&shared->lock);
+    stats->shared_objects = shared->count;
+    pool_unlock(&shared->lock);
+    stats->thread_objects = g_pool_caches[slot - 1].count;
+}
+
+/* ========================================================================== */
+/* String Interning Implementation                                            */
+/* ========================================================================== */
+
+// Independent shards keep concurrent parsers from contending on one lock
+#define FHIR_INTERN_SHARD_COUNT 16
+#define FHIR_INTERN_INITIAL_CAPACITY 64
+#define FHIR_INTERN_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+    uint64_t hash;
+    size_t length;
+    const char* value;          // NULL for an empty slot
+} FHIRInternEntry;
+
+// Interned text is packed back to back in chunks rather than allocated per string
+typedef struct FHIRInternChunk {
+    struct FHIRInternChunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} FHIRInternChunk;
+
+typedef struct {
+    FHIRAtomicInt lock;         // Spinlock; the critical section is a probe or an insert
+    FHIRInternEntry* entries;   // Open addressing, capacity is a power of two
+    size_t capacity;
+    FHIRInternChunk* chunks;    // Newest chunk first
+    FHIRInternStats stats;
+} FHIRInternShard;
+
+static FHIRInternShard g_intern_shards[FHIR_INTERN_SHARD_COUNT];
+
+static uint64_t intern_hash(const char* str, size_t length) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void intern_lock(FHIRInternShard* shard) {
+    int expected = 0;
+    while (!fhir_atomic_compare_exchange(&shard->lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void intern_unlock(FHIRInternShard* shard) {
+    fhir_atomic_store(&shard->lock, 0);
+}
+
+static bool intern_grow(FHIRInternShard* shard) {
+    size_t capacity = shard->capacity ? shard->capacity * 2 : FHIR_INTERN_INITIAL_CAPACITY;
+    FHIRInternEntry* entries = heap_calloc(capacity, sizeof(FHIRInternEntry), false);
+    if (!entries) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < shard->capacity; i++) {
+        if (shard->entries[i].value) {
+            size_t slot = shard->entries[i].hash & (capacity - 1);
+            while (entries[slot].value) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            entries[slot] = shard->entries[i];
+        }
+    }
+    
+    heap_free(shard->entries);
+    shard->entries = entries;
+    shard->capacity = capacity;
+    return true;
+}
+
+static char* intern_store(FHIRInternShard* shard, const char* str, size_t length) {
+    size_t size = length + 1;
+    FHIRInternChunk* chunk = shard->chunks;
+    
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > FHIR_INTERN_CHUNK_SIZE ? size : FHIR_INTERN_CHUNK_SIZE;
+        chunk = heap_malloc(sizeof(FHIRInternChunk) + capacity, false);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        chunk->next = shard->chunks;
+        shard->chunks = chunk;
+    }
+    
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    chunk->used += size;
+    shard->stats.bytes_stored += size;
+    return copy;
+}
+
+static const char* intern_local_n(const char* str, size_t length) {
+    uint64_t hash = intern_hash(str, length);
+    FHIRInternShard* shard = &g_intern_shards[hash >> 60];
+    const char* result = NULL;
+    
+    intern_lock(shard);
+    shard->stats.lookup_count++;
+    
+    // Keep the load factor below 0.7
+    if ((shard->stats.string_count + 1) * 10 > shard->capacity * 7 && !intern_grow(shard)) {
+        intern_unlock(shard);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow string pool");
+        return NULL;
+    }
+    
+    size_t slot = hash & (shard->capacity - 1);
+    while (shard->entries[slot].value) {
+        const FHIRInternEntry* entry = &shard->entries[slot];
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->value, str, length) == 0) {
+            shard->stats.hit_count++;
+            result = entry->value;
+            break;
+        }
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+    
+    if (!result) {
+        char* copy = intern_store(shard, str, length);
+        if (copy) {
+            shard->entries[slot] = (FHIRInternEntry){ hash, length, copy };
+            shard->stats.string_count++;
+            result = copy;
+        }
+    }
+    
+    intern_unlock(shard);
+    
+    if (!result) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate interned string");
+    }
+    return result;
+}
+
+static void intern_local_get_stats(FHIRInternStats* stats) {
+    memset(stats, 0, sizeof(FHIRInternStats));
+    for (size_t i = 0; i < FHIR_INTERN_SHARD_COUNT; i++) {
+        FHIRInternShard* shard = &g_intern_shards[i];
+        intern_lock(shard);
+        stats->string_count += shard->stats.string_count;
+        stats->bytes_stored += shard->stats.bytes_stored;
+        stats->lookup_count += shard->stats.lookup_count;
+        stats->hit_count += shard->stats.hit_count;
+        intern_unlock(shard);
+    }
+}
+
+static void intern_local_clear(void) {
+    for (size_t i = 0; i < FHIR_INTERN_SHARD_COUNT; i++) {
+        FHIRInternShard* shard = &g_intern_shards[i];
+        intern_lock(shard);
+        while (shard->chunks) {
+            FHIRInternChunk* chunk = shard->chunks;
+            shard->chunks = chunk->next;
+            heap_free(chunk);
+        }
+        heap_free(shard->entries);
+        shard->entries = NULL;
+        shard->capacity = 0;
+        memset(&shard->stats, 0, sizeof(FHIRInternStats));
+        intern_unlock(shard);
+    }
+}
+
+static const FHIRInternPool g_intern_local = { intern_local_n, intern_local_get_stats, intern_local_clear };
+static const FHIRInternPool* g_intern_pool = &g_intern_local;
+
+const FHIRInternPool* fhir_intern_pool(void) {
+    return g_intern_pool;
+}
+
+void fhir_intern_use_pool(const FHIRInternPool* pool) {
+    g_intern_pool = pool ? pool : &g_intern_local;
+}
+
+const char* fhir_intern(const char* str) {
+    if (!str) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "String is NULL");
+        return NULL;
+    }
+    return fhir_intern_n(str, strlen(str));
+}
+
+const char* fhir_intern_n(const char* str, size_t length) {
+    if (!str) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "String is NULL");
+        return NULL;
+    }
+    
+    const char* result = g_intern_pool->intern_n(str, length);
+    if (!result && g_intern_pool != &g_intern_local) {
+        // An adopted pool reports the failure in its own copy's error state
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate interned string");
+    }
+    return result;
+}
+
+void fhir_intern_get_stats(FHIRInternStats* stats) {
+    if (!stats) return;
+    g_intern_pool->get_stats(stats);
+}
+
+void fhir_intern_clear(void) {
+    g_intern_pool->clear();
 }
 
 /* ========================================================================== */
@@ -156,7 +1065,7 @@ bool fhir_resize_array(void** array, size_t old_size, size_t new_size, size_t el
     }
     
     if (new_size == 0) {
-        free(*array);
+        fhir_free(*array);
         *array = NULL;
         return true;
     }
@@ -218,12 +1127,12 @@ void fhir_free_pointer_array(void** array, size_t count, void (*free_func)(void*
             if (free_func) {
                 free_func(array[i]);
             } else {
-                free(array[i]);
+                fhir_free(array[i]);
             }
         }
     }
     
-    free(array);
+    fhir_free(array);
 }
 
 /* ========================================================================== */
@@ -338,18 +1247,122 @@ bool fhir_json_add_int(cJSON* json, const char* key, int value) {
 /* Validation Utilities Implementation                                        */
 /* ========================================================================== */
 
+// Single-pass scanners for the FHIR primitive grammars. Each returns a pointer
+// just past the consumed text, or NULL if the input does not match.
+
+static const char* scan_digits(const char* p, int count, int* value) {
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (p[i] < '0' || p[i] > '9') return NULL;
+        result = result * 10 + (p[i] - '0');
+    }
+    *value = result;
+    return p + count;
+}
+
+static int days_in_month(int year, int month) {
+    static const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+// Components of a scanned date or time; fields that were not written stay 0
+typedef struct {
+    int year, month, day;
+    int hour, minute, second;
+    int fraction_digits;
+    int microseconds;             // Fraction truncated to six digits
+    int offset_minutes;
+    bool has_timezone;
+} DateTimeFields;
+
+// YYYY, YYYY-MM or YYYY-MM-DD; day is non-zero when the date is full
+static const char* scan_date(const char* p, DateTimeFields* fields) {
+    int year, month, day;
+    
+    memset(fields, 0, sizeof(*fields));
+    p = scan_digits(p, 4, &year);
+    if (!p || year == 0) return NULL;
+    fields->year = year;
+    if (*p != '-') return p;
+    
+    p = scan_digits(p + 1, 2, &month);
+    if (!p || month < 1 || month > 12) return NULL;
+    fields->month = month;
+    if (*p != '-') return p;
+    
+    p = scan_digits(p + 1, 2, &day);
+    if (!p || day < 1 || day > days_in_month(year, month)) return NULL;
+    
+    fields->day = day;
+    return p;
+}
+
+// hh:mm:ss with an optional fraction of 1-9 digits
+static const char* scan_time(const char* p, DateTimeFields* fields) {
+    int hour, minute, second;
+    
+    p = scan_digits(p, 2, &hour);
+    if (!p || hour > 23 || *p != ':') return NULL;
+    p = scan_digits(p + 1, 2, &minute);
+    if (!p || minute > 59 || *p != ':') return NULL;
+    p = scan_digits(p + 1, 2, &second);
+    if (!p || second > 60) return NULL;  // 60 allows a leap second
+    fields->hour = hour;
+    fields->minute = minute;
+    fields->second = second;
+    
+    if (*p == '.') {
+        int digits = 0;
+        int microseconds = 0;
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (digits < 6) microseconds = microseconds * 10 + (*p - '0');
+            p++;
+            digits++;
+        }
+        if (digits < 1 || digits > 9) return NULL;
+        for (int i = digits; i < 6; i++) microseconds *= 10;
+        fields->fraction_digits = digits;
+        fields->microseconds = microseconds;
+    }
+    return p;
+}
+
+// Z or (+|-)hh:mm with offsets up to 14:00
+static const char* scan_timezone(const char* p, DateTimeFields* fields) {
+    int hour, minute;
+    
+    if (*p == 'Z') {
+        fields->has_timezone = true;
+        return p + 1;
+    }
+    if (*p != '+' && *p != '-') return NULL;
+    
+    int sign = *p == '-' ? -1 : 1;
+    p = scan_digits(p + 1, 2, &hour);
+    if (!p || *p != ':') return NULL;
+    p = scan_digits(p + 1, 2, &minute);
+    if (!p || minute > 59) return NULL;
+    if (hour > 14 || (hour == 14 && minute != 0)) return NULL;
+    fields->offset_minutes = sign * (hour * 60 + minute);
+    fields->has_timezone = true;
+    return p;
+}
+
 bool fhir_validate_id(const char* id) {
     if (fhir_string_is_empty(id)) return false;
     
-    // FHIR ID regex: [A-Za-z0-9\-\.]{1,64}
-    regex_t regex;
-    int result = regcomp(&regex, "^[A-Za-z0-9\\-\\.]{1,64}$", REG_EXTENDED);
-    if (result != 0) return false;
-    
-    result = regexec(&regex, id, 0, NULL, 0);
-    regfree(&regex);
+    // FHIR ID: [A-Za-z0-9\-\.]{1,64}
+    size_t length = 0;
+    for (const char* p = id; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '-' && *p != '.') return false;
+        if (++length > 64) return false;
+    }
     
-    return result == 0;
+    return true;
 }
 
 bool fhir_validate_uri(const char* uri) {
@@ -362,43 +1375,185 @@ bool fhir_validate_uri(const char* uri) {
 bool fhir_validate_date(const char* date) {
     if (fhir_string_is_empty(date)) return false;
     
-    // FHIR date regex: YYYY-MM-DD
-    regex_t regex;
-    int result = regcomp(&regex, "^[0-9]{4}-[0-9]{2}-[0-9]{2}$", REG_EXTENDED);
-    if (result != 0) return false;
+    // FHIR date: YYYY(-MM(-DD)?)?
+    DateTimeFields fields;
+    const char* end = scan_date(date, &fields);
     
-    result = regexec(&regex, date, 0, NULL, 0);
-    regfree(&regex);
-    
-    return result == 0;
+    return end != NULL && *end == '\0';
 }
 
 bool fhir_validate_datetime(const char* datetime) {
     if (fhir_string_is_empty(datetime)) return false;
     
-    // FHIR datetime regex (simplified)
-    regex_t regex;
-    int result = regcomp(&regex, "^[0-9]{4}-[0-9]{2}-[0-9]{2}T[0-9]{2}:[0-9]{2}:[0-9]{2}", REG_EXTENDED);
-    if (result != 0) return false;
+    // FHIR dateTime: YYYY(-MM(-DD(Thh:mm:ss(.f{1,9})?(Z|(+|-)hh:mm)?)?)?)?
+    DateTimeFields fields;
+    const char* p = scan_date(datetime, &fields);
+    if (!p) return false;
+    if (*p == '\0') return true;
+    if (!fields.day || *p != 'T') return false;
+    
+    p = scan_time(p + 1, &fields);
+    if (!p) return false;
+    if (*p == '\0') return true;
+    
+    p = scan_timezone(p, &fields);
+    return p != NULL && *p == '\0';
+}
+
+bool fhir_validate_instant(const char* instant) {
+    if (fhir_string_is_empty(instant)) return false;
+    
+    // FHIR instant: YYYY-MM-DDThh:mm:ss(.f{1,9})?(Z|(+|-)hh:mm)
+    DateTimeFields fields;
+    const char* p = scan_date(instant, &fields);
+    if (!p || !fields.day || *p != 'T') return false;
+    
+    p = scan_time(p + 1, &fields);
+    if (!p) return false;
+    
+    p = scan_timezone(p, &fields);
+    return p != NULL && *p == '\0';
+}
+
+bool fhir_validate_time(const char* time) {
+    if (fhir_string_is_empty(time)) return false;
     
-    result = regexec(&regex, datetime, 0, NULL, 0);
-    regfree(&regex);
+    // FHIR time: hh:mm:ss(.f{1,9})?
+    DateTimeFields fields = {0};
+    const char* end = scan_time(time, &fields);
     
-    return result == 0;
+    return end != NULL && *end == '\0';
 }
 
 bool fhir_validate_code(const char* code) {
     if (fhir_string_is_empty(code)) return false;
     
-    // FHIR code regex: [^\s]+(\s[^\s]+)*
-    regex_t regex;
-    int result = regcomp(&regex, "^[^\\s]+(\\s[^\\s]+)*$", REG_EXTENDED);
-    if (result != 0) return false;
+    // FHIR code: [^\s]+( [^\s]+)*
+    bool previous_space = true;
+    for (const char* p = code; *p; p++) {
+        if (*p == ' ') {
+            if (previous_space) return false;
+            previous_space = true;
+        } else if (isspace((unsigned char)*p)) {
+            return false;
+        } else {
+            previous_space = false;
+        }
+    }
     
-    result = regexec(&regex, code, 0, NULL, 0);
-    regfree(&regex);
+    return !previous_space;
+}
+
+/* ========================================================================== */
+/* Date/Time Utilities Implementation                                         */
+/* ========================================================================== */
+
+#define MICROSECONDS_PER_DAY INT64_C(86400000000)
+
+// Days from 1970-01-01 to a proleptic Gregorian date
+static int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+bool fhir_datetime_parse(const char* text, FHIRDateTimeValue* value) {
+    if (!value) return false;
+    memset(value, 0, sizeof(*value));
+    if (fhir_string_is_empty(text)) return false;
+    
+    // Same grammar as fhir_validate_datetime, keeping the components
+    DateTimeFields fields;
+    const char* p = scan_date(text, &fields);
+    if (!p) return false;
+    
+    FHIRDateTimePrecision precision = fields.day ? FHIR_DATETIME_PRECISION_DAY :
+        fields.month ? FHIR_DATETIME_PRECISION_MONTH : FHIR_DATETIME_PRECISION_YEAR;
+    if (*p == 'T') {
+        if (!fields.day) return false;
+        p = scan_time(p + 1, &fields);
+        if (!p) return false;
+        if (*p != '\0') {
+            p = scan_timezone(p, &fields);
+            if (!p) return false;
+        }
+        int digits = fields.fraction_digits < 6 ? fields.fraction_digits : 6;
+        precision = (FHIRDateTimePrecision)(FHIR_DATETIME_PRECISION_SECOND + digits);
+    }
+    if (*p != '\0') return false;
+    
+    int64_t days = days_from_civil(fields.year, fields.month ? fields.month : 1,
+                                   fields.day ? fields.day : 1);
+    int64_t seconds = days * 86400 + fields.hour * 3600 + fields.minute * 60 + fields.second -
+                      (int64_t)fields.offset_minutes * 60;
+    value->epoch_us = seconds * 1000000 + fields.microseconds;
+    value->tz_offset_minutes = (int16_t)fields.offset_minutes;
+    value->precision = (uint8_t)precision;
+    value->has_timezone = fields.has_timezone;
+    return true;
+}
+
+void fhir_datetime_to_civil(int64_t epoch_us, int* year, int* month, int* day) {
+    // Floor division so times before the epoch land on the right day
+    int64_t days = epoch_us / MICROSECONDS_PER_DAY;
+    if (epoch_us % MICROSECONDS_PER_DAY < 0) days--;
+    
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t day_of_era = days - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t month_index = (5 * day_of_year + 2) / 153;
+    
+    *day = (int)(day_of_year - (153 * month_index + 2) / 5 + 1);
+    *month = (int)(month_index < 10 ? month_index + 3 : month_index - 9);
+    *year = (int)(year_of_era + era * 400 + (*month <= 2));
+}
+
+int64_t fhir_datetime_end(const FHIRDateTimeValue* value) {
+    if (!value) return 0;
+    
+    int year, month, day;
+    switch (value->precision) {
+        case FHIR_DATETIME_PRECISION_NONE:
+            return value->epoch_us;
+        case FHIR_DATETIME_PRECISION_YEAR:
+            fhir_datetime_to_civil(value->epoch_us, &year, &month, &day);
+            return days_from_civil(year + 1, 1, 1) * MICROSECONDS_PER_DAY;
+        case FHIR_DATETIME_PRECISION_MONTH:
+            fhir_datetime_to_civil(value->epoch_us, &year, &month, &day);
+            return month == 12 ? days_from_civil(year + 1, 1, 1) * MICROSECONDS_PER_DAY :
+                                 days_from_civil(year, month + 1, 1) * MICROSECONDS_PER_DAY;
+        case FHIR_DATETIME_PRECISION_DAY:
+            return value->epoch_us + MICROSECONDS_PER_DAY;
+        default: {
+            // One unit of the last written digit: 1 s down to 1 us
+            int64_t unit = 1000000;
+            for (int i = FHIR_DATETIME_PRECISION_SECOND; i < value->precision; i++) unit /= 10;
+            return value->epoch_us + unit;
+        }
+    }
+}
+
+int fhir_datetime_compare(const FHIRDateTimeValue* a, const FHIRDateTimeValue* b) {
+    bool a_parsed = a && a->precision != FHIR_DATETIME_PRECISION_NONE;
+    bool b_parsed = b && b->precision != FHIR_DATETIME_PRECISION_NONE;
+    if (!a_parsed || !b_parsed) return (int)a_parsed - (int)b_parsed;
     
-    return result == 0;
+    if (a->epoch_us != b->epoch_us) return a->epoch_us < b->epoch_us ? -1 : 1;
+    return (int)a->precision - (int)b->precision;
+}
+
+bool fhir_datetime_overlaps(const FHIRDateTimeValue* a, const FHIRDateTimeValue* b) {
+    if (!a || !b || a->precision == FHIR_DATETIME_PRECISION_NONE ||
+        b->precision == FHIR_DATETIME_PRECISION_NONE) {
+        return false;
+    }
+    return fhir_datetime_ranges_overlap(a->epoch_us, fhir_datetime_end(a),
+                                        b->epoch_us, fhir_datetime_end(b));
 }
 
 /* ========================================================================== */
@@ -424,7 +1579,7 @@ bool fhir_init_base_resource(const char* resource_type, const char* id,
     
     *id_field = fhir_strdup(id);
     if (!*id_field) {
-        free(*resource_type_field);
+        fhir_free(*resource_type_field);
         *resource_type_field = NULL;
         return false;
     }
@@ -434,12 +1589,12 @@ bool fhir_init_base_resource(const char* resource_type, const char* id,
 
 void fhir_free_base_resource(char** resource_type_field, char** id_field) {
     if (resource_type_field) {
-        free(*resource_type_field);
+        fhir_free(*resource_type_field);
         *resource_type_field = NULL;
     }
     
     if (id_field) {
-        free(*id_field);
+        fhir_free(*id_field);
         *id_field = NULL;
     }
 }
@@ -468,11 +1623,11 @@ bool fhir_validate_base_resource(const char* resource_type, const char* id) {
 /* ========================================================================== */
 
 void fhir_set_log_level(FHIRLogLevel level) {
-    g_log_level = level;
+    fhir_atomic_store_relaxed(&fhir_log_level, (int)level);
 }
 
 void fhir_log(FHIRLogLevel level, const char* file, int line, const char* format, ...) {
-    if (level < g_log_level) return;
+    if ((int)level < fhir_atomic_load_relaxed(&fhir_log_level)) return;
     
     const char* level_strings[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
     const char* level_str = (level >= 0 && level <= FHIR_LOG_LEVEL_FATAL) ? 
@@ -487,4 +1642,208 @@ void fhir_log(FHIRLogLevel level, const char* file, int line, const char* format
     
     fprintf(stderr, "\n");
     fflush(stderr);
-}
\ No newline at end of file
+}
+
+/* ========================================================================== */
+/* Performance Counters and Tracing Implementation                            */
+/* ========================================================================== */
+
+#define FHIR_PERF_COUNTERS 1
+#define FHIR_PERF_TRACE 2
+
+typedef struct {
+    FHIRAtomicLong parsed;
+    FHIRAtomicLong failures;
+    FHIRAtomicLong bytes;
+    FHIRAtomicLong calls[FHIR_PERF_PHASE_COUNT];
+    FHIRAtomicLong nanoseconds[FHIR_PERF_PHASE_COUNT];
+} FHIRPerfCell;
+
+// One thread's counters; a slot is handed to a new thread once its owner exits
+typedef struct FHIRPerfSlot {
+    struct FHIRPerfSlot* next;
+    bool in_use;                // Guarded by g_perf_lock
+    FHIRPerfCell cells[FHIR_RESOURCE_TYPE_COUNT];
+} FHIRPerfSlot;
+
+static FHIRAtomicInt g_perf_mode;
+static FHIRAtomicInt g_perf_lock;
+static FHIRPerfSlot* g_perf_slots;  // Only grows; guarded by g_perf_lock
+static FHIR_THREAD_LOCAL FHIRPerfSlot* g_thread_perf_slot;
+static pthread_key_t g_perf_slot_key;
+static pthread_once_t g_perf_slot_key_once = PTHREAD_ONCE_INIT;
+static FHIRTraceCallback g_trace_callback;
+static void* g_trace_context;
+
+static const char* const g_perf_phase_names[FHIR_PERF_PHASE_COUNT] = {
+    "tokenize", "deserialize", "validate", "serialize", "python"
+};
+
+static uint64_t perf_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void perf_lock(void) {
+    int expected = 0;
+    while (!fhir_atomic_compare_exchange(&g_perf_lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void perf_unlock(void) {
+    fhir_atomic_store(&g_perf_lock, 0);
+}
+
+static void perf_release_slot(void* slot) {
+    perf_lock();
+    ((FHIRPerfSlot*)slot)->in_use = false;
+    perf_unlock();
+}
+
+static void perf_create_slot_key(void) {
+    pthread_key_create(&g_perf_slot_key, perf_release_slot);
+}
+
+static FHIRPerfSlot* perf_acquire_slot(void) {
+    pthread_once(&g_perf_slot_key_once, perf_create_slot_key);
+    
+    perf_lock();
+    FHIRPerfSlot* slot = g_perf_slots;
+    while (slot && slot->in_use) {
+        slot = slot->next;
+    }
+    if (!slot) {
+        slot = heap_calloc(1, sizeof(FHIRPerfSlot), false);
+        if (slot) {
+            slot->next = g_perf_slots;
+            g_perf_slots = slot;
+        }
+    }
+    if (slot) {
+        slot->in_use = true;
+    }
+    perf_unlock();
+    
+    if (slot) {
+        pthread_setspecific(g_perf_slot_key, slot);
+        g_thread_perf_slot = slot;
+    }
+    return slot;
+}
+
+// Only the owning thread writes a slot, so a plain add suffices
+static inline void perf_add(FHIRAtomicLong* counter, uint64_t value) {
+    fhir_atomic_store_relaxed(counter, fhir_atomic_load_relaxed(counter) + (long long)value);
+}
+
+static void perf_count(const FHIRTraceSpan* span) {
+    FHIRPerfSlot* slot = g_thread_perf_slot ? g_thread_perf_slot : perf_acquire_slot();
+    if (!slot || span->resource_type < 0 || span->resource_type >= FHIR_RESOURCE_TYPE_COUNT) {
+        return;
+    }
+    
+    FHIRPerfCell* cell = &slot->cells[span->resource_type];
+    perf_add(&cell->calls[span->phase], 1);
+    perf_add(&cell->nanoseconds[span->phase], span->duration_ns);
+    perf_add(&cell->bytes, span->bytes);
+    if (!span->ok) {
+        perf_add(&cell->failures, 1);
+    } else if (span->phase == FHIR_PERF_PHASE_DESERIALIZE) {
+        perf_add(&cell->parsed, 1);
+    }
+}
+
+bool fhir_perf_set_enabled(bool enabled) {
+    perf_lock();
+    int mode = fhir_atomic_load_relaxed(&g_perf_mode);
+    fhir_atomic_store(&g_perf_mode, enabled ? mode | FHIR_PERF_COUNTERS : mode & ~FHIR_PERF_COUNTERS);
+    perf_unlock();
+    return (mode & FHIR_PERF_COUNTERS) != 0;
+}
+
+void fhir_trace_set_callback(FHIRTraceCallback callback, void* context) {
+    perf_lock();
+    g_trace_callback = callback;
+    g_trace_context = context;
+    int mode = fhir_atomic_load_relaxed(&g_perf_mode);
+    fhir_atomic_store(&g_perf_mode, callback ? mode | FHIR_PERF_TRACE : mode & ~FHIR_PERF_TRACE);
+    perf_unlock();
+}
+
+void fhir_perf_begin(FHIRPerfSpan* span, FHIRPerfPhase phase, int resource_type) {
+    span->phase = phase;
+    span->resource_type = resource_type;
+#ifdef FHIR_USDT
+    span->start_ns = perf_now_ns();
+#else
+    span->start_ns = fhir_atomic_load_relaxed(&g_perf_mode) ? perf_now_ns() : 0;
+#endif
+}
+
+void fhir_perf_end(FHIRPerfSpan* span, size_t bytes, bool ok) {
+    if (span->start_ns == 0 || (unsigned)span->phase >= FHIR_PERF_PHASE_COUNT) {
+        return;
+    }
+    
+    int mode = fhir_atomic_load_relaxed(&g_perf_mode);
+    FHIRTraceSpan finished = {
+        span->phase, span->resource_type, span->start_ns, perf_now_ns() - span->start_ns, bytes, ok
+    };
+    if (mode & FHIR_PERF_COUNTERS) {
+        perf_count(&finished);
+    }
+    if (mode & FHIR_PERF_TRACE) {
+        FHIRTraceCallback callback = g_trace_callback;
+        if (callback) {
+            callback(g_trace_context, &finished);
+        }
+    }
+#ifdef FHIR_USDT
+    DTRACE_PROBE5(fast_fhir, span, finished.phase, finished.resource_type, finished.start_ns,
+                  finished.duration_ns, finished.ok);
+#endif
+}
+
+bool fhir_perf_get_counters(int resource_type, FHIRPerfCounters* counters) {
+    if (!counters || resource_type < 0 || resource_type >= FHIR_RESOURCE_TYPE_COUNT) {
+        return false;
+    }
+    
+    memset(counters, 0, sizeof(FHIRPerfCounters));
+    perf_lock();
+    for (FHIRPerfSlot* slot = g_perf_slots; slot; slot = slot->next) {
+        FHIRPerfCell* cell = &slot->cells[resource_type];
+        counters->parsed += (uint64_t)fhir_atomic_load_relaxed(&cell->parsed);
+        counters->failures += (uint64_t)fhir_atomic_load_relaxed(&cell->failures);
+        counters->bytes += (uint64_t)fhir_atomic_load_relaxed(&cell->bytes);
+        for (int phase = 0; phase < FHIR_PERF_PHASE_COUNT; phase++) {
+            counters->calls[phase] += (uint64_t)fhir_atomic_load_relaxed(&cell->calls[phase]);
+            counters->nanoseconds[phase] += (uint64_t)fhir_atomic_load_relaxed(&cell->nanoseconds[phase]);
+        }
+    }
+    perf_unlock();
+    return true;
+}
+
+void fhir_perf_reset(void) {
+    perf_lock();
+    for (FHIRPerfSlot* slot = g_perf_slots; slot; slot = slot->next) {
+        for (size_t type = 0; type < FHIR_RESOURCE_TYPE_COUNT; type++) {
+            FHIRPerfCell* cell = &slot->cells[type];
+            fhir_atomic_store_relaxed(&cell->parsed, 0);
+            fhir_atomic_store_relaxed(&cell->failures, 0);
+            fhir_atomic_store_relaxed(&cell->bytes, 0);
+            for (int phase = 0; phase < FHIR_PERF_PHASE_COUNT; phase++) {
+                fhir_atomic_store_relaxed(&cell->calls[phase], 0);
+                fhir_atomic_store_relaxed(&cell->nanoseconds[phase], 0);
+            }
+        }
+    }
+    perf_unlock();
+}
+
+const char* fhir_perf_phase_name(FHIRPerfPhase phase) {
+    return (unsigned)phase < FHIR_PERF_PHASE_COUNT ? g_perf_phase_names[phase] : "unknown";
+}
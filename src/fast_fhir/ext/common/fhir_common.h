@@ -14,12 +14,76 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <cjson/cJSON.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ========================================================================== */
+/* Thread Support                                                             */
+/* ========================================================================== */
+
+/**
+ * @brief Storage class for per-thread library state
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define FHIR_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define FHIR_THREAD_LOCAL __declspec(thread)
+#else
+#define FHIR_THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief Atomic integers and the operations used for shared resource state
+ *
+ * C11 <stdatomic.h> when the compiler provides it, otherwise the GCC/Clang
+ * __atomic builtins, which follow the same memory model. Loads are acquire
+ * unless named relaxed, stores are release; the read-modify-write operations
+ * name their ordering. FHIRAtomicLong is for counters that may exceed int.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+typedef atomic_int FHIRAtomicInt;
+typedef atomic_llong FHIRAtomicLong;
+#define fhir_atomic_init(ptr, value) atomic_init((ptr), (value))
+#define fhir_atomic_load(ptr) \
+    atomic_load_explicit((FHIRAtomicInt*)(ptr), memory_order_acquire)
+#define fhir_atomic_load_relaxed(ptr) atomic_load_explicit((ptr), memory_order_relaxed)
+#define fhir_atomic_store(ptr, value) \
+    atomic_store_explicit((ptr), (value), memory_order_release)
+#define fhir_atomic_store_relaxed(ptr, value) \
+    atomic_store_explicit((ptr), (value), memory_order_relaxed)
+#define fhir_atomic_fetch_add_relaxed(ptr, value) \
+    atomic_fetch_add_explicit((ptr), (value), memory_order_relaxed)
+#define fhir_atomic_fetch_sub_release(ptr, value) \
+    atomic_fetch_sub_explicit((ptr), (value), memory_order_release)
+#define fhir_atomic_compare_exchange(ptr, expected, desired) \
+    atomic_compare_exchange_strong_explicit((ptr), (expected), (desired), \
+                                            memory_order_acq_rel, memory_order_acquire)
+#define fhir_atomic_fence_acquire() atomic_thread_fence(memory_order_acquire)
+#elif defined(__GNUC__) || defined(__clang__)
+typedef int FHIRAtomicInt;
+typedef long long FHIRAtomicLong;
+#define fhir_atomic_init(ptr, value) (*(ptr) = (value))
+#define fhir_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define fhir_atomic_load_relaxed(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define fhir_atomic_store(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define fhir_atomic_store_relaxed(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELAXED)
+#define fhir_atomic_fetch_add_relaxed(ptr, value) \
+    __atomic_fetch_add((ptr), (value), __ATOMIC_RELAXED)
+#define fhir_atomic_fetch_sub_release(ptr, value) \
+    __atomic_fetch_sub((ptr), (value), __ATOMIC_RELEASE)
+#define fhir_atomic_compare_exchange(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), false, \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define fhir_atomic_fence_acquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#error "fhir_common.h requires C11 atomics or GCC/Clang __atomic builtins"
+#endif
+
 /* ========================================================================== */
 /* Error Handling                                                             */
 /* ========================================================================== */
@@ -37,22 +101,32 @@ typedef enum {
     FHIR_ERROR_VALIDATION_FAILED,
     FHIR_ERROR_PARSE_FAILED,
     FHIR_ERROR_SERIALIZE_FAILED,
+    FHIR_ERROR_IO,
     FHIR_ERROR_UNKNOWN
 } FHIRErrorCode;
 
+#define FHIR_ERROR_MESSAGE_MAX 256
+#define FHIR_ERROR_FIELD_MAX 64
+
 /**
  * @brief Error information structure
+ *
+ * One instance exists per thread. Message and field text are copied
+ * (truncated if necessary) into inline buffers, so setting an error never
+ * allocates.
  */
 typedef struct {
     FHIRErrorCode code;
-    char* message;
-    char* field;
+    const char* message;    /**< Points into message_buffer, NULL if none */
+    const char* field;      /**< Points into field_buffer, NULL if none */
     int line;
     const char* file;
+    char message_buffer[FHIR_ERROR_MESSAGE_MAX];
+    char field_buffer[FHIR_ERROR_FIELD_MAX];
 } FHIRError;
 
 /**
- * @brief Get the last error that occurred
+ * @brief Get the last error that occurred on the calling thread
  * @return Pointer to error information or NULL if no error
  */
 const FHIRError* fhir_get_last_error(void);
@@ -124,6 +198,375 @@ void* fhir_calloc(size_t count, size_t size);
  */
 void fhir_free(void* ptr);
 
+/* ========================================================================== */
+/* Arena Allocation                                                           */
+/* ========================================================================== */
+
+#define FHIR_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+/**
+ * @brief Bump allocator owning whole resource graphs
+ *
+ * While an arena is current on a thread (fhir_arena_set_current),
+ * fhir_malloc, fhir_calloc, fhir_realloc and fhir_strdup carve memory out of
+ * it and fhir_free ignores pointers it owns. Everything is released at once
+ * by fhir_arena_reset or fhir_arena_destroy. An arena must only be used by
+ * one thread at a time.
+ */
+typedef struct FHIRArena FHIRArena;
+
+/**
+ * @brief Arena usage counters
+ */
+typedef struct {
+    size_t allocation_count;    /**< Allocations served since the last reset */
+    size_t bytes_used;          /**< Bytes handed out, including headers and padding */
+    size_t bytes_reserved;      /**< Bytes held in blocks */
+    size_t block_count;         /**< Blocks obtained from malloc */
+} FHIRArenaStats;
+
+/**
+ * @brief Create an arena
+ * @param block_size Block size in bytes (0 for FHIR_ARENA_DEFAULT_BLOCK_SIZE)
+ * @return New arena or NULL on failure
+ */
+FHIRArena* fhir_arena_create(size_t block_size);
+
+/**
+ * @brief Allocate memory from an arena
+ * @param arena Arena to allocate from
+ * @param size Number of bytes (aligned for any FHIR type)
+ * @return Uninitialized memory or NULL on failure
+ */
+void* fhir_arena_alloc(FHIRArena* arena, size_t size);
+
+/**
+ * @brief Release every allocation while keeping the first block for reuse
+ * @param arena Arena to reset (may be NULL)
+ */
+void fhir_arena_reset(FHIRArena* arena);
+
+/**
+ * @brief Destroy an arena and all memory allocated from it
+ * @param arena Arena to destroy (may be NULL)
+ */
+void fhir_arena_destroy(FHIRArena* arena);
+
+/**
+ * @brief Check whether a pointer was allocated from an arena
+ * @param arena Arena to search
+ * @param ptr Pointer to check
+ * @return true if ptr lies inside one of the arena's blocks
+ */
+bool fhir_arena_owns(const FHIRArena* arena, const void* ptr);
+
+/**
+ * @brief Get arena usage counters
+ * @param arena Arena to query
+ * @param stats Output counters
+ */
+void fhir_arena_get_stats(const FHIRArena* arena, FHIRArenaStats* stats);
+
+/**
+ * @brief Route fhir_* allocations on the calling thread to an arena
+ * @param arena Arena to make current (NULL restores the heap)
+ * @return Previously current arena, to be restored by the caller
+ */
+FHIRArena* fhir_arena_set_current(FHIRArena* arena);
+
+/**
+ * @brief Get the arena current on the calling thread
+ * @return Current arena or NULL when allocating from the heap
+ */
+FHIRArena* fhir_arena_get_current(void);
+
+/* ========================================================================== */
+/* Object Pools                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Whether fixed-size object pools are compiled in
+ *
+ * Define as 0 to send pool allocations straight to fhir_calloc/fhir_free,
+ * e.g. so AddressSanitizer sees every use after free.
+ */
+#ifndef FHIR_OBJECT_POOLS
+#define FHIR_OBJECT_POOLS 1
+#endif
+
+/**
+ * @brief Most objects a thread keeps cached per pool before returning a
+ * batch to the shared free list
+ */
+#define FHIR_OBJECT_POOL_CACHE_SIZE 64
+
+/**
+ * @brief Free list of identically sized objects
+ *
+ * Declared static next to the type it serves and initialized with
+ * FHIR_OBJECT_POOL_INIT; the pool's state is set up on first use. Freed
+ * objects go to a small per-thread cache and overflow to a shared list, so
+ * the common create/destroy cycle on one thread takes no lock. Objects are
+ * ordinary heap blocks: memory from a pool may be released with fhir_free
+ * and heap memory of the right size may be given back to a pool.
+ */
+typedef struct {
+    const char* name;
+    size_t object_size;
+    FHIRAtomicInt slot;         /**< Index in the pool table plus one; 0 until first use */
+} FHIRObjectPool;
+
+#define FHIR_OBJECT_POOL_INIT(name, type) { (name), sizeof(type), 0 }
+
+/**
+ * @brief Pool usage counters
+ */
+typedef struct {
+    size_t heap_allocations;    /**< Objects the pool had to take from the heap */
+    size_t shared_objects;      /**< Objects on the shared free list */
+    size_t thread_objects;      /**< Objects in the calling thread's cache */
+} FHIRObjectPoolStats;
+
+/**
+ * @brief Allocate a zeroed object from a pool
+ *
+ * While an arena is current the object comes from the arena instead, as
+ * with fhir_calloc.
+ *
+ * @param pool Pool to allocate from
+ * @return Zeroed object or NULL on failure
+ */
+void* fhir_pool_alloc(FHIRObjectPool* pool);
+
+/**
+ * @brief Return an object to its pool
+ * @param pool Pool the object's size belongs to
+ * @param object Object to release (can be NULL); arena memory is ignored
+ */
+void fhir_pool_free(FHIRObjectPool* pool, void* object);
+
+/**
+ * @brief Release pooled memory back to the heap
+ *
+ * Frees every object on the shared free lists and in the calling thread's
+ * caches. Other threads keep their caches (at most
+ * FHIR_OBJECT_POOL_CACHE_SIZE objects per pool) until they trim or exit.
+ *
+ * @return Bytes released
+ */
+size_t fhir_pool_trim(void);
+
+/**
+ * @brief Get pool usage counters
+ * @param pool Pool to query
+ * @param stats Output counters
+ */
+void fhir_pool_get_stats(FHIRObjectPool* pool, FHIRObjectPoolStats* stats);
+
+/* ========================================================================== */
+/* String Interning                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief String pool usage counters
+ */
+typedef struct {
+    size_t string_count;        /**< Distinct strings held by the pool */
+    size_t bytes_stored;        /**< Bytes of string text, including terminators */
+    size_t lookup_count;        /**< Calls to fhir_intern / fhir_intern_n */
+    size_t hit_count;           /**< Lookups that found an existing string */
+} FHIRInternStats;
+
+/**
+ * @brief Get the canonical copy of a string from the string pool
+ *
+ * Intended for low-cardinality values repeated across many resources:
+ * codes, coding and identifier systems, units and canonical URLs. Equal
+ * text always yields the same pointer, so interned values compare equal
+ * by pointer. The returned string must not be modified or passed to
+ * fhir_free; it lives until fhir_intern_clear. Safe to call from any
+ * thread, independently of the current arena.
+ *
+ * Each program or extension module that links this file has its own pool
+ * unless it adopts another with fhir_intern_use_pool; the Python
+ * extensions share one (fhir_python_runtime.h). Pointer equality only
+ * holds between strings interned in the same pool, so comparisons go
+ * through fhir_intern_equals.
+ *
+ * @param str String to intern
+ * @return Interned string or NULL on failure
+ */
+const char* fhir_intern(const char* str);
+
+/**
+ * @brief Intern a string of known length (need not be NUL-terminated)
+ * @param str String to intern
+ * @param length Length of str in bytes
+ * @return Interned NUL-terminated string or NULL on failure
+ */
+const char* fhir_intern_n(const char* str, size_t length);
+
+/**
+ * @brief Compare two strings that are usually interned
+ *
+ * Equal pointers (the interned case) are accepted without reading the text;
+ * anything else falls back to a string comparison.
+ *
+ * @param a First string (can be NULL)
+ * @param b Second string (can be NULL)
+ * @return true if both are NULL or hold the same text
+ */
+static inline bool fhir_intern_equals(const char* a, const char* b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/**
+ * @brief Get string pool usage counters
+ * @param stats Output counters
+ */
+void fhir_intern_get_stats(FHIRInternStats* stats);
+
+/**
+ * @brief Free every interned string
+ *
+ * Only safe once no resource refers to an interned value any more
+ * (typically at shutdown or between test cases).
+ */
+void fhir_intern_clear(void);
+
+/**
+ * @brief Entry points of a string pool
+ */
+typedef struct {
+    const char* (*intern_n)(const char* str, size_t length);
+    void (*get_stats)(FHIRInternStats* stats);
+    void (*clear)(void);
+} FHIRInternPool;
+
+/**
+ * @brief Get the pool behind fhir_intern and the other fhir_intern_ functions
+ * @return The pool adopted with fhir_intern_use_pool, or this copy's own
+ */
+const FHIRInternPool* fhir_intern_pool(void);
+
+/**
+ * @brief Intern through the pool of another copy of this file
+ *
+ * Lets separately linked extension modules hand out the same pointers.
+ * Not thread-safe: call before this copy interns from more than one
+ * thread. Strings interned earlier stay valid but no longer match new
+ * ones by pointer.
+ *
+ * @param pool Pool from the other copy's fhir_intern_pool, or NULL for this copy's own
+ */
+void fhir_intern_use_pool(const FHIRInternPool* pool);
+
+/* ========================================================================== */
+/* Memory Accounting                                                          */
+/* ========================================================================== */
+
+/**
+ * @brief Whether allocation accounting is compiled in
+ *
+ * Byte counts come from the allocator's own usable-size query
+ * (malloc_usable_size, malloc_size or _msize), so no header is added to
+ * allocations and memory stays interchangeable with libc free. Defaults to 1
+ * where such a query exists; define as 0 to compile the counters out.
+ */
+#ifndef FHIR_MEMORY_STATS
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+#define FHIR_MEMORY_STATS 1
+#else
+#define FHIR_MEMORY_STATS 0
+#endif
+#endif
+
+/**
+ * @brief Allocation counters for the process or for one thread
+ *
+ * Heap counters cover every byte the fhir_* allocators and the arena and
+ * string pools take from libc; a reallocation counts as a free and an
+ * allocation. Counting starts when it is enabled, so memory allocated
+ * earlier but freed while enabled makes live_bytes smaller than the true
+ * figure (possibly negative). Per-thread live_bytes is likewise negative on
+ * a thread that frees memory allocated elsewhere.
+ */
+typedef struct {
+    size_t allocations;         /**< Heap allocations */
+    size_t frees;               /**< Heap frees through fhir_free and the pools */
+    size_t arena_allocations;   /**< Requests served by the current arena */
+    size_t bytes_allocated;     /**< Bytes obtained from the heap */
+    size_t bytes_freed;         /**< Bytes returned to the heap */
+    int64_t live_bytes;         /**< Bytes allocated and not yet freed */
+    int64_t peak_bytes;         /**< Highest live_bytes since the last reset */
+} FHIRMemoryStats;
+
+/**
+ * @brief Allocations attributed to one resource type
+ *
+ * fhir_* allocations are attributed to the type set on the allocating
+ * thread by fhir_memory_set_type, which the generic create, parse,
+ * from_json, clone and from_binary entry points do for the resource they
+ * work on. Arena blocks and the string pool serve every type and are not
+ * attributed.
+ */
+typedef struct {
+    size_t allocations;         /**< Heap and arena allocations */
+    size_t bytes_allocated;     /**< Heap bytes, or bytes requested from an arena */
+} FHIRMemoryTypeStats;
+
+/**
+ * @brief Turn allocation accounting on or off
+ *
+ * While off (the default) an allocation pays one relaxed load; while on it
+ * also updates thread-local counters and a few shared atomics.
+ *
+ * @param enabled Whether to count allocations
+ * @return Previous setting, or false when FHIR_MEMORY_STATS is 0
+ */
+bool fhir_memory_stats_set_enabled(bool enabled);
+
+/**
+ * @brief Check whether allocation accounting is on
+ * @return true if allocations are being counted
+ */
+bool fhir_memory_stats_enabled(void);
+
+/**
+ * @brief Get the process-wide counters
+ * @param stats Output counters
+ */
+void fhir_memory_get_stats(FHIRMemoryStats* stats);
+
+/**
+ * @brief Get the counters of the calling thread
+ * @param stats Output counters
+ */
+void fhir_memory_get_thread_stats(FHIRMemoryStats* stats);
+
+/**
+ * @brief Get the counters attributed to a resource type
+ * @param resource_type FHIRResourceType value
+ * @param stats Output counters
+ * @return false if resource_type is out of range
+ */
+bool fhir_memory_get_type_stats(int resource_type, FHIRMemoryTypeStats* stats);
+
+/**
+ * @brief Zero the cumulative counters and restart peaks from the live bytes
+ *
+ * Resets the process-wide and per-type counters and those of the calling
+ * thread; other threads keep their own until they reset.
+ */
+void fhir_memory_stats_reset(void);
+
+/**
+ * @brief Attribute the calling thread's allocations to a resource type
+ * @param resource_type FHIRResourceType value (0 for none)
+ * @return Previous type, to be restored by the caller
+ */
+int fhir_memory_set_type(int resource_type);
+
 /* ========================================================================== */
 /* Array Management                                                           */
 /* ========================================================================== */
@@ -284,19 +727,33 @@ bool fhir_validate_id(const char* id);
 bool fhir_validate_uri(const char* uri);
 
 /**
- * @brief Validate FHIR date format (YYYY-MM-DD)
+ * @brief Validate FHIR date format (YYYY, YYYY-MM or YYYY-MM-DD)
  * @param date Date string to validate
  * @return true if valid, false otherwise
  */
 bool fhir_validate_date(const char* date);
 
 /**
- * @brief Validate FHIR datetime format (YYYY-MM-DDTHH:MM:SS[.sss][Z|(+|-)HH:MM])
+ * @brief Validate FHIR dateTime format (partial date, or YYYY-MM-DDThh:mm:ss[.fffffffff][Z|(+|-)hh:mm])
  * @param datetime Datetime string to validate
  * @return true if valid, false otherwise
  */
 bool fhir_validate_datetime(const char* datetime);
 
+/**
+ * @brief Validate FHIR instant format (YYYY-MM-DDThh:mm:ss[.fffffffff](Z|(+|-)hh:mm))
+ * @param instant Instant string to validate
+ * @return true if valid, false otherwise
+ */
+bool fhir_validate_instant(const char* instant);
+
+/**
+ * @brief Validate FHIR time format (hh:mm:ss[.fffffffff])
+ * @param time Time string to validate
+ * @return true if valid, false otherwise
+ */
+bool fhir_validate_time(const char* time);
+
 /**
  * @brief Validate FHIR code format
  * @param code Code string to validate
@@ -304,6 +761,95 @@ bool fhir_validate_datetime(const char* datetime);
  */
 bool fhir_validate_code(const char* code);
 
+/* ========================================================================== */
+/* Date/Time Utilities                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Precision of a parsed date, dateTime or instant
+ *
+ * SECOND + n stands for n fractional digits; digits past the sixth are
+ * truncated to MICROSECOND.
+ */
+typedef enum {
+    FHIR_DATETIME_PRECISION_NONE = 0,       /**< Not parsed or invalid */
+    FHIR_DATETIME_PRECISION_YEAR = 1,
+    FHIR_DATETIME_PRECISION_MONTH = 2,
+    FHIR_DATETIME_PRECISION_DAY = 3,
+    FHIR_DATETIME_PRECISION_SECOND = 4,
+    FHIR_DATETIME_PRECISION_MILLISECOND = 7,
+    FHIR_DATETIME_PRECISION_MICROSECOND = 10
+} FHIRDateTimePrecision;
+
+/**
+ * @brief Pre-parsed date, dateTime or instant
+ *
+ * epoch_us is the UTC start of the value: partial dates and values without a
+ * timezone are taken as UTC, so comparisons never reparse the string.
+ */
+typedef struct {
+    int64_t epoch_us;             /**< Microseconds since 1970-01-01T00:00:00Z */
+    int16_t tz_offset_minutes;    /**< Offset that was written, 0 for Z or none */
+    uint8_t precision;            /**< FHIRDateTimePrecision */
+    bool has_timezone;
+} FHIRDateTimeValue;
+
+/**
+ * @brief Parse a FHIR date, dateTime or instant string
+ * @param text String in the dateTime grammar (a superset of date and instant)
+ * @param value Output value, precision NONE when text is invalid
+ * @return true if text is valid, false otherwise
+ */
+bool fhir_datetime_parse(const char* text, FHIRDateTimeValue* value);
+
+/**
+ * @brief Get the exclusive end of the interval a value covers at its precision
+ *
+ * "2024-02" covers [2024-02-01, 2024-03-01), "2024-02-01T10:00:00.5Z" covers
+ * a tenth of a second.
+ *
+ * @param value Parsed value
+ * @return End in epoch microseconds, or epoch_us when precision is NONE
+ */
+int64_t fhir_datetime_end(const FHIRDateTimeValue* value);
+
+/**
+ * @brief Order two parsed values
+ *
+ * Values order by their start instant, with the coarser precision first when
+ * the starts are equal; unparsed values sort before everything else.
+ *
+ * @param a First value
+ * @param b Second value
+ * @return Negative, zero or positive as a is before, equal to or after b
+ */
+int fhir_datetime_compare(const FHIRDateTimeValue* a, const FHIRDateTimeValue* b);
+
+/**
+ * @brief Check whether two half-open [start, end) ranges share an instant
+ */
+static inline bool fhir_datetime_ranges_overlap(int64_t start_a, int64_t end_a,
+                                                int64_t start_b, int64_t end_b) {
+    return start_a < end_b && start_b < end_a;
+}
+
+/**
+ * @brief Check whether the intervals two values cover at their precision overlap
+ * @param a First value
+ * @param b Second value
+ * @return true if both are parsed and overlap, false otherwise
+ */
+bool fhir_datetime_overlaps(const FHIRDateTimeValue* a, const FHIRDateTimeValue* b);
+
+/**
+ * @brief Get the UTC calendar date of an epoch time
+ * @param epoch_us Microseconds since the epoch
+ * @param year Output year
+ * @param month Output month (1-12)
+ * @param day Output day of month (1-31)
+ */
+void fhir_datetime_to_civil(int64_t epoch_us, int* year, int* month, int* day);
+
 /* ========================================================================== */
 /* Resource Utilities                                                         */
 /* ========================================================================== */
@@ -349,6 +895,23 @@ typedef enum {
     FHIR_LOG_LEVEL_FATAL
 } FHIRLogLevel;
 
+/**
+ * @brief Lowest level the FHIR_LOG_* macros compile in
+ *
+ * Define as FHIR_LOG_LEVEL_INFO or higher to drop debug logging from a
+ * build altogether.
+ */
+#ifndef FHIR_LOG_MIN_LEVEL
+#define FHIR_LOG_MIN_LEVEL FHIR_LOG_LEVEL_DEBUG
+#endif
+
+/**
+ * @brief Current log level (an FHIRLogLevel), read inline by the FHIR_LOG_* macros
+ *
+ * Set it with fhir_set_log_level. Atomic, since any thread may log or set it.
+ */
+extern FHIRAtomicInt fhir_log_level;
+
 /**
  * @brief Set logging level
  * @param level Log level
@@ -365,12 +928,146 @@ void fhir_set_log_level(FHIRLogLevel level);
  */
 void fhir_log(FHIRLogLevel level, const char* file, int line, const char* format, ...);
 
-/* Convenience macros for logging */
-#define FHIR_LOG_DEBUG(fmt, ...) fhir_log(FHIR_LOG_LEVEL_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define FHIR_LOG_INFO(fmt, ...) fhir_log(FHIR_LOG_LEVEL_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define FHIR_LOG_WARN(fmt, ...) fhir_log(FHIR_LOG_LEVEL_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define FHIR_LOG_ERROR(fmt, ...) fhir_log(FHIR_LOG_LEVEL_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define FHIR_LOG_FATAL(fmt, ...) fhir_log(FHIR_LOG_LEVEL_FATAL, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+/* Convenience macros for logging; arguments are not evaluated below the current level */
+#define FHIR_LOG_ENABLED(level) \
+    ((level) >= FHIR_LOG_MIN_LEVEL && (int)(level) >= fhir_atomic_load_relaxed(&fhir_log_level))
+#define FHIR_LOG_AT(level, fmt, ...) \
+    do { \
+        if (FHIR_LOG_ENABLED(level)) { \
+            fhir_log((level), __FILE__, __LINE__, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+#define FHIR_LOG_DEBUG(fmt, ...) FHIR_LOG_AT(FHIR_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define FHIR_LOG_INFO(fmt, ...) FHIR_LOG_AT(FHIR_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define FHIR_LOG_WARN(fmt, ...) FHIR_LOG_AT(FHIR_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define FHIR_LOG_ERROR(fmt, ...) FHIR_LOG_AT(FHIR_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define FHIR_LOG_FATAL(fmt, ...) FHIR_LOG_AT(FHIR_LOG_LEVEL_FATAL, fmt, ##__VA_ARGS__)
+
+/* ========================================================================== */
+/* Performance Counters and Tracing                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Phases of resource processing timed by spans
+ */
+typedef enum {
+    FHIR_PERF_PHASE_TOKENIZE = 0,   /**< JSON text to a parsed tree */
+    FHIR_PERF_PHASE_DESERIALIZE,    /**< Parsed tree to a typed resource */
+    FHIR_PERF_PHASE_VALIDATE,       /**< Resource validation */
+    FHIR_PERF_PHASE_SERIALIZE,      /**< Resource to JSON */
+    FHIR_PERF_PHASE_PYTHON,         /**< Conversion to Python objects */
+    FHIR_PERF_PHASE_COUNT
+} FHIRPerfPhase;
+
+/**
+ * @brief Counters of one resource type, summed over all threads
+ *
+ * Type 0 (FHIR_RESOURCE_TYPE_UNKNOWN) collects work done before the type is
+ * known, chiefly tokenizing.
+ */
+typedef struct {
+    uint64_t parsed;                                /**< Successful deserializations */
+    uint64_t failures;                              /**< Spans that ended in failure */
+    uint64_t bytes;                                 /**< Input bytes reported by spans */
+    uint64_t calls[FHIR_PERF_PHASE_COUNT];          /**< Spans per phase */
+    uint64_t nanoseconds[FHIR_PERF_PHASE_COUNT];    /**< Time per phase */
+} FHIRPerfCounters;
+
+/**
+ * @brief A finished span, as passed to the trace callback
+ */
+typedef struct {
+    FHIRPerfPhase phase;
+    int resource_type;          /**< FHIRResourceType value, 0 if unknown */
+    uint64_t start_ns;          /**< Monotonic clock */
+    uint64_t duration_ns;
+    size_t bytes;               /**< Input bytes, 0 if not applicable */
+    bool ok;
+} FHIRTraceSpan;
+
+/**
+ * @brief Receives every finished span while installed
+ *
+ * Called on the thread that ran the span, possibly from several threads at
+ * once; it must be thread-safe and should be cheap. A bridge to
+ * OpenTelemetry can record span->start_ns and duration_ns as an
+ * explicit-time span.
+ */
+typedef void (*FHIRTraceCallback)(void* context, const FHIRTraceSpan* span);
+
+/**
+ * @brief Span in progress, kept on the caller's stack
+ *
+ * resource_type may be set between fhir_perf_begin and fhir_perf_end when
+ * the type only becomes known during the span.
+ */
+typedef struct {
+    uint64_t start_ns;          /**< 0 when instrumentation was off at begin */
+    FHIRPerfPhase phase;
+    int resource_type;
+} FHIRPerfSpan;
+
+/**
+ * @brief Turn the per-type counters on or off
+ *
+ * Counters live in per-thread slots, so recording a span writes only to
+ * memory owned by the recording thread; readers sum the slots. While
+ * neither counters nor a trace callback are active a span costs one
+ * relaxed load at each end.
+ *
+ * @param enabled Whether to count spans
+ * @return Previous setting
+ */
+bool fhir_perf_set_enabled(bool enabled);
+
+/**
+ * @brief Install a trace callback
+ *
+ * Install or remove it while no spans are running (typically at startup).
+ * Builds with FHIR_USDT defined also fire a fast_fhir:span USDT probe.
+ *
+ * @param callback Callback (NULL to remove)
+ * @param context Passed to every call
+ */
+void fhir_trace_set_callback(FHIRTraceCallback callback, void* context);
+
+/**
+ * @brief Start a span
+ * @param span Span to start
+ * @param phase Phase being timed
+ * @param resource_type FHIRResourceType value (0 if not known yet)
+ */
+void fhir_perf_begin(FHIRPerfSpan* span, FHIRPerfPhase phase, int resource_type);
+
+/**
+ * @brief Finish a span, counting it and passing it to the trace callback
+ * @param span Span started by fhir_perf_begin
+ * @param bytes Input bytes processed (0 if not applicable)
+ * @param ok Whether the phase succeeded
+ */
+void fhir_perf_end(FHIRPerfSpan* span, size_t bytes, bool ok);
+
+/**
+ * @brief Get the counters of a resource type
+ * @param resource_type FHIRResourceType value (0 for untyped work)
+ * @param counters Output counters
+ * @return false if resource_type is out of range
+ */
+bool fhir_perf_get_counters(int resource_type, FHIRPerfCounters* counters);
+
+/**
+ * @brief Zero every counter
+ *
+ * Spans finishing concurrently on other threads may survive the reset.
+ */
+void fhir_perf_reset(void);
+
+/**
+ * @brief Get the lowercase name of a phase
+ * @param phase Phase
+ * @return Name, or "unknown" for an invalid phase
+ */
+const char* fhir_perf_phase_name(FHIRPerfPhase phase);
 
 #ifdef __cplusplus
 }
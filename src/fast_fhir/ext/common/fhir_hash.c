@@ -0,0 +1,181 @@
+/**
+ * @file fhir_hash.c
+ * @brief Streaming 64-bit structural hashing (XXH64)
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_hash.h"
+#include <string.h>
+
+#define PRIME64_1 UINT64_C(0x9E3779B185EBCA87)
+#define PRIME64_2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define PRIME64_3 UINT64_C(0x165667B19E3779F9)
+#define PRIME64_4 UINT64_C(0x85EBCA77C2B2AE63)
+#define PRIME64_5 UINT64_C(0x27D4EB2F165667C5)
+
+// Field tags of the framed helpers
+#define HASH_TAG_NULL 0x00
+#define HASH_TAG_STRING 0x01
+
+/* ========================================================================== */
+/* Primitives                                                                 */
+/* ========================================================================== */
+
+static inline uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline uint64_t round64(uint64_t lane, uint64_t input) {
+    lane += input * PRIME64_2;
+    lane = rotl64(lane, 31);
+    return lane * PRIME64_1;
+}
+
+static inline uint64_t merge_round(uint64_t hash, uint64_t lane) {
+    hash ^= round64(0, lane);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+static void consume_stripes(uint64_t lanes[4], const uint8_t* data, size_t stripes) {
+    uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+    for (size_t i = 0; i < stripes; i++, data += 32) {
+        v1 = round64(v1, read64(data));
+        v2 = round64(v2, read64(data + 8));
+        v3 = round64(v3, read64(data + 16));
+        v4 = round64(v4, read64(data + 24));
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+}
+
+static uint64_t finalize(uint64_t hash, const uint8_t* tail, size_t length) {
+    while (length >= 8) {
+        hash ^= round64(0, read64(tail));
+        hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+        tail += 8;
+        length -= 8;
+    }
+    if (length >= 4) {
+        hash ^= (uint64_t)read32(tail) * PRIME64_1;
+        hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+        tail += 4;
+        length -= 4;
+    }
+    while (length > 0) {
+        hash ^= (*tail++) * PRIME64_5;
+        hash = rotl64(hash, 11) * PRIME64_1;
+        length--;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/* ========================================================================== */
+/* Hasher                                                                     */
+/* ========================================================================== */
+
+void fhir_hasher_init(FHIRHasher* hasher, uint64_t seed) {
+    hasher->total_length = 0;
+    hasher->seed = seed;
+    hasher->lanes[0] = seed + PRIME64_1 + PRIME64_2;
+    hasher->lanes[1] = seed + PRIME64_2;
+    hasher->lanes[2] = seed;
+    hasher->lanes[3] = seed - PRIME64_1;
+    hasher->buffered = 0;
+}
+
+void fhir_hasher_update(FHIRHasher* hasher, const void* data, size_t length) {
+    const uint8_t* p = data;
+    hasher->total_length += length;
+
+    // Complete a buffered stripe first
+    if (hasher->buffered > 0) {
+        size_t take = 32 - hasher->buffered;
+        if (take > length) take = length;
+        memcpy(hasher->buffer + hasher->buffered, p, take);
+        hasher->buffered += take;
+        p += take;
+        length -= take;
+        if (hasher->buffered < 32) return;
+        consume_stripes(hasher->lanes, hasher->buffer, 1);
+        hasher->buffered = 0;
+    }
+
+    size_t stripes = length / 32;
+    consume_stripes(hasher->lanes, p, stripes);
+    p += stripes * 32;
+    length -= stripes * 32;
+
+    memcpy(hasher->buffer, p, length);
+    hasher->buffered = length;
+}
+
+void fhir_hasher_string(FHIRHasher* hasher, const char* value) {
+    if (!value) {
+        uint8_t tag = HASH_TAG_NULL;
+        fhir_hasher_update(hasher, &tag, 1);
+        return;
+    }
+    uint8_t tag = HASH_TAG_STRING;
+    size_t length = strlen(value);
+    fhir_hasher_update(hasher, &tag, 1);
+    fhir_hasher_u64(hasher, (uint64_t)length);
+    fhir_hasher_update(hasher, value, length);
+}
+
+void fhir_hasher_u64(FHIRHasher* hasher, uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    fhir_hasher_update(hasher, bytes, sizeof(bytes));
+}
+
+uint64_t fhir_hasher_digest(const FHIRHasher* hasher) {
+    uint64_t hash;
+    if (hasher->total_length >= 32) {
+        const uint64_t* v = hasher->lanes;
+        hash = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+        hash = merge_round(hash, v[0]);
+        hash = merge_round(hash, v[1]);
+        hash = merge_round(hash, v[2]);
+        hash = merge_round(hash, v[3]);
+    } else {
+        hash = hasher->seed + PRIME64_5;
+    }
+    hash += hasher->total_length;
+    return finalize(hash, hasher->buffer, hasher->buffered);
+}
+
+uint64_t fhir_hash64(const void* data, size_t length, uint64_t seed) {
+    FHIRHasher hasher;
+    fhir_hasher_init(&hasher, seed);
+    fhir_hasher_update(&hasher, data, length);
+    return fhir_hasher_digest(&hasher);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file fhir_hash.h
+ * @brief Streaming 64-bit structural hashing (XXH64)
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * FHIRHasher computes XXH64 over data fed in any number of pieces; the
+ * digest equals the one-shot fhir_hash64 of the concatenated input. The
+ * field helpers frame their input (a tag plus a length for strings), so a
+ * resource hashed field by field in a fixed order cannot collide with one
+ * whose values merely split differently ("ab" + "c" versus "a" + "bc").
+ * Integers are hashed as little-endian bytes, so digests are the same on
+ * every platform and can be stored.
+ */
+
+#ifndef FHIR_HASH_H
+#define FHIR_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Hasher                                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Incremental XXH64 state
+ */
+typedef struct {
+    uint64_t total_length;      /**< Bytes fed so far */
+    uint64_t lanes[4];          /**< Accumulators of the 32-byte stripes */
+    uint64_t seed;
+    uint8_t buffer[32];         /**< Partial stripe */
+    size_t buffered;            /**< Bytes held in buffer */
+} FHIRHasher;
+
+/**
+ * @brief Start a hash
+ * @param hasher Hasher to initialize
+ * @param seed Seed; different seeds give independent hashes
+ */
+void fhir_hasher_init(FHIRHasher* hasher, uint64_t seed);
+
+/**
+ * @brief Feed raw bytes
+ * @param hasher Hasher
+ * @param data Bytes to hash
+ * @param length Number of bytes
+ */
+void fhir_hasher_update(FHIRHasher* hasher, const void* data, size_t length);
+
+/**
+ * @brief Feed a framed string; NULL hashes differently from ""
+ * @param hasher Hasher
+ * @param value String or NULL
+ */
+void fhir_hasher_string(FHIRHasher* hasher, const char* value);
+
+/**
+ * @brief Feed an unsigned integer as 8 little-endian bytes
+ * @param hasher Hasher
+ * @param value Value
+ */
+void fhir_hasher_u64(FHIRHasher* hasher, uint64_t value);
+
+/**
+ * @brief Get the hash of everything fed so far (the hasher can keep going)
+ * @param hasher Hasher
+ * @return 64-bit hash
+ */
+uint64_t fhir_hasher_digest(const FHIRHasher* hasher);
+
+/**
+ * @brief Hash a buffer in one call
+ * @param data Bytes to hash
+ * @param length Number of bytes
+ * @param seed Seed
+ * @return XXH64 of the buffer
+ */
+uint64_t fhir_hash64(const void* data, size_t length, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_HASH_H */
@@ -0,0 +1,875 @@
+/**
+ * @file fhir_json_reader.c
+ * @brief Structural-index JSON parser with SIMD stage 1 and cJSON fallback
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FHIR_JSON_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#include <immintrin.h>
+#define FHIR_JSON_AVX2 1
+#define FHIR_JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FHIR_JSON_NEON 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FHIR_JSON_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define FHIR_JSON_ALWAYS_INLINE inline
+#endif
+
+// Index entries reserved before each 64-byte block (a block adds at most 64)
+#define FHIR_JSON_BLOCK_SIZE 64
+
+// Selected backend; FHIR_JSON_BACKEND_AUTO until first resolved
+static FHIRAtomicInt g_backend;
+
+static const char* const g_backend_names[FHIR_JSON_BACKEND_COUNT] = {
+    "auto", "cjson", "scalar", "sse2", "avx2", "neon"
+};
+
+/* ========================================================================== */
+/* Block Classification                                                       */
+/* ========================================================================== */
+
+/**
+ * Per-block bitmasks, bit i describing byte i of a 64-byte block
+ */
+typedef struct {
+    uint64_t quote;         // '"'
+    uint64_t backslash;     // '\\'
+    uint64_t op;            // { } [ ] : ,
+    uint64_t space;         // space, \t, \n, \r
+} FHIRJSONBlockMasks;
+
+typedef void (*FHIRJSONClassifyFunction)(const uint8_t* block, FHIRJSONBlockMasks* masks);
+
+enum {
+    CLASS_QUOTE = 1,
+    CLASS_BACKSLASH = 2,
+    CLASS_OP = 4,
+    CLASS_SPACE = 8
+};
+
+static const uint8_t g_byte_class[256] = {
+    ['"'] = CLASS_QUOTE, ['\\'] = CLASS_BACKSLASH,
+    ['{'] = CLASS_OP, ['}'] = CLASS_OP, ['['] = CLASS_OP, [']'] = CLASS_OP,
+    [':'] = CLASS_OP, [','] = CLASS_OP,
+    [' '] = CLASS_SPACE, ['\t'] = CLASS_SPACE, ['\n'] = CLASS_SPACE, ['\r'] = CLASS_SPACE
+};
+
+static void classify_scalar(const uint8_t* block, FHIRJSONBlockMasks* masks) {
+    uint64_t quote = 0, backslash = 0, op = 0, space = 0;
+    for (int i = 0; i < FHIR_JSON_BLOCK_SIZE; i++) {
+        uint8_t byte_class = g_byte_class[block[i]];
+        uint64_t bit = (uint64_t)1 << i;
+        if (byte_class & CLASS_QUOTE) quote |= bit;
+        if (byte_class & CLASS_BACKSLASH) backslash |= bit;
+        if (byte_class & CLASS_OP) op |= bit;
+        if (byte_class & CLASS_SPACE) space |= bit;
+    }
+    masks->quote = quote;
+    masks->backslash = backslash;
+    masks->op = op;
+    masks->space = space;
+}
+
+#if defined(FHIR_JSON_SSE2)
+// '[' | 0x20 == '{' and ']' | 0x20 == '}', so two compares cover all brackets
+static inline void classify_sse2_lane(__m128i v, int shift, FHIRJSONBlockMasks* masks) {
+    __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i op = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+    __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+    masks->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << shift;
+    masks->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << shift;
+    masks->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << shift;
+    masks->space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << shift;
+}
+
+static inline void classify_sse2(const uint8_t* block, FHIRJSONBlockMasks* masks) {
+    memset(masks, 0, sizeof(FHIRJSONBlockMasks));
+    for (int i = 0; i < FHIR_JSON_BLOCK_SIZE; i += 16) {
+        classify_sse2_lane(_mm_loadu_si128((const __m128i*)(block + i)), i, masks);
+    }
+}
+#endif
+
+#if defined(FHIR_JSON_AVX2)
+FHIR_JSON_TARGET_AVX2
+static inline void classify_avx2_lane(__m256i v, int shift, FHIRJSONBlockMasks* masks) {
+    __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i op = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                        _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+    __m256i space = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+
+    masks->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << shift;
+    masks->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << shift;
+    masks->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << shift;
+    masks->space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << shift;
+}
+
+FHIR_JSON_TARGET_AVX2
+static inline void classify_avx2(const uint8_t* block, FHIRJSONBlockMasks* masks) {
+    memset(masks, 0, sizeof(FHIRJSONBlockMasks));
+    classify_avx2_lane(_mm256_loadu_si256((const __m256i*)block), 0, masks);
+    classify_avx2_lane(_mm256_loadu_si256((const __m256i*)(block + 32)), 32, masks);
+}
+#endif
+
+#if defined(FHIR_JSON_NEON)
+// Compress a 0x00/0xFF lane vector to 16 bits by weighting and pairwise adding
+static inline uint64_t neon_movemask(uint8x16_t v) {
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t masked = vandq_u8(v, vld1q_u8(weights));
+    uint8x8_t sum = vpadd_u8(vget_low_u8(masked), vget_high_u8(masked));
+    sum = vpadd_u8(sum, sum);
+    sum = vpadd_u8(sum, sum);
+    return vget_lane_u16(vreinterpret_u16_u8(sum), 0);
+}
+
+static inline void classify_neon(const uint8_t* block, FHIRJSONBlockMasks* masks) {
+    memset(masks, 0, sizeof(FHIRJSONBlockMasks));
+    for (int i = 0; i < FHIR_JSON_BLOCK_SIZE; i += 16) {
+        uint8x16_t v = vld1q_u8(block + i);
+        uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+        uint8x16_t op = vorrq_u8(
+            vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+        uint8x16_t space = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+
+        masks->quote |= neon_movemask(vceqq_u8(v, vdupq_n_u8('"'))) << i;
+        masks->backslash |= neon_movemask(vceqq_u8(v, vdupq_n_u8('\\'))) << i;
+        masks->op |= neon_movemask(op) << i;
+        masks->space |= neon_movemask(space) << i;
+    }
+}
+#endif
+
+/* ========================================================================== */
+/* Stage 1: Structural Index                                                  */
+/* ========================================================================== */
+
+typedef struct {
+    uint32_t* data;
+    size_t count;
+    size_t capacity;
+    bool growable;          // data may be replaced by a larger fhir_malloc'd array
+    bool owned;             // data was allocated here and must be freed
+} FHIRJSONIndex;
+
+static bool reserve_block(FHIRJSONIndex* index) {
+    if (index->capacity - index->count >= FHIR_JSON_BLOCK_SIZE) return true;
+    if (!index->growable) return false;
+
+    size_t capacity = index->capacity * 2;
+    uint32_t* grown;
+    if (index->owned) {
+        grown = fhir_realloc(index->data, capacity * sizeof(uint32_t));
+    } else {
+        grown = fhir_malloc(capacity * sizeof(uint32_t));
+        if (grown) memcpy(grown, index->data, index->count * sizeof(uint32_t));
+    }
+    if (!grown) return false;
+    index->data = grown;
+    index->capacity = capacity;
+    index->owned = true;
+    return true;
+}
+
+static inline uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Mask of characters escaped by an odd run of backslashes, carrying runs across blocks
+static inline uint64_t find_escaped(uint64_t backslash, uint64_t* prev_escaped) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~*prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | *prev_escaped;
+    uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    *prev_escaped = sequences_starting_on_even_bits < backslash;
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+static inline int trailing_zeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Shared stage-1 loop; each backend instantiates it with its classifier so the
+ * classifier inlines under the backend's target attributes.
+ */
+static FHIR_JSON_ALWAYS_INLINE bool index_blocks(const uint8_t* text, size_t length, FHIRJSONIndex* index,
+                                                 FHIRJSONClassifyFunction classify) {
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_scalar = 0;
+    uint8_t tail[FHIR_JSON_BLOCK_SIZE];
+
+    for (size_t offset = 0; offset < length; offset += FHIR_JSON_BLOCK_SIZE) {
+        const uint8_t* block = text + offset;
+        if (length - offset < FHIR_JSON_BLOCK_SIZE) {
+            // Pad the last block with whitespace, which never produces index entries
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, length - offset);
+            block = tail;
+        }
+        if (!reserve_block(index)) return false;
+
+        FHIRJSONBlockMasks masks;
+        classify(block, &masks);
+
+        // Unescaped quotes toggle string state; in_string covers opening quotes and contents
+        uint64_t quote = masks.quote & ~find_escaped(masks.backslash, &prev_escaped);
+        uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+        // Literals and numbers are indexed at their first byte
+        uint64_t scalar = ~(masks.op | masks.space | masks.quote | in_string);
+        uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        uint64_t bits = (masks.op & ~in_string) | quote | scalar_start;
+        while (bits) {
+            index->data[index->count++] = (uint32_t)(offset + (size_t)trailing_zeros(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    if (prev_in_string) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Unterminated string");
+        return false;
+    }
+    return true;
+}
+
+static bool index_scalar(const uint8_t* text, size_t length, FHIRJSONIndex* index) {
+    return index_blocks(text, length, index, classify_scalar);
+}
+
+#if defined(FHIR_JSON_SSE2)
+static bool index_sse2(const uint8_t* text, size_t length, FHIRJSONIndex* index) {
+    return index_blocks(text, length, index, classify_sse2);
+}
+#endif
+
+#if defined(FHIR_JSON_AVX2)
+FHIR_JSON_TARGET_AVX2
+static bool index_avx2(const uint8_t* text, size_t length, FHIRJSONIndex* index) {
+    return index_blocks(text, length, index, classify_avx2);
+}
+#endif
+
+#if defined(FHIR_JSON_NEON)
+static bool index_neon(const uint8_t* text, size_t length, FHIRJSONIndex* index) {
+    return index_blocks(text, length, index, classify_neon);
+}
+#endif
+
+static bool build_index(FHIRJSONBackend backend, const char* text, size_t length, FHIRJSONIndex* index) {
+    const uint8_t* bytes = (const uint8_t*)text;
+    switch (backend) {
+#if defined(FHIR_JSON_SSE2)
+        case FHIR_JSON_BACKEND_SSE2:
+            return index_sse2(bytes, length, index);
+#endif
+#if defined(FHIR_JSON_AVX2)
+        case FHIR_JSON_BACKEND_AVX2:
+            return index_avx2(bytes, length, index);
+#endif
+#if defined(FHIR_JSON_NEON)
+        case FHIR_JSON_BACKEND_NEON:
+            return index_neon(bytes, length, index);
+#endif
+        default:
+            return index_scalar(bytes, length, index);
+    }
+}
+
+/* ========================================================================== */
+/* Stage 2: Tree Construction                                                 */
+/* ========================================================================== */
+
+typedef struct {
+    const char* text;
+    size_t length;
+    const uint32_t* index;
+    size_t count;
+    size_t position;        // next index entry to consume
+} FHIRJSONCursor;
+
+static inline char next_char(FHIRJSONCursor* cursor, uint32_t* offset) {
+    if (cursor->position >= cursor->count) return '\0';
+    *offset = cursor->index[cursor->position++];
+    return cursor->text[*offset];
+}
+
+static inline char peek_char(const FHIRJSONCursor* cursor) {
+    return cursor->position < cursor->count ? cursor->text[cursor->index[cursor->position]] : '\0';
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const char* p, const char* end, uint32_t* value) {
+    if (end - p < 4) return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) return false;
+        *value = (*value << 4) | (uint32_t)digit;
+    }
+    return true;
+}
+
+static char* encode_utf8(char* out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        *out++ = (char)code_point;
+    } else if (code_point < 0x800) {
+        *out++ = (char)(0xC0 | (code_point >> 6));
+        *out++ = (char)(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        *out++ = (char)(0xE0 | (code_point >> 12));
+        *out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code_point & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (code_point >> 18));
+        *out++ = (char)(0x80 | ((code_point >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code_point & 0x3F));
+    }
+    return out;
+}
+
+// Unescape string contents into a cJSON-owned buffer; escapes only ever shrink
+static char* decode_string(const char* start, const char* end) {
+    size_t length = (size_t)(end - start);
+    char* decoded = cJSON_malloc(length + 1);
+    if (!decoded) return NULL;
+
+    const char* backslash = memchr(start, '\\', length);
+    if (!backslash) {
+        memcpy(decoded, start, length);
+        decoded[length] = '\0';
+        return decoded;
+    }
+
+    size_t prefix = (size_t)(backslash - start);
+    memcpy(decoded, start, prefix);
+    char* out = decoded + prefix;
+    const char* p = backslash;
+    while (p < end) {
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+        if (++p >= end) goto invalid;
+        switch (*p++) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t code_point;
+                if (!read_hex4(p, end, &code_point)) goto invalid;
+                p += 4;
+                if (code_point >= 0xDC00 && code_point <= 0xDFFF) goto invalid;
+                if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !read_hex4(p + 2, end, &low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        goto invalid;
+                    }
+                    p += 6;
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                out = encode_utf8(out, code_point);
+                break;
+            }
+            default:
+                goto invalid;
+        }
+    }
+    *out = '\0';
+    return decoded;
+
+invalid:
+    cJSON_free(decoded);
+    return NULL;
+}
+
+// Decode the string opened at offset; its closing quote is the next index entry
+static char* parse_string_text(FHIRJSONCursor* cursor, uint32_t offset) {
+    uint32_t close;
+    if (next_char(cursor, &close) != '"') return NULL;
+    return decode_string(cursor->text + offset + 1, cursor->text + close);
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Check JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool valid_number(const char* p, const char* end, bool* integral) {
+    *integral = true;
+    if (p < end && *p == '-') p++;
+    if (p >= end || !is_digit(*p)) return false;
+    if (*p == '0') {
+        p++;
+    } else {
+        while (p < end && is_digit(*p)) p++;
+    }
+    if (p < end && *p == '.') {
+        *integral = false;
+        if (++p >= end || !is_digit(*p)) return false;
+        while (p < end && is_digit(*p)) p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        *integral = false;
+        if (++p < end && (*p == '+' || *p == '-')) p++;
+        if (p >= end || !is_digit(*p)) return false;
+        while (p < end && is_digit(*p)) p++;
+    }
+    return p == end;
+}
+
+static cJSON* parse_number(const char* start, const char* end) {
+    bool integral;
+    if (!valid_number(start, end, &integral)) return NULL;
+
+    // Up to 15 digits are exact in a double without going through strtod
+    size_t length = (size_t)(end - start);
+    bool negative = *start == '-';
+    if (integral && length - negative <= 15) {
+        int64_t value = 0;
+        for (const char* p = start + negative; p < end; p++) {
+            value = value * 10 + (*p - '0');
+        }
+        return cJSON_CreateNumber((double)(negative ? -value : value));
+    }
+
+    char buffer[64];
+    char* text = length < sizeof(buffer) ? buffer : fhir_malloc(length + 1);
+    if (!text) return NULL;
+    memcpy(text, start, length);
+    text[length] = '\0';
+    double value = strtod(text, NULL);
+    if (text != buffer) fhir_free(text);
+    return cJSON_CreateNumber(value);
+}
+
+// Literal or number starting at offset; it ends at whitespace or the next index entry
+static cJSON* parse_scalar(const FHIRJSONCursor* cursor, uint32_t offset) {
+    const char* start = cursor->text + offset;
+    const char* limit = cursor->text + (cursor->position < cursor->count
+                                            ? cursor->index[cursor->position] : cursor->length);
+    const char* end = start;
+    while (end < limit && !(g_byte_class[(uint8_t)*end] & CLASS_SPACE)) end++;
+
+    size_t length = (size_t)(end - start);
+    if (length == 4 && memcmp(start, "true", 4) == 0) return cJSON_CreateTrue();
+    if (length == 5 && memcmp(start, "false", 5) == 0) return cJSON_CreateFalse();
+    if (length == 4 && memcmp(start, "null", 4) == 0) return cJSON_CreateNull();
+    return parse_number(start, end);
+}
+
+static cJSON* parse_value(FHIRJSONCursor* cursor, int depth);
+
+static cJSON* parse_string_value(FHIRJSONCursor* cursor, uint32_t offset) {
+    char* text = parse_string_text(cursor, offset);
+    if (!text) return NULL;
+    cJSON* item = cJSON_CreateNull();
+    if (!item) {
+        cJSON_free(text);
+        return NULL;
+    }
+    item->type = cJSON_String;
+    item->valuestring = text;
+    return item;
+}
+
+static cJSON* parse_object(FHIRJSONCursor* cursor, int depth) {
+    cJSON* object = cJSON_CreateObject();
+    if (!object) return NULL;
+    uint32_t offset;
+    if (peek_char(cursor) == '}') {
+        cursor->position++;
+        return object;
+    }
+
+    for (;;) {
+        if (next_char(cursor, &offset) != '"') goto fail;
+        char* key = parse_string_text(cursor, offset);
+        if (!key) goto fail;
+        if (next_char(cursor, &offset) != ':') {
+            cJSON_free(key);
+            goto fail;
+        }
+        cJSON* value = parse_value(cursor, depth);
+        if (!value) {
+            cJSON_free(key);
+            goto fail;
+        }
+        value->string = key;
+        cJSON_AddItemToArray(object, value);
+
+        char separator = next_char(cursor, &offset);
+        if (separator == '}') return object;
+        if (separator != ',') goto fail;
+    }
+
+fail:
+    cJSON_Delete(object);
+    return NULL;
+}
+
+static cJSON* parse_array(FHIRJSONCursor* cursor, int depth) {
+    cJSON* array = cJSON_CreateArray();
+    if (!array) return NULL;
+    uint32_t offset;
+    if (peek_char(cursor) == ']') {
+        cursor->position++;
+        return array;
+    }
+
+    for (;;) {
+        cJSON* value = parse_value(cursor, depth);
+        if (!value) goto fail;
+        cJSON_AddItemToArray(array, value);
+
+        char separator = next_char(cursor, &offset);
+        if (separator == ']') return array;
+        if (separator != ',') goto fail;
+    }
+
+fail:
+    cJSON_Delete(array);
+    return NULL;
+}
+
+static cJSON* parse_value(FHIRJSONCursor* cursor, int depth) {
+    uint32_t offset;
+    switch (next_char(cursor, &offset)) {
+        case '{':
+            return depth < FHIR_JSON_NESTING_LIMIT ? parse_object(cursor, depth + 1) : NULL;
+        case '[':
+            return depth < FHIR_JSON_NESTING_LIMIT ? parse_array(cursor, depth + 1) : NULL;
+        case '"':
+            return parse_string_value(cursor, offset);
+        case '}': case ']': case ':': case ',': case '\0':
+            return NULL;
+        default:
+            return parse_scalar(cursor, offset);
+    }
+}
+
+static cJSON* parse_structural(FHIRJSONBackend backend, const char* text, size_t length) {
+    if (length > UINT32_MAX) {
+        return cJSON_ParseWithLength(text, length);
+    }
+
+    uint32_t stack_index[FHIR_JSON_STACK_INDEX_SIZE];
+    FHIRJSONIndex index = {stack_index, 0, FHIR_JSON_STACK_INDEX_SIZE, true, false};
+    cJSON* json = NULL;
+    if (build_index(backend, text, length, &index)) {
+        FHIRJSONCursor cursor = {text, length, index.data, index.count, 0};
+        json = parse_value(&cursor, 0);
+        if (json && cursor.position != cursor.count) {
+            cJSON_Delete(json);
+            json = NULL;
+        }
+    }
+    if (index.owned) {
+        fhir_free(index.data);
+    }
+    return json;
+}
+
+/* ========================================================================== */
+/* Backend Selection                                                          */
+/* ========================================================================== */
+
+bool fhir_json_backend_supported(FHIRJSONBackend backend) {
+    switch (backend) {
+        case FHIR_JSON_BACKEND_AUTO:
+        case FHIR_JSON_BACKEND_CJSON:
+        case FHIR_JSON_BACKEND_SCALAR:
+            return true;
+#if defined(FHIR_JSON_SSE2)
+        case FHIR_JSON_BACKEND_SSE2:
+            return true;
+#endif
+#if defined(FHIR_JSON_AVX2)
+        case FHIR_JSON_BACKEND_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(FHIR_JSON_NEON)
+        case FHIR_JSON_BACKEND_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+static FHIRJSONBackend best_backend(void) {
+    static const FHIRJSONBackend preference[] = {
+        FHIR_JSON_BACKEND_AVX2, FHIR_JSON_BACKEND_NEON, FHIR_JSON_BACKEND_SSE2
+    };
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (fhir_json_backend_supported(preference[i])) return preference[i];
+    }
+    return FHIR_JSON_BACKEND_SCALAR;
+}
+
+const char* fhir_json_backend_name(FHIRJSONBackend backend) {
+    if ((int)backend < 0 || backend >= FHIR_JSON_BACKEND_COUNT) return "unknown";
+    return g_backend_names[backend];
+}
+
+bool fhir_json_backend_from_name(const char* name, FHIRJSONBackend* backend) {
+    if (!name) return false;
+    for (int i = 0; i < FHIR_JSON_BACKEND_COUNT; i++) {
+        if (strcmp(name, g_backend_names[i]) == 0) {
+            *backend = (FHIRJSONBackend)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool fhir_json_set_backend(FHIRJSONBackend backend) {
+    if (!fhir_json_backend_supported(backend)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "JSON backend not supported on this CPU");
+        return false;
+    }
+    fhir_atomic_store(&g_backend, (int)(backend == FHIR_JSON_BACKEND_AUTO ? best_backend() : backend));
+    return true;
+}
+
+FHIRJSONBackend fhir_json_get_backend(void) {
+    int backend = fhir_atomic_load(&g_backend);
+    if (backend == FHIR_JSON_BACKEND_AUTO) {
+        // First use: honour FHIR_JSON_BACKEND if it names a supported backend; racing callers agree
+        FHIRJSONBackend requested;
+        if (!fhir_json_backend_from_name(getenv("FHIR_JSON_BACKEND"), &requested) ||
+            !fhir_json_backend_supported(requested) || requested == FHIR_JSON_BACKEND_AUTO) {
+            requested = best_backend();
+        }
+        backend = (int)requested;
+        fhir_atomic_store(&g_backend, backend);
+    }
+    return (FHIRJSONBackend)backend;
+}
+
+/* ========================================================================== */
+/* Parsing                                                                    */
+/* ========================================================================== */
+
+cJSON* fhir_json_parse_with_backend(FHIRJSONBackend backend, const char* text, size_t length) {
+    if (!text) return NULL;
+    if (backend == FHIR_JSON_BACKEND_AUTO) {
+        backend = best_backend();
+    }
+
+    FHIRPerfSpan span;
+    fhir_perf_begin(&span, FHIR_PERF_PHASE_TOKENIZE, 0);
+    cJSON* json;
+    if (backend == FHIR_JSON_BACKEND_CJSON || !fhir_json_backend_supported(backend)) {
+        json = cJSON_ParseWithLength(text, length);
+    } else {
+        json = parse_structural(backend, text, length);
+    }
+    fhir_perf_end(&span, length, json != NULL);
+    return json;
+}
+
+cJSON* fhir_json_parse(const char* text, size_t length) {
+    return fhir_json_parse_with_backend(fhir_json_get_backend(), text, length);
+}
+
+bool fhir_json_structural_index(FHIRJSONBackend backend, const char* text, size_t length,
+                                uint32_t* index, size_t capacity, size_t* count) {
+    if (backend == FHIR_JSON_BACKEND_AUTO) {
+        backend = best_backend();
+    }
+    if (!text || !index || !count || length > UINT32_MAX || backend == FHIR_JSON_BACKEND_CJSON ||
+        !fhir_json_backend_supported(backend)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (capacity < length + FHIR_JSON_BLOCK_SIZE) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Index capacity too small");
+        return false;
+    }
+
+    FHIRJSONIndex built = {index, 0, capacity, false, false};
+    bool ok = build_index(backend, text, length, &built);
+    *count = built.count;
+    return ok;
+}
+
+/* ========================================================================== */
+/* Member Spans                                                               */
+/* ========================================================================== */
+
+// End (exclusive) of the literal or number starting at offset
+static size_t scalar_end(const FHIRJSONCursor* cursor, uint32_t offset) {
+    size_t limit = cursor->position < cursor->count ? cursor->index[cursor->position] : cursor->length;
+    size_t end = offset;
+    while (end < limit && !(g_byte_class[(uint8_t)cursor->text[end]] & CLASS_SPACE)) end++;
+    return end;
+}
+
+// Consume one value from the index, reporting the offset one past its last byte
+static bool skip_value(FHIRJSONCursor* cursor, int depth, size_t* end) {
+    uint32_t offset;
+    char open = next_char(cursor, &offset);
+    switch (open) {
+        case '{':
+        case '[': {
+            if (depth >= FHIR_JSON_NESTING_LIMIT) return false;
+            char close = open == '{' ? '}' : ']';
+            if (peek_char(cursor) == close) {
+                next_char(cursor, &offset);
+                *end = offset + 1u;
+                return true;
+            }
+            for (;;) {
+                size_t value_end;
+                if (open == '{' && (next_char(cursor, &offset) != '"' || next_char(cursor, &offset) != '"' ||
+                                    next_char(cursor, &offset) != ':')) {
+                    return false;
+                }
+                if (!skip_value(cursor, depth + 1, &value_end)) return false;
+                char separator = next_char(cursor, &offset);
+                if (separator == close) {
+                    *end = offset + 1u;
+                    return true;
+                }
+                if (separator != ',') return false;
+            }
+        }
+        case '"':
+            if (next_char(cursor, &offset) != '"') return false;
+            *end = offset + 1u;
+            return true;
+        case '}': case ']': case ':': case ',': case '\0':
+            return false;
+        default:
+            *end = scalar_end(cursor, offset);
+            return true;
+    }
+}
+
+static bool walk_members(FHIRJSONCursor* cursor, FHIRJSONMemberFunction callback, void* context,
+                         bool* stopped) {
+    uint32_t offset;
+    if (next_char(cursor, &offset) != '{') return false;
+    if (peek_char(cursor) == '}') {
+        cursor->position++;
+        return cursor->position == cursor->count;
+    }
+
+    for (;;) {
+        FHIRJSONMemberSpan member;
+        uint32_t close, colon;
+        if (next_char(cursor, &offset) != '"' || next_char(cursor, &close) != '"' ||
+            next_char(cursor, &colon) != ':' || cursor->position >= cursor->count) {
+            return false;
+        }
+        member.key_offset = offset + 1u;
+        member.key_length = (size_t)(close - offset - 1u);
+        member.value_offset = cursor->index[cursor->position];
+
+        size_t end;
+        if (!skip_value(cursor, 1, &end)) return false;
+        member.value_length = end - member.value_offset;
+        if (!callback(&member, context)) {
+            *stopped = true;
+            return false;
+        }
+
+        char separator = next_char(cursor, &offset);
+        if (separator == '}') return cursor->position == cursor->count;
+        if (separator != ',') return false;
+    }
+}
+
+bool fhir_json_object_members(const char* text, size_t length,
+                              FHIRJSONMemberFunction callback, void* context) {
+    if (!text || !callback || length > UINT32_MAX) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    FHIRJSONBackend backend = fhir_json_get_backend();
+    if (backend == FHIR_JSON_BACKEND_CJSON) {
+        backend = best_backend();
+    }
+
+    uint32_t stack_index[FHIR_JSON_STACK_INDEX_SIZE];
+    FHIRJSONIndex index = {stack_index, 0, FHIR_JSON_STACK_INDEX_SIZE, true, false};
+    bool ok = build_index(backend, text, length, &index);
+    if (ok) {
+        FHIRJSONCursor cursor = {text, length, index.data, index.count, 0};
+        bool stopped = false;
+        ok = walk_members(&cursor, callback, context, &stopped);
+        if (!ok && !stopped) {
+            FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Invalid JSON object");
+        }
+    }
+    if (index.owned) {
+        fhir_free(index.data);
+    }
+    return ok;
+}
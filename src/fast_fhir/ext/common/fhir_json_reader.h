@@ -0,0 +1,177 @@
+/**
+ * @file fhir_json_reader.h
+ * @brief Pluggable JSON parser backends producing cJSON trees
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Every parse in the extension goes through fhir_json_parse, which hands the
+ * text to the selected backend. The structural backends run in two stages:
+ * stage 1 classifies 64-byte blocks with SIMD compares (AVX2, SSE2 or NEON,
+ * chosen at runtime) and emits the offsets of structural characters, quotes
+ * and scalar starts outside strings; stage 2 walks that index and builds the
+ * same cJSON tree cJSON_ParseWithLength would, so callers and cJSON_Delete
+ * are unchanged. cJSON itself stays available as the fallback backend.
+ *
+ * The backend is process-wide (per extension module). It starts as
+ * FHIR_JSON_BACKEND_AUTO, which picks the best backend the CPU supports, and
+ * can be overridden with the FHIR_JSON_BACKEND environment variable ("cjson",
+ * "scalar", "sse2", "avx2", "neon") or fhir_json_set_backend.
+ */
+
+#ifndef FHIR_JSON_READER_H
+#define FHIR_JSON_READER_H
+
+#include "fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Backends                                                                   */
+/* ========================================================================== */
+
+/** Maximum object/array nesting accepted by the structural backends (as cJSON) */
+#define FHIR_JSON_NESTING_LIMIT 1000
+
+/** Documents with at most this many index entries are indexed on the stack */
+#define FHIR_JSON_STACK_INDEX_SIZE 512
+
+/**
+ * @brief Parser backend
+ */
+typedef enum {
+    FHIR_JSON_BACKEND_AUTO = 0,     /**< Best supported structural backend */
+    FHIR_JSON_BACKEND_CJSON,        /**< cJSON_ParseWithLength */
+    FHIR_JSON_BACKEND_SCALAR,       /**< Structural index built with 64-bit scalar code */
+    FHIR_JSON_BACKEND_SSE2,         /**< Structural index built with SSE2 (x86-64) */
+    FHIR_JSON_BACKEND_AVX2,         /**< Structural index built with AVX2 (x86-64, runtime detected) */
+    FHIR_JSON_BACKEND_NEON,         /**< Structural index built with NEON (AArch64) */
+    FHIR_JSON_BACKEND_COUNT
+} FHIRJSONBackend;
+
+/**
+ * @brief Check whether a backend can run on this CPU and build
+ * @param backend Backend to check; FHIR_JSON_BACKEND_AUTO is always supported
+ * @return true if supported
+ */
+bool fhir_json_backend_supported(FHIRJSONBackend backend);
+
+/**
+ * @brief Select the parser backend
+ * @param backend Backend to use; FHIR_JSON_BACKEND_AUTO picks the best supported one
+ * @return true on success, false with FHIR_ERROR_INVALID_ARGUMENT if unsupported
+ */
+bool fhir_json_set_backend(FHIRJSONBackend backend);
+
+/**
+ * @brief Get the backend fhir_json_parse currently uses (never AUTO)
+ * @return Resolved backend
+ */
+FHIRJSONBackend fhir_json_get_backend(void);
+
+/**
+ * @brief Get the name of a backend ("auto", "cjson", "scalar", "sse2", "avx2", "neon")
+ * @param backend Backend
+ * @return Static name, or "unknown"
+ */
+const char* fhir_json_backend_name(FHIRJSONBackend backend);
+
+/**
+ * @brief Look up a backend by name
+ * @param name Backend name as returned by fhir_json_backend_name
+ * @param backend Output backend
+ * @return true if the name is known
+ */
+bool fhir_json_backend_from_name(const char* name, FHIRJSONBackend* backend);
+
+/* ========================================================================== */
+/* Parsing                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Parse JSON text of a given length with the selected backend
+ *
+ * The text need not be NUL-terminated. Trailing whitespace is allowed after
+ * the value; anything else fails, as does nesting deeper than
+ * FHIR_JSON_NESTING_LIMIT.
+ *
+ * @param text JSON text
+ * @param length Length of text in bytes
+ * @return Parsed tree (free with cJSON_Delete), or NULL on invalid JSON or allocation failure
+ */
+cJSON* fhir_json_parse(const char* text, size_t length);
+
+/**
+ * @brief Parse JSON text with a specific backend, ignoring the selection
+ * @param backend Backend to use; unsupported backends fall back to cJSON
+ * @param text JSON text
+ * @param length Length of text in bytes
+ * @return Parsed tree (free with cJSON_Delete), or NULL on failure
+ */
+cJSON* fhir_json_parse_with_backend(FHIRJSONBackend backend, const char* text, size_t length);
+
+/**
+ * @brief Run stage 1 only: collect structural offsets of a document
+ *
+ * Offsets are those of structural characters ({}[]:,) and quotes outside
+ * strings plus the first byte of every literal or number, in order. Exposed
+ * for tests and benchmarks.
+ *
+ * @param backend Structural backend (SCALAR, SSE2, AVX2 or NEON; AUTO picks the best)
+ * @param text JSON text
+ * @param length Length of text in bytes (at most UINT32_MAX)
+ * @param index Output offsets
+ * @param capacity Entries available in index; at least length + 64
+ * @param count Output number of offsets
+ * @return true on success, false if a string is left open or the arguments are invalid
+ */
+bool fhir_json_structural_index(FHIRJSONBackend backend, const char* text, size_t length,
+                                uint32_t* index, size_t capacity, size_t* count);
+
+/* ========================================================================== */
+/* Member Spans                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Location of one top-level object member in the source text
+ */
+typedef struct {
+    size_t key_offset;      /**< First byte of the key, after its opening quote */
+    size_t key_length;      /**< Raw key length in bytes (escapes not decoded) */
+    size_t value_offset;    /**< First byte of the value */
+    size_t value_length;    /**< Raw value length, including quotes or brackets */
+} FHIRJSONMemberSpan;
+
+/**
+ * @brief Called for each member; return false to stop with failure
+ */
+typedef bool (*FHIRJSONMemberFunction)(const FHIRJSONMemberSpan* member, void* context);
+
+/**
+ * @brief Walk the top-level members of a JSON object without building a tree
+ *
+ * Runs stage 1 with the selected structural backend and reports where each
+ * member's key and value lie, so a caller can parse only the members it
+ * needs (fhir_json_parse on the value span) and leave large values such as
+ * base64 payloads in place. The object structure is checked; scalar values
+ * and string contents are not validated until parsed.
+ *
+ * @param text JSON text
+ * @param length Length of text in bytes (at most UINT32_MAX)
+ * @param callback Function called per member in document order
+ * @param context Passed to callback
+ * @return true if text is a well-formed object and every callback returned true
+ */
+bool fhir_json_object_members(const char* text, size_t length,
+                              FHIRJSONMemberFunction callback, void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_JSON_READER_H */
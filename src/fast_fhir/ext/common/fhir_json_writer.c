@@ -0,0 +1,702 @@
+/**
+ * @file fhir_json_writer.c
+ * @brief Streaming compact JSON writer implementation
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_json_writer.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ========================================================================== */
+/* Output Buffer                                                              */
+/* ========================================================================== */
+
+static bool writer_fail(FHIRWriter* writer, FHIRErrorCode code, const char* message) {
+    if (!writer->failed) {
+        writer->failed = true;
+        FHIR_SET_ERROR(code, message);
+    }
+    return false;
+}
+
+// Whether output goes to a descriptor or sink rather than staying in data
+static inline bool writer_streams(const FHIRWriter* writer) {
+    return writer->fd >= 0 || writer->sink;
+}
+
+// Whether new output must be kept in data: always in buffer mode, and while a
+// canonical value is open, since its members may still be reordered
+static inline bool writer_holds(const FHIRWriter* writer) {
+    return !writer_streams(writer) || (writer->canonical && writer->depth > 0);
+}
+
+static bool writer_drain(FHIRWriter* writer) {
+    if (writer->sink) {
+        bool passed = writer->length == 0 || writer->sink(writer->sink_context, writer->data, writer->length);
+        writer->length = 0;
+        return passed || writer_fail(writer, FHIR_ERROR_IO, "JSON output sink failed");
+    }
+
+    size_t offset = 0;
+    while (offset < writer->length) {
+        ssize_t written = write(writer->fd, writer->data + offset, writer->length - offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            writer->length = 0;
+            return writer_fail(writer, FHIR_ERROR_IO, "Failed to write JSON output");
+        }
+        offset += (size_t)written;
+    }
+    writer->length = 0;
+    return true;
+}
+
+// Make room for size more bytes plus the buffer-mode NUL terminator
+static bool writer_reserve(FHIRWriter* writer, size_t size) {
+    if (writer->length + size < writer->capacity) {
+        return true;
+    }
+
+    size_t capacity = writer->capacity ? writer->capacity : FHIR_WRITER_DEFAULT_CAPACITY;
+    while (writer->length + size >= capacity) {
+        capacity *= 2;
+    }
+
+    char* data = fhir_realloc(writer->data, capacity);
+    if (!data) {
+        return writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow JSON output buffer");
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+    return true;
+}
+
+static bool writer_append(FHIRWriter* writer, const char* bytes, size_t size) {
+    if (writer_holds(writer)) {
+        if (!writer_reserve(writer, size)) {
+            return false;
+        }
+        memcpy(writer->data + writer->length, bytes, size);
+        writer->length += size;
+        return true;
+    }
+
+    // Descriptor or sink mode: fill the staging buffer, draining it whenever it is full
+    while (size > 0) {
+        size_t space = writer->capacity - writer->length;
+        if (space == 0) {
+            if (!writer_drain(writer)) {
+                return false;
+            }
+            space = writer->capacity;
+        }
+        size_t chunk = size < space ? size : space;
+        memcpy(writer->data + writer->length, bytes, chunk);
+        writer->length += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+static bool writer_append_char(FHIRWriter* writer, char c) {
+    if (writer_holds(writer) && writer->length + 1 < writer->capacity) {
+        writer->data[writer->length++] = c;
+        return true;
+    }
+    return writer_append(writer, &c, 1);
+}
+
+// Emit the separator a new value needs at the current position
+static bool writer_begin_value(FHIRWriter* writer) {
+    if (writer->failed) {
+        return false;
+    }
+    if (writer->after_key) {
+        writer->after_key = false;
+        return true;
+    }
+    if (writer->has_items[writer->depth]) {
+        if (writer->depth == 0) {
+            return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "JSON value already written");
+        }
+        if (!writer_append_char(writer, ',')) {
+            return false;
+        }
+    }
+    writer->has_items[writer->depth] = true;
+    return true;
+}
+
+/* ========================================================================== */
+/* Writer Lifecycle                                                           */
+/* ========================================================================== */
+
+static void writer_init(FHIRWriter* writer, int fd) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = fd;
+}
+
+static void writer_free_canonical(FHIRWriter* writer) {
+    fhir_free(writer->members);
+    fhir_free(writer->scratch);
+    writer->members = NULL;
+    writer->scratch = NULL;
+    writer->member_count = writer->member_capacity = writer->scratch_capacity = 0;
+}
+
+bool fhir_writer_init_buffer(FHIRWriter* writer, size_t initial_capacity) {
+    if (!writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Writer is NULL");
+        return false;
+    }
+
+    writer_init(writer, -1);
+    writer->data = fhir_malloc(initial_capacity ? initial_capacity : FHIR_WRITER_DEFAULT_CAPACITY);
+    if (!writer->data) {
+        writer->failed = true;
+        return false;
+    }
+    writer->capacity = initial_capacity ? initial_capacity : FHIR_WRITER_DEFAULT_CAPACITY;
+    return true;
+}
+
+bool fhir_writer_init_fd(FHIRWriter* writer, int fd) {
+    if (!writer || fd < 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid writer or file descriptor");
+        return false;
+    }
+
+    writer_init(writer, fd);
+    writer->data = fhir_malloc(FHIR_WRITER_FD_BUFFER_SIZE);
+    if (!writer->data) {
+        writer->failed = true;
+        return false;
+    }
+    writer->capacity = FHIR_WRITER_FD_BUFFER_SIZE;
+    return true;
+}
+
+bool fhir_writer_init_sink(FHIRWriter* writer, FHIRWriterSink sink, void* context) {
+    if (!writer || !sink) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid writer or sink");
+        return false;
+    }
+
+    writer_init(writer, -1);
+    writer->sink = sink;
+    writer->sink_context = context;
+    writer->data = fhir_malloc(FHIR_WRITER_FD_BUFFER_SIZE);
+    if (!writer->data) {
+        writer->failed = true;
+        return false;
+    }
+    writer->capacity = FHIR_WRITER_FD_BUFFER_SIZE;
+    return true;
+}
+
+bool fhir_writer_set_canonical(FHIRWriter* writer, bool canonical) {
+    if (!writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Writer is NULL");
+        return false;
+    }
+    if (writer->depth != 0 || writer->after_key || writer->has_items[0]) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Canonical mode changed after output");
+    }
+    writer->canonical = canonical;
+    return true;
+}
+
+void fhir_writer_reset(FHIRWriter* writer) {
+    if (!writer) return;
+
+    writer->length = 0;
+    writer->member_count = 0;
+    writer->failed = false;
+    writer->after_key = false;
+    writer->depth = 0;
+    memset(writer->has_items, 0, sizeof(writer->has_items));
+}
+
+bool fhir_writer_flush(FHIRWriter* writer) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    return !writer_streams(writer) || writer_drain(writer);
+}
+
+bool fhir_writer_finish(FHIRWriter* writer) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (writer->depth != 0 || writer->after_key) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Incomplete JSON value");
+    }
+    if (!writer_streams(writer)) {
+        writer->data[writer->length] = '\0';
+        return true;
+    }
+    return writer_drain(writer);
+}
+
+bool fhir_writer_end_line(FHIRWriter* writer) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (writer->depth != 0 || writer->after_key) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Incomplete JSON value");
+    }
+    writer->has_items[0] = false;
+    return writer_append_char(writer, '\n');
+}
+
+char* fhir_writer_take_buffer(FHIRWriter* writer, size_t* length) {
+    if (!writer || writer_streams(writer) || !fhir_writer_finish(writer)) {
+        return NULL;
+    }
+
+    char* data = writer->data;
+    if (length) {
+        *length = writer->length;
+    }
+    writer_free_canonical(writer);
+    writer_init(writer, -1);
+    return data;
+}
+
+void fhir_writer_cleanup(FHIRWriter* writer) {
+    if (!writer) return;
+
+    fhir_free(writer->data);
+    writer_free_canonical(writer);
+    writer_init(writer, writer->fd);
+}
+
+/* ========================================================================== */
+/* Canonical Form                                                             */
+/* ========================================================================== */
+
+// Decode the next character of an escaped member name; the writer only emits
+// the short escapes and \u00XX, so every escape stands for a single byte
+static unsigned int next_name_char(const char** cursor) {
+    const char* p = *cursor;
+    unsigned int c = (unsigned char)*p++;
+    if (c == '\\') {
+        c = (unsigned char)*p++;
+        switch (c) {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u': sscanf(p, "%4x", &c); p += 4; break;
+            default: break;
+        }
+    }
+    *cursor = p;
+    return c;
+}
+
+// Order of two written members by name; UTF-8 byte order is code point order
+static int compare_member_names(const char* a, const char* b) {
+    a++;
+    b++;
+    for (;;) {
+        bool a_end = *a == '"';
+        bool b_end = *b == '"';
+        if (a_end || b_end) {
+            return (int)b_end - (int)a_end;
+        }
+        unsigned int ca = next_name_char(&a);
+        unsigned int cb = next_name_char(&b);
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
+    }
+}
+
+static int compare_members(const void* a, const void* b) {
+    return compare_member_names(((const FHIRWriterMember*)a)->name, ((const FHIRWriterMember*)b)->name);
+}
+
+static bool record_member(FHIRWriter* writer) {
+    if (writer->member_count == writer->member_capacity) {
+        size_t capacity = writer->member_capacity ? writer->member_capacity * 2 : 32;
+        FHIRWriterMember* members = fhir_realloc(writer->members, capacity * sizeof(FHIRWriterMember));
+        if (!members) {
+            return writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow canonical member list");
+        }
+        writer->members = members;
+        writer->member_capacity = capacity;
+    }
+    writer->members[writer->member_count++].start = writer->length;
+    return true;
+}
+
+// Reorder the members of the innermost object by name, in place in data
+static bool sort_members(FHIRWriter* writer) {
+    size_t first = writer->member_base[writer->depth];
+    FHIRWriterMember* members = writer->members + first;
+    size_t count = writer->member_count - first;
+    writer->member_count = first;
+    if (count < 2) {
+        return true;
+    }
+
+    // Each member runs up to the comma before the next one
+    for (size_t i = 0; i < count; i++) {
+        members[i].end = i + 1 < count ? members[i + 1].start - 1 : writer->length;
+        members[i].name = writer->data + members[i].start;
+    }
+
+    bool sorted = true;
+    for (size_t i = 0; i + 1 < count && sorted; i++) {
+        sorted = compare_member_names(members[i].name, members[i + 1].name) <= 0;
+    }
+    if (sorted) {
+        return true;
+    }
+
+    size_t span = writer->length - members[0].start;
+    if (span > writer->scratch_capacity) {
+        char* scratch = fhir_realloc(writer->scratch, span);
+        if (!scratch) {
+            return writer_fail(writer, FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate canonical sort space");
+        }
+        writer->scratch = scratch;
+        writer->scratch_capacity = span;
+    }
+
+    qsort(members, count, sizeof(FHIRWriterMember), compare_members);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            writer->scratch[offset++] = ',';
+        }
+        size_t size = members[i].end - members[i].start;
+        memcpy(writer->scratch + offset, writer->data + members[i].start, size);
+        offset += size;
+    }
+    memcpy(writer->data + writer->length - span, writer->scratch, span);
+    return true;
+}
+
+// Shortest round-trip digits laid out as ECMAScript Number::toString does
+static size_t format_canonical_double(double value, char* out) {
+    if (value == 0) {
+        out[0] = '0';   // Also -0
+        return 1;
+    }
+
+    char printed[32];
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(printed, sizeof(printed), "%.*e", precision - 1, value);
+        if (strtod(printed, NULL) == value) break;
+    }
+
+    // printed is [-]d[.ddd]e(+|-)xx
+    const char* p = printed;
+    size_t length = 0;
+    if (*p == '-') {
+        out[length++] = *p++;
+    }
+    char digits[20];
+    int k = 0;
+    for (; *p != 'e'; p++) {
+        if (*p != '.') digits[k++] = *p;
+    }
+    while (k > 1 && digits[k - 1] == '0') {
+        k--;
+    }
+    int n = atoi(p + 1) + 1;    // Position of the decimal point
+
+    if (k <= n && n <= 21) {
+        memcpy(out + length, digits, (size_t)k);
+        length += (size_t)k;
+        for (int i = k; i < n; i++) out[length++] = '0';
+    } else if (0 < n && n <= 21) {
+        memcpy(out + length, digits, (size_t)n);
+        length += (size_t)n;
+        out[length++] = '.';
+        memcpy(out + length, digits + n, (size_t)(k - n));
+        length += (size_t)(k - n);
+    } else if (-6 < n && n <= 0) {
+        out[length++] = '0';
+        out[length++] = '.';
+        for (int i = n; i < 0; i++) out[length++] = '0';
+        memcpy(out + length, digits, (size_t)k);
+        length += (size_t)k;
+    } else {
+        out[length++] = digits[0];
+        if (k > 1) {
+            out[length++] = '.';
+            memcpy(out + length, digits + 1, (size_t)(k - 1));
+            length += (size_t)(k - 1);
+        }
+        length += (size_t)sprintf(out + length, "e%c%d", n - 1 < 0 ? '-' : '+', abs(n - 1));
+    }
+    return length;
+}
+
+/* ========================================================================== */
+/* Value Writers                                                              */
+/* ========================================================================== */
+
+static bool writer_open(FHIRWriter* writer, char bracket) {
+    if (!writer || !writer_begin_value(writer)) {
+        return false;
+    }
+    if (writer->depth >= FHIR_WRITER_MAX_DEPTH) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "JSON nesting too deep");
+    }
+    writer->depth++;
+    writer->has_items[writer->depth] = false;
+    writer->member_base[writer->depth] = writer->member_count;
+    return writer_append_char(writer, bracket);
+}
+
+static bool writer_close(FHIRWriter* writer, char bracket) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (writer->depth == 0 || writer->after_key) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Unbalanced JSON container");
+    }
+    if (writer->canonical && !sort_members(writer)) {
+        return false;
+    }
+    writer->depth--;
+    return writer_append_char(writer, bracket);
+}
+
+bool fhir_writer_begin_object(FHIRWriter* writer) {
+    return writer_open(writer, '{');
+}
+
+bool fhir_writer_end_object(FHIRWriter* writer) {
+    return writer_close(writer, '}');
+}
+
+bool fhir_writer_begin_array(FHIRWriter* writer) {
+    return writer_open(writer, '[');
+}
+
+bool fhir_writer_end_array(FHIRWriter* writer) {
+    return writer_close(writer, ']');
+}
+
+// Append a quoted string, copying runs of characters that need no escaping in one go
+static bool writer_quoted(FHIRWriter* writer, const char* value, size_t length) {
+    if (!writer_append_char(writer, '"')) {
+        return false;
+    }
+
+    const unsigned char* text = (const unsigned char*)value;
+    size_t run_start = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        if (i > run_start && !writer_append(writer, value + run_start, i - run_start)) {
+            return false;
+        }
+        run_start = i + 1;
+
+        char escape[8];
+        size_t escape_length = 2;
+        escape[0] = '\\';
+        switch (c) {
+            case '"': escape[1] = '"'; break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                escape_length = (size_t)snprintf(escape, sizeof(escape), "\\u%04x", c);
+                break;
+        }
+        if (!writer_append(writer, escape, escape_length)) {
+            return false;
+        }
+    }
+
+    if (length > run_start && !writer_append(writer, value + run_start, length - run_start)) {
+        return false;
+    }
+    return writer_append_char(writer, '"');
+}
+
+bool fhir_writer_key(FHIRWriter* writer, const char* key) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (!key) {
+        return writer_fail(writer, FHIR_ERROR_INVALID_ARGUMENT, "JSON member name is NULL");
+    }
+    if (writer->depth == 0 || writer->after_key) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "JSON member name outside an object");
+    }
+
+    if (writer->has_items[writer->depth] && !writer_append_char(writer, ',')) {
+        return false;
+    }
+    writer->has_items[writer->depth] = true;
+    if (writer->canonical && !record_member(writer)) {
+        return false;
+    }
+
+    if (!writer_quoted(writer, key, strlen(key)) || !writer_append_char(writer, ':')) {
+        return false;
+    }
+    writer->after_key = true;
+    return true;
+}
+
+bool fhir_writer_string_n(FHIRWriter* writer, const char* value, size_t length) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (!value) {
+        return writer_fail(writer, FHIR_ERROR_INVALID_ARGUMENT, "JSON string value is NULL");
+    }
+    return writer_begin_value(writer) && writer_quoted(writer, value, length);
+}
+
+bool fhir_writer_string(FHIRWriter* writer, const char* value) {
+    return fhir_writer_string_n(writer, value, value ? strlen(value) : 0);
+}
+
+bool fhir_writer_bool(FHIRWriter* writer, bool value) {
+    if (!writer || !writer_begin_value(writer)) {
+        return false;
+    }
+    return value ? writer_append(writer, "true", 4) : writer_append(writer, "false", 5);
+}
+
+bool fhir_writer_null(FHIRWriter* writer) {
+    if (!writer || !writer_begin_value(writer)) {
+        return false;
+    }
+    return writer_append(writer, "null", 4);
+}
+
+bool fhir_writer_int(FHIRWriter* writer, int64_t value) {
+    if (!writer || !writer_begin_value(writer)) {
+        return false;
+    }
+
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%lld", (long long)value);
+    return writer_append(writer, digits, (size_t)length);
+}
+
+bool fhir_writer_double(FHIRWriter* writer, double value) {
+    if (!writer || !writer_begin_value(writer)) {
+        return false;
+    }
+    if (!isfinite(value)) {
+        return writer_append(writer, "null", 4);
+    }
+    if (writer->canonical) {
+        char canonical[40];
+        return writer_append(writer, canonical, format_canonical_double(value, canonical));
+    }
+
+    // Shortest of 15 or 17 significant digits that round-trips, as cJSON prints
+    char digits[32];
+    int length = snprintf(digits, sizeof(digits), "%1.15g", value);
+    if (strtod(digits, NULL) != value) {
+        length = snprintf(digits, sizeof(digits), "%1.17g", value);
+    }
+    return writer_append(writer, digits, (size_t)length);
+}
+
+bool fhir_writer_cjson(FHIRWriter* writer, const cJSON* item) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (!item) {
+        return writer_fail(writer, FHIR_ERROR_INVALID_ARGUMENT, "cJSON item is NULL");
+    }
+
+    const cJSON* child;
+    switch (item->type & 0xFF) {
+        case cJSON_False:
+            return fhir_writer_bool(writer, false);
+        case cJSON_True:
+            return fhir_writer_bool(writer, true);
+        case cJSON_NULL:
+            return fhir_writer_null(writer);
+        case cJSON_Number:
+            return fhir_writer_double(writer, item->valuedouble);
+        case cJSON_String:
+            return fhir_writer_string(writer, item->valuestring ? item->valuestring : "");
+        case cJSON_Raw:
+            if (writer->canonical) {
+                return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Raw JSON cannot be canonicalized");
+            }
+            if (!item->valuestring || !writer_begin_value(writer)) {
+                return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Invalid raw JSON value");
+            }
+            return writer_append(writer, item->valuestring, strlen(item->valuestring));
+        case cJSON_Array:
+            if (!fhir_writer_begin_array(writer)) {
+                return false;
+            }
+            cJSON_ArrayForEach(child, item) {
+                if (!fhir_writer_cjson(writer, child)) {
+                    return false;
+                }
+            }
+            return fhir_writer_end_array(writer);
+        case cJSON_Object:
+            if (!fhir_writer_begin_object(writer)) {
+                return false;
+            }
+            cJSON_ArrayForEach(child, item) {
+                if (!fhir_writer_key(writer, child->string ? child->string : "") ||
+                    !fhir_writer_cjson(writer, child)) {
+                    return false;
+                }
+            }
+            return fhir_writer_end_object(writer);
+        default:
+            return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Invalid cJSON item");
+    }
+}
+
+bool fhir_writer_raw(FHIRWriter* writer, const char* json, size_t length) {
+    if (!writer || writer->failed) {
+        return false;
+    }
+    if (!json || length == 0) {
+        return writer_fail(writer, FHIR_ERROR_INVALID_ARGUMENT, "Raw JSON value is empty");
+    }
+    if (writer->canonical) {
+        return writer_fail(writer, FHIR_ERROR_SERIALIZE_FAILED, "Raw JSON cannot be canonicalized");
+    }
+    return writer_begin_value(writer) && writer_append(writer, json, length);
+}
+
+bool fhir_writer_member_string(FHIRWriter* writer, const char* key, const char* value) {
+    return fhir_writer_key(writer, key) && fhir_writer_string(writer, value);
+}
+
+bool fhir_writer_member_bool(FHIRWriter* writer, const char* key, bool value) {
+    return fhir_writer_key(writer, key) && fhir_writer_bool(writer, value);
+}
+
+bool fhir_writer_member_int(FHIRWriter* writer, const char* key, int64_t value) {
+    return fhir_writer_key(writer, key) && fhir_writer_int(writer, value);
+}
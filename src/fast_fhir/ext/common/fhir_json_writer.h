@@ -0,0 +1,326 @@
+/**
+ * @file fhir_json_writer.h
+ * @brief Streaming compact JSON writer for FHIR resource serialization
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Writes compact JSON text directly into a growable buffer or a file
+ * descriptor, without building a cJSON tree and printing it afterwards.
+ * Commas and nesting are tracked by the writer; the first failure is sticky,
+ * so a serializer can issue a run of calls and check the result once.
+ *
+ * In canonical mode (fhir_writer_set_canonical) the same calls produce FHIR
+ * canonical JSON for signatures and content addressing: object members are
+ * sorted by name and numbers take their shortest round-trip form (RFC 8785).
+ * Members are sorted in place when their object closes, so the innermost
+ * open top-level value is held in memory; a sink or descriptor still
+ * receives every completed value without the whole output being kept.
+ */
+
+#ifndef FHIR_JSON_WRITER_H
+#define FHIR_JSON_WRITER_H
+
+#include "fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Writer Types                                                               */
+/* ========================================================================== */
+
+#define FHIR_WRITER_MAX_DEPTH 64
+#define FHIR_WRITER_DEFAULT_CAPACITY 1024
+#define FHIR_WRITER_FD_BUFFER_SIZE 65536
+
+/**
+ * @brief Output callback of a sink writer
+ * @param context Context given to fhir_writer_init_sink
+ * @param data Next piece of output
+ * @param length Length of data in bytes
+ * @return true to continue, false to fail the writer
+ */
+typedef bool (*FHIRWriterSink)(void* context, const char* data, size_t length);
+
+/**
+ * @brief Canonical-mode record of one object member
+ */
+typedef struct {
+    size_t start;               /**< Offset of the member name's opening quote */
+    size_t end;                 /**< Offset just past the member value */
+    const char* name;           /**< Member name in data, set while sorting */
+} FHIRWriterMember;
+
+/**
+ * @brief JSON writer state
+ *
+ * Lives in caller storage (usually the stack). In buffer mode the output
+ * accumulates in data; in descriptor and sink mode data is a staging buffer
+ * that is passed on whenever it fills up and by fhir_writer_flush.
+ */
+typedef struct FHIRWriter {
+    char* data;                 /**< Output (buffer mode) or staging buffer (fd mode) */
+    size_t length;              /**< Bytes currently held in data */
+    size_t capacity;            /**< Allocated size of data */
+    int fd;                     /**< Destination descriptor, -1 in buffer and sink mode */
+    FHIRWriterSink sink;        /**< Destination callback, NULL unless in sink mode */
+    void* sink_context;         /**< Context passed to sink */
+    bool failed;                /**< Set on the first error; later calls do nothing */
+    bool after_key;             /**< A member name was written and awaits its value */
+    int depth;                  /**< Current object/array nesting */
+    bool has_items[FHIR_WRITER_MAX_DEPTH + 1];  /**< Whether each level already has a value */
+    bool canonical;             /**< Sort members and normalize numbers */
+    FHIRWriterMember* members;  /**< Canonical mode: members of the open objects */
+    size_t member_count;
+    size_t member_capacity;
+    size_t member_base[FHIR_WRITER_MAX_DEPTH + 1];  /**< First member of each open level */
+    char* scratch;              /**< Canonical mode: reordering space */
+    size_t scratch_capacity;
+} FHIRWriter;
+
+/* ========================================================================== */
+/* Writer Lifecycle                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize a writer that accumulates output in memory
+ * @param writer Writer to initialize
+ * @param initial_capacity Initial buffer size (0 = FHIR_WRITER_DEFAULT_CAPACITY)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_writer_init_buffer(FHIRWriter* writer, size_t initial_capacity);
+
+/**
+ * @brief Initialize a writer that streams output to a file descriptor
+ * @param writer Writer to initialize
+ * @param fd Open descriptor (not closed by the writer)
+ * @return true on success, false on failure
+ */
+bool fhir_writer_init_fd(FHIRWriter* writer, int fd);
+
+/**
+ * @brief Initialize a writer that passes its output to a callback
+ *
+ * Lets output be consumed incrementally, e.g. fed to a hash function,
+ * without being accumulated in memory.
+ *
+ * @param writer Writer to initialize
+ * @param sink Output callback
+ * @param context Context passed to sink
+ * @return true on success, false on failure
+ */
+bool fhir_writer_init_sink(FHIRWriter* writer, FHIRWriterSink sink, void* context);
+
+/**
+ * @brief Switch canonical JSON mode on or off
+ *
+ * Must be called before anything is written. Canonical output has its
+ * object members sorted by name (code point order) and numbers written in
+ * their shortest round-trip form as JavaScript prints them (RFC 8785), so
+ * equal content always serializes to the same bytes. Raw cJSON values
+ * cannot be canonicalized and fail the writer.
+ *
+ * @param writer Writer instance
+ * @param canonical Whether to write canonical JSON
+ * @return true on success, false if output was already written
+ */
+bool fhir_writer_set_canonical(FHIRWriter* writer, bool canonical);
+
+/**
+ * @brief Discard written output and nesting state, keeping the buffer
+ * @param writer Writer instance
+ */
+void fhir_writer_reset(FHIRWriter* writer);
+
+/**
+ * @brief Pass any staged output to the descriptor or sink (no-op in buffer mode)
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_flush(FHIRWriter* writer);
+
+/**
+ * @brief Check that a complete JSON value was written and flush it
+ * @param writer Writer instance
+ * @return true if no error occurred and all containers are closed
+ */
+bool fhir_writer_finish(FHIRWriter* writer);
+
+/**
+ * @brief Terminate a complete top-level value with a newline (NDJSON output)
+ *
+ * Another top-level value may be written after the newline.
+ *
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_end_line(FHIRWriter* writer);
+
+/**
+ * @brief Take ownership of the buffered output (buffer mode)
+ *
+ * The returned text is NUL-terminated and released with fhir_free; the
+ * writer is left empty and may be reused after fhir_writer_init_buffer.
+ *
+ * @param writer Writer instance
+ * @param length Output for text length (can be NULL)
+ * @return Output text or NULL on failure
+ */
+char* fhir_writer_take_buffer(FHIRWriter* writer, size_t* length);
+
+/**
+ * @brief Free the writer's buffer (does not flush)
+ * @param writer Writer instance
+ */
+void fhir_writer_cleanup(FHIRWriter* writer);
+
+/* ========================================================================== */
+/* Value Writers                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Open an object
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_begin_object(FHIRWriter* writer);
+
+/**
+ * @brief Close the innermost object
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_end_object(FHIRWriter* writer);
+
+/**
+ * @brief Open an array
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_begin_array(FHIRWriter* writer);
+
+/**
+ * @brief Close the innermost array
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_end_array(FHIRWriter* writer);
+
+/**
+ * @brief Write an object member name; the next value becomes its value
+ * @param writer Writer instance
+ * @param key Member name
+ * @return true on success, false on failure
+ */
+bool fhir_writer_key(FHIRWriter* writer, const char* key);
+
+/**
+ * @brief Write an escaped string value
+ * @param writer Writer instance
+ * @param value NUL-terminated UTF-8 string
+ * @return true on success, false on failure
+ */
+bool fhir_writer_string(FHIRWriter* writer, const char* value);
+
+/**
+ * @brief Write an escaped string value of known length
+ * @param writer Writer instance
+ * @param value UTF-8 string, not necessarily NUL-terminated
+ * @param length Length of value in bytes
+ * @return true on success, false on failure
+ */
+bool fhir_writer_string_n(FHIRWriter* writer, const char* value, size_t length);
+
+/**
+ * @brief Write a boolean value
+ * @param writer Writer instance
+ * @param value Value to write
+ * @return true on success, false on failure
+ */
+bool fhir_writer_bool(FHIRWriter* writer, bool value);
+
+/**
+ * @brief Write an integer value
+ * @param writer Writer instance
+ * @param value Value to write
+ * @return true on success, false on failure
+ */
+bool fhir_writer_int(FHIRWriter* writer, int64_t value);
+
+/**
+ * @brief Write a number value (non-finite values are written as null, like cJSON)
+ *
+ * Outside canonical mode numbers are printed like cJSON prints them.
+ *
+ * @param writer Writer instance
+ * @param value Value to write
+ * @return true on success, false on failure
+ */
+bool fhir_writer_double(FHIRWriter* writer, double value);
+
+/**
+ * @brief Write a null value
+ * @param writer Writer instance
+ * @return true on success, false on failure
+ */
+bool fhir_writer_null(FHIRWriter* writer);
+
+/**
+ * @brief Write an existing cJSON value without printing it to a string first
+ * @param writer Writer instance
+ * @param item cJSON value
+ * @return true on success, false on failure
+ */
+bool fhir_writer_cjson(FHIRWriter* writer, const cJSON* item);
+
+/**
+ * @brief Write an already serialized JSON value verbatim
+ *
+ * Lets a caller copy unchanged parts of a source document without parsing
+ * them. The text is not checked; like raw cJSON values it fails the writer
+ * in canonical mode.
+ *
+ * @param writer Writer instance
+ * @param json Serialized JSON value
+ * @param length Length of json in bytes
+ * @return true on success, false on failure
+ */
+bool fhir_writer_raw(FHIRWriter* writer, const char* json, size_t length);
+
+/**
+ * @brief Write a string member
+ * @param writer Writer instance
+ * @param key Member name
+ * @param value Member value (NULL is an invalid argument)
+ * @return true on success, false on failure
+ */
+bool fhir_writer_member_string(FHIRWriter* writer, const char* key, const char* value);
+
+/**
+ * @brief Write a boolean member
+ * @param writer Writer instance
+ * @param key Member name
+ * @param value Member value
+ * @return true on success, false on failure
+ */
+bool fhir_writer_member_bool(FHIRWriter* writer, const char* key, bool value);
+
+/**
+ * @brief Write an integer member
+ * @param writer Writer instance
+ * @param key Member name
+ * @param value Member value
+ * @return true on success, false on failure
+ */
+bool fhir_writer_member_int(FHIRWriter* writer, const char* key, int64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_JSON_WRITER_H */
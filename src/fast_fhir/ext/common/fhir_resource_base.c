@@ -7,20 +7,28 @@
 
 #include "fhir_resource_base.h"
 #include "fhir_common.h"
+#include "fhir_resource_type_lookup.h"
+#include "fhir_hash.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 
 /* ========================================================================== */
 /* Global Resource Registry                                                   */
 /* ========================================================================== */
 
+/*
+ * Registrations are written once, under the lock, and published through
+ * g_registry_ready, so lookups from any thread (or interpreter) take no lock.
+ * Every program or extension module linking this file has its own registry.
+ */
 static FHIRResourceRegistration g_resource_registry[FHIR_RESOURCE_TYPE_COUNT];
-static bool g_registry_initialized = false;
+static FHIRAtomicInt g_registry_ready[FHIR_RESOURCE_TYPE_COUNT];
+static pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
 
-/* Resource type name mapping */
+/* Resource type name mapping (none for FHIR_RESOURCE_TYPE_UNKNOWN) */
 static const char* g_resource_type_names[FHIR_RESOURCE_TYPE_COUNT] = {
-    [FHIR_RESOURCE_TYPE_UNKNOWN] = "Unknown",
     [FHIR_RESOURCE_TYPE_PATIENT] = "Patient",
     [FHIR_RESOURCE_TYPE_PRACTITIONER] = "Practitioner",
     [FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE] = "PractitionerRole",
@@ -49,20 +57,155 @@ static const char* g_resource_type_names[FHIR_RESOURCE_TYPE_COUNT] = {
     [FHIR_RESOURCE_TYPE_DEVICE_METRIC] = "DeviceMetric",
     [FHIR_RESOURCE_TYPE_BIOLOGICALLY_DERIVED_PRODUCT] = "BiologicallyDerivedProduct",
     [FHIR_RESOURCE_TYPE_NUTRITION_PRODUCT] = "NutritionProduct",
-    [FHIR_RESOURCE_TYPE_VERIFICATION_RESULT] = "VerificationResult"
+    [FHIR_RESOURCE_TYPE_VERIFICATION_RESULT] = "VerificationResult",
+    [FHIR_RESOURCE_TYPE_BASIC] = "Basic",
+    [FHIR_RESOURCE_TYPE_BINARY] = "Binary",
+    [FHIR_RESOURCE_TYPE_BUNDLE] = "Bundle",
+    [FHIR_RESOURCE_TYPE_COMPOSITION] = "Composition",
+    [FHIR_RESOURCE_TYPE_DOCUMENT_REFERENCE] = "DocumentReference",
+    [FHIR_RESOURCE_TYPE_LINKAGE] = "Linkage",
+    [FHIR_RESOURCE_TYPE_LIST] = "List",
+    [FHIR_RESOURCE_TYPE_MESSAGE_HEADER] = "MessageHeader",
+    [FHIR_RESOURCE_TYPE_OPERATION_OUTCOME] = "OperationOutcome",
+    [FHIR_RESOURCE_TYPE_PARAMETERS] = "Parameters",
+    [FHIR_RESOURCE_TYPE_SUBSCRIPTION] = "Subscription",
+    [FHIR_RESOURCE_TYPE_SUBSCRIPTION_STATUS] = "SubscriptionStatus",
+    [FHIR_RESOURCE_TYPE_SUBSCRIPTION_TOPIC] = "SubscriptionTopic",
+    [FHIR_RESOURCE_TYPE_ALLERGY_INTOLERANCE] = "AllergyIntolerance",
+    [FHIR_RESOURCE_TYPE_ADVERSE_EVENT] = "AdverseEvent",
+    [FHIR_RESOURCE_TYPE_BODY_STRUCTURE] = "BodyStructure",
+    [FHIR_RESOURCE_TYPE_CARE_PLAN] = "CarePlan",
+    [FHIR_RESOURCE_TYPE_CARE_TEAM] = "CareTeam",
+    [FHIR_RESOURCE_TYPE_CLINICAL_IMPRESSION] = "ClinicalImpression",
+    [FHIR_RESOURCE_TYPE_DETECTED_ISSUE] = "DetectedIssue",
+    [FHIR_RESOURCE_TYPE_FAMILY_MEMBER_HISTORY] = "FamilyMemberHistory",
+    [FHIR_RESOURCE_TYPE_FLAG] = "Flag",
+    [FHIR_RESOURCE_TYPE_GOAL] = "Goal",
+    [FHIR_RESOURCE_TYPE_NUTRITION_INTAKE] = "NutritionIntake",
+    [FHIR_RESOURCE_TYPE_NUTRITION_ORDER] = "NutritionOrder",
+    [FHIR_RESOURCE_TYPE_RISK_ASSESSMENT] = "RiskAssessment",
+    [FHIR_RESOURCE_TYPE_SERVICE_REQUEST] = "ServiceRequest",
+    [FHIR_RESOURCE_TYPE_VISION_PRESCRIPTION] = "VisionPrescription",
+    [FHIR_RESOURCE_TYPE_GENOMIC_STUDY] = "GenomicStudy",
+    [FHIR_RESOURCE_TYPE_IMAGING_SELECTION] = "ImagingSelection",
+    [FHIR_RESOURCE_TYPE_IMAGING_STUDY] = "ImagingStudy",
+    [FHIR_RESOURCE_TYPE_MOLECULAR_SEQUENCE] = "MolecularSequence",
+    [FHIR_RESOURCE_TYPE_QUESTIONNAIRE_RESPONSE] = "QuestionnaireResponse",
+    [FHIR_RESOURCE_TYPE_SPECIMEN] = "Specimen",
+    [FHIR_RESOURCE_TYPE_IMMUNIZATION] = "Immunization",
+    [FHIR_RESOURCE_TYPE_IMMUNIZATION_EVALUATION] = "ImmunizationEvaluation",
+    [FHIR_RESOURCE_TYPE_IMMUNIZATION_RECOMMENDATION] = "ImmunizationRecommendation",
+    [FHIR_RESOURCE_TYPE_MEDICATION] = "Medication",
+    [FHIR_RESOURCE_TYPE_MEDICATION_ADMINISTRATION] = "MedicationAdministration",
+    [FHIR_RESOURCE_TYPE_MEDICATION_DISPENSE] = "MedicationDispense",
+    [FHIR_RESOURCE_TYPE_MEDICATION_REQUEST] = "MedicationRequest",
+    [FHIR_RESOURCE_TYPE_MEDICATION_STATEMENT] = "MedicationStatement",
+    [FHIR_RESOURCE_TYPE_COMMUNICATION] = "Communication",
+    [FHIR_RESOURCE_TYPE_COMMUNICATION_REQUEST] = "CommunicationRequest",
+    [FHIR_RESOURCE_TYPE_DEVICE_DISPENSE] = "DeviceDispense",
+    [FHIR_RESOURCE_TYPE_DEVICE_REQUEST] = "DeviceRequest",
+    [FHIR_RESOURCE_TYPE_DEVICE_USAGE] = "DeviceUsage",
+    [FHIR_RESOURCE_TYPE_GUIDANCE_RESPONSE] = "GuidanceResponse",
+    [FHIR_RESOURCE_TYPE_INVENTORY_ITEM] = "InventoryItem",
+    [FHIR_RESOURCE_TYPE_INVENTORY_REPORT] = "InventoryReport",
+    [FHIR_RESOURCE_TYPE_REQUEST_ORCHESTRATION] = "RequestOrchestration",
+    [FHIR_RESOURCE_TYPE_SUPPLY_DELIVERY] = "SupplyDelivery",
+    [FHIR_RESOURCE_TYPE_SUPPLY_REQUEST] = "SupplyRequest",
+    [FHIR_RESOURCE_TYPE_ACCOUNT] = "Account",
+    [FHIR_RESOURCE_TYPE_CHARGE_ITEM] = "ChargeItem",
+    [FHIR_RESOURCE_TYPE_CHARGE_ITEM_DEFINITION] = "ChargeItemDefinition",
+    [FHIR_RESOURCE_TYPE_CLAIM] = "Claim",
+    [FHIR_RESOURCE_TYPE_CLAIM_RESPONSE] = "ClaimResponse",
+    [FHIR_RESOURCE_TYPE_CONTRACT] = "Contract",
+    [FHIR_RESOURCE_TYPE_COVERAGE] = "Coverage",
+    [FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_REQUEST] = "CoverageEligibilityRequest",
+    [FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_RESPONSE] = "CoverageEligibilityResponse",
+    [FHIR_RESOURCE_TYPE_ENROLLMENT_REQUEST] = "EnrollmentRequest",
+    [FHIR_RESOURCE_TYPE_ENROLLMENT_RESPONSE] = "EnrollmentResponse",
+    [FHIR_RESOURCE_TYPE_EXPLANATION_OF_BENEFIT] = "ExplanationOfBenefit",
+    [FHIR_RESOURCE_TYPE_INSURANCE_PLAN] = "InsurancePlan",
+    [FHIR_RESOURCE_TYPE_INVOICE] = "Invoice",
+    [FHIR_RESOURCE_TYPE_PAYMENT_NOTICE] = "PaymentNotice",
+    [FHIR_RESOURCE_TYPE_PAYMENT_RECONCILIATION] = "PaymentReconciliation",
+    [FHIR_RESOURCE_TYPE_AUDIT_EVENT] = "AuditEvent",
+    [FHIR_RESOURCE_TYPE_CONSENT] = "Consent",
+    [FHIR_RESOURCE_TYPE_PERMISSION] = "Permission",
+    [FHIR_RESOURCE_TYPE_PROVENANCE] = "Provenance",
+    [FHIR_RESOURCE_TYPE_ACTOR_DEFINITION] = "ActorDefinition",
+    [FHIR_RESOURCE_TYPE_CAPABILITY_STATEMENT] = "CapabilityStatement",
+    [FHIR_RESOURCE_TYPE_CODE_SYSTEM] = "CodeSystem",
+    [FHIR_RESOURCE_TYPE_COMPARTMENT_DEFINITION] = "CompartmentDefinition",
+    [FHIR_RESOURCE_TYPE_CONCEPT_MAP] = "ConceptMap",
+    [FHIR_RESOURCE_TYPE_EXAMPLE_SCENARIO] = "ExampleScenario",
+    [FHIR_RESOURCE_TYPE_GRAPH_DEFINITION] = "GraphDefinition",
+    [FHIR_RESOURCE_TYPE_IMPLEMENTATION_GUIDE] = "ImplementationGuide",
+    [FHIR_RESOURCE_TYPE_MESSAGE_DEFINITION] = "MessageDefinition",
+    [FHIR_RESOURCE_TYPE_NAMING_SYSTEM] = "NamingSystem",
+    [FHIR_RESOURCE_TYPE_OPERATION_DEFINITION] = "OperationDefinition",
+    [FHIR_RESOURCE_TYPE_REQUIREMENTS] = "Requirements",
+    [FHIR_RESOURCE_TYPE_SEARCH_PARAMETER] = "SearchParameter",
+    [FHIR_RESOURCE_TYPE_STRUCTURE_DEFINITION] = "StructureDefinition",
+    [FHIR_RESOURCE_TYPE_STRUCTURE_MAP] = "StructureMap",
+    [FHIR_RESOURCE_TYPE_TERMINOLOGY_CAPABILITIES] = "TerminologyCapabilities",
+    [FHIR_RESOURCE_TYPE_TEST_PLAN] = "TestPlan",
+    [FHIR_RESOURCE_TYPE_TEST_REPORT] = "TestReport",
+    [FHIR_RESOURCE_TYPE_TEST_SCRIPT] = "TestScript",
+    [FHIR_RESOURCE_TYPE_VALUE_SET] = "ValueSet",
+    [FHIR_RESOURCE_TYPE_ACTIVITY_DEFINITION] = "ActivityDefinition",
+    [FHIR_RESOURCE_TYPE_CONDITION_DEFINITION] = "ConditionDefinition",
+    [FHIR_RESOURCE_TYPE_DEVICE_DEFINITION] = "DeviceDefinition",
+    [FHIR_RESOURCE_TYPE_EVENT_DEFINITION] = "EventDefinition",
+    [FHIR_RESOURCE_TYPE_LIBRARY] = "Library",
+    [FHIR_RESOURCE_TYPE_MEASURE] = "Measure",
+    [FHIR_RESOURCE_TYPE_MEASURE_REPORT] = "MeasureReport",
+    [FHIR_RESOURCE_TYPE_OBSERVATION_DEFINITION] = "ObservationDefinition",
+    [FHIR_RESOURCE_TYPE_PLAN_DEFINITION] = "PlanDefinition",
+    [FHIR_RESOURCE_TYPE_QUESTIONNAIRE] = "Questionnaire",
+    [FHIR_RESOURCE_TYPE_SPECIMEN_DEFINITION] = "SpecimenDefinition",
+    [FHIR_RESOURCE_TYPE_ARTIFACT_ASSESSMENT] = "ArtifactAssessment",
+    [FHIR_RESOURCE_TYPE_CITATION] = "Citation",
+    [FHIR_RESOURCE_TYPE_EVIDENCE] = "Evidence",
+    [FHIR_RESOURCE_TYPE_EVIDENCE_REPORT] = "EvidenceReport",
+    [FHIR_RESOURCE_TYPE_EVIDENCE_VARIABLE] = "EvidenceVariable",
+    [FHIR_RESOURCE_TYPE_RESEARCH_STUDY] = "ResearchStudy",
+    [FHIR_RESOURCE_TYPE_RESEARCH_SUBJECT] = "ResearchSubject",
+    [FHIR_RESOURCE_TYPE_ADMINISTRABLE_PRODUCT_DEFINITION] = "AdministrableProductDefinition",
+    [FHIR_RESOURCE_TYPE_BIOLOGICALLY_DERIVED_PRODUCT_DISPENSE] = "BiologicallyDerivedProductDispense",
+    [FHIR_RESOURCE_TYPE_CLINICAL_USE_DEFINITION] = "ClinicalUseDefinition",
+    [FHIR_RESOURCE_TYPE_FORMULARY_ITEM] = "FormularyItem",
+    [FHIR_RESOURCE_TYPE_INGREDIENT] = "Ingredient",
+    [FHIR_RESOURCE_TYPE_MANUFACTURED_ITEM_DEFINITION] = "ManufacturedItemDefinition",
+    [FHIR_RESOURCE_TYPE_MEDICATION_KNOWLEDGE] = "MedicationKnowledge",
+    [FHIR_RESOURCE_TYPE_MEDICINAL_PRODUCT_DEFINITION] = "MedicinalProductDefinition",
+    [FHIR_RESOURCE_TYPE_PACKAGED_PRODUCT_DEFINITION] = "PackagedProductDefinition",
+    [FHIR_RESOURCE_TYPE_REGULATED_AUTHORIZATION] = "RegulatedAuthorization",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE] = "Substance",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_DEFINITION] = "SubstanceDefinition",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_NUCLEIC_ACID] = "SubstanceNucleicAcid",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_POLYMER] = "SubstancePolymer",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_PROTEIN] = "SubstanceProtein",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_REFERENCE_INFORMATION] = "SubstanceReferenceInformation",
+    [FHIR_RESOURCE_TYPE_SUBSTANCE_SOURCE_MATERIAL] = "SubstanceSourceMaterial"
 };
 
 /* ========================================================================== */
 /* Private Helper Functions                                                   */
 /* ========================================================================== */
 
-static void init_registry_if_needed(void) {
-    if (!g_registry_initialized) {
-        memset(g_resource_registry, 0, sizeof(g_resource_registry));
-        g_registry_initialized = true;
-    }
+// Published registration of a valid type, or NULL
+static const FHIRResourceRegistration* registry_get(FHIRResourceType type) {
+    return fhir_atomic_load(&g_registry_ready[type]) ? &g_resource_registry[type] : NULL;
 }
 
+static void release_fields(FHIRResourceBase* self, const FHIRSharedField* fields, size_t field_count);
+
+static const FHIRSharedField g_base_shared_fields[] = {
+    FHIR_SHARED_FIELD(FHIRResourceBase, extension, FHIRExtension, shared_extension),
+    FHIR_SHARED_FIELD(FHIRResourceBase, modifier_extension, FHIRExtension, shared_modifier_extension)
+};
+
+#define BASE_SHARED_FIELD_COUNT (sizeof(g_base_shared_fields) / sizeof(g_base_shared_fields[0]))
+
 static void free_validation_errors(FHIRResourceBase* self) {
     if (self->validation_errors) {
         for (size_t i = 0; i < self->validation_error_count; i++) {
@@ -85,14 +228,22 @@ bool fhir_resource_register_type(const FHIRResourceRegistration* registration) {
         return false;
     }
     
-    init_registry_if_needed();
+    pthread_mutex_lock(&g_registry_lock);
+    const FHIRResourceRegistration* existing = &g_resource_registry[registration->type];
+    bool registered = fhir_atomic_load_relaxed(&g_registry_ready[registration->type]) != 0;
+    bool same = registered && existing->vtable == registration->vtable &&
+                existing->factory == registration->factory;
+    if (!registered) {
+        g_resource_registry[registration->type] = *registration;
+        fhir_atomic_store(&g_registry_ready[registration->type], 1);
+    }
+    pthread_mutex_unlock(&g_registry_lock);
     
-    if (g_resource_registry[registration->type].type != FHIR_RESOURCE_TYPE_UNKNOWN) {
+    // Modules initialized in several interpreters register the same type again
+    if (registered && !same) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Resource type already registered");
         return false;
     }
-    
-    g_resource_registry[registration->type] = *registration;
     return true;
 }
 
@@ -112,17 +263,47 @@ FHIRResourceBase* fhir_resource_create_by_type(FHIRResourceType type, const char
         return NULL;
     }
     
-    init_registry_if_needed();
-    
-    const FHIRResourceRegistration* reg = &g_resource_registry[type];
-    if (reg->type == FHIR_RESOURCE_TYPE_UNKNOWN || !reg->factory) {
+    const FHIRResourceRegistration* reg = registry_get(type);
+    if (!reg || !reg->factory) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Resource type not registered");
         return NULL;
     }
     
-    return reg->factory(id);
-}/* ====
-====================================================================== */
+    int previous_type = fhir_memory_set_type(type);
+    FHIRResourceBase* resource = reg->factory(id);
+    fhir_memory_set_type(previous_type);
+    return resource;
+}
+
+FHIRResourceBase* fhir_resource_parse_with_arena(FHIRArena* arena, const cJSON* json) {
+    if (!arena || !json) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    
+    const char* type_name = fhir_json_get_string(json, "resourceType");
+    if (!type_name) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "resourceType");
+        return NULL;
+    }
+    const char* id = fhir_json_get_string(json, "id");
+    if (!id) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "id");
+        return NULL;
+    }
+    
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    FHIRResourceBase* resource = fhir_resource_create_by_name(type_name, id);
+    if (resource && !fhir_resource_from_json(resource, json)) {
+        // Partially loaded fields stay in the arena until it is reset
+        resource = NULL;
+    }
+    fhir_arena_set_current(previous);
+    
+    return resource;
+}
+
+/* ========================================================================== */
 /* Base Resource Implementation                                               */
 /* ========================================================================== */
 
@@ -141,7 +322,13 @@ bool fhir_resource_base_init(FHIRResourceBase* self, const FHIRResourceVTable* v
     // Initialize base fields
     memset(self, 0, sizeof(FHIRResourceBase));
     self->vtable = vtable;
-    self->ref_count = 1;
+    fhir_atomic_init(&self->ref_count, 1);
+    fhir_atomic_init(&self->validation_state, FHIR_VALIDATION_CACHE_EMPTY);
+    fhir_atomic_init(&self->validation_dirty, 0);
+    fhir_atomic_init(&self->validation_failures, 0);
+    fhir_atomic_init(&self->hash_state, FHIR_VALIDATION_CACHE_EMPTY);
+    fhir_atomic_init(&self->share_state, FHIR_SHARE_STATE_PRIVATE);
+    self->arena = fhir_arena_get_current();
     self->resource_type = type;
     self->is_domain_resource = true; // Most FHIR resources are DomainResources
     
@@ -174,6 +361,9 @@ void fhir_resource_base_cleanup(FHIRResourceBase* self) {
         fhir_free(self->contained);
     }
     
+    // Drop shared extension arrays; private ones are freed below
+    release_fields(self, g_base_shared_fields, BASE_SHARED_FIELD_COUNT);
+    
     // Free extensions
     if (self->extension) {
         for (size_t i = 0; i < self->extension_count; i++) {
@@ -189,13 +379,62 @@ void fhir_resource_base_cleanup(FHIRResourceBase* self) {
         fhir_free(self->modifier_extension);
     }
     
+    // Free unknown member names
+    if (self->unknown_members) {
+        for (size_t i = 0; i < self->unknown_member_count; i++) {
+            fhir_free(self->unknown_members[i]);
+        }
+        fhir_free(self->unknown_members);
+    }
+    
     // Free validation errors
     free_validation_errors(self);
 }
 
+void* fhir_resource_alloc(const FHIRResourceVTable* vtable) {
+    if (!vtable || vtable->instance_size == 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid vtable");
+        return NULL;
+    }
+
+    return vtable->pool ? fhir_pool_alloc(vtable->pool) : fhir_calloc(1, vtable->instance_size);
+}
+
+void fhir_resource_free(const FHIRResourceVTable* vtable, void* instance) {
+    if (vtable && vtable->pool) {
+        fhir_pool_free(vtable->pool, instance);
+    } else {
+        fhir_free(instance);
+    }
+}
+
+bool fhir_resource_add_unknown_member(FHIRResourceBase* self, const char* name) {
+    if (!self || !name) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    char* copy = fhir_strdup(name);
+    if (!copy) {
+        return false;
+    }
+    
+    char** members = fhir_realloc(self->unknown_members,
+                                  (self->unknown_member_count + 1) * sizeof(char*));
+    if (!members) {
+        fhir_free(copy);
+        return false;
+    }
+    
+    members[self->unknown_member_count++] = copy;
+    self->unknown_members = members;
+    return true;
+}
+
 FHIRResourceBase* fhir_resource_retain(FHIRResourceBase* self) {
     if (self) {
-        self->ref_count++;
+        // A new reference is always made from an existing one, so no ordering is needed
+        fhir_atomic_fetch_add_relaxed(&self->ref_count, 1);
     }
     return self;
 }
@@ -203,8 +442,14 @@ FHIRResourceBase* fhir_resource_retain(FHIRResourceBase* self) {
 void fhir_resource_release(FHIRResourceBase* self) {
     if (!self) return;
     
-    self->ref_count--;
-    if (self->ref_count <= 0) {
+    // Release orders this thread's use of the resource before the decrement;
+    // the final owner's acquire fence makes all of them visible before destroy
+    if (fhir_atomic_fetch_sub_release(&self->ref_count, 1) == 1) {
+        fhir_atomic_fence_acquire();
+        if (self->arena) {
+            return;
+        }
+        
         // Call virtual destructor
         if (self->vtable && self->vtable->destroy) {
             self->vtable->destroy(self);
@@ -217,7 +462,520 @@ void fhir_resource_release(FHIRResourceBase* self) {
 }
 
 int fhir_resource_get_ref_count(const FHIRResourceBase* self) {
-    return self ? self->ref_count : 0;
+    return self ? fhir_atomic_load(&self->ref_count) : 0;
+}
+
+/* ========================================================================== */
+/* Validation Cache                                                           */
+/* ========================================================================== */
+
+bool fhir_resource_get_cached_validation(const FHIRResourceBase* self, bool* result) {
+    if (!self || fhir_atomic_load(&self->validation_state) != FHIR_VALIDATION_CACHE_READY) {
+        return false;
+    }
+    if (result) {
+        *result = self->validation_result;
+    }
+    return true;
+}
+
+// Store a result while holding the BUSY state; replaces a stale result's errors
+static void publish_validation(FHIRResourceBase* cache, bool result, char** errors, size_t error_count,
+                               bool incremental, uint32_t failures) {
+    free_validation_errors(cache);
+    cache->validation_result = result;
+    cache->validation_incremental = incremental;
+    cache->validation_errors = errors;
+    cache->validation_error_count = error_count;
+    fhir_atomic_store(&cache->validation_dirty, 0);
+    fhir_atomic_store(&cache->validation_failures, (int)failures);
+    fhir_atomic_store(&cache->validation_state, FHIR_VALIDATION_CACHE_READY);
+}
+
+// Lost the race to publish: drop our errors and return the winner's result
+static bool await_validation(FHIRResourceBase* cache, char** errors, size_t error_count) {
+    if (errors) {
+        for (size_t i = 0; i < error_count; i++) {
+            fhir_free(errors[i]);
+        }
+        fhir_free(errors);
+    }
+    
+    // The winner publishes with a few plain stores, so this wait is brief
+    while (fhir_atomic_load(&cache->validation_state) == FHIR_VALIDATION_CACHE_BUSY) {
+    }
+    return cache->validation_result;
+}
+
+bool fhir_resource_cache_validation(const FHIRResourceBase* self, bool result,
+                                    char** errors, size_t error_count) {
+    if (!self) return result;
+    
+    // The cache is logically const: it only memoizes a pure function of the resource
+    FHIRResourceBase* cache = (FHIRResourceBase*)self;
+    
+    int expected = fhir_atomic_load(&cache->validation_state);
+    if ((expected == FHIR_VALIDATION_CACHE_EMPTY || expected == FHIR_VALIDATION_CACHE_STALE) &&
+        fhir_atomic_compare_exchange(&cache->validation_state, &expected, FHIR_VALIDATION_CACHE_BUSY)) {
+        publish_validation(cache, result, errors, error_count, false, 0);
+        return result;
+    }
+    
+    // Another thread won; its result is identical, so discard ours
+    return await_validation(cache, errors, error_count);
+}
+
+void fhir_resource_invalidate_validation(FHIRResourceBase* self) {
+    if (!self) return;
+    
+    free_validation_errors(self);
+    self->validation_result = false;
+    self->validation_incremental = false;
+    fhir_atomic_store(&self->validation_dirty, 0);
+    fhir_atomic_store(&self->validation_failures, 0);
+    fhir_atomic_store(&self->validation_state, FHIR_VALIDATION_CACHE_EMPTY);
+    fhir_atomic_store(&self->hash_state, FHIR_VALIDATION_CACHE_EMPTY);
+}
+
+void fhir_resource_mark_dirty(FHIRResourceBase* self, uint32_t fields) {
+    if (!self) return;
+    
+    // Any change can change the hash
+    fhir_atomic_store(&self->hash_state, FHIR_VALIDATION_CACHE_EMPTY);
+    
+    int state = fhir_atomic_load(&self->validation_state);
+    if (state == FHIR_VALIDATION_CACHE_EMPTY) {
+        return;
+    }
+    if (!self->validation_incremental) {
+        fhir_resource_invalidate_validation(self);
+        return;
+    }
+    
+    uint32_t dirty = (uint32_t)fhir_atomic_load(&self->validation_dirty) | fields;
+    fhir_atomic_store(&self->validation_dirty, (int)dirty);
+    fhir_atomic_store(&self->validation_state, FHIR_VALIDATION_CACHE_STALE);
+}
+
+bool fhir_resource_validate_rules(const FHIRResourceBase* self, const FHIRValidationRule* rules,
+                                  size_t rule_count) {
+    if (!self || (rule_count > 0 && !rules) || rule_count > FHIR_VALIDATION_RULE_MAX) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid validation rule table");
+        return false;
+    }
+    
+    FHIRResourceBase* cache = (FHIRResourceBase*)self;
+    int state = fhir_atomic_load(&cache->validation_state);
+    if (state == FHIR_VALIDATION_CACHE_READY) {
+        return cache->validation_result;
+    }
+    if (state == FHIR_VALIDATION_CACHE_BUSY) {
+        return await_validation(cache, NULL, 0);
+    }
+    
+    // A stale result keeps the outcome of every rule that reads only clean fields
+    bool full = state != FHIR_VALIDATION_CACHE_STALE;
+    uint32_t dirty = full ? FHIR_DIRTY_ALL : (uint32_t)fhir_atomic_load(&cache->validation_dirty);
+    uint32_t failures = full ? 0 : (uint32_t)fhir_atomic_load(&cache->validation_failures);
+    for (size_t i = 0; i < rule_count; i++) {
+        if (full || (rules[i].fields & dirty)) {
+            uint32_t bit = 1u << i;
+            failures = rules[i].check(self) ? failures & ~bit : failures | bit;
+        }
+    }
+    
+    // Errors are rebuilt from the failure bits, so unchanged rules report as before
+    size_t error_count = 0;
+    for (size_t i = 0; i < rule_count; i++) {
+        error_count += (failures >> i) & 1u;
+    }
+    char** errors = error_count ? fhir_calloc(error_count, sizeof(char*)) : NULL;
+    if (errors) {
+        size_t next = 0;
+        for (size_t i = 0; i < rule_count; i++) {
+            if ((failures >> i) & 1u) {
+                errors[next++] = fhir_strdup(rules[i].message);
+            }
+        }
+    } else {
+        error_count = 0;
+    }
+    
+    int expected = state;
+    if (fhir_atomic_compare_exchange(&cache->validation_state, &expected, FHIR_VALIDATION_CACHE_BUSY)) {
+        publish_validation(cache, failures == 0, errors, error_count, true, failures);
+        return failures == 0;
+    }
+    return await_validation(cache, errors, error_count);
+}
+
+uint32_t fhir_resource_member_dirty_fields(const FHIRResourceVTable* vtable, const char* member) {
+    if (!vtable || !vtable->member_dirty_fields || !member) {
+        return FHIR_DIRTY_ALL;
+    }
+    return vtable->member_dirty_fields(member);
+}
+
+void fhir_resource_inherit_validation(FHIRResourceBase* target, const FHIRResourceBase* source,
+                                      uint32_t fields) {
+    if (!target || !source || target->vtable != source->vtable) return;
+    
+    // Only per-rule outcomes can be partially reused; errors are rebuilt from them
+    int state = fhir_atomic_load(&source->validation_state);
+    if ((state != FHIR_VALIDATION_CACHE_READY && state != FHIR_VALIDATION_CACHE_STALE) ||
+        !source->validation_incremental) {
+        return;
+    }
+    
+    fhir_resource_invalidate_validation(target);
+    uint32_t dirty = (uint32_t)fhir_atomic_load(&source->validation_dirty) | fields;
+    target->validation_result = source->validation_result;
+    target->validation_incremental = true;
+    fhir_atomic_store(&target->validation_dirty, (int)dirty);
+    fhir_atomic_store(&target->validation_failures, fhir_atomic_load(&source->validation_failures));
+    fhir_atomic_store(&target->validation_state, FHIR_VALIDATION_CACHE_STALE);
+}
+
+/* ========================================================================== */
+/* Structural Hashing                                                         */
+/* ========================================================================== */
+
+// Seed of structural hashes; changing it changes every stored hash
+#define FHIR_RESOURCE_HASH_SEED UINT64_C(0x46484952)
+
+static bool hash_output(void* context, const char* data, size_t length) {
+    fhir_hasher_update(context, data, length);
+    return true;
+}
+
+// Canonical JSON makes the hash independent of the serializer's member order
+static bool hash_serialized(const FHIRResourceBase* self, uint64_t* hash) {
+    FHIRHasher hasher;
+    FHIRWriter writer;
+    fhir_hasher_init(&hasher, FHIR_RESOURCE_HASH_SEED);
+    if (!fhir_writer_init_sink(&writer, hash_output, &hasher)) {
+        return false;
+    }
+    bool ok = fhir_writer_set_canonical(&writer, true) && fhir_resource_write_json(self, &writer) &&
+              fhir_writer_finish(&writer);
+    if (ok) {
+        *hash = fhir_hasher_digest(&hasher);
+    }
+    fhir_writer_cleanup(&writer);
+    return ok;
+}
+
+uint64_t fhir_resource_hash(const FHIRResourceBase* self) {
+    if (!self) return 0;
+    
+    uint64_t hash = 0;
+    if (fhir_resource_get_cached_hash(self, &hash)) {
+        return hash;
+    }
+    
+    // A failed serialization is not cached, so a later call can retry
+    bool ok = true;
+    if (self->vtable && self->vtable->hash) {
+        hash = self->vtable->hash(self);
+    } else {
+        ok = hash_serialized(self, &hash);
+    }
+    
+    // Same publication protocol as the validation cache; every thread computes the same value
+    FHIRResourceBase* cache = (FHIRResourceBase*)self;
+    int expected = FHIR_VALIDATION_CACHE_EMPTY;
+    if (ok && fhir_atomic_compare_exchange(&cache->hash_state, &expected, FHIR_VALIDATION_CACHE_BUSY)) {
+        cache->hash_value = hash;
+        fhir_atomic_store(&cache->hash_state, FHIR_VALIDATION_CACHE_READY);
+    }
+    return hash;
+}
+
+bool fhir_resource_get_cached_hash(const FHIRResourceBase* self, uint64_t* hash) {
+    if (!self || fhir_atomic_load(&self->hash_state) != FHIR_VALIDATION_CACHE_READY) {
+        return false;
+    }
+    if (hash) {
+        *hash = self->hash_value;
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Copy-on-Write Sharing                                                      */
+/* ========================================================================== */
+
+static void*** field_items_slot(FHIRResourceBase* self, const FHIRSharedField* field) {
+    return (void***)((char*)self + field->items_offset);
+}
+
+static size_t* field_count_slot(FHIRResourceBase* self, const FHIRSharedField* field) {
+    return (size_t*)((char*)self + field->count_offset);
+}
+
+static FHIRSharedArray** field_share_slot(FHIRResourceBase* self, const FHIRSharedField* field) {
+    return (FHIRSharedArray**)((char*)self + field->share_offset);
+}
+
+static void shared_array_release(FHIRSharedArray* share) {
+    // Same ordering as fhir_resource_release: the last owner sees all prior uses
+    if (fhir_atomic_fetch_sub_release(&share->ref_count, 1) == 1) {
+        fhir_atomic_fence_acquire();
+        for (size_t i = 0; i < share->count; i++) {
+            fhir_free(share->items[i]);
+        }
+        fhir_free(share->items);
+        fhir_free(share);
+    }
+}
+
+static void release_fields(FHIRResourceBase* self, const FHIRSharedField* fields, size_t field_count) {
+    for (size_t i = 0; i < field_count; i++) {
+        FHIRSharedArray** share = field_share_slot(self, &fields[i]);
+        if (*share) {
+            shared_array_release(*share);
+            *share = NULL;
+            *field_items_slot(self, &fields[i]) = NULL;
+            *field_count_slot(self, &fields[i]) = 0;
+        }
+    }
+}
+
+static bool convert_fields(FHIRResourceBase* self, const FHIRSharedField* fields, size_t field_count) {
+    for (size_t i = 0; i < field_count; i++) {
+        FHIRSharedArray** share = field_share_slot(self, &fields[i]);
+        size_t count = *field_count_slot(self, &fields[i]);
+        if (*share || count == 0) {
+            continue;
+        }
+        
+        // The block takes over the existing arrays; the resource keeps pointing at them
+        FHIRSharedArray* block = fhir_malloc(sizeof(FHIRSharedArray));
+        if (!block) {
+            return false;
+        }
+        fhir_atomic_init(&block->ref_count, 1);
+        block->items = *field_items_slot(self, &fields[i]);
+        block->count = count;
+        *share = block;
+    }
+    return true;
+}
+
+static bool make_shareable(FHIRResourceBase* self, const FHIRSharedField* fields, size_t field_count) {
+    if (fhir_atomic_load(&self->share_state) == FHIR_SHARE_STATE_SHARED) {
+        return true;
+    }
+    
+    int expected = FHIR_SHARE_STATE_PRIVATE;
+    if (fhir_atomic_compare_exchange(&self->share_state, &expected, FHIR_SHARE_STATE_CONVERTING)) {
+        bool converted = convert_fields(self, g_base_shared_fields, BASE_SHARED_FIELD_COUNT) &&
+                         convert_fields(self, fields, field_count);
+        fhir_atomic_store(&self->share_state,
+                          converted ? FHIR_SHARE_STATE_SHARED : FHIR_SHARE_STATE_PRIVATE);
+        if (!converted) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate shared array");
+        }
+        return converted;
+    }
+    
+    // Another clone of this resource is converting it; conversion only allocates
+    while (fhir_atomic_load(&self->share_state) == FHIR_SHARE_STATE_CONVERTING) {
+    }
+    if (fhir_atomic_load(&self->share_state) != FHIR_SHARE_STATE_SHARED) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate shared array");
+        return false;
+    }
+    return true;
+}
+
+static void alias_fields(FHIRResourceBase* source, FHIRResourceBase* clone,
+                         const FHIRSharedField* fields, size_t field_count) {
+    for (size_t i = 0; i < field_count; i++) {
+        FHIRSharedArray* block = *field_share_slot(source, &fields[i]);
+        if (!block) {
+            continue;
+        }
+        fhir_atomic_fetch_add_relaxed(&block->ref_count, 1);
+        *field_share_slot(clone, &fields[i]) = block;
+        *field_items_slot(clone, &fields[i]) = block->items;
+        *field_count_slot(clone, &fields[i]) = block->count;
+    }
+}
+
+bool fhir_resource_share_fields(const FHIRResourceBase* source, FHIRResourceBase* clone,
+                                const FHIRSharedField* fields, size_t field_count) {
+    if (!source || !clone || (field_count > 0 && !fields)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    // Shared blocks live on the heap and may outlive any arena
+    if (source->arena || clone->arena || fhir_arena_get_current()) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Arena-owned resources cannot share fields");
+        return false;
+    }
+    
+    // Moving arrays into shared blocks leaves the source's contents unchanged
+    FHIRResourceBase* shared = (FHIRResourceBase*)source;
+    if (!make_shareable(shared, fields, field_count)) {
+        return false;
+    }
+    
+    alias_fields(shared, clone, g_base_shared_fields, BASE_SHARED_FIELD_COUNT);
+    alias_fields(shared, clone, fields, field_count);
+    fhir_atomic_store(&clone->share_state, FHIR_SHARE_STATE_SHARED);
+    return true;
+}
+
+bool fhir_resource_detach_field(FHIRResourceBase* self, const FHIRSharedField* field) {
+    if (!self || !field) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    // The field is about to change, so the next clone has to share it again
+    fhir_atomic_store(&self->share_state, FHIR_SHARE_STATE_PRIVATE);
+    
+    FHIRSharedArray** share = field_share_slot(self, field);
+    FHIRSharedArray* block = *share;
+    if (!block) {
+        return true;
+    }
+    
+    // Sole owner: keep the arrays and drop the block
+    if (fhir_atomic_load(&block->ref_count) == 1) {
+        fhir_free(block);
+        *share = NULL;
+        return true;
+    }
+    
+    void** items = fhir_calloc(block->count, sizeof(void*));
+    if (!items) {
+        return false;
+    }
+    for (size_t i = 0; i < block->count; i++) {
+        if (!block->items[i]) {
+            continue;
+        }
+        if (field->copy_element) {
+            items[i] = field->copy_element(block->items[i]);
+        } else if ((items[i] = fhir_malloc(field->element_size))) {
+            memcpy(items[i], block->items[i], field->element_size);
+        }
+        if (!items[i]) {
+            for (size_t j = 0; j < i; j++) {
+                fhir_free(items[j]);
+            }
+            fhir_free(items);
+            return false;
+        }
+    }
+    
+    *field_items_slot(self, field) = items;
+    *share = NULL;
+    shared_array_release(block);
+    return true;
+}
+
+bool fhir_resource_detach_extensions(FHIRResourceBase* self) {
+    return fhir_resource_detach_field(self, &g_base_shared_fields[0]) &&
+           fhir_resource_detach_field(self, &g_base_shared_fields[1]);
+}
+
+void fhir_resource_release_shared_fields(FHIRResourceBase* self, const FHIRSharedField* fields,
+                                         size_t field_count) {
+    if (!self || (field_count > 0 && !fields)) return;
+    
+    release_fields(self, fields, field_count);
+}
+
+/* ========================================================================== */
+/* Polymorphic Serialization                                                  */
+/* ========================================================================== */
+
+bool fhir_resource_write_json(const FHIRResourceBase* self, FHIRWriter* writer) {
+    if (!self || !self->vtable || !writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    FHIRPerfSpan span;
+    fhir_perf_begin(&span, FHIR_PERF_PHASE_SERIALIZE, self->resource_type);
+    bool written;
+    if (self->vtable->write_json) {
+        written = self->vtable->write_json(self, writer);
+    } else {
+        cJSON* json = fhir_resource_to_json(self);
+        written = json && fhir_writer_cjson(writer, json);
+        cJSON_Delete(json);
+    }
+    fhir_perf_end(&span, 0, written);
+    return written;
+}
+
+uint8_t* fhir_resource_to_binary(const FHIRResourceBase* self, size_t* length) {
+    if (!self || !self->vtable || !length) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    
+    FHIRBinaryWriter writer;
+    if (!fhir_binary_writer_init(&writer, self->resource_type, self->id)) {
+        fhir_binary_writer_cleanup(&writer);
+        return NULL;
+    }
+    
+    bool encoded;
+    if (self->vtable->to_binary) {
+        encoded = self->vtable->to_binary(self, &writer);
+    } else {
+        cJSON* json = fhir_resource_to_json(self);
+        writer.flags |= FHIR_BINARY_FLAG_JSON;
+        encoded = json && fhir_binary_write_json_members(&writer, json);
+        cJSON_Delete(json);
+    }
+    
+    uint8_t* data = encoded ? fhir_binary_writer_finish(&writer, length) : NULL;
+    fhir_binary_writer_cleanup(&writer);
+    return data;
+}
+
+FHIRResourceBase* fhir_resource_from_binary(const void* data, size_t length) {
+    FHIRBinaryDocument document;
+    if (!fhir_binary_open(&document, data, length)) {
+        return NULL;
+    }
+    
+    const char* id = fhir_binary_get_id(&document);
+    if (!id) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "id");
+        return NULL;
+    }
+    FHIRResourceBase* resource = fhir_resource_create_by_type((FHIRResourceType)document.resource_type, id);
+    if (!resource) {
+        return NULL;
+    }
+    
+    bool loaded;
+    if (document.flags & FHIR_BINARY_FLAG_JSON) {
+        cJSON* json = fhir_binary_to_json(&document);
+        loaded = json && fhir_resource_from_json(resource, json);
+        cJSON_Delete(json);
+    } else if (resource->vtable->from_binary) {
+        int previous_type = fhir_memory_set_type(resource->resource_type);
+        loaded = resource->vtable->from_binary(resource, &document);
+        fhir_memory_set_type(previous_type);
+    } else {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Resource type has no binary decoder");
+        loaded = false;
+    }
+    
+    if (!loaded) {
+        fhir_resource_release(resource);
+        return NULL;
+    }
+    return resource;
 }
 
 /* ========================================================================== */
@@ -233,14 +991,12 @@ const char* fhir_resource_type_to_string(FHIRResourceType type) {
 
 FHIRResourceType fhir_resource_type_from_string(const char* name) {
     if (!name) return FHIR_RESOURCE_TYPE_UNKNOWN;
-    
-    for (int i = 1; i < FHIR_RESOURCE_TYPE_COUNT; i++) {
-        if (g_resource_type_names[i] && strcmp(name, g_resource_type_names[i]) == 0) {
-            return (FHIRResourceType)i;
-        }
-    }
-    
-    return FHIR_RESOURCE_TYPE_UNKNOWN;
+    return fhir_resource_type_lookup(name, strlen(name));
+}
+
+FHIRResourceType fhir_resource_type_from_string_n(const char* name, size_t length) {
+    if (!name) return FHIR_RESOURCE_TYPE_UNKNOWN;
+    return fhir_resource_type_lookup(name, length);
 }
 
 bool fhir_resource_type_is_valid(FHIRResourceType type) {
@@ -252,10 +1008,8 @@ size_t fhir_resource_get_instance_size(FHIRResourceType type) {
         return 0;
     }
     
-    init_registry_if_needed();
-    
-    const FHIRResourceRegistration* reg = &g_resource_registry[type];
-    if (reg->vtable) {
+    const FHIRResourceRegistration* reg = registry_get(type);
+    if (reg && reg->vtable) {
         return reg->vtable->instance_size;
     }
     
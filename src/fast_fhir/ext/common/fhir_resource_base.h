@@ -12,6 +12,8 @@
 #define FHIR_RESOURCE_BASE_H
 
 #include "fhir_common.h"
+#include "fhir_json_writer.h"
+#include "fhir_binary.h"
 #include "../fhir_datatypes.h"
 #include <stdbool.h>
 #include <stddef.h>
@@ -72,6 +74,156 @@ typedef enum {
     FHIR_RESOURCE_TYPE_NUTRITION_PRODUCT,
     FHIR_RESOURCE_TYPE_VERIFICATION_RESULT,
     
+    // Base & Management Resources
+    FHIR_RESOURCE_TYPE_BASIC,
+    FHIR_RESOURCE_TYPE_BINARY,
+    FHIR_RESOURCE_TYPE_BUNDLE,
+    FHIR_RESOURCE_TYPE_COMPOSITION,
+    FHIR_RESOURCE_TYPE_DOCUMENT_REFERENCE,
+    FHIR_RESOURCE_TYPE_LINKAGE,
+    FHIR_RESOURCE_TYPE_LIST,
+    FHIR_RESOURCE_TYPE_MESSAGE_HEADER,
+    FHIR_RESOURCE_TYPE_OPERATION_OUTCOME,
+    FHIR_RESOURCE_TYPE_PARAMETERS,
+    FHIR_RESOURCE_TYPE_SUBSCRIPTION,
+    FHIR_RESOURCE_TYPE_SUBSCRIPTION_STATUS,
+    FHIR_RESOURCE_TYPE_SUBSCRIPTION_TOPIC,
+    
+    // Clinical Summary & Care Provision Resources
+    FHIR_RESOURCE_TYPE_ALLERGY_INTOLERANCE,
+    FHIR_RESOURCE_TYPE_ADVERSE_EVENT,
+    FHIR_RESOURCE_TYPE_BODY_STRUCTURE,
+    FHIR_RESOURCE_TYPE_CARE_PLAN,
+    FHIR_RESOURCE_TYPE_CARE_TEAM,
+    FHIR_RESOURCE_TYPE_CLINICAL_IMPRESSION,
+    FHIR_RESOURCE_TYPE_DETECTED_ISSUE,
+    FHIR_RESOURCE_TYPE_FAMILY_MEMBER_HISTORY,
+    FHIR_RESOURCE_TYPE_FLAG,
+    FHIR_RESOURCE_TYPE_GOAL,
+    FHIR_RESOURCE_TYPE_NUTRITION_INTAKE,
+    FHIR_RESOURCE_TYPE_NUTRITION_ORDER,
+    FHIR_RESOURCE_TYPE_RISK_ASSESSMENT,
+    FHIR_RESOURCE_TYPE_SERVICE_REQUEST,
+    FHIR_RESOURCE_TYPE_VISION_PRESCRIPTION,
+    
+    // Diagnostic Resources
+    FHIR_RESOURCE_TYPE_GENOMIC_STUDY,
+    FHIR_RESOURCE_TYPE_IMAGING_SELECTION,
+    FHIR_RESOURCE_TYPE_IMAGING_STUDY,
+    FHIR_RESOURCE_TYPE_MOLECULAR_SEQUENCE,
+    FHIR_RESOURCE_TYPE_QUESTIONNAIRE_RESPONSE,
+    FHIR_RESOURCE_TYPE_SPECIMEN,
+    
+    // Medication & Immunization Resources
+    FHIR_RESOURCE_TYPE_IMMUNIZATION,
+    FHIR_RESOURCE_TYPE_IMMUNIZATION_EVALUATION,
+    FHIR_RESOURCE_TYPE_IMMUNIZATION_RECOMMENDATION,
+    FHIR_RESOURCE_TYPE_MEDICATION,
+    FHIR_RESOURCE_TYPE_MEDICATION_ADMINISTRATION,
+    FHIR_RESOURCE_TYPE_MEDICATION_DISPENSE,
+    FHIR_RESOURCE_TYPE_MEDICATION_REQUEST,
+    FHIR_RESOURCE_TYPE_MEDICATION_STATEMENT,
+    
+    // Request & Response Resources
+    FHIR_RESOURCE_TYPE_COMMUNICATION,
+    FHIR_RESOURCE_TYPE_COMMUNICATION_REQUEST,
+    FHIR_RESOURCE_TYPE_DEVICE_DISPENSE,
+    FHIR_RESOURCE_TYPE_DEVICE_REQUEST,
+    FHIR_RESOURCE_TYPE_DEVICE_USAGE,
+    FHIR_RESOURCE_TYPE_GUIDANCE_RESPONSE,
+    FHIR_RESOURCE_TYPE_INVENTORY_ITEM,
+    FHIR_RESOURCE_TYPE_INVENTORY_REPORT,
+    FHIR_RESOURCE_TYPE_REQUEST_ORCHESTRATION,
+    FHIR_RESOURCE_TYPE_SUPPLY_DELIVERY,
+    FHIR_RESOURCE_TYPE_SUPPLY_REQUEST,
+    
+    // Financial Resources
+    FHIR_RESOURCE_TYPE_ACCOUNT,
+    FHIR_RESOURCE_TYPE_CHARGE_ITEM,
+    FHIR_RESOURCE_TYPE_CHARGE_ITEM_DEFINITION,
+    FHIR_RESOURCE_TYPE_CLAIM,
+    FHIR_RESOURCE_TYPE_CLAIM_RESPONSE,
+    FHIR_RESOURCE_TYPE_CONTRACT,
+    FHIR_RESOURCE_TYPE_COVERAGE,
+    FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_REQUEST,
+    FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_RESPONSE,
+    FHIR_RESOURCE_TYPE_ENROLLMENT_REQUEST,
+    FHIR_RESOURCE_TYPE_ENROLLMENT_RESPONSE,
+    FHIR_RESOURCE_TYPE_EXPLANATION_OF_BENEFIT,
+    FHIR_RESOURCE_TYPE_INSURANCE_PLAN,
+    FHIR_RESOURCE_TYPE_INVOICE,
+    FHIR_RESOURCE_TYPE_PAYMENT_NOTICE,
+    FHIR_RESOURCE_TYPE_PAYMENT_RECONCILIATION,
+    
+    // Security Resources
+    FHIR_RESOURCE_TYPE_AUDIT_EVENT,
+    FHIR_RESOURCE_TYPE_CONSENT,
+    FHIR_RESOURCE_TYPE_PERMISSION,
+    FHIR_RESOURCE_TYPE_PROVENANCE,
+    
+    // Conformance & Terminology Resources
+    FHIR_RESOURCE_TYPE_ACTOR_DEFINITION,
+    FHIR_RESOURCE_TYPE_CAPABILITY_STATEMENT,
+    FHIR_RESOURCE_TYPE_CODE_SYSTEM,
+    FHIR_RESOURCE_TYPE_COMPARTMENT_DEFINITION,
+    FHIR_RESOURCE_TYPE_CONCEPT_MAP,
+    FHIR_RESOURCE_TYPE_EXAMPLE_SCENARIO,
+    FHIR_RESOURCE_TYPE_GRAPH_DEFINITION,
+    FHIR_RESOURCE_TYPE_IMPLEMENTATION_GUIDE,
+    FHIR_RESOURCE_TYPE_MESSAGE_DEFINITION,
+    FHIR_RESOURCE_TYPE_NAMING_SYSTEM,
+    FHIR_RESOURCE_TYPE_OPERATION_DEFINITION,
+    FHIR_RESOURCE_TYPE_REQUIREMENTS,
+    FHIR_RESOURCE_TYPE_SEARCH_PARAMETER,
+    FHIR_RESOURCE_TYPE_STRUCTURE_DEFINITION,
+    FHIR_RESOURCE_TYPE_STRUCTURE_MAP,
+    FHIR_RESOURCE_TYPE_TERMINOLOGY_CAPABILITIES,
+    FHIR_RESOURCE_TYPE_TEST_PLAN,
+    FHIR_RESOURCE_TYPE_TEST_REPORT,
+    FHIR_RESOURCE_TYPE_TEST_SCRIPT,
+    FHIR_RESOURCE_TYPE_VALUE_SET,
+    
+    // Definitional & Quality Resources
+    FHIR_RESOURCE_TYPE_ACTIVITY_DEFINITION,
+    FHIR_RESOURCE_TYPE_CONDITION_DEFINITION,
+    FHIR_RESOURCE_TYPE_DEVICE_DEFINITION,
+    FHIR_RESOURCE_TYPE_EVENT_DEFINITION,
+    FHIR_RESOURCE_TYPE_LIBRARY,
+    FHIR_RESOURCE_TYPE_MEASURE,
+    FHIR_RESOURCE_TYPE_MEASURE_REPORT,
+    FHIR_RESOURCE_TYPE_OBSERVATION_DEFINITION,
+    FHIR_RESOURCE_TYPE_PLAN_DEFINITION,
+    FHIR_RESOURCE_TYPE_QUESTIONNAIRE,
+    FHIR_RESOURCE_TYPE_SPECIMEN_DEFINITION,
+    
+    // Evidence-Based Medicine & Research Resources
+    FHIR_RESOURCE_TYPE_ARTIFACT_ASSESSMENT,
+    FHIR_RESOURCE_TYPE_CITATION,
+    FHIR_RESOURCE_TYPE_EVIDENCE,
+    FHIR_RESOURCE_TYPE_EVIDENCE_REPORT,
+    FHIR_RESOURCE_TYPE_EVIDENCE_VARIABLE,
+    FHIR_RESOURCE_TYPE_RESEARCH_STUDY,
+    FHIR_RESOURCE_TYPE_RESEARCH_SUBJECT,
+    
+    // Medication Definition & Substance Resources
+    FHIR_RESOURCE_TYPE_ADMINISTRABLE_PRODUCT_DEFINITION,
+    FHIR_RESOURCE_TYPE_BIOLOGICALLY_DERIVED_PRODUCT_DISPENSE,
+    FHIR_RESOURCE_TYPE_CLINICAL_USE_DEFINITION,
+    FHIR_RESOURCE_TYPE_FORMULARY_ITEM,
+    FHIR_RESOURCE_TYPE_INGREDIENT,
+    FHIR_RESOURCE_TYPE_MANUFACTURED_ITEM_DEFINITION,
+    FHIR_RESOURCE_TYPE_MEDICATION_KNOWLEDGE,
+    FHIR_RESOURCE_TYPE_MEDICINAL_PRODUCT_DEFINITION,
+    FHIR_RESOURCE_TYPE_PACKAGED_PRODUCT_DEFINITION,
+    FHIR_RESOURCE_TYPE_REGULATED_AUTHORIZATION,
+    FHIR_RESOURCE_TYPE_SUBSTANCE,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_DEFINITION,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_NUCLEIC_ACID,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_POLYMER,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_PROTEIN,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_REFERENCE_INFORMATION,
+    FHIR_RESOURCE_TYPE_SUBSTANCE_SOURCE_MATERIAL,
+    
     FHIR_RESOURCE_TYPE_COUNT
 } FHIRResourceType;
 
@@ -84,15 +236,18 @@ typedef enum {
  * 
  * This structure implements polymorphism in C by providing function pointers
  * for virtual methods that can be overridden by derived resource types.
- */struct F
-HIRResourceVTable {
+ */
+struct FHIRResourceVTable {
     // Resource lifecycle methods
     void (*destroy)(FHIRResourceBase* self);
     FHIRResourceBase* (*clone)(const FHIRResourceBase* self);
     
     // Serialization methods
     cJSON* (*to_json)(const FHIRResourceBase* self);
+    bool (*write_json)(const FHIRResourceBase* self, FHIRWriter* writer);  // NULL falls back to to_json
     bool (*from_json)(FHIRResourceBase* self, const cJSON* json);
+    bool (*to_binary)(const FHIRResourceBase* self, FHIRBinaryWriter* writer);        // NULL stores the to_json tree
+    bool (*from_binary)(FHIRResourceBase* self, const FHIRBinaryDocument* document);  // Reads to_binary output
     
     // Validation methods
     bool (*validate)(const FHIRResourceBase* self);
@@ -101,6 +256,7 @@ HIRResourceVTable {
     // Comparison methods
     bool (*equals)(const FHIRResourceBase* self, const FHIRResourceBase* other);
     int (*compare)(const FHIRResourceBase* self, const FHIRResourceBase* other);
+    uint64_t (*hash)(const FHIRResourceBase* self);     // NULL hashes the write_json output
     
     // String representation
     char* (*to_string)(const FHIRResourceBase* self);
@@ -108,17 +264,78 @@ HIRResourceVTable {
     // Resource-specific methods (can be NULL if not applicable)
     bool (*is_active)(const FHIRResourceBase* self);
     const char* (*get_display_name)(const FHIRResourceBase* self);
+    uint32_t (*member_dirty_fields)(const char* member);    // Dirty bits a JSON member feeds; NULL = all
     
     // Type information
     const char* resource_type_name;
     FHIRResourceType resource_type;
     size_t instance_size;
+    FHIRObjectPool* pool;       // Free list of instance_size objects; NULL allocates directly
 };
 
 /* ========================================================================== */
 /* Base Resource Structure                                                    */
 /* ========================================================================== */
 
+/**
+ * @brief States of the lazily filled validation cache
+ */
+typedef enum {
+    FHIR_VALIDATION_CACHE_EMPTY = 0,
+    FHIR_VALIDATION_CACHE_BUSY,      /**< One thread is publishing its result */
+    FHIR_VALIDATION_CACHE_READY,
+    FHIR_VALIDATION_CACHE_STALE      /**< Cached, but the fields in validation_dirty changed since */
+} FHIRValidationCacheState;
+
+/**
+ * @brief States of a resource's copy-on-write sharing
+ */
+typedef enum {
+    FHIR_SHARE_STATE_PRIVATE = 0,   /**< Some non-empty shareable array is privately owned */
+    FHIR_SHARE_STATE_CONVERTING,    /**< One thread is moving arrays into shared blocks */
+    FHIR_SHARE_STATE_SHARED         /**< Every non-empty shareable array is shared */
+} FHIRShareState;
+
+/**
+ * @brief Reference-counted pointer array shared by copy-on-write clones
+ *
+ * Owns the pointer array and the elements it points to. Every resource that
+ * aliases the array holds one reference; the last release frees it.
+ */
+typedef struct FHIRSharedArray {
+    FHIRAtomicInt ref_count;
+    void** items;
+    size_t count;
+} FHIRSharedArray;
+
+/**
+ * @brief Describes one shareable pointer-array field of a resource structure
+ *
+ * Offsets are relative to the start of the resource, which is also the
+ * address of its FHIRResourceBase.
+ */
+typedef struct {
+    size_t items_offset;    /**< Offset of the T** field */
+    size_t count_offset;    /**< Offset of its size_t count */
+    size_t share_offset;    /**< Offset of the FHIRSharedArray* slot (NULL = private) */
+    size_t element_size;    /**< sizeof(T), for detaching copies */
+    void* (*copy_element)(const void* element);  /**< Detaching copy (NULL = copy element_size bytes) */
+} FHIRSharedField;
+
+/**
+ * @brief Build an FHIRSharedField for array field "field" with count "field_count"
+ */
+#define FHIR_SHARED_FIELD(StructType, field, ElementType, share_slot) \
+    { offsetof(StructType, field), offsetof(StructType, field##_count), \
+      offsetof(StructType, share_slot), sizeof(ElementType), NULL }
+
+/**
+ * @brief As FHIR_SHARED_FIELD, for elements that own memory beyond sizeof(T)
+ */
+#define FHIR_SHARED_FIELD_WITH_COPY(StructType, field, ElementType, share_slot, copy) \
+    { offsetof(StructType, field), offsetof(StructType, field##_count), \
+      offsetof(StructType, share_slot), sizeof(ElementType), copy }
+
 /**
  * @brief Base structure for all FHIR resources
  * 
@@ -129,8 +346,9 @@ struct FHIRResourceBase {
     // Virtual function table (must be first for polymorphism)
     const FHIRResourceVTable* vtable;
     
-    // Reference counting for memory management
-    int ref_count;
+    // Reference counting for memory management (atomic, so resources can be shared across threads)
+    FHIRAtomicInt ref_count;
+    FHIRArena* arena;   // Owning arena, NULL for heap-allocated resources
     
     // Base FHIR Resource fields
     char* id;
@@ -140,7 +358,7 @@ struct FHIRResourceBase {
     
     // DomainResource fields (most resources inherit from DomainResource)
     FHIRNarrative* text;
-    FHIRResource** contained;
+    FHIRResourceBase** contained;
     size_t contained_count;
     FHIRExtension** extension;
     size_t extension_count;
@@ -151,11 +369,27 @@ struct FHIRResourceBase {
     bool is_domain_resource;
     FHIRResourceType resource_type;
     
-    // Validation cache
-    bool validation_cached;
+    // Validation cache, filled at most once even by concurrent validate calls
+    FHIRAtomicInt validation_state;   // FHIRValidationCacheState
     bool validation_result;
+    bool validation_incremental;      // Result came from fhir_resource_validate_rules
     char** validation_errors;
     size_t validation_error_count;
+    FHIRAtomicInt validation_dirty;    // Dirty field bits since the cached result
+    FHIRAtomicInt validation_failures; // One bit per failed rule of the cached result
+    
+    // Structural hash cache, with the validation cache's EMPTY/BUSY/READY states
+    FHIRAtomicInt hash_state;
+    uint64_t hash_value;
+    
+    // JSON members from_json did not recognize (e.g. "_birthDate" primitive extensions)
+    char** unknown_members;
+    size_t unknown_member_count;
+    
+    // Copy-on-write state: extension arrays shared with clones (NULL = privately owned)
+    FHIRAtomicInt share_state;        // FHIRShareState
+    FHIRSharedArray* shared_extension;
+    FHIRSharedArray* shared_modifier_extension;
 };
 
 /* ========================================================================== */
@@ -179,8 +413,16 @@ typedef struct {
 
 /**
  * @brief Register a resource type
+ *
+ * Thread-safe. Registering a type again with the same vtable and factory
+ * (as each interpreter importing an extension module does) succeeds.
+ *
+ * The registry belongs to the copy of fhir_resource_base.c it is called
+ * in: each Python extension module links its own, so a module registers
+ * the types it creates from its own exec, whatever other modules did.
+ *
  * @param registration Resource registration information
- * @return true on success, false on failure
+ * @return true on success, false on failure (another registration exists for the type)
  */
 bool fhir_resource_register_type(const FHIRResourceRegistration* registration);
 
@@ -198,8 +440,21 @@ FHIRResourceBase* fhir_resource_create_by_name(const char* type_name, const char
  * @param id Resource ID
  * @return New resource instance or NULL on failure
  */
-FHIRResourceBase* fhir_resource_create_by_type(FHIRResourceType type, const char* id);/*
- ========================================================================== */
+FHIRResourceBase* fhir_resource_create_by_type(FHIRResourceType type, const char* id);
+
+/**
+ * @brief Create and load a resource of any registered type inside an arena
+ *
+ * The resource and everything it owns are allocated from the arena and are
+ * freed by fhir_arena_reset/destroy; fhir_resource_release never frees them.
+ *
+ * @param arena Arena to allocate from
+ * @param json JSON object with resourceType and id
+ * @return New resource or NULL on failure
+ */
+FHIRResourceBase* fhir_resource_parse_with_arena(FHIRArena* arena, const cJSON* json);
+
+/* ========================================================================== */
 /* Base Resource Methods (OOP Interface)                                     */
 /* ========================================================================== */
 
@@ -220,8 +475,175 @@ bool fhir_resource_base_init(FHIRResourceBase* self, const FHIRResourceVTable* v
  */
 void fhir_resource_base_cleanup(FHIRResourceBase* self);
 
+/**
+ * @brief Allocate a zeroed resource struct from its type's object pool
+ * @param vtable Virtual function table of the type
+ * @return vtable->instance_size zeroed bytes or NULL on failure
+ */
+void* fhir_resource_alloc(const FHIRResourceVTable* vtable);
+
+/**
+ * @brief Return a resource struct to its type's object pool
+ *
+ * The last step of a derived destructor, after fhir_resource_base_cleanup.
+ *
+ * @param vtable Virtual function table of the type
+ * @param instance Struct from fhir_resource_alloc (can be NULL)
+ */
+void fhir_resource_free(const FHIRResourceVTable* vtable, void* instance);
+
+/**
+ * @brief Record the name of a JSON member that from_json did not recognize
+ * @param self Resource instance
+ * @param name Member name (copied)
+ * @return true on success, false on failure
+ */
+bool fhir_resource_add_unknown_member(FHIRResourceBase* self, const char* name);
+
+/**
+ * @brief Read the cached validation result
+ *
+ * Safe to call concurrently on a shared const resource.
+ *
+ * @param self Resource instance
+ * @param result Output for the cached result
+ * @return true if a result is cached, false otherwise
+ */
+bool fhir_resource_get_cached_validation(const FHIRResourceBase* self, bool* result);
+
+/**
+ * @brief Publish a validation result into the cache of a (possibly shared) resource
+ *
+ * The first caller's result and errors are stored; later or concurrent
+ * callers have their errors freed and get the stored result back, so all
+ * threads observe the same cache contents.
+ *
+ * @param self Resource instance
+ * @param result Validation result
+ * @param errors Validation error messages (ownership is taken, can be NULL)
+ * @param error_count Number of error messages
+ * @return The cached validation result
+ */
+bool fhir_resource_cache_validation(const FHIRResourceBase* self, bool result,
+                                    char** errors, size_t error_count);
+
+/**
+ * @brief Drop the cached validation result after the resource was modified
+ *
+ * Also drops the cached structural hash. Modifying a resource requires
+ * exclusive access, so this must not run concurrently with readers of the
+ * cache.
+ *
+ * @param self Resource instance
+ */
+void fhir_resource_invalidate_validation(FHIRResourceBase* self);
+
+/** Maximum rules in one validation table (one failure bit each) */
+#define FHIR_VALIDATION_RULE_MAX 32
+
+/** Dirty mask covering every field */
+#define FHIR_DIRTY_ALL 0xFFFFFFFFu
+
+/**
+ * @brief One constraint of a resource type's validation table
+ *
+ * fields names the resource's dirty bits the check reads; after a setter
+ * marks some fields dirty, only the rules that read them are rerun.
+ */
+typedef struct {
+    uint32_t fields;                                /**< Dirty bits the rule depends on */
+    bool (*check)(const FHIRResourceBase* self);    /**< Returns true if the rule holds */
+    const char* message;                            /**< Error reported when it does not */
+} FHIRValidationRule;
+
+/**
+ * @brief Record that fields changed after the resource was validated
+ *
+ * A result cached by fhir_resource_validate_rules is kept together with the
+ * dirty bits, so the next validation reruns only the rules that read them.
+ * Other cached results are dropped as by fhir_resource_invalidate_validation,
+ * and so is the cached structural hash. Same exclusive-access requirement as
+ * fhir_resource_invalidate_validation.
+ *
+ * @param self Resource instance
+ * @param fields Dirty bits of the changed fields (FHIR_DIRTY_ALL if unknown)
+ */
+void fhir_resource_mark_dirty(FHIRResourceBase* self, uint32_t fields);
+
+/**
+ * @brief Validate a resource against a rule table, reusing the cached result
+ *
+ * Without a cached result every rule runs. With a stale one only the rules
+ * whose fields are dirty run; the others keep their cached outcome. Errors
+ * are the messages of the failed rules in table order. Safe to call
+ * concurrently on a shared const resource, like fhir_resource_cache_validation.
+ *
+ * @param self Resource instance
+ * @param rules Rule table of the resource type
+ * @param rule_count Number of rules (at most FHIR_VALIDATION_RULE_MAX)
+ * @return true if every rule holds
+ */
+bool fhir_resource_validate_rules(const FHIRResourceBase* self, const FHIRValidationRule* rules,
+                                  size_t rule_count);
+
+/**
+ * @brief Dirty bits of the fields loaded from a top-level JSON member
+ * @param vtable Resource type's vtable
+ * @param member JSON member name
+ * @return The type's mapping, or FHIR_DIRTY_ALL if it has none
+ */
+uint32_t fhir_resource_member_dirty_fields(const FHIRResourceVTable* vtable, const char* member);
+
+/**
+ * @brief Carry an incremental validation result over to a modified copy
+ *
+ * For a copy rebuilt from the source's JSON with some members changed: if
+ * the source holds a result from fhir_resource_validate_rules, the copy
+ * takes its rule outcomes as a stale result with the given fields dirty,
+ * so validating the copy reruns only the affected rules. Otherwise the
+ * copy's cache is left as is. The copy must not be shared yet.
+ *
+ * @param target Freshly loaded copy
+ * @param source Resource the copy was derived from
+ * @param fields Dirty bits of the changed fields
+ */
+void fhir_resource_inherit_validation(FHIRResourceBase* target, const FHIRResourceBase* source,
+                                      uint32_t fields);
+
+/* ========================================================================== */
+/* Structural Hashing                                                         */
+/* ========================================================================== */
+
+/**
+ * @brief Get the structural hash of a resource, computing it on first use
+ *
+ * Types with a hash method hash their fields in a fixed order; equal
+ * resources (per their equals method) must hash alike, which lets equals
+ * reject on differing cached hashes. Other types hash their write_json
+ * output in canonical JSON, streamed into the hasher, so member order does
+ * not matter. The hash is cached and
+ * dropped by fhir_resource_mark_dirty and fhir_resource_invalidate_validation.
+ * Safe to call concurrently on a shared const resource.
+ *
+ * @param self Resource instance
+ * @return 64-bit hash (0 for NULL or if serialization fails)
+ */
+uint64_t fhir_resource_hash(const FHIRResourceBase* self);
+
+/**
+ * @brief Read the cached structural hash without computing it
+ * @param self Resource instance
+ * @param hash Output for the cached hash
+ * @return true if a hash is cached
+ */
+bool fhir_resource_get_cached_hash(const FHIRResourceBase* self, uint64_t* hash);
+
 /**
  * @brief Add reference to resource (reference counting)
+ *
+ * The count is atomic, so threads sharing a resource may retain and release
+ * it concurrently. The resource itself must be treated as read-only while shared.
+ *
  * @param self Resource instance
  * @return Resource instance (for chaining)
  */
@@ -229,6 +651,10 @@ FHIRResourceBase* fhir_resource_retain(FHIRResourceBase* self);
 
 /**
  * @brief Remove reference from resource (reference counting)
+ *
+ * Arena-owned resources are not destroyed when the count reaches zero;
+ * their memory is reclaimed when the arena is reset or destroyed.
+ *
  * @param self Resource instance
  */
 void fhir_resource_release(FHIRResourceBase* self);
@@ -240,6 +666,63 @@ void fhir_resource_release(FHIRResourceBase* self);
  */
 int fhir_resource_get_ref_count(const FHIRResourceBase* self);
 
+/* ========================================================================== */
+/* Copy-on-Write Sharing                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Make a clone alias the source's pointer arrays instead of copying them
+ *
+ * The base extension arrays and the given resource-specific fields are
+ * moved into reference-counted FHIRSharedArray blocks on first use (the
+ * source stays logically unchanged, and concurrent clones of one source are
+ * safe). The clone then points at the same arrays and holds a reference to
+ * each block. Only heap resources can share: fails with
+ * FHIR_ERROR_INVALID_ARGUMENT if either resource is arena-owned.
+ *
+ * @param source Resource being cloned
+ * @param clone Freshly created clone whose shareable arrays are still empty
+ * @param fields Resource-specific shareable fields
+ * @param field_count Number of entries in fields
+ * @return true on success, false on failure
+ */
+bool fhir_resource_share_fields(const FHIRResourceBase* source, FHIRResourceBase* clone,
+                                const FHIRSharedField* fields, size_t field_count);
+
+/**
+ * @brief Give a resource its own copy of a field before modifying it
+ *
+ * Must be called by every modifier of a shareable field, shared or not, so
+ * the next clone knows to share the field again. A block referenced only by
+ * this resource is taken back without copying; otherwise the pointer array
+ * and its elements are copied.
+ *
+ * @param self Resource about to modify the field
+ * @param field Field descriptor
+ * @return true on success, false on allocation failure
+ */
+bool fhir_resource_detach_field(FHIRResourceBase* self, const FHIRSharedField* field);
+
+/**
+ * @brief Give a resource its own copy of its extension and modifierExtension arrays
+ * @param self Resource about to modify its extensions
+ * @return true on success, false on allocation failure
+ */
+bool fhir_resource_detach_extensions(FHIRResourceBase* self);
+
+/**
+ * @brief Drop a resource's references to shared fields (called by derived destructors)
+ *
+ * Shared fields are reset to empty, so the destructor's own cleanup skips
+ * them. The base extension arrays are handled by fhir_resource_base_cleanup.
+ *
+ * @param self Resource being destroyed
+ * @param fields Resource-specific shareable fields
+ * @param field_count Number of entries in fields
+ */
+void fhir_resource_release_shared_fields(FHIRResourceBase* self, const FHIRSharedField* fields,
+                                         size_t field_count);
+
 /* ========================================================================== */
 /* Polymorphic Method Calls (Virtual Method Dispatch)                       */
 /* ========================================================================== */
@@ -261,7 +744,10 @@ static inline void fhir_resource_destroy(FHIRResourceBase* self) {
  */
 static inline FHIRResourceBase* fhir_resource_clone(const FHIRResourceBase* self) {
     if (self && self->vtable && self->vtable->clone) {
-        return self->vtable->clone(self);
+        int previous_type = fhir_memory_set_type(self->resource_type);
+        FHIRResourceBase* clone = self->vtable->clone(self);
+        fhir_memory_set_type(previous_type);
+        return clone;
     }
     return NULL;
 }
@@ -278,6 +764,43 @@ static inline cJSON* fhir_resource_to_json(const FHIRResourceBase* self) {
     return NULL;
 }
 
+/**
+ * @brief Stream resource as compact JSON (calls virtual method)
+ *
+ * Resources without a write_json method are converted with to_json and the
+ * resulting tree is streamed without being printed to a string first. A
+ * canonical writer (fhir_writer_set_canonical) yields canonical JSON either way.
+ *
+ * @param self Resource instance
+ * @param writer Destination writer
+ * @return true on success, false on failure
+ */
+bool fhir_resource_write_json(const FHIRResourceBase* self, FHIRWriter* writer);
+
+/**
+ * @brief Encode resource in the compact binary format (calls virtual method)
+ *
+ * Resources without a to_binary method are stored as their to_json tree
+ * (FHIR_BINARY_FLAG_JSON).
+ *
+ * @param self Resource instance
+ * @param length Output document length
+ * @return Document (caller must fhir_free) or NULL on failure
+ */
+uint8_t* fhir_resource_to_binary(const FHIRResourceBase* self, size_t* length);
+
+/**
+ * @brief Decode a resource from the compact binary format
+ *
+ * Creates a resource of the registered type named in the header; its
+ * strings are copied, so the buffer may be released afterwards.
+ *
+ * @param data Document, e.g. read from a cache or an mmap'ed file
+ * @param length Bytes available in data
+ * @return New resource (caller must release) or NULL on failure
+ */
+FHIRResourceBase* fhir_resource_from_binary(const void* data, size_t length);
+
 /**
  * @brief Load resource from JSON (calls virtual method)
  * @param self Resource instance
@@ -286,7 +809,13 @@ static inline cJSON* fhir_resource_to_json(const FHIRResourceBase* self) {
  */
 static inline bool fhir_resource_from_json(FHIRResourceBase* self, const cJSON* json) {
     if (self && self->vtable && self->vtable->from_json) {
-        return self->vtable->from_json(self, json);
+        FHIRPerfSpan span;
+        fhir_perf_begin(&span, FHIR_PERF_PHASE_DESERIALIZE, self->resource_type);
+        int previous_type = fhir_memory_set_type(self->resource_type);
+        bool loaded = self->vtable->from_json(self, json);
+        fhir_memory_set_type(previous_type);
+        fhir_perf_end(&span, 0, loaded);
+        return loaded;
     }
     return false;
 }
@@ -298,12 +827,17 @@ static inline bool fhir_resource_from_json(FHIRResourceBase* self, const cJSON*
  */
 static inline bool fhir_resource_validate(const FHIRResourceBase* self) {
     if (self && self->vtable && self->vtable->validate) {
-        return self->vtable->validate(self);
+        FHIRPerfSpan span;
+        fhir_perf_begin(&span, FHIR_PERF_PHASE_VALIDATE, self->resource_type);
+        bool valid = self->vtable->validate(self);
+        fhir_perf_end(&span, 0, valid);
+        return valid;
     }
     return false;
-}/**
- * @b
-rief Check if resource is active (calls virtual method)
+}
+
+/**
+ * @brief Check if resource is active (calls virtual method)
  * @param self Resource instance
  * @return true if active, false otherwise
  */
@@ -357,6 +891,14 @@ const char* fhir_resource_type_to_string(FHIRResourceType type);
  */
 FHIRResourceType fhir_resource_type_from_string(const char* name);
 
+/**
+ * @brief Get resource type from a name of known length
+ * @param name Type name, not necessarily NUL-terminated
+ * @param length Length of name in bytes
+ * @return Resource type or FHIR_RESOURCE_TYPE_UNKNOWN
+ */
+FHIRResourceType fhir_resource_type_from_string_n(const char* name, size_t length);
+
 /**
  * @brief Check if resource type is valid
  * @param type Resource type
@@ -376,31 +918,75 @@ size_t fhir_resource_get_instance_size(FHIRResourceType type);
 /* ========================================================================== */
 
 /**
- * @brief Macro to define a resource structure with proper inheritance
+ * @brief Macro to open a resource structure with proper inheritance
+ * 
+ * Resource-specific fields follow the macro and the structure is closed with
+ * "};" by the caller.
  */
 #define FHIR_RESOURCE_DEFINE(ResourceName) \
-    typedef struct FHIR##ResourceName { \
-        FHIRResourceBase base; \
-        /* Resource-specific fields follow */ \
-    } FHIR##ResourceName;
+    typedef struct FHIR##ResourceName FHIR##ResourceName; \
+    struct FHIR##ResourceName { \
+        FHIRResourceBase base;
+
+/**
+ * @brief Vtable entries shared by the FHIR_RESOURCE_VTABLE_INIT macros
+ */
+#define FHIR_RESOURCE_VTABLE_ENTRIES(ResourceName, method_prefix, TYPE_NAME) \
+        .destroy = (void (*)(FHIRResourceBase*))fhir_##method_prefix##_destroy, \
+        .clone = (FHIRResourceBase* (*)(const FHIRResourceBase*))fhir_##method_prefix##_clone, \
+        .to_json = (cJSON* (*)(const FHIRResourceBase*))fhir_##method_prefix##_to_json, \
+        .from_json = (bool (*)(FHIRResourceBase*, const cJSON*))fhir_##method_prefix##_from_json, \
+        .validate = (bool (*)(const FHIRResourceBase*))fhir_##method_prefix##_validate, \
+        .equals = (bool (*)(const FHIRResourceBase*, const FHIRResourceBase*))fhir_##method_prefix##_equals, \
+        .to_string = (char* (*)(const FHIRResourceBase*))fhir_##method_prefix##_to_string, \
+        .is_active = (bool (*)(const FHIRResourceBase*))fhir_##method_prefix##_is_active, \
+        .get_display_name = (const char* (*)(const FHIRResourceBase*))fhir_##method_prefix##_get_display_name, \
+        .resource_type_name = #ResourceName, \
+        .resource_type = FHIR_RESOURCE_TYPE_##TYPE_NAME, \
+        .instance_size = sizeof(FHIR##ResourceName), \
+        .pool = &ResourceName##_pool
+
+/**
+ * @brief Object pool behind a resource vtable, declared ahead of it
+ */
+#define FHIR_RESOURCE_POOL_DEFINE(ResourceName) \
+    static FHIRObjectPool ResourceName##_pool = FHIR_OBJECT_POOL_INIT(#ResourceName, FHIR##ResourceName);
 
 /**
  * @brief Macro to implement virtual method dispatch
  */
-#define FHIR_RESOURCE_VTABLE_INIT(ResourceName, resource_type) \
+#define FHIR_RESOURCE_VTABLE_INIT(ResourceName, method_prefix, TYPE_NAME) \
+    FHIR_RESOURCE_POOL_DEFINE(ResourceName) \
     static const FHIRResourceVTable ResourceName##_vtable = { \
-        .destroy = (void (*)(FHIRResourceBase*))fhir_##resource_type##_destroy, \
-        .clone = (FHIRResourceBase* (*)(const FHIRResourceBase*))fhir_##resource_type##_clone, \
-        .to_json = (cJSON* (*)(const FHIRResourceBase*))fhir_##resource_type##_to_json, \
-        .from_json = (bool (*)(FHIRResourceBase*, const cJSON*))fhir_##resource_type##_from_json, \
-        .validate = (bool (*)(const FHIRResourceBase*))fhir_##resource_type##_validate, \
-        .equals = (bool (*)(const FHIRResourceBase*, const FHIRResourceBase*))fhir_##resource_type##_equals, \
-        .to_string = (char* (*)(const FHIRResourceBase*))fhir_##resource_type##_to_string, \
-        .is_active = (bool (*)(const FHIRResourceBase*))fhir_##resource_type##_is_active, \
-        .get_display_name = (const char* (*)(const FHIRResourceBase*))fhir_##resource_type##_get_display_name, \
-        .resource_type_name = #ResourceName, \
-        .resource_type = FHIR_RESOURCE_TYPE_##ResourceName, \
-        .instance_size = sizeof(FHIR##ResourceName) \
+        FHIR_RESOURCE_VTABLE_ENTRIES(ResourceName, method_prefix, TYPE_NAME) \
+    };
+
+/**
+ * @brief Macro to implement virtual method dispatch for resources with a
+ * streaming fhir_<prefix>_write_json serializer
+ */
+#define FHIR_RESOURCE_VTABLE_INIT_WITH_WRITER(ResourceName, method_prefix, TYPE_NAME) \
+    FHIR_RESOURCE_POOL_DEFINE(ResourceName) \
+    static const FHIRResourceVTable ResourceName##_vtable = { \
+        FHIR_RESOURCE_VTABLE_ENTRIES(ResourceName, method_prefix, TYPE_NAME), \
+        .write_json = (bool (*)(const FHIRResourceBase*, FHIRWriter*))fhir_##method_prefix##_write_json \
+    };
+
+/**
+ * @brief Macro to implement virtual method dispatch for resources with a
+ * streaming writer, fhir_<prefix>_to_binary/from_binary codecs, a
+ * fhir_<prefix>_hash structural hash and a fhir_<prefix>_member_dirty_fields
+ * member-to-dirty-bit mapping
+ */
+#define FHIR_RESOURCE_VTABLE_INIT_WITH_BINARY(ResourceName, method_prefix, TYPE_NAME) \
+    FHIR_RESOURCE_POOL_DEFINE(ResourceName) \
+    static const FHIRResourceVTable ResourceName##_vtable = { \
+        FHIR_RESOURCE_VTABLE_ENTRIES(ResourceName, method_prefix, TYPE_NAME), \
+        .write_json = (bool (*)(const FHIRResourceBase*, FHIRWriter*))fhir_##method_prefix##_write_json, \
+        .to_binary = (bool (*)(const FHIRResourceBase*, FHIRBinaryWriter*))fhir_##method_prefix##_to_binary, \
+        .from_binary = (bool (*)(FHIRResourceBase*, const FHIRBinaryDocument*))fhir_##method_prefix##_from_binary, \
+        .hash = (uint64_t (*)(const FHIRResourceBase*))fhir_##method_prefix##_hash, \
+        .member_dirty_fields = fhir_##method_prefix##_member_dirty_fields \
     };
 
 #ifdef __cplusplus
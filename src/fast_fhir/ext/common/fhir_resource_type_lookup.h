@@ -0,0 +1,569 @@
+/**
+ * @file fhir_resource_type_lookup.h
+ * @brief Resource type name to FHIRResourceType lookup for all FHIR R5 resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ * 
+ * Generated by scripts/generate_resources.py --resource-types; do not edit.
+ * 
+ * Replaces a strcmp against every registered name with a switch on the name
+ * length and one distinguishing character, confirmed by a single memcmp.
+ */
+
+#ifndef FHIR_RESOURCE_TYPE_LOOKUP_H
+#define FHIR_RESOURCE_TYPE_LOOKUP_H
+
+#include "fhir_resource_base.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map a resource type name to its FHIRResourceType (case-sensitive)
+ * @param key Type name, not necessarily NUL-terminated
+ * @param length Length of key in bytes
+ * @return Resource type or FHIR_RESOURCE_TYPE_UNKNOWN
+ */
+static inline FHIRResourceType fhir_resource_type_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 4:
+            switch (key[0]) {
+                case 'F':
+                    if (memcmp(key, "Flag", 4) == 0) return FHIR_RESOURCE_TYPE_FLAG;
+                    break;
+                case 'G':
+                    if (memcmp(key, "Goal", 4) == 0) return FHIR_RESOURCE_TYPE_GOAL;
+                    break;
+                case 'L':
+                    if (memcmp(key, "List", 4) == 0) return FHIR_RESOURCE_TYPE_LIST;
+                    break;
+                case 'S':
+                    if (memcmp(key, "Slot", 4) == 0) return FHIR_RESOURCE_TYPE_SLOT;
+                    break;
+                case 'T':
+                    if (memcmp(key, "Task", 4) == 0) return FHIR_RESOURCE_TYPE_TASK;
+                    break;
+            }
+            break;
+        case 5:
+            switch (key[0]) {
+                case 'B':
+                    if (memcmp(key, "Basic", 5) == 0) return FHIR_RESOURCE_TYPE_BASIC;
+                    break;
+                case 'C':
+                    if (memcmp(key, "Claim", 5) == 0) return FHIR_RESOURCE_TYPE_CLAIM;
+                    break;
+                case 'G':
+                    if (memcmp(key, "Group", 5) == 0) return FHIR_RESOURCE_TYPE_GROUP;
+                    break;
+            }
+            break;
+        case 6:
+            switch (key[3]) {
+                case 'a':
+                    if (memcmp(key, "Binary", 6) == 0) return FHIR_RESOURCE_TYPE_BINARY;
+                    break;
+                case 'd':
+                    if (memcmp(key, "Bundle", 6) == 0) return FHIR_RESOURCE_TYPE_BUNDLE;
+                    break;
+                case 'i':
+                    if (memcmp(key, "Device", 6) == 0) return FHIR_RESOURCE_TYPE_DEVICE;
+                    break;
+                case 's':
+                    if (memcmp(key, "Person", 6) == 0) return FHIR_RESOURCE_TYPE_PERSON;
+                    break;
+            }
+            break;
+        case 7:
+            switch (key[0]) {
+                case 'A':
+                    if (memcmp(key, "Account", 7) == 0) return FHIR_RESOURCE_TYPE_ACCOUNT;
+                    break;
+                case 'C':
+                    if (memcmp(key, "Consent", 7) == 0) return FHIR_RESOURCE_TYPE_CONSENT;
+                    break;
+                case 'I':
+                    if (memcmp(key, "Invoice", 7) == 0) return FHIR_RESOURCE_TYPE_INVOICE;
+                    break;
+                case 'L':
+                    if (memcmp(key, "Library", 7) == 0) return FHIR_RESOURCE_TYPE_LIBRARY;
+                    if (memcmp(key, "Linkage", 7) == 0) return FHIR_RESOURCE_TYPE_LINKAGE;
+                    break;
+                case 'M':
+                    if (memcmp(key, "Measure", 7) == 0) return FHIR_RESOURCE_TYPE_MEASURE;
+                    break;
+                case 'P':
+                    if (memcmp(key, "Patient", 7) == 0) return FHIR_RESOURCE_TYPE_PATIENT;
+                    break;
+            }
+            break;
+        case 8:
+            switch (key[2]) {
+                case 'c':
+                    if (memcmp(key, "Location", 8) == 0) return FHIR_RESOURCE_TYPE_LOCATION;
+                    break;
+                case 'd':
+                    if (memcmp(key, "Endpoint", 8) == 0) return FHIR_RESOURCE_TYPE_ENDPOINT;
+                    break;
+                case 'e':
+                    if (memcmp(key, "Specimen", 8) == 0) return FHIR_RESOURCE_TYPE_SPECIMEN;
+                    break;
+                case 'h':
+                    if (memcmp(key, "Schedule", 8) == 0) return FHIR_RESOURCE_TYPE_SCHEDULE;
+                    break;
+                case 'i':
+                    if (memcmp(key, "Evidence", 8) == 0) return FHIR_RESOURCE_TYPE_EVIDENCE;
+                    break;
+                case 'l':
+                    if (memcmp(key, "ValueSet", 8) == 0) return FHIR_RESOURCE_TYPE_VALUE_SET;
+                    break;
+                case 'n':
+                    if (memcmp(key, "Contract", 8) == 0) return FHIR_RESOURCE_TYPE_CONTRACT;
+                    break;
+                case 'r':
+                    if (memcmp(key, "CarePlan", 8) == 0) return FHIR_RESOURCE_TYPE_CARE_PLAN;
+                    if (memcmp(key, "CareTeam", 8) == 0) return FHIR_RESOURCE_TYPE_CARE_TEAM;
+                    break;
+                case 's':
+                    if (memcmp(key, "TestPlan", 8) == 0) return FHIR_RESOURCE_TYPE_TEST_PLAN;
+                    break;
+                case 't':
+                    if (memcmp(key, "Citation", 8) == 0) return FHIR_RESOURCE_TYPE_CITATION;
+                    break;
+                case 'v':
+                    if (memcmp(key, "Coverage", 8) == 0) return FHIR_RESOURCE_TYPE_COVERAGE;
+                    break;
+            }
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'C':
+                    if (memcmp(key, "Condition", 9) == 0) return FHIR_RESOURCE_TYPE_CONDITION;
+                    break;
+                case 'E':
+                    if (memcmp(key, "Encounter", 9) == 0) return FHIR_RESOURCE_TYPE_ENCOUNTER;
+                    break;
+                case 'P':
+                    if (memcmp(key, "Procedure", 9) == 0) return FHIR_RESOURCE_TYPE_PROCEDURE;
+                    break;
+                case 'S':
+                    if (memcmp(key, "Substance", 9) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE;
+                    break;
+                case 'T':
+                    if (memcmp(key, "Transport", 9) == 0) return FHIR_RESOURCE_TYPE_TRANSPORT;
+                    break;
+            }
+            break;
+        case 10:
+            switch (key[5]) {
+                case 'E':
+                    if (memcmp(key, "AuditEvent", 10) == 0) return FHIR_RESOURCE_TYPE_AUDIT_EVENT;
+                    break;
+                case 'a':
+                    if (memcmp(key, "Medication", 10) == 0) return FHIR_RESOURCE_TYPE_MEDICATION;
+                    break;
+                case 'c':
+                    if (memcmp(key, "TestScript", 10) == 0) return FHIR_RESOURCE_TYPE_TEST_SCRIPT;
+                    break;
+                case 'd':
+                    if (memcmp(key, "Ingredient", 10) == 0) return FHIR_RESOURCE_TYPE_INGREDIENT;
+                    break;
+                case 'e':
+                    if (memcmp(key, "ChargeItem", 10) == 0) return FHIR_RESOURCE_TYPE_CHARGE_ITEM;
+                    if (memcmp(key, "Parameters", 10) == 0) return FHIR_RESOURCE_TYPE_PARAMETERS;
+                    if (memcmp(key, "TestReport", 10) == 0) return FHIR_RESOURCE_TYPE_TEST_REPORT;
+                    break;
+                case 'n':
+                    if (memcmp(key, "Provenance", 10) == 0) return FHIR_RESOURCE_TYPE_PROVENANCE;
+                    break;
+                case 'p':
+                    if (memcmp(key, "ConceptMap", 10) == 0) return FHIR_RESOURCE_TYPE_CONCEPT_MAP;
+                    break;
+                case 's':
+                    if (memcmp(key, "Permission", 10) == 0) return FHIR_RESOURCE_TYPE_PERMISSION;
+                    break;
+                case 'y':
+                    if (memcmp(key, "CodeSystem", 10) == 0) return FHIR_RESOURCE_TYPE_CODE_SYSTEM;
+                    break;
+            }
+            break;
+        case 11:
+            switch (key[0]) {
+                case 'A':
+                    if (memcmp(key, "Appointment", 11) == 0) return FHIR_RESOURCE_TYPE_APPOINTMENT;
+                    break;
+                case 'C':
+                    if (memcmp(key, "Composition", 11) == 0) return FHIR_RESOURCE_TYPE_COMPOSITION;
+                    break;
+                case 'D':
+                    if (memcmp(key, "DeviceUsage", 11) == 0) return FHIR_RESOURCE_TYPE_DEVICE_USAGE;
+                    break;
+                case 'O':
+                    if (memcmp(key, "Observation", 11) == 0) return FHIR_RESOURCE_TYPE_OBSERVATION;
+                    break;
+            }
+            break;
+        case 12:
+            switch (key[0]) {
+                case 'A':
+                    if (memcmp(key, "AdverseEvent", 12) == 0) return FHIR_RESOURCE_TYPE_ADVERSE_EVENT;
+                    break;
+                case 'D':
+                    if (memcmp(key, "DeviceMetric", 12) == 0) return FHIR_RESOURCE_TYPE_DEVICE_METRIC;
+                    break;
+                case 'G':
+                    if (memcmp(key, "GenomicStudy", 12) == 0) return FHIR_RESOURCE_TYPE_GENOMIC_STUDY;
+                    break;
+                case 'I':
+                    if (memcmp(key, "ImagingStudy", 12) == 0) return FHIR_RESOURCE_TYPE_IMAGING_STUDY;
+                    if (memcmp(key, "Immunization", 12) == 0) return FHIR_RESOURCE_TYPE_IMMUNIZATION;
+                    break;
+                case 'N':
+                    if (memcmp(key, "NamingSystem", 12) == 0) return FHIR_RESOURCE_TYPE_NAMING_SYSTEM;
+                    break;
+                case 'O':
+                    if (memcmp(key, "Organization", 12) == 0) return FHIR_RESOURCE_TYPE_ORGANIZATION;
+                    break;
+                case 'P':
+                    if (memcmp(key, "Practitioner", 12) == 0) return FHIR_RESOURCE_TYPE_PRACTITIONER;
+                    break;
+                case 'R':
+                    if (memcmp(key, "Requirements", 12) == 0) return FHIR_RESOURCE_TYPE_REQUIREMENTS;
+                    break;
+                case 'S':
+                    if (memcmp(key, "StructureMap", 12) == 0) return FHIR_RESOURCE_TYPE_STRUCTURE_MAP;
+                    if (memcmp(key, "Subscription", 12) == 0) return FHIR_RESOURCE_TYPE_SUBSCRIPTION;
+                    break;
+            }
+            break;
+        case 13:
+            switch (key[7]) {
+                case 'H':
+                    if (memcmp(key, "MessageHeader", 13) == 0) return FHIR_RESOURCE_TYPE_MESSAGE_HEADER;
+                    break;
+                case 'N':
+                    if (memcmp(key, "PaymentNotice", 13) == 0) return FHIR_RESOURCE_TYPE_PAYMENT_NOTICE;
+                    break;
+                case 'O':
+                    if (memcmp(key, "EpisodeOfCare", 13) == 0) return FHIR_RESOURCE_TYPE_EPISODE_OF_CARE;
+                    break;
+                case 'P':
+                    if (memcmp(key, "RelatedPerson", 13) == 0) return FHIR_RESOURCE_TYPE_RELATED_PERSON;
+                    break;
+                case 'R':
+                    if (memcmp(key, "MeasureReport", 13) == 0) return FHIR_RESOURCE_TYPE_MEASURE_REPORT;
+                    break;
+                case 'c':
+                    if (memcmp(key, "Communication", 13) == 0) return FHIR_RESOURCE_TYPE_COMMUNICATION;
+                    if (memcmp(key, "InsurancePlan", 13) == 0) return FHIR_RESOURCE_TYPE_INSURANCE_PLAN;
+                    break;
+                case 'd':
+                    if (memcmp(key, "DetectedIssue", 13) == 0) return FHIR_RESOURCE_TYPE_DETECTED_ISSUE;
+                    break;
+                case 'e':
+                    if (memcmp(key, "DeviceRequest", 13) == 0) return FHIR_RESOURCE_TYPE_DEVICE_REQUEST;
+                    if (memcmp(key, "SupplyRequest", 13) == 0) return FHIR_RESOURCE_TYPE_SUPPLY_REQUEST;
+                    break;
+                case 'h':
+                    if (memcmp(key, "ResearchStudy", 13) == 0) return FHIR_RESOURCE_TYPE_RESEARCH_STUDY;
+                    break;
+                case 'n':
+                    if (memcmp(key, "Questionnaire", 13) == 0) return FHIR_RESOURCE_TYPE_QUESTIONNAIRE;
+                    break;
+                case 'r':
+                    if (memcmp(key, "FormularyItem", 13) == 0) return FHIR_RESOURCE_TYPE_FORMULARY_ITEM;
+                    if (memcmp(key, "InventoryItem", 13) == 0) return FHIR_RESOURCE_TYPE_INVENTORY_ITEM;
+                    break;
+                case 's':
+                    if (memcmp(key, "ClaimResponse", 13) == 0) return FHIR_RESOURCE_TYPE_CLAIM_RESPONSE;
+                    break;
+                case 'u':
+                    if (memcmp(key, "BodyStructure", 13) == 0) return FHIR_RESOURCE_TYPE_BODY_STRUCTURE;
+                    break;
+            }
+            break;
+        case 14:
+            switch (key[2]) {
+                case 'a':
+                    if (memcmp(key, "PlanDefinition", 14) == 0) return FHIR_RESOURCE_TYPE_PLAN_DEFINITION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "EvidenceReport", 14) == 0) return FHIR_RESOURCE_TYPE_EVIDENCE_REPORT;
+                    break;
+                case 'p':
+                    if (memcmp(key, "SupplyDelivery", 14) == 0) return FHIR_RESOURCE_TYPE_SUPPLY_DELIVERY;
+                    break;
+                case 'r':
+                    if (memcmp(key, "ServiceRequest", 14) == 0) return FHIR_RESOURCE_TYPE_SERVICE_REQUEST;
+                    break;
+                case 's':
+                    if (memcmp(key, "RiskAssessment", 14) == 0) return FHIR_RESOURCE_TYPE_RISK_ASSESSMENT;
+                    break;
+                case 't':
+                    if (memcmp(key, "NutritionOrder", 14) == 0) return FHIR_RESOURCE_TYPE_NUTRITION_ORDER;
+                    break;
+                case 'v':
+                    if (memcmp(key, "DeviceDispense", 14) == 0) return FHIR_RESOURCE_TYPE_DEVICE_DISPENSE;
+                    break;
+            }
+            break;
+        case 15:
+            switch (key[4]) {
+                case 'a':
+                    if (memcmp(key, "ResearchSubject", 15) == 0) return FHIR_RESOURCE_TYPE_RESEARCH_SUBJECT;
+                    break;
+                case 'c':
+                    if (memcmp(key, "SearchParameter", 15) == 0) return FHIR_RESOURCE_TYPE_SEARCH_PARAMETER;
+                    break;
+                case 'h':
+                    if (memcmp(key, "GraphDefinition", 15) == 0) return FHIR_RESOURCE_TYPE_GRAPH_DEFINITION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "NutritionIntake", 15) == 0) return FHIR_RESOURCE_TYPE_NUTRITION_INTAKE;
+                    break;
+                case 'n':
+                    if (memcmp(key, "InventoryReport", 15) == 0) return FHIR_RESOURCE_TYPE_INVENTORY_REPORT;
+                    break;
+                case 'p':
+                    if (memcmp(key, "ExampleScenario", 15) == 0) return FHIR_RESOURCE_TYPE_EXAMPLE_SCENARIO;
+                    break;
+                case 'r':
+                    if (memcmp(key, "ActorDefinition", 15) == 0) return FHIR_RESOURCE_TYPE_ACTOR_DEFINITION;
+                    break;
+                case 't':
+                    if (memcmp(key, "EventDefinition", 15) == 0) return FHIR_RESOURCE_TYPE_EVENT_DEFINITION;
+                    break;
+            }
+            break;
+        case 16:
+            switch (key[9]) {
+                case 'H':
+                    if (memcmp(key, "EncounterHistory", 16) == 0) return FHIR_RESOURCE_TYPE_ENCOUNTER_HISTORY;
+                    break;
+                case 'O':
+                    if (memcmp(key, "OperationOutcome", 16) == 0) return FHIR_RESOURCE_TYPE_OPERATION_OUTCOME;
+                    break;
+                case 'P':
+                    if (memcmp(key, "NutritionProduct", 16) == 0) return FHIR_RESOURCE_TYPE_NUTRITION_PRODUCT;
+                    if (memcmp(key, "SubstancePolymer", 16) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_POLYMER;
+                    if (memcmp(key, "SubstanceProtein", 16) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_PROTEIN;
+                    break;
+                case 'a':
+                    if (memcmp(key, "EvidenceVariable", 16) == 0) return FHIR_RESOURCE_TYPE_EVIDENCE_VARIABLE;
+                    break;
+                case 'c':
+                    if (memcmp(key, "DiagnosticReport", 16) == 0) return FHIR_RESOURCE_TYPE_DIAGNOSTIC_REPORT;
+                    break;
+                case 'e':
+                    if (memcmp(key, "GuidanceResponse", 16) == 0) return FHIR_RESOURCE_TYPE_GUIDANCE_RESPONSE;
+                    break;
+                case 'i':
+                    if (memcmp(key, "DeviceDefinition", 16) == 0) return FHIR_RESOURCE_TYPE_DEVICE_DEFINITION;
+                    break;
+                case 'l':
+                    if (memcmp(key, "ImagingSelection", 16) == 0) return FHIR_RESOURCE_TYPE_IMAGING_SELECTION;
+                    break;
+                case 'n':
+                    if (memcmp(key, "PractitionerRole", 16) == 0) return FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE;
+                    break;
+            }
+            break;
+        case 17:
+            switch (key[2]) {
+                case 'a':
+                    if (memcmp(key, "HealthcareService", 17) == 0) return FHIR_RESOURCE_TYPE_HEALTHCARE_SERVICE;
+                    break;
+                case 'b':
+                    if (memcmp(key, "SubscriptionTopic", 17) == 0) return FHIR_RESOURCE_TYPE_SUBSCRIPTION_TOPIC;
+                    break;
+                case 'c':
+                    if (memcmp(key, "DocumentReference", 17) == 0) return FHIR_RESOURCE_TYPE_DOCUMENT_REFERENCE;
+                    break;
+                case 'd':
+                    if (memcmp(key, "MedicationRequest", 17) == 0) return FHIR_RESOURCE_TYPE_MEDICATION_REQUEST;
+                    break;
+                case 'l':
+                    if (memcmp(key, "MolecularSequence", 17) == 0) return FHIR_RESOURCE_TYPE_MOLECULAR_SEQUENCE;
+                    break;
+                case 'r':
+                    if (memcmp(key, "EnrollmentRequest", 17) == 0) return FHIR_RESOURCE_TYPE_ENROLLMENT_REQUEST;
+                    break;
+                case 's':
+                    if (memcmp(key, "MessageDefinition", 17) == 0) return FHIR_RESOURCE_TYPE_MESSAGE_DEFINITION;
+                    break;
+            }
+            break;
+        case 18:
+            switch (key[7]) {
+                case 'I':
+                    if (memcmp(key, "AllergyIntolerance", 18) == 0) return FHIR_RESOURCE_TYPE_ALLERGY_INTOLERANCE;
+                    break;
+                case 'a':
+                    if (memcmp(key, "VerificationResult", 18) == 0) return FHIR_RESOURCE_TYPE_VERIFICATION_RESULT;
+                    break;
+                case 'e':
+                    if (memcmp(key, "EnrollmentResponse", 18) == 0) return FHIR_RESOURCE_TYPE_ENROLLMENT_RESPONSE;
+                    break;
+                case 'i':
+                    if (memcmp(key, "MedicationDispense", 18) == 0) return FHIR_RESOURCE_TYPE_MEDICATION_DISPENSE;
+                    break;
+                case 'l':
+                    if (memcmp(key, "ClinicalImpression", 18) == 0) return FHIR_RESOURCE_TYPE_CLINICAL_IMPRESSION;
+                    break;
+                case 'n':
+                    if (memcmp(key, "SpecimenDefinition", 18) == 0) return FHIR_RESOURCE_TYPE_SPECIMEN_DEFINITION;
+                    break;
+                case 'p':
+                    if (memcmp(key, "SubscriptionStatus", 18) == 0) return FHIR_RESOURCE_TYPE_SUBSCRIPTION_STATUS;
+                    break;
+                case 'r':
+                    if (memcmp(key, "VisionPrescription", 18) == 0) return FHIR_RESOURCE_TYPE_VISION_PRESCRIPTION;
+                    break;
+                case 't':
+                    if (memcmp(key, "ArtifactAssessment", 18) == 0) return FHIR_RESOURCE_TYPE_ARTIFACT_ASSESSMENT;
+                    break;
+                case 'y':
+                    if (memcmp(key, "ActivityDefinition", 18) == 0) return FHIR_RESOURCE_TYPE_ACTIVITY_DEFINITION;
+                    break;
+            }
+            break;
+        case 19:
+            switch (key[3]) {
+                case 'a':
+                    if (memcmp(key, "CapabilityStatement", 19) == 0) return FHIR_RESOURCE_TYPE_CAPABILITY_STATEMENT;
+                    break;
+                case 'd':
+                    if (memcmp(key, "ConditionDefinition", 19) == 0) return FHIR_RESOURCE_TYPE_CONDITION_DEFINITION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "FamilyMemberHistory", 19) == 0) return FHIR_RESOURCE_TYPE_FAMILY_MEMBER_HISTORY;
+                    if (memcmp(key, "MedicationKnowledge", 19) == 0) return FHIR_RESOURCE_TYPE_MEDICATION_KNOWLEDGE;
+                    if (memcmp(key, "MedicationStatement", 19) == 0) return FHIR_RESOURCE_TYPE_MEDICATION_STATEMENT;
+                    break;
+                case 'l':
+                    if (memcmp(key, "ImplementationGuide", 19) == 0) return FHIR_RESOURCE_TYPE_IMPLEMENTATION_GUIDE;
+                    break;
+                case 'o':
+                    if (memcmp(key, "AppointmentResponse", 19) == 0) return FHIR_RESOURCE_TYPE_APPOINTMENT_RESPONSE;
+                    break;
+                case 'r':
+                    if (memcmp(key, "OperationDefinition", 19) == 0) return FHIR_RESOURCE_TYPE_OPERATION_DEFINITION;
+                    break;
+                case 's':
+                    if (memcmp(key, "SubstanceDefinition", 19) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_DEFINITION;
+                    break;
+                case 'u':
+                    if (memcmp(key, "StructureDefinition", 19) == 0) return FHIR_RESOURCE_TYPE_STRUCTURE_DEFINITION;
+                    break;
+            }
+            break;
+        case 20:
+            switch (key[1]) {
+                case 'e':
+                    if (memcmp(key, "RequestOrchestration", 20) == 0) return FHIR_RESOURCE_TYPE_REQUEST_ORCHESTRATION;
+                    break;
+                case 'h':
+                    if (memcmp(key, "ChargeItemDefinition", 20) == 0) return FHIR_RESOURCE_TYPE_CHARGE_ITEM_DEFINITION;
+                    break;
+                case 'o':
+                    if (memcmp(key, "CommunicationRequest", 20) == 0) return FHIR_RESOURCE_TYPE_COMMUNICATION_REQUEST;
+                    break;
+                case 'u':
+                    if (memcmp(key, "SubstanceNucleicAcid", 20) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_NUCLEIC_ACID;
+                    break;
+                case 'x':
+                    if (memcmp(key, "ExplanationOfBenefit", 20) == 0) return FHIR_RESOURCE_TYPE_EXPLANATION_OF_BENEFIT;
+                    break;
+            }
+            break;
+        case 21:
+            switch (key[1]) {
+                case 'a':
+                    if (memcmp(key, "PaymentReconciliation", 21) == 0) return FHIR_RESOURCE_TYPE_PAYMENT_RECONCILIATION;
+                    break;
+                case 'b':
+                    if (memcmp(key, "ObservationDefinition", 21) == 0) return FHIR_RESOURCE_TYPE_OBSERVATION_DEFINITION;
+                    break;
+                case 'l':
+                    if (memcmp(key, "ClinicalUseDefinition", 21) == 0) return FHIR_RESOURCE_TYPE_CLINICAL_USE_DEFINITION;
+                    break;
+                case 'o':
+                    if (memcmp(key, "CompartmentDefinition", 21) == 0) return FHIR_RESOURCE_TYPE_COMPARTMENT_DEFINITION;
+                    break;
+                case 'u':
+                    if (memcmp(key, "QuestionnaireResponse", 21) == 0) return FHIR_RESOURCE_TYPE_QUESTIONNAIRE_RESPONSE;
+                    break;
+            }
+            break;
+        case 22:
+            switch (key[0]) {
+                case 'I':
+                    if (memcmp(key, "ImmunizationEvaluation", 22) == 0) return FHIR_RESOURCE_TYPE_IMMUNIZATION_EVALUATION;
+                    break;
+                case 'R':
+                    if (memcmp(key, "RegulatedAuthorization", 22) == 0) return FHIR_RESOURCE_TYPE_REGULATED_AUTHORIZATION;
+                    break;
+            }
+            break;
+        case 23:
+            switch (key[0]) {
+                case 'O':
+                    if (memcmp(key, "OrganizationAffiliation", 23) == 0) return FHIR_RESOURCE_TYPE_ORGANIZATION_AFFILIATION;
+                    break;
+                case 'S':
+                    if (memcmp(key, "SubstanceSourceMaterial", 23) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_SOURCE_MATERIAL;
+                    break;
+                case 'T':
+                    if (memcmp(key, "TerminologyCapabilities", 23) == 0) return FHIR_RESOURCE_TYPE_TERMINOLOGY_CAPABILITIES;
+                    break;
+            }
+            break;
+        case 24:
+            if (memcmp(key, "MedicationAdministration", 24) == 0) return FHIR_RESOURCE_TYPE_MEDICATION_ADMINISTRATION;
+            break;
+        case 25:
+            if (memcmp(key, "PackagedProductDefinition", 25) == 0) return FHIR_RESOURCE_TYPE_PACKAGED_PRODUCT_DEFINITION;
+            break;
+        case 26:
+            switch (key[1]) {
+                case 'a':
+                    if (memcmp(key, "ManufacturedItemDefinition", 26) == 0) return FHIR_RESOURCE_TYPE_MANUFACTURED_ITEM_DEFINITION;
+                    break;
+                case 'e':
+                    if (memcmp(key, "MedicinalProductDefinition", 26) == 0) return FHIR_RESOURCE_TYPE_MEDICINAL_PRODUCT_DEFINITION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "BiologicallyDerivedProduct", 26) == 0) return FHIR_RESOURCE_TYPE_BIOLOGICALLY_DERIVED_PRODUCT;
+                    break;
+                case 'm':
+                    if (memcmp(key, "ImmunizationRecommendation", 26) == 0) return FHIR_RESOURCE_TYPE_IMMUNIZATION_RECOMMENDATION;
+                    break;
+                case 'o':
+                    if (memcmp(key, "CoverageEligibilityRequest", 26) == 0) return FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_REQUEST;
+                    break;
+            }
+            break;
+        case 27:
+            if (memcmp(key, "CoverageEligibilityResponse", 27) == 0) return FHIR_RESOURCE_TYPE_COVERAGE_ELIGIBILITY_RESPONSE;
+            break;
+        case 29:
+            if (memcmp(key, "SubstanceReferenceInformation", 29) == 0) return FHIR_RESOURCE_TYPE_SUBSTANCE_REFERENCE_INFORMATION;
+            break;
+        case 30:
+            if (memcmp(key, "AdministrableProductDefinition", 30) == 0) return FHIR_RESOURCE_TYPE_ADMINISTRABLE_PRODUCT_DEFINITION;
+            break;
+        case 34:
+            if (memcmp(key, "BiologicallyDerivedProductDispense", 34) == 0) return FHIR_RESOURCE_TYPE_BIOLOGICALLY_DERIVED_PRODUCT_DISPENSE;
+            break;
+    }
+    return FHIR_RESOURCE_TYPE_UNKNOWN;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_RESOURCE_TYPE_LOOKUP_H */
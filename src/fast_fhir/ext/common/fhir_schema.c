@@ -0,0 +1,590 @@
+/**
+ * @file fhir_schema.c
+ * @brief Table-driven JSON codecs for generated resources and data types
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_schema.h"
+#include "fhir_common.h"
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FIELD_AT(self, offset) ((char*)(self) + (offset))
+#define CONST_FIELD_AT(self, offset) ((const char*)(self) + (offset))
+
+// Kinds stored inline rather than behind a pointer
+static bool is_inline_kind(FHIRSchemaKind kind) {
+    return kind == FHIR_SCHEMA_FLAG || kind == FHIR_SCHEMA_NUMBER ||
+           kind == FHIR_SCHEMA_COUNT || kind == FHIR_SCHEMA_CODE;
+}
+
+static bool is_whole_number(const cJSON* item, double min, double max) {
+    if (!cJSON_IsNumber(item)) return false;
+    double value = item->valuedouble;
+    return value >= min && value <= max && (double)(long long)value == value;
+}
+
+/* ========================================================================== */
+/* Single Values                                                              */
+/* ========================================================================== */
+
+static void* alloc_value(size_t size) {
+    void* value = fhir_calloc(1, size);
+    if (!value) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate field value");
+    }
+    return value;
+}
+
+static char* copy_text(const char* text) {
+    char* copy = fhir_strdup(text);
+    if (!copy) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy field value");
+    }
+    return copy;
+}
+
+// Read one value into slot; values of the wrong JSON type leave it untouched
+static bool read_value(const FHIRSchemaField* field, const cJSON* item, void* slot) {
+    switch (field->kind) {
+        case FHIR_SCHEMA_BOOLEAN: {
+            if (!cJSON_IsBool(item)) return true;
+            FHIRBoolean* value = alloc_value(sizeof(FHIRBoolean));
+            if (!value) return false;
+            value->value = cJSON_IsTrue(item);
+            *(FHIRBoolean**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_INTEGER: {
+            if (!is_whole_number(item, INT_MIN, INT_MAX)) return true;
+            FHIRInteger* value = alloc_value(sizeof(FHIRInteger));
+            if (!value) return false;
+            value->value = (int)item->valuedouble;
+            *(FHIRInteger**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_UNSIGNED: {
+            if (!is_whole_number(item, 0, UINT_MAX)) return true;
+            FHIRUnsignedInt* value = alloc_value(sizeof(FHIRUnsignedInt));
+            if (!value) return false;
+            value->value = (unsigned int)item->valuedouble;
+            *(FHIRUnsignedInt**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_DECIMAL: {
+            if (!cJSON_IsNumber(item)) return true;
+            FHIRDecimal* value = alloc_value(sizeof(FHIRDecimal));
+            if (!value) return false;
+            value->value = item->valuedouble;
+            *(FHIRDecimal**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_STRING: {
+            if (!cJSON_IsString(item)) return true;
+            FHIRString* value = alloc_value(sizeof(FHIRString));
+            if (!value) return false;
+            value->value = copy_text(item->valuestring);
+            if (!value->value) {
+                fhir_free(value);
+                return false;
+            }
+            *(FHIRString**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_DATE_TIME: {
+            // FHIRDate, FHIRDateTime and FHIRInstant share one layout
+            FHIRDateTimeValue parsed;
+            if (!cJSON_IsString(item) || !fhir_datetime_parse(item->valuestring, &parsed)) return true;
+            FHIRDateTime* value = alloc_value(sizeof(FHIRDateTime));
+            if (!value) return false;
+            value->value = copy_text(item->valuestring);
+            if (!value->value) {
+                fhir_free(value);
+                return false;
+            }
+            value->parsed = parsed;
+            *(FHIRDateTime**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_TEXT:
+            if (!cJSON_IsString(item)) return true;
+            *(char**)slot = copy_text(item->valuestring);
+            return *(char**)slot != NULL;
+        case FHIR_SCHEMA_FLAG:
+            if (cJSON_IsBool(item)) *(bool*)slot = cJSON_IsTrue(item);
+            return true;
+        case FHIR_SCHEMA_NUMBER:
+            if (cJSON_IsNumber(item)) *(double*)slot = item->valuedouble;
+            return true;
+        case FHIR_SCHEMA_COUNT:
+            if (is_whole_number(item, 0, UINT_MAX)) *(unsigned int*)slot = (unsigned int)item->valuedouble;
+            return true;
+        case FHIR_SCHEMA_CODE:
+            if (!cJSON_IsString(item)) return true;
+            for (size_t i = 0; i < field->code_count; i++) {
+                if (strcmp(field->codes[i], item->valuestring) == 0) {
+                    *(int*)slot = (int)i + 1;
+                    break;
+                }
+            }
+            return true;
+        case FHIR_SCHEMA_COMPLEX: {
+            if (!cJSON_IsObject(item)) return true;
+            void* value = alloc_value(field->schema->size);
+            if (!value) return false;
+            if (!fhir_schema_from_json(field->schema, value, item)) {
+                fhir_schema_clear(field->schema, value);
+                fhir_free(value);
+                return false;
+            }
+            *(void**)slot = value;
+            return true;
+        }
+        case FHIR_SCHEMA_JSON:
+            *(cJSON**)slot = cJSON_Duplicate(item, true);
+            if (!*(cJSON**)slot) {
+                FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy field value");
+                return false;
+            }
+            return true;
+    }
+    return true;
+}
+
+// Serialize one value; *out stays NULL for absent values
+static bool write_value(const FHIRSchemaField* field, const void* slot, cJSON** out) {
+    *out = NULL;
+    const void* value = is_inline_kind(field->kind) ? slot : *(void* const*)slot;
+    if (!value) return true;
+
+    switch (field->kind) {
+        case FHIR_SCHEMA_BOOLEAN:
+            *out = cJSON_CreateBool(((const FHIRBoolean*)value)->value);
+            break;
+        case FHIR_SCHEMA_INTEGER:
+            *out = cJSON_CreateNumber(((const FHIRInteger*)value)->value);
+            break;
+        case FHIR_SCHEMA_UNSIGNED:
+            *out = cJSON_CreateNumber(((const FHIRUnsignedInt*)value)->value);
+            break;
+        case FHIR_SCHEMA_DECIMAL:
+            *out = cJSON_CreateNumber(((const FHIRDecimal*)value)->value);
+            break;
+        case FHIR_SCHEMA_STRING:
+        case FHIR_SCHEMA_DATE_TIME:
+            if (!((const FHIRString*)value)->value) return true;
+            *out = cJSON_CreateString(((const FHIRString*)value)->value);
+            break;
+        case FHIR_SCHEMA_TEXT:
+            *out = cJSON_CreateString(value);
+            break;
+        case FHIR_SCHEMA_FLAG:
+            if (!*(const bool*)value) return true;
+            *out = cJSON_CreateTrue();
+            break;
+        case FHIR_SCHEMA_NUMBER:
+            *out = cJSON_CreateNumber(*(const double*)value);
+            break;
+        case FHIR_SCHEMA_COUNT:
+            if (*(const unsigned int*)value == 0) return true;
+            *out = cJSON_CreateNumber(*(const unsigned int*)value);
+            break;
+        case FHIR_SCHEMA_CODE: {
+            int code = *(const int*)value;
+            if (code <= 0 || (size_t)code > field->code_count) return true;
+            *out = cJSON_CreateString(field->codes[code - 1]);
+            break;
+        }
+        case FHIR_SCHEMA_COMPLEX:
+            *out = cJSON_CreateObject();
+            if (*out && !fhir_schema_to_json(field->schema, value, *out)) {
+                cJSON_Delete(*out);
+                *out = NULL;
+            }
+            break;
+        case FHIR_SCHEMA_JSON:
+            *out = cJSON_Duplicate(value, true);
+            break;
+    }
+    if (!*out) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_SERIALIZE_FAILED, "Failed to serialize field", field->key);
+        return false;
+    }
+    return true;
+}
+
+static void free_value(const FHIRSchemaField* field, void* value) {
+    if (!value) return;
+    switch (field->kind) {
+        case FHIR_SCHEMA_STRING:
+        case FHIR_SCHEMA_DATE_TIME:
+            fhir_free(((FHIRString*)value)->value);
+            break;
+        case FHIR_SCHEMA_COMPLEX:
+            fhir_schema_clear(field->schema, value);
+            break;
+        case FHIR_SCHEMA_JSON:
+            cJSON_Delete(value);
+            return;
+        default:
+            break;
+    }
+    fhir_free(value);
+}
+
+static bool copy_value(const FHIRSchemaField* field, const void* value, void** out) {
+    *out = NULL;
+    if (!value) return true;
+
+    switch (field->kind) {
+        case FHIR_SCHEMA_STRING:
+        case FHIR_SCHEMA_DATE_TIME: {
+            size_t size = field->kind == FHIR_SCHEMA_STRING ? sizeof(FHIRString) : sizeof(FHIRDateTime);
+            FHIRString* copy = alloc_value(size);
+            if (!copy) return false;
+            memcpy(copy, value, size);
+            copy->base = (FHIRElement){0};
+            copy->value = NULL;
+            if (((const FHIRString*)value)->value) {
+                copy->value = copy_text(((const FHIRString*)value)->value);
+                if (!copy->value) {
+                    fhir_free(copy);
+                    return false;
+                }
+            }
+            *out = copy;
+            return true;
+        }
+        case FHIR_SCHEMA_TEXT:
+            *out = copy_text(value);
+            return *out != NULL;
+        case FHIR_SCHEMA_COMPLEX: {
+            void* copy = alloc_value(field->schema->size);
+            if (!copy) return false;
+            if (!fhir_schema_copy(field->schema, copy, value)) {
+                fhir_schema_clear(field->schema, copy);
+                fhir_free(copy);
+                return false;
+            }
+            *out = copy;
+            return true;
+        }
+        case FHIR_SCHEMA_JSON:
+            *out = cJSON_Duplicate(value, true);
+            break;
+        default: {
+            // Boolean, integer and decimal wrappers hold no pointers
+            size_t size = field->kind == FHIR_SCHEMA_BOOLEAN ? sizeof(FHIRBoolean)
+                        : field->kind == FHIR_SCHEMA_DECIMAL ? sizeof(FHIRDecimal)
+                        : sizeof(FHIRInteger);
+            *out = alloc_value(size);
+            if (*out) memcpy(*out, value, size);
+            return *out != NULL;
+        }
+    }
+    if (!*out) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy field value");
+        return false;
+    }
+    return true;
+}
+
+static bool values_equal(const FHIRSchemaField* field, const void* a, const void* b) {
+    if (is_inline_kind(field->kind)) {
+        switch (field->kind) {
+            case FHIR_SCHEMA_FLAG: return *(const bool*)a == *(const bool*)b;
+            case FHIR_SCHEMA_NUMBER: return *(const double*)a == *(const double*)b;
+            case FHIR_SCHEMA_COUNT: return *(const unsigned int*)a == *(const unsigned int*)b;
+            default: return *(const int*)a == *(const int*)b;
+        }
+    }
+
+    a = *(void* const*)a;
+    b = *(void* const*)b;
+    if (!a || !b) return a == b;
+    switch (field->kind) {
+        case FHIR_SCHEMA_BOOLEAN: return ((const FHIRBoolean*)a)->value == ((const FHIRBoolean*)b)->value;
+        case FHIR_SCHEMA_INTEGER: return ((const FHIRInteger*)a)->value == ((const FHIRInteger*)b)->value;
+        case FHIR_SCHEMA_UNSIGNED:
+            return ((const FHIRUnsignedInt*)a)->value == ((const FHIRUnsignedInt*)b)->value;
+        case FHIR_SCHEMA_DECIMAL: return ((const FHIRDecimal*)a)->value == ((const FHIRDecimal*)b)->value;
+        case FHIR_SCHEMA_STRING:
+        case FHIR_SCHEMA_DATE_TIME:
+            return fhir_strcmp(((const FHIRString*)a)->value, ((const FHIRString*)b)->value) == 0;
+        case FHIR_SCHEMA_TEXT: return strcmp(a, b) == 0;
+        case FHIR_SCHEMA_COMPLEX: return fhir_schema_equals(field->schema, a, b);
+        case FHIR_SCHEMA_JSON: return cJSON_Compare(a, b, true);
+        default: return true;
+    }
+}
+
+/* ========================================================================== */
+/* Fields                                                                     */
+/* ========================================================================== */
+
+static void clear_field(const FHIRSchemaField* field, void* self) {
+    void* slot = FIELD_AT(self, field->offset);
+    if (is_inline_kind(field->kind)) {
+        memset(slot, 0, field->kind == FHIR_SCHEMA_FLAG ? sizeof(bool)
+                      : field->kind == FHIR_SCHEMA_NUMBER ? sizeof(double)
+                      : field->kind == FHIR_SCHEMA_COUNT ? sizeof(unsigned int) : sizeof(int));
+        return;
+    }
+    if (!(field->flags & FHIR_SCHEMA_ARRAY)) {
+        free_value(field, *(void**)slot);
+        *(void**)slot = NULL;
+        return;
+    }
+
+    void** items = *(void***)slot;
+    size_t* count = (size_t*)FIELD_AT(self, field->count_offset);
+    for (size_t i = 0; i < *count; i++) {
+        free_value(field, items[i]);
+    }
+    fhir_free(items);
+    *(void***)slot = NULL;
+    *count = 0;
+}
+
+static bool read_field(const FHIRSchemaField* field, void* self, const cJSON* item) {
+    // A repeated key replaces the earlier value
+    clear_field(field, self);
+    void* slot = FIELD_AT(self, field->offset);
+    if (!(field->flags & FHIR_SCHEMA_ARRAY)) {
+        return read_value(field, item, slot);
+    }
+
+    bool single = (field->flags & FHIR_SCHEMA_SINGLE) && !cJSON_IsArray(item);
+    if (!single && !cJSON_IsArray(item)) return true;
+    size_t count = single ? 1 : (size_t)cJSON_GetArraySize(item);
+    if (count == 0) return true;
+
+    void** items = fhir_calloc(count, sizeof(void*));
+    if (!items) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate array", field->key);
+        return false;
+    }
+    *(void***)slot = items;
+    *(size_t*)FIELD_AT(self, field->count_offset) = count;
+
+    if (single) {
+        return read_value(field, item, &items[0]);
+    }
+    size_t i = 0;
+    const cJSON* element;
+    cJSON_ArrayForEach(element, item) {
+        if (!read_value(field, element, &items[i++])) return false;
+    }
+    return true;
+}
+
+static bool write_field(const FHIRSchemaField* field, const void* self, cJSON* json) {
+    const void* slot = CONST_FIELD_AT(self, field->offset);
+    cJSON* value = NULL;
+    if (!(field->flags & FHIR_SCHEMA_ARRAY)) {
+        if (!write_value(field, slot, &value)) return false;
+    } else {
+        void* const* items = *(void* const* const*)slot;
+        size_t count = *(const size_t*)CONST_FIELD_AT(self, field->count_offset);
+        if (!items || count == 0) return true;
+        if (field->flags & FHIR_SCHEMA_SINGLE) {
+            // The first value that survived reading is the JSON value
+            for (size_t i = 0; i < count && !value; i++) {
+                if (!write_value(field, &items[i], &value)) return false;
+            }
+        } else {
+            value = cJSON_CreateArray();
+            if (!value) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to create array", field->key);
+                return false;
+            }
+            for (size_t i = 0; i < count; i++) {
+                cJSON* element;
+                if (!write_value(field, &items[i], &element)) {
+                    cJSON_Delete(value);
+                    return false;
+                }
+                if (element) cJSON_AddItemToArray(value, element);
+            }
+            if (cJSON_GetArraySize(value) == 0) {
+                cJSON_Delete(value);
+                value = NULL;
+            }
+        }
+    }
+
+    if (value) cJSON_AddItemToObject(json, field->key, value);
+    return true;
+}
+
+static bool copy_field(const FHIRSchemaField* field, void* dest, const void* src) {
+    const void* src_slot = CONST_FIELD_AT(src, field->offset);
+    void* dest_slot = FIELD_AT(dest, field->offset);
+    if (is_inline_kind(field->kind)) {
+        memcpy(dest_slot, src_slot, field->kind == FHIR_SCHEMA_FLAG ? sizeof(bool)
+                                  : field->kind == FHIR_SCHEMA_NUMBER ? sizeof(double)
+                                  : field->kind == FHIR_SCHEMA_COUNT ? sizeof(unsigned int) : sizeof(int));
+        return true;
+    }
+    if (!(field->flags & FHIR_SCHEMA_ARRAY)) {
+        return copy_value(field, *(void* const*)src_slot, (void**)dest_slot);
+    }
+
+    void* const* items = *(void* const* const*)src_slot;
+    size_t count = *(const size_t*)CONST_FIELD_AT(src, field->count_offset);
+    if (!items || count == 0) return true;
+    void** copies = fhir_calloc(count, sizeof(void*));
+    if (!copies) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate array", field->key);
+        return false;
+    }
+    *(void***)dest_slot = copies;
+    *(size_t*)FIELD_AT(dest, field->count_offset) = count;
+    for (size_t i = 0; i < count; i++) {
+        if (!copy_value(field, items[i], &copies[i])) return false;
+    }
+    return true;
+}
+
+static bool fields_equal(const FHIRSchemaField* field, const void* a, const void* b) {
+    const void* a_slot = CONST_FIELD_AT(a, field->offset);
+    const void* b_slot = CONST_FIELD_AT(b, field->offset);
+    if (!(field->flags & FHIR_SCHEMA_ARRAY)) {
+        return values_equal(field, a_slot, b_slot);
+    }
+
+    size_t count = *(const size_t*)CONST_FIELD_AT(a, field->count_offset);
+    if (count != *(const size_t*)CONST_FIELD_AT(b, field->count_offset)) return false;
+    void* const* a_items = *(void* const* const*)a_slot;
+    void* const* b_items = *(void* const* const*)b_slot;
+    for (size_t i = 0; i < count; i++) {
+        if (!values_equal(field, &a_items[i], &b_items[i])) return false;
+    }
+    return true;
+}
+
+static bool field_present(const FHIRSchemaField* field, const void* self) {
+    const void* slot = CONST_FIELD_AT(self, field->offset);
+    if (field->flags & FHIR_SCHEMA_ARRAY) {
+        return *(const size_t*)CONST_FIELD_AT(self, field->count_offset) > 0;
+    }
+    if (field->kind == FHIR_SCHEMA_CODE) return *(const int*)slot != 0;
+    if (is_inline_kind(field->kind)) return true;
+    return *(void* const*)slot != NULL;
+}
+
+/* ========================================================================== */
+/* Codec                                                                      */
+/* ========================================================================== */
+
+// Read members in one pass; resource is NULL for data types
+static bool load_members(const FHIRSchema* schema, void* self, const cJSON* json,
+                         FHIRResourceBase* resource) {
+    // Field index seen per choice group, so a second variant can be rejected
+    int choices[64];
+    uint64_t seen = 0;
+
+    const cJSON* member;
+    cJSON_ArrayForEach(member, json) {
+        if (!member->string) continue;
+
+        int index = schema->lookup(member->string, strlen(member->string));
+        if (index == FHIR_SCHEMA_MEMBER_BASE) continue;
+        if (index < 0) {
+            if (resource && !fhir_resource_add_unknown_member(resource, member->string)) {
+                return false;
+            }
+            continue;
+        }
+
+        const FHIRSchemaField* field = &schema->fields[index];
+        if (field->choice > 0 && field->choice <= 64) {
+            uint64_t bit = (uint64_t)1 << (field->choice - 1);
+            if ((seen & bit) && choices[field->choice - 1] != index) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED,
+                                     "More than one value for a choice element", field->key);
+                return false;
+            }
+            seen |= bit;
+            choices[field->choice - 1] = index;
+        }
+        if (!read_field(field, self, member)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fhir_schema_load_resource(const FHIRSchema* schema, void* self, const cJSON* json) {
+    if (!schema || !self || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+    if (!cJSON_IsString(resource_type) || strcmp(resource_type->valuestring, schema->name) != 0) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
+        return false;
+    }
+    return load_members(schema, self, json, (FHIRResourceBase*)self);
+}
+
+bool fhir_schema_from_json(const FHIRSchema* schema, void* self, const cJSON* json) {
+    if (!schema || !self || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    return load_members(schema, self, json, NULL);
+}
+
+bool fhir_schema_to_json(const FHIRSchema* schema, const void* self, cJSON* json) {
+    if (!schema || !self || !json) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    for (size_t i = 0; i < schema->field_count; i++) {
+        if (!write_field(&schema->fields[i], self, json)) return false;
+    }
+    return true;
+}
+
+bool fhir_schema_copy(const FHIRSchema* schema, void* dest, const void* src) {
+    if (!schema || !dest || !src) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    for (size_t i = 0; i < schema->field_count; i++) {
+        if (!copy_field(&schema->fields[i], dest, src)) return false;
+    }
+    return true;
+}
+
+void fhir_schema_clear(const FHIRSchema* schema, void* self) {
+    if (!schema || !self) return;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        clear_field(&schema->fields[i], self);
+    }
+}
+
+bool fhir_schema_equals(const FHIRSchema* schema, const void* a, const void* b) {
+    if (a == b) return true;
+    if (!schema || !a || !b) return false;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        if (!fields_equal(&schema->fields[i], a, b)) return false;
+    }
+    return true;
+}
+
+bool fhir_schema_validate(const FHIRSchema* schema, const void* self) {
+    if (!schema || !self) return false;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const FHIRSchemaField* field = &schema->fields[i];
+        if ((field->flags & FHIR_SCHEMA_REQUIRED) && !field_present(field, self)) {
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", field->key);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file fhir_schema.h
+ * @brief Table-driven JSON codecs for generated resources and data types
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * scripts/generate_resources.py --codecs turns StructureDefinitions into
+ * one FHIRSchema per struct: a field table with offsetof positions and a
+ * generated key lookup (a switch on key length and one character, confirmed
+ * by a single memcmp). The functions here walk those tables, so every
+ * generated resource shares one set of from_json/to_json/clone/destroy
+ * loops instead of carrying its own copy of them.
+ *
+ * from_json makes a single pass over the object's members. Each value is
+ * allocated at its exact size, arrays at their element count. Elements of
+ * a choice type (deceased[x], value[x]) are separate fields sharing a
+ * choice group; an object with two variants of one group is rejected.
+ * Values of the wrong JSON type are skipped, as in the hand-written codecs,
+ * and array entries that could not be read stay NULL.
+ */
+
+#ifndef FHIR_SCHEMA_H
+#define FHIR_SCHEMA_H
+
+#include "fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief How a field is stored and read from JSON
+ */
+typedef enum {
+    FHIR_SCHEMA_BOOLEAN,    /**< FHIRBoolean* */
+    FHIR_SCHEMA_INTEGER,    /**< FHIRInteger* */
+    FHIR_SCHEMA_UNSIGNED,   /**< FHIRUnsignedInt* or FHIRPositiveInt* */
+    FHIR_SCHEMA_DECIMAL,    /**< FHIRDecimal* */
+    FHIR_SCHEMA_STRING,     /**< FHIRString* or another { FHIRElement base; char* value; } primitive */
+    FHIR_SCHEMA_DATE_TIME,  /**< FHIRDate*, FHIRDateTime* or FHIRInstant*, checked and pre-parsed */
+    FHIR_SCHEMA_TEXT,       /**< char* member of a data type */
+    FHIR_SCHEMA_FLAG,       /**< bool member of a data type, written when true */
+    FHIR_SCHEMA_NUMBER,     /**< double member of a data type */
+    FHIR_SCHEMA_COUNT,      /**< unsigned int member of a data type, written when non-zero */
+    FHIR_SCHEMA_CODE,       /**< int enumeration: value i + 1 is codes[i], 0 is absent */
+    FHIR_SCHEMA_COMPLEX,    /**< Pointer to a struct described by schema */
+    FHIR_SCHEMA_JSON        /**< cJSON* copy of an element without a C model */
+} FHIRSchemaKind;
+
+#define FHIR_SCHEMA_ARRAY    0x01  /**< Pointer array with a size_t count at count_offset */
+#define FHIR_SCHEMA_REQUIRED 0x02  /**< Minimum cardinality 1 */
+#define FHIR_SCHEMA_SINGLE   0x04  /**< Array in C, one value in JSON (HumanName.family) */
+
+#define FHIR_SCHEMA_MEMBER_UNKNOWN (-1)  /**< Lookup result for unrecognized keys */
+#define FHIR_SCHEMA_MEMBER_BASE    (-2)  /**< Lookup result for Resource/DomainResource members */
+
+typedef struct FHIRSchema FHIRSchema;
+
+/**
+ * @brief One JSON member of a struct
+ */
+typedef struct {
+    const char* key;            /**< JSON member name */
+    FHIRSchemaKind kind;
+    unsigned flags;             /**< FHIR_SCHEMA_ARRAY, _REQUIRED, _SINGLE */
+    unsigned choice;            /**< Choice group (1-based), 0 outside choice types */
+    size_t offset;              /**< offsetof the value or array */
+    size_t count_offset;        /**< offsetof the array count */
+    const FHIRSchema* schema;   /**< Element schema of COMPLEX fields */
+    const char* const* codes;   /**< Codes of CODE fields */
+    size_t code_count;
+} FHIRSchemaField;
+
+/**
+ * @brief Field table of a resource or data type struct
+ */
+struct FHIRSchema {
+    const char* name;           /**< FHIR type name */
+    size_t size;                /**< sizeof the struct */
+    const FHIRSchemaField* fields;
+    size_t field_count;
+    int (*lookup)(const char* key, size_t length);  /**< Field index or FHIR_SCHEMA_MEMBER_* */
+};
+
+/* ========================================================================== */
+/* Codec                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Load a resource's fields from its JSON object
+ *
+ * Checks resourceType against schema->name, skips the Resource and
+ * DomainResource members (the caller owns id) and records the names of
+ * unrecognized members on the resource.
+ *
+ * @param schema Resource schema
+ * @param self Zero-initialized resource struct starting with FHIRResourceBase
+ * @param json Resource JSON object
+ * @return true on success, false on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE,
+ *         FHIR_ERROR_VALIDATION_FAILED for two variants of a choice type)
+ */
+bool fhir_schema_load_resource(const FHIRSchema* schema, void* self, const cJSON* json);
+
+/**
+ * @brief Load a data type struct from its JSON object (unknown members ignored)
+ * @param schema Data type schema
+ * @param self Zero-initialized struct
+ * @param json JSON object
+ * @return true on success, false on failure
+ */
+bool fhir_schema_from_json(const FHIRSchema* schema, void* self, const cJSON* json);
+
+/**
+ * @brief Add a struct's fields to a JSON object, in schema order
+ * @param schema Schema of self
+ * @param self Struct to serialize
+ * @param json Object receiving the members
+ * @return true on success, false on failure
+ */
+bool fhir_schema_to_json(const FHIRSchema* schema, const void* self, cJSON* json);
+
+/**
+ * @brief Deep-copy a struct's fields
+ * @param schema Schema of both structs
+ * @param dest Zero-initialized destination
+ * @param src Source struct
+ * @return true on success, false on failure (dest is left for fhir_schema_clear)
+ */
+bool fhir_schema_copy(const FHIRSchema* schema, void* dest, const void* src);
+
+/**
+ * @brief Free everything a struct's fields own and zero them
+ * @param schema Schema of self
+ * @param self Struct to clear (the struct itself is not freed)
+ */
+void fhir_schema_clear(const FHIRSchema* schema, void* self);
+
+/**
+ * @brief Compare two structs field by field
+ * @param schema Schema of both structs
+ * @param a First struct
+ * @param b Second struct
+ * @return true if all fields are equal
+ */
+bool fhir_schema_equals(const FHIRSchema* schema, const void* a, const void* b);
+
+/**
+ * @brief Check that every required field is present
+ * @param schema Schema of self
+ * @param self Struct to check
+ * @return true if valid, false otherwise (FHIR_ERROR_MISSING_REQUIRED_FIELD
+ *         naming the first missing member)
+ */
+bool fhir_schema_validate(const FHIRSchema* schema, const void* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_SCHEMA_H */
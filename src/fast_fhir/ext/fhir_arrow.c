@@ -0,0 +1,611 @@
+/**
+ * @file fhir_arrow.c
+ * @brief Apache Arrow export of parsed resources through the Arrow C Data Interface
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_arrow.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Exported memory is released by the consumer, possibly on another thread and
+// after any arena current here is gone, so it always comes from malloc/free.
+
+#define ARROW_MAX_BUFFERS 3
+
+typedef struct {
+    void* buffers[ARROW_MAX_BUFFERS];
+    const void* buffer_pointers[ARROW_MAX_BUFFERS];
+    struct ArrowArray* child_storage;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+} ArrowArrayPrivate;
+
+typedef struct {
+    char* name;
+    struct ArrowSchema* child_storage;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+} ArrowSchemaPrivate;
+
+/* ========================================================================== */
+/* Arrays and Schemas                                                         */
+/* ========================================================================== */
+
+static void release_array(struct ArrowArray* array) {
+    ArrowArrayPrivate* private_data = array->private_data;
+
+    for (int64_t i = 0; i < array->n_children; i++) {
+        if (private_data->children[i]->release) {
+            private_data->children[i]->release(private_data->children[i]);
+        }
+    }
+    if (private_data->dictionary && private_data->dictionary->release) {
+        private_data->dictionary->release(private_data->dictionary);
+    }
+    for (int i = 0; i < ARROW_MAX_BUFFERS; i++) {
+        free(private_data->buffers[i]);
+    }
+    free(private_data->child_storage);
+    free(private_data->children);
+    free(private_data->dictionary);
+    free(private_data);
+    array->release = NULL;
+}
+
+static bool array_init(struct ArrowArray* array, int64_t length, int64_t n_buffers, int64_t n_children) {
+    memset(array, 0, sizeof(struct ArrowArray));
+
+    ArrowArrayPrivate* private_data = calloc(1, sizeof(ArrowArrayPrivate));
+    if (!private_data) return false;
+    if (n_children > 0) {
+        private_data->child_storage = calloc((size_t)n_children, sizeof(struct ArrowArray));
+        private_data->children = calloc((size_t)n_children, sizeof(struct ArrowArray*));
+        if (!private_data->child_storage || !private_data->children) {
+            free(private_data->child_storage);
+            free(private_data->children);
+            free(private_data);
+            return false;
+        }
+        for (int64_t i = 0; i < n_children; i++) {
+            private_data->children[i] = &private_data->child_storage[i];
+        }
+    }
+
+    array->length = length;
+    array->n_buffers = n_buffers;
+    array->n_children = n_children;
+    array->buffers = private_data->buffer_pointers;
+    array->children = private_data->children;
+    array->release = release_array;
+    array->private_data = private_data;
+    return true;
+}
+
+// Hand an owned buffer to an array
+static void array_set_buffer(struct ArrowArray* array, int index, void* buffer) {
+    ArrowArrayPrivate* private_data = array->private_data;
+    private_data->buffers[index] = buffer;
+    private_data->buffer_pointers[index] = buffer;
+}
+
+static struct ArrowArray* array_add_dictionary(struct ArrowArray* array) {
+    ArrowArrayPrivate* private_data = array->private_data;
+    private_data->dictionary = calloc(1, sizeof(struct ArrowArray));
+    array->dictionary = private_data->dictionary;
+    return private_data->dictionary;
+}
+
+static void release_schema(struct ArrowSchema* schema) {
+    ArrowSchemaPrivate* private_data = schema->private_data;
+
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        if (private_data->children[i]->release) {
+            private_data->children[i]->release(private_data->children[i]);
+        }
+    }
+    if (private_data->dictionary && private_data->dictionary->release) {
+        private_data->dictionary->release(private_data->dictionary);
+    }
+    free(private_data->name);
+    free(private_data->child_storage);
+    free(private_data->children);
+    free(private_data->dictionary);
+    free(private_data);
+    schema->release = NULL;
+}
+
+// Format strings are static literals; names are copied
+static bool schema_init(struct ArrowSchema* schema, const char* format, const char* name,
+                        int64_t flags, int64_t n_children) {
+    memset(schema, 0, sizeof(struct ArrowSchema));
+
+    ArrowSchemaPrivate* private_data = calloc(1, sizeof(ArrowSchemaPrivate));
+    if (!private_data) return false;
+    private_data->name = malloc(strlen(name) + 1);
+    if (n_children > 0) {
+        private_data->child_storage = calloc((size_t)n_children, sizeof(struct ArrowSchema));
+        private_data->children = calloc((size_t)n_children, sizeof(struct ArrowSchema*));
+    }
+    if (!private_data->name || (n_children > 0 && (!private_data->child_storage || !private_data->children))) {
+        free(private_data->name);
+        free(private_data->child_storage);
+        free(private_data->children);
+        free(private_data);
+        return false;
+    }
+    strcpy(private_data->name, name);
+    for (int64_t i = 0; i < n_children; i++) {
+        private_data->children[i] = &private_data->child_storage[i];
+    }
+
+    schema->format = format;
+    schema->name = private_data->name;
+    schema->flags = flags;
+    schema->n_children = n_children;
+    schema->children = private_data->children;
+    schema->release = release_schema;
+    schema->private_data = private_data;
+    return true;
+}
+
+// Give a dictionary-encoded field its value type
+static bool schema_add_dictionary(struct ArrowSchema* schema, const char* format) {
+    ArrowSchemaPrivate* private_data = schema->private_data;
+    private_data->dictionary = calloc(1, sizeof(struct ArrowSchema));
+    if (!private_data->dictionary ||
+        !schema_init(private_data->dictionary, format, "", ARROW_FLAG_NULLABLE, 0)) {
+        return false;
+    }
+    schema->dictionary = private_data->dictionary;
+    return true;
+}
+
+// Release whatever part of an export was produced before a failure
+static bool export_failed(struct ArrowSchema* schema, struct ArrowArray* array) {
+    if (schema->release) schema->release(schema);
+    if (array->release) array->release(array);
+    FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to build Arrow record batch");
+    return false;
+}
+
+/* ========================================================================== */
+/* Column Builders                                                            */
+/* ========================================================================== */
+
+static uint8_t* bitmap_create(size_t length) {
+    return calloc((length + 7) / 8 + 1, 1);
+}
+
+static void bitmap_set(uint8_t* bitmap, size_t index) {
+    bitmap[index / 8] |= (uint8_t)(1u << (index % 8));
+}
+
+// Variable-length UTF-8 column (format "u", 32-bit offsets)
+typedef struct {
+    uint8_t* validity;
+    int32_t* offsets;
+    char* data;
+    size_t data_length;
+    size_t data_capacity;
+    size_t length;
+    int64_t null_count;
+    bool failed;
+} StringColumn;
+
+static void string_column_init(StringColumn* column, size_t rows) {
+    memset(column, 0, sizeof(StringColumn));
+    column->validity = bitmap_create(rows);
+    column->offsets = malloc((rows + 1) * sizeof(int32_t));
+    column->data_capacity = rows * 8 + 64;
+    column->data = malloc(column->data_capacity);
+    column->failed = !column->validity || !column->offsets || !column->data;
+    if (!column->failed) column->offsets[0] = 0;
+}
+
+static void string_column_append(StringColumn* column, const char* value) {
+    if (column->failed) return;
+
+    size_t length = value ? strlen(value) : 0;
+    if (column->data_length + length > INT32_MAX) {
+        column->failed = true;
+        return;
+    }
+    if (column->data_length + length > column->data_capacity) {
+        size_t capacity = column->data_capacity * 2;
+        while (capacity < column->data_length + length) capacity *= 2;
+        char* data = realloc(column->data, capacity);
+        if (!data) {
+            column->failed = true;
+            return;
+        }
+        column->data = data;
+        column->data_capacity = capacity;
+    }
+
+    if (value) {
+        memcpy(column->data + column->data_length, value, length);
+        column->data_length += length;
+        bitmap_set(column->validity, column->length);
+    } else {
+        column->null_count++;
+    }
+    column->offsets[++column->length] = (int32_t)column->data_length;
+}
+
+// Move a built column into an array, or free it on failure
+static bool string_column_finish(StringColumn* column, struct ArrowArray* array) {
+    if (column->failed || !array_init(array, (int64_t)column->length, 3, 0)) {
+        free(column->validity);
+        free(column->offsets);
+        free(column->data);
+        return false;
+    }
+    array->null_count = column->null_count;
+    array_set_buffer(array, 0, column->validity);
+    array_set_buffer(array, 1, column->offsets);
+    array_set_buffer(array, 2, column->data);
+    return true;
+}
+
+// Fixed-width or boolean column: validity bitmap plus one values buffer
+static bool values_column_finish(struct ArrowArray* array, size_t length, int64_t null_count,
+                                 uint8_t* validity, void* values) {
+    if (!validity || !values || !array_init(array, (int64_t)length, 2, 0)) {
+        free(validity);
+        free(values);
+        return false;
+    }
+    array->null_count = null_count;
+    array_set_buffer(array, 0, validity);
+    array_set_buffer(array, 1, values);
+    return true;
+}
+
+// Dictionary-encoded column: int32 indices (FHIR_OBSERVATION_COLUMNS_NONE is null) and UTF-8 values
+static bool dictionary_column_export(struct ArrowArray* array, const uint32_t* ids, const size_t* rows,
+                                     size_t row_count, const char* const* values, size_t value_count) {
+    uint8_t* validity = bitmap_create(row_count);
+    int32_t* indices = calloc(row_count + 1, sizeof(int32_t));
+    int64_t null_count = 0;
+    if (validity && indices) {
+        for (size_t i = 0; i < row_count; i++) {
+            uint32_t id = ids[rows[i]];
+            if (id == FHIR_OBSERVATION_COLUMNS_NONE || id > INT32_MAX) {
+                null_count++;
+            } else {
+                indices[i] = (int32_t)id;
+                bitmap_set(validity, i);
+            }
+        }
+    }
+    if (!values_column_finish(array, row_count, null_count, validity, indices)) return false;
+
+    struct ArrowArray* dictionary = array_add_dictionary(array);
+    if (!dictionary) return false;
+
+    StringColumn column;
+    string_column_init(&column, value_count);
+    for (size_t i = 0; i < value_count; i++) {
+        string_column_append(&column, values[i]);
+    }
+    return string_column_finish(&column, dictionary);
+}
+
+/* ========================================================================== */
+/* Patient Export                                                             */
+/* ========================================================================== */
+
+typedef enum {
+    PATIENT_COLUMN_STRING,
+    PATIENT_COLUMN_BOOLEAN
+} PatientColumnKind;
+
+// One flattened FHIRPatient field; boolean getters return -1 for null
+typedef struct {
+    const char* name;
+    PatientColumnKind kind;
+    const char* (*get_string)(const FHIRPatient* patient);
+    int (*get_boolean)(const FHIRPatient* patient);
+} PatientColumn;
+
+static const char* patient_id(const FHIRPatient* patient) {
+    return patient->base.id;
+}
+
+static int patient_active(const FHIRPatient* patient) {
+    return patient->active ? patient->active->value : -1;
+}
+
+// Unknown gender is how an absent gender is stored, as in fhir_patient_to_json
+static const char* patient_gender(const FHIRPatient* patient) {
+    return patient->gender == FHIR_PATIENT_GENDER_UNKNOWN ? NULL : fhir_patient_gender_to_string(patient->gender);
+}
+
+static const char* patient_birth_date(const FHIRPatient* patient) {
+    return patient->birth_date ? patient->birth_date->value : NULL;
+}
+
+static int patient_deceased_boolean(const FHIRPatient* patient) {
+    return patient->deceased_boolean ? patient->deceased_boolean->value : -1;
+}
+
+static const char* patient_deceased_date_time(const FHIRPatient* patient) {
+    return patient->deceased_date_time ? patient->deceased_date_time->value : NULL;
+}
+
+// Sub-structures go through the getters, which materialize lazily parsed Patients
+static const char* patient_family(const FHIRPatient* patient) {
+    const FHIRHumanName* name = fhir_patient_get_primary_name(patient);
+    return name && name->family_count > 0 ? name->family[0] : NULL;
+}
+
+static const char* patient_given(const FHIRPatient* patient) {
+    const FHIRHumanName* name = fhir_patient_get_primary_name(patient);
+    return name && name->given_count > 0 ? name->given[0] : NULL;
+}
+
+static const char* patient_managing_organization(const FHIRPatient* patient) {
+    const FHIRReference* organization = fhir_patient_get_managing_organization(patient);
+    return organization ? organization->reference : NULL;
+}
+
+static const PatientColumn g_patient_columns[] = {
+    {"id", PATIENT_COLUMN_STRING, patient_id, NULL},
+    {"active", PATIENT_COLUMN_BOOLEAN, NULL, patient_active},
+    {"gender", PATIENT_COLUMN_STRING, patient_gender, NULL},
+    {"birth_date", PATIENT_COLUMN_STRING, patient_birth_date, NULL},
+    {"deceased_boolean", PATIENT_COLUMN_BOOLEAN, NULL, patient_deceased_boolean},
+    {"deceased_date_time", PATIENT_COLUMN_STRING, patient_deceased_date_time, NULL},
+    {"family", PATIENT_COLUMN_STRING, patient_family, NULL},
+    {"given", PATIENT_COLUMN_STRING, patient_given, NULL},
+    {"managing_organization", PATIENT_COLUMN_STRING, patient_managing_organization, NULL}
+};
+
+#define PATIENT_COLUMN_COUNT (sizeof(g_patient_columns) / sizeof(g_patient_columns[0]))
+
+static bool export_patient_column(const PatientColumn* definition, const FHIRPatient* const* patients,
+                                  size_t count, struct ArrowArray* array) {
+    if (definition->kind == PATIENT_COLUMN_STRING) {
+        StringColumn column;
+        string_column_init(&column, count);
+        for (size_t i = 0; i < count; i++) {
+            string_column_append(&column, definition->get_string(patients[i]));
+        }
+        return string_column_finish(&column, array);
+    }
+
+    uint8_t* validity = bitmap_create(count);
+    uint8_t* values = bitmap_create(count);
+    int64_t null_count = 0;
+    if (validity && values) {
+        for (size_t i = 0; i < count; i++) {
+            int value = definition->get_boolean(patients[i]);
+            if (value < 0) {
+                null_count++;
+                continue;
+            }
+            bitmap_set(validity, i);
+            if (value) bitmap_set(values, i);
+        }
+    }
+    return values_column_finish(array, count, null_count, validity, values);
+}
+
+bool fhir_arrow_export_patients(const FHIRPatient* const* patients, size_t count,
+                                struct ArrowSchema* schema, struct ArrowArray* array) {
+    if ((!patients && count > 0) || !schema || !array) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    memset(schema, 0, sizeof(struct ArrowSchema));
+    memset(array, 0, sizeof(struct ArrowArray));
+
+    if (!schema_init(schema, "+s", "", 0, PATIENT_COLUMN_COUNT) ||
+        !array_init(array, (int64_t)count, 1, PATIENT_COLUMN_COUNT)) {
+        return export_failed(schema, array);
+    }
+
+    for (size_t c = 0; c < PATIENT_COLUMN_COUNT; c++) {
+        const PatientColumn* definition = &g_patient_columns[c];
+        const char* format = definition->kind == PATIENT_COLUMN_STRING ? "u" : "b";
+        int64_t flags = c == 0 ? 0 : ARROW_FLAG_NULLABLE;  // Resource id is required
+        if (!schema_init(schema->children[c], format, definition->name, flags, 0) ||
+            !export_patient_column(definition, patients, count, array->children[c])) {
+            return export_failed(schema, array);
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Observation Export                                                         */
+/* ========================================================================== */
+
+typedef enum {
+    OBSERVATION_COLUMN_EFFECTIVE_TIME,
+    OBSERVATION_COLUMN_CODE_SYSTEM,
+    OBSERVATION_COLUMN_CODE,
+    OBSERVATION_COLUMN_VALUE,
+    OBSERVATION_COLUMN_UNIT,
+    OBSERVATION_COLUMN_SUBJECT,
+    OBSERVATION_COLUMN_STATUS,
+    OBSERVATION_COLUMN_COUNT
+} ObservationColumn;
+
+static const char* const g_observation_column_names[OBSERVATION_COLUMN_COUNT] = {
+    "effective_time", "code_system", "code", "value", "unit", "subject", "status"
+};
+
+static const char* const g_observation_status_values[] = {
+    "registered", "preliminary", "final", "amended",
+    "corrected", "cancelled", "entered-in-error", "unknown"
+};
+
+#define OBSERVATION_STATUS_COUNT (sizeof(g_observation_status_values) / sizeof(g_observation_status_values[0]))
+
+// Collect a dictionary's values in id order
+static const char** dictionary_values(const FHIRObservationColumns* columns, ObservationColumn column,
+                                      size_t* count) {
+    size_t capacity = 0;
+    if (column == OBSERVATION_COLUMN_CODE_SYSTEM || column == OBSERVATION_COLUMN_CODE) {
+        capacity = fhir_observation_columns_get_code_count(columns);
+    } else {
+        const char* (*get)(const FHIRObservationColumns*, uint32_t) =
+            column == OBSERVATION_COLUMN_UNIT ? fhir_observation_columns_get_unit
+                                              : fhir_observation_columns_get_subject;
+        while (get(columns, (uint32_t)capacity)) capacity++;
+    }
+
+    const char** values = malloc((capacity ? capacity : 1) * sizeof(char*));
+    if (!values) return NULL;
+    for (size_t id = 0; id < capacity; id++) {
+        const char* system = NULL;
+        const char* code = NULL;
+        switch (column) {
+            case OBSERVATION_COLUMN_CODE_SYSTEM:
+                fhir_observation_columns_get_code(columns, (uint32_t)id, &system, NULL);
+                values[id] = system;
+                break;
+            case OBSERVATION_COLUMN_CODE:
+                fhir_observation_columns_get_code(columns, (uint32_t)id, NULL, &code);
+                values[id] = code;
+                break;
+            case OBSERVATION_COLUMN_UNIT:
+                values[id] = fhir_observation_columns_get_unit(columns, (uint32_t)id);
+                break;
+            default:
+                values[id] = fhir_observation_columns_get_subject(columns, (uint32_t)id);
+                break;
+        }
+    }
+    *count = capacity;
+    return values;
+}
+
+static bool export_observation_column(const FHIRObservationColumns* columns, const FHIRObservationColumnView* view,
+                                      ObservationColumn column, const size_t* rows, size_t row_count,
+                                      struct ArrowArray* array) {
+    uint8_t* validity;
+    int64_t null_count = 0;
+
+    switch (column) {
+        case OBSERVATION_COLUMN_EFFECTIVE_TIME: {
+            validity = bitmap_create(row_count);
+            int64_t* times = calloc(row_count + 1, sizeof(int64_t));
+            if (validity && times) {
+                for (size_t i = 0; i < row_count; i++) {
+                    int64_t time = view->effective_time[rows[i]];
+                    if (time == FHIR_OBSERVATION_COLUMNS_NO_TIME) {
+                        null_count++;
+                    } else {
+                        times[i] = time;
+                        bitmap_set(validity, i);
+                    }
+                }
+            }
+            return values_column_finish(array, row_count, null_count, validity, times);
+        }
+
+        case OBSERVATION_COLUMN_VALUE: {
+            validity = bitmap_create(row_count);
+            double* values = calloc(row_count + 1, sizeof(double));
+            if (validity && values) {
+                for (size_t i = 0; i < row_count; i++) {
+                    double value = view->value[rows[i]];
+                    if (isnan(value)) {
+                        null_count++;
+                    } else {
+                        values[i] = value;
+                        bitmap_set(validity, i);
+                    }
+                }
+            }
+            return values_column_finish(array, row_count, null_count, validity, values);
+        }
+
+        case OBSERVATION_COLUMN_STATUS: {
+            validity = bitmap_create(row_count);
+            int8_t* indices = calloc(row_count + 1, sizeof(int8_t));
+            if (validity && indices) {
+                for (size_t i = 0; i < row_count; i++) {
+                    indices[i] = (int8_t)view->status[rows[i]];
+                    bitmap_set(validity, i);
+                }
+            }
+            if (!values_column_finish(array, row_count, 0, validity, indices)) return false;
+
+            struct ArrowArray* dictionary = array_add_dictionary(array);
+            if (!dictionary) return false;
+            StringColumn values;
+            string_column_init(&values, OBSERVATION_STATUS_COUNT);
+            for (size_t i = 0; i < OBSERVATION_STATUS_COUNT; i++) {
+                string_column_append(&values, g_observation_status_values[i]);
+            }
+            return string_column_finish(&values, dictionary);
+        }
+
+        default: {
+            size_t value_count = 0;
+            const char** values = dictionary_values(columns, column, &value_count);
+            if (!values) return false;
+
+            const uint32_t* ids = column == OBSERVATION_COLUMN_UNIT ? view->unit
+                                : column == OBSERVATION_COLUMN_SUBJECT ? view->subject
+                                : view->code;
+            bool ok = dictionary_column_export(array, ids, rows, row_count, values, value_count);
+            free(values);
+            return ok;
+        }
+    }
+}
+
+bool fhir_arrow_export_observation_columns(const FHIRObservationColumns* columns, const uint8_t* mask,
+                                           struct ArrowSchema* schema, struct ArrowArray* array) {
+    if (!columns || !schema || !array) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    memset(schema, 0, sizeof(struct ArrowSchema));
+    memset(array, 0, sizeof(struct ArrowArray));
+
+    FHIRObservationColumnView view;
+    fhir_observation_columns_get_view(columns, &view);
+
+    // Positions of the selected rows
+    size_t* rows = malloc((view.row_count ? view.row_count : 1) * sizeof(size_t));
+    if (!rows) return export_failed(schema, array);
+    size_t row_count = 0;
+    for (size_t i = 0; i < view.row_count; i++) {
+        if (!mask || mask[i]) rows[row_count++] = i;
+    }
+
+    bool ok = schema_init(schema, "+s", "", 0, OBSERVATION_COLUMN_COUNT) &&
+              array_init(array, (int64_t)row_count, 1, OBSERVATION_COLUMN_COUNT);
+    for (int c = 0; ok && c < OBSERVATION_COLUMN_COUNT; c++) {
+        struct ArrowSchema* field = schema->children[c];
+        const char* name = g_observation_column_names[c];
+        switch (c) {
+            case OBSERVATION_COLUMN_EFFECTIVE_TIME:
+                ok = schema_init(field, "tsm:UTC", name, ARROW_FLAG_NULLABLE, 0);
+                break;
+            case OBSERVATION_COLUMN_VALUE:
+                ok = schema_init(field, "g", name, ARROW_FLAG_NULLABLE, 0);
+                break;
+            case OBSERVATION_COLUMN_STATUS:
+                ok = schema_init(field, "c", name, ARROW_FLAG_NULLABLE, 0) && schema_add_dictionary(field, "u");
+                break;
+            default:
+                ok = schema_init(field, "i", name, ARROW_FLAG_NULLABLE, 0) && schema_add_dictionary(field, "u");
+                break;
+        }
+        ok = ok && export_observation_column(columns, &view, (ObservationColumn)c, rows, row_count,
+                                             array->children[c]);
+    }
+
+    free(rows);
+    return ok ? true : export_failed(schema, array);
+}
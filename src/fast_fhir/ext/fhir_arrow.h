@@ -0,0 +1,122 @@
+/**
+ * @file fhir_arrow.h
+ * @brief Apache Arrow export of parsed resources through the Arrow C Data Interface
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Turns a batch of parsed resources of one type into a single Arrow record
+ * batch: a struct array with one flat child column per field, exported as
+ * an ArrowSchema/ArrowArray pair. Consumers (pyarrow, Polars, DuckDB, ...)
+ * import the pair without copying and without a per-row object.
+ *
+ * The flattening schemas follow the resource structs: Patient columns come
+ * from FHIRPatient (resources/fhir_patient.h) and Observation columns from
+ * the columnar store in fhir_observation_columns.h, whose code, unit and
+ * subject ids become dictionary-encoded arrays.
+ *
+ * Exported buffers are copies owned by the ArrowArray and are freed by its
+ * release callback, so the source resources may be freed right after export.
+ */
+
+#ifndef FHIR_ARROW_H
+#define FHIR_ARROW_H
+
+#include "common/fhir_common.h"
+#include "fhir_observation_columns.h"
+#include "resources/fhir_patient.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Arrow C Data Interface                                                     */
+/* ========================================================================== */
+
+// Definitions from the Arrow C Data Interface specification (ABI-stable)
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+/* ========================================================================== */
+/* Export                                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Export Patients as one record batch
+ *
+ * Columns: id, active, gender, birth_date, deceased_boolean,
+ * deceased_date_time, family and given (first name, first family and first
+ * given name) and managing_organization (reference).
+ *
+ * @param patients Patients to export (entries may not be NULL)
+ * @param count Number of patients
+ * @param schema Output schema; call schema->release when done
+ * @param array Output struct array; call array->release when done
+ * @return true on success, false on failure (FHIR_ERROR_OUT_OF_MEMORY)
+ */
+bool fhir_arrow_export_patients(const FHIRPatient* const* patients, size_t count,
+                                struct ArrowSchema* schema, struct ArrowArray* array);
+
+/**
+ * @brief Export rows of a columnar Observation store as one record batch
+ *
+ * Columns: effective_time (timestamp[ms, UTC]), code_system and code
+ * (dictionary-encoded, sharing the code ids), value (float64), unit and
+ * subject (dictionary-encoded) and status (dictionary-encoded).
+ *
+ * @param columns Store to export
+ * @param mask Rows to export (NULL for all rows), as used by the filter kernels
+ * @param schema Output schema; call schema->release when done
+ * @param array Output struct array; call array->release when done
+ * @return true on success, false on failure (FHIR_ERROR_OUT_OF_MEMORY)
+ */
+bool fhir_arrow_export_observation_columns(const FHIRObservationColumns* columns, const uint8_t* mask,
+                                           struct ArrowSchema* schema, struct ArrowArray* array);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_ARROW_H */
@@ -0,0 +1,308 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_arrow.h"
+#include "fhir_ndjson.h"
+#include "fhir_observation_columns.h"
+#include "resources/fhir_patient.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Python wrapper exporting NDJSON resources as Arrow record batches (PyCapsule interface)
+
+typedef struct {
+    PyObject_HEAD
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+} ArrowBatch;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* batch_type;
+} ArrowModuleState;
+
+static void ArrowBatch_dealloc(ArrowBatch* self) {
+    if (self->schema.release) self->schema.release(&self->schema);
+    if (self->array.release) self->array.release(&self->array);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static void release_schema_capsule(PyObject* capsule) {
+    struct ArrowSchema* schema = PyCapsule_GetPointer(capsule, "arrow_schema");
+    if (schema->release) schema->release(schema);
+    free(schema);
+}
+
+static void release_array_capsule(PyObject* capsule) {
+    struct ArrowArray* array = PyCapsule_GetPointer(capsule, "arrow_array");
+    if (array->release) array->release(array);
+    free(array);
+}
+
+// Move the batch into a (schema, array) capsule pair; a batch can be exported once
+static PyObject* ArrowBatch_arrow_c_array(ArrowBatch* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"requested_schema", NULL};
+    PyObject* requested_schema = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &requested_schema)) {
+        return NULL;
+    }
+    if (requested_schema != Py_None) {
+        PyErr_SetString(PyExc_NotImplementedError, "Casting to a requested schema is not supported");
+        return NULL;
+    }
+
+    struct ArrowSchema* schema = malloc(sizeof(struct ArrowSchema));
+    struct ArrowArray* array = malloc(sizeof(struct ArrowArray));
+    if (!schema || !array) {
+        free(schema);
+        free(array);
+        return PyErr_NoMemory();
+    }
+
+    // Two threads may race to export the same batch; one of them wins
+    bool exported = false;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (self->array.release) {
+        *schema = self->schema;
+        *array = self->array;
+        self->schema.release = NULL;
+        self->array.release = NULL;
+        exported = true;
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (!exported) {
+        free(schema);
+        free(array);
+        PyErr_SetString(PyExc_RuntimeError, "ArrowBatch has already been exported");
+        return NULL;
+    }
+
+    PyObject* schema_capsule = PyCapsule_New(schema, "arrow_schema", release_schema_capsule);
+    if (!schema_capsule) {
+        schema->release(schema);
+        free(schema);
+        array->release(array);
+        free(array);
+        return NULL;
+    }
+    PyObject* array_capsule = PyCapsule_New(array, "arrow_array", release_array_capsule);
+    if (!array_capsule) {
+        Py_DECREF(schema_capsule);
+        array->release(array);
+        free(array);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", schema_capsule, array_capsule);
+}
+
+static PyObject* ArrowBatch_num_rows(ArrowBatch* self, void* Py_UNUSED(closure)) {
+    return PyLong_FromLongLong(self->array.release ? self->array.length : 0);
+}
+
+static PyMethodDef ArrowBatchMethods[] = {
+    {"__arrow_c_array__", (PyCFunction)ArrowBatch_arrow_c_array, METH_VARARGS | METH_KEYWORDS,
+     "Export as (schema, array) PyCapsules of the Arrow C Data Interface"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef ArrowBatchGetSet[] = {
+    {"num_rows", (getter)ArrowBatch_num_rows, NULL, "Number of rows (0 once exported)", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot ArrowBatchSlots[] = {
+    {Py_tp_doc, "Arrow record batch of parsed resources, consumed by pyarrow.record_batch()"},
+    {Py_tp_dealloc, ArrowBatch_dealloc},
+    {Py_tp_methods, ArrowBatchMethods},
+    {Py_tp_getset, ArrowBatchGetSet},
+    {0, NULL}
+};
+
+static PyType_Spec ArrowBatchSpec = {
+    .name = "fhir_arrow_c.ArrowBatch",
+    .basicsize = sizeof(ArrowBatch),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = ArrowBatchSlots,
+};
+
+// Parse every Patient line of a file and export them (runs without the GIL)
+static bool export_patient_file(const char* path, const FHIRNDJSONOptions* options, ArrowBatch* batch) {
+    FHIRNDJSONReader* reader = fhir_ndjson_open(path, options);
+    if (!reader) return false;
+
+    FHIRPatient** patients = NULL;
+    size_t patient_count = 0;
+    size_t patient_capacity = 0;
+    bool ok = true;
+    FHIRNDJSONResult* results;
+    size_t count;
+
+    while (ok && (results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            if (results[i].resource_type != FHIR_RESOURCE_TYPE_PATIENT || !results[i].resource) {
+                continue;
+            }
+            if (patient_count == patient_capacity) {
+                size_t capacity = patient_capacity ? patient_capacity * 2 : 1024;
+                FHIRPatient** grown = realloc(patients, capacity * sizeof(FHIRPatient*));
+                if (!grown) {
+                    FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Patient list");
+                    ok = false;
+                    break;
+                }
+                patients = grown;
+                patient_capacity = capacity;
+            }
+            // Take the resource so the reader does not release it with the batch
+            patients[patient_count++] = (FHIRPatient*)results[i].resource;
+            results[i].resource = NULL;
+        }
+    }
+    fhir_ndjson_close(reader);
+
+    ok = ok && fhir_arrow_export_patients((const FHIRPatient* const*)patients, patient_count,
+                                          &batch->schema, &batch->array);
+    for (size_t i = 0; i < patient_count; i++) {
+        fhir_resource_release(&patients[i]->base);
+    }
+    free(patients);
+    return ok;
+}
+
+// Load every Observation line of a file into a columnar store and export it (runs without the GIL)
+static bool export_observation_file(const char* path, const FHIRNDJSONOptions* options, ArrowBatch* batch) {
+    FHIRObservationColumns* columns = fhir_observation_columns_create();
+    if (!columns) return false;
+
+    bool ok = fhir_observation_columns_load_ndjson(columns, path, options, NULL) &&
+              fhir_arrow_export_observation_columns(columns, NULL, &batch->schema, &batch->array);
+    fhir_observation_columns_destroy(columns);
+    return ok;
+}
+
+// Read one resource type from an NDJSON file into an ArrowBatch
+static PyObject* py_read_ndjson(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "resource_type", "threads", NULL};
+    PyObject* path = NULL;
+    const char* resource_type = "Patient";
+    Py_ssize_t threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|sn", kwlist, PyUnicode_FSConverter, &path,
+                                     &resource_type, &threads)) {
+        return NULL;
+    }
+    if (threads < 0) {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0");
+        return NULL;
+    }
+
+    bool (*export_file)(const char*, const FHIRNDJSONOptions*, ArrowBatch*);
+    if (strcmp(resource_type, "Patient") == 0) {
+        export_file = export_patient_file;
+    } else if (strcmp(resource_type, "Observation") == 0) {
+        export_file = export_observation_file;
+    } else {
+        Py_DECREF(path);
+        PyErr_Format(PyExc_ValueError, "Arrow export is not supported for %s", resource_type);
+        return NULL;
+    }
+
+    ArrowModuleState* state = PyModule_GetState(self);
+    ArrowBatch* batch = PyObject_New(ArrowBatch, state->batch_type);
+    if (!batch) {
+        Py_DECREF(path);
+        return NULL;
+    }
+    batch->schema.release = NULL;
+    batch->array.release = NULL;
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = (size_t)threads;
+    options.validate = false;
+
+    bool ok;
+    FHIRErrorCode error_code = FHIR_ERROR_NONE;
+    Py_BEGIN_ALLOW_THREADS
+    ok = export_file(PyBytes_AS_STRING(path), &options, batch);
+    if (!ok) {
+        // Failed allocations leave no error set
+        const FHIRError* error = fhir_get_last_error();
+        error_code = error ? error->code : FHIR_ERROR_OUT_OF_MEMORY;
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!ok) {
+        Py_DECREF(batch);
+        if (error_code == FHIR_ERROR_OUT_OF_MEMORY) {
+            Py_DECREF(path);
+            return PyErr_NoMemory();
+        }
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_DECREF(path);
+    return (PyObject*)batch;
+}
+
+static PyMethodDef ArrowModuleMethods[] = {
+    {"read_ndjson", (PyCFunction)py_read_ndjson, METH_VARARGS | METH_KEYWORDS,
+     "Read the Patient or Observation lines of an NDJSON file into an ArrowBatch"},
+    {NULL, NULL, 0, NULL}
+};
+
+static int arrow_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    ArrowModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->batch_type);
+    return 0;
+}
+
+static int arrow_module_clear(PyObject* module) {
+    ArrowModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->batch_type);
+    return 0;
+}
+
+static void arrow_module_free(void* module) {
+    arrow_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int arrow_module_exec(PyObject* module) {
+    ArrowModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    // Register the typed resources available to the reader (once per process)
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+    fhir_clear_error();
+
+    state->batch_type = fhir_python_add_type(module, &ArrowBatchSpec);
+    return state->batch_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot arrow_module_slots[] = FHIR_PY_MODULE_SLOTS(arrow_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_arrow_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_arrow_c",
+    "Apache Arrow export of parsed FHIR resources in C",
+    sizeof(ArrowModuleState),
+    ArrowModuleMethods,
+    arrow_module_slots,
+    arrow_module_traverse,
+    arrow_module_clear,
+    arrow_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_arrow_c(void) {
+    return PyModuleDef_Init(&fhir_arrow_module);
+}
@@ -0,0 +1,268 @@
+/**
+ * @file fhir_batch.c
+ * @brief Parsed batches encoded into one buffer for handoff between processes
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_batch.h"
+#include "common/fhir_resource_type_lookup.h"
+#include <string.h>
+
+#define FHIR_BATCH_HEADER_SIZE 24
+#define FHIR_BATCH_ENTRY_SIZE 16
+#define FHIR_BATCH_ALIGNMENT 8
+
+typedef struct {
+    size_t offset;
+    size_t length;
+} FHIRBatchEntry;
+
+struct FHIRBatchWriter {
+    FHIRBatchEntry* entries;
+    size_t count;
+    size_t entry_capacity;
+    uint8_t* data;              /**< Documents, each starting 8-byte aligned */
+    size_t data_bytes;
+    size_t data_capacity;
+};
+
+/* ========================================================================== */
+/* Byte Order                                                                 */
+/* ========================================================================== */
+
+static void store_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void store_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t load_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint64_t load_u64(const uint8_t* in) {
+    return (uint64_t)load_u32(in) | ((uint64_t)load_u32(in + 4) << 32);
+}
+
+static size_t align_up(size_t value) {
+    return (value + FHIR_BATCH_ALIGNMENT - 1) & ~(size_t)(FHIR_BATCH_ALIGNMENT - 1);
+}
+
+/* ========================================================================== */
+/* Writing                                                                    */
+/* ========================================================================== */
+
+FHIRBatchWriter* fhir_batch_writer_create(void) {
+    FHIRBatchWriter* writer = fhir_calloc(1, sizeof(FHIRBatchWriter));
+    if (!writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate batch writer");
+    }
+    return writer;
+}
+
+void fhir_batch_writer_destroy(FHIRBatchWriter* writer) {
+    if (!writer) return;
+
+    fhir_free(writer->entries);
+    fhir_free(writer->data);
+    fhir_free(writer);
+}
+
+// Append a document the caller has already checked
+static bool append_document(FHIRBatchWriter* writer, const uint8_t* document, size_t length) {
+    if (length > UINT32_MAX) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Resource too large for batch");
+        return false;
+    }
+    if (writer->count == writer->entry_capacity) {
+        size_t capacity = writer->entry_capacity ? writer->entry_capacity * 2 : 64;
+        FHIRBatchEntry* entries = fhir_realloc(writer->entries, capacity * sizeof(FHIRBatchEntry));
+        if (!entries) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow batch index");
+            return false;
+        }
+        writer->entries = entries;
+        writer->entry_capacity = capacity;
+    }
+
+    size_t offset = align_up(writer->data_bytes);
+    if (offset + length > writer->data_capacity) {
+        size_t capacity = writer->data_capacity ? writer->data_capacity : 4096;
+        while (capacity < offset + length) {
+            capacity *= 2;
+        }
+        uint8_t* data = fhir_realloc(writer->data, capacity);
+        if (!data) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow batch data");
+            return false;
+        }
+        writer->data = data;
+        writer->data_capacity = capacity;
+    }
+
+    memset(writer->data + writer->data_bytes, 0, offset - writer->data_bytes);
+    memcpy(writer->data + offset, document, length);
+    writer->data_bytes = offset + length;
+    writer->entries[writer->count].offset = offset;
+    writer->entries[writer->count].length = length;
+    writer->count++;
+    return true;
+}
+
+bool fhir_batch_writer_add(FHIRBatchWriter* writer, const void* document, size_t length) {
+    if (!writer || !document) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    // Only the document itself is stored, even if the buffer holds more
+    FHIRBinaryDocument view;
+    if (!fhir_binary_open(&view, document, length)) {
+        return false;
+    }
+    return append_document(writer, view.data, view.size);
+}
+
+bool fhir_batch_writer_add_json(FHIRBatchWriter* writer, const cJSON* json) {
+    if (!writer || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* type_name = fhir_json_get_string(json, "resourceType");
+    int type = type_name ? (int)fhir_resource_type_lookup(type_name, strlen(type_name))
+                         : FHIR_RESOURCE_TYPE_UNKNOWN;
+
+    FHIRBinaryWriter encoder;
+    uint8_t* data = NULL;
+    size_t length = 0;
+    if (fhir_binary_writer_init(&encoder, type, fhir_json_get_string(json, "id"))) {
+        encoder.flags |= FHIR_BINARY_FLAG_JSON;
+        if (fhir_binary_write_json_members(&encoder, json)) {
+            data = fhir_binary_writer_finish(&encoder, &length);
+        }
+    }
+    fhir_binary_writer_cleanup(&encoder);
+    if (!data) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to encode batch resource");
+        return false;
+    }
+
+    bool ok = append_document(writer, data, length);
+    fhir_free(data);
+    return ok;
+}
+
+size_t fhir_batch_writer_get_count(const FHIRBatchWriter* writer) {
+    return writer ? writer->count : 0;
+}
+
+size_t fhir_batch_writer_get_size(const FHIRBatchWriter* writer) {
+    if (!writer) return 0;
+    return FHIR_BATCH_HEADER_SIZE + writer->count * FHIR_BATCH_ENTRY_SIZE + writer->data_bytes;
+}
+
+size_t fhir_batch_writer_write(const FHIRBatchWriter* writer, void* buffer, size_t capacity) {
+    if (!writer || !buffer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return 0;
+    }
+    size_t size = fhir_batch_writer_get_size(writer);
+    if (capacity < size) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Buffer too small for batch");
+        return 0;
+    }
+
+    // Header and entries are a multiple of 8 bytes, so documents keep their alignment
+    uint8_t* out = buffer;
+    memcpy(out, FHIR_BATCH_MAGIC, 4);
+    store_u32(out + 4, FHIR_BATCH_VERSION);
+    store_u64(out + 8, writer->count);
+    store_u64(out + 16, writer->data_bytes);
+
+    uint8_t* entry = out + FHIR_BATCH_HEADER_SIZE;
+    for (size_t i = 0; i < writer->count; i++, entry += FHIR_BATCH_ENTRY_SIZE) {
+        store_u64(entry, writer->entries[i].offset);
+        store_u32(entry + 8, (uint32_t)writer->entries[i].length);
+        store_u32(entry + 12, 0);
+    }
+    if (writer->data_bytes > 0) {
+        memcpy(entry, writer->data, writer->data_bytes);
+    }
+    return size;
+}
+
+/* ========================================================================== */
+/* Reading                                                                    */
+/* ========================================================================== */
+
+bool fhir_batch_open(FHIRBatch* batch, const void* data, size_t length) {
+    if (!batch || !data) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const uint8_t* bytes = data;
+    if (length < FHIR_BATCH_HEADER_SIZE || memcmp(bytes, FHIR_BATCH_MAGIC, 4) != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed batch");
+        return false;
+    }
+    if (load_u32(bytes + 4) != FHIR_BATCH_VERSION) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Unsupported batch format version");
+        return false;
+    }
+
+    uint64_t count = load_u64(bytes + 8);
+    uint64_t data_bytes = load_u64(bytes + 16);
+    uint64_t available = length - FHIR_BATCH_HEADER_SIZE;
+    if (count > available / FHIR_BATCH_ENTRY_SIZE ||
+        data_bytes > available - count * FHIR_BATCH_ENTRY_SIZE) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed batch");
+        return false;
+    }
+
+    batch->entries = bytes + FHIR_BATCH_HEADER_SIZE;
+    batch->count = (size_t)count;
+    batch->data = batch->entries + count * FHIR_BATCH_ENTRY_SIZE;
+    batch->data_bytes = data_bytes;
+    return true;
+}
+
+size_t fhir_batch_get_count(const FHIRBatch* batch) {
+    return batch ? batch->count : 0;
+}
+
+bool fhir_batch_get(const FHIRBatch* batch, size_t index, FHIRBinaryDocument* document) {
+    if (!batch || !document || index >= batch->count) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Batch index out of range");
+        return false;
+    }
+
+    const uint8_t* entry = batch->entries + index * FHIR_BATCH_ENTRY_SIZE;
+    uint64_t offset = load_u64(entry);
+    uint32_t length = load_u32(entry + 8);
+    if (offset > batch->data_bytes || length > batch->data_bytes - offset) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed batch entry");
+        return false;
+    }
+    return fhir_binary_open(document, batch->data + offset, length);
+}
+
+cJSON* fhir_batch_get_json(const FHIRBatch* batch, size_t index) {
+    FHIRBinaryDocument document;
+    if (!fhir_batch_get(batch, index, &document)) {
+        return NULL;
+    }
+    if (!(document.flags & FHIR_BINARY_FLAG_JSON)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Batch document is not JSON-encoded");
+        return NULL;
+    }
+    return fhir_binary_to_json(&document);
+}
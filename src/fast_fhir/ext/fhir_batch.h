@@ -0,0 +1,163 @@
+/**
+ * @file fhir_batch.h
+ * @brief Parsed batches encoded into one buffer for handoff between processes
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * A batch is a run of binary-encoded resources (common/fhir_binary.h) with
+ * an offset index in front, laid out so it can be written straight into a
+ * caller's buffer, typically a shared memory segment, and read back in
+ * place by another process. Opening a batch only checks its header; each
+ * document is validated when it is read, and the reader never copies or
+ * allocates.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header    "FHBT", version u32, document count u64, data bytes u64
+ *   entries   16 bytes each, in the order documents were added: document
+ *             offset u64, document length u32, reserved u32
+ *   data      binary documents, 8-byte aligned
+ */
+
+#ifndef FHIR_BATCH_H
+#define FHIR_BATCH_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_binary.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FHIR_BATCH_MAGIC "FHBT"
+#define FHIR_BATCH_VERSION 1
+
+/**
+ * @brief Opaque batch builder
+ */
+typedef struct FHIRBatchWriter FHIRBatchWriter;
+
+/**
+ * @brief Validated view of an encoded batch (does not own the buffer)
+ */
+typedef struct {
+    const uint8_t* entries;
+    size_t count;
+    const uint8_t* data;
+    uint64_t data_bytes;
+} FHIRBatch;
+
+/* ========================================================================== */
+/* Writing                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty batch writer
+ * @return New writer or NULL on failure
+ */
+FHIRBatchWriter* fhir_batch_writer_create(void);
+
+/**
+ * @brief Destroy a writer and the documents it holds
+ * @param writer Writer to destroy (can be NULL)
+ */
+void fhir_batch_writer_destroy(FHIRBatchWriter* writer);
+
+/**
+ * @brief Append an encoded document (copied)
+ *
+ * Documents from a type's binary codec need that type registered to be
+ * decoded again; JSON documents (FHIR_BINARY_FLAG_JSON) can be read by any
+ * process.
+ *
+ * @param writer Writer instance
+ * @param document Binary document
+ * @param length Document length in bytes
+ * @return true on success, false on failure (FHIR_ERROR_PARSE_FAILED if the
+ *         document is malformed)
+ */
+bool fhir_batch_writer_add(FHIRBatchWriter* writer, const void* document, size_t length);
+
+/**
+ * @brief Append a resource from its JSON tree
+ * @param writer Writer instance
+ * @param json Resource JSON object (resourceType and id are optional)
+ * @return true on success, false on failure
+ */
+bool fhir_batch_writer_add_json(FHIRBatchWriter* writer, const cJSON* json);
+
+/**
+ * @brief Get the number of documents added
+ * @param writer Writer instance
+ * @return Number of documents
+ */
+size_t fhir_batch_writer_get_count(const FHIRBatchWriter* writer);
+
+/**
+ * @brief Get the size of the encoded batch
+ * @param writer Writer instance
+ * @return Bytes fhir_batch_writer_write needs
+ */
+size_t fhir_batch_writer_get_size(const FHIRBatchWriter* writer);
+
+/**
+ * @brief Write the batch into a buffer
+ * @param writer Writer instance
+ * @param buffer Destination (any alignment; 8-byte aligned keeps documents aligned)
+ * @param capacity Bytes available in buffer
+ * @return Bytes written, or 0 on failure (FHIR_ERROR_INVALID_ARGUMENT if the
+ *         buffer is smaller than fhir_batch_writer_get_size)
+ */
+size_t fhir_batch_writer_write(const FHIRBatchWriter* writer, void* buffer, size_t capacity);
+
+/* ========================================================================== */
+/* Reading                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Check a batch header and section sizes
+ * @param batch Output view into data
+ * @param data Buffer starting with a batch
+ * @param length Bytes available in data (may exceed the batch)
+ * @return true on success, false on failure (FHIR_ERROR_PARSE_FAILED)
+ */
+bool fhir_batch_open(FHIRBatch* batch, const void* data, size_t length);
+
+/**
+ * @brief Get the number of documents
+ * @param batch Batch view
+ * @return Number of documents
+ */
+size_t fhir_batch_get_count(const FHIRBatch* batch);
+
+/**
+ * @brief Open a document by position
+ * @param batch Batch view
+ * @param index Document index (< fhir_batch_get_count)
+ * @param document Output view into the batch buffer
+ * @return true on success, false if index is out of range or the document is corrupt
+ */
+bool fhir_batch_get(const FHIRBatch* batch, size_t index, FHIRBinaryDocument* document);
+
+/**
+ * @brief Decode a JSON document
+ *
+ * Documents from a type's binary codec are decoded with
+ * fhir_resource_from_binary instead.
+ *
+ * @param batch Batch view
+ * @param index Document index
+ * @return JSON object (caller must cJSON_Delete) or NULL on failure
+ *         (FHIR_ERROR_INVALID_ARGUMENT for a codec document)
+ */
+cJSON* fhir_batch_get_json(const FHIRBatch* batch, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_BATCH_H */
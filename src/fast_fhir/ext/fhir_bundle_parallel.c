@@ -0,0 +1,1065 @@
+/**
+ * @file fhir_bundle_parallel.c
+ * @brief Parallel deserialization of FHIR Bundle entries
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_bundle_parallel.h"
+#include "common/fhir_hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Entries a worker takes from its own range at a time
+#define FHIR_BUNDLE_PARALLEL_CLAIM_SIZE 16
+
+// Resources a validation worker claims at a time
+#define FHIR_VALIDATE_PARALLEL_CLAIM_SIZE 64
+
+// No entry (no dependency, no barrier)
+#define FHIR_TRANSACTION_NONE ((size_t)-1)
+
+// Seed of the transaction key index hash
+#define FHIR_TRANSACTION_HASH_SEED 14695981039346656037ULL
+
+// Range of entries still to be loaded by one worker; thieves take from the end
+typedef struct {
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+} FHIRBundleWorkRange;
+
+typedef struct {
+    FHIRParallelBundle* bundle;
+    const cJSON** entries;
+    FHIRBundleWorkRange* ranges;
+    size_t worker_count;
+} FHIRBundleWork;
+
+typedef struct {
+    FHIRBundleWork* work;
+    size_t index;
+} FHIRBundleWorker;
+
+/* ========================================================================== */
+/* Entry Processing                                                           */
+/* ========================================================================== */
+
+// Describe the calling thread's last error, or fallback if none is set
+static void format_last_error(char* message, size_t size, const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+
+    if (error && error->message && error->field) {
+        snprintf(message, size, "%s (%s)", error->message, error->field);
+    } else {
+        snprintf(message, size, "%s", error && error->message ? error->message : fallback);
+    }
+}
+
+static void set_result_error(FHIRBundleEntryResult* result, FHIRErrorCode code, const char* fallback) {
+    result->error_code = code;
+    format_last_error(result->error_message, sizeof(result->error_message), fallback);
+}
+
+static void process_entry(FHIRArena* arena, const cJSON* entry, FHIRBundleEntryResult* result) {
+    fhir_clear_error();
+
+    if (!cJSON_IsObject(entry)) {
+        result->error_code = FHIR_ERROR_INVALID_JSON;
+        snprintf(result->error_message, sizeof(result->error_message), "Bundle entry is not an object");
+        return;
+    }
+
+    result->full_url = fhir_json_get_string(entry, "fullUrl");
+    result->json = cJSON_GetObjectItemCaseSensitive(entry, "resource");
+    if (!result->json) {
+        // Entries such as DELETE requests carry no resource
+        return;
+    }
+
+    const char* type_name = fhir_json_get_string(result->json, "resourceType");
+    if (!cJSON_IsObject(result->json) || !type_name) {
+        result->error_code = FHIR_ERROR_MISSING_REQUIRED_FIELD;
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Missing required field (resourceType)");
+        return;
+    }
+
+    result->resource_type = fhir_resource_type_from_string(type_name);
+    if (fhir_resource_get_instance_size(result->resource_type) == 0) {
+        return;
+    }
+
+    FHIRResourceBase* resource = fhir_resource_parse_with_arena(arena, result->json);
+    if (!resource) {
+        set_result_error(result, FHIR_ERROR_PARSE_FAILED, "Failed to parse resource");
+        return;
+    }
+
+    // Anything validation allocates shares the resource's lifetime
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    bool valid = fhir_resource_validate(resource);
+    fhir_arena_set_current(previous);
+
+    if (!valid) {
+        set_result_error(result, FHIR_ERROR_VALIDATION_FAILED, "Validation failed");
+        return;
+    }
+    result->resource = resource;
+}
+
+/* ========================================================================== */
+/* Work Stealing                                                              */
+/* ========================================================================== */
+
+// Take the next few entries of a worker's own range
+static bool take_own(FHIRBundleWorkRange* range, size_t* begin, size_t* end) {
+    pthread_mutex_lock(&range->lock);
+    *begin = range->begin;
+    *end = range->end - range->begin > FHIR_BUNDLE_PARALLEL_CLAIM_SIZE
+               ? range->begin + FHIR_BUNDLE_PARALLEL_CLAIM_SIZE : range->end;
+    range->begin = *end;
+    pthread_mutex_unlock(&range->lock);
+    return *begin < *end;
+}
+
+// Move the back half of another worker's range into an empty own range
+static bool steal(FHIRBundleWork* work, size_t self) {
+    for (size_t offset = 1; offset < work->worker_count; offset++) {
+        FHIRBundleWorkRange* victim = &work->ranges[(self + offset) % work->worker_count];
+
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->begin;
+        size_t end = victim->end;
+        victim->end -= remaining - remaining / 2;
+        size_t begin = victim->end;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            FHIRBundleWorkRange* own = &work->ranges[self];
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_worker(FHIRBundleWork* work, size_t self) {
+    FHIRArena* arena = work->bundle->arenas[self];
+    size_t begin, end;
+
+    do {
+        while (take_own(&work->ranges[self], &begin, &end)) {
+            for (size_t i = begin; i < end; i++) {
+                process_entry(arena, work->entries[i], &work->bundle->entries[i]);
+            }
+        }
+    } while (steal(work, self));
+}
+
+static void* worker_main(void* arg) {
+    FHIRBundleWorker* worker = arg;
+    run_worker(worker->work, worker->index);
+
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+/* ========================================================================== */
+/* Parsing                                                                    */
+/* ========================================================================== */
+
+void fhir_parallel_bundle_free(FHIRParallelBundle* bundle) {
+    if (!bundle) return;
+
+    if (bundle->arenas) {
+        for (size_t i = 0; i < bundle->thread_count; i++) {
+            fhir_arena_destroy(bundle->arenas[i]);
+        }
+        fhir_free(bundle->arenas);
+    }
+    fhir_free(bundle->entries);
+    fhir_free(bundle);
+}
+
+static FHIRParallelBundle* bundle_create(size_t entry_count, size_t thread_count) {
+    FHIRParallelBundle* bundle = fhir_calloc(1, sizeof(FHIRParallelBundle));
+    if (!bundle) return NULL;
+
+    bundle->entry_count = entry_count;
+    bundle->thread_count = thread_count;
+    bundle->entries = fhir_calloc(entry_count ? entry_count : 1, sizeof(FHIRBundleEntryResult));
+    bundle->arenas = fhir_calloc(thread_count, sizeof(FHIRArena*));
+    if (!bundle->entries || !bundle->arenas) {
+        fhir_parallel_bundle_free(bundle);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        bundle->arenas[i] = fhir_arena_create(0);
+        if (!bundle->arenas[i]) {
+            fhir_parallel_bundle_free(bundle);
+            return NULL;
+        }
+    }
+    return bundle;
+}
+
+FHIRParallelBundle* fhir_parse_bundle_parallel(const cJSON* json, size_t thread_count) {
+    const char* type_name = json ? fhir_json_get_string(json, "resourceType") : NULL;
+    if (!type_name || strcmp(type_name, "Bundle") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Not a Bundle");
+        return NULL;
+    }
+
+    // Index entry[] up front; cJSON arrays are linked lists
+    const cJSON* entry_array = cJSON_GetObjectItemCaseSensitive(json, "entry");
+    size_t entry_count = cJSON_IsArray(entry_array) ? (size_t)cJSON_GetArraySize(entry_array) : 0;
+
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+    // Workers with less than one claim of entries would only contend for locks
+    size_t useful = (entry_count + FHIR_BUNDLE_PARALLEL_CLAIM_SIZE - 1) / FHIR_BUNDLE_PARALLEL_CLAIM_SIZE;
+    if (thread_count > useful) thread_count = useful ? useful : 1;
+
+    FHIRParallelBundle* bundle = bundle_create(entry_count, thread_count);
+    const cJSON** entries = fhir_calloc(entry_count ? entry_count : 1, sizeof(cJSON*));
+    FHIRBundleWorkRange* ranges = fhir_calloc(thread_count, sizeof(FHIRBundleWorkRange));
+    FHIRBundleWorker* workers = fhir_calloc(thread_count, sizeof(FHIRBundleWorker));
+    pthread_t* threads = fhir_calloc(thread_count, sizeof(pthread_t));
+    bool* started = fhir_calloc(thread_count, sizeof(bool));
+    if (!bundle || !entries || !ranges || !workers || !threads || !started) {
+        fhir_parallel_bundle_free(bundle);
+        fhir_free(entries);
+        fhir_free(ranges);
+        fhir_free(workers);
+        fhir_free(threads);
+        fhir_free(started);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Bundle entry results");
+        return NULL;
+    }
+
+    size_t position = 0;
+    const cJSON* entry;
+    cJSON_ArrayForEach(entry, entry_array) {
+        entries[position++] = entry;
+    }
+
+    FHIRBundleWork work = { bundle, entries, ranges, thread_count };
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&ranges[i].lock, NULL);
+        ranges[i].begin = entry_count * i / thread_count;
+        ranges[i].end = entry_count * (i + 1) / thread_count;
+        workers[i].work = &work;
+        workers[i].index = i;
+    }
+
+    // The calling thread is worker 0; ranges of workers that fail to start are stolen
+    for (size_t i = 1; i < thread_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, worker_main, &workers[i]) == 0;
+    }
+    run_worker(&work, 0);
+    for (size_t i = 1; i < thread_count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    fhir_clear_error();
+
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_mutex_destroy(&ranges[i].lock);
+    }
+    for (size_t i = 0; i < entry_count; i++) {
+        if (bundle->entries[i].error_code != FHIR_ERROR_NONE) {
+            bundle->error_count++;
+        }
+    }
+
+    fhir_free(entries);
+    fhir_free(ranges);
+    fhir_free(workers);
+    fhir_free(threads);
+    fhir_free(started);
+    return bundle;
+}
+
+/* ========================================================================== */
+/* Batch Validation                                                           */
+/* ========================================================================== */
+
+typedef struct {
+    FHIRResourceBase* const* resources;
+    size_t count;
+    bool* results;
+    FHIRAtomicInt next_claim;
+} FHIRValidateWork;
+
+static void* validate_worker_main(void* arg) {
+    FHIRValidateWork* work = arg;
+    for (;;) {
+        size_t begin = (size_t)fhir_atomic_fetch_add_relaxed(&work->next_claim, 1) *
+                       FHIR_VALIDATE_PARALLEL_CLAIM_SIZE;
+        if (begin >= work->count) break;
+        size_t end = begin + FHIR_VALIDATE_PARALLEL_CLAIM_SIZE;
+        if (end > work->count) end = work->count;
+        for (size_t i = begin; i < end; i++) {
+            work->results[i] = fhir_resource_validate(work->resources[i]);
+        }
+    }
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+size_t fhir_validate_resources_parallel(FHIRResourceBase* const* resources, size_t count,
+                                        size_t thread_count, bool* results) {
+    if (count > 0 && (!resources || !results)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return count;
+    }
+
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+    // Workers with less than one claim of resources would only contend for the counter
+    size_t useful = (count + FHIR_VALIDATE_PARALLEL_CLAIM_SIZE - 1) / FHIR_VALIDATE_PARALLEL_CLAIM_SIZE;
+    if (thread_count > useful) thread_count = useful ? useful : 1;
+
+    FHIRValidateWork work = { resources, count, results, 0 };
+    fhir_atomic_init(&work.next_claim, 0);
+
+    // The calling thread works too; claims left by threads that fail to start are taken by the rest
+    pthread_t* threads = thread_count > 1 ? fhir_calloc(thread_count, sizeof(pthread_t)) : NULL;
+    bool* started = thread_count > 1 ? fhir_calloc(thread_count, sizeof(bool)) : NULL;
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, validate_worker_main, &work) == 0;
+    }
+    validate_worker_main(&work);
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    fhir_free(threads);
+    fhir_free(started);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        failed += !results[i];
+    }
+    return failed;
+}
+
+
+/* ========================================================================== */
+/* Transaction Scheduling                                                     */
+/* ========================================================================== */
+
+// What a request url addresses
+typedef enum {
+    FHIR_TRANSACTION_TARGET_INSTANCE = 0,  // "Type/id"
+    FHIR_TRANSACTION_TARGET_TYPE,          // Searches, conditional requests, operations
+    FHIR_TRANSACTION_TARGET_CREATE         // Unconditional POST of a new resource
+} FHIRTransactionTarget;
+
+typedef struct {
+    char* key;
+    size_t length;
+    uint64_t hash;
+    size_t value;
+} FHIRTransactionSlot;
+
+// Open-addressing map from a string key to an entry index
+typedef struct {
+    FHIRTransactionSlot* slots;
+    size_t capacity;  // Power of two, at least twice the number of keys
+} FHIRTransactionIndex;
+
+typedef struct {
+    size_t position;
+    int phase;                      // Processing order of the method, -1 if the request is invalid
+    bool write;
+    FHIRTransactionTarget target;
+    const char* type;               // Points into the request url
+    size_t type_length;
+    size_t key_length;              // Length of the "Type/id" url prefix of instance targets
+    size_t* dependents;
+    size_t dependent_count;
+    size_t dependent_capacity;
+    size_t pending;                 // Dependencies not completed yet
+    bool blocked;                   // A dependency did not succeed
+} FHIRTransactionNode;
+
+typedef struct {
+    FHIRTransactionResult* result;
+    FHIRTransactionNode* nodes;
+    const FHIRTransactionIndex* full_urls;
+    FHIRTransactionEntryCallback callback;
+    void* context;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    size_t* queue;                  // Entries whose dependencies completed, each pushed once
+    size_t head;
+    size_t tail;
+    size_t completed;
+    bool stopped;                   // A transaction entry failed; start nothing new
+} FHIRTransactionWork;
+
+static bool transaction_index_init(FHIRTransactionIndex* index, size_t key_count) {
+    size_t capacity = 16;
+    while (capacity < key_count * 2) capacity <<= 1;
+    index->slots = fhir_calloc(capacity, sizeof(FHIRTransactionSlot));
+    index->capacity = capacity;
+    return index->slots != NULL;
+}
+
+static void transaction_index_free(FHIRTransactionIndex* index) {
+    if (!index->slots) return;
+    for (size_t i = 0; i < index->capacity; i++) {
+        fhir_free(index->slots[i].key);
+    }
+    fhir_free(index->slots);
+}
+
+static FHIRTransactionSlot* transaction_index_slot(const FHIRTransactionIndex* index, const char* key,
+                                                   size_t length, uint64_t hash) {
+    size_t mask = index->capacity - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        FHIRTransactionSlot* slot = &index->slots[i];
+        if (!slot->key || (slot->hash == hash && slot->length == length &&
+                           memcmp(slot->key, key, length) == 0)) {
+            return slot;
+        }
+    }
+}
+
+static bool transaction_index_find(const FHIRTransactionIndex* index, const char* key, size_t length,
+                                   size_t* value) {
+    FHIRTransactionSlot* slot = transaction_index_slot(index, key, length,
+                                                       fhir_hash64(key, length, FHIR_TRANSACTION_HASH_SEED));
+    if (!slot->key) return false;
+    *value = slot->value;
+    return true;
+}
+
+// Map key to value, replacing an existing mapping
+static bool transaction_index_put(FHIRTransactionIndex* index, const char* key, size_t length, size_t value) {
+    uint64_t hash = fhir_hash64(key, length, FHIR_TRANSACTION_HASH_SEED);
+    FHIRTransactionSlot* slot = transaction_index_slot(index, key, length, hash);
+    if (!slot->key) {
+        slot->key = fhir_malloc(length + 1);
+        if (!slot->key) return false;
+        memcpy(slot->key, key, length);
+        slot->key[length] = '\0';
+        slot->length = length;
+        slot->hash = hash;
+    }
+    slot->value = value;
+    return true;
+}
+
+/* ========================================================================== */
+/* Transaction Dependencies                                                   */
+/* ========================================================================== */
+
+static bool add_dependency(FHIRTransactionNode* nodes, size_t from, size_t to) {
+    FHIRTransactionNode* node = &nodes[from];
+    if (node->dependent_count == node->dependent_capacity) {
+        size_t capacity = node->dependent_capacity ? node->dependent_capacity * 2 : 4;
+        size_t* dependents = fhir_realloc(node->dependents, capacity * sizeof(size_t));
+        if (!dependents) return false;
+        node->dependents = dependents;
+        node->dependent_capacity = capacity;
+    }
+    node->dependents[node->dependent_count++] = to;
+    nodes[to].pending++;
+    return true;
+}
+
+// Classify an entry's request; false if it is missing or unsupported
+static bool parse_transaction_request(const cJSON* item, FHIRTransactionEntryResult* entry,
+                                      FHIRTransactionNode* node) {
+    static const struct {
+        const char* name;
+        int phase;
+        bool write;
+    } methods[] = {
+        { "DELETE", 0, true }, { "POST", 1, true }, { "PUT", 2, true },
+        { "PATCH", 2, true }, { "GET", 3, false }, { "HEAD", 3, false }
+    };
+
+    // Invalid entries fail, so whatever references them is skipped
+    node->phase = -1;
+    node->write = true;
+    if (!cJSON_IsObject(item)) {
+        entry->error_code = FHIR_ERROR_INVALID_JSON;
+        snprintf(entry->error_message, sizeof(entry->error_message), "Bundle entry is not an object");
+        return false;
+    }
+
+    const cJSON* resource = cJSON_GetObjectItemCaseSensitive(item, "resource");
+    const cJSON* request = cJSON_GetObjectItemCaseSensitive(item, "request");
+    entry->full_url = fhir_json_get_string(item, "fullUrl");
+    entry->resource = cJSON_IsObject(resource) ? resource : NULL;
+    entry->method = cJSON_IsObject(request) ? fhir_json_get_string(request, "method") : NULL;
+    entry->url = cJSON_IsObject(request) ? fhir_json_get_string(request, "url") : NULL;
+    if (!entry->method || !entry->url) {
+        entry->error_code = FHIR_ERROR_MISSING_REQUIRED_FIELD;
+        snprintf(entry->error_message, sizeof(entry->error_message), "Missing required field (%s)",
+                 entry->method ? "request.url" : "request.method");
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(entry->method, methods[i].name) == 0) {
+            node->phase = methods[i].phase;
+            node->write = methods[i].write;
+            break;
+        }
+    }
+    if (node->phase < 0) {
+        entry->error_code = FHIR_ERROR_VALIDATION_FAILED;
+        snprintf(entry->error_message, sizeof(entry->error_message), "Unsupported request method (%s)",
+                 entry->method);
+        return false;
+    }
+
+    const char* url = entry->url;
+    while (*url == '/') url++;
+    node->type = url;
+    node->type_length = strcspn(url, "/?");
+    const char* id = url[node->type_length] == '/' ? url + node->type_length + 1 : NULL;
+    size_t id_length = id ? strcspn(id, "/?") : 0;
+
+    if (strchr(url, '?') || url[0] == '$' || (id && (id_length == 0 || id[0] == '$'))) {
+        node->target = FHIR_TRANSACTION_TARGET_TYPE;
+    } else if (id) {
+        node->target = FHIR_TRANSACTION_TARGET_INSTANCE;
+        node->key_length = node->type_length + 1 + id_length;
+    } else if (node->phase == 1 && !fhir_json_get_string(request, "ifNoneExist")) {
+        node->target = FHIR_TRANSACTION_TARGET_CREATE;
+    } else {
+        node->target = FHIR_TRANSACTION_TARGET_TYPE;
+    }
+    return true;
+}
+
+// Entry a reference names, with the rules of fhir_bundle_resolve_reference
+static size_t resolve_transaction_reference(const FHIRTransactionIndex* full_urls,
+                                            const FHIRTransactionIndex* type_ids, const char* reference) {
+    size_t target;
+    if (!reference[0] || reference[0] == '#') {
+        return FHIR_TRANSACTION_NONE;
+    }
+
+    size_t length = strlen(reference);
+    if (transaction_index_find(full_urls, reference, length, &target)) {
+        return target;
+    }
+    if (strchr(reference, ':')) {
+        return FHIR_TRANSACTION_NONE;
+    }
+
+    const char* history = strstr(reference, "/_history/");
+    if (history) {
+        length = (size_t)(history - reference);
+    }
+    return transaction_index_find(type_ids, reference, length, &target) ? target : FHIR_TRANSACTION_NONE;
+}
+
+// An entry runs after the writes its resource references
+static bool add_reference_dependencies(FHIRTransactionNode* nodes, const FHIRTransactionIndex* full_urls,
+                                       const FHIRTransactionIndex* type_ids, const cJSON* item, size_t self) {
+    const cJSON* child;
+    for (child = item->child; child; child = child->next) {
+        if (cJSON_IsString(child) && child->string && strcmp(child->string, "reference") == 0) {
+            size_t target = resolve_transaction_reference(full_urls, type_ids, child->valuestring);
+            if (target != FHIR_TRANSACTION_NONE && target != self && nodes[target].write &&
+                !add_dependency(nodes, target, self)) {
+                return false;
+            }
+        } else if (child->child && !add_reference_dependencies(nodes, full_urls, type_ids, child, self)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Order by type, then method phase, then Bundle position
+static int compare_transaction_nodes(const void* a, const void* b) {
+    const FHIRTransactionNode* x = *(const FHIRTransactionNode* const*)a;
+    const FHIRTransactionNode* y = *(const FHIRTransactionNode* const*)b;
+
+    int order = memcmp(x->type, y->type, x->type_length < y->type_length ? x->type_length : y->type_length);
+    if (order != 0) return order;
+    if (x->type_length != y->type_length) return x->type_length < y->type_length ? -1 : 1;
+    if (x->phase != y->phase) return x->phase < y->phase ? -1 : 1;
+    return x->position < y->position ? -1 : x->position > y->position;
+}
+
+/*
+ * Entries with the same target run in phase order. Within a type, a
+ * type-level write is a barrier: it runs after every earlier write of the
+ * type and everything later runs after it. Instance entries also chain on
+ * the last write of the same Type/id. Reads come last, so the first
+ * type-level read waits for the writes since the barrier and further
+ * type-level reads just wait for it, keeping the edge count linear.
+ */
+static bool add_order_dependencies(FHIRTransactionNode* nodes, size_t count, FHIRTransactionIndex* writers) {
+    FHIRTransactionNode** order = fhir_malloc((count ? count : 1) * sizeof(FHIRTransactionNode*));
+    size_t* since = fhir_malloc((count ? count : 1) * sizeof(size_t));
+    bool ok = order && since;
+
+    size_t valid = 0;
+    for (size_t i = 0; ok && i < count; i++) {
+        if (nodes[i].phase >= 0) order[valid++] = &nodes[i];
+    }
+    if (ok) qsort(order, valid, sizeof(FHIRTransactionNode*), compare_transaction_nodes);
+
+    size_t barrier = FHIR_TRANSACTION_NONE;
+    size_t first_search = FHIR_TRANSACTION_NONE;
+    size_t since_count = 0;
+    for (size_t i = 0; ok && i < valid; i++) {
+        FHIRTransactionNode* node = order[i];
+        size_t self = node->position;
+
+        if (i == 0 || node->type_length != order[i - 1]->type_length ||
+            memcmp(node->type, order[i - 1]->type, node->type_length) != 0) {
+            barrier = first_search = FHIR_TRANSACTION_NONE;
+            since_count = 0;
+        }
+
+        if (node->target == FHIR_TRANSACTION_TARGET_TYPE && !node->write && first_search != FHIR_TRANSACTION_NONE) {
+            ok = add_dependency(nodes, first_search, self);
+            continue;
+        }
+        if (barrier != FHIR_TRANSACTION_NONE) {
+            ok = add_dependency(nodes, barrier, self);
+        }
+
+        if (node->target == FHIR_TRANSACTION_TARGET_INSTANCE) {
+            size_t last;
+            if (ok && transaction_index_find(writers, node->type, node->key_length, &last)) {
+                ok = add_dependency(nodes, last, self);
+            }
+            if (ok && node->write) {
+                ok = transaction_index_put(writers, node->type, node->key_length, self);
+                since[since_count++] = self;
+            }
+        } else if (node->target == FHIR_TRANSACTION_TARGET_CREATE) {
+            since[since_count++] = self;
+        } else {
+            for (size_t j = 0; ok && j < since_count; j++) {
+                ok = add_dependency(nodes, since[j], self);
+            }
+            if (node->write) {
+                barrier = self;
+                since_count = 0;
+            } else {
+                first_search = self;
+            }
+        }
+    }
+
+    fhir_free(order);
+    fhir_free(since);
+    return ok;
+}
+
+// Parse the requests and add every dependency edge; false on allocation failure
+static bool build_transaction_graph(const cJSON* entry_array, FHIRTransactionResult* result,
+                                    FHIRTransactionNode* nodes, FHIRTransactionIndex* full_urls,
+                                    FHIRTransactionIndex* type_ids, FHIRTransactionIndex* writers) {
+    size_t position = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, entry_array) {
+        FHIRTransactionEntryResult* entry = &result->entries[position];
+        FHIRTransactionNode* node = &nodes[position];
+        node->position = position++;
+
+        if (!parse_transaction_request(item, entry, node)) {
+            entry->state = FHIR_TRANSACTION_ENTRY_FAILED;
+        }
+        size_t existing;
+        if (entry->full_url && !transaction_index_find(full_urls, entry->full_url, strlen(entry->full_url), &existing) &&
+            !transaction_index_put(full_urls, entry->full_url, strlen(entry->full_url), node->position)) {
+            return false;
+        }
+        if (!node->write) continue;
+
+        // Relative references name the last write of a Type/id in processing order
+        const char* type = entry->resource ? fhir_json_get_string(entry->resource, "resourceType") : NULL;
+        const char* id = entry->resource ? fhir_json_get_string(entry->resource, "id") : NULL;
+        char* key = NULL;
+        size_t key_length = 0;
+        if (type && id) {
+            key_length = strlen(type) + 1 + strlen(id);
+            key = fhir_malloc(key_length + 1);
+            if (!key) return false;
+            snprintf(key, key_length + 1, "%s/%s", type, id);
+        } else if (node->phase >= 0 && node->target == FHIR_TRANSACTION_TARGET_INSTANCE) {
+            key_length = node->key_length;
+        }
+        if (key_length > 0) {
+            const char* name = key ? key : node->type;
+            bool ok = true;
+            if (!transaction_index_find(type_ids, name, key_length, &existing) ||
+                nodes[existing].phase <= node->phase) {
+                ok = transaction_index_put(type_ids, name, key_length, node->position);
+            }
+            fhir_free(key);
+            if (!ok) return false;
+        }
+    }
+
+    for (size_t i = 0; i < result->entry_count; i++) {
+        const cJSON* resource = result->entries[i].resource;
+        if (nodes[i].phase >= 0 && resource &&
+            !add_reference_dependencies(nodes, full_urls, type_ids, resource, i)) {
+            return false;
+        }
+    }
+    return add_order_dependencies(nodes, result->entry_count, writers);
+}
+
+// Kahn's algorithm over a scratch copy of the pending counts
+static bool transaction_graph_is_acyclic(const FHIRTransactionNode* nodes, size_t count, size_t* queue,
+                                         bool* acyclic) {
+    size_t* pending = fhir_malloc((count ? count : 1) * sizeof(size_t));
+    if (!pending) return false;
+
+    size_t head = 0, tail = 0;
+    for (size_t i = 0; i < count; i++) {
+        pending[i] = nodes[i].pending;
+        if (pending[i] == 0) queue[tail++] = i;
+    }
+    while (head < tail) {
+        const FHIRTransactionNode* node = &nodes[queue[head++]];
+        for (size_t i = 0; i < node->dependent_count; i++) {
+            if (--pending[node->dependents[i]] == 0) queue[tail++] = node->dependents[i];
+        }
+    }
+
+    fhir_free(pending);
+    *acyclic = tail == count;
+    return true;
+}
+
+/* ========================================================================== */
+/* Transaction Execution                                                      */
+/* ========================================================================== */
+
+// Location a reference to a completed write's fullUrl is rewritten to, or NULL
+static const char* rewrite_target(const FHIRTransactionWork* work, const char* reference, size_t* target) {
+    size_t index;
+    if (!reference[0] || !transaction_index_find(work->full_urls, reference, strlen(reference), &index) ||
+        !work->nodes[index].write) {
+        return NULL;
+    }
+
+    // Dependencies completed before this entry was queued, under the work lock
+    const FHIRTransactionEntryResult* entry = &work->result->entries[index];
+    if (entry->state != FHIR_TRANSACTION_ENTRY_DONE || !entry->location || !entry->location[0]) {
+        return NULL;
+    }
+    *target = index;
+    return entry->location;
+}
+
+static size_t count_rewrites(const FHIRTransactionWork* work, const cJSON* item) {
+    size_t count = 0, target;
+    const cJSON* child;
+    for (child = item->child; child; child = child->next) {
+        if (cJSON_IsString(child) && child->string && strcmp(child->string, "reference") == 0) {
+            count += rewrite_target(work, child->valuestring, &target) != NULL;
+        } else if (child->child) {
+            count += count_rewrites(work, child);
+        }
+    }
+    return count;
+}
+
+// Rewrite references in copy, a duplicate of item walked in step with it
+static bool apply_rewrites(const FHIRTransactionWork* work, FHIRTransactionEntryResult* entry,
+                           const cJSON* item, cJSON* copy) {
+    const cJSON* child = item->child;
+    cJSON* copy_child = copy->child;
+    while (child && copy_child) {
+        cJSON* copy_next = copy_child->next;
+        size_t target;
+        const char* location = NULL;
+
+        if (cJSON_IsString(child) && child->string && strcmp(child->string, "reference") == 0) {
+            location = rewrite_target(work, child->valuestring, &target);
+        }
+        if (location) {
+            // References name the resource, not the version the write created
+            const char* history = strstr(location, "/_history/");
+            size_t length = history ? (size_t)(history - location) : strlen(location);
+            char* value = fhir_malloc(length + 1);
+            if (!value) return false;
+            memcpy(value, location, length);
+            value[length] = '\0';
+
+            cJSON* replacement = cJSON_CreateString(value);
+            fhir_free(value);
+            if (!replacement || !cJSON_ReplaceItemInObjectCaseSensitive(copy, "reference", replacement)) {
+                cJSON_Delete(replacement);
+                return false;
+            }
+            FHIRTransactionRewrite* rewrite = &entry->rewrites[entry->rewrite_count++];
+            rewrite->reference = child->valuestring;
+            rewrite->target = replacement->valuestring;
+            rewrite->target_entry = target;
+        } else if (child->child && !apply_rewrites(work, entry, child, copy_child)) {
+            return false;
+        }
+        child = child->next;
+        copy_child = copy_next;
+    }
+    return true;
+}
+
+static void run_transaction_entry(FHIRTransactionWork* work, size_t index) {
+    FHIRTransactionEntryResult* entry = &work->result->entries[index];
+    fhir_clear_error();
+
+    size_t count = entry->resource ? count_rewrites(work, entry->resource) : 0;
+    if (count > 0) {
+        entry->rewrites = fhir_calloc(count, sizeof(FHIRTransactionRewrite));
+        entry->rewritten = entry->rewrites ? cJSON_Duplicate(entry->resource, true) : NULL;
+        if (!entry->rewritten || !apply_rewrites(work, entry, entry->resource, entry->rewritten)) {
+            entry->state = FHIR_TRANSACTION_ENTRY_FAILED;
+            entry->error_code = FHIR_ERROR_OUT_OF_MEMORY;
+            snprintf(entry->error_message, sizeof(entry->error_message), "Failed to rewrite references");
+            return;
+        }
+        entry->resource = entry->rewritten;
+    }
+
+    if (work->callback(entry, index, work->context)) {
+        entry->state = FHIR_TRANSACTION_ENTRY_DONE;
+        return;
+    }
+    const FHIRError* error = fhir_get_last_error();
+    entry->state = FHIR_TRANSACTION_ENTRY_FAILED;
+    entry->error_code = error && error->code != FHIR_ERROR_NONE ? error->code : FHIR_ERROR_VALIDATION_FAILED;
+    format_last_error(entry->error_message, sizeof(entry->error_message), "Entry processing failed");
+}
+
+// Release an entry's dependents; called with the work lock held
+static void complete_transaction_entry(FHIRTransactionWork* work, size_t index) {
+    FHIRTransactionEntryState state = work->result->entries[index].state;
+    const FHIRTransactionNode* node = &work->nodes[index];
+
+    if (state == FHIR_TRANSACTION_ENTRY_FAILED && work->result->atomic) {
+        work->stopped = true;
+    }
+    for (size_t i = 0; i < node->dependent_count; i++) {
+        FHIRTransactionNode* dependent = &work->nodes[node->dependents[i]];
+        if (state != FHIR_TRANSACTION_ENTRY_DONE) {
+            dependent->blocked = true;
+        }
+        if (--dependent->pending == 0) {
+            work->queue[work->tail++] = node->dependents[i];
+            pthread_cond_signal(&work->ready);
+        }
+    }
+    if (++work->completed == work->result->entry_count) {
+        pthread_cond_broadcast(&work->ready);
+    }
+}
+
+static void* transaction_worker_main(void* arg) {
+    FHIRTransactionWork* work = arg;
+
+    pthread_mutex_lock(&work->lock);
+    for (;;) {
+        while (work->head == work->tail && work->completed < work->result->entry_count) {
+            pthread_cond_wait(&work->ready, &work->lock);
+        }
+        if (work->head == work->tail) break;
+
+        size_t index = work->queue[work->head++];
+        FHIRTransactionEntryResult* entry = &work->result->entries[index];
+        bool run = entry->state == FHIR_TRANSACTION_ENTRY_PENDING;
+        if (run && (work->nodes[index].blocked || work->stopped)) {
+            entry->state = FHIR_TRANSACTION_ENTRY_SKIPPED;
+            snprintf(entry->error_message, sizeof(entry->error_message), "%s",
+                     work->nodes[index].blocked ? "Skipped: a dependency failed" : "Skipped: transaction aborted");
+            run = false;
+        }
+
+        // Callbacks run outside the lock; the entry is only touched by this worker until completed
+        if (run) {
+            pthread_mutex_unlock(&work->lock);
+            run_transaction_entry(work, index);
+            pthread_mutex_lock(&work->lock);
+        }
+        complete_transaction_entry(work, index);
+    }
+    pthread_mutex_unlock(&work->lock);
+
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+bool fhir_transaction_entry_set_location(FHIRTransactionEntryResult* entry, const char* location) {
+    if (!entry) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    char* copy = NULL;
+    if (location) {
+        copy = fhir_strdup(location);
+        if (!copy) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy entry location");
+            return false;
+        }
+    }
+    fhir_free(entry->location);
+    entry->location = copy;
+    return true;
+}
+
+void fhir_transaction_result_free(FHIRTransactionResult* result) {
+    if (!result) return;
+
+    if (result->entries) {
+        for (size_t i = 0; i < result->entry_count; i++) {
+            fhir_free(result->entries[i].location);
+            fhir_free(result->entries[i].rewrites);
+            cJSON_Delete(result->entries[i].rewritten);
+        }
+        fhir_free(result->entries);
+    }
+    fhir_free(result);
+}
+
+static void run_transaction(FHIRTransactionWork* work, size_t thread_count) {
+    FHIRTransactionResult* result = work->result;
+
+    // In a transaction an invalid request aborts everything
+    for (size_t i = 0; i < result->entry_count; i++) {
+        if (result->entries[i].state == FHIR_TRANSACTION_ENTRY_FAILED && result->atomic) {
+            work->stopped = true;
+        }
+        if (work->nodes[i].pending == 0) {
+            work->queue[work->tail++] = i;
+        }
+    }
+
+    pthread_mutex_init(&work->lock, NULL);
+    pthread_cond_init(&work->ready, NULL);
+
+    // The calling thread is worker 0; queued entries are shared, so failed starts lose nothing
+    pthread_t* threads = thread_count > 1 ? fhir_calloc(thread_count, sizeof(pthread_t)) : NULL;
+    bool* started = thread_count > 1 ? fhir_calloc(thread_count, sizeof(bool)) : NULL;
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, transaction_worker_main, work) == 0;
+    }
+    transaction_worker_main(work);
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    fhir_free(threads);
+    fhir_free(started);
+
+    pthread_cond_destroy(&work->ready);
+    pthread_mutex_destroy(&work->lock);
+
+    for (size_t i = 0; i < result->entry_count; i++) {
+        result->failed_count += result->entries[i].state == FHIR_TRANSACTION_ENTRY_FAILED;
+        result->skipped_count += result->entries[i].state == FHIR_TRANSACTION_ENTRY_SKIPPED;
+        result->rewrite_count += result->entries[i].rewrite_count;
+    }
+}
+
+FHIRTransactionResult* fhir_process_transaction(const cJSON* json, size_t thread_count,
+                                                FHIRTransactionEntryCallback callback, void* context) {
+    const char* type_name = json ? fhir_json_get_string(json, "resourceType") : NULL;
+    if (!type_name || strcmp(type_name, "Bundle") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Not a Bundle");
+        return NULL;
+    }
+    if (!callback) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    const char* bundle_type = fhir_json_get_string(json, "type");
+    bool atomic = bundle_type && strcmp(bundle_type, "transaction") == 0;
+    if (!atomic && (!bundle_type || strcmp(bundle_type, "batch") != 0)) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Bundle is not a transaction or batch", "type");
+        return NULL;
+    }
+
+    const cJSON* entry_array = cJSON_GetObjectItemCaseSensitive(json, "entry");
+    size_t entry_count = cJSON_IsArray(entry_array) ? (size_t)cJSON_GetArraySize(entry_array) : 0;
+
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+    // Entries run one at a time, so more workers than entries would only wait
+    if (thread_count > entry_count) thread_count = entry_count ? entry_count : 1;
+
+    FHIRTransactionResult* result = fhir_calloc(1, sizeof(FHIRTransactionResult));
+    FHIRTransactionNode* nodes = fhir_calloc(entry_count ? entry_count : 1, sizeof(FHIRTransactionNode));
+    size_t* queue = fhir_calloc(entry_count ? entry_count : 1, sizeof(size_t));
+    FHIRTransactionIndex full_urls = { NULL, 0 }, type_ids = { NULL, 0 }, writers = { NULL, 0 };
+    if (result) {
+        result->entry_count = entry_count;
+        result->thread_count = thread_count;
+        result->atomic = atomic;
+        result->entries = fhir_calloc(entry_count ? entry_count : 1, sizeof(FHIRTransactionEntryResult));
+    }
+
+    bool acyclic = false;
+    bool ok = result && result->entries && nodes && queue &&
+              transaction_index_init(&full_urls, entry_count) &&
+              transaction_index_init(&type_ids, entry_count) &&
+              transaction_index_init(&writers, entry_count) &&
+              build_transaction_graph(entry_array, result, nodes, &full_urls, &type_ids, &writers) &&
+              transaction_graph_is_acyclic(nodes, entry_count, queue, &acyclic);
+
+    if (ok && acyclic) {
+        FHIRTransactionWork work;
+        memset(&work, 0, sizeof(work));
+        work.result = result;
+        work.nodes = nodes;
+        work.full_urls = &full_urls;
+        work.callback = callback;
+        work.context = context;
+        work.queue = queue;
+        run_transaction(&work, thread_count);
+        fhir_clear_error();
+    }
+
+    transaction_index_free(&full_urls);
+    transaction_index_free(&type_ids);
+    transaction_index_free(&writers);
+    for (size_t i = 0; nodes && i < entry_count; i++) {
+        fhir_free(nodes[i].dependents);
+    }
+    fhir_free(nodes);
+    fhir_free(queue);
+
+    if (!ok || !acyclic) {
+        fhir_transaction_result_free(result);
+        if (!ok) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to build transaction dependency graph");
+        } else {
+            FHIR_SET_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Bundle entries reference each other in a cycle");
+        }
+        return NULL;
+    }
+    return result;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file fhir_bundle_parallel.h
+ * @brief Parallel deserialization of FHIR Bundle entries
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Once a Bundle's entry[] array is parsed, every entry resource can be
+ * loaded independently. fhir_parse_bundle_parallel splits the entries into
+ * one range per worker; a worker that runs out of entries steals half of the
+ * remaining range of another worker. Each worker loads resources into its
+ * own arena through the resource registry and the vtable from_json and
+ * validate methods. Results are stored at their entry position, so they come
+ * back in Bundle order whatever the thread count.
+ *
+ * fhir_validate_resources_parallel runs the vtable validate method (the
+ * type's constraint rules) of many already loaded resources the same way.
+ *
+ * fhir_process_transaction schedules the entries of a transaction or batch
+ * Bundle. It builds a dependency graph from the Bundle's references (an
+ * entry runs after the entries whose fullUrl or Type/id it references) and
+ * from the transaction processing order of entries with the same target
+ * (DELETE, then POST, then PUT/PATCH, then GET/HEAD), then hands each entry
+ * to a callback on a pool of worker threads as soon as its dependencies are
+ * done. References to another entry's fullUrl are rewritten to the location
+ * that entry's callback reported.
+ */
+
+#ifndef FHIR_BUNDLE_PARALLEL_H
+#define FHIR_BUNDLE_PARALLEL_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+#define FHIR_BUNDLE_PARALLEL_ERROR_MESSAGE_MAX 128
+
+/**
+ * @brief Result for a single Bundle entry
+ */
+typedef struct {
+    const char* full_url;                                      /**< entry.fullUrl (borrowed), NULL if absent */
+    const cJSON* json;                                         /**< entry.resource (borrowed), NULL if absent */
+    FHIRResourceType resource_type;                            /**< Type named by resourceType */
+    FHIRResourceBase* resource;                                /**< Typed resource in a worker arena, or NULL */
+    FHIRErrorCode error_code;                                  /**< FHIR_ERROR_NONE on success */
+    char error_message[FHIR_BUNDLE_PARALLEL_ERROR_MESSAGE_MAX]; /**< Empty on success */
+} FHIRBundleEntryResult;
+
+/**
+ * @brief Entries of a Bundle loaded by fhir_parse_bundle_parallel
+ *
+ * Strings and JSON are borrowed from the Bundle tree, which must outlive
+ * the result. Typed resources are owned by the worker arenas and are freed
+ * by fhir_parallel_bundle_free.
+ */
+typedef struct {
+    FHIRBundleEntryResult* entries;  /**< One result per entry[] element, in order */
+    size_t entry_count;
+    size_t error_count;              /**< Entries whose error_code is set */
+    size_t thread_count;             /**< Workers used, including the calling thread */
+    FHIRArena** arenas;              /**< One arena per worker */
+} FHIRParallelBundle;
+
+/* ========================================================================== */
+/* Parsing                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Load every entry resource of a Bundle on a pool of worker threads
+ *
+ * Resources without a registered type are left untyped (resource is NULL
+ * and error_code is FHIR_ERROR_NONE), as are entries without a resource.
+ * Entries that fail from_json or validate carry their error. Does not touch
+ * the Python interpreter, so callers may release the GIL.
+ *
+ * @param json Bundle JSON; must not be modified while the call runs
+ * @param thread_count Worker threads including the caller (0 = number of online CPUs)
+ * @return Entry results or NULL on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         if json is not a Bundle, FHIR_ERROR_OUT_OF_MEMORY)
+ */
+FHIRParallelBundle* fhir_parse_bundle_parallel(const cJSON* json, size_t thread_count);
+
+/**
+ * @brief Free entry results and the resources owned by their arenas
+ * @param bundle Results to free (may be NULL)
+ */
+void fhir_parallel_bundle_free(FHIRParallelBundle* bundle);
+
+/* ========================================================================== */
+/* Batch Validation                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Validate many resources on a pool of worker threads
+ *
+ * Each resource's validate method caches its outcome, so a resource that
+ * was validated before and changed only in a few fields reruns only the
+ * rules reading them. A resource may appear more than once. The resources
+ * must not be modified while the call runs. Does not touch the Python
+ * interpreter, so callers may release the GIL.
+ *
+ * @param resources Resources to validate (NULL entries fail)
+ * @param count Number of resources
+ * @param thread_count Worker threads including the caller (0 = number of online CPUs)
+ * @param results Output validity per resource, in input order
+ * @return Number of resources that failed
+ */
+size_t fhir_validate_resources_parallel(FHIRResourceBase* const* resources, size_t count,
+                                        size_t thread_count, bool* results);
+
+/* ========================================================================== */
+/* Transaction Scheduling                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Processing state of a transaction entry
+ */
+typedef enum {
+    FHIR_TRANSACTION_ENTRY_PENDING = 0,  /**< Not processed yet */
+    FHIR_TRANSACTION_ENTRY_DONE,         /**< Callback succeeded */
+    FHIR_TRANSACTION_ENTRY_FAILED,       /**< Invalid request or callback failed */
+    FHIR_TRANSACTION_ENTRY_SKIPPED       /**< A dependency failed, or a transaction was aborted */
+} FHIRTransactionEntryState;
+
+/**
+ * @brief Reference rewritten in an entry resource
+ */
+typedef struct {
+    const char* reference;  /**< Reference as written in the Bundle (borrowed) */
+    const char* target;     /**< Value it was rewritten to (owned by the entry's rewritten copy) */
+    size_t target_entry;    /**< Index of the referenced entry */
+} FHIRTransactionRewrite;
+
+/**
+ * @brief Request and outcome of a single transaction entry
+ *
+ * The callback reads the request fields and resource and reports the
+ * outcome through status and fhir_transaction_entry_set_location.
+ */
+typedef struct {
+    const char* full_url;                                       /**< entry.fullUrl (borrowed), NULL if absent */
+    const char* method;                                         /**< entry.request.method (borrowed) */
+    const char* url;                                            /**< entry.request.url (borrowed) */
+    const cJSON* resource;                                      /**< Resource with references rewritten, NULL if absent */
+    cJSON* rewritten;                                           /**< Owned copy behind resource, NULL if nothing was rewritten */
+    FHIRTransactionRewrite* rewrites;                           /**< References rewritten in resource */
+    size_t rewrite_count;
+    FHIRTransactionEntryState state;
+    int status;                                                 /**< Status set by the callback, 0 if none */
+    char* location;                                             /**< Location set by the callback (owned), NULL if none */
+    FHIRErrorCode error_code;                                   /**< FHIR_ERROR_NONE unless failed */
+    char error_message[FHIR_BUNDLE_PARALLEL_ERROR_MESSAGE_MAX]; /**< Why the entry failed or was skipped */
+} FHIRTransactionEntryResult;
+
+/**
+ * @brief Process one transaction entry
+ *
+ * Called once per entry whose dependencies succeeded, from any worker
+ * thread, concurrently with other entries. On failure the callback may set
+ * the error (FHIR_SET_ERROR) to describe it.
+ *
+ * @param entry Entry to process; set status and location on it
+ * @param index Position of the entry in the Bundle
+ * @param context User context passed to fhir_process_transaction
+ * @return true if the entry succeeded
+ */
+typedef bool (*FHIRTransactionEntryCallback)(FHIRTransactionEntryResult* entry, size_t index, void* context);
+
+/**
+ * @brief Outcome of fhir_process_transaction
+ *
+ * Strings and JSON not marked owned are borrowed from the Bundle tree,
+ * which must outlive the result.
+ */
+typedef struct {
+    FHIRTransactionEntryResult* entries;  /**< One result per entry[] element, in order */
+    size_t entry_count;
+    size_t failed_count;                  /**< Entries in state FAILED */
+    size_t skipped_count;                 /**< Entries in state SKIPPED */
+    size_t rewrite_count;                 /**< References rewritten across all entries */
+    size_t thread_count;                  /**< Workers used, including the calling thread */
+    bool atomic;                          /**< Bundle.type is transaction: the first failure aborts the rest */
+} FHIRTransactionResult;
+
+/**
+ * @brief Run the entries of a transaction or batch Bundle in dependency order
+ *
+ * An entry depends on:
+ *   - the entries its resource references, matched by fullUrl or, for
+ *     relative references, by Type/id (the resource's, or the request
+ *     url's for entries without one);
+ *   - earlier-phase entries with the same Type/id request url, and for
+ *     type-level requests (searches, conditional writes, operations) every
+ *     earlier-phase write of the type. Entries with the same phase keep
+ *     their Bundle order.
+ * Independent entries run concurrently. In a transaction, the first failure
+ * stops new entries from starting; in a batch, only the entries depending
+ * on a failed entry are skipped. Entries with a missing or unsupported
+ * request fail without reaching the callback.
+ *
+ * @param json Transaction or batch Bundle; must not be modified while the call runs
+ * @param thread_count Worker threads including the caller (0 = number of online CPUs)
+ * @param callback Called for every entry that runs
+ * @param context User context passed to the callback
+ * @return Entry outcomes or NULL on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         if json is not a Bundle, FHIR_ERROR_VALIDATION_FAILED if it is not a
+ *         transaction or batch or its entries depend on each other in a cycle,
+ *         FHIR_ERROR_OUT_OF_MEMORY); no callback runs in that case
+ */
+FHIRTransactionResult* fhir_process_transaction(const cJSON* json, size_t thread_count,
+                                                FHIRTransactionEntryCallback callback, void* context);
+
+/**
+ * @brief Set the location of a processed entry (e.g. "Patient/123/_history/1")
+ *
+ * References to the entry's fullUrl are rewritten to the location without
+ * its _history suffix.
+ *
+ * @param entry Entry passed to the callback
+ * @param location Location to copy (NULL clears it)
+ * @return false on allocation failure
+ */
+bool fhir_transaction_entry_set_location(FHIRTransactionEntryResult* entry, const char* location);
+
+/**
+ * @brief Free transaction results
+ * @param result Results to free (may be NULL)
+ */
+void fhir_transaction_result_free(FHIRTransactionResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_BUNDLE_PARALLEL_H */
@@ -0,0 +1,511 @@
+/**
+ * @file fhir_bundle_stream.c
+ * @brief Incremental pull tokenizer over FHIR Bundle entries
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Only the structure needed to locate entry[i].resource is tokenized; other
+ * members are skipped by bracket matching. Each captured resource is left for
+ * the caller to parse, which is where full JSON validation happens.
+ *
+ * Push mode reuses the same tokenizer over an owned buffer. Running out of
+ * fed input marks the stream starved; fhir_bundle_stream_next then rewinds
+ * to where the call started and waits for the next feed, so the tokenizer
+ * itself never has to suspend mid-value. A starved entry is rescanned only
+ * once its buffered bytes have doubled, which keeps the total rescanning of
+ * an entry split over many small chunks linear in its size.
+ */
+
+#include "fhir_bundle_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FHIR_BUNDLE_STREAM_DEFAULT_CHUNK (64 * 1024)
+#define FHIR_BUNDLE_STREAM_KEY_MAX 32
+#define FHIR_STREAM_EOF (-1)
+#define FHIR_STREAM_FAIL (-2)
+
+typedef enum {
+    STREAM_STATE_START,
+    STREAM_STATE_ENTRIES,
+    STREAM_STATE_DONE,
+    STREAM_STATE_ERROR
+} StreamState;
+
+struct FHIRBundleStream {
+    // Input window: the whole input in buffer mode, the current chunk otherwise
+    const char* data;
+    size_t length;
+    size_t pos;
+    size_t window_offset;
+
+    // Reader mode
+    FHIRStreamReadFunc read;
+    void* context;
+    char* chunk;
+    size_t chunk_size;
+    bool eof;
+
+    // Push mode: fed bytes from the start of the unfinished entry on
+    bool push;
+    bool starved;
+    size_t retry_length;
+    char* buffer;
+    size_t buffer_capacity;
+
+    // Resource capture
+    bool capturing;
+    size_t capture_start;
+    size_t capture_end;
+    char* capture;
+    size_t capture_length;
+    size_t capture_capacity;
+
+    StreamState state;
+    bool need_comma;
+    const char* error;
+};
+
+/* ========================================================================== */
+/* Lifecycle                                                                  */
+/* ========================================================================== */
+
+FHIRBundleStream* fhir_bundle_stream_create_from_buffer(const char* data, size_t length) {
+    if (!data) return NULL;
+
+    FHIRBundleStream* stream = calloc(1, sizeof(FHIRBundleStream));
+    if (!stream) return NULL;
+
+    stream->data = data;
+    stream->length = length;
+    stream->eof = true;
+    stream->state = STREAM_STATE_START;
+    return stream;
+}
+
+FHIRBundleStream* fhir_bundle_stream_create(FHIRStreamReadFunc read, void* context,
+                                            size_t chunk_size) {
+    if (!read) return NULL;
+
+    FHIRBundleStream* stream = calloc(1, sizeof(FHIRBundleStream));
+    if (!stream) return NULL;
+
+    stream->chunk_size = chunk_size > 0 ? chunk_size : FHIR_BUNDLE_STREAM_DEFAULT_CHUNK;
+    stream->chunk = malloc(stream->chunk_size);
+    if (!stream->chunk) {
+        free(stream);
+        return NULL;
+    }
+
+    stream->read = read;
+    stream->context = context;
+    stream->data = stream->chunk;
+    stream->state = STREAM_STATE_START;
+    return stream;
+}
+
+FHIRBundleStream* fhir_bundle_stream_create_push(void) {
+    FHIRBundleStream* stream = calloc(1, sizeof(FHIRBundleStream));
+    if (!stream) return NULL;
+
+    stream->push = true;
+    stream->data = "";
+    stream->state = STREAM_STATE_START;
+    return stream;
+}
+
+void fhir_bundle_stream_destroy(FHIRBundleStream* stream) {
+    if (!stream) return;
+
+    free(stream->buffer);
+    free(stream->chunk);
+    free(stream->capture);
+    free(stream);
+}
+
+const char* fhir_bundle_stream_get_error(const FHIRBundleStream* stream) {
+    return stream ? stream->error : NULL;
+}
+
+size_t fhir_bundle_stream_get_offset(const FHIRBundleStream* stream) {
+    return stream ? stream->window_offset + stream->pos : 0;
+}
+
+/* ========================================================================== */
+/* Byte Access                                                                */
+/* ========================================================================== */
+
+static bool stream_fail(FHIRBundleStream* stream, const char* message) {
+    if (!stream->error) {
+        stream->error = message;
+    }
+    stream->state = STREAM_STATE_ERROR;
+    return false;
+}
+
+static bool capture_append(FHIRBundleStream* stream, const char* bytes, size_t count) {
+    if (stream->capture_length + count > stream->capture_capacity) {
+        size_t capacity = stream->capture_capacity ? stream->capture_capacity : 4096;
+        while (capacity < stream->capture_length + count) {
+            capacity *= 2;
+        }
+        char* grown = realloc(stream->capture, capacity);
+        if (!grown) {
+            return stream_fail(stream, "Out of memory while buffering Bundle entry");
+        }
+        stream->capture = grown;
+        stream->capture_capacity = capacity;
+    }
+
+    memcpy(stream->capture + stream->capture_length, bytes, count);
+    stream->capture_length += count;
+    return true;
+}
+
+// Pull the next chunk in reader mode, flushing any partial capture first
+static bool stream_refill(FHIRBundleStream* stream) {
+    if (stream->eof) return false;
+    if (stream->push) {
+        stream->starved = true;
+        return false;
+    }
+
+    if (stream->capturing) {
+        if (!capture_append(stream, stream->data + stream->capture_start,
+                            stream->length - stream->capture_start)) {
+            return false;
+        }
+        stream->capture_start = 0;
+    }
+
+    long count = stream->read(stream->context, stream->chunk, stream->chunk_size);
+    if (count < 0) {
+        stream_fail(stream, "Failed to read Bundle input");
+        return false;
+    }
+
+    stream->window_offset += stream->length;
+    stream->length = (size_t)count;
+    stream->pos = 0;
+    if (count == 0) {
+        stream->eof = true;
+        return false;
+    }
+    return true;
+}
+
+static int stream_peek(FHIRBundleStream* stream) {
+    if (stream->pos >= stream->length && !stream_refill(stream)) {
+        return stream->state == STREAM_STATE_ERROR ? FHIR_STREAM_FAIL : FHIR_STREAM_EOF;
+    }
+    return (unsigned char)stream->data[stream->pos];
+}
+
+static int stream_skip_whitespace(FHIRBundleStream* stream) {
+    for (;;) {
+        int c = stream_peek(stream);
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return c;
+        }
+        stream->pos++;
+    }
+}
+
+static bool stream_expect(FHIRBundleStream* stream, char expected, const char* message) {
+    if (stream_skip_whitespace(stream) != (unsigned char)expected) {
+        return stream_fail(stream, message);
+    }
+    stream->pos++;
+    return true;
+}
+
+/* ========================================================================== */
+/* Push Input                                                                 */
+/* ========================================================================== */
+
+bool fhir_bundle_stream_feed(FHIRBundleStream* stream, const char* data, size_t length) {
+    if (!stream || !stream->push || stream->eof || (!data && length > 0)) return false;
+    if (length == 0 || stream->state == STREAM_STATE_DONE) return true;
+
+    // Bytes before pos belong to entries already returned
+    size_t kept = stream->length - stream->pos;
+    if (stream->pos > 0) {
+        memmove(stream->buffer, stream->buffer + stream->pos, kept);
+        stream->window_offset += stream->pos;
+        stream->pos = 0;
+        stream->length = kept;
+    }
+
+    if (kept + length > stream->buffer_capacity) {
+        size_t capacity = stream->buffer_capacity ? stream->buffer_capacity : FHIR_BUNDLE_STREAM_DEFAULT_CHUNK;
+        while (capacity < kept + length) {
+            capacity *= 2;
+        }
+        char* grown = realloc(stream->buffer, capacity);
+        if (!grown) return false;
+        stream->buffer = grown;
+        stream->buffer_capacity = capacity;
+    }
+
+    memcpy(stream->buffer + kept, data, length);
+    stream->data = stream->buffer;
+    stream->length = kept + length;
+    return true;
+}
+
+void fhir_bundle_stream_finish(FHIRBundleStream* stream) {
+    if (stream && stream->push) {
+        stream->eof = true;
+    }
+}
+
+/* ========================================================================== */
+/* Tokenizer                                                                  */
+/* ========================================================================== */
+
+// Consume a string body after its opening quote; copies it into out when it fits
+static bool stream_read_string(FHIRBundleStream* stream, char* out, size_t capacity) {
+    size_t used = 0;
+    bool fits = out != NULL;
+
+    for (;;) {
+        int c = stream_peek(stream);
+        if (c < 0) {
+            return stream_fail(stream, "Unterminated string in Bundle");
+        }
+        stream->pos++;
+
+        if (c == '"') break;
+        if (c == '\\') {
+            // Escaped names never match the plain member names we look for
+            fits = false;
+            if (stream_peek(stream) < 0) {
+                return stream_fail(stream, "Unterminated string in Bundle");
+            }
+            stream->pos++;
+            continue;
+        }
+        if (fits) {
+            if (used + 1 < capacity) {
+                out[used++] = (char)c;
+            } else {
+                fits = false;
+            }
+        }
+    }
+
+    if (out) {
+        out[fits ? used : 0] = '\0';
+    }
+    return true;
+}
+
+// Skip one JSON value using bracket matching; scalars are not validated here
+static bool stream_skip_value(FHIRBundleStream* stream) {
+    int c = stream_skip_whitespace(stream);
+    if (c < 0) {
+        return stream_fail(stream, "Unexpected end of Bundle");
+    }
+
+    if (c == '"') {
+        stream->pos++;
+        return stream_read_string(stream, NULL, 0);
+    }
+
+    if (c == '{' || c == '[') {
+        size_t depth = 0;
+        for (;;) {
+            c = stream_peek(stream);
+            if (c < 0) {
+                return stream_fail(stream, "Unexpected end of Bundle");
+            }
+            stream->pos++;
+
+            if (c == '"') {
+                if (!stream_read_string(stream, NULL, 0)) return false;
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return true;
+            }
+        }
+    }
+
+    // Number, true, false or null
+    size_t start = fhir_bundle_stream_get_offset(stream);
+    while ((c = stream_peek(stream)) >= 0 && c != ',' && c != '}' && c != ']' && c != ' ' &&
+           c != '\t' && c != '\n' && c != '\r') {
+        stream->pos++;
+    }
+    if (c == FHIR_STREAM_FAIL) return false;
+    if (fhir_bundle_stream_get_offset(stream) == start) {
+        return stream_fail(stream, "Invalid value in Bundle");
+    }
+    return true;
+}
+
+// Read the next member name of an object and its ':'; returns 1, 0 at '}', -1 on error
+static int stream_next_member(FHIRBundleStream* stream, bool* first, char* key) {
+    int c = stream_skip_whitespace(stream);
+
+    if (c == '}') {
+        stream->pos++;
+        return 0;
+    }
+    if (!*first) {
+        if (c != ',') {
+            stream_fail(stream, "Expected ',' or '}' in Bundle object");
+            return -1;
+        }
+        stream->pos++;
+        c = stream_skip_whitespace(stream);
+    }
+    *first = false;
+
+    if (c != '"') {
+        stream_fail(stream, "Expected member name in Bundle object");
+        return -1;
+    }
+    stream->pos++;
+
+    if (!stream_read_string(stream, key, FHIR_BUNDLE_STREAM_KEY_MAX)) return -1;
+    if (!stream_expect(stream, ':', "Expected ':' in Bundle object")) return -1;
+    return 1;
+}
+
+// Walk the root object up to the opening '[' of entry
+static int stream_enter_entries(FHIRBundleStream* stream) {
+    char key[FHIR_BUNDLE_STREAM_KEY_MAX];
+    bool first = true;
+
+    if (!stream_expect(stream, '{', "Bundle must be a JSON object")) return -1;
+
+    for (;;) {
+        int member = stream_next_member(stream, &first, key);
+        if (member <= 0) return member;
+
+        if (strcmp(key, "resourceType") == 0) {
+            char value[FHIR_BUNDLE_STREAM_KEY_MAX];
+            if (!stream_expect(stream, '"', "resourceType must be a string")) return -1;
+            if (!stream_read_string(stream, value, sizeof(value))) return -1;
+            if (strcmp(value, "Bundle") != 0) {
+                stream_fail(stream, "Data is not a FHIR Bundle");
+                return -1;
+            }
+        } else if (strcmp(key, "entry") == 0) {
+            if (!stream_expect(stream, '[', "Bundle entry must be an array")) return -1;
+            return 1;
+        } else if (!stream_skip_value(stream)) {
+            return -1;
+        }
+    }
+}
+
+// Scan one entry object, capturing its resource; returns true when a resource was found
+static bool stream_scan_entry(FHIRBundleStream* stream, bool* found) {
+    char key[FHIR_BUNDLE_STREAM_KEY_MAX];
+    bool first = true;
+
+    *found = false;
+    if (!stream_expect(stream, '{', "Bundle entry must be an object")) return false;
+
+    for (;;) {
+        int member = stream_next_member(stream, &first, key);
+        if (member < 0) return false;
+        if (member == 0) return true;
+
+        if (!*found && strcmp(key, "resource") == 0) {
+            if (stream_skip_whitespace(stream) != '{') {
+                return stream_fail(stream, "Bundle entry resource must be an object");
+            }
+            stream->capturing = true;
+            stream->capture_start = stream->pos;
+            stream->capture_length = 0;
+
+            bool skipped = stream_skip_value(stream);
+            stream->capturing = false;
+            if (!skipped) return false;
+            stream->capture_end = stream->pos;
+
+            if (stream->read && !capture_append(stream, stream->data + stream->capture_start,
+                                                stream->pos - stream->capture_start)) {
+                return false;
+            }
+            *found = true;
+        } else if (!stream_skip_value(stream)) {
+            return false;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Iteration                                                                  */
+/* ========================================================================== */
+
+FHIRBundleStreamResult fhir_bundle_stream_next(FHIRBundleStream* stream, const char** json,
+                                               size_t* length) {
+    if (!stream || !json || !length) return FHIR_BUNDLE_STREAM_ERROR;
+    if (stream->push && !stream->eof && stream->length - stream->pos < stream->retry_length) {
+        return FHIR_BUNDLE_STREAM_NEED_MORE;
+    }
+
+    // Where to resume in push mode when the fed input runs out
+    size_t resume_pos = stream->pos;
+    StreamState resume_state = stream->state;
+    bool resume_comma = stream->need_comma;
+    stream->starved = false;
+
+    if (stream->state == STREAM_STATE_START) {
+        int entered = stream_enter_entries(stream);
+        if (entered < 0) goto failed;
+        if (entered == 0) {
+            stream->state = STREAM_STATE_DONE;
+            return FHIR_BUNDLE_STREAM_END;
+        }
+        stream->state = STREAM_STATE_ENTRIES;
+        stream->need_comma = false;
+    }
+
+    while (stream->state == STREAM_STATE_ENTRIES) {
+        resume_pos = stream->pos;
+        resume_comma = stream->need_comma;
+        resume_state = STREAM_STATE_ENTRIES;
+
+        int c = stream_skip_whitespace(stream);
+        if (c == ']') {
+            // Members after the entry array are not needed and are not scanned
+            stream->pos++;
+            stream->state = STREAM_STATE_DONE;
+            break;
+        }
+        if (stream->need_comma) {
+            if (c != ',') {
+                stream_fail(stream, "Expected ',' or ']' in Bundle entry array");
+                break;
+            }
+            stream->pos++;
+        }
+        stream->need_comma = true;
+
+        bool found;
+        if (!stream_scan_entry(stream, &found)) break;
+        if (found) {
+            stream->retry_length = 0;
+            *json = stream->read ? stream->capture : stream->data + stream->capture_start;
+            *length = stream->read ? stream->capture_length : stream->capture_end - stream->capture_start;
+            return FHIR_BUNDLE_STREAM_ENTRY;
+        }
+    }
+
+failed:
+    if (stream->starved) {
+        // Scanning stopped at the end of the fed input, not at bad JSON
+        stream->pos = resume_pos;
+        stream->state = resume_state;
+        stream->need_comma = resume_comma;
+        stream->error = NULL;
+        stream->retry_length = 2 * (stream->length - resume_pos);
+        return FHIR_BUNDLE_STREAM_NEED_MORE;
+    }
+    return stream->state == STREAM_STATE_ERROR ? FHIR_BUNDLE_STREAM_ERROR : FHIR_BUNDLE_STREAM_END;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file fhir_bundle_stream.h
+ * @brief Incremental pull tokenizer over FHIR Bundle entries
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Scans a Bundle without building a tree for the whole document and hands
+ * back the raw JSON text of each entry[i].resource in turn. Input comes from
+ * an in-memory buffer (including an mmap), from a read callback, or is
+ * pushed chunk by chunk as it arrives (for example from a network socket),
+ * so peak memory is bounded by the largest single resource rather than the
+ * Bundle.
+ */
+
+#ifndef FHIR_BUNDLE_STREAM_H
+#define FHIR_BUNDLE_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Read callback used to pull more input
+ * @param context Caller supplied context
+ * @param buffer Destination buffer
+ * @param capacity Size of destination buffer
+ * @return Bytes written, 0 at end of input, or negative on error
+ */
+typedef long (*FHIRStreamReadFunc)(void* context, char* buffer, size_t capacity);
+
+/**
+ * @brief Opaque Bundle entry stream
+ */
+typedef struct FHIRBundleStream FHIRBundleStream;
+
+/**
+ * @brief Result of advancing a Bundle entry stream
+ */
+typedef enum {
+    FHIR_BUNDLE_STREAM_ERROR = -1,
+    FHIR_BUNDLE_STREAM_END = 0,
+    FHIR_BUNDLE_STREAM_ENTRY = 1,
+    FHIR_BUNDLE_STREAM_NEED_MORE = 2     /**< Push mode: the next entry is not complete yet */
+} FHIRBundleStreamResult;
+
+/* ========================================================================== */
+/* Lifecycle                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Create a stream over a complete in-memory buffer (no copy is made)
+ * @param data Bundle JSON text; must outlive the stream
+ * @param length Length of data in bytes
+ * @return New stream or NULL on allocation failure
+ */
+FHIRBundleStream* fhir_bundle_stream_create_from_buffer(const char* data, size_t length);
+
+/**
+ * @brief Create a stream that pulls input through a read callback
+ * @param read Read callback
+ * @param context Context passed to read
+ * @param chunk_size Size of the refill buffer (0 selects the default)
+ * @return New stream or NULL on failure
+ */
+FHIRBundleStream* fhir_bundle_stream_create(FHIRStreamReadFunc read, void* context,
+                                            size_t chunk_size);
+
+/**
+ * @brief Create a stream that is fed input with fhir_bundle_stream_feed
+ *
+ * fhir_bundle_stream_next returns FHIR_BUNDLE_STREAM_NEED_MORE instead of
+ * waiting when the fed input ends inside an entry; only the bytes of that
+ * unfinished entry are kept between feeds.
+ *
+ * @return New stream or NULL on allocation failure
+ */
+FHIRBundleStream* fhir_bundle_stream_create_push(void);
+
+/**
+ * @brief Destroy a stream
+ * @param stream Stream to destroy (may be NULL)
+ */
+void fhir_bundle_stream_destroy(FHIRBundleStream* stream);
+
+/* ========================================================================== */
+/* Push Input                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Append input to a push stream
+ *
+ * Chunks may split the Bundle anywhere, including inside a string or a
+ * multi-byte character.
+ *
+ * @param stream Stream created by fhir_bundle_stream_create_push
+ * @param data Next bytes of the Bundle (copied)
+ * @param length Length of data in bytes
+ * @return true on success, false on allocation failure, after
+ *         fhir_bundle_stream_finish or on a stream that is not in push mode
+ */
+bool fhir_bundle_stream_feed(FHIRBundleStream* stream, const char* data, size_t length);
+
+/**
+ * @brief Mark the end of a push stream's input
+ *
+ * Afterwards fhir_bundle_stream_next reports a Bundle cut short as an error
+ * instead of FHIR_BUNDLE_STREAM_NEED_MORE.
+ *
+ * @param stream Stream created by fhir_bundle_stream_create_push
+ */
+void fhir_bundle_stream_finish(FHIRBundleStream* stream);
+
+/* ========================================================================== */
+/* Iteration                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Advance to the next entry that carries a resource
+ *
+ * Entries without a "resource" member are skipped. The returned text stays
+ * valid until the next call on the stream, including fhir_bundle_stream_feed.
+ *
+ * @param stream Stream to advance
+ * @param json Output pointer to the resource JSON text (not NUL terminated)
+ * @param length Output length of the resource JSON text
+ * @return FHIR_BUNDLE_STREAM_ENTRY, FHIR_BUNDLE_STREAM_END, FHIR_BUNDLE_STREAM_ERROR,
+ *         or FHIR_BUNDLE_STREAM_NEED_MORE in push mode
+ */
+FHIRBundleStreamResult fhir_bundle_stream_next(FHIRBundleStream* stream, const char** json,
+                                               size_t* length);
+
+/**
+ * @brief Get the last error message of a stream
+ * @param stream Stream to query
+ * @return Error message or NULL if no error occurred
+ */
+const char* fhir_bundle_stream_get_error(const FHIRBundleStream* stream);
+
+/**
+ * @brief Get the number of input bytes consumed so far
+ * @param stream Stream to query
+ * @return Byte offset into the input
+ */
+size_t fhir_bundle_stream_get_offset(const FHIRBundleStream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_BUNDLE_STREAM_H */
@@ -0,0 +1,65 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_json.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_json_writer.h"
+
+// Python binding for canonical JSON serialization
+
+// Rewrite any JSON document as canonical JSON in one pass over the parsed tree
+static PyObject* py_canonical_json(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
+        return NULL;
+    }
+
+    FHIRWriter writer;
+    bool parsed = false;
+    bool written = false;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    parsed = json != NULL;
+    written = parsed && fhir_writer_init_buffer(&writer, (size_t)view.len + 1) &&
+              fhir_writer_set_canonical(&writer, true) && fhir_writer_cjson(&writer, json) &&
+              fhir_writer_finish(&writer);
+    cJSON_Delete(json);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (!parsed) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    PyObject* result = written ? PyUnicode_FromStringAndSize(writer.data, (Py_ssize_t)writer.length)
+                               : PyErr_NoMemory();
+    fhir_writer_cleanup(&writer);
+    return result;
+}
+
+static PyMethodDef CanonicalModuleMethods[] = {
+    {"canonical_json", py_canonical_json, METH_O,
+     "Rewrite a JSON document as canonical JSON (sorted members, normalized numbers)"},
+    {NULL, NULL, 0, NULL}
+};
+
+// Module execution (once per interpreter); the module keeps no state
+static int canonical_module_exec(PyObject* module) {
+    return fhir_python_add_runtime(module);
+}
+
+static PyModuleDef_Slot canonical_module_slots[] = FHIR_PY_MODULE_SLOTS(canonical_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_canonical_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_canonical_c",
+    "Canonical FHIR JSON serialization in C",
+    0,
+    CanonicalModuleMethods,
+    canonical_module_slots
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_canonical_c(void) {
+    return PyModuleDef_Init(&fhir_canonical_module);
+}
@@ -0,0 +1,510 @@
+/**
+ * @file fhir_datatype_schemas.c
+ * @brief Codec schemas of the complex data types in fhir_datatypes.h
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ */
+
+#include "fhir_datatype_schemas.h"
+#include "fhir_datatypes.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Coding                                                                     */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_coding_fields[] = {
+    { .key = "system", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRCoding, system) },
+    { .key = "version", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRCoding, version) },
+    { .key = "code", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRCoding, code) },
+    { .key = "display", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRCoding, display) },
+    { .key = "userSelected", .kind = FHIR_SCHEMA_FLAG, .flags = 0,
+      .offset = offsetof(FHIRCoding, user_selected) },
+};
+
+static int fhir_coding_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            if (memcmp(key, "code", 4) == 0) return 2;
+            break;
+        case 6:
+            if (memcmp(key, "system", 6) == 0) return 0;
+            break;
+        case 7:
+            switch (key[0]) {
+                case 'd':
+                    if (memcmp(key, "display", 7) == 0) return 3;
+                    break;
+                case 'v':
+                    if (memcmp(key, "version", 7) == 0) return 1;
+                    break;
+            }
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 12:
+            if (memcmp(key, "userSelected", 12) == 0) return 4;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_coding_schema = {
+    .name = "Coding",
+    .size = sizeof(FHIRCoding),
+    .fields = g_coding_fields,
+    .field_count = sizeof(g_coding_fields) / sizeof(g_coding_fields[0]),
+    .lookup = fhir_coding_field_lookup
+};
+
+/* ========================================================================== */
+/* CodeableConcept                                                            */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_codeableconcept_fields[] = {
+    { .key = "coding", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRCodeableConcept, coding), .count_offset = offsetof(FHIRCodeableConcept, coding_count),
+      .schema = &fhir_coding_schema },
+    { .key = "text", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRCodeableConcept, text) },
+};
+
+static int fhir_codeableconcept_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            if (memcmp(key, "text", 4) == 0) return 1;
+            break;
+        case 6:
+            if (memcmp(key, "coding", 6) == 0) return 0;
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_codeableconcept_schema = {
+    .name = "CodeableConcept",
+    .size = sizeof(FHIRCodeableConcept),
+    .fields = g_codeableconcept_fields,
+    .field_count = sizeof(g_codeableconcept_fields) / sizeof(g_codeableconcept_fields[0]),
+    .lookup = fhir_codeableconcept_field_lookup
+};
+
+/* ========================================================================== */
+/* Quantity                                                                   */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_quantity_fields[] = {
+    { .key = "value", .kind = FHIR_SCHEMA_NUMBER, .flags = 0,
+      .offset = offsetof(FHIRQuantity, value) },
+    { .key = "comparator", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRQuantity, comparator) },
+    { .key = "unit", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRQuantity, unit) },
+    { .key = "system", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRQuantity, system) },
+    { .key = "code", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRQuantity, code) },
+};
+
+static int fhir_quantity_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "code", 4) == 0) return 4;
+                    break;
+                case 'u':
+                    if (memcmp(key, "unit", 4) == 0) return 2;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(key, "value", 5) == 0) return 0;
+            break;
+        case 6:
+            if (memcmp(key, "system", 6) == 0) return 3;
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 10:
+            if (memcmp(key, "comparator", 10) == 0) return 1;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_quantity_schema = {
+    .name = "Quantity",
+    .size = sizeof(FHIRQuantity),
+    .fields = g_quantity_fields,
+    .field_count = sizeof(g_quantity_fields) / sizeof(g_quantity_fields[0]),
+    .lookup = fhir_quantity_field_lookup
+};
+
+/* ========================================================================== */
+/* Period                                                                     */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_period_fields[] = {
+    { .key = "start", .kind = FHIR_SCHEMA_DATE_TIME, .flags = 0,
+      .offset = offsetof(FHIRPeriod, start) },
+    { .key = "end", .kind = FHIR_SCHEMA_DATE_TIME, .flags = 0,
+      .offset = offsetof(FHIRPeriod, end) },
+};
+
+static int fhir_period_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 3:
+            if (memcmp(key, "end", 3) == 0) return 1;
+            break;
+        case 5:
+            if (memcmp(key, "start", 5) == 0) return 0;
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_period_schema = {
+    .name = "Period",
+    .size = sizeof(FHIRPeriod),
+    .fields = g_period_fields,
+    .field_count = sizeof(g_period_fields) / sizeof(g_period_fields[0]),
+    .lookup = fhir_period_field_lookup
+};
+
+/* ========================================================================== */
+/* Identifier                                                                 */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_identifier_fields[] = {
+    { .key = "use", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRIdentifier, use) },
+    { .key = "system", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRIdentifier, system) },
+    { .key = "value", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRIdentifier, value) },
+    { .key = "period", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRIdentifier, period),
+      .schema = &fhir_period_schema },
+};
+
+static int fhir_identifier_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 3:
+            if (memcmp(key, "use", 3) == 0) return 0;
+            break;
+        case 5:
+            if (memcmp(key, "value", 5) == 0) return 2;
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'p':
+                    if (memcmp(key, "period", 6) == 0) return 3;
+                    break;
+                case 's':
+                    if (memcmp(key, "system", 6) == 0) return 1;
+                    break;
+            }
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_identifier_schema = {
+    .name = "Identifier",
+    .size = sizeof(FHIRIdentifier),
+    .fields = g_identifier_fields,
+    .field_count = sizeof(g_identifier_fields) / sizeof(g_identifier_fields[0]),
+    .lookup = fhir_identifier_field_lookup
+};
+
+/* ========================================================================== */
+/* Reference                                                                  */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_reference_fields[] = {
+    { .key = "reference", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRReference, reference) },
+    { .key = "type", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRReference, type) },
+    { .key = "identifier", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRReference, identifier),
+      .schema = &fhir_identifier_schema },
+    { .key = "display", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRReference, display) },
+};
+
+static int fhir_reference_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            if (memcmp(key, "type", 4) == 0) return 1;
+            break;
+        case 7:
+            if (memcmp(key, "display", 7) == 0) return 3;
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'e':
+                    if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'r':
+                    if (memcmp(key, "reference", 9) == 0) return 0;
+                    break;
+            }
+            break;
+        case 10:
+            if (memcmp(key, "identifier", 10) == 0) return 2;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_reference_schema = {
+    .name = "Reference",
+    .size = sizeof(FHIRReference),
+    .fields = g_reference_fields,
+    .field_count = sizeof(g_reference_fields) / sizeof(g_reference_fields[0]),
+    .lookup = fhir_reference_field_lookup
+};
+
+/* ========================================================================== */
+/* HumanName                                                                  */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_humanname_fields[] = {
+    { .key = "use", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRHumanName, use) },
+    { .key = "text", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRHumanName, text) },
+    { .key = "family", .kind = FHIR_SCHEMA_TEXT, .flags = FHIR_SCHEMA_ARRAY | FHIR_SCHEMA_SINGLE,
+      .offset = offsetof(FHIRHumanName, family), .count_offset = offsetof(FHIRHumanName, family_count) },
+    { .key = "given", .kind = FHIR_SCHEMA_TEXT, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRHumanName, given), .count_offset = offsetof(FHIRHumanName, given_count) },
+    { .key = "prefix", .kind = FHIR_SCHEMA_TEXT, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRHumanName, prefix), .count_offset = offsetof(FHIRHumanName, prefix_count) },
+    { .key = "suffix", .kind = FHIR_SCHEMA_TEXT, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRHumanName, suffix), .count_offset = offsetof(FHIRHumanName, suffix_count) },
+    { .key = "period", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRHumanName, period),
+      .schema = &fhir_period_schema },
+};
+
+static int fhir_humanname_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 3:
+            if (memcmp(key, "use", 3) == 0) return 0;
+            break;
+        case 4:
+            if (memcmp(key, "text", 4) == 0) return 1;
+            break;
+        case 5:
+            if (memcmp(key, "given", 5) == 0) return 3;
+            break;
+        case 6:
+            switch (key[1]) {
+                case 'a':
+                    if (memcmp(key, "family", 6) == 0) return 2;
+                    break;
+                case 'e':
+                    if (memcmp(key, "period", 6) == 0) return 6;
+                    break;
+                case 'r':
+                    if (memcmp(key, "prefix", 6) == 0) return 4;
+                    break;
+                case 'u':
+                    if (memcmp(key, "suffix", 6) == 0) return 5;
+                    break;
+            }
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_humanname_schema = {
+    .name = "HumanName",
+    .size = sizeof(FHIRHumanName),
+    .fields = g_humanname_fields,
+    .field_count = sizeof(g_humanname_fields) / sizeof(g_humanname_fields[0]),
+    .lookup = fhir_humanname_field_lookup
+};
+
+/* ========================================================================== */
+/* ContactPoint                                                               */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_contactpoint_fields[] = {
+    { .key = "system", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRContactPoint, system) },
+    { .key = "value", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRContactPoint, value) },
+    { .key = "use", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRContactPoint, use) },
+    { .key = "rank", .kind = FHIR_SCHEMA_COUNT, .flags = 0,
+      .offset = offsetof(FHIRContactPoint, rank) },
+    { .key = "period", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRContactPoint, period),
+      .schema = &fhir_period_schema },
+};
+
+static int fhir_contactpoint_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 3:
+            if (memcmp(key, "use", 3) == 0) return 2;
+            break;
+        case 4:
+            if (memcmp(key, "rank", 4) == 0) return 3;
+            break;
+        case 5:
+            if (memcmp(key, "value", 5) == 0) return 1;
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'p':
+                    if (memcmp(key, "period", 6) == 0) return 4;
+                    break;
+                case 's':
+                    if (memcmp(key, "system", 6) == 0) return 0;
+                    break;
+            }
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_contactpoint_schema = {
+    .name = "ContactPoint",
+    .size = sizeof(FHIRContactPoint),
+    .fields = g_contactpoint_fields,
+    .field_count = sizeof(g_contactpoint_fields) / sizeof(g_contactpoint_fields[0]),
+    .lookup = fhir_contactpoint_field_lookup
+};
+
+/* ========================================================================== */
+/* Address                                                                    */
+/* ========================================================================== */
+
+static const FHIRSchemaField g_address_fields[] = {
+    { .key = "use", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, use) },
+    { .key = "type", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, type) },
+    { .key = "text", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, text) },
+    { .key = "line", .kind = FHIR_SCHEMA_TEXT, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRAddress, line), .count_offset = offsetof(FHIRAddress, line_count) },
+    { .key = "city", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, city) },
+    { .key = "district", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, district) },
+    { .key = "state", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, state) },
+    { .key = "postalCode", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, postal_code) },
+    { .key = "country", .kind = FHIR_SCHEMA_TEXT, .flags = 0,
+      .offset = offsetof(FHIRAddress, country) },
+    { .key = "period", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRAddress, period),
+      .schema = &fhir_period_schema },
+};
+
+static int fhir_address_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 3:
+            if (memcmp(key, "use", 3) == 0) return 0;
+            break;
+        case 4:
+            switch (key[2]) {
+                case 'n':
+                    if (memcmp(key, "line", 4) == 0) return 3;
+                    break;
+                case 'p':
+                    if (memcmp(key, "type", 4) == 0) return 1;
+                    break;
+                case 't':
+                    if (memcmp(key, "city", 4) == 0) return 4;
+                    break;
+                case 'x':
+                    if (memcmp(key, "text", 4) == 0) return 2;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(key, "state", 5) == 0) return 6;
+            break;
+        case 6:
+            if (memcmp(key, "period", 6) == 0) return 9;
+            break;
+        case 7:
+            if (memcmp(key, "country", 7) == 0) return 8;
+            break;
+        case 8:
+            if (memcmp(key, "district", 8) == 0) return 5;
+            break;
+        case 9:
+            if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 10:
+            if (memcmp(key, "postalCode", 10) == 0) return 7;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+const FHIRSchema fhir_address_schema = {
+    .name = "Address",
+    .size = sizeof(FHIRAddress),
+    .fields = g_address_fields,
+    .field_count = sizeof(g_address_fields) / sizeof(g_address_fields[0]),
+    .lookup = fhir_address_field_lookup
+};
@@ -0,0 +1,33 @@
+/**
+ * @file fhir_datatype_schemas.h
+ * @brief Codec schemas of the complex data types in fhir_datatypes.h
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ */
+
+#ifndef FHIR_DATATYPE_SCHEMAS_H
+#define FHIR_DATATYPE_SCHEMAS_H
+
+#include "common/fhir_schema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const FHIRSchema fhir_coding_schema;
+extern const FHIRSchema fhir_codeableconcept_schema;
+extern const FHIRSchema fhir_quantity_schema;
+extern const FHIRSchema fhir_period_schema;
+extern const FHIRSchema fhir_identifier_schema;
+extern const FHIRSchema fhir_reference_schema;
+extern const FHIRSchema fhir_humanname_schema;
+extern const FHIRSchema fhir_contactpoint_schema;
+extern const FHIRSchema fhir_address_schema;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_DATATYPE_SCHEMAS_H */
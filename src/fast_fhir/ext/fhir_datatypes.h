@@ -4,6 +4,7 @@
 #include <Python.h>
 #include <stdbool.h>
 #include <cjson/cJSON.h>
+#include "common/fhir_common.h"
 
 // Forward declarations
 struct FHIRElement;
@@ -72,16 +73,19 @@ typedef struct {
 typedef struct {
     FHIRElement base;
     char* value;  // Instant format (YYYY-MM-DDTHH:mm:ss.sss+zz:zz)
+    FHIRDateTimeValue parsed;  // Filled when value is parsed
 } FHIRInstant;
 
 typedef struct {
     FHIRElement base;
     char* value;  // Date format (YYYY, YYYY-MM, or YYYY-MM-DD)
+    FHIRDateTimeValue parsed;  // Filled when value is parsed
 } FHIRDate;
 
 typedef struct {
     FHIRElement base;
     char* value;  // DateTime format
+    FHIRDateTimeValue parsed;  // Filled when value is parsed
 } FHIRDateTime;
 
 typedef struct {
@@ -1,13 +1,96 @@
-#define PY_SSIZE_T_CLEAN
-#include <Python.h>
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
 #include "fhir_datatypes.h"
+#include "fhir_python_json.h"
+#include "common/fhir_json_reader.h"
+#include <limits.h>
 
 // Python wrapper functions for FHIR data types
 
+// Per-module state: member names, interned once per interpreter
+typedef struct {
+    PyObject* key_value;
+    PyObject* key_system;
+    PyObject* key_code;
+    PyObject* key_display;
+    PyObject* key_user_selected;
+    PyObject* key_unit;
+    PyObject* key_comparator;
+} DatatypesModuleState;
+
+#define DATATYPES_KEY_COUNT (sizeof(DatatypesModuleState) / sizeof(PyObject*))
+
+// Store a new reference under an interned key, consuming the reference
+static int set_item(PyObject* dict, PyObject* key, PyObject* value) {
+    if (!value) {
+        return -1;
+    }
+    int result = PyDict_SetItem(dict, key, value);
+    Py_DECREF(value);
+    return result;
+}
+
+// Store an optional C string under an interned key
+static int set_string(PyObject* dict, PyObject* key, const char* value) {
+    return value ? set_item(dict, key, PyUnicode_FromString(value)) : 0;
+}
+
+// Wrap a single primitive value as {"value": value}
+static PyObject* value_dict(const DatatypesModuleState* state, PyObject* value) {
+    PyObject* dict = PyDict_New();
+    if (!dict || set_item(dict, state->key_value, value) < 0) {
+        Py_XDECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+static PyObject* coding_to_python(const DatatypesModuleState* state, const FHIRCoding* coding) {
+    PyObject* dict = PyDict_New();
+    if (!dict ||
+        set_string(dict, state->key_system, coding->system) < 0 ||
+        set_string(dict, state->key_code, coding->code) < 0 ||
+        set_string(dict, state->key_display, coding->display) < 0 ||
+        set_item(dict, state->key_user_selected, PyBool_FromLong(coding->user_selected)) < 0) {
+        Py_XDECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+static void coding_free(FHIRCoding* coding) {
+    fhir_string_free(coding->system);
+    fhir_string_free(coding->code);
+    fhir_string_free(coding->display);
+    free(coding);
+}
+
+static PyObject* quantity_to_python(const DatatypesModuleState* state, const FHIRQuantity* quantity) {
+    PyObject* dict = PyDict_New();
+    if (!dict ||
+        set_item(dict, state->key_value, PyFloat_FromDouble(quantity->value)) < 0 ||
+        set_string(dict, state->key_unit, quantity->unit) < 0 ||
+        set_string(dict, state->key_system, quantity->system) < 0 ||
+        set_string(dict, state->key_code, quantity->code) < 0 ||
+        set_string(dict, state->key_comparator, quantity->comparator) < 0) {
+        Py_XDECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+static void quantity_free(FHIRQuantity* quantity) {
+    fhir_string_free(quantity->unit);
+    fhir_string_free(quantity->system);
+    fhir_string_free(quantity->code);
+    fhir_string_free(quantity->comparator);
+    free(quantity);
+}
+
 // Create Python objects from C structures
-static PyObject* py_fhir_string_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_string_create(PyObject* self, PyObject* arg) {
     const char* value;
-    if (!PyArg_ParseTuple(args, "s", &value)) {
+    if (!fhir_python_text_arg(arg, &value, NULL)) {
         return NULL;
     }
     
@@ -18,10 +101,9 @@ static PyObject* py_fhir_string_create(PyObject* self, PyObject* args) {
     }
     
     // Create Python dictionary representation
-    PyObject* dict = PyDict_New();
-    if (fhir_str->value) {
-        PyDict_SetItemString(dict, "value", PyUnicode_FromString(fhir_str->value));
-    }
+    PyObject* dict = fhir_str->value
+        ? value_dict(PyModule_GetState(self), PyUnicode_FromString(fhir_str->value))
+        : PyDict_New();
     
     // Clean up C structure
     fhir_string_free(fhir_str->value);
@@ -30,9 +112,9 @@ static PyObject* py_fhir_string_create(PyObject* self, PyObject* args) {
     return dict;
 }
 
-static PyObject* py_fhir_boolean_create(PyObject* self, PyObject* args) {
-    int value;
-    if (!PyArg_ParseTuple(args, "p", &value)) {
+static PyObject* py_fhir_boolean_create(PyObject* self, PyObject* arg) {
+    int value = PyObject_IsTrue(arg);
+    if (value < 0) {
         return NULL;
     }
     
@@ -42,35 +124,38 @@ static PyObject* py_fhir_boolean_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    PyDict_SetItemString(dict, "value", PyBool_FromLong(fhir_bool->value));
+    PyObject* dict = value_dict(PyModule_GetState(self), PyBool_FromLong(fhir_bool->value));
     
     free(fhir_bool);
     return dict;
 }
 
-static PyObject* py_fhir_integer_create(PyObject* self, PyObject* args) {
-    int value;
-    if (!PyArg_ParseTuple(args, "i", &value)) {
+static PyObject* py_fhir_integer_create(PyObject* self, PyObject* arg) {
+    int overflow;
+    long value = PyLong_AsLongAndOverflow(arg, &overflow);
+    if (value == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+    if (overflow || value < INT_MIN || value > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "FHIR integer is out of range");
         return NULL;
     }
     
-    FHIRInteger* fhir_int = fhir_integer_create(value);
+    FHIRInteger* fhir_int = fhir_integer_create((int)value);
     if (!fhir_int) {
         PyErr_SetString(PyExc_MemoryError, "Failed to create FHIR integer");
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    PyDict_SetItemString(dict, "value", PyLong_FromLong(fhir_int->value));
+    PyObject* dict = value_dict(PyModule_GetState(self), PyLong_FromLong(fhir_int->value));
     
     free(fhir_int);
     return dict;
 }
 
-static PyObject* py_fhir_decimal_create(PyObject* self, PyObject* args) {
-    double value;
-    if (!PyArg_ParseTuple(args, "d", &value)) {
+static PyObject* py_fhir_decimal_create(PyObject* self, PyObject* arg) {
+    double value = PyFloat_AsDouble(arg);
+    if (value == -1.0 && PyErr_Occurred()) {
         return NULL;
     }
     
@@ -80,19 +165,21 @@ static PyObject* py_fhir_decimal_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    PyDict_SetItemString(dict, "value", PyFloat_FromDouble(fhir_decimal->value));
+    PyObject* dict = value_dict(PyModule_GetState(self), PyFloat_FromDouble(fhir_decimal->value));
     
     free(fhir_decimal);
     return dict;
 }
 
-static PyObject* py_fhir_coding_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_coding_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* system = NULL;
     const char* code = NULL;
     const char* display = NULL;
     
-    if (!PyArg_ParseTuple(args, "|zzz", &system, &code, &display)) {
+    if (!fhir_python_check_args("create_coding", nargs, 0, 3) ||
+        (nargs > 0 && !fhir_python_optional_text_arg(args[0], &system)) ||
+        (nargs > 1 && !fhir_python_optional_text_arg(args[1], &code)) ||
+        (nargs > 2 && !fhir_python_optional_text_arg(args[2], &display))) {
         return NULL;
     }
     
@@ -102,34 +189,26 @@ static PyObject* py_fhir_coding_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    if (coding->system) {
-        PyDict_SetItemString(dict, "system", PyUnicode_FromString(coding->system));
-    }
-    if (coding->code) {
-        PyDict_SetItemString(dict, "code", PyUnicode_FromString(coding->code));
-    }
-    if (coding->display) {
-        PyDict_SetItemString(dict, "display", PyUnicode_FromString(coding->display));
-    }
-    PyDict_SetItemString(dict, "userSelected", PyBool_FromLong(coding->user_selected));
-    
-    // Clean up
-    fhir_string_free(coding->system);
-    fhir_string_free(coding->code);
-    fhir_string_free(coding->display);
-    free(coding);
+    PyObject* dict = coding_to_python(PyModule_GetState(self), coding);
+    coding_free(coding);
     
     return dict;
 }
 
-static PyObject* py_fhir_quantity_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_quantity_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     double value;
     const char* unit = NULL;
     const char* system = NULL;
     const char* code = NULL;
     
-    if (!PyArg_ParseTuple(args, "d|zzz", &value, &unit, &system, &code)) {
+    if (!fhir_python_check_args("create_quantity", nargs, 1, 4)) {
+        return NULL;
+    }
+    value = PyFloat_AsDouble(args[0]);
+    if ((value == -1.0 && PyErr_Occurred()) ||
+        (nargs > 1 && !fhir_python_optional_text_arg(args[1], &unit)) ||
+        (nargs > 2 && !fhir_python_optional_text_arg(args[2], &system)) ||
+        (nargs > 3 && !fhir_python_optional_text_arg(args[3], &code))) {
         return NULL;
     }
     
@@ -139,120 +218,85 @@ static PyObject* py_fhir_quantity_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    PyObject* dict = PyDict_New();
-    PyDict_SetItemString(dict, "value", PyFloat_FromDouble(quantity->value));
-    if (quantity->unit) {
-        PyDict_SetItemString(dict, "unit", PyUnicode_FromString(quantity->unit));
-    }
-    if (quantity->system) {
-        PyDict_SetItemString(dict, "system", PyUnicode_FromString(quantity->system));
-    }
-    if (quantity->code) {
-        PyDict_SetItemString(dict, "code", PyUnicode_FromString(quantity->code));
-    }
-    
-    // Clean up
-    fhir_string_free(quantity->unit);
-    fhir_string_free(quantity->system);
-    fhir_string_free(quantity->code);
-    free(quantity);
+    PyObject* dict = quantity_to_python(PyModule_GetState(self), quantity);
+    quantity_free(quantity);
     
     return dict;
 }
 
 // Parse JSON to FHIR data types
-static PyObject* py_fhir_parse_coding(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_parse_coding(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    FHIRCoding* coding = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        coding = fhir_parse_coding(json);
+        cJSON_Delete(json);
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRCoding* coding = fhir_parse_coding(json);
-    cJSON_Delete(json);
-    
     if (!coding) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Coding");
         return NULL;
     }
     
     // Convert to Python dict
-    PyObject* dict = PyDict_New();
-    if (coding->system) {
-        PyDict_SetItemString(dict, "system", PyUnicode_FromString(coding->system));
-    }
-    if (coding->code) {
-        PyDict_SetItemString(dict, "code", PyUnicode_FromString(coding->code));
-    }
-    if (coding->display) {
-        PyDict_SetItemString(dict, "display", PyUnicode_FromString(coding->display));
-    }
-    PyDict_SetItemString(dict, "userSelected", PyBool_FromLong(coding->user_selected));
-    
-    // Clean up
-    fhir_string_free(coding->system);
-    fhir_string_free(coding->code);
-    fhir_string_free(coding->display);
-    free(coding);
+    PyObject* dict = coding_to_python(PyModule_GetState(self), coding);
+    coding_free(coding);
     
     return dict;
 }
 
-static PyObject* py_fhir_parse_quantity(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_parse_quantity(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    FHIRQuantity* quantity = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        quantity = fhir_parse_quantity(json);
+        cJSON_Delete(json);
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRQuantity* quantity = fhir_parse_quantity(json);
-    cJSON_Delete(json);
-    
     if (!quantity) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Quantity");
         return NULL;
     }
     
     // Convert to Python dict
-    PyObject* dict = PyDict_New();
-    PyDict_SetItemString(dict, "value", PyFloat_FromDouble(quantity->value));
-    if (quantity->unit) {
-        PyDict_SetItemString(dict, "unit", PyUnicode_FromString(quantity->unit));
-    }
-    if (quantity->system) {
-        PyDict_SetItemString(dict, "system", PyUnicode_FromString(quantity->system));
-    }
-    if (quantity->code) {
-        PyDict_SetItemString(dict, "code", PyUnicode_FromString(quantity->code));
-    }
-    if (quantity->comparator) {
-        PyDict_SetItemString(dict, "comparator", PyUnicode_FromString(quantity->comparator));
-    }
-    
-    // Clean up
-    fhir_string_free(quantity->unit);
-    fhir_string_free(quantity->system);
-    fhir_string_free(quantity->code);
-    fhir_string_free(quantity->comparator);
-    free(quantity);
+    PyObject* dict = quantity_to_python(PyModule_GetState(self), quantity);
+    quantity_free(quantity);
     
     return dict;
 }
 
 // Validation functions
-static PyObject* py_fhir_validate_date(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_validate_date(PyObject* self, PyObject* arg) {
     const char* date;
-    if (!PyArg_ParseTuple(args, "s", &date)) {
+    if (!fhir_python_text_arg(arg, &date, NULL)) {
         return NULL;
     }
     
@@ -260,9 +304,9 @@ static PyObject* py_fhir_validate_date(PyObject* self, PyObject* args) {
     return PyBool_FromLong(is_valid);
 }
 
-static PyObject* py_fhir_validate_time(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_validate_time(PyObject* self, PyObject* arg) {
     const char* time;
-    if (!PyArg_ParseTuple(args, "s", &time)) {
+    if (!fhir_python_text_arg(arg, &time, NULL)) {
         return NULL;
     }
     
@@ -270,9 +314,9 @@ static PyObject* py_fhir_validate_time(PyObject* self, PyObject* args) {
     return PyBool_FromLong(is_valid);
 }
 
-static PyObject* py_fhir_validate_uri(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_validate_uri(PyObject* self, PyObject* arg) {
     const char* uri;
-    if (!PyArg_ParseTuple(args, "s", &uri)) {
+    if (!fhir_python_text_arg(arg, &uri, NULL)) {
         return NULL;
     }
     
@@ -280,9 +324,9 @@ static PyObject* py_fhir_validate_uri(PyObject* self, PyObject* args) {
     return PyBool_FromLong(is_valid);
 }
 
-static PyObject* py_fhir_validate_code(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_validate_code(PyObject* self, PyObject* arg) {
     const char* code;
-    if (!PyArg_ParseTuple(args, "s", &code)) {
+    if (!fhir_python_text_arg(arg, &code, NULL)) {
         return NULL;
     }
     
@@ -293,36 +337,94 @@ static PyObject* py_fhir_validate_code(PyObject* self, PyObject* args) {
 // Method definitions
 static PyMethodDef FHIRDatatypesMethods[] = {
     // Creation functions
-    {"create_string", py_fhir_string_create, METH_VARARGS, "Create FHIR string"},
-    {"create_boolean", py_fhir_boolean_create, METH_VARARGS, "Create FHIR boolean"},
-    {"create_integer", py_fhir_integer_create, METH_VARARGS, "Create FHIR integer"},
-    {"create_decimal", py_fhir_decimal_create, METH_VARARGS, "Create FHIR decimal"},
-    {"create_coding", py_fhir_coding_create, METH_VARARGS, "Create FHIR coding"},
-    {"create_quantity", py_fhir_quantity_create, METH_VARARGS, "Create FHIR quantity"},
+    {"create_string", py_fhir_string_create, METH_O, "Create FHIR string"},
+    {"create_boolean", py_fhir_boolean_create, METH_O, "Create FHIR boolean"},
+    {"create_integer", py_fhir_integer_create, METH_O, "Create FHIR integer"},
+    {"create_decimal", py_fhir_decimal_create, METH_O, "Create FHIR decimal"},
+    {"create_coding", (PyCFunction)(void (*)(void))py_fhir_coding_create, METH_FASTCALL, "Create FHIR coding"},
+    {"create_quantity", (PyCFunction)(void (*)(void))py_fhir_quantity_create, METH_FASTCALL, "Create FHIR quantity"},
     
     // Parsing functions
-    {"parse_coding", py_fhir_parse_coding, METH_VARARGS, "Parse FHIR Coding from JSON"},
-    {"parse_quantity", py_fhir_parse_quantity, METH_VARARGS, "Parse FHIR Quantity from JSON"},
+    {"parse_coding", py_fhir_parse_coding, METH_O, "Parse FHIR Coding from JSON"},
+    {"parse_quantity", py_fhir_parse_quantity, METH_O, "Parse FHIR Quantity from JSON"},
     
     // Validation functions
-    {"validate_date", py_fhir_validate_date, METH_VARARGS, "Validate FHIR date format"},
-    {"validate_time", py_fhir_validate_time, METH_VARARGS, "Validate FHIR time format"},
-    {"validate_uri", py_fhir_validate_uri, METH_VARARGS, "Validate FHIR URI format"},
-    {"validate_code", py_fhir_validate_code, METH_VARARGS, "Validate FHIR code format"},
+    {"validate_date", py_fhir_validate_date, METH_O, "Validate FHIR date format"},
+    {"validate_time", py_fhir_validate_time, METH_O, "Validate FHIR time format"},
+    {"validate_uri", py_fhir_validate_uri, METH_O, "Validate FHIR URI format"},
+    {"validate_code", py_fhir_validate_code, METH_O, "Validate FHIR code format"},
     
     {NULL, NULL, 0, NULL}
 };
 
+static PyObject** state_keys(PyObject* module) {
+    return (PyObject**)PyModule_GetState(module);
+}
+
+static int datatypes_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    PyObject** keys = state_keys(module);
+    for (size_t i = 0; i < DATATYPES_KEY_COUNT; i++) {
+        Py_VISIT(keys[i]);
+    }
+    return 0;
+}
+
+static int datatypes_module_clear(PyObject* module) {
+    PyObject** keys = state_keys(module);
+    for (size_t i = 0; i < DATATYPES_KEY_COUNT; i++) {
+        Py_CLEAR(keys[i]);
+    }
+    return 0;
+}
+
+static void datatypes_module_free(void* module) {
+    datatypes_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int datatypes_module_exec(PyObject* module) {
+    DatatypesModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    struct {
+        PyObject** slot;
+        const char* name;
+    } keys[] = {
+        {&state->key_value, "value"},
+        {&state->key_system, "system"},
+        {&state->key_code, "code"},
+        {&state->key_display, "display"},
+        {&state->key_user_selected, "userSelected"},
+        {&state->key_unit, "unit"},
+        {&state->key_comparator, "comparator"},
+    };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (!(*keys[i].slot = PyUnicode_InternFromString(keys[i].name))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static PyModuleDef_Slot datatypes_module_slots[] = FHIR_PY_MODULE_SLOTS(datatypes_module_exec);
+
 // Module definition
 static struct PyModuleDef fhir_datatypes_module = {
     PyModuleDef_HEAD_INIT,
     "fhir_datatypes_c",
     "FHIR R5 data types implemented in C",
-    -1,
-    FHIRDatatypesMethods
+    sizeof(DatatypesModuleState),
+    FHIRDatatypesMethods,
+    datatypes_module_slots,
+    datatypes_module_traverse,
+    datatypes_module_clear,
+    datatypes_module_free
 };
 
 // Module initialization
 PyMODINIT_FUNC PyInit_fhir_datatypes_c(void) {
-    return PyModule_Create(&fhir_datatypes_module);
-}
\ No newline at end of file
+    return PyModuleDef_Init(&fhir_datatypes_module);
+}
@@ -0,0 +1,554 @@
+/**
+ * @file fhir_decompress.c
+ * @brief Pipelined decompression of gzip and zstd Bulk Data files
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_decompress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef FHIR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    bool ready;
+} FHIRDecompressBlock;
+
+#ifdef FHIR_HAVE_ZSTD
+typedef struct {
+    size_t offset;
+    size_t length;
+    size_t content_size;
+} FHIRZstdFrame;
+#endif
+
+struct FHIRDecompressor {
+    // Input
+    const unsigned char* input;
+    size_t input_length;
+    size_t input_offset;
+    FHIRCompression compression;
+
+    // Ring of output blocks; output block i lives in slot i % block_count
+    FHIRDecompressBlock* blocks;
+    size_t block_count;
+    size_t next_claim;
+    size_t next_consume;
+    size_t total_blocks;    // SIZE_MAX until the producer reaches the end
+    bool holding;           // Consumer still holds block next_consume
+
+    // Producers
+    pthread_t* threads;
+    size_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t block_ready;
+    pthread_cond_t slot_free;
+    bool stopping;
+    bool failed;
+    FHIRErrorCode error_code;
+    const char* error_message;
+
+    // Streaming decoders, driven by a single producer
+    z_stream inflate_stream;
+    bool inflate_ready;
+#ifdef FHIR_HAVE_ZSTD
+    ZSTD_DStream* zstd_stream;
+    bool zstd_pending;
+    FHIRZstdFrame* frames;
+    size_t frame_count;
+#endif
+};
+
+/* ========================================================================== */
+/* Formats                                                                    */
+/* ========================================================================== */
+
+FHIRCompression fhir_compression_detect(const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    if (!bytes) return FHIR_COMPRESSION_NONE;
+
+    if (length >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+        return FHIR_COMPRESSION_GZIP;
+    }
+    // zstd frame (0xFD2FB528) or skippable frame (0x184D2A50-5F), little-endian
+    if (length >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) {
+        return FHIR_COMPRESSION_ZSTD;
+    }
+    if (length >= 4 && (bytes[0] & 0xf0) == 0x50 && bytes[1] == 0x2a && bytes[2] == 0x4d &&
+        bytes[3] == 0x18) {
+        return FHIR_COMPRESSION_ZSTD;
+    }
+    return FHIR_COMPRESSION_NONE;
+}
+
+bool fhir_compression_available(FHIRCompression compression) {
+    switch (compression) {
+        case FHIR_COMPRESSION_NONE:
+        case FHIR_COMPRESSION_GZIP:
+            return true;
+        case FHIR_COMPRESSION_ZSTD:
+#ifdef FHIR_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* fhir_compression_name(FHIRCompression compression) {
+    switch (compression) {
+        case FHIR_COMPRESSION_NONE: return "none";
+        case FHIR_COMPRESSION_GZIP: return "gzip";
+        case FHIR_COMPRESSION_ZSTD: return "zstd";
+        default: return "auto";
+    }
+}
+
+/* ========================================================================== */
+/* Block Ring                                                                 */
+/* ========================================================================== */
+
+// Wait until output block `index` has a free slot (mutex held); NULL when stopping
+static FHIRDecompressBlock* wait_for_slot(FHIRDecompressor* decompressor, size_t index) {
+    while (!decompressor->stopping && !decompressor->failed &&
+           index >= decompressor->next_consume + decompressor->block_count) {
+        pthread_cond_wait(&decompressor->slot_free, &decompressor->mutex);
+    }
+    if (decompressor->stopping || decompressor->failed) return NULL;
+    return &decompressor->blocks[index % decompressor->block_count];
+}
+
+static bool reserve_block(FHIRDecompressBlock* block, size_t capacity) {
+    if (block->capacity >= capacity) return true;
+
+    char* data = fhir_realloc(block->data, capacity);
+    if (!data) return false;
+    block->data = data;
+    block->capacity = capacity;
+    return true;
+}
+
+static void fail(FHIRDecompressor* decompressor, FHIRErrorCode code, const char* message) {
+    pthread_mutex_lock(&decompressor->mutex);
+    if (!decompressor->failed) {
+        decompressor->failed = true;
+        decompressor->error_code = code;
+        decompressor->error_message = message;
+    }
+    pthread_cond_broadcast(&decompressor->block_ready);
+    pthread_cond_broadcast(&decompressor->slot_free);
+    pthread_mutex_unlock(&decompressor->mutex);
+}
+
+/* ========================================================================== */
+/* Streaming Decoders                                                         */
+/* ========================================================================== */
+
+// Inflate into block until it is full or the last gzip member ends
+static bool inflate_fill(FHIRDecompressor* decompressor, FHIRDecompressBlock* block, bool* done) {
+    z_stream* stream = &decompressor->inflate_stream;
+    stream->next_out = (Bytef*)block->data;
+    stream->avail_out = (uInt)block->capacity;
+
+    while (stream->avail_out > 0) {
+        if (stream->avail_in == 0 && decompressor->input_offset < decompressor->input_length) {
+            size_t chunk = decompressor->input_length - decompressor->input_offset;
+            if (chunk > UINT_MAX) chunk = UINT_MAX;
+            stream->next_in = (Bytef*)(decompressor->input + decompressor->input_offset);
+            stream->avail_in = (uInt)chunk;
+            decompressor->input_offset += chunk;
+        }
+
+        int status = inflate(stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            // Another member follows in multi-member files; like gzip, ignore trailing bytes
+            size_t next = decompressor->input_offset - stream->avail_in;
+            if (fhir_compression_detect(decompressor->input + next,
+                                        decompressor->input_length - next) != FHIR_COMPRESSION_GZIP) {
+                *done = true;
+                break;
+            }
+            inflateReset(stream);
+        } else if (status == Z_BUF_ERROR) {
+            // No input left inside a member
+            fail(decompressor, FHIR_ERROR_PARSE_FAILED, "Truncated gzip stream");
+            return false;
+        } else if (status != Z_OK) {
+            fail(decompressor, status == Z_MEM_ERROR ? FHIR_ERROR_OUT_OF_MEMORY : FHIR_ERROR_PARSE_FAILED,
+                 status == Z_MEM_ERROR ? "Out of memory" : "Corrupt gzip stream");
+            return false;
+        }
+    }
+
+    block->length = block->capacity - stream->avail_out;
+    return true;
+}
+
+#ifdef FHIR_HAVE_ZSTD
+// Decompress into block until it is full or the input ends
+static bool zstd_fill(FHIRDecompressor* decompressor, FHIRDecompressBlock* block, bool* done) {
+    ZSTD_outBuffer out = { block->data, block->capacity, 0 };
+
+    while (out.pos < out.size) {
+        if (decompressor->input_offset == decompressor->input_length && !decompressor->zstd_pending) {
+            *done = true;
+            break;
+        }
+
+        ZSTD_inBuffer in = { decompressor->input + decompressor->input_offset,
+                             decompressor->input_length - decompressor->input_offset, 0 };
+        size_t produced = out.pos;
+        size_t hint = ZSTD_decompressStream(decompressor->zstd_stream, &out, &in);
+        if (ZSTD_isError(hint)) {
+            fail(decompressor, FHIR_ERROR_PARSE_FAILED, "Corrupt zstd frame");
+            return false;
+        }
+        decompressor->input_offset += in.pos;
+        decompressor->zstd_pending = hint != 0;
+
+        if (in.pos == 0 && out.pos == produced) {
+            // Mid-frame with no input left and nothing buffered
+            fail(decompressor, FHIR_ERROR_PARSE_FAILED, "Truncated zstd stream");
+            return false;
+        }
+    }
+
+    block->length = out.pos;
+    return true;
+}
+#endif
+
+// Single producer: decode the whole input as one stream of fixed-size blocks
+static void* stream_main(void* arg) {
+    FHIRDecompressor* decompressor = arg;
+    bool done = false;
+
+    for (size_t index = 0; !done; index++) {
+        pthread_mutex_lock(&decompressor->mutex);
+        FHIRDecompressBlock* block = wait_for_slot(decompressor, index);
+        pthread_mutex_unlock(&decompressor->mutex);
+        if (!block) break;
+
+        if (!reserve_block(block, FHIR_DECOMPRESS_BLOCK_SIZE)) {
+            fail(decompressor, FHIR_ERROR_OUT_OF_MEMORY, "Out of memory");
+            break;
+        }
+
+        bool filled;
+#ifdef FHIR_HAVE_ZSTD
+        if (decompressor->compression == FHIR_COMPRESSION_ZSTD) {
+            filled = zstd_fill(decompressor, block, &done);
+        } else
+#endif
+        {
+            filled = inflate_fill(decompressor, block, &done);
+        }
+        if (!filled) break;
+
+        pthread_mutex_lock(&decompressor->mutex);
+        if (block->length > 0) {
+            block->ready = true;
+            if (done) decompressor->total_blocks = index + 1;
+        } else {
+            decompressor->total_blocks = index;
+        }
+        pthread_cond_broadcast(&decompressor->block_ready);
+        pthread_mutex_unlock(&decompressor->mutex);
+    }
+
+    // Producer threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+/* ========================================================================== */
+/* Parallel zstd Frames                                                       */
+/* ========================================================================== */
+
+#ifdef FHIR_HAVE_ZSTD
+// Record frame boundaries; true if every frame can be decoded on its own thread
+static bool scan_frames(FHIRDecompressor* decompressor, bool* parallel) {
+    size_t capacity = 0;
+    bool sized = true;
+
+    for (size_t offset = 0; offset < decompressor->input_length;) {
+        const unsigned char* start = decompressor->input + offset;
+        size_t remaining = decompressor->input_length - offset;
+        size_t length = ZSTD_findFrameCompressedSize(start, remaining);
+        if (ZSTD_isError(length)) {
+            FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Corrupt zstd frame");
+            return false;
+        }
+
+        unsigned long long content_size = ZSTD_getFrameContentSize(start, length);
+        if (content_size == ZSTD_CONTENTSIZE_UNKNOWN || content_size == ZSTD_CONTENTSIZE_ERROR ||
+            content_size > FHIR_DECOMPRESS_MAX_FRAME_SIZE) {
+            sized = false;
+        }
+
+        if (decompressor->frame_count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 16;
+            FHIRZstdFrame* frames = fhir_realloc(decompressor->frames,
+                                                 new_capacity * sizeof(FHIRZstdFrame));
+            if (!frames) return false;
+            decompressor->frames = frames;
+            capacity = new_capacity;
+        }
+        FHIRZstdFrame* frame = &decompressor->frames[decompressor->frame_count++];
+        frame->offset = offset;
+        frame->length = length;
+        frame->content_size = sized ? (size_t)content_size : 0;
+        offset += length;
+    }
+
+    *parallel = sized && decompressor->frame_count > 1;
+    return true;
+}
+
+static void publish_block(FHIRDecompressor* decompressor, FHIRDecompressBlock* block) {
+    pthread_mutex_lock(&decompressor->mutex);
+    block->ready = true;
+    pthread_cond_broadcast(&decompressor->block_ready);
+    pthread_mutex_unlock(&decompressor->mutex);
+}
+
+// Frame producer: claim frames in order and decode each into its own block
+static void* frame_main(void* arg) {
+    FHIRDecompressor* decompressor = arg;
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (!context) {
+        fail(decompressor, FHIR_ERROR_OUT_OF_MEMORY, "Out of memory");
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&decompressor->mutex);
+        size_t index = decompressor->next_claim;
+        FHIRDecompressBlock* block = NULL;
+        if (index < decompressor->frame_count) {
+            decompressor->next_claim++;
+            block = wait_for_slot(decompressor, index);
+        }
+        pthread_mutex_unlock(&decompressor->mutex);
+        if (!block) break;
+
+        const FHIRZstdFrame* frame = &decompressor->frames[index];
+        if (!reserve_block(block, frame->content_size > 0 ? frame->content_size : 1)) {
+            fail(decompressor, FHIR_ERROR_OUT_OF_MEMORY, "Out of memory");
+            break;
+        }
+
+        size_t written = ZSTD_decompressDCtx(context, block->data, block->capacity,
+                                             decompressor->input + frame->offset, frame->length);
+        if (ZSTD_isError(written) || written != frame->content_size) {
+            fail(decompressor, FHIR_ERROR_PARSE_FAILED, "Corrupt zstd frame");
+            break;
+        }
+        block->length = written;
+        publish_block(decompressor, block);
+    }
+
+    ZSTD_freeDCtx(context);
+    fhir_clear_error();
+    return NULL;
+}
+#endif
+
+/* ========================================================================== */
+/* Decompressor                                                               */
+/* ========================================================================== */
+
+FHIRDecompressor* fhir_decompressor_create(const void* data, size_t length,
+                                           FHIRCompression compression,
+                                           size_t thread_count, size_t block_count) {
+    if (!data && length > 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Compressed buffer is NULL");
+        return NULL;
+    }
+    if (compression == FHIR_COMPRESSION_AUTO) {
+        compression = fhir_compression_detect(data, length);
+    }
+    if (compression == FHIR_COMPRESSION_NONE) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Input is not compressed");
+        return NULL;
+    }
+    if (!fhir_compression_available(compression)) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Compression not supported by this build",
+                             fhir_compression_name(compression));
+        return NULL;
+    }
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    FHIRDecompressor* decompressor = fhir_calloc(1, sizeof(FHIRDecompressor));
+    if (!decompressor) return NULL;
+
+    decompressor->input = data ? data : (const void*)"";
+    decompressor->input_length = length;
+    decompressor->compression = compression;
+    decompressor->total_blocks = SIZE_MAX;
+    pthread_mutex_init(&decompressor->mutex, NULL);
+    pthread_cond_init(&decompressor->block_ready, NULL);
+    pthread_cond_init(&decompressor->slot_free, NULL);
+
+    size_t producers = 1;
+    void* (*producer_main)(void*) = stream_main;
+
+    if (compression == FHIR_COMPRESSION_GZIP) {
+        if (inflateInit2(&decompressor->inflate_stream, 16 + MAX_WBITS) != Z_OK) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to initialize gzip stream");
+            fhir_decompressor_destroy(decompressor);
+            return NULL;
+        }
+        decompressor->inflate_ready = true;
+    }
+#ifdef FHIR_HAVE_ZSTD
+    if (compression == FHIR_COMPRESSION_ZSTD) {
+        bool parallel = false;
+        if (!scan_frames(decompressor, &parallel)) {
+            fhir_decompressor_destroy(decompressor);
+            return NULL;
+        }
+        if (parallel) {
+            producers = thread_count < decompressor->frame_count ? thread_count
+                                                                 : decompressor->frame_count;
+            producer_main = frame_main;
+            decompressor->total_blocks = decompressor->frame_count;
+        } else {
+            decompressor->zstd_stream = ZSTD_createDStream();
+            if (!decompressor->zstd_stream || ZSTD_isError(ZSTD_initDStream(decompressor->zstd_stream))) {
+                FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to initialize zstd stream");
+                fhir_decompressor_destroy(decompressor);
+                return NULL;
+            }
+        }
+    }
+#endif
+
+    if (block_count == 0) {
+        block_count = producers * 2 < 4 ? 4 : producers * 2;
+    }
+    decompressor->block_count = block_count;
+    decompressor->blocks = fhir_calloc(block_count, sizeof(FHIRDecompressBlock));
+    decompressor->threads = fhir_calloc(producers, sizeof(pthread_t));
+    if (!decompressor->blocks || !decompressor->threads) {
+        fhir_decompressor_destroy(decompressor);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < producers; i++) {
+        if (pthread_create(&decompressor->threads[i], NULL, producer_main, decompressor) != 0) {
+            break;
+        }
+        decompressor->thread_count++;
+    }
+    if (decompressor->thread_count == 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_UNKNOWN, "Failed to start decompression thread");
+        fhir_decompressor_destroy(decompressor);
+        return NULL;
+    }
+    return decompressor;
+}
+
+const char* fhir_decompressor_next(FHIRDecompressor* decompressor, size_t* length) {
+    if (!decompressor || !length) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    *length = 0;
+
+    pthread_mutex_lock(&decompressor->mutex);
+    for (;;) {
+        FHIRDecompressBlock* block = &decompressor->blocks[decompressor->next_consume %
+                                                          decompressor->block_count];
+        if (decompressor->holding) {
+            // Hand the previous block back to the producers
+            block->ready = false;
+            decompressor->next_consume++;
+            decompressor->holding = false;
+            pthread_cond_broadcast(&decompressor->slot_free);
+            block = &decompressor->blocks[decompressor->next_consume % decompressor->block_count];
+        }
+
+        while (!block->ready && !decompressor->failed &&
+               decompressor->next_consume < decompressor->total_blocks) {
+            pthread_cond_wait(&decompressor->block_ready, &decompressor->mutex);
+        }
+        if (!block->ready) break;
+
+        decompressor->holding = true;
+        if (block->length > 0) {
+            *length = block->length;
+            pthread_mutex_unlock(&decompressor->mutex);
+            return block->data;
+        }
+    }
+
+    bool failed = decompressor->failed;
+    FHIRErrorCode code = decompressor->error_code;
+    const char* message = decompressor->error_message;
+    pthread_mutex_unlock(&decompressor->mutex);
+
+    if (failed) {
+        FHIR_SET_ERROR(code, message);
+    }
+    return NULL;
+}
+
+bool fhir_decompressor_failed(FHIRDecompressor* decompressor) {
+    if (!decompressor) return false;
+
+    pthread_mutex_lock(&decompressor->mutex);
+    bool failed = decompressor->failed;
+    pthread_mutex_unlock(&decompressor->mutex);
+    return failed;
+}
+
+void fhir_decompressor_destroy(FHIRDecompressor* decompressor) {
+    if (!decompressor) return;
+
+    pthread_mutex_lock(&decompressor->mutex);
+    decompressor->stopping = true;
+    pthread_cond_broadcast(&decompressor->slot_free);
+    pthread_cond_broadcast(&decompressor->block_ready);
+    pthread_mutex_unlock(&decompressor->mutex);
+
+    for (size_t i = 0; i < decompressor->thread_count; i++) {
+        pthread_join(decompressor->threads[i], NULL);
+    }
+    fhir_free(decompressor->threads);
+
+    if (decompressor->blocks) {
+        for (size_t i = 0; i < decompressor->block_count; i++) {
+            fhir_free(decompressor->blocks[i].data);
+        }
+        fhir_free(decompressor->blocks);
+    }
+
+    if (decompressor->inflate_ready) {
+        inflateEnd(&decompressor->inflate_stream);
+    }
+#ifdef FHIR_HAVE_ZSTD
+    ZSTD_freeDStream(decompressor->zstd_stream);
+    fhir_free(decompressor->frames);
+#endif
+
+    pthread_mutex_destroy(&decompressor->mutex);
+    pthread_cond_destroy(&decompressor->block_ready);
+    pthread_cond_destroy(&decompressor->slot_free);
+    fhir_free(decompressor);
+}
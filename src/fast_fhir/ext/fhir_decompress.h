@@ -0,0 +1,132 @@
+/**
+ * @file fhir_decompress.h
+ * @brief Pipelined decompression of gzip and zstd Bulk Data files
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Bulk Data exports are often published as .ndjson.gz or .ndjson.zst. A
+ * decompressor runs on its own threads over the compressed bytes (usually
+ * a memory-mapped file) and hands decompressed blocks to one consumer, in
+ * order, through a fixed ring of block buffers: the producers stop when the
+ * ring is full, so memory stays bounded however large the export is.
+ *
+ * gzip is inflated on one thread, member after member, so concatenated
+ * (multi-member) files such as those written by pigz or bgzip decode
+ * completely. zstd files made of several frames (pzstd output, or .zst
+ * files concatenated together) decode one frame per thread; a single frame,
+ * or one without a recorded size, streams on one thread.
+ * zstd support is compiled in when FHIR_HAVE_ZSTD is defined.
+ */
+
+#ifndef FHIR_DECOMPRESS_H
+#define FHIR_DECOMPRESS_H
+
+#include "common/fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+#define FHIR_DECOMPRESS_BLOCK_SIZE (1u << 20)           /**< Output block of the streaming decoders */
+#define FHIR_DECOMPRESS_MAX_FRAME_SIZE (64u << 20)      /**< Largest zstd frame decoded in one piece */
+
+/**
+ * @brief Compression format of an input
+ */
+typedef enum {
+    FHIR_COMPRESSION_AUTO = 0,  /**< Detect from the leading magic bytes */
+    FHIR_COMPRESSION_NONE,      /**< Plain text */
+    FHIR_COMPRESSION_GZIP,      /**< gzip, one or more members */
+    FHIR_COMPRESSION_ZSTD       /**< zstd, one or more frames */
+} FHIRCompression;
+
+/**
+ * @brief Opaque decompressor
+ */
+typedef struct FHIRDecompressor FHIRDecompressor;
+
+/* ========================================================================== */
+/* Formats                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Detect the compression of an input from its magic bytes
+ * @param data Start of the input
+ * @param length Length of data in bytes
+ * @return FHIR_COMPRESSION_GZIP, FHIR_COMPRESSION_ZSTD or FHIR_COMPRESSION_NONE
+ */
+FHIRCompression fhir_compression_detect(const void* data, size_t length);
+
+/**
+ * @brief Check whether this build can decompress a format
+ * @param compression Format to check
+ * @return true for NONE and GZIP, and for ZSTD when built with FHIR_HAVE_ZSTD
+ */
+bool fhir_compression_available(FHIRCompression compression);
+
+/**
+ * @brief Get the name of a format ("none", "gzip", "zstd")
+ * @param compression Format
+ * @return Static name string
+ */
+const char* fhir_compression_name(FHIRCompression compression);
+
+/* ========================================================================== */
+/* Decompressor                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Start decompressing a compressed buffer in the background
+ *
+ * @param data Compressed bytes; must outlive the decompressor
+ * @param length Length of data in bytes
+ * @param compression FHIR_COMPRESSION_GZIP or FHIR_COMPRESSION_ZSTD
+ *        (FHIR_COMPRESSION_AUTO detects one of them)
+ * @param thread_count Threads decoding zstd frames (0 = number of online CPUs)
+ * @param block_count Decompressed blocks buffered ahead of the consumer
+ *        (0 = two per thread, at least four)
+ * @return New decompressor or NULL on failure (FHIR_ERROR_INVALID_ARGUMENT
+ *         for plain or unsupported input, FHIR_ERROR_PARSE_FAILED for a
+ *         corrupt zstd frame table)
+ */
+FHIRDecompressor* fhir_decompressor_create(const void* data, size_t length,
+                                           FHIRCompression compression,
+                                           size_t thread_count, size_t block_count);
+
+/**
+ * @brief Take the next decompressed block, in input order
+ *
+ * Blocks the calling thread until the block is ready. The previous block is
+ * handed back to the producers by this call.
+ *
+ * @param decompressor Decompressor to read
+ * @param length Output length of the block in bytes
+ * @return Block valid until the next call, or NULL at end of input or on a
+ *         corrupt stream (see fhir_decompressor_failed)
+ */
+const char* fhir_decompressor_next(FHIRDecompressor* decompressor, size_t* length);
+
+/**
+ * @brief Check whether decompression stopped on an error
+ * @param decompressor Decompressor to query
+ * @return true after a corrupt or truncated stream was found
+ */
+bool fhir_decompressor_failed(FHIRDecompressor* decompressor);
+
+/**
+ * @brief Stop the producer threads and free a decompressor
+ * @param decompressor Decompressor to destroy (may be NULL)
+ */
+void fhir_decompressor_destroy(FHIRDecompressor* decompressor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_DECOMPRESS_H */
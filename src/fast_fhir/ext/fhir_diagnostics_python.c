@@ -0,0 +1,305 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "common/fhir_resource_base.h"
+
+// Python binding for the C core's diagnostics. Each extension module keeps
+// its own counters (see fhir_python_runtime.h); these functions combine the
+// modules loaded when they are called.
+
+#define MAX_RUNTIMES 64
+
+typedef struct {
+    const FHIRPythonRuntime* items[MAX_RUNTIMES];
+    size_t count;
+} RuntimeList;
+
+// Runtimes exported by the modules in sys.modules, each once even if imported under two names
+static bool collect_runtimes(RuntimeList* list) {
+    list->count = 0;
+    PyObject* modules = PyDict_Values(PyImport_GetModuleDict());
+    if (!modules) {
+        return false;
+    }
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(modules) && list->count < MAX_RUNTIMES; i++) {
+        PyObject* module = PyList_GET_ITEM(modules, i);
+        if (!PyModule_Check(module)) {
+            continue;
+        }
+        PyObject* capsule = PyDict_GetItemString(PyModule_GetDict(module), FHIR_PY_RUNTIME_ATTRIBUTE);
+        if (!capsule || !PyCapsule_IsValid(capsule, FHIR_PY_RUNTIME_CAPSULE)) {
+            continue;
+        }
+        const FHIRPythonRuntime* runtime = PyCapsule_GetPointer(capsule, FHIR_PY_RUNTIME_CAPSULE);
+        bool seen = false;
+        for (size_t j = 0; j < list->count && !seen; j++) {
+            seen = list->items[j] == runtime;
+        }
+        if (!seen) {
+            list->items[list->count++] = runtime;
+        }
+    }
+    Py_DECREF(modules);
+    return true;
+}
+
+/* ========================================================================== */
+/* Memory Statistics                                                          */
+/* ========================================================================== */
+
+static PyObject* memory_stats_to_python(const FHIRMemoryStats* stats) {
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:L,s:L}",
+                         "allocations", (Py_ssize_t)stats->allocations,
+                         "frees", (Py_ssize_t)stats->frees,
+                         "arena_allocations", (Py_ssize_t)stats->arena_allocations,
+                         "bytes_allocated", (Py_ssize_t)stats->bytes_allocated,
+                         "bytes_freed", (Py_ssize_t)stats->bytes_freed,
+                         "live_bytes", (long long)stats->live_bytes,
+                         "peak_bytes", (long long)stats->peak_bytes);
+}
+
+// Allocation counters summed over the loaded modules, with per-type attribution
+static PyObject* py_fhir_memory_stats(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"thread", "reset", NULL};
+    int thread = 0;
+    int reset = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pp", kwlist, &thread, &reset)) {
+        return NULL;
+    }
+    RuntimeList runtimes;
+    if (!collect_runtimes(&runtimes)) {
+        return NULL;
+    }
+
+    // Peaks are reached at different times, so the summed peak is an upper bound
+    FHIRMemoryStats stats = {0};
+    FHIRMemoryTypeStats by_type_stats[FHIR_RESOURCE_TYPE_COUNT] = {{0}};
+    bool enabled = false;
+    for (size_t i = 0; i < runtimes.count; i++) {
+        const FHIRPythonRuntime* runtime = runtimes.items[i];
+        FHIRMemoryStats module_stats;
+        if (thread) {
+            runtime->memory_get_thread_stats(&module_stats);
+        } else {
+            runtime->memory_get_stats(&module_stats);
+        }
+        stats.allocations += module_stats.allocations;
+        stats.frees += module_stats.frees;
+        stats.arena_allocations += module_stats.arena_allocations;
+        stats.bytes_allocated += module_stats.bytes_allocated;
+        stats.bytes_freed += module_stats.bytes_freed;
+        stats.live_bytes += module_stats.live_bytes;
+        stats.peak_bytes += module_stats.peak_bytes;
+        enabled = enabled || runtime->memory_stats_enabled();
+
+        for (int type = FHIR_RESOURCE_TYPE_UNKNOWN + 1; !thread && type < FHIR_RESOURCE_TYPE_COUNT; type++) {
+            FHIRMemoryTypeStats type_stats;
+            if (runtime->memory_get_type_stats(type, &type_stats)) {
+                by_type_stats[type].allocations += type_stats.allocations;
+                by_type_stats[type].bytes_allocated += type_stats.bytes_allocated;
+            }
+        }
+    }
+
+    PyObject* result = memory_stats_to_python(&stats);
+    PyObject* by_type = PyDict_New();
+    if (!result || !by_type) {
+        Py_XDECREF(result);
+        Py_XDECREF(by_type);
+        return NULL;
+    }
+
+    for (int type = FHIR_RESOURCE_TYPE_UNKNOWN + 1; type < FHIR_RESOURCE_TYPE_COUNT; type++) {
+        if (by_type_stats[type].allocations == 0) {
+            continue;
+        }
+        PyObject* item = Py_BuildValue("{s:n,s:n}", "allocations", (Py_ssize_t)by_type_stats[type].allocations,
+                                       "bytes_allocated", (Py_ssize_t)by_type_stats[type].bytes_allocated);
+        if (!item || PyDict_SetItemString(by_type, fhir_resource_type_to_string((FHIRResourceType)type), item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(by_type);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+
+    if (PyDict_SetItemString(result, "by_type", by_type) < 0 ||
+        PyDict_SetItemString(result, "enabled", enabled ? Py_True : Py_False) < 0) {
+        Py_DECREF(by_type);
+        Py_DECREF(result);
+        return NULL;
+    }
+    Py_DECREF(by_type);
+
+    for (size_t i = 0; reset && i < runtimes.count; i++) {
+        runtimes.items[i]->memory_stats_reset();
+    }
+    return result;
+}
+
+static PyObject* py_enable_memory_stats(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"enabled", NULL};
+    int enabled = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &enabled)) {
+        return NULL;
+    }
+    if (enabled && !FHIR_MEMORY_STATS) {
+        PyErr_SetString(PyExc_RuntimeError, "Memory statistics are not compiled in");
+        return NULL;
+    }
+    RuntimeList runtimes;
+    if (!collect_runtimes(&runtimes)) {
+        return NULL;
+    }
+    bool previous = false;
+    for (size_t i = 0; i < runtimes.count; i++) {
+        previous = runtimes.items[i]->memory_stats_set_enabled(enabled != 0) || previous;
+    }
+    return PyBool_FromLong(previous);
+}
+
+/* ========================================================================== */
+/* Performance Counters                                                       */
+/* ========================================================================== */
+
+// Per-type counters summed over the loaded modules, keyed by resourceType ("unknown" for tokenizing)
+static PyObject* py_perf_counters(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"reset", NULL};
+    int reset = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &reset)) {
+        return NULL;
+    }
+    RuntimeList runtimes;
+    if (!collect_runtimes(&runtimes)) {
+        return NULL;
+    }
+
+    PyObject* result = PyDict_New();
+    for (int type = FHIR_RESOURCE_TYPE_UNKNOWN; result && type < FHIR_RESOURCE_TYPE_COUNT; type++) {
+        FHIRPerfCounters counters = {0};
+        uint64_t calls = 0;
+        for (size_t i = 0; i < runtimes.count; i++) {
+            FHIRPerfCounters module_counters;
+            if (!runtimes.items[i]->perf_get_counters(type, &module_counters)) continue;
+            counters.parsed += module_counters.parsed;
+            counters.failures += module_counters.failures;
+            counters.bytes += module_counters.bytes;
+            for (int phase = 0; phase < FHIR_PERF_PHASE_COUNT; phase++) {
+                counters.calls[phase] += module_counters.calls[phase];
+                counters.nanoseconds[phase] += module_counters.nanoseconds[phase];
+            }
+        }
+        for (int phase = 0; phase < FHIR_PERF_PHASE_COUNT; phase++) {
+            calls += counters.calls[phase];
+        }
+        if (calls == 0) continue;
+
+        PyObject* phases = PyDict_New();
+        for (int phase = 0; phases && phase < FHIR_PERF_PHASE_COUNT; phase++) {
+            PyObject* item = Py_BuildValue("{s:K,s:K}", "calls", (unsigned long long)counters.calls[phase],
+                                           "nanoseconds", (unsigned long long)counters.nanoseconds[phase]);
+            if (!item || PyDict_SetItemString(phases, fhir_perf_phase_name((FHIRPerfPhase)phase), item) < 0) {
+                Py_CLEAR(phases);
+            }
+            Py_XDECREF(item);
+        }
+        PyObject* entry = phases ? Py_BuildValue("{s:K,s:K,s:K,s:N}",
+                                                 "parsed", (unsigned long long)counters.parsed,
+                                                 "failures", (unsigned long long)counters.failures,
+                                                 "bytes", (unsigned long long)counters.bytes,
+                                                 "phases", phases) : NULL;
+        const char* name = type == FHIR_RESOURCE_TYPE_UNKNOWN ? "unknown"
+                                                              : fhir_resource_type_to_string((FHIRResourceType)type);
+        if (!entry || PyDict_SetItemString(result, name, entry) < 0) {
+            Py_CLEAR(result);
+        }
+        Py_XDECREF(entry);
+    }
+
+    for (size_t i = 0; result && reset && i < runtimes.count; i++) {
+        runtimes.items[i]->perf_reset();
+    }
+    return result;
+}
+
+static PyObject* py_enable_perf_counters(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"enabled", NULL};
+    int enabled = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &enabled)) {
+        return NULL;
+    }
+    RuntimeList runtimes;
+    if (!collect_runtimes(&runtimes)) {
+        return NULL;
+    }
+    bool previous = false;
+    for (size_t i = 0; i < runtimes.count; i++) {
+        previous = runtimes.items[i]->perf_set_enabled(enabled != 0) || previous;
+    }
+    return PyBool_FromLong(previous);
+}
+
+/* ========================================================================== */
+/* Object Pools                                                               */
+/* ========================================================================== */
+
+// Trim the pools of every loaded module; returns the bytes released in total
+static PyObject* py_trim_object_pools(PyObject* self, PyObject* Py_UNUSED(ignored)) {
+    RuntimeList runtimes;
+    if (!collect_runtimes(&runtimes)) {
+        return NULL;
+    }
+    size_t released = 0;
+    for (size_t i = 0; i < runtimes.count; i++) {
+        released += runtimes.items[i]->pool_trim();
+    }
+    return PyLong_FromSize_t(released);
+}
+
+/* ========================================================================== */
+/* Module                                                                     */
+/* ========================================================================== */
+
+static PyMethodDef DiagnosticsModuleMethods[] = {
+    {"fhir_memory_stats", (PyCFunction)py_fhir_memory_stats, METH_VARARGS | METH_KEYWORDS,
+     "Allocation counters summed over the loaded extension modules (process-wide, or thread=True "
+     "for the calling thread); reset=True zeroes them"},
+    {"enable_memory_stats", (PyCFunction)py_enable_memory_stats, METH_VARARGS | METH_KEYWORDS,
+     "Turn allocation accounting on or off in the loaded extension modules; returns the previous setting"},
+    {"perf_counters", (PyCFunction)py_perf_counters, METH_VARARGS | METH_KEYWORDS,
+     "Per-type span counters (calls and nanoseconds per phase) summed over the loaded extension modules; "
+     "reset=True zeroes them"},
+    {"enable_perf_counters", (PyCFunction)py_enable_perf_counters, METH_VARARGS | METH_KEYWORDS,
+     "Turn the per-type performance counters on or off in the loaded extension modules; returns the previous setting"},
+    {"trim_object_pools", py_trim_object_pools, METH_NOARGS,
+     "Free the pooled resource structs cached by this thread and the shared free lists of the loaded "
+     "extension modules; returns bytes released"},
+    {NULL, NULL, 0, NULL}
+};
+
+// Module execution (once per interpreter); the module keeps no state
+static int diagnostics_module_exec(PyObject* module) {
+    (void)module;
+    return 0;
+}
+
+static PyModuleDef_Slot diagnostics_module_slots[] = FHIR_PY_MODULE_SLOTS(diagnostics_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_diagnostics_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_diagnostics_c",
+    "Allocation accounting, performance counters and object pools of the FHIR C extensions",
+    0,
+    DiagnosticsModuleMethods,
+    diagnostics_module_slots
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_diagnostics_c(void) {
+    return PyModuleDef_Init(&fhir_diagnostics_module);
+}
@@ -0,0 +1,931 @@
+/**
+ * @file fhir_directory_index.c
+ * @brief Reference graph over provider directory resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_directory_index.h"
+#include "common/fhir_resource_type_lookup.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Codes are numbered per kind: code number * FHIR_DIRECTORY_CODE_KIND_COUNT + kind
+#define TAG_CODE(code, kind) ((code) * FHIR_DIRECTORY_CODE_KIND_COUNT + (uint32_t)(kind))
+
+/* ========================================================================== */
+/* Index Structure                                                            */
+/* ========================================================================== */
+
+// Interned strings numbered in insertion order
+typedef struct {
+    char** strings;
+    size_t count;
+    size_t capacity;
+    uint32_t* slots;             // String + 1 by hash, 0 when empty
+    size_t slot_capacity;
+} StringTable;
+
+typedef struct {
+    uint32_t target;
+    uint32_t edge;
+} DirectoryLink;
+
+// A resource that was added or referenced; links and codes belong to added ones
+typedef struct {
+    FHIRResourceType type;
+    bool loaded;
+    bool active;
+    DirectoryLink* links;        // Ordered by edge
+    uint32_t link_count;
+    uint32_t* codes;             // Tagged code numbers
+    uint32_t code_count;
+} DirectoryNode;
+
+struct FHIRDirectoryIndex {
+    StringTable references;      // "Type/id" of node i at position i
+    DirectoryNode* nodes;
+    size_t node_capacity;
+    StringTable codes;           // "system|code" and bare "code"
+    size_t edge_count;
+    bool dirty;
+
+    // Built arrays, valid while !dirty
+    size_t built_nodes;
+    uint32_t* out_offsets;       // Edges of node n: out_offsets[n] .. out_offsets[n + 1]
+    uint32_t* out_targets;
+    uint8_t* out_edges;
+    uint32_t* in_offsets;        // Edges into node n, sources ascending
+    uint32_t* in_sources;
+    uint8_t* in_edges;
+    uint32_t* code_offsets;      // Nodes with tagged code c, ascending
+    uint32_t* code_nodes;
+    size_t built_tags;
+};
+
+// FNV-1a
+static size_t hash_string(const char* text, size_t length) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * UINT64_C(1099511628211);
+    }
+    return (size_t)hash;
+}
+
+static uint32_t table_find(const StringTable* table, const char* text, size_t length) {
+    if (table->slot_capacity == 0) return FHIR_DIRECTORY_NONE;
+
+    size_t mask = table->slot_capacity - 1;
+    for (size_t position = hash_string(text, length) & mask; table->slots[position];
+         position = (position + 1) & mask) {
+        const char* candidate = table->strings[table->slots[position] - 1];
+        if (strncmp(candidate, text, length) == 0 && candidate[length] == '\0') {
+            return table->slots[position] - 1;
+        }
+    }
+    return FHIR_DIRECTORY_NONE;
+}
+
+static bool table_reserve(StringTable* table) {
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 64;
+        char** strings = fhir_realloc(table->strings, capacity * sizeof(char*));
+        if (!strings) return false;
+        table->strings = strings;
+        table->capacity = capacity;
+    }
+    if ((table->count + 1) * 2 <= table->slot_capacity) return true;
+
+    size_t capacity = table->slot_capacity ? table->slot_capacity * 2 : 128;
+    uint32_t* slots = fhir_calloc(capacity, sizeof(uint32_t));
+    if (!slots) return false;
+    for (size_t i = 0; i < table->count; i++) {
+        const char* text = table->strings[i];
+        size_t position = hash_string(text, strlen(text)) & (capacity - 1);
+        while (slots[position]) position = (position + 1) & (capacity - 1);
+        slots[position] = (uint32_t)i + 1;
+    }
+    fhir_free(table->slots);
+    table->slots = slots;
+    table->slot_capacity = capacity;
+    return true;
+}
+
+// Number of text, adding it when new; *added tells which. FHIR_DIRECTORY_NONE when out of memory
+static uint32_t table_intern(StringTable* table, const char* text, size_t length, bool* added) {
+    *added = false;
+    uint32_t found = table_find(table, text, length);
+    if (found != FHIR_DIRECTORY_NONE) return found;
+    if (table->count >= FHIR_DIRECTORY_NONE - 1 || !table_reserve(table)) return FHIR_DIRECTORY_NONE;
+
+    char* copy = fhir_malloc(length + 1);
+    if (!copy) return FHIR_DIRECTORY_NONE;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+
+    size_t mask = table->slot_capacity - 1;
+    size_t position = hash_string(text, length) & mask;
+    while (table->slots[position]) position = (position + 1) & mask;
+    table->strings[table->count] = copy;
+    table->slots[position] = (uint32_t)++table->count;
+    *added = true;
+    return (uint32_t)(table->count - 1);
+}
+
+static void table_cleanup(StringTable* table) {
+    for (size_t i = 0; i < table->count; i++) {
+        fhir_free(table->strings[i]);
+    }
+    fhir_free(table->strings);
+    fhir_free(table->slots);
+}
+
+static void free_built(FHIRDirectoryIndex* index) {
+    fhir_free(index->out_offsets);
+    fhir_free(index->out_targets);
+    fhir_free(index->out_edges);
+    fhir_free(index->in_offsets);
+    fhir_free(index->in_sources);
+    fhir_free(index->in_edges);
+    fhir_free(index->code_offsets);
+    fhir_free(index->code_nodes);
+    index->out_offsets = index->out_targets = index->in_offsets = NULL;
+    index->in_sources = index->code_offsets = index->code_nodes = NULL;
+    index->out_edges = index->in_edges = NULL;
+}
+
+FHIRDirectoryIndex* fhir_directory_index_create(void) {
+    FHIRDirectoryIndex* index = fhir_calloc(1, sizeof(FHIRDirectoryIndex));
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate directory index");
+    }
+    return index;
+}
+
+void fhir_directory_index_destroy(FHIRDirectoryIndex* index) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->references.count; i++) {
+        fhir_free(index->nodes[i].links);
+        fhir_free(index->nodes[i].codes);
+    }
+    fhir_free(index->nodes);
+    table_cleanup(&index->references);
+    table_cleanup(&index->codes);
+    free_built(index);
+    fhir_free(index);
+}
+
+/* ========================================================================== */
+/* Adding Resources                                                           */
+/* ========================================================================== */
+
+// Locate "Type/id" in a relative or absolute reference; false for contained
+// (#id), conditional and unknown-type references
+static bool reference_key(const char* reference, const char** key, size_t* length) {
+    if (!reference || !*reference || reference[0] == '#' || strchr(reference, '?')) return false;
+
+    size_t end = strlen(reference);
+    const char* history = strstr(reference, "/_history/");
+    if (history) end = (size_t)(history - reference);
+    while (end > 0 && reference[end - 1] == '/') end--;
+
+    size_t slash = end;
+    while (slash > 0 && reference[slash - 1] != '/') slash--;
+    if (slash == 0 || slash == end) return false;
+
+    size_t start = slash - 1;
+    while (start > 0 && reference[start - 1] != '/') start--;
+    if (fhir_resource_type_lookup(reference + start, slash - 1 - start) == FHIR_RESOURCE_TYPE_UNKNOWN) {
+        return false;
+    }
+    *key = reference + start;
+    *length = end - start;
+    return true;
+}
+
+// Node of a "Type/id" key, created (not loaded) when new
+static uint32_t intern_node(FHIRDirectoryIndex* index, const char* key, size_t length) {
+    if (index->references.count == index->node_capacity) {
+        size_t capacity = index->node_capacity ? index->node_capacity * 2 : 64;
+        DirectoryNode* nodes = fhir_realloc(index->nodes, capacity * sizeof(DirectoryNode));
+        if (!nodes) return FHIR_DIRECTORY_NONE;
+        index->nodes = nodes;
+        index->node_capacity = capacity;
+    }
+
+    bool added;
+    uint32_t node = table_intern(&index->references, key, length, &added);
+    if (added) {
+        DirectoryNode* entry = &index->nodes[node];
+        memset(entry, 0, sizeof(DirectoryNode));
+        const char* slash = memchr(key, '/', length);
+        entry->type = fhir_resource_type_lookup(key, slash ? (size_t)(slash - key) : length);
+        entry->active = true;
+        index->dirty = true;
+    }
+    return node;
+}
+
+// Growable link and code lists of the resource being added
+typedef struct {
+    DirectoryLink* links;
+    size_t link_count;
+    size_t link_capacity;
+    uint32_t* codes;
+    size_t code_count;
+    size_t code_capacity;
+} NodeBuilder;
+
+static bool add_link(FHIRDirectoryIndex* index, NodeBuilder* builder, const cJSON* reference,
+                     FHIRDirectoryEdge edge) {
+    const char* key;
+    size_t length;
+    const char* text = cJSON_IsObject(reference) ? fhir_json_get_string(reference, "reference") : NULL;
+    if (!reference_key(text, &key, &length)) return true;
+
+    uint32_t target = intern_node(index, key, length);
+    if (target == FHIR_DIRECTORY_NONE) return false;
+
+    for (size_t i = 0; i < builder->link_count; i++) {
+        if (builder->links[i].target == target && builder->links[i].edge == (uint32_t)edge) return true;
+    }
+    if (builder->link_count == builder->link_capacity) {
+        size_t capacity = builder->link_capacity ? builder->link_capacity * 2 : 8;
+        DirectoryLink* links = fhir_realloc(builder->links, capacity * sizeof(DirectoryLink));
+        if (!links) return false;
+        builder->links = links;
+        builder->link_capacity = capacity;
+    }
+    builder->links[builder->link_count++] = (DirectoryLink){ target, (uint32_t)edge };
+    return true;
+}
+
+static bool add_links(FHIRDirectoryIndex* index, NodeBuilder* builder, const cJSON* json, const char* key,
+                      FHIRDirectoryEdge edge) {
+    const cJSON* member = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!cJSON_IsArray(member)) return add_link(index, builder, member, edge);
+
+    const cJSON* item;
+    cJSON_ArrayForEach(item, member) {
+        if (!add_link(index, builder, item, edge)) return false;
+    }
+    return true;
+}
+
+static bool add_code(FHIRDirectoryIndex* index, NodeBuilder* builder, const char* text, size_t length,
+                     FHIRDirectoryCodeKind kind) {
+    bool added;
+    uint32_t code = table_intern(&index->codes, text, length, &added);
+    if (code == FHIR_DIRECTORY_NONE || code > (UINT32_MAX - kind) / FHIR_DIRECTORY_CODE_KIND_COUNT) return false;
+
+    uint32_t tag = TAG_CODE(code, kind);
+    for (size_t i = 0; i < builder->code_count; i++) {
+        if (builder->codes[i] == tag) return true;
+    }
+    if (builder->code_count == builder->code_capacity) {
+        size_t capacity = builder->code_capacity ? builder->code_capacity * 2 : 8;
+        uint32_t* codes = fhir_realloc(builder->codes, capacity * sizeof(uint32_t));
+        if (!codes) return false;
+        builder->codes = codes;
+        builder->code_capacity = capacity;
+    }
+    builder->codes[builder->code_count++] = tag;
+    return true;
+}
+
+// Every coding of a CodeableConcept as "system|code" and as the bare "code"
+static bool add_concept_codes(FHIRDirectoryIndex* index, NodeBuilder* builder, const cJSON* concept,
+                              FHIRDirectoryCodeKind kind) {
+    const cJSON* coding;
+    cJSON_ArrayForEach(coding, cJSON_GetObjectItemCaseSensitive(concept, "coding")) {
+        const char* code = fhir_json_get_string(coding, "code");
+        if (!code || !*code) continue;
+        if (!add_code(index, builder, code, strlen(code), kind)) return false;
+
+        const char* system = fhir_json_get_string(coding, "system");
+        if (!system || !*system) continue;
+
+        size_t system_length = strlen(system), code_length = strlen(code);
+        char* qualified = fhir_malloc(system_length + code_length + 2);
+        if (!qualified) return false;
+        memcpy(qualified, system, system_length);
+        qualified[system_length] = '|';
+        memcpy(qualified + system_length + 1, code, code_length + 1);
+        bool ok = add_code(index, builder, qualified, system_length + code_length + 1, kind);
+        fhir_free(qualified);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static bool add_codes(FHIRDirectoryIndex* index, NodeBuilder* builder, const cJSON* json, const char* key,
+                      FHIRDirectoryCodeKind kind) {
+    const cJSON* member = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!cJSON_IsArray(member)) return add_concept_codes(index, builder, member, kind);
+
+    const cJSON* concept;
+    cJSON_ArrayForEach(concept, member) {
+        if (!add_concept_codes(index, builder, concept, kind)) return false;
+    }
+    return true;
+}
+
+static int compare_links(const void* left, const void* right) {
+    const DirectoryLink* a = left;
+    const DirectoryLink* b = right;
+    if (a->edge != b->edge) return a->edge < b->edge ? -1 : 1;
+    return a->target < b->target ? -1 : a->target > b->target;
+}
+
+bool fhir_directory_index_add_json(FHIRDirectoryIndex* index, const cJSON* json) {
+    if (!index || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    const char* type_name = fhir_json_get_string(json, "resourceType");
+    const char* id = fhir_json_get_string(json, "id");
+    FHIRResourceType type = type_name ? fhir_resource_type_lookup(type_name, strlen(type_name))
+                                      : FHIR_RESOURCE_TYPE_UNKNOWN;
+    if (type == FHIR_RESOURCE_TYPE_UNKNOWN || !id || !*id || strchr(id, '/')) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Expected a resource with resourceType and id");
+        return false;
+    }
+
+    size_t type_length = strlen(type_name), id_length = strlen(id);
+    char* key = fhir_malloc(type_length + id_length + 2);
+    if (!key) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow directory index");
+        return false;
+    }
+    memcpy(key, type_name, type_length);
+    key[type_length] = '/';
+    memcpy(key + type_length + 1, id, id_length + 1);
+    uint32_t node = intern_node(index, key, type_length + id_length + 1);
+    fhir_free(key);
+
+    NodeBuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    bool ok = node != FHIR_DIRECTORY_NONE;
+
+    switch (type) {
+        case FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE:
+            ok = ok && add_links(index, &builder, json, "practitioner", FHIR_DIRECTORY_EDGE_PRACTITIONER) &&
+                 add_links(index, &builder, json, "organization", FHIR_DIRECTORY_EDGE_ORGANIZATION) &&
+                 add_links(index, &builder, json, "location", FHIR_DIRECTORY_EDGE_LOCATION) &&
+                 add_links(index, &builder, json, "healthcareService", FHIR_DIRECTORY_EDGE_SERVICE) &&
+                 add_codes(index, &builder, json, "specialty", FHIR_DIRECTORY_CODE_SPECIALTY) &&
+                 add_codes(index, &builder, json, "code", FHIR_DIRECTORY_CODE_ROLE);
+            break;
+        case FHIR_RESOURCE_TYPE_ORGANIZATION_AFFILIATION:
+            ok = ok && add_links(index, &builder, json, "organization", FHIR_DIRECTORY_EDGE_ORGANIZATION) &&
+                 add_links(index, &builder, json, "participatingOrganization", FHIR_DIRECTORY_EDGE_PARTICIPATING) &&
+                 add_links(index, &builder, json, "network", FHIR_DIRECTORY_EDGE_NETWORK) &&
+                 add_links(index, &builder, json, "location", FHIR_DIRECTORY_EDGE_LOCATION) &&
+                 add_links(index, &builder, json, "healthcareService", FHIR_DIRECTORY_EDGE_SERVICE) &&
+                 add_codes(index, &builder, json, "specialty", FHIR_DIRECTORY_CODE_SPECIALTY) &&
+                 add_codes(index, &builder, json, "code", FHIR_DIRECTORY_CODE_ROLE);
+            break;
+        case FHIR_RESOURCE_TYPE_ORGANIZATION:
+            ok = ok && add_links(index, &builder, json, "partOf", FHIR_DIRECTORY_EDGE_PART_OF) &&
+                 add_codes(index, &builder, json, "type", FHIR_DIRECTORY_CODE_TYPE);
+            break;
+        case FHIR_RESOURCE_TYPE_LOCATION:
+            ok = ok && add_links(index, &builder, json, "partOf", FHIR_DIRECTORY_EDGE_PART_OF) &&
+                 add_links(index, &builder, json, "managingOrganization",
+                           FHIR_DIRECTORY_EDGE_MANAGING_ORGANIZATION) &&
+                 add_codes(index, &builder, json, "type", FHIR_DIRECTORY_CODE_TYPE);
+            break;
+        default:
+            break;
+    }
+
+    if (!ok) {
+        fhir_free(builder.links);
+        fhir_free(builder.codes);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow directory index");
+        return false;
+    }
+
+    if (builder.link_count > 1) {
+        qsort(builder.links, builder.link_count, sizeof(DirectoryLink), compare_links);
+    }
+    DirectoryNode* entry = &index->nodes[node];
+    index->edge_count -= entry->link_count;
+    index->edge_count += builder.link_count;
+    fhir_free(entry->links);
+    fhir_free(entry->codes);
+    entry->links = builder.links;
+    entry->link_count = (uint32_t)builder.link_count;
+    entry->codes = builder.codes;
+    entry->code_count = (uint32_t)builder.code_count;
+    entry->loaded = true;
+    const cJSON* active = cJSON_GetObjectItemCaseSensitive(json, "active");
+    entry->active = !cJSON_IsFalse(active);
+    index->dirty = true;
+    return true;
+}
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+bool fhir_directory_index_build(FHIRDirectoryIndex* index) {
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!index->dirty) return true;
+
+    free_built(index);
+    size_t node_count = index->references.count;
+    size_t edge_count = index->edge_count;
+    size_t tag_count = index->codes.count * FHIR_DIRECTORY_CODE_KIND_COUNT;
+    size_t posting_count = 0;
+    for (size_t n = 0; n < node_count; n++) {
+        posting_count += index->nodes[n].code_count;
+    }
+
+    index->out_offsets = fhir_calloc(node_count + 1, sizeof(uint32_t));
+    index->out_targets = fhir_malloc((edge_count + 1) * sizeof(uint32_t));
+    index->out_edges = fhir_malloc(edge_count + 1);
+    index->in_offsets = fhir_calloc(node_count + 2, sizeof(uint32_t));
+    index->in_sources = fhir_malloc((edge_count + 1) * sizeof(uint32_t));
+    index->in_edges = fhir_malloc(edge_count + 1);
+    index->code_offsets = fhir_calloc(tag_count + 2, sizeof(uint32_t));
+    index->code_nodes = fhir_malloc((posting_count + 1) * sizeof(uint32_t));
+    if (!index->out_offsets || !index->out_targets || !index->out_edges || !index->in_offsets ||
+        !index->in_sources || !index->in_edges || !index->code_offsets || !index->code_nodes) {
+        free_built(index);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to build directory index");
+        return false;
+    }
+
+    // Forward edges in node order; count the reverse edges and postings on the way
+    uint32_t position = 0;
+    for (size_t n = 0; n < node_count; n++) {
+        const DirectoryNode* node = &index->nodes[n];
+        index->out_offsets[n] = position;
+        for (uint32_t l = 0; l < node->link_count; l++) {
+            index->out_targets[position] = node->links[l].target;
+            index->out_edges[position++] = (uint8_t)node->links[l].edge;
+            index->in_offsets[node->links[l].target + 2]++;
+        }
+        for (uint32_t c = 0; c < node->code_count; c++) {
+            index->code_offsets[node->codes[c] + 2]++;
+        }
+    }
+    index->out_offsets[node_count] = position;
+
+    // Counting sort by target (and by code): visiting sources in order keeps each list ascending
+    for (size_t n = 2; n < node_count + 2; n++) {
+        index->in_offsets[n] += index->in_offsets[n - 1];
+    }
+    for (size_t t = 2; t < tag_count + 2; t++) {
+        index->code_offsets[t] += index->code_offsets[t - 1];
+    }
+    for (size_t n = 0; n < node_count; n++) {
+        const DirectoryNode* node = &index->nodes[n];
+        for (uint32_t l = 0; l < node->link_count; l++) {
+            uint32_t slot = index->in_offsets[node->links[l].target + 1]++;
+            index->in_sources[slot] = (uint32_t)n;
+            index->in_edges[slot] = (uint8_t)node->links[l].edge;
+        }
+        for (uint32_t c = 0; c < node->code_count; c++) {
+            index->code_nodes[index->code_offsets[node->codes[c] + 1]++] = (uint32_t)n;
+        }
+    }
+
+    index->built_nodes = node_count;
+    index->built_tags = tag_count;
+    index->dirty = false;
+    return true;
+}
+
+bool fhir_directory_index_needs_build(const FHIRDirectoryIndex* index) {
+    return index && index->dirty;
+}
+
+/* ========================================================================== */
+/* Nodes                                                                      */
+/* ========================================================================== */
+
+size_t fhir_directory_index_node_count(const FHIRDirectoryIndex* index) {
+    return index ? index->references.count : 0;
+}
+
+size_t fhir_directory_index_edge_count(const FHIRDirectoryIndex* index) {
+    return index ? index->edge_count : 0;
+}
+
+uint32_t fhir_directory_index_find(const FHIRDirectoryIndex* index, const char* reference) {
+    const char* key;
+    size_t length;
+    if (!index || !reference_key(reference, &key, &length)) return FHIR_DIRECTORY_NONE;
+    return table_find(&index->references, key, length);
+}
+
+const char* fhir_directory_index_reference(const FHIRDirectoryIndex* index, uint32_t node) {
+    return index && node < index->references.count ? index->references.strings[node] : NULL;
+}
+
+FHIRResourceType fhir_directory_index_type(const FHIRDirectoryIndex* index, uint32_t node) {
+    return index && node < index->references.count ? index->nodes[node].type : FHIR_RESOURCE_TYPE_UNKNOWN;
+}
+
+bool fhir_directory_index_is_loaded(const FHIRDirectoryIndex* index, uint32_t node) {
+    return index && node < index->references.count && index->nodes[node].loaded;
+}
+
+/* ========================================================================== */
+/* Node Lists                                                                 */
+/* ========================================================================== */
+
+void fhir_directory_nodes_init(FHIRDirectoryNodes* nodes) {
+    if (!nodes) return;
+    memset(nodes, 0, sizeof(FHIRDirectoryNodes));
+}
+
+void fhir_directory_nodes_cleanup(FHIRDirectoryNodes* nodes) {
+    if (!nodes) return;
+    fhir_free(nodes->items);
+    memset(nodes, 0, sizeof(FHIRDirectoryNodes));
+}
+
+void fhir_directory_matches_init(FHIRDirectoryMatches* matches) {
+    if (!matches) return;
+    memset(matches, 0, sizeof(FHIRDirectoryMatches));
+}
+
+void fhir_directory_matches_cleanup(FHIRDirectoryMatches* matches) {
+    if (!matches) return;
+    fhir_free(matches->items);
+    memset(matches, 0, sizeof(FHIRDirectoryMatches));
+}
+
+static bool nodes_reserve(FHIRDirectoryNodes* nodes, size_t count) {
+    if (count <= nodes->capacity) return true;
+
+    size_t capacity = nodes->capacity ? nodes->capacity : 16;
+    while (capacity < count) capacity *= 2;
+    uint32_t* items = fhir_realloc(nodes->items, capacity * sizeof(uint32_t));
+    if (!items) return false;
+    nodes->items = items;
+    nodes->capacity = capacity;
+    return true;
+}
+
+static bool nodes_push(FHIRDirectoryNodes* nodes, uint32_t node) {
+    if (!nodes_reserve(nodes, nodes->count + 1)) return false;
+    nodes->items[nodes->count++] = node;
+    return true;
+}
+
+static int compare_nodes(const void* left, const void* right) {
+    uint32_t a = *(const uint32_t*)left;
+    uint32_t b = *(const uint32_t*)right;
+    return a < b ? -1 : a > b;
+}
+
+static void nodes_sort_unique(FHIRDirectoryNodes* nodes) {
+    if (nodes->count < 2) return;
+
+    qsort(nodes->items, nodes->count, sizeof(uint32_t), compare_nodes);
+    size_t kept = 1;
+    for (size_t i = 1; i < nodes->count; i++) {
+        if (nodes->items[i] != nodes->items[kept - 1]) nodes->items[kept++] = nodes->items[i];
+    }
+    nodes->count = kept;
+}
+
+static bool nodes_contains(const FHIRDirectoryNodes* nodes, uint32_t node) {
+    size_t low = 0, high = nodes->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (nodes->items[middle] < node) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < nodes->count && nodes->items[low] == node;
+}
+
+// Keep the nodes of a (sorted) list that are also in another sorted list
+static void nodes_intersect(FHIRDirectoryNodes* nodes, const uint32_t* other, size_t other_count) {
+    size_t kept = 0, j = 0;
+    for (size_t i = 0; i < nodes->count && j < other_count; i++) {
+        while (j < other_count && other[j] < nodes->items[i]) j++;
+        if (j < other_count && other[j] == nodes->items[i]) nodes->items[kept++] = nodes->items[i];
+    }
+    nodes->count = kept;
+}
+
+static bool nodes_copy(FHIRDirectoryNodes* nodes, const FHIRDirectoryNodes* source) {
+    if (!nodes_reserve(nodes, source->count)) return false;
+    if (source->count) memcpy(nodes->items, source->items, source->count * sizeof(uint32_t));
+    nodes->count = source->count;
+    return true;
+}
+
+/* ========================================================================== */
+/* Traversal                                                                  */
+/* ========================================================================== */
+
+static bool check_built(const FHIRDirectoryIndex* index) {
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (index->dirty) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Directory index changed since it was built");
+        return false;
+    }
+    return true;
+}
+
+// Tagged number of a code, FHIR_DIRECTORY_NONE when no resource has it
+static uint32_t find_code(const FHIRDirectoryIndex* index, const char* code, FHIRDirectoryCodeKind kind) {
+    uint32_t number = table_find(&index->codes, code, strlen(code));
+    return number == FHIR_DIRECTORY_NONE ? number : TAG_CODE(number, kind);
+}
+
+static const uint32_t* code_postings(const FHIRDirectoryIndex* index, uint32_t tag, size_t* count) {
+    *count = tag < index->built_tags ? index->code_offsets[tag + 1] - index->code_offsets[tag] : 0;
+    return *count ? index->code_nodes + index->code_offsets[tag] : NULL;
+}
+
+// Append the nodes one edge away from every node of from
+static bool expand(const FHIRDirectoryIndex* index, const FHIRDirectoryNodes* from, FHIRDirectoryEdge edge,
+                   bool reverse, FHIRDirectoryNodes* to) {
+    const uint32_t* offsets = reverse ? index->in_offsets : index->out_offsets;
+    const uint32_t* nodes = reverse ? index->in_sources : index->out_targets;
+    const uint8_t* edges = reverse ? index->in_edges : index->out_edges;
+
+    for (size_t i = 0; i < from->count; i++) {
+        uint32_t node = from->items[i];
+        for (uint32_t e = offsets[node]; e < offsets[node + 1]; e++) {
+            if (edges[e] == (uint8_t)edge && !nodes_push(to, nodes[e])) return false;
+        }
+    }
+    return true;
+}
+
+// One step from the sorted nodes in from, replacing to; tag FHIR_DIRECTORY_NONE for no code filter
+static bool run_step(const FHIRDirectoryIndex* index, const FHIRDirectoryNodes* from, FHIRDirectoryEdge edge,
+                     bool reverse, bool transitive, FHIRResourceType type, uint32_t tag, bool active_only,
+                     FHIRDirectoryNodes* to) {
+    to->count = 0;
+    if (!transitive) {
+        if (!expand(index, from, edge, reverse, to)) return false;
+        nodes_sort_unique(to);
+    } else {
+        // Breadth-first: to collects every node reached, frontier the newest ones
+        FHIRDirectoryNodes frontier, next;
+        fhir_directory_nodes_init(&frontier);
+        fhir_directory_nodes_init(&next);
+        bool ok = nodes_copy(to, from) && nodes_copy(&frontier, from);
+        while (ok && frontier.count > 0) {
+            next.count = 0;
+            ok = expand(index, &frontier, edge, reverse, &next);
+            nodes_sort_unique(&next);
+            frontier.count = 0;
+            for (size_t i = 0; ok && i < next.count; i++) {
+                if (!nodes_contains(to, next.items[i])) ok = nodes_push(&frontier, next.items[i]);
+            }
+            for (size_t i = 0; ok && i < frontier.count; i++) {
+                ok = nodes_push(to, frontier.items[i]);
+            }
+            nodes_sort_unique(to);
+        }
+        fhir_directory_nodes_cleanup(&frontier);
+        fhir_directory_nodes_cleanup(&next);
+        if (!ok) return false;
+    }
+
+    size_t code_count = 0;
+    const uint32_t* postings = tag == FHIR_DIRECTORY_NONE ? NULL : code_postings(index, tag, &code_count);
+    if (tag != FHIR_DIRECTORY_NONE) nodes_intersect(to, postings, code_count);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < to->count; i++) {
+        const DirectoryNode* node = &index->nodes[to->items[i]];
+        if (type != FHIR_RESOURCE_TYPE_UNKNOWN && node->type != type) continue;
+        if (active_only && !node->active) continue;
+        to->items[kept++] = to->items[i];
+    }
+    to->count = kept;
+    return true;
+}
+
+bool fhir_directory_index_traverse(const FHIRDirectoryIndex* index, const uint32_t* start, size_t start_count,
+                                   const FHIRDirectoryStep* steps, size_t step_count,
+                                   FHIRDirectoryNodes* result) {
+    if (!check_built(index)) return false;
+    if (!result || (start_count && !start) || (step_count && !steps)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRDirectoryNodes current;
+    fhir_directory_nodes_init(&current);
+    bool ok = true;
+    result->count = 0;
+    for (size_t i = 0; ok && i < start_count; i++) {
+        if (start[i] < index->built_nodes) ok = nodes_push(result, start[i]);
+    }
+    nodes_sort_unique(result);
+
+    for (size_t s = 0; ok && s < step_count; s++) {
+        const FHIRDirectoryStep* step = &steps[s];
+        if ((unsigned)step->edge >= FHIR_DIRECTORY_EDGE_COUNT ||
+            (step->code && (unsigned)step->code_kind >= FHIR_DIRECTORY_CODE_KIND_COUNT)) {
+            fhir_directory_nodes_cleanup(&current);
+            FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid traversal step");
+            return false;
+        }
+        uint32_t tag = FHIR_DIRECTORY_NONE;
+        if (step->code) {
+            tag = find_code(index, step->code, step->code_kind);
+            if (tag == FHIR_DIRECTORY_NONE) {
+                result->count = 0;
+                break;
+            }
+        }
+        ok = nodes_copy(&current, result) &&
+             run_step(index, &current, step->edge, step->reverse, step->transitive, step->type, tag, false, result);
+    }
+    fhir_directory_nodes_cleanup(&current);
+
+    if (!ok) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to traverse directory index");
+    }
+    return ok;
+}
+
+/* ========================================================================== */
+/* Practitioner Search                                                        */
+/* ========================================================================== */
+
+// Roles at the query's organization, its sub-organizations and affiliated participants, sorted
+static bool organization_roles(const FHIRDirectoryIndex* index, const FHIRDirectoryQuery* query, uint32_t organization,
+                               FHIRDirectoryNodes* roles) {
+    FHIRDirectoryNodes start, organizations, affiliations, participants;
+    fhir_directory_nodes_init(&start);
+    fhir_directory_nodes_init(&organizations);
+    fhir_directory_nodes_init(&affiliations);
+    fhir_directory_nodes_init(&participants);
+    bool active_only = !query->include_inactive;
+
+    bool ok = nodes_push(&start, organization);
+    if (ok && query->include_children) {
+        ok = run_step(index, &start, FHIR_DIRECTORY_EDGE_PART_OF, true, true, FHIR_RESOURCE_TYPE_ORGANIZATION,
+                      FHIR_DIRECTORY_NONE, false, &organizations);
+    } else if (ok) {
+        ok = nodes_copy(&organizations, &start);
+    }
+
+    if (ok && query->affiliated) {
+        // organization <- OrganizationAffiliation.organization, .participatingOrganization -> participant
+        ok = run_step(index, &organizations, FHIR_DIRECTORY_EDGE_ORGANIZATION, true, false,
+                      FHIR_RESOURCE_TYPE_ORGANIZATION_AFFILIATION, FHIR_DIRECTORY_NONE, active_only, &affiliations) &&
+             run_step(index, &affiliations, FHIR_DIRECTORY_EDGE_PARTICIPATING, false, false,
+                      FHIR_RESOURCE_TYPE_UNKNOWN, FHIR_DIRECTORY_NONE, false, &participants);
+        for (size_t i = 0; ok && i < participants.count; i++) {
+            ok = nodes_push(&organizations, participants.items[i]);
+        }
+        nodes_sort_unique(&organizations);
+    }
+
+    ok = ok && run_step(index, &organizations, FHIR_DIRECTORY_EDGE_ORGANIZATION, true, false,
+                        FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE, FHIR_DIRECTORY_NONE, active_only, roles);
+    fhir_directory_nodes_cleanup(&start);
+    fhir_directory_nodes_cleanup(&organizations);
+    fhir_directory_nodes_cleanup(&affiliations);
+    fhir_directory_nodes_cleanup(&participants);
+    return ok;
+}
+
+// Roles at a Location or any Location that is partOf it, sorted
+static bool location_roles(const FHIRDirectoryIndex* index, const FHIRDirectoryQuery* query, uint32_t location,
+                           FHIRDirectoryNodes* roles) {
+    FHIRDirectoryNodes start, locations;
+    fhir_directory_nodes_init(&start);
+    fhir_directory_nodes_init(&locations);
+
+    bool ok = nodes_push(&start, location) &&
+              run_step(index, &start, FHIR_DIRECTORY_EDGE_PART_OF, true, true, FHIR_RESOURCE_TYPE_LOCATION,
+                       FHIR_DIRECTORY_NONE, false, &locations) &&
+              run_step(index, &locations, FHIR_DIRECTORY_EDGE_LOCATION, true, false,
+                       FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE, FHIR_DIRECTORY_NONE, !query->include_inactive, roles);
+    fhir_directory_nodes_cleanup(&start);
+    fhir_directory_nodes_cleanup(&locations);
+    return ok;
+}
+
+// Intersect candidates with another constraint; the first constraint is copied in
+static void constrain(FHIRDirectoryNodes* candidates, bool* first, const uint32_t* nodes, size_t count,
+                      bool* ok) {
+    if (!*first) {
+        nodes_intersect(candidates, nodes, count);
+        return;
+    }
+    *first = false;
+    if (!nodes_reserve(candidates, count)) {
+        *ok = false;
+        return;
+    }
+    if (count) memcpy(candidates->items, nodes, count * sizeof(uint32_t));
+    candidates->count = count;
+}
+
+static uint32_t first_link(const FHIRDirectoryIndex* index, uint32_t node, FHIRDirectoryEdge edge) {
+    for (uint32_t e = index->out_offsets[node]; e < index->out_offsets[node + 1]; e++) {
+        if (index->out_edges[e] == (uint8_t)edge) return index->out_targets[e];
+    }
+    return FHIR_DIRECTORY_NONE;
+}
+
+bool fhir_directory_index_find_practitioners(const FHIRDirectoryIndex* index, const FHIRDirectoryQuery* query,
+                                             FHIRDirectoryMatches* matches) {
+    if (!check_built(index)) return false;
+    if (!query || !matches ||
+        (!query->organization && !query->location && !query->specialty && !query->role_code)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Expected an organization, location, specialty or code");
+        return false;
+    }
+    matches->count = 0;
+
+    // Cheapest constraints first: code postings are already sorted lists
+    struct {
+        const char* code;
+        FHIRDirectoryCodeKind kind;
+    } codes[] = {
+        { query->specialty, FHIR_DIRECTORY_CODE_SPECIALTY },
+        { query->role_code, FHIR_DIRECTORY_CODE_ROLE },
+    };
+
+    FHIRDirectoryNodes candidates, roles;
+    fhir_directory_nodes_init(&candidates);
+    fhir_directory_nodes_init(&roles);
+    bool first = true;
+    bool ok = true;
+    bool empty = false;
+
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]) && !empty; i++) {
+        if (!codes[i].code) continue;
+        uint32_t tag = find_code(index, codes[i].code, codes[i].kind);
+        size_t count = 0;
+        const uint32_t* postings = tag == FHIR_DIRECTORY_NONE ? NULL : code_postings(index, tag, &count);
+        constrain(&candidates, &first, postings, count, &ok);
+        empty = !ok || candidates.count == 0;
+    }
+    if (!empty && query->organization) {
+        uint32_t organization = fhir_directory_index_find(index, query->organization);
+        empty = organization == FHIR_DIRECTORY_NONE;
+        if (!empty) {
+            ok = organization_roles(index, query, organization, &roles);
+            constrain(&candidates, &first, roles.items, roles.count, &ok);
+            empty = !ok || candidates.count == 0;
+        }
+    }
+    if (!empty && query->location) {
+        uint32_t location = fhir_directory_index_find(index, query->location);
+        empty = location == FHIR_DIRECTORY_NONE;
+        if (!empty) {
+            ok = location_roles(index, query, location, &roles);
+            constrain(&candidates, &first, roles.items, roles.count, &ok);
+            empty = !ok || candidates.count == 0;
+        }
+    }
+
+    for (size_t i = 0; ok && !empty && i < candidates.count; i++) {
+        uint32_t role = candidates.items[i];
+        const DirectoryNode* node = &index->nodes[role];
+        if (node->type != FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE || (!query->include_inactive && !node->active)) {
+            continue;
+        }
+        if (matches->count == matches->capacity) {
+            size_t capacity = matches->capacity ? matches->capacity * 2 : 16;
+            FHIRDirectoryMatch* items = fhir_realloc(matches->items, capacity * sizeof(FHIRDirectoryMatch));
+            if (!items) {
+                ok = false;
+                break;
+            }
+            matches->items = items;
+            matches->capacity = capacity;
+        }
+        matches->items[matches->count++] = (FHIRDirectoryMatch){
+            role,
+            first_link(index, role, FHIR_DIRECTORY_EDGE_PRACTITIONER),
+            first_link(index, role, FHIR_DIRECTORY_EDGE_ORGANIZATION),
+        };
+    }
+
+    fhir_directory_nodes_cleanup(&candidates);
+    fhir_directory_nodes_cleanup(&roles);
+    if (!ok) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to search directory index");
+    }
+    return ok;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file fhir_directory_index.h
+ * @brief Reference graph over provider directory resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Provider directory queries chain references across PractitionerRole,
+ * OrganizationAffiliation, Organization and Location. The index gives each
+ * resource, and each resource it references, a dense node number and keeps
+ * the references as labeled edges:
+ *
+ * - PractitionerRole: practitioner, organization, location, healthcareService
+ * - OrganizationAffiliation: organization, participatingOrganization,
+ *   network, location, healthcareService
+ * - Organization and Location: partOf; Location: managingOrganization
+ *
+ * plus the codes of each resource (specialty, code, type) as interned code
+ * numbers. fhir_directory_index_build packs edges and codes into CSR arrays
+ * in both directions (and codes into posting lists by code), so a query
+ * step is a walk over contiguous node numbers and filters compare integers.
+ *
+ * Adding a resource again replaces its edges and codes; the index must be
+ * built again before it is queried.
+ */
+
+#ifndef FHIR_DIRECTORY_INDEX_H
+#define FHIR_DIRECTORY_INDEX_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Node number of no node */
+#define FHIR_DIRECTORY_NONE UINT32_MAX
+
+/**
+ * @brief Reference edge labels
+ */
+typedef enum {
+    FHIR_DIRECTORY_EDGE_PRACTITIONER = 0,      /**< PractitionerRole.practitioner */
+    FHIR_DIRECTORY_EDGE_ORGANIZATION,          /**< PractitionerRole / OrganizationAffiliation.organization */
+    FHIR_DIRECTORY_EDGE_PARTICIPATING,         /**< OrganizationAffiliation.participatingOrganization */
+    FHIR_DIRECTORY_EDGE_NETWORK,               /**< OrganizationAffiliation.network */
+    FHIR_DIRECTORY_EDGE_LOCATION,              /**< PractitionerRole / OrganizationAffiliation.location */
+    FHIR_DIRECTORY_EDGE_SERVICE,               /**< healthcareService */
+    FHIR_DIRECTORY_EDGE_PART_OF,               /**< Organization / Location.partOf */
+    FHIR_DIRECTORY_EDGE_MANAGING_ORGANIZATION, /**< Location.managingOrganization */
+    FHIR_DIRECTORY_EDGE_COUNT
+} FHIRDirectoryEdge;
+
+/**
+ * @brief Where a code was found on its resource
+ */
+typedef enum {
+    FHIR_DIRECTORY_CODE_SPECIALTY = 0,         /**< specialty */
+    FHIR_DIRECTORY_CODE_ROLE,                  /**< PractitionerRole / OrganizationAffiliation.code */
+    FHIR_DIRECTORY_CODE_TYPE,                  /**< Organization / Location.type */
+    FHIR_DIRECTORY_CODE_KIND_COUNT
+} FHIRDirectoryCodeKind;
+
+/**
+ * @brief One step of a traversal
+ *
+ * Codes are "system|code" to match one coding, or a bare "code" to match
+ * the code in any system.
+ */
+typedef struct {
+    FHIRDirectoryEdge edge;
+    bool reverse;                /**< Follow edges from target back to source */
+    bool transitive;             /**< Repeat the step, keeping the nodes it starts from (partOf trees) */
+    FHIRResourceType type;       /**< Keep only nodes of this type (UNKNOWN for any) */
+    const char* code;            /**< Keep only nodes with this code (NULL for any) */
+    FHIRDirectoryCodeKind code_kind;
+} FHIRDirectoryStep;
+
+/**
+ * @brief Practitioner search
+ *
+ * Unset (NULL) filters match everything; at least one of organization,
+ * location, specialty and role_code must be set.
+ */
+typedef struct {
+    const char* organization;    /**< "Organization/id" the role is at */
+    bool affiliated;             /**< Also organizations participating in its affiliations */
+    bool include_children;       /**< Also organizations that are partOf it, at any depth */
+    const char* location;        /**< "Location/id" the role is at, including sub-locations */
+    const char* specialty;       /**< PractitionerRole.specialty code */
+    const char* role_code;       /**< PractitionerRole.code code */
+    bool include_inactive;       /**< Also roles and affiliations with active = false */
+} FHIRDirectoryQuery;
+
+/**
+ * @brief PractitionerRole selected by a query
+ */
+typedef struct {
+    uint32_t role;
+    uint32_t practitioner;       /**< FHIR_DIRECTORY_NONE when the role has none */
+    uint32_t organization;       /**< FHIR_DIRECTORY_NONE when the role has none */
+} FHIRDirectoryMatch;
+
+/**
+ * @brief Node numbers, ascending and unique
+ */
+typedef struct {
+    uint32_t* items;
+    size_t count;
+    size_t capacity;
+} FHIRDirectoryNodes;
+
+/**
+ * @brief Query matches, ordered by role
+ */
+typedef struct {
+    FHIRDirectoryMatch* items;
+    size_t count;
+    size_t capacity;
+} FHIRDirectoryMatches;
+
+/**
+ * @brief Provider directory index (opaque)
+ */
+typedef struct FHIRDirectoryIndex FHIRDirectoryIndex;
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty index
+ * @return New index or NULL on allocation failure
+ */
+FHIRDirectoryIndex* fhir_directory_index_create(void);
+
+/**
+ * @brief Destroy an index
+ * @param index Index to destroy (can be NULL)
+ */
+void fhir_directory_index_destroy(FHIRDirectoryIndex* index);
+
+/**
+ * @brief Add or replace a directory resource
+ *
+ * PractitionerRole, OrganizationAffiliation, Organization and Location
+ * contribute edges and codes; any other resource with an id (Practitioner,
+ * HealthcareService) is recorded as loaded.
+ *
+ * @param index Index to update
+ * @param json Resource JSON with resourceType and id
+ * @return true on success, false on allocation failure or without
+ *         resourceType and id (FHIR_ERROR_INVALID_ARGUMENT)
+ */
+bool fhir_directory_index_add_json(FHIRDirectoryIndex* index, const cJSON* json);
+
+/**
+ * @brief Pack edges and codes into the CSR arrays used by queries
+ * @param index Index to build
+ * @return true on success, false on allocation failure
+ */
+bool fhir_directory_index_build(FHIRDirectoryIndex* index);
+
+/**
+ * @brief Check whether the index changed since it was last built
+ * @param index Index to query
+ * @return true when fhir_directory_index_build must run before queries
+ */
+bool fhir_directory_index_needs_build(const FHIRDirectoryIndex* index);
+
+/* ========================================================================== */
+/* Nodes                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Get the number of nodes, loaded or only referenced
+ * @param index Index to query
+ * @return Node count
+ */
+size_t fhir_directory_index_node_count(const FHIRDirectoryIndex* index);
+
+/**
+ * @brief Get the number of edges
+ * @param index Index to query
+ * @return Edge count
+ */
+size_t fhir_directory_index_edge_count(const FHIRDirectoryIndex* index);
+
+/**
+ * @brief Find the node of a reference
+ * @param index Index to query
+ * @param reference "Type/id", or an absolute URL ending in Type/id
+ * @return Node or FHIR_DIRECTORY_NONE when nothing refers to it
+ */
+uint32_t fhir_directory_index_find(const FHIRDirectoryIndex* index, const char* reference);
+
+/**
+ * @brief Get the "Type/id" of a node
+ * @param index Index to query
+ * @param node Node number
+ * @return Reference string owned by the index, NULL when out of range
+ */
+const char* fhir_directory_index_reference(const FHIRDirectoryIndex* index, uint32_t node);
+
+/**
+ * @brief Get the resource type of a node
+ * @param index Index to query
+ * @param node Node number
+ * @return Type, FHIR_RESOURCE_TYPE_UNKNOWN when out of range
+ */
+FHIRResourceType fhir_directory_index_type(const FHIRDirectoryIndex* index, uint32_t node);
+
+/**
+ * @brief Check whether a node's resource was added (not only referenced)
+ * @param index Index to query
+ * @param node Node number
+ * @return true when loaded
+ */
+bool fhir_directory_index_is_loaded(const FHIRDirectoryIndex* index, uint32_t node);
+
+/* ========================================================================== */
+/* Queries                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty node list
+ * @param nodes Node list to initialize
+ */
+void fhir_directory_nodes_init(FHIRDirectoryNodes* nodes);
+
+/**
+ * @brief Free a node list
+ * @param nodes Node list to clean up (can be NULL)
+ */
+void fhir_directory_nodes_cleanup(FHIRDirectoryNodes* nodes);
+
+/**
+ * @brief Initialize an empty match list
+ * @param matches Match list to initialize
+ */
+void fhir_directory_matches_init(FHIRDirectoryMatches* matches);
+
+/**
+ * @brief Free a match list
+ * @param matches Match list to clean up (can be NULL)
+ */
+void fhir_directory_matches_cleanup(FHIRDirectoryMatches* matches);
+
+/**
+ * @brief Follow a chain of steps from a set of nodes
+ *
+ * @param index Built index
+ * @param start Start nodes (any order, duplicates allowed)
+ * @param start_count Number of start nodes
+ * @param steps Steps applied in order
+ * @param step_count Number of steps
+ * @param result Output nodes reached by the last step, replacing its contents
+ * @return true on success, false on allocation failure or an index that
+ *         needs a build (FHIR_ERROR_INVALID_ARGUMENT)
+ */
+bool fhir_directory_index_traverse(const FHIRDirectoryIndex* index, const uint32_t* start, size_t start_count,
+                                   const FHIRDirectoryStep* steps, size_t step_count,
+                                   FHIRDirectoryNodes* result);
+
+/**
+ * @brief Find the PractitionerRoles matching a practitioner search
+ * @param index Built index
+ * @param query Search filters
+ * @param matches Output matches, replacing its contents
+ * @return true on success (no matches for unknown references or codes),
+ *         false on allocation failure, an index that needs a build or a
+ *         query without filters (FHIR_ERROR_INVALID_ARGUMENT)
+ */
+bool fhir_directory_index_find_practitioners(const FHIRDirectoryIndex* index, const FHIRDirectoryQuery* query,
+                                             FHIRDirectoryMatches* matches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_DIRECTORY_INDEX_H */
@@ -0,0 +1,231 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_document.h"
+#include "fhir_directory_index.h"
+
+// Python binding for the provider directory index
+
+// DirectoryIndex: reference graph over PractitionerRole, OrganizationAffiliation, Organization and Location
+typedef struct {
+    PyObject_HEAD
+    FHIRDirectoryIndex* index;
+} DirectoryIndex;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* directory_index_type;
+    const FHIRPythonDocuments* documents;   // fhir_parser_c entry points, or NULL without it
+} DirectoryModuleState;
+
+static struct PyModuleDef fhir_directory_module;
+
+static int DirectoryIndex_init(DirectoryIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+        return -1;
+    }
+    
+    FHIRDirectoryIndex* index = fhir_directory_index_create();
+    if (index == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_directory_index_destroy(self->index);
+    self->index = index;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void DirectoryIndex_dealloc(DirectoryIndex* self) {
+    fhir_directory_index_destroy(self->index);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int DirectoryIndex_check_ready(const DirectoryIndex* self) {
+    if (self->index == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "DirectoryIndex is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* directory_error(const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+    if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+        return PyErr_NoMemory();
+    }
+    PyErr_SetString(PyExc_ValueError, error ? error->message : fallback);
+    return NULL;
+}
+
+static PyObject* DirectoryIndex_add(DirectoryIndex* self, PyObject* document) {
+    DirectoryModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_directory_module);
+    if (!state || !DirectoryIndex_check_ready(self)) {
+        return NULL;
+    }
+    
+    cJSON* owned;
+    const cJSON* json = fhir_python_document_json(state->documents, document, &owned);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    bool ok;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_directory_index_add_json(self->index, json);
+    FHIR_PY_END_CRITICAL_SECTION();
+    cJSON_Delete(owned);
+    if (!ok) {
+        return directory_error("Expected a resource with resourceType and id");
+    }
+    Py_RETURN_NONE;
+}
+
+// Reference of a node, or None for FHIR_DIRECTORY_NONE
+static PyObject* directory_reference_to_python(const FHIRDirectoryIndex* index, uint32_t node) {
+    if (node == FHIR_DIRECTORY_NONE) {
+        Py_RETURN_NONE;
+    }
+    return PyUnicode_FromString(fhir_directory_index_reference(index, node));
+}
+
+static PyObject* directory_matches_to_python(const FHIRDirectoryIndex* index, const FHIRDirectoryMatches* matches) {
+    PyObject* list = PyList_New((Py_ssize_t)matches->count);
+    if (list == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < matches->count; i++) {
+        const FHIRDirectoryMatch* match = &matches->items[i];
+        PyObject* item = Py_BuildValue("(NNN)",
+                                       directory_reference_to_python(index, match->practitioner),
+                                       directory_reference_to_python(index, match->role),
+                                       directory_reference_to_python(index, match->organization));
+        if (item == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+    return list;
+}
+
+static PyObject* DirectoryIndex_find_practitioners(DirectoryIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"organization", "location", "specialty", "code", "affiliated",
+                             "include_children", "include_inactive", NULL};
+    FHIRDirectoryQuery query;
+    memset(&query, 0, sizeof(query));
+    int affiliated = 0, include_children = 0, include_inactive = 0;
+    if (!DirectoryIndex_check_ready(self) ||
+        !PyArg_ParseTupleAndKeywords(args, kwds, "|zzzzppp", kwlist, &query.organization, &query.location,
+                                     &query.specialty, &query.role_code, &affiliated, &include_children,
+                                     &include_inactive)) {
+        return NULL;
+    }
+    query.affiliated = affiliated;
+    query.include_children = include_children;
+    query.include_inactive = include_inactive;
+    
+    // Adds since the last query are packed here, under the same lock as the query
+    FHIRDirectoryMatches matches;
+    bool ok;
+    PyObject* result;
+    fhir_directory_matches_init(&matches);
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = (!fhir_directory_index_needs_build(self->index) || fhir_directory_index_build(self->index)) &&
+         fhir_directory_index_find_practitioners(self->index, &query, &matches);
+    result = ok ? directory_matches_to_python(self->index, &matches) : NULL;
+    FHIR_PY_END_CRITICAL_SECTION();
+    fhir_directory_matches_cleanup(&matches);
+    if (!ok) {
+        return directory_error("Expected at least one of organization, location, specialty or code");
+    }
+    return result;
+}
+
+static Py_ssize_t DirectoryIndex_length(DirectoryIndex* self) {
+    if (!DirectoryIndex_check_ready(self)) {
+        return -1;
+    }
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = (Py_ssize_t)fhir_directory_index_node_count(self->index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+static PyMethodDef DirectoryIndexMethods[] = {
+    {"add", (PyCFunction)DirectoryIndex_add, METH_O,
+     "Add or replace a directory resource (ParsedDocument or JSON text)"},
+    {"find_practitioners", (PyCFunction)(void (*)(void))DirectoryIndex_find_practitioners,
+     METH_VARARGS | METH_KEYWORDS,
+     "find_practitioners(organization=None, location=None, specialty=None, code=None, affiliated=False, "
+     "include_children=False, include_inactive=False): [(practitioner, role, organization)] references"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot DirectoryIndexSlots[] = {
+    {Py_tp_doc, "Provider directory reference graph for practitioner searches"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, DirectoryIndex_init},
+    {Py_tp_dealloc, DirectoryIndex_dealloc},
+    {Py_tp_methods, DirectoryIndexMethods},
+    {Py_sq_length, DirectoryIndex_length},
+    {0, NULL}
+};
+
+static PyType_Spec DirectoryIndexSpec = {
+    .name = "fhir_directory_c.DirectoryIndex",
+    .basicsize = sizeof(DirectoryIndex),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = DirectoryIndexSlots,
+};
+
+static int directory_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    DirectoryModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->directory_index_type);
+    return 0;
+}
+
+static int directory_module_clear(PyObject* module) {
+    DirectoryModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->directory_index_type);
+    return 0;
+}
+
+static void directory_module_free(void* module) {
+    directory_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int directory_module_exec(PyObject* module) {
+    DirectoryModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+    state->documents = fhir_python_import_documents();
+
+    state->directory_index_type = fhir_python_add_type(module, &DirectoryIndexSpec);
+    return state->directory_index_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot directory_module_slots[] = FHIR_PY_MODULE_SLOTS(directory_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_directory_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_directory_c",
+    "Provider directory reference graph in C",
+    sizeof(DirectoryModuleState),
+    NULL,
+    directory_module_slots,
+    directory_module_traverse,
+    directory_module_clear,
+    directory_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_directory_c(void) {
+    return PyModuleDef_Init(&fhir_directory_module);
+}
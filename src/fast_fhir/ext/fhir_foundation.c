@@ -1,4 +1,5 @@
 #include "fhir_foundation.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -21,6 +22,17 @@ FHIRDomainResource* fhir_domain_resource_create(const char* resource_type, const
     return domain_resource;
 }
 
+FHIRResource* fhir_parse_resource(cJSON* json) {
+    if (!json || !cJSON_IsObject(json)) return NULL;
+    
+    cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+    if (!cJSON_IsString(resource_type)) return NULL;
+    
+    // Generic resource header; typed parsers fill in the rest
+    cJSON* id = cJSON_GetObjectItemCaseSensitive(json, "id");
+    return fhir_resource_create(resource_type->valuestring, cJSON_IsString(id) ? id->valuestring : NULL);
+}
+
 void fhir_resource_free(FHIRResource* resource) {
     if (resource) {
         fhir_string_free(resource->resource_type);
@@ -905,6 +917,148 @@ cJSON* fhir_binary_to_json(const FHIRBinary* binary) {
     return json;
 }
 
+// Bundle reference index: open addressing over entry positions. Keys are
+// not copied; slots are compared against the entry's fullUrl or
+// resourceType and id.
+typedef enum {
+    BUNDLE_KEY_FREE = 0,
+    BUNDLE_KEY_FULL_URL,
+    BUNDLE_KEY_TYPE_ID
+} BundleKeyKind;
+
+typedef struct {
+    uint64_t hash;
+    size_t entry;
+    int kind;
+} BundleReferenceSlot;
+
+struct FHIRBundleReferenceIndex {
+    BundleReferenceSlot* slots;
+    size_t capacity;  // Power of two
+    size_t count;
+};
+
+typedef struct FHIRBundleReferenceIndex FHIRBundleReferenceIndex;
+
+static uint64_t bundle_hash(uint64_t hash, const char* str, size_t length) {
+    // FNV-1a; hashing "Type", "/" and "id" in turn equals hashing "Type/id"
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)str[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+#define BUNDLE_HASH_SEED 14695981039346656037ULL
+
+// fhir_parse_bundle and fhir_bundle_add_entry store fullUrl as a plain string
+static const char* bundle_entry_full_url(const BundleEntry* entry) {
+    return (const char*)entry->full_url;
+}
+
+static bool bundle_slot_matches(const FHIRBundle* bundle, const BundleReferenceSlot* slot,
+                                int kind, const char* key, size_t length) {
+    if (slot->kind != kind) return false;
+    
+    const BundleEntry* entry = bundle->entry[slot->entry];
+    if (kind == BUNDLE_KEY_FULL_URL) {
+        const char* full_url = bundle_entry_full_url(entry);
+        return strlen(full_url) == length && memcmp(full_url, key, length) == 0;
+    }
+    
+    const char* type = entry->resource->resource_type;
+    const char* id = entry->resource->id;
+    size_t type_length = strlen(type);
+    size_t id_length = length > type_length ? length - type_length - 1 : 0;
+    return type_length < length && key[type_length] == '/' &&
+           memcmp(type, key, type_length) == 0 &&
+           strlen(id) == id_length && memcmp(id, key + type_length + 1, id_length) == 0;
+}
+
+static BundleEntry* bundle_index_find(const FHIRBundle* bundle, int kind, const char* key, size_t length) {
+    const FHIRBundleReferenceIndex* index = bundle->reference_index;
+    if (index->capacity == 0) return NULL;
+    
+    uint64_t hash = bundle_hash(BUNDLE_HASH_SEED, key, length);
+    for (size_t slot = hash & (index->capacity - 1); index->slots[slot].kind != BUNDLE_KEY_FREE;
+         slot = (slot + 1) & (index->capacity - 1)) {
+        if (index->slots[slot].hash == hash &&
+            bundle_slot_matches(bundle, &index->slots[slot], kind, key, length)) {
+            return bundle->entry[index->slots[slot].entry];
+        }
+    }
+    return NULL;
+}
+
+static bool bundle_index_insert(FHIRBundle* bundle, int kind, uint64_t hash, size_t entry,
+                                const char* key, size_t length) {
+    FHIRBundleReferenceIndex* index = bundle->reference_index;
+    
+    // Keep the load factor below 0.7
+    if ((index->count + 1) * 10 > index->capacity * 7) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 16;
+        BundleReferenceSlot* slots = calloc(capacity, sizeof(BundleReferenceSlot));
+        if (!slots) return false;
+        
+        for (size_t i = 0; i < index->capacity; i++) {
+            if (index->slots[i].kind != BUNDLE_KEY_FREE) {
+                size_t slot = index->slots[i].hash & (capacity - 1);
+                while (slots[slot].kind != BUNDLE_KEY_FREE) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                slots[slot] = index->slots[i];
+            }
+        }
+        free(index->slots);
+        index->slots = slots;
+        index->capacity = capacity;
+    }
+    
+    size_t slot = hash & (index->capacity - 1);
+    while (index->slots[slot].kind != BUNDLE_KEY_FREE) {
+        // The first entry with a key wins
+        if (index->slots[slot].hash == hash &&
+            bundle_slot_matches(bundle, &index->slots[slot], kind, key, length)) {
+            return true;
+        }
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    
+    index->slots[slot] = (BundleReferenceSlot){ hash, entry, kind };
+    index->count++;
+    return true;
+}
+
+static bool bundle_index_add_entry(FHIRBundle* bundle, size_t position) {
+    const BundleEntry* entry = bundle->entry[position];
+    if (!entry) return true;
+    
+    const char* full_url = bundle_entry_full_url(entry);
+    if (full_url && !bundle_index_insert(bundle, BUNDLE_KEY_FULL_URL,
+                                         bundle_hash(BUNDLE_HASH_SEED, full_url, strlen(full_url)),
+                                         position, full_url, strlen(full_url))) {
+        return false;
+    }
+    
+    const FHIRResource* resource = entry->resource;
+    if (!resource || !resource->resource_type || !resource->id) return true;
+    
+    // Match the inserted key against the slot the same way lookups do
+    size_t type_length = strlen(resource->resource_type);
+    size_t id_length = strlen(resource->id);
+    char stack_key[128];
+    char* key = type_length + id_length + 2 <= sizeof(stack_key) ? stack_key : malloc(type_length + id_length + 2);
+    if (!key) return false;
+    memcpy(key, resource->resource_type, type_length);
+    key[type_length] = '/';
+    memcpy(key + type_length + 1, resource->id, id_length + 1);
+    
+    bool ok = bundle_index_insert(bundle, BUNDLE_KEY_TYPE_ID,
+                                  bundle_hash(BUNDLE_HASH_SEED, key, type_length + 1 + id_length),
+                                  position, key, type_length + 1 + id_length);
+    if (key != stack_key) free(key);
+    return ok;
+}
+
 // Bundle Resource functions
 FHIRBundle* fhir_bundle_create(const char* id) {
     FHIRBundle* bundle = calloc(1, sizeof(FHIRBundle));
@@ -945,6 +1099,11 @@ void fhir_bundle_free(FHIRBundle* bundle) {
         
         if (bundle->signature) free(bundle->signature);
         
+        if (bundle->reference_index) {
+            free(bundle->reference_index->slots);
+            free(bundle->reference_index);
+        }
+        
         free(bundle);
     }
 }
@@ -1006,6 +1165,12 @@ FHIRBundle* fhir_parse_bundle(cJSON* json) {
         }
     }
     
+    // Index entries once so references resolve without scanning entry[]
+    if (!fhir_bundle_build_reference_index(bundle)) {
+        fhir_bundle_free(bundle);
+        return NULL;
+    }
+    
     return bundle;
 }
 
@@ -1095,9 +1260,62 @@ bool fhir_bundle_add_entry(FHIRBundle* bundle, FHIRResource* resource, const cha
         bundle->total->value = bundle->entry_count;
     }
     
+    if (!bundle->reference_index) {
+        return fhir_bundle_build_reference_index(bundle);
+    }
+    return bundle_index_add_entry(bundle, bundle->entry_count - 1);
+}
+
+/* Bundle reference index */
+
+bool fhir_bundle_build_reference_index(FHIRBundle* bundle) {
+    if (!bundle) return false;
+    
+    FHIRBundleReferenceIndex* index = bundle->reference_index;
+    if (!index) {
+        index = calloc(1, sizeof(FHIRBundleReferenceIndex));
+        if (!index) return false;
+        bundle->reference_index = index;
+    }
+    
+    // Room for a fullUrl and a type/id key per entry below the load limit
+    size_t capacity = 16;
+    while (capacity * 7 < bundle->entry_count * 2 * 10) {
+        capacity *= 2;
+    }
+    free(index->slots);
+    index->slots = calloc(capacity, sizeof(BundleReferenceSlot));
+    index->capacity = index->slots ? capacity : 0;
+    index->count = 0;
+    if (!index->slots) return false;
+    
+    for (size_t i = 0; i < bundle->entry_count; i++) {
+        if (!bundle_index_add_entry(bundle, i)) return false;
+    }
     return true;
 }
 
+BundleEntry* fhir_bundle_resolve_reference(const FHIRBundle* bundle, const char* reference) {
+    // Local references ("#id") point at contained resources, not entries
+    if (!bundle || !bundle->reference_index || !reference || !reference[0] || reference[0] == '#') {
+        return NULL;
+    }
+    
+    size_t length = strlen(reference);
+    BundleEntry* entry = bundle_index_find(bundle, BUNDLE_KEY_FULL_URL, reference, length);
+    if (entry || strchr(reference, ':')) {
+        // Absolute references (urn:uuid:, http://...) only match fullUrl
+        return entry;
+    }
+    
+    // Relative "Type/id", optionally versioned with "/_history/vid"
+    const char* history = strstr(reference, "/_history/");
+    if (history) {
+        length = (size_t)(history - reference);
+    }
+    return bundle_index_find(bundle, BUNDLE_KEY_TYPE_ID, reference, length);
+}
+
 bool fhir_validate_code_system(const FHIRCodeSystem* code_system) {
     if (!code_system) return false;
     
@@ -7,6 +7,7 @@
 #include <cjson/cJSON.h>
 
 // Forward declarations
+struct FHIRBundleReferenceIndex;
 struct FHIRResource;
 struct FHIRDomainResource;
 struct FHIRUsageContext;
@@ -839,6 +840,7 @@ typedef struct {
     struct BundleEntry** entry;
     size_t entry_count;
     struct FHIRSignature* signature;
+    struct FHIRBundleReferenceIndex* reference_index;  // fullUrl and type/id -> entry
 } FHIRBundle;
 
 // Bundle Link structure
@@ -955,6 +957,12 @@ size_t fhir_bundle_get_entry_count(const FHIRBundle* bundle);
 FHIRResource* fhir_bundle_get_entry_resource(const FHIRBundle* bundle, size_t index);
 bool fhir_bundle_add_entry(FHIRBundle* bundle, FHIRResource* resource, const char* full_url);
 
+// Bundle reference resolution. fhir_parse_bundle and fhir_bundle_add_entry
+// keep the index current; call fhir_bundle_build_reference_index after
+// changing bundle->entry directly.
+bool fhir_bundle_build_reference_index(FHIRBundle* bundle);
+struct BundleEntry* fhir_bundle_resolve_reference(const FHIRBundle* bundle, const char* reference);
+
 // Utility functions for terminology resources
 bool fhir_is_terminology_resource(const char* resource_type);
 char* fhir_code_system_lookup_display(const FHIRCodeSystem* code_system, const char* code);
@@ -1,23 +1,30 @@
-#define PY_SSIZE_T_CLEAN
-#include <Python.h>
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
 #include "fhir_foundation.h"
+#include "fhir_python_json.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_base64.h"
 
 // Forward declarations for Python wrapper functions
-static PyObject* py_fhir_code_system_create(PyObject* self, PyObject* args);
-static PyObject* py_fhir_parse_code_system(PyObject* self, PyObject* args);
-static PyObject* py_fhir_value_set_create(PyObject* self, PyObject* args);
-static PyObject* py_fhir_binary_create(PyObject* self, PyObject* args);
-static PyObject* py_fhir_bundle_create(PyObject* self, PyObject* args);
-static PyObject* py_fhir_parse_bundle(PyObject* self, PyObject* args);
-static PyObject* py_fhir_bundle_get_entry_count(PyObject* self, PyObject* args);
-static PyObject* py_fhir_is_terminology_resource(PyObject* self, PyObject* args);
+static PyObject* py_fhir_code_system_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_parse_code_system(PyObject* self, PyObject* arg);
+static PyObject* py_fhir_value_set_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_binary_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_parse_binary(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_base64_decode(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_base64_encode(PyObject* self, PyObject* arg);
+static PyObject* py_fhir_bundle_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs);
+static PyObject* py_fhir_parse_bundle(PyObject* self, PyObject* arg);
+static PyObject* py_fhir_bundle_get_entry_count(PyObject* self, PyObject* arg);
+static PyObject* py_fhir_is_terminology_resource(PyObject* self, PyObject* arg);
 
 // Python wrapper functions for FHIR Foundation resources
 
 // Patient resource functions
-static PyObject* py_fhir_patient_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_patient_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_patient", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -36,132 +43,89 @@ static PyObject* py_fhir_patient_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
-static PyObject* py_fhir_parse_patient(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_parse_patient(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    // Parse, convert and free without the GIL; only the Python conversion needs it
+    bool parsed = false;
+    bool resolved = false;
+    cJSON* result_json = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRPatient* patient = fhir_parse_patient(json);
+        cJSON_Delete(json);
+        if (patient) {
+            resolved = true;
+            result_json = fhir_patient_to_json(patient);
+            fhir_patient_free(patient);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRPatient* patient = fhir_parse_patient(json);
-    cJSON_Delete(json);
-    
-    if (!patient) {
+    if (!resolved) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Patient");
         return NULL;
     }
-    
-    // Convert back to JSON for Python
-    cJSON* result_json = fhir_patient_to_json(patient);
-    fhir_patient_free(patient);
-    
     if (!result_json) {
         PyErr_SetString(PyExc_RuntimeError, "Failed to serialize Patient");
         return NULL;
     }
     
-    char* result_string = cJSON_Print(result_json);
+    PyObject* result = fhir_cjson_to_python(result_json);
     cJSON_Delete(result_json);
     
-    if (!result_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(result_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(result_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(result_string);
-    free(result_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
-static PyObject* py_fhir_patient_get_full_name(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_patient_get_full_name(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    bool resolved = false;
+    char* full_name = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRPatient* patient = fhir_parse_patient(json);
+        cJSON_Delete(json);
+        if (patient) {
+            resolved = true;
+            full_name = fhir_patient_get_full_name(patient);
+            fhir_patient_free(patient);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRPatient* patient = fhir_parse_patient(json);
-    cJSON_Delete(json);
-    
-    if (!patient) {
+    if (!resolved) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Patient");
         return NULL;
     }
     
-    char* full_name = fhir_patient_get_full_name(patient);
-    fhir_patient_free(patient);
-    
     if (!full_name) {
         Py_RETURN_NONE;
     }
@@ -172,61 +136,82 @@ static PyObject* py_fhir_patient_get_full_name(PyObject* self, PyObject* args) {
     return result;
 }
 
-static PyObject* py_fhir_patient_is_active(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_patient_is_active(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    bool resolved = false;
+    bool is_active = false;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRPatient* patient = fhir_parse_patient(json);
+        cJSON_Delete(json);
+        if (patient) {
+            resolved = true;
+            is_active = fhir_patient_is_active(patient);
+            fhir_patient_free(patient);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRPatient* patient = fhir_parse_patient(json);
-    cJSON_Delete(json);
-    
-    if (!patient) {
+    if (!resolved) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Patient");
         return NULL;
     }
     
-    bool is_active = fhir_patient_is_active(patient);
-    fhir_patient_free(patient);
-    
     return PyBool_FromLong(is_active);
 }
 
-static PyObject* py_fhir_validate_patient(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_validate_patient(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    bool resolved = false;
+    bool is_valid = false;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRPatient* patient = fhir_parse_patient(json);
+        cJSON_Delete(json);
+        if (patient) {
+            resolved = true;
+            is_valid = fhir_validate_patient(patient);
+            fhir_patient_free(patient);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRPatient* patient = fhir_parse_patient(json);
-    cJSON_Delete(json);
-    
-    if (!patient) {
+    if (!resolved) {
         return PyBool_FromLong(false);
     }
     
-    bool is_valid = fhir_validate_patient(patient);
-    fhir_patient_free(patient);
-    
     return PyBool_FromLong(is_valid);
 }
 
 // Practitioner resource functions
-static PyObject* py_fhir_practitioner_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_practitioner_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_practitioner", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -245,47 +230,17 @@ static PyObject* py_fhir_practitioner_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
 // Organization resource functions
-static PyObject* py_fhir_organization_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_organization_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_organization", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -304,47 +259,16 @@ static PyObject* py_fhir_organization_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
 // Utility functions
-static PyObject* py_fhir_is_foundation_resource(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_is_foundation_resource(PyObject* self, PyObject* arg) {
     const char* resource_type;
-    if (!PyArg_ParseTuple(args, "s", &resource_type)) {
+    if (!fhir_python_text_arg(arg, &resource_type, NULL)) {
         return NULL;
     }
     
@@ -352,13 +276,17 @@ static PyObject* py_fhir_is_foundation_resource(PyObject* self, PyObject* args)
     return PyBool_FromLong(is_foundation);
 }
 
-static PyObject* py_fhir_get_resource_type(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_get_resource_type(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    json = fhir_json_parse(view.buf, (size_t)view.len);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
     if (!json) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
@@ -379,60 +307,74 @@ static PyObject* py_fhir_get_resource_type(PyObject* self, PyObject* args) {
 // Method definitions
 static PyMethodDef FHIRFoundationMethods[] = {
     // Patient functions
-    {"create_patient", py_fhir_patient_create, METH_VARARGS, "Create FHIR Patient resource"},
-    {"parse_patient", py_fhir_parse_patient, METH_VARARGS, "Parse FHIR Patient from JSON"},
-    {"patient_get_full_name", py_fhir_patient_get_full_name, METH_VARARGS, "Get patient full name"},
-    {"patient_is_active", py_fhir_patient_is_active, METH_VARARGS, "Check if patient is active"},
-    {"validate_patient", py_fhir_validate_patient, METH_VARARGS, "Validate FHIR Patient"},
+    {"create_patient", (PyCFunction)(void (*)(void))py_fhir_patient_create, METH_FASTCALL, "Create FHIR Patient resource"},
+    {"parse_patient", py_fhir_parse_patient, METH_O, "Parse FHIR Patient from JSON"},
+    {"patient_get_full_name", py_fhir_patient_get_full_name, METH_O, "Get patient full name"},
+    {"patient_is_active", py_fhir_patient_is_active, METH_O, "Check if patient is active"},
+    {"validate_patient", py_fhir_validate_patient, METH_O, "Validate FHIR Patient"},
     
     // Practitioner functions
-    {"create_practitioner", py_fhir_practitioner_create, METH_VARARGS, "Create FHIR Practitioner resource"},
+    {"create_practitioner", (PyCFunction)(void (*)(void))py_fhir_practitioner_create, METH_FASTCALL, "Create FHIR Practitioner resource"},
     
     // Organization functions
-    {"create_organization", py_fhir_organization_create, METH_VARARGS, "Create FHIR Organization resource"},
+    {"create_organization", (PyCFunction)(void (*)(void))py_fhir_organization_create, METH_FASTCALL, "Create FHIR Organization resource"},
     
     // CodeSystem functions
-    {"create_code_system", py_fhir_code_system_create, METH_VARARGS, "Create FHIR CodeSystem resource"},
-    {"parse_code_system", py_fhir_parse_code_system, METH_VARARGS, "Parse FHIR CodeSystem from JSON"},
+    {"create_code_system", (PyCFunction)(void (*)(void))py_fhir_code_system_create, METH_FASTCALL, "Create FHIR CodeSystem resource"},
+    {"parse_code_system", py_fhir_parse_code_system, METH_O, "Parse FHIR CodeSystem from JSON"},
     
     // ValueSet functions
-    {"create_value_set", py_fhir_value_set_create, METH_VARARGS, "Create FHIR ValueSet resource"},
+    {"create_value_set", (PyCFunction)(void (*)(void))py_fhir_value_set_create, METH_FASTCALL, "Create FHIR ValueSet resource"},
     
     // Binary functions
-    {"create_binary", py_fhir_binary_create, METH_VARARGS, "Create FHIR Binary resource"},
+    {"create_binary", (PyCFunction)(void (*)(void))py_fhir_binary_create, METH_FASTCALL, "Create FHIR Binary resource"},
+    {"parse_binary", (PyCFunction)(void (*)(void))py_fhir_parse_binary, METH_FASTCALL,
+     "parse_binary(source, decode_data=True): parse a Binary or Attachment to a dict; 'data' becomes a memoryview of the decoded bytes, or a slice of byte offsets into source when decode_data is false"},
+    {"base64_decode", (PyCFunction)(void (*)(void))py_fhir_base64_decode, METH_FASTCALL,
+     "base64_decode(data, out=None, span=None): decode base64 to a memoryview, or into the writable buffer out and return the byte count"},
+    {"base64_encode", py_fhir_base64_encode, METH_O, "Encode a bytes-like object as base64 text"},
     
     // Bundle functions
-    {"create_bundle", py_fhir_bundle_create, METH_VARARGS, "Create FHIR Bundle resource"},
-    {"parse_bundle", py_fhir_parse_bundle, METH_VARARGS, "Parse FHIR Bundle from JSON"},
-    {"bundle_get_entry_count", py_fhir_bundle_get_entry_count, METH_VARARGS, "Get Bundle entry count"},
+    {"create_bundle", (PyCFunction)(void (*)(void))py_fhir_bundle_create, METH_FASTCALL, "Create FHIR Bundle resource"},
+    {"parse_bundle", py_fhir_parse_bundle, METH_O, "Parse FHIR Bundle from JSON"},
+    {"bundle_get_entry_count", py_fhir_bundle_get_entry_count, METH_O, "Get Bundle entry count"},
     
     // Utility functions
-    {"is_foundation_resource", py_fhir_is_foundation_resource, METH_VARARGS, "Check if resource type is Foundation"},
-    {"is_terminology_resource", py_fhir_is_terminology_resource, METH_VARARGS, "Check if resource type is Terminology"},
-    {"get_resource_type", py_fhir_get_resource_type, METH_VARARGS, "Get resource type from JSON"},
+    {"is_foundation_resource", py_fhir_is_foundation_resource, METH_O, "Check if resource type is Foundation"},
+    {"is_terminology_resource", py_fhir_is_terminology_resource, METH_O, "Check if resource type is Terminology"},
+    {"get_resource_type", py_fhir_get_resource_type, METH_O, "Get resource type from JSON"},
     
     {NULL, NULL, 0, NULL}
 };
 
+// Module execution (once per interpreter); the module keeps no state
+static int foundation_module_exec(PyObject* module) {
+    return fhir_python_add_runtime(module);
+}
+
+static PyModuleDef_Slot foundation_module_slots[] = FHIR_PY_MODULE_SLOTS(foundation_module_exec);
+
 // Module definition
 static struct PyModuleDef fhir_foundation_module = {
     PyModuleDef_HEAD_INIT,
     "fhir_foundation_c",
     "FHIR R5 Foundation resources implemented in C",
-    -1,
-    FHIRFoundationMethods
+    0,
+    FHIRFoundationMethods,
+    foundation_module_slots
 };
 
 // Module initialization
 PyMODINIT_FUNC PyInit_fhir_foundation_c(void) {
-    return PyModule_Create(&fhir_foundation_module);
+    return PyModuleDef_Init(&fhir_foundation_module);
 }
 // Additional Python wrapper functions for new Foundation resources
 
 // CodeSystem resource functions
-static PyObject* py_fhir_code_system_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_code_system_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_code_system", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -451,113 +393,61 @@ static PyObject* py_fhir_code_system_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
-static PyObject* py_fhir_parse_code_system(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_parse_code_system(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    // Parse, convert and free without the GIL; only the Python conversion needs it
+    bool parsed = false;
+    bool resolved = false;
+    cJSON* result_json = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRCodeSystem* code_system = fhir_parse_code_system(json);
+        cJSON_Delete(json);
+        if (code_system) {
+            resolved = true;
+            result_json = fhir_code_system_to_json(code_system);
+            fhir_code_system_free(code_system);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRCodeSystem* code_system = fhir_parse_code_system(json);
-    cJSON_Delete(json);
-    
-    if (!code_system) {
+    if (!resolved) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR CodeSystem");
         return NULL;
     }
-    
-    // Convert back to JSON for Python
-    cJSON* result_json = fhir_code_system_to_json(code_system);
-    fhir_code_system_free(code_system);
-    
     if (!result_json) {
         PyErr_SetString(PyExc_RuntimeError, "Failed to serialize CodeSystem");
         return NULL;
     }
     
-    char* result_string = cJSON_Print(result_json);
+    PyObject* result = fhir_cjson_to_python(result_json);
     cJSON_Delete(result_json);
     
-    if (!result_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(result_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(result_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(result_string);
-    free(result_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
 // ValueSet resource functions
-static PyObject* py_fhir_value_set_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_value_set_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_value_set", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -576,47 +466,17 @@ static PyObject* py_fhir_value_set_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
 // Binary resource functions
-static PyObject* py_fhir_binary_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_binary_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_binary", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -635,198 +495,346 @@ static PyObject* py_fhir_binary_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
+    return result;
+}
+
+// Decode base64 text into a new bytes object and wrap it in a memoryview
+static PyObject* fhir_base64_to_memoryview(const char* text, size_t length) {
+    PyObject* bytes = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)fhir_base64_decoded_max_length(length));
+    if (!bytes) {
         return NULL;
     }
     
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
+    // The bytes object is not shared yet, so it can be filled without the GIL
+    size_t written = 0;
+    bool decoded;
+    FHIR_BEGIN_ALLOW_THREADS(length)
+    decoded = fhir_base64_decode(text, length, (uint8_t*)PyBytes_AS_STRING(bytes),
+                                 (size_t)PyBytes_GET_SIZE(bytes), &written);
+    FHIR_END_ALLOW_THREADS
+    
+    if (!decoded) {
+        Py_DECREF(bytes);
+        PyErr_SetString(PyExc_ValueError, "Invalid base64 data");
         return NULL;
     }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
+    if ((Py_ssize_t)written != PyBytes_GET_SIZE(bytes) && _PyBytes_Resize(&bytes, (Py_ssize_t)written) < 0) {
         return NULL;
     }
     
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
+    PyObject* result = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    return result;
+}
+
+typedef struct {
+    FHIRJSONMemberSpan* members;
+    size_t count;
+    size_t capacity;
+} FHIRMemberList;
+
+static bool collect_member(const FHIRJSONMemberSpan* member, void* context) {
+    FHIRMemberList* list = (FHIRMemberList*)context;
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        FHIRJSONMemberSpan* members = fhir_realloc(list->members, capacity * sizeof(FHIRJSONMemberSpan));
+        if (!members) {
+            return false;
+        }
+        list->members = members;
+        list->capacity = capacity;
+    }
+    list->members[list->count++] = *member;
+    return true;
+}
+
+// Convert a raw JSON span (a key including its quotes, or a value) to Python
+static PyObject* json_span_to_python(const char* text, size_t length) {
+    cJSON* json = fhir_json_parse(text, length);
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
+    PyObject* result = fhir_cjson_to_python(json);
+    cJSON_Delete(json);
     return result;
 }
 
-// Bundle resource functions
-static PyObject* py_fhir_bundle_create(PyObject* self, PyObject* args) {
-    const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+// Value for the "data" member: decoded bytes, or the byte offsets of the base64 text
+static PyObject* binary_data_value(const char* text, const FHIRJSONMemberSpan* member, bool decode_data) {
+    const char* content = text + member->value_offset + 1;
+    size_t length = member->value_length - 2;
+    if (!decode_data) {
+        PyObject* start = PyLong_FromSize_t(member->value_offset + 1);
+        PyObject* stop = start ? PyLong_FromSize_t(member->value_offset + 1 + length) : NULL;
+        PyObject* result = stop ? PySlice_New(start, stop, NULL) : NULL;
+        Py_XDECREF(start);
+        Py_XDECREF(stop);
+        return result;
+    }
+    if (!memchr(content, '\\', length)) {
+        return fhir_base64_to_memoryview(content, length);
+    }
+    
+    // Escaped payloads ("\/", "\n") are unescaped by the JSON parser first
+    cJSON* json = fhir_json_parse(text + member->value_offset, member->value_length);
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRBundle* bundle = fhir_bundle_create(id);
-    if (!bundle) {
-        PyErr_SetString(PyExc_MemoryError, "Failed to create FHIR Bundle");
+    PyObject* result = fhir_base64_to_memoryview(json->valuestring, strlen(json->valuestring));
+    cJSON_Delete(json);
+    return result;
+}
+
+static PyObject* py_fhir_parse_binary(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!fhir_python_check_args("parse_binary", nargs, 1, 2)) {
+        return NULL;
+    }
+    int decode_data = nargs == 2 ? PyObject_IsTrue(args[1]) : 1;
+    if (decode_data < 0) {
         return NULL;
     }
     
-    // Convert to Python dictionary
-    cJSON* json = fhir_bundle_to_json(bundle);
-    fhir_bundle_free(bundle);
-    
-    if (!json) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to serialize Bundle to JSON");
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(args[0], &view)) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
-    cJSON_Delete(json);
+    // Locate the members without the GIL; only the values other than "data" are parsed
+    const char* text = view.buf;
+    FHIRMemberList list = {NULL, 0, 0};
+    bool walked;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    walked = fhir_json_object_members(text, (size_t)view.len, collect_member, &list);
+    FHIR_END_ALLOW_THREADS
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
+    PyObject* result = NULL;
+    if (!walked) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        goto done;
+    }
+    
+    result = PyDict_New();
+    for (size_t i = 0; result && i < list.count; i++) {
+        const FHIRJSONMemberSpan* member = &list.members[i];
+        const char* key_text = text + member->key_offset;
+        PyObject* key = memchr(key_text, '\\', member->key_length)
+            ? json_span_to_python(key_text - 1, member->key_length + 2)
+            : PyUnicode_DecodeUTF8(key_text, (Py_ssize_t)member->key_length, NULL);
+        
+        bool is_data = member->key_length == 4 && memcmp(key_text, "data", 4) == 0 &&
+                       text[member->value_offset] == '"';
+        PyObject* value = !key ? NULL
+            : is_data ? binary_data_value(text, member, decode_data)
+            : json_span_to_python(text + member->value_offset, member->value_length);
+        
+        if (!value || PyDict_SetItem(result, key, value) < 0) {
+            Py_CLEAR(result);
+        }
+        Py_XDECREF(key);
+        Py_XDECREF(value);
+    }
+    
+done:
+    fhir_free(list.members);
+    PyBuffer_Release(&view);
+    return result;
+}
+
+static PyObject* py_fhir_base64_decode(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    if (!fhir_python_check_args("base64_decode", nargs, 1, 3)) {
         return NULL;
     }
     
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(args[0], &view)) {
         return NULL;
     }
     
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
+    // An optional span selects the payload inside a larger document
+    const char* text = view.buf;
+    size_t length = (size_t)view.len;
+    if (nargs == 3 && args[2] != Py_None) {
+        Py_ssize_t start, stop, step;
+        if (!PySlice_Check(args[2])) {
+            PyErr_SetString(PyExc_TypeError, "span must be a slice");
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        if (PySlice_Unpack(args[2], &start, &stop, &step) < 0) {
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        if (step != 1) {
+            PyErr_SetString(PyExc_ValueError, "span step must be 1");
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        length = (size_t)PySlice_AdjustIndices(view.len, &start, &stop, step);
+        text += start;
     }
     
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
+    if (nargs < 2 || args[1] == Py_None) {
+        PyObject* result = fhir_base64_to_memoryview(text, length);
+        PyBuffer_Release(&view);
+        return result;
+    }
     
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
+    Py_buffer out;
+    if (PyObject_GetBuffer(args[1], &out, PyBUF_WRITABLE) < 0) {
+        PyBuffer_Release(&view);
         return NULL;
     }
+    size_t written = 0;
+    bool decoded;
+    FHIR_BEGIN_ALLOW_THREADS(length)
+    decoded = fhir_base64_decode(text, length, out.buf, (size_t)out.len, &written);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&view);
     
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
-    return result;
+    if (!decoded) {
+        PyErr_SetString(PyExc_ValueError, "Invalid base64 data or output buffer too small");
+        return NULL;
+    }
+    return PyLong_FromSize_t(written);
 }
 
-static PyObject* py_fhir_parse_bundle(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_base64_encode(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
-        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+    // Encode straight into the storage of a new ASCII string
+    size_t length = fhir_base64_encoded_length((size_t)view.len);
+    PyObject* result = PyUnicode_New((Py_ssize_t)length, 127);
+    if (result) {
+        FHIR_BEGIN_ALLOW_THREADS(view.len)
+        fhir_base64_encode(view.buf, (size_t)view.len, (char*)PyUnicode_1BYTE_DATA(result));
+        FHIR_END_ALLOW_THREADS
+    }
+    PyBuffer_Release(&view);
+    return result;
+}
+
+// Bundle resource functions
+static PyObject* py_fhir_bundle_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    const char* id = NULL;
+    if (!fhir_python_check_args("create_bundle", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
-    FHIRBundle* bundle = fhir_parse_bundle(json);
-    cJSON_Delete(json);
-    
+    FHIRBundle* bundle = fhir_bundle_create(id);
     if (!bundle) {
-        PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Bundle");
+        PyErr_SetString(PyExc_MemoryError, "Failed to create FHIR Bundle");
         return NULL;
     }
     
-    // Convert back to JSON for Python
-    cJSON* result_json = fhir_bundle_to_json(bundle);
+    // Convert to Python dictionary
+    cJSON* json = fhir_bundle_to_json(bundle);
     fhir_bundle_free(bundle);
     
-    if (!result_json) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to serialize Bundle");
+    if (!json) {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to serialize Bundle to JSON");
         return NULL;
     }
     
-    char* result_string = cJSON_Print(result_json);
-    cJSON_Delete(result_json);
+    PyObject* result = fhir_cjson_to_python(json);
+    cJSON_Delete(json);
     
-    if (!result_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
+    return result;
+}
+
+static PyObject* py_fhir_parse_bundle(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(result_string);
-        return NULL;
+    // Parse, convert and free without the GIL; only the Python conversion needs it
+    bool parsed = false;
+    bool resolved = false;
+    cJSON* result_json = NULL;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRBundle* bundle = fhir_parse_bundle(json);
+        cJSON_Delete(json);
+        if (bundle) {
+            resolved = true;
+            result_json = fhir_bundle_to_json(bundle);
+            fhir_bundle_free(bundle);
+        }
     }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
     
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(result_string);
+    if (!parsed) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(result_string);
-    free(result_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
+    if (!resolved) {
+        PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Bundle");
+        return NULL;
+    }
+    if (!result_json) {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to serialize Bundle");
         return NULL;
     }
     
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
+    PyObject* result = fhir_cjson_to_python(result_json);
+    cJSON_Delete(result_json);
     
     return result;
 }
 
-static PyObject* py_fhir_bundle_get_entry_count(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+static PyObject* py_fhir_bundle_get_entry_count(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
-    if (!json) {
+    bool parsed = false;
+    bool resolved = false;
+    size_t count = 0;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        parsed = true;
+        FHIRBundle* bundle = fhir_parse_bundle(json);
+        cJSON_Delete(json);
+        if (bundle) {
+            resolved = true;
+            count = fhir_bundle_get_entry_count(bundle);
+            fhir_bundle_free(bundle);
+        }
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (!parsed) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
-    
-    FHIRBundle* bundle = fhir_parse_bundle(json);
-    cJSON_Delete(json);
-    
-    if (!bundle) {
+    if (!resolved) {
         PyErr_SetString(PyExc_ValueError, "Failed to parse FHIR Bundle");
         return NULL;
     }
     
-    size_t count = fhir_bundle_get_entry_count(bundle);
-    fhir_bundle_free(bundle);
-    
     return PyLong_FromSize_t(count);
 }
 
 // Utility functions
-static PyObject* py_fhir_is_terminology_resource(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_is_terminology_resource(PyObject* self, PyObject* arg) {
     const char* resource_type;
-    if (!PyArg_ParseTuple(args, "s", &resource_type)) {
+    if (!fhir_python_text_arg(arg, &resource_type, NULL)) {
         return NULL;
     }
     
@@ -837,9 +845,10 @@ static PyObject* py_fhir_is_terminology_resource(PyObject* self, PyObject* args)
 // Additional Python wrapper functions for new Foundation resources
 
 // Location resource functions
-static PyObject* py_fhir_location_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_location_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_location", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -858,47 +867,17 @@ static PyObject* py_fhir_location_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
 
 // Task resource functions
-static PyObject* py_fhir_task_create(PyObject* self, PyObject* args) {
+static PyObject* py_fhir_task_create(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
     const char* id = NULL;
-    if (!PyArg_ParseTuple(args, "|z", &id)) {
+    if (!fhir_python_check_args("create_task", nargs, 0, 1) ||
+        (nargs == 1 && !fhir_python_optional_text_arg(args[0], &id))) {
         return NULL;
     }
     
@@ -917,39 +896,8 @@ static PyObject* py_fhir_task_create(PyObject* self, PyObject* args) {
         return NULL;
     }
     
-    char* json_string = cJSON_Print(json);
+    PyObject* result = fhir_cjson_to_python(json);
     cJSON_Delete(json);
     
-    if (!json_string) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to convert JSON to string");
-        return NULL;
-    }
-    
-    PyObject* json_module = PyImport_ImportModule("json");
-    if (!json_module) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* loads_func = PyObject_GetAttrString(json_module, "loads");
-    Py_DECREF(json_module);
-    
-    if (!loads_func) {
-        free(json_string);
-        return NULL;
-    }
-    
-    PyObject* json_str_obj = PyUnicode_FromString(json_string);
-    free(json_string);
-    
-    if (!json_str_obj) {
-        Py_DECREF(loads_func);
-        return NULL;
-    }
-    
-    PyObject* result = PyObject_CallFunctionObjArgs(loads_func, json_str_obj, NULL);
-    Py_DECREF(loads_func);
-    Py_DECREF(json_str_obj);
-    
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,506 @@
+/**
+ * @file fhir_interval_index.c
+ * @brief Interval index over Encounter periods and CarePlan activity windows
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_interval_index.h"
+#include "common/fhir_resource_type_lookup.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Pending entries always tolerated before merging */
+#define FHIR_INTERVAL_INDEX_PENDING_MIN 64
+
+/* ========================================================================== */
+/* Index Structure                                                            */
+/* ========================================================================== */
+
+// Run of sorted entries sharing a subject
+typedef struct {
+    const char* subject;
+    size_t offset;
+    size_t count;
+    int root_level;              // Level of the root of the implicit tree
+} IntervalGroup;
+
+struct FHIRIntervalIndex {
+    FHIRIntervalEntry* entries;  // [0, sorted) by (subject, start), then pending inserts
+    size_t count;
+    size_t capacity;
+    size_t sorted;
+    int64_t* max_end;            // Largest end below each sorted entry in its group's tree
+    IntervalGroup* groups;       // Ordered by subject
+    size_t group_count;
+    FHIRArena* strings;          // Subject and id copies
+};
+
+FHIRIntervalIndex* fhir_interval_index_create(void) {
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    FHIRIntervalIndex* index = fhir_calloc(1, sizeof(FHIRIntervalIndex));
+    if (index && !(index->strings = fhir_arena_create(0))) {
+        fhir_free(index);
+        index = NULL;
+    }
+    fhir_arena_set_current(previous);
+
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate interval index");
+    }
+    return index;
+}
+
+void fhir_interval_index_destroy(FHIRIntervalIndex* index) {
+    if (!index) return;
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    fhir_free(index->entries);
+    fhir_free(index->max_end);
+    fhir_free(index->groups);
+    fhir_arena_destroy(index->strings);
+    fhir_free(index);
+    fhir_arena_set_current(previous);
+}
+
+size_t fhir_interval_index_count(const FHIRIntervalIndex* index) {
+    return index ? index->count : 0;
+}
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+// NULL subjects order first
+static int compare_subjects(const char* a, const char* b) {
+    if (a == b) return 0;
+    if (!a || !b) return a ? 1 : -1;
+    return strcmp(a, b);
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const FHIRIntervalEntry* left = a;
+    const FHIRIntervalEntry* right = b;
+    int subject = compare_subjects(left->subject, right->subject);
+    if (subject != 0) return subject;
+    if (left->start != right->start) return left->start < right->start ? -1 : 1;
+    if (left->end != right->end) return left->end < right->end ? -1 : 1;
+    return 0;
+}
+
+// Fill max_end for the implicit tree over n entries sorted by start. Node i
+// sits at the level given by its trailing one bits; a node's children are
+// i -/+ 2^(level-1), and nodes missing from the right edge borrow the largest
+// end seen so far. Returns the root level.
+static int prepare_group(const FHIRIntervalEntry* entries, int64_t* max_end, size_t n) {
+    size_t last_i = 0;
+    int64_t last = 0;
+    for (size_t i = 0; i < n; i += 2) {
+        last_i = i;
+        last = max_end[i] = entries[i].end;
+    }
+
+    int level = 1;
+    for (; ((size_t)1 << level) <= n; level++) {
+        size_t half = (size_t)1 << (level - 1);
+        size_t step = half << 2;
+        for (size_t i = (half << 1) - 1; i < n; i += step) {
+            int64_t end = entries[i].end;
+            int64_t left = max_end[i - half];
+            int64_t right = i + half < n ? max_end[i + half] : last;
+            if (left > end) end = left;
+            if (right > end) end = right;
+            max_end[i] = end;
+        }
+        last_i = (last_i >> level & 1) ? last_i - half : last_i + half;
+        if (last_i < n && max_end[last_i] > last) last = max_end[last_i];
+    }
+    return level - 1;
+}
+
+// Merge the pending tail into the sorted part and rebuild groups and trees
+static bool build_on_heap(FHIRIntervalIndex* index) {
+    if (index->sorted == index->count) return true;
+
+    size_t pending = index->count - index->sorted;
+    qsort(index->entries + index->sorted, pending, sizeof(FHIRIntervalEntry), compare_entries);
+
+    FHIRIntervalEntry* merged = fhir_malloc(index->capacity * sizeof(FHIRIntervalEntry));
+    int64_t* max_end = fhir_malloc(index->count * sizeof(int64_t));
+    if (!merged || !max_end) {
+        fhir_free(merged);
+        fhir_free(max_end);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to build interval index");
+        return false;
+    }
+
+    // Two sorted runs: [0, sorted) and [sorted, count)
+    size_t left = 0, right = index->sorted, out = 0;
+    while (left < index->sorted && right < index->count) {
+        bool take_right = compare_entries(&index->entries[right], &index->entries[left]) < 0;
+        merged[out++] = index->entries[take_right ? right++ : left++];
+    }
+    while (left < index->sorted) merged[out++] = index->entries[left++];
+    while (right < index->count) merged[out++] = index->entries[right++];
+
+    // Groups are runs of one subject
+    size_t group_count = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        if (i == 0 || compare_subjects(merged[i].subject, merged[i - 1].subject) != 0) group_count++;
+    }
+    IntervalGroup* groups = fhir_malloc(group_count * sizeof(IntervalGroup));
+    if (!groups) {
+        fhir_free(merged);
+        fhir_free(max_end);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to build interval index");
+        return false;
+    }
+
+    size_t group = 0;
+    for (size_t i = 0; i < index->count; group++) {
+        size_t begin = i;
+        while (i < index->count && compare_subjects(merged[i].subject, merged[begin].subject) == 0) i++;
+        groups[group].subject = merged[begin].subject;
+        groups[group].offset = begin;
+        groups[group].count = i - begin;
+        groups[group].root_level = prepare_group(merged + begin, max_end + begin, i - begin);
+    }
+
+    fhir_free(index->entries);
+    fhir_free(index->max_end);
+    fhir_free(index->groups);
+    index->entries = merged;
+    index->max_end = max_end;
+    index->groups = groups;
+    index->group_count = group_count;
+    index->sorted = index->count;
+    return true;
+}
+
+bool fhir_interval_index_build(FHIRIntervalIndex* index) {
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = build_on_heap(index);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+// Append an entry whose strings already belong to the index
+static bool append_entry(FHIRIntervalIndex* index, const FHIRIntervalEntry* entry) {
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 64;
+        FHIRIntervalEntry* entries = fhir_realloc(index->entries, capacity * sizeof(FHIRIntervalEntry));
+        if (!entries) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow interval index");
+            return false;
+        }
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    index->entries[index->count++] = *entry;
+
+    // Merging once the tail reaches an eighth of the index keeps inserts
+    // amortized; if the merge cannot allocate, the entry simply stays pending
+    size_t pending = index->count - index->sorted;
+    if (pending > FHIR_INTERVAL_INDEX_PENDING_MIN && pending * 8 > index->sorted) {
+        (void)build_on_heap(index);
+    }
+    return true;
+}
+
+// Copy an optional string into the index; *copy is NULL for a NULL text
+static bool copy_optional(FHIRIntervalIndex* index, const char* text, const char** copy) {
+    *copy = NULL;
+    if (!text) return true;
+
+    size_t length = strlen(text);
+    char* buffer = fhir_arena_alloc(index->strings, length + 1);
+    if (!buffer) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy interval index string");
+        return false;
+    }
+    memcpy(buffer, text, length + 1);
+    *copy = buffer;
+    return true;
+}
+
+bool fhir_interval_index_insert(FHIRIntervalIndex* index, const FHIRIntervalEntry* entry) {
+    if (!index || !entry || entry->start >= entry->end) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRIntervalEntry copy = *entry;
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = copy_optional(index, entry->subject, &copy.subject) &&
+              copy_optional(index, entry->id, &copy.id) &&
+              append_entry(index, &copy);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+// [start, end) of a Period; a missing or malformed bound stays open
+static bool period_range(const cJSON* period, int64_t* start, int64_t* end) {
+    if (!cJSON_IsObject(period)) return false;
+
+    const char* period_start = fhir_json_get_string(period, "start");
+    const char* period_end = fhir_json_get_string(period, "end");
+    if (!period_start && !period_end) return false;
+
+    FHIRDateTimeValue value;
+    *start = period_start && fhir_datetime_parse(period_start, &value) ? value.epoch_us
+                                                                       : FHIR_INTERVAL_INDEX_MIN;
+    *end = period_end && fhir_datetime_parse(period_end, &value) ? fhir_datetime_end(&value)
+                                                                 : FHIR_INTERVAL_INDEX_MAX;
+    return true;
+}
+
+static bool add_period(FHIRIntervalIndex* index, FHIRIntervalEntry* entry, const cJSON* period,
+                       int activity, size_t* added) {
+    // Periods ending before they start cover nothing
+    if (!period_range(period, &entry->start, &entry->end) || entry->start >= entry->end) return true;
+
+    entry->activity = activity;
+    if (!append_entry(index, entry)) return false;
+    (*added)++;
+    return true;
+}
+
+static bool add_json_on_heap(FHIRIntervalIndex* index, const cJSON* json, FHIRResourceType type,
+                             FHIRIntervalEntry* entry, size_t* added) {
+    const cJSON* subject = cJSON_GetObjectItemCaseSensitive(json, "subject");
+    if (!copy_optional(index, cJSON_IsObject(subject) ? fhir_json_get_string(subject, "reference") : NULL,
+                       &entry->subject) ||
+        !copy_optional(index, fhir_json_get_string(json, "id"), &entry->id)) {
+        return false;
+    }
+
+    if (type == FHIR_RESOURCE_TYPE_ENCOUNTER) {
+        // R5 renamed period to actualPeriod
+        const cJSON* period = cJSON_GetObjectItemCaseSensitive(json, "actualPeriod");
+        if (!period) period = cJSON_GetObjectItemCaseSensitive(json, "period");
+        return add_period(index, entry, period, FHIR_INTERVAL_INDEX_RESOURCE_PERIOD, added);
+    }
+
+    if (!add_period(index, entry, cJSON_GetObjectItemCaseSensitive(json, "period"),
+                    FHIR_INTERVAL_INDEX_RESOURCE_PERIOD, added)) {
+        return false;
+    }
+    const cJSON* activities = cJSON_GetObjectItemCaseSensitive(json, "activity");
+    if (!cJSON_IsArray(activities)) return true;
+
+    int activity = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, activities) {
+        const cJSON* detail = cJSON_GetObjectItemCaseSensitive(item, "detail");
+        if (cJSON_IsObject(detail) &&
+            !add_period(index, entry, cJSON_GetObjectItemCaseSensitive(detail, "scheduledPeriod"),
+                        activity, added)) {
+            return false;
+        }
+        activity++;
+    }
+    return true;
+}
+
+bool fhir_interval_index_add_json(FHIRIntervalIndex* index, const cJSON* json, size_t value, size_t* added) {
+    size_t ignored;
+    if (!added) added = &ignored;
+    *added = 0;
+
+    const char* type_name = cJSON_IsObject(json) ? fhir_json_get_string(json, "resourceType") : NULL;
+    if (!index || !type_name) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRResourceType type = fhir_resource_type_lookup(type_name, strlen(type_name));
+    if (type != FHIR_RESOURCE_TYPE_ENCOUNTER && type != FHIR_RESOURCE_TYPE_CARE_PLAN) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Expected an Encounter or CarePlan");
+        return false;
+    }
+
+    FHIRIntervalEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.resource_type = type;
+    entry.value = value;
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = add_json_on_heap(index, json, type, &entry, added);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Queries                                                                    */
+/* ========================================================================== */
+
+void fhir_interval_result_init(FHIRIntervalResult* result) {
+    if (!result) return;
+    memset(result, 0, sizeof(*result));
+}
+
+void fhir_interval_result_cleanup(FHIRIntervalResult* result) {
+    if (!result) return;
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    fhir_free((void*)result->items);
+    fhir_arena_set_current(previous);
+    memset(result, 0, sizeof(*result));
+}
+
+typedef enum {
+    INTERVAL_QUERY_OVERLAP,
+    INTERVAL_QUERY_CONTAIN
+} IntervalQueryKind;
+
+typedef struct {
+    int64_t start;
+    int64_t end;
+    IntervalQueryKind kind;
+    FHIRIntervalResult* result;
+} IntervalQuery;
+
+static bool result_push(FHIRIntervalResult* result, const FHIRIntervalEntry* entry) {
+    if (result->count == result->capacity) {
+        size_t capacity = result->capacity ? result->capacity * 2 : 16;
+        const FHIRIntervalEntry** items = fhir_realloc((void*)result->items,
+                                                       capacity * sizeof(const FHIRIntervalEntry*));
+        if (!items) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow interval result");
+            return false;
+        }
+        result->items = items;
+        result->capacity = capacity;
+    }
+    result->items[result->count++] = entry;
+    return true;
+}
+
+// Push an entry known to start before the window ends if it matches the query
+static bool query_match(const IntervalQuery* query, const FHIRIntervalEntry* entry) {
+    if (entry->end <= query->start) return true;
+    if (query->kind == INTERVAL_QUERY_CONTAIN && (entry->start > query->start || entry->end < query->end)) {
+        return true;
+    }
+    return result_push(query->result, entry);
+}
+
+// Top-down walk of the implicit tree, pruning subtrees whose largest end is
+// before the window and right subtrees starting after it
+static bool query_group(const FHIRIntervalIndex* index, const IntervalGroup* group, const IntervalQuery* query) {
+    const FHIRIntervalEntry* entries = index->entries + group->offset;
+    const int64_t* max_end = index->max_end + group->offset;
+    size_t n = group->count;
+
+    struct {
+        size_t node;
+        int level;
+        bool left_done;
+    } stack[64];
+    int top = 0;
+    stack[top].node = ((size_t)1 << group->root_level) - 1;
+    stack[top].level = group->root_level;
+    stack[top++].left_done = false;
+
+    while (top > 0) {
+        size_t node = stack[--top].node;
+        int level = stack[top].level;
+        bool left_done = stack[top].left_done;
+
+        if (level <= 3) {
+            // Small subtree: scan it in start order
+            size_t first = node >> level << level;
+            size_t last = first + ((size_t)1 << (level + 1)) - 1;
+            if (last > n) last = n;
+            for (size_t i = first; i < last && entries[i].start < query->end; i++) {
+                if (!query_match(query, &entries[i])) return false;
+            }
+        } else if (!left_done) {
+            size_t left = node - ((size_t)1 << (level - 1));
+            stack[top].node = node;
+            stack[top].level = level;
+            stack[top++].left_done = true;
+            // A left child past the right edge has no max_end but may have descendants
+            if (left >= n || max_end[left] > query->start) {
+                stack[top].node = left;
+                stack[top].level = level - 1;
+                stack[top++].left_done = false;
+            }
+        } else if (node < n && entries[node].start < query->end) {
+            if (!query_match(query, &entries[node])) return false;
+            stack[top].node = node + ((size_t)1 << (level - 1));
+            stack[top].level = level - 1;
+            stack[top++].left_done = false;
+        }
+    }
+    return true;
+}
+
+static bool run_query(const FHIRIntervalIndex* index, const char* subject, const IntervalQuery* query) {
+    // Sorted part: one group, or every group when subject is NULL
+    size_t first = 0, last = index->group_count;
+    if (subject) {
+        size_t low = 0, high = index->group_count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (compare_subjects(index->groups[middle].subject, subject) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        first = low;
+        last = low < index->group_count && compare_subjects(index->groups[low].subject, subject) == 0 ? low + 1
+                                                                                                    : low;
+    }
+    for (size_t group = first; group < last; group++) {
+        if (!query_group(index, &index->groups[group], query)) return false;
+    }
+
+    // Pending tail
+    for (size_t i = index->sorted; i < index->count; i++) {
+        const FHIRIntervalEntry* entry = &index->entries[i];
+        if (entry->start >= query->end) continue;
+        if (subject && compare_subjects(entry->subject, subject) != 0) continue;
+        if (!query_match(query, entry)) return false;
+    }
+    return true;
+}
+
+static bool query_on_heap(const FHIRIntervalIndex* index, const char* subject, int64_t start, int64_t end,
+                          IntervalQueryKind kind, FHIRIntervalResult* result) {
+    if (!index || !result) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    result->count = 0;
+    if (start >= end) return true;
+
+    IntervalQuery query = { start, end, kind, result };
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = run_query(index, subject, &query);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+bool fhir_interval_index_overlapping(const FHIRIntervalIndex* index, const char* subject,
+                                     int64_t start, int64_t end, FHIRIntervalResult* result) {
+    return query_on_heap(index, subject, start, end, INTERVAL_QUERY_OVERLAP, result);
+}
+
+bool fhir_interval_index_containing(const FHIRIntervalIndex* index, const char* subject,
+                                    int64_t start, int64_t end, FHIRIntervalResult* result) {
+    return query_on_heap(index, subject, start, end, INTERVAL_QUERY_CONTAIN, result);
+}
+
+bool fhir_interval_index_at(const FHIRIntervalIndex* index, const char* subject, int64_t instant,
+                            FHIRIntervalResult* result) {
+    // The last representable instant only ends open periods, which never contain it
+    int64_t end = instant == FHIR_INTERVAL_INDEX_MAX ? instant : instant + 1;
+    return query_on_heap(index, subject, instant, end, INTERVAL_QUERY_OVERLAP, result);
+}
@@ -0,0 +1,193 @@
+/**
+ * @file fhir_interval_index.h
+ * @brief Interval index over Encounter periods and CarePlan activity windows
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Periods are kept as half-open [start, end) epoch microsecond ranges from
+ * the pre-parsed datetime form (fhir_datetime_parse), grouped by subject and
+ * sorted by start. Each group carries an implicit augmented binary tree (the
+ * maximum end below every node, stored beside the sorted entries), so
+ * overlap, containment and stabbing queries cost O(log n + k) instead of a
+ * scan of every resource:
+ *
+ *   overlapping   entries sharing an instant with [start, end)
+ *   containing    entries covering all of [start, end)
+ *   at            entries covering one instant
+ *
+ * Inserts append to a pending tail that queries scan linearly; the tail is
+ * merged into the sorted part once it grows past an eighth of the index, so
+ * inserting stays amortized O(log n) and queries never modify the index.
+ * Concurrent queries are safe; inserts need exclusive access.
+ */
+
+#ifndef FHIR_INTERVAL_INDEX_H
+#define FHIR_INTERVAL_INDEX_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Open ends of a period without start or end */
+#define FHIR_INTERVAL_INDEX_MIN INT64_MIN
+#define FHIR_INTERVAL_INDEX_MAX INT64_MAX
+
+/** Activity index of an entry for the period of the resource itself */
+#define FHIR_INTERVAL_INDEX_RESOURCE_PERIOD (-1)
+
+/**
+ * @brief One indexed period
+ *
+ * Strings are owned by the index.
+ */
+typedef struct {
+    int64_t start;                   /**< Inclusive epoch microseconds */
+    int64_t end;                     /**< Exclusive epoch microseconds */
+    const char* subject;             /**< Subject reference, e.g. "Patient/123" (can be NULL) */
+    const char* id;                  /**< Resource id (can be NULL) */
+    FHIRResourceType resource_type;
+    int activity;                    /**< CarePlan activity, or FHIR_INTERVAL_INDEX_RESOURCE_PERIOD */
+    size_t value;                    /**< Caller value, e.g. a position in a resource list */
+} FHIRIntervalEntry;
+
+/**
+ * @brief Interval index (opaque)
+ */
+typedef struct FHIRIntervalIndex FHIRIntervalIndex;
+
+/**
+ * @brief Entries selected by a query
+ *
+ * Pointers stay valid until the next insert into the index.
+ */
+typedef struct {
+    const FHIRIntervalEntry** items;
+    size_t count;
+    size_t capacity;
+} FHIRIntervalResult;
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty index
+ * @return New index or NULL on allocation failure
+ */
+FHIRIntervalIndex* fhir_interval_index_create(void);
+
+/**
+ * @brief Destroy an index and the strings it owns
+ * @param index Index to destroy (can be NULL)
+ */
+void fhir_interval_index_destroy(FHIRIntervalIndex* index);
+
+/**
+ * @brief Get the number of indexed entries
+ * @param index Index to query
+ * @return Entry count
+ */
+size_t fhir_interval_index_count(const FHIRIntervalIndex* index);
+
+/**
+ * @brief Insert one period
+ * @param index Index to insert into
+ * @param entry Period to insert; subject and id are copied
+ * @return true on success, false on allocation failure, invalid arguments or an empty period
+ */
+bool fhir_interval_index_insert(FHIRIntervalIndex* index, const FHIRIntervalEntry* entry);
+
+/**
+ * @brief Insert the periods of an Encounter or CarePlan JSON tree
+ *
+ * Encounter contributes period (R4) or actualPeriod (R5); CarePlan
+ * contributes period and every activity.detail.scheduledPeriod. A missing
+ * or malformed bound leaves that end open; a period with neither bound, or
+ * one ending before it starts, is skipped.
+ *
+ * @param index Index to insert into
+ * @param json Encounter or CarePlan JSON
+ * @param value Caller value stored in every inserted entry
+ * @param added Output number of inserted entries (can be NULL)
+ * @return true on success, false on allocation failure or another resource type
+ */
+bool fhir_interval_index_add_json(FHIRIntervalIndex* index, const cJSON* json, size_t value, size_t* added);
+
+/**
+ * @brief Merge pending inserts into the sorted part
+ *
+ * Optional: queries include pending entries. Calling it after a bulk load
+ * makes the next queries fully logarithmic.
+ *
+ * @param index Index to build
+ * @return true on success, false on allocation failure
+ */
+bool fhir_interval_index_build(FHIRIntervalIndex* index);
+
+/* ========================================================================== */
+/* Queries                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty result
+ * @param result Result to initialize
+ */
+void fhir_interval_result_init(FHIRIntervalResult* result);
+
+/**
+ * @brief Free the buffer of a result
+ * @param result Result to clean up (can be NULL)
+ */
+void fhir_interval_result_cleanup(FHIRIntervalResult* result);
+
+/**
+ * @brief Find entries overlapping [start, end)
+ * @param index Index to query
+ * @param subject Subject reference to restrict to, NULL for every subject
+ * @param start Inclusive window start (epoch microseconds)
+ * @param end Exclusive window end
+ * @param result Output entries (replaces the previous contents)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_interval_index_overlapping(const FHIRIntervalIndex* index, const char* subject,
+                                     int64_t start, int64_t end, FHIRIntervalResult* result);
+
+/**
+ * @brief Find entries covering all of [start, end)
+ * @param index Index to query
+ * @param subject Subject reference to restrict to, NULL for every subject
+ * @param start Inclusive window start (epoch microseconds)
+ * @param end Exclusive window end
+ * @param result Output entries (replaces the previous contents)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_interval_index_containing(const FHIRIntervalIndex* index, const char* subject,
+                                    int64_t start, int64_t end, FHIRIntervalResult* result);
+
+/**
+ * @brief Find entries covering one instant (stabbing query)
+ * @param index Index to query
+ * @param subject Subject reference to restrict to, NULL for every subject
+ * @param instant Instant in epoch microseconds
+ * @param result Output entries (replaces the previous contents)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_interval_index_at(const FHIRIntervalIndex* index, const char* subject, int64_t instant,
+                            FHIRIntervalResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_INTERVAL_INDEX_H */
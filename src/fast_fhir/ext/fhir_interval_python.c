@@ -0,0 +1,270 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_document.h"
+#include "fhir_python_time.h"
+#include "fhir_interval_index.h"
+
+// Python binding for the interval index
+
+// IntervalIndex: Encounter periods and CarePlan activity windows for overlap queries
+typedef struct {
+    PyObject_HEAD
+    FHIRIntervalIndex* index;
+} IntervalIndex;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* interval_index_type;
+    const FHIRPythonDocuments* documents;   // fhir_parser_c entry points, or NULL without it
+} IntervalModuleState;
+
+static struct PyModuleDef fhir_interval_module;
+
+static int IntervalIndex_init(IntervalIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+        return -1;
+    }
+    
+    FHIRIntervalIndex* index = fhir_interval_index_create();
+    if (index == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_interval_index_destroy(self->index);
+    self->index = index;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void IntervalIndex_dealloc(IntervalIndex* self) {
+    fhir_interval_index_destroy(self->index);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int IntervalIndex_check_ready(const IntervalIndex* self) {
+    if (self->index == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "IntervalIndex is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* IntervalIndex_add(IntervalIndex* self, PyObject* document) {
+    IntervalModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_interval_module);
+    if (!state || !IntervalIndex_check_ready(self)) {
+        return NULL;
+    }
+    
+    cJSON* owned;
+    const cJSON* json = fhir_python_document_json(state->documents, document, &owned);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    size_t added;
+    bool ok;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_interval_index_add_json(self->index, json, 0, &added);
+    FHIR_PY_END_CRITICAL_SECTION();
+    cJSON_Delete(owned);
+    if (!ok) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, error ? error->message : "Expected an Encounter or CarePlan");
+        return NULL;
+    }
+    return PyLong_FromSize_t(added);
+}
+
+static PyObject* IntervalIndex_build(IntervalIndex* self, PyObject* Py_UNUSED(ignored)) {
+    if (!IntervalIndex_check_ready(self)) {
+        return NULL;
+    }
+    bool ok;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_interval_index_build(self->index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (!ok) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+// Entries as (resource_type, id, activity, start_ms, end_ms) tuples
+static PyObject* interval_result_to_python(const FHIRIntervalResult* result) {
+    PyObject* list = PyList_New((Py_ssize_t)result->count);
+    for (size_t i = 0; list != NULL && i < result->count; i++) {
+        const FHIRIntervalEntry* entry = result->items[i];
+        PyObject* activity = entry->activity == FHIR_INTERVAL_INDEX_RESOURCE_PERIOD
+                                 ? (Py_INCREF(Py_None), Py_None)
+                                 : PyLong_FromLong(entry->activity);
+        PyObject* item = activity == NULL ? NULL :
+            Py_BuildValue("(szNNN)",
+                          entry->resource_type == FHIR_RESOURCE_TYPE_ENCOUNTER ? "Encounter" : "CarePlan",
+                          entry->id, activity, fhir_python_time_bound_to_python(entry->start, false),
+                          fhir_python_time_bound_to_python(entry->end, true));
+        if (item == NULL) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+    return list;
+}
+
+typedef bool (*IntervalQueryFunction)(const FHIRIntervalIndex*, const char*, int64_t, int64_t,
+                                      FHIRIntervalResult*);
+
+static PyObject* IntervalIndex_query(IntervalIndex* self, PyObject* args, IntervalQueryFunction query) {
+    const char* subject;
+    PyObject* start_arg;
+    PyObject* end_arg;
+    if (!IntervalIndex_check_ready(self) || !PyArg_ParseTuple(args, "zOO", &subject, &start_arg, &end_arg)) {
+        return NULL;
+    }
+    
+    int64_t start, end;
+    if (!fhir_python_time_bound_from_python(start_arg, false, &start) ||
+        !fhir_python_time_bound_from_python(end_arg, true, &end)) {
+        return NULL;
+    }
+    
+    // Results point into the index, so they are converted before another thread can add to it
+    FHIRIntervalResult result;
+    PyObject* entries;
+    fhir_interval_result_init(&result);
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    entries = query(self->index, subject, start, end, &result) ? interval_result_to_python(&result)
+                                                               : PyErr_NoMemory();
+    FHIR_PY_END_CRITICAL_SECTION();
+    fhir_interval_result_cleanup(&result);
+    return entries;
+}
+
+static PyObject* IntervalIndex_overlapping(IntervalIndex* self, PyObject* args) {
+    return IntervalIndex_query(self, args, fhir_interval_index_overlapping);
+}
+
+static PyObject* IntervalIndex_containing(IntervalIndex* self, PyObject* args) {
+    return IntervalIndex_query(self, args, fhir_interval_index_containing);
+}
+
+static PyObject* IntervalIndex_at(IntervalIndex* self, PyObject* args) {
+    const char* subject;
+    PyObject* instant_arg;
+    if (!IntervalIndex_check_ready(self) || !PyArg_ParseTuple(args, "zO", &subject, &instant_arg)) {
+        return NULL;
+    }
+    
+    int64_t instant;
+    if (instant_arg == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "instant must be a FHIR date or epoch milliseconds");
+        return NULL;
+    }
+    if (!fhir_python_time_bound_from_python(instant_arg, false, &instant)) {
+        return NULL;
+    }
+    
+    FHIRIntervalResult result;
+    PyObject* entries;
+    fhir_interval_result_init(&result);
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    entries = fhir_interval_index_at(self->index, subject, instant, &result)
+                  ? interval_result_to_python(&result) : PyErr_NoMemory();
+    FHIR_PY_END_CRITICAL_SECTION();
+    fhir_interval_result_cleanup(&result);
+    return entries;
+}
+
+static Py_ssize_t IntervalIndex_length(IntervalIndex* self) {
+    if (!IntervalIndex_check_ready(self)) {
+        return -1;
+    }
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = (Py_ssize_t)fhir_interval_index_count(self->index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+static PyMethodDef IntervalIndexMethods[] = {
+    {"add", (PyCFunction)IntervalIndex_add, METH_O,
+     "Index the periods of an Encounter or CarePlan (ParsedDocument or JSON text); returns the count added"},
+    {"build", (PyCFunction)IntervalIndex_build, METH_NOARGS, "Merge pending inserts after a bulk load"},
+    {"overlapping", (PyCFunction)IntervalIndex_overlapping, METH_VARARGS,
+     "overlapping(subject, start, end): entries sharing an instant with the window"},
+    {"containing", (PyCFunction)IntervalIndex_containing, METH_VARARGS,
+     "containing(subject, start, end): entries covering the whole window"},
+    {"at", (PyCFunction)IntervalIndex_at, METH_VARARGS, "at(subject, instant): entries covering an instant"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot IntervalIndexSlots[] = {
+    {Py_tp_doc, "Interval index over Encounter periods and CarePlan activity windows"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, IntervalIndex_init},
+    {Py_tp_dealloc, IntervalIndex_dealloc},
+    {Py_tp_methods, IntervalIndexMethods},
+    {Py_sq_length, IntervalIndex_length},
+    {0, NULL}
+};
+
+static PyType_Spec IntervalIndexSpec = {
+    .name = "fhir_interval_c.IntervalIndex",
+    .basicsize = sizeof(IntervalIndex),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = IntervalIndexSlots,
+};
+
+static int interval_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    IntervalModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->interval_index_type);
+    return 0;
+}
+
+static int interval_module_clear(PyObject* module) {
+    IntervalModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->interval_index_type);
+    return 0;
+}
+
+static void interval_module_free(void* module) {
+    interval_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int interval_module_exec(PyObject* module) {
+    IntervalModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+    state->documents = fhir_python_import_documents();
+
+    state->interval_index_type = fhir_python_add_type(module, &IntervalIndexSpec);
+    return state->interval_index_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot interval_module_slots[] = FHIR_PY_MODULE_SLOTS(interval_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_interval_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_interval_c",
+    "Interval index over FHIR periods in C",
+    sizeof(IntervalModuleState),
+    NULL,
+    interval_module_slots,
+    interval_module_traverse,
+    interval_module_clear,
+    interval_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_interval_c(void) {
+    return PyModuleDef_Init(&fhir_interval_module);
+}
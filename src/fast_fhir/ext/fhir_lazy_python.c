@@ -0,0 +1,502 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_json.h"
+#include "common/fhir_binary.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_resource_type_lookup.h"
+
+// Python binding for lazily converted resources
+
+// LazyResource: an element of a parsed JSON tree whose members become Python
+// values only when read. Every wrapper of one tree holds a reference to a
+// capsule owning the cJSON tree; the capsule holds no Python references, so
+// member caches never form cycles.
+typedef struct {
+    PyObject_HEAD
+    PyObject* tree;     // Capsule owning the whole cJSON tree
+    cJSON* json;        // Object node
+    PyObject* cache;    // Member name -> converted value, created on first read
+} LazyResource;
+
+// LazyList: a JSON array whose items are converted on first access
+typedef struct {
+    PyObject_HEAD
+    PyObject* tree;
+    cJSON* json;
+    Py_ssize_t length;
+    cJSON** nodes;      // Item nodes by index, collected on first access
+    PyObject** items;   // Converted items (NULL until read)
+} LazyList;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* lazy_resource_type;
+    PyTypeObject* lazy_list_type;
+    FHIRPythonKeyCache keys;
+} LazyModuleState;
+
+static struct PyModuleDef fhir_lazy_module;
+
+// State of the module that created the type of self
+static LazyModuleState* lazy_state(PyObject* self) {
+    return fhir_python_type_state(Py_TYPE(self), &fhir_lazy_module);
+}
+
+static void lazy_tree_destructor(PyObject* capsule) {
+    cJSON_Delete(PyCapsule_GetPointer(capsule, NULL));
+}
+
+// Wrap a node of the tree owned by the capsule tree
+static PyObject* lazy_wrap(const LazyModuleState* state, PyObject* tree, cJSON* json) {
+    if (cJSON_IsObject(json)) {
+        LazyResource* self = PyObject_New(LazyResource, state->lazy_resource_type);
+        if (self == NULL) {
+            return NULL;
+        }
+        Py_INCREF(tree);
+        self->tree = tree;
+        self->json = json;
+        self->cache = NULL;
+        return (PyObject*)self;
+    }
+    if (cJSON_IsArray(json)) {
+        LazyList* self = PyObject_New(LazyList, state->lazy_list_type);
+        if (self == NULL) {
+            return NULL;
+        }
+        Py_INCREF(tree);
+        self->tree = tree;
+        self->json = json;
+        self->length = cJSON_GetArraySize(json);
+        self->nodes = NULL;
+        self->items = NULL;
+        return (PyObject*)self;
+    }
+    return fhir_cjson_to_python(json);
+}
+
+// Wrap the root of a parsed tree, taking ownership of json
+static PyObject* lazy_wrap_root(const LazyModuleState* state, cJSON* json) {
+    PyObject* tree = PyCapsule_New(json, NULL, lazy_tree_destructor);
+    if (tree == NULL) {
+        cJSON_Delete(json);
+        return NULL;
+    }
+    PyObject* result = lazy_wrap(state, tree, json);
+    Py_DECREF(tree);
+    return result;
+}
+
+static void LazyResource_dealloc(LazyResource* self) {
+    Py_XDECREF(self->cache);
+    Py_DECREF(self->tree);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+// Find a member by name, then by its camelCase form (birth_date -> birthDate)
+static cJSON* LazyResource_find(LazyResource* self, const char* name) {
+    cJSON* member = cJSON_GetObjectItemCaseSensitive(self->json, name);
+    if (member != NULL || strchr(name, '_') == NULL || name[0] == '_') {
+        return member;
+    }
+    
+    char camel[128];
+    size_t length = 0;
+    for (const char* c = name; *c; c++) {
+        if (length + 1 >= sizeof(camel)) {
+            return NULL;
+        }
+        if (*c == '_' && c[1] >= 'a' && c[1] <= 'z') {
+            camel[length++] = (char)(c[1] - 'a' + 'A');
+            c++;
+        } else {
+            camel[length++] = *c;
+        }
+    }
+    camel[length] = '\0';
+    return cJSON_GetObjectItemCaseSensitive(self->json, camel);
+}
+
+// Attributes: cached member values, then members of the JSON object, then
+// the type's methods; absent members read as None
+static PyObject* LazyResource_getattro(LazyResource* self, PyObject* name) {
+    PyObject* cached = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (self->cache) {
+        cached = PyDict_GetItemWithError(self->cache, name);
+        Py_XINCREF(cached);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (cached || PyErr_Occurred()) {
+        return cached;
+    }
+    
+    const char* text = PyUnicode_AsUTF8(name);
+    if (text == NULL) {
+        return NULL;
+    }
+    cJSON* member = LazyResource_find(self, text);
+    if (member == NULL) {
+        PyObject* attribute = PyObject_GenericGetAttr((PyObject*)self, name);
+        if (attribute || text[0] == '_' || !PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            return attribute;
+        }
+        PyErr_Clear();
+        Py_RETURN_NONE;
+    }
+    
+    LazyModuleState* state = lazy_state((PyObject*)self);
+    PyObject* value = state ? lazy_wrap(state, self->tree, member) : NULL;
+    if (value == NULL) {
+        return NULL;
+    }
+    
+    // A thread that converted the same member first wins, so every read sees one object
+    PyObject* result = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (self->cache != NULL || (self->cache = PyDict_New()) != NULL) {
+        result = PyDict_SetDefault(self->cache, name, value);
+        Py_XINCREF(result);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    Py_DECREF(value);
+    return result;
+}
+
+static int LazyResource_contains(LazyResource* self, PyObject* name) {
+    const char* text = PyUnicode_AsUTF8(name);
+    if (text == NULL) {
+        return -1;
+    }
+    return cJSON_GetObjectItemCaseSensitive(self->json, text) != NULL;
+}
+
+static PyObject* LazyResource_repr(LazyResource* self) {
+    const char* type = fhir_json_get_string(self->json, "resourceType");
+    const char* id = fhir_json_get_string(self->json, "id");
+    if (type) {
+        return PyUnicode_FromFormat("<LazyResource %s/%s>", type, id ? id : "");
+    }
+    return PyUnicode_FromFormat("<LazyResource with %d members>", cJSON_GetArraySize(self->json));
+}
+
+static PyObject* LazyResource_to_dict(LazyResource* self, PyObject* Py_UNUSED(ignored)) {
+    LazyModuleState* state = lazy_state((PyObject*)self);
+    return state ? fhir_cjson_to_python_cached(self->json, &state->keys) : NULL;
+}
+
+static PyObject* LazyResource_keys(LazyResource* self, PyObject* Py_UNUSED(ignored)) {
+    PyObject* keys = PyList_New(0);
+    for (cJSON* member = self->json->child; keys && member; member = member->next) {
+        PyObject* key = PyUnicode_InternFromString(member->string ? member->string : "");
+        if (key == NULL || PyList_Append(keys, key) < 0) {
+            Py_XDECREF(key);
+            Py_CLEAR(keys);
+            break;
+        }
+        Py_DECREF(key);
+    }
+    return keys;
+}
+
+// Binary encoding of the object (see common/fhir_binary.h)
+static PyObject* LazyResource_to_binary(LazyResource* self, PyObject* Py_UNUSED(ignored)) {
+    const char* type_name = fhir_json_get_string(self->json, "resourceType");
+    int type = type_name ? (int)fhir_resource_type_lookup(type_name, strlen(type_name))
+                         : FHIR_RESOURCE_TYPE_UNKNOWN;
+    
+    FHIRBinaryWriter writer;
+    uint8_t* data = NULL;
+    size_t length = 0;
+    if (fhir_binary_writer_init(&writer, type, fhir_json_get_string(self->json, "id"))) {
+        writer.flags |= FHIR_BINARY_FLAG_JSON;
+        if (fhir_binary_write_json_members(&writer, self->json)) {
+            data = fhir_binary_writer_finish(&writer, &length);
+        }
+    }
+    fhir_binary_writer_cleanup(&writer);
+    if (data == NULL) {
+        return PyErr_NoMemory();
+    }
+    
+    PyObject* result = PyBytes_FromStringAndSize((const char*)data, (Py_ssize_t)length);
+    fhir_free(data);
+    return result;
+}
+
+// Pickle as the binary encoding of the object
+static PyObject* LazyResource_reduce(LazyResource* self, PyObject* Py_UNUSED(ignored)) {
+    PyObject* data = LazyResource_to_binary(self, NULL);
+    if (data == NULL) {
+        return NULL;
+    }
+    PyObject* module = PyImport_ImportModule("fast_fhir.fhir_lazy_c");
+    PyObject* loader = module ? PyObject_GetAttrString(module, "lazy_from_binary") : NULL;
+    Py_XDECREF(module);
+    PyObject* result = loader ? Py_BuildValue("(N(N))", loader, data) : NULL;
+    if (loader == NULL) {
+        Py_DECREF(data);
+    }
+    return result;
+}
+
+static PyMethodDef LazyResourceMethods[] = {
+    {"to_dict", (PyCFunction)LazyResource_to_dict, METH_NOARGS, "Convert the whole element to a dict"},
+    {"keys", (PyCFunction)LazyResource_keys, METH_NOARGS, "Member names present in the JSON"},
+    {"to_binary", (PyCFunction)LazyResource_to_binary, METH_NOARGS,
+     "Binary resource encoding, as read by lazy_from_binary and fhir_store_c.export_batch"},
+    {"__reduce__", (PyCFunction)LazyResource_reduce, METH_NOARGS, "Pickle via the binary resource encoding"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot LazyResourceSlots[] = {
+    {Py_tp_doc, "FHIR element whose members are converted on attribute access"},
+    {Py_tp_dealloc, LazyResource_dealloc},
+    {Py_tp_repr, LazyResource_repr},
+    {Py_tp_getattro, LazyResource_getattro},
+    {Py_tp_methods, LazyResourceMethods},
+    {Py_sq_contains, LazyResource_contains},
+    {0, NULL}
+};
+
+static PyType_Spec LazyResourceSpec = {
+    .name = "fhir_lazy_c.LazyResource",
+    .basicsize = sizeof(LazyResource),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = LazyResourceSlots,
+};
+
+static void LazyList_dealloc(LazyList* self) {
+    if (self->items) {
+        for (Py_ssize_t i = 0; i < self->length; i++) {
+            Py_XDECREF(self->items[i]);
+        }
+    }
+    PyMem_Free(self->items);
+    PyMem_Free(self->nodes);
+    Py_DECREF(self->tree);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static Py_ssize_t LazyList_length(LazyList* self) {
+    return self->length;
+}
+
+static PyObject* LazyList_item_locked(LazyList* self, Py_ssize_t index) {
+    if (self->items == NULL) {
+        // One pass over the linked items instead of a walk per index
+        self->nodes = PyMem_Malloc((size_t)self->length * sizeof(cJSON*));
+        self->items = PyMem_Calloc((size_t)self->length, sizeof(PyObject*));
+        if (self->nodes == NULL || self->items == NULL) {
+            PyMem_Free(self->nodes);
+            PyMem_Free(self->items);
+            self->nodes = NULL;
+            self->items = NULL;
+            return PyErr_NoMemory();
+        }
+        Py_ssize_t i = 0;
+        for (cJSON* item = self->json->child; item && i < self->length; item = item->next) {
+            self->nodes[i++] = item;
+        }
+    }
+    if (self->items[index] == NULL) {
+        LazyModuleState* state = lazy_state((PyObject*)self);
+        self->items[index] = state ? lazy_wrap(state, self->tree, self->nodes[index]) : NULL;
+        if (self->items[index] == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(self->items[index]);
+    return self->items[index];
+}
+
+static PyObject* LazyList_item(LazyList* self, Py_ssize_t index) {
+    if (index < 0 || index >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "list index out of range");
+        return NULL;
+    }
+    PyObject* item;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    item = LazyList_item_locked(self, index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return item;
+}
+
+static PyObject* LazyList_subscript(LazyList* self, PyObject* key) {
+    if (PyIndex_Check(key)) {
+        Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (index == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        return LazyList_item(self, index < 0 ? index + self->length : index);
+    }
+    if (PySlice_Check(key)) {
+        Py_ssize_t start, stop, step;
+        if (PySlice_Unpack(key, &start, &stop, &step) < 0) {
+            return NULL;
+        }
+        Py_ssize_t count = PySlice_AdjustIndices(self->length, &start, &stop, step);
+        PyObject* list = PyList_New(count);
+        for (Py_ssize_t i = 0; list && i < count; i++) {
+            PyObject* item = LazyList_item(self, start + i * step);
+            if (item == NULL) {
+                Py_CLEAR(list);
+                break;
+            }
+            PyList_SET_ITEM(list, i, item);
+        }
+        return list;
+    }
+    PyErr_Format(PyExc_TypeError, "list indices must be integers or slices, not %.50s",
+                 Py_TYPE(key)->tp_name);
+    return NULL;
+}
+
+static PyObject* LazyList_repr(LazyList* self) {
+    return PyUnicode_FromFormat("<LazyList of %zd items>", self->length);
+}
+
+static PyObject* LazyList_to_list(LazyList* self, PyObject* Py_UNUSED(ignored)) {
+    LazyModuleState* state = lazy_state((PyObject*)self);
+    return state ? fhir_cjson_to_python_cached(self->json, &state->keys) : NULL;
+}
+
+// Pickle as a plain list of the (lazy) items
+static PyObject* LazyList_reduce(LazyList* self, PyObject* Py_UNUSED(ignored)) {
+    PyObject* slice = PySlice_New(NULL, NULL, NULL);
+    PyObject* items = slice ? LazyList_subscript(self, slice) : NULL;
+    Py_XDECREF(slice);
+    return items ? Py_BuildValue("(O(N))", (PyObject*)&PyList_Type, items) : NULL;
+}
+
+static PyMethodDef LazyListMethods[] = {
+    {"to_list", (PyCFunction)LazyList_to_list, METH_NOARGS, "Convert the whole array to a list"},
+    {"__reduce__", (PyCFunction)LazyList_reduce, METH_NOARGS, "Pickle as a list"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot LazyListSlots[] = {
+    {Py_tp_doc, "FHIR JSON array whose items are converted on first access"},
+    {Py_tp_dealloc, LazyList_dealloc},
+    {Py_tp_repr, LazyList_repr},
+    {Py_tp_methods, LazyListMethods},
+    {Py_sq_length, LazyList_length},
+    {Py_sq_item, LazyList_item},
+    {Py_mp_length, LazyList_length},
+    {Py_mp_subscript, LazyList_subscript},
+    {0, NULL}
+};
+
+static PyType_Spec LazyListSpec = {
+    .name = "fhir_lazy_c.LazyList",
+    .basicsize = sizeof(LazyList),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = LazyListSlots,
+};
+
+// Parse a JSON object into a LazyResource without converting any member
+static PyObject* parse_lazy(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
+        return NULL;
+    }
+    
+    cJSON* json;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    json = fhir_json_parse(view.buf, (size_t)view.len);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!cJSON_IsObject(json)) {
+        cJSON_Delete(json);
+        PyErr_SetString(PyExc_ValueError, "JSON is not an object");
+        return NULL;
+    }
+    
+    return lazy_wrap_root(PyModule_GetState(self), json);
+}
+
+// Rebuild a pickled LazyResource from its binary encoding
+static PyObject* lazy_from_binary(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0) {
+        return NULL;
+    }
+    
+    FHIRBinaryDocument document;
+    cJSON* json = NULL;
+    if (fhir_binary_open(&document, view.buf, (size_t)view.len)) {
+        json = fhir_binary_to_json(&document);
+    }
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Invalid binary resource");
+        return NULL;
+    }
+    
+    return lazy_wrap_root(PyModule_GetState(self), json);
+}
+
+static PyMethodDef FHIRLazyMethods[] = {
+    {"parse_lazy", parse_lazy, METH_O, "Parse a resource into a LazyResource converted on attribute access"},
+    {"lazy_from_binary", lazy_from_binary, METH_O, "Rebuild a LazyResource from its pickled binary encoding"},
+    {NULL, NULL, 0, NULL}
+};
+
+static int lazy_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    LazyModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->lazy_resource_type);
+    Py_VISIT(state->lazy_list_type);
+    return 0;
+}
+
+static int lazy_module_clear(PyObject* module) {
+    LazyModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->lazy_resource_type);
+    Py_CLEAR(state->lazy_list_type);
+    fhir_python_key_cache_clear(&state->keys);
+    return 0;
+}
+
+static void lazy_module_free(void* module) {
+    lazy_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int lazy_module_exec(PyObject* module) {
+    LazyModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    state->lazy_resource_type = fhir_python_add_type(module, &LazyResourceSpec);
+    if (state->lazy_resource_type == NULL) {
+        return -1;
+    }
+    state->lazy_list_type = fhir_python_add_type(module, &LazyListSpec);
+    return state->lazy_list_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot lazy_module_slots[] = FHIR_PY_MODULE_SLOTS(lazy_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_lazy_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_lazy_c",
+    "Lazily converted FHIR resources in C",
+    sizeof(LazyModuleState),
+    FHIRLazyMethods,
+    lazy_module_slots,
+    lazy_module_traverse,
+    lazy_module_clear,
+    lazy_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_lazy_c(void) {
+    return PyModuleDef_Init(&fhir_lazy_module);
+}
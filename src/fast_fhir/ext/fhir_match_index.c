@@ -0,0 +1,883 @@
+/**
+ * @file fhir_match_index.c
+ * @brief Blocking index and pairwise scoring for Patient deduplication
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_match_index.h"
+#include "common/fhir_hash.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Field weights: agreement adds evidence for a match, disagreement removes it
+#define WEIGHT_FAMILY_EXACT       4.0f
+#define WEIGHT_FAMILY_PHONETIC    2.0f
+#define WEIGHT_FAMILY_DIFFERENT  -3.0f
+#define WEIGHT_GIVEN_EXACT        3.0f
+#define WEIGHT_GIVEN_PHONETIC     1.5f
+#define WEIGHT_GIVEN_DIFFERENT   -2.0f
+#define WEIGHT_BIRTH_EXACT        5.0f
+#define WEIGHT_BIRTH_TRANSPOSED   2.5f   // Day and month swapped
+#define WEIGHT_BIRTH_PARTIAL      1.0f   // Same year and month, or a partial date that fits
+#define WEIGHT_BIRTH_DIFFERENT   -4.0f
+#define WEIGHT_GENDER_SAME        0.5f
+#define WEIGHT_GENDER_DIFFERENT  -3.0f
+#define WEIGHT_POSTAL_SAME        2.0f
+#define WEIGHT_POSTAL_DIFFERENT  -0.5f
+#define WEIGHT_LINE_SAME          2.0f
+#define WEIGHT_IDENTIFIER_SAME    8.0f
+#define WEIGHT_IDENTIFIER_CONFLICT -8.0f  // Same system, different value
+
+#define MATCH_MAX_KEYS (FHIR_MATCH_MAX_IDENTIFIERS + 4)
+#define MATCH_NORMALIZED_MAX 128
+#define MATCH_CLAIM_BLOCKS 16
+
+// Seeds of the feature hashes, so equal text in different fields never agrees
+enum {
+    SEED_FAMILY = 1,
+    SEED_GIVEN,
+    SEED_POSTAL,
+    SEED_LINE,
+    SEED_IDENTIFIER,
+    SEED_SYSTEM,
+    KEY_IDENTIFIER,
+    KEY_FAMILY_BIRTH,
+    KEY_FAMILY_POSTAL,
+    KEY_BIRTH_POSTAL,
+    KEY_NAMES_YEAR
+};
+
+/* ========================================================================== */
+/* Index Structure                                                            */
+/* ========================================================================== */
+
+// Normalized features of one Patient; 0 marks an absent value
+typedef struct {
+    char* id;
+    size_t value;
+    uint64_t family;
+    uint64_t given;
+    uint64_t postal;
+    uint64_t line;
+    uint64_t identifier[FHIR_MATCH_MAX_IDENTIFIERS];   // System and value
+    uint64_t system[FHIR_MATCH_MAX_IDENTIFIERS];
+    uint64_t keys[MATCH_MAX_KEYS];
+    uint32_t family_code;        // Soundex, one character per byte
+    uint32_t given_code;
+    uint32_t birth;              // YYYYMMDD, 00 for a missing month or day
+    uint32_t gender;
+    uint32_t key_count;
+} MatchEntry;
+
+struct FHIRMatchIndex {
+    MatchEntry* entries;
+    size_t count;
+    size_t capacity;
+};
+
+/* ========================================================================== */
+/* Normalization                                                              */
+/* ========================================================================== */
+
+static char soundex_digit(char letter) {
+    switch (letter) {
+        case 'B': case 'F': case 'P': case 'V':
+            return '1';
+        case 'C': case 'G': case 'J': case 'K': case 'Q': case 'S': case 'X': case 'Z':
+            return '2';
+        case 'D': case 'T':
+            return '3';
+        case 'L':
+            return '4';
+        case 'M': case 'N':
+            return '5';
+        case 'R':
+            return '6';
+        case 'H': case 'W':
+            return 'h';          // Does not separate equal codes
+        default:
+            return '0';          // Vowels and Y separate equal codes
+    }
+}
+
+bool fhir_soundex(const char* name, char code[5]) {
+    code[0] = '\0';
+    if (!name) return false;
+
+    size_t length = 0;
+    char last = 0;
+    for (const char* p = name; *p && length < 4; p++) {
+        char letter = *p;
+        if (letter >= 'a' && letter <= 'z') letter = (char)(letter - 'a' + 'A');
+        if (letter < 'A' || letter > 'Z') continue;
+
+        char digit = soundex_digit(letter);
+        if (length == 0) {
+            code[length++] = letter;
+        } else if (digit == 'h') {
+            continue;
+        } else if (digit != '0' && digit != last) {
+            code[length++] = digit;
+        }
+        last = digit;
+    }
+    if (length == 0) return false;
+
+    while (length < 4) code[length++] = '0';
+    code[4] = '\0';
+    return true;
+}
+
+static uint32_t soundex_key(const char* name) {
+    char code[5];
+    if (!fhir_soundex(name, code)) return 0;
+    return (uint32_t)(unsigned char)code[0] << 24 | (uint32_t)(unsigned char)code[1] << 16 |
+           (uint32_t)(unsigned char)code[2] << 8 | (uint32_t)(unsigned char)code[3];
+}
+
+// Uppercase ASCII letters (and digits), keep UTF-8 bytes, drop punctuation and spaces
+static size_t normalize(const char* text, bool keep_digits, char* out) {
+    size_t length = 0;
+    if (!text) return 0;
+
+    for (const unsigned char* p = (const unsigned char*)text; *p && length < MATCH_NORMALIZED_MAX; p++) {
+        unsigned char c = *p;
+        if (c >= 'a' && c <= 'z') {
+            out[length++] = (char)(c - 'a' + 'A');
+        } else if ((c >= 'A' && c <= 'Z') || c >= 0x80 || (keep_digits && c >= '0' && c <= '9')) {
+            out[length++] = (char)c;
+        }
+    }
+    return length;
+}
+
+static uint64_t hash_bytes(const char* data, size_t length, uint64_t seed) {
+    if (length == 0) return 0;
+    uint64_t hash = fhir_hash64(data, length, seed);
+    return hash ? hash : 1;
+}
+
+static uint64_t hash_normalized(const char* text, bool keep_digits, uint64_t seed) {
+    char buffer[MATCH_NORMALIZED_MAX];
+    return hash_bytes(buffer, normalize(text, keep_digits, buffer), seed);
+}
+
+// Postal codes compare without spaces, and US ZIP+4 as its five-digit ZIP
+static uint64_t hash_postal(const char* text) {
+    char buffer[MATCH_NORMALIZED_MAX];
+    size_t length = normalize(text, true, buffer);
+    if (length == 9 && strspn(buffer, "0123456789") >= 9) length = 5;
+    return hash_bytes(buffer, length, SEED_POSTAL);
+}
+
+static uint32_t parse_digits(const char* text, size_t count) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (text[i] < '0' || text[i] > '9') return UINT32_MAX;
+        value = value * 10 + (uint32_t)(text[i] - '0');
+    }
+    return value;
+}
+
+// YYYY, YYYY-MM or YYYY-MM-DD as YYYYMMDD; 0 when absent or malformed
+static uint32_t parse_birth(const char* text) {
+    if (!text) return 0;
+
+    size_t length = strlen(text);
+    uint32_t year = length >= 4 ? parse_digits(text, 4) : UINT32_MAX;
+    if (year == UINT32_MAX || year == 0) return 0;
+
+    uint32_t month = 0, day = 0;
+    if (length >= 7 && text[4] == '-') {
+        month = parse_digits(text + 5, 2);
+        if (month < 1 || month > 12) return 0;
+        if (length >= 10 && text[7] == '-') {
+            day = parse_digits(text + 8, 2);
+            if (day < 1 || day > 31) return 0;
+        }
+    }
+    return year * 10000 + month * 100 + day;
+}
+
+static uint32_t parse_gender(const char* text) {
+    if (!text) return 0;
+    if (strcmp(text, "male") == 0) return 1;
+    if (strcmp(text, "female") == 0) return 2;
+    if (strcmp(text, "other") == 0) return 3;
+    return 0;
+}
+
+static uint64_t make_key(uint64_t kind, uint64_t first, uint64_t second) {
+    uint64_t parts[2] = { first, second };
+    return fhir_hash64(parts, sizeof(parts), kind);
+}
+
+static void add_key(MatchEntry* entry, uint64_t key) {
+    for (uint32_t i = 0; i < entry->key_count; i++) {
+        if (entry->keys[i] == key) return;
+    }
+    entry->keys[entry->key_count++] = key;
+}
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+FHIRMatchIndex* fhir_match_index_create(void) {
+    return fhir_calloc(1, sizeof(FHIRMatchIndex));
+}
+
+void fhir_match_index_destroy(FHIRMatchIndex* index) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->count; i++) {
+        fhir_free(index->entries[i].id);
+    }
+    fhir_free(index->entries);
+    fhir_free(index);
+}
+
+size_t fhir_match_index_count(const FHIRMatchIndex* index) {
+    return index ? index->count : 0;
+}
+
+bool fhir_match_index_add(FHIRMatchIndex* index, const FHIRMatchRecord* record, size_t value) {
+    if (!index || !record || !record->id) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Expected a Patient with an id");
+        return false;
+    }
+
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 64;
+        MatchEntry* entries = fhir_realloc(index->entries, capacity * sizeof(MatchEntry));
+        if (!entries) return false;
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    MatchEntry* entry = &index->entries[index->count];
+    memset(entry, 0, sizeof(MatchEntry));
+    entry->id = fhir_strdup(record->id);
+    if (!entry->id) return false;
+
+    entry->value = value;
+    entry->family = hash_normalized(record->family, false, SEED_FAMILY);
+    entry->family_code = soundex_key(record->family);
+    entry->given = hash_normalized(record->given, false, SEED_GIVEN);
+    entry->given_code = soundex_key(record->given);
+    entry->birth = parse_birth(record->birth_date);
+    entry->gender = parse_gender(record->gender);
+    entry->postal = hash_postal(record->postal_code);
+    entry->line = hash_normalized(record->address_line, true, SEED_LINE);
+
+    size_t identifiers = 0;
+    for (size_t i = 0; i < record->identifier_count && i < FHIR_MATCH_MAX_IDENTIFIERS; i++) {
+        const char* identifier_value = record->identifier_value[i];
+        if (!identifier_value || !*identifier_value) continue;
+
+        const char* system = record->identifier_system[i];
+        if (system && !*system) system = NULL;
+        FHIRHasher hasher;
+        fhir_hasher_init(&hasher, SEED_IDENTIFIER);
+        fhir_hasher_string(&hasher, system);
+        fhir_hasher_string(&hasher, identifier_value);
+        entry->identifier[identifiers] = fhir_hasher_digest(&hasher) | 1;
+        entry->system[identifiers] = system ? hash_bytes(system, strlen(system), SEED_SYSTEM) : 0;
+        add_key(entry, make_key(KEY_IDENTIFIER, entry->identifier[identifiers], 0));
+        identifiers++;
+    }
+
+    // Names without an ASCII letter block on their exact hash instead of Soundex
+    uint64_t family = entry->family_code ? entry->family_code : entry->family;
+    uint64_t given = entry->given_code ? entry->given_code : entry->given;
+    if (family && entry->birth) add_key(entry, make_key(KEY_FAMILY_BIRTH, family, entry->birth));
+    if (family && entry->postal) add_key(entry, make_key(KEY_FAMILY_POSTAL, family, entry->postal));
+    if (entry->birth && entry->postal) add_key(entry, make_key(KEY_BIRTH_POSTAL, entry->birth, entry->postal));
+    if (family && given && entry->birth) {
+        add_key(entry, make_key(KEY_NAMES_YEAR, family ^ given << 1, entry->birth / 10000));
+    }
+
+    index->count++;
+    return true;
+}
+
+bool fhir_match_index_add_patient(FHIRMatchIndex* index, const FHIRPatient* patient, size_t value) {
+    if (!index || !patient) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRMatchRecord record;
+    memset(&record, 0, sizeof(record));
+    record.id = patient->base.id;
+    record.gender = fhir_patient_gender_to_string(patient->gender);
+    record.birth_date = patient->birth_date ? patient->birth_date->value : NULL;
+
+    size_t count;
+    FHIRHumanName* const* names = fhir_patient_get_names(patient, &count);
+    const FHIRHumanName* name = NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (!names[i]) continue;
+        if (!name) name = names[i];
+        if (names[i]->use && strcmp(names[i]->use, "official") == 0) {
+            name = names[i];
+            break;
+        }
+    }
+    if (name) {
+        record.family = name->family_count > 0 ? name->family[0] : NULL;
+        record.given = name->given_count > 0 ? name->given[0] : NULL;
+    }
+
+    FHIRAddress* const* addresses = fhir_patient_get_addresses(patient, &count);
+    if (count > 0 && addresses[0]) {
+        record.postal_code = addresses[0]->postal_code;
+        record.address_line = addresses[0]->line_count > 0 ? addresses[0]->line[0] : NULL;
+    }
+
+    FHIRIdentifier* const* identifiers = fhir_patient_get_identifiers(patient, &count);
+    for (size_t i = 0; i < count && record.identifier_count < FHIR_MATCH_MAX_IDENTIFIERS; i++) {
+        if (!identifiers[i] || !identifiers[i]->value) continue;
+        record.identifier_system[record.identifier_count] = identifiers[i]->system;
+        record.identifier_value[record.identifier_count++] = identifiers[i]->value;
+    }
+
+    return fhir_match_index_add(index, &record, value);
+}
+
+// First string of a member that is a string or an array of strings
+static const char* first_string(const cJSON* json, const char* key) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (cJSON_IsArray(item)) item = cJSON_GetArrayItem(item, 0);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+bool fhir_match_index_add_json(FHIRMatchIndex* index, const cJSON* json, size_t value) {
+    if (!index || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    const char* type = fhir_json_get_string(json, "resourceType");
+    if (!type || strcmp(type, "Patient") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Expected a Patient");
+        return false;
+    }
+
+    FHIRMatchRecord record;
+    memset(&record, 0, sizeof(record));
+    record.id = fhir_json_get_string(json, "id");
+    record.birth_date = fhir_json_get_string(json, "birthDate");
+    record.gender = fhir_json_get_string(json, "gender");
+
+    const cJSON* name = NULL;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(json, "name")) {
+        if (!cJSON_IsObject(item)) continue;
+        if (!name) name = item;
+        const char* use = fhir_json_get_string(item, "use");
+        if (use && strcmp(use, "official") == 0) {
+            name = item;
+            break;
+        }
+    }
+    if (name) {
+        record.family = first_string(name, "family");
+        record.given = first_string(name, "given");
+    }
+
+    const cJSON* address = cJSON_GetArrayItem(cJSON_GetObjectItemCaseSensitive(json, "address"), 0);
+    if (cJSON_IsObject(address)) {
+        record.postal_code = fhir_json_get_string(address, "postalCode");
+        record.address_line = first_string(address, "line");
+    }
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(json, "identifier")) {
+        if (record.identifier_count == FHIR_MATCH_MAX_IDENTIFIERS) break;
+        const char* identifier_value = cJSON_IsObject(item) ? fhir_json_get_string(item, "value") : NULL;
+        if (!identifier_value) continue;
+        record.identifier_system[record.identifier_count] = fhir_json_get_string(item, "system");
+        record.identifier_value[record.identifier_count++] = identifier_value;
+    }
+
+    return fhir_match_index_add(index, &record, value);
+}
+
+const char* fhir_match_index_get_id(const FHIRMatchIndex* index, size_t entry) {
+    return index && entry < index->count ? index->entries[entry].id : NULL;
+}
+
+size_t fhir_match_index_get_value(const FHIRMatchIndex* index, size_t entry) {
+    return index && entry < index->count ? index->entries[entry].value : 0;
+}
+
+/* ========================================================================== */
+/* Scoring                                                                    */
+/* ========================================================================== */
+
+static inline float score_name(uint64_t a, uint32_t a_code, uint64_t b, uint32_t b_code,
+                               float exact, float phonetic, float different) {
+    if (!a || !b) return 0.0f;
+    return a == b ? exact : a_code && a_code == b_code ? phonetic : different;
+}
+
+static inline float score_birth(uint32_t a, uint32_t b) {
+    if (!a || !b) return 0.0f;
+    if (a == b) return WEIGHT_BIRTH_EXACT;
+    if (a / 10000 != b / 10000) return WEIGHT_BIRTH_DIFFERENT;
+
+    uint32_t a_month = a / 100 % 100, a_day = a % 100;
+    uint32_t b_month = b / 100 % 100, b_day = b % 100;
+    if (!a_month || !b_month || (a_month == b_month && (!a_day || !b_day))) return WEIGHT_BIRTH_PARTIAL;
+    if (a_month == b_day && a_day == b_month) return WEIGHT_BIRTH_TRANSPOSED;
+    return a_month == b_month ? WEIGHT_BIRTH_PARTIAL : WEIGHT_BIRTH_DIFFERENT;
+}
+
+static inline float score_value(uint64_t a, uint64_t b, float same, float different) {
+    if (!a || !b) return 0.0f;
+    return a == b ? same : different;
+}
+
+static inline float score_identifiers(const uint64_t* a_values, const uint64_t* a_systems,
+                                      const uint64_t* b_values, const uint64_t* b_systems) {
+    bool same = false, conflict = false;
+    for (size_t i = 0; i < FHIR_MATCH_MAX_IDENTIFIERS; i++) {
+        for (size_t j = 0; j < FHIR_MATCH_MAX_IDENTIFIERS; j++) {
+            bool present = a_values[i] && b_values[j];
+            same |= present && a_values[i] == b_values[j];
+            conflict |= present && a_systems[i] && a_systems[i] == b_systems[j] && a_values[i] != b_values[j];
+        }
+    }
+    return same ? WEIGHT_IDENTIFIER_SAME : conflict ? WEIGHT_IDENTIFIER_CONFLICT : 0.0f;
+}
+
+static float score_entries(const MatchEntry* a, const MatchEntry* b) {
+    return score_name(a->family, a->family_code, b->family, b->family_code,
+                      WEIGHT_FAMILY_EXACT, WEIGHT_FAMILY_PHONETIC, WEIGHT_FAMILY_DIFFERENT) +
+           score_name(a->given, a->given_code, b->given, b->given_code,
+                      WEIGHT_GIVEN_EXACT, WEIGHT_GIVEN_PHONETIC, WEIGHT_GIVEN_DIFFERENT) +
+           score_birth(a->birth, b->birth) +
+           score_value(a->gender, b->gender, WEIGHT_GENDER_SAME, WEIGHT_GENDER_DIFFERENT) +
+           score_value(a->postal, b->postal, WEIGHT_POSTAL_SAME, WEIGHT_POSTAL_DIFFERENT) +
+           score_value(a->line, b->line, WEIGHT_LINE_SAME, 0.0f) +
+           score_identifiers(a->identifier, a->system, b->identifier, b->system);
+}
+
+double fhir_match_index_score(const FHIRMatchIndex* index, size_t a, size_t b) {
+    if (!index || a >= index->count || b >= index->count) return 0.0;
+    return score_entries(&index->entries[a], &index->entries[b]);
+}
+
+// Features of a block's members gathered into columns, so a row of scores
+// is one pass over contiguous arrays the compiler can vectorize
+typedef struct {
+    uint64_t* family;
+    uint64_t* given;
+    uint64_t* postal;
+    uint64_t* line;
+    uint64_t* identifier;        // FHIR_MATCH_MAX_IDENTIFIERS per member
+    uint64_t* system;
+    uint32_t* family_code;
+    uint32_t* given_code;
+    uint32_t* birth;
+    uint32_t* gender;
+    float* scores;
+    size_t capacity;
+    void* memory;
+} BlockColumns;
+
+static bool reserve_columns(BlockColumns* columns, size_t count) {
+    if (columns->capacity >= count) return true;
+
+    size_t capacity = columns->capacity ? columns->capacity : 64;
+    while (capacity < count) capacity *= 2;
+
+    size_t wide = 4 + 2 * FHIR_MATCH_MAX_IDENTIFIERS;
+    void* memory = fhir_malloc(capacity * (wide * sizeof(uint64_t) + 4 * sizeof(uint32_t) + sizeof(float)));
+    if (!memory) return false;
+    fhir_free(columns->memory);
+    columns->memory = memory;
+    columns->capacity = capacity;
+
+    uint64_t* words = memory;
+    columns->family = words;
+    columns->given = words + capacity;
+    columns->postal = words + 2 * capacity;
+    columns->line = words + 3 * capacity;
+    columns->identifier = words + 4 * capacity;
+    columns->system = columns->identifier + FHIR_MATCH_MAX_IDENTIFIERS * capacity;
+    uint32_t* halves = (uint32_t*)(words + wide * capacity);
+    columns->family_code = halves;
+    columns->given_code = halves + capacity;
+    columns->birth = halves + 2 * capacity;
+    columns->gender = halves + 3 * capacity;
+    columns->scores = (float*)(halves + 4 * capacity);
+    return true;
+}
+
+static void gather_member(BlockColumns* columns, size_t member, const MatchEntry* entry) {
+    columns->family[member] = entry->family;
+    columns->given[member] = entry->given;
+    columns->postal[member] = entry->postal;
+    columns->line[member] = entry->line;
+    memcpy(columns->identifier + member * FHIR_MATCH_MAX_IDENTIFIERS, entry->identifier, sizeof(entry->identifier));
+    memcpy(columns->system + member * FHIR_MATCH_MAX_IDENTIFIERS, entry->system, sizeof(entry->system));
+    columns->family_code[member] = entry->family_code;
+    columns->given_code[member] = entry->given_code;
+    columns->birth[member] = entry->birth;
+    columns->gender[member] = entry->gender;
+}
+
+// Score member i against members i + 1 .. count - 1 into columns->scores
+static void score_row(const BlockColumns* c, size_t i, size_t count) {
+    const uint64_t family = c->family[i], given = c->given[i], postal = c->postal[i], line = c->line[i];
+    const uint32_t family_code = c->family_code[i], given_code = c->given_code[i];
+    const uint32_t birth = c->birth[i], gender = c->gender[i];
+    const uint64_t* identifier = c->identifier + i * FHIR_MATCH_MAX_IDENTIFIERS;
+    const uint64_t* system = c->system + i * FHIR_MATCH_MAX_IDENTIFIERS;
+
+    for (size_t j = i + 1; j < count; j++) {
+        c->scores[j] = score_name(family, family_code, c->family[j], c->family_code[j],
+                                  WEIGHT_FAMILY_EXACT, WEIGHT_FAMILY_PHONETIC, WEIGHT_FAMILY_DIFFERENT) +
+                       score_name(given, given_code, c->given[j], c->given_code[j],
+                                  WEIGHT_GIVEN_EXACT, WEIGHT_GIVEN_PHONETIC, WEIGHT_GIVEN_DIFFERENT) +
+                       score_birth(birth, c->birth[j]) +
+                       score_value(gender, c->gender[j], WEIGHT_GENDER_SAME, WEIGHT_GENDER_DIFFERENT) +
+                       score_value(postal, c->postal[j], WEIGHT_POSTAL_SAME, WEIGHT_POSTAL_DIFFERENT) +
+                       score_value(line, c->line[j], WEIGHT_LINE_SAME, 0.0f) +
+                       score_identifiers(identifier, system, c->identifier + j * FHIR_MATCH_MAX_IDENTIFIERS,
+                                         c->system + j * FHIR_MATCH_MAX_IDENTIFIERS);
+    }
+}
+
+/* ========================================================================== */
+/* Pair Search                                                                */
+/* ========================================================================== */
+
+typedef struct {
+    uint64_t key;
+    size_t entry;
+} MatchPosting;
+
+typedef struct {
+    size_t start;                // First posting of the block
+    size_t count;
+} MatchBlock;
+
+typedef struct {
+    const FHIRMatchIndex* index;
+    const MatchPosting* postings;
+    const MatchBlock* blocks;
+    size_t block_count;
+    const uint16_t* scored;      // Per entry: bit k set when keys[k] names a scored block
+    float threshold;
+
+    pthread_mutex_t mutex;
+    size_t next_block;
+    bool failed;
+} MatchSearch;
+
+typedef struct {
+    MatchSearch* search;
+    FHIRMatchResult result;
+    size_t comparisons;
+    BlockColumns columns;
+    pthread_t thread;
+} MatchWorker;
+
+void fhir_match_options_init(FHIRMatchOptions* options) {
+    if (!options) return;
+
+    memset(options, 0, sizeof(FHIRMatchOptions));
+    options->threshold = FHIR_MATCH_DEFAULT_THRESHOLD;
+    options->max_block_size = FHIR_MATCH_DEFAULT_MAX_BLOCK_SIZE;
+}
+
+void fhir_match_result_init(FHIRMatchResult* result) {
+    if (!result) return;
+    memset(result, 0, sizeof(FHIRMatchResult));
+}
+
+void fhir_match_result_cleanup(FHIRMatchResult* result) {
+    if (!result) return;
+    fhir_free(result->items);
+    memset(result, 0, sizeof(FHIRMatchResult));
+}
+
+static bool result_append(FHIRMatchResult* result, size_t a, size_t b, double score) {
+    if (result->count == result->capacity) {
+        size_t capacity = result->capacity ? result->capacity * 2 : 64;
+        FHIRMatchPair* items = fhir_realloc(result->items, capacity * sizeof(FHIRMatchPair));
+        if (!items) return false;
+        result->items = items;
+        result->capacity = capacity;
+    }
+    result->items[result->count++] = (FHIRMatchPair){ a, b, score };
+    return true;
+}
+
+// Stable LSD radix sort on the key, one byte per pass; returns the sorted array
+static MatchPosting* sort_postings(MatchPosting* postings, MatchPosting* scratch, size_t count) {
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = {0};
+        for (size_t i = 0; i < count; i++) {
+            offsets[(postings[i].key >> shift) & 0xff]++;
+        }
+        // A byte shared by every key leaves the order as it is
+        if (count > 0 && offsets[(postings[0].key >> shift) & 0xff] == count) continue;
+
+        size_t total = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t digit_count = offsets[digit];
+            offsets[digit] = total;
+            total += digit_count;
+        }
+        for (size_t i = 0; i < count; i++) {
+            scratch[offsets[(postings[i].key >> shift) & 0xff]++] = postings[i];
+        }
+
+        MatchPosting* swap = postings;
+        postings = scratch;
+        scratch = swap;
+    }
+    return postings;
+}
+
+// A pair sharing several scored blocks is reported by the one with the smallest key
+static bool first_shared_block(const MatchSearch* search, size_t a, size_t b, uint64_t key) {
+    const MatchEntry* first = &search->index->entries[a];
+    const MatchEntry* second = &search->index->entries[b];
+
+    for (uint32_t i = 0; i < first->key_count; i++) {
+        if (!(search->scored[a] >> i & 1) || first->keys[i] >= key) continue;
+        for (uint32_t j = 0; j < second->key_count; j++) {
+            if ((search->scored[b] >> j & 1) && second->keys[j] == first->keys[i]) return false;
+        }
+    }
+    return true;
+}
+
+static bool score_block(MatchWorker* worker, const MatchBlock* block) {
+    const MatchSearch* search = worker->search;
+    const MatchPosting* members = search->postings + block->start;
+    size_t count = block->count;
+
+    if (!reserve_columns(&worker->columns, count)) return false;
+    for (size_t m = 0; m < count; m++) {
+        gather_member(&worker->columns, m, &search->index->entries[members[m].entry]);
+    }
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        score_row(&worker->columns, i, count);
+        worker->comparisons += count - i - 1;
+
+        for (size_t j = i + 1; j < count; j++) {
+            float score = worker->columns.scores[j];
+            if (score < search->threshold) continue;
+
+            // Members are in entry order, so a < b
+            size_t a = members[i].entry, b = members[j].entry;
+            if (!first_shared_block(search, a, b, members[i].key)) continue;
+            if (!result_append(&worker->result, a, b, score)) return false;
+        }
+    }
+    return true;
+}
+
+static void run_worker(MatchWorker* worker) {
+    MatchSearch* search = worker->search;
+
+    for (;;) {
+        pthread_mutex_lock(&search->mutex);
+        size_t begin = search->next_block;
+        size_t end = begin + MATCH_CLAIM_BLOCKS;
+        if (end > search->block_count) end = search->block_count;
+        search->next_block = end;
+        bool stop = search->failed;
+        pthread_mutex_unlock(&search->mutex);
+
+        if (stop || begin >= end) return;
+
+        for (size_t i = begin; i < end; i++) {
+            if (!score_block(worker, &search->blocks[i])) {
+                pthread_mutex_lock(&search->mutex);
+                search->failed = true;
+                pthread_mutex_unlock(&search->mutex);
+                return;
+            }
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    run_worker(arg);
+
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+static int compare_pairs(const void* left, const void* right) {
+    const FHIRMatchPair* a = left;
+    const FHIRMatchPair* b = right;
+    if (a->a != b->a) return a->a < b->a ? -1 : 1;
+    if (a->b != b->b) return a->b < b->b ? -1 : 1;
+    return 0;
+}
+
+// Group postings into blocks of equal keys and mark the keys of scored blocks
+static MatchBlock* build_blocks(const FHIRMatchIndex* index, const MatchPosting* postings, size_t count,
+                                size_t max_block_size, uint16_t* scored, size_t* block_count,
+                                FHIRMatchStats* stats) {
+    MatchBlock* blocks = fhir_malloc((count / 2 + 1) * sizeof(MatchBlock));
+    if (!blocks) return NULL;
+
+    *block_count = 0;
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+        while (end < count && postings[end].key == postings[start].key) end++;
+
+        size_t size = end - start;
+        if (size > max_block_size) {
+            stats->skipped_blocks++;
+        } else if (size >= 2) {
+            blocks[(*block_count)++] = (MatchBlock){ start, size };
+            for (size_t p = start; p < end; p++) {
+                const MatchEntry* entry = &index->entries[postings[p].entry];
+                for (uint32_t k = 0; k < entry->key_count; k++) {
+                    if (entry->keys[k] == postings[p].key) scored[postings[p].entry] |= (uint16_t)(1u << k);
+                }
+            }
+        }
+        start = end;
+    }
+    stats->blocks = *block_count;
+    return blocks;
+}
+
+bool fhir_match_index_find_pairs(const FHIRMatchIndex* index, const FHIRMatchOptions* options,
+                                 FHIRMatchResult* result, FHIRMatchStats* stats) {
+    if (!index || !result) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRMatchOptions defaults;
+    if (!options) {
+        fhir_match_options_init(&defaults);
+        options = &defaults;
+    }
+    size_t max_block_size = options->max_block_size ? options->max_block_size : FHIR_MATCH_DEFAULT_MAX_BLOCK_SIZE;
+    size_t thread_count = options->thread_count;
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    FHIRMatchStats counters;
+    memset(&counters, 0, sizeof(counters));
+    result->count = 0;
+
+    size_t posting_count = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        posting_count += index->entries[i].key_count;
+    }
+
+    MatchPosting* postings = fhir_malloc((posting_count + 1) * sizeof(MatchPosting));
+    MatchPosting* scratch = fhir_malloc((posting_count + 1) * sizeof(MatchPosting));
+    uint16_t* scored = fhir_calloc(index->count + 1, sizeof(uint16_t));
+    MatchBlock* blocks = NULL;
+    MatchWorker* workers = NULL;
+    size_t block_count = 0;
+    size_t worker_count = 0;
+    bool ok = false;
+
+    MatchSearch search;
+    memset(&search, 0, sizeof(search));
+    pthread_mutex_init(&search.mutex, NULL);
+
+    if (!postings || !scratch || !scored) goto cleanup;
+
+    size_t p = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        for (uint32_t k = 0; k < index->entries[i].key_count; k++) {
+            postings[p++] = (MatchPosting){ index->entries[i].keys[k], i };
+        }
+    }
+    MatchPosting* sorted = sort_postings(postings, scratch, posting_count);
+
+    blocks = build_blocks(index, sorted, posting_count, max_block_size, scored, &block_count, &counters);
+    if (!blocks) goto cleanup;
+
+    search.index = index;
+    search.postings = sorted;
+    search.blocks = blocks;
+    search.block_count = block_count;
+    search.scored = scored;
+    search.threshold = (float)options->threshold;
+
+    worker_count = thread_count < block_count ? thread_count : block_count;
+    if (worker_count == 0) worker_count = 1;
+    workers = fhir_calloc(worker_count, sizeof(MatchWorker));
+    if (!workers) {
+        worker_count = 0;
+        goto cleanup;
+    }
+
+    size_t started = 0;
+    for (size_t w = 0; w < worker_count; w++) {
+        workers[w].search = &search;
+    }
+    for (size_t w = 1; w < worker_count; w++) {
+        if (pthread_create(&workers[w].thread, NULL, worker_main, &workers[w]) != 0) break;
+        started++;
+    }
+    // The calling thread works too
+    run_worker(&workers[0]);
+    for (size_t w = 1; w <= started; w++) {
+        pthread_join(workers[w].thread, NULL);
+    }
+    if (search.failed) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Out of memory");
+        goto cleanup;
+    }
+
+    size_t total = 0;
+    for (size_t w = 0; w < worker_count; w++) {
+        total += workers[w].result.count;
+        counters.comparisons += workers[w].comparisons;
+    }
+    if (total > result->capacity) {
+        FHIRMatchPair* items = fhir_realloc(result->items, total * sizeof(FHIRMatchPair));
+        if (!items) goto cleanup;
+        result->items = items;
+        result->capacity = total;
+    }
+    for (size_t w = 0; w < worker_count; w++) {
+        if (workers[w].result.count == 0) continue;
+        memcpy(result->items + result->count, workers[w].result.items,
+               workers[w].result.count * sizeof(FHIRMatchPair));
+        result->count += workers[w].result.count;
+    }
+    if (result->count > 1) {
+        qsort(result->items, result->count, sizeof(FHIRMatchPair), compare_pairs);
+    }
+    ok = true;
+
+cleanup:
+    for (size_t w = 0; w < worker_count; w++) {
+        fhir_match_result_cleanup(&workers[w].result);
+        fhir_free(workers[w].columns.memory);
+    }
+    fhir_free(workers);
+    fhir_free(blocks);
+    fhir_free(scored);
+    fhir_free(scratch);
+    fhir_free(postings);
+    pthread_mutex_destroy(&search.mutex);
+
+    if (stats) *stats = counters;
+    return ok;
+}
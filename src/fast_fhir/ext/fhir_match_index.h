@@ -0,0 +1,237 @@
+/**
+ * @file fhir_match_index.h
+ * @brief Blocking index and pairwise scoring for Patient deduplication
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Master patient index matching compares Patients that share a blocking
+ * key instead of all pairs. Each Patient added to the index is reduced to
+ * hashed, normalized features (family and given name with their Soundex
+ * codes, birth date, gender, postal code, first address line and up to
+ * FHIR_MATCH_MAX_IDENTIFIERS identifiers) and to a handful of keys:
+ *
+ * - identifier system and value
+ * - family-name Soundex and birth date
+ * - family-name Soundex and postal code
+ * - birth date and postal code (catches changed surnames)
+ * - family and given Soundex and birth year (catches birth date typos)
+ *
+ * fhir_match_index_find_pairs sorts the keys into blocks and scores every
+ * pair inside a block with field agreement weights, block by block on a
+ * worker pool. Blocks larger than max_block_size (a shared placeholder
+ * identifier, a very common name in one town) are skipped, so the work
+ * grows with the number of Patients rather than its square. A pair found
+ * in several blocks is reported once.
+ */
+
+#ifndef FHIR_MATCH_INDEX_H
+#define FHIR_MATCH_INDEX_H
+
+#include "common/fhir_common.h"
+#include "resources/fhir_patient.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Identifiers kept per Patient; further identifiers are ignored */
+#define FHIR_MATCH_MAX_IDENTIFIERS 4
+
+/** Default minimum score of a reported pair */
+#define FHIR_MATCH_DEFAULT_THRESHOLD 8.0
+
+/** Default largest block that is scored */
+#define FHIR_MATCH_DEFAULT_MAX_BLOCK_SIZE 1000
+
+/**
+ * @brief Matching fields of one Patient
+ *
+ * All strings are borrowed for the duration of fhir_match_index_add.
+ */
+typedef struct {
+    const char* id;
+    const char* family;
+    const char* given;                                          /**< First given name */
+    const char* birth_date;                                     /**< YYYY, YYYY-MM or YYYY-MM-DD */
+    const char* gender;                                         /**< male, female, other or unknown */
+    const char* postal_code;
+    const char* address_line;                                   /**< First address line */
+    const char* identifier_system[FHIR_MATCH_MAX_IDENTIFIERS];
+    const char* identifier_value[FHIR_MATCH_MAX_IDENTIFIERS];
+    size_t identifier_count;
+} FHIRMatchRecord;
+
+/**
+ * @brief Pair search options
+ */
+typedef struct {
+    double threshold;            /**< Minimum score of a reported pair */
+    size_t max_block_size;       /**< Larger blocks are skipped (0 = default) */
+    size_t thread_count;         /**< Scoring threads (0 = number of online CPUs) */
+} FHIRMatchOptions;
+
+/**
+ * @brief Candidate duplicate pair
+ */
+typedef struct {
+    size_t a;                    /**< Entry index, a < b */
+    size_t b;
+    double score;
+} FHIRMatchPair;
+
+/**
+ * @brief Pairs of a search, ordered by a then b
+ */
+typedef struct {
+    FHIRMatchPair* items;
+    size_t count;
+    size_t capacity;
+} FHIRMatchResult;
+
+/**
+ * @brief Work done by a pair search
+ */
+typedef struct {
+    size_t blocks;               /**< Blocks with at least two Patients that were scored */
+    size_t skipped_blocks;       /**< Blocks over max_block_size */
+    size_t comparisons;          /**< Pairs scored, counting repeats across blocks */
+} FHIRMatchStats;
+
+/**
+ * @brief Patient matching index (opaque)
+ */
+typedef struct FHIRMatchIndex FHIRMatchIndex;
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty index
+ * @return New index or NULL on allocation failure
+ */
+FHIRMatchIndex* fhir_match_index_create(void);
+
+/**
+ * @brief Destroy an index and the ids it owns
+ * @param index Index to destroy (can be NULL)
+ */
+void fhir_match_index_destroy(FHIRMatchIndex* index);
+
+/**
+ * @brief Get the number of indexed Patients
+ * @param index Index to query
+ * @return Entry count
+ */
+size_t fhir_match_index_count(const FHIRMatchIndex* index);
+
+/**
+ * @brief Add a Patient from its matching fields
+ * @param index Index to update
+ * @param record Matching fields; id is copied and must not be NULL
+ * @param value Caller value stored in the entry
+ * @return true on success, false on allocation failure or a missing id
+ */
+bool fhir_match_index_add(FHIRMatchIndex* index, const FHIRMatchRecord* record, size_t value);
+
+/**
+ * @brief Add a parsed Patient (its official or first name, first address)
+ * @param index Index to update
+ * @param patient Patient with an id
+ * @param value Caller value stored in the entry
+ * @return true on success, false on failure
+ */
+bool fhir_match_index_add_patient(FHIRMatchIndex* index, const FHIRPatient* patient, size_t value);
+
+/**
+ * @brief Add a Patient JSON tree
+ * @param index Index to update
+ * @param json Patient JSON with an id
+ * @param value Caller value stored in the entry
+ * @return true on success, false on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         for other resources)
+ */
+bool fhir_match_index_add_json(FHIRMatchIndex* index, const cJSON* json, size_t value);
+
+/**
+ * @brief Get the id of an entry
+ * @param index Index to query
+ * @param entry Entry index
+ * @return Patient id or NULL when out of range
+ */
+const char* fhir_match_index_get_id(const FHIRMatchIndex* index, size_t entry);
+
+/**
+ * @brief Get the caller value of an entry
+ * @param index Index to query
+ * @param entry Entry index
+ * @return Value given to the add call, 0 when out of range
+ */
+size_t fhir_match_index_get_value(const FHIRMatchIndex* index, size_t entry);
+
+/* ========================================================================== */
+/* Matching                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize options with defaults
+ * @param options Options to initialize
+ */
+void fhir_match_options_init(FHIRMatchOptions* options);
+
+/**
+ * @brief Initialize an empty result
+ * @param result Result to initialize
+ */
+void fhir_match_result_init(FHIRMatchResult* result);
+
+/**
+ * @brief Free the buffer of a result
+ * @param result Result to clean up (can be NULL)
+ */
+void fhir_match_result_cleanup(FHIRMatchResult* result);
+
+/**
+ * @brief Score the pairs of every block and collect those over the threshold
+ *
+ * The index must not change during the search.
+ *
+ * @param index Index to search
+ * @param options Options (NULL for defaults)
+ * @param result Output pairs, replacing its contents
+ * @param stats Output work counters (can be NULL)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_match_index_find_pairs(const FHIRMatchIndex* index, const FHIRMatchOptions* options,
+                                 FHIRMatchResult* result, FHIRMatchStats* stats);
+
+/**
+ * @brief Score one pair of entries with the weights of the block pass
+ * @param index Index to query
+ * @param a First entry
+ * @param b Second entry
+ * @return Score (positive for agreement), 0 when an entry is out of range
+ */
+double fhir_match_index_score(const FHIRMatchIndex* index, size_t a, size_t b);
+
+/**
+ * @brief American Soundex code of a name
+ * @param name Name; characters other than ASCII letters are skipped
+ * @param code Output letter and three digits, NUL-terminated
+ * @return false (and an empty code) when name has no ASCII letter
+ */
+bool fhir_soundex(const char* name, char code[5]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_MATCH_INDEX_H */
@@ -0,0 +1,372 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_json.h"
+#include "fhir_match_index.h"
+#include "fhir_ndjson.h"
+#include "common/fhir_json_reader.h"
+#include "resources/fhir_patient.h"
+
+// Python wrapper for the Patient matching blocking index
+
+typedef struct {
+    PyObject_HEAD
+    FHIRMatchIndex* index;
+    FHIRMatchOptions options;
+    FHIRMatchStats stats;      // Work of the last pairs() call
+    int busy;                  // Held while the index is used without the GIL
+} MatchIndex;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* match_index_type;
+} MatchModuleState;
+
+// Raise the last C error: MemoryError when out of memory, ValueError otherwise
+static PyObject* set_match_error(const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+    // Failed allocations leave no error set
+    if (!error || error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+        return PyErr_NoMemory();
+    }
+    PyErr_SetString(PyExc_ValueError, error->message ? error->message : fallback);
+    return NULL;
+}
+
+static int MatchIndex_init(MatchIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"threshold", "max_block_size", NULL};
+    double threshold = FHIR_MATCH_DEFAULT_THRESHOLD;
+    Py_ssize_t max_block_size = FHIR_MATCH_DEFAULT_MAX_BLOCK_SIZE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|dn", kwlist, &threshold, &max_block_size)) {
+        return -1;
+    }
+    if (max_block_size < 2) {
+        PyErr_SetString(PyExc_ValueError, "max_block_size must be at least 2");
+        return -1;
+    }
+    if (self->index) {
+        PyErr_SetString(PyExc_RuntimeError, "MatchIndex is already initialized");
+        return -1;
+    }
+
+    self->index = fhir_match_index_create();
+    if (!self->index) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    fhir_match_options_init(&self->options);
+    self->options.threshold = threshold;
+    self->options.max_block_size = (size_t)max_block_size;
+    return 0;
+}
+
+static void MatchIndex_dealloc(MatchIndex* self) {
+    fhir_match_index_destroy(self->index);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+// Claim the index for a call that may release the GIL; false with an exception set
+static bool MatchIndex_claim(MatchIndex* self) {
+    if (!self->index) {
+        PyErr_SetString(PyExc_RuntimeError, "MatchIndex is not initialized");
+        return false;
+    }
+    int busy;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    busy = self->busy;
+    self->busy = 1;
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (busy) {
+        PyErr_SetString(PyExc_RuntimeError, "MatchIndex is already in use by another thread");
+        return false;
+    }
+    return true;
+}
+
+static void MatchIndex_release(MatchIndex* self) {
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    self->busy = 0;
+    FHIR_PY_END_CRITICAL_SECTION();
+}
+
+// Add a Patient (JSON text, or an object with to_json() such as an NDJSON Resource)
+// and return its entry number
+static PyObject* MatchIndex_add(MatchIndex* self, PyObject* arg) {
+    PyObject* text;
+    if (PyUnicode_Check(arg) || PyObject_CheckBuffer(arg)) {
+        Py_INCREF(arg);
+        text = arg;
+    } else {
+        text = PyObject_CallMethod(arg, "to_json", NULL);
+        if (!text) {
+            return NULL;
+        }
+    }
+
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(text, &view)) {
+        Py_DECREF(text);
+        return NULL;
+    }
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    PyBuffer_Release(&view);
+    Py_DECREF(text);
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!MatchIndex_claim(self)) {
+        cJSON_Delete(json);
+        return NULL;
+    }
+
+    size_t entry = fhir_match_index_count(self->index);
+    bool added = fhir_match_index_add_json(self->index, json, entry);
+    MatchIndex_release(self);
+    cJSON_Delete(json);
+
+    if (!added) {
+        return set_match_error("Expected a Patient with an id");
+    }
+    return PyLong_FromSize_t(entry);
+}
+
+// Add the Patients of an NDJSON batch in line order (runs without the GIL)
+static bool batch_to_index(FHIRMatchIndex* index, const FHIRNDJSONResult* results, size_t count,
+                           size_t first_entry, size_t* added) {
+    for (size_t i = 0; i < count; i++) {
+        const FHIRNDJSONResult* result = &results[i];
+        if (result->error_code != FHIR_ERROR_NONE || !result->resource ||
+            result->resource_type != FHIR_RESOURCE_TYPE_PATIENT || !result->resource->id) {
+            continue;
+        }
+        if (!fhir_match_index_add_patient(index, (const FHIRPatient*)result->resource,
+                                          first_entry + result->line_number - 1)) {
+            return false;
+        }
+        (*added)++;
+    }
+    return true;
+}
+
+// Parse NDJSON on the C reader's worker pool and add every Patient; returns the number added
+static PyObject* MatchIndex_add_ndjson(MatchIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "threads", "batch_size", NULL};
+    PyObject* source;
+    Py_ssize_t threads = 0;
+    Py_ssize_t batch_size = FHIR_NDJSON_DEFAULT_BATCH_SIZE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|nn", kwlist, &source, &threads, &batch_size)) {
+        return NULL;
+    }
+    if (threads < 0 || batch_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0 and batch_size > 0");
+        return NULL;
+    }
+
+    Py_buffer view;
+    PyObject* path = NULL;
+    if (PyObject_CheckBuffer(source)) {
+        // In-memory NDJSON (bytes, bytearray, mmap, ...)
+        if (PyObject_GetBuffer(source, &view, PyBUF_SIMPLE) < 0) {
+            return NULL;
+        }
+    } else if (!PyUnicode_FSConverter(source, &path)) {
+        return NULL;
+    }
+    if (!MatchIndex_claim(self)) {
+        if (path) {
+            Py_DECREF(path);
+        } else {
+            PyBuffer_Release(&view);
+        }
+        return NULL;
+    }
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = (size_t)threads;
+    options.batch_size = (size_t)batch_size;
+
+    // Entries continue from the current size, one per line
+    size_t first_entry = fhir_match_index_count(self->index);
+    size_t added = 0;
+    bool opened;
+    bool ok = true;
+    FHIRErrorCode open_error = FHIR_ERROR_NONE;
+
+    Py_BEGIN_ALLOW_THREADS
+    FHIRNDJSONReader* reader = path ? fhir_ndjson_open(PyBytes_AS_STRING(path), &options)
+                                    : fhir_ndjson_open_buffer(view.buf, (size_t)view.len, &options);
+    opened = reader != NULL;
+    if (!opened) {
+        const FHIRError* error = fhir_get_last_error();
+        open_error = error ? error->code : FHIR_ERROR_OUT_OF_MEMORY;
+    }
+    FHIRNDJSONResult* results;
+    size_t count;
+    while (ok && opened && (results = fhir_ndjson_next_batch(reader, &count))) {
+        ok = batch_to_index(self->index, results, count, first_entry, &added);
+    }
+    ok = ok && opened && !fhir_ndjson_failed(reader);
+    fhir_ndjson_close(reader);
+    Py_END_ALLOW_THREADS
+    MatchIndex_release(self);
+
+    if (path) {
+        Py_DECREF(path);
+    } else {
+        PyBuffer_Release(&view);
+    }
+    if (!opened && open_error == FHIR_ERROR_IO) {
+        return PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, source);
+    }
+    if (!ok) {
+        return set_match_error("Failed to read NDJSON input");
+    }
+    return PyLong_FromSize_t(added);
+}
+
+// Score every block and return [(id_a, id_b, score)], ordered by entry
+static PyObject* MatchIndex_pairs(MatchIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"threads", NULL};
+    Py_ssize_t threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n", kwlist, &threads)) {
+        return NULL;
+    }
+    if (threads < 0) {
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0");
+        return NULL;
+    }
+    if (!MatchIndex_claim(self)) {
+        return NULL;
+    }
+
+    FHIRMatchOptions options = self->options;
+    options.thread_count = (size_t)threads;
+    FHIRMatchResult result;
+    fhir_match_result_init(&result);
+    bool ok;
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = fhir_match_index_find_pairs(self->index, &options, &result, &self->stats);
+    Py_END_ALLOW_THREADS
+    MatchIndex_release(self);
+
+    if (!ok) {
+        fhir_match_result_cleanup(&result);
+        return set_match_error("Failed to match Patients");
+    }
+
+    PyObject* list = PyList_New((Py_ssize_t)result.count);
+    for (size_t i = 0; list && i < result.count; i++) {
+        const FHIRMatchPair* pair = &result.items[i];
+        PyObject* item = Py_BuildValue("(ssd)", fhir_match_index_get_id(self->index, pair->a),
+                                       fhir_match_index_get_id(self->index, pair->b), pair->score);
+        if (!item) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+    fhir_match_result_cleanup(&result);
+    return list;
+}
+
+static PyObject* MatchIndex_stats(MatchIndex* self, PyObject* Py_UNUSED(ignored)) {
+    return Py_BuildValue("{s:n,s:n,s:n}",
+                         "blocks", (Py_ssize_t)self->stats.blocks,
+                         "skipped_blocks", (Py_ssize_t)self->stats.skipped_blocks,
+                         "comparisons", (Py_ssize_t)self->stats.comparisons);
+}
+
+static Py_ssize_t MatchIndex_length(MatchIndex* self) {
+    return (Py_ssize_t)fhir_match_index_count(self->index);
+}
+
+static PyMethodDef MatchIndexMethods[] = {
+    {"add", (PyCFunction)MatchIndex_add, METH_O,
+     "Add a Patient (JSON, or an object with to_json()); returns its entry number"},
+    {"add_ndjson", (PyCFunction)MatchIndex_add_ndjson, METH_VARARGS | METH_KEYWORDS,
+     "add_ndjson(source, threads=0, batch_size=4096): add the Patients of an NDJSON file or buffer; "
+     "returns the number added"},
+    {"pairs", (PyCFunction)MatchIndex_pairs, METH_VARARGS | METH_KEYWORDS,
+     "Candidate duplicates as (id_a, id_b, score) tuples"},
+    {"stats", (PyCFunction)MatchIndex_stats, METH_NOARGS, "Blocks and comparisons of the last pairs() call"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot MatchIndexSlots[] = {
+    {Py_tp_doc, "Patient matching blocking index for master patient index deduplication"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, MatchIndex_init},
+    {Py_tp_dealloc, MatchIndex_dealloc},
+    {Py_tp_methods, MatchIndexMethods},
+    {Py_sq_length, MatchIndex_length},
+    {0, NULL}
+};
+
+static PyType_Spec MatchIndexSpec = {
+    .name = "fhir_match_c.MatchIndex",
+    .basicsize = sizeof(MatchIndex),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = MatchIndexSlots,
+};
+
+/* ========================================================================== */
+/* Module                                                                     */
+/* ========================================================================== */
+
+static int match_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    MatchModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->match_index_type);
+    return 0;
+}
+
+static int match_module_clear(PyObject* module) {
+    MatchModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->match_index_type);
+    return 0;
+}
+
+static void match_module_free(void* module) {
+    match_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int match_module_exec(PyObject* module) {
+    MatchModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    // The NDJSON reader deserializes Patients through the registry (once per process)
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+    fhir_clear_error();
+
+    state->match_index_type = fhir_python_add_type(module, &MatchIndexSpec);
+    return state->match_index_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot match_module_slots[] = FHIR_PY_MODULE_SLOTS(match_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_match_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_match_c",
+    "Patient matching blocking index in C",
+    sizeof(MatchModuleState),
+    NULL,
+    match_module_slots,
+    match_module_traverse,
+    match_module_clear,
+    match_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_match_c(void) {
+    return PyModuleDef_Init(&fhir_match_module);
+}
@@ -0,0 +1,522 @@
+/**
+ * @file fhir_ndjson.c
+ * @brief Multi-threaded NDJSON reader for FHIR Bulk Data files
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_ndjson.h"
+#include "common/fhir_json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Lines claimed by a worker per trip to the shared index
+#define FHIR_NDJSON_CLAIM_SIZE 32
+
+typedef struct {
+    size_t offset;          // Start of the line in reader->data
+    size_t length;
+    size_t line_number;
+} FHIRNDJSONLine;
+
+struct FHIRNDJSONReader {
+    // Input
+    const char* data;
+    size_t length;
+    size_t offset;
+    size_t line_number;
+    void* mapping;
+    size_t mapping_length;
+
+    // Compressed input: decompressed blocks are appended to window, which
+    // reader->data points at, until it holds a full batch of lines
+    FHIRDecompressor* decompressor;
+    char* window;
+    size_t window_capacity;
+    bool input_complete;
+    bool failed;
+
+    FHIRNDJSONOptions options;
+
+    // Current batch
+    FHIRNDJSONLine* lines;
+    FHIRNDJSONResult* results;
+    size_t batch_count;
+
+    // Worker pool
+    pthread_t* threads;
+    size_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    unsigned long generation;
+    size_t next_index;
+    size_t finished_workers;
+    bool shutting_down;
+};
+
+/* ========================================================================== */
+/* Line Processing                                                            */
+/* ========================================================================== */
+
+static void set_result_error(FHIRNDJSONResult* result, FHIRErrorCode code, const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+
+    result->error_code = code;
+    if (error && error->message && error->field) {
+        snprintf(result->error_message, sizeof(result->error_message), "%s (%s)",
+                 error->message, error->field);
+    } else {
+        snprintf(result->error_message, sizeof(result->error_message), "%s",
+                 error && error->message ? error->message : fallback);
+    }
+}
+
+static void process_line(const FHIRNDJSONReader* reader, const FHIRNDJSONLine* line,
+                         FHIRNDJSONResult* result) {
+    memset(result, 0, sizeof(FHIRNDJSONResult));
+    result->line_number = line->line_number;
+    fhir_clear_error();
+
+    cJSON* json = fhir_json_parse(reader->data + line->offset, line->length);
+    if (!json || !cJSON_IsObject(json)) {
+        cJSON_Delete(json);
+        result->error_code = FHIR_ERROR_INVALID_JSON;
+        snprintf(result->error_message, sizeof(result->error_message), "Invalid JSON");
+        return;
+    }
+
+    cJSON* type_json = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+    if (!cJSON_IsString(type_json) || !type_json->valuestring) {
+        cJSON_Delete(json);
+        result->error_code = FHIR_ERROR_MISSING_REQUIRED_FIELD;
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Missing required field (resourceType)");
+        return;
+    }
+
+    result->resource_type = fhir_resource_type_from_string(type_json->valuestring);
+    bool registered = fhir_resource_get_instance_size(result->resource_type) > 0;
+
+    if (registered) {
+        cJSON* id_json = cJSON_GetObjectItemCaseSensitive(json, "id");
+        const char* id = cJSON_IsString(id_json) ? id_json->valuestring : NULL;
+
+        FHIRResourceBase* resource = fhir_resource_create_by_type(result->resource_type, id);
+        if (!resource) {
+            set_result_error(result, FHIR_ERROR_PARSE_FAILED, "Failed to create resource");
+        } else if (!fhir_resource_from_json(resource, json)) {
+            set_result_error(result, FHIR_ERROR_PARSE_FAILED, "Failed to parse resource");
+            fhir_resource_release(resource);
+        } else if (reader->options.validate && !fhir_resource_validate(resource)) {
+            set_result_error(result, FHIR_ERROR_VALIDATION_FAILED, "Validation failed");
+            fhir_resource_release(resource);
+        } else {
+            result->resource = resource;
+        }
+    } else if (reader->options.strict_types) {
+        result->error_code = FHIR_ERROR_INVALID_RESOURCE_TYPE;
+        snprintf(result->error_message, sizeof(result->error_message),
+                 "Resource type not registered (%s)", type_json->valuestring);
+    }
+
+    if (reader->options.keep_json && result->error_code == FHIR_ERROR_NONE) {
+        result->json = json;
+    } else {
+        cJSON_Delete(json);
+    }
+}
+
+static void cleanup_results(FHIRNDJSONReader* reader) {
+    for (size_t i = 0; i < reader->batch_count; i++) {
+        if (reader->results[i].resource) {
+            fhir_resource_release(reader->results[i].resource);
+        }
+        cJSON_Delete(reader->results[i].json);
+    }
+    reader->batch_count = 0;
+}
+
+/* ========================================================================== */
+/* Worker Pool                                                                */
+/* ========================================================================== */
+
+// Claim and process lines of the current batch until none are left
+static void process_batch_share(FHIRNDJSONReader* reader) {
+    for (;;) {
+        pthread_mutex_lock(&reader->mutex);
+        size_t begin = reader->next_index;
+        size_t end = begin + FHIR_NDJSON_CLAIM_SIZE;
+        if (end > reader->batch_count) end = reader->batch_count;
+        reader->next_index = end;
+        pthread_mutex_unlock(&reader->mutex);
+
+        if (begin >= end) return;
+
+        for (size_t i = begin; i < end; i++) {
+            process_line(reader, &reader->lines[i], &reader->results[i]);
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    FHIRNDJSONReader* reader = arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&reader->mutex);
+    for (;;) {
+        while (!reader->shutting_down && reader->generation == seen) {
+            pthread_cond_wait(&reader->work_ready, &reader->mutex);
+        }
+        if (reader->shutting_down) break;
+        seen = reader->generation;
+        pthread_mutex_unlock(&reader->mutex);
+
+        process_batch_share(reader);
+
+        pthread_mutex_lock(&reader->mutex);
+        if (++reader->finished_workers == reader->thread_count) {
+            pthread_cond_signal(&reader->work_done);
+        }
+    }
+    pthread_mutex_unlock(&reader->mutex);
+
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+static bool start_workers(FHIRNDJSONReader* reader) {
+    if (reader->thread_count <= 1) return true;
+
+    reader->threads = fhir_calloc(reader->thread_count, sizeof(pthread_t));
+    if (!reader->threads) return false;
+
+    for (size_t i = 0; i < reader->thread_count; i++) {
+        if (pthread_create(&reader->threads[i], NULL, worker_main, reader) != 0) {
+            // Run with the workers that did start
+            reader->thread_count = i;
+            break;
+        }
+    }
+
+    if (reader->thread_count <= 1) {
+        // Too few workers to be worth the hand-off; stop any that started
+        pthread_mutex_lock(&reader->mutex);
+        reader->shutting_down = true;
+        pthread_cond_broadcast(&reader->work_ready);
+        pthread_mutex_unlock(&reader->mutex);
+        for (size_t i = 0; i < reader->thread_count; i++) {
+            pthread_join(reader->threads[i], NULL);
+        }
+        fhir_free(reader->threads);
+        reader->threads = NULL;
+        reader->thread_count = 1;
+        reader->shutting_down = false;
+    }
+    return true;
+}
+
+static void stop_workers(FHIRNDJSONReader* reader) {
+    if (!reader->threads) return;
+
+    pthread_mutex_lock(&reader->mutex);
+    reader->shutting_down = true;
+    pthread_cond_broadcast(&reader->work_ready);
+    pthread_mutex_unlock(&reader->mutex);
+
+    for (size_t i = 0; i < reader->thread_count; i++) {
+        pthread_join(reader->threads[i], NULL);
+    }
+    fhir_free(reader->threads);
+    reader->threads = NULL;
+}
+
+/* ========================================================================== */
+/* Reader Lifecycle                                                           */
+/* ========================================================================== */
+
+void fhir_ndjson_options_init(FHIRNDJSONOptions* options) {
+    if (!options) return;
+
+    memset(options, 0, sizeof(FHIRNDJSONOptions));
+    options->batch_size = FHIR_NDJSON_DEFAULT_BATCH_SIZE;
+    options->validate = true;
+}
+
+static FHIRNDJSONReader* reader_create(const char* data, size_t length,
+                                       const FHIRNDJSONOptions* options) {
+    FHIRNDJSONReader* reader = fhir_calloc(1, sizeof(FHIRNDJSONReader));
+    if (!reader) return NULL;
+
+    if (options) {
+        reader->options = *options;
+    } else {
+        fhir_ndjson_options_init(&reader->options);
+    }
+    if (reader->options.batch_size == 0) {
+        reader->options.batch_size = FHIR_NDJSON_DEFAULT_BATCH_SIZE;
+    }
+
+    reader->thread_count = reader->options.thread_count;
+    if (reader->thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        reader->thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    reader->data = data;
+    reader->length = length;
+    reader->input_complete = true;
+    reader->lines = fhir_calloc(reader->options.batch_size, sizeof(FHIRNDJSONLine));
+    reader->results = fhir_calloc(reader->options.batch_size, sizeof(FHIRNDJSONResult));
+    if (!reader->lines || !reader->results) {
+        fhir_free(reader->lines);
+        fhir_free(reader->results);
+        fhir_free(reader);
+        return NULL;
+    }
+
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->work_ready, NULL);
+    pthread_cond_init(&reader->work_done, NULL);
+
+    if (!start_workers(reader)) {
+        fhir_ndjson_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+// Put a decompressor in front of the line splitter if the input is compressed
+static bool attach_decompressor(FHIRNDJSONReader* reader, const char* data, size_t length) {
+    FHIRCompression compression = reader->options.compression;
+    if (compression == FHIR_COMPRESSION_AUTO) {
+        compression = fhir_compression_detect(data, length);
+    }
+    if (compression == FHIR_COMPRESSION_NONE) return true;
+
+    reader->decompressor = fhir_decompressor_create(data, length, compression,
+                                                    reader->thread_count, 0);
+    if (!reader->decompressor) return false;
+
+    reader->data = "";
+    reader->length = 0;
+    reader->input_complete = false;
+    return true;
+}
+
+FHIRNDJSONReader* fhir_ndjson_open_buffer(const char* data, size_t length,
+                                          const FHIRNDJSONOptions* options) {
+    if (!data && length > 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "NDJSON buffer is NULL");
+        return NULL;
+    }
+
+    FHIRNDJSONReader* reader = reader_create(data ? data : "", length, options);
+    if (reader && !attach_decompressor(reader, data, length)) {
+        fhir_ndjson_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+FHIRNDJSONReader* fhir_ndjson_open(const char* path, const FHIRNDJSONOptions* options) {
+    if (!path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "NDJSON path is NULL");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to open NDJSON file", path);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to stat NDJSON file", path);
+        return NULL;
+    }
+
+    size_t length = (size_t)info.st_size;
+    void* mapping = NULL;
+    if (length > 0) {
+        mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to map NDJSON file", path);
+            return NULL;
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(mapping, length, MADV_SEQUENTIAL);
+#endif
+    }
+    close(fd);
+
+    FHIRNDJSONReader* reader = reader_create(mapping ? mapping : "", length, options);
+    if (!reader) {
+        if (mapping) munmap(mapping, length);
+        return NULL;
+    }
+
+    reader->mapping = mapping;
+    reader->mapping_length = length;
+    if (!attach_decompressor(reader, mapping, length)) {
+        fhir_ndjson_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+void fhir_ndjson_close(FHIRNDJSONReader* reader) {
+    if (!reader) return;
+
+    stop_workers(reader);
+    cleanup_results(reader);
+    fhir_decompressor_destroy(reader->decompressor);
+
+    pthread_mutex_destroy(&reader->mutex);
+    pthread_cond_destroy(&reader->work_ready);
+    pthread_cond_destroy(&reader->work_done);
+
+    if (reader->mapping) {
+        munmap(reader->mapping, reader->mapping_length);
+    }
+    fhir_free(reader->window);
+    fhir_free(reader->lines);
+    fhir_free(reader->results);
+    fhir_free(reader);
+}
+
+size_t fhir_ndjson_get_thread_count(const FHIRNDJSONReader* reader) {
+    return reader ? reader->thread_count : 0;
+}
+
+bool fhir_ndjson_failed(const FHIRNDJSONReader* reader) {
+    return reader ? reader->failed : false;
+}
+
+/* ========================================================================== */
+/* Batch Parsing                                                              */
+/* ========================================================================== */
+
+// Split non-empty lines out of the input until the batch holds count lines
+static size_t collect_lines(FHIRNDJSONReader* reader, size_t count) {
+    while (count < reader->options.batch_size && reader->offset < reader->length) {
+        size_t line_offset = reader->offset;
+        const char* start = reader->data + line_offset;
+        size_t remaining = reader->length - line_offset;
+        const char* newline = memchr(start, '\n', remaining);
+        size_t length = newline ? (size_t)(newline - start) : remaining;
+
+        // A partial line at the end of the window waits for the next block
+        if (!newline && !reader->input_complete) break;
+
+        reader->offset += newline ? length + 1 : length;
+        reader->line_number++;
+
+        // Tolerate CRLF line endings and blank lines
+        while (length > 0 && (start[length - 1] == '\r' || start[length - 1] == ' ' ||
+                              start[length - 1] == '\t')) {
+            length--;
+        }
+        if (length == 0) continue;
+
+        reader->lines[count].offset = line_offset;
+        reader->lines[count].length = length;
+        reader->lines[count].line_number = reader->line_number;
+        count++;
+    }
+
+    return count;
+}
+
+// Drop the lines of the previous batch from the window, keeping a partial line
+static void compact_window(FHIRNDJSONReader* reader) {
+    size_t kept = reader->length - reader->offset;
+    if (reader->offset > 0 && kept > 0) {
+        memmove(reader->window, reader->window + reader->offset, kept);
+    }
+    reader->length = kept;
+    reader->offset = 0;
+}
+
+// Append the next decompressed block to the window; false on corrupt input
+static bool fill_window(FHIRNDJSONReader* reader) {
+    size_t block_length;
+    const char* block = fhir_decompressor_next(reader->decompressor, &block_length);
+    if (!block) {
+        reader->input_complete = true;
+        return !fhir_decompressor_failed(reader->decompressor);
+    }
+
+    if (reader->length + block_length > reader->window_capacity) {
+        size_t capacity = reader->window_capacity ? reader->window_capacity : FHIR_DECOMPRESS_BLOCK_SIZE;
+        while (capacity < reader->length + block_length) capacity *= 2;
+
+        char* window = fhir_realloc(reader->window, capacity);
+        if (!window) return false;
+        reader->window = window;
+        reader->window_capacity = capacity;
+    }
+
+    memcpy(reader->window + reader->length, block, block_length);
+    reader->length += block_length;
+    reader->data = reader->window;
+    return true;
+}
+
+FHIRNDJSONResult* fhir_ndjson_next_batch(FHIRNDJSONReader* reader, size_t* count) {
+    if (!reader || !count) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+
+    cleanup_results(reader);
+    *count = 0;
+
+    if (reader->failed) return NULL;
+
+    size_t line_count;
+    if (!reader->decompressor) {
+        line_count = collect_lines(reader, 0);
+    } else {
+        // Lines are offsets, so the window may move while the batch fills
+        compact_window(reader);
+        line_count = collect_lines(reader, 0);
+        while (line_count < reader->options.batch_size && !reader->input_complete) {
+            if (!fill_window(reader)) {
+                reader->failed = true;
+                return NULL;
+            }
+            line_count = collect_lines(reader, line_count);
+        }
+    }
+    if (line_count == 0) return NULL;
+
+    reader->batch_count = line_count;
+    reader->next_index = 0;
+
+    if (!reader->threads) {
+        process_batch_share(reader);
+    } else {
+        pthread_mutex_lock(&reader->mutex);
+        reader->finished_workers = 0;
+        reader->generation++;
+        pthread_cond_broadcast(&reader->work_ready);
+        while (reader->finished_workers < reader->thread_count) {
+            pthread_cond_wait(&reader->work_done, &reader->mutex);
+        }
+        pthread_mutex_unlock(&reader->mutex);
+    }
+
+    *count = line_count;
+    return reader->results;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file fhir_ndjson.h
+ * @brief Multi-threaded NDJSON reader for FHIR Bulk Data files
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Memory-maps an NDJSON file (one resource per line, as produced by the
+ * Bulk Data $export operation), splits it on newlines and parses batches of
+ * lines on a worker pool. Each line is dispatched through the resource
+ * registry (fhir_resource_create_by_name) and the vtable from_json method.
+ *
+ * gzip and zstd input (.ndjson.gz, .ndjson.zst) is recognized by its magic
+ * bytes and parsed without a decompressed copy on disk or in memory: a
+ * fhir_decompress producer inflates ahead of the line splitter into a small
+ * ring of blocks while the workers parse the previous batch.
+ */
+
+#ifndef FHIR_NDJSON_H
+#define FHIR_NDJSON_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include "fhir_decompress.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+#define FHIR_NDJSON_DEFAULT_BATCH_SIZE 4096
+#define FHIR_NDJSON_ERROR_MESSAGE_MAX 128
+
+/**
+ * @brief NDJSON reader options
+ */
+typedef struct {
+    size_t thread_count;    /**< Worker threads (0 = number of online CPUs) */
+    size_t batch_size;      /**< Lines per batch (0 = FHIR_NDJSON_DEFAULT_BATCH_SIZE) */
+    bool validate;          /**< Run the vtable validate method on each resource */
+    bool keep_json;         /**< Keep the parsed cJSON tree of each line */
+    bool strict_types;      /**< Treat resource types without a registration as errors */
+    FHIRCompression compression;  /**< Input compression (FHIR_COMPRESSION_AUTO = detect) */
+} FHIRNDJSONOptions;
+
+/**
+ * @brief Result for a single NDJSON line
+ *
+ * Results are owned by the reader and released on the next batch. Callers
+ * may take ownership of resource or json by setting the field to NULL.
+ */
+typedef struct {
+    size_t line_number;                                  /**< 1-based line number */
+    FHIRResourceType resource_type;                      /**< Type named by resourceType */
+    FHIRResourceBase* resource;                          /**< Typed resource or NULL */
+    cJSON* json;                                         /**< Parsed line if keep_json */
+    FHIRErrorCode error_code;                            /**< FHIR_ERROR_NONE on success */
+    char error_message[FHIR_NDJSON_ERROR_MESSAGE_MAX];   /**< Empty on success */
+} FHIRNDJSONResult;
+
+/**
+ * @brief Opaque NDJSON reader
+ */
+typedef struct FHIRNDJSONReader FHIRNDJSONReader;
+
+/* ========================================================================== */
+/* Reader Lifecycle                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize options with defaults (all CPUs, validation on)
+ * @param options Options to initialize
+ */
+void fhir_ndjson_options_init(FHIRNDJSONOptions* options);
+
+/**
+ * @brief Open an NDJSON file by memory-mapping it
+ *
+ * Compressed files are decompressed on background threads as they are read.
+ *
+ * @param path File path
+ * @param options Reader options (NULL for defaults)
+ * @return New reader or NULL on failure
+ */
+FHIRNDJSONReader* fhir_ndjson_open(const char* path, const FHIRNDJSONOptions* options);
+
+/**
+ * @brief Open a reader over an in-memory NDJSON buffer (no copy is made)
+ * @param data NDJSON text; must outlive the reader
+ * @param length Length of data in bytes
+ * @param options Reader options (NULL for defaults)
+ * @return New reader or NULL on failure
+ */
+FHIRNDJSONReader* fhir_ndjson_open_buffer(const char* data, size_t length,
+                                          const FHIRNDJSONOptions* options);
+
+/**
+ * @brief Close a reader, its worker pool and any outstanding results
+ * @param reader Reader to close (may be NULL)
+ */
+void fhir_ndjson_close(FHIRNDJSONReader* reader);
+
+/* ========================================================================== */
+/* Batch Parsing                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Parse the next batch of non-empty lines in parallel
+ *
+ * Does not touch the Python interpreter, so callers may release the GIL.
+ *
+ * @param reader Reader to advance
+ * @param count Output number of results in the batch
+ * @return Array of results valid until the next call, or NULL at end of input
+ *         or when compressed input is corrupt (see fhir_ndjson_failed)
+ */
+FHIRNDJSONResult* fhir_ndjson_next_batch(FHIRNDJSONReader* reader, size_t* count);
+
+/**
+ * @brief Check whether reading stopped on corrupt or truncated compressed input
+ * @param reader Reader to query
+ * @return true if fhir_ndjson_next_batch returned NULL because of an error
+ */
+bool fhir_ndjson_failed(const FHIRNDJSONReader* reader);
+
+/**
+ * @brief Get the number of worker threads used by a reader
+ * @param reader Reader to query
+ * @return Worker thread count
+ */
+size_t fhir_ndjson_get_thread_count(const FHIRNDJSONReader* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_NDJSON_H */
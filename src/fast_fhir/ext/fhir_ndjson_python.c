@@ -0,0 +1,674 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "fhir_ndjson.h"
+#include "fhir_bundle_parallel.h"
+#include "fhir_python_json.h"
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_json_writer.h"
+#include "resources/fhir_patient.h"
+
+/* ========================================================================== */
+/* Resource                                                                   */
+/* ========================================================================== */
+
+// Native wrapper around a typed resource; attributes read the C struct directly
+
+typedef struct {
+    PyObject_HEAD
+    FHIRResourceBase* resource;    // Heap-allocated, one reference owned
+} Resource;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* resource_type;
+    PyTypeObject* reader_type;
+    PyObject* resource_type_names[FHIR_RESOURCE_TYPE_COUNT];   // Interned resourceType strings
+    FHIRPythonKeyCache keys;
+} NDJSONModuleState;
+
+static struct PyModuleDef fhir_ndjson_module;
+
+// Wrap a resource, taking over the caller's reference
+static PyObject* resource_to_python(NDJSONModuleState* state, FHIRResourceBase* resource) {
+    Resource* self = PyObject_New(Resource, state->resource_type);
+    if (!self) {
+        fhir_resource_release(resource);
+        return NULL;
+    }
+    self->resource = resource;
+    return (PyObject*)self;
+}
+
+// Raise the last C error: MemoryError when out of memory, ValueError otherwise
+static PyObject* set_reader_error(const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+    if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+        return PyErr_NoMemory();
+    }
+    PyErr_SetString(PyExc_ValueError, error && error->message ? error->message : fallback);
+    return NULL;
+}
+
+static PyObject* optional_string(const char* value) {
+    if (!value) {
+        Py_RETURN_NONE;
+    }
+    return PyUnicode_FromString(value);
+}
+
+static void Resource_dealloc(Resource* self) {
+    fhir_resource_release(self->resource);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static PyObject* Resource_repr(Resource* self) {
+    return PyUnicode_FromFormat("<Resource %s/%s>", self->resource->vtable->resource_type_name,
+                                self->resource->id ? self->resource->id : "");
+}
+
+static PyObject* Resource_get_resource_type(Resource* self, void* closure) {
+    FHIRResourceType type = self->resource->resource_type;
+    NDJSONModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_ndjson_module);
+    if (!state) {
+        return NULL;
+    }
+    if (type <= FHIR_RESOURCE_TYPE_UNKNOWN || type >= FHIR_RESOURCE_TYPE_COUNT ||
+        !state->resource_type_names[type]) {
+        return PyUnicode_FromString(self->resource->vtable->resource_type_name);
+    }
+    Py_INCREF(state->resource_type_names[type]);
+    return state->resource_type_names[type];
+}
+
+static PyObject* Resource_get_id(Resource* self, void* closure) {
+    return optional_string(self->resource->id);
+}
+
+static PyObject* Resource_get_active(Resource* self, void* closure) {
+    return PyBool_FromLong(fhir_resource_is_active(self->resource));
+}
+
+static PyObject* Resource_get_display_name(Resource* self, void* closure) {
+    return optional_string(fhir_resource_get_display_name(self->resource));
+}
+
+static PyObject* Resource_get_gender(Resource* self, void* closure) {
+    if (self->resource->resource_type != FHIR_RESOURCE_TYPE_PATIENT) {
+        Py_RETURN_NONE;
+    }
+    const FHIRPatient* patient = (const FHIRPatient*)self->resource;
+    if (patient->gender == FHIR_PATIENT_GENDER_UNKNOWN) {
+        Py_RETURN_NONE;
+    }
+    return optional_string(fhir_patient_gender_to_string(patient->gender));
+}
+
+static PyObject* Resource_get_birth_date(Resource* self, void* closure) {
+    if (self->resource->resource_type != FHIR_RESOURCE_TYPE_PATIENT) {
+        Py_RETURN_NONE;
+    }
+    const FHIRPatient* patient = (const FHIRPatient*)self->resource;
+    return optional_string(patient->birth_date ? patient->birth_date->value : NULL);
+}
+
+static PyObject* Resource_to_dict(Resource* self, PyObject* Py_UNUSED(ignored)) {
+    NDJSONModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_ndjson_module);
+    if (!state) {
+        return NULL;
+    }
+    cJSON* json = fhir_resource_to_json(self->resource);
+    if (!json) {
+        return PyErr_NoMemory();
+    }
+    FHIRPerfSpan span;
+    fhir_perf_begin(&span, FHIR_PERF_PHASE_PYTHON, self->resource->resource_type);
+    PyObject* result = fhir_cjson_to_python_cached(json, &state->keys);
+    fhir_perf_end(&span, 0, result != NULL);
+    cJSON_Delete(json);
+    return result;
+}
+
+static PyObject* Resource_to_json(Resource* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"canonical", NULL};
+    int canonical = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &canonical)) {
+        return NULL;
+    }
+
+    FHIRWriter writer;
+    if (!fhir_writer_init_buffer(&writer, 0)) {
+        return PyErr_NoMemory();
+    }
+    if (!fhir_writer_set_canonical(&writer, canonical) || !fhir_resource_write_json(self->resource, &writer)) {
+        fhir_writer_cleanup(&writer);
+        return PyErr_NoMemory();
+    }
+    PyObject* result = PyUnicode_FromStringAndSize(writer.data, (Py_ssize_t)writer.length);
+    fhir_writer_cleanup(&writer);
+    return result;
+}
+
+static PyObject* Resource_validate(Resource* self, PyObject* Py_UNUSED(ignored)) {
+    // Validation caches its outcome in the resource
+    bool valid;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    valid = fhir_resource_validate(self->resource);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return PyBool_FromLong(valid);
+}
+
+static PyGetSetDef ResourceGetSet[] = {
+    {"resource_type", (getter)Resource_get_resource_type, NULL, "resourceType", NULL},
+    {"id", (getter)Resource_get_id, NULL, "Logical id", NULL},
+    {"active", (getter)Resource_get_active, NULL, "Whether the resource is active", NULL},
+    {"display_name", (getter)Resource_get_display_name, NULL, "Display name, or None", NULL},
+    {"gender", (getter)Resource_get_gender, NULL, "Patient gender, or None", NULL},
+    {"birth_date", (getter)Resource_get_birth_date, NULL, "Patient birthDate, or None", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyMethodDef ResourceMethods[] = {
+    {"to_dict", (PyCFunction)Resource_to_dict, METH_NOARGS, "Convert to a JSON dict"},
+    {"to_json", (PyCFunction)Resource_to_json, METH_VARARGS | METH_KEYWORDS,
+     "Serialize to compact JSON; canonical=True sorts members and normalizes numbers"},
+    {"validate", (PyCFunction)Resource_validate, METH_NOARGS, "Validate the resource (cached)"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot ResourceSlots[] = {
+    {Py_tp_doc, "Typed FHIR resource backed by the C structure"},
+    {Py_tp_dealloc, Resource_dealloc},
+    {Py_tp_repr, Resource_repr},
+    {Py_tp_methods, ResourceMethods},
+    {Py_tp_getset, ResourceGetSet},
+    {0, NULL}
+};
+
+static PyType_Spec ResourceSpec = {
+    .name = "fhir_ndjson_c.Resource",
+    .basicsize = sizeof(Resource),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = ResourceSlots,
+};
+
+// Parse one resource of a registered type into a Resource
+static PyObject* py_parse_resource(PyObject* self, PyObject* arg) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(arg, &view)) {
+        return NULL;
+    }
+
+    bool parsed = false;
+    bool registered = false;
+    FHIRResourceBase* resource = NULL;
+    FHIRErrorCode error_code = FHIR_ERROR_NONE;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json && cJSON_IsObject(json)) {
+        parsed = true;
+        FHIRResourceType type = fhir_resource_type_from_string(fhir_json_get_string(json, "resourceType"));
+        registered = fhir_resource_get_instance_size(type) > 0;
+        if (registered) {
+            resource = fhir_resource_create_by_type(type, fhir_json_get_string(json, "id"));
+            if (resource && !fhir_resource_from_json(resource, json)) {
+                fhir_resource_release(resource);
+                resource = NULL;
+            }
+            if (!resource) {
+                // Failed allocations leave no error set
+                const FHIRError* error = fhir_get_last_error();
+                error_code = error ? error->code : FHIR_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+    cJSON_Delete(json);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (!parsed) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!registered) {
+        PyErr_SetString(PyExc_ValueError, "Resource type not registered");
+        return NULL;
+    }
+    if (!resource) {
+        if (error_code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, "Failed to parse resource");
+        return NULL;
+    }
+    return resource_to_python(PyModule_GetState(self), resource);
+}
+
+/* ========================================================================== */
+/* NDJSON Reader                                                              */
+/* ========================================================================== */
+
+// Python wrapper for the multi-threaded NDJSON reader
+
+typedef struct {
+    PyObject_HEAD
+    FHIRNDJSONReader* reader;
+    Py_buffer view;
+    int has_view;
+    int busy;
+    int as_bytes;
+    int as_resources;     // Typed resources become Resource objects instead of dicts
+    FHIRWriter writer;    // Compact JSON of the current batch, one line per resource (as_bytes)
+    size_t* line_ends;    // End offset in writer of each result's line
+    size_t line_ends_capacity;
+} NDJSONReader;
+
+static int NDJSONReader_init(NDJSONReader* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "threads", "batch_size", "validate", "strict_types", "as_bytes",
+                             "as_resources", NULL};
+    PyObject* source;
+    Py_ssize_t threads = 0;
+    Py_ssize_t batch_size = FHIR_NDJSON_DEFAULT_BATCH_SIZE;
+    int validate = 1;
+    int strict_types = 0;
+    int as_bytes = 0;
+    int as_resources = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|nnpppp", kwlist, &source, &threads,
+                                     &batch_size, &validate, &strict_types, &as_bytes,
+                                     &as_resources)) {
+        return -1;
+    }
+    if (as_bytes && as_resources) {
+        PyErr_SetString(PyExc_ValueError, "as_bytes and as_resources are mutually exclusive");
+        return -1;
+    }
+    if (threads < 0 || batch_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0 and batch_size > 0");
+        return -1;
+    }
+    if (self->reader) {
+        PyErr_SetString(PyExc_RuntimeError, "NDJSONReader is already initialized");
+        return -1;
+    }
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = (size_t)threads;
+    options.batch_size = (size_t)batch_size;
+    options.validate = validate;
+    options.strict_types = strict_types;
+    options.keep_json = true;
+
+    if (as_bytes && !fhir_writer_init_buffer(&self->writer, 0)) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->as_bytes = as_bytes;
+    self->as_resources = as_resources;
+
+    if (PyObject_CheckBuffer(source)) {
+        // In-memory NDJSON (bytes, bytearray, mmap, ...)
+        if (PyObject_GetBuffer(source, &self->view, PyBUF_SIMPLE) < 0) {
+            return -1;
+        }
+        self->has_view = 1;
+        self->reader = fhir_ndjson_open_buffer(self->view.buf, (size_t)self->view.len, &options);
+    } else {
+        PyObject* path = NULL;
+        if (!PyUnicode_FSConverter(source, &path)) {
+            return -1;
+        }
+        Py_BEGIN_ALLOW_THREADS
+        self->reader = fhir_ndjson_open(PyBytes_AS_STRING(path), &options);
+        Py_END_ALLOW_THREADS
+
+        const FHIRError* error = fhir_get_last_error();
+        if (!self->reader && error && error->code == FHIR_ERROR_IO) {
+            PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, source);
+            Py_DECREF(path);
+            return -1;
+        }
+        Py_DECREF(path);
+    }
+
+    if (!self->reader) {
+        if (!fhir_get_last_error()) {
+            // Failed allocations leave no error set
+            PyErr_NoMemory();
+            return -1;
+        }
+        set_reader_error("Failed to open NDJSON input");
+        return -1;
+    }
+    return 0;
+}
+
+static void NDJSONReader_dealloc(NDJSONReader* self) {
+    fhir_ndjson_close(self->reader);
+    if (self->as_bytes) {
+        fhir_writer_cleanup(&self->writer);
+    }
+    PyMem_RawFree(self->line_ends);
+    if (self->has_view) {
+        PyBuffer_Release(&self->view);
+    }
+    fhir_python_free_instance((PyObject*)self);
+}
+
+// Write each parsed resource of a batch as one line of compact JSON (runs without the GIL)
+static bool batch_to_lines(NDJSONReader* self, FHIRNDJSONResult* results, size_t count) {
+    if (count > self->line_ends_capacity) {
+        size_t* line_ends = PyMem_RawRealloc(self->line_ends, count * sizeof(size_t));
+        if (!line_ends) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate line offsets");
+            return false;
+        }
+        self->line_ends = line_ends;
+        self->line_ends_capacity = count;
+    }
+
+    fhir_writer_reset(&self->writer);
+    for (size_t i = 0; i < count; i++) {
+        FHIRNDJSONResult* result = &results[i];
+        if (result->error_code == FHIR_ERROR_NONE) {
+            // Typed resources stream through the vtable; others copy their parsed tree
+            bool written = result->resource ? fhir_resource_write_json(result->resource, &self->writer)
+                                            : fhir_writer_cjson(&self->writer, result->json);
+            if (!written || !fhir_writer_end_line(&self->writer)) {
+                return false;
+            }
+        }
+        self->line_ends[i] = self->writer.length;
+    }
+    return true;
+}
+
+// Convert one batch into (resources, errors)
+static PyObject* batch_to_python(NDJSONReader* self, FHIRNDJSONResult* results, size_t count) {
+    NDJSONModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_ndjson_module);
+    if (!state) {
+        return NULL;
+    }
+    PyObject* resources = PyList_New(0);
+    PyObject* errors = PyList_New(0);
+    if (!resources || !errors) {
+        goto fail;
+    }
+
+    size_t line_start = 0;
+    for (size_t i = 0; i < count; i++) {
+        FHIRNDJSONResult* result = &results[i];
+        PyObject* item;
+
+        if (result->error_code == FHIR_ERROR_NONE) {
+            if (self->as_bytes) {
+                // Line without its trailing newline
+                item = PyBytes_FromStringAndSize(self->writer.data + line_start,
+                                                 (Py_ssize_t)(self->line_ends[i] - line_start - 1));
+                line_start = self->line_ends[i];
+            } else if (self->as_resources && result->resource) {
+                // Take the resource over from the reader
+                item = resource_to_python(state, result->resource);
+                result->resource = NULL;
+            } else {
+                item = fhir_cjson_to_python_cached(result->json, &state->keys);
+            }
+            if (!item || PyList_Append(resources, item) < 0) {
+                Py_XDECREF(item);
+                goto fail;
+            }
+        } else {
+            item = Py_BuildValue("(ns)", (Py_ssize_t)result->line_number, result->error_message);
+            if (!item || PyList_Append(errors, item) < 0) {
+                Py_XDECREF(item);
+                goto fail;
+            }
+        }
+        Py_DECREF(item);
+    }
+
+    return Py_BuildValue("(NN)", resources, errors);
+
+fail:
+    Py_XDECREF(resources);
+    Py_XDECREF(errors);
+    return NULL;
+}
+
+static PyObject* NDJSONReader_next(NDJSONReader* self) {
+    if (!self->reader) {
+        PyErr_SetString(PyExc_RuntimeError, "NDJSONReader is not initialized");
+        return NULL;
+    }
+
+    // Claim the reader; without the GIL, two threads may race for it
+    int busy;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    busy = self->busy;
+    self->busy = 1;
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (busy) {
+        PyErr_SetString(PyExc_RuntimeError, "NDJSONReader is already in use by another thread");
+        return NULL;
+    }
+
+    FHIRNDJSONResult* results;
+    size_t count;
+    bool serialized = true;
+
+    Py_BEGIN_ALLOW_THREADS
+    results = fhir_ndjson_next_batch(self->reader, &count);
+    if (results && self->as_bytes) {
+        serialized = batch_to_lines(self, results, count);
+    }
+    Py_END_ALLOW_THREADS
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    self->busy = 0;
+    FHIR_PY_END_CRITICAL_SECTION();
+
+    if (!results) {
+        if (fhir_ndjson_failed(self->reader)) {
+            return set_reader_error("Corrupt compressed NDJSON input");
+        }
+        return NULL;
+    }
+    if (!serialized) {
+        const FHIRError* error = fhir_get_last_error();
+        if (!error || error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_RuntimeError, error->message ? error->message : "Failed to serialize resource");
+        return NULL;
+    }
+    return batch_to_python(self, results, count);
+}
+
+static PyObject* NDJSONReader_thread_count(NDJSONReader* self, PyObject* Py_UNUSED(ignored)) {
+    return PyLong_FromSize_t(fhir_ndjson_get_thread_count(self->reader));
+}
+
+static PyMethodDef NDJSONReaderMethods[] = {
+    {"thread_count", (PyCFunction)NDJSONReader_thread_count, METH_NOARGS, "Number of worker threads"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot NDJSONReaderSlots[] = {
+    {Py_tp_doc, "Parallel NDJSON reader yielding (resources, errors) batches"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, NDJSONReader_init},
+    {Py_tp_dealloc, NDJSONReader_dealloc},
+    {Py_tp_iter, PyObject_SelfIter},
+    {Py_tp_iternext, NDJSONReader_next},
+    {Py_tp_methods, NDJSONReaderMethods},
+    {0, NULL}
+};
+
+static PyType_Spec NDJSONReaderSpec = {
+    .name = "fhir_ndjson_c.NDJSONReader",
+    .basicsize = sizeof(NDJSONReader),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = NDJSONReaderSlots,
+};
+
+// Load the entries of a Bundle in parallel and return (resources, errors)
+static PyObject* py_parse_bundle(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "threads", NULL};
+    Py_buffer view;
+    Py_ssize_t threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s*|n", kwlist, &view, &threads)) {
+        return NULL;
+    }
+    if (threads < 0) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0");
+        return NULL;
+    }
+
+    cJSON* json;
+    FHIRParallelBundle* bundle = NULL;
+    FHIRErrorCode error_code = FHIR_ERROR_NONE;
+    Py_BEGIN_ALLOW_THREADS
+    json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        bundle = fhir_parse_bundle_parallel(json, (size_t)threads);
+        if (!bundle) {
+            const FHIRError* error = fhir_get_last_error();
+            error_code = error ? error->code : FHIR_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!bundle) {
+        cJSON_Delete(json);
+        if (error_code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, "Data is not a FHIR Bundle");
+        return NULL;
+    }
+
+    NDJSONModuleState* state = PyModule_GetState(self);
+    PyObject* resources = PyList_New(0);
+    PyObject* errors = PyList_New(0);
+    for (size_t i = 0; resources && errors && i < bundle->entry_count; i++) {
+        FHIRBundleEntryResult* entry = &bundle->entries[i];
+        PyObject* item;
+        PyObject* list;
+
+        if (entry->error_code != FHIR_ERROR_NONE) {
+            item = Py_BuildValue("(ns)", (Py_ssize_t)i, entry->error_message);
+            list = errors;
+        } else if (entry->json) {
+            FHIRPerfSpan span;
+            fhir_perf_begin(&span, FHIR_PERF_PHASE_PYTHON, entry->resource_type);
+            item = fhir_cjson_to_python_cached(entry->json, &state->keys);
+            fhir_perf_end(&span, 0, item != NULL);
+            list = resources;
+        } else {
+            continue;
+        }
+        if (!item || PyList_Append(list, item) < 0) {
+            Py_XDECREF(item);
+            Py_CLEAR(resources);
+            break;
+        }
+        Py_DECREF(item);
+    }
+
+    fhir_parallel_bundle_free(bundle);
+    cJSON_Delete(json);
+    if (!resources || !errors) {
+        Py_XDECREF(resources);
+        Py_XDECREF(errors);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", resources, errors);
+}
+
+/* ========================================================================== */
+/* Module                                                                     */
+/* ========================================================================== */
+
+static PyMethodDef NDJSONModuleMethods[] = {
+    {"parse_bundle", (PyCFunction)py_parse_bundle, METH_VARARGS | METH_KEYWORDS,
+     "Load Bundle entries on a worker pool; returns (resources, errors)"},
+    {"parse_resource", py_parse_resource, METH_O,
+     "Parse one resource of a registered type into a Resource"},
+    {NULL, NULL, 0, NULL}
+};
+
+static int ndjson_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    NDJSONModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->resource_type);
+    Py_VISIT(state->reader_type);
+    return 0;
+}
+
+static int ndjson_module_clear(PyObject* module) {
+    NDJSONModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->resource_type);
+    Py_CLEAR(state->reader_type);
+    for (size_t i = 0; i < FHIR_RESOURCE_TYPE_COUNT; i++) {
+        Py_CLEAR(state->resource_type_names[i]);
+    }
+    fhir_python_key_cache_clear(&state->keys);
+    return 0;
+}
+
+static void ndjson_module_free(void* module) {
+    ndjson_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int ndjson_module_exec(PyObject* module) {
+    NDJSONModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    // Register the typed resources available to the reader (once per process)
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+    fhir_clear_error();
+
+    for (size_t i = FHIR_RESOURCE_TYPE_UNKNOWN + 1; i < FHIR_RESOURCE_TYPE_COUNT; i++) {
+        const char* name = fhir_resource_type_to_string((FHIRResourceType)i);
+        if (name && !(state->resource_type_names[i] = PyUnicode_InternFromString(name))) {
+            return -1;
+        }
+    }
+
+    state->resource_type = fhir_python_add_type(module, &ResourceSpec);
+    state->reader_type = state->resource_type ? fhir_python_add_type(module, &NDJSONReaderSpec) : NULL;
+    return state->reader_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot ndjson_module_slots[] = FHIR_PY_MODULE_SLOTS(ndjson_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_ndjson_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_ndjson_c",
+    "Multi-threaded FHIR NDJSON bulk data reader in C",
+    sizeof(NDJSONModuleState),
+    NDJSONModuleMethods,
+    ndjson_module_slots,
+    ndjson_module_traverse,
+    ndjson_module_clear,
+    ndjson_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_ndjson_c(void) {
+    return PyModuleDef_Init(&fhir_ndjson_module);
+}
@@ -5,18 +5,19 @@
  * using the Python C API.
  */
 
-#include <Python.h>
+#include "fhir_python_module.h"
 #include "fhir_foundation.h"
 #include "fhir_specialized.h"
 #include "fhir_workflow.h"
+#include "fhir_python_json.h"
 
 // ============================================================================
 // OrganizationAffiliation Python Bindings
 // ============================================================================
 
-static PyObject* py_organization_affiliation_create(PyObject* self, PyObject* args) {
+static PyObject* py_organization_affiliation_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -29,19 +30,17 @@ static PyObject* py_organization_affiliation_create(PyObject* self, PyObject* ar
     return PyCapsule_New(org_affiliation, "FHIROrganizationAffiliation", NULL);
 }
 
-static PyObject* py_organization_affiliation_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_organization_affiliation_validate(PyObject* self, PyObject* capsule) {
     FHIROrganizationAffiliation* org_affiliation = (FHIROrganizationAffiliation*)PyCapsule_GetPointer(capsule, "FHIROrganizationAffiliation");
     if (!org_affiliation) {
         PyErr_SetString(PyExc_ValueError, "Invalid OrganizationAffiliation object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_organization_affiliation(org_affiliation);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_organization_affiliation(org_affiliation);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -49,9 +48,9 @@ static PyObject* py_organization_affiliation_validate(PyObject* self, PyObject*
 // BiologicallyDerivedProduct Python Bindings
 // ============================================================================
 
-static PyObject* py_biologically_derived_product_create(PyObject* self, PyObject* args) {
+static PyObject* py_biologically_derived_product_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -64,19 +63,17 @@ static PyObject* py_biologically_derived_product_create(PyObject* self, PyObject
     return PyCapsule_New(product, "FHIRBiologicallyDerivedProduct", NULL);
 }
 
-static PyObject* py_biologically_derived_product_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_biologically_derived_product_validate(PyObject* self, PyObject* capsule) {
     FHIRBiologicallyDerivedProduct* product = (FHIRBiologicallyDerivedProduct*)PyCapsule_GetPointer(capsule, "FHIRBiologicallyDerivedProduct");
     if (!product) {
         PyErr_SetString(PyExc_ValueError, "Invalid BiologicallyDerivedProduct object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_biologically_derived_product(product);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_biologically_derived_product(product);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -84,9 +81,9 @@ static PyObject* py_biologically_derived_product_validate(PyObject* self, PyObje
 // DeviceMetric Python Bindings
 // ============================================================================
 
-static PyObject* py_device_metric_create(PyObject* self, PyObject* args) {
+static PyObject* py_device_metric_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -99,19 +96,17 @@ static PyObject* py_device_metric_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(metric, "FHIRDeviceMetric", NULL);
 }
 
-static PyObject* py_device_metric_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_device_metric_validate(PyObject* self, PyObject* capsule) {
     FHIRDeviceMetric* metric = (FHIRDeviceMetric*)PyCapsule_GetPointer(capsule, "FHIRDeviceMetric");
     if (!metric) {
         PyErr_SetString(PyExc_ValueError, "Invalid DeviceMetric object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_device_metric(metric);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_device_metric(metric);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -119,9 +114,9 @@ static PyObject* py_device_metric_validate(PyObject* self, PyObject* args) {
 // NutritionProduct Python Bindings
 // ============================================================================
 
-static PyObject* py_nutrition_product_create(PyObject* self, PyObject* args) {
+static PyObject* py_nutrition_product_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -134,28 +129,21 @@ static PyObject* py_nutrition_product_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(product, "FHIRNutritionProduct", NULL);
 }
 
-static PyObject* py_nutrition_product_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_nutrition_product_validate(PyObject* self, PyObject* capsule) {
     FHIRNutritionProduct* product = (FHIRNutritionProduct*)PyCapsule_GetPointer(capsule, "FHIRNutritionProduct");
     if (!product) {
         PyErr_SetString(PyExc_ValueError, "Invalid NutritionProduct object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_nutrition_product(product);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_nutrition_product(product);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
-static PyObject* py_nutrition_product_is_active(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_nutrition_product_is_active(PyObject* self, PyObject* capsule) {
     FHIRNutritionProduct* product = (FHIRNutritionProduct*)PyCapsule_GetPointer(capsule, "FHIRNutritionProduct");
     if (!product) {
         PyErr_SetString(PyExc_ValueError, "Invalid NutritionProduct object");
@@ -170,9 +158,9 @@ static PyObject* py_nutrition_product_is_active(PyObject* self, PyObject* args)
 // Transport Python Bindings
 // ============================================================================
 
-static PyObject* py_transport_create(PyObject* self, PyObject* args) {
+static PyObject* py_transport_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -185,19 +173,17 @@ static PyObject* py_transport_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(transport, "FHIRTransport", NULL);
 }
 
-static PyObject* py_transport_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_transport_validate(PyObject* self, PyObject* capsule) {
     FHIRTransport* transport = (FHIRTransport*)PyCapsule_GetPointer(capsule, "FHIRTransport");
     if (!transport) {
         PyErr_SetString(PyExc_ValueError, "Invalid Transport object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_transport(transport);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_transport(transport);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -205,9 +191,9 @@ static PyObject* py_transport_validate(PyObject* self, PyObject* args) {
 // VerificationResult Python Bindings
 // ============================================================================
 
-static PyObject* py_verification_result_create(PyObject* self, PyObject* args) {
+static PyObject* py_verification_result_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -220,28 +206,21 @@ static PyObject* py_verification_result_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(result, "FHIRVerificationResult", NULL);
 }
 
-static PyObject* py_verification_result_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_verification_result_validate(PyObject* self, PyObject* capsule) {
     FHIRVerificationResult* result = (FHIRVerificationResult*)PyCapsule_GetPointer(capsule, "FHIRVerificationResult");
     if (!result) {
         PyErr_SetString(PyExc_ValueError, "Invalid VerificationResult object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_verification_result(result);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_verification_result(result);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
-static PyObject* py_verification_result_is_validated(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_verification_result_is_validated(PyObject* self, PyObject* capsule) {
     FHIRVerificationResult* result = (FHIRVerificationResult*)PyCapsule_GetPointer(capsule, "FHIRVerificationResult");
     if (!result) {
         PyErr_SetString(PyExc_ValueError, "Invalid VerificationResult object");
@@ -256,9 +235,9 @@ static PyObject* py_verification_result_is_validated(PyObject* self, PyObject* a
 // EncounterHistory Python Bindings
 // ============================================================================
 
-static PyObject* py_encounter_history_create(PyObject* self, PyObject* args) {
+static PyObject* py_encounter_history_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -271,19 +250,17 @@ static PyObject* py_encounter_history_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(history, "FHIREncounterHistory", NULL);
 }
 
-static PyObject* py_encounter_history_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_encounter_history_validate(PyObject* self, PyObject* capsule) {
     FHIREncounterHistory* history = (FHIREncounterHistory*)PyCapsule_GetPointer(capsule, "FHIREncounterHistory");
     if (!history) {
         PyErr_SetString(PyExc_ValueError, "Invalid EncounterHistory object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_encounter_history(history);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_encounter_history(history);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -291,9 +268,9 @@ static PyObject* py_encounter_history_validate(PyObject* self, PyObject* args) {
 // EpisodeOfCare Python Bindings
 // ============================================================================
 
-static PyObject* py_episode_of_care_create(PyObject* self, PyObject* args) {
+static PyObject* py_episode_of_care_create(PyObject* self, PyObject* arg) {
     const char* id;
-    if (!PyArg_ParseTuple(args, "s", &id)) {
+    if (!fhir_python_text_arg(arg, &id, NULL)) {
         return NULL;
     }
     
@@ -306,19 +283,17 @@ static PyObject* py_episode_of_care_create(PyObject* self, PyObject* args) {
     return PyCapsule_New(episode, "FHIREpisodeOfCare", NULL);
 }
 
-static PyObject* py_episode_of_care_validate(PyObject* self, PyObject* args) {
-    PyObject* capsule;
-    if (!PyArg_ParseTuple(args, "O", &capsule)) {
-        return NULL;
-    }
-    
+static PyObject* py_episode_of_care_validate(PyObject* self, PyObject* capsule) {
     FHIREpisodeOfCare* episode = (FHIREpisodeOfCare*)PyCapsule_GetPointer(capsule, "FHIREpisodeOfCare");
     if (!episode) {
         PyErr_SetString(PyExc_ValueError, "Invalid EpisodeOfCare object");
         return NULL;
     }
     
-    bool is_valid = fhir_validate_episode_of_care(episode);
+    bool is_valid;
+    Py_BEGIN_ALLOW_THREADS
+    is_valid = fhir_validate_episode_of_care(episode);
+    Py_END_ALLOW_THREADS
     return PyBool_FromLong(is_valid);
 }
 
@@ -328,38 +303,38 @@ static PyObject* py_episode_of_care_validate(PyObject* self, PyObject* args) {
 
 static PyMethodDef FHIRNewResourcesMethods[] = {
     // OrganizationAffiliation methods
-    {"organization_affiliation_create", py_organization_affiliation_create, METH_VARARGS, "Create OrganizationAffiliation"},
-    {"organization_affiliation_validate", py_organization_affiliation_validate, METH_VARARGS, "Validate OrganizationAffiliation"},
+    {"organization_affiliation_create", py_organization_affiliation_create, METH_O, "Create OrganizationAffiliation"},
+    {"organization_affiliation_validate", py_organization_affiliation_validate, METH_O, "Validate OrganizationAffiliation"},
     
     // BiologicallyDerivedProduct methods
-    {"biologically_derived_product_create", py_biologically_derived_product_create, METH_VARARGS, "Create BiologicallyDerivedProduct"},
-    {"biologically_derived_product_validate", py_biologically_derived_product_validate, METH_VARARGS, "Validate BiologicallyDerivedProduct"},
+    {"biologically_derived_product_create", py_biologically_derived_product_create, METH_O, "Create BiologicallyDerivedProduct"},
+    {"biologically_derived_product_validate", py_biologically_derived_product_validate, METH_O, "Validate BiologicallyDerivedProduct"},
     
     // DeviceMetric methods
-    {"device_metric_create", py_device_metric_create, METH_VARARGS, "Create DeviceMetric"},
-    {"device_metric_validate", py_device_metric_validate, METH_VARARGS, "Validate DeviceMetric"},
+    {"device_metric_create", py_device_metric_create, METH_O, "Create DeviceMetric"},
+    {"device_metric_validate", py_device_metric_validate, METH_O, "Validate DeviceMetric"},
     
     // NutritionProduct methods
-    {"nutrition_product_create", py_nutrition_product_create, METH_VARARGS, "Create NutritionProduct"},
-    {"nutrition_product_validate", py_nutrition_product_validate, METH_VARARGS, "Validate NutritionProduct"},
-    {"nutrition_product_is_active", py_nutrition_product_is_active, METH_VARARGS, "Check if NutritionProduct is active"},
+    {"nutrition_product_create", py_nutrition_product_create, METH_O, "Create NutritionProduct"},
+    {"nutrition_product_validate", py_nutrition_product_validate, METH_O, "Validate NutritionProduct"},
+    {"nutrition_product_is_active", py_nutrition_product_is_active, METH_O, "Check if NutritionProduct is active"},
     
     // Transport methods
-    {"transport_create", py_transport_create, METH_VARARGS, "Create Transport"},
-    {"transport_validate", py_transport_validate, METH_VARARGS, "Validate Transport"},
+    {"transport_create", py_transport_create, METH_O, "Create Transport"},
+    {"transport_validate", py_transport_validate, METH_O, "Validate Transport"},
     
     // VerificationResult methods
-    {"verification_result_create", py_verification_result_create, METH_VARARGS, "Create VerificationResult"},
-    {"verification_result_validate", py_verification_result_validate, METH_VARARGS, "Validate VerificationResult"},
-    {"verification_result_is_validated", py_verification_result_is_validated, METH_VARARGS, "Check if VerificationResult is validated"},
+    {"verification_result_create", py_verification_result_create, METH_O, "Create VerificationResult"},
+    {"verification_result_validate", py_verification_result_validate, METH_O, "Validate VerificationResult"},
+    {"verification_result_is_validated", py_verification_result_is_validated, METH_O, "Check if VerificationResult is validated"},
     
     // EncounterHistory methods
-    {"encounter_history_create", py_encounter_history_create, METH_VARARGS, "Create EncounterHistory"},
-    {"encounter_history_validate", py_encounter_history_validate, METH_VARARGS, "Validate EncounterHistory"},
+    {"encounter_history_create", py_encounter_history_create, METH_O, "Create EncounterHistory"},
+    {"encounter_history_validate", py_encounter_history_validate, METH_O, "Validate EncounterHistory"},
     
     // EpisodeOfCare methods
-    {"episode_of_care_create", py_episode_of_care_create, METH_VARARGS, "Create EpisodeOfCare"},
-    {"episode_of_care_validate", py_episode_of_care_validate, METH_VARARGS, "Validate EpisodeOfCare"},
+    {"episode_of_care_create", py_episode_of_care_create, METH_O, "Create EpisodeOfCare"},
+    {"episode_of_care_validate", py_episode_of_care_validate, METH_O, "Validate EpisodeOfCare"},
     
     {NULL, NULL, 0, NULL}  // Sentinel
 };
@@ -368,23 +343,26 @@ static PyMethodDef FHIRNewResourcesMethods[] = {
 // Module Definition
 // ============================================================================
 
+static int new_resources_module_exec(PyObject* module) {
+    // Add module constants
+    if (PyModule_AddStringConstant(module, "__version__", "0.1.0") < 0 ||
+        PyModule_AddStringConstant(module, "__author__", "FHIR Implementation Team") < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static PyModuleDef_Slot new_resources_module_slots[] = FHIR_PY_MODULE_SLOTS(new_resources_module_exec);
+
 static struct PyModuleDef fhir_new_resources_module = {
     PyModuleDef_HEAD_INIT,
     "fhir_new_resources_c",
     "FHIR New Resources C Extension Module",
-    -1,
-    FHIRNewResourcesMethods
+    0,
+    FHIRNewResourcesMethods,
+    new_resources_module_slots
 };
 
 PyMODINIT_FUNC PyInit_fhir_new_resources_c(void) {
-    PyObject* module = PyModule_Create(&fhir_new_resources_module);
-    if (module == NULL) {
-        return NULL;
-    }
-    
-    // Add module constants
-    PyModule_AddStringConstant(module, "__version__", "0.1.0");
-    PyModule_AddStringConstant(module, "__author__", "FHIR Implementation Team");
-    
-    return module;
+    return PyModuleDef_Init(&fhir_new_resources_module);
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+/**
+ * @file fhir_observation_columns.c
+ * @brief Columnar (struct-of-arrays) Observation store for analytics
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_observation_columns.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FHIR_OBSERVATION_COLUMNS_INITIAL_CAPACITY 1024
+
+// Interned string (or system/code pair) to dense id; pointers compare by identity
+typedef struct {
+    const char** first;
+    const char** second;
+    size_t count;
+    size_t capacity;
+    uint32_t* slots;        // id + 1, 0 when empty
+    size_t slot_capacity;   // Power of two
+} ColumnDictionary;
+
+struct FHIRObservationColumns {
+    size_t row_count;
+    size_t capacity;
+    int64_t* effective_time;
+    uint32_t* code;
+    double* value;
+    uint32_t* unit;
+    uint32_t* subject;
+    uint8_t* status;
+
+    ColumnDictionary codes;
+    ColumnDictionary units;
+    ColumnDictionary subjects;
+};
+
+// Observation.status codes in FHIRObservationColumnStatus order
+static const char* const g_status_codes[] = {
+    "registered", "preliminary", "final", "amended",
+    "corrected", "cancelled", "entered-in-error", "unknown"
+};
+
+/* ========================================================================== */
+/* Dictionaries                                                               */
+/* ========================================================================== */
+
+static size_t dictionary_hash(const char* first, const char* second) {
+    uint64_t hash = (uint64_t)(uintptr_t)first * 0x9E3779B97F4A7C15ULL;
+    hash ^= (uint64_t)(uintptr_t)second + 0x7F4A7C159E3779B9ULL + (hash << 6) + (hash >> 2);
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+static uint32_t dictionary_find(const ColumnDictionary* dictionary, const char* first, const char* second) {
+    if (dictionary->slot_capacity == 0) return FHIR_OBSERVATION_COLUMNS_NONE;
+
+    size_t mask = dictionary->slot_capacity - 1;
+    for (size_t slot = dictionary_hash(first, second) & mask; dictionary->slots[slot] != 0;
+         slot = (slot + 1) & mask) {
+        uint32_t id = dictionary->slots[slot] - 1;
+        if (dictionary->first[id] == first && dictionary->second[id] == second) {
+            return id;
+        }
+    }
+    return FHIR_OBSERVATION_COLUMNS_NONE;
+}
+
+static bool dictionary_grow(ColumnDictionary* dictionary) {
+    size_t capacity = dictionary->capacity ? dictionary->capacity * 2 : 64;
+    const char** first = fhir_realloc(dictionary->first, capacity * sizeof(char*));
+    if (!first) return false;
+    dictionary->first = first;
+    const char** second = fhir_realloc(dictionary->second, capacity * sizeof(char*));
+    if (!second) return false;
+    dictionary->second = second;
+    dictionary->capacity = capacity;
+
+    // Twice as many slots as ids keeps the load factor at or below 0.5
+    size_t slot_capacity = capacity * 2;
+    uint32_t* slots = fhir_calloc(slot_capacity, sizeof(uint32_t));
+    if (!slots) return false;
+    for (size_t id = 0; id < dictionary->count; id++) {
+        size_t slot = dictionary_hash(dictionary->first[id], dictionary->second[id]) & (slot_capacity - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slot_capacity - 1);
+        }
+        slots[slot] = (uint32_t)id + 1;
+    }
+    fhir_free(dictionary->slots);
+    dictionary->slots = slots;
+    dictionary->slot_capacity = slot_capacity;
+    return true;
+}
+
+static bool dictionary_add(ColumnDictionary* dictionary, const char* first, const char* second,
+                           uint32_t* id) {
+    *id = dictionary_find(dictionary, first, second);
+    if (*id != FHIR_OBSERVATION_COLUMNS_NONE) return true;
+
+    if (dictionary->count == FHIR_OBSERVATION_COLUMNS_NONE - 1) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Column dictionary is full");
+        return false;
+    }
+    if (dictionary->count == dictionary->capacity && !dictionary_grow(dictionary)) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow column dictionary");
+        return false;
+    }
+
+    *id = (uint32_t)dictionary->count++;
+    dictionary->first[*id] = first;
+    dictionary->second[*id] = second;
+
+    size_t mask = dictionary->slot_capacity - 1;
+    size_t slot = dictionary_hash(first, second) & mask;
+    while (dictionary->slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    dictionary->slots[slot] = *id + 1;
+    return true;
+}
+
+// Intern a string column value and map it to its id
+static bool dictionary_add_string(ColumnDictionary* dictionary, const char* value, uint32_t* id) {
+    *id = FHIR_OBSERVATION_COLUMNS_NONE;
+    if (!value) return true;
+
+    const char* interned = fhir_intern(value);
+    return interned && dictionary_add(dictionary, interned, NULL, id);
+}
+
+static void dictionary_cleanup(ColumnDictionary* dictionary) {
+    fhir_free(dictionary->first);
+    fhir_free(dictionary->second);
+    fhir_free(dictionary->slots);
+}
+
+/* ========================================================================== */
+/* Store Lifecycle                                                            */
+/* ========================================================================== */
+
+FHIRObservationColumns* fhir_observation_columns_create(void) {
+    FHIRObservationColumns* columns = fhir_calloc(1, sizeof(FHIRObservationColumns));
+    if (!columns) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Observation columns");
+    }
+    return columns;
+}
+
+void fhir_observation_columns_destroy(FHIRObservationColumns* columns) {
+    if (!columns) return;
+
+    fhir_free(columns->effective_time);
+    fhir_free(columns->code);
+    fhir_free(columns->value);
+    fhir_free(columns->unit);
+    fhir_free(columns->subject);
+    fhir_free(columns->status);
+    dictionary_cleanup(&columns->codes);
+    dictionary_cleanup(&columns->units);
+    dictionary_cleanup(&columns->subjects);
+    fhir_free(columns);
+}
+
+void fhir_observation_columns_get_view(const FHIRObservationColumns* columns,
+                                       FHIRObservationColumnView* view) {
+    if (!view) return;
+
+    memset(view, 0, sizeof(FHIRObservationColumnView));
+    if (!columns) return;
+
+    view->row_count = columns->row_count;
+    view->effective_time = columns->effective_time;
+    view->code = columns->code;
+    view->value = columns->value;
+    view->unit = columns->unit;
+    view->subject = columns->subject;
+    view->status = columns->status;
+}
+
+// Reallocate one column to capacity elements
+#define GROW_COLUMN(columns, name, capacity)                                         \
+    do {                                                                             \
+        void* grown = fhir_realloc((columns)->name, (capacity) * sizeof(*(columns)->name)); \
+        if (!grown) return false;                                                    \
+        (columns)->name = grown;                                                     \
+    } while (0)
+
+static bool reserve_row(FHIRObservationColumns* columns) {
+    if (columns->row_count < columns->capacity) return true;
+
+    size_t capacity = columns->capacity ? columns->capacity * 2 : FHIR_OBSERVATION_COLUMNS_INITIAL_CAPACITY;
+    GROW_COLUMN(columns, effective_time, capacity);
+    GROW_COLUMN(columns, code, capacity);
+    GROW_COLUMN(columns, value, capacity);
+    GROW_COLUMN(columns, unit, capacity);
+    GROW_COLUMN(columns, subject, capacity);
+    GROW_COLUMN(columns, status, capacity);
+    columns->capacity = capacity;
+    return true;
+}
+
+/* ========================================================================== */
+/* Loading                                                                    */
+/* ========================================================================== */
+
+static int64_t observation_effective_time(const cJSON* observation) {
+    const char* effective = fhir_json_get_string(observation, "effectiveDateTime");
+    if (!effective) {
+        effective = fhir_json_get_string(observation, "effectiveInstant");
+    }
+    if (!effective) {
+        const cJSON* period = cJSON_GetObjectItemCaseSensitive(observation, "effectivePeriod");
+        effective = cJSON_IsObject(period) ? fhir_json_get_string(period, "start") : NULL;
+    }
+
+    int64_t millis;
+    if (effective && fhir_observation_columns_parse_time(effective, &millis)) {
+        return millis;
+    }
+    return FHIR_OBSERVATION_COLUMNS_NO_TIME;
+}
+
+static uint8_t observation_status(const cJSON* observation) {
+    const char* status = fhir_json_get_string(observation, "status");
+    if (status) {
+        for (size_t i = 0; i < sizeof(g_status_codes) / sizeof(g_status_codes[0]); i++) {
+            if (strcmp(status, g_status_codes[i]) == 0) return (uint8_t)i;
+        }
+    }
+    return FHIR_OBSERVATION_COLUMN_STATUS_UNKNOWN;
+}
+
+bool fhir_observation_columns_append_json(FHIRObservationColumns* columns, const cJSON* observation) {
+    if (!columns || !cJSON_IsObject(observation)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* type_name = fhir_json_get_string(observation, "resourceType");
+    if (!type_name || strcmp(type_name, "Observation") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Not an Observation");
+        return false;
+    }
+
+    if (!reserve_row(columns)) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow Observation columns");
+        return false;
+    }
+
+    // code.coding[0]
+    uint32_t code_id = FHIR_OBSERVATION_COLUMNS_NONE;
+    const cJSON* code = cJSON_GetObjectItemCaseSensitive(observation, "code");
+    const cJSON* coding = cJSON_IsObject(code) ? cJSON_GetObjectItemCaseSensitive(code, "coding") : NULL;
+    const cJSON* first_coding = cJSON_IsArray(coding) ? coding->child : NULL;
+    const char* code_value = cJSON_IsObject(first_coding) ? fhir_json_get_string(first_coding, "code") : NULL;
+    if (code_value) {
+        const char* system = fhir_json_get_string(first_coding, "system");
+        const char* interned_system = system ? fhir_intern(system) : NULL;
+        const char* interned_code = fhir_intern(code_value);
+        if ((system && !interned_system) || !interned_code ||
+            !dictionary_add(&columns->codes, interned_system, interned_code, &code_id)) {
+            return false;
+        }
+    }
+
+    // valueQuantity or valueInteger
+    double value = NAN;
+    const char* unit = NULL;
+    const cJSON* quantity = cJSON_GetObjectItemCaseSensitive(observation, "valueQuantity");
+    if (cJSON_IsObject(quantity)) {
+        const cJSON* number = cJSON_GetObjectItemCaseSensitive(quantity, "value");
+        if (cJSON_IsNumber(number)) value = number->valuedouble;
+        unit = fhir_json_get_string(quantity, "code");
+        if (!unit) unit = fhir_json_get_string(quantity, "unit");
+    } else {
+        const cJSON* integer = cJSON_GetObjectItemCaseSensitive(observation, "valueInteger");
+        if (cJSON_IsNumber(integer)) value = integer->valuedouble;
+    }
+
+    const cJSON* subject = cJSON_GetObjectItemCaseSensitive(observation, "subject");
+    const char* reference = cJSON_IsObject(subject) ? fhir_json_get_string(subject, "reference") : NULL;
+
+    uint32_t unit_id, subject_id;
+    if (!dictionary_add_string(&columns->units, unit, &unit_id) ||
+        !dictionary_add_string(&columns->subjects, reference, &subject_id)) {
+        return false;
+    }
+
+    size_t row = columns->row_count++;
+    columns->effective_time[row] = observation_effective_time(observation);
+    columns->code[row] = code_id;
+    columns->value[row] = value;
+    columns->unit[row] = unit_id;
+    columns->subject[row] = subject_id;
+    columns->status[row] = observation_status(observation);
+    return true;
+}
+
+bool fhir_observation_columns_load_ndjson(FHIRObservationColumns* columns, const char* path,
+                                          const FHIRNDJSONOptions* options, size_t* appended) {
+    if (appended) *appended = 0;
+    if (!columns || !path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRNDJSONOptions reader_options;
+    if (options) {
+        reader_options = *options;
+    } else {
+        fhir_ndjson_options_init(&reader_options);
+        reader_options.validate = false;
+    }
+    reader_options.keep_json = true;
+    reader_options.strict_types = false;
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open(path, &reader_options);
+    if (!reader) return false;
+
+    bool ok = true;
+    FHIRNDJSONResult* results;
+    size_t count;
+    while (ok && (results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            if (results[i].resource_type != FHIR_RESOURCE_TYPE_OBSERVATION || !results[i].json) {
+                continue;
+            }
+            if (!fhir_observation_columns_append_json(columns, results[i].json)) {
+                ok = false;
+                break;
+            }
+            if (appended) (*appended)++;
+        }
+    }
+
+    fhir_ndjson_close(reader);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Dictionaries                                                               */
+/* ========================================================================== */
+
+uint32_t fhir_observation_columns_find_code(const FHIRObservationColumns* columns,
+                                            const char* system, const char* code) {
+    if (!columns || !code) return FHIR_OBSERVATION_COLUMNS_NONE;
+    return dictionary_find(&columns->codes, system ? fhir_intern(system) : NULL, fhir_intern(code));
+}
+
+size_t fhir_observation_columns_get_code_count(const FHIRObservationColumns* columns) {
+    return columns ? columns->codes.count : 0;
+}
+
+bool fhir_observation_columns_get_code(const FHIRObservationColumns* columns, uint32_t code_id,
+                                       const char** system, const char** code) {
+    if (!columns || code_id >= columns->codes.count) return false;
+
+    if (system) *system = columns->codes.first[code_id];
+    if (code) *code = columns->codes.second[code_id];
+    return true;
+}
+
+const char* fhir_observation_columns_get_unit(const FHIRObservationColumns* columns, uint32_t unit_id) {
+    return columns && unit_id < columns->units.count ? columns->units.first[unit_id] : NULL;
+}
+
+const char* fhir_observation_columns_get_subject(const FHIRObservationColumns* columns,
+                                                 uint32_t subject_id) {
+    return columns && subject_id < columns->subjects.count ? columns->subjects.first[subject_id] : NULL;
+}
+
+/* ========================================================================== */
+/* Filter and Aggregate Kernels                                               */
+/* ========================================================================== */
+
+// Branch-free loops over contiguous columns so the compiler can vectorize
+// them; row counts are read into locals because mask stores may alias them
+
+size_t fhir_observation_columns_select_all(const FHIRObservationColumns* columns, uint8_t* mask) {
+    if (!columns || !mask) return 0;
+
+    memset(mask, 1, columns->row_count);
+    return columns->row_count;
+}
+
+size_t fhir_observation_columns_filter_time_range(const FHIRObservationColumns* columns,
+                                                  int64_t start, int64_t end, uint8_t* mask) {
+    if (!columns || !mask) return 0;
+
+    const int64_t* restrict times = columns->effective_time;
+    uint8_t* restrict selected = mask;
+    size_t row_count = columns->row_count;
+    size_t count = 0;
+    for (size_t i = 0; i < row_count; i++) {
+        selected[i] &= (uint8_t)((times[i] >= start) & (times[i] < end));
+        count += selected[i];
+    }
+    return count;
+}
+
+size_t fhir_observation_columns_filter_code(const FHIRObservationColumns* columns, uint32_t code_id,
+                                            uint8_t* mask) {
+    if (!columns || !mask) return 0;
+
+    const uint32_t* restrict codes = columns->code;
+    uint8_t* restrict selected = mask;
+    size_t row_count = columns->row_count;
+    size_t count = 0;
+    for (size_t i = 0; i < row_count; i++) {
+        selected[i] &= (uint8_t)(codes[i] == code_id);
+        count += selected[i];
+    }
+    return count;
+}
+
+size_t fhir_observation_columns_filter_status(const FHIRObservationColumns* columns,
+                                              FHIRObservationColumnStatus status, uint8_t* mask) {
+    if (!columns || !mask) return 0;
+
+    const uint8_t* restrict statuses = columns->status;
+    uint8_t* restrict selected = mask;
+    size_t row_count = columns->row_count;
+    size_t count = 0;
+    for (size_t i = 0; i < row_count; i++) {
+        selected[i] &= (uint8_t)(statuses[i] == (uint8_t)status);
+        count += selected[i];
+    }
+    return count;
+}
+
+void fhir_observation_columns_aggregate_by_code(const FHIRObservationColumns* columns,
+                                                const uint8_t* mask,
+                                                FHIRObservationCodeStats* stats, size_t stats_count) {
+    if (!stats) return;
+
+    for (size_t i = 0; i < stats_count; i++) {
+        stats[i].count = 0;
+        stats[i].min = INFINITY;
+        stats[i].max = -INFINITY;
+        stats[i].sum = 0.0;
+    }
+
+    if (columns) {
+        const uint32_t* restrict codes = columns->code;
+        const double* restrict values = columns->value;
+        for (size_t i = 0; i < columns->row_count; i++) {
+            uint32_t code = codes[i];
+            double value = values[i];
+            if ((mask && !mask[i]) || code >= stats_count || isnan(value)) continue;
+
+            FHIRObservationCodeStats* entry = &stats[code];
+            entry->count++;
+            entry->sum += value;
+            if (value < entry->min) entry->min = value;
+            if (value > entry->max) entry->max = value;
+        }
+    }
+
+    for (size_t i = 0; i < stats_count; i++) {
+        if (stats[i].count == 0) {
+            stats[i].min = stats[i].max = stats[i].mean = NAN;
+        } else {
+            stats[i].mean = stats[i].sum / (double)stats[i].count;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Utilities                                                                  */
+/* ========================================================================== */
+
+bool fhir_observation_columns_parse_time(const char* value, int64_t* millis) {
+    if (!value || !millis) return false;
+
+    FHIRDateTimeValue parsed;
+    if (!fhir_datetime_parse(value, &parsed)) return false;
+
+    // Floor so instants before the epoch keep their millisecond
+    *millis = parsed.epoch_us / 1000 - (parsed.epoch_us % 1000 < 0);
+    return true;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file fhir_observation_columns.h
+ * @brief Columnar (struct-of-arrays) Observation store for analytics
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Keeps the fields aggregate queries touch in contiguous typed arrays rather
+ * than one FHIRObservation graph per record: effective time as int64
+ * milliseconds since the Unix epoch, code, numeric value, unit, subject and
+ * status. Codes, units and subjects are interned (fhir_intern) and stored as
+ * dictionary ids, so a column is a flat array of integers that filter and
+ * aggregate kernels scan without chasing pointers.
+ *
+ * Rows are appended from Observation JSON (the members fhir_observation_from_json
+ * reads) or straight from an NDJSON file. A store must be destroyed before
+ * fhir_intern_clear is called.
+ */
+
+#ifndef FHIR_OBSERVATION_COLUMNS_H
+#define FHIR_OBSERVATION_COLUMNS_H
+
+#include "common/fhir_common.h"
+#include "fhir_ndjson.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Dictionary id of a missing code, unit or subject */
+#define FHIR_OBSERVATION_COLUMNS_NONE UINT32_MAX
+
+/** Effective time of an Observation without effective[x] */
+#define FHIR_OBSERVATION_COLUMNS_NO_TIME INT64_MIN
+
+/**
+ * @brief Observation.status codes stored in the status column
+ *
+ * Same order as FHIRObservationStatus in resources/fhir_observation.h.
+ */
+typedef enum {
+    FHIR_OBSERVATION_COLUMN_STATUS_REGISTERED = 0,
+    FHIR_OBSERVATION_COLUMN_STATUS_PRELIMINARY,
+    FHIR_OBSERVATION_COLUMN_STATUS_FINAL,
+    FHIR_OBSERVATION_COLUMN_STATUS_AMENDED,
+    FHIR_OBSERVATION_COLUMN_STATUS_CORRECTED,
+    FHIR_OBSERVATION_COLUMN_STATUS_CANCELLED,
+    FHIR_OBSERVATION_COLUMN_STATUS_ENTERED_IN_ERROR,
+    FHIR_OBSERVATION_COLUMN_STATUS_UNKNOWN
+} FHIRObservationColumnStatus;
+
+/**
+ * @brief Read-only view of the columns, valid until the next append
+ *
+ * Every array has row_count elements. Missing values are
+ * FHIR_OBSERVATION_COLUMNS_NO_TIME, NaN and FHIR_OBSERVATION_COLUMNS_NONE.
+ */
+typedef struct {
+    size_t row_count;
+    const int64_t* effective_time;  /**< effective[x] start, ms since the epoch (UTC) */
+    const uint32_t* code;           /**< Code id of code.coding[0] */
+    const double* value;            /**< valueQuantity.value or valueInteger */
+    const uint32_t* unit;           /**< Unit id of valueQuantity.code, else .unit */
+    const uint32_t* subject;        /**< Subject id of subject.reference */
+    const uint8_t* status;          /**< FHIRObservationColumnStatus */
+} FHIRObservationColumnView;
+
+/**
+ * @brief Aggregates of the numeric values of one code
+ */
+typedef struct {
+    size_t count;   /**< Selected rows with a value */
+    double min;     /**< NaN when count is 0 */
+    double max;
+    double sum;
+    double mean;
+} FHIRObservationCodeStats;
+
+/**
+ * @brief Opaque columnar Observation store
+ */
+typedef struct FHIRObservationColumns FHIRObservationColumns;
+
+/* ========================================================================== */
+/* Store Lifecycle                                                            */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty store
+ * @return New store or NULL on failure
+ */
+FHIRObservationColumns* fhir_observation_columns_create(void);
+
+/**
+ * @brief Destroy a store and its columns
+ * @param columns Store to destroy (can be NULL)
+ */
+void fhir_observation_columns_destroy(FHIRObservationColumns* columns);
+
+/**
+ * @brief Get the current columns
+ * @param columns Store to query
+ * @param view Output view
+ */
+void fhir_observation_columns_get_view(const FHIRObservationColumns* columns,
+                                       FHIRObservationColumnView* view);
+
+/* ========================================================================== */
+/* Loading                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Append one row from Observation JSON
+ * @param columns Store to fill
+ * @param observation Observation JSON object
+ * @return true on success, false on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         if not an Observation, FHIR_ERROR_OUT_OF_MEMORY)
+ */
+bool fhir_observation_columns_append_json(FHIRObservationColumns* columns, const cJSON* observation);
+
+/**
+ * @brief Append every Observation line of an NDJSON file
+ *
+ * Lines are parsed on the NDJSON reader's worker pool; options.keep_json is
+ * forced on. Other resource types and lines that fail to parse are skipped.
+ *
+ * @param columns Store to fill
+ * @param path NDJSON file path
+ * @param options Reader options (NULL for defaults without validation)
+ * @param appended Output number of rows appended (can be NULL)
+ * @return true on success, false if the file cannot be read or memory runs out
+ */
+bool fhir_observation_columns_load_ndjson(FHIRObservationColumns* columns, const char* path,
+                                          const FHIRNDJSONOptions* options, size_t* appended);
+
+/* ========================================================================== */
+/* Dictionaries                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Find the id of a code
+ * @param columns Store to query
+ * @param system Code system URL (can be NULL for codings without a system)
+ * @param code Code
+ * @return Code id or FHIR_OBSERVATION_COLUMNS_NONE if no row has the code
+ */
+uint32_t fhir_observation_columns_find_code(const FHIRObservationColumns* columns,
+                                            const char* system, const char* code);
+
+/**
+ * @brief Get the number of distinct codes (code ids are 0 to count - 1)
+ * @param columns Store to query
+ * @return Number of codes
+ */
+size_t fhir_observation_columns_get_code_count(const FHIRObservationColumns* columns);
+
+/**
+ * @brief Get the system and code of a code id
+ * @param columns Store to query
+ * @param code_id Code id
+ * @param system Output interned system, NULL for codings without one (can be NULL)
+ * @param code Output interned code (can be NULL)
+ * @return true if code_id exists
+ */
+bool fhir_observation_columns_get_code(const FHIRObservationColumns* columns, uint32_t code_id,
+                                       const char** system, const char** code);
+
+/**
+ * @brief Get the unit of a unit id
+ * @param columns Store to query
+ * @param unit_id Unit id
+ * @return Interned unit or NULL if unit_id does not exist
+ */
+const char* fhir_observation_columns_get_unit(const FHIRObservationColumns* columns, uint32_t unit_id);
+
+/**
+ * @brief Get the subject reference of a subject id
+ * @param columns Store to query
+ * @param subject_id Subject id
+ * @return Interned reference or NULL if subject_id does not exist
+ */
+const char* fhir_observation_columns_get_subject(const FHIRObservationColumns* columns,
+                                                 uint32_t subject_id);
+
+/* ========================================================================== */
+/* Filter and Aggregate Kernels                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Select every row
+ * @param columns Store to query
+ * @param mask Output row_count bytes, set to 1
+ * @return Number of selected rows
+ */
+size_t fhir_observation_columns_select_all(const FHIRObservationColumns* columns, uint8_t* mask);
+
+/**
+ * @brief Keep selected rows whose effective time is in [start, end)
+ * @param columns Store to query
+ * @param start Inclusive lower bound, ms since the epoch
+ * @param end Exclusive upper bound, ms since the epoch
+ * @param mask row_count bytes; rows outside the range are cleared
+ * @return Number of rows still selected
+ */
+size_t fhir_observation_columns_filter_time_range(const FHIRObservationColumns* columns,
+                                                  int64_t start, int64_t end, uint8_t* mask);
+
+/**
+ * @brief Keep selected rows with a code
+ * @param columns Store to query
+ * @param code_id Code id
+ * @param mask row_count bytes; rows with other codes are cleared
+ * @return Number of rows still selected
+ */
+size_t fhir_observation_columns_filter_code(const FHIRObservationColumns* columns, uint32_t code_id,
+                                            uint8_t* mask);
+
+/**
+ * @brief Keep selected rows with a status
+ * @param columns Store to query
+ * @param status Status to keep
+ * @param mask row_count bytes; rows with other statuses are cleared
+ * @return Number of rows still selected
+ */
+size_t fhir_observation_columns_filter_status(const FHIRObservationColumns* columns,
+                                              FHIRObservationColumnStatus status, uint8_t* mask);
+
+/**
+ * @brief Compute min/max/mean of the values of every code in one pass
+ * @param columns Store to query
+ * @param mask Selected rows (NULL for all rows)
+ * @param stats Output array indexed by code id
+ * @param stats_count Capacity of stats; codes at or above it are ignored
+ */
+void fhir_observation_columns_aggregate_by_code(const FHIRObservationColumns* columns,
+                                                const uint8_t* mask,
+                                                FHIRObservationCodeStats* stats, size_t stats_count);
+
+/* ========================================================================== */
+/* Utilities                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Convert a FHIR date, dateTime or instant to milliseconds since the epoch
+ *
+ * Partial dates map to their first instant; values without a time zone are
+ * taken as UTC.
+ *
+ * @param value Date text (e.g. "2024", "2024-03-01", "2024-03-01T10:00:00.5+01:00")
+ * @param millis Output milliseconds since 1970-01-01T00:00:00Z
+ * @return true if value is a valid date
+ */
+bool fhir_observation_columns_parse_time(const char* value, int64_t* millis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_OBSERVATION_COLUMNS_H */
@@ -1,141 +1,1385 @@
 #define PY_SSIZE_T_CLEAN
-#include <Python.h>
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_document.h"
 #include <string.h>
 #include <cjson/cJSON.h>
+#include "fhir_bundle_stream.h"
+#include "fhir_path.h"
+#include "fhir_search_index.h"
+#include "fhir_structure_rules.h"
+#include "fhir_python_json.h"
+#include "common/fhir_json_reader.h"
+#include "common/fhir_resource_type_lookup.h"
 
-// Fast JSON validation for FHIR resources
-static PyObject* validate_fhir_json(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
-        return NULL;
-    }
+// Python binding for parsing: ParsedDocument and the entry points that read a
+// tree while it is parsed (Bundle streaming, FHIRPath, search index extraction
+// and validation). Features that only consume parsed resources live in their
+// own fhir_*_c modules and borrow ParsedDocument trees through _fhir_documents.
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* parsed_document_type;
+    PyTypeObject* bundle_entry_iterator_type;
+    PyTypeObject* bundle_feed_type;
+    PyTypeObject* compiled_path_type;
+    PyObject* resource_type_codes;  // Interned type name str -> FHIRResourceType int, filled as known names are looked up
+    FHIRPythonKeyCache keys;
+} ParserModuleState;
+
+static struct PyModuleDef fhir_parser_module;
+
+// State of the module that created the type of self
+static ParserModuleState* parser_state(PyObject* self) {
+    return fhir_python_type_state(Py_TYPE(self), &fhir_parser_module);
+}
+
+// Parse JSON text, raising ValueError on failure; large inputs are parsed without the GIL
+static cJSON* parser_parse_json_or_raise(const char* json_string, Py_ssize_t length) {
+    cJSON* json;
+    
+    FHIR_BEGIN_ALLOW_THREADS(length)
+    json = fhir_json_parse(json_string, (size_t)length);
+    FHIR_END_ALLOW_THREADS
     
-    cJSON* json = cJSON_Parse(json_string);
     if (json == NULL) {
         PyErr_SetString(PyExc_ValueError, "Invalid JSON");
-        return NULL;
     }
-    
-    // Check for required FHIR fields
+    return json;
+}
+
+// Convert a scalar cJSON field to a Python value (None for missing or non-scalar fields)
+static PyObject* field_to_python(const cJSON* field) {
+    if (field != NULL) {
+        if (cJSON_IsString(field) && (field->valuestring != NULL)) {
+            return PyUnicode_FromString(field->valuestring);
+        } else if (cJSON_IsBool(field)) {
+            return PyBool_FromLong(cJSON_IsTrue(field));
+        } else if (cJSON_IsNumber(field)) {
+            if (field->valuedouble == (int)field->valuedouble) {
+                return PyLong_FromLong((long)field->valuedouble);
+            }
+            return PyFloat_FromDouble(field->valuedouble);
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+// Check the required FHIR fields on an already parsed document
+static PyObject* validate_parsed(const cJSON* json) {
     cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
     if (!cJSON_IsString(resource_type) || (resource_type->valuestring == NULL)) {
-        cJSON_Delete(json);
         PyErr_SetString(PyExc_ValueError, "Missing or invalid resourceType");
         return NULL;
     }
+    Py_RETURN_TRUE;
+}
+
+static PyObject* resource_type_parsed(const cJSON* json) {
+    cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+    if (!cJSON_IsString(resource_type) || (resource_type->valuestring == NULL)) {
+        Py_RETURN_NONE;
+    }
+    return PyUnicode_FromString(resource_type->valuestring);
+}
+
+static PyObject* resource_type_code_parsed(const cJSON* json) {
+    cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+    if (!cJSON_IsString(resource_type) || (resource_type->valuestring == NULL)) {
+        return PyLong_FromLong(FHIR_RESOURCE_TYPE_UNKNOWN);
+    }
+    const char* name = resource_type->valuestring;
+    return PyLong_FromLong(fhir_resource_type_lookup(name, strlen(name)));
+}
+
+static PyObject* entry_count_parsed(const cJSON* json) {
+    cJSON* entry = cJSON_GetObjectItemCaseSensitive(json, "entry");
+    int count = 0;
+    
+    if (cJSON_IsArray(entry)) {
+        count = cJSON_GetArraySize(entry);
+    }
+    
+    return PyLong_FromLong(count);
+}
+
+// Build {name: value} for every name in a sequence of field names
+static PyObject* extract_fields_parsed(const cJSON* json, PyObject* field_names) {
+    PyObject* names = PySequence_Fast(field_names, "field names must be a sequence of strings");
+    if (!names) {
+        return NULL;
+    }
     
+    PyObject* result = PyDict_New();
+    if (!result) {
+        Py_DECREF(names);
+        return NULL;
+    }
+    
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(names);
+    PyObject** items = PySequence_Fast_ITEMS(names);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        const char* field_name = PyUnicode_AsUTF8(items[i]);
+        if (!field_name) {
+            Py_DECREF(result);
+            Py_DECREF(names);
+            return NULL;
+        }
+        
+        PyObject* value = field_to_python(cJSON_GetObjectItemCaseSensitive(json, field_name));
+        if (!value || PyDict_SetItem(result, items[i], value) < 0) {
+            Py_XDECREF(value);
+            Py_DECREF(result);
+            Py_DECREF(names);
+            return NULL;
+        }
+        Py_DECREF(value);
+    }
+    
+    Py_DECREF(names);
+    return result;
+}
+
+// Fast JSON validation for FHIR resources
+static PyObject* validate_fhir_json(PyObject* self, PyObject* args) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
+        return NULL;
+    }
+    
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    PyObject* result = validate_parsed(json);
     cJSON_Delete(json);
-    Py_RETURN_TRUE;
+    return result;
 }
 
 // Fast resource type extraction
 static PyObject* extract_resource_type(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
     if (json == NULL) {
-        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
     
-    cJSON* resource_type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
-    if (!cJSON_IsString(resource_type) || (resource_type->valuestring == NULL)) {
-        cJSON_Delete(json);
-        Py_RETURN_NONE;
-    }
-    
-    PyObject* result = PyUnicode_FromString(resource_type->valuestring);
+    PyObject* result = resource_type_parsed(json);
     cJSON_Delete(json);
     return result;
 }
 
+// Map a resource type name to its FHIRResourceType code (0 for unknown names)
+static PyObject* resource_type_code(PyObject* self, PyObject* name) {
+    if (!PyUnicode_Check(name)) {
+        PyErr_SetString(PyExc_TypeError, "resource type name must be a str");
+        return NULL;
+    }
+    
+    // Repeated names hit the cache on the str's stored hash without re-encoding
+    ParserModuleState* state = PyModule_GetState(self);
+    PyObject* code = PyDict_GetItemWithError(state->resource_type_codes, name);
+    if (code != NULL) {
+        Py_INCREF(code);
+        return code;
+    }
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    
+    Py_ssize_t length;
+    const char* utf8 = PyUnicode_AsUTF8AndSize(name, &length);
+    if (utf8 == NULL) {
+        return NULL;
+    }
+    
+    FHIRResourceType type = fhir_resource_type_lookup(utf8, (size_t)length);
+    code = PyLong_FromLong(type);
+    
+    // Only known names are cached, so arbitrary input cannot grow the cache.
+    // Entries are only ever inserted, never replaced, so the values the
+    // lookup above borrows stay alive when threads race to add a name.
+    if (code != NULL && type != FHIR_RESOURCE_TYPE_UNKNOWN) {
+        Py_INCREF(name);
+        PyUnicode_InternInPlace(&name);
+        PyObject* cached = PyDict_SetDefault(state->resource_type_codes, name, code);
+        Py_DECREF(name);
+        if (cached == NULL) {
+            Py_DECREF(code);
+            return NULL;
+        }
+    }
+    return code;
+}
+
 // Fast bundle entry count
 static PyObject* count_bundle_entries(PyObject* self, PyObject* args) {
-    const char* json_string;
-    if (!PyArg_ParseTuple(args, "s", &json_string)) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
     if (json == NULL) {
-        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
         return NULL;
     }
     
-    cJSON* entry = cJSON_GetObjectItemCaseSensitive(json, "entry");
-    int count = 0;
+    PyObject* result = entry_count_parsed(json);
+    cJSON_Delete(json);
+    return result;
+}
+
+// Fast field extraction for common FHIR fields
+static PyObject* extract_field(PyObject* self, PyObject* args) {
+    Py_buffer view;
+    const char* field_name;
     
-    if (cJSON_IsArray(entry)) {
-        count = cJSON_GetArraySize(entry);
+    if (!PyArg_ParseTuple(args, "s*s", &view, &field_name)) {
+        return NULL;
+    }
+    
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        return NULL;
     }
     
+    PyObject* result = field_to_python(cJSON_GetObjectItemCaseSensitive(json, field_name));
     cJSON_Delete(json);
-    return PyLong_FromLong(count);
+    return result;
 }
 
-// Fast field extraction for common FHIR fields
-static PyObject* extract_field(PyObject* self, PyObject* args) {
-    const char* json_string;
+// Batch field extraction from a single parse
+static PyObject* extract_fields(PyObject* self, PyObject* args) {
+    Py_buffer view;
+    PyObject* field_names;
+    
+    if (!PyArg_ParseTuple(args, "s*O", &view, &field_names)) {
+        return NULL;
+    }
+    
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    PyObject* result = extract_fields_parsed(json, field_names);
+    cJSON_Delete(json);
+    return result;
+}
+
+// Convert an epoch millisecond bound to int, or None for an open end
+static PyObject* date_bound_to_python(int64_t millis) {
+    if (millis == FHIR_SEARCH_INDEX_DATE_MIN || millis == FHIR_SEARCH_INDEX_DATE_MAX) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromLongLong((long long)millis);
+}
+
+// Index rows as (parameter, type, ...) tuples:
+// ("token", system, code), ("string", value), ("date", start_ms, end_ms),
+// ("quantity", value, system, unit), ("reference", type, id)
+static PyObject* search_index_parsed(const cJSON* json) {
+    FHIRSearchIndexRows rows;
+    fhir_search_index_rows_init(&rows);
+    
+    if (!fhir_search_index_extract(json, &rows)) {
+        const FHIRError* error = fhir_get_last_error();
+        fhir_search_index_rows_cleanup(&rows);
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, "Missing resourceType");
+        return NULL;
+    }
+    
+    PyObject* list = PyList_New((Py_ssize_t)rows.count);
+    for (size_t i = 0; list != NULL && i < rows.count; i++) {
+        const FHIRSearchIndexRow* row = &rows.rows[i];
+        PyObject* item = NULL;
+        switch (row->type) {
+            case FHIR_SEARCH_PARAM_TOKEN:
+                item = Py_BuildValue("(sszs)", row->parameter, "token", row->value.token.system,
+                                     row->value.token.code);
+                break;
+            case FHIR_SEARCH_PARAM_STRING:
+                item = Py_BuildValue("(sss)", row->parameter, "string", row->value.string);
+                break;
+            case FHIR_SEARCH_PARAM_DATE:
+                item = Py_BuildValue("(ssNN)", row->parameter, "date",
+                                     date_bound_to_python(row->value.date.start),
+                                     date_bound_to_python(row->value.date.end));
+                break;
+            case FHIR_SEARCH_PARAM_QUANTITY:
+                item = Py_BuildValue("(ssdzz)", row->parameter, "quantity", row->value.quantity.value,
+                                     row->value.quantity.system, row->value.quantity.unit);
+                break;
+            case FHIR_SEARCH_PARAM_REFERENCE:
+                item = Py_BuildValue("(sszs)", row->parameter, "reference", row->value.reference.type_name,
+                                     row->value.reference.id);
+                break;
+        }
+        if (item == NULL) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+    fhir_search_index_rows_cleanup(&rows);
+    return list;
+}
+
+// Extract search parameter index rows from a resource
+static PyObject* extract_search_index(PyObject* self, PyObject* args) {
+    Py_buffer view;
+    
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
+        return NULL;
+    }
+    
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    PyObject* result = search_index_parsed(json);
+    cJSON_Delete(json);
+    return result;
+}
+
+// ParsedDocument: parses once and keeps the cJSON tree for repeated queries
+typedef struct {
+    PyObject_HEAD
+    cJSON* json;
+} ParsedDocument;
+
+static int ParsedDocument_init(ParsedDocument* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"json", NULL};
+    Py_buffer view;
+    
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s*", kwlist, &view)) {
+        return -1;
+    }
+    
+    cJSON* json = parser_parse_json_or_raise(view.buf, view.len);
+    PyBuffer_Release(&view);
+    if (json == NULL) {
+        return -1;
+    }
+    
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    cJSON_Delete(self->json);
+    self->json = json;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void ParsedDocument_dealloc(ParsedDocument* self) {
+    cJSON_Delete(self->json);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int ParsedDocument_check_ready(ParsedDocument* self) {
+    if (self->json == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "ParsedDocument is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+// Run a query on the tree, which a concurrent __init__ would otherwise free under it
+static PyObject* ParsedDocument_query(ParsedDocument* self, PyObject* (*query)(const cJSON*)) {
+    PyObject* result = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (ParsedDocument_check_ready(self)) {
+        result = query(self->json);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* ParsedDocument_validate(ParsedDocument* self, PyObject* Py_UNUSED(ignored)) {
+    return ParsedDocument_query(self, validate_parsed);
+}
+
+static PyObject* ParsedDocument_resource_type(ParsedDocument* self, PyObject* Py_UNUSED(ignored)) {
+    return ParsedDocument_query(self, resource_type_parsed);
+}
+
+static PyObject* ParsedDocument_resource_type_code(ParsedDocument* self, PyObject* Py_UNUSED(ignored)) {
+    return ParsedDocument_query(self, resource_type_code_parsed);
+}
+
+static PyObject* ParsedDocument_entry_count(ParsedDocument* self, PyObject* Py_UNUSED(ignored)) {
+    return ParsedDocument_query(self, entry_count_parsed);
+}
+
+static PyObject* ParsedDocument_extract_field(ParsedDocument* self, PyObject* args) {
     const char* field_name;
+    if (!PyArg_ParseTuple(args, "s", &field_name)) {
+        return NULL;
+    }
+    PyObject* result = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (ParsedDocument_check_ready(self)) {
+        result = field_to_python(cJSON_GetObjectItemCaseSensitive(self->json, field_name));
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* ParsedDocument_extract_fields(ParsedDocument* self, PyObject* field_names) {
+    PyObject* result = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (ParsedDocument_check_ready(self)) {
+        result = extract_fields_parsed(self->json, field_names);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* ParsedDocument_search_index(ParsedDocument* self, PyObject* Py_UNUSED(ignored)) {
+    return ParsedDocument_query(self, search_index_parsed);
+}
+
+static PyMethodDef ParsedDocumentMethods[] = {
+    {"validate", (PyCFunction)ParsedDocument_validate, METH_NOARGS, "Validate FHIR JSON structure"},
+    {"resource_type", (PyCFunction)ParsedDocument_resource_type, METH_NOARGS, "Get resourceType of the document"},
+    {"resource_type_code", (PyCFunction)ParsedDocument_resource_type_code, METH_NOARGS, "Get the FHIRResourceType code of the document"},
+    {"entry_count", (PyCFunction)ParsedDocument_entry_count, METH_NOARGS, "Count entries in FHIR Bundle"},
+    {"extract_field", (PyCFunction)ParsedDocument_extract_field, METH_VARARGS, "Extract field value"},
+    {"extract_fields", (PyCFunction)ParsedDocument_extract_fields, METH_O, "Extract several field values as a dict"},
+    {"search_index", (PyCFunction)ParsedDocument_search_index, METH_NOARGS, "Extract search parameter index rows"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot ParsedDocumentSlots[] = {
+    {Py_tp_doc, "FHIR JSON document parsed once and queried many times"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, ParsedDocument_init},
+    {Py_tp_dealloc, ParsedDocument_dealloc},
+    {Py_tp_methods, ParsedDocumentMethods},
+    {0, NULL}
+};
+
+static PyType_Spec ParsedDocumentSpec = {
+    .name = "fhir_parser_c.ParsedDocument",
+    .basicsize = sizeof(ParsedDocument),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = ParsedDocumentSlots,
+};
+
+// Borrow the tree of a ParsedDocument of any import of this module (see
+// fhir_python_document.h); the type is final, so its dealloc identifies it
+static int documents_document_json(PyObject* document, const cJSON** json) {
+    if (Py_TYPE(document)->tp_dealloc != (destructor)ParsedDocument_dealloc) {
+        return 0;
+    }
+    ParsedDocument* parsed = (ParsedDocument*)document;
+    if (!ParsedDocument_check_ready(parsed)) {
+        return -1;
+    }
+    *json = parsed->json;
+    return 1;
+}
+
+static const FHIRPythonDocuments parser_documents = {
+    documents_document_json,
+};
+
+// BundleEntryIterator: yields entry[i].resource of a Bundle one at a time
+typedef struct {
+    PyObject_HEAD
+    FHIRBundleStream* stream;
+    PyObject* source;
+    Py_buffer view;
+    int has_view;
+    PyObject* read_method;
+    PyObject* pending;
+    Py_ssize_t pending_offset;
+    int busy;
+} BundleEntryIterator;
+
+// Read callback that pulls chunks from a Python file-like object
+static long BundleEntryIterator_read(void* context, char* buffer, size_t capacity) {
+    BundleEntryIterator* self = (BundleEntryIterator*)context;
+    
+    if (!self->pending) {
+        PyObject* chunk = PyObject_CallFunction(self->read_method, "n", (Py_ssize_t)capacity);
+        if (!chunk) {
+            return -1;
+        }
+        
+        // Text files return str; keep its UTF-8 bytes so a chunk may exceed capacity
+        if (PyUnicode_Check(chunk)) {
+            PyObject* encoded = PyUnicode_AsUTF8String(chunk);
+            Py_DECREF(chunk);
+            if (!encoded) {
+                return -1;
+            }
+            chunk = encoded;
+        } else if (!PyBytes_Check(chunk)) {
+            Py_DECREF(chunk);
+            PyErr_SetString(PyExc_TypeError, "read() must return bytes or str");
+            return -1;
+        }
+        
+        self->pending = chunk;
+        self->pending_offset = 0;
+    }
+    
+    Py_ssize_t available = PyBytes_GET_SIZE(self->pending) - self->pending_offset;
+    size_t count = (size_t)available < capacity ? (size_t)available : capacity;
+    memcpy(buffer, PyBytes_AS_STRING(self->pending) + self->pending_offset, count);
+    self->pending_offset += (Py_ssize_t)count;
+    
+    if (self->pending_offset >= PyBytes_GET_SIZE(self->pending)) {
+        Py_CLEAR(self->pending);
+    }
+    
+    return (long)count;
+}
+
+static void BundleEntryIterator_dealloc(BundleEntryIterator* self) {
+    fhir_bundle_stream_destroy(self->stream);
+    if (self->has_view) {
+        PyBuffer_Release(&self->view);
+    }
+    Py_XDECREF(self->pending);
+    Py_XDECREF(self->read_method);
+    Py_XDECREF(self->source);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static PyObject* BundleEntryIterator_next(BundleEntryIterator* self) {
+    const char* json_text;
+    size_t length;
+    
+    // Entry text lives in the stream buffer, which another thread's next() would overwrite
+    int busy;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    busy = self->busy;
+    self->busy = 1;
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (busy) {
+        PyErr_SetString(PyExc_RuntimeError, "BundleEntryIterator is already in use by another thread");
+        return NULL;
+    }
     
-    if (!PyArg_ParseTuple(args, "ss", &json_string, &field_name)) {
+    FHIRBundleStreamResult result = fhir_bundle_stream_next(self->stream, &json_text, &length);
+    cJSON* json = NULL;
+    if (result == FHIR_BUNDLE_STREAM_ENTRY) {
+        FHIR_BEGIN_ALLOW_THREADS(length)
+        json = fhir_json_parse(json_text, length);
+        FHIR_END_ALLOW_THREADS
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    self->busy = 0;
+    FHIR_PY_END_CRITICAL_SECTION();
+    
+    if (result == FHIR_BUNDLE_STREAM_END) {
+        return NULL;
+    }
+    if (result == FHIR_BUNDLE_STREAM_ERROR) {
+        if (!PyErr_Occurred()) {
+            const char* message = fhir_bundle_stream_get_error(self->stream);
+            PyErr_Format(PyExc_ValueError, "%s (at byte %zu)",
+                         message ? message : "Invalid Bundle",
+                         fhir_bundle_stream_get_offset(self->stream));
+        }
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
     if (json == NULL) {
-        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        PyErr_Format(PyExc_ValueError, "Invalid JSON in Bundle entry (at byte %zu)",
+                     fhir_bundle_stream_get_offset(self->stream));
+        return NULL;
+    }
+    
+    ParserModuleState* state = parser_state((PyObject*)self);
+    PyObject* resource = state ? fhir_cjson_to_python_cached(json, &state->keys) : NULL;
+    cJSON_Delete(json);
+    return resource;
+}
+
+static PyType_Slot BundleEntryIteratorSlots[] = {
+    {Py_tp_doc, "Iterator over the entry resources of a FHIR Bundle"},
+    {Py_tp_dealloc, BundleEntryIterator_dealloc},
+    {Py_tp_iter, PyObject_SelfIter},
+    {Py_tp_iternext, BundleEntryIterator_next},
+    {0, NULL}
+};
+
+static PyType_Spec BundleEntryIteratorSpec = {
+    .name = "fhir_parser_c.BundleEntryIterator",
+    .basicsize = sizeof(BundleEntryIterator),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = BundleEntryIteratorSlots,
+};
+
+// Streaming iteration over Bundle entries from str, bytes-like objects or files
+static PyObject* iter_bundle_entries(PyObject* self, PyObject* source) {
+    ParserModuleState* state = PyModule_GetState(self);
+    BundleEntryIterator* iterator = PyObject_New(BundleEntryIterator, state->bundle_entry_iterator_type);
+    if (!iterator) {
         return NULL;
     }
+    iterator->stream = NULL;
+    iterator->source = NULL;
+    iterator->has_view = 0;
+    iterator->read_method = NULL;
+    iterator->pending = NULL;
+    iterator->pending_offset = 0;
+    iterator->busy = 0;
     
-    cJSON* field = cJSON_GetObjectItemCaseSensitive(json, field_name);
-    PyObject* result = Py_None;
-    Py_INCREF(result);
+    Py_INCREF(source);
+    iterator->source = source;
     
-    if (field != NULL) {
-        if (cJSON_IsString(field) && (field->valuestring != NULL)) {
-            result = PyUnicode_FromString(field->valuestring);
-            Py_DECREF(Py_None);
-        } else if (cJSON_IsBool(field)) {
-            result = cJSON_IsTrue(field) ? Py_True : Py_False;
-            Py_INCREF(result);
-            Py_DECREF(Py_None);
-        } else if (cJSON_IsNumber(field)) {
-            if (field->valuedouble == (int)field->valuedouble) {
-                result = PyLong_FromLong((long)field->valuedouble);
-            } else {
-                result = PyFloat_FromDouble(field->valuedouble);
+    if (PyUnicode_Check(source)) {
+        Py_ssize_t size;
+        const char* data = PyUnicode_AsUTF8AndSize(source, &size);
+        if (!data) {
+            Py_DECREF(iterator);
+            return NULL;
+        }
+        iterator->stream = fhir_bundle_stream_create_from_buffer(data, (size_t)size);
+    } else if (PyObject_CheckBuffer(source)) {
+        // bytes, bytearray, memoryview and mmap are scanned in place
+        if (PyObject_GetBuffer(source, &iterator->view, PyBUF_SIMPLE) < 0) {
+            Py_DECREF(iterator);
+            return NULL;
+        }
+        iterator->has_view = 1;
+        iterator->stream = fhir_bundle_stream_create_from_buffer(iterator->view.buf,
+                                                                 (size_t)iterator->view.len);
+    } else {
+        iterator->read_method = PyObject_GetAttrString(source, "read");
+        if (!iterator->read_method) {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_TypeError,
+                            "source must be str, a bytes-like object or a file object");
+            Py_DECREF(iterator);
+            return NULL;
+        }
+        iterator->stream = fhir_bundle_stream_create(BundleEntryIterator_read, iterator, 0);
+    }
+    
+    if (!iterator->stream) {
+        Py_DECREF(iterator);
+        return PyErr_NoMemory();
+    }
+    
+    return (PyObject*)iterator;
+}
+
+// BundleFeed: Bundle entries tokenized from chunks pushed as they arrive
+typedef struct {
+    PyObject_HEAD
+    FHIRBundleStream* stream;
+    int closed;
+} BundleFeed;
+
+static int BundleFeed_init(BundleFeed* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+        return -1;
+    }
+    
+    FHIRBundleStream* stream = fhir_bundle_stream_create_push();
+    if (stream == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_bundle_stream_destroy(self->stream);
+    self->stream = stream;
+    self->closed = 0;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void BundleFeed_dealloc(BundleFeed* self) {
+    fhir_bundle_stream_destroy(self->stream);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int BundleFeed_check_ready(const BundleFeed* self) {
+    if (self->stream == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "BundleFeed is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+// Resource texts of the entries completed so far, as bytes; NULL with ValueError on a bad Bundle
+static PyObject* bundle_feed_drain(BundleFeed* self) {
+    PyObject* entries = PyList_New(0);
+    if (entries == NULL) {
+        return NULL;
+    }
+    
+    for (;;) {
+        const char* json_text;
+        size_t length;
+        FHIRBundleStreamResult result = fhir_bundle_stream_next(self->stream, &json_text, &length);
+        if (result == FHIR_BUNDLE_STREAM_END || result == FHIR_BUNDLE_STREAM_NEED_MORE) {
+            return entries;
+        }
+        if (result == FHIR_BUNDLE_STREAM_ERROR) {
+            const char* message = fhir_bundle_stream_get_error(self->stream);
+            PyErr_Format(PyExc_ValueError, "%s (at byte %zu)", message ? message : "Invalid Bundle",
+                         fhir_bundle_stream_get_offset(self->stream));
+            Py_DECREF(entries);
+            return NULL;
+        }
+        
+        PyObject* entry = PyBytes_FromStringAndSize(json_text, (Py_ssize_t)length);
+        if (entry == NULL || PyList_Append(entries, entry) < 0) {
+            Py_XDECREF(entry);
+            Py_DECREF(entries);
+            return NULL;
+        }
+        Py_DECREF(entry);
+    }
+}
+
+static PyObject* BundleFeed_feed(BundleFeed* self, PyObject* chunk) {
+    Py_buffer view;
+    if (!BundleFeed_check_ready(self) || !fhir_python_buffer_arg(chunk, &view)) {
+        return NULL;
+    }
+    
+    PyObject* entries = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "BundleFeed is closed");
+    } else if (!fhir_bundle_stream_feed(self->stream, view.buf, (size_t)view.len)) {
+        PyErr_NoMemory();
+    } else {
+        entries = bundle_feed_drain(self);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    PyBuffer_Release(&view);
+    return entries;
+}
+
+static PyObject* BundleFeed_close(BundleFeed* self, PyObject* Py_UNUSED(ignored)) {
+    if (!BundleFeed_check_ready(self)) {
+        return NULL;
+    }
+    
+    PyObject* entries;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    self->closed = 1;
+    fhir_bundle_stream_finish(self->stream);
+    entries = bundle_feed_drain(self);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return entries;
+}
+
+static PyMethodDef BundleFeedMethods[] = {
+    {"feed", (PyCFunction)BundleFeed_feed, METH_O,
+     "feed(chunk): add the next bytes of the Bundle; returns the resource JSON (bytes) of entries completed by it"},
+    {"close", (PyCFunction)BundleFeed_close, METH_NOARGS,
+     "End the input; returns the remaining entries, or raises ValueError for a Bundle cut short"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot BundleFeedSlots[] = {
+    {Py_tp_doc, "Push tokenizer over the entry resources of a Bundle that arrives in chunks"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, BundleFeed_init},
+    {Py_tp_dealloc, BundleFeed_dealloc},
+    {Py_tp_methods, BundleFeedMethods},
+    {0, NULL}
+};
+
+static PyType_Spec BundleFeedSpec = {
+    .name = "fhir_parser_c.BundleFeed",
+    .basicsize = sizeof(BundleFeed),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = BundleFeedSlots,
+};
+
+// CompiledPath: a FHIRPath expression compiled once and evaluated many times
+typedef struct {
+    PyObject_HEAD
+    FHIRPathProgram* program;
+} CompiledPath;
+
+static int CompiledPath_init(CompiledPath* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"expression", NULL};
+    const char* expression;
+    
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", kwlist, &expression)) {
+        return -1;
+    }
+    
+    FHIRPathProgram* program = fhir_path_compile(expression);
+    if (program == NULL) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            PyErr_NoMemory();
+        } else {
+            PyErr_SetString(PyExc_ValueError, error ? error->message : "Invalid FHIRPath expression");
+        }
+        return -1;
+    }
+    
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_path_destroy(self->program);
+    self->program = program;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void CompiledPath_dealloc(CompiledPath* self) {
+    fhir_path_destroy(self->program);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int CompiledPath_check_ready(const CompiledPath* self) {
+    if (self->program == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "CompiledPath is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+// Convert selected nodes to a list: scalars as values, elements as dicts and lists
+static PyObject* path_result_to_python(const FHIRPathResult* result, FHIRPythonKeyCache* keys) {
+    PyObject* list = PyList_New((Py_ssize_t)result->count);
+    if (list == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < result->count; i++) {
+        const cJSON* node = result->items[i];
+        PyObject* value = (cJSON_IsObject(node) || cJSON_IsArray(node)) ? fhir_cjson_to_python_cached(node, keys)
+                                                                        : field_to_python(node);
+        if (value == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, value);
+    }
+    return list;
+}
+
+static PyObject* CompiledPath_evaluate(CompiledPath* self, PyObject* document) {
+    ParserModuleState* state = parser_state((PyObject*)self);
+    if (!state || !CompiledPath_check_ready(self)) {
+        return NULL;
+    }
+    
+    cJSON* owned;
+    const cJSON* json = fhir_python_document_json(&parser_documents, document, &owned);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+    PyObject* values = fhir_path_evaluate(self->program, json, &result) ? path_result_to_python(&result, &state->keys)
+                                                                        : PyErr_NoMemory();
+    fhir_path_result_cleanup(&result);
+    cJSON_Delete(owned);
+    return values;
+}
+
+static PyObject* CompiledPath_get_expression(CompiledPath* self, void* Py_UNUSED(closure)) {
+    if (!CompiledPath_check_ready(self)) {
+        return NULL;
+    }
+    return PyUnicode_FromString(fhir_path_get_expression(self->program));
+}
+
+static PyMethodDef CompiledPathMethods[] = {
+    {"evaluate", (PyCFunction)CompiledPath_evaluate, METH_O,
+     "Evaluate against a ParsedDocument or JSON text; returns the list of selected values"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef CompiledPathGetSet[] = {
+    {"expression", (getter)CompiledPath_get_expression, NULL, "Source expression", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot CompiledPathSlots[] = {
+    {Py_tp_doc, "FHIRPath expression (extraction subset) compiled for repeated evaluation"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, CompiledPath_init},
+    {Py_tp_dealloc, CompiledPath_dealloc},
+    {Py_tp_methods, CompiledPathMethods},
+    {Py_tp_getset, CompiledPathGetSet},
+    {0, NULL}
+};
+
+static PyType_Spec CompiledPathSpec = {
+    .name = "fhir_parser_c.CompiledPath",
+    .basicsize = sizeof(CompiledPath),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = CompiledPathSlots,
+};
+
+// Evaluate N compiled paths over M documents; returns one list of value lists per document
+static PyObject* evaluate_paths(PyObject* self, PyObject* args) {
+    PyObject* path_arg;
+    PyObject* document_arg;
+    if (!PyArg_ParseTuple(args, "OO", &path_arg, &document_arg)) {
+        return NULL;
+    }
+    ParserModuleState* state = PyModule_GetState(self);
+    
+    PyObject* paths = PySequence_Fast(path_arg, "paths must be a sequence of CompiledPath");
+    if (paths == NULL) {
+        return NULL;
+    }
+    PyObject* documents = PySequence_Fast(document_arg, "documents must be a sequence");
+    if (documents == NULL) {
+        Py_DECREF(paths);
+        return NULL;
+    }
+    
+    size_t path_count = (size_t)PySequence_Fast_GET_SIZE(paths);
+    size_t document_count = (size_t)PySequence_Fast_GET_SIZE(documents);
+    const FHIRPathProgram** programs = PyMem_Calloc(path_count, sizeof(FHIRPathProgram*));
+    const cJSON** trees = PyMem_Calloc(document_count, sizeof(cJSON*));
+    cJSON** owned = PyMem_Calloc(document_count, sizeof(cJSON*));
+    FHIRPathResult* results = PyMem_Calloc(path_count * document_count, sizeof(FHIRPathResult));
+    PyObject* output = NULL;
+    bool ok = false;
+    
+    if (programs == NULL || trees == NULL || owned == NULL || results == NULL) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    for (size_t p = 0; p < path_count; p++) {
+        PyObject* path = PySequence_Fast_GET_ITEM(paths, p);
+        if (!PyObject_TypeCheck(path, state->compiled_path_type)) {
+            PyErr_SetString(PyExc_TypeError, "paths must be a sequence of CompiledPath");
+            goto cleanup;
+        }
+        if (!CompiledPath_check_ready((CompiledPath*)path)) {
+            goto cleanup;
+        }
+        programs[p] = ((CompiledPath*)path)->program;
+    }
+    for (size_t d = 0; d < document_count; d++) {
+        trees[d] = fhir_python_document_json(&parser_documents, PySequence_Fast_GET_ITEM(documents, d), &owned[d]);
+        if (trees[d] == NULL) {
+            goto cleanup;
+        }
+    }
+    
+    // Evaluation only reads the trees, so it runs without the GIL
+    Py_BEGIN_ALLOW_THREADS
+    ok = fhir_path_evaluate_batch((const FHIRPathProgram* const*)programs, path_count,
+                                  (const cJSON* const*)trees, document_count, results);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    
+    output = PyList_New((Py_ssize_t)document_count);
+    for (size_t d = 0; output != NULL && d < document_count; d++) {
+        PyObject* row = PyList_New((Py_ssize_t)path_count);
+        for (size_t p = 0; row != NULL && p < path_count; p++) {
+            PyObject* values = path_result_to_python(&results[d * path_count + p], &state->keys);
+            if (values == NULL) {
+                Py_CLEAR(row);
+                break;
             }
-            Py_DECREF(Py_None);
+            PyList_SET_ITEM(row, (Py_ssize_t)p, values);
+        }
+        if (row == NULL) {
+            Py_CLEAR(output);
+            break;
+        }
+        PyList_SET_ITEM(output, (Py_ssize_t)d, row);
+    }
+    
+cleanup:
+    if (results != NULL) {
+        for (size_t i = 0; i < path_count * document_count; i++) {
+            fhir_path_result_cleanup(&results[i]);
+        }
+    }
+    if (owned != NULL) {
+        for (size_t d = 0; d < document_count; d++) {
+            cJSON_Delete(owned[d]);
+        }
+    }
+    PyMem_Free(programs);
+    PyMem_Free((void*)trees);
+    PyMem_Free(owned);
+    PyMem_Free(results);
+    Py_DECREF(paths);
+    Py_DECREF(documents);
+    return output;
+}
+
+// Parse a resource and check it against its structure rules, returning the validated dict
+static PyObject* parse_validated(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+    Py_buffer view;
+    const char* resource_type = NULL;
+    if (!fhir_python_check_args("parse_validated", nargs, 1, 2) ||
+        (nargs > 1 && !fhir_python_optional_text_arg(args[1], &resource_type)) ||
+        !fhir_python_buffer_arg(args[0], &view)) {
+        return NULL;
+    }
+    
+    cJSON* json;
+    bool valid = false;
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json != NULL) {
+        valid = fhir_structure_validate(json, resource_type);
+    }
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    
+    if (json == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!valid) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->field && error->code != FHIR_ERROR_INVALID_RESOURCE_TYPE) {
+            PyErr_Format(PyExc_ValueError, "%s: %s", error->message, error->field);
+        } else {
+            PyErr_SetString(PyExc_ValueError, error ? error->message : "Invalid resource");
         }
+        cJSON_Delete(json);
+        return NULL;
     }
     
+    ParserModuleState* state = PyModule_GetState(self);
+    PyObject* result = fhir_cjson_to_python_cached(json, &state->keys);
     cJSON_Delete(json);
     return result;
 }
 
+// Build the structured error dict of one failed batch document
+static PyObject* batch_error_to_python(Py_ssize_t index, const FHIRStructureInput* input,
+                                       const FHIRStructureResult* result) {
+    PyObject* line = Py_None;
+    PyObject* field = Py_None;
+    if (input->line_number) {
+        line = PyLong_FromSize_t(input->line_number);
+    } else {
+        Py_INCREF(line);
+    }
+    if (result->error_field[0]) {
+        field = PyUnicode_FromString(result->error_field);
+    } else {
+        Py_INCREF(field);
+    }
+    if (!line || !field) {
+        Py_XDECREF(line);
+        Py_XDECREF(field);
+        return NULL;
+    }
+    return Py_BuildValue("{s:n,s:N,s:s,s:s,s:N}", "index", index, "line", line,
+                         "code", fhir_error_code_to_string(result->error_code),
+                         "message", result->error_message, "field", field);
+}
+
+// Parse and validate many resources in one call; returns (results, errors)
+static PyObject* parse_validated_many(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "resource_type", "threads", NULL};
+    PyObject* source;
+    const char* resource_type = NULL;
+    Py_ssize_t threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|zn", kwlist, &source, &resource_type, &threads)) {
+        return NULL;
+    }
+    if (threads < 0) {
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0");
+        return NULL;
+    }
+    
+    // Split one NDJSON or JSON array buffer, or borrow the buffer of each item of an iterable
+    PyObject* items = NULL;
+    Py_buffer* views = NULL;
+    Py_buffer source_view;
+    bool has_source_view = false;
+    FHIRStructureInput* inputs = NULL;
+    size_t count = 0;
+    size_t length = 0;
+    if (PyUnicode_Check(source) || PyObject_CheckBuffer(source)) {
+        if (!fhir_python_buffer_arg(source, &source_view)) {
+            return NULL;
+        }
+        has_source_view = true;
+        const char* text = source_view.buf;
+        length = (size_t)source_view.len;
+        size_t start = 0;
+        while (start < length && strchr(" \t\r\n", text[start]) != NULL) start++;
+        bool array = start < length && text[start] == '[';
+        
+        FHIR_BEGIN_ALLOW_THREADS(length)
+        inputs = array ? fhir_structure_split_array(text, length, &count)
+                       : fhir_structure_split_lines(text, length, &count);
+        FHIR_END_ALLOW_THREADS
+        
+        if (!inputs) {
+            PyBuffer_Release(&source_view);
+            // Failed allocations leave no error set
+            const FHIRError* error = fhir_get_last_error();
+            if (!error || error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+                return PyErr_NoMemory();
+            }
+            PyErr_SetString(PyExc_ValueError, error->message ? error->message : "Invalid NDJSON or JSON array");
+            return NULL;
+        }
+    } else {
+        items = PySequence_Fast(source, "source must be str, a bytes-like object or an iterable of them");
+        if (!items) {
+            return NULL;
+        }
+        count = (size_t)PySequence_Fast_GET_SIZE(items);
+        inputs = fhir_malloc((count ? count : 1) * sizeof(FHIRStructureInput));
+        views = fhir_malloc((count ? count : 1) * sizeof(Py_buffer));
+        if (!inputs || !views) {
+            fhir_free(inputs);
+            fhir_free(views);
+            Py_DECREF(items);
+            return PyErr_NoMemory();
+        }
+        PyObject** item_array = PySequence_Fast_ITEMS(items);
+        for (size_t i = 0; i < count; i++) {
+            if (!fhir_python_buffer_arg(item_array[i], &views[i])) {
+                while (i > 0) PyBuffer_Release(&views[--i]);
+                fhir_free(views);
+                fhir_free(inputs);
+                Py_DECREF(items);
+                return NULL;
+            }
+            inputs[i].text = views[i].buf;
+            inputs[i].length = (size_t)views[i].len;
+            inputs[i].line_number = 0;
+            length += (size_t)views[i].len;
+        }
+    }
+    
+    FHIRStructureResult* results = fhir_calloc(count ? count : 1, sizeof(FHIRStructureResult));
+    if (results) {
+        FHIR_BEGIN_ALLOW_THREADS(length)
+        fhir_structure_validate_batch(inputs, count, resource_type, (size_t)threads, results);
+        FHIR_END_ALLOW_THREADS
+    }
+    
+    // The parsed trees no longer reference the input buffers
+    if (has_source_view) {
+        PyBuffer_Release(&source_view);
+    }
+    for (size_t i = 0; views && i < count; i++) {
+        PyBuffer_Release(&views[i]);
+    }
+    fhir_free(views);
+    if (!results) {
+        fhir_free(inputs);
+        Py_XDECREF(items);
+        return PyErr_NoMemory();
+    }
+    
+    // Results stay aligned with the input; failed documents are None and listed in errors
+    ParserModuleState* state = PyModule_GetState(self);
+    PyObject* resources = PyList_New((Py_ssize_t)count);
+    PyObject* errors = PyList_New(0);
+    for (size_t i = 0; resources && errors && i < count; i++) {
+        if (results[i].json) {
+            PyObject* item = fhir_cjson_to_python_cached(results[i].json, &state->keys);
+            if (!item) {
+                Py_CLEAR(resources);
+                break;
+            }
+            PyList_SET_ITEM(resources, (Py_ssize_t)i, item);
+        } else {
+            Py_INCREF(Py_None);
+            PyList_SET_ITEM(resources, (Py_ssize_t)i, Py_None);
+            PyObject* error = batch_error_to_python((Py_ssize_t)i, &inputs[i], &results[i]);
+            if (!error || PyList_Append(errors, error) < 0) {
+                Py_XDECREF(error);
+                Py_CLEAR(resources);
+                break;
+            }
+            Py_DECREF(error);
+        }
+    }
+    
+    fhir_structure_results_clear(results, count);
+    fhir_free(results);
+    fhir_free(inputs);
+    Py_XDECREF(items);
+    if (!resources || !errors) {
+        Py_XDECREF(resources);
+        Py_XDECREF(errors);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", resources, errors);
+}
+
+// Name of the JSON parser backend this module parses with
+static PyObject* json_backend(PyObject* self, PyObject* Py_UNUSED(args)) {
+    return PyUnicode_FromString(fhir_json_backend_name(fhir_json_get_backend()));
+}
+
+// Select the JSON parser backend by name ("auto", "cjson", "scalar", "sse2", "avx2", "neon")
+static PyObject* set_json_backend(PyObject* self, PyObject* arg) {
+    const char* name;
+    if (!fhir_python_text_arg(arg, &name, NULL)) {
+        return NULL;
+    }
+    
+    FHIRJSONBackend backend;
+    if (!fhir_json_backend_from_name(name, &backend)) {
+        PyErr_Format(PyExc_ValueError, "Unknown JSON backend: %s", name);
+        return NULL;
+    }
+    if (!fhir_json_set_backend(backend)) {
+        PyErr_Format(PyExc_ValueError, "JSON backend not supported on this CPU: %s", name);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// Names of the JSON parser backends this build and CPU support
+static PyObject* json_backends(PyObject* self, PyObject* Py_UNUSED(args)) {
+    PyObject* names = PyList_New(0);
+    for (int i = FHIR_JSON_BACKEND_CJSON; names && i < FHIR_JSON_BACKEND_COUNT; i++) {
+        if (!fhir_json_backend_supported((FHIRJSONBackend)i)) {
+            continue;
+        }
+        PyObject* name = PyUnicode_FromString(fhir_json_backend_name((FHIRJSONBackend)i));
+        if (!name || PyList_Append(names, name) < 0) {
+            Py_XDECREF(name);
+            Py_CLEAR(names);
+            break;
+        }
+        Py_DECREF(name);
+    }
+    return names;
+}
+
 // Method definitions
 static PyMethodDef FHIRParserMethods[] = {
     {"validate_fhir_json", validate_fhir_json, METH_VARARGS, "Validate FHIR JSON structure"},
     {"extract_resource_type", extract_resource_type, METH_VARARGS, "Extract resourceType from JSON"},
+    {"resource_type_code", resource_type_code, METH_O, "Map a resource type name to its FHIRResourceType code"},
     {"count_bundle_entries", count_bundle_entries, METH_VARARGS, "Count entries in FHIR Bundle"},
     {"extract_field", extract_field, METH_VARARGS, "Extract field value from JSON"},
+    {"extract_fields", extract_fields, METH_VARARGS, "Extract several field values from JSON as a dict"},
+    {"extract_search_index", extract_search_index, METH_VARARGS, "Extract search parameter index rows from JSON"},
+    {"iter_bundle_entries", iter_bundle_entries, METH_O, "Iterate over Bundle entry resources without loading the whole Bundle"},
+    {"evaluate_paths", evaluate_paths, METH_VARARGS, "Evaluate CompiledPaths over documents; returns a list of value lists per document"},
+    {"parse_validated", (PyCFunction)(void (*)(void))parse_validated, METH_FASTCALL,
+     "Parse a resource, check it against its structure rules and return it as a dict"},
+    {"parse_validated_many", (PyCFunction)(void (*)(void))parse_validated_many, METH_VARARGS | METH_KEYWORDS,
+     "Parse and validate many resources on a worker pool; returns (results, errors)"},
+    {"json_backend", json_backend, METH_NOARGS, "Name of the JSON parser backend in use"},
+    {"set_json_backend", set_json_backend, METH_O, "Select the JSON parser backend by name"},
+    {"json_backends", json_backends, METH_NOARGS, "Names of the JSON parser backends supported on this CPU"},
     {NULL, NULL, 0, NULL}
 };
 
+static int parser_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    ParserModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->parsed_document_type);
+    Py_VISIT(state->bundle_entry_iterator_type);
+    Py_VISIT(state->bundle_feed_type);
+    Py_VISIT(state->compiled_path_type);
+    Py_VISIT(state->resource_type_codes);
+    return 0;
+}
+
+static int parser_module_clear(PyObject* module) {
+    ParserModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->parsed_document_type);
+    Py_CLEAR(state->bundle_entry_iterator_type);
+    Py_CLEAR(state->bundle_feed_type);
+    Py_CLEAR(state->compiled_path_type);
+    Py_CLEAR(state->resource_type_codes);
+    fhir_python_key_cache_clear(&state->keys);
+    return 0;
+}
+
+static void parser_module_free(void* module) {
+    parser_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int parser_module_exec(PyObject* module) {
+    ParserModuleState* state = PyModule_GetState(module);
+    
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+    
+    // Other extensions borrow the trees of ParsedDocuments through this capsule
+    PyObject* documents = PyCapsule_New((void*)&parser_documents, FHIR_PY_DOCUMENTS_CAPSULE, NULL);
+    if (documents == NULL) {
+        return -1;
+    }
+    if (PyModule_AddObject(module, FHIR_PY_DOCUMENTS_ATTRIBUTE, documents) < 0) {
+        Py_DECREF(documents);
+        return -1;
+    }
+    
+    if (PyModule_AddIntConstant(module, "RESOURCE_TYPE_UNKNOWN", FHIR_RESOURCE_TYPE_UNKNOWN) < 0 ||
+        PyModule_AddIntConstant(module, "RESOURCE_TYPE_COUNT", FHIR_RESOURCE_TYPE_COUNT) < 0) {
+        return -1;
+    }
+    
+    state->resource_type_codes = PyDict_New();
+    if (state->resource_type_codes == NULL) {
+        return -1;
+    }
+    
+    struct {
+        PyTypeObject** slot;
+        PyType_Spec* spec;
+    } types[] = {
+        {&state->parsed_document_type, &ParsedDocumentSpec},
+        {&state->bundle_entry_iterator_type, &BundleEntryIteratorSpec},
+        {&state->bundle_feed_type, &BundleFeedSpec},
+        {&state->compiled_path_type, &CompiledPathSpec},
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if ((*types[i].slot = fhir_python_add_type(module, types[i].spec)) == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static PyModuleDef_Slot parser_module_slots[] = FHIR_PY_MODULE_SLOTS(parser_module_exec);
+
 // Module definition
 static struct PyModuleDef fhir_parser_module = {
     PyModuleDef_HEAD_INIT,
     "fhir_parser_c",
     "Fast FHIR parsing utilities in C",
-    -1,
-    FHIRParserMethods
+    sizeof(ParserModuleState),
+    FHIRParserMethods,
+    parser_module_slots,
+    parser_module_traverse,
+    parser_module_clear,
+    parser_module_free
 };
 
 // Module initialization
 PyMODINIT_FUNC PyInit_fhir_parser_c(void) {
-    return PyModule_Create(&fhir_parser_module);
-}
\ No newline at end of file
+    return PyModuleDef_Init(&fhir_parser_module);
+}
@@ -0,0 +1,1335 @@
+/**
+ * @file fhir_patch.c
+ * @brief JSON Patch (RFC 6902) and FHIRPath Patch applied in place
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_patch.h"
+#include "fhir_path.h"
+#include "common/fhir_json_reader.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Patch Representation                                                       */
+/* ========================================================================== */
+
+typedef enum {
+    FHIR_PATCH_OP_ADD,
+    FHIR_PATCH_OP_REMOVE,
+    FHIR_PATCH_OP_REPLACE,
+    FHIR_PATCH_OP_MOVE,
+    FHIR_PATCH_OP_COPY,
+    FHIR_PATCH_OP_TEST,
+    FHIR_PATCH_OP_INSERT,   // FHIRPath Patch only
+    FHIR_PATCH_OP_DELETE    // FHIRPath Patch only
+} FHIRPatchOpcode;
+
+// JSON Pointer split into unescaped reference tokens ("" has none)
+typedef struct {
+    char** tokens;
+    size_t count;
+} FHIRPatchPointer;
+
+typedef struct {
+    FHIRPatchOpcode opcode;
+    FHIRPatchPointer path;          // JSON Patch
+    FHIRPatchPointer from;          // JSON Patch move/copy
+    FHIRPathProgram* program;       // FHIRPath Patch path
+    FHIRPathProgram* container;     // FHIRPath insert: element holding the list, to create it
+    char* name;                     // FHIRPath add: element name; insert: list name
+    cJSON* value;                   // Detached value (no member name)
+    int index;
+    int source;
+    int destination;
+    char* member;                   // Top-level member the path starts at, NULL if unknown
+    char* from_member;
+} FHIRPatchOperation;
+
+struct FHIRPatch {
+    FHIRPatchFormat format;
+    FHIRPatchOperation* operations;
+    size_t count;
+    bool members_known;             // Every operation's top-level member is known statically
+};
+
+static bool patch_fail(FHIRErrorCode code, size_t operation, const char* message) {
+    char buffer[FHIR_ERROR_MESSAGE_MAX];
+    snprintf(buffer, sizeof(buffer), "Patch operation %zu: %s", operation, message);
+    FHIR_SET_ERROR(code, buffer);
+    return false;
+}
+
+static void pointer_cleanup(FHIRPatchPointer* pointer) {
+    for (size_t i = 0; i < pointer->count; i++) {
+        fhir_free(pointer->tokens[i]);
+    }
+    fhir_free(pointer->tokens);
+    pointer->tokens = NULL;
+    pointer->count = 0;
+}
+
+static void operation_cleanup(FHIRPatchOperation* operation) {
+    pointer_cleanup(&operation->path);
+    pointer_cleanup(&operation->from);
+    fhir_path_destroy(operation->program);
+    fhir_path_destroy(operation->container);
+    fhir_free(operation->name);
+    fhir_free(operation->member);
+    fhir_free(operation->from_member);
+    if (operation->value) {
+        cJSON_Delete(operation->value);
+    }
+}
+
+void fhir_patch_destroy(FHIRPatch* patch) {
+    if (!patch) return;
+
+    for (size_t i = 0; i < patch->count; i++) {
+        operation_cleanup(&patch->operations[i]);
+    }
+    fhir_free(patch->operations);
+    fhir_free(patch);
+}
+
+FHIRPatchFormat fhir_patch_get_format(const FHIRPatch* patch) {
+    return patch ? patch->format : FHIR_PATCH_JSON_PATCH;
+}
+
+size_t fhir_patch_get_operation_count(const FHIRPatch* patch) {
+    return patch ? patch->count : 0;
+}
+
+static FHIRPatch* patch_create(FHIRPatchFormat format, size_t count) {
+    FHIRPatch* patch = fhir_calloc(1, sizeof(FHIRPatch));
+    if (!patch) return NULL;
+
+    patch->format = format;
+    patch->members_known = true;
+    if (count > 0) {
+        patch->operations = fhir_calloc(count, sizeof(FHIRPatchOperation));
+        if (!patch->operations) {
+            fhir_free(patch);
+            return NULL;
+        }
+    }
+    return patch;
+}
+
+// Drop the member name a detached item had in its object
+static cJSON* strip_name(cJSON* item) {
+    if (item && item->string) {
+        if (!(item->type & cJSON_StringIsConst)) {
+            cJSON_free(item->string);
+        }
+        item->string = NULL;
+        item->type &= ~cJSON_StringIsConst;
+    }
+    return item;
+}
+
+static cJSON* copy_value(const cJSON* item) {
+    return strip_name(cJSON_Duplicate(item, 1));
+}
+
+/* ========================================================================== */
+/* JSON Patch Compilation                                                     */
+/* ========================================================================== */
+
+// Split "/a/b~1c" into {"a", "b/c"}; ~1 is '/' and ~0 is '~'
+static bool pointer_parse(const char* text, FHIRPatchPointer* pointer) {
+    pointer->tokens = NULL;
+    pointer->count = 0;
+    if (text[0] == '\0') {
+        return true;
+    }
+    if (text[0] != '/') {
+        return false;
+    }
+
+    size_t count = 0;
+    for (const char* c = text; *c; c++) {
+        count += *c == '/';
+    }
+    pointer->tokens = fhir_calloc(count, sizeof(char*));
+    if (!pointer->tokens) {
+        return false;
+    }
+
+    const char* start = text + 1;
+    while (pointer->count < count) {
+        const char* end = strchr(start, '/');
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        char* token = fhir_malloc(length + 1);
+        if (!token) {
+            pointer_cleanup(pointer);
+            return false;
+        }
+        pointer->tokens[pointer->count++] = token;
+
+        size_t out = 0;
+        for (size_t i = 0; i < length; i++) {
+            if (start[i] != '~') {
+                token[out++] = start[i];
+            } else if (i + 1 < length && (start[i + 1] == '0' || start[i + 1] == '1')) {
+                token[out++] = start[++i] == '0' ? '~' : '/';
+            } else {
+                pointer_cleanup(pointer);
+                return false;
+            }
+        }
+        token[out] = '\0';
+        start += length + 1;
+    }
+    return true;
+}
+
+static bool compile_pointer(const cJSON* operation, const char* member, FHIRPatchPointer* pointer,
+                            size_t index) {
+    const cJSON* text = cJSON_GetObjectItemCaseSensitive(operation, member);
+    if (!cJSON_IsString(text) || !text->valuestring) {
+        char message[64];
+        snprintf(message, sizeof(message), "missing \"%s\"", member);
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, message);
+    }
+    if (!pointer_parse(text->valuestring, pointer)) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "invalid JSON Pointer");
+    }
+    return true;
+}
+
+static bool compile_json_operation(FHIRPatch* patch, const cJSON* item, size_t index) {
+    static const struct {
+        const char* name;
+        FHIRPatchOpcode opcode;
+    } opcodes[] = {
+        {"add", FHIR_PATCH_OP_ADD}, {"remove", FHIR_PATCH_OP_REMOVE},
+        {"replace", FHIR_PATCH_OP_REPLACE}, {"move", FHIR_PATCH_OP_MOVE},
+        {"copy", FHIR_PATCH_OP_COPY}, {"test", FHIR_PATCH_OP_TEST}
+    };
+    FHIRPatchOperation* operation = &patch->operations[index];
+
+    const cJSON* op = cJSON_GetObjectItemCaseSensitive(item, "op");
+    if (!cJSON_IsObject(item) || !cJSON_IsString(op) || !op->valuestring) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "expected an object with \"op\"");
+    }
+    size_t found = sizeof(opcodes) / sizeof(opcodes[0]);
+    for (size_t i = 0; i < sizeof(opcodes) / sizeof(opcodes[0]); i++) {
+        if (strcmp(opcodes[i].name, op->valuestring) == 0) {
+            found = i;
+            break;
+        }
+    }
+    if (found == sizeof(opcodes) / sizeof(opcodes[0])) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "unknown op");
+    }
+    operation->opcode = opcodes[found].opcode;
+
+    if (!compile_pointer(item, "path", &operation->path, index)) {
+        return false;
+    }
+    bool has_from = operation->opcode == FHIR_PATCH_OP_MOVE || operation->opcode == FHIR_PATCH_OP_COPY;
+    if (has_from && !compile_pointer(item, "from", &operation->from, index)) {
+        return false;
+    }
+
+    // Replacing the whole resource is not an in-place edit
+    if ((operation->path.count == 0 && operation->opcode != FHIR_PATCH_OP_TEST) ||
+        (has_from && operation->from.count == 0)) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "operation on the document root");
+    }
+
+    if (operation->opcode == FHIR_PATCH_OP_ADD || operation->opcode == FHIR_PATCH_OP_REPLACE ||
+        operation->opcode == FHIR_PATCH_OP_TEST) {
+        const cJSON* value = cJSON_GetObjectItemCaseSensitive(item, "value");
+        if (!value) {
+            return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "missing \"value\"");
+        }
+        operation->value = copy_value(value);
+        if (!operation->value) {
+            return false;
+        }
+    }
+
+    if (operation->path.count > 0) {
+        operation->member = fhir_strdup(operation->path.tokens[0]);
+        if (!operation->member) return false;
+    } else {
+        patch->members_known = false;
+    }
+    if (has_from) {
+        operation->from_member = fhir_strdup(operation->from.tokens[0]);
+        if (!operation->from_member) return false;
+    }
+    return true;
+}
+
+FHIRPatch* fhir_patch_compile_json_patch(const cJSON* operations) {
+    if (!cJSON_IsArray(operations)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "JSON Patch must be an array");
+        return NULL;
+    }
+
+    FHIRPatch* patch = patch_create(FHIR_PATCH_JSON_PATCH, (size_t)cJSON_GetArraySize(operations));
+    if (!patch) return NULL;
+
+    const cJSON* item;
+    cJSON_ArrayForEach(item, operations) {
+        if (!compile_json_operation(patch, item, patch->count++)) {
+            fhir_patch_destroy(patch);
+            return NULL;
+        }
+    }
+    return patch;
+}
+
+/* ========================================================================== */
+/* FHIRPath Patch Compilation                                                 */
+/* ========================================================================== */
+
+// The value[x] member of a parameter part, e.g. valueString
+static const cJSON* part_value(const cJSON* part) {
+    const cJSON* member;
+    cJSON_ArrayForEach(member, part) {
+        if (member->string && strncmp(member->string, "value", 5) == 0 &&
+            isupper((unsigned char)member->string[5])) {
+            return member;
+        }
+    }
+    return NULL;
+}
+
+static const cJSON* find_part(const cJSON* parts, const char* name) {
+    const cJSON* part;
+    cJSON_ArrayForEach(part, parts) {
+        const cJSON* part_name = cJSON_GetObjectItemCaseSensitive(part, "name");
+        if (cJSON_IsString(part_name) && part_name->valuestring &&
+            strcmp(part_name->valuestring, name) == 0) {
+            return part;
+        }
+    }
+    return NULL;
+}
+
+static const char* part_string(const cJSON* parts, const char* name) {
+    const cJSON* value = part_value(find_part(parts, name));
+    return cJSON_IsString(value) ? value->valuestring : NULL;
+}
+
+static bool part_integer(const cJSON* parts, const char* name, int* out) {
+    const cJSON* value = part_value(find_part(parts, name));
+    if (!cJSON_IsNumber(value) || value->valuedouble < 0 || value->valuedouble > INT_MAX ||
+        value->valuedouble != (double)(int)value->valuedouble) {
+        return false;
+    }
+    *out = (int)value->valuedouble;
+    return true;
+}
+
+// A value is value[x], or parts that become an object (repeated names become an array)
+static cJSON* part_to_value(const cJSON* part) {
+    const cJSON* value = part_value(part);
+    if (value) {
+        return copy_value(value);
+    }
+
+    const cJSON* parts = cJSON_GetObjectItemCaseSensitive(part, "part");
+    if (!cJSON_IsArray(parts)) {
+        return NULL;
+    }
+    cJSON* object = cJSON_CreateObject();
+    const cJSON* child;
+    cJSON_ArrayForEach(child, parts) {
+        const cJSON* name = cJSON_GetObjectItemCaseSensitive(child, "name");
+        cJSON* element = cJSON_IsString(name) && name->valuestring ? part_to_value(child) : NULL;
+        if (!object || !element) {
+            cJSON_Delete(element);
+            cJSON_Delete(object);
+            return NULL;
+        }
+
+        cJSON* existing = cJSON_GetObjectItemCaseSensitive(object, name->valuestring);
+        if (!existing) {
+            cJSON_AddItemToObject(object, name->valuestring, element);
+            continue;
+        }
+        if (!cJSON_IsArray(existing)) {
+            cJSON* list = cJSON_CreateArray();
+            cJSON* first = list ? copy_value(existing) : NULL;
+            if (!first) {
+                cJSON_Delete(list);
+                cJSON_Delete(element);
+                cJSON_Delete(object);
+                return NULL;
+            }
+            cJSON_AddItemToArray(list, first);
+            cJSON_ReplaceItemInObjectCaseSensitive(object, name->valuestring, list);
+            existing = list;
+        }
+        cJSON_AddItemToArray(existing, element);
+    }
+    return object;
+}
+
+// Top-level element a path starts at: "Patient.name.where(...)" and "name[0]" give name.
+// Unions and paths starting with a function or at the resource itself give NULL.
+static char* path_member(const char* expression, bool* root) {
+    *root = false;
+    if (strchr(expression, '|')) {
+        return NULL;
+    }
+
+    const char* c = expression;
+    while (*c == '(' || isspace((unsigned char)*c)) c++;
+    const char* start = c;
+    while (isalnum((unsigned char)*c) || *c == '_') c++;
+    if (c == start) {
+        return NULL;
+    }
+
+    // A capitalized first name is the resource type
+    if (isupper((unsigned char)*start)) {
+        while (isspace((unsigned char)*c)) c++;
+        if (*c != '.') {
+            *root = *c == '\0' || *c == ')';
+            return NULL;
+        }
+        c++;
+        while (isspace((unsigned char)*c)) c++;
+        start = c;
+        while (isalnum((unsigned char)*c) || *c == '_') c++;
+        if (c == start) {
+            return NULL;
+        }
+    }
+
+    const char* end = c;
+    while (isspace((unsigned char)*c)) c++;
+    if (*c == '(') {
+        return NULL;
+    }
+    char* member = fhir_malloc((size_t)(end - start) + 1);
+    if (member) {
+        memcpy(member, start, (size_t)(end - start));
+        member[end - start] = '\0';
+    }
+    return member;
+}
+
+// "Patient.contact.telecom" -> container "Patient.contact" and list name "telecom"
+static bool compile_container(FHIRPatchOperation* operation, const char* expression) {
+    size_t length = strlen(expression);
+    while (length > 0 && isspace((unsigned char)expression[length - 1])) length--;
+    size_t start = length;
+    while (start > 0 && (isalnum((unsigned char)expression[start - 1]) || expression[start - 1] == '_')) {
+        start--;
+    }
+    if (start == length || start < 2 || expression[start - 1] != '.') {
+        return true;  // Not a plain element name: inserting needs an existing list
+    }
+
+    char* container = fhir_malloc(start);
+    operation->name = fhir_malloc(length - start + 1);
+    if (!container || !operation->name) {
+        fhir_free(container);
+        return false;
+    }
+    memcpy(container, expression, start - 1);
+    container[start - 1] = '\0';
+    memcpy(operation->name, expression + start, length - start);
+    operation->name[length - start] = '\0';
+    operation->container = fhir_path_compile(container);
+    fhir_free(container);
+    if (!operation->container) {
+        fhir_clear_error();
+        fhir_free(operation->name);
+        operation->name = NULL;
+    }
+    return true;
+}
+
+static bool compile_fhirpath_operation(FHIRPatch* patch, const cJSON* parameter, size_t index) {
+    static const struct {
+        const char* name;
+        FHIRPatchOpcode opcode;
+    } opcodes[] = {
+        {"add", FHIR_PATCH_OP_ADD}, {"insert", FHIR_PATCH_OP_INSERT},
+        {"delete", FHIR_PATCH_OP_DELETE}, {"replace", FHIR_PATCH_OP_REPLACE},
+        {"move", FHIR_PATCH_OP_MOVE}
+    };
+    FHIRPatchOperation* operation = &patch->operations[index];
+
+    const cJSON* name = cJSON_GetObjectItemCaseSensitive(parameter, "name");
+    const cJSON* parts = cJSON_GetObjectItemCaseSensitive(parameter, "part");
+    if (!cJSON_IsString(name) || !name->valuestring || strcmp(name->valuestring, "operation") != 0 ||
+        !cJSON_IsArray(parts)) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "expected an \"operation\" parameter with parts");
+    }
+
+    const char* type = part_string(parts, "type");
+    size_t found = sizeof(opcodes) / sizeof(opcodes[0]);
+    for (size_t i = 0; type && i < sizeof(opcodes) / sizeof(opcodes[0]); i++) {
+        if (strcmp(opcodes[i].name, type) == 0) {
+            found = i;
+            break;
+        }
+    }
+    if (found == sizeof(opcodes) / sizeof(opcodes[0])) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "unknown or missing type");
+    }
+    operation->opcode = opcodes[found].opcode;
+
+    const char* path = part_string(parts, "path");
+    if (!path) {
+        return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "missing path");
+    }
+    operation->program = fhir_path_compile(path);
+    if (!operation->program) {
+        return false;
+    }
+
+    switch (operation->opcode) {
+        case FHIR_PATCH_OP_ADD: {
+            const char* element = part_string(parts, "name");
+            if (!element) {
+                return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "add needs a name");
+            }
+            operation->name = fhir_strdup(element);
+            if (!operation->name) return false;
+            break;
+        }
+        case FHIR_PATCH_OP_INSERT:
+            if (!part_integer(parts, "index", &operation->index)) {
+                return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "insert needs an index");
+            }
+            if (!compile_container(operation, path)) return false;
+            break;
+        case FHIR_PATCH_OP_MOVE:
+            if (!part_integer(parts, "source", &operation->source) ||
+                !part_integer(parts, "destination", &operation->destination)) {
+                return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "move needs source and destination");
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (operation->opcode == FHIR_PATCH_OP_ADD || operation->opcode == FHIR_PATCH_OP_INSERT ||
+        operation->opcode == FHIR_PATCH_OP_REPLACE) {
+        const cJSON* value = find_part(parts, "value");
+        operation->value = value ? part_to_value(value) : NULL;
+        if (!operation->value) {
+            return patch_fail(FHIR_ERROR_PARSE_FAILED, index, "missing or invalid value");
+        }
+    }
+
+    // An add at the resource itself touches the element it names
+    bool root = false;
+    operation->member = path_member(path, &root);
+    if (!operation->member && root && operation->opcode == FHIR_PATCH_OP_ADD) {
+        operation->member = fhir_strdup(operation->name);
+    }
+    if (!operation->member) {
+        patch->members_known = false;
+    }
+    return true;
+}
+
+FHIRPatch* fhir_patch_compile_fhirpath_patch(const cJSON* parameters) {
+    const cJSON* type = cJSON_GetObjectItemCaseSensitive(parameters, "resourceType");
+    const cJSON* list = cJSON_GetObjectItemCaseSensitive(parameters, "parameter");
+    if (!cJSON_IsObject(parameters) || !cJSON_IsString(type) || !type->valuestring ||
+        strcmp(type->valuestring, "Parameters") != 0 || (list && !cJSON_IsArray(list))) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "FHIRPath Patch must be a Parameters resource");
+        return NULL;
+    }
+
+    FHIRPatch* patch = patch_create(FHIR_PATCH_FHIRPATH_PATCH, list ? (size_t)cJSON_GetArraySize(list) : 0);
+    if (!patch) return NULL;
+
+    const cJSON* parameter;
+    cJSON_ArrayForEach(parameter, list) {
+        if (!compile_fhirpath_operation(patch, parameter, patch->count++)) {
+            fhir_patch_destroy(patch);
+            return NULL;
+        }
+    }
+    return patch;
+}
+
+FHIRPatch* fhir_patch_compile(const cJSON* patch) {
+    if (cJSON_IsArray(patch)) {
+        return fhir_patch_compile_json_patch(patch);
+    }
+    return fhir_patch_compile_fhirpath_patch(patch);
+}
+
+/* ========================================================================== */
+/* Change Journal                                                             */
+/* ========================================================================== */
+
+// Before an operation modifies a top-level member, a copy of it is saved so
+// a failed patch can be rolled back; the saved names are the change set.
+typedef struct {
+    char* name;
+    cJSON* saved;       // Member before the patch, NULL if it was absent
+} FHIRPatchSaved;
+
+typedef struct {
+    cJSON* root;
+    char** order;       // Top-level member names before the patch
+    size_t order_count;
+    FHIRPatchSaved* saved;
+    size_t count;
+    size_t capacity;
+} FHIRPatchJournal;
+
+static void journal_init(FHIRPatchJournal* journal, cJSON* root) {
+    memset(journal, 0, sizeof(*journal));
+    journal->root = root;
+}
+
+static void journal_cleanup(FHIRPatchJournal* journal) {
+    for (size_t i = 0; i < journal->count; i++) {
+        fhir_free(journal->saved[i].name);
+        if (journal->saved[i].saved) {
+            cJSON_Delete(journal->saved[i].saved);
+        }
+    }
+    for (size_t i = 0; i < journal->order_count; i++) {
+        fhir_free(journal->order[i]);
+    }
+    fhir_free(journal->saved);
+    fhir_free(journal->order);
+}
+
+static bool journal_snapshot_order(FHIRPatchJournal* journal) {
+    size_t count = (size_t)cJSON_GetArraySize(journal->root);
+    journal->order = count ? fhir_calloc(count, sizeof(char*)) : NULL;
+    if (count && !journal->order) {
+        return false;
+    }
+    const cJSON* child;
+    cJSON_ArrayForEach(child, journal->root) {
+        char* name = fhir_strdup(child->string ? child->string : "");
+        if (!name) return false;
+        journal->order[journal->order_count++] = name;
+    }
+    return true;
+}
+
+static bool journal_touch(FHIRPatchJournal* journal, const char* name) {
+    for (size_t i = 0; i < journal->count; i++) {
+        if (strcmp(journal->saved[i].name, name) == 0) {
+            return true;
+        }
+    }
+    if (journal->count == 0 && !journal_snapshot_order(journal)) {
+        return false;
+    }
+    if (journal->count == journal->capacity) {
+        size_t capacity = journal->capacity ? journal->capacity * 2 : 4;
+        FHIRPatchSaved* saved = fhir_realloc(journal->saved, capacity * sizeof(FHIRPatchSaved));
+        if (!saved) return false;
+        journal->saved = saved;
+        journal->capacity = capacity;
+    }
+
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(journal->root, name);
+    FHIRPatchSaved entry = {fhir_strdup(name), item ? cJSON_Duplicate(item, 1) : NULL};
+    if (!entry.name || (item && !entry.saved)) {
+        fhir_free(entry.name);
+        cJSON_Delete(entry.saved);
+        return false;
+    }
+    journal->saved[journal->count++] = entry;
+    return true;
+}
+
+// Put every saved member back, then restore the original member order
+static void journal_rollback(FHIRPatchJournal* journal) {
+    cJSON* root = journal->root;
+    for (size_t i = 0; i < journal->count; i++) {
+        cJSON_DeleteItemFromObjectCaseSensitive(root, journal->saved[i].name);
+        if (journal->saved[i].saved) {
+            cJSON_AddItemToObject(root, journal->saved[i].name, journal->saved[i].saved);
+            journal->saved[i].saved = NULL;
+        }
+    }
+
+    cJSON** items = journal->order_count ? fhir_calloc(journal->order_count, sizeof(cJSON*)) : NULL;
+    if (!items) return;  // Content is restored either way; only the order is lost
+    for (size_t i = 0; i < journal->order_count; i++) {
+        cJSON* item = cJSON_GetObjectItemCaseSensitive(root, journal->order[i]);
+        items[i] = item ? cJSON_DetachItemViaPointer(root, item) : NULL;
+    }
+    for (size_t i = 0; i < journal->order_count; i++) {
+        if (items[i]) {
+            cJSON_AddItemToArray(root, items[i]);
+        }
+    }
+    fhir_free(items);
+}
+
+void fhir_patch_changes_init(FHIRPatchChanges* changes) {
+    if (changes) {
+        changes->members = NULL;
+        changes->count = 0;
+    }
+}
+
+void fhir_patch_changes_cleanup(FHIRPatchChanges* changes) {
+    if (!changes) return;
+
+    for (size_t i = 0; i < changes->count; i++) {
+        fhir_free(changes->members[i]);
+    }
+    fhir_free(changes->members);
+    fhir_patch_changes_init(changes);
+}
+
+static bool changes_contain(const FHIRPatchChanges* changes, const char* name, size_t length) {
+    for (size_t i = 0; i < changes->count; i++) {
+        if (strlen(changes->members[i]) == length && memcmp(changes->members[i], name, length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ========================================================================== */
+/* JSON Patch Application                                                     */
+/* ========================================================================== */
+
+// Array index token: digits without leading zeros
+static bool array_index(const char* token, int* index) {
+    if (!isdigit((unsigned char)token[0]) || (token[0] == '0' && token[1] != '\0')) {
+        return false;
+    }
+    long value = 0;
+    for (const char* c = token; *c; c++) {
+        if (!isdigit((unsigned char)*c) || value > (INT_MAX - 9) / 10) {
+            return false;
+        }
+        value = value * 10 + (*c - '0');
+    }
+    *index = (int)value;
+    return true;
+}
+
+static cJSON* pointer_child(cJSON* container, const char* token) {
+    if (cJSON_IsObject(container)) {
+        return cJSON_GetObjectItemCaseSensitive(container, token);
+    }
+    int index;
+    if (cJSON_IsArray(container) && array_index(token, &index)) {
+        return cJSON_GetArrayItem(container, index);
+    }
+    return NULL;
+}
+
+// Node referenced by the first depth tokens of a pointer
+static cJSON* pointer_resolve(cJSON* root, const FHIRPatchPointer* pointer, size_t depth) {
+    cJSON* node = root;
+    for (size_t i = 0; node && i < depth; i++) {
+        node = pointer_child(node, pointer->tokens[i]);
+    }
+    return node;
+}
+
+// Add value (consumed on success) at pointer: set a member, or insert into an array
+static bool pointer_add(cJSON* root, const FHIRPatchPointer* pointer, cJSON* value) {
+    cJSON* parent = pointer_resolve(root, pointer, pointer->count - 1);
+    const char* token = pointer->tokens[pointer->count - 1];
+    if (cJSON_IsObject(parent)) {
+        if (cJSON_GetObjectItemCaseSensitive(parent, token)) {
+            return cJSON_ReplaceItemInObjectCaseSensitive(parent, token, value);
+        }
+        return cJSON_AddItemToObject(parent, token, value);
+    }
+    if (!cJSON_IsArray(parent)) {
+        return false;
+    }
+
+    int size = cJSON_GetArraySize(parent);
+    int index = size;
+    if (strcmp(token, "-") != 0 && (!array_index(token, &index) || index > size)) {
+        return false;
+    }
+    return index == size ? cJSON_AddItemToArray(parent, value) : cJSON_InsertItemInArray(parent, index, value);
+}
+
+static cJSON* pointer_detach(cJSON* root, const FHIRPatchPointer* pointer) {
+    cJSON* parent = pointer_resolve(root, pointer, pointer->count - 1);
+    cJSON* item = parent ? pointer_child(parent, pointer->tokens[pointer->count - 1]) : NULL;
+    return item ? cJSON_DetachItemViaPointer(parent, item) : NULL;
+}
+
+static bool pointer_replace(cJSON* root, const FHIRPatchPointer* pointer, cJSON* value) {
+    cJSON* parent = pointer_resolve(root, pointer, pointer->count - 1);
+    const char* token = pointer->tokens[pointer->count - 1];
+    cJSON* item = parent ? pointer_child(parent, token) : NULL;
+    if (!item) {
+        return false;
+    }
+    if (cJSON_IsObject(parent)) {
+        return cJSON_ReplaceItemInObjectCaseSensitive(parent, token, value);
+    }
+    return cJSON_ReplaceItemViaPointer(parent, item, value);
+}
+
+// Whether a is a proper prefix of b (a value cannot move into itself)
+static bool pointer_is_prefix(const FHIRPatchPointer* a, const FHIRPatchPointer* b) {
+    if (a->count >= b->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; i++) {
+        if (strcmp(a->tokens[i], b->tokens[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool pointer_equals(const FHIRPatchPointer* a, const FHIRPatchPointer* b) {
+    if (a->count != b->count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; i++) {
+        if (strcmp(a->tokens[i], b->tokens[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool apply_json_operation(const FHIRPatchOperation* operation, size_t index,
+                                 FHIRPatchJournal* journal) {
+    cJSON* root = journal->root;
+    if (operation->opcode == FHIR_PATCH_OP_TEST) {
+        cJSON* node = pointer_resolve(root, &operation->path, operation->path.count);
+        if (!node) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "test path not found");
+        }
+        if (!cJSON_Compare(node, operation->value, 1)) {
+            return patch_fail(FHIR_ERROR_VALIDATION_FAILED, index, "test failed");
+        }
+        return true;
+    }
+
+    if ((operation->from_member && !journal_touch(journal, operation->from_member)) ||
+        !journal_touch(journal, operation->member)) {
+        return false;
+    }
+
+    cJSON* value = NULL;
+    switch (operation->opcode) {
+        case FHIR_PATCH_OP_ADD:
+        case FHIR_PATCH_OP_REPLACE:
+            value = cJSON_Duplicate(operation->value, 1);
+            if (!value) return false;
+            break;
+        case FHIR_PATCH_OP_REMOVE: {
+            cJSON* removed = pointer_detach(root, &operation->path);
+            if (!removed) {
+                return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "path not found");
+            }
+            cJSON_Delete(removed);
+            return true;
+        }
+        case FHIR_PATCH_OP_MOVE:
+            if (pointer_is_prefix(&operation->from, &operation->path)) {
+                return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "cannot move a value into itself");
+            }
+            if (pointer_equals(&operation->from, &operation->path)) {
+                if (!pointer_resolve(root, &operation->from, operation->from.count)) {
+                    return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "from path not found");
+                }
+                return true;
+            }
+            value = pointer_detach(root, &operation->from);
+            break;
+        case FHIR_PATCH_OP_COPY: {
+            cJSON* source = pointer_resolve(root, &operation->from, operation->from.count);
+            value = source ? copy_value(source) : NULL;
+            break;
+        }
+        default:
+            break;
+    }
+    if (!value) {
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "from path not found");
+    }
+    strip_name(value);
+
+    bool ok = operation->opcode == FHIR_PATCH_OP_REPLACE ? pointer_replace(root, &operation->path, value)
+                                                         : pointer_add(root, &operation->path, value);
+    if (!ok) {
+        cJSON_Delete(value);
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "path not found");
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* FHIRPath Patch Application                                                 */
+/* ========================================================================== */
+
+// Container holding node directly, searched from container down
+static cJSON* find_parent(cJSON* container, const cJSON* node) {
+    cJSON* child;
+    cJSON_ArrayForEach(child, container) {
+        if (child == node) {
+            return container;
+        }
+        if (cJSON_IsObject(child) || cJSON_IsArray(child)) {
+            cJSON* parent = find_parent(child, node);
+            if (parent) return parent;
+        }
+    }
+    return NULL;
+}
+
+// Record the top-level member holding node (or named name, for the root itself)
+static bool touch_node(FHIRPatchJournal* journal, const cJSON* node, const char* name) {
+    if (node == journal->root) {
+        return journal_touch(journal, name);
+    }
+    cJSON* child;
+    cJSON_ArrayForEach(child, journal->root) {
+        if (child == node || ((cJSON_IsObject(child) || cJSON_IsArray(child)) && find_parent(child, node))) {
+            return journal_touch(journal, child->string ? child->string : "");
+        }
+    }
+    return false;
+}
+
+// The array whose elements are exactly the selected nodes, in order
+static cJSON* selected_list(cJSON* root, const FHIRPathResult* result) {
+    cJSON* parent = find_parent(root, result->items[0]);
+    if (!cJSON_IsArray(parent) || (size_t)cJSON_GetArraySize(parent) != result->count) {
+        return NULL;
+    }
+    size_t i = 0;
+    const cJSON* child;
+    cJSON_ArrayForEach(child, parent) {
+        if (child != result->items[i++]) {
+            return NULL;
+        }
+    }
+    return parent;
+}
+
+static bool list_insert(cJSON* list, int index, cJSON* value) {
+    return index == cJSON_GetArraySize(list) ? cJSON_AddItemToArray(list, value)
+                                             : cJSON_InsertItemInArray(list, index, value);
+}
+
+static bool fhirpath_add(const FHIRPatchOperation* operation, size_t index, FHIRPatchJournal* journal,
+                         const FHIRPathResult* result) {
+    cJSON* target = result->count == 1 ? (cJSON*)result->items[0] : NULL;
+    if (!cJSON_IsObject(target)) {
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "add needs exactly one target element");
+    }
+    cJSON* existing = cJSON_GetObjectItemCaseSensitive(target, operation->name);
+    if (existing && !cJSON_IsArray(existing)) {
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "add target already has the element");
+    }
+    if (!touch_node(journal, target, operation->name)) {
+        return false;
+    }
+
+    cJSON* value = cJSON_Duplicate(operation->value, 1);
+    if (!value) return false;
+    bool ok = existing ? cJSON_AddItemToArray(existing, value)
+                       : cJSON_AddItemToObject(target, operation->name, value);
+    if (!ok) cJSON_Delete(value);
+    return ok;
+}
+
+static bool fhirpath_insert(const FHIRPatchOperation* operation, size_t index, FHIRPatchJournal* journal,
+                            const FHIRPathResult* result) {
+    cJSON* root = journal->root;
+    cJSON* list = NULL;
+    cJSON* holder = NULL;
+    if (result->count > 0) {
+        list = selected_list(root, result);
+        if (!list) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "insert path must select a whole list");
+        }
+    } else {
+        // Nothing selected: the list is empty or absent and may be created
+        FHIRPathResult containers;
+        fhir_path_result_init(&containers);
+        bool evaluated = operation->container &&
+                         fhir_path_evaluate(operation->container, root, &containers);
+        if (evaluated && containers.count == 1 && cJSON_IsObject(containers.items[0])) {
+            holder = (cJSON*)containers.items[0];
+        }
+        fhir_path_result_cleanup(&containers);
+        if (!holder) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "insert path has no single parent element");
+        }
+        list = cJSON_GetObjectItemCaseSensitive(holder, operation->name);
+        if (list && !cJSON_IsArray(list)) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "insert path is not a list");
+        }
+    }
+    if (operation->index > (list ? cJSON_GetArraySize(list) : 0)) {
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "insert index out of range");
+    }
+    if (!touch_node(journal, list ? list : holder, operation->name)) {
+        return false;
+    }
+
+    cJSON* value = cJSON_Duplicate(operation->value, 1);
+    if (!value) return false;
+    if (list) {
+        if (!list_insert(list, operation->index, value)) {
+            cJSON_Delete(value);
+            return false;
+        }
+        return true;
+    }
+    cJSON* created = cJSON_CreateArray();
+    if (!created) {
+        cJSON_Delete(value);
+        return false;
+    }
+    cJSON_AddItemToArray(created, value);
+    if (!cJSON_AddItemToObject(holder, operation->name, created)) {
+        cJSON_Delete(created);
+        return false;
+    }
+    return true;
+}
+
+static bool fhirpath_apply_operation(const FHIRPatchOperation* operation, size_t index,
+                                     FHIRPatchJournal* journal, FHIRPathResult* result) {
+    cJSON* root = journal->root;
+    if (!fhir_path_evaluate(operation->program, root, result)) {
+        return false;
+    }
+
+    switch (operation->opcode) {
+        case FHIR_PATCH_OP_ADD:
+            return fhirpath_add(operation, index, journal, result);
+        case FHIR_PATCH_OP_INSERT:
+            return fhirpath_insert(operation, index, journal, result);
+        default:
+            break;
+    }
+
+    if (operation->opcode == FHIR_PATCH_OP_MOVE) {
+        cJSON* list = result->count > 0 ? selected_list(root, result) : NULL;
+        if (!list) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "move path must select a whole list");
+        }
+        int size = cJSON_GetArraySize(list);
+        if (operation->source >= size || operation->destination >= size) {
+            return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "move index out of range");
+        }
+        if (operation->source == operation->destination) {
+            return true;
+        }
+        if (!touch_node(journal, list, NULL)) {
+            return false;
+        }
+        cJSON* item = cJSON_DetachItemFromArray(list, operation->source);
+        if (!list_insert(list, operation->destination, item)) {
+            cJSON_Delete(item);
+            return false;
+        }
+        return true;
+    }
+
+    // delete and replace work on a single element; deleting nothing is a no-op
+    if (result->count == 0 && operation->opcode == FHIR_PATCH_OP_DELETE) {
+        return true;
+    }
+    cJSON* node = result->count == 1 ? (cJSON*)result->items[0] : NULL;
+    cJSON* parent = node && node != root ? find_parent(root, node) : NULL;
+    if (!parent) {
+        return patch_fail(FHIR_ERROR_INVALID_ARGUMENT, index, "path must select exactly one element");
+    }
+    if (!touch_node(journal, node, NULL)) {
+        return false;
+    }
+
+    if (operation->opcode == FHIR_PATCH_OP_REPLACE) {
+        cJSON* value = cJSON_Duplicate(operation->value, 1);
+        bool ok = value && (cJSON_IsObject(parent)
+                                ? cJSON_ReplaceItemInObjectCaseSensitive(parent, node->string, value)
+                                : cJSON_ReplaceItemViaPointer(parent, node, value));
+        if (!ok) cJSON_Delete(value);
+        return ok;
+    }
+
+    // A list left empty is removed too, as FHIR has no empty arrays
+    cJSON_Delete(cJSON_DetachItemViaPointer(parent, node));
+    if (cJSON_IsArray(parent) && !parent->child) {
+        cJSON* holder = find_parent(root, parent);
+        if (holder) {
+            cJSON_Delete(cJSON_DetachItemViaPointer(holder, parent));
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Application                                                                */
+/* ========================================================================== */
+
+bool fhir_patch_apply(const FHIRPatch* patch, cJSON* document, FHIRPatchChanges* changes) {
+    if (!patch || !cJSON_IsObject(document)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Patch needs a patch and a JSON object");
+        return false;
+    }
+    fhir_patch_changes_cleanup(changes);
+
+    FHIRPatchJournal journal;
+    journal_init(&journal, document);
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < patch->count; i++) {
+        const FHIRPatchOperation* operation = &patch->operations[i];
+        ok = patch->format == FHIR_PATCH_JSON_PATCH ? apply_json_operation(operation, i, &journal)
+                                                   : fhirpath_apply_operation(operation, i, &journal, &result);
+    }
+    fhir_path_result_cleanup(&result);
+
+    if (!ok) {
+        journal_rollback(&journal);
+    } else if (changes && journal.count > 0) {
+        changes->members = fhir_calloc(journal.count, sizeof(char*));
+        if (changes->members) {
+            for (size_t i = 0; i < journal.count; i++) {
+                changes->members[changes->count++] = journal.saved[i].name;
+                journal.saved[i].name = NULL;
+            }
+        } else {
+            ok = false;
+            journal_rollback(&journal);
+        }
+    }
+    journal_cleanup(&journal);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Serialized Documents                                                       */
+/* ========================================================================== */
+
+typedef struct {
+    FHIRJSONMemberSpan* spans;
+    size_t count;
+    size_t capacity;
+    const char* text;
+    bool escaped;       // Some key has an escape, so raw keys do not compare as names
+} FHIRPatchSpans;
+
+static bool collect_span(const FHIRJSONMemberSpan* member, void* context) {
+    FHIRPatchSpans* spans = context;
+    if (spans->count == spans->capacity) {
+        size_t capacity = spans->capacity ? spans->capacity * 2 : 16;
+        FHIRJSONMemberSpan* grown = fhir_realloc(spans->spans, capacity * sizeof(FHIRJSONMemberSpan));
+        if (!grown) return false;
+        spans->spans = grown;
+        spans->capacity = capacity;
+    }
+    spans->spans[spans->count++] = *member;
+    if (memchr(spans->text + member->key_offset, '\\', member->key_length)) {
+        spans->escaped = true;
+    }
+    return true;
+}
+
+// key is member, or member's choice element (deceased -> deceasedBoolean)
+static bool member_matches(const char* key, size_t key_length, const char* member) {
+    size_t length = strlen(member);
+    return key_length >= length && memcmp(key, member, length) == 0 &&
+           (key_length == length || isupper((unsigned char)key[length]));
+}
+
+static bool patch_reads(const FHIRPatch* patch, const char* key, size_t key_length) {
+    if (key_length == 12 && memcmp(key, "resourceType", 12) == 0) {
+        return true;  // Type prefixes of FHIRPath paths check it
+    }
+    for (size_t i = 0; i < patch->count; i++) {
+        const FHIRPatchOperation* operation = &patch->operations[i];
+        if (member_matches(key, key_length, operation->member) ||
+            (operation->from_member && member_matches(key, key_length, operation->from_member))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static char* span_key(const char* text, const FHIRJSONMemberSpan* span) {
+    char* key = fhir_malloc(span->key_length + 1);
+    if (key) {
+        memcpy(key, text + span->key_offset, span->key_length);
+        key[span->key_length] = '\0';
+    }
+    return key;
+}
+
+static bool apply_text_full(const FHIRPatch* patch, const char* text, size_t length, FHIRWriter* writer) {
+    cJSON* document = fhir_json_parse(text, length);
+    if (!document) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Invalid JSON document");
+        return false;
+    }
+    bool ok = fhir_patch_apply(patch, document, NULL) && fhir_writer_cjson(writer, document);
+    cJSON_Delete(document);
+    return ok;
+}
+
+// Unchanged members are copied from text; changed ones keep their position
+static bool write_patched(const FHIRPatchSpans* spans, const cJSON* partial,
+                          const FHIRPatchChanges* changes, FHIRWriter* writer) {
+    const char* text = spans->text;
+    bool ok = fhir_writer_begin_object(writer);
+    for (size_t i = 0; ok && i < spans->count; i++) {
+        const FHIRJSONMemberSpan* span = &spans->spans[i];
+        char* key = span_key(text, span);
+        if (!key) return false;
+
+        if (!changes_contain(changes, key, span->key_length)) {
+            ok = fhir_writer_key(writer, key) &&
+                 fhir_writer_raw(writer, text + span->value_offset, span->value_length);
+        } else {
+            // Written once, at the first occurrence of the name
+            bool first = true;
+            for (size_t j = 0; j < i && first; j++) {
+                first = spans->spans[j].key_length != span->key_length ||
+                        memcmp(text + spans->spans[j].key_offset, key, span->key_length) != 0;
+            }
+            const cJSON* item = cJSON_GetObjectItemCaseSensitive(partial, key);
+            if (first && item) {
+                ok = fhir_writer_key(writer, key) && fhir_writer_cjson(writer, item);
+            }
+        }
+        fhir_free(key);
+    }
+
+    // Members the patch added go last, in the order they were added
+    const cJSON* child;
+    cJSON_ArrayForEach(child, partial) {
+        if (!ok) break;
+        const char* name = child->string ? child->string : "";
+        if (!changes_contain(changes, name, strlen(name))) {
+            continue;
+        }
+        bool present = false;
+        for (size_t i = 0; i < spans->count && !present; i++) {
+            present = spans->spans[i].key_length == strlen(name) &&
+                      memcmp(text + spans->spans[i].key_offset, name, strlen(name)) == 0;
+        }
+        if (!present) {
+            ok = fhir_writer_key(writer, name) && fhir_writer_cjson(writer, child);
+        }
+    }
+    return ok && fhir_writer_end_object(writer);
+}
+
+bool fhir_patch_apply_text(const FHIRPatch* patch, const char* text, size_t length, FHIRWriter* writer) {
+    if (!patch || !text || !writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!patch->members_known || writer->canonical) {
+        return apply_text_full(patch, text, length, writer);
+    }
+
+    FHIRPatchSpans spans = {NULL, 0, 0, text, false};
+    if (!fhir_json_object_members(text, length, collect_span, &spans)) {
+        fhir_free(spans.spans);
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Invalid JSON object");
+        return false;
+    }
+    if (spans.escaped) {
+        fhir_free(spans.spans);
+        return apply_text_full(patch, text, length, writer);
+    }
+
+    // Parse only the members some operation reads or writes
+    bool ok = true;
+    cJSON* partial = cJSON_CreateObject();
+    for (size_t i = 0; ok && partial && i < spans.count; i++) {
+        const FHIRJSONMemberSpan* span = &spans.spans[i];
+        if (!patch_reads(patch, text + span->key_offset, span->key_length)) {
+            continue;
+        }
+        char* key = span_key(text, span);
+        cJSON* value = key ? fhir_json_parse(text + span->value_offset, span->value_length) : NULL;
+        if (value) {
+            cJSON_AddItemToObject(partial, key, value);
+        } else {
+            if (key) FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Invalid JSON member value");
+            ok = false;
+        }
+        fhir_free(key);
+    }
+
+    FHIRPatchChanges changes;
+    fhir_patch_changes_init(&changes);
+    ok = ok && partial && fhir_patch_apply(patch, partial, &changes) &&
+         write_patched(&spans, partial, &changes, writer);
+    fhir_patch_changes_cleanup(&changes);
+    cJSON_Delete(partial);
+    fhir_free(spans.spans);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Resources                                                                  */
+/* ========================================================================== */
+
+FHIRResourceBase* fhir_resource_patch(const FHIRResourceBase* resource, const FHIRPatch* patch) {
+    if (!resource || !resource->vtable || !patch) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+    cJSON* json = fhir_resource_to_json(resource);
+    if (!json) {
+        return NULL;
+    }
+
+    FHIRPatchChanges changes;
+    fhir_patch_changes_init(&changes);
+    FHIRResourceBase* patched = NULL;
+    if (fhir_patch_apply(patch, json, &changes)) {
+        const cJSON* type = cJSON_GetObjectItemCaseSensitive(json, "resourceType");
+        const cJSON* id = cJSON_GetObjectItemCaseSensitive(json, "id");
+        if (!cJSON_IsString(type) || !type->valuestring ||
+            strcmp(type->valuestring, resource->vtable->resource_type_name) != 0) {
+            FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Patch changed the resource type");
+        } else {
+            patched = fhir_resource_create_by_type(resource->resource_type,
+                                                   cJSON_IsString(id) ? id->valuestring : NULL);
+        }
+        if (patched && !fhir_resource_from_json(patched, json)) {
+            fhir_resource_release(patched);
+            patched = NULL;
+        }
+    }
+
+    if (patched) {
+        uint32_t fields = 0;
+        for (size_t i = 0; i < changes.count; i++) {
+            fields |= fhir_resource_member_dirty_fields(resource->vtable, changes.members[i]);
+        }
+        fhir_resource_inherit_validation(patched, resource, fields);
+    }
+    fhir_patch_changes_cleanup(&changes);
+    cJSON_Delete(json);
+    return patched;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file fhir_patch.h
+ * @brief JSON Patch (RFC 6902) and FHIRPath Patch applied in place
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * A patch is compiled once (pointers split, FHIRPath expressions compiled,
+ * values copied) and then applied to any number of documents:
+ *
+ *   - fhir_patch_apply edits a cJSON resource tree in place. A patch is
+ *     atomic: if any operation fails, the tree is restored as it was.
+ *   - fhir_patch_apply_text patches serialized JSON into a streaming writer.
+ *     Only the top-level members the patch can touch are parsed; the others
+ *     are copied to the output byte for byte.
+ *   - fhir_resource_patch derives a patched resource struct whose
+ *     incremental validation cache has only the changed members' fields
+ *     dirty, so revalidating it reruns only the affected rules.
+ *
+ * JSON Patch supports add, remove, replace, move, copy and test on JSON
+ * Pointer paths below the document root. FHIRPath Patch takes a Parameters
+ * resource of "operation" parameters (add, insert, delete, replace, move)
+ * whose paths are in the fhir_path subset. Its add sets a missing element
+ * or appends to an existing array; insert into an absent list creates the
+ * array when the path ends in a plain element name.
+ */
+
+#ifndef FHIR_PATCH_H
+#define FHIR_PATCH_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_json_writer.h"
+#include "common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque compiled patch (immutable, so shareable across threads)
+ */
+typedef struct FHIRPatch FHIRPatch;
+
+/**
+ * @brief Patch formats
+ */
+typedef enum {
+    FHIR_PATCH_JSON_PATCH = 0,      /**< RFC 6902 operation array */
+    FHIR_PATCH_FHIRPATH_PATCH       /**< FHIRPath Patch Parameters resource */
+} FHIRPatchFormat;
+
+/**
+ * @brief Top-level members an applied patch changed, added or removed
+ */
+typedef struct {
+    char** members;
+    size_t count;
+} FHIRPatchChanges;
+
+/* ========================================================================== */
+/* Compilation                                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Compile a JSON Patch document
+ * @param operations Array of operation objects
+ * @return Patch or NULL on failure (FHIR_ERROR_PARSE_FAILED names the bad operation)
+ */
+FHIRPatch* fhir_patch_compile_json_patch(const cJSON* operations);
+
+/**
+ * @brief Compile a FHIRPath Patch Parameters resource
+ * @param parameters Parameters resource with "operation" parameters
+ * @return Patch or NULL on failure
+ */
+FHIRPatch* fhir_patch_compile_fhirpath_patch(const cJSON* parameters);
+
+/**
+ * @brief Compile either format: an array is JSON Patch, an object FHIRPath Patch
+ * @param patch Patch document
+ * @return Patch or NULL on failure
+ */
+FHIRPatch* fhir_patch_compile(const cJSON* patch);
+
+/**
+ * @brief Destroy a compiled patch
+ * @param patch Patch to destroy (can be NULL)
+ */
+void fhir_patch_destroy(FHIRPatch* patch);
+
+/**
+ * @brief Get the format a patch was compiled from
+ */
+FHIRPatchFormat fhir_patch_get_format(const FHIRPatch* patch);
+
+/**
+ * @brief Get the number of operations in a patch
+ */
+size_t fhir_patch_get_operation_count(const FHIRPatch* patch);
+
+/* ========================================================================== */
+/* Application                                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty change set
+ */
+void fhir_patch_changes_init(FHIRPatchChanges* changes);
+
+/**
+ * @brief Free the member names of a change set
+ * @param changes Change set to clean up (can be NULL)
+ */
+void fhir_patch_changes_cleanup(FHIRPatchChanges* changes);
+
+/**
+ * @brief Apply a patch to a resource tree in place
+ *
+ * Operations run in order. If one fails (a failed test, a missing target,
+ * an ambiguous FHIRPath selection), the tree is restored and the error is
+ * set. Nodes previously obtained from the tree may be replaced even then.
+ *
+ * @param patch Compiled patch
+ * @param document JSON object to patch
+ * @param changes Optional output: top-level members the patch modified (replaces the contents)
+ * @return true if every operation succeeded
+ */
+bool fhir_patch_apply(const FHIRPatch* patch, cJSON* document, FHIRPatchChanges* changes);
+
+/**
+ * @brief Patch serialized JSON, writing the result
+ *
+ * Top-level members the patch cannot touch are written verbatim without
+ * being parsed; changed members are re-serialized in their original
+ * position and new ones are appended. Patches whose targets cannot be
+ * determined statically (unions, paths starting with a function), keys
+ * with escapes and canonical writers fall back to patching the fully
+ * parsed document.
+ *
+ * @param patch Compiled patch
+ * @param text JSON object text (need not be NUL-terminated)
+ * @param length Length of text in bytes
+ * @param writer Destination writer; nothing is written if the patch fails
+ * @return true on success
+ */
+bool fhir_patch_apply_text(const FHIRPatch* patch, const char* text, size_t length, FHIRWriter* writer);
+
+/**
+ * @brief Derive a patched copy of a resource
+ *
+ * The resource is serialized, patched and loaded into a new resource of
+ * the same type; the source is not modified. If the source holds an
+ * incremental validation result, the copy inherits it with only the fields
+ * of the changed members dirty.
+ *
+ * @param resource Resource to patch
+ * @param patch Compiled patch
+ * @return New resource (release with fhir_resource_release) or NULL on failure
+ */
+FHIRResourceBase* fhir_resource_patch(const FHIRResourceBase* resource, const FHIRPatch* patch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PATCH_H */
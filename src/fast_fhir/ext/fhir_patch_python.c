@@ -0,0 +1,90 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_json.h"
+#include "fhir_patch.h"
+#include "common/fhir_json_reader.h"
+
+// Python binding for JSON Patch and FHIRPath Patch
+
+// Apply a JSON Patch or FHIRPath Patch to a JSON document, re-serializing only what changed
+static PyObject* py_apply_patch(PyObject* self, PyObject* args) {
+    PyObject* document_arg;
+    PyObject* patch_arg;
+    if (!PyArg_ParseTuple(args, "OO", &document_arg, &patch_arg)) {
+        return NULL;
+    }
+    Py_buffer view;
+    Py_buffer patch_view;
+    if (!fhir_python_buffer_arg(document_arg, &view)) {
+        return NULL;
+    }
+    if (!fhir_python_buffer_arg(patch_arg, &patch_view)) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    FHIRWriter writer;
+    bool initialized = false;
+    bool written = false;
+    FHIRErrorCode error_code = FHIR_ERROR_NONE;
+    char message[FHIR_ERROR_MESSAGE_MAX] = "Invalid patch";
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    cJSON* patch_json = fhir_json_parse(patch_view.buf, (size_t)patch_view.len);
+    FHIRPatch* patch = patch_json ? fhir_patch_compile(patch_json) : NULL;
+    initialized = patch && fhir_writer_init_buffer(&writer, (size_t)view.len + 1);
+    written = initialized && fhir_patch_apply_text(patch, view.buf, (size_t)view.len, &writer) &&
+              fhir_writer_finish(&writer);
+    if (!written && patch_json) {
+        const FHIRError* error = fhir_get_last_error();
+        error_code = error ? error->code : FHIR_ERROR_NONE;
+        if (error && error->message) {
+            snprintf(message, sizeof(message), "%s", error->message);
+        }
+    }
+    fhir_patch_destroy(patch);
+    cJSON_Delete(patch_json);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&patch_view);
+    PyBuffer_Release(&view);
+
+    PyObject* result = NULL;
+    if (written) {
+        result = PyUnicode_FromStringAndSize(writer.data, (Py_ssize_t)writer.length);
+    } else if (error_code == FHIR_ERROR_OUT_OF_MEMORY) {
+        PyErr_NoMemory();
+    } else {
+        PyErr_SetString(PyExc_ValueError, message);
+    }
+    if (initialized) {
+        fhir_writer_cleanup(&writer);
+    }
+    return result;
+}
+
+static PyMethodDef PatchModuleMethods[] = {
+    {"apply_patch", py_apply_patch, METH_VARARGS,
+     "apply_patch(document, patch): apply a JSON Patch array or FHIRPath Patch Parameters; returns JSON text"},
+    {NULL, NULL, 0, NULL}
+};
+
+// Module execution (once per interpreter); the module keeps no state
+static int patch_module_exec(PyObject* module) {
+    return fhir_python_add_runtime(module);
+}
+
+static PyModuleDef_Slot patch_module_slots[] = FHIR_PY_MODULE_SLOTS(patch_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_patch_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_patch_c",
+    "JSON Patch and FHIRPath Patch for FHIR resources in C",
+    0,
+    PatchModuleMethods,
+    patch_module_slots
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_patch_c(void) {
+    return PyModuleDef_Init(&fhir_patch_module);
+}
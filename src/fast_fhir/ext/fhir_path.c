@@ -0,0 +1,808 @@
+/**
+ * @file fhir_path.c
+ * @brief Compiled FHIRPath subset for field extraction
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_path.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Nesting limit for parentheses and where(), which also bounds evaluation recursion
+#define FHIR_PATH_MAX_DEPTH 32
+
+/* ========================================================================== */
+/* Program Representation                                                     */
+/* ========================================================================== */
+
+typedef enum {
+    // Navigation: map the current collection
+    FHIR_PATH_OP_TYPE,      // Keep resources whose resourceType is name
+    FHIR_PATH_OP_CHILD,     // Member name of each object, arrays flattened
+    FHIR_PATH_OP_INDEX,     // Keep the node at position number
+    FHIR_PATH_OP_FIRST,
+    FHIR_PATH_OP_LAST,
+    FHIR_PATH_OP_WHERE,     // Keep nodes for which the next length criteria instructions hold
+    FHIR_PATH_OP_UNION,     // End of an alternative: restart from the resource
+    // Criteria: evaluated for one node on a stack of booleans
+    FHIR_PATH_OP_TEST,      // Push the test of the next length navigation instructions
+    FHIR_PATH_OP_AND,
+    FHIR_PATH_OP_OR
+} FHIRPathOpcode;
+
+typedef enum {
+    FHIR_PATH_TEST_EXISTS,
+    FHIR_PATH_TEST_EMPTY,
+    FHIR_PATH_TEST_EQUALS,
+    FHIR_PATH_TEST_NOT_EQUALS
+} FHIRPathTest;
+
+typedef enum {
+    FHIR_PATH_LITERAL_NONE,
+    FHIR_PATH_LITERAL_STRING,   // In name
+    FHIR_PATH_LITERAL_NUMBER,   // In number
+    FHIR_PATH_LITERAL_BOOLEAN   // In number (0 or 1)
+} FHIRPathLiteral;
+
+typedef struct {
+    FHIRPathOpcode opcode;
+    FHIRPathTest test;
+    FHIRPathLiteral literal;
+    uint32_t length;            // WHERE, TEST: number of instructions that follow
+    char* name;                 // TYPE, CHILD, string literal of TEST (owned)
+    double number;              // INDEX, number or boolean literal of TEST
+} FHIRPathInstruction;
+
+struct FHIRPathProgram {
+    char* expression;
+    FHIRPathInstruction* code;
+    size_t count;
+    size_t capacity;
+};
+
+/* ========================================================================== */
+/* Lexer                                                                      */
+/* ========================================================================== */
+
+typedef enum {
+    FHIR_PATH_TOKEN_END,
+    FHIR_PATH_TOKEN_IDENTIFIER,
+    FHIR_PATH_TOKEN_STRING,
+    FHIR_PATH_TOKEN_NUMBER,
+    FHIR_PATH_TOKEN_THIS,
+    FHIR_PATH_TOKEN_DOT,
+    FHIR_PATH_TOKEN_LBRACKET,
+    FHIR_PATH_TOKEN_RBRACKET,
+    FHIR_PATH_TOKEN_LPAREN,
+    FHIR_PATH_TOKEN_RPAREN,
+    FHIR_PATH_TOKEN_PIPE,
+    FHIR_PATH_TOKEN_EQUALS,
+    FHIR_PATH_TOKEN_NOT_EQUALS,
+    FHIR_PATH_TOKEN_INVALID
+} FHIRPathTokenType;
+
+typedef struct {
+    FHIRPathTokenType type;
+    const char* start;          // Identifier text, or the string literal inside its quotes
+    size_t length;
+    double number;
+} FHIRPathToken;
+
+typedef struct {
+    const char* source;
+    const char* position;
+    FHIRPathToken token;        // Current token
+    FHIRPathProgram* program;
+    int depth;
+    bool failed;
+} FHIRPathCompiler;
+
+static const char* lex_token(const char* p, FHIRPathToken* token) {
+    while (isspace((unsigned char)*p)) p++;
+    token->start = p;
+    token->length = 1;
+
+    char c = *p;
+    if (c == '\0') {
+        token->type = FHIR_PATH_TOKEN_END;
+        token->length = 0;
+        return p;
+    }
+    if (isalpha((unsigned char)c) || c == '_') {
+        const char* end = p + 1;
+        while (isalnum((unsigned char)*end) || *end == '_') end++;
+        token->type = FHIR_PATH_TOKEN_IDENTIFIER;
+        token->length = (size_t)(end - p);
+        return end;
+    }
+    if (c == '`') {
+        // Delimited identifier, for names that clash with keywords
+        const char* end = strchr(p + 1, '`');
+        if (!end) {
+            token->type = FHIR_PATH_TOKEN_INVALID;
+            return p;
+        }
+        token->type = FHIR_PATH_TOKEN_IDENTIFIER;
+        token->start = p + 1;
+        token->length = (size_t)(end - p - 1);
+        return end + 1;
+    }
+    if (c == '\'') {
+        // Escapes are kept in the token and decoded by copy_string_literal
+        const char* end = p + 1;
+        while (*end && *end != '\'') {
+            end += (end[0] == '\\' && end[1]) ? 2 : 1;
+        }
+        if (*end != '\'') {
+            token->type = FHIR_PATH_TOKEN_INVALID;
+            return p;
+        }
+        token->type = FHIR_PATH_TOKEN_STRING;
+        token->start = p + 1;
+        token->length = (size_t)(end - p - 1);
+        return end + 1;
+    }
+    if (isdigit((unsigned char)c) || (c == '-' && isdigit((unsigned char)p[1]))) {
+        char* end;
+        token->type = FHIR_PATH_TOKEN_NUMBER;
+        token->number = strtod(p, &end);
+        token->length = (size_t)(end - p);
+        return end;
+    }
+    if (c == '$' && strncmp(p, "$this", 5) == 0 && !isalnum((unsigned char)p[5])) {
+        token->type = FHIR_PATH_TOKEN_THIS;
+        token->length = 5;
+        return p + 5;
+    }
+    if (c == '!' && p[1] == '=') {
+        token->type = FHIR_PATH_TOKEN_NOT_EQUALS;
+        token->length = 2;
+        return p + 2;
+    }
+
+    switch (c) {
+        case '.': token->type = FHIR_PATH_TOKEN_DOT; break;
+        case '[': token->type = FHIR_PATH_TOKEN_LBRACKET; break;
+        case ']': token->type = FHIR_PATH_TOKEN_RBRACKET; break;
+        case '(': token->type = FHIR_PATH_TOKEN_LPAREN; break;
+        case ')': token->type = FHIR_PATH_TOKEN_RPAREN; break;
+        case '|': token->type = FHIR_PATH_TOKEN_PIPE; break;
+        case '=': token->type = FHIR_PATH_TOKEN_EQUALS; break;
+        default: token->type = FHIR_PATH_TOKEN_INVALID; return p;
+    }
+    return p + 1;
+}
+
+static void compiler_advance(FHIRPathCompiler* compiler) {
+    compiler->position = lex_token(compiler->position, &compiler->token);
+}
+
+static FHIRPathTokenType compiler_peek(const FHIRPathCompiler* compiler) {
+    FHIRPathToken next;
+    lex_token(compiler->position, &next);
+    return next.type;
+}
+
+static bool compiler_fail(FHIRPathCompiler* compiler, const char* message) {
+    if (!compiler->failed) {
+        char buffer[FHIR_ERROR_MESSAGE_MAX];
+        snprintf(buffer, sizeof(buffer), "%s at offset %zu of FHIRPath expression", message,
+                 (size_t)(compiler->token.start - compiler->source));
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, buffer);
+        compiler->failed = true;
+    }
+    return false;
+}
+
+static bool token_is(const FHIRPathToken* token, const char* word) {
+    return token->type == FHIR_PATH_TOKEN_IDENTIFIER && strlen(word) == token->length &&
+           memcmp(token->start, word, token->length) == 0;
+}
+
+static bool compiler_expect(FHIRPathCompiler* compiler, FHIRPathTokenType type, const char* message) {
+    if (compiler->token.type != type) {
+        return compiler_fail(compiler, message);
+    }
+    compiler_advance(compiler);
+    return true;
+}
+
+/* ========================================================================== */
+/* Code Generation                                                            */
+/* ========================================================================== */
+
+// Append an instruction; returns its index or SIZE_MAX on allocation failure
+static size_t emit(FHIRPathCompiler* compiler, FHIRPathOpcode opcode) {
+    FHIRPathProgram* program = compiler->program;
+    if (program->count == program->capacity) {
+        size_t capacity = program->capacity ? program->capacity * 2 : 8;
+        FHIRPathInstruction* code = fhir_realloc(program->code, capacity * sizeof(FHIRPathInstruction));
+        if (!code) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate FHIRPath program");
+            compiler->failed = true;
+            return SIZE_MAX;
+        }
+        program->code = code;
+        program->capacity = capacity;
+    }
+    FHIRPathInstruction* instruction = &program->code[program->count];
+    memset(instruction, 0, sizeof(*instruction));
+    instruction->opcode = opcode;
+    return program->count++;
+}
+
+static char* copy_text(FHIRPathCompiler* compiler, const char* text, size_t length) {
+    char* copy = fhir_malloc(length + 1);
+    if (!copy) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate FHIRPath program");
+        compiler->failed = true;
+        return NULL;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static char* copy_string_literal(FHIRPathCompiler* compiler, const FHIRPathToken* token) {
+    char* copy = copy_text(compiler, token->start, token->length);
+    if (!copy) return NULL;
+
+    // Decode \' \\ \" \/ \t \n \r in place; the result is never longer
+    char* out = copy;
+    for (const char* in = copy; *in; in++) {
+        if (*in == '\\' && in[1]) {
+            in++;
+            switch (*in) {
+                case 't': *out++ = '\t'; break;
+                case 'n': *out++ = '\n'; break;
+                case 'r': *out++ = '\r'; break;
+                default: *out++ = *in; break;
+            }
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+    return copy;
+}
+
+static bool emit_child(FHIRPathCompiler* compiler, const char* name, size_t length) {
+    size_t index = emit(compiler, FHIR_PATH_OP_CHILD);
+    if (index == SIZE_MAX) return false;
+    compiler->program->code[index].name = copy_text(compiler, name, length);
+    return compiler->program->code[index].name != NULL;
+}
+
+// ofType(T) and 'as T' name the choice element: value + Quantity = valueQuantity
+static bool apply_type(FHIRPathCompiler* compiler) {
+    if (compiler->token.type != FHIR_PATH_TOKEN_IDENTIFIER) {
+        return compiler_fail(compiler, "Expected a type name");
+    }
+    FHIRPathProgram* program = compiler->program;
+    FHIRPathInstruction* last = program->count > 0 ? &program->code[program->count - 1] : NULL;
+    if (!last || last->opcode != FHIR_PATH_OP_CHILD) {
+        return compiler_fail(compiler, "Type selection must follow an element name");
+    }
+
+    size_t base_length = strlen(last->name);
+    size_t type_length = compiler->token.length;
+    char* name = fhir_realloc(last->name, base_length + type_length + 1);
+    if (!name) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate FHIRPath program");
+        compiler->failed = true;
+        return false;
+    }
+    memcpy(name + base_length, compiler->token.start, type_length);
+    name[base_length] = (char)toupper((unsigned char)name[base_length]);
+    name[base_length + type_length] = '\0';
+    last->name = name;
+    compiler_advance(compiler);
+    return true;
+}
+
+/* ========================================================================== */
+/* Parser                                                                     */
+/* ========================================================================== */
+
+static bool parse_criteria(FHIRPathCompiler* compiler);
+
+static bool enter(FHIRPathCompiler* compiler) {
+    if (++compiler->depth > FHIR_PATH_MAX_DEPTH) {
+        return compiler_fail(compiler, "Expression nested too deeply");
+    }
+    return true;
+}
+
+// where(criteria): the criteria follow the WHERE instruction inline
+static bool parse_where(FHIRPathCompiler* compiler) {
+    size_t where = emit(compiler, FHIR_PATH_OP_WHERE);
+    if (where == SIZE_MAX || !enter(compiler) || !parse_criteria(compiler)) {
+        return false;
+    }
+    compiler->depth--;
+    compiler->program->code[where].length = (uint32_t)(compiler->program->count - where - 1);
+    return true;
+}
+
+// extension('url') is shorthand for extension.where(url = 'url')
+static bool parse_extension(FHIRPathCompiler* compiler) {
+    if (compiler->token.type != FHIR_PATH_TOKEN_STRING) {
+        return compiler_fail(compiler, "Expected an extension URL");
+    }
+    size_t where;
+    size_t test;
+    if (!emit_child(compiler, "extension", 9) ||
+        (where = emit(compiler, FHIR_PATH_OP_WHERE)) == SIZE_MAX ||
+        (test = emit(compiler, FHIR_PATH_OP_TEST)) == SIZE_MAX) {
+        return false;
+    }
+    FHIRPathInstruction* instruction = &compiler->program->code[test];
+    instruction->test = FHIR_PATH_TEST_EQUALS;
+    instruction->literal = FHIR_PATH_LITERAL_STRING;
+    instruction->length = 1;
+    if (!(instruction->name = copy_string_literal(compiler, &compiler->token)) ||
+        !emit_child(compiler, "url", 3)) {
+        return false;
+    }
+    compiler->program->code[where].length = 2;
+    compiler_advance(compiler);
+    return true;
+}
+
+// One invocation after '.': an element name or a supported function
+static bool parse_invocation(FHIRPathCompiler* compiler) {
+    FHIRPathToken name = compiler->token;
+    if (name.type != FHIR_PATH_TOKEN_IDENTIFIER) {
+        return compiler_fail(compiler, "Expected an element or function name");
+    }
+    compiler_advance(compiler);
+    if (compiler->token.type != FHIR_PATH_TOKEN_LPAREN) {
+        return emit_child(compiler, name.start, name.length);
+    }
+    compiler_advance(compiler);
+
+    bool ok;
+    if (token_is(&name, "where")) {
+        ok = parse_where(compiler);
+    } else if (token_is(&name, "first")) {
+        ok = emit(compiler, FHIR_PATH_OP_FIRST) != SIZE_MAX;
+    } else if (token_is(&name, "last")) {
+        ok = emit(compiler, FHIR_PATH_OP_LAST) != SIZE_MAX;
+    } else if (token_is(&name, "ofType")) {
+        ok = apply_type(compiler);
+    } else if (token_is(&name, "extension")) {
+        ok = parse_extension(compiler);
+    } else {
+        compiler->token = name;
+        return compiler_fail(compiler, "Unsupported function");
+    }
+    return ok && compiler_expect(compiler, FHIR_PATH_TOKEN_RPAREN, "Expected ')'");
+}
+
+// Trailing invocations and indexers of a path; stops before .exists() and .empty() in criteria
+static bool parse_steps(FHIRPathCompiler* compiler, bool in_criteria) {
+    while (!compiler->failed) {
+        if (compiler->token.type == FHIR_PATH_TOKEN_LBRACKET) {
+            compiler_advance(compiler);
+            FHIRPathToken index = compiler->token;
+            if (index.type != FHIR_PATH_TOKEN_NUMBER || index.number < 0 ||
+                index.number != (double)(size_t)index.number) {
+                return compiler_fail(compiler, "Expected a non-negative integer index");
+            }
+            size_t instruction = emit(compiler, FHIR_PATH_OP_INDEX);
+            if (instruction == SIZE_MAX) return false;
+            compiler->program->code[instruction].number = index.number;
+            compiler_advance(compiler);
+            if (!compiler_expect(compiler, FHIR_PATH_TOKEN_RBRACKET, "Expected ']'")) return false;
+        } else if (compiler->token.type == FHIR_PATH_TOKEN_DOT) {
+            if (in_criteria) {
+                FHIRPathToken next;
+                const char* after = lex_token(compiler->position, &next);
+                FHIRPathToken paren;
+                lex_token(after, &paren);
+                if ((token_is(&next, "exists") || token_is(&next, "empty")) &&
+                    paren.type == FHIR_PATH_TOKEN_LPAREN) {
+                    return true;
+                }
+            }
+            compiler_advance(compiler);
+            if (!parse_invocation(compiler)) return false;
+        } else if (token_is(&compiler->token, "as") && compiler_peek(compiler) == FHIR_PATH_TOKEN_IDENTIFIER) {
+            compiler_advance(compiler);
+            if (!apply_type(compiler)) return false;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+// First element of a top-level path: a capitalized name is a resource type
+static bool parse_path_start(FHIRPathCompiler* compiler) {
+    FHIRPathToken name = compiler->token;
+    if (name.type != FHIR_PATH_TOKEN_IDENTIFIER) {
+        return compiler_fail(compiler, "Expected an element or resource type name");
+    }
+    if (isupper((unsigned char)name.start[0]) && compiler_peek(compiler) != FHIR_PATH_TOKEN_LPAREN) {
+        size_t instruction = emit(compiler, FHIR_PATH_OP_TYPE);
+        if (instruction == SIZE_MAX) return false;
+        compiler->program->code[instruction].name = copy_text(compiler, name.start, name.length);
+        compiler_advance(compiler);
+        return compiler->program->code[instruction].name != NULL;
+    }
+    return parse_invocation(compiler);
+}
+
+// path := '(' path ')' steps | start steps
+static bool parse_path(FHIRPathCompiler* compiler) {
+    if (compiler->token.type == FHIR_PATH_TOKEN_LPAREN) {
+        compiler_advance(compiler);
+        if (!enter(compiler) || !parse_path(compiler) ||
+            !compiler_expect(compiler, FHIR_PATH_TOKEN_RPAREN, "Expected ')'")) {
+            return false;
+        }
+        compiler->depth--;
+    } else if (!parse_path_start(compiler)) {
+        return false;
+    }
+    return parse_steps(compiler, false);
+}
+
+// test := ('$this' | invocation) steps [.exists() | .empty()] [('=' | '!=') literal]
+static bool parse_test(FHIRPathCompiler* compiler) {
+    size_t test = emit(compiler, FHIR_PATH_OP_TEST);
+    if (test == SIZE_MAX) return false;
+
+    if (compiler->token.type == FHIR_PATH_TOKEN_THIS) {
+        compiler_advance(compiler);
+    } else if (!parse_invocation(compiler)) {
+        return false;
+    }
+    if (!parse_steps(compiler, true)) return false;
+
+    FHIRPathProgram* program = compiler->program;
+    program->code[test].length = (uint32_t)(program->count - test - 1);
+    program->code[test].test = FHIR_PATH_TEST_EXISTS;
+
+    if (compiler->token.type == FHIR_PATH_TOKEN_DOT) {
+        // parse_steps stopped at exists() or empty()
+        compiler_advance(compiler);
+        program->code[test].test = token_is(&compiler->token, "empty") ? FHIR_PATH_TEST_EMPTY
+                                                                        : FHIR_PATH_TEST_EXISTS;
+        compiler_advance(compiler);
+        compiler_advance(compiler);
+        return compiler_expect(compiler, FHIR_PATH_TOKEN_RPAREN, "Expected ')'");
+    }
+
+    if (compiler->token.type != FHIR_PATH_TOKEN_EQUALS && compiler->token.type != FHIR_PATH_TOKEN_NOT_EQUALS) {
+        return true;
+    }
+    FHIRPathInstruction* instruction = &program->code[test];
+    instruction->test = compiler->token.type == FHIR_PATH_TOKEN_EQUALS ? FHIR_PATH_TEST_EQUALS
+                                                                      : FHIR_PATH_TEST_NOT_EQUALS;
+    compiler_advance(compiler);
+    if (compiler->token.type == FHIR_PATH_TOKEN_STRING) {
+        instruction->literal = FHIR_PATH_LITERAL_STRING;
+        instruction->name = copy_string_literal(compiler, &compiler->token);
+        if (!instruction->name) return false;
+    } else if (compiler->token.type == FHIR_PATH_TOKEN_NUMBER) {
+        instruction->literal = FHIR_PATH_LITERAL_NUMBER;
+        instruction->number = compiler->token.number;
+    } else if (token_is(&compiler->token, "true") || token_is(&compiler->token, "false")) {
+        instruction->literal = FHIR_PATH_LITERAL_BOOLEAN;
+        instruction->number = token_is(&compiler->token, "true") ? 1 : 0;
+    } else {
+        return compiler_fail(compiler, "Expected a string, number or boolean literal");
+    }
+    compiler_advance(compiler);
+    return true;
+}
+
+static bool parse_criteria_operand(FHIRPathCompiler* compiler) {
+    if (compiler->token.type != FHIR_PATH_TOKEN_LPAREN) {
+        return parse_test(compiler);
+    }
+    compiler_advance(compiler);
+    if (!enter(compiler) || !parse_criteria(compiler) ||
+        !compiler_expect(compiler, FHIR_PATH_TOKEN_RPAREN, "Expected ')'")) {
+        return false;
+    }
+    compiler->depth--;
+    return true;
+}
+
+static bool parse_criteria_and(FHIRPathCompiler* compiler) {
+    if (!parse_criteria_operand(compiler)) return false;
+    while (token_is(&compiler->token, "and")) {
+        compiler_advance(compiler);
+        if (!parse_criteria_operand(compiler) || emit(compiler, FHIR_PATH_OP_AND) == SIZE_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Criteria are emitted in postfix order: operands, then AND / OR
+static bool parse_criteria(FHIRPathCompiler* compiler) {
+    if (!parse_criteria_and(compiler)) return false;
+    while (token_is(&compiler->token, "or")) {
+        compiler_advance(compiler);
+        if (!parse_criteria_and(compiler) || emit(compiler, FHIR_PATH_OP_OR) == SIZE_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Compilation API                                                            */
+/* ========================================================================== */
+
+FHIRPathProgram* fhir_path_compile(const char* expression) {
+    if (!expression) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Expression is NULL");
+        return NULL;
+    }
+
+    FHIRPathProgram* program = fhir_calloc(1, sizeof(FHIRPathProgram));
+    if (!program || !(program->expression = fhir_strdup(expression))) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate FHIRPath program");
+        fhir_free(program);
+        return NULL;
+    }
+
+    FHIRPathCompiler compiler = { .source = expression, .position = expression, .program = program };
+    compiler_advance(&compiler);
+
+    // expression := path ('|' path)*
+    bool ok = parse_path(&compiler);
+    while (ok && compiler.token.type == FHIR_PATH_TOKEN_PIPE) {
+        compiler_advance(&compiler);
+        ok = emit(&compiler, FHIR_PATH_OP_UNION) != SIZE_MAX && parse_path(&compiler);
+    }
+    if (ok && compiler.token.type != FHIR_PATH_TOKEN_END) {
+        ok = compiler_fail(&compiler, "Unexpected token");
+    }
+
+    if (!ok) {
+        fhir_path_destroy(program);
+        return NULL;
+    }
+    return program;
+}
+
+void fhir_path_destroy(FHIRPathProgram* program) {
+    if (!program) return;
+
+    for (size_t i = 0; i < program->count; i++) {
+        fhir_free(program->code[i].name);
+    }
+    fhir_free(program->code);
+    fhir_free(program->expression);
+    fhir_free(program);
+}
+
+const char* fhir_path_get_expression(const FHIRPathProgram* program) {
+    return program ? program->expression : NULL;
+}
+
+size_t fhir_path_get_instruction_count(const FHIRPathProgram* program) {
+    return program ? program->count : 0;
+}
+
+/* ========================================================================== */
+/* Evaluation                                                                 */
+/* ========================================================================== */
+
+// The result buffer doubles as the evaluation stack: the collection being
+// navigated is always its top [base, count), and criteria work above it.
+
+void fhir_path_result_init(FHIRPathResult* result) {
+    if (!result) return;
+    memset(result, 0, sizeof(*result));
+}
+
+void fhir_path_result_cleanup(FHIRPathResult* result) {
+    if (!result) return;
+    fhir_free(result->items);
+    memset(result, 0, sizeof(*result));
+}
+
+static bool result_push(FHIRPathResult* stack, const cJSON* node) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = stack->capacity ? stack->capacity * 2 : 16;
+        const cJSON** items = fhir_realloc((void*)stack->items, capacity * sizeof(const cJSON*));
+        if (!items) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow FHIRPath result");
+            return false;
+        }
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = node;
+    return true;
+}
+
+static bool literal_matches(const FHIRPathInstruction* test, const cJSON* node) {
+    switch (test->literal) {
+        case FHIR_PATH_LITERAL_STRING:
+            return cJSON_IsString(node) && strcmp(node->valuestring, test->name) == 0;
+        case FHIR_PATH_LITERAL_NUMBER:
+            return cJSON_IsNumber(node) && node->valuedouble == test->number;
+        case FHIR_PATH_LITERAL_BOOLEAN:
+            return cJSON_IsBool(node) && cJSON_IsTrue(node) == (test->number != 0);
+        default:
+            return false;
+    }
+}
+
+static bool evaluate_criteria(const FHIRPathInstruction* code, size_t begin, size_t end,
+                              const cJSON* node, FHIRPathResult* stack, bool* matched);
+
+static bool evaluate_navigation(const FHIRPathInstruction* code, size_t begin, size_t end,
+                                FHIRPathResult* stack, size_t base) {
+    for (size_t pc = begin; pc < end; pc++) {
+        const FHIRPathInstruction* instruction = &code[pc];
+        size_t top = stack->count;
+        switch (instruction->opcode) {
+            case FHIR_PATH_OP_TYPE: {
+                size_t kept = base;
+                for (size_t i = base; i < top; i++) {
+                    const char* type = cJSON_GetStringValue(
+                        cJSON_GetObjectItemCaseSensitive(stack->items[i], "resourceType"));
+                    if (type && strcmp(type, instruction->name) == 0) {
+                        stack->items[kept++] = stack->items[i];
+                    }
+                }
+                stack->count = kept;
+                break;
+            }
+            case FHIR_PATH_OP_CHILD: {
+                // Children are pushed above the collection, then moved down over it
+                for (size_t i = base; i < top; i++) {
+                    const cJSON* node = stack->items[i];
+                    const cJSON* child = cJSON_IsObject(node)
+                                             ? cJSON_GetObjectItemCaseSensitive(node, instruction->name)
+                                             : NULL;
+                    if (cJSON_IsArray(child)) {
+                        const cJSON* item;
+                        cJSON_ArrayForEach(item, child) {
+                            if (!result_push(stack, item)) return false;
+                        }
+                    } else if (child && !result_push(stack, child)) {
+                        return false;
+                    }
+                }
+                size_t produced = stack->count - top;
+                memmove((void*)(stack->items + base), stack->items + top, produced * sizeof(const cJSON*));
+                stack->count = base + produced;
+                break;
+            }
+            case FHIR_PATH_OP_INDEX: {
+                size_t index = (size_t)instruction->number;
+                if (index < top - base) {
+                    stack->items[base] = stack->items[base + index];
+                    stack->count = base + 1;
+                } else {
+                    stack->count = base;
+                }
+                break;
+            }
+            case FHIR_PATH_OP_FIRST:
+                if (top > base) stack->count = base + 1;
+                break;
+            case FHIR_PATH_OP_LAST:
+                if (top > base) {
+                    stack->items[base] = stack->items[top - 1];
+                    stack->count = base + 1;
+                }
+                break;
+            case FHIR_PATH_OP_WHERE: {
+                size_t kept = base;
+                for (size_t i = base; i < top; i++) {
+                    const cJSON* node = stack->items[i];
+                    bool matched;
+                    if (!evaluate_criteria(code, pc + 1, pc + 1 + instruction->length, node, stack, &matched)) {
+                        return false;
+                    }
+                    if (matched) {
+                        stack->items[kept++] = node;
+                    }
+                }
+                stack->count = kept;
+                pc += instruction->length;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+static bool evaluate_criteria(const FHIRPathInstruction* code, size_t begin, size_t end,
+                              const cJSON* node, FHIRPathResult* stack, bool* matched) {
+    // Postfix evaluation; nesting is bounded at compile time
+    bool values[2 * FHIR_PATH_MAX_DEPTH + 2];
+    size_t depth = 0;
+    size_t top = stack->count;
+
+    for (size_t pc = begin; pc < end; pc++) {
+        const FHIRPathInstruction* instruction = &code[pc];
+        if (instruction->opcode == FHIR_PATH_OP_AND || instruction->opcode == FHIR_PATH_OP_OR) {
+            bool right = values[--depth];
+            bool left = values[depth - 1];
+            values[depth - 1] = instruction->opcode == FHIR_PATH_OP_AND ? left && right : left || right;
+            continue;
+        }
+
+        // FHIR_PATH_OP_TEST: navigate from the node, then test what it reached
+        if (!result_push(stack, node) ||
+            !evaluate_navigation(code, pc + 1, pc + 1 + instruction->length, stack, top)) {
+            return false;
+        }
+        bool value;
+        if (instruction->test == FHIR_PATH_TEST_EXISTS || instruction->test == FHIR_PATH_TEST_EMPTY) {
+            value = (stack->count > top) == (instruction->test == FHIR_PATH_TEST_EXISTS);
+        } else {
+            bool any = false;
+            for (size_t i = top; i < stack->count && !any; i++) {
+                any = literal_matches(instruction, stack->items[i]);
+            }
+            value = any == (instruction->test == FHIR_PATH_TEST_EQUALS);
+        }
+        stack->count = top;
+        values[depth++] = value;
+        pc += instruction->length;
+    }
+
+    *matched = depth > 0 && values[depth - 1];
+    return true;
+}
+
+bool fhir_path_evaluate(const FHIRPathProgram* program, const cJSON* resource, FHIRPathResult* result) {
+    if (!program || !result) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    result->count = 0;
+    if (!resource) return true;
+
+    // Each alternative of a union appends its nodes after the previous ones
+    size_t begin = 0;
+    while (begin <= program->count) {
+        size_t end = begin;
+        while (end < program->count && program->code[end].opcode != FHIR_PATH_OP_UNION) end++;
+
+        size_t base = result->count;
+        if (!result_push(result, resource) ||
+            !evaluate_navigation(program->code, begin, end, result, base)) {
+            return false;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+bool fhir_path_evaluate_batch(const FHIRPathProgram* const* programs, size_t program_count,
+                              const cJSON* const* resources, size_t resource_count,
+                              FHIRPathResult* results) {
+    if ((program_count > 0 && !programs) || (resource_count > 0 && !resources) ||
+        (program_count > 0 && resource_count > 0 && !results)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    for (size_t r = 0; r < resource_count; r++) {
+        for (size_t p = 0; p < program_count; p++) {
+            if (!fhir_path_evaluate(programs[p], resources[r], &results[r * program_count + p])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file fhir_path.h
+ * @brief Compiled FHIRPath subset for field extraction
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * An expression is compiled once into a flat instruction program, which is
+ * then evaluated against any number of cJSON resource trees. Results are
+ * the matching nodes of the tree, so evaluation copies nothing.
+ *
+ * Supported subset (enough for search parameter definitions):
+ *
+ *   Patient.name.family                 type prefix, element navigation
+ *   name[0].given                       indexers
+ *   name.first() / name.last()
+ *   code.coding.where(system = 'http://loinc.org').code
+ *   telecom.where(use != 'old' and (system = 'phone' or system = 'sms'))
+ *   identifier.where(period.exists()) / where(period.empty()) / where($this = 'x')
+ *   extension('http://example.org/ext').value.ofType(string)
+ *   (Observation.value as Quantity) / value.ofType(Quantity)
+ *   Patient.name | Practitioner.name    union of alternatives
+ *
+ * Collections flatten arrays as FHIRPath does. '=' and '!=' inside where()
+ * hold if any (respectively no) node of the left side equals the literal,
+ * which is a string, a number, true or false. ofType and 'as' select the
+ * choice element directly (value + Quantity = valueQuantity). Anything else
+ * fails to compile with FHIR_ERROR_PARSE_FAILED and the offending offset.
+ */
+
+#ifndef FHIR_PATH_H
+#define FHIR_PATH_H
+
+#include "common/fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque compiled expression (immutable, so shareable across threads)
+ */
+typedef struct FHIRPathProgram FHIRPathProgram;
+
+/**
+ * @brief Nodes selected by an expression
+ *
+ * Items point into the evaluated tree and stay valid as long as it does.
+ * Reusing a result across evaluations reuses its buffer.
+ */
+typedef struct {
+    const cJSON** items;
+    size_t count;
+    size_t capacity;
+} FHIRPathResult;
+
+/* ========================================================================== */
+/* Compilation                                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Compile an expression
+ * @param expression FHIRPath expression in the supported subset
+ * @return Program or NULL on failure (FHIR_ERROR_PARSE_FAILED)
+ */
+FHIRPathProgram* fhir_path_compile(const char* expression);
+
+/**
+ * @brief Destroy a program
+ * @param program Program to destroy (can be NULL)
+ */
+void fhir_path_destroy(FHIRPathProgram* program);
+
+/**
+ * @brief Get the source expression of a program
+ * @param program Program instance
+ * @return Expression text
+ */
+const char* fhir_path_get_expression(const FHIRPathProgram* program);
+
+/**
+ * @brief Get the number of instructions of a program
+ * @param program Program instance
+ * @return Instruction count
+ */
+size_t fhir_path_get_instruction_count(const FHIRPathProgram* program);
+
+/* ========================================================================== */
+/* Evaluation                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty result
+ * @param result Result to initialize
+ */
+void fhir_path_result_init(FHIRPathResult* result);
+
+/**
+ * @brief Free the buffer of a result
+ * @param result Result to clean up (can be NULL)
+ */
+void fhir_path_result_cleanup(FHIRPathResult* result);
+
+/**
+ * @brief Evaluate a program against a resource
+ * @param program Compiled program
+ * @param resource Resource JSON tree
+ * @param result Output nodes (replaces the previous contents)
+ * @return true on success, false on allocation failure
+ */
+bool fhir_path_evaluate(const FHIRPathProgram* program, const cJSON* resource, FHIRPathResult* result);
+
+/**
+ * @brief Evaluate several programs against several resources in one call
+ *
+ * results[r * program_count + p] receives program p on resource r. The
+ * results must be initialized; their buffers are reused.
+ *
+ * @param programs Compiled programs
+ * @param program_count Number of programs
+ * @param resources Resource JSON trees (NULL entries give empty results)
+ * @param resource_count Number of resources
+ * @param results Output array of resource_count * program_count results
+ * @return true on success, false on allocation failure
+ */
+bool fhir_path_evaluate_batch(const FHIRPathProgram* const* programs, size_t program_count,
+                              const cJSON* const* resources, size_t resource_count,
+                              FHIRPathResult* results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PATH_H */
@@ -0,0 +1,105 @@
+/**
+ * @file fhir_python_document.h
+ * @brief Resource arguments taken as JSON text or a fhir_parser_c.ParsedDocument
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * The index and buffer extensions (fhir_interval_c, fhir_spatial_c, ...)
+ * accept resources that fhir_parser_c has already parsed. fast_fhir.fhir_parser_c
+ * exports a capsule named _fhir_documents through which they borrow a
+ * ParsedDocument's tree instead of parsing the resource again. A module
+ * imports it once from its exec and falls back to JSON text alone when
+ * fhir_parser_c is not available.
+ *
+ * The extensions are built from one tree against the same cJSON, so a tree
+ * from fhir_parser_c can be read by any of them; it must not be modified or
+ * freed outside fhir_parser_c.
+ */
+
+#ifndef FHIR_PYTHON_DOCUMENT_H
+#define FHIR_PYTHON_DOCUMENT_H
+
+#include "fhir_python_json.h"
+#include "common/fhir_json_reader.h"
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Module attribute holding the capsule */
+#define FHIR_PY_DOCUMENTS_ATTRIBUTE "_fhir_documents"
+
+/** @brief Capsule name, also the path PyCapsule_Import resolves */
+#define FHIR_PY_DOCUMENTS_CAPSULE "fast_fhir.fhir_parser_c._fhir_documents"
+
+/**
+ * @brief Entry points fhir_parser_c exports for its ParsedDocuments
+ *
+ * Internal to the extensions, which are built from one tree, so the
+ * layout needs no versioning.
+ */
+typedef struct {
+    /**
+     * Borrow the tree of a ParsedDocument from any import of fhir_parser_c.
+     * Returns 1 with *json set, 0 if document is not a ParsedDocument, or
+     * -1 with an exception set. The tree stays valid until the document is
+     * re-initialized, which callers must not do concurrently.
+     */
+    int (*document_json)(PyObject* document, const cJSON** json);
+} FHIRPythonDocuments;
+
+/**
+ * @brief Import the entry points of fast_fhir.fhir_parser_c from a module exec
+ * @return Entry points, or NULL (with no exception set) if fhir_parser_c is not available
+ */
+static inline const FHIRPythonDocuments* fhir_python_import_documents(void) {
+    const FHIRPythonDocuments* documents = PyCapsule_Import(FHIR_PY_DOCUMENTS_CAPSULE, 0);
+    if (!documents) {
+        PyErr_Clear();
+    }
+    return documents;
+}
+
+/**
+ * @brief Get the tree of a ParsedDocument, or parse JSON text into *owned
+ *
+ * Large JSON text is parsed without the GIL.
+ *
+ * @param documents Entry points from fhir_python_import_documents (can be NULL)
+ * @param document ParsedDocument, str or bytes-like object
+ * @param owned Set to the parsed tree the caller must delete, or NULL
+ * @return Tree, or NULL with an exception set
+ */
+static inline const cJSON* fhir_python_document_json(const FHIRPythonDocuments* documents, PyObject* document,
+                                                     cJSON** owned) {
+    *owned = NULL;
+    const cJSON* json = NULL;
+    int found = documents ? documents->document_json(document, &json) : 0;
+    if (found != 0) {
+        return found > 0 ? json : NULL;
+    }
+
+    if (!PyUnicode_Check(document) && !PyObject_CheckBuffer(document)) {
+        PyErr_SetString(PyExc_TypeError, "Expected a ParsedDocument, str or bytes-like object");
+        return NULL;
+    }
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(document, &view)) {
+        return NULL;
+    }
+    FHIR_BEGIN_ALLOW_THREADS(view.len)
+    *owned = fhir_json_parse(view.buf, (size_t)view.len);
+    FHIR_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (*owned == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+    }
+    return *owned;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PYTHON_DOCUMENT_H */
@@ -0,0 +1,153 @@
+/**
+ * @file fhir_python_json.c
+ * @brief Direct cJSON to Python object conversion for the FHIR C extensions
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_python_json.h"
+#include <math.h>
+#include <stdint.h>
+
+// Largest magnitude that cJSON_Print would still emit as an integer literal
+#define FHIR_PY_JSON_MAX_EXACT_INT 1e15
+
+#ifdef Py_GIL_DISABLED
+#define KEY_CACHE_LOCK(keys) PyMutex_Lock(&(keys)->mutex)
+#define KEY_CACHE_UNLOCK(keys) PyMutex_Unlock(&(keys)->mutex)
+#else
+#define KEY_CACHE_LOCK(keys) ((void)0)
+#define KEY_CACHE_UNLOCK(keys) ((void)0)
+#endif
+
+void fhir_python_key_cache_clear(FHIRPythonKeyCache* keys) {
+    for (size_t i = 0; i < FHIR_PY_JSON_KEY_CACHE_SIZE; i++) {
+        Py_CLEAR(keys->entries[i].key);
+    }
+}
+
+static PyObject* member_name_to_python(const char* name, FHIRPythonKeyCache* keys) {
+    if (!keys) {
+        return PyUnicode_InternFromString(name);
+    }
+
+    uint32_t hash = 2166136261u;
+    size_t length = 0;
+    while (name[length] && length <= FHIR_PY_JSON_KEY_MAX_LENGTH) {
+        hash = (hash ^ (uint8_t)name[length]) * 16777619u;
+        length++;
+    }
+    if (length > FHIR_PY_JSON_KEY_MAX_LENGTH) {
+        return PyUnicode_InternFromString(name);
+    }
+
+    PyObject* key = NULL;
+    KEY_CACHE_LOCK(keys);
+    FHIRPythonKeyCacheEntry* entry = &keys->entries[hash & (FHIR_PY_JSON_KEY_CACHE_SIZE - 1)];
+    if (entry->key && memcmp(entry->name, name, length + 1) == 0) {
+        key = entry->key;
+        Py_INCREF(key);
+    }
+    KEY_CACHE_UNLOCK(keys);
+    if (key) {
+        return key;
+    }
+
+    key = PyUnicode_InternFromString(name);
+    if (!key) {
+        return NULL;
+    }
+    Py_INCREF(key);
+    KEY_CACHE_LOCK(keys);
+    PyObject* replaced = entry->key;
+    entry->key = key;
+    memcpy(entry->name, name, length + 1);
+    KEY_CACHE_UNLOCK(keys);
+    Py_XDECREF(replaced);
+    return key;
+}
+
+static PyObject* number_to_python(double value) {
+    if (!isfinite(value)) {
+        // cJSON prints NaN and infinity as null
+        Py_RETURN_NONE;
+    }
+    if (value == floor(value) && fabs(value) < FHIR_PY_JSON_MAX_EXACT_INT) {
+        return PyLong_FromLongLong((long long)value);
+    }
+    return PyFloat_FromDouble(value);
+}
+
+static PyObject* array_to_python(const cJSON* array, FHIRPythonKeyCache* keys) {
+    PyObject* list = PyList_New(cJSON_GetArraySize(array));
+    if (!list) {
+        return NULL;
+    }
+    
+    Py_ssize_t index = 0;
+    for (const cJSON* child = array->child; child; child = child->next) {
+        PyObject* value = fhir_cjson_to_python_cached(child, keys);
+        if (!value) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, index++, value);
+    }
+    
+    return list;
+}
+
+static PyObject* object_to_python(const cJSON* object, FHIRPythonKeyCache* keys) {
+    PyObject* dict = PyDict_New();
+    if (!dict) {
+        return NULL;
+    }
+    
+    for (const cJSON* child = object->child; child; child = child->next) {
+        PyObject* key = member_name_to_python(child->string ? child->string : "", keys);
+        if (!key) {
+            Py_DECREF(dict);
+            return NULL;
+        }
+        
+        PyObject* value = fhir_cjson_to_python_cached(child, keys);
+        if (!value || PyDict_SetItem(dict, key, value) < 0) {
+            Py_XDECREF(value);
+            Py_DECREF(key);
+            Py_DECREF(dict);
+            return NULL;
+        }
+        Py_DECREF(value);
+        Py_DECREF(key);
+    }
+    
+    return dict;
+}
+
+PyObject* fhir_cjson_to_python(const cJSON* item) {
+    return fhir_cjson_to_python_cached(item, NULL);
+}
+
+PyObject* fhir_cjson_to_python_cached(const cJSON* item, FHIRPythonKeyCache* keys) {
+    if (!item || cJSON_IsNull(item)) {
+        Py_RETURN_NONE;
+    }
+    if (cJSON_IsBool(item)) {
+        return PyBool_FromLong(cJSON_IsTrue(item));
+    }
+    if (cJSON_IsNumber(item)) {
+        return number_to_python(item->valuedouble);
+    }
+    if (cJSON_IsString(item)) {
+        return PyUnicode_FromString(item->valuestring ? item->valuestring : "");
+    }
+    if (cJSON_IsArray(item)) {
+        return array_to_python(item, keys);
+    }
+    if (cJSON_IsObject(item)) {
+        return object_to_python(item, keys);
+    }
+    
+    PyErr_SetString(PyExc_ValueError, "Unsupported JSON value");
+    return NULL;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file fhir_python_json.h
+ * @brief Direct cJSON to Python object conversion for the FHIR C extensions
+ * @version 0.1.0
+ * @date 2024-01-01
+ * 
+ * Builds Python dict/list/str/int/float/bool/None objects straight from a
+ * cJSON tree, avoiding the print + json.loads round trip.
+ */
+
+#ifndef FHIR_PYTHON_JSON_H
+#define FHIR_PYTHON_JSON_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <cjson/cJSON.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Input size (bytes) from which parse entry points release the GIL
+ *
+ * Below this the PyEval_SaveThread/RestoreThread round trip costs more than
+ * the parse it would overlap with other threads.
+ */
+#ifndef FHIR_PYTHON_NOGIL_MIN_LENGTH
+#define FHIR_PYTHON_NOGIL_MIN_LENGTH 2048
+#endif
+
+/**
+ * @brief Release the GIL around a block of pure C work on a text of the given length
+ *
+ * The block must not touch Python objects. Input text must be owned by an
+ * object the caller holds a reference to and that cannot change meanwhile
+ * (the UTF-8 buffer of a str argument, an exported Py_buffer, ...). Error
+ * state in common/fhir_common.c is thread-local, so FHIR_SET_ERROR inside
+ * the block is safe.
+ */
+#define FHIR_BEGIN_ALLOW_THREADS(length) \
+    { \
+        PyThreadState* _fhir_save = ((size_t)(length) >= FHIR_PYTHON_NOGIL_MIN_LENGTH) \
+            ? PyEval_SaveThread() : NULL;
+
+/**
+ * @brief Reacquire the GIL released by FHIR_BEGIN_ALLOW_THREADS
+ */
+#define FHIR_END_ALLOW_THREADS \
+        if (_fhir_save) { \
+            PyEval_RestoreThread(_fhir_save); \
+        } \
+    }
+
+/**
+ * @brief Check the positional argument count of a METH_FASTCALL function
+ * @param name Function name for the error message
+ * @param nargs Number of arguments received
+ * @param min Minimum number of arguments
+ * @param max Maximum number of arguments
+ * @return 1 if the count is accepted, 0 with TypeError set otherwise
+ */
+static inline int fhir_python_check_args(const char* name, Py_ssize_t nargs,
+                                         Py_ssize_t min, Py_ssize_t max) {
+    if (nargs < min || nargs > max) {
+        if (min == max) {
+            PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument%s (%zd given)",
+                         name, min, min == 1 ? "" : "s", nargs);
+        } else {
+            PyErr_Format(PyExc_TypeError, "%s() takes from %zd to %zd arguments (%zd given)",
+                         name, min, max, nargs);
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Borrow the UTF-8 text of an argument (the "s#" / "s" converters)
+ *
+ * The text is cached on the str object and lives as long as the argument.
+ * With a length output bytes are accepted as well, as "s#" does.
+ *
+ * @param arg Argument to convert
+ * @param text Output UTF-8 text
+ * @param length Output length in bytes; NULL rejects embedded NUL characters like "s"
+ * @return 1 on success, 0 with TypeError or ValueError set otherwise
+ */
+static inline int fhir_python_text_arg(PyObject* arg, const char** text, Py_ssize_t* length) {
+    if (length && PyBytes_Check(arg)) {
+        *text = PyBytes_AS_STRING(arg);
+        *length = PyBytes_GET_SIZE(arg);
+        return 1;
+    }
+    if (!PyUnicode_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "argument must be str, not %.50s", Py_TYPE(arg)->tp_name);
+        return 0;
+    }
+    Py_ssize_t size;
+    *text = PyUnicode_AsUTF8AndSize(arg, &size);
+    if (!*text) {
+        return 0;
+    }
+    if (length) {
+        *length = size;
+    } else if (strlen(*text) != (size_t)size) {
+        PyErr_SetString(PyExc_ValueError, "embedded null character");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Borrow the JSON text of a str or buffer-protocol argument (the "s*" converter)
+ *
+ * A str exposes its cached UTF-8 encoding; bytes, bytearray, memoryview,
+ * mmap and any other contiguous buffer are used in place without decoding
+ * or copying. The text is not NUL-terminated and may hold any bytes, so it
+ * must be parsed with its length (cJSON_ParseWithLength). The export keeps
+ * resizable objects such as bytearray from being resized until release.
+ *
+ * @param arg Argument to convert
+ * @param view Output buffer; release with PyBuffer_Release
+ * @return 1 on success, 0 with TypeError or BufferError set otherwise
+ */
+static inline int fhir_python_buffer_arg(PyObject* arg, Py_buffer* view) {
+    if (PyUnicode_Check(arg)) {
+        Py_ssize_t size;
+        const char* text = PyUnicode_AsUTF8AndSize(arg, &size);
+        return text && PyBuffer_FillInfo(view, arg, (void*)text, size, 1, PyBUF_SIMPLE) == 0;
+    }
+    if (!PyObject_CheckBuffer(arg)) {
+        PyErr_Format(PyExc_TypeError, "argument must be str or a bytes-like object, not %.50s",
+                     Py_TYPE(arg)->tp_name);
+        return 0;
+    }
+    return PyObject_GetBuffer(arg, view, PyBUF_SIMPLE) == 0;
+}
+
+/**
+ * @brief Borrow the UTF-8 text of a str-or-None argument (the "z" converter)
+ * @param arg Argument to convert
+ * @param text Output UTF-8 text, NULL for None
+ * @return 1 on success, 0 with an exception set otherwise
+ */
+static inline int fhir_python_optional_text_arg(PyObject* arg, const char** text) {
+    if (arg == Py_None) {
+        *text = NULL;
+        return 1;
+    }
+    return fhir_python_text_arg(arg, text, NULL);
+}
+
+/** @brief Number of member names a key cache holds (a power of two) */
+#define FHIR_PY_JSON_KEY_CACHE_SIZE 512
+
+/** @brief Longest member name a key cache stores; longer ones are interned directly */
+#define FHIR_PY_JSON_KEY_MAX_LENGTH 31
+
+/**
+ * @brief Member name cache of one module, kept in its per-module state
+ *
+ * Direct-mapped on the FNV-1a hash of the name's bytes; a colliding name
+ * replaces the previous one. Module state is zeroed on creation, which is
+ * an empty cache. The module's m_clear must call fhir_python_key_cache_clear,
+ * which drops the cached strs with the module rather than at process exit.
+ */
+typedef struct {
+    char name[FHIR_PY_JSON_KEY_MAX_LENGTH + 1];
+    PyObject* key;      // Interned str, one reference held by the cache
+} FHIRPythonKeyCacheEntry;
+
+typedef struct {
+    FHIRPythonKeyCacheEntry entries[FHIR_PY_JSON_KEY_CACHE_SIZE];
+#ifdef Py_GIL_DISABLED
+    PyMutex mutex;      // Threads of the interpreter share the cache
+#endif
+} FHIRPythonKeyCache;
+
+/**
+ * @brief Release every str held by a key cache, leaving it empty
+ * @param keys Cache to clear
+ */
+void fhir_python_key_cache_clear(FHIRPythonKeyCache* keys);
+
+/**
+ * @brief Convert a cJSON tree to the equivalent Python object
+ *
+ * Object keys are interned, so repeated FHIR member names share one
+ * string object and hash.
+ *
+ * @param item cJSON item to convert (NULL converts to None)
+ * @return New reference or NULL with a Python exception set
+ */
+PyObject* fhir_cjson_to_python(const cJSON* item);
+
+/**
+ * @brief Convert a cJSON tree, looking short member names up in a key cache
+ *
+ * The hot conversion paths pass the cache in their module's state, so the
+ * common member names of a resource are created once per module rather
+ * than once per object.
+ *
+ * @param item cJSON item to convert (NULL converts to None)
+ * @param keys Key cache of the calling module, or NULL for none
+ * @return New reference or NULL with a Python exception set
+ */
+PyObject* fhir_cjson_to_python_cached(const cJSON* item, FHIRPythonKeyCache* keys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PYTHON_JSON_H */
@@ -0,0 +1,160 @@
+/**
+ * @file fhir_python_module.h
+ * @brief Multi-phase initialization helpers for the FHIR C extension modules
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Every extension module is initialized in phases (PEP 489): PyInit_*
+ * returns the module definition and its Py_mod_exec slot fills in a fresh
+ * module object. Types are heap types created from a PyType_Spec in the
+ * exec slot and kept, with any cached Python objects, in per-module state,
+ * so each interpreter that imports a module gets its own copies and nothing
+ * Python-level is shared between interpreters.
+ *
+ * The modules declare support for a per-interpreter GIL (3.12+) and for
+ * running without the GIL on free-threaded builds (3.13t). Objects whose
+ * C state a method mutates guard it with FHIR_PY_BEGIN_CRITICAL_SECTION;
+ * the C core (registry, error state, pools, counters) is thread-safe.
+ */
+
+#ifndef FHIR_PYTHON_MODULE_H
+#define FHIR_PYTHON_MODULE_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if PY_VERSION_HEX >= 0x030C0000
+#define FHIR_PY_MOD_INTERPRETERS_SLOT { Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED },
+#else
+#define FHIR_PY_MOD_INTERPRETERS_SLOT
+#endif
+
+#if PY_VERSION_HEX >= 0x030D0000
+#define FHIR_PY_MOD_GIL_SLOT { Py_mod_gil, Py_MOD_GIL_NOT_USED },
+#else
+#define FHIR_PY_MOD_GIL_SLOT
+#endif
+
+/**
+ * @brief Module slots: the exec function plus the interpreter and GIL declarations
+ *
+ * Use as the initializer of a PyModuleDef_Slot array.
+ */
+#define FHIR_PY_MODULE_SLOTS(exec_function) \
+    { \
+        { Py_mod_exec, (void*)(exec_function) }, \
+        FHIR_PY_MOD_INTERPRETERS_SLOT \
+        FHIR_PY_MOD_GIL_SLOT \
+        { 0, NULL } \
+    }
+
+/**
+ * @brief Type flag for types only the extension creates instances of
+ *
+ * Before 3.10 fhir_python_add_type clears tp_new instead.
+ */
+#if PY_VERSION_HEX >= 0x030A0000
+#define FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION Py_TPFLAGS_DISALLOW_INSTANTIATION
+#else
+#define FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION 0
+#endif
+
+/**
+ * @brief Per-object lock on free-threaded builds; a plain block otherwise
+ *
+ * The section is suspended while the thread releases the GIL (or detaches
+ * on free-threaded builds), so it cannot span Py_BEGIN_ALLOW_THREADS.
+ */
+#if PY_VERSION_HEX >= 0x030D0000
+#define FHIR_PY_BEGIN_CRITICAL_SECTION(object) Py_BEGIN_CRITICAL_SECTION(object)
+#define FHIR_PY_END_CRITICAL_SECTION() Py_END_CRITICAL_SECTION()
+#else
+#define FHIR_PY_BEGIN_CRITICAL_SECTION(object) {
+#define FHIR_PY_END_CRITICAL_SECTION() }
+#endif
+
+#if PY_VERSION_HEX < 0x03090000
+// Python 3.8 cannot map a type to its module; each extension remembers its last module
+static inline PyObject** fhir_python_legacy_module(void) {
+    static PyObject* module;
+    return &module;
+}
+#endif
+
+/**
+ * @brief Create a heap type for a module and add it under its short name
+ * @param module Module being executed
+ * @param spec Type spec; tp_name is "module.Name"
+ * @return New reference to the type (keep it in module state) or NULL with an exception set
+ */
+static inline PyTypeObject* fhir_python_add_type(PyObject* module, PyType_Spec* spec) {
+#if PY_VERSION_HEX >= 0x03090000
+    PyObject* type = PyType_FromModuleAndSpec(module, spec, NULL);
+#else
+    *fhir_python_legacy_module() = module;
+    PyObject* type = PyType_FromSpec(spec);
+#endif
+    if (!type) {
+        return NULL;
+    }
+
+#if PY_VERSION_HEX < 0x030A0000
+    bool has_new = false;
+    for (const PyType_Slot* slot = spec->slots; slot->slot; slot++) {
+        has_new = has_new || slot->slot == Py_tp_new;
+    }
+    if (!has_new) {
+        ((PyTypeObject*)type)->tp_new = NULL;
+    }
+#endif
+
+    const char* name = strrchr(spec->name, '.');
+    Py_INCREF(type);
+    if (PyModule_AddObject(module, name ? name + 1 : spec->name, type) < 0) {
+        Py_DECREF(type);
+        Py_DECREF(type);
+        return NULL;
+    }
+    return (PyTypeObject*)type;
+}
+
+/**
+ * @brief Get the state of the module that created a type
+ * @param type Type created by fhir_python_add_type (the extension's types are final)
+ * @param def Definition of the module
+ * @return Module state, or NULL with an exception set
+ */
+static inline void* fhir_python_type_state(PyTypeObject* type, PyModuleDef* def) {
+#if PY_VERSION_HEX >= 0x030B0000
+    PyObject* module = PyType_GetModuleByDef(type, def);
+#elif PY_VERSION_HEX >= 0x03090000
+    (void)def;
+    PyObject* module = PyType_GetModule(type);
+#else
+    (void)type;
+    (void)def;
+    PyObject* module = *fhir_python_legacy_module();
+#endif
+    return module ? PyModule_GetState(module) : NULL;
+}
+
+/**
+ * @brief Deallocate an instance of a heap type, releasing its type reference
+ */
+static inline void fhir_python_free_instance(PyObject* self) {
+    PyTypeObject* type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PYTHON_MODULE_H */
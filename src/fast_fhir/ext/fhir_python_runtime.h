@@ -0,0 +1,135 @@
+/**
+ * @file fhir_python_runtime.h
+ * @brief C runtime hooks each FHIR extension module exports to fast_fhir.fhir_diagnostics_c
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Every extension links its own copy of common/fhir_common.c, so each has
+ * its own allocation and performance counters and object pools. A module exports the entry points of its
+ * copy as a capsule named _fhir_runtime; the diagnostics module finds the
+ * capsules of the loaded modules and combines what they report.
+ *
+ * The string pool is the exception: the first extension loaded publishes
+ * its pool on the fast_fhir package as _fhir_intern and the others intern
+ * through it, so interned codes and systems match by pointer whichever
+ * module produced them.
+ */
+
+#ifndef FHIR_PYTHON_RUNTIME_H
+#define FHIR_PYTHON_RUNTIME_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "common/fhir_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Module attribute holding the capsule */
+#define FHIR_PY_RUNTIME_ATTRIBUTE "_fhir_runtime"
+
+/** @brief Capsule name, checked by the diagnostics module */
+#define FHIR_PY_RUNTIME_CAPSULE "fast_fhir._fhir_runtime"
+
+/** @brief Package attribute holding the shared string pool */
+#define FHIR_PY_INTERN_ATTRIBUTE "_fhir_intern"
+
+/** @brief Capsule name of the shared string pool */
+#define FHIR_PY_INTERN_CAPSULE "fast_fhir._fhir_intern"
+
+/**
+ * @brief Entry points of one extension's copy of the C core
+ *
+ * Internal to the extensions, which are built from one tree, so the
+ * layout needs no versioning.
+ */
+typedef struct {
+    bool (*memory_stats_set_enabled)(bool enabled);
+    bool (*memory_stats_enabled)(void);
+    void (*memory_get_stats)(FHIRMemoryStats* stats);
+    void (*memory_get_thread_stats)(FHIRMemoryStats* stats);
+    bool (*memory_get_type_stats)(int resource_type, FHIRMemoryTypeStats* stats);
+    void (*memory_stats_reset)(void);
+    bool (*perf_set_enabled)(bool enabled);
+    bool (*perf_get_counters)(int resource_type, FHIRPerfCounters* counters);
+    void (*perf_reset)(void);
+    size_t (*pool_trim)(void);
+} FHIRPythonRuntime;
+
+/**
+ * @brief Intern through the string pool published on the fast_fhir package, or publish this extension's
+ * @return 0 on success, -1 with an exception set
+ */
+static inline int fhir_python_share_intern_pool(void) {
+    PyObject* package = PyImport_ImportModule("fast_fhir");
+    if (!package) {
+        // Loaded outside the package: keep this extension's own pool
+        PyErr_Clear();
+        return 0;
+    }
+
+    int result = 0;
+    PyObject* capsule = PyObject_GetAttrString(package, FHIR_PY_INTERN_ATTRIBUTE);
+    if (capsule) {
+        const FHIRInternPool* pool = PyCapsule_GetPointer(capsule, FHIR_PY_INTERN_CAPSULE);
+        if (pool) {
+            fhir_intern_use_pool(pool);
+        } else {
+            result = -1;
+        }
+    } else if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+        PyErr_Clear();
+        // Publish the pool in use, which another interpreter may already share
+        capsule = PyCapsule_New((void*)fhir_intern_pool(), FHIR_PY_INTERN_CAPSULE, NULL);
+        if (!capsule || PyObject_SetAttrString(package, FHIR_PY_INTERN_ATTRIBUTE, capsule) < 0) {
+            result = -1;
+        }
+    } else {
+        result = -1;
+    }
+    Py_XDECREF(capsule);
+    Py_DECREF(package);
+    return result;
+}
+
+/**
+ * @brief Export the calling extension's runtime from its module exec
+ *
+ * Also joins the shared string pool (fhir_python_share_intern_pool).
+ *
+ * @param module Module being executed
+ * @return 0 on success, -1 with an exception set
+ */
+static inline int fhir_python_add_runtime(PyObject* module) {
+    static const FHIRPythonRuntime runtime = {
+        fhir_memory_stats_set_enabled,
+        fhir_memory_stats_enabled,
+        fhir_memory_get_stats,
+        fhir_memory_get_thread_stats,
+        fhir_memory_get_type_stats,
+        fhir_memory_stats_reset,
+        fhir_perf_set_enabled,
+        fhir_perf_get_counters,
+        fhir_perf_reset,
+        fhir_pool_trim,
+    };
+    if (fhir_python_share_intern_pool() < 0) {
+        return -1;
+    }
+    PyObject* capsule = PyCapsule_New((void*)&runtime, FHIR_PY_RUNTIME_CAPSULE, NULL);
+    if (!capsule) {
+        return -1;
+    }
+    if (PyModule_AddObject(module, FHIR_PY_RUNTIME_ATTRIBUTE, capsule) < 0) {
+        Py_DECREF(capsule);
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PYTHON_RUNTIME_H */
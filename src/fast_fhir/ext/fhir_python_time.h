@@ -0,0 +1,88 @@
+/**
+ * @file fhir_python_time.h
+ * @brief Time window bounds of the index and buffer extensions in Python
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * The C cores keep instants as epoch microseconds with INT64_MIN and
+ * INT64_MAX for open bounds (FHIR_INTERVAL_INDEX_MIN/MAX). Python callers
+ * pass FHIR date text, int epoch milliseconds or None, and get epoch
+ * milliseconds back.
+ */
+
+#ifndef FHIR_PYTHON_TIME_H
+#define FHIR_PYTHON_TIME_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "common/fhir_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Convert a time bound from Python to epoch microseconds
+ *
+ * Accepts FHIR date text (its first instant, or the end of its precision
+ * for an upper bound), int epoch milliseconds, or None for an open bound.
+ *
+ * @param value Python value
+ * @param upper Whether the bound ends a window
+ * @param bound Output bound
+ * @return 1 on success, 0 with an exception set
+ */
+static inline int fhir_python_time_bound_from_python(PyObject* value, bool upper, int64_t* bound) {
+    if (value == Py_None) {
+        *bound = upper ? INT64_MAX : INT64_MIN;
+        return 1;
+    }
+    if (PyUnicode_Check(value)) {
+        const char* text = PyUnicode_AsUTF8(value);
+        if (text == NULL) {
+            return 0;
+        }
+        FHIRDateTimeValue parsed;
+        if (!fhir_datetime_parse(text, &parsed)) {
+            PyErr_Format(PyExc_ValueError, "Invalid FHIR date: %s", text);
+            return 0;
+        }
+        *bound = upper ? fhir_datetime_end(&parsed) : parsed.epoch_us;
+        return 1;
+    }
+
+    long long millis = PyLong_AsLongLong(value);
+    if (millis == -1 && PyErr_Occurred()) {
+        return 0;
+    }
+    if (millis > INT64_MAX / 1000 || millis < INT64_MIN / 1000) {
+        PyErr_SetString(PyExc_OverflowError, "Time out of range");
+        return 0;
+    }
+    *bound = (int64_t)millis * 1000;
+    return 1;
+}
+
+/**
+ * @brief Convert an epoch microsecond bound to milliseconds rounded outward
+ * @param micros Bound
+ * @param upper Whether the bound ends a window
+ * @return New reference (None for an open bound), or NULL with an exception set
+ */
+static inline PyObject* fhir_python_time_bound_to_python(int64_t micros, bool upper) {
+    if (micros == INT64_MIN || micros == INT64_MAX) {
+        Py_RETURN_NONE;
+    }
+    int64_t millis = micros / 1000;
+    if (upper && micros % 1000 > 0) millis++;
+    if (!upper && micros % 1000 < 0) millis--;
+    return PyLong_FromLongLong((long long)millis);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PYTHON_TIME_H */
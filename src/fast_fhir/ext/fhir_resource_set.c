@@ -0,0 +1,171 @@
+/**
+ * @file fhir_resource_set.c
+ * @brief Hash set of structurally distinct resources, for deduplication
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_resource_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Minimum number of slots
+#define FHIR_RESOURCE_SET_MIN_CAPACITY 16
+
+typedef struct {
+    uint64_t hash;
+    FHIRResourceBase* resource;     // NULL for an empty slot
+} FHIRResourceSetSlot;
+
+struct FHIRResourceSet {
+    FHIRResourceSetSlot* slots;
+    size_t capacity;                // Power of two, kept at least twice count
+    size_t count;
+};
+
+/* ========================================================================== */
+/* Slots                                                                      */
+/* ========================================================================== */
+
+static size_t capacity_for(size_t count) {
+    size_t capacity = FHIR_RESOURCE_SET_MIN_CAPACITY;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static bool same_resource(const FHIRResourceSetSlot* slot, uint64_t hash, const FHIRResourceBase* resource) {
+    const FHIRResourceBase* member = slot->resource;
+    if (slot->hash != hash) return false;
+    if (member == resource) return true;
+    return member->resource_type == resource->resource_type && fhir_resource_equals(member, resource);
+}
+
+// Slot holding a resource equal to resource, or the empty slot where it would go
+static FHIRResourceSetSlot* probe(const FHIRResourceSet* set, uint64_t hash, const FHIRResourceBase* resource) {
+    size_t mask = set->capacity - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        FHIRResourceSetSlot* slot = &set->slots[i];
+        if (!slot->resource || same_resource(slot, hash, resource)) {
+            return slot;
+        }
+    }
+}
+
+static bool grow(FHIRResourceSet* set) {
+    size_t capacity = set->capacity * 2;
+    FHIRResourceSetSlot* slots = fhir_calloc(capacity, sizeof(FHIRResourceSetSlot));
+    if (!slots) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow resource set");
+        return false;
+    }
+
+    // Members are distinct, so rehashing needs no equality checks
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < set->capacity; i++) {
+        const FHIRResourceSetSlot* slot = &set->slots[i];
+        if (!slot->resource) continue;
+        size_t j = (size_t)slot->hash & mask;
+        while (slots[j].resource) {
+            j = (j + 1) & mask;
+        }
+        slots[j] = *slot;
+    }
+    fhir_free(set->slots);
+    set->slots = slots;
+    set->capacity = capacity;
+    return true;
+}
+
+/* ========================================================================== */
+/* Set                                                                        */
+/* ========================================================================== */
+
+FHIRResourceSet* fhir_resource_set_create(size_t expected_count) {
+    FHIRResourceSet* set = fhir_calloc(1, sizeof(FHIRResourceSet));
+    if (set) {
+        set->capacity = capacity_for(expected_count);
+        set->slots = fhir_calloc(set->capacity, sizeof(FHIRResourceSetSlot));
+    }
+    if (!set || !set->slots) {
+        fhir_free(set);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate resource set");
+        return NULL;
+    }
+    return set;
+}
+
+void fhir_resource_set_free(FHIRResourceSet* set) {
+    if (!set) return;
+
+    for (size_t i = 0; i < set->capacity; i++) {
+        fhir_resource_release(set->slots[i].resource);
+    }
+    fhir_free(set->slots);
+    fhir_free(set);
+}
+
+size_t fhir_resource_set_count(const FHIRResourceSet* set) {
+    return set ? set->count : 0;
+}
+
+FHIRResourceBase* fhir_resource_set_find(const FHIRResourceSet* set, const FHIRResourceBase* resource) {
+    if (!set || !resource) return NULL;
+    return probe(set, fhir_resource_hash(resource), resource)->resource;
+}
+
+FHIRResourceBase* fhir_resource_set_add(FHIRResourceSet* set, FHIRResourceBase* resource) {
+    if (!set || !resource) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return NULL;
+    }
+
+    uint64_t hash = fhir_resource_hash(resource);
+    FHIRResourceSetSlot* slot = probe(set, hash, resource);
+    if (slot->resource) {
+        return slot->resource;
+    }
+
+    if ((set->count + 1) * 2 > set->capacity) {
+        if (!grow(set)) return NULL;
+        slot = probe(set, hash, resource);
+    }
+    slot->hash = hash;
+    slot->resource = fhir_resource_retain(resource);
+    set->count++;
+    return resource;
+}
+
+/* ========================================================================== */
+/* Deduplication                                                              */
+/* ========================================================================== */
+
+size_t fhir_resource_dedup(FHIRResourceBase** resources, size_t count) {
+    if (count == 0) return 0;
+    if (!resources) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Resources array is NULL");
+        return 0;
+    }
+
+    FHIRResourceSet* set = fhir_resource_set_create(count);
+    if (!set) return 0;
+
+    // Swapping each first occurrence forward keeps the kept ones in input order
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t before = set->count;
+        if (!fhir_resource_set_add(set, resources[i])) {
+            fhir_resource_set_free(set);
+            return 0;
+        }
+        if (set->count > before) {
+            FHIRResourceBase* first = resources[i];
+            resources[i] = resources[kept];
+            resources[kept++] = first;
+        }
+    }
+
+    fhir_resource_set_free(set);
+    return kept;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file fhir_resource_set.h
+ * @brief Hash set of structurally distinct resources, for deduplication
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Resources are keyed by fhir_resource_hash and confirmed with the type's
+ * equals method, so two resources count as duplicates when they have the
+ * same type, the same structural hash and compare equal. Slots hold only the
+ * hash and a pointer (open addressing, linear probing), so a merge job can
+ * check tens of millions of resources without comparing each pair.
+ *
+ * A set is not synchronized; fill it from one thread. Hashes are cached on
+ * the resources, so hashing them in parallel first (fhir_resource_hash is
+ * thread-safe) takes the expensive part off that thread.
+ */
+
+#ifndef FHIR_RESOURCE_SET_H
+#define FHIR_RESOURCE_SET_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FHIRResourceSet FHIRResourceSet;
+
+/* ========================================================================== */
+/* Set                                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty set
+ * @param expected_count Number of resources expected (0 for a small default)
+ * @return New set or NULL on failure (FHIR_ERROR_OUT_OF_MEMORY)
+ */
+FHIRResourceSet* fhir_resource_set_create(size_t expected_count);
+
+/**
+ * @brief Free a set, releasing the resources it retained
+ * @param set Set to free (may be NULL)
+ */
+void fhir_resource_set_free(FHIRResourceSet* set);
+
+/**
+ * @brief Get the number of distinct resources in a set
+ * @param set Set
+ * @return Number of resources
+ */
+size_t fhir_resource_set_count(const FHIRResourceSet* set);
+
+/**
+ * @brief Find the member equal to a resource
+ * @param set Set
+ * @param resource Resource to look up
+ * @return Equal member (borrowed) or NULL if there is none
+ */
+FHIRResourceBase* fhir_resource_set_find(const FHIRResourceSet* set, const FHIRResourceBase* resource);
+
+/**
+ * @brief Add a resource unless an equal one is already a member
+ *
+ * A newly added resource is retained by the set. Whether it was added
+ * shows in fhir_resource_set_count, since resource may already be a member.
+ *
+ * @param set Set
+ * @param resource Resource to add
+ * @return The member equal to resource (borrowed; resource itself if it was
+ *         added), or NULL on failure (FHIR_ERROR_INVALID_ARGUMENT,
+ *         FHIR_ERROR_OUT_OF_MEMORY)
+ */
+FHIRResourceBase* fhir_resource_set_add(FHIRResourceSet* set, FHIRResourceBase* resource);
+
+/* ========================================================================== */
+/* Deduplication                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Move duplicates to the end of an array
+ *
+ * The first occurrence of every distinct resource is kept, in input order,
+ * at the front of the array; later duplicates follow in unspecified order.
+ * No resource is released, so the caller can release or merge the tail.
+ *
+ * @param resources Resources to deduplicate (no NULL entries)
+ * @param count Number of resources
+ * @return Number of distinct resources, or 0 on failure with count > 0
+ *         (FHIR_ERROR_INVALID_ARGUMENT, FHIR_ERROR_OUT_OF_MEMORY)
+ */
+size_t fhir_resource_dedup(FHIRResourceBase** resources, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_RESOURCE_SET_H */
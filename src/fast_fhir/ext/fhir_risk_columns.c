@@ -0,0 +1,347 @@
+/**
+ * @file fhir_risk_columns.c
+ * @brief Columnar RiskAssessment scores with batch threshold and top-K kernels
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_risk_columns.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FHIR_RISK_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FHIR_RISK_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FHIR_RISK_NEON 1
+#endif
+
+#define FHIR_RISK_COLUMNS_INITIAL_CAPACITY 1024
+
+struct FHIRRiskColumns {
+    size_t row_count;
+    size_t capacity;
+    double* risk;
+    int32_t* prediction;
+    const char** subject;
+};
+
+/* ========================================================================== */
+/* Store Lifecycle                                                            */
+/* ========================================================================== */
+
+FHIRRiskColumns* fhir_risk_columns_create(void) {
+    FHIRRiskColumns* columns = fhir_calloc(1, sizeof(FHIRRiskColumns));
+    if (!columns) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate RiskAssessment columns");
+    }
+    return columns;
+}
+
+void fhir_risk_columns_destroy(FHIRRiskColumns* columns) {
+    if (!columns) return;
+
+    fhir_free(columns->risk);
+    fhir_free(columns->prediction);
+    fhir_free(columns->subject);
+    fhir_free(columns);
+}
+
+void fhir_risk_columns_get_view(const FHIRRiskColumns* columns, FHIRRiskColumnView* view) {
+    if (!view) return;
+
+    memset(view, 0, sizeof(FHIRRiskColumnView));
+    if (!columns) return;
+
+    view->row_count = columns->row_count;
+    view->risk = columns->risk;
+    view->prediction = columns->prediction;
+    view->subject = columns->subject;
+}
+
+// Reallocate one column to capacity elements
+#define GROW_COLUMN(columns, name, capacity)                                         \
+    do {                                                                             \
+        void* grown = fhir_realloc((columns)->name, (capacity) * sizeof(*(columns)->name)); \
+        if (!grown) return false;                                                    \
+        (columns)->name = grown;                                                     \
+    } while (0)
+
+static bool reserve_row(FHIRRiskColumns* columns) {
+    if (columns->row_count < columns->capacity) return true;
+
+    size_t capacity = columns->capacity ? columns->capacity * 2 : FHIR_RISK_COLUMNS_INITIAL_CAPACITY;
+    GROW_COLUMN(columns, risk, capacity);
+    GROW_COLUMN(columns, prediction, capacity);
+    GROW_COLUMN(columns, subject, capacity);
+    columns->capacity = capacity;
+    return true;
+}
+
+/* ========================================================================== */
+/* Loading                                                                    */
+/* ========================================================================== */
+
+// Risk of one prediction, as fhir_riskassessment_get_highest_risk_prediction reads it
+static double prediction_risk(const cJSON* prediction) {
+    const cJSON* decimal = cJSON_GetObjectItemCaseSensitive(prediction, "probabilityDecimal");
+    if (cJSON_IsNumber(decimal) && decimal->valuedouble != 0.0) {
+        return decimal->valuedouble;
+    }
+
+    const cJSON* range = cJSON_GetObjectItemCaseSensitive(prediction, "probabilityRange");
+    const cJSON* high = cJSON_IsObject(range) ? cJSON_GetObjectItemCaseSensitive(range, "high") : NULL;
+    const cJSON* value = cJSON_IsObject(high) ? cJSON_GetObjectItemCaseSensitive(high, "value") : NULL;
+    return cJSON_IsNumber(value) ? value->valuedouble : 0.0;
+}
+
+bool fhir_risk_columns_append_json(FHIRRiskColumns* columns, const cJSON* assessment) {
+    if (!columns || !cJSON_IsObject(assessment)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* type_name = fhir_json_get_string(assessment, "resourceType");
+    if (!type_name || strcmp(type_name, "RiskAssessment") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Not a RiskAssessment");
+        return false;
+    }
+
+    if (columns->row_count == UINT32_MAX || !reserve_row(columns)) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow RiskAssessment columns");
+        return false;
+    }
+
+    const cJSON* subject = cJSON_GetObjectItemCaseSensitive(assessment, "subject");
+    const char* reference = cJSON_IsObject(subject) ? fhir_json_get_string(subject, "reference") : NULL;
+    const char* interned = reference ? fhir_intern(reference) : NULL;
+    if (reference && !interned) return false;
+
+    // Highest risk over every prediction; like the single-resource function,
+    // the reported prediction must beat 0 and the first of equal risks wins
+    double risk = NAN;
+    double highest = 0.0;
+    int32_t best = FHIR_RISK_COLUMNS_NO_PREDICTION;
+    const cJSON* predictions = cJSON_GetObjectItemCaseSensitive(assessment, "prediction");
+    if (!cJSON_IsArray(predictions)) predictions = NULL;
+    const cJSON* prediction;
+    int32_t index = 0;
+    cJSON_ArrayForEach(prediction, predictions) {
+        if (cJSON_IsObject(prediction)) {
+            double value = prediction_risk(prediction);
+            if (isnan(risk) || value > risk) risk = value;
+            if (value > highest) {
+                highest = value;
+                best = index;
+            }
+        }
+        index++;
+    }
+
+    size_t row = columns->row_count++;
+    columns->risk[row] = risk;
+    columns->prediction[row] = best;
+    columns->subject[row] = interned;
+    return true;
+}
+
+bool fhir_risk_columns_load_ndjson(FHIRRiskColumns* columns, const char* path,
+                                   const FHIRNDJSONOptions* options, size_t* appended) {
+    if (appended) *appended = 0;
+    if (!columns || !path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRNDJSONOptions reader_options;
+    if (options) {
+        reader_options = *options;
+    } else {
+        fhir_ndjson_options_init(&reader_options);
+        reader_options.validate = false;
+    }
+    reader_options.keep_json = true;
+    reader_options.strict_types = false;
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open(path, &reader_options);
+    if (!reader) return false;
+
+    bool ok = true;
+    FHIRNDJSONResult* results;
+    size_t count;
+    while (ok && (results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            if (results[i].resource_type != FHIR_RESOURCE_TYPE_RISK_ASSESSMENT || !results[i].json) {
+                continue;
+            }
+            if (!fhir_risk_columns_append_json(columns, results[i].json)) {
+                ok = false;
+                break;
+            }
+            if (appended) (*appended)++;
+        }
+    }
+
+    fhir_ndjson_close(reader);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Cohort Queries                                                             */
+/* ========================================================================== */
+
+size_t fhir_risk_columns_high_risk(const FHIRRiskColumns* columns, double threshold, uint8_t* mask) {
+    if (!columns || !mask) return 0;
+    return fhir_risk_threshold_mask(columns->risk, columns->row_count, threshold, mask);
+}
+
+size_t fhir_risk_columns_top_k(const FHIRRiskColumns* columns, size_t k, uint32_t* rows) {
+    if (!columns || !rows) return 0;
+    return fhir_risk_top_k(columns->risk, columns->row_count, k, rows);
+}
+
+/* ========================================================================== */
+/* Kernels                                                                    */
+/* ========================================================================== */
+
+#if defined(FHIR_RISK_AVX) || defined(FHIR_RISK_SSE2)
+// Four mask bytes and the number of set bits for every 4-bit movemask
+static const uint32_t g_mask_bytes[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+static const uint8_t g_mask_bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+#endif
+
+size_t fhir_risk_threshold_mask(const double* values, size_t count, double threshold, uint8_t* mask) {
+    if (!values || !mask) return 0;
+
+    size_t passing = 0;
+    size_t i = 0;
+#if defined(FHIR_RISK_AVX)
+    __m256d bound = _mm256_set1_pd(threshold);
+    for (; i + 4 <= count; i += 4) {
+        int bits = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), bound, _CMP_GE_OQ));
+        memcpy(mask + i, &g_mask_bytes[bits], 4);
+        passing += g_mask_bits[bits];
+    }
+#elif defined(FHIR_RISK_SSE2)
+    __m128d bound = _mm_set1_pd(threshold);
+    for (; i + 4 <= count; i += 4) {
+        int bits = _mm_movemask_pd(_mm_cmpge_pd(_mm_loadu_pd(values + i), bound)) |
+                   _mm_movemask_pd(_mm_cmpge_pd(_mm_loadu_pd(values + i + 2), bound)) << 2;
+        memcpy(mask + i, &g_mask_bytes[bits], 4);
+        passing += g_mask_bits[bits];
+    }
+#elif defined(FHIR_RISK_NEON)
+    float64x2_t bound = vdupq_n_f64(threshold);
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t bits = vcgeq_f64(vld1q_f64(values + i), bound);
+        mask[i] = (uint8_t)(vgetq_lane_u64(bits, 0) & 1);
+        mask[i + 1] = (uint8_t)(vgetq_lane_u64(bits, 1) & 1);
+        passing += mask[i] + mask[i + 1];
+    }
+#endif
+    // Tail, and the whole array without SIMD; NaN compares false
+    for (; i < count; i++) {
+        mask[i] = values[i] >= threshold;
+        passing += mask[i];
+    }
+    return passing;
+}
+
+// Whether the value at a ranks below the value at b (ties: higher index ranks below)
+static inline bool ranks_below(const double* values, uint32_t a, uint32_t b) {
+    return values[a] < values[b] || (values[a] == values[b] && a > b);
+}
+
+// Restore the heap below position, lowest-ranked entry at the root
+static void sift_down(const double* values, uint32_t* heap, size_t size, size_t position) {
+    for (;;) {
+        size_t child = 2 * position + 1;
+        if (child >= size) return;
+        if (child + 1 < size && ranks_below(values, heap[child + 1], heap[child])) child++;
+        if (!ranks_below(values, heap[child], heap[position])) return;
+        uint32_t swap = heap[child];
+        heap[child] = heap[position];
+        heap[position] = swap;
+        position = child;
+    }
+}
+
+static void sift_up(const double* values, uint32_t* heap, size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (!ranks_below(values, heap[position], heap[parent])) return;
+        uint32_t swap = heap[parent];
+        heap[parent] = heap[position];
+        heap[position] = swap;
+        position = parent;
+    }
+}
+
+// Offer one index; ties lose against the heap since indices grow
+static inline void offer(const double* values, uint32_t* heap, size_t* size, size_t k, uint32_t index) {
+    if (isnan(values[index])) return;
+    if (*size < k) {
+        heap[*size] = index;
+        sift_up(values, heap, (*size)++);
+    } else if (values[index] > values[heap[0]]) {
+        heap[0] = index;
+        sift_down(values, heap, k, 0);
+    }
+}
+
+size_t fhir_risk_top_k(const double* values, size_t count, size_t k, uint32_t* indices) {
+    if (!values || !indices || k == 0) return 0;
+    if (count > UINT32_MAX) count = UINT32_MAX;
+
+    size_t size = 0;
+    size_t i = 0;
+
+    // Fill the heap, then only blocks with a value above its root need a look
+    for (; i < count && size < k; i++) {
+        offer(values, indices, &size, k, (uint32_t)i);
+    }
+#if defined(FHIR_RISK_AVX)
+    for (; size == k && i + 4 <= count; i += 4) {
+        __m256d floor = _mm256_set1_pd(values[indices[0]]);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), floor, _CMP_GT_OQ))) {
+            for (size_t lane = 0; lane < 4; lane++) offer(values, indices, &size, k, (uint32_t)(i + lane));
+        }
+    }
+#elif defined(FHIR_RISK_SSE2)
+    for (; size == k && i + 2 <= count; i += 2) {
+        __m128d floor = _mm_set1_pd(values[indices[0]]);
+        if (_mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(values + i), floor))) {
+            offer(values, indices, &size, k, (uint32_t)i);
+            offer(values, indices, &size, k, (uint32_t)(i + 1));
+        }
+    }
+#elif defined(FHIR_RISK_NEON)
+    for (; size == k && i + 2 <= count; i += 2) {
+        uint64x2_t above = vcgtq_f64(vld1q_f64(values + i), vdupq_n_f64(values[indices[0]]));
+        if (vgetq_lane_u64(above, 0) | vgetq_lane_u64(above, 1)) {
+            offer(values, indices, &size, k, (uint32_t)i);
+            offer(values, indices, &size, k, (uint32_t)(i + 1));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        offer(values, indices, &size, k, (uint32_t)i);
+    }
+
+    // Heap sort: moving the root to the back leaves the highest rank first
+    for (size_t end = size; end > 1; end--) {
+        uint32_t swap = indices[0];
+        indices[0] = indices[end - 1];
+        indices[end - 1] = swap;
+        sift_down(values, indices, end - 1, 0);
+    }
+    return size;
+}
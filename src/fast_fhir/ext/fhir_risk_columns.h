@@ -0,0 +1,165 @@
+/**
+ * @file fhir_risk_columns.h
+ * @brief Columnar RiskAssessment scores with batch threshold and top-K kernels
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Each RiskAssessment becomes one row holding the score the single-resource
+ * functions in resources/fhir_riskassessment.c derive from its predictions:
+ * a prediction's risk is probabilityDecimal when non-zero, otherwise
+ * probabilityRange.high.value, otherwise 0. The row keeps the highest
+ * prediction risk (what fhir_riskassessment_is_high_risk compares) and the
+ * index of the prediction fhir_riskassessment_get_highest_risk_prediction
+ * returns, so a cohort is scored by scanning one contiguous double array.
+ *
+ * The threshold and top-K kernels work on any double array and use SSE2 or
+ * AVX (x86) and NEON (AArch64) when the compiler targets them, with a
+ * scalar fallback giving identical results.
+ */
+
+#ifndef FHIR_RISK_COLUMNS_H
+#define FHIR_RISK_COLUMNS_H
+
+#include "common/fhir_common.h"
+#include "fhir_ndjson.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Prediction index of a row without a positive risk */
+#define FHIR_RISK_COLUMNS_NO_PREDICTION (-1)
+
+/**
+ * @brief Read-only view of the columns, valid until the next append
+ *
+ * Every array has row_count elements.
+ */
+typedef struct {
+    size_t row_count;
+    const double* risk;             /**< Highest prediction risk, NaN without predictions */
+    const int32_t* prediction;      /**< Index of the highest-risk prediction, or FHIR_RISK_COLUMNS_NO_PREDICTION */
+    const char* const* subject;     /**< Interned subject.reference (NULL when missing) */
+} FHIRRiskColumnView;
+
+/**
+ * @brief Opaque columnar RiskAssessment store
+ */
+typedef struct FHIRRiskColumns FHIRRiskColumns;
+
+/* ========================================================================== */
+/* Store Lifecycle                                                            */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty store
+ * @return New store or NULL on failure
+ */
+FHIRRiskColumns* fhir_risk_columns_create(void);
+
+/**
+ * @brief Destroy a store and its columns
+ * @param columns Store to destroy (can be NULL)
+ */
+void fhir_risk_columns_destroy(FHIRRiskColumns* columns);
+
+/**
+ * @brief Get the current columns
+ * @param columns Store to query
+ * @param view Output view
+ */
+void fhir_risk_columns_get_view(const FHIRRiskColumns* columns, FHIRRiskColumnView* view);
+
+/* ========================================================================== */
+/* Loading                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Append one row from RiskAssessment JSON
+ * @param columns Store to fill
+ * @param assessment RiskAssessment JSON object
+ * @return true on success, false on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         if not a RiskAssessment, FHIR_ERROR_OUT_OF_MEMORY)
+ */
+bool fhir_risk_columns_append_json(FHIRRiskColumns* columns, const cJSON* assessment);
+
+/**
+ * @brief Append every RiskAssessment line of an NDJSON file
+ *
+ * Lines are parsed on the NDJSON reader's worker pool; options.keep_json is
+ * forced on. Other resource types and lines that fail to parse are skipped.
+ *
+ * @param columns Store to fill
+ * @param path NDJSON file path
+ * @param options Reader options (NULL for defaults without validation)
+ * @param appended Output number of rows appended (can be NULL)
+ * @return true on success, false if the file cannot be read or memory runs out
+ */
+bool fhir_risk_columns_load_ndjson(FHIRRiskColumns* columns, const char* path,
+                                   const FHIRNDJSONOptions* options, size_t* appended);
+
+/* ========================================================================== */
+/* Cohort Queries                                                             */
+/* ========================================================================== */
+
+/**
+ * @brief Mark the rows fhir_riskassessment_is_high_risk would accept
+ * @param columns Store to query
+ * @param threshold Risk threshold (inclusive)
+ * @param mask row_count bytes; set to 1 for high-risk rows, 0 otherwise
+ * @return Number of high-risk rows
+ */
+size_t fhir_risk_columns_high_risk(const FHIRRiskColumns* columns, double threshold, uint8_t* mask);
+
+/**
+ * @brief Find the k rows with the highest risk
+ * @param columns Store to query
+ * @param k Maximum number of rows
+ * @param rows Output row indices, highest risk first (k elements)
+ * @return Number of rows written
+ */
+size_t fhir_risk_columns_top_k(const FHIRRiskColumns* columns, size_t k, uint32_t* rows);
+
+/* ========================================================================== */
+/* Kernels                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Set mask[i] to whether values[i] >= threshold
+ *
+ * NaN never passes.
+ *
+ * @param values Values to test
+ * @param count Number of values
+ * @param threshold Inclusive threshold
+ * @param mask Output count bytes of 0 or 1
+ * @return Number of values passing
+ */
+size_t fhir_risk_threshold_mask(const double* values, size_t count, double threshold, uint8_t* mask);
+
+/**
+ * @brief Select the indices of the k largest values
+ *
+ * Ties keep the lower index first; NaN values are never selected.
+ *
+ * @param values Values to rank
+ * @param count Number of values (at most UINT32_MAX)
+ * @param k Maximum number of indices
+ * @param indices Output indices, largest value first (k elements)
+ * @return Number of indices written
+ */
+size_t fhir_risk_top_k(const double* values, size_t count, size_t k, uint32_t* indices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_RISK_COLUMNS_H */
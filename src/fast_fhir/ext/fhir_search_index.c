@@ -0,0 +1,601 @@
+/**
+ * @file fhir_search_index.c
+ * @brief Search parameter index rows extracted from parsed resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_search_index.h"
+#include "common/fhir_resource_type_lookup.h"
+#include <ctype.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Parameter Table                                                            */
+/* ========================================================================== */
+
+#define TOKEN FHIR_SEARCH_PARAM_TOKEN
+#define STRING FHIR_SEARCH_PARAM_STRING
+#define DATE FHIR_SEARCH_PARAM_DATE
+#define QUANTITY FHIR_SEARCH_PARAM_QUANTITY
+#define REFERENCE FHIR_SEARCH_PARAM_REFERENCE
+#define ANY FHIR_RESOURCE_TYPE_UNKNOWN
+
+// Expressions follow the FHIR R5 SearchParameter definitions, within the fhir_path subset
+static const FHIRSearchParameter g_patient_parameters[] = {
+    {"identifier", TOKEN, "Patient.identifier", ANY},
+    {"active", TOKEN, "Patient.active", ANY},
+    {"gender", TOKEN, "Patient.gender", ANY},
+    {"birthdate", DATE, "Patient.birthDate", ANY},
+    {"death-date", DATE, "(Patient.deceased as dateTime)", ANY},
+    {"name", STRING, "Patient.name", ANY},
+    {"family", STRING, "Patient.name.family", ANY},
+    {"given", STRING, "Patient.name.given", ANY},
+    {"address", STRING, "Patient.address", ANY},
+    {"address-city", STRING, "Patient.address.city", ANY},
+    {"address-postalcode", STRING, "Patient.address.postalCode", ANY},
+    {"organization", REFERENCE, "Patient.managingOrganization", FHIR_RESOURCE_TYPE_ORGANIZATION},
+    {"general-practitioner", REFERENCE, "Patient.generalPractitioner", ANY},
+    {"link", REFERENCE, "Patient.link.other", ANY},
+};
+
+static const FHIRSearchParameter g_practitioner_parameters[] = {
+    {"identifier", TOKEN, "Practitioner.identifier", ANY},
+    {"active", TOKEN, "Practitioner.active", ANY},
+    {"gender", TOKEN, "Practitioner.gender", ANY},
+    {"name", STRING, "Practitioner.name", ANY},
+    {"family", STRING, "Practitioner.name.family", ANY},
+    {"given", STRING, "Practitioner.name.given", ANY},
+    {"address-city", STRING, "Practitioner.address.city", ANY},
+};
+
+static const FHIRSearchParameter g_organization_parameters[] = {
+    {"identifier", TOKEN, "Organization.identifier", ANY},
+    {"active", TOKEN, "Organization.active", ANY},
+    {"type", TOKEN, "Organization.type", ANY},
+    {"name", STRING, "Organization.name | Organization.alias", ANY},
+    {"partof", REFERENCE, "Organization.partOf", FHIR_RESOURCE_TYPE_ORGANIZATION},
+};
+
+static const FHIRSearchParameter g_location_parameters[] = {
+    {"identifier", TOKEN, "Location.identifier", ANY},
+    {"status", TOKEN, "Location.status", ANY},
+    {"type", TOKEN, "Location.type", ANY},
+    {"name", STRING, "Location.name | Location.alias", ANY},
+    {"address-city", STRING, "Location.address.city", ANY},
+    {"organization", REFERENCE, "Location.managingOrganization", FHIR_RESOURCE_TYPE_ORGANIZATION},
+    {"partof", REFERENCE, "Location.partOf", FHIR_RESOURCE_TYPE_LOCATION},
+};
+
+static const FHIRSearchParameter g_encounter_parameters[] = {
+    {"identifier", TOKEN, "Encounter.identifier", ANY},
+    {"status", TOKEN, "Encounter.status", ANY},
+    {"class", TOKEN, "Encounter.class", ANY},
+    {"type", TOKEN, "Encounter.type", ANY},
+    {"reason-code", TOKEN, "Encounter.reason.value.concept", ANY},
+    {"date", DATE, "Encounter.actualPeriod", ANY},
+    {"subject", REFERENCE, "Encounter.subject", ANY},
+    {"patient", REFERENCE, "Encounter.subject", FHIR_RESOURCE_TYPE_PATIENT},
+    {"participant", REFERENCE, "Encounter.participant.actor", ANY},
+    {"service-provider", REFERENCE, "Encounter.serviceProvider", FHIR_RESOURCE_TYPE_ORGANIZATION},
+};
+
+static const FHIRSearchParameter g_observation_parameters[] = {
+    {"identifier", TOKEN, "Observation.identifier", ANY},
+    {"status", TOKEN, "Observation.status", ANY},
+    {"code", TOKEN, "Observation.code", ANY},
+    {"category", TOKEN, "Observation.category", ANY},
+    {"value-concept", TOKEN, "(Observation.value as CodeableConcept)", ANY},
+    {"component-code", TOKEN, "Observation.component.code", ANY},
+    {"date", DATE, "Observation.effective.ofType(dateTime) | Observation.effective.ofType(Period) | "
+                   "Observation.effective.ofType(instant)", ANY},
+    {"value-quantity", QUANTITY, "(Observation.value as Quantity)", ANY},
+    {"component-value-quantity", QUANTITY, "(Observation.component.value as Quantity)", ANY},
+    {"subject", REFERENCE, "Observation.subject", ANY},
+    {"patient", REFERENCE, "Observation.subject", FHIR_RESOURCE_TYPE_PATIENT},
+    {"encounter", REFERENCE, "Observation.encounter", FHIR_RESOURCE_TYPE_ENCOUNTER},
+    {"performer", REFERENCE, "Observation.performer", ANY},
+};
+
+static const FHIRSearchParameter g_condition_parameters[] = {
+    {"identifier", TOKEN, "Condition.identifier", ANY},
+    {"clinical-status", TOKEN, "Condition.clinicalStatus", ANY},
+    {"code", TOKEN, "Condition.code", ANY},
+    {"category", TOKEN, "Condition.category", ANY},
+    {"onset-date", DATE, "Condition.onset.ofType(dateTime) | Condition.onset.ofType(Period)", ANY},
+    {"recorded-date", DATE, "Condition.recordedDate", ANY},
+    {"subject", REFERENCE, "Condition.subject", ANY},
+    {"patient", REFERENCE, "Condition.subject", FHIR_RESOURCE_TYPE_PATIENT},
+    {"encounter", REFERENCE, "Condition.encounter", FHIR_RESOURCE_TYPE_ENCOUNTER},
+};
+
+static const FHIRSearchParameter g_care_plan_parameters[] = {
+    {"identifier", TOKEN, "CarePlan.identifier", ANY},
+    {"status", TOKEN, "CarePlan.status", ANY},
+    {"intent", TOKEN, "CarePlan.intent", ANY},
+    {"category", TOKEN, "CarePlan.category", ANY},
+    {"date", DATE, "CarePlan.period", ANY},
+    {"subject", REFERENCE, "CarePlan.subject", ANY},
+    {"patient", REFERENCE, "CarePlan.subject", FHIR_RESOURCE_TYPE_PATIENT},
+    {"encounter", REFERENCE, "CarePlan.encounter", FHIR_RESOURCE_TYPE_ENCOUNTER},
+};
+
+#undef TOKEN
+#undef STRING
+#undef DATE
+#undef QUANTITY
+#undef REFERENCE
+#undef ANY
+
+#define FHIR_SEARCH_PARAMETER_TABLE(parameters) { parameters, sizeof(parameters) / sizeof(parameters[0]) }
+
+static const struct {
+    const FHIRSearchParameter* parameters;
+    size_t count;
+} g_search_parameters[FHIR_RESOURCE_TYPE_COUNT] = {
+    [FHIR_RESOURCE_TYPE_PATIENT] = FHIR_SEARCH_PARAMETER_TABLE(g_patient_parameters),
+    [FHIR_RESOURCE_TYPE_PRACTITIONER] = FHIR_SEARCH_PARAMETER_TABLE(g_practitioner_parameters),
+    [FHIR_RESOURCE_TYPE_ORGANIZATION] = FHIR_SEARCH_PARAMETER_TABLE(g_organization_parameters),
+    [FHIR_RESOURCE_TYPE_LOCATION] = FHIR_SEARCH_PARAMETER_TABLE(g_location_parameters),
+    [FHIR_RESOURCE_TYPE_ENCOUNTER] = FHIR_SEARCH_PARAMETER_TABLE(g_encounter_parameters),
+    [FHIR_RESOURCE_TYPE_OBSERVATION] = FHIR_SEARCH_PARAMETER_TABLE(g_observation_parameters),
+    [FHIR_RESOURCE_TYPE_CONDITION] = FHIR_SEARCH_PARAMETER_TABLE(g_condition_parameters),
+    [FHIR_RESOURCE_TYPE_CARE_PLAN] = FHIR_SEARCH_PARAMETER_TABLE(g_care_plan_parameters),
+};
+
+// Compiled expressions of each type, built on first use
+enum {
+    FHIR_SEARCH_PROGRAMS_UNCOMPILED = 0,
+    FHIR_SEARCH_PROGRAMS_BUSY,
+    FHIR_SEARCH_PROGRAMS_READY
+};
+
+static FHIRPathProgram** g_programs[FHIR_RESOURCE_TYPE_COUNT];
+static FHIRAtomicInt g_program_state[FHIR_RESOURCE_TYPE_COUNT];
+
+const FHIRSearchParameter* fhir_search_index_get_parameters(FHIRResourceType type, size_t* count) {
+    bool known = type > FHIR_RESOURCE_TYPE_UNKNOWN && type < FHIR_RESOURCE_TYPE_COUNT;
+    if (count) {
+        *count = known ? g_search_parameters[type].count : 0;
+    }
+    return known ? g_search_parameters[type].parameters : NULL;
+}
+
+static void destroy_programs(FHIRPathProgram** programs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        fhir_path_destroy(programs[i]);
+    }
+    fhir_free(programs);
+}
+
+static FHIRPathProgram* const* get_programs(FHIRResourceType type) {
+    FHIRAtomicInt* state = &g_program_state[type];
+    if (fhir_atomic_load(state) == FHIR_SEARCH_PROGRAMS_READY) {
+        return g_programs[type];
+    }
+
+    int expected = FHIR_SEARCH_PROGRAMS_UNCOMPILED;
+    if (fhir_atomic_compare_exchange(state, &expected, FHIR_SEARCH_PROGRAMS_BUSY)) {
+        size_t count = g_search_parameters[type].count;
+        FHIRPathProgram** programs = fhir_calloc(count, sizeof(FHIRPathProgram*));
+        bool compiled = programs != NULL;
+        for (size_t i = 0; compiled && i < count; i++) {
+            programs[i] = fhir_path_compile(g_search_parameters[type].parameters[i].expression);
+            compiled = programs[i] != NULL;
+        }
+        if (!compiled) {
+            if (programs) destroy_programs(programs, count);
+            fhir_atomic_store(state, FHIR_SEARCH_PROGRAMS_UNCOMPILED);
+            return NULL;
+        }
+        g_programs[type] = programs;
+        fhir_atomic_store(state, FHIR_SEARCH_PROGRAMS_READY);
+        return programs;
+    }
+
+    // Another thread is compiling them
+    while ((expected = fhir_atomic_load(state)) == FHIR_SEARCH_PROGRAMS_BUSY) {
+    }
+    if (expected != FHIR_SEARCH_PROGRAMS_READY) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to compile search parameters");
+        return NULL;
+    }
+    return g_programs[type];
+}
+
+/* ========================================================================== */
+/* Row Storage                                                                */
+/* ========================================================================== */
+
+void fhir_search_index_rows_init(FHIRSearchIndexRows* rows) {
+    if (!rows) return;
+    memset(rows, 0, sizeof(*rows));
+    fhir_path_result_init(&rows->scratch);
+}
+
+void fhir_search_index_rows_clear(FHIRSearchIndexRows* rows) {
+    if (!rows) return;
+    rows->count = 0;
+    fhir_arena_reset(rows->strings);
+}
+
+void fhir_search_index_rows_cleanup(FHIRSearchIndexRows* rows) {
+    if (!rows) return;
+    fhir_free(rows->rows);
+    fhir_arena_destroy(rows->strings);
+    fhir_path_result_cleanup(&rows->scratch);
+    memset(rows, 0, sizeof(*rows));
+}
+
+static FHIRSearchIndexRow* add_row(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter) {
+    if (rows->count == rows->capacity) {
+        size_t capacity = rows->capacity ? rows->capacity * 2 : 32;
+        FHIRSearchIndexRow* grown = fhir_realloc(rows->rows, capacity * sizeof(FHIRSearchIndexRow));
+        if (!grown) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow search index rows");
+            return NULL;
+        }
+        rows->rows = grown;
+        rows->capacity = capacity;
+    }
+    FHIRSearchIndexRow* row = &rows->rows[rows->count++];
+    memset(row, 0, sizeof(*row));
+    row->parameter = parameter->code;
+    row->type = parameter->type;
+    return row;
+}
+
+static char* copy_string(FHIRSearchIndexRows* rows, const char* text, size_t length) {
+    if (!rows->strings && !(rows->strings = fhir_arena_create(0))) {
+        return NULL;
+    }
+    char* copy = fhir_arena_alloc(rows->strings, length + 1);
+    if (copy) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+// Copy an optional string; *copy is NULL for a NULL text
+static bool copy_optional(FHIRSearchIndexRows* rows, const char* text, const char** copy) {
+    *copy = text ? copy_string(rows, text, strlen(text)) : NULL;
+    return !text || *copy;
+}
+
+/* ========================================================================== */
+/* Token Rows                                                                 */
+/* ========================================================================== */
+
+static bool add_token(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter,
+                      const char* system, const char* code) {
+    if (!code || !*code) return true;
+
+    FHIRSearchIndexRow* row = add_row(rows, parameter);
+    return row && copy_optional(rows, system, &row->value.token.system) &&
+           copy_optional(rows, code, &row->value.token.code);
+}
+
+static bool index_token(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const cJSON* node) {
+    if (cJSON_IsString(node)) {
+        return add_token(rows, parameter, NULL, node->valuestring);
+    }
+    if (cJSON_IsBool(node)) {
+        return add_token(rows, parameter, NULL, cJSON_IsTrue(node) ? "true" : "false");
+    }
+    if (!cJSON_IsObject(node)) {
+        return true;
+    }
+
+    // CodeableConcept
+    const cJSON* coding = cJSON_GetObjectItemCaseSensitive(node, "coding");
+    if (cJSON_IsArray(coding)) {
+        const cJSON* item;
+        cJSON_ArrayForEach(item, coding) {
+            if (cJSON_IsObject(item) &&
+                !add_token(rows, parameter, fhir_json_get_string(item, "system"),
+                           fhir_json_get_string(item, "code"))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Coding, then Identifier
+    const char* code = fhir_json_get_string(node, "code");
+    if (!code) code = fhir_json_get_string(node, "value");
+    return add_token(rows, parameter, fhir_json_get_string(node, "system"), code);
+}
+
+/* ========================================================================== */
+/* String Rows                                                                */
+/* ========================================================================== */
+
+// ASCII folds of U+00C0..U+00FF ('-' keeps the character)
+static const char g_latin1_folds[] = "aaaaaa-ceeeeiiii-nooooo-ouuuuy--aaaaaa-ceeeeiiii-nooooo-ouuuuy-y";
+
+static bool add_string(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const char* text) {
+    if (!text) return true;
+
+    // Lowercase, fold Latin-1 accents and collapse whitespace; never longer than text
+    size_t length = strlen(text);
+    char* normalized = copy_string(rows, text, length);
+    if (!normalized) return false;
+
+    size_t out = 0;
+    bool space = false;
+    for (size_t in = 0; in < length; in++) {
+        unsigned char c = (unsigned char)text[in];
+        if (isspace(c)) {
+            space = out > 0;
+            continue;
+        }
+        if (space) {
+            normalized[out++] = ' ';
+            space = false;
+        }
+        if (c == 0xC3 && in + 1 < length && (unsigned char)text[in + 1] >= 0x80 &&
+            (unsigned char)text[in + 1] <= 0xBF && g_latin1_folds[(unsigned char)text[in + 1] - 0x80] != '-') {
+            normalized[out++] = g_latin1_folds[(unsigned char)text[++in] - 0x80];
+        } else {
+            normalized[out++] = (char)(c < 0x80 ? tolower(c) : c);
+        }
+    }
+    normalized[out] = '\0';
+    if (out == 0) return true;
+
+    FHIRSearchIndexRow* row = add_row(rows, parameter);
+    if (!row) return false;
+    row->value.string = normalized;
+    return true;
+}
+
+static bool index_string(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const cJSON* node) {
+    if (cJSON_IsString(node)) {
+        return add_string(rows, parameter, node->valuestring);
+    }
+    if (!cJSON_IsObject(node)) {
+        return true;
+    }
+
+    // HumanName and Address parts
+    static const char* const parts[] = {
+        "text", "family", "given", "prefix", "suffix",
+        "line", "city", "district", "state", "postalCode", "country"
+    };
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        const cJSON* part = cJSON_GetObjectItemCaseSensitive(node, parts[i]);
+        if (cJSON_IsArray(part)) {
+            const cJSON* item;
+            cJSON_ArrayForEach(item, part) {
+                if (cJSON_IsString(item) && !add_string(rows, parameter, item->valuestring)) {
+                    return false;
+                }
+            }
+        } else if (cJSON_IsString(part) && !add_string(rows, parameter, part->valuestring)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Date Rows                                                                  */
+/* ========================================================================== */
+
+// The range a date, dateTime or instant covers at its precision; zone-less values are UTC
+static bool parse_date_range(const char* value, int64_t* start, int64_t* end) {
+    FHIRDateTimeValue parsed;
+    if (!fhir_datetime_parse(value, &parsed)) return false;
+
+    // Microseconds to milliseconds, rounding outward so the range never empties
+    int64_t end_us = fhir_datetime_end(&parsed);
+    *start = parsed.epoch_us / 1000 - (parsed.epoch_us % 1000 < 0);
+    *end = end_us / 1000 + (end_us % 1000 > 0);
+    return true;
+}
+
+static bool index_date(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const cJSON* node) {
+    int64_t start, end, ignored;
+    if (cJSON_IsString(node)) {
+        if (!parse_date_range(node->valuestring, &start, &end)) return true;
+    } else if (cJSON_IsObject(node)) {
+        // Period: a missing or malformed bound leaves that end open
+        const char* period_start = fhir_json_get_string(node, "start");
+        const char* period_end = fhir_json_get_string(node, "end");
+        if (!period_start && !period_end) return true;
+        if (!period_start || !parse_date_range(period_start, &start, &ignored)) {
+            start = FHIR_SEARCH_INDEX_DATE_MIN;
+        }
+        if (!period_end || !parse_date_range(period_end, &ignored, &end)) {
+            end = FHIR_SEARCH_INDEX_DATE_MAX;
+        }
+    } else {
+        return true;
+    }
+
+    FHIRSearchIndexRow* row = add_row(rows, parameter);
+    if (!row) return false;
+    row->value.date.start = start;
+    row->value.date.end = end;
+    return true;
+}
+
+/* ========================================================================== */
+/* Quantity Rows                                                              */
+/* ========================================================================== */
+
+// canonical = value * factor + offset
+static const struct {
+    const char* unit;
+    const char* canonical;
+    double factor;
+    double offset;
+} g_ucum_units[] = {
+    // Mass
+    {"g", "g", 1, 0}, {"kg", "g", 1e3, 0}, {"mg", "g", 1e-3, 0}, {"ug", "g", 1e-6, 0},
+    {"ng", "g", 1e-9, 0}, {"[lb_av]", "g", 453.59237, 0}, {"[oz_av]", "g", 28.349523125, 0},
+    // Length
+    {"m", "m", 1, 0}, {"km", "m", 1e3, 0}, {"cm", "m", 1e-2, 0}, {"mm", "m", 1e-3, 0},
+    {"[in_i]", "m", 0.0254, 0}, {"[ft_i]", "m", 0.3048, 0},
+    // Volume
+    {"L", "L", 1, 0}, {"dL", "L", 1e-1, 0}, {"mL", "L", 1e-3, 0}, {"uL", "L", 1e-6, 0},
+    // Time
+    {"s", "s", 1, 0}, {"ms", "s", 1e-3, 0}, {"min", "s", 60, 0}, {"h", "s", 3600, 0},
+    {"d", "s", 86400, 0}, {"wk", "s", 604800, 0}, {"mo", "s", 2629800, 0}, {"a", "s", 31557600, 0},
+    // Pressure
+    {"Pa", "Pa", 1, 0}, {"kPa", "Pa", 1e3, 0}, {"mm[Hg]", "Pa", 133.322387415, 0}, {"bar", "Pa", 1e5, 0},
+    // Temperature
+    {"Cel", "Cel", 1, 0}, {"K", "Cel", 1, -273.15}, {"[degF]", "Cel", 5.0 / 9.0, -160.0 / 9.0},
+    // Mass concentration
+    {"g/L", "g/L", 1, 0}, {"g/dL", "g/L", 10, 0}, {"mg/dL", "g/L", 1e-2, 0}, {"mg/L", "g/L", 1e-3, 0},
+    {"mg/mL", "g/L", 1, 0}, {"ug/L", "g/L", 1e-6, 0}, {"ng/mL", "g/L", 1e-6, 0},
+    // Substance concentration
+    {"mol/L", "mol/L", 1, 0}, {"mmol/L", "mol/L", 1e-3, 0}, {"umol/L", "mol/L", 1e-6, 0},
+    {"nmol/L", "mol/L", 1e-9, 0},
+    // Rates and ratios
+    {"/min", "/min", 1, 0}, {"/s", "/min", 60, 0}, {"/h", "/min", 1.0 / 60, 0},
+    {"%", "%", 1, 0},
+};
+
+bool fhir_search_index_normalize_quantity(double value, const char* unit, double* normalized,
+                                          const char** canonical) {
+    if (!unit || !normalized || !canonical) return false;
+
+    for (size_t i = 0; i < sizeof(g_ucum_units) / sizeof(g_ucum_units[0]); i++) {
+        if (strcmp(unit, g_ucum_units[i].unit) == 0) {
+            *normalized = value * g_ucum_units[i].factor + g_ucum_units[i].offset;
+            *canonical = g_ucum_units[i].canonical;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool index_quantity(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const cJSON* node) {
+    const cJSON* number = cJSON_IsObject(node) ? cJSON_GetObjectItemCaseSensitive(node, "value") : NULL;
+    if (!cJSON_IsNumber(number)) return true;
+
+    const char* system = fhir_json_get_string(node, "system");
+    const char* unit = fhir_json_get_string(node, "code");
+    if (!unit) unit = fhir_json_get_string(node, "unit");
+
+    FHIRSearchIndexRow* row = add_row(rows, parameter);
+    if (!row) return false;
+
+    const char* canonical;
+    if ((!system || strcmp(system, FHIR_SEARCH_INDEX_UCUM_SYSTEM) == 0) &&
+        fhir_search_index_normalize_quantity(number->valuedouble, unit, &row->value.quantity.value, &canonical)) {
+        // Canonical units are static
+        row->value.quantity.system = FHIR_SEARCH_INDEX_UCUM_SYSTEM;
+        row->value.quantity.unit = canonical;
+        return true;
+    }
+    row->value.quantity.value = number->valuedouble;
+    return copy_optional(rows, system, &row->value.quantity.system) &&
+           copy_optional(rows, unit, &row->value.quantity.unit);
+}
+
+/* ========================================================================== */
+/* Reference Rows                                                             */
+/* ========================================================================== */
+
+static bool index_reference(FHIRSearchIndexRows* rows, const FHIRSearchParameter* parameter, const cJSON* node) {
+    const char* reference = cJSON_IsObject(node) ? fhir_json_get_string(node, "reference") : NULL;
+    // Contained resources are not indexed
+    if (!reference || !*reference || reference[0] == '#') return true;
+
+    // [base/]Type/id[/_history/version]
+    size_t length = strlen(reference);
+    const char* history = strstr(reference, "/_history/");
+    if (history) length = (size_t)(history - reference);
+
+    FHIRResourceType type = FHIR_RESOURCE_TYPE_UNKNOWN;
+    size_t type_start = 0, id_start = 0;
+    if (strncmp(reference, "urn:", 4) != 0) {
+        // The last two segments are the type and the id
+        for (size_t i = 0; i < length; i++) {
+            if (reference[i] == '/') {
+                type_start = id_start;
+                id_start = i + 1;
+            }
+        }
+        if (id_start > 0 && id_start < length) {
+            type = fhir_resource_type_lookup(reference + type_start, id_start - 1 - type_start);
+        }
+    }
+    if (parameter->target != FHIR_RESOURCE_TYPE_UNKNOWN && type != parameter->target) {
+        return true;
+    }
+
+    FHIRSearchIndexRow* row = add_row(rows, parameter);
+    if (!row) return false;
+    row->value.reference.type = type;
+    if (type == FHIR_RESOURCE_TYPE_UNKNOWN) {
+        row->value.reference.id = copy_string(rows, reference, length);
+        return row->value.reference.id != NULL;
+    }
+    row->value.reference.type_name = copy_string(rows, reference + type_start, id_start - 1 - type_start);
+    row->value.reference.id = copy_string(rows, reference + id_start, length - id_start);
+    return row->value.reference.type_name && row->value.reference.id;
+}
+
+/* ========================================================================== */
+/* Extraction                                                                 */
+/* ========================================================================== */
+
+static bool extract_rows(FHIRResourceType type, const cJSON* json, FHIRSearchIndexRows* rows) {
+    size_t count;
+    const FHIRSearchParameter* parameters = fhir_search_index_get_parameters(type, &count);
+    if (count == 0) return true;
+
+    FHIRPathProgram* const* programs = get_programs(type);
+    if (!programs) return false;
+
+    for (size_t p = 0; p < count; p++) {
+        const FHIRSearchParameter* parameter = &parameters[p];
+        if (!fhir_path_evaluate(programs[p], json, &rows->scratch)) return false;
+
+        for (size_t i = 0; i < rows->scratch.count; i++) {
+            const cJSON* node = rows->scratch.items[i];
+            bool ok = true;
+            switch (parameter->type) {
+                case FHIR_SEARCH_PARAM_TOKEN: ok = index_token(rows, parameter, node); break;
+                case FHIR_SEARCH_PARAM_STRING: ok = index_string(rows, parameter, node); break;
+                case FHIR_SEARCH_PARAM_DATE: ok = index_date(rows, parameter, node); break;
+                case FHIR_SEARCH_PARAM_QUANTITY: ok = index_quantity(rows, parameter, node); break;
+                case FHIR_SEARCH_PARAM_REFERENCE: ok = index_reference(rows, parameter, node); break;
+            }
+            if (!ok) {
+                FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to add search index row");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Rows, programs and the scratch buffer outlive any arena current on the calling thread
+static bool extract_on_heap(FHIRResourceType type, const cJSON* json, FHIRSearchIndexRows* rows) {
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = extract_rows(type, json, rows);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+bool fhir_search_index_extract(const cJSON* json, FHIRSearchIndexRows* rows) {
+    const char* type_name = cJSON_IsObject(json) ? fhir_json_get_string(json, "resourceType") : NULL;
+    if (!type_name || !rows) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    return extract_on_heap(fhir_resource_type_lookup(type_name, strlen(type_name)), json, rows);
+}
+
+bool fhir_search_index_load(FHIRResourceBase* resource, const cJSON* json, FHIRSearchIndexRows* rows) {
+    if (!resource || !json || !rows) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    return fhir_resource_from_json(resource, json) && extract_on_heap(resource->resource_type, json, rows);
+}
@@ -0,0 +1,182 @@
+/**
+ * @file fhir_search_index.h
+ * @brief Search parameter index rows extracted from parsed resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * A built-in table keyed by FHIRResourceType lists the search parameters of
+ * each resource type as compiled FHIRPath expressions (fhir_path.h). The
+ * values they select are normalized into index rows while the JSON tree of
+ * the resource is still at hand, so indexing a write costs no second parse:
+ *
+ *   token      system|code from code, boolean, Coding, CodeableConcept, Identifier
+ *   string     lowercased, accent-folded text from strings, HumanName, Address
+ *   date       [start, end) epoch milliseconds from date, dateTime, instant, Period
+ *   quantity   value in the canonical UCUM unit of its dimension (mg/dL -> g/L)
+ *   reference  target type and id from relative or absolute references
+ */
+
+#ifndef FHIR_SEARCH_INDEX_H
+#define FHIR_SEARCH_INDEX_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include "fhir_path.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Search parameter types with a normalized row form
+ */
+typedef enum {
+    FHIR_SEARCH_PARAM_TOKEN,
+    FHIR_SEARCH_PARAM_STRING,
+    FHIR_SEARCH_PARAM_DATE,
+    FHIR_SEARCH_PARAM_QUANTITY,
+    FHIR_SEARCH_PARAM_REFERENCE
+} FHIRSearchParamType;
+
+/**
+ * @brief Search parameter definition of the built-in table
+ */
+typedef struct {
+    const char* code;            /**< Search parameter code, e.g. "birthdate" */
+    FHIRSearchParamType type;
+    const char* expression;      /**< FHIRPath expression */
+    FHIRResourceType target;     /**< Only references to this type (UNKNOWN = any) */
+} FHIRSearchParameter;
+
+/** Open ends of a date range (Period without start or end) */
+#define FHIR_SEARCH_INDEX_DATE_MIN INT64_MIN
+#define FHIR_SEARCH_INDEX_DATE_MAX INT64_MAX
+
+/** System of normalized quantities */
+#define FHIR_SEARCH_INDEX_UCUM_SYSTEM "http://unitsofmeasure.org"
+
+/**
+ * @brief One normalized index row
+ *
+ * Strings are owned by the FHIRSearchIndexRows that holds the row, except
+ * parameter, which points into the static parameter table.
+ */
+typedef struct {
+    const char* parameter;
+    FHIRSearchParamType type;
+    union {
+        struct {
+            const char* system;  /**< NULL when the value has no system */
+            const char* code;
+        } token;
+        const char* string;
+        struct {
+            int64_t start;       /**< Inclusive */
+            int64_t end;         /**< Exclusive */
+        } date;
+        struct {
+            double value;
+            const char* system;  /**< FHIR_SEARCH_INDEX_UCUM_SYSTEM when normalized */
+            const char* unit;    /**< Canonical unit code, or the original one */
+        } quantity;
+        struct {
+            FHIRResourceType type;  /**< UNKNOWN for urn: and unrecognized URLs */
+            const char* type_name;  /**< NULL when type is UNKNOWN */
+            const char* id;         /**< Id, or the whole reference when type is UNKNOWN */
+        } reference;
+    } value;
+} FHIRSearchIndexRow;
+
+/**
+ * @brief Growable set of index rows, reused across resources
+ */
+typedef struct {
+    FHIRSearchIndexRow* rows;
+    size_t count;
+    size_t capacity;
+    FHIRArena* strings;          /**< Row strings, reset by clear */
+    FHIRPathResult scratch;      /**< Evaluation buffer */
+} FHIRSearchIndexRows;
+
+/* ========================================================================== */
+/* Parameter Table                                                            */
+/* ========================================================================== */
+
+/**
+ * @brief Get the built-in search parameters of a resource type
+ * @param type Resource type
+ * @param count Output number of parameters
+ * @return Parameters, or NULL when the type has none
+ */
+const FHIRSearchParameter* fhir_search_index_get_parameters(FHIRResourceType type, size_t* count);
+
+/* ========================================================================== */
+/* Extraction                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty row set
+ * @param rows Row set to initialize
+ */
+void fhir_search_index_rows_init(FHIRSearchIndexRows* rows);
+
+/**
+ * @brief Remove every row, keeping the buffers
+ * @param rows Row set to clear
+ */
+void fhir_search_index_rows_clear(FHIRSearchIndexRows* rows);
+
+/**
+ * @brief Free a row set
+ * @param rows Row set to clean up (can be NULL)
+ */
+void fhir_search_index_rows_cleanup(FHIRSearchIndexRows* rows);
+
+/**
+ * @brief Append the index rows of a resource JSON tree
+ *
+ * Values that do not normalize (malformed dates, references to contained
+ * resources) produce no row rather than an error.
+ *
+ * @param json Resource JSON with resourceType
+ * @param rows Row set to append to
+ * @return true on success, false on allocation failure or invalid arguments
+ */
+bool fhir_search_index_extract(const cJSON* json, FHIRSearchIndexRows* rows);
+
+/**
+ * @brief Load a typed resource and append its index rows from the same tree
+ * @param resource Resource to load (from_json of its vtable)
+ * @param json Resource JSON
+ * @param rows Row set to append to
+ * @return true on success, false if loading or extraction fails
+ */
+bool fhir_search_index_load(FHIRResourceBase* resource, const cJSON* json, FHIRSearchIndexRows* rows);
+
+/**
+ * @brief Normalize a UCUM quantity to the canonical unit of its dimension
+ *
+ * Search values must go through the same normalization as index rows.
+ *
+ * @param value Value in unit
+ * @param unit UCUM unit code
+ * @param normalized Output value in the canonical unit
+ * @param canonical Output canonical unit code (static)
+ * @return true if unit is known, false to leave the quantity as is
+ */
+bool fhir_search_index_normalize_quantity(double value, const char* unit, double* normalized,
+                                          const char** canonical);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_SEARCH_INDEX_H */
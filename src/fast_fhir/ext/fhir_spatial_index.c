@@ -0,0 +1,686 @@
+/**
+ * @file fhir_spatial_index.c
+ * @brief Spatial index for Location.position proximity queries
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_spatial_index.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEGREES_TO_RADIANS (M_PI / 180.0)
+#define MINUTES_PER_DAY 1440
+
+/* ========================================================================== */
+/* Index Structure                                                            */
+/* ========================================================================== */
+
+// Entry storage; unused slots form a free list
+typedef struct {
+    FHIRSpatialEntry entry;
+    int64_t cell;
+    uint32_t next_free;
+    bool used;
+} SpatialSlot;
+
+// Grid cell listing the slots whose position falls inside it
+typedef struct {
+    int64_t key;                 // -1 when the table entry is empty
+    uint32_t* slots;
+    uint32_t count;
+    uint32_t capacity;
+} SpatialCell;
+
+struct FHIRSpatialIndex {
+    SpatialSlot* slots;
+    size_t slot_count;           // High-water mark
+    size_t slot_capacity;
+    uint32_t free_head;          // Slot + 1, 0 when the free list is empty
+    size_t count;
+    SpatialCell* cells;          // Open addressing, power-of-two capacity
+    size_t cell_capacity;
+    size_t cell_used;
+    uint32_t* ids;               // Slot + 1 by id hash, 0 when empty
+    size_t id_capacity;
+    size_t id_used;
+};
+
+static int64_t lat_cell_count(void) {
+    return (int64_t)llround(180.0 / FHIR_SPATIAL_INDEX_CELL_DEGREES) + 1;
+}
+
+static int64_t lon_cell_count(void) {
+    return (int64_t)llround(360.0 / FHIR_SPATIAL_INDEX_CELL_DEGREES);
+}
+
+static int64_t lat_cell(double latitude) {
+    int64_t cell = (int64_t)floor((latitude + 90.0) / FHIR_SPATIAL_INDEX_CELL_DEGREES);
+    int64_t last = lat_cell_count() - 1;
+    return cell < 0 ? 0 : cell > last ? last : cell;
+}
+
+// Any integer column, wrapped around the antimeridian
+static int64_t wrap_lon_cell(int64_t cell) {
+    int64_t count = lon_cell_count();
+    cell %= count;
+    return cell < 0 ? cell + count : cell;
+}
+
+static int64_t lon_cell(double longitude) {
+    return wrap_lon_cell((int64_t)floor((longitude + 180.0) / FHIR_SPATIAL_INDEX_CELL_DEGREES));
+}
+
+static size_t hash_cell(int64_t key) {
+    return (size_t)(((uint64_t)key * UINT64_C(0x9E3779B97F4A7C15)) >> 17);
+}
+
+// FNV-1a
+static size_t hash_id(const char* id) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (const unsigned char* p = (const unsigned char*)id; *p; p++) {
+        hash = (hash ^ *p) * UINT64_C(1099511628211);
+    }
+    return (size_t)hash;
+}
+
+FHIRSpatialIndex* fhir_spatial_index_create(void) {
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    FHIRSpatialIndex* index = fhir_calloc(1, sizeof(FHIRSpatialIndex));
+    fhir_arena_set_current(previous);
+
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate spatial index");
+    }
+    return index;
+}
+
+void fhir_spatial_index_destroy(FHIRSpatialIndex* index) {
+    if (!index) return;
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    for (size_t i = 0; i < index->slot_count; i++) {
+        if (index->slots[i].used) fhir_free((char*)index->slots[i].entry.id);
+    }
+    for (size_t i = 0; i < index->cell_capacity; i++) {
+        fhir_free(index->cells[i].slots);
+    }
+    fhir_free(index->slots);
+    fhir_free(index->cells);
+    fhir_free(index->ids);
+    fhir_free(index);
+    fhir_arena_set_current(previous);
+}
+
+size_t fhir_spatial_index_count(const FHIRSpatialIndex* index) {
+    return index ? index->count : 0;
+}
+
+/* ========================================================================== */
+/* Id Table                                                                   */
+/* ========================================================================== */
+
+// Position of id in the table, or of the empty entry where it would go
+static size_t id_position(const FHIRSpatialIndex* index, const char* id) {
+    size_t mask = index->id_capacity - 1;
+    size_t position = hash_id(id) & mask;
+    while (index->ids[position] &&
+           strcmp(index->slots[index->ids[position] - 1].entry.id, id) != 0) {
+        position = (position + 1) & mask;
+    }
+    return position;
+}
+
+static bool id_reserve(FHIRSpatialIndex* index) {
+    if ((index->id_used + 1) * 2 <= index->id_capacity) return true;
+
+    size_t capacity = index->id_capacity ? index->id_capacity * 2 : 64;
+    uint32_t* ids = fhir_calloc(capacity, sizeof(uint32_t));
+    if (!ids) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow spatial index");
+        return false;
+    }
+    for (size_t i = 0; i < index->id_capacity; i++) {
+        uint32_t slot = index->ids[i];
+        if (!slot) continue;
+        size_t position = hash_id(index->slots[slot - 1].entry.id) & (capacity - 1);
+        while (ids[position]) position = (position + 1) & (capacity - 1);
+        ids[position] = slot;
+    }
+    fhir_free(index->ids);
+    index->ids = ids;
+    index->id_capacity = capacity;
+    return true;
+}
+
+// Delete the entry at position, shifting later entries of its probe run back
+static void id_delete(FHIRSpatialIndex* index, size_t position) {
+    size_t mask = index->id_capacity - 1;
+    index->ids[position] = 0;
+    index->id_used--;
+
+    for (size_t next = (position + 1) & mask; index->ids[next]; next = (next + 1) & mask) {
+        size_t home = hash_id(index->slots[index->ids[next] - 1].entry.id) & mask;
+        if (((next - home) & mask) >= ((next - position) & mask)) {
+            index->ids[position] = index->ids[next];
+            index->ids[next] = 0;
+            position = next;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Cell Table                                                                 */
+/* ========================================================================== */
+
+static SpatialCell* cell_find(const FHIRSpatialIndex* index, int64_t key) {
+    if (!index->cell_capacity) return NULL;
+
+    size_t mask = index->cell_capacity - 1;
+    for (size_t position = hash_cell(key) & mask;; position = (position + 1) & mask) {
+        SpatialCell* cell = &index->cells[position];
+        if (cell->key == key) return cell;
+        if (cell->key < 0) return NULL;
+    }
+}
+
+static bool cell_reserve(FHIRSpatialIndex* index) {
+    if ((index->cell_used + 1) * 2 <= index->cell_capacity) return true;
+
+    size_t capacity = index->cell_capacity ? index->cell_capacity * 2 : 64;
+    SpatialCell* cells = fhir_calloc(capacity, sizeof(SpatialCell));
+    if (!cells) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow spatial index");
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) cells[i].key = -1;
+    for (size_t i = 0; i < index->cell_capacity; i++) {
+        if (index->cells[i].key < 0) continue;
+        size_t position = hash_cell(index->cells[i].key) & (capacity - 1);
+        while (cells[position].key >= 0) position = (position + 1) & (capacity - 1);
+        cells[position] = index->cells[i];
+    }
+    fhir_free(index->cells);
+    index->cells = cells;
+    index->cell_capacity = capacity;
+    return true;
+}
+
+// Emptied cells stay in the table, so a cell is never moved by removals
+static bool cell_add(FHIRSpatialIndex* index, int64_t key, uint32_t slot) {
+    SpatialCell* cell = cell_find(index, key);
+    if (!cell) {
+        if (!cell_reserve(index)) return false;
+        size_t mask = index->cell_capacity - 1;
+        size_t position = hash_cell(key) & mask;
+        while (index->cells[position].key >= 0) position = (position + 1) & mask;
+        cell = &index->cells[position];
+        cell->key = key;
+        index->cell_used++;
+    }
+    if (cell->count == cell->capacity) {
+        uint32_t capacity = cell->capacity ? cell->capacity * 2 : 4;
+        uint32_t* slots = fhir_realloc(cell->slots, capacity * sizeof(uint32_t));
+        if (!slots) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow spatial index cell");
+            return false;
+        }
+        cell->slots = slots;
+        cell->capacity = capacity;
+    }
+    cell->slots[cell->count++] = slot;
+    return true;
+}
+
+static void cell_remove(FHIRSpatialIndex* index, int64_t key, uint32_t slot) {
+    SpatialCell* cell = cell_find(index, key);
+    if (!cell) return;
+    for (uint32_t i = 0; i < cell->count; i++) {
+        if (cell->slots[i] == slot) {
+            cell->slots[i] = cell->slots[--cell->count];
+            return;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Updates                                                                    */
+/* ========================================================================== */
+
+static bool valid_position(double latitude, double longitude) {
+    return latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0;
+}
+
+static int64_t cell_key(double latitude, double longitude) {
+    return lat_cell(latitude) * lon_cell_count() + lon_cell(longitude);
+}
+
+static bool allocate_slot(FHIRSpatialIndex* index, uint32_t* slot) {
+    if (index->free_head) {
+        *slot = index->free_head - 1;
+        index->free_head = index->slots[*slot].next_free;
+        return true;
+    }
+    if (index->slot_count == index->slot_capacity) {
+        size_t capacity = index->slot_capacity ? index->slot_capacity * 2 : 64;
+        if (capacity > UINT32_MAX - 1) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Spatial index is full");
+            return false;
+        }
+        SpatialSlot* slots = fhir_realloc(index->slots, capacity * sizeof(SpatialSlot));
+        if (!slots) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow spatial index");
+            return false;
+        }
+        index->slots = slots;
+        index->slot_capacity = capacity;
+    }
+    *slot = (uint32_t)index->slot_count++;
+    return true;
+}
+
+static bool upsert_on_heap(FHIRSpatialIndex* index, const FHIRSpatialEntry* entry) {
+    if (!id_reserve(index)) return false;
+
+    size_t position = id_position(index, entry->id);
+    int64_t key = cell_key(entry->latitude, entry->longitude);
+
+    if (index->ids[position]) {
+        // Move an indexed Location; its id string stays
+        uint32_t slot = index->ids[position] - 1;
+        SpatialSlot* existing = &index->slots[slot];
+        if (existing->cell != key) {
+            if (!cell_add(index, key, slot)) return false;
+            // cell_add may move the table, not the slots
+            cell_remove(index, existing->cell, slot);
+            existing->cell = key;
+        }
+        const char* id = existing->entry.id;
+        existing->entry = *entry;
+        existing->entry.id = id;
+        return true;
+    }
+
+    char* id = fhir_strdup(entry->id);
+    uint32_t slot;
+    if (!id || !allocate_slot(index, &slot)) {
+        fhir_free(id);
+        if (!id) FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy Location id");
+        return false;
+    }
+    SpatialSlot* created = &index->slots[slot];
+    created->entry = *entry;
+    created->entry.id = id;
+    created->cell = key;
+    created->used = true;
+    created->next_free = 0;
+    if (!cell_add(index, key, slot)) {
+        created->used = false;
+        created->next_free = index->free_head;
+        index->free_head = slot + 1;
+        fhir_free(id);
+        return false;
+    }
+
+    index->ids[position] = slot + 1;
+    index->id_used++;
+    index->count++;
+    return true;
+}
+
+bool fhir_spatial_index_upsert(FHIRSpatialIndex* index, const FHIRSpatialEntry* entry) {
+    if (!index || !entry || !entry->id || !valid_position(entry->latitude, entry->longitude) ||
+        entry->hours_count > FHIR_SPATIAL_INDEX_MAX_HOURS) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = upsert_on_heap(index, entry);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+bool fhir_spatial_index_remove(FHIRSpatialIndex* index, const char* id) {
+    if (!index || !id || !index->id_capacity) return false;
+
+    size_t position = id_position(index, id);
+    if (!index->ids[position]) return false;
+
+    uint32_t slot = index->ids[position] - 1;
+    SpatialSlot* removed = &index->slots[slot];
+    cell_remove(index, removed->cell, slot);
+    id_delete(index, position);
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    fhir_free((char*)removed->entry.id);
+    fhir_arena_set_current(previous);
+    removed->entry.id = NULL;
+    removed->used = false;
+    removed->next_free = index->free_head;
+    index->free_head = slot + 1;
+    index->count--;
+    return true;
+}
+
+const FHIRSpatialEntry* fhir_spatial_index_get(const FHIRSpatialIndex* index, const char* id) {
+    if (!index || !id || !index->id_capacity) return NULL;
+
+    size_t position = id_position(index, id);
+    return index->ids[position] ? &index->slots[index->ids[position] - 1].entry : NULL;
+}
+
+/* ========================================================================== */
+/* Hours Of Operation                                                         */
+/* ========================================================================== */
+
+// hh:mm or hh:mm:ss as minutes after midnight, -1 if malformed
+static int parse_minutes(const char* text) {
+    if (!text) return -1;
+    for (int i = 0; i < 5; i++) {
+        if (i == 2 ? text[i] != ':' : (text[i] < '0' || text[i] > '9')) return -1;
+    }
+    int hour = (text[0] - '0') * 10 + (text[1] - '0');
+    int minute = (text[3] - '0') * 10 + (text[4] - '0');
+    if (hour > 24 || minute > 59 || (hour == 24 && minute != 0)) return -1;
+    return hour * 60 + minute;
+}
+
+static uint8_t parse_days(const cJSON* days) {
+    static const char* codes[] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+    if (!cJSON_IsArray(days) || cJSON_GetArraySize(days) == 0) return 0x7F;
+
+    uint8_t mask = 0;
+    const cJSON* day;
+    cJSON_ArrayForEach(day, days) {
+        for (int i = 0; cJSON_IsString(day) && i < 7; i++) {
+            if (strcmp(day->valuestring, codes[i]) == 0) mask |= (uint8_t)(1 << i);
+        }
+    }
+    return mask;
+}
+
+// One R4 hoursOfOperation or R5 availableTime item
+static void parse_hours_item(const cJSON* item, const char* open_name, const char* close_name,
+                             FHIRSpatialHours* hours, size_t* count) {
+    if (!cJSON_IsObject(item) || *count == FHIR_SPATIAL_INDEX_MAX_HOURS) return;
+
+    FHIRSpatialHours range;
+    range.days = parse_days(cJSON_GetObjectItemCaseSensitive(item, "daysOfWeek"));
+    if (!range.days) return;
+
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(item, "allDay"))) {
+        range.open_minute = 0;
+        range.close_minute = MINUTES_PER_DAY;
+    } else {
+        const char* open_text = fhir_json_get_string(item, open_name);
+        const char* close_text = fhir_json_get_string(item, close_name);
+        int open_minute = open_text ? parse_minutes(open_text) : 0;
+        int close_minute = close_text ? parse_minutes(close_text) : MINUTES_PER_DAY;
+        if (open_minute < 0 || close_minute < 0) return;
+        range.open_minute = (uint16_t)open_minute;
+        range.close_minute = (uint16_t)close_minute;
+    }
+    hours[(*count)++] = range;
+}
+
+size_t fhir_spatial_index_parse_hours(const cJSON* json, FHIRSpatialHours* hours) {
+    const cJSON* items = cJSON_GetObjectItemCaseSensitive(json, "hoursOfOperation");
+    if (!hours || !cJSON_IsArray(items)) return 0;
+
+    size_t count = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, items) {
+        // R5 wraps the times in an Availability
+        const cJSON* available = cJSON_GetObjectItemCaseSensitive(item, "availableTime");
+        if (cJSON_IsArray(available)) {
+            const cJSON* time;
+            cJSON_ArrayForEach(time, available) {
+                parse_hours_item(time, "availableStartTime", "availableEndTime", hours, &count);
+            }
+        } else {
+            parse_hours_item(item, "openingTime", "closingTime", hours, &count);
+        }
+    }
+    return count;
+}
+
+bool fhir_spatial_entry_is_open(const FHIRSpatialEntry* entry, const FHIRSpatialOpenAt* open_at) {
+    if (!entry || !open_at || open_at->day < 0 || open_at->day > 6) return false;
+
+    uint8_t today = (uint8_t)(1 << open_at->day);
+    uint8_t yesterday = (uint8_t)(1 << ((open_at->day + 6) % 7));
+    for (size_t i = 0; i < entry->hours_count; i++) {
+        const FHIRSpatialHours* range = &entry->hours[i];
+        if (range->open_minute < range->close_minute) {
+            if ((range->days & today) && open_at->minute >= range->open_minute &&
+                open_at->minute < range->close_minute) {
+                return true;
+            }
+        } else if (range->open_minute == range->close_minute) {
+            if (range->days & today) return true;
+        } else if (((range->days & today) && open_at->minute >= range->open_minute) ||
+                   ((range->days & yesterday) && open_at->minute < range->close_minute)) {
+            // Open past midnight
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ========================================================================== */
+/* Queries                                                                    */
+/* ========================================================================== */
+
+double fhir_spatial_distance(double latitude_a, double longitude_a, double latitude_b, double longitude_b) {
+    double phi_a = latitude_a * DEGREES_TO_RADIANS;
+    double phi_b = latitude_b * DEGREES_TO_RADIANS;
+    double half_phi = (phi_b - phi_a) / 2.0;
+    double half_lambda = (longitude_b - longitude_a) * DEGREES_TO_RADIANS / 2.0;
+    double h = sin(half_phi) * sin(half_phi) + cos(phi_a) * cos(phi_b) * sin(half_lambda) * sin(half_lambda);
+    if (h > 1.0) h = 1.0;
+    return 2.0 * FHIR_SPATIAL_INDEX_EARTH_RADIUS * asin(sqrt(h));
+}
+
+void fhir_spatial_result_init(FHIRSpatialResult* result) {
+    if (!result) return;
+    memset(result, 0, sizeof(*result));
+}
+
+void fhir_spatial_result_cleanup(FHIRSpatialResult* result) {
+    if (!result) return;
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    fhir_free(result->items);
+    fhir_arena_set_current(previous);
+    memset(result, 0, sizeof(*result));
+}
+
+typedef struct {
+    double latitude;
+    double longitude;
+    double radius;
+    const FHIRSpatialOpenAt* open_at;
+    FHIRSpatialResult* result;
+} SpatialQuery;
+
+static bool result_push(FHIRSpatialResult* result, const FHIRSpatialEntry* entry, double distance) {
+    if (result->count == result->capacity) {
+        size_t capacity = result->capacity ? result->capacity * 2 : 16;
+        FHIRSpatialHit* items = fhir_realloc(result->items, capacity * sizeof(FHIRSpatialHit));
+        if (!items) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow spatial result");
+            return false;
+        }
+        result->items = items;
+        result->capacity = capacity;
+    }
+    result->items[result->count].entry = entry;
+    result->items[result->count].distance = distance;
+    result->count++;
+    return true;
+}
+
+static bool scan_cell(const FHIRSpatialIndex* index, const SpatialCell* cell, const SpatialQuery* query) {
+    for (uint32_t i = 0; i < cell->count; i++) {
+        const FHIRSpatialEntry* entry = &index->slots[cell->slots[i]].entry;
+        double distance = fhir_spatial_distance(query->latitude, query->longitude, entry->latitude, entry->longitude);
+        if (distance > query->radius) continue;
+        if (query->open_at && !fhir_spatial_entry_is_open(entry, query->open_at)) continue;
+        if (!result_push(query->result, entry, distance)) return false;
+    }
+    return true;
+}
+
+static int compare_hits(const void* a, const void* b) {
+    const FHIRSpatialHit* left = a;
+    const FHIRSpatialHit* right = b;
+    if (left->distance != right->distance) return left->distance < right->distance ? -1 : 1;
+    return strcmp(left->entry->id, right->entry->id);
+}
+
+// Collect hits from the cells of the bounding box of the query circle
+static bool collect(const FHIRSpatialIndex* index, const SpatialQuery* query) {
+    double angle = query->radius / FHIR_SPATIAL_INDEX_EARTH_RADIUS;
+    double angle_degrees = angle / DEGREES_TO_RADIANS;
+    double lat_min = query->latitude - angle_degrees;
+    double lat_max = query->latitude + angle_degrees;
+
+    // Longitude half-width of the circle; undefined once it reaches a pole
+    bool every_column = angle >= M_PI || lat_min <= -90.0 || lat_max >= 90.0;
+    double lon_half_width = 180.0;
+    if (!every_column) {
+        double ratio = sin(angle) / cos(query->latitude * DEGREES_TO_RADIANS);
+        every_column = ratio >= 1.0;
+        if (!every_column) lon_half_width = asin(ratio) / DEGREES_TO_RADIANS;
+    }
+
+    int64_t row_first = lat_cell(lat_min < -90.0 ? -90.0 : lat_min);
+    int64_t row_last = lat_cell(lat_max > 90.0 ? 90.0 : lat_max);
+    int64_t column_first = 0, column_last = lon_cell_count() - 1;
+    if (!every_column) {
+        column_first = (int64_t)floor((query->longitude - lon_half_width + 180.0) / FHIR_SPATIAL_INDEX_CELL_DEGREES);
+        column_last = (int64_t)floor((query->longitude + lon_half_width + 180.0) / FHIR_SPATIAL_INDEX_CELL_DEGREES);
+        if (column_last - column_first + 1 >= lon_cell_count()) {
+            column_first = 0;
+            column_last = lon_cell_count() - 1;
+        }
+    }
+
+    // Wide circles visit the occupied cells rather than every box cell
+    double box_cells = (double)(row_last - row_first + 1) * (double)(column_last - column_first + 1);
+    if (box_cells > (double)index->cell_used) {
+        for (size_t i = 0; i < index->cell_capacity; i++) {
+            if (index->cells[i].key >= 0 && !scan_cell(index, &index->cells[i], query)) return false;
+        }
+        return true;
+    }
+
+    for (int64_t row = row_first; row <= row_last; row++) {
+        for (int64_t column = column_first; column <= column_last; column++) {
+            const SpatialCell* cell = cell_find(index, row * lon_cell_count() + wrap_lon_cell(column));
+            if (cell && !scan_cell(index, cell, query)) return false;
+        }
+    }
+    return true;
+}
+
+static bool within_on_heap(const FHIRSpatialIndex* index, const SpatialQuery* query) {
+    query->result->count = 0;
+    if (!collect(index, query)) return false;
+    if (query->result->count > 1) {
+        qsort(query->result->items, query->result->count, sizeof(FHIRSpatialHit), compare_hits);
+    }
+    return true;
+}
+
+bool fhir_spatial_index_within(const FHIRSpatialIndex* index, double latitude, double longitude,
+                               double radius, const FHIRSpatialOpenAt* open_at, FHIRSpatialResult* result) {
+    if (!index || !result || !valid_position(latitude, longitude) || !(radius >= 0.0)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    SpatialQuery query = { latitude, longitude, radius, open_at, result };
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok = within_on_heap(index, &query);
+    fhir_arena_set_current(previous);
+    return ok;
+}
+
+bool fhir_spatial_index_nearest(const FHIRSpatialIndex* index, double latitude, double longitude, size_t k,
+                                const FHIRSpatialOpenAt* open_at, FHIRSpatialResult* result) {
+    if (!index || !result || !valid_position(latitude, longitude)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    result->count = 0;
+    if (k == 0 || index->count == 0) return true;
+
+    // Anything outside a radius is farther than everything inside it, so the
+    // first radius holding k hits gives the exact k nearest
+    const double half_circumference = M_PI * FHIR_SPATIAL_INDEX_EARTH_RADIUS;
+    double radius = FHIR_SPATIAL_INDEX_CELL_DEGREES * DEGREES_TO_RADIANS * FHIR_SPATIAL_INDEX_EARTH_RADIUS;
+    SpatialQuery query = { latitude, longitude, radius, open_at, result };
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    bool ok;
+    for (;;) {
+        query.radius = radius < half_circumference ? radius : half_circumference;
+        ok = within_on_heap(index, &query);
+        if (!ok || result->count >= k || radius >= half_circumference) break;
+        radius *= 2.0;
+    }
+    fhir_arena_set_current(previous);
+
+    if (ok && result->count > k) result->count = k;
+    return ok;
+}
+
+/* ========================================================================== */
+/* Resources                                                                  */
+/* ========================================================================== */
+
+bool fhir_spatial_index_upsert_json(FHIRSpatialIndex* index, const cJSON* json, size_t value, bool* indexed) {
+    bool ignored;
+    if (!indexed) indexed = &ignored;
+    *indexed = false;
+
+    const char* id = cJSON_IsObject(json) ? fhir_json_get_string(json, "id") : NULL;
+    if (!index || !id) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    const char* type = fhir_json_get_string(json, "resourceType");
+    if (type && strcmp(type, "Location") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Expected a Location");
+        return false;
+    }
+
+    const cJSON* position = cJSON_GetObjectItemCaseSensitive(json, "position");
+    const cJSON* latitude = cJSON_IsObject(position) ? cJSON_GetObjectItemCaseSensitive(position, "latitude") : NULL;
+    const cJSON* longitude = cJSON_IsObject(position) ? cJSON_GetObjectItemCaseSensitive(position, "longitude") : NULL;
+    if (!cJSON_IsNumber(latitude) || !cJSON_IsNumber(longitude) ||
+        !valid_position(latitude->valuedouble, longitude->valuedouble)) {
+        // Without a usable position the Location leaves the index
+        fhir_spatial_index_remove(index, id);
+        return true;
+    }
+
+    FHIRSpatialEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.id = id;
+    entry.latitude = latitude->valuedouble;
+    entry.longitude = longitude->valuedouble;
+    entry.value = value;
+    entry.hours_count = fhir_spatial_index_parse_hours(json, entry.hours);
+
+    if (!fhir_spatial_index_upsert(index, &entry)) return false;
+    *indexed = true;
+    return true;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file fhir_spatial_index.h
+ * @brief Spatial index for Location.position proximity queries
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Locations are bucketed by their position into a grid of
+ * FHIR_SPATIAL_INDEX_CELL_DEGREES cells held in a hash table, so a radius
+ * query only visits the cells of the spherical bounding box of its circle
+ * and a k-nearest query widens a radius until it holds k Locations.
+ * Distances are great-circle (haversine) meters.
+ *
+ * Entries are keyed by Location id: indexing a Location again moves it,
+ * and removing it frees its slot, so the index follows updates without a
+ * rebuild. Hours of operation (R4 hoursOfOperation or R5 Availability) are
+ * kept per entry for "open at" filtering.
+ */
+
+#ifndef FHIR_SPATIAL_INDEX_H
+#define FHIR_SPATIAL_INDEX_H
+
+#include "common/fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Grid cell size in degrees of latitude and longitude */
+#define FHIR_SPATIAL_INDEX_CELL_DEGREES 0.1
+
+/** Mean Earth radius used for distances, in meters */
+#define FHIR_SPATIAL_INDEX_EARTH_RADIUS 6371008.8
+
+/** Opening ranges kept per Location; further ranges are ignored */
+#define FHIR_SPATIAL_INDEX_MAX_HOURS 16
+
+/**
+ * @brief Weekly opening range
+ *
+ * close_minute before open_minute spans midnight.
+ */
+typedef struct {
+    uint8_t days;                /**< Bit 0 = Monday ... bit 6 = Sunday */
+    uint16_t open_minute;        /**< Minutes after local midnight, inclusive */
+    uint16_t close_minute;       /**< Exclusive, 1440 for end of day */
+} FHIRSpatialHours;
+
+/**
+ * @brief One indexed Location
+ *
+ * Strings are owned by the index.
+ */
+typedef struct {
+    const char* id;
+    double latitude;
+    double longitude;
+    size_t value;                /**< Caller value, e.g. a position in a resource list */
+    FHIRSpatialHours hours[FHIR_SPATIAL_INDEX_MAX_HOURS];
+    size_t hours_count;          /**< 0 when the Location has no hours of operation */
+} FHIRSpatialEntry;
+
+/**
+ * @brief Local time for "open at" filtering
+ */
+typedef struct {
+    int day;                     /**< 0 = Monday ... 6 = Sunday */
+    int minute;                  /**< Minutes after local midnight */
+} FHIRSpatialOpenAt;
+
+/**
+ * @brief Location selected by a query
+ */
+typedef struct {
+    const FHIRSpatialEntry* entry;
+    double distance;             /**< Meters from the query point */
+} FHIRSpatialHit;
+
+/**
+ * @brief Hits of a query, nearest first
+ *
+ * Entry pointers stay valid until the next change to the index.
+ */
+typedef struct {
+    FHIRSpatialHit* items;
+    size_t count;
+    size_t capacity;
+} FHIRSpatialResult;
+
+/**
+ * @brief Spatial index (opaque)
+ */
+typedef struct FHIRSpatialIndex FHIRSpatialIndex;
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty index
+ * @return New index or NULL on allocation failure
+ */
+FHIRSpatialIndex* fhir_spatial_index_create(void);
+
+/**
+ * @brief Destroy an index and the strings it owns
+ * @param index Index to destroy (can be NULL)
+ */
+void fhir_spatial_index_destroy(FHIRSpatialIndex* index);
+
+/**
+ * @brief Get the number of indexed Locations
+ * @param index Index to query
+ * @return Entry count
+ */
+size_t fhir_spatial_index_count(const FHIRSpatialIndex* index);
+
+/**
+ * @brief Insert a Location or move an indexed one
+ * @param index Index to update
+ * @param entry Location to store; id is copied and must not be NULL
+ * @return true on success, false on allocation failure or invalid coordinates
+ */
+bool fhir_spatial_index_upsert(FHIRSpatialIndex* index, const FHIRSpatialEntry* entry);
+
+/**
+ * @brief Index a Location JSON tree by its id, position and hours of operation
+ *
+ * A Location without a valid position is removed from the index, so
+ * re-indexing a changed resource always leaves the index current.
+ *
+ * @param index Index to update
+ * @param json Location JSON with an id
+ * @param value Caller value stored in the entry
+ * @param indexed Output whether the Location is now in the index (can be NULL)
+ * @return true on success, false on allocation failure or invalid arguments
+ */
+bool fhir_spatial_index_upsert_json(FHIRSpatialIndex* index, const cJSON* json, size_t value, bool* indexed);
+
+/**
+ * @brief Remove a Location
+ * @param index Index to update
+ * @param id Location id
+ * @return true if the Location was indexed
+ */
+bool fhir_spatial_index_remove(FHIRSpatialIndex* index, const char* id);
+
+/**
+ * @brief Find an indexed Location
+ * @param index Index to query
+ * @param id Location id
+ * @return Entry or NULL when not indexed
+ */
+const FHIRSpatialEntry* fhir_spatial_index_get(const FHIRSpatialIndex* index, const char* id);
+
+/**
+ * @brief Parse hoursOfOperation of a Location JSON tree
+ * @param json Location JSON
+ * @param hours Output ranges (FHIR_SPATIAL_INDEX_MAX_HOURS)
+ * @return Number of ranges stored
+ */
+size_t fhir_spatial_index_parse_hours(const cJSON* json, FHIRSpatialHours* hours);
+
+/**
+ * @brief Check whether an entry is open at a local time
+ * @param entry Indexed entry
+ * @param open_at Local day and minute
+ * @return true if one of its ranges covers open_at
+ */
+bool fhir_spatial_entry_is_open(const FHIRSpatialEntry* entry, const FHIRSpatialOpenAt* open_at);
+
+/* ========================================================================== */
+/* Queries                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Initialize an empty result
+ * @param result Result to initialize
+ */
+void fhir_spatial_result_init(FHIRSpatialResult* result);
+
+/**
+ * @brief Free the buffer of a result
+ * @param result Result to clean up (can be NULL)
+ */
+void fhir_spatial_result_cleanup(FHIRSpatialResult* result);
+
+/**
+ * @brief Find Locations within a radius, nearest first
+ * @param index Index to query
+ * @param latitude Query latitude in degrees
+ * @param longitude Query longitude in degrees
+ * @param radius Radius in meters
+ * @param open_at Only Locations open at this time (NULL for all)
+ * @param result Output hits (replaces the previous contents)
+ * @return true on success, false on allocation failure or invalid arguments
+ */
+bool fhir_spatial_index_within(const FHIRSpatialIndex* index, double latitude, double longitude,
+                               double radius, const FHIRSpatialOpenAt* open_at, FHIRSpatialResult* result);
+
+/**
+ * @brief Find the k nearest Locations, nearest first
+ * @param index Index to query
+ * @param latitude Query latitude in degrees
+ * @param longitude Query longitude in degrees
+ * @param k Maximum number of hits
+ * @param open_at Only Locations open at this time (NULL for all)
+ * @param result Output hits (replaces the previous contents)
+ * @return true on success, false on allocation failure or invalid arguments
+ */
+bool fhir_spatial_index_nearest(const FHIRSpatialIndex* index, double latitude, double longitude, size_t k,
+                                const FHIRSpatialOpenAt* open_at, FHIRSpatialResult* result);
+
+/**
+ * @brief Great-circle distance between two points
+ * @param latitude_a Latitude of the first point in degrees
+ * @param longitude_a Longitude of the first point in degrees
+ * @param latitude_b Latitude of the second point in degrees
+ * @param longitude_b Longitude of the second point in degrees
+ * @return Distance in meters
+ */
+double fhir_spatial_distance(double latitude_a, double longitude_a, double latitude_b, double longitude_b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_SPATIAL_INDEX_H */
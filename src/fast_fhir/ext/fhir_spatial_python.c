@@ -0,0 +1,304 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_document.h"
+#include "fhir_spatial_index.h"
+
+// Python binding for the spatial index
+
+// SpatialIndex: Location positions for radius and k-nearest queries
+typedef struct {
+    PyObject_HEAD
+    FHIRSpatialIndex* index;
+} SpatialIndex;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* spatial_index_type;
+    const FHIRPythonDocuments* documents;   // fhir_parser_c entry points, or NULL without it
+} SpatialModuleState;
+
+static struct PyModuleDef fhir_spatial_module;
+
+static int SpatialIndex_init(SpatialIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+        return -1;
+    }
+    
+    FHIRSpatialIndex* index = fhir_spatial_index_create();
+    if (index == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_spatial_index_destroy(self->index);
+    self->index = index;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void SpatialIndex_dealloc(SpatialIndex* self) {
+    fhir_spatial_index_destroy(self->index);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int SpatialIndex_check_ready(const SpatialIndex* self) {
+    if (self->index == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "SpatialIndex is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* SpatialIndex_upsert(SpatialIndex* self, PyObject* document) {
+    SpatialModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_spatial_module);
+    if (!state || !SpatialIndex_check_ready(self)) {
+        return NULL;
+    }
+    
+    cJSON* owned;
+    const cJSON* json = fhir_python_document_json(state->documents, document, &owned);
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    bool indexed;
+    bool ok;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_spatial_index_upsert_json(self->index, json, 0, &indexed);
+    FHIR_PY_END_CRITICAL_SECTION();
+    cJSON_Delete(owned);
+    if (!ok) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, error ? error->message : "Expected a Location with an id");
+        return NULL;
+    }
+    return PyBool_FromLong(indexed);
+}
+
+static PyObject* SpatialIndex_remove(SpatialIndex* self, PyObject* args) {
+    const char* id;
+    if (!SpatialIndex_check_ready(self) || !PyArg_ParseTuple(args, "s", &id)) {
+        return NULL;
+    }
+    bool removed;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    removed = fhir_spatial_index_remove(self->index, id);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return PyBool_FromLong(removed);
+}
+
+// open_at from a (day, time) tuple such as ("mon", "09:30"), or None
+static int spatial_open_at_from_python(PyObject* value, FHIRSpatialOpenAt* open_at, bool* present) {
+    static const char* days[] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+    *present = value != NULL && value != Py_None;
+    if (!*present) {
+        return 1;
+    }
+    
+    const char* day;
+    const char* time;
+    if (!PyTuple_Check(value) || !PyArg_ParseTuple(value, "ss", &day, &time)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_TypeError, "open_at must be a (day, \"hh:mm\") tuple");
+        return 0;
+    }
+    
+    open_at->day = -1;
+    for (int i = 0; i < 7; i++) {
+        if (strcmp(day, days[i]) == 0) {
+            open_at->day = i;
+        }
+    }
+    int hour, minute;
+    if (open_at->day < 0 || sscanf(time, "%2d:%2d", &hour, &minute) != 2 ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        PyErr_Format(PyExc_ValueError, "Invalid open_at: (%s, %s)", day, time);
+        return 0;
+    }
+    open_at->minute = hour * 60 + minute;
+    return 1;
+}
+
+static PyObject* spatial_result_to_python(const FHIRSpatialResult* result) {
+    PyObject* hits = PyList_New((Py_ssize_t)result->count);
+    if (hits == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < result->count; i++) {
+        PyObject* hit = Py_BuildValue("(sd)", result->items[i].entry->id, result->items[i].distance);
+        if (hit == NULL) {
+            Py_DECREF(hits);
+            return NULL;
+        }
+        PyList_SET_ITEM(hits, (Py_ssize_t)i, hit);
+    }
+    return hits;
+}
+
+static PyObject* SpatialIndex_nearest(SpatialIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"latitude", "longitude", "k", "open_at", NULL};
+    double latitude, longitude;
+    Py_ssize_t k;
+    PyObject* open_arg = NULL;
+    if (!SpatialIndex_check_ready(self) ||
+        !PyArg_ParseTupleAndKeywords(args, kwds, "ddn|O", kwlist, &latitude, &longitude, &k, &open_arg)) {
+        return NULL;
+    }
+    
+    FHIRSpatialOpenAt open_at;
+    bool filter;
+    if (!spatial_open_at_from_python(open_arg, &open_at, &filter)) {
+        return NULL;
+    }
+    if (k < 0) {
+        PyErr_SetString(PyExc_ValueError, "k must not be negative");
+        return NULL;
+    }
+    
+    // Hits point at index entries, which a concurrent upsert or remove may free
+    FHIRSpatialResult result;
+    bool ok;
+    PyObject* hits;
+    fhir_spatial_result_init(&result);
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_spatial_index_nearest(self->index, latitude, longitude, (size_t)k,
+                                    filter ? &open_at : NULL, &result);
+    hits = ok ? spatial_result_to_python(&result) : NULL;
+    FHIR_PY_END_CRITICAL_SECTION();
+    fhir_spatial_result_cleanup(&result);
+    if (!ok) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, "Invalid coordinates");
+    }
+    return hits;
+}
+
+static PyObject* SpatialIndex_within(SpatialIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"latitude", "longitude", "radius", "open_at", NULL};
+    double latitude, longitude, radius;
+    PyObject* open_arg = NULL;
+    if (!SpatialIndex_check_ready(self) ||
+        !PyArg_ParseTupleAndKeywords(args, kwds, "ddd|O", kwlist, &latitude, &longitude, &radius, &open_arg)) {
+        return NULL;
+    }
+    
+    FHIRSpatialOpenAt open_at;
+    bool filter;
+    if (!spatial_open_at_from_python(open_arg, &open_at, &filter)) {
+        return NULL;
+    }
+    
+    FHIRSpatialResult result;
+    bool ok;
+    PyObject* hits;
+    fhir_spatial_result_init(&result);
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = fhir_spatial_index_within(self->index, latitude, longitude, radius,
+                                   filter ? &open_at : NULL, &result);
+    hits = ok ? spatial_result_to_python(&result) : NULL;
+    FHIR_PY_END_CRITICAL_SECTION();
+    fhir_spatial_result_cleanup(&result);
+    if (!ok) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, "Invalid coordinates or radius");
+    }
+    return hits;
+}
+
+static Py_ssize_t SpatialIndex_length(SpatialIndex* self) {
+    if (!SpatialIndex_check_ready(self)) {
+        return -1;
+    }
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = (Py_ssize_t)fhir_spatial_index_count(self->index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+static PyMethodDef SpatialIndexMethods[] = {
+    {"upsert", (PyCFunction)SpatialIndex_upsert, METH_O,
+     "Index or move a Location (ParsedDocument or JSON text); returns whether it has a position"},
+    {"remove", (PyCFunction)SpatialIndex_remove, METH_VARARGS, "remove(id): drop a Location; returns whether it was indexed"},
+    {"nearest", (PyCFunction)(void (*)(void))SpatialIndex_nearest, METH_VARARGS | METH_KEYWORDS,
+     "nearest(latitude, longitude, k, open_at=None): [(id, meters)] of the k nearest Locations"},
+    {"within", (PyCFunction)(void (*)(void))SpatialIndex_within, METH_VARARGS | METH_KEYWORDS,
+     "within(latitude, longitude, radius, open_at=None): [(id, meters)] within radius meters"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot SpatialIndexSlots[] = {
+    {Py_tp_doc, "Spatial index over Location positions with hours of operation"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, SpatialIndex_init},
+    {Py_tp_dealloc, SpatialIndex_dealloc},
+    {Py_tp_methods, SpatialIndexMethods},
+    {Py_sq_length, SpatialIndex_length},
+    {0, NULL}
+};
+
+static PyType_Spec SpatialIndexSpec = {
+    .name = "fhir_spatial_c.SpatialIndex",
+    .basicsize = sizeof(SpatialIndex),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = SpatialIndexSlots,
+};
+
+static int spatial_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    SpatialModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->spatial_index_type);
+    return 0;
+}
+
+static int spatial_module_clear(PyObject* module) {
+    SpatialModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->spatial_index_type);
+    return 0;
+}
+
+static void spatial_module_free(void* module) {
+    spatial_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int spatial_module_exec(PyObject* module) {
+    SpatialModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+    state->documents = fhir_python_import_documents();
+
+    state->spatial_index_type = fhir_python_add_type(module, &SpatialIndexSpec);
+    return state->spatial_index_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot spatial_module_slots[] = FHIR_PY_MODULE_SLOTS(spatial_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_spatial_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_spatial_c",
+    "Spatial index over Location positions in C",
+    sizeof(SpatialModuleState),
+    NULL,
+    spatial_module_slots,
+    spatial_module_traverse,
+    spatial_module_clear,
+    spatial_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_spatial_c(void) {
+    return PyModuleDef_Init(&fhir_spatial_module);
+}
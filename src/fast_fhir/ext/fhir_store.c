@@ -0,0 +1,552 @@
+/**
+ * @file fhir_store.c
+ * @brief Memory-mapped read-only resource store with a type/id index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FHIR_STORE_HEADER_SIZE 32
+#define FHIR_STORE_ENTRY_SIZE 24
+#define FHIR_STORE_ALIGNMENT 8
+
+typedef struct {
+    FHIRResourceType type;
+    char* id;
+    uint8_t* data;
+    size_t length;
+} FHIRStoreRecord;
+
+struct FHIRStoreBuilder {
+    FHIRStoreRecord* records;
+    size_t count;
+    size_t capacity;
+};
+
+struct FHIRStore {
+    void* mapping;
+    size_t mapping_length;
+    size_t count;
+    const uint8_t* entries;
+    const char* keys;
+    uint64_t key_bytes;
+    const uint8_t* data;
+    uint64_t data_bytes;
+};
+
+/* ========================================================================== */
+/* Byte Order                                                                 */
+/* ========================================================================== */
+
+static void store_u16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void store_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void store_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint16_t load_u16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t load_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint64_t load_u64(const uint8_t* in) {
+    return (uint64_t)load_u32(in) | ((uint64_t)load_u32(in + 4) << 32);
+}
+
+static size_t align_up(size_t value) {
+    return (value + FHIR_STORE_ALIGNMENT - 1) & ~(size_t)(FHIR_STORE_ALIGNMENT - 1);
+}
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+FHIRStoreBuilder* fhir_store_builder_create(void) {
+    FHIRStoreBuilder* builder = fhir_calloc(1, sizeof(FHIRStoreBuilder));
+    if (!builder) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate store builder");
+    }
+    return builder;
+}
+
+void fhir_store_builder_destroy(FHIRStoreBuilder* builder) {
+    if (!builder) return;
+
+    for (size_t i = 0; i < builder->count; i++) {
+        fhir_free(builder->records[i].id);
+        fhir_free(builder->records[i].data);
+    }
+    fhir_free(builder->records);
+    fhir_free(builder);
+}
+
+// Take ownership of an encoded document
+static bool add_record(FHIRStoreBuilder* builder, FHIRResourceType type, const char* id,
+                       uint8_t* data, size_t length) {
+    if (length > UINT32_MAX) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Resource too large for store", id);
+        fhir_free(data);
+        return false;
+    }
+    if (builder->count == builder->capacity) {
+        size_t capacity = builder->capacity ? builder->capacity * 2 : 256;
+        FHIRStoreRecord* records = fhir_realloc(builder->records, capacity * sizeof(FHIRStoreRecord));
+        if (!records) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow store builder");
+            fhir_free(data);
+            return false;
+        }
+        builder->records = records;
+        builder->capacity = capacity;
+    }
+
+    char* id_copy = fhir_strdup(id);
+    if (!id_copy) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to copy resource id");
+        fhir_free(data);
+        return false;
+    }
+
+    FHIRStoreRecord* record = &builder->records[builder->count++];
+    record->type = type;
+    record->id = id_copy;
+    record->data = data;
+    record->length = length;
+    return true;
+}
+
+bool fhir_store_builder_add(FHIRStoreBuilder* builder, const FHIRResourceBase* resource) {
+    if (!builder || !resource) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!resource->id) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "id");
+        return false;
+    }
+
+    size_t length;
+    uint8_t* data = fhir_resource_to_binary(resource, &length);
+    return data && add_record(builder, resource->resource_type, resource->id, data, length);
+}
+
+bool fhir_store_builder_add_json(FHIRStoreBuilder* builder, const cJSON* json) {
+    if (!builder || !cJSON_IsObject(json)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* type_name = fhir_json_get_string(json, "resourceType");
+    FHIRResourceType type = type_name ? fhir_resource_type_from_string(type_name) : FHIR_RESOURCE_TYPE_UNKNOWN;
+    if (type == FHIR_RESOURCE_TYPE_UNKNOWN) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Unknown resource type", type_name);
+        return false;
+    }
+    const char* id = fhir_json_get_string(json, "id");
+    if (!id) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "id");
+        return false;
+    }
+
+    FHIRBinaryWriter writer;
+    uint8_t* data = NULL;
+    size_t length = 0;
+    if (fhir_binary_writer_init(&writer, type, id)) {
+        writer.flags |= FHIR_BINARY_FLAG_JSON;
+        if (fhir_binary_write_json_members(&writer, json)) {
+            data = fhir_binary_writer_finish(&writer, &length);
+        }
+    }
+    fhir_binary_writer_cleanup(&writer);
+    return data && add_record(builder, type, id, data, length);
+}
+
+bool fhir_store_builder_add_ndjson(FHIRStoreBuilder* builder, const char* path,
+                                   const FHIRNDJSONOptions* options, size_t* added) {
+    if (added) *added = 0;
+    if (!builder || !path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FHIRNDJSONOptions reader_options;
+    if (options) {
+        reader_options = *options;
+    } else {
+        fhir_ndjson_options_init(&reader_options);
+        reader_options.validate = false;
+    }
+    reader_options.keep_json = true;
+    reader_options.strict_types = false;
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open(path, &reader_options);
+    if (!reader) return false;
+
+    bool ok = true;
+    FHIRNDJSONResult* results;
+    size_t count;
+    while (ok && (results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            const FHIRNDJSONResult* result = &results[i];
+            if (result->error_code != FHIR_ERROR_NONE || !result->json ||
+                !fhir_json_get_string(result->json, "id")) {
+                continue;
+            }
+            ok = result->resource ? fhir_store_builder_add(builder, result->resource)
+                                  : fhir_store_builder_add_json(builder, result->json);
+            if (!ok) {
+                // Types fhir_resource_type_from_string does not know are skipped
+                const FHIRError* error = fhir_get_last_error();
+                if (error && error->code == FHIR_ERROR_INVALID_RESOURCE_TYPE) {
+                    ok = true;
+                    continue;
+                }
+                break;
+            }
+            if (added) (*added)++;
+        }
+    }
+
+    fhir_ndjson_close(reader);
+    return ok;
+}
+
+size_t fhir_store_builder_get_count(const FHIRStoreBuilder* builder) {
+    return builder ? builder->count : 0;
+}
+
+static int compare_records(const void* a, const void* b) {
+    const FHIRStoreRecord* left = a;
+    const FHIRStoreRecord* right = b;
+    if (left->type != right->type) {
+        return left->type < right->type ? -1 : 1;
+    }
+    return strcmp(left->id, right->id);
+}
+
+static bool write_bytes(FILE* file, const void* data, size_t length) {
+    return length == 0 || fwrite(data, 1, length, file) == length;
+}
+
+bool fhir_store_builder_write(FHIRStoreBuilder* builder, const char* path) {
+    if (!builder || !path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    qsort(builder->records, builder->count, sizeof(FHIRStoreRecord), compare_records);
+
+    // Lay out the keys and documents
+    size_t key_bytes = 0;
+    size_t data_bytes = 0;
+    for (size_t i = 0; i < builder->count; i++) {
+        if (i > 0 && compare_records(&builder->records[i - 1], &builder->records[i]) == 0) {
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Duplicate resource in store",
+                                 builder->records[i].id);
+            return false;
+        }
+        key_bytes += strlen(builder->records[i].id) + 1;
+        data_bytes = align_up(data_bytes) + builder->records[i].length;
+    }
+    if (key_bytes > UINT32_MAX) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Store ids exceed 4 GiB");
+        return false;
+    }
+    size_t index_bytes = FHIR_STORE_HEADER_SIZE + builder->count * FHIR_STORE_ENTRY_SIZE + key_bytes;
+    size_t padding = align_up(index_bytes) - index_bytes;
+
+    uint8_t* index = fhir_malloc(index_bytes + padding);
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate store index");
+        return false;
+    }
+    memset(index, 0, index_bytes + padding);
+
+    memcpy(index, FHIR_STORE_MAGIC, 4);
+    store_u32(index + 4, FHIR_STORE_VERSION);
+    store_u64(index + 8, builder->count);
+    store_u64(index + 16, key_bytes);
+    store_u64(index + 24, data_bytes);
+
+    char* keys = (char*)index + FHIR_STORE_HEADER_SIZE + builder->count * FHIR_STORE_ENTRY_SIZE;
+    size_t key_offset = 0;
+    size_t data_offset = 0;
+    for (size_t i = 0; i < builder->count; i++) {
+        const FHIRStoreRecord* record = &builder->records[i];
+        uint8_t* entry = index + FHIR_STORE_HEADER_SIZE + i * FHIR_STORE_ENTRY_SIZE;
+        data_offset = align_up(data_offset);
+        store_u16(entry, (uint16_t)record->type);
+        store_u32(entry + 4, (uint32_t)key_offset);
+        store_u64(entry + 8, data_offset);
+        store_u32(entry + 16, (uint32_t)record->length);
+
+        size_t id_length = strlen(record->id) + 1;
+        memcpy(keys + key_offset, record->id, id_length);
+        key_offset += id_length;
+        data_offset += record->length;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fhir_free(index);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to create store file", path);
+        return false;
+    }
+
+    static const uint8_t zeros[FHIR_STORE_ALIGNMENT] = {0};
+    bool ok = write_bytes(file, index, index_bytes + padding);
+    fhir_free(index);
+    data_offset = 0;
+    for (size_t i = 0; ok && i < builder->count; i++) {
+        size_t aligned = align_up(data_offset);
+        ok = write_bytes(file, zeros, aligned - data_offset) &&
+             write_bytes(file, builder->records[i].data, builder->records[i].length);
+        data_offset = aligned + builder->records[i].length;
+    }
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to write store file", path);
+    }
+    return ok;
+}
+
+/* ========================================================================== */
+/* Reading                                                                    */
+/* ========================================================================== */
+
+static FHIRStore* store_corrupt(const char* path) {
+    FHIR_SET_FIELD_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed store file", path);
+    return NULL;
+}
+
+// Check the header and section sizes; entries are checked when read
+static FHIRStore* store_from_mapping(const uint8_t* data, size_t length, const char* path) {
+    if (length < FHIR_STORE_HEADER_SIZE || memcmp(data, FHIR_STORE_MAGIC, 4) != 0 ||
+        load_u32(data + 4) != FHIR_STORE_VERSION) {
+        return store_corrupt(path);
+    }
+
+    uint64_t count = load_u64(data + 8);
+    uint64_t key_bytes = load_u64(data + 16);
+    uint64_t data_bytes = load_u64(data + 24);
+    uint64_t available = length - FHIR_STORE_HEADER_SIZE;
+    if (count > available / FHIR_STORE_ENTRY_SIZE ||
+        key_bytes > available - count * FHIR_STORE_ENTRY_SIZE) {
+        return store_corrupt(path);
+    }
+    uint64_t index_bytes = FHIR_STORE_HEADER_SIZE + count * FHIR_STORE_ENTRY_SIZE + key_bytes;
+    uint64_t data_start = align_up((size_t)index_bytes);
+    if (data_start > length || data_bytes > length - data_start ||
+        (count > 0 && (key_bytes == 0 || data[index_bytes - 1] != '\0'))) {
+        return store_corrupt(path);
+    }
+
+    FHIRStore* store = fhir_calloc(1, sizeof(FHIRStore));
+    if (!store) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate store");
+        return NULL;
+    }
+    store->count = (size_t)count;
+    store->entries = data + FHIR_STORE_HEADER_SIZE;
+    store->keys = (const char*)store->entries + count * FHIR_STORE_ENTRY_SIZE;
+    store->key_bytes = key_bytes;
+    store->data = data + data_start;
+    store->data_bytes = data_bytes;
+    return store;
+}
+
+FHIRStore* fhir_store_open(const char* path) {
+    if (!path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Store path is NULL");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to open store file", path);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to stat store file", path);
+        return NULL;
+    }
+
+    size_t length = (size_t)info.st_size;
+    if (length < FHIR_STORE_HEADER_SIZE) {
+        close(fd);
+        return store_corrupt(path);
+    }
+
+    // Shared and read-only: every process mapping the file uses the same pages
+    void* mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_IO, "Failed to map store file", path);
+        return NULL;
+    }
+#ifdef MADV_RANDOM
+    madvise(mapping, length, MADV_RANDOM);
+#endif
+
+    FHIRStore* store = store_from_mapping(mapping, length, path);
+    if (!store) {
+        munmap(mapping, length);
+        return NULL;
+    }
+    store->mapping = mapping;
+    store->mapping_length = length;
+    return store;
+}
+
+void fhir_store_close(FHIRStore* store) {
+    if (!store) return;
+
+    munmap(store->mapping, store->mapping_length);
+    fhir_free(store);
+}
+
+size_t fhir_store_get_count(const FHIRStore* store) {
+    return store ? store->count : 0;
+}
+
+static const char* entry_id(const FHIRStore* store, const uint8_t* entry) {
+    uint32_t offset = load_u32(entry + 4);
+    // The key section ends with a NUL (checked on open), so any in-range offset is terminated
+    return offset < store->key_bytes ? store->keys + offset : NULL;
+}
+
+static bool entry_document(const FHIRStore* store, const uint8_t* entry, FHIRBinaryDocument* document) {
+    uint64_t offset = load_u64(entry + 8);
+    uint32_t length = load_u32(entry + 16);
+    if (offset > store->data_bytes || length > store->data_bytes - offset) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed store entry");
+        return false;
+    }
+    return fhir_binary_open(document, store->data + offset, length);
+}
+
+// Binary search for (type, id); returns the entry or NULL
+static const uint8_t* find_entry(const FHIRStore* store, FHIRResourceType type, const char* id,
+                                 bool* corrupt) {
+    size_t low = 0;
+    size_t high = store->count;
+    *corrupt = false;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const uint8_t* entry = store->entries + middle * FHIR_STORE_ENTRY_SIZE;
+        FHIRResourceType entry_type = (FHIRResourceType)load_u16(entry);
+        int order;
+        if (entry_type != type) {
+            order = entry_type < type ? -1 : 1;
+        } else {
+            const char* key = entry_id(store, entry);
+            if (!key) {
+                *corrupt = true;
+                return NULL;
+            }
+            order = strcmp(key, id);
+        }
+
+        if (order == 0) return entry;
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+bool fhir_store_find(const FHIRStore* store, FHIRResourceType type, const char* id,
+                     FHIRBinaryDocument* document) {
+    if (!store || !id || !document) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    bool corrupt;
+    const uint8_t* entry = find_entry(store, type, id, &corrupt);
+    if (!entry) {
+        if (corrupt) {
+            FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed store entry");
+        } else {
+            fhir_clear_error();
+        }
+        return false;
+    }
+    return entry_document(store, entry, document);
+}
+
+FHIRResourceBase* fhir_store_get(const FHIRStore* store, FHIRResourceType type, const char* id) {
+    FHIRBinaryDocument document;
+    if (!fhir_store_find(store, type, id, &document)) {
+        return NULL;
+    }
+    return fhir_resource_from_binary(document.data, document.size);
+}
+
+cJSON* fhir_store_get_json(const FHIRStore* store, FHIRResourceType type, const char* id) {
+    FHIRBinaryDocument document;
+    if (!fhir_store_find(store, type, id, &document)) {
+        return NULL;
+    }
+    if (document.flags & FHIR_BINARY_FLAG_JSON) {
+        return fhir_binary_to_json(&document);
+    }
+
+    FHIRResourceBase* resource = fhir_resource_from_binary(document.data, document.size);
+    if (!resource) {
+        return NULL;
+    }
+    cJSON* json = fhir_resource_to_json(resource);
+    fhir_resource_release(resource);
+    return json;
+}
+
+bool fhir_store_get_entry(const FHIRStore* store, size_t index, FHIRResourceType* type,
+                          const char** id, FHIRBinaryDocument* document) {
+    if (!store || index >= store->count) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Store entry index out of range");
+        return false;
+    }
+
+    const uint8_t* entry = store->entries + index * FHIR_STORE_ENTRY_SIZE;
+    const char* key = entry_id(store, entry);
+    if (!key) {
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Malformed store entry");
+        return false;
+    }
+    if (document && !entry_document(store, entry, document)) {
+        return false;
+    }
+    if (type) *type = (FHIRResourceType)load_u16(entry);
+    if (id) *id = key;
+    return true;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file fhir_store.h
+ * @brief Memory-mapped read-only resource store with a type/id index
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * A store file is built once (e.g. offline from a Bulk Data export) and
+ * opened read-only by any number of processes. Opening maps the file and
+ * checks its header, so it costs the same for ten resources or ten million;
+ * the mapping is MAP_SHARED, so forked workers share one copy through the
+ * page cache.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header    "FHRS", version u32, entry count u64, key bytes u64, data bytes u64
+ *   entries   24 bytes each, sorted by (resource type, id): resource type u16,
+ *             reserved u16, key offset u32, document offset u64,
+ *             document length u32, reserved u32
+ *   keys      NUL-terminated ids
+ *   data      binary documents (common/fhir_binary.h), 8-byte aligned
+ *
+ * Lookups binary-search the entries and decode only the resource asked for.
+ */
+
+#ifndef FHIR_STORE_H
+#define FHIR_STORE_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_resource_base.h"
+#include "common/fhir_binary.h"
+#include "fhir_ndjson.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FHIR_STORE_MAGIC "FHRS"
+#define FHIR_STORE_VERSION 1
+
+/**
+ * @brief Opaque store builder
+ */
+typedef struct FHIRStoreBuilder FHIRStoreBuilder;
+
+/**
+ * @brief Opaque read-only store
+ */
+typedef struct FHIRStore FHIRStore;
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty builder
+ * @return New builder or NULL on failure
+ */
+FHIRStoreBuilder* fhir_store_builder_create(void);
+
+/**
+ * @brief Destroy a builder and the documents it holds
+ * @param builder Builder to destroy (can be NULL)
+ */
+void fhir_store_builder_destroy(FHIRStoreBuilder* builder);
+
+/**
+ * @brief Add a typed resource
+ * @param builder Builder instance
+ * @param resource Resource with an id (encoded now, so it can be released)
+ * @return true on success, false on failure
+ */
+bool fhir_store_builder_add(FHIRStoreBuilder* builder, const FHIRResourceBase* resource);
+
+/**
+ * @brief Add a resource from its JSON
+ *
+ * Works for any resource type, registered or not: the JSON tree is stored
+ * with FHIR_BINARY_FLAG_JSON.
+ *
+ * @param builder Builder instance
+ * @param json Resource JSON object with resourceType and id
+ * @return true on success, false on failure
+ */
+bool fhir_store_builder_add_json(FHIRStoreBuilder* builder, const cJSON* json);
+
+/**
+ * @brief Add every resource of an NDJSON file
+ *
+ * Registered types use their binary codec, others their JSON tree. Lines
+ * that fail to parse or have no id are skipped.
+ *
+ * @param builder Builder instance
+ * @param path NDJSON file path
+ * @param options Reader options (NULL for defaults without validation)
+ * @param added Output number of resources added (can be NULL)
+ * @return true on success, false if the file cannot be read or memory runs out
+ */
+bool fhir_store_builder_add_ndjson(FHIRStoreBuilder* builder, const char* path,
+                                   const FHIRNDJSONOptions* options, size_t* added);
+
+/**
+ * @brief Get the number of resources added
+ * @param builder Builder instance
+ * @return Number of resources
+ */
+size_t fhir_store_builder_get_count(const FHIRStoreBuilder* builder);
+
+/**
+ * @brief Sort the resources and write the store file
+ * @param builder Builder instance
+ * @param path Output file path (replaced if it exists)
+ * @return true on success, false on failure (FHIR_ERROR_INVALID_ARGUMENT if
+ *         two resources share a type and id, FHIR_ERROR_IO)
+ */
+bool fhir_store_builder_write(FHIRStoreBuilder* builder, const char* path);
+
+/* ========================================================================== */
+/* Reading                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Map a store file
+ * @param path Store file path
+ * @return Store or NULL on failure (FHIR_ERROR_IO, FHIR_ERROR_PARSE_FAILED)
+ */
+FHIRStore* fhir_store_open(const char* path);
+
+/**
+ * @brief Unmap a store
+ *
+ * Documents and ids returned by the store become invalid; resources from
+ * fhir_store_get are independent copies and stay valid.
+ *
+ * @param store Store to close (can be NULL)
+ */
+void fhir_store_close(FHIRStore* store);
+
+/**
+ * @brief Get the number of resources
+ * @param store Store instance
+ * @return Number of resources
+ */
+size_t fhir_store_get_count(const FHIRStore* store);
+
+/**
+ * @brief Find the encoded document of a resource without decoding it
+ * @param store Store instance
+ * @param type Resource type
+ * @param id Resource id
+ * @param document Output view into the mapping
+ * @return true if found, false otherwise (FHIR_ERROR_PARSE_FAILED if the
+ *         store is corrupt, no error if the resource is absent)
+ */
+bool fhir_store_find(const FHIRStore* store, FHIRResourceType type, const char* id,
+                     FHIRBinaryDocument* document);
+
+/**
+ * @brief Decode a resource
+ * @param store Store instance
+ * @param type Resource type (must be registered)
+ * @param id Resource id
+ * @return New resource (release with fhir_resource_release) or NULL if absent
+ *         or on failure
+ */
+FHIRResourceBase* fhir_store_get(const FHIRStore* store, FHIRResourceType type, const char* id);
+
+/**
+ * @brief Decode a resource as JSON
+ *
+ * Works for unregistered types stored with fhir_store_builder_add_json.
+ *
+ * @param store Store instance
+ * @param type Resource type
+ * @param id Resource id
+ * @return JSON object (caller must cJSON_Delete) or NULL if absent or on failure
+ */
+cJSON* fhir_store_get_json(const FHIRStore* store, FHIRResourceType type, const char* id);
+
+/**
+ * @brief Read an entry by position (entries are sorted by type, then id)
+ * @param store Store instance
+ * @param index Entry index (< fhir_store_get_count)
+ * @param type Output resource type (can be NULL)
+ * @param id Output id inside the mapping (can be NULL)
+ * @param document Output view into the mapping (can be NULL)
+ * @return true on success, false if index is out of range or the entry is corrupt
+ */
+bool fhir_store_get_entry(const FHIRStore* store, size_t index, FHIRResourceType* type,
+                          const char** id, FHIRBinaryDocument* document);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_STORE_H */
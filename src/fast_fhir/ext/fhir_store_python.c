@@ -0,0 +1,585 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_store.h"
+#include "fhir_batch.h"
+#include "fhir_python_json.h"
+#include "resources/fhir_patient.h"
+#include "common/fhir_binary.h"
+#include "common/fhir_json_reader.h"
+#include <string.h>
+
+// Python wrapper for the memory-mapped resource store and shared resource batches
+
+typedef struct {
+    PyObject_HEAD
+    FHIRStore* store;
+} ResourceStore;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* store_type;
+    PyTypeObject* shared_batch_type;
+    FHIRPythonKeyCache keys;
+} StoreModuleState;
+
+static struct PyModuleDef fhir_store_module;
+
+static PyObject* set_store_error(const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+    if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+        return PyErr_NoMemory();
+    }
+    PyErr_SetString(error && error->code == FHIR_ERROR_IO ? PyExc_OSError : PyExc_ValueError,
+                    error && error->message ? error->message : fallback);
+    return NULL;
+}
+
+static int ResourceStore_init(ResourceStore* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"path", NULL};
+    PyObject* path = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", kwlist, PyUnicode_FSConverter, &path)) {
+        return -1;
+    }
+
+    FHIRStore* store;
+    Py_BEGIN_ALLOW_THREADS
+    store = fhir_store_open(PyBytes_AS_STRING(path));
+    Py_END_ALLOW_THREADS
+    Py_DECREF(path);
+    if (!store) {
+        set_store_error("Failed to open resource store");
+        return -1;
+    }
+
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_store_close(self->store);
+    self->store = store;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void ResourceStore_dealloc(ResourceStore* self) {
+    fhir_store_close(self->store);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static bool check_open(const ResourceStore* self) {
+    if (!self->store) {
+        PyErr_SetString(PyExc_ValueError, "Resource store is closed");
+        return false;
+    }
+    return true;
+}
+
+static PyObject* ResourceStore_get(ResourceStore* self, PyObject* args) {
+    const char* type_name;
+    const char* id;
+    if (!PyArg_ParseTuple(args, "ss", &type_name, &id)) {
+        return NULL;
+    }
+
+    StoreModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_store_module);
+    if (!state) {
+        return NULL;
+    }
+    FHIRResourceType type = fhir_resource_type_from_string(type_name);
+    if (type == FHIR_RESOURCE_TYPE_UNKNOWN) {
+        PyErr_Format(PyExc_ValueError, "Unknown resource type: %s", type_name);
+        return NULL;
+    }
+
+    // The store stays mapped while it is read; close() waits for the section
+    bool open;
+    cJSON* json = NULL;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    open = check_open(self);
+    if (open) {
+        json = fhir_store_get_json(self->store, type, id);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (!open) {
+        return NULL;
+    }
+    if (!json) {
+        if (fhir_get_last_error()) {
+            return set_store_error("Failed to decode resource");
+        }
+        Py_RETURN_NONE;
+    }
+    PyObject* result = fhir_cjson_to_python_cached(json, &state->keys);
+    cJSON_Delete(json);
+    return result;
+}
+
+static PyObject* ResourceStore_close(ResourceStore* self, PyObject* Py_UNUSED(ignored)) {
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_store_close(self->store);
+    self->store = NULL;
+    FHIR_PY_END_CRITICAL_SECTION();
+    Py_RETURN_NONE;
+}
+
+static Py_ssize_t ResourceStore_length(ResourceStore* self) {
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = (Py_ssize_t)fhir_store_get_count(self->store);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+static PyMethodDef ResourceStoreMethods[] = {
+    {"get", (PyCFunction)ResourceStore_get, METH_VARARGS,
+     "Decode (resource_type, id) to a dict, or None if absent"},
+    {"close", (PyCFunction)ResourceStore_close, METH_NOARGS, "Unmap the store file"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot ResourceStoreSlots[] = {
+    {Py_tp_doc, "Read-only resource store file, memory-mapped and shared across processes"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, ResourceStore_init},
+    {Py_tp_dealloc, ResourceStore_dealloc},
+    {Py_tp_methods, ResourceStoreMethods},
+    {Py_sq_length, ResourceStore_length},
+    {0, NULL}
+};
+
+static PyType_Spec ResourceStoreSpec = {
+    .name = "fhir_store_c.ResourceStore",
+    .basicsize = sizeof(ResourceStore),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = ResourceStoreSlots,
+};
+
+// Build a store file from an NDJSON file (runs without the GIL)
+static PyObject* py_build(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"path", "source", "threads", NULL};
+    PyObject* path = NULL;
+    PyObject* source = NULL;
+    Py_ssize_t threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&|n", kwlist, PyUnicode_FSConverter, &path,
+                                     PyUnicode_FSConverter, &source, &threads)) {
+        Py_XDECREF(path);
+        return NULL;
+    }
+    if (threads < 0) {
+        Py_DECREF(path);
+        Py_DECREF(source);
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 0");
+        return NULL;
+    }
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = (size_t)threads;
+    options.validate = false;
+
+    bool ok = false;
+    size_t added = 0;
+    Py_BEGIN_ALLOW_THREADS
+    FHIRStoreBuilder* builder = fhir_store_builder_create();
+    if (builder) {
+        ok = fhir_store_builder_add_ndjson(builder, PyBytes_AS_STRING(source), &options, &added) &&
+             fhir_store_builder_write(builder, PyBytes_AS_STRING(path));
+        fhir_store_builder_destroy(builder);
+    }
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(path);
+    Py_DECREF(source);
+    if (!ok) {
+        return set_store_error("Failed to build resource store");
+    }
+    return PyLong_FromSize_t(added);
+}
+
+// SharedBatch: a batch of resources (fhir_batch.h) read in place from a
+// buffer, typically a multiprocessing.shared_memory segment written by
+// another process. Opening copies nothing; each resource is decoded on first
+// access and cached, by the batch's loader if it has one (such as
+// fhir_lazy_c.lazy_from_binary, for LazyResources) and to a dict otherwise.
+// The buffer stays exported until release(), so the segment cannot be closed
+// while the batch is open.
+typedef struct {
+    PyObject_HEAD
+    Py_buffer view;     // view.obj is NULL once released
+    FHIRBatch batch;
+    Py_ssize_t length;
+    PyObject* loader;   // Called with the bytes of each binary document, or NULL
+    PyObject** items;   // Decoded resources by index (NULL until read)
+} SharedBatch;
+
+static void SharedBatch_release_locked(SharedBatch* self) {
+    if (self->items) {
+        for (Py_ssize_t i = 0; i < self->length; i++) {
+            Py_XDECREF(self->items[i]);
+        }
+        PyMem_Free(self->items);
+        self->items = NULL;
+    }
+    if (self->view.obj) {
+        PyBuffer_Release(&self->view);
+    }
+    self->length = 0;
+}
+
+static void SharedBatch_dealloc(SharedBatch* self) {
+    SharedBatch_release_locked(self);
+    Py_XDECREF(self->loader);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static bool SharedBatch_check_open(const SharedBatch* self) {
+    if (self->view.obj == NULL) {
+        PyErr_SetString(PyExc_ValueError, "SharedBatch is released");
+        return false;
+    }
+    return true;
+}
+
+static Py_ssize_t SharedBatch_length(SharedBatch* self) {
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = self->length;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+// Decode one document with the loader, or to a dict
+static PyObject* SharedBatch_decode(SharedBatch* self, Py_ssize_t index) {
+    if (self->loader) {
+        FHIRBinaryDocument document;
+        if (!fhir_batch_get(&self->batch, (size_t)index, &document)) {
+            return set_store_error("Malformed batch entry");
+        }
+        // The loader gets a copy, so nothing it keeps points into the buffer
+        PyObject* data = PyBytes_FromStringAndSize((const char*)document.data, (Py_ssize_t)document.size);
+        if (data == NULL) {
+            return NULL;
+        }
+        PyObject* item = PyObject_CallFunctionObjArgs(self->loader, data, NULL);
+        Py_DECREF(data);
+        return item;
+    }
+    
+    StoreModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_store_module);
+    if (!state) {
+        return NULL;
+    }
+    cJSON* json = fhir_batch_get_json(&self->batch, (size_t)index);
+    if (json == NULL) {
+        return set_store_error("Malformed batch entry");
+    }
+    PyObject* item = fhir_cjson_to_python_cached(json, &state->keys);
+    cJSON_Delete(json);
+    return item;
+}
+
+static PyObject* SharedBatch_item_locked(SharedBatch* self, Py_ssize_t index) {
+    if (!SharedBatch_check_open(self)) {
+        return NULL;
+    }
+    if (index < 0 || index >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "batch index out of range");
+        return NULL;
+    }
+    if (self->items == NULL) {
+        self->items = PyMem_Calloc((size_t)self->length, sizeof(PyObject*));
+        if (self->items == NULL) {
+            return PyErr_NoMemory();
+        }
+    }
+    if (self->items[index] == NULL) {
+        self->items[index] = SharedBatch_decode(self, index);
+        if (self->items[index] == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(self->items[index]);
+    return self->items[index];
+}
+
+static PyObject* SharedBatch_item(SharedBatch* self, Py_ssize_t index) {
+    PyObject* item;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    item = SharedBatch_item_locked(self, index);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return item;
+}
+
+// Read the id from the document header without decoding the resource
+static PyObject* SharedBatch_id(SharedBatch* self, PyObject* arg) {
+    Py_ssize_t index = PyNumber_AsSsize_t(arg, PyExc_IndexError);
+    if (index == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+    
+    PyObject* result = NULL;
+    bool ok;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    if (index < 0) {
+        index += self->length;
+    }
+    FHIRBinaryDocument document;
+    ok = SharedBatch_check_open(self);
+    if (ok && (index < 0 || index >= self->length)) {
+        PyErr_SetString(PyExc_IndexError, "batch index out of range");
+        ok = false;
+    }
+    if (ok && !fhir_batch_get(&self->batch, (size_t)index, &document)) {
+        set_store_error("Malformed batch entry");
+        ok = false;
+    }
+    // The id points into the buffer, so it is copied before the section ends
+    if (ok) {
+        const char* id = fhir_binary_get_id(&document);
+        if (id) {
+            result = PyUnicode_FromString(id);
+        } else {
+            Py_INCREF(Py_None);
+            result = Py_None;
+        }
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* SharedBatch_release(SharedBatch* self, PyObject* Py_UNUSED(ignored)) {
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    SharedBatch_release_locked(self);
+    FHIR_PY_END_CRITICAL_SECTION();
+    Py_RETURN_NONE;
+}
+
+static PyObject* SharedBatch_enter(SharedBatch* self, PyObject* Py_UNUSED(ignored)) {
+    Py_INCREF(self);
+    return (PyObject*)self;
+}
+
+static PyObject* SharedBatch_exit(SharedBatch* self, PyObject* Py_UNUSED(args)) {
+    return SharedBatch_release(self, NULL);
+}
+
+static PyObject* SharedBatch_repr(SharedBatch* self) {
+    return PyUnicode_FromFormat("<SharedBatch of %zd resources>", SharedBatch_length(self));
+}
+
+static PyMethodDef SharedBatchMethods[] = {
+    {"id", (PyCFunction)SharedBatch_id, METH_O, "Id of the resource at an index (None if absent), without decoding it"},
+    {"release", (PyCFunction)SharedBatch_release, METH_NOARGS,
+     "Drop the cached resources and release the buffer (decoded resources stay valid)"},
+    {"__enter__", (PyCFunction)SharedBatch_enter, METH_NOARGS, NULL},
+    {"__exit__", (PyCFunction)SharedBatch_exit, METH_VARARGS, NULL},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot SharedBatchSlots[] = {
+    {Py_tp_doc, "Batch of resources read in place from a buffer; items are decoded on first access"},
+    {Py_tp_dealloc, SharedBatch_dealloc},
+    {Py_tp_repr, SharedBatch_repr},
+    {Py_tp_methods, SharedBatchMethods},
+    {Py_sq_length, SharedBatch_length},
+    {Py_sq_item, SharedBatch_item},
+    {0, NULL}
+};
+
+static PyType_Spec SharedBatchSpec = {
+    .name = "fhir_store_c.SharedBatch",
+    .basicsize = sizeof(SharedBatch),
+    .flags = Py_TPFLAGS_DEFAULT | FHIR_PY_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = SharedBatchSlots,
+};
+
+// Open a batch in place; the buffer is held until the batch is released
+static PyObject* open_batch(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"buffer", "loader", NULL};
+    PyObject* buffer;
+    PyObject* loader = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", kwlist, &buffer, &loader)) {
+        return NULL;
+    }
+    if (loader != Py_None && !PyCallable_Check(loader)) {
+        PyErr_SetString(PyExc_TypeError, "loader must be callable or None");
+        return NULL;
+    }
+    
+    StoreModuleState* state = PyModule_GetState(self);
+    SharedBatch* batch = PyObject_New(SharedBatch, state->shared_batch_type);
+    if (batch == NULL) {
+        return NULL;
+    }
+    batch->view.obj = NULL;
+    batch->length = 0;
+    batch->items = NULL;
+    batch->loader = NULL;
+    if (loader != Py_None) {
+        Py_INCREF(loader);
+        batch->loader = loader;
+    }
+    
+    if (PyObject_GetBuffer(buffer, &batch->view, PyBUF_SIMPLE) < 0) {
+        Py_DECREF(batch);
+        return NULL;
+    }
+    if (!fhir_batch_open(&batch->batch, batch->view.buf, (size_t)batch->view.len)) {
+        Py_DECREF(batch);
+        return set_store_error("Malformed batch");
+    }
+    batch->length = (Py_ssize_t)fhir_batch_get_count(&batch->batch);
+    return (PyObject*)batch;
+}
+
+// Add one resource to a batch writer: a binary document or JSON text
+static bool batch_add(FHIRBatchWriter* writer, PyObject* resource) {
+    Py_buffer view;
+    if (!fhir_python_buffer_arg(resource, &view)) {
+        return false;
+    }
+    
+    bool ok;
+    size_t magic_length = sizeof(FHIR_BINARY_MAGIC) - 1;
+    if ((size_t)view.len >= magic_length && memcmp(view.buf, FHIR_BINARY_MAGIC, magic_length) == 0) {
+        ok = fhir_batch_writer_add(writer, view.buf, (size_t)view.len);
+        if (!ok) {
+            set_store_error("Invalid binary resource");
+        }
+    } else {
+        cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+        ok = cJSON_IsObject(json);
+        if (!ok) {
+            PyErr_SetString(PyExc_ValueError, json ? "JSON is not an object" : "Invalid JSON");
+        } else if (!(ok = fhir_batch_writer_add_json(writer, json))) {
+            set_store_error("Failed to encode resource");
+        }
+        cJSON_Delete(json);
+    }
+    PyBuffer_Release(&view);
+    return ok;
+}
+
+// Encode resources into a batch, as bytes or into a writable buffer
+static PyObject* export_batch(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"resources", "buffer", NULL};
+    PyObject* resources;
+    PyObject* buffer = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", kwlist, &resources, &buffer)) {
+        return NULL;
+    }
+    
+    PyObject* iterator = PyObject_GetIter(resources);
+    if (iterator == NULL) {
+        return NULL;
+    }
+    FHIRBatchWriter* writer = fhir_batch_writer_create();
+    if (writer == NULL) {
+        Py_DECREF(iterator);
+        return PyErr_NoMemory();
+    }
+    
+    bool ok = true;
+    PyObject* resource;
+    while (ok && (resource = PyIter_Next(iterator)) != NULL) {
+        ok = batch_add(writer, resource);
+        Py_DECREF(resource);
+    }
+    Py_DECREF(iterator);
+    if (!ok || PyErr_Occurred()) {
+        fhir_batch_writer_destroy(writer);
+        return NULL;
+    }
+    
+    size_t size = fhir_batch_writer_get_size(writer);
+    PyObject* result = NULL;
+    if (buffer == Py_None) {
+        result = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)size);
+        if (result) {
+            fhir_batch_writer_write(writer, PyBytes_AS_STRING(result), size);
+        }
+    } else {
+        Py_buffer view;
+        if (PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE) == 0) {
+            if ((size_t)view.len < size) {
+                PyErr_Format(PyExc_ValueError, "Buffer of %zd bytes is too small for a batch of %zu bytes",
+                             view.len, size);
+            } else {
+                fhir_batch_writer_write(writer, view.buf, (size_t)view.len);
+                result = PyLong_FromSize_t(size);
+            }
+            PyBuffer_Release(&view);
+        }
+    }
+    fhir_batch_writer_destroy(writer);
+    return result;
+}
+
+static PyMethodDef StoreModuleMethods[] = {
+    {"build", (PyCFunction)py_build, METH_VARARGS | METH_KEYWORDS,
+     "Write a store file holding every resource with an id in an NDJSON file; returns the count"},
+    {"export_batch", (PyCFunction)(void (*)(void))export_batch, METH_VARARGS | METH_KEYWORDS,
+     "Encode resources into a batch; returns bytes, or the size written into a writable buffer"},
+    {"open_batch", (PyCFunction)(void (*)(void))open_batch, METH_VARARGS | METH_KEYWORDS,
+     "Open a batch in place as a SharedBatch, decoding items with loader(data) or to dicts"},
+    {NULL, NULL, 0, NULL}
+};
+
+static int store_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    StoreModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->store_type);
+    Py_VISIT(state->shared_batch_type);
+    return 0;
+}
+
+static int store_module_clear(PyObject* module) {
+    StoreModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->store_type);
+    Py_CLEAR(state->shared_batch_type);
+    fhir_python_key_cache_clear(&state->keys);
+    return 0;
+}
+
+static void store_module_free(void* module) {
+    store_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int store_module_exec(PyObject* module) {
+    StoreModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    // Register the typed resources with binary codecs (once per process)
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+    fhir_clear_error();
+
+    state->store_type = fhir_python_add_type(module, &ResourceStoreSpec);
+    if (!state->store_type) {
+        return -1;
+    }
+    state->shared_batch_type = fhir_python_add_type(module, &SharedBatchSpec);
+    return state->shared_batch_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot store_module_slots[] = FHIR_PY_MODULE_SLOTS(store_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_store_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_store_c",
+    "Memory-mapped FHIR resource store in C",
+    sizeof(StoreModuleState),
+    StoreModuleMethods,
+    store_module_slots,
+    store_module_traverse,
+    store_module_clear,
+    store_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_store_c(void) {
+    return PyModuleDef_Init(&fhir_store_module);
+}
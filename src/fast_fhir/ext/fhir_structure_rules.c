@@ -0,0 +1,860 @@
+/**
+ * @file fhir_structure_rules.c
+ * @brief Table-driven structural validation of parsed FHIR resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_structure_rules.h"
+#include "common/fhir_json_reader.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MEMBER(name, kind, flags) { name, kind, flags, NULL, NULL }
+#define CODE(name, flags, codes) { name, FHIR_MEMBER_CODE, flags, codes, NULL }
+#define ELEMENT(name, flags, element) { name, FHIR_MEMBER_OBJECT, flags, NULL, &element }
+#define RULES(members) { members, sizeof(members) / sizeof(members[0]) }
+
+// Documents a batch worker claims at a time
+#define FHIR_STRUCTURE_BATCH_CLAIM_SIZE 64
+
+#define REQUIRED FHIR_MEMBER_REQUIRED
+#define REPEATS FHIR_MEMBER_REPEATS
+
+/* ========================================================================== */
+/* Value Sets                                                                 */
+/* ========================================================================== */
+
+static const char* const g_request_status[] = {
+    "draft", "active", "on-hold", "revoked", "completed", "entered-in-error", "unknown", NULL
+};
+static const char* const g_request_intent[] = {
+    "proposal", "plan", "directive", "order", "original-order", "reflex-order",
+    "filler-order", "instance-order", "option", NULL
+};
+static const char* const g_care_plan_intent[] = {
+    "proposal", "plan", "order", "option", "directive", NULL
+};
+static const char* const g_care_plan_activity_status[] = {
+    "not-started", "scheduled", "in-progress", "on-hold", "completed", "cancelled",
+    "stopped", "unknown", "entered-in-error", NULL
+};
+static const char* const g_care_team_status[] = {
+    "proposed", "active", "suspended", "inactive", "entered-in-error", NULL
+};
+static const char* const g_goal_lifecycle_status[] = {
+    "proposed", "planned", "accepted", "active", "on-hold", "completed", "cancelled",
+    "entered-in-error", "rejected", NULL
+};
+static const char* const g_request_priority[] = {
+    "routine", "urgent", "asap", "stat", NULL
+};
+static const char* const g_observation_status[] = {
+    "registered", "preliminary", "final", "amended", "corrected", "cancelled",
+    "entered-in-error", "unknown", NULL
+};
+static const char* const g_financial_status[] = {
+    "active", "cancelled", "draft", "entered-in-error", NULL
+};
+static const char* const g_vision_eye[] = { "right", "left", NULL };
+static const char* const g_vision_base[] = { "up", "down", "in", "out", NULL };
+static const char* const g_administrative_gender[] = {
+    "male", "female", "other", "unknown", NULL
+};
+static const char* const g_encounter_status[] = {
+    "planned", "in-progress", "on-hold", "discharged", "completed", "cancelled",
+    "discontinued", "entered-in-error", "unknown", NULL
+};
+static const char* const g_group_type[] = {
+    "person", "animal", "practitioner", "device", "medication", "substance", NULL
+};
+static const char* const g_group_membership[] = { "definitional", "enumerated", NULL };
+static const char* const g_location_status[] = { "active", "suspended", "inactive", NULL };
+static const char* const g_location_mode[] = { "instance", "kind", NULL };
+static const char* const g_endpoint_status[] = {
+    "active", "suspended", "error", "off", "entered-in-error", "test", NULL
+};
+static const char* const g_device_status[] = {
+    "active", "inactive", "entered-in-error", "unknown", NULL
+};
+
+/* ========================================================================== */
+/* Care Provision Rules                                                       */
+/* ========================================================================== */
+
+static const FHIRMemberRule g_care_plan_activity_detail_members[] = {
+    CODE("status", REQUIRED, g_care_plan_activity_status),
+    MEMBER("code", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("description", FHIR_MEMBER_STRING, 0),
+};
+static const FHIRElementRules g_care_plan_activity_detail = RULES(g_care_plan_activity_detail_members);
+
+static const FHIRMemberRule g_care_plan_activity_members[] = {
+    ELEMENT("detail", 0, g_care_plan_activity_detail),
+};
+static const FHIRElementRules g_care_plan_activity = RULES(g_care_plan_activity_members);
+
+static const FHIRMemberRule g_care_plan_members[] = {
+    CODE("status", REQUIRED, g_request_status),
+    CODE("intent", REQUIRED, g_care_plan_intent),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("title", FHIR_MEMBER_STRING, 0),
+    MEMBER("description", FHIR_MEMBER_STRING, 0),
+    MEMBER("encounter", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("period", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("created", FHIR_MEMBER_STRING, 0),
+    MEMBER("author", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("contributor", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("careTeam", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("addresses", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("goal", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+    ELEMENT("activity", REPEATS, g_care_plan_activity),
+};
+
+static const FHIRMemberRule g_care_team_participant_members[] = {
+    MEMBER("member", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("onBehalfOf", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("coveragePeriod", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("role", FHIR_MEMBER_OBJECT, REPEATS),
+};
+static const FHIRElementRules g_care_team_participant = RULES(g_care_team_participant_members);
+
+static const FHIRMemberRule g_care_team_members[] = {
+    CODE("status", 0, g_care_team_status),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("period", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonCode", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonReference", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("managingOrganization", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("telecom", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+    ELEMENT("participant", REPEATS, g_care_team_participant),
+};
+
+static const FHIRMemberRule g_goal_target_members[] = {
+    MEMBER("measure", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("dueDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("detailQuantity", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("detailRange", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("detailCodeableConcept", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("detailString", FHIR_MEMBER_STRING, 0),
+    MEMBER("detailBoolean", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("detailInteger", FHIR_MEMBER_INTEGER, 0),
+};
+static const FHIRElementRules g_goal_target = RULES(g_goal_target_members);
+
+static const FHIRMemberRule g_goal_members[] = {
+    CODE("lifecycleStatus", REQUIRED, g_goal_lifecycle_status),
+    MEMBER("description", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("achievementStatus", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("priority", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("startDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("startCodeableConcept", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("statusDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("statusReason", FHIR_MEMBER_STRING, 0),
+    MEMBER("expressedBy", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("addresses", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("outcomeCode", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("outcomeReference", FHIR_MEMBER_OBJECT, REPEATS),
+    ELEMENT("target", REPEATS, g_goal_target),
+};
+
+static const FHIRMemberRule g_service_request_members[] = {
+    CODE("status", REQUIRED, g_request_status),
+    CODE("intent", REQUIRED, g_request_intent),
+    CODE("priority", 0, g_request_priority),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("code", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("encounter", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("occurrenceDateTime", FHIR_MEMBER_STRING, 0),
+    MEMBER("occurrencePeriod", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("occurrenceTiming", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("authoredOn", FHIR_MEMBER_STRING, 0),
+    MEMBER("requester", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("performerType", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("doNotPerform", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("patientInstruction", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("performer", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonCode", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonReference", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_nutrition_order_members[] = {
+    CODE("status", REQUIRED, g_request_status),
+    CODE("intent", REQUIRED, g_request_intent),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("encounter", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("dateTime", FHIR_MEMBER_STRING, 0),
+    MEMBER("orderer", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("priority", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("outsideFoodAllowed", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("performer", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("allergyIntolerance", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("foodPreferenceModifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("excludeFoodModifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_risk_assessment_prediction_members[] = {
+    MEMBER("outcome", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("probabilityDecimal", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("probabilityRange", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("qualitativeRisk", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("relativeRisk", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("rationale", FHIR_MEMBER_STRING, 0),
+};
+static const FHIRElementRules g_risk_assessment_prediction = RULES(g_risk_assessment_prediction_members);
+
+static const FHIRMemberRule g_risk_assessment_members[] = {
+    CODE("status", REQUIRED, g_observation_status),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("basedOn", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("parent", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("method", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("code", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("encounter", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("occurrenceDateTime", FHIR_MEMBER_STRING, 0),
+    MEMBER("occurrencePeriod", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("condition", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("performer", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("mitigation", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonCode", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("reasonReference", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("basis", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+    ELEMENT("prediction", REPEATS, g_risk_assessment_prediction),
+};
+
+static const FHIRMemberRule g_vision_prism_members[] = {
+    MEMBER("amount", FHIR_MEMBER_DECIMAL, 0),
+    CODE("base", 0, g_vision_base),
+};
+static const FHIRElementRules g_vision_prism = RULES(g_vision_prism_members);
+
+static const FHIRMemberRule g_vision_lens_members[] = {
+    MEMBER("product", FHIR_MEMBER_OBJECT, 0),
+    CODE("eye", 0, g_vision_eye),
+    MEMBER("sphere", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("cylinder", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("axis", FHIR_MEMBER_INTEGER, 0),
+    MEMBER("add", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("power", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("backCurve", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("diameter", FHIR_MEMBER_DECIMAL, 0),
+    MEMBER("color", FHIR_MEMBER_STRING, 0),
+    MEMBER("brand", FHIR_MEMBER_STRING, 0),
+    ELEMENT("prism", REPEATS, g_vision_prism),
+};
+static const FHIRElementRules g_vision_lens = RULES(g_vision_lens_members);
+
+static const FHIRMemberRule g_vision_prescription_members[] = {
+    CODE("status", REQUIRED, g_financial_status),
+    MEMBER("patient", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("prescriber", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("created", FHIR_MEMBER_STRING, 0),
+    MEMBER("encounter", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("dateWritten", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    ELEMENT("lensSpecification", REPEATS, g_vision_lens),
+};
+
+/* ========================================================================== */
+/* Foundation Rules                                                           */
+/* ========================================================================== */
+
+static const FHIRMemberRule g_patient_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    CODE("gender", 0, g_administrative_gender),
+    MEMBER("birthDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("name", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("telecom", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("address", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_practitioner_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    CODE("gender", 0, g_administrative_gender),
+    MEMBER("birthDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("name", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("telecom", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("qualification", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_practitioner_role_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("practitioner", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("organization", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("code", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("specialty", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_encounter_members[] = {
+    CODE("status", REQUIRED, g_encounter_status),
+    MEMBER("subject", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("period", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("participant", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_person_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    CODE("gender", 0, g_administrative_gender),
+    MEMBER("birthDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("name", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("link", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_related_person_members[] = {
+    MEMBER("patient", FHIR_MEMBER_OBJECT, REQUIRED),
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    CODE("gender", 0, g_administrative_gender),
+    MEMBER("birthDate", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("relationship", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("name", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_group_members[] = {
+    CODE("type", REQUIRED, g_group_type),
+    CODE("membership", REQUIRED, g_group_membership),
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("quantity", FHIR_MEMBER_INTEGER, 0),
+    MEMBER("characteristic", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("member", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+/* ========================================================================== */
+/* Entities Rules                                                             */
+/* ========================================================================== */
+
+static const FHIRMemberRule g_organization_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("partOf", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("type", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("telecom", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("address", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_location_position_members[] = {
+    MEMBER("longitude", FHIR_MEMBER_DECIMAL, REQUIRED),
+    MEMBER("latitude", FHIR_MEMBER_DECIMAL, REQUIRED),
+    MEMBER("altitude", FHIR_MEMBER_DECIMAL, 0),
+};
+static const FHIRElementRules g_location_position = RULES(g_location_position_members);
+
+static const FHIRMemberRule g_location_members[] = {
+    CODE("status", 0, g_location_status),
+    CODE("mode", 0, g_location_mode),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("address", FHIR_MEMBER_OBJECT, 0),
+    ELEMENT("position", 0, g_location_position),
+    MEMBER("managingOrganization", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("type", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_healthcare_service_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("providedBy", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("appointmentRequired", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("type", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("location", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_endpoint_members[] = {
+    CODE("status", REQUIRED, g_endpoint_status),
+    MEMBER("address", FHIR_MEMBER_STRING, REQUIRED),
+    MEMBER("name", FHIR_MEMBER_STRING, 0),
+    MEMBER("managingOrganization", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("payloadType", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_device_members[] = {
+    CODE("status", 0, g_device_status),
+    MEMBER("type", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("owner", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("location", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("udiCarrier", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_substance_members[] = {
+    MEMBER("instance", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("code", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("expiry", FHIR_MEMBER_STRING, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_organization_affiliation_members[] = {
+    MEMBER("active", FHIR_MEMBER_BOOLEAN, 0),
+    MEMBER("period", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("organization", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("participatingOrganization", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("code", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("location", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const char* const g_nutrition_product_status[] = { "active", "inactive", "entered-in-error", NULL };
+static const char* const g_device_metric_category[] = {
+    "measurement", "setting", "calculation", "unspecified", NULL
+};
+static const char* const g_device_metric_operational_status[] = {
+    "on", "off", "standby", "entered-in-error", NULL
+};
+
+static const FHIRMemberRule g_biologically_derived_product_members[] = {
+    MEMBER("productCategory", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("productCode", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("parent", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_nutrition_product_members[] = {
+    CODE("status", 0, g_nutrition_product_status),
+    MEMBER("code", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("category", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("manufacturer", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("note", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+static const FHIRMemberRule g_device_metric_members[] = {
+    CODE("category", 0, g_device_metric_category),
+    CODE("operationalStatus", 0, g_device_metric_operational_status),
+    MEMBER("type", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("unit", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("device", FHIR_MEMBER_OBJECT, 0),
+    MEMBER("identifier", FHIR_MEMBER_OBJECT, REPEATS),
+    MEMBER("calibration", FHIR_MEMBER_OBJECT, REPEATS),
+};
+
+/* ========================================================================== */
+/* Resource Table                                                             */
+/* ========================================================================== */
+
+static const FHIRStructureRules g_structure_rules[] = {
+    { "CarePlan", RULES(g_care_plan_members) },
+    { "CareTeam", RULES(g_care_team_members) },
+    { "Goal", RULES(g_goal_members) },
+    { "ServiceRequest", RULES(g_service_request_members) },
+    { "NutritionOrder", RULES(g_nutrition_order_members) },
+    { "RiskAssessment", RULES(g_risk_assessment_members) },
+    { "VisionPrescription", RULES(g_vision_prescription_members) },
+    { "Patient", RULES(g_patient_members) },
+    { "Practitioner", RULES(g_practitioner_members) },
+    { "PractitionerRole", RULES(g_practitioner_role_members) },
+    { "Encounter", RULES(g_encounter_members) },
+    { "Person", RULES(g_person_members) },
+    { "RelatedPerson", RULES(g_related_person_members) },
+    { "Group", RULES(g_group_members) },
+    { "Organization", RULES(g_organization_members) },
+    { "Location", RULES(g_location_members) },
+    { "HealthcareService", RULES(g_healthcare_service_members) },
+    { "Endpoint", RULES(g_endpoint_members) },
+    { "Device", RULES(g_device_members) },
+    { "Substance", RULES(g_substance_members) },
+    { "OrganizationAffiliation", RULES(g_organization_affiliation_members) },
+    { "BiologicallyDerivedProduct", RULES(g_biologically_derived_product_members) },
+    { "NutritionProduct", RULES(g_nutrition_product_members) },
+    { "DeviceMetric", RULES(g_device_metric_members) },
+};
+
+const FHIRStructureRules* fhir_structure_rules_find(const char* resource_type) {
+    if (!resource_type) return NULL;
+
+    for (size_t i = 0; i < sizeof(g_structure_rules) / sizeof(g_structure_rules[0]); i++) {
+        if (strcmp(g_structure_rules[i].resource_type, resource_type) == 0) {
+            return &g_structure_rules[i];
+        }
+    }
+    return NULL;
+}
+
+/* ========================================================================== */
+/* Validation                                                                 */
+/* ========================================================================== */
+
+static bool code_allowed(const char* const* codes, const char* value) {
+    if (!codes) return true;
+
+    for (; *codes; codes++) {
+        if (strcmp(*codes, value) == 0) return true;
+    }
+    return false;
+}
+
+static bool validate_element(const cJSON* element, const FHIRElementRules* rules,
+                             char* path, size_t path_length);
+
+// Check one value (an array item for repeating members) against a rule
+static bool validate_value(const cJSON* value, const FHIRMemberRule* rule,
+                           char* path, size_t path_length) {
+    bool ok;
+    switch (rule->kind) {
+        case FHIR_MEMBER_STRING:
+            ok = cJSON_IsString(value);
+            break;
+        case FHIR_MEMBER_CODE:
+            if (!cJSON_IsString(value)) {
+                ok = false;
+                break;
+            }
+            if (!code_allowed(rule->codes, value->valuestring)) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Code is not in the bound value set", path);
+                return false;
+            }
+            return true;
+        case FHIR_MEMBER_BOOLEAN:
+            ok = cJSON_IsBool(value);
+            break;
+        case FHIR_MEMBER_DECIMAL:
+            ok = cJSON_IsNumber(value);
+            break;
+        case FHIR_MEMBER_INTEGER:
+            ok = cJSON_IsNumber(value) && value->valuedouble == floor(value->valuedouble);
+            break;
+        case FHIR_MEMBER_OBJECT:
+            if (!cJSON_IsObject(value)) {
+                ok = false;
+                break;
+            }
+            return !rule->element || validate_element(value, rule->element, path, path_length);
+        default:
+            ok = false;
+            break;
+    }
+
+    if (!ok) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Member has the wrong JSON type", path);
+    }
+    return ok;
+}
+
+// Check every ruled member of an object; path holds the element's own path
+static bool validate_element(const cJSON* element, const FHIRElementRules* rules,
+                             char* path, size_t path_length) {
+    for (size_t i = 0; i < rules->member_count; i++) {
+        const FHIRMemberRule* rule = &rules->members[i];
+        const cJSON* value = cJSON_GetObjectItemCaseSensitive(element, rule->name);
+
+        // Extend the path in place; truncated paths still name the resource's member
+        int written = snprintf(path + path_length, FHIR_ERROR_FIELD_MAX - path_length,
+                               path_length ? ".%s" : "%s", rule->name);
+        size_t member_length = path_length + (written > 0 ? (size_t)written : 0);
+        if (member_length >= FHIR_ERROR_FIELD_MAX) member_length = FHIR_ERROR_FIELD_MAX - 1;
+
+        bool ok = true;
+        if (!value || cJSON_IsNull(value)) {
+            if (rule->flags & FHIR_MEMBER_REQUIRED) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required member", path);
+                ok = false;
+            }
+        } else if (rule->flags & FHIR_MEMBER_REPEATS) {
+            if (!cJSON_IsArray(value)) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Repeating member must be an array", path);
+                ok = false;
+            }
+            size_t index = 0;
+            for (const cJSON* item = ok ? value->child : NULL; item; item = item->next, index++) {
+                written = snprintf(path + member_length, FHIR_ERROR_FIELD_MAX - member_length,
+                                   "[%zu]", index);
+                size_t item_length = member_length + (written > 0 ? (size_t)written : 0);
+                if (item_length >= FHIR_ERROR_FIELD_MAX) item_length = FHIR_ERROR_FIELD_MAX - 1;
+                if (!validate_value(item, rule, path, item_length)) {
+                    ok = false;
+                    break;
+                }
+            }
+        } else {
+            ok = validate_value(value, rule, path, member_length);
+        }
+
+        path[path_length] = '\0';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool fhir_structure_validate(const cJSON* resource, const char* resource_type) {
+    if (!cJSON_IsObject(resource)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Resource must be a JSON object");
+        return false;
+    }
+
+    const char* declared = fhir_json_get_string(resource, "resourceType");
+    if (!declared && !resource_type) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Missing resourceType", "resourceType");
+        return false;
+    }
+
+    char message[FHIR_ERROR_MESSAGE_MAX];
+    if (declared && resource_type && strcmp(declared, resource_type) != 0) {
+        snprintf(message, sizeof(message), "Resource type mismatch: expected %s, got %s",
+                 resource_type, declared);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, message, "resourceType");
+        return false;
+    }
+
+    const FHIRStructureRules* rules = fhir_structure_rules_find(declared ? declared : resource_type);
+    if (!rules) {
+        snprintf(message, sizeof(message), "Unsupported resource type: %s",
+                 declared ? declared : resource_type);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, message, "resourceType");
+        return false;
+    }
+
+    const cJSON* id = cJSON_GetObjectItemCaseSensitive(resource, "id");
+    if (id && !cJSON_IsNull(id) && !(cJSON_IsString(id) && fhir_validate_id(id->valuestring))) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Invalid resource id", "id");
+        return false;
+    }
+
+    char path[FHIR_ERROR_FIELD_MAX];
+    path[0] = '\0';
+    return validate_element(resource, &rules->rules, path, 0);
+}
+
+/* ========================================================================== */
+/* Input Splitting                                                            */
+/* ========================================================================== */
+
+static bool is_json_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Append one input, doubling the array as needed
+static bool push_input(FHIRStructureInput** inputs, size_t* count, size_t* capacity,
+                       const char* text, size_t length, size_t line_number) {
+    if (*count == *capacity) {
+        size_t grown_capacity = *capacity ? *capacity * 2 : 256;
+        FHIRStructureInput* grown = fhir_realloc(*inputs, grown_capacity * sizeof(FHIRStructureInput));
+        if (!grown) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate batch inputs");
+            return false;
+        }
+        *inputs = grown;
+        *capacity = grown_capacity;
+    }
+    (*inputs)[*count].text = text;
+    (*inputs)[*count].length = length;
+    (*inputs)[*count].line_number = line_number;
+    (*count)++;
+    return true;
+}
+
+FHIRStructureInput* fhir_structure_split_lines(const char* text, size_t length, size_t* count) {
+    FHIRStructureInput* inputs = NULL;
+    size_t capacity = 0;
+    size_t line_number = 0;
+    size_t offset = 0;
+
+    *count = 0;
+    while (offset < length) {
+        const char* start = text + offset;
+        const char* newline = memchr(start, '\n', length - offset);
+        size_t line_length = newline ? (size_t)(newline - start) : length - offset;
+        offset += newline ? line_length + 1 : line_length;
+        line_number++;
+
+        // Tolerate CRLF line endings and blank lines, as the NDJSON reader does
+        while (line_length > 0 && is_json_space(start[line_length - 1])) line_length--;
+        if (line_length == 0) continue;
+
+        if (!push_input(&inputs, count, &capacity, start, line_length, line_number)) {
+            fhir_free(inputs);
+            return NULL;
+        }
+    }
+
+    if (!inputs && !(inputs = fhir_malloc(sizeof(FHIRStructureInput)))) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate batch inputs");
+    }
+    return inputs;
+}
+
+FHIRStructureInput* fhir_structure_split_array(const char* text, size_t length, size_t* count) {
+    FHIRStructureInput* inputs = NULL;
+    size_t capacity = 0;
+    size_t position = 0;
+
+    *count = 0;
+    while (position < length && is_json_space(text[position])) position++;
+    if (position == length || text[position] != '[') {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Expected a JSON array");
+        return NULL;
+    }
+    position++;
+
+    size_t start = position;
+    size_t depth = 0;
+    bool in_string = false;
+    bool closed = false;
+    while (position < length && !closed) {
+        char c = text[position];
+        if (in_string) {
+            if (c == '\\') position++;
+            else if (c == '"') in_string = false;
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if ((c == ']' || c == '}') && depth > 0) {
+            depth--;
+        } else if (depth == 0 && (c == ',' || c == ']')) {
+            // Trim the element; only "[]" may have an empty one
+            size_t begin = start;
+            size_t end = position;
+            while (begin < end && is_json_space(text[begin])) begin++;
+            while (end > begin && is_json_space(text[end - 1])) end--;
+            if (begin == end) {
+                if (c == ',' || *count > 0) break;
+            } else if (!push_input(&inputs, count, &capacity, text + begin, end - begin, 0)) {
+                fhir_free(inputs);
+                return NULL;
+            }
+            start = position + 1;
+            closed = c == ']';
+        }
+        position++;
+    }
+
+    while (position < length && is_json_space(text[position])) position++;
+    if (!closed || position != length) {
+        fhir_free(inputs);
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Malformed JSON array");
+        return NULL;
+    }
+
+    if (!inputs && !(inputs = fhir_malloc(sizeof(FHIRStructureInput)))) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate batch inputs");
+    }
+    return inputs;
+}
+
+/* ========================================================================== */
+/* Batch Validation                                                           */
+/* ========================================================================== */
+
+typedef struct {
+    const FHIRStructureInput* inputs;
+    size_t count;
+    const char* resource_type;
+    FHIRStructureResult* results;
+    FHIRAtomicInt next_claim;
+} FHIRStructureBatch;
+
+static void validate_input(const FHIRStructureInput* input, const char* resource_type,
+                           FHIRStructureResult* result) {
+    memset(result, 0, sizeof(FHIRStructureResult));
+    fhir_clear_error();
+
+    cJSON* json = fhir_json_parse(input->text, input->length);
+    if (!json) {
+        result->error_code = FHIR_ERROR_INVALID_JSON;
+        snprintf(result->error_message, sizeof(result->error_message), "Invalid JSON");
+        return;
+    }
+    if (!fhir_structure_validate(json, resource_type)) {
+        // Failed allocations leave no error set
+        const FHIRError* error = fhir_get_last_error();
+        result->error_code = error ? error->code : FHIR_ERROR_OUT_OF_MEMORY;
+        snprintf(result->error_message, sizeof(result->error_message), "%s",
+                 error && error->message ? error->message : "Validation failed");
+        if (error && error->field) {
+            snprintf(result->error_field, sizeof(result->error_field), "%s", error->field);
+        }
+        cJSON_Delete(json);
+        return;
+    }
+    result->json = json;
+}
+
+static void* batch_worker_main(void* arg) {
+    FHIRStructureBatch* batch = arg;
+    for (;;) {
+        size_t begin = (size_t)fhir_atomic_fetch_add_relaxed(&batch->next_claim, 1) *
+                       FHIR_STRUCTURE_BATCH_CLAIM_SIZE;
+        if (begin >= batch->count) break;
+        size_t end = begin + FHIR_STRUCTURE_BATCH_CLAIM_SIZE;
+        if (end > batch->count) end = batch->count;
+        for (size_t i = begin; i < end; i++) {
+            validate_input(&batch->inputs[i], batch->resource_type, &batch->results[i]);
+        }
+    }
+    // Worker threads own their thread-local error state
+    fhir_clear_error();
+    return NULL;
+}
+
+size_t fhir_structure_validate_batch(const FHIRStructureInput* inputs, size_t count,
+                                     const char* resource_type, size_t thread_count,
+                                     FHIRStructureResult* results) {
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+    // Workers with less than one claim of documents would only contend for the counter
+    size_t useful = (count + FHIR_STRUCTURE_BATCH_CLAIM_SIZE - 1) / FHIR_STRUCTURE_BATCH_CLAIM_SIZE;
+    if (thread_count > useful) thread_count = useful ? useful : 1;
+
+    FHIRStructureBatch batch = { inputs, count, resource_type, results, 0 };
+    fhir_atomic_init(&batch.next_claim, 0);
+
+    // The calling thread works too; claims left by threads that fail to start are taken by the rest
+    pthread_t* threads = thread_count > 1 ? fhir_calloc(thread_count, sizeof(pthread_t)) : NULL;
+    bool* started = thread_count > 1 ? fhir_calloc(thread_count, sizeof(bool)) : NULL;
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, batch_worker_main, &batch) == 0;
+    }
+    batch_worker_main(&batch);
+    for (size_t i = 1; threads && started && i < thread_count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    fhir_free(threads);
+    fhir_free(started);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        failed += results[i].error_code != FHIR_ERROR_NONE;
+    }
+    return failed;
+}
+
+void fhir_structure_results_clear(FHIRStructureResult* results, size_t count) {
+    if (!results) return;
+
+    for (size_t i = 0; i < count; i++) {
+        cJSON_Delete(results[i].json);
+        results[i].json = NULL;
+    }
+}
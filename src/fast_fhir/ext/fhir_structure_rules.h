@@ -0,0 +1,188 @@
+/**
+ * @file fhir_structure_rules.h
+ * @brief Table-driven structural validation of parsed FHIR resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Each supported resource type has a static table of member rules: the JSON
+ * kind a member must have, whether it is required, whether it repeats and,
+ * for codes, the value set it is bound to. Backbone elements (CarePlan
+ * activity, VisionPrescription lensSpecification, ...) carry their own
+ * nested tables. The tables mirror the required members and enumerations of
+ * the Pydantic models in deserializers/, so a document that passes here is
+ * one the Python conversion helpers accept, without building any Python
+ * object first.
+ *
+ * fhir_structure_validate_batch parses and validates many documents on a
+ * pool of worker threads; the split helpers turn an NDJSON buffer or a JSON
+ * array into one input per document without parsing it.
+ */
+
+#ifndef FHIR_STRUCTURE_RULES_H
+#define FHIR_STRUCTURE_RULES_H
+
+#include "common/fhir_common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief JSON kind a member value must have
+ */
+typedef enum {
+    FHIR_MEMBER_STRING = 0,     /**< Any JSON string */
+    FHIR_MEMBER_CODE,           /**< JSON string from the rule's value set */
+    FHIR_MEMBER_BOOLEAN,        /**< JSON true or false */
+    FHIR_MEMBER_DECIMAL,        /**< Any JSON number */
+    FHIR_MEMBER_INTEGER,        /**< JSON number without a fractional part */
+    FHIR_MEMBER_OBJECT          /**< JSON object, checked against the rule's element table if any */
+} FHIRMemberKind;
+
+/** Member must be present and not null */
+#define FHIR_MEMBER_REQUIRED 0x01u
+/** Member is a JSON array whose items each have the rule's kind */
+#define FHIR_MEMBER_REPEATS 0x02u
+
+typedef struct FHIRElementRules FHIRElementRules;
+
+/**
+ * @brief Rule for one member of a resource or backbone element
+ */
+typedef struct {
+    const char* name;                   /**< JSON member name */
+    FHIRMemberKind kind;                /**< Kind of the value (or of each item if repeating) */
+    unsigned flags;                     /**< FHIR_MEMBER_REQUIRED | FHIR_MEMBER_REPEATS */
+    const char* const* codes;           /**< NULL-terminated value set for FHIR_MEMBER_CODE */
+    const FHIRElementRules* element;    /**< Nested rules for FHIR_MEMBER_OBJECT (can be NULL) */
+} FHIRMemberRule;
+
+/**
+ * @brief Rules for the members of a resource or backbone element
+ *
+ * Members without a rule are accepted as they are.
+ */
+struct FHIRElementRules {
+    const FHIRMemberRule* members;
+    size_t member_count;
+};
+
+/**
+ * @brief Rules for one resource type
+ */
+typedef struct {
+    const char* resource_type;          /**< FHIR resource type name */
+    FHIRElementRules rules;             /**< Top-level member rules */
+} FHIRStructureRules;
+
+#define FHIR_STRUCTURE_ERROR_MESSAGE_MAX 128
+
+/**
+ * @brief One document of a batch (borrowed text)
+ */
+typedef struct {
+    const char* text;           /**< JSON text of the document */
+    size_t length;              /**< Length of text in bytes */
+    size_t line_number;         /**< 1-based NDJSON line, 0 for other sources */
+} FHIRStructureInput;
+
+/**
+ * @brief Result for one document of a batch
+ */
+typedef struct {
+    cJSON* json;                                            /**< Validated document, NULL on error */
+    FHIRErrorCode error_code;                               /**< FHIR_ERROR_NONE on success */
+    char error_message[FHIR_STRUCTURE_ERROR_MESSAGE_MAX];   /**< Empty on success */
+    char error_field[FHIR_ERROR_FIELD_MAX];                 /**< Offending member path, empty if none */
+} FHIRStructureResult;
+
+/* ========================================================================== */
+/* Validation                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Find the rules for a resource type
+ * @param resource_type Resource type name
+ * @return Rules or NULL if the type has none
+ */
+const FHIRStructureRules* fhir_structure_rules_find(const char* resource_type);
+
+/**
+ * @brief Validate a parsed resource against the rules of its type
+ *
+ * With a resource_type the document may omit resourceType, but must not
+ * name a different one. The error field is the path of the offending
+ * member, e.g. "lensSpecification[1].prism[0].base".
+ *
+ * @param resource Parsed resource
+ * @param resource_type Expected resource type (NULL to use resourceType)
+ * @return true if valid, false on failure (FHIR_ERROR_INVALID_RESOURCE_TYPE
+ *         for a missing, mismatched or unsupported type,
+ *         FHIR_ERROR_MISSING_REQUIRED_FIELD, FHIR_ERROR_VALIDATION_FAILED)
+ */
+bool fhir_structure_validate(const cJSON* resource, const char* resource_type);
+
+/* ========================================================================== */
+/* Batch Validation                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Split an NDJSON buffer into one input per non-empty line
+ * @param text NDJSON text; must outlive the inputs
+ * @param length Length of text in bytes
+ * @param count Output number of inputs
+ * @return Inputs (free with fhir_free) or NULL on failure (FHIR_ERROR_OUT_OF_MEMORY)
+ */
+FHIRStructureInput* fhir_structure_split_lines(const char* text, size_t length, size_t* count);
+
+/**
+ * @brief Split a top-level JSON array into one input per element
+ *
+ * Elements are delimited by scanning brackets and strings; their content
+ * is checked only when the batch parses them.
+ *
+ * @param text JSON array text; must outlive the inputs
+ * @param length Length of text in bytes
+ * @param count Output number of inputs
+ * @return Inputs (free with fhir_free) or NULL on failure (FHIR_ERROR_INVALID_JSON
+ *         if text is not a complete array, FHIR_ERROR_OUT_OF_MEMORY)
+ */
+FHIRStructureInput* fhir_structure_split_array(const char* text, size_t length, size_t* count);
+
+/**
+ * @brief Parse and validate documents on a pool of worker threads
+ *
+ * Each result is stored at its input position, so results come back in
+ * input order whatever the thread count. Does not touch the Python
+ * interpreter, so callers may release the GIL.
+ *
+ * @param inputs Documents to validate
+ * @param count Number of documents
+ * @param resource_type Expected resource type of every document (NULL for any)
+ * @param thread_count Worker threads including the caller (0 = number of online CPUs)
+ * @param results Output count results; release with fhir_structure_results_clear
+ * @return Number of documents that failed
+ */
+size_t fhir_structure_validate_batch(const FHIRStructureInput* inputs, size_t count,
+                                     const char* resource_type, size_t thread_count,
+                                     FHIRStructureResult* results);
+
+/**
+ * @brief Free the documents held by batch results
+ * @param results Results to clear
+ * @param count Number of results
+ */
+void fhir_structure_results_clear(FHIRStructureResult* results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_STRUCTURE_RULES_H */
@@ -0,0 +1,1477 @@
+/**
+ * @file fhir_terminology.c
+ * @brief Compiled terminology index implementation
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_terminology.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Internal Structures                                                        */
+/* ========================================================================== */
+
+#define FHIR_TERMINOLOGY_MAGIC "FHIRTIX"
+#define FHIR_TERMINOLOGY_FORMAT_VERSION 2u
+#define FHIR_TERMINOLOGY_BYTE_ORDER 0x01020304u
+#define FHIR_TERMINOLOGY_INITIAL_CAPACITY 1024
+#define FHIR_TERMINOLOGY_NULL_STRING UINT32_MAX
+#define FHIR_TERMINOLOGY_MAX_DEPTH 64
+#define FHIR_TERMINOLOGY_NOT_FOUND ((size_t)-1)
+#define BITSET_WORDS(bit_count) (((bit_count) + 63) / 64)
+
+typedef enum {
+    KEY_EMPTY = 0,
+    KEY_CONCEPT,                // (system, code) -> concept
+    KEY_VALUE_SET,              // (url, version) -> ValueSet definition
+    KEY_VALUE_SET_LATEST,       // (url) -> last added version of a ValueSet
+    KEY_VALUE_SET_CODE,         // (value set key, system, code) -> enumerated include
+    KEY_VALUE_SET_EXCLUDE,      // (value set key, system, code) -> enumerated exclude
+    KEY_TRANSLATION,            // (concept map, system, code) -> translation list
+    KEY_TRANSLATION_ANY         // (system, code) -> translation list across maps
+} KeyKind;
+
+typedef struct {
+    uint64_t hash;
+    const char* scope;          // ValueSet/ConceptMap URL or key, NULL for concepts
+    const char* system;
+    const char* code;           // ValueSet version for definitions
+    size_t head;                // Concept, ValueSet or first translation index
+    size_t tail;                // Last translation, for appending in order
+    int kind;                   // KeyKind, KEY_EMPTY for a free slot
+} TerminologyEntry;
+
+typedef struct {
+    const char* property;
+    const char* op;
+    const char* value;
+} TerminologyFilter;
+
+// One ValueSet.compose include or exclude; the arrays live in the string arena
+typedef struct {
+    bool include;
+    bool enumerated;            // Lists concepts rather than selecting the whole system
+    const char* system;         // NULL for rules that only import value sets
+    const char** codes;
+    size_t code_count;
+    TerminologyFilter* filters;
+    size_t filter_count;
+    const char** value_sets;    // Imported ValueSet canonicals
+    size_t value_set_count;
+} TerminologyComposeRule;
+
+// Expanded ValueSet membership, one bit per concept index
+typedef struct {
+    uint64_t* bits;
+    size_t bit_count;           // Concept count when expanded; later concepts are not members
+    size_t member_count;
+    const char** systems;       // Code systems the expansion was computed from
+    size_t system_count;
+} TerminologyExpansion;
+
+typedef enum {
+    EXPANSION_EMPTY = 0,
+    EXPANSION_READY
+} ExpansionState;
+
+typedef struct {
+    const char* url;
+    const char* version;        // NULL if the ValueSet has no version
+    const char* key;            // "url|version" (or url), scope of enumerated code entries
+    TerminologyComposeRule* rules;
+    size_t rule_count;
+    size_t rule_capacity;
+    FHIRAtomicInt expansion_state;  // ExpansionState, stored after expansion is set
+    TerminologyExpansion* expansion;
+    bool expanding;             // Import cycle guard, under expansion_lock
+} TerminologyValueSet;
+
+typedef struct {
+    FHIRTerminologyTranslation translation;
+    size_t next_in_map;         // Next target for the same (map, system, code)
+    size_t next_any;            // Next target for the same (system, code) in any map
+} TerminologyTranslationNode;
+
+struct FHIRTerminologyIndex {
+    FHIRArena* strings;         // Codes and displays; systems and URLs are interned
+
+    TerminologyEntry* entries;  // Open addressing, capacity is a power of two
+    size_t capacity;
+    size_t entry_count;
+
+    FHIRTerminologyConcept* concepts;
+    size_t concept_count;
+    size_t concept_capacity;
+
+    TerminologyValueSet** value_sets;
+    size_t value_set_count;
+    size_t value_set_capacity;
+
+    pthread_mutex_t expansion_lock;  // Serializes computing expansions during queries
+    size_t expansion_count;          // Cached expansions
+
+    TerminologyTranslationNode* translations;
+    size_t translation_count;
+    size_t translation_capacity;
+};
+
+/* ========================================================================== */
+/* Private Helper Functions                                                   */
+/* ========================================================================== */
+
+static void hash_bytes(uint64_t* hash, const char* str) {
+    // FNV-1a over the text and its terminator; NULL hashes as a distinct byte
+    if (!str) {
+        *hash = (*hash ^ 0xFFu) * 1099511628211ULL;
+        return;
+    }
+    do {
+        *hash = (*hash ^ (unsigned char)*str) * 1099511628211ULL;
+    } while (*str++);
+}
+
+static uint64_t key_hash(int kind, const char* scope, const char* system, const char* code) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = (hash ^ (unsigned)kind) * 1099511628211ULL;
+    hash_bytes(&hash, scope);
+    hash_bytes(&hash, system);
+    hash_bytes(&hash, code);
+    return hash;
+}
+
+static bool key_equals(const TerminologyEntry* entry, int kind, const char* scope,
+                       const char* system, const char* code) {
+    return entry->kind == kind && fhir_intern_equals(entry->scope, scope) &&
+           fhir_intern_equals(entry->system, system) && fhir_intern_equals(entry->code, code);
+}
+
+static const TerminologyEntry* find_entry(const FHIRTerminologyIndex* index, int kind,
+                                          const char* scope, const char* system, const char* code) {
+    if (!index || index->capacity == 0) return NULL;
+
+    uint64_t hash = key_hash(kind, scope, system, code);
+    size_t slot = hash & (index->capacity - 1);
+    while (index->entries[slot].kind != KEY_EMPTY) {
+        const TerminologyEntry* entry = &index->entries[slot];
+        if (entry->hash == hash && key_equals(entry, kind, scope, system, code)) {
+            return entry;
+        }
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    return NULL;
+}
+
+static bool grow_entries(FHIRTerminologyIndex* index) {
+    size_t capacity = index->capacity ? index->capacity * 2 : FHIR_TERMINOLOGY_INITIAL_CAPACITY;
+    TerminologyEntry* entries = calloc(capacity, sizeof(TerminologyEntry));
+    if (!entries) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow terminology index");
+        return false;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->entries[i].kind != KEY_EMPTY) {
+            size_t slot = index->entries[i].hash & (capacity - 1);
+            while (entries[slot].kind != KEY_EMPTY) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            entries[slot] = index->entries[i];
+        }
+    }
+
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = capacity;
+    return true;
+}
+
+// Find or insert a key; *created tells the caller whether head/tail need filling
+static TerminologyEntry* upsert_entry(FHIRTerminologyIndex* index, int kind, const char* scope,
+                                      const char* system, const char* code, bool* created) {
+    // Keep the load factor below 0.7
+    if ((index->entry_count + 1) * 10 > index->capacity * 7 && !grow_entries(index)) {
+        return NULL;
+    }
+
+    uint64_t hash = key_hash(kind, scope, system, code);
+    size_t slot = hash & (index->capacity - 1);
+    while (index->entries[slot].kind != KEY_EMPTY) {
+        TerminologyEntry* entry = &index->entries[slot];
+        if (entry->hash == hash && key_equals(entry, kind, scope, system, code)) {
+            *created = false;
+            return entry;
+        }
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    TerminologyEntry* entry = &index->entries[slot];
+    *entry = (TerminologyEntry){ .hash = hash, .scope = scope, .system = system, .code = code,
+                                 .head = FHIR_TERMINOLOGY_NO_PARENT,
+                                 .tail = FHIR_TERMINOLOGY_NO_PARENT, .kind = kind };
+    index->entry_count++;
+    *created = true;
+    return entry;
+}
+
+static bool reserve(void** array, size_t* capacity, size_t needed, size_t element_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void* grown = realloc(*array, new_capacity * element_size);
+    if (!grown) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow terminology index");
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static const char* copy_string(FHIRTerminologyIndex* index, const char* str) {
+    if (!str) return NULL;
+
+    size_t size = strlen(str) + 1;
+    char* copy = fhir_arena_alloc(index->strings, size);
+    if (copy) {
+        memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+// URLs, systems and equivalence codes repeat on every entry, so they are interned
+static const char* intern_string(const char* str) {
+    return str ? fhir_intern(str) : NULL;
+}
+
+static bool link_translation(FHIRTerminologyIndex* index, int kind, const char* scope,
+                             const FHIRTerminologyTranslation* translation, size_t node) {
+    bool created;
+    TerminologyEntry* entry = upsert_entry(index, kind, scope, translation->source_system,
+                                           translation->source_code, &created);
+    if (!entry) {
+        return false;
+    }
+
+    if (created) {
+        entry->head = node;
+    } else if (kind == KEY_TRANSLATION) {
+        index->translations[entry->tail].next_in_map = node;
+    } else {
+        index->translations[entry->tail].next_any = node;
+    }
+    entry->tail = node;
+    return true;
+}
+
+static bool add_translation(FHIRTerminologyIndex* index, const char* concept_map,
+                            const char* source_system, const char* source_code,
+                            const char* target_system, const char* target_code,
+                            const char* target_display, const char* equivalence) {
+    if (!index || !concept_map || !source_system || !source_code) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!reserve((void**)&index->translations, &index->translation_capacity,
+                 index->translation_count + 1, sizeof(TerminologyTranslationNode))) {
+        return false;
+    }
+
+    FHIRTerminologyTranslation translation = {
+        .concept_map = intern_string(concept_map),
+        .source_system = intern_string(source_system),
+        .source_code = copy_string(index, source_code),
+        .target_system = intern_string(target_system),
+        .target_code = copy_string(index, target_code),
+        .target_display = copy_string(index, target_display),
+        .equivalence = intern_string(equivalence)
+    };
+    if (!translation.concept_map || !translation.source_system || !translation.source_code ||
+        (target_system && !translation.target_system) || (target_code && !translation.target_code) ||
+        (target_display && !translation.target_display) || (equivalence && !translation.equivalence)) {
+        return false;
+    }
+
+    size_t node = index->translation_count;
+    index->translations[node] = (TerminologyTranslationNode){
+        translation, FHIR_TERMINOLOGY_NO_PARENT, FHIR_TERMINOLOGY_NO_PARENT
+    };
+    if (!link_translation(index, KEY_TRANSLATION, translation.concept_map, &translation, node) ||
+        !link_translation(index, KEY_TRANSLATION_ANY, NULL, &translation, node)) {
+        return false;
+    }
+    index->translation_count++;
+    return true;
+}
+
+/* ========================================================================== */
+/* ValueSet Definitions                                                       */
+/* ========================================================================== */
+
+static void expansion_destroy(TerminologyExpansion* expansion) {
+    if (!expansion) return;
+
+    free(expansion->bits);
+    free(expansion->systems);
+    free(expansion);
+}
+
+// Drop cached expansions computed from system, or every one for NULL. Only
+// called while building, when no queries run concurrently.
+static void invalidate_expansions(FHIRTerminologyIndex* index, const char* system) {
+    if (index->expansion_count == 0) return;
+
+    for (size_t i = 0; i < index->value_set_count; i++) {
+        TerminologyValueSet* value_set = index->value_sets[i];
+        TerminologyExpansion* expansion = value_set->expansion;
+        if (!expansion) continue;
+
+        bool depends = system == NULL;
+        for (size_t j = 0; !depends && j < expansion->system_count; j++) {
+            depends = expansion->systems[j] == system;
+        }
+        if (depends) {
+            fhir_atomic_store(&value_set->expansion_state, EXPANSION_EMPTY);
+            value_set->expansion = NULL;
+            expansion_destroy(expansion);
+            index->expansion_count--;
+        }
+    }
+}
+
+// Find or create the definition of url/version
+static TerminologyValueSet* get_value_set(FHIRTerminologyIndex* index, const char* url,
+                                          const char* version) {
+    const char* interned_url = intern_string(url);
+    const char* interned_version = intern_string(version);
+    if (!interned_url || (version && !interned_version)) {
+        return NULL;
+    }
+
+    const TerminologyEntry* existing = find_entry(index, KEY_VALUE_SET, interned_url, NULL, interned_version);
+    if (existing) {
+        return index->value_sets[existing->head];
+    }
+    if (!reserve((void**)&index->value_sets, &index->value_set_capacity, index->value_set_count + 1,
+                 sizeof(TerminologyValueSet*))) {
+        return NULL;
+    }
+
+    TerminologyValueSet* value_set = calloc(1, sizeof(TerminologyValueSet));
+    if (!value_set) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate ValueSet definition");
+        return NULL;
+    }
+    value_set->url = interned_url;
+    value_set->version = interned_version;
+    value_set->key = interned_url;
+    fhir_atomic_init(&value_set->expansion_state, EXPANSION_EMPTY);
+
+    if (version) {
+        size_t url_length = strlen(url);
+        size_t version_length = strlen(version);
+        char* key = malloc(url_length + version_length + 2);
+        if (key) {
+            memcpy(key, url, url_length);
+            key[url_length] = '|';
+            memcpy(key + url_length + 1, version, version_length + 1);
+            value_set->key = fhir_intern(key);
+            free(key);
+        }
+        if (!key || !value_set->key) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate ValueSet definition");
+            free(value_set);
+            return NULL;
+        }
+    }
+
+    size_t position = index->value_set_count;
+    index->value_sets[index->value_set_count++] = value_set;
+
+    bool created;
+    TerminologyEntry* entry = upsert_entry(index, KEY_VALUE_SET, interned_url, NULL, interned_version, &created);
+    if (!entry) {
+        return NULL;
+    }
+    entry->head = position;
+
+    // A plain URL reference resolves to the version added last
+    entry = upsert_entry(index, KEY_VALUE_SET_LATEST, interned_url, NULL, NULL, &created);
+    if (!entry) {
+        return NULL;
+    }
+    entry->head = position;
+    return value_set;
+}
+
+// Append a compose rule with room for the given number of codes, filters and imports
+static TerminologyComposeRule* add_compose_rule(FHIRTerminologyIndex* index, TerminologyValueSet* value_set,
+                                                bool include, const char* system, bool enumerated,
+                                                size_t code_capacity, size_t filter_capacity,
+                                                size_t value_set_capacity) {
+    if (!reserve((void**)&value_set->rules, &value_set->rule_capacity, value_set->rule_count + 1,
+                 sizeof(TerminologyComposeRule))) {
+        return NULL;
+    }
+
+    TerminologyComposeRule rule = { .include = include, .enumerated = enumerated,
+                                    .system = intern_string(system) };
+    if ((system && !rule.system) ||
+        (code_capacity &&
+         !(rule.codes = fhir_arena_alloc(index->strings, code_capacity * sizeof(const char*)))) ||
+        (filter_capacity &&
+         !(rule.filters = fhir_arena_alloc(index->strings, filter_capacity * sizeof(TerminologyFilter)))) ||
+        (value_set_capacity &&
+         !(rule.value_sets = fhir_arena_alloc(index->strings, value_set_capacity * sizeof(const char*))))) {
+        return NULL;
+    }
+
+    // Other ValueSets may import this one, so every cached expansion is stale
+    invalidate_expansions(index, NULL);
+
+    value_set->rules[value_set->rule_count] = rule;
+    return &value_set->rules[value_set->rule_count++];
+}
+
+static bool rule_add_code(FHIRTerminologyIndex* index, const TerminologyValueSet* value_set,
+                          TerminologyComposeRule* rule, const char* code) {
+    const char* copy = copy_string(index, code);
+    if (!copy) {
+        return false;
+    }
+    rule->codes[rule->code_count++] = copy;
+
+    // Direct entry for codes of code systems the index does not hold
+    bool created;
+    return !rule->system ||
+           upsert_entry(index, rule->include ? KEY_VALUE_SET_CODE : KEY_VALUE_SET_EXCLUDE,
+                        value_set->key, rule->system, copy, &created) != NULL;
+}
+
+static bool rule_add_filter(FHIRTerminologyIndex* index, TerminologyComposeRule* rule,
+                            const char* property, const char* op, const char* value) {
+    if (!property || !op || !value) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "ValueSet filter needs property, op and value",
+                             "compose.include.filter");
+        return false;
+    }
+
+    TerminologyFilter filter = { intern_string(property), intern_string(op), copy_string(index, value) };
+    if (!filter.property || !filter.op || !filter.value) {
+        return false;
+    }
+    rule->filters[rule->filter_count++] = filter;
+    return true;
+}
+
+static bool rule_add_value_set(TerminologyComposeRule* rule, const char* canonical) {
+    const char* interned = intern_string(canonical);
+    if (!interned) {
+        return false;
+    }
+    rule->value_sets[rule->value_set_count++] = interned;
+    return true;
+}
+
+// Resolve "url" (last added version) or "url|version"
+static TerminologyValueSet* resolve_value_set(const FHIRTerminologyIndex* index, const char* canonical) {
+    const char* bar = strchr(canonical, '|');
+    const TerminologyEntry* entry;
+
+    if (!bar) {
+        entry = find_entry(index, KEY_VALUE_SET_LATEST, canonical, NULL, NULL);
+    } else {
+        char buffer[256];
+        size_t length = (size_t)(bar - canonical);
+        char* url = length < sizeof(buffer) ? buffer : malloc(length + 1);
+        if (!url) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to resolve ValueSet");
+            return NULL;
+        }
+        memcpy(url, canonical, length);
+        url[length] = '\0';
+        entry = find_entry(index, KEY_VALUE_SET, url, NULL, bar + 1);
+        if (url != buffer) {
+            free(url);
+        }
+    }
+    return entry ? index->value_sets[entry->head] : NULL;
+}
+
+/* ========================================================================== */
+/* Index Lifecycle                                                            */
+/* ========================================================================== */
+
+FHIRTerminologyIndex* fhir_terminology_index_create(void) {
+    FHIRTerminologyIndex* index = calloc(1, sizeof(FHIRTerminologyIndex));
+    if (!index) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate terminology index");
+        return NULL;
+    }
+
+    pthread_mutex_init(&index->expansion_lock, NULL);
+    index->strings = fhir_arena_create(0);
+    if (!index->strings || !grow_entries(index)) {
+        fhir_terminology_index_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+void fhir_terminology_index_destroy(FHIRTerminologyIndex* index) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->value_set_count; i++) {
+        expansion_destroy(index->value_sets[i]->expansion);
+        free(index->value_sets[i]->rules);
+        free(index->value_sets[i]);
+    }
+    free(index->value_sets);
+
+    fhir_arena_destroy(index->strings);
+    free(index->entries);
+    free(index->concepts);
+    free(index->translations);
+    pthread_mutex_destroy(&index->expansion_lock);
+    free(index);
+}
+
+void fhir_terminology_index_get_stats(const FHIRTerminologyIndex* index, FHIRTerminologyStats* stats) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(FHIRTerminologyStats));
+    if (!index) return;
+
+    FHIRArenaStats arena_stats;
+    fhir_arena_get_stats(index->strings, &arena_stats);
+    stats->concept_count = index->concept_count;
+    stats->value_set_count = index->value_set_count;
+    stats->expansion_count = index->expansion_count;
+    stats->translation_count = index->translation_count;
+    stats->bytes_used = arena_stats.bytes_reserved +
+                        index->capacity * sizeof(TerminologyEntry) +
+                        index->concept_capacity * sizeof(FHIRTerminologyConcept) +
+                        index->value_set_capacity * sizeof(TerminologyValueSet*) +
+                        index->translation_capacity * sizeof(TerminologyTranslationNode);
+
+    for (size_t i = 0; i < index->value_set_count; i++) {
+        const TerminologyValueSet* value_set = index->value_sets[i];
+        stats->bytes_used += sizeof(TerminologyValueSet) +
+                             value_set->rule_capacity * sizeof(TerminologyComposeRule);
+        if (value_set->expansion) {
+            stats->bytes_used += sizeof(TerminologyExpansion) +
+                                 BITSET_WORDS(value_set->expansion->bit_count) * sizeof(uint64_t) +
+                                 value_set->expansion->system_count * sizeof(const char*);
+        }
+
+        for (size_t j = 0; j < value_set->rule_count; j++) {
+            const TerminologyComposeRule* rule = &value_set->rules[j];
+            stats->value_set_rule_count += rule->code_count + rule->value_set_count +
+                                           (rule->system && !rule->enumerated ? 1 : 0);
+        }
+    }
+}
+
+/* ========================================================================== */
+/* Persistence                                                                */
+/* ========================================================================== */
+
+// The file replays the operations that built the index: concepts in index
+// order (so parent indices stay valid), then ValueSet definitions with their
+// compose rules, then translations. Integers are written in native byte
+// order. Expansions are not saved; they are recomputed on first use.
+
+static bool write_u32(FILE* file, uint32_t value) {
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool write_u64(FILE* file, uint64_t value) {
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool write_string(FILE* file, const char* str) {
+    if (!str) {
+        return write_u32(file, FHIR_TERMINOLOGY_NULL_STRING);
+    }
+    size_t length = strlen(str);
+    return length < FHIR_TERMINOLOGY_NULL_STRING && write_u32(file, (uint32_t)length) &&
+           fwrite(str, 1, length, file) == length;
+}
+
+static bool read_u32(FILE* file, uint32_t* value) {
+    return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+static bool read_u64(FILE* file, uint64_t* value) {
+    return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+// Reads into a reusable buffer; *str is NULL for a NULL string
+static bool read_string(FILE* file, char** buffer, size_t* capacity, const char** str) {
+    uint32_t length;
+    if (!read_u32(file, &length)) return false;
+    if (length == FHIR_TERMINOLOGY_NULL_STRING) {
+        *str = NULL;
+        return true;
+    }
+
+    if ((size_t)length + 1 > *capacity) {
+        char* grown = realloc(*buffer, (size_t)length + 1);
+        if (!grown) return false;
+        *buffer = grown;
+        *capacity = (size_t)length + 1;
+    }
+    if (fread(*buffer, 1, length, file) != length) return false;
+    (*buffer)[length] = '\0';
+    *str = *buffer;
+    return true;
+}
+
+bool fhir_terminology_index_save(const FHIRTerminologyIndex* index, const char* path) {
+    if (!index || !path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        FHIR_SET_ERROR(FHIR_ERROR_IO, "Failed to open terminology index file for writing");
+        return false;
+    }
+
+    bool ok = fwrite(FHIR_TERMINOLOGY_MAGIC, 1, sizeof(FHIR_TERMINOLOGY_MAGIC), file) ==
+                  sizeof(FHIR_TERMINOLOGY_MAGIC) &&
+              write_u32(file, FHIR_TERMINOLOGY_FORMAT_VERSION) &&
+              write_u32(file, FHIR_TERMINOLOGY_BYTE_ORDER) &&
+              write_u64(file, index->concept_count) &&
+              write_u64(file, index->value_set_count) &&
+              write_u64(file, index->translation_count);
+
+    for (size_t i = 0; ok && i < index->concept_count; i++) {
+        const FHIRTerminologyConcept* concept = &index->concepts[i];
+        ok = write_string(file, concept->system) && write_string(file, concept->code) &&
+             write_string(file, concept->display) && write_u64(file, concept->parent);
+    }
+    for (size_t i = 0; ok && i < index->value_set_count; i++) {
+        const TerminologyValueSet* value_set = index->value_sets[i];
+        ok = write_string(file, value_set->url) && write_string(file, value_set->version) &&
+             write_u64(file, value_set->rule_count);
+
+        for (size_t j = 0; ok && j < value_set->rule_count; j++) {
+            const TerminologyComposeRule* rule = &value_set->rules[j];
+            ok = write_u32(file, rule->include) && write_u32(file, rule->enumerated) &&
+                 write_u32(file, (uint32_t)rule->code_count) &&
+                 write_u32(file, (uint32_t)rule->filter_count) &&
+                 write_u32(file, (uint32_t)rule->value_set_count) &&
+                 write_string(file, rule->system);
+            for (size_t k = 0; ok && k < rule->code_count; k++) {
+                ok = write_string(file, rule->codes[k]);
+            }
+            for (size_t k = 0; ok && k < rule->filter_count; k++) {
+                ok = write_string(file, rule->filters[k].property) &&
+                     write_string(file, rule->filters[k].op) &&
+                     write_string(file, rule->filters[k].value);
+            }
+            for (size_t k = 0; ok && k < rule->value_set_count; k++) {
+                ok = write_string(file, rule->value_sets[k]);
+            }
+        }
+    }
+    for (size_t i = 0; ok && i < index->translation_count; i++) {
+        const FHIRTerminologyTranslation* t = &index->translations[i].translation;
+        ok = write_string(file, t->concept_map) && write_string(file, t->source_system) &&
+             write_string(file, t->source_code) && write_string(file, t->target_system) &&
+             write_string(file, t->target_code) && write_string(file, t->target_display) &&
+             write_string(file, t->equivalence);
+    }
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        FHIR_SET_ERROR(FHIR_ERROR_IO, "Failed to write terminology index file");
+    }
+    return ok;
+}
+
+FHIRTerminologyIndex* fhir_terminology_index_load(const char* path) {
+    if (!path) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Path is NULL");
+        return NULL;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        FHIR_SET_ERROR(FHIR_ERROR_IO, "Failed to open terminology index file");
+        return NULL;
+    }
+
+    char magic[sizeof(FHIR_TERMINOLOGY_MAGIC)];
+    uint32_t version = 0, byte_order = 0;
+    uint64_t concept_count = 0, value_set_count = 0, translation_count = 0;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, FHIR_TERMINOLOGY_MAGIC, sizeof(magic)) != 0 ||
+        !read_u32(file, &version) || version != FHIR_TERMINOLOGY_FORMAT_VERSION ||
+        !read_u32(file, &byte_order) || byte_order != FHIR_TERMINOLOGY_BYTE_ORDER ||
+        !read_u64(file, &concept_count) || !read_u64(file, &value_set_count) ||
+        !read_u64(file, &translation_count)) {
+        fclose(file);
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Not a terminology index file of this version");
+        return NULL;
+    }
+
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    if (!index) {
+        fclose(file);
+        return NULL;
+    }
+
+    // One scratch buffer per string field of a record
+    char* buffers[7] = {0};
+    size_t capacities[7] = {0};
+    const char* s[7];
+    bool ok = true;
+
+    for (uint64_t i = 0; ok && i < concept_count; i++) {
+        uint64_t parent;
+        ok = read_string(file, &buffers[0], &capacities[0], &s[0]) &&
+             read_string(file, &buffers[1], &capacities[1], &s[1]) &&
+             read_string(file, &buffers[2], &capacities[2], &s[2]) &&
+             read_u64(file, &parent) &&
+             (parent == FHIR_TERMINOLOGY_NO_PARENT || parent < i) &&
+             fhir_terminology_add_concept(index, s[0], s[1], s[2], (size_t)parent) == (size_t)i;
+    }
+    for (uint64_t i = 0; ok && i < value_set_count; i++) {
+        uint64_t rule_count = 0;
+        TerminologyValueSet* value_set = NULL;
+        ok = read_string(file, &buffers[0], &capacities[0], &s[0]) && s[0] &&
+             read_string(file, &buffers[1], &capacities[1], &s[1]) &&
+             read_u64(file, &rule_count) &&
+             (value_set = get_value_set(index, s[0], s[1])) != NULL;
+
+        for (uint64_t j = 0; ok && j < rule_count; j++) {
+            uint32_t include, enumerated, code_count, filter_count, import_count;
+            TerminologyComposeRule* rule = NULL;
+            ok = read_u32(file, &include) && read_u32(file, &enumerated) &&
+                 read_u32(file, &code_count) && read_u32(file, &filter_count) &&
+                 read_u32(file, &import_count) &&
+                 read_string(file, &buffers[2], &capacities[2], &s[2]) &&
+                 (rule = add_compose_rule(index, value_set, include != 0, s[2], enumerated != 0,
+                                          code_count, filter_count, import_count)) != NULL;
+
+            for (uint32_t k = 0; ok && k < code_count; k++) {
+                ok = read_string(file, &buffers[3], &capacities[3], &s[3]) && s[3] &&
+                     rule_add_code(index, value_set, rule, s[3]);
+            }
+            for (uint32_t k = 0; ok && k < filter_count; k++) {
+                ok = read_string(file, &buffers[3], &capacities[3], &s[3]) &&
+                     read_string(file, &buffers[4], &capacities[4], &s[4]) &&
+                     read_string(file, &buffers[5], &capacities[5], &s[5]) &&
+                     rule_add_filter(index, rule, s[3], s[4], s[5]);
+            }
+            for (uint32_t k = 0; ok && k < import_count; k++) {
+                ok = read_string(file, &buffers[3], &capacities[3], &s[3]) && s[3] &&
+                     rule_add_value_set(rule, s[3]);
+            }
+        }
+    }
+    for (uint64_t i = 0; ok && i < translation_count; i++) {
+        for (int field = 0; ok && field < 7; field++) {
+            ok = read_string(file, &buffers[field], &capacities[field], &s[field]);
+        }
+        ok = ok && add_translation(index, s[0], s[1], s[2], s[3], s[4], s[5], s[6]);
+    }
+
+    for (int field = 0; field < 7; field++) {
+        free(buffers[field]);
+    }
+    fclose(file);
+
+    if (!ok) {
+        fhir_terminology_index_destroy(index);
+        FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, "Truncated or corrupt terminology index file");
+        return NULL;
+    }
+    return index;
+}
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+size_t fhir_terminology_add_concept(FHIRTerminologyIndex* index, const char* system,
+                                    const char* code, const char* display, size_t parent) {
+    if (!index || !system || !code ||
+        (parent != FHIR_TERMINOLOGY_NO_PARENT && parent >= index->concept_count)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return FHIR_TERMINOLOGY_NO_PARENT;
+    }
+    if (!reserve((void**)&index->concepts, &index->concept_capacity, index->concept_count + 1,
+                 sizeof(FHIRTerminologyConcept))) {
+        return FHIR_TERMINOLOGY_NO_PARENT;
+    }
+
+    FHIRTerminologyConcept concept = {
+        .system = intern_string(system),
+        .code = copy_string(index, code),
+        .display = copy_string(index, display),
+        .parent = parent
+    };
+    if (!concept.system || !concept.code || (display && !concept.display)) {
+        return FHIR_TERMINOLOGY_NO_PARENT;
+    }
+
+    bool created;
+    TerminologyEntry* entry = upsert_entry(index, KEY_CONCEPT, NULL, concept.system, concept.code, &created);
+    if (!entry) {
+        return FHIR_TERMINOLOGY_NO_PARENT;
+    }
+
+    // A repeated code keeps its first definition
+    if (!created) {
+        return entry->head;
+    }
+
+    entry->head = index->concept_count;
+    index->concepts[index->concept_count] = concept;
+    invalidate_expansions(index, concept.system);
+    return index->concept_count++;
+}
+
+static bool add_concepts_json(FHIRTerminologyIndex* index, const char* system,
+                              const cJSON* concepts, size_t parent, int depth) {
+    if (depth > FHIR_TERMINOLOGY_MAX_DEPTH) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Concept hierarchy too deep", "concept");
+        return false;
+    }
+
+    const cJSON* concept;
+    cJSON_ArrayForEach(concept, concepts) {
+        const char* code = fhir_json_get_string(concept, "code");
+        if (!code) {
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Concept without code", "concept.code");
+            return false;
+        }
+
+        size_t added = fhir_terminology_add_concept(index, system, code,
+                                                    fhir_json_get_string(concept, "display"), parent);
+        if (added == FHIR_TERMINOLOGY_NO_PARENT) {
+            return false;
+        }
+
+        const cJSON* children = cJSON_GetObjectItemCaseSensitive(concept, "concept");
+        if (cJSON_IsArray(children) && !add_concepts_json(index, system, children, added, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fhir_terminology_add_code_system_json(FHIRTerminologyIndex* index, const cJSON* code_system) {
+    if (!index || !cJSON_IsObject(code_system)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* url = fhir_json_get_string(code_system, "url");
+    if (!url) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "CodeSystem without url", "url");
+        return false;
+    }
+
+    const cJSON* concepts = cJSON_GetObjectItemCaseSensitive(code_system, "concept");
+    return !cJSON_IsArray(concepts) ||
+           add_concepts_json(index, url, concepts, FHIR_TERMINOLOGY_NO_PARENT, 0);
+}
+
+static bool add_concepts(FHIRTerminologyIndex* index, const char* system,
+                         CodeSystemConcept* const* concepts, size_t count, size_t parent, int depth) {
+    if (depth > FHIR_TERMINOLOGY_MAX_DEPTH) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Concept hierarchy too deep", "concept");
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const CodeSystemConcept* concept = concepts[i];
+        if (!concept) continue;
+        if (!concept->code || !concept->code->value) {
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Concept without code", "concept.code");
+            return false;
+        }
+
+        const char* display = concept->display ? concept->display->value : NULL;
+        size_t added = fhir_terminology_add_concept(index, system, concept->code->value, display, parent);
+        if (added == FHIR_TERMINOLOGY_NO_PARENT ||
+            !add_concepts(index, system, concept->concept, concept->concept_count, added, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fhir_terminology_add_code_system(FHIRTerminologyIndex* index, const FHIRCodeSystem* code_system) {
+    if (!index || !code_system) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!code_system->url || !code_system->url->value) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "CodeSystem without url", "url");
+        return false;
+    }
+
+    return add_concepts(index, code_system->url->value, code_system->concept,
+                        code_system->concept_count, FHIR_TERMINOLOGY_NO_PARENT, 0);
+}
+
+static const cJSON* json_array(const cJSON* json, const char* key) {
+    const cJSON* array = cJSON_GetObjectItemCaseSensitive(json, key);
+    return cJSON_IsArray(array) ? array : NULL;
+}
+
+static bool add_compose_json(FHIRTerminologyIndex* index, TerminologyValueSet* value_set,
+                             const cJSON* rules, bool include) {
+    const cJSON* source;
+    cJSON_ArrayForEach(source, rules) {
+        const char* system = fhir_json_get_string(source, "system");
+        const cJSON* concepts = system ? json_array(source, "concept") : NULL;
+        const cJSON* filters = system ? json_array(source, "filter") : NULL;
+        const cJSON* imports = json_array(source, "valueSet");
+        size_t code_count = concepts ? (size_t)cJSON_GetArraySize(concepts) : 0;
+        size_t import_count = imports ? (size_t)cJSON_GetArraySize(imports) : 0;
+        if (!system && import_count == 0) {
+            continue;
+        }
+
+        TerminologyComposeRule* rule = add_compose_rule(
+            index, value_set, include, system, code_count > 0, code_count,
+            filters ? (size_t)cJSON_GetArraySize(filters) : 0, import_count);
+        if (!rule) {
+            return false;
+        }
+
+        const cJSON* item;
+        cJSON_ArrayForEach(item, concepts) {
+            const char* code = fhir_json_get_string(item, "code");
+            if (code && !rule_add_code(index, value_set, rule, code)) {
+                return false;
+            }
+        }
+        cJSON_ArrayForEach(item, filters) {
+            if (!rule_add_filter(index, rule, fhir_json_get_string(item, "property"),
+                                 fhir_json_get_string(item, "op"), fhir_json_get_string(item, "value"))) {
+                return false;
+            }
+        }
+        cJSON_ArrayForEach(item, imports) {
+            if (cJSON_IsString(item) && !rule_add_value_set(rule, item->valuestring)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool fhir_terminology_add_value_set_json(FHIRTerminologyIndex* index, const cJSON* value_set) {
+    if (!index || !cJSON_IsObject(value_set)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* url = fhir_json_get_string(value_set, "url");
+    if (!url) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "ValueSet without url", "url");
+        return false;
+    }
+
+    TerminologyValueSet* definition = get_value_set(index, url, fhir_json_get_string(value_set, "version"));
+    if (!definition) {
+        return false;
+    }
+
+    const cJSON* compose = cJSON_GetObjectItemCaseSensitive(value_set, "compose");
+    if (!cJSON_IsObject(compose)) {
+        return true;
+    }
+    return add_compose_json(index, definition, json_array(compose, "include"), true) &&
+           add_compose_json(index, definition, json_array(compose, "exclude"), false);
+}
+
+static bool add_compose(FHIRTerminologyIndex* index, TerminologyValueSet* value_set,
+                        ValueSetComposeInclude* const* rules, size_t count, bool include) {
+    for (size_t i = 0; i < count; i++) {
+        const ValueSetComposeInclude* source = rules[i];
+        if (!source) continue;
+
+        const char* system = source->system ? source->system->value : NULL;
+        if (!system && source->value_set_count == 0) {
+            continue;
+        }
+
+        size_t code_count = system ? source->concept_count : 0;
+        TerminologyComposeRule* rule = add_compose_rule(index, value_set, include, system, code_count > 0,
+                                                        code_count, system ? source->filter_count : 0,
+                                                        source->value_set_count);
+        if (!rule) {
+            return false;
+        }
+
+        for (size_t j = 0; j < code_count; j++) {
+            const ValueSetComposeIncludeConcept* concept = source->concept[j];
+            if (concept && concept->code && concept->code->value &&
+                !rule_add_code(index, value_set, rule, concept->code->value)) {
+                return false;
+            }
+        }
+        for (size_t j = 0; system && j < source->filter_count; j++) {
+            const ValueSetComposeIncludeFilter* filter = source->filter[j];
+            if (filter &&
+                !rule_add_filter(index, rule, filter->property ? filter->property->value : NULL,
+                                 filter->op ? filter->op->value : NULL,
+                                 filter->value ? filter->value->value : NULL)) {
+                return false;
+            }
+        }
+        for (size_t j = 0; j < source->value_set_count; j++) {
+            const FHIRCanonical* canonical = source->value_set[j];
+            if (canonical && canonical->value && !rule_add_value_set(rule, canonical->value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool fhir_terminology_add_value_set_compose(FHIRTerminologyIndex* index, const char* url,
+                                            const char* version, const ValueSetCompose* compose) {
+    if (!index || !url || !compose) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    TerminologyValueSet* definition = get_value_set(index, url, version);
+    return definition &&
+           add_compose(index, definition, compose->include, compose->include_count, true) &&
+           add_compose(index, definition, compose->exclude, compose->exclude_count, false);
+}
+
+bool fhir_terminology_add_concept_map_json(FHIRTerminologyIndex* index, const cJSON* concept_map) {
+    if (!index || !cJSON_IsObject(concept_map)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    const char* url = fhir_json_get_string(concept_map, "url");
+    if (!url) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "ConceptMap without url", "url");
+        return false;
+    }
+
+    const cJSON* group;
+    cJSON_ArrayForEach(group, cJSON_GetObjectItemCaseSensitive(concept_map, "group")) {
+        const char* source = fhir_json_get_string(group, "source");
+        const char* target = fhir_json_get_string(group, "target");
+        if (!source) {
+            continue;
+        }
+
+        const cJSON* element;
+        cJSON_ArrayForEach(element, cJSON_GetObjectItemCaseSensitive(group, "element")) {
+            const char* code = fhir_json_get_string(element, "code");
+            if (!code) {
+                continue;
+            }
+
+            const cJSON* mapped;
+            cJSON_ArrayForEach(mapped, cJSON_GetObjectItemCaseSensitive(element, "target")) {
+                // R5 names the field relationship, R4 equivalence
+                const char* relationship = fhir_json_get_string(mapped, "relationship");
+                if (!relationship) {
+                    relationship = fhir_json_get_string(mapped, "equivalence");
+                }
+                if (!add_translation(index, url, source, code, target,
+                                     fhir_json_get_string(mapped, "code"),
+                                     fhir_json_get_string(mapped, "display"), relationship)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Expansion                                                                  */
+/* ========================================================================== */
+
+typedef enum {
+    FILTER_IS_A,
+    FILTER_DESCENDENT_OF,
+    FILTER_IS_NOT_A,
+    FILTER_GENERALIZES,
+    FILTER_EQUALS,
+    FILTER_IN,
+    FILTER_NOT_IN
+} FilterOp;
+
+static bool bit_test(const uint64_t* bits, size_t bit_count, size_t bit) {
+    return bit < bit_count && ((bits[bit / 64] >> (bit % 64)) & 1u);
+}
+
+static void bit_set(uint64_t* bits, size_t bit) {
+    bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+static void bit_clear(uint64_t* bits, size_t bit) {
+    bits[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+}
+
+static size_t popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_popcountll(word);
+#else
+    size_t count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static bool is_descendant(const FHIRTerminologyIndex* index, size_t concept, size_t ancestor) {
+    // Parents always precede their children, so the chain strictly decreases
+    for (size_t parent = index->concepts[concept].parent;
+         parent != FHIR_TERMINOLOGY_NO_PARENT && parent >= ancestor;
+         parent = index->concepts[parent].parent) {
+        if (parent == ancestor) return true;
+    }
+    return false;
+}
+
+// Whether code is an item of a comma-separated in/not-in list
+static bool code_in_list(const char* code, const char* list) {
+    size_t length = strlen(code);
+    while (*list) {
+        while (*list == ' ') list++;
+        const char* end = strchr(list, ',');
+        size_t item = end ? (size_t)(end - list) : strlen(list);
+        while (item > 0 && list[item - 1] == ' ') item--;
+        if (item == length && strncmp(list, code, length) == 0) {
+            return true;
+        }
+        if (!end) break;
+        list = end + 1;
+    }
+    return false;
+}
+
+static bool parse_filter_op(const TerminologyFilter* filter, FilterOp* op) {
+    static const struct {
+        const char* name;
+        FilterOp op;
+    } ops[] = {
+        {"is-a", FILTER_IS_A},
+        {"descendent-of", FILTER_DESCENDENT_OF},
+        {"is-not-a", FILTER_IS_NOT_A},
+        {"generalizes", FILTER_GENERALIZES},
+        {"=", FILTER_EQUALS},
+        {"in", FILTER_IN},
+        {"not-in", FILTER_NOT_IN}
+    };
+
+    // Only the concept hierarchy and codes are indexed, not concept properties
+    if (strcmp(filter->property, "concept") != 0 && strcmp(filter->property, "code") != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(filter->op, ops[i].name) == 0) {
+            *op = ops[i].op;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool filter_matches(const FHIRTerminologyIndex* index, size_t concept, FilterOp op,
+                           size_t target, const char* value) {
+    const char* code = index->concepts[concept].code;
+    switch (op) {
+        case FILTER_IS_A:
+            return target != FHIR_TERMINOLOGY_NOT_FOUND &&
+                   (concept == target || is_descendant(index, concept, target));
+        case FILTER_DESCENDENT_OF:
+            return target != FHIR_TERMINOLOGY_NOT_FOUND && is_descendant(index, concept, target);
+        case FILTER_IS_NOT_A:
+            return target == FHIR_TERMINOLOGY_NOT_FOUND ||
+                   (concept != target && !is_descendant(index, concept, target));
+        case FILTER_GENERALIZES:
+            return target != FHIR_TERMINOLOGY_NOT_FOUND &&
+                   (concept == target || is_descendant(index, target, concept));
+        case FILTER_EQUALS:
+            return strcmp(code, value) == 0;
+        case FILTER_IN:
+            return code_in_list(code, value);
+        case FILTER_NOT_IN:
+            return !code_in_list(code, value);
+    }
+    return false;
+}
+
+static bool add_dependency(TerminologyExpansion* expansion, size_t* capacity, const char* system) {
+    for (size_t i = 0; i < expansion->system_count; i++) {
+        if (expansion->systems[i] == system) return true;
+    }
+    if (!reserve((void**)&expansion->systems, capacity, expansion->system_count + 1, sizeof(const char*))) {
+        return false;
+    }
+    expansion->systems[expansion->system_count++] = system;
+    return true;
+}
+
+static TerminologyExpansion* expand_value_set(FHIRTerminologyIndex* index, TerminologyValueSet* value_set);
+
+// Set the bits of the concepts one compose rule selects
+static bool expand_rule(FHIRTerminologyIndex* index, const TerminologyComposeRule* rule, uint64_t* bits,
+                        TerminologyExpansion* expansion, size_t* system_capacity) {
+    size_t words = BITSET_WORDS(index->concept_count);
+
+    if (rule->system) {
+        if (!add_dependency(expansion, system_capacity, rule->system)) {
+            return false;
+        }
+
+        if (rule->enumerated) {
+            for (size_t i = 0; i < rule->code_count; i++) {
+                const TerminologyEntry* entry = find_entry(index, KEY_CONCEPT, NULL, rule->system, rule->codes[i]);
+                if (entry) {
+                    bit_set(bits, entry->head);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < index->concept_count; i++) {
+                if (index->concepts[i].system == rule->system) {
+                    bit_set(bits, i);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < rule->filter_count; i++) {
+            const TerminologyFilter* filter = &rule->filters[i];
+            FilterOp op;
+            if (!parse_filter_op(filter, &op)) {
+                FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Unsupported ValueSet filter",
+                                     "compose.include.filter");
+                return false;
+            }
+
+            const TerminologyEntry* entry = find_entry(index, KEY_CONCEPT, NULL, rule->system, filter->value);
+            size_t target = entry ? entry->head : FHIR_TERMINOLOGY_NOT_FOUND;
+            for (size_t concept = 0; concept < index->concept_count; concept++) {
+                if (bit_test(bits, index->concept_count, concept) &&
+                    !filter_matches(index, concept, op, target, filter->value)) {
+                    bit_clear(bits, concept);
+                }
+            }
+        }
+    }
+
+    // Imported value sets intersect with the system part and with each other
+    for (size_t i = 0; i < rule->value_set_count; i++) {
+        TerminologyValueSet* imported = resolve_value_set(index, rule->value_sets[i]);
+        if (!imported) {
+            FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Imported ValueSet not found",
+                                 "compose.include.valueSet");
+            return false;
+        }
+
+        const TerminologyExpansion* nested = expand_value_set(index, imported);
+        if (!nested) {
+            return false;
+        }
+        for (size_t j = 0; j < nested->system_count; j++) {
+            if (!add_dependency(expansion, system_capacity, nested->systems[j])) {
+                return false;
+            }
+        }
+
+        size_t nested_words = BITSET_WORDS(nested->bit_count);
+        for (size_t w = 0; w < words; w++) {
+            uint64_t word = w < nested_words ? nested->bits[w] : 0;
+            bits[w] = (rule->system || i > 0) ? (bits[w] & word) : word;
+        }
+    }
+    return true;
+}
+
+// Compute and cache an expansion; the caller holds expansion_lock
+static TerminologyExpansion* expand_value_set(FHIRTerminologyIndex* index, TerminologyValueSet* value_set) {
+    if (fhir_atomic_load(&value_set->expansion_state) == EXPANSION_READY) {
+        return value_set->expansion;
+    }
+    if (value_set->expanding) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "ValueSet imports itself",
+                             "compose.include.valueSet");
+        return NULL;
+    }
+
+    size_t words = BITSET_WORDS(index->concept_count);
+    size_t allocated = words ? words : 1;
+    TerminologyExpansion* expansion = calloc(1, sizeof(TerminologyExpansion));
+    uint64_t* rule_bits = calloc(allocated, sizeof(uint64_t));
+    uint64_t* excluded = calloc(allocated, sizeof(uint64_t));
+    if (expansion) {
+        expansion->bits = calloc(allocated, sizeof(uint64_t));
+        expansion->bit_count = index->concept_count;
+    }
+    if (!expansion || !expansion->bits || !rule_bits || !excluded) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate ValueSet expansion");
+        expansion_destroy(expansion);
+        free(rule_bits);
+        free(excluded);
+        return NULL;
+    }
+
+    value_set->expanding = true;
+    size_t system_capacity = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < value_set->rule_count; i++) {
+        const TerminologyComposeRule* rule = &value_set->rules[i];
+        memset(rule_bits, 0, allocated * sizeof(uint64_t));
+        ok = expand_rule(index, rule, rule_bits, expansion, &system_capacity);
+
+        uint64_t* target = rule->include ? expansion->bits : excluded;
+        for (size_t w = 0; ok && w < words; w++) {
+            target[w] |= rule_bits[w];
+        }
+    }
+    value_set->expanding = false;
+
+    for (size_t w = 0; w < words; w++) {
+        expansion->bits[w] &= ~excluded[w];
+        expansion->member_count += popcount64(expansion->bits[w]);
+    }
+    free(rule_bits);
+    free(excluded);
+
+    if (!ok) {
+        expansion_destroy(expansion);
+        return NULL;
+    }
+
+    value_set->expansion = expansion;
+    fhir_atomic_store(&value_set->expansion_state, EXPANSION_READY);
+    index->expansion_count++;
+    return expansion;
+}
+
+// Cached expansion, computed on first use; the cache is the only state queries modify
+static const TerminologyExpansion* get_expansion(const FHIRTerminologyIndex* index,
+                                                 TerminologyValueSet* value_set) {
+    if (fhir_atomic_load(&value_set->expansion_state) == EXPANSION_READY) {
+        return value_set->expansion;
+    }
+
+    FHIRTerminologyIndex* cache_owner = (FHIRTerminologyIndex*)index;
+    pthread_mutex_lock(&cache_owner->expansion_lock);
+    const TerminologyExpansion* expansion = expand_value_set(cache_owner, value_set);
+    pthread_mutex_unlock(&cache_owner->expansion_lock);
+    return expansion;
+}
+
+bool fhir_terminology_expand(const FHIRTerminologyIndex* index, const char* value_set,
+                             size_t* concepts, size_t max_concepts, size_t* count) {
+    if (!index || !value_set) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    TerminologyValueSet* definition = resolve_value_set(index, value_set);
+    if (!definition) {
+        FHIR_SET_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Unknown ValueSet");
+        return false;
+    }
+    const TerminologyExpansion* expansion = get_expansion(index, definition);
+    if (!expansion) {
+        return false;
+    }
+
+    size_t written = 0;
+    for (size_t w = 0; concepts && written < max_concepts && w < BITSET_WORDS(expansion->bit_count); w++) {
+        for (uint64_t word = expansion->bits[w]; word && written < max_concepts; word &= word - 1) {
+            uint64_t lowest = word & (~word + 1);
+            concepts[written++] = w * 64 + popcount64(lowest - 1);
+        }
+    }
+    if (count) {
+        *count = expansion->member_count;
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Lookups                                                                    */
+/* ========================================================================== */
+
+const FHIRTerminologyConcept* fhir_terminology_find_concept(const FHIRTerminologyIndex* index,
+                                                            const char* system, const char* code) {
+    if (!system || !code) return NULL;
+
+    const TerminologyEntry* entry = find_entry(index, KEY_CONCEPT, NULL, system, code);
+    return entry ? &index->concepts[entry->head] : NULL;
+}
+
+const FHIRTerminologyConcept* fhir_terminology_get_concept(const FHIRTerminologyIndex* index,
+                                                           size_t concept_index) {
+    if (!index || concept_index >= index->concept_count) return NULL;
+    return &index->concepts[concept_index];
+}
+
+const char* fhir_terminology_lookup_display(const FHIRTerminologyIndex* index,
+                                            const char* system, const char* code) {
+    const FHIRTerminologyConcept* concept = fhir_terminology_find_concept(index, system, code);
+    return concept ? concept->display : NULL;
+}
+
+bool fhir_terminology_value_set_contains(const FHIRTerminologyIndex* index, const char* value_set,
+                                         const char* system, const char* code) {
+    if (!index || !value_set || !system || !code) return false;
+
+    TerminologyValueSet* definition = resolve_value_set(index, value_set);
+    if (!definition) return false;
+
+    const TerminologyEntry* concept = find_entry(index, KEY_CONCEPT, NULL, system, code);
+    if (concept) {
+        const TerminologyExpansion* expansion = get_expansion(index, definition);
+        return expansion && bit_test(expansion->bits, expansion->bit_count, concept->head);
+    }
+
+    // Codes of code systems the index does not hold can only match enumerated concepts
+    return !find_entry(index, KEY_VALUE_SET_EXCLUDE, definition->key, system, code) &&
+           find_entry(index, KEY_VALUE_SET_CODE, definition->key, system, code);
+}
+
+size_t fhir_terminology_translate(const FHIRTerminologyIndex* index, const char* concept_map,
+                                  const char* system, const char* code,
+                                  const FHIRTerminologyTranslation** results, size_t max_results) {
+    if (!system || !code) return 0;
+
+    int kind = concept_map ? KEY_TRANSLATION : KEY_TRANSLATION_ANY;
+    const TerminologyEntry* entry = find_entry(index, kind, concept_map, system, code);
+    if (!entry) return 0;
+
+    size_t count = 0;
+    for (size_t node = entry->head; node != FHIR_TERMINOLOGY_NO_PARENT; count++) {
+        const TerminologyTranslationNode* current = &index->translations[node];
+        if (results && count < max_results) {
+            results[count] = &current->translation;
+        }
+        node = concept_map ? current->next_in_map : current->next_any;
+    }
+    return count;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file fhir_terminology.h
+ * @brief Compiled terminology index for CodeSystem, ValueSet and ConceptMap lookups
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * Replaces nested scans over CodeSystem concepts, ValueSet compose rules and
+ * ConceptMap groups with hash lookups. An index is filled once from
+ * CodeSystem, ValueSet and ConceptMap resources (as cJSON trees or the
+ * structures in fhir_foundation.h), can be saved to a binary file and loaded
+ * again without JSON parsing, and is read-only afterwards, so any number of
+ * threads may query it concurrently.
+ *
+ * ValueSet membership of known concepts is answered from an expansion
+ * bitset computed on first use and cached per ValueSet URL and version.
+ * A cached expansion is dropped only when a CodeSystem it was computed
+ * from gains concepts, or when ValueSet definitions are added.
+ */
+
+#ifndef FHIR_TERMINOLOGY_H
+#define FHIR_TERMINOLOGY_H
+
+#include "common/fhir_common.h"
+#include "fhir_foundation.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+#define FHIR_TERMINOLOGY_NO_PARENT ((size_t)-1)
+
+/**
+ * @brief Concept defined by a CodeSystem
+ */
+typedef struct {
+    const char* system;         /**< CodeSystem.url */
+    const char* code;
+    const char* display;        /**< NULL when the concept has no display */
+    size_t parent;              /**< Index of the enclosing concept, FHIR_TERMINOLOGY_NO_PARENT at the root */
+} FHIRTerminologyConcept;
+
+/**
+ * @brief One target of a ConceptMap element
+ */
+typedef struct {
+    const char* concept_map;    /**< ConceptMap.url */
+    const char* source_system;
+    const char* source_code;
+    const char* target_system;
+    const char* target_code;    /**< NULL for unmatched targets */
+    const char* target_display;
+    const char* equivalence;    /**< Target relationship/equivalence code, can be NULL */
+} FHIRTerminologyTranslation;
+
+/**
+ * @brief Index size counters
+ */
+typedef struct {
+    size_t concept_count;       /**< Concepts from all CodeSystems */
+    size_t value_set_count;     /**< ValueSet definitions (per URL and version) */
+    size_t value_set_rule_count; /**< Included/excluded codes, whole-system or filtered rules and imports */
+    size_t expansion_count;     /**< ValueSet expansions currently cached */
+    size_t translation_count;   /**< ConceptMap targets */
+    size_t bytes_used;          /**< Memory held by strings and tables */
+} FHIRTerminologyStats;
+
+/**
+ * @brief Opaque terminology index
+ */
+typedef struct FHIRTerminologyIndex FHIRTerminologyIndex;
+
+/* ========================================================================== */
+/* Index Lifecycle                                                            */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty index
+ * @return New index or NULL on failure
+ */
+FHIRTerminologyIndex* fhir_terminology_index_create(void);
+
+/**
+ * @brief Destroy an index and everything it owns
+ * @param index Index to destroy (can be NULL)
+ */
+void fhir_terminology_index_destroy(FHIRTerminologyIndex* index);
+
+/**
+ * @brief Get index size counters
+ * @param index Index to query
+ * @param stats Output counters
+ */
+void fhir_terminology_index_get_stats(const FHIRTerminologyIndex* index, FHIRTerminologyStats* stats);
+
+/**
+ * @brief Write an index to a binary file
+ * @param index Index to save
+ * @param path Destination file (replaced if it exists)
+ * @return true on success, false on failure (FHIR_ERROR_IO)
+ */
+bool fhir_terminology_index_save(const FHIRTerminologyIndex* index, const char* path);
+
+/**
+ * @brief Load an index written by fhir_terminology_index_save
+ * @param path Source file
+ * @return New index or NULL on failure (FHIR_ERROR_IO or FHIR_ERROR_PARSE_FAILED)
+ */
+FHIRTerminologyIndex* fhir_terminology_index_load(const char* path);
+
+/* ========================================================================== */
+/* Building                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Add a concept of a code system
+ * @param index Index to fill
+ * @param system Code system URL
+ * @param code Concept code
+ * @param display Display text (can be NULL)
+ * @param parent Index of the parent concept or FHIR_TERMINOLOGY_NO_PARENT
+ * @return Index of the concept, or FHIR_TERMINOLOGY_NO_PARENT on failure
+ */
+size_t fhir_terminology_add_concept(FHIRTerminologyIndex* index, const char* system,
+                                    const char* code, const char* display, size_t parent);
+
+/**
+ * @brief Add every concept of a CodeSystem resource, following nested concepts
+ * @param index Index to fill
+ * @param code_system CodeSystem JSON (must have a url)
+ * @return true on success, false on failure
+ */
+bool fhir_terminology_add_code_system_json(FHIRTerminologyIndex* index, const cJSON* code_system);
+
+/**
+ * @brief Add every concept of a CodeSystem structure, following nested concepts
+ * @param index Index to fill
+ * @param code_system CodeSystem (must have a url)
+ * @return true on success, false on failure
+ */
+bool fhir_terminology_add_code_system(FHIRTerminologyIndex* index, const FHIRCodeSystem* code_system);
+
+/**
+ * @brief Add the compose rules of a ValueSet resource
+ *
+ * Enumerated concepts, whole code systems, hierarchy filters (is-a,
+ * descendent-of, is-not-a, generalizes, and =, in, not-in on the code) and
+ * valueSet imports are supported. The rules are stored under the ValueSet's
+ * url and version; adding the same url and version again adds to its rules.
+ *
+ * @param index Index to fill
+ * @param value_set ValueSet JSON (must have a url)
+ * @return true on success, false on failure
+ */
+bool fhir_terminology_add_value_set_json(FHIRTerminologyIndex* index, const cJSON* value_set);
+
+/**
+ * @brief Add the compose rules of a ValueSet, as fhir_terminology_add_value_set_json
+ * @param index Index to fill
+ * @param url ValueSet canonical URL
+ * @param version ValueSet version (can be NULL)
+ * @param compose ValueSet.compose
+ * @return true on success, false on failure
+ */
+bool fhir_terminology_add_value_set_compose(FHIRTerminologyIndex* index, const char* url,
+                                            const char* version, const ValueSetCompose* compose);
+
+/**
+ * @brief Add every group/element/target of a ConceptMap resource
+ * @param index Index to fill
+ * @param concept_map ConceptMap JSON (must have a url)
+ * @return true on success, false on failure
+ */
+bool fhir_terminology_add_concept_map_json(FHIRTerminologyIndex* index, const cJSON* concept_map);
+
+/* ========================================================================== */
+/* Lookups                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Find a concept by code system and code
+ * @param index Index to query
+ * @param system Code system URL
+ * @param code Concept code
+ * @return Concept or NULL if unknown
+ */
+const FHIRTerminologyConcept* fhir_terminology_find_concept(const FHIRTerminologyIndex* index,
+                                                            const char* system, const char* code);
+
+/**
+ * @brief Get the concept stored at an index (e.g. a concept's parent)
+ * @param index Index to query
+ * @param concept_index Value returned by fhir_terminology_add_concept or a parent field
+ * @return Concept or NULL if out of range
+ */
+const FHIRTerminologyConcept* fhir_terminology_get_concept(const FHIRTerminologyIndex* index,
+                                                           size_t concept_index);
+
+/**
+ * @brief Look up the display text of a code
+ * @param index Index to query
+ * @param system Code system URL
+ * @param code Concept code
+ * @return Display (owned by the index) or NULL if unknown or without display
+ */
+const char* fhir_terminology_lookup_display(const FHIRTerminologyIndex* index,
+                                            const char* system, const char* code);
+
+/**
+ * @brief Check whether a ValueSet's compose rules include a code ($validate-code)
+ *
+ * Concepts known to the index are tested against the cached expansion of
+ * the ValueSet (computed on first use). Codes of code systems the index
+ * does not hold can only match enumerated include concepts.
+ *
+ * @param index Index to query
+ * @param value_set ValueSet canonical URL, optionally with a |version suffix
+ * @param system Code system URL
+ * @param code Concept code
+ * @return true if included and not excluded
+ */
+bool fhir_terminology_value_set_contains(const FHIRTerminologyIndex* index, const char* value_set,
+                                         const char* system, const char* code);
+
+/**
+ * @brief Expand a ValueSet against the indexed code systems
+ *
+ * The expansion is cached, so repeated calls (and value_set_contains) only
+ * copy or test bits. Codes of code systems the index does not hold are not
+ * part of an expansion.
+ *
+ * @param index Index to query
+ * @param value_set ValueSet canonical URL, optionally with a |version suffix
+ * @param concepts Output for up to max_concepts concept indices in ascending order (can be NULL)
+ * @param max_concepts Capacity of concepts
+ * @param count Output total number of concepts in the expansion (can be NULL)
+ * @return true on success, false if the ValueSet is unknown, imports itself
+ *         or uses an unsupported filter (FHIR_ERROR_VALIDATION_FAILED)
+ */
+bool fhir_terminology_expand(const FHIRTerminologyIndex* index, const char* value_set,
+                             size_t* concepts, size_t max_concepts, size_t* count);
+
+/**
+ * @brief Translate a code through ConceptMaps
+ * @param index Index to query
+ * @param concept_map ConceptMap canonical URL, or NULL to search every map
+ * @param system Source code system URL
+ * @param code Source code
+ * @param results Output for up to max_results targets, in ConceptMap order (can be NULL)
+ * @param max_results Capacity of results
+ * @return Total number of targets (may exceed max_results)
+ */
+size_t fhir_terminology_translate(const FHIRTerminologyIndex* index, const char* concept_map,
+                                  const char* system, const char* code,
+                                  const FHIRTerminologyTranslation** results, size_t max_results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_TERMINOLOGY_H */
@@ -0,0 +1,368 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_terminology.h"
+#include "common/fhir_json_reader.h"
+
+// Python wrapper for the compiled terminology index
+
+typedef struct {
+    PyObject_HEAD
+    FHIRTerminologyIndex* index;
+} TerminologyIndex;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* index_type;
+} TerminologyModuleState;
+
+static PyObject* set_terminology_error(const char* fallback) {
+    const FHIRError* error = fhir_get_last_error();
+    // Failed allocations leave no error set
+    if (!error || error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+        return PyErr_NoMemory();
+    }
+    PyErr_SetString(error->code == FHIR_ERROR_IO ? PyExc_OSError : PyExc_ValueError,
+                    error->message ? error->message : fallback);
+    return NULL;
+}
+
+static int TerminologyIndex_init(TerminologyIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+        return -1;
+    }
+
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    if (!index) {
+        set_terminology_error("Failed to create terminology index");
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_terminology_index_destroy(self->index);
+    self->index = index;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void TerminologyIndex_dealloc(TerminologyIndex* self) {
+    fhir_terminology_index_destroy(self->index);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static PyObject* add_resource(TerminologyIndex* self, PyObject* args,
+                              bool (*add)(FHIRTerminologyIndex*, const cJSON*)) {
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "s*", &view)) {
+        return NULL;
+    }
+
+    cJSON* json = fhir_json_parse(view.buf, (size_t)view.len);
+    PyBuffer_Release(&view);
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+
+    // Adding rewrites the hash tables that concurrent lookups walk
+    bool ok;
+    fhir_clear_error();
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    ok = add(self->index, json);
+    FHIR_PY_END_CRITICAL_SECTION();
+    cJSON_Delete(json);
+    if (!ok) {
+        return set_terminology_error("Failed to index resource");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* TerminologyIndex_add_code_system(TerminologyIndex* self, PyObject* args) {
+    return add_resource(self, args, fhir_terminology_add_code_system_json);
+}
+
+static PyObject* TerminologyIndex_add_value_set(TerminologyIndex* self, PyObject* args) {
+    return add_resource(self, args, fhir_terminology_add_value_set_json);
+}
+
+static PyObject* TerminologyIndex_add_concept_map(TerminologyIndex* self, PyObject* args) {
+    return add_resource(self, args, fhir_terminology_add_concept_map_json);
+}
+
+static PyObject* TerminologyIndex_lookup_display(TerminologyIndex* self, PyObject* args) {
+    const char* system;
+    const char* code;
+    if (!PyArg_ParseTuple(args, "ss", &system, &code)) {
+        return NULL;
+    }
+
+    PyObject* result;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    const char* display = fhir_terminology_lookup_display(self->index, system, code);
+    if (display) {
+        result = PyUnicode_FromString(display);
+    } else {
+        result = Py_None;
+        Py_INCREF(result);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* TerminologyIndex_contains_code(TerminologyIndex* self, PyObject* args) {
+    const char* value_set;
+    const char* system;
+    const char* code;
+    if (!PyArg_ParseTuple(args, "sss", &value_set, &system, &code)) {
+        return NULL;
+    }
+    bool contains;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    contains = fhir_terminology_value_set_contains(self->index, value_set, system, code);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return PyBool_FromLong(contains);
+}
+
+static PyObject* expand_value_set(TerminologyIndex* self, const char* value_set) {
+    size_t count;
+    fhir_clear_error();
+    if (!fhir_terminology_expand(self->index, value_set, NULL, 0, &count)) {
+        return set_terminology_error("Failed to expand ValueSet");
+    }
+
+    size_t* concepts = PyMem_Malloc((count ? count : 1) * sizeof(size_t));
+    if (!concepts) {
+        return PyErr_NoMemory();
+    }
+    fhir_terminology_expand(self->index, value_set, concepts, count, NULL);
+
+    PyObject* list = PyList_New((Py_ssize_t)count);
+    for (size_t i = 0; list && i < count; i++) {
+        const FHIRTerminologyConcept* concept = fhir_terminology_get_concept(self->index, concepts[i]);
+        PyObject* item = Py_BuildValue("(ss)", concept->system, concept->code);
+        if (!item) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+
+    PyMem_Free(concepts);
+    return list;
+}
+
+static PyObject* TerminologyIndex_expand(TerminologyIndex* self, PyObject* args) {
+    const char* value_set;
+    if (!PyArg_ParseTuple(args, "s", &value_set)) {
+        return NULL;
+    }
+
+    PyObject* result;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    result = expand_value_set(self, value_set);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static int set_item_string(PyObject* dict, const char* key, const char* value) {
+    if (!value) {
+        return PyDict_SetItemString(dict, key, Py_None);
+    }
+    PyObject* item = PyUnicode_FromString(value);
+    if (!item) {
+        return -1;
+    }
+    int result = PyDict_SetItemString(dict, key, item);
+    Py_DECREF(item);
+    return result;
+}
+
+static PyObject* translate_code(TerminologyIndex* self, const char* system, const char* code,
+                                const char* concept_map) {
+    size_t count = fhir_terminology_translate(self->index, concept_map, system, code, NULL, 0);
+    PyObject* list = PyList_New((Py_ssize_t)count);
+    if (!list || count == 0) {
+        return list;
+    }
+
+    const FHIRTerminologyTranslation** results = PyMem_Malloc(count * sizeof(*results));
+    if (!results) {
+        Py_DECREF(list);
+        return PyErr_NoMemory();
+    }
+    fhir_terminology_translate(self->index, concept_map, system, code, results, count);
+
+    for (size_t i = 0; i < count; i++) {
+        PyObject* item = PyDict_New();
+        if (!item ||
+            set_item_string(item, "concept_map", results[i]->concept_map) < 0 ||
+            set_item_string(item, "system", results[i]->target_system) < 0 ||
+            set_item_string(item, "code", results[i]->target_code) < 0 ||
+            set_item_string(item, "display", results[i]->target_display) < 0 ||
+            set_item_string(item, "equivalence", results[i]->equivalence) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            PyMem_Free(results);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, (Py_ssize_t)i, item);
+    }
+
+    PyMem_Free(results);
+    return list;
+}
+
+static PyObject* TerminologyIndex_translate(TerminologyIndex* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"system", "code", "concept_map", NULL};
+    const char* system;
+    const char* code;
+    const char* concept_map = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ss|z", kwlist, &system, &code, &concept_map)) {
+        return NULL;
+    }
+
+    PyObject* result;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    result = translate_code(self, system, code, concept_map);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return result;
+}
+
+static PyObject* TerminologyIndex_save(TerminologyIndex* self, PyObject* args) {
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) {
+        return NULL;
+    }
+
+    // Not a critical section: the index must not be added to while it is saved
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = fhir_terminology_index_save(self->index, path);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        return set_terminology_error("Failed to save terminology index");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* TerminologyIndex_load(PyTypeObject* type, PyObject* args) {
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) {
+        return NULL;
+    }
+
+    FHIRTerminologyIndex* index;
+    Py_BEGIN_ALLOW_THREADS
+    index = fhir_terminology_index_load(path);
+    Py_END_ALLOW_THREADS
+    if (!index) {
+        return set_terminology_error("Failed to load terminology index");
+    }
+
+    TerminologyIndex* self = (TerminologyIndex*)type->tp_alloc(type, 0);
+    if (!self) {
+        fhir_terminology_index_destroy(index);
+        return NULL;
+    }
+    self->index = index;
+    return (PyObject*)self;
+}
+
+static PyObject* TerminologyIndex_stats(TerminologyIndex* self, PyObject* Py_UNUSED(ignored)) {
+    FHIRTerminologyStats stats;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_terminology_index_get_stats(self->index, &stats);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:n}",
+                         "concepts", (Py_ssize_t)stats.concept_count,
+                         "value_sets", (Py_ssize_t)stats.value_set_count,
+                         "value_set_rules", (Py_ssize_t)stats.value_set_rule_count,
+                         "expansions", (Py_ssize_t)stats.expansion_count,
+                         "translations", (Py_ssize_t)stats.translation_count,
+                         "bytes_used", (Py_ssize_t)stats.bytes_used);
+}
+
+static PyMethodDef TerminologyIndexMethods[] = {
+    {"add_code_system", (PyCFunction)TerminologyIndex_add_code_system, METH_VARARGS,
+     "Index the concepts of a CodeSystem JSON string"},
+    {"add_value_set", (PyCFunction)TerminologyIndex_add_value_set, METH_VARARGS,
+     "Index the compose rules of a ValueSet JSON string"},
+    {"add_concept_map", (PyCFunction)TerminologyIndex_add_concept_map, METH_VARARGS,
+     "Index the mappings of a ConceptMap JSON string"},
+    {"lookup_display", (PyCFunction)TerminologyIndex_lookup_display, METH_VARARGS,
+     "Display of (system, code), or None"},
+    {"contains_code", (PyCFunction)TerminologyIndex_contains_code, METH_VARARGS,
+     "Whether ValueSet value_set includes (system, code)"},
+    {"expand", (PyCFunction)TerminologyIndex_expand, METH_VARARGS,
+     "(system, code) of every indexed concept in ValueSet value_set"},
+    {"translate", (PyCFunction)TerminologyIndex_translate, METH_VARARGS | METH_KEYWORDS,
+     "Targets of (system, code) in one ConceptMap or all of them"},
+    {"save", (PyCFunction)TerminologyIndex_save, METH_VARARGS, "Write the index to a binary file"},
+    {"load", (PyCFunction)TerminologyIndex_load, METH_VARARGS | METH_CLASS,
+     "Read an index written by save()"},
+    {"stats", (PyCFunction)TerminologyIndex_stats, METH_NOARGS, "Index size counters"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot TerminologyIndexSlots[] = {
+    {Py_tp_doc, "Hash index over CodeSystem concepts, ValueSet rules and ConceptMap targets"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, TerminologyIndex_init},
+    {Py_tp_dealloc, TerminologyIndex_dealloc},
+    {Py_tp_methods, TerminologyIndexMethods},
+    {0, NULL}
+};
+
+static PyType_Spec TerminologyIndexSpec = {
+    .name = "fhir_terminology_c.TerminologyIndex",
+    .basicsize = sizeof(TerminologyIndex),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = TerminologyIndexSlots,
+};
+
+static int terminology_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    TerminologyModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->index_type);
+    return 0;
+}
+
+static int terminology_module_clear(PyObject* module) {
+    TerminologyModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->index_type);
+    return 0;
+}
+
+static void terminology_module_free(void* module) {
+    terminology_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int terminology_module_exec(PyObject* module) {
+    TerminologyModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+
+    state->index_type = fhir_python_add_type(module, &TerminologyIndexSpec);
+    return state->index_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot terminology_module_slots[] = FHIR_PY_MODULE_SLOTS(terminology_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_terminology_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_terminology_c",
+    "Compiled FHIR terminology index in C",
+    sizeof(TerminologyModuleState),
+    NULL,
+    terminology_module_slots,
+    terminology_module_traverse,
+    terminology_module_clear,
+    terminology_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_terminology_c(void) {
+    return PyModuleDef_Init(&fhir_terminology_module);
+}
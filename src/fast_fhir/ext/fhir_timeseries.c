@@ -0,0 +1,479 @@
+/**
+ * @file fhir_timeseries.c
+ * @brief Fixed-capacity sample ring for DeviceMetric/Observation streams
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "fhir_timeseries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MICROSECONDS_PER_SECOND INT64_C(1000000)
+#define MICROSECONDS_PER_DAY (INT64_C(86400) * MICROSECONDS_PER_SECOND)
+#define UCUM_SYSTEM "http://unitsofmeasure.org"
+
+/* ========================================================================== */
+/* Series Structure                                                           */
+/* ========================================================================== */
+
+struct FHIRTimeSeries {
+    FHIRTimeSeriesInfo info;     // Strings owned by the series
+    FHIRTimeSeriesSample* samples;
+    size_t capacity;
+    size_t head;                 // Ring position of the oldest sample
+    size_t count;
+    size_t pending;              // The newest pending samples are not flushed yet
+    uint64_t dropped;
+};
+
+static char* copy_optional(const char* text, bool* ok) {
+    if (!text) return NULL;
+    char* copy = fhir_strdup(text);
+    if (!copy) *ok = false;
+    return copy;
+}
+
+static void free_info(FHIRTimeSeriesInfo* info) {
+    fhir_free((char*)info->metric);
+    fhir_free((char*)info->device);
+    fhir_free((char*)info->subject);
+    fhir_free((char*)info->code_system);
+    fhir_free((char*)info->code);
+    fhir_free((char*)info->display);
+    fhir_free((char*)info->unit);
+    fhir_free((char*)info->unit_code);
+}
+
+FHIRTimeSeries* fhir_timeseries_create(const FHIRTimeSeriesInfo* info, size_t capacity) {
+    if (capacity == 0) capacity = FHIR_TIMESERIES_DEFAULT_CAPACITY;
+    if (capacity > SIZE_MAX / sizeof(FHIRTimeSeriesSample)) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Time series capacity too large");
+        return NULL;
+    }
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    FHIRTimeSeries* series = fhir_calloc(1, sizeof(FHIRTimeSeries));
+    bool ok = series != NULL;
+    if (ok) {
+        series->capacity = capacity;
+        series->samples = fhir_malloc(capacity * sizeof(FHIRTimeSeriesSample));
+        ok = series->samples != NULL;
+    }
+    if (ok && info) {
+        series->info.metric = copy_optional(info->metric, &ok);
+        series->info.device = copy_optional(info->device, &ok);
+        series->info.subject = copy_optional(info->subject, &ok);
+        series->info.code_system = copy_optional(info->code_system, &ok);
+        series->info.code = copy_optional(info->code, &ok);
+        series->info.display = copy_optional(info->display, &ok);
+        series->info.unit = copy_optional(info->unit, &ok);
+        series->info.unit_code = copy_optional(info->unit_code, &ok);
+    }
+    fhir_arena_set_current(previous);
+
+    if (!ok) {
+        fhir_timeseries_destroy(series);
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate time series");
+        return NULL;
+    }
+    return series;
+}
+
+// First coding of a CodeableConcept member
+static const cJSON* first_coding(const cJSON* json, const char* name) {
+    const cJSON* concept = cJSON_GetObjectItemCaseSensitive(json, name);
+    const cJSON* codings = cJSON_IsObject(concept) ? cJSON_GetObjectItemCaseSensitive(concept, "coding") : NULL;
+    const cJSON* coding = cJSON_IsArray(codings) ? cJSON_GetArrayItem(codings, 0) : NULL;
+    return cJSON_IsObject(coding) ? coding : NULL;
+}
+
+static const char* reference_of(const cJSON* json, const char* name) {
+    const cJSON* reference = cJSON_GetObjectItemCaseSensitive(json, name);
+    return cJSON_IsObject(reference) ? fhir_json_get_string(reference, "reference") : NULL;
+}
+
+FHIRTimeSeries* fhir_timeseries_create_from_json(const cJSON* device_metric, const char* subject,
+                                                 size_t capacity) {
+    const char* type = cJSON_IsObject(device_metric) ? fhir_json_get_string(device_metric, "resourceType") : NULL;
+    if (!type || strcmp(type, "DeviceMetric") != 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Expected a DeviceMetric");
+        return NULL;
+    }
+
+    FHIRTimeSeriesInfo info;
+    memset(&info, 0, sizeof(info));
+    info.subject = subject;
+    info.device = reference_of(device_metric, "device");
+    if (!info.device) info.device = reference_of(device_metric, "source");
+
+    const cJSON* code = first_coding(device_metric, "type");
+    if (code) {
+        info.code_system = fhir_json_get_string(code, "system");
+        info.code = fhir_json_get_string(code, "code");
+        info.display = fhir_json_get_string(code, "display");
+    }
+    const cJSON* unit = first_coding(device_metric, "unit");
+    if (unit) {
+        info.unit_code = fhir_json_get_string(unit, "code");
+        info.unit = fhir_json_get_string(unit, "display");
+        if (!info.unit) info.unit = info.unit_code;
+    }
+
+    // "DeviceMetric/" + id
+    char metric[128];
+    const char* id = fhir_json_get_string(device_metric, "id");
+    if (id && strlen(id) < sizeof(metric) - sizeof("DeviceMetric/")) {
+        snprintf(metric, sizeof(metric), "DeviceMetric/%s", id);
+        info.metric = metric;
+    }
+
+    return fhir_timeseries_create(&info, capacity);
+}
+
+void fhir_timeseries_destroy(FHIRTimeSeries* series) {
+    if (!series) return;
+
+    FHIRArena* previous = fhir_arena_set_current(NULL);
+    free_info(&series->info);
+    fhir_free(series->samples);
+    fhir_free(series);
+    fhir_arena_set_current(previous);
+}
+
+const FHIRTimeSeriesInfo* fhir_timeseries_info(const FHIRTimeSeries* series) {
+    return series ? &series->info : NULL;
+}
+
+/* ========================================================================== */
+/* Samples                                                                    */
+/* ========================================================================== */
+
+// Ring position of the sample index places after the oldest one
+static size_t ring_position(const FHIRTimeSeries* series, size_t index) {
+    size_t position = series->head + index;
+    return position < series->capacity ? position : position - series->capacity;
+}
+
+static const FHIRTimeSeriesSample* sample_at(const FHIRTimeSeries* series, size_t index) {
+    return &series->samples[ring_position(series, index)];
+}
+
+bool fhir_timeseries_push(FHIRTimeSeries* series, int64_t timestamp, double value) {
+    if (!series) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (series->count && timestamp < sample_at(series, series->count - 1)->timestamp) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Sample is older than the last sample");
+        return false;
+    }
+
+    if (series->count == series->capacity) {
+        // Overwrite the oldest sample
+        series->samples[series->head].timestamp = timestamp;
+        series->samples[series->head].value = value;
+        series->head = series->head + 1 == series->capacity ? 0 : series->head + 1;
+        if (series->pending == series->capacity) {
+            series->dropped++;
+        } else {
+            series->pending++;
+        }
+        return true;
+    }
+
+    FHIRTimeSeriesSample* sample = &series->samples[ring_position(series, series->count)];
+    sample->timestamp = timestamp;
+    sample->value = value;
+    series->count++;
+    series->pending++;
+    return true;
+}
+
+size_t fhir_timeseries_push_many(FHIRTimeSeries* series, const FHIRTimeSeriesSample* samples, size_t count) {
+    if (!samples) return 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!fhir_timeseries_push(series, samples[i].timestamp, samples[i].value)) return i;
+    }
+    return count;
+}
+
+size_t fhir_timeseries_count(const FHIRTimeSeries* series) {
+    return series ? series->count : 0;
+}
+
+size_t fhir_timeseries_capacity(const FHIRTimeSeries* series) {
+    return series ? series->capacity : 0;
+}
+
+size_t fhir_timeseries_pending(const FHIRTimeSeries* series) {
+    return series ? series->pending : 0;
+}
+
+uint64_t fhir_timeseries_dropped(const FHIRTimeSeries* series) {
+    return series ? series->dropped : 0;
+}
+
+bool fhir_timeseries_get(const FHIRTimeSeries* series, size_t index, FHIRTimeSeriesSample* sample) {
+    if (!series || !sample || index >= series->count) return false;
+    *sample = *sample_at(series, index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Windows                                                                    */
+/* ========================================================================== */
+
+// Index of the first sample at or after timestamp
+static size_t lower_bound(const FHIRTimeSeries* series, int64_t timestamp) {
+    size_t low = 0, high = series->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (sample_at(series, middle)->timestamp < timestamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool fhir_timeseries_stats(const FHIRTimeSeries* series, int64_t start, int64_t end, FHIRTimeSeriesStats* stats) {
+    if (!series || !stats) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    size_t first = lower_bound(series, start);
+    size_t last = start < end ? lower_bound(series, end) : first;
+    if (first >= last) return true;
+
+    double sum = 0.0;
+    stats->min = stats->max = sample_at(series, first)->value;
+    for (size_t i = first; i < last; i++) {
+        double value = sample_at(series, i)->value;
+        if (value < stats->min) stats->min = value;
+        if (value > stats->max) stats->max = value;
+        sum += value;
+    }
+    stats->count = last - first;
+    stats->mean = sum / (double)stats->count;
+    stats->first = sample_at(series, first)->timestamp;
+    stats->last = sample_at(series, last - 1)->timestamp;
+    return true;
+}
+
+size_t fhir_timeseries_downsample(const FHIRTimeSeries* series, int64_t start, int64_t end, int64_t width,
+                                  FHIRTimeSeriesBucket* buckets, size_t max_buckets) {
+    if (!series || !buckets || width <= 0 || start >= end) return 0;
+
+    size_t written = 0;
+    double sum = 0.0;
+    FHIRTimeSeriesBucket* bucket = NULL;
+    for (size_t i = lower_bound(series, start); i < series->count; i++) {
+        const FHIRTimeSeriesSample* sample = sample_at(series, i);
+        if (sample->timestamp >= end) break;
+
+        // Samples are ordered, so a new bucket closes the previous one
+        int64_t bucket_start = start + (sample->timestamp - start) / width * width;
+        if (!bucket || bucket->start != bucket_start) {
+            if (bucket) bucket->mean = sum / (double)bucket->count;
+            if (written == max_buckets) return written;
+            bucket = &buckets[written++];
+            bucket->start = bucket_start;
+            bucket->count = 0;
+            bucket->min = bucket->max = sample->value;
+            sum = 0.0;
+        }
+        if (sample->value < bucket->min) bucket->min = sample->value;
+        if (sample->value > bucket->max) bucket->max = sample->value;
+        sum += sample->value;
+        bucket->count++;
+    }
+    if (bucket) bucket->mean = sum / (double)bucket->count;
+    return written;
+}
+
+/* ========================================================================== */
+/* Flushing                                                                   */
+/* ========================================================================== */
+
+// FHIR instant text, with a fraction only when the timestamp has one
+static void format_instant(int64_t timestamp, char* text, size_t size) {
+    int year, month, day;
+    fhir_datetime_to_civil(timestamp, &year, &month, &day);
+    int64_t of_day = timestamp % MICROSECONDS_PER_DAY;
+    if (of_day < 0) of_day += MICROSECONDS_PER_DAY;
+
+    int seconds = (int)(of_day / MICROSECONDS_PER_SECOND);
+    int fraction = (int)(of_day % MICROSECONDS_PER_SECOND);
+    int length = snprintf(text, size, "%04d-%02d-%02dT%02d:%02d:%02d", year, month, day,
+                          seconds / 3600, seconds / 60 % 60, seconds % 60);
+    if (fraction % 1000 != 0) {
+        snprintf(text + length, size - (size_t)length, ".%06dZ", fraction);
+    } else if (fraction != 0) {
+        snprintf(text + length, size - (size_t)length, ".%03dZ", fraction / 1000);
+    } else {
+        snprintf(text + length, size - (size_t)length, "Z");
+    }
+}
+
+static void write_optional(FHIRWriter* writer, const char* key, const char* value) {
+    if (value) fhir_writer_member_string(writer, key, value);
+}
+
+static void write_reference(FHIRWriter* writer, const char* key, const char* reference) {
+    if (!reference) return;
+    fhir_writer_key(writer, key);
+    fhir_writer_begin_object(writer);
+    fhir_writer_member_string(writer, "reference", reference);
+    fhir_writer_end_object(writer);
+}
+
+// Members every flushed Observation starts with
+static void write_header(FHIRWriter* writer, const FHIRTimeSeriesInfo* info) {
+    fhir_writer_member_string(writer, "resourceType", "Observation");
+    fhir_writer_member_string(writer, "status", "final");
+    fhir_writer_key(writer, "code");
+    fhir_writer_begin_object(writer);
+    if (info->code_system || info->code || info->display) {
+        fhir_writer_key(writer, "coding");
+        fhir_writer_begin_array(writer);
+        fhir_writer_begin_object(writer);
+        write_optional(writer, "system", info->code_system);
+        write_optional(writer, "code", info->code);
+        write_optional(writer, "display", info->display);
+        fhir_writer_end_object(writer);
+        fhir_writer_end_array(writer);
+    }
+    fhir_writer_end_object(writer);
+    write_reference(writer, "subject", info->subject);
+    // R5 Observation.device accepts a DeviceMetric
+    write_reference(writer, "device", info->metric ? info->metric : info->device);
+}
+
+static void write_unit(FHIRWriter* writer, const FHIRTimeSeriesInfo* info) {
+    write_optional(writer, "unit", info->unit);
+    if (info->unit_code) {
+        fhir_writer_member_string(writer, "system", UCUM_SYSTEM);
+        fhir_writer_member_string(writer, "code", info->unit_code);
+    }
+}
+
+static bool write_observations(const FHIRTimeSeries* series, size_t first, FHIRWriter* writer) {
+    char instant[40];
+    for (size_t i = first; i < series->count; i++) {
+        const FHIRTimeSeriesSample* sample = sample_at(series, i);
+        format_instant(sample->timestamp, instant, sizeof(instant));
+
+        fhir_writer_begin_object(writer);
+        write_header(writer, &series->info);
+        fhir_writer_member_string(writer, "effectiveDateTime", instant);
+        fhir_writer_key(writer, "valueQuantity");
+        fhir_writer_begin_object(writer);
+        fhir_writer_key(writer, "value");
+        fhir_writer_double(writer, sample->value);
+        write_unit(writer, &series->info);
+        fhir_writer_end_object(writer);
+        fhir_writer_end_object(writer);
+        if (!fhir_writer_end_line(writer)) return false;
+    }
+    return true;
+}
+
+// Space separated decimals for SampledData.offsets and SampledData.data
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} DecimalList;
+
+static bool decimal_list_append(DecimalList* list, double value) {
+    if (list->capacity - list->length < 32) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        char* data = fhir_realloc(list->data, capacity);
+        if (!data) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to grow SampledData text");
+            return false;
+        }
+        list->data = data;
+        list->capacity = capacity;
+    }
+    if (list->length) list->data[list->length++] = ' ';
+    list->length += (size_t)snprintf(list->data + list->length, list->capacity - list->length, "%.15g", value);
+    return true;
+}
+
+static bool write_sampled_data(const FHIRTimeSeries* series, size_t first, FHIRWriter* writer) {
+    int64_t origin = sample_at(series, first)->timestamp;
+    DecimalList offsets = { NULL, 0, 0 };
+    DecimalList data = { NULL, 0, 0 };
+    bool ok = true;
+    for (size_t i = first; ok && i < series->count; i++) {
+        const FHIRTimeSeriesSample* sample = sample_at(series, i);
+        ok = decimal_list_append(&offsets, (double)(sample->timestamp - origin) / 1000.0) &&
+             decimal_list_append(&data, sample->value);
+    }
+
+    if (ok) {
+        char start[40], end[40];
+        format_instant(origin, start, sizeof(start));
+        format_instant(sample_at(series, series->count - 1)->timestamp, end, sizeof(end));
+
+        fhir_writer_begin_object(writer);
+        write_header(writer, &series->info);
+        fhir_writer_key(writer, "effectivePeriod");
+        fhir_writer_begin_object(writer);
+        fhir_writer_member_string(writer, "start", start);
+        fhir_writer_member_string(writer, "end", end);
+        fhir_writer_end_object(writer);
+        fhir_writer_key(writer, "valueSampledData");
+        fhir_writer_begin_object(writer);
+        fhir_writer_key(writer, "origin");
+        fhir_writer_begin_object(writer);
+        fhir_writer_member_int(writer, "value", 0);
+        write_unit(writer, &series->info);
+        fhir_writer_end_object(writer);
+        // Offsets are milliseconds from effectivePeriod.start
+        fhir_writer_member_string(writer, "intervalUnit", "ms");
+        fhir_writer_member_int(writer, "dimensions", 1);
+        fhir_writer_key(writer, "offsets");
+        fhir_writer_string_n(writer, offsets.data, offsets.length);
+        fhir_writer_key(writer, "data");
+        fhir_writer_string_n(writer, data.data, data.length);
+        fhir_writer_end_object(writer);
+        fhir_writer_end_object(writer);
+        ok = fhir_writer_end_line(writer);
+    }
+
+    fhir_free(offsets.data);
+    fhir_free(data.data);
+    return ok;
+}
+
+bool fhir_timeseries_flush(FHIRTimeSeries* series, FHIRTimeSeriesFlushMode mode, FHIRWriter* writer,
+                           size_t* written) {
+    if (written) *written = 0;
+    if (!series || !writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (series->pending == 0) return true;
+
+    size_t first = series->count - series->pending;
+    bool ok;
+    if (mode == FHIR_TIMESERIES_FLUSH_SAMPLED_DATA) {
+        FHIRArena* previous = fhir_arena_set_current(NULL);
+        ok = write_sampled_data(series, first, writer);
+        fhir_arena_set_current(previous);
+    } else {
+        ok = write_observations(series, first, writer);
+    }
+    if (!ok) return false;
+
+    if (written) *written = mode == FHIR_TIMESERIES_FLUSH_SAMPLED_DATA ? 1 : series->pending;
+    series->pending = 0;
+    return true;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file fhir_timeseries.h
+ * @brief Fixed-capacity sample ring for DeviceMetric/Observation streams
+ * @version 0.1.0
+ * @date 2024-01-01
+ *
+ * High-frequency vitals are kept as (timestamp, value) pairs in one
+ * contiguous ring per DeviceMetric instead of one Observation per sample,
+ * 16 bytes a sample. The Observation metadata (code, unit, subject, device)
+ * is stored once per series. Windowed statistics and downsampling run over
+ * the ring directly; Observation JSON is only produced by a flush, either
+ * one Observation per sample or one Observation carrying the batch as R5
+ * SampledData with offsets.
+ *
+ * When the ring is full the oldest sample is overwritten. Samples are
+ * flushed at most once; overwriting a sample that was never flushed counts
+ * it as dropped.
+ */
+
+#ifndef FHIR_TIMESERIES_H
+#define FHIR_TIMESERIES_H
+
+#include "common/fhir_common.h"
+#include "common/fhir_json_writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========================================================================== */
+/* Types                                                                      */
+/* ========================================================================== */
+
+/** Capacity used when none is given */
+#define FHIR_TIMESERIES_DEFAULT_CAPACITY 4096
+
+/**
+ * @brief One sample
+ */
+typedef struct {
+    int64_t timestamp;           /**< Epoch microseconds */
+    double value;
+} FHIRTimeSeriesSample;
+
+/**
+ * @brief Observation metadata shared by every sample of a series
+ *
+ * All members can be NULL; the series keeps its own copies.
+ */
+typedef struct {
+    const char* metric;          /**< DeviceMetric reference, e.g. "DeviceMetric/hr" */
+    const char* device;          /**< Device reference, used when metric is NULL */
+    const char* subject;         /**< Patient reference */
+    const char* code_system;     /**< Observation.code */
+    const char* code;
+    const char* display;
+    const char* unit;            /**< Human readable unit, e.g. "beats/minute" */
+    const char* unit_code;       /**< UCUM code, e.g. "/min" */
+} FHIRTimeSeriesInfo;
+
+/**
+ * @brief Summary of the samples in a window
+ */
+typedef struct {
+    size_t count;
+    double min;
+    double max;
+    double mean;
+    int64_t first;               /**< Timestamp of the first sample */
+    int64_t last;                /**< Timestamp of the last sample */
+} FHIRTimeSeriesStats;
+
+/**
+ * @brief One downsampled bucket
+ */
+typedef struct {
+    int64_t start;               /**< Bucket start in epoch microseconds */
+    size_t count;
+    double min;
+    double max;
+    double mean;
+} FHIRTimeSeriesBucket;
+
+/**
+ * @brief Output form of a flush
+ */
+typedef enum {
+    FHIR_TIMESERIES_FLUSH_OBSERVATIONS = 0,  /**< One Observation per sample */
+    FHIR_TIMESERIES_FLUSH_SAMPLED_DATA       /**< One Observation with valueSampledData */
+} FHIRTimeSeriesFlushMode;
+
+/**
+ * @brief Sample ring (opaque)
+ */
+typedef struct FHIRTimeSeries FHIRTimeSeries;
+
+/* ========================================================================== */
+/* Lifecycle                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Create an empty series
+ * @param info Observation metadata to copy (can be NULL)
+ * @param capacity Samples kept (0 = FHIR_TIMESERIES_DEFAULT_CAPACITY)
+ * @return New series or NULL on allocation failure
+ */
+FHIRTimeSeries* fhir_timeseries_create(const FHIRTimeSeriesInfo* info, size_t capacity);
+
+/**
+ * @brief Create a series for a DeviceMetric JSON tree
+ *
+ * The Observation code comes from DeviceMetric.type, the unit from
+ * DeviceMetric.unit and the device from DeviceMetric.device (R5) or
+ * DeviceMetric.source (R4).
+ *
+ * @param device_metric DeviceMetric JSON with an id
+ * @param subject Patient reference for the Observations (can be NULL)
+ * @param capacity Samples kept (0 = FHIR_TIMESERIES_DEFAULT_CAPACITY)
+ * @return New series or NULL on allocation failure or another resource type
+ */
+FHIRTimeSeries* fhir_timeseries_create_from_json(const cJSON* device_metric, const char* subject,
+                                                 size_t capacity);
+
+/**
+ * @brief Destroy a series
+ * @param series Series to destroy (can be NULL)
+ */
+void fhir_timeseries_destroy(FHIRTimeSeries* series);
+
+/**
+ * @brief Get the Observation metadata of a series
+ * @param series Series to query
+ * @return Metadata owned by the series
+ */
+const FHIRTimeSeriesInfo* fhir_timeseries_info(const FHIRTimeSeries* series);
+
+/* ========================================================================== */
+/* Samples                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Append a sample, overwriting the oldest one when full
+ * @param series Series to append to
+ * @param timestamp Epoch microseconds, not before the last sample
+ * @param value Sample value
+ * @return true on success, false on an out-of-order timestamp or invalid arguments
+ */
+bool fhir_timeseries_push(FHIRTimeSeries* series, int64_t timestamp, double value);
+
+/**
+ * @brief Append samples in order
+ * @param series Series to append to
+ * @param samples Samples to append
+ * @param count Number of samples
+ * @return Number appended; fewer than count when a sample is out of order
+ */
+size_t fhir_timeseries_push_many(FHIRTimeSeries* series, const FHIRTimeSeriesSample* samples, size_t count);
+
+/**
+ * @brief Get the number of samples held
+ * @param series Series to query
+ * @return Sample count
+ */
+size_t fhir_timeseries_count(const FHIRTimeSeries* series);
+
+/**
+ * @brief Get the ring capacity
+ * @param series Series to query
+ * @return Maximum sample count
+ */
+size_t fhir_timeseries_capacity(const FHIRTimeSeries* series);
+
+/**
+ * @brief Get the number of samples not flushed yet
+ * @param series Series to query
+ * @return Pending sample count
+ */
+size_t fhir_timeseries_pending(const FHIRTimeSeries* series);
+
+/**
+ * @brief Get the number of samples overwritten before they were flushed
+ * @param series Series to query
+ * @return Dropped sample count
+ */
+uint64_t fhir_timeseries_dropped(const FHIRTimeSeries* series);
+
+/**
+ * @brief Get a held sample, oldest first
+ * @param series Series to query
+ * @param index Position from the oldest sample
+ * @param sample Output sample
+ * @return true if index is below the sample count
+ */
+bool fhir_timeseries_get(const FHIRTimeSeries* series, size_t index, FHIRTimeSeriesSample* sample);
+
+/* ========================================================================== */
+/* Windows                                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Summarize the samples in [start, end)
+ * @param series Series to query
+ * @param start Inclusive window start (epoch microseconds)
+ * @param end Exclusive window end
+ * @param stats Output summary; count is 0 for an empty window
+ * @return true on success, false on invalid arguments
+ */
+bool fhir_timeseries_stats(const FHIRTimeSeries* series, int64_t start, int64_t end, FHIRTimeSeriesStats* stats);
+
+/**
+ * @brief Aggregate the samples in [start, end) into fixed-width buckets
+ *
+ * Buckets are aligned to start; empty buckets are skipped.
+ *
+ * @param series Series to query
+ * @param start Inclusive window start (epoch microseconds)
+ * @param end Exclusive window end
+ * @param width Bucket width in microseconds
+ * @param buckets Output buckets, oldest first
+ * @param max_buckets Capacity of buckets
+ * @return Number of buckets written, at most max_buckets
+ */
+size_t fhir_timeseries_downsample(const FHIRTimeSeries* series, int64_t start, int64_t end, int64_t width,
+                                  FHIRTimeSeriesBucket* buckets, size_t max_buckets);
+
+/* ========================================================================== */
+/* Flushing                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Write the pending samples as Observation NDJSON and mark them flushed
+ *
+ * Each Observation is followed by a newline. Nothing is written when no
+ * sample is pending.
+ *
+ * @param series Series to flush
+ * @param mode One Observation per sample or one SampledData Observation
+ * @param writer Destination writer
+ * @param written Output number of Observations written (can be NULL)
+ * @return true on success, false on write failure (samples stay pending)
+ */
+bool fhir_timeseries_flush(FHIRTimeSeries* series, FHIRTimeSeriesFlushMode mode, FHIRWriter* writer,
+                           size_t* written);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_TIMESERIES_H */
@@ -0,0 +1,361 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_document.h"
+#include "fhir_python_time.h"
+#include "fhir_timeseries.h"
+
+// Python binding for DeviceMetric time series buffers
+
+// TimeSeries: sample ring for one DeviceMetric, flushed to Observations on demand
+typedef struct {
+    PyObject_HEAD
+    FHIRTimeSeries* series;
+} TimeSeries;
+
+// Per-module state, one per interpreter that imports the module
+typedef struct {
+    PyTypeObject* timeseries_type;
+    const FHIRPythonDocuments* documents;   // fhir_parser_c entry points, or NULL without it
+} TimeSeriesModuleState;
+
+static struct PyModuleDef fhir_timeseries_module;
+
+static int TimeSeries_init(TimeSeries* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"device_metric", "subject", "capacity", NULL};
+    PyObject* document;
+    const char* subject = NULL;
+    Py_ssize_t capacity = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|zn", kwlist, &document, &subject, &capacity)) {
+        return -1;
+    }
+    if (capacity < 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must not be negative");
+        return -1;
+    }
+    TimeSeriesModuleState* state = fhir_python_type_state(Py_TYPE(self), &fhir_timeseries_module);
+    if (!state) {
+        return -1;
+    }
+    
+    cJSON* owned;
+    const cJSON* json = fhir_python_document_json(state->documents, document, &owned);
+    if (json == NULL) {
+        return -1;
+    }
+    FHIRTimeSeries* series = fhir_timeseries_create_from_json(json, subject, (size_t)capacity);
+    cJSON_Delete(owned);
+    if (series == NULL) {
+        const FHIRError* error = fhir_get_last_error();
+        if (error && error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            PyErr_NoMemory();
+        } else {
+            PyErr_SetString(PyExc_ValueError, error ? error->message : "Expected a DeviceMetric");
+        }
+        return -1;
+    }
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_timeseries_destroy(self->series);
+    self->series = series;
+    FHIR_PY_END_CRITICAL_SECTION();
+    return 0;
+}
+
+static void TimeSeries_dealloc(TimeSeries* self) {
+    fhir_timeseries_destroy(self->series);
+    fhir_python_free_instance((PyObject*)self);
+}
+
+static int TimeSeries_check_ready(const TimeSeries* self) {
+    if (self->series == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "TimeSeries is not initialized");
+        return 0;
+    }
+    return 1;
+}
+
+// Sample time from FHIR instant text or int epoch milliseconds
+static int timeseries_time_from_python(PyObject* value, int64_t* timestamp) {
+    if (value == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "Sample time must not be None");
+        return 0;
+    }
+    return fhir_python_time_bound_from_python(value, false, timestamp);
+}
+
+static int timeseries_push(TimeSeries* self, PyObject* time_arg, PyObject* value_arg) {
+    int64_t timestamp;
+    if (!timeseries_time_from_python(time_arg, &timestamp)) {
+        return 0;
+    }
+    double value = PyFloat_AsDouble(value_arg);
+    if (value == -1.0 && PyErr_Occurred()) {
+        return 0;
+    }
+    bool pushed;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    pushed = fhir_timeseries_push(self->series, timestamp, value);
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (!pushed) {
+        PyErr_SetString(PyExc_ValueError, "Sample is older than the last sample");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject* TimeSeries_push(TimeSeries* self, PyObject* args) {
+    PyObject* time_arg;
+    PyObject* value_arg;
+    if (!TimeSeries_check_ready(self) || !PyArg_ParseTuple(args, "OO", &time_arg, &value_arg)) {
+        return NULL;
+    }
+    if (!timeseries_push(self, time_arg, value_arg)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* TimeSeries_extend(TimeSeries* self, PyObject* samples) {
+    if (!TimeSeries_check_ready(self)) {
+        return NULL;
+    }
+    PyObject* sequence = PySequence_Fast(samples, "extend() expects an iterable of (time, value) pairs");
+    if (sequence == NULL) {
+        return NULL;
+    }
+    
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject* pair = PySequence_Fast_GET_ITEM(sequence, i);
+        if (!PyTuple_Check(pair) || PyTuple_GET_SIZE(pair) != 2) {
+            PyErr_SetString(PyExc_TypeError, "extend() expects (time, value) pairs");
+            Py_DECREF(sequence);
+            return NULL;
+        }
+        if (!timeseries_push(self, PyTuple_GET_ITEM(pair, 0), PyTuple_GET_ITEM(pair, 1))) {
+            Py_DECREF(sequence);
+            return NULL;
+        }
+    }
+    Py_DECREF(sequence);
+    Py_RETURN_NONE;
+}
+
+static PyObject* TimeSeries_stats(TimeSeries* self, PyObject* args) {
+    PyObject* start_arg = Py_None;
+    PyObject* end_arg = Py_None;
+    if (!TimeSeries_check_ready(self) || !PyArg_ParseTuple(args, "|OO", &start_arg, &end_arg)) {
+        return NULL;
+    }
+    
+    int64_t start, end;
+    if (!fhir_python_time_bound_from_python(start_arg, false, &start) ||
+        !fhir_python_time_bound_from_python(end_arg, true, &end)) {
+        return NULL;
+    }
+    FHIRTimeSeriesStats stats;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    fhir_timeseries_stats(self->series, start, end, &stats);
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (stats.count == 0) {
+        return Py_BuildValue("{s:n,s:O,s:O,s:O}", "count", (Py_ssize_t)0, "min", Py_None, "max", Py_None,
+                             "mean", Py_None);
+    }
+    return Py_BuildValue("{s:n,s:d,s:d,s:d,s:N,s:N}", "count", (Py_ssize_t)stats.count, "min", stats.min,
+                         "max", stats.max, "mean", stats.mean,
+                         "first", fhir_python_time_bound_to_python(stats.first, false),
+                         "last", fhir_python_time_bound_to_python(stats.last, false));
+}
+
+static PyObject* TimeSeries_downsample(TimeSeries* self, PyObject* args) {
+    PyObject* start_arg;
+    PyObject* end_arg;
+    long long width_ms;
+    if (!TimeSeries_check_ready(self) || !PyArg_ParseTuple(args, "OOL", &start_arg, &end_arg, &width_ms)) {
+        return NULL;
+    }
+    
+    int64_t start, end;
+    if (!timeseries_time_from_python(start_arg, &start) || !timeseries_time_from_python(end_arg, &end)) {
+        return NULL;
+    }
+    if (width_ms <= 0 || width_ms > INT64_MAX / 1000) {
+        PyErr_SetString(PyExc_ValueError, "Bucket width must be a positive number of milliseconds");
+        return NULL;
+    }
+    
+    // At most one bucket per held sample, counted under the same lock as the pass
+    FHIRTimeSeriesBucket* buckets;
+    size_t count = 0;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    size_t capacity = fhir_timeseries_count(self->series);
+    buckets = PyMem_Malloc((capacity ? capacity : 1) * sizeof(FHIRTimeSeriesBucket));
+    if (buckets != NULL) {
+        count = fhir_timeseries_downsample(self->series, start, end, (int64_t)width_ms * 1000, buckets, capacity);
+    }
+    FHIR_PY_END_CRITICAL_SECTION();
+    if (buckets == NULL) {
+        return PyErr_NoMemory();
+    }
+    
+    PyObject* output = PyList_New((Py_ssize_t)count);
+    for (size_t i = 0; output != NULL && i < count; i++) {
+        PyObject* bucket = Py_BuildValue("(Nnddd)", fhir_python_time_bound_to_python(buckets[i].start, false),
+                                         (Py_ssize_t)buckets[i].count, buckets[i].min, buckets[i].max,
+                                         buckets[i].mean);
+        if (bucket == NULL) {
+            Py_CLEAR(output);
+            break;
+        }
+        PyList_SET_ITEM(output, (Py_ssize_t)i, bucket);
+    }
+    PyMem_Free(buckets);
+    return output;
+}
+
+static PyObject* TimeSeries_flush(TimeSeries* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"sampled", NULL};
+    int sampled = 0;
+    if (!TimeSeries_check_ready(self) || !PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &sampled)) {
+        return NULL;
+    }
+    
+    FHIRWriter writer;
+    if (!fhir_writer_init_buffer(&writer, 0)) {
+        return PyErr_NoMemory();
+    }
+    FHIRTimeSeriesFlushMode mode = sampled ? FHIR_TIMESERIES_FLUSH_SAMPLED_DATA : FHIR_TIMESERIES_FLUSH_OBSERVATIONS;
+    bool flushed;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    flushed = fhir_timeseries_flush(self->series, mode, &writer, NULL);
+    FHIR_PY_END_CRITICAL_SECTION();
+    PyObject* output = flushed ? PyUnicode_FromStringAndSize(writer.data, (Py_ssize_t)writer.length)
+                               : PyErr_NoMemory();
+    fhir_writer_cleanup(&writer);
+    return output;
+}
+
+static Py_ssize_t TimeSeries_length(TimeSeries* self) {
+    if (!TimeSeries_check_ready(self)) {
+        return -1;
+    }
+    Py_ssize_t length;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    length = (Py_ssize_t)fhir_timeseries_count(self->series);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return length;
+}
+
+static PyObject* TimeSeries_get_pending(TimeSeries* self, void* Py_UNUSED(closure)) {
+    if (!TimeSeries_check_ready(self)) {
+        return NULL;
+    }
+    size_t pending;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    pending = fhir_timeseries_pending(self->series);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return PyLong_FromSize_t(pending);
+}
+
+static PyObject* TimeSeries_get_dropped(TimeSeries* self, void* Py_UNUSED(closure)) {
+    if (!TimeSeries_check_ready(self)) {
+        return NULL;
+    }
+    unsigned long long dropped;
+    FHIR_PY_BEGIN_CRITICAL_SECTION(self);
+    dropped = fhir_timeseries_dropped(self->series);
+    FHIR_PY_END_CRITICAL_SECTION();
+    return PyLong_FromUnsignedLongLong(dropped);
+}
+
+static PyObject* TimeSeries_get_capacity(TimeSeries* self, void* Py_UNUSED(closure)) {
+    if (!TimeSeries_check_ready(self)) {
+        return NULL;
+    }
+    return PyLong_FromSize_t(fhir_timeseries_capacity(self->series));
+}
+
+static PyMethodDef TimeSeriesMethods[] = {
+    {"push", (PyCFunction)TimeSeries_push, METH_VARARGS, "push(time, value): append a sample (epoch ms or FHIR instant)"},
+    {"extend", (PyCFunction)TimeSeries_extend, METH_O, "extend(samples): append (time, value) pairs in order"},
+    {"stats", (PyCFunction)TimeSeries_stats, METH_VARARGS,
+     "stats(start=None, end=None): count/min/max/mean of the samples in the window"},
+    {"downsample", (PyCFunction)TimeSeries_downsample, METH_VARARGS,
+     "downsample(start, end, width_ms): [(bucket_start_ms, count, min, max, mean)] of non-empty buckets"},
+    {"flush", (PyCFunction)(void (*)(void))TimeSeries_flush, METH_VARARGS | METH_KEYWORDS,
+     "flush(sampled=False): pending samples as Observation NDJSON, one per sample or one SampledData Observation"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef TimeSeriesGetSet[] = {
+    {"pending", (getter)TimeSeries_get_pending, NULL, "Samples not flushed yet", NULL},
+    {"dropped", (getter)TimeSeries_get_dropped, NULL, "Samples overwritten before they were flushed", NULL},
+    {"capacity", (getter)TimeSeries_get_capacity, NULL, "Samples kept by the ring", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot TimeSeriesSlots[] = {
+    {Py_tp_doc, "Fixed-capacity (time, value) ring for one DeviceMetric"},
+    {Py_tp_new, PyType_GenericNew},
+    {Py_tp_init, TimeSeries_init},
+    {Py_tp_dealloc, TimeSeries_dealloc},
+    {Py_tp_methods, TimeSeriesMethods},
+    {Py_tp_getset, TimeSeriesGetSet},
+    {Py_sq_length, TimeSeries_length},
+    {0, NULL}
+};
+
+static PyType_Spec TimeSeriesSpec = {
+    .name = "fhir_timeseries_c.TimeSeries",
+    .basicsize = sizeof(TimeSeries),
+    .flags = Py_TPFLAGS_DEFAULT,
+    .slots = TimeSeriesSlots,
+};
+
+static int timeseries_module_traverse(PyObject* module, visitproc visit, void* arg) {
+    TimeSeriesModuleState* state = PyModule_GetState(module);
+    Py_VISIT(state->timeseries_type);
+    return 0;
+}
+
+static int timeseries_module_clear(PyObject* module) {
+    TimeSeriesModuleState* state = PyModule_GetState(module);
+    Py_CLEAR(state->timeseries_type);
+    return 0;
+}
+
+static void timeseries_module_free(void* module) {
+    timeseries_module_clear((PyObject*)module);
+}
+
+// Module execution (once per interpreter)
+static int timeseries_module_exec(PyObject* module) {
+    TimeSeriesModuleState* state = PyModule_GetState(module);
+
+    if (fhir_python_add_runtime(module) < 0) {
+        return -1;
+    }
+    state->documents = fhir_python_import_documents();
+
+    state->timeseries_type = fhir_python_add_type(module, &TimeSeriesSpec);
+    return state->timeseries_type ? 0 : -1;
+}
+
+static PyModuleDef_Slot timeseries_module_slots[] = FHIR_PY_MODULE_SLOTS(timeseries_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_timeseries_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_timeseries_c",
+    "DeviceMetric time series buffers in C",
+    sizeof(TimeSeriesModuleState),
+    NULL,
+    timeseries_module_slots,
+    timeseries_module_traverse,
+    timeseries_module_clear,
+    timeseries_module_free
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_timeseries_c(void) {
+    return PyModuleDef_Init(&fhir_timeseries_module);
+}
@@ -0,0 +1,173 @@
+#include "fhir_python_module.h"
+#include "fhir_python_runtime.h"
+#include "fhir_python_json.h"
+#include "fhir_bundle_parallel.h"
+#include "common/fhir_json_reader.h"
+
+// Python binding for dependency-ordered transaction processing
+
+// Run one transaction entry through the Python callback (any worker thread)
+static bool py_transaction_entry(FHIRTransactionEntryResult* entry, size_t index, void* context) {
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject* resource = entry->resource ? fhir_cjson_to_python(entry->resource) : NULL;
+    PyObject* item = resource || !entry->resource
+        ? Py_BuildValue("{s:n,s:z,s:s,s:s,s:O}",
+                        "index", (Py_ssize_t)index,
+                        "fullUrl", entry->full_url,
+                        "method", entry->method,
+                        "url", entry->url,
+                        "resource", resource ? resource : Py_None)
+        : NULL;
+    Py_XDECREF(resource);
+    PyObject* outcome = item ? PyObject_CallFunctionObjArgs((PyObject*)context, item, NULL) : NULL;
+    Py_XDECREF(item);
+
+    // The callback returns None, a location, or (status, location)
+    bool ok = outcome != NULL;
+    const char* location = NULL;
+    if (ok && PyUnicode_Check(outcome)) {
+        location = PyUnicode_AsUTF8(outcome);
+        ok = location != NULL;
+    } else if (ok && PyTuple_Check(outcome)) {
+        ok = PyArg_ParseTuple(outcome, "iz", &entry->status, &location) != 0;
+    } else if (ok && outcome != Py_None) {
+        PyErr_SetString(PyExc_TypeError, "callback must return None, a location or (status, location)");
+        ok = false;
+    }
+    if (ok && !fhir_transaction_entry_set_location(entry, location)) {
+        PyErr_NoMemory();
+        ok = false;
+    }
+    Py_XDECREF(outcome);
+
+    // Exceptions fail the entry; the message becomes its error
+    if (!ok) {
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        PyObject* message = value ? PyObject_Str(value) : NULL;
+        const char* text = message ? PyUnicode_AsUTF8(message) : NULL;
+        PyErr_Clear();
+        FHIR_SET_ERROR(FHIR_ERROR_VALIDATION_FAILED, text && text[0] ? text : "Transaction callback failed");
+        Py_XDECREF(message);
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+    }
+    PyGILState_Release(gil);
+    return ok;
+}
+
+static PyObject* transaction_entry_to_python(const FHIRTransactionEntryResult* entry) {
+    static const char* states[] = { "pending", "done", "failed", "skipped" };
+
+    PyObject* rewrites = PyList_New((Py_ssize_t)entry->rewrite_count);
+    for (size_t i = 0; rewrites && i < entry->rewrite_count; i++) {
+        PyObject* rewrite = Py_BuildValue("(ss)", entry->rewrites[i].reference, entry->rewrites[i].target);
+        if (!rewrite) {
+            Py_CLEAR(rewrites);
+            break;
+        }
+        PyList_SET_ITEM(rewrites, (Py_ssize_t)i, rewrite);
+    }
+    if (!rewrites) return NULL;
+
+    PyObject* status = entry->status ? PyLong_FromLong(entry->status) : NULL;
+    if (entry->status && !status) {
+        Py_DECREF(rewrites);
+        return NULL;
+    }
+    PyObject* outcome = Py_BuildValue("{s:s,s:O,s:z,s:z,s:N}",
+                                      "state", states[entry->state],
+                                      "status", status ? status : Py_None,
+                                      "location", entry->location,
+                                      "error", entry->error_message[0] ? entry->error_message : NULL,
+                                      "rewrites", rewrites);
+    Py_XDECREF(status);
+    return outcome;
+}
+
+// Run the entries of a transaction or batch Bundle through a callback in dependency order
+static PyObject* py_process_transaction(PyObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"source", "callback", "threads", NULL};
+    Py_buffer view;
+    PyObject* callback;
+    Py_ssize_t threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s*O|n", kwlist, &view, &callback, &threads)) {
+        return NULL;
+    }
+    if (!PyCallable_Check(callback) || threads < 0) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyCallable_Check(callback) ? PyExc_ValueError : PyExc_TypeError,
+                        PyCallable_Check(callback) ? "threads must be >= 0" : "callback must be callable");
+        return NULL;
+    }
+
+    // Workers take the GIL only around the callback
+    cJSON* json;
+    FHIRTransactionResult* result = NULL;
+    Py_BEGIN_ALLOW_THREADS
+    json = fhir_json_parse(view.buf, (size_t)view.len);
+    if (json) {
+        result = fhir_process_transaction(json, (size_t)threads, py_transaction_entry, callback);
+    }
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (!json) {
+        PyErr_SetString(PyExc_ValueError, "Invalid JSON");
+        return NULL;
+    }
+    if (!result) {
+        const FHIRError* error = fhir_get_last_error();
+        cJSON_Delete(json);
+        // Failed allocations leave no error set
+        if (!error || error->code == FHIR_ERROR_OUT_OF_MEMORY) {
+            return PyErr_NoMemory();
+        }
+        PyErr_SetString(PyExc_ValueError, error->message ? error->message : "Invalid transaction Bundle");
+        return NULL;
+    }
+
+    PyObject* outcomes = PyList_New((Py_ssize_t)result->entry_count);
+    for (size_t i = 0; outcomes && i < result->entry_count; i++) {
+        PyObject* outcome = transaction_entry_to_python(&result->entries[i]);
+        if (!outcome) {
+            Py_CLEAR(outcomes);
+            break;
+        }
+        PyList_SET_ITEM(outcomes, (Py_ssize_t)i, outcome);
+    }
+
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return outcomes;
+}
+
+static PyMethodDef TransactionModuleMethods[] = {
+    {"process_transaction", (PyCFunction)py_process_transaction, METH_VARARGS | METH_KEYWORDS,
+     "process_transaction(source, callback, threads=0): run transaction entries through callback in dependency order; returns per-entry outcomes"},
+    {NULL, NULL, 0, NULL}
+};
+
+// Module execution (once per interpreter); the module keeps no state
+static int transaction_module_exec(PyObject* module) {
+    return fhir_python_add_runtime(module);
+}
+
+static PyModuleDef_Slot transaction_module_slots[] = FHIR_PY_MODULE_SLOTS(transaction_module_exec);
+
+// Module definition
+static struct PyModuleDef fhir_transaction_module = {
+    PyModuleDef_HEAD_INIT,
+    "fhir_transaction_c",
+    "FHIR transaction and batch Bundle processing in C",
+    0,
+    TransactionModuleMethods,
+    transaction_module_slots
+};
+
+// Module initialization
+PyMODINIT_FUNC PyInit_fhir_transaction_c(void) {
+    return PyModuleDef_Init(&fhir_transaction_module);
+}
@@ -7,6 +7,7 @@
 
 #include "fhir_careplan.h"
 #include "../common/fhir_common.h"
+#include "../common/fhir_json_reader.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,7 +16,7 @@
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(CarePlan, careplan)
+FHIR_RESOURCE_VTABLE_INIT(CarePlan, careplan, CARE_PLAN)
 
 /* ========================================================================== */
 /* CarePlan Sub-structure Methods                                            */
@@ -90,14 +91,14 @@ FHIRCarePlan* fhir_careplan_create(const char* id) {
         return NULL;
     }
     
-    FHIRCarePlan* careplan = fhir_calloc(1, sizeof(FHIRCarePlan));
+    FHIRCarePlan* careplan = fhir_resource_alloc(&CarePlan_vtable);
     if (!careplan) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&careplan->base, &CarePlan_vtable, 
-                                FHIR_RESOURCE_TYPE_CAREPLAN, id)) {
-        fhir_free(careplan);
+                                FHIR_RESOURCE_TYPE_CARE_PLAN, id)) {
+        fhir_resource_free(&CarePlan_vtable, careplan);
         return NULL;
     }
     
@@ -137,7 +138,7 @@ void fhir_careplan_destroy(FHIRCarePlan* self) {
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&CarePlan_vtable, self);
 }
 
 FHIRCarePlan* fhir_careplan_clone(const FHIRCarePlan* self) {
@@ -339,7 +340,7 @@ FHIRCarePlan* fhir_careplan_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -480,7 +481,7 @@ FHIRCarePlanIntent fhir_careplan_intent_from_string(const char* intent_str) {
 
 bool fhir_careplan_register(void) {
     FHIRResourceRegistration registration = {
-        .type = FHIR_RESOURCE_TYPE_CAREPLAN,
+        .type = FHIR_RESOURCE_TYPE_CARE_PLAN,
         .name = "CarePlan",
         .vtable = &CarePlan_vtable,
         .factory = (FHIRResourceFactory)fhir_careplan_create
@@ -15,7 +15,7 @@
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Encounter, encounter)
+FHIR_RESOURCE_VTABLE_INIT(Encounter, encounter, ENCOUNTER)
 
 /* ========================================================================== */
 /* Encounter Sub-structure Methods                                           */
@@ -128,14 +128,14 @@ FHIREncounter* fhir_encounter_create(const char* id) {
         return NULL;
     }
     
-    FHIREncounter* encounter = fhir_calloc(1, sizeof(FHIREncounter));
+    FHIREncounter* encounter = fhir_resource_alloc(&Encounter_vtable);
     if (!encounter) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&encounter->base, &Encounter_vtable, 
                                 FHIR_RESOURCE_TYPE_ENCOUNTER, id)) {
-        fhir_free(encounter);
+        fhir_resource_free(&Encounter_vtable, encounter);
         return NULL;
     }
     
@@ -180,7 +180,7 @@ void fhir_encounter_destroy(FHIREncounter* self) {
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Encounter_vtable, self);
 }
 
 /* ========================================================================== */
@@ -3,19 +3,229 @@
  * @brief FHIR R5 Location resource C implementation with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ *
+ * The codec is the field table below run by common/fhir_schema.c: one pass
+ * over the JSON members with a generated key switch, each value allocated
+ * at its exact size.
  */
 
 #include "fhir_location.h"
 #include "../common/fhir_common.h"
-#include <stdlib.h>
-#include <string.h>
+#include "../common/fhir_json_reader.h"
+#include "../common/fhir_schema.h"
+#include "../fhir_datatype_schemas.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ========================================================================== */
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Location, location)
+FHIR_RESOURCE_VTABLE_INIT(Location, location, LOCATION)
+
+/* ========================================================================== */
+/* Location Schema                                                            */
+/* ========================================================================== */
+
+typedef enum {
+    FHIR_LOCATION_FIELD_IDENTIFIER,
+    FHIR_LOCATION_FIELD_STATUS,
+    FHIR_LOCATION_FIELD_OPERATIONAL_STATUS,
+    FHIR_LOCATION_FIELD_NAME,
+    FHIR_LOCATION_FIELD_ALIAS,
+    FHIR_LOCATION_FIELD_DESCRIPTION,
+    FHIR_LOCATION_FIELD_MODE,
+    FHIR_LOCATION_FIELD_TYPE,
+    FHIR_LOCATION_FIELD_CONTACT,
+    FHIR_LOCATION_FIELD_ADDRESS,
+    FHIR_LOCATION_FIELD_FORM,
+    FHIR_LOCATION_FIELD_POSITION,
+    FHIR_LOCATION_FIELD_MANAGING_ORGANIZATION,
+    FHIR_LOCATION_FIELD_PART_OF,
+    FHIR_LOCATION_FIELD_CHARACTERISTIC,
+    FHIR_LOCATION_FIELD_HOURS_OF_OPERATION,
+    FHIR_LOCATION_FIELD_VIRTUAL_SERVICE,
+    FHIR_LOCATION_FIELD_ENDPOINT,
+} FHIRLocationField;
+
+static const char* const g_location_status_codes[] = {"active", "suspended", "inactive"};
+static const char* const g_location_mode_codes[] = {"instance", "kind"};
+
+static const FHIRSchemaField g_location_fields[] = {
+    { .key = "identifier", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRLocation, identifier), .count_offset = offsetof(FHIRLocation, identifier_count),
+      .schema = &fhir_identifier_schema },
+    { .key = "status", .kind = FHIR_SCHEMA_CODE, .flags = 0,
+      .offset = offsetof(FHIRLocation, status),
+      .codes = g_location_status_codes, .code_count = sizeof(g_location_status_codes) / sizeof(g_location_status_codes[0]) },
+    { .key = "operationalStatus", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRLocation, operational_status),
+      .schema = &fhir_coding_schema },
+    { .key = "name", .kind = FHIR_SCHEMA_STRING, .flags = 0,
+      .offset = offsetof(FHIRLocation, name) },
+    { .key = "alias", .kind = FHIR_SCHEMA_STRING, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRLocation, alias), .count_offset = offsetof(FHIRLocation, alias_count) },
+    { .key = "description", .kind = FHIR_SCHEMA_STRING, .flags = 0,
+      .offset = offsetof(FHIRLocation, description) },
+    { .key = "mode", .kind = FHIR_SCHEMA_CODE, .flags = 0,
+      .offset = offsetof(FHIRLocation, mode),
+      .codes = g_location_mode_codes, .code_count = sizeof(g_location_mode_codes) / sizeof(g_location_mode_codes[0]) },
+    { .key = "type", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRLocation, type), .count_offset = offsetof(FHIRLocation, type_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "contact", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRLocation, contact) },
+    { .key = "address", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRLocation, address),
+      .schema = &fhir_address_schema },
+    { .key = "form", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRLocation, form),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "position", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRLocation, position) },
+    { .key = "managingOrganization", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRLocation, managing_organization),
+      .schema = &fhir_reference_schema },
+    { .key = "partOf", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRLocation, part_of),
+      .schema = &fhir_reference_schema },
+    { .key = "characteristic", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRLocation, characteristic), .count_offset = offsetof(FHIRLocation, characteristic_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "hoursOfOperation", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRLocation, hours_of_operation) },
+    { .key = "virtualService", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRLocation, virtual_service) },
+    { .key = "endpoint", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRLocation, endpoint), .count_offset = offsetof(FHIRLocation, endpoint_count),
+      .schema = &fhir_reference_schema },
+};
+
+static int fhir_location_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            switch (key[2]) {
+                case 'd':
+                    if (memcmp(key, "mode", 4) == 0) return FHIR_LOCATION_FIELD_MODE;
+                    break;
+                case 'm':
+                    if (memcmp(key, "name", 4) == 0) return FHIR_LOCATION_FIELD_NAME;
+                    break;
+                case 'p':
+                    if (memcmp(key, "type", 4) == 0) return FHIR_LOCATION_FIELD_TYPE;
+                    break;
+                case 'r':
+                    if (memcmp(key, "form", 4) == 0) return FHIR_LOCATION_FIELD_FORM;
+                    break;
+                case 't':
+                    if (memcmp(key, "meta", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'x':
+                    if (memcmp(key, "text", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(key, "alias", 5) == 0) return FHIR_LOCATION_FIELD_ALIAS;
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'p':
+                    if (memcmp(key, "partOf", 6) == 0) return FHIR_LOCATION_FIELD_PART_OF;
+                    break;
+                case 's':
+                    if (memcmp(key, "status", 6) == 0) return FHIR_LOCATION_FIELD_STATUS;
+                    break;
+            }
+            break;
+        case 7:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "address", 7) == 0) return FHIR_LOCATION_FIELD_ADDRESS;
+                    break;
+                case 'c':
+                    if (memcmp(key, "contact", 7) == 0) return FHIR_LOCATION_FIELD_CONTACT;
+                    break;
+            }
+            break;
+        case 8:
+            switch (key[0]) {
+                case 'e':
+                    if (memcmp(key, "endpoint", 8) == 0) return FHIR_LOCATION_FIELD_ENDPOINT;
+                    break;
+                case 'l':
+                    if (memcmp(key, "language", 8) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'p':
+                    if (memcmp(key, "position", 8) == 0) return FHIR_LOCATION_FIELD_POSITION;
+                    break;
+            }
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "contained", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'e':
+                    if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 10:
+            if (memcmp(key, "identifier", 10) == 0) return FHIR_LOCATION_FIELD_IDENTIFIER;
+            break;
+        case 11:
+            if (memcmp(key, "description", 11) == 0) return FHIR_LOCATION_FIELD_DESCRIPTION;
+            break;
+        case 12:
+            if (memcmp(key, "resourceType", 12) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 13:
+            if (memcmp(key, "implicitRules", 13) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 14:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "characteristic", 14) == 0) return FHIR_LOCATION_FIELD_CHARACTERISTIC;
+                    break;
+                case 'v':
+                    if (memcmp(key, "virtualService", 14) == 0) return FHIR_LOCATION_FIELD_VIRTUAL_SERVICE;
+                    break;
+            }
+            break;
+        case 16:
+            if (memcmp(key, "hoursOfOperation", 16) == 0) return FHIR_LOCATION_FIELD_HOURS_OF_OPERATION;
+            break;
+        case 17:
+            switch (key[0]) {
+                case 'm':
+                    if (memcmp(key, "modifierExtension", 17) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'o':
+                    if (memcmp(key, "operationalStatus", 17) == 0) return FHIR_LOCATION_FIELD_OPERATIONAL_STATUS;
+                    break;
+            }
+            break;
+        case 20:
+            if (memcmp(key, "managingOrganization", 20) == 0) return FHIR_LOCATION_FIELD_MANAGING_ORGANIZATION;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+static const FHIRSchema g_location_schema = {
+    .name = "Location",
+    .size = sizeof(FHIRLocation),
+    .fields = g_location_fields,
+    .field_count = sizeof(g_location_fields) / sizeof(g_location_fields[0]),
+    .lookup = fhir_location_field_lookup
+};
 
 /* ========================================================================== */
 /* Location Factory and Lifecycle Methods                             */
@@ -27,49 +237,27 @@ FHIRLocation* fhir_location_create(const char* id) {
         return NULL;
     }
     
-    FHIRLocation* location = fhir_calloc(1, sizeof(FHIRLocation));
+    FHIRLocation* location = fhir_resource_alloc(&Location_vtable);
     if (!location) {
         return NULL;
     }
     
-    if (!fhir_resource_base_init(&location->base, &Location_vtable, 
+    if (!fhir_resource_base_init(&location->base, &Location_vtable,
                                 FHIR_RESOURCE_TYPE_LOCATION, id)) {
-        fhir_free(location);
+        fhir_resource_free(&Location_vtable, location);
         return NULL;
     }
     
-    // Initialize Location-specific defaults
-    location->status = FHIRLOCATIONSTATUS_ACTIVE;
-    location->mode = FHIRLOCATIONMODE_INSTANCE;
-    
     return location;
 }
 
 void fhir_location_destroy(FHIRLocation* self) {
     if (!self) return;
     
-    // Free Location-specific fields
-    if (self->operational_status) fhir_coding_destroy(self->operational_status);
-    if (self->name) fhir_string_destroy(self->name);
-    if (self->description) fhir_markdown_destroy(self->description);
-    if (self->address) fhir_address_destroy(self->address);
-    if (self->physical_type) fhir_codeableconcept_destroy(self->physical_type);
-    if (self->position) fhir_locationposition_destroy(self->position);
-    if (self->managing_organization) fhir_reference_destroy(self->managing_organization);
-    if (self->part_of) fhir_reference_destroy(self->part_of);
-    
-    // Free arrays
-    fhir_array_destroy((void**)self->alias, self->alias_count, (FHIRDestroyFunc)fhir_string_destroy);
-    fhir_array_destroy((void**)self->type, self->type_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->contact, self->contact_count, (FHIRDestroyFunc)fhir_extendedcontactdetail_destroy);
-    fhir_array_destroy((void**)self->characteristic, self->characteristic_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->hours_of_operation, self->hours_of_operation_count, (FHIRDestroyFunc)fhir_availability_destroy);
-    fhir_array_destroy((void**)self->virtual_service, self->virtual_service_count, (FHIRDestroyFunc)fhir_virtualservicedetail_destroy);
-    
-    // Free base resource
+    fhir_schema_clear(&g_location_schema, self);
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Location_vtable, self);
 }
 
 FHIRLocation* fhir_location_clone(const FHIRLocation* self) {
@@ -78,45 +266,11 @@ FHIRLocation* fhir_location_clone(const FHIRLocation* self) {
     FHIRLocation* clone = fhir_location_create(self->base.id);
     if (!clone) return NULL;
     
-    // Clone Location-specific fields
-    clone->status = self->status;
-    clone->mode = self->mode;
-    
-    if (self->operational_status) {
-        clone->operational_status = fhir_coding_clone(self->operational_status);
-    }
-    if (self->name) {
-        clone->name = fhir_string_clone(self->name);
-    }
-    if (self->description) {
-        clone->description = fhir_markdown_clone(self->description);
-    }
-    if (self->address) {
-        clone->address = fhir_address_clone(self->address);
-    }
-    if (self->physical_type) {
-        clone->physical_type = fhir_codeableconcept_clone(self->physical_type);
-    }
-    if (self->position) {
-        clone->position = fhir_locationposition_clone(self->position);
-    }
-    if (self->managing_organization) {
-        clone->managing_organization = fhir_reference_clone(self->managing_organization);
-    }
-    if (self->part_of) {
-        clone->part_of = fhir_reference_clone(self->part_of);
+    if (!fhir_schema_copy(&g_location_schema, clone, self)) {
+        fhir_location_destroy(clone);
+        return NULL;
     }
     
-    // Clone arrays
-    clone->alias = fhir_array_clone((void**)self->alias, self->alias_count, 
-                                   (FHIRCloneFunc)fhir_string_clone, &clone->alias_count);
-    clone->type = fhir_array_clone((void**)self->type, self->type_count, 
-                                  (FHIRCloneFunc)fhir_codeableconcept_clone, &clone->type_count);
-    clone->contact = fhir_array_clone((void**)self->contact, self->contact_count, 
-                                     (FHIRCloneFunc)fhir_extendedcontactdetail_clone, &clone->contact_count);
-    clone->characteristic = fhir_array_clone((void**)self->characteristic, self->characteristic_count, 
-                                            (FHIRCloneFunc)fhir_codeableconcept_clone, &clone->characteristic_count);
-    
     return clone;
 }
 
@@ -138,58 +292,12 @@ cJSON* fhir_location_to_json(const FHIRLocation* self) {
     
     // Add resource type and id
     if (!fhir_json_add_string(json, "resourceType", "Location") ||
-        !fhir_json_add_string(json, "id", self->base.id)) {
+        !fhir_json_add_string(json, "id", self->base.id) ||
+        !fhir_schema_to_json(&g_location_schema, self, json)) {
         cJSON_Delete(json);
         return NULL;
     }
     
-    // Add Location-specific fields
-    const char* status_str = (self->status == FHIRLOCATIONSTATUS_ACTIVE) ? "active" :
-                            (self->status == FHIRLOCATIONSTATUS_SUSPENDED) ? "suspended" : "inactive";
-    fhir_json_add_string(json, "status", status_str);
-    
-    const char* mode_str = (self->mode == FHIRLOCATIONMODE_INSTANCE) ? "instance" : "kind";
-    fhir_json_add_string(json, "mode", mode_str);
-    
-    if (self->operational_status) {
-        fhir_json_add_coding(json, "operationalStatus", self->operational_status);
-    }
-    if (self->name) {
-        fhir_json_add_string_value(json, "name", self->name);
-    }
-    if (self->description) {
-        fhir_json_add_markdown(json, "description", self->description);
-    }
-    if (self->address) {
-        fhir_json_add_address(json, "address", self->address);
-    }
-    if (self->physical_type) {
-        fhir_json_add_codeableconcept(json, "physicalType", self->physical_type);
-    }
-    if (self->position) {
-        fhir_json_add_locationposition(json, "position", self->position);
-    }
-    if (self->managing_organization) {
-        fhir_json_add_reference(json, "managingOrganization", self->managing_organization);
-    }
-    if (self->part_of) {
-        fhir_json_add_reference(json, "partOf", self->part_of);
-    }
-    
-    // Add arrays
-    if (self->alias && self->alias_count > 0) {
-        fhir_json_add_string_array(json, "alias", self->alias, self->alias_count);
-    }
-    if (self->type && self->type_count > 0) {
-        fhir_json_add_codeableconcept_array(json, "type", self->type, self->type_count);
-    }
-    if (self->contact && self->contact_count > 0) {
-        fhir_json_add_extendedcontactdetail_array(json, "contact", self->contact, self->contact_count);
-    }
-    if (self->characteristic && self->characteristic_count > 0) {
-        fhir_json_add_codeableconcept_array(json, "characteristic", self->characteristic, self->characteristic_count);
-    }
-    
     return json;
 }
 
@@ -199,81 +307,7 @@ bool fhir_location_from_json(FHIRLocation* self, const cJSON* json) {
         return false;
     }
     
-    // Validate resource type
-    const char* resource_type = fhir_json_get_string(json, "resourceType");
-    if (!resource_type || strcmp(resource_type, "Location") != 0) {
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
-        return false;
-    }
-    
-    // Parse Location-specific fields
-    const char* status_str = fhir_json_get_string(json, "status");
-    if (status_str) {
-        if (strcmp(status_str, "active") == 0) {
-            self->status = FHIRLOCATIONSTATUS_ACTIVE;
-        } else if (strcmp(status_str, "suspended") == 0) {
-            self->status = FHIRLOCATIONSTATUS_SUSPENDED;
-        } else if (strcmp(status_str, "inactive") == 0) {
-            self->status = FHIRLOCATIONSTATUS_INACTIVE;
-        }
-    }
-    
-    const char* mode_str = fhir_json_get_string(json, "mode");
-    if (mode_str) {
-        if (strcmp(mode_str, "instance") == 0) {
-            self->mode = FHIRLOCATIONMODE_INSTANCE;
-        } else if (strcmp(mode_str, "kind") == 0) {
-            self->mode = FHIRLOCATIONMODE_KIND;
-        }
-    }
-    
-    const cJSON* operational_status_json = cJSON_GetObjectItem(json, "operationalStatus");
-    if (operational_status_json) {
-        self->operational_status = fhir_json_parse_coding(operational_status_json);
-    }
-    
-    const cJSON* name_json = cJSON_GetObjectItem(json, "name");
-    if (name_json) {
-        self->name = fhir_json_parse_string(name_json);
-    }
-    
-    const cJSON* description_json = cJSON_GetObjectItem(json, "description");
-    if (description_json) {
-        self->description = fhir_json_parse_markdown(description_json);
-    }
-    
-    const cJSON* address_json = cJSON_GetObjectItem(json, "address");
-    if (address_json) {
-        self->address = fhir_json_parse_address(address_json);
-    }
-    
-    const cJSON* physical_type_json = cJSON_GetObjectItem(json, "physicalType");
-    if (physical_type_json) {
-        self->physical_type = fhir_json_parse_codeableconcept(physical_type_json);
-    }
-    
-    const cJSON* managing_organization_json = cJSON_GetObjectItem(json, "managingOrganization");
-    if (managing_organization_json) {
-        self->managing_organization = fhir_json_parse_reference(managing_organization_json);
-    }
-    
-    const cJSON* part_of_json = cJSON_GetObjectItem(json, "partOf");
-    if (part_of_json) {
-        self->part_of = fhir_json_parse_reference(part_of_json);
-    }
-    
-    // Parse arrays
-    const cJSON* alias_json = cJSON_GetObjectItem(json, "alias");
-    if (alias_json && cJSON_IsArray(alias_json)) {
-        self->alias = fhir_json_parse_string_array(alias_json, &self->alias_count);
-    }
-    
-    const cJSON* type_json = cJSON_GetObjectItem(json, "type");
-    if (type_json && cJSON_IsArray(type_json)) {
-        self->type = fhir_json_parse_codeableconcept_array(type_json, &self->type_count);
-    }
-    
-    return true;
+    return fhir_schema_load_resource(&g_location_schema, self, json);
 }
 
 FHIRLocation* fhir_location_parse(const char* json_string) {
@@ -282,7 +316,7 @@ FHIRLocation* fhir_location_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -323,8 +357,31 @@ bool fhir_location_validate(const FHIRLocation* self) {
         return false;
     }
     
-    // Location has no required fields beyond base resource
-    return true;
+    return fhir_schema_validate(&g_location_schema, self);
+}
+
+bool fhir_location_equals(const FHIRLocation* self, const FHIRLocation* other) {
+    if (self == other) return true;
+    if (!self || !other) return false;
+    
+    if (fhir_strcmp(self->base.id, other->base.id) != 0) return false;
+    return fhir_schema_equals(&g_location_schema, self, other);
+}
+
+char* fhir_location_to_string(const FHIRLocation* self) {
+    if (!self) return NULL;
+    
+    const char* display_name = fhir_location_get_display_name(self);
+    
+    char* result = fhir_malloc(256);
+    if (!result) return NULL;
+    
+    snprintf(result, 256, "Location(id=%s, name=%s, active=%s)",
+             self->base.id ? self->base.id : "unknown",
+             display_name ? display_name : "unknown",
+             fhir_location_is_active(self) ? "true" : "false");
+    
+    return result;
 }
 
 /* ========================================================================== */
@@ -332,18 +389,16 @@ bool fhir_location_validate(const FHIRLocation* self) {
 /* ========================================================================== */
 
 bool fhir_location_is_active(const FHIRLocation* self) {
-    if (!self) return false;
-    return self->status == FHIRLOCATIONSTATUS_ACTIVE;
+    return self && self->status == FHIR_LOCATION_STATUS_ACTIVE;
 }
 
 const char* fhir_location_get_display_name(const FHIRLocation* self) {
     if (!self) return NULL;
     
-    // Return location name if available
     if (self->name && self->name->value) {
         return self->name->value;
     }
-    
+
     return "Location";
 }
 
@@ -356,4 +411,4 @@ bool fhir_location_register(void) {
     };
     
     return fhir_resource_register_type(&registration);
-}
\ No newline at end of file
+}
@@ -3,8 +3,10 @@
  * @brief FHIR R5 Location resource C interface with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
- * 
+ *
  * Details and position information for a physical place
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
  */
 
 #ifndef FHIR_LOCATION_H
@@ -20,29 +22,34 @@ extern "C" {
 #endif
 
 /**
- * @brief Location status enumeration
+ * @brief Location status codes (FHIR_LOCATION_STATUS_NONE when absent)
  */
 typedef enum {
-    FHIRLOCATIONSTATUS_ACTIVE = 0,
-    FHIRLOCATIONSTATUS_SUSPENDED = 1,
-    FHIRLOCATIONSTATUS_INACTIVE = 2,
+    FHIR_LOCATION_STATUS_NONE = 0,
+    FHIR_LOCATION_STATUS_ACTIVE,
+    FHIR_LOCATION_STATUS_SUSPENDED,
+    FHIR_LOCATION_STATUS_INACTIVE,
 } FHIRLocationStatus;
 
 /**
- * @brief Location mode enumeration
+ * @brief Location mode codes (FHIR_LOCATION_MODE_NONE when absent)
  */
 typedef enum {
-    FHIRLOCATIONMODE_INSTANCE = 0,
-    FHIRLOCATIONMODE_KIND = 1,
+    FHIR_LOCATION_MODE_NONE = 0,
+    FHIR_LOCATION_MODE_INSTANCE,
+    FHIR_LOCATION_MODE_KIND,
 } FHIRLocationMode;
 
 /**
  * @brief FHIR R5 Location resource structure
- * 
+ *
  * Details and position information for a physical place
  */
 FHIR_RESOURCE_DEFINE(Location)
     // Location-specific fields
+    FHIRIdentifier** identifier;
+    size_t identifier_count;
+    
     FHIRLocationStatus status;
     
     FHIRCoding* operational_status;
@@ -59,14 +66,13 @@ FHIR_RESOURCE_DEFINE(Location)
     FHIRCodeableConcept** type;
     size_t type_count;
     
-    FHIRExtendedContactDetail** contact;
-    size_t contact_count;
+    cJSON* contact;
     
     FHIRAddress* address;
     
-    FHIRCodeableConcept* physical_type;
+    FHIRCodeableConcept* form;
     
-    FHIRLocationPosition* position;
+    cJSON* position;
     
     FHIRReference* managing_organization;
     
@@ -75,11 +81,12 @@ FHIR_RESOURCE_DEFINE(Location)
     FHIRCodeableConcept** characteristic;
     size_t characteristic_count;
     
-    FHIRAvailability** hours_of_operation;
-    size_t hours_of_operation_count;
+    cJSON* hours_of_operation;
+    
+    cJSON* virtual_service;
     
-    FHIRVirtualServiceDetail** virtual_service;
-    size_t virtual_service_count;
+    FHIRReference** endpoint;
+    size_t endpoint_count;
     
 };
 
@@ -144,6 +151,21 @@ FHIRLocation* fhir_location_parse(const char* json_string);
  */
 bool fhir_location_validate(const FHIRLocation* self);
 
+/**
+ * @brief Check if two Locations are equal (virtual method)
+ * @param self First Location
+ * @param other Second Location
+ * @return true if equal, false otherwise
+ */
+bool fhir_location_equals(const FHIRLocation* self, const FHIRLocation* other);
+
+/**
+ * @brief Convert Location to string representation (virtual method)
+ * @param self Location to convert
+ * @return String representation (must be freed by caller)
+ */
+char* fhir_location_to_string(const FHIRLocation* self);
+
 /* ========================================================================== */
 /* Location-Specific Methods                                          */
 /* ========================================================================== */
@@ -172,4 +194,4 @@ bool fhir_location_register(void);
 }
 #endif
 
-#endif /* FHIR_LOCATION_H */
\ No newline at end of file
+#endif /* FHIR_LOCATION_H */
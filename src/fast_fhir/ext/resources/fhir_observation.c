@@ -7,6 +7,7 @@
 
 #include "fhir_observation.h"
 #include "../common/fhir_common.h"
+#include "../common/fhir_json_reader.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,14 +16,20 @@
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Observation, observation)
+FHIR_RESOURCE_VTABLE_INIT(Observation, observation, OBSERVATION)
+
+// Components and reference ranges churn at the same rate as Observations
+static FHIRObjectPool g_component_pool =
+    FHIR_OBJECT_POOL_INIT("ObservationComponent", FHIRObservationComponent);
+static FHIRObjectPool g_reference_range_pool =
+    FHIR_OBJECT_POOL_INIT("ObservationReferenceRange", FHIRObservationReferenceRange);
 
 /* ========================================================================== */
 /* Observation Sub-structure Methods                                         */
 /* ========================================================================== */
 
 FHIRObservationComponent* fhir_observation_component_create(void) {
-    FHIRObservationComponent* component = fhir_calloc(1, sizeof(FHIRObservationComponent));
+    FHIRObservationComponent* component = fhir_pool_alloc(&g_component_pool);
     if (!component) return NULL;
     
     fhir_element_init(&component->base);
@@ -54,11 +61,11 @@ void fhir_observation_component_destroy(FHIRObservationComponent* self) {
     fhir_array_destroy((void**)self->reference_range, self->reference_range_count, (FHIRDestroyFunc)fhir_observation_reference_range_destroy);
     
     fhir_element_cleanup(&self->base);
-    fhir_free(self);
+    fhir_pool_free(&g_component_pool, self);
 }
 
 FHIRObservationReferenceRange* fhir_observation_reference_range_create(void) {
-    FHIRObservationReferenceRange* range = fhir_calloc(1, sizeof(FHIRObservationReferenceRange));
+    FHIRObservationReferenceRange* range = fhir_pool_alloc(&g_reference_range_pool);
     if (!range) return NULL;
     
     fhir_element_init(&range->base);
@@ -77,7 +84,7 @@ void fhir_observation_reference_range_destroy(FHIRObservationReferenceRange* sel
     if (self->text) fhir_string_destroy(self->text);
     
     fhir_element_cleanup(&self->base);
-    fhir_free(self);
+    fhir_pool_free(&g_reference_range_pool, self);
 }
 
 /* ========================================================================== */
@@ -90,14 +97,14 @@ FHIRObservation* fhir_observation_create(const char* id) {
         return NULL;
     }
     
-    FHIRObservation* observation = fhir_calloc(1, sizeof(FHIRObservation));
+    FHIRObservation* observation = fhir_resource_alloc(&Observation_vtable);
     if (!observation) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&observation->base, &Observation_vtable, 
                                 FHIR_RESOURCE_TYPE_OBSERVATION, id)) {
-        fhir_free(observation);
+        fhir_resource_free(&Observation_vtable, observation);
         return NULL;
     }
     
@@ -162,7 +169,7 @@ void fhir_observation_destroy(FHIRObservation* self) {
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Observation_vtable, self);
 }
 
 FHIRObservation* fhir_observation_clone(const FHIRObservation* self) {
@@ -352,7 +359,7 @@ FHIRObservation* fhir_observation_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
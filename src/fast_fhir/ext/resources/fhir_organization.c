@@ -3,19 +3,163 @@
  * @brief FHIR R5 Organization resource C implementation with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ *
+ * The codec is the field table below run by common/fhir_schema.c: one pass
+ * over the JSON members with a generated key switch, each value allocated
+ * at its exact size.
  */
 
 #include "fhir_organization.h"
 #include "../common/fhir_common.h"
-#include <stdlib.h>
-#include <string.h>
+#include "../common/fhir_json_reader.h"
+#include "../common/fhir_schema.h"
+#include "../fhir_datatype_schemas.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ========================================================================== */
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Organization, organization)
+FHIR_RESOURCE_VTABLE_INIT(Organization, organization, ORGANIZATION)
+
+/* ========================================================================== */
+/* Organization Schema                                                        */
+/* ========================================================================== */
+
+typedef enum {
+    FHIR_ORGANIZATION_FIELD_IDENTIFIER,
+    FHIR_ORGANIZATION_FIELD_ACTIVE,
+    FHIR_ORGANIZATION_FIELD_TYPE,
+    FHIR_ORGANIZATION_FIELD_NAME,
+    FHIR_ORGANIZATION_FIELD_ALIAS,
+    FHIR_ORGANIZATION_FIELD_DESCRIPTION,
+    FHIR_ORGANIZATION_FIELD_CONTACT,
+    FHIR_ORGANIZATION_FIELD_PART_OF,
+    FHIR_ORGANIZATION_FIELD_ENDPOINT,
+    FHIR_ORGANIZATION_FIELD_QUALIFICATION,
+} FHIROrganizationField;
+
+static const FHIRSchemaField g_organization_fields[] = {
+    { .key = "identifier", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIROrganization, identifier), .count_offset = offsetof(FHIROrganization, identifier_count),
+      .schema = &fhir_identifier_schema },
+    { .key = "active", .kind = FHIR_SCHEMA_BOOLEAN, .flags = 0,
+      .offset = offsetof(FHIROrganization, active) },
+    { .key = "type", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIROrganization, type), .count_offset = offsetof(FHIROrganization, type_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "name", .kind = FHIR_SCHEMA_STRING, .flags = 0,
+      .offset = offsetof(FHIROrganization, name) },
+    { .key = "alias", .kind = FHIR_SCHEMA_STRING, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIROrganization, alias), .count_offset = offsetof(FHIROrganization, alias_count) },
+    { .key = "description", .kind = FHIR_SCHEMA_STRING, .flags = 0,
+      .offset = offsetof(FHIROrganization, description) },
+    { .key = "contact", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIROrganization, contact) },
+    { .key = "partOf", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIROrganization, part_of),
+      .schema = &fhir_reference_schema },
+    { .key = "endpoint", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIROrganization, endpoint), .count_offset = offsetof(FHIROrganization, endpoint_count),
+      .schema = &fhir_reference_schema },
+    { .key = "qualification", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIROrganization, qualification) },
+};
+
+static int fhir_organization_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            switch (key[2]) {
+                case 'm':
+                    if (memcmp(key, "name", 4) == 0) return FHIR_ORGANIZATION_FIELD_NAME;
+                    break;
+                case 'p':
+                    if (memcmp(key, "type", 4) == 0) return FHIR_ORGANIZATION_FIELD_TYPE;
+                    break;
+                case 't':
+                    if (memcmp(key, "meta", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'x':
+                    if (memcmp(key, "text", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(key, "alias", 5) == 0) return FHIR_ORGANIZATION_FIELD_ALIAS;
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "active", 6) == 0) return FHIR_ORGANIZATION_FIELD_ACTIVE;
+                    break;
+                case 'p':
+                    if (memcmp(key, "partOf", 6) == 0) return FHIR_ORGANIZATION_FIELD_PART_OF;
+                    break;
+            }
+            break;
+        case 7:
+            if (memcmp(key, "contact", 7) == 0) return FHIR_ORGANIZATION_FIELD_CONTACT;
+            break;
+        case 8:
+            switch (key[0]) {
+                case 'e':
+                    if (memcmp(key, "endpoint", 8) == 0) return FHIR_ORGANIZATION_FIELD_ENDPOINT;
+                    break;
+                case 'l':
+                    if (memcmp(key, "language", 8) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "contained", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'e':
+                    if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 10:
+            if (memcmp(key, "identifier", 10) == 0) return FHIR_ORGANIZATION_FIELD_IDENTIFIER;
+            break;
+        case 11:
+            if (memcmp(key, "description", 11) == 0) return FHIR_ORGANIZATION_FIELD_DESCRIPTION;
+            break;
+        case 12:
+            if (memcmp(key, "resourceType", 12) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 13:
+            switch (key[0]) {
+                case 'i':
+                    if (memcmp(key, "implicitRules", 13) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'q':
+                    if (memcmp(key, "qualification", 13) == 0) return FHIR_ORGANIZATION_FIELD_QUALIFICATION;
+                    break;
+            }
+            break;
+        case 17:
+            if (memcmp(key, "modifierExtension", 17) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+static const FHIRSchema g_organization_schema = {
+    .name = "Organization",
+    .size = sizeof(FHIROrganization),
+    .fields = g_organization_fields,
+    .field_count = sizeof(g_organization_fields) / sizeof(g_organization_fields[0]),
+    .lookup = fhir_organization_field_lookup
+};
 
 /* ========================================================================== */
 /* Organization Factory and Lifecycle Methods                             */
@@ -27,43 +171,27 @@ FHIROrganization* fhir_organization_create(const char* id) {
         return NULL;
     }
     
-    FHIROrganization* organization = fhir_calloc(1, sizeof(FHIROrganization));
+    FHIROrganization* organization = fhir_resource_alloc(&Organization_vtable);
     if (!organization) {
         return NULL;
     }
     
-    if (!fhir_resource_base_init(&organization->base, &Organization_vtable, 
+    if (!fhir_resource_base_init(&organization->base, &Organization_vtable,
                                 FHIR_RESOURCE_TYPE_ORGANIZATION, id)) {
-        fhir_free(organization);
+        fhir_resource_free(&Organization_vtable, organization);
         return NULL;
     }
     
-    // Initialize Organization-specific defaults
-    organization->active = fhir_boolean_create(true);
-    
     return organization;
 }
 
 void fhir_organization_destroy(FHIROrganization* self) {
     if (!self) return;
     
-    // Free Organization-specific fields
-    if (self->active) fhir_boolean_destroy(self->active);
-    if (self->name) fhir_string_destroy(self->name);
-    if (self->description) fhir_markdown_destroy(self->description);
-    if (self->part_of) fhir_reference_destroy(self->part_of);
-    
-    // Free arrays
-    fhir_array_destroy((void**)self->type, self->type_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->alias, self->alias_count, (FHIRDestroyFunc)fhir_string_destroy);
-    fhir_array_destroy((void**)self->contact, self->contact_count, (FHIRDestroyFunc)fhir_extendedcontactdetail_destroy);
-    fhir_array_destroy((void**)self->endpoint, self->endpoint_count, (FHIRDestroyFunc)fhir_reference_destroy);
-    fhir_array_destroy((void**)self->qualification, self->qualification_count, (FHIRDestroyFunc)fhir_organizationqualification_destroy);
-    
-    // Free base resource
+    fhir_schema_clear(&g_organization_schema, self);
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Organization_vtable, self);
 }
 
 FHIROrganization* fhir_organization_clone(const FHIROrganization* self) {
@@ -72,30 +200,11 @@ FHIROrganization* fhir_organization_clone(const FHIROrganization* self) {
     FHIROrganization* clone = fhir_organization_create(self->base.id);
     if (!clone) return NULL;
     
-    // Clone Organization-specific fields
-    if (self->active) {
-        clone->active = fhir_boolean_clone(self->active);
-    }
-    if (self->name) {
-        clone->name = fhir_string_clone(self->name);
-    }
-    if (self->description) {
-        clone->description = fhir_markdown_clone(self->description);
-    }
-    if (self->part_of) {
-        clone->part_of = fhir_reference_clone(self->part_of);
+    if (!fhir_schema_copy(&g_organization_schema, clone, self)) {
+        fhir_organization_destroy(clone);
+        return NULL;
     }
     
-    // Clone arrays
-    clone->type = fhir_array_clone((void**)self->type, self->type_count, 
-                                  (FHIRCloneFunc)fhir_codeableconcept_clone, &clone->type_count);
-    clone->alias = fhir_array_clone((void**)self->alias, self->alias_count, 
-                                   (FHIRCloneFunc)fhir_string_clone, &clone->alias_count);
-    clone->contact = fhir_array_clone((void**)self->contact, self->contact_count, 
-                                     (FHIRCloneFunc)fhir_extendedcontactdetail_clone, &clone->contact_count);
-    clone->endpoint = fhir_array_clone((void**)self->endpoint, self->endpoint_count, 
-                                      (FHIRCloneFunc)fhir_reference_clone, &clone->endpoint_count);
-    
     return clone;
 }
 
@@ -117,39 +226,12 @@ cJSON* fhir_organization_to_json(const FHIROrganization* self) {
     
     // Add resource type and id
     if (!fhir_json_add_string(json, "resourceType", "Organization") ||
-        !fhir_json_add_string(json, "id", self->base.id)) {
+        !fhir_json_add_string(json, "id", self->base.id) ||
+        !fhir_schema_to_json(&g_organization_schema, self, json)) {
         cJSON_Delete(json);
         return NULL;
     }
     
-    // Add Organization-specific fields
-    if (self->active) {
-        fhir_json_add_boolean(json, "active", self->active);
-    }
-    if (self->name) {
-        fhir_json_add_string_value(json, "name", self->name);
-    }
-    if (self->description) {
-        fhir_json_add_markdown(json, "description", self->description);
-    }
-    if (self->part_of) {
-        fhir_json_add_reference(json, "partOf", self->part_of);
-    }
-    
-    // Add arrays
-    if (self->type && self->type_count > 0) {
-        fhir_json_add_codeableconcept_array(json, "type", self->type, self->type_count);
-    }
-    if (self->alias && self->alias_count > 0) {
-        fhir_json_add_string_array(json, "alias", self->alias, self->alias_count);
-    }
-    if (self->contact && self->contact_count > 0) {
-        fhir_json_add_extendedcontactdetail_array(json, "contact", self->contact, self->contact_count);
-    }
-    if (self->endpoint && self->endpoint_count > 0) {
-        fhir_json_add_reference_array(json, "endpoint", self->endpoint, self->endpoint_count);
-    }
-    
     return json;
 }
 
@@ -159,51 +241,7 @@ bool fhir_organization_from_json(FHIROrganization* self, const cJSON* json) {
         return false;
     }
     
-    // Validate resource type
-    const char* resource_type = fhir_json_get_string(json, "resourceType");
-    if (!resource_type || strcmp(resource_type, "Organization") != 0) {
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
-        return false;
-    }
-    
-    // Parse Organization-specific fields
-    const cJSON* active_json = cJSON_GetObjectItem(json, "active");
-    if (active_json) {
-        self->active = fhir_json_parse_boolean(active_json);
-    }
-    
-    const cJSON* name_json = cJSON_GetObjectItem(json, "name");
-    if (name_json) {
-        self->name = fhir_json_parse_string(name_json);
-    }
-    
-    const cJSON* description_json = cJSON_GetObjectItem(json, "description");
-    if (description_json) {
-        self->description = fhir_json_parse_markdown(description_json);
-    }
-    
-    const cJSON* part_of_json = cJSON_GetObjectItem(json, "partOf");
-    if (part_of_json) {
-        self->part_of = fhir_json_parse_reference(part_of_json);
-    }
-    
-    // Parse arrays
-    const cJSON* type_json = cJSON_GetObjectItem(json, "type");
-    if (type_json && cJSON_IsArray(type_json)) {
-        self->type = fhir_json_parse_codeableconcept_array(type_json, &self->type_count);
-    }
-    
-    const cJSON* alias_json = cJSON_GetObjectItem(json, "alias");
-    if (alias_json && cJSON_IsArray(alias_json)) {
-        self->alias = fhir_json_parse_string_array(alias_json, &self->alias_count);
-    }
-    
-    const cJSON* contact_json = cJSON_GetObjectItem(json, "contact");
-    if (contact_json && cJSON_IsArray(contact_json)) {
-        self->contact = fhir_json_parse_extendedcontactdetail_array(contact_json, &self->contact_count);
-    }
-    
-    return true;
+    return fhir_schema_load_resource(&g_organization_schema, self, json);
 }
 
 FHIROrganization* fhir_organization_parse(const char* json_string) {
@@ -212,7 +250,7 @@ FHIROrganization* fhir_organization_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -253,8 +291,31 @@ bool fhir_organization_validate(const FHIROrganization* self) {
         return false;
     }
     
-    // Organization has no required fields beyond base resource
-    return true;
+    return fhir_schema_validate(&g_organization_schema, self);
+}
+
+bool fhir_organization_equals(const FHIROrganization* self, const FHIROrganization* other) {
+    if (self == other) return true;
+    if (!self || !other) return false;
+    
+    if (fhir_strcmp(self->base.id, other->base.id) != 0) return false;
+    return fhir_schema_equals(&g_organization_schema, self, other);
+}
+
+char* fhir_organization_to_string(const FHIROrganization* self) {
+    if (!self) return NULL;
+    
+    const char* display_name = fhir_organization_get_display_name(self);
+    
+    char* result = fhir_malloc(256);
+    if (!result) return NULL;
+    
+    snprintf(result, 256, "Organization(id=%s, name=%s, active=%s)",
+             self->base.id ? self->base.id : "unknown",
+             display_name ? display_name : "unknown",
+             fhir_organization_is_active(self) ? "true" : "false");
+    
+    return result;
 }
 
 /* ========================================================================== */
@@ -262,18 +323,16 @@ bool fhir_organization_validate(const FHIROrganization* self) {
 /* ========================================================================== */
 
 bool fhir_organization_is_active(const FHIROrganization* self) {
-    if (!self || !self->active) return false;
-    return self->active->value;
+    return self && self->active && self->active->value;
 }
 
 const char* fhir_organization_get_display_name(const FHIROrganization* self) {
     if (!self) return NULL;
     
-    // Return organization name if available
     if (self->name && self->name->value) {
         return self->name->value;
     }
-    
+
     return "Organization";
 }
 
@@ -286,4 +345,4 @@ bool fhir_organization_register(void) {
     };
     
     return fhir_resource_register_type(&registration);
-}
\ No newline at end of file
+}
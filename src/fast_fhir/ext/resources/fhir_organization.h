@@ -3,8 +3,10 @@
  * @brief FHIR R5 Organization resource C interface with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
- * 
+ *
  * A formally or informally recognized grouping of people or organizations
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
  */
 
 #ifndef FHIR_ORGANIZATION_H
@@ -21,11 +23,14 @@ extern "C" {
 
 /**
  * @brief FHIR R5 Organization resource structure
- * 
+ *
  * A formally or informally recognized grouping of people or organizations
  */
 FHIR_RESOURCE_DEFINE(Organization)
     // Organization-specific fields
+    FHIRIdentifier** identifier;
+    size_t identifier_count;
+    
     FHIRBoolean* active;
     
     FHIRCodeableConcept** type;
@@ -38,16 +43,14 @@ FHIR_RESOURCE_DEFINE(Organization)
     
     FHIRMarkdown* description;
     
-    FHIRExtendedContactDetail** contact;
-    size_t contact_count;
+    cJSON* contact;
     
     FHIRReference* part_of;
     
     FHIRReference** endpoint;
     size_t endpoint_count;
     
-    FHIROrganizationQualification** qualification;
-    size_t qualification_count;
+    cJSON* qualification;
     
 };
 
@@ -112,6 +115,21 @@ FHIROrganization* fhir_organization_parse(const char* json_string);
  */
 bool fhir_organization_validate(const FHIROrganization* self);
 
+/**
+ * @brief Check if two Organizations are equal (virtual method)
+ * @param self First Organization
+ * @param other Second Organization
+ * @return true if equal, false otherwise
+ */
+bool fhir_organization_equals(const FHIROrganization* self, const FHIROrganization* other);
+
+/**
+ * @brief Convert Organization to string representation (virtual method)
+ * @param self Organization to convert
+ * @return String representation (must be freed by caller)
+ */
+char* fhir_organization_to_string(const FHIROrganization* self);
+
 /* ========================================================================== */
 /* Organization-Specific Methods                                          */
 /* ========================================================================== */
@@ -140,4 +158,4 @@ bool fhir_organization_register(void);
 }
 #endif
 
-#endif /* FHIR_ORGANIZATION_H */
\ No newline at end of file
+#endif /* FHIR_ORGANIZATION_H */
@@ -6,7 +6,12 @@
  */
 
 #include "fhir_patient.h"
+#include "fhir_patient_members.h"
 #include "../common/fhir_common.h"
+#include "../common/fhir_json_reader.h"
+#include "../common/fhir_hash.h"
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -28,13 +33,46 @@ static const char* g_gender_strings[] = {
 /* ========================================================================== */
 
 static void fhir_patient_free_arrays(FHIRPatient* self);
-static bool fhir_patient_validate_internal(const FHIRPatient* self, char*** errors, size_t* error_count);
+static bool fhir_patient_copy_scalars(const FHIRPatient* self, FHIRPatient* clone);
+static bool fhir_patient_append_copy(void*** array, size_t* count, const void* element,
+                                     size_t element_size);
+static bool fhir_patient_materialize_field(const FHIRPatient* self, FHIRPatientLazyField field);
+static void* fhir_patient_copy_human_name(const void* name);
+static void* fhir_patient_copy_contact_point(const void* telecom);
+static void* fhir_patient_copy_address(const void* address);
 
 /* ========================================================================== */
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Patient, patient)
+FHIR_RESOURCE_VTABLE_INIT_WITH_BINARY(Patient, patient, PATIENT)
+
+// Arrays shared by copy-on-write clones
+static const FHIRSharedField g_patient_shared_fields[FHIR_PATIENT_SHARED_FIELD_COUNT] = {
+    [FHIR_PATIENT_SHARED_IDENTIFIER] = FHIR_SHARED_FIELD(FHIRPatient, identifier, FHIRIdentifier,
+                                                         shared[FHIR_PATIENT_SHARED_IDENTIFIER]),
+    [FHIR_PATIENT_SHARED_NAME] = FHIR_SHARED_FIELD_WITH_COPY(FHIRPatient, name, FHIRHumanName,
+                                                             shared[FHIR_PATIENT_SHARED_NAME],
+                                                             fhir_patient_copy_human_name),
+    [FHIR_PATIENT_SHARED_TELECOM] = FHIR_SHARED_FIELD_WITH_COPY(FHIRPatient, telecom, FHIRContactPoint,
+                                                                shared[FHIR_PATIENT_SHARED_TELECOM],
+                                                                fhir_patient_copy_contact_point),
+    [FHIR_PATIENT_SHARED_ADDRESS] = FHIR_SHARED_FIELD_WITH_COPY(FHIRPatient, address, FHIRAddress,
+                                                                shared[FHIR_PATIENT_SHARED_ADDRESS],
+                                                                fhir_patient_copy_address),
+    [FHIR_PATIENT_SHARED_PHOTO] = FHIR_SHARED_FIELD(FHIRPatient, photo, FHIRAttachment,
+                                                    shared[FHIR_PATIENT_SHARED_PHOTO]),
+    [FHIR_PATIENT_SHARED_CONTACT] = FHIR_SHARED_FIELD(FHIRPatient, contact, FHIRPatientContact,
+                                                      shared[FHIR_PATIENT_SHARED_CONTACT]),
+    [FHIR_PATIENT_SHARED_COMMUNICATION] = FHIR_SHARED_FIELD(FHIRPatient, communication,
+                                                            FHIRPatientCommunication,
+                                                            shared[FHIR_PATIENT_SHARED_COMMUNICATION]),
+    [FHIR_PATIENT_SHARED_GENERAL_PRACTITIONER] = FHIR_SHARED_FIELD(FHIRPatient, general_practitioner,
+                                                                   FHIRReference,
+                                                                   shared[FHIR_PATIENT_SHARED_GENERAL_PRACTITIONER]),
+    [FHIR_PATIENT_SHARED_LINK] = FHIR_SHARED_FIELD(FHIRPatient, link, FHIRPatientLink,
+                                                   shared[FHIR_PATIENT_SHARED_LINK])
+};
 
 /* ========================================================================== */
 /* Patient Factory and Lifecycle Methods                                     */
@@ -46,13 +84,13 @@ FHIRPatient* fhir_patient_create(const char* id) {
         return NULL;
     }
     
-    FHIRPatient* patient = fhir_calloc(1, sizeof(FHIRPatient));
+    FHIRPatient* patient = fhir_resource_alloc(&Patient_vtable);
     if (!patient) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&patient->base, &Patient_vtable, FHIR_RESOURCE_TYPE_PATIENT, id)) {
-        fhir_free(patient);
+        fhir_resource_free(&Patient_vtable, patient);
         return NULL;
     }
     
@@ -65,48 +103,48 @@ FHIRPatient* fhir_patient_create(const char* id) {
 void fhir_patient_destroy(FHIRPatient* self) {
     if (!self) return;
     
+    // Drop shared arrays first so only privately owned ones are freed
+    fhir_resource_release_shared_fields(&self->base, g_patient_shared_fields,
+                                        FHIR_PATIENT_SHARED_FIELD_COUNT);
+    
     // Free Patient-specific fields
     fhir_patient_free_arrays(self);
     
     // Free choice type fields
     fhir_free(self->deceased_boolean);
+    if (self->deceased_date_time) {
+        fhir_free(self->deceased_date_time->value);
+    }
     fhir_free(self->deceased_date_time);
     fhir_free(self->multiple_birth_boolean);
     fhir_free(self->multiple_birth_integer);
     
     // Free single fields
     fhir_free(self->active);
+    if (self->birth_date) {
+        fhir_free(self->birth_date->value);
+    }
     fhir_free(self->birth_date);
     fhir_free(self->marital_status);
     fhir_free(self->managing_organization);
+    cJSON_Delete(self->lazy_json);
     
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Patient_vtable, self);
 }
 
 FHIRPatient* fhir_patient_clone(const FHIRPatient* self) {
-    if (!self) return NULL;
+    if (!self || !fhir_patient_materialize(self)) return NULL;
     
     FHIRPatient* clone = fhir_patient_create(self->base.id);
     if (!clone) return NULL;
     
     // Clone Patient-specific fields
-    if (self->active) {
-        clone->active = fhir_malloc(sizeof(FHIRBoolean));
-        if (clone->active) {
-            clone->active->value = self->active->value;
-        }
-    }
-    
-    clone->gender = self->gender;
-    
-    if (self->birth_date) {
-        clone->birth_date = fhir_malloc(sizeof(FHIRDate));
-        if (clone->birth_date && self->birth_date->value) {
-            clone->birth_date->value = fhir_strdup(self->birth_date->value);
-        }
+    if (!fhir_patient_copy_scalars(self, clone)) {
+        fhir_patient_destroy(clone);
+        return NULL;
     }
     
     // Clone arrays (simplified - full implementation would deep copy all arrays)
@@ -130,10 +168,98 @@ FHIRPatient* fhir_patient_clone(const FHIRPatient* self) {
     return clone;
 }
 
+FHIRPatient* fhir_patient_clone_cow(const FHIRPatient* self) {
+    if (!self) return NULL;
+    
+    // Arena-owned patients are freed with their arena, so nothing can outlive them by sharing
+    if (self->base.arena || fhir_arena_get_current()) {
+        return fhir_patient_clone(self);
+    }
+    if (!fhir_patient_materialize(self)) return NULL;
+    
+    FHIRPatient* clone = fhir_patient_create(self->base.id);
+    if (!clone) return NULL;
+    
+    if (!fhir_resource_share_fields(&self->base, &clone->base, g_patient_shared_fields,
+                                    FHIR_PATIENT_SHARED_FIELD_COUNT) ||
+        !fhir_patient_copy_scalars(self, clone)) {
+        fhir_patient_destroy(clone);
+        return NULL;
+    }
+    
+    return clone;
+}
+
 /* ========================================================================== */
 /* Private Helper Functions                                                   */
 /* ========================================================================== */
 
+static bool fhir_patient_append_copy(void*** array, size_t* count, const void* element,
+                                     size_t element_size) {
+    // Array elements are owned (and freed) by the patient, so store a copy
+    void* copy = fhir_malloc(element_size);
+    if (!copy) return false;
+    memcpy(copy, element, element_size);
+    
+    if (!fhir_array_add((void**)array, count, &copy, sizeof(void*))) {
+        fhir_free(copy);
+        return false;
+    }
+    return true;
+}
+
+static bool fhir_patient_copy_scalars(const FHIRPatient* self, FHIRPatient* clone) {
+    clone->gender = self->gender;
+    
+    if (self->active) {
+        clone->active = fhir_malloc(sizeof(FHIRBoolean));
+        if (!clone->active) return false;
+        clone->active->value = self->active->value;
+    }
+    
+    if (self->birth_date) {
+        clone->birth_date = fhir_calloc(1, sizeof(FHIRDate));
+        if (!clone->birth_date) return false;
+        if (self->birth_date->value) {
+            clone->birth_date->value = fhir_strdup(self->birth_date->value);
+            if (!clone->birth_date->value) return false;
+        }
+        clone->birth_date->parsed = self->birth_date->parsed;
+    }
+    
+    // Deceased information (choice type)
+    if (self->deceased_boolean) {
+        clone->deceased_boolean = fhir_malloc(sizeof(FHIRBoolean));
+        if (!clone->deceased_boolean) return false;
+        clone->deceased_boolean->value = self->deceased_boolean->value;
+    }
+    
+    if (self->deceased_date_time) {
+        clone->deceased_date_time = fhir_calloc(1, sizeof(FHIRDateTime));
+        if (!clone->deceased_date_time) return false;
+        if (self->deceased_date_time->value) {
+            clone->deceased_date_time->value = fhir_strdup(self->deceased_date_time->value);
+            if (!clone->deceased_date_time->value) return false;
+        }
+        clone->deceased_date_time->parsed = self->deceased_date_time->parsed;
+    }
+    
+    // Multiple birth information (choice type)
+    if (self->multiple_birth_boolean) {
+        clone->multiple_birth_boolean = fhir_malloc(sizeof(FHIRBoolean));
+        if (!clone->multiple_birth_boolean) return false;
+        clone->multiple_birth_boolean->value = self->multiple_birth_boolean->value;
+    }
+    
+    if (self->multiple_birth_integer) {
+        clone->multiple_birth_integer = fhir_malloc(sizeof(FHIRInteger));
+        if (!clone->multiple_birth_integer) return false;
+        clone->multiple_birth_integer->value = self->multiple_birth_integer->value;
+    }
+    
+    return true;
+}
+
 static void fhir_patient_free_arrays(FHIRPatient* self) {
     if (!self) return;
     
@@ -208,8 +334,585 @@ static void fhir_patient_free_arrays(FHIRPatient* self) {
         }
         fhir_free(self->link);
     }
-}/* =====
-===================================================================== */
+}
+
+/* ========================================================================== */
+/* Patient Sub-structures                                                     */
+/* ========================================================================== */
+
+// Sub-structures are built as one block: the struct, its string pointer arrays,
+// then the string bytes. fhir_patient_free_arrays releases each element with a
+// single fhir_free, and a block never points into the source JSON, so it can
+// outlive it (lazily parsed Patients, copy-on-write clones).
+
+typedef enum {
+    FHIR_PATIENT_FIELD_STRING,          // char*
+    FHIR_PATIENT_FIELD_STRING_LIST,     // char** plus a size_t count
+    FHIR_PATIENT_FIELD_SINGLE_LIST,     // As STRING_LIST, but a single string in JSON
+    FHIR_PATIENT_FIELD_UINT             // unsigned int
+} FHIRPatientFieldKind;
+
+typedef struct {
+    const char* key;                    // JSON member
+    FHIRPatientFieldKind kind;
+    size_t offset;
+    size_t count_offset;                // STRING_LIST and SINGLE_LIST only
+} FHIRPatientStructField;
+
+typedef struct {
+    size_t size;
+    const FHIRPatientStructField* fields;   // Binary field number = index + 1; append only
+    size_t field_count;
+} FHIRPatientStructSpec;
+
+#define FHIR_PATIENT_STRING(type, key, member) \
+    { key, FHIR_PATIENT_FIELD_STRING, offsetof(type, member), 0 }
+#define FHIR_PATIENT_LIST(type, kind, key, member) \
+    { key, kind, offsetof(type, member), offsetof(type, member##_count) }
+
+static const FHIRPatientStructField g_human_name_fields[] = {
+    FHIR_PATIENT_STRING(FHIRHumanName, "use", use),
+    FHIR_PATIENT_STRING(FHIRHumanName, "text", text),
+    FHIR_PATIENT_LIST(FHIRHumanName, FHIR_PATIENT_FIELD_SINGLE_LIST, "family", family),
+    FHIR_PATIENT_LIST(FHIRHumanName, FHIR_PATIENT_FIELD_STRING_LIST, "given", given),
+    FHIR_PATIENT_LIST(FHIRHumanName, FHIR_PATIENT_FIELD_STRING_LIST, "prefix", prefix),
+    FHIR_PATIENT_LIST(FHIRHumanName, FHIR_PATIENT_FIELD_STRING_LIST, "suffix", suffix)
+};
+
+static const FHIRPatientStructField g_contact_point_fields[] = {
+    FHIR_PATIENT_STRING(FHIRContactPoint, "system", system),
+    FHIR_PATIENT_STRING(FHIRContactPoint, "value", value),
+    FHIR_PATIENT_STRING(FHIRContactPoint, "use", use),
+    { "rank", FHIR_PATIENT_FIELD_UINT, offsetof(FHIRContactPoint, rank), 0 }
+};
+
+static const FHIRPatientStructField g_address_fields[] = {
+    FHIR_PATIENT_STRING(FHIRAddress, "use", use),
+    FHIR_PATIENT_STRING(FHIRAddress, "type", type),
+    FHIR_PATIENT_STRING(FHIRAddress, "text", text),
+    FHIR_PATIENT_LIST(FHIRAddress, FHIR_PATIENT_FIELD_STRING_LIST, "line", line),
+    FHIR_PATIENT_STRING(FHIRAddress, "city", city),
+    FHIR_PATIENT_STRING(FHIRAddress, "district", district),
+    FHIR_PATIENT_STRING(FHIRAddress, "state", state),
+    FHIR_PATIENT_STRING(FHIRAddress, "postalCode", postal_code),
+    FHIR_PATIENT_STRING(FHIRAddress, "country", country)
+};
+
+static const FHIRPatientStructField g_reference_fields[] = {
+    FHIR_PATIENT_STRING(FHIRReference, "reference", reference),
+    FHIR_PATIENT_STRING(FHIRReference, "type", type),
+    FHIR_PATIENT_STRING(FHIRReference, "display", display)
+};
+
+#define FHIR_PATIENT_STRUCT_SPEC(type, fields) \
+    { sizeof(type), fields, sizeof(fields) / sizeof(fields[0]) }
+
+// Upper bound on field_count; binary field numbers above it are markers
+#define FHIR_PATIENT_STRUCT_MAX_FIELDS 14
+
+static const FHIRPatientStructSpec g_human_name_spec = FHIR_PATIENT_STRUCT_SPEC(FHIRHumanName, g_human_name_fields);
+static const FHIRPatientStructSpec g_contact_point_spec = FHIR_PATIENT_STRUCT_SPEC(FHIRContactPoint, g_contact_point_fields);
+static const FHIRPatientStructSpec g_address_spec = FHIR_PATIENT_STRUCT_SPEC(FHIRAddress, g_address_fields);
+static const FHIRPatientStructSpec g_reference_spec = FHIR_PATIENT_STRUCT_SPEC(FHIRReference, g_reference_fields);
+
+// Binary field numbers; never reuse a number once documents with it exist
+typedef enum {
+    FHIR_PATIENT_BINARY_ACTIVE = 1,
+    FHIR_PATIENT_BINARY_GENDER,
+    FHIR_PATIENT_BINARY_BIRTH_DATE,
+    FHIR_PATIENT_BINARY_DECEASED_BOOLEAN,
+    FHIR_PATIENT_BINARY_DECEASED_DATE_TIME,
+    FHIR_PATIENT_BINARY_IDENTIFIER,         // Message of FHIR_PATIENT_BINARY_IDENTIFIER_* fields
+    FHIR_PATIENT_BINARY_UNKNOWN_MEMBER,
+    FHIR_PATIENT_BINARY_NAME,               // Messages of sub-structure fields (spec index + 1)
+    FHIR_PATIENT_BINARY_TELECOM,
+    FHIR_PATIENT_BINARY_ADDRESS,
+    FHIR_PATIENT_BINARY_MANAGING_ORGANIZATION
+} FHIRPatientBinaryField;
+
+enum {
+    FHIR_PATIENT_BINARY_IDENTIFIER_USE = 1,
+    FHIR_PATIENT_BINARY_IDENTIFIER_SYSTEM,
+    FHIR_PATIENT_BINARY_IDENTIFIER_NONE     // Slot without an identifier
+};
+
+// Slot without a sub-structure
+#define FHIR_PATIENT_BINARY_STRUCT_NONE (FHIR_PATIENT_STRUCT_MAX_FIELDS + 1)
+
+// Where each lazy field lives and how its elements are built and encoded
+typedef struct {
+    FHIRPatientMember member;
+    const char* key;
+    FHIRPatientBinaryField binary_field;
+    const FHIRPatientStructSpec* spec;      // NULL for identifiers
+    size_t array_offset;                    // Element array, or the single element pointer
+    size_t count_offset;                    // SIZE_MAX for a single element
+} FHIRPatientLazyFieldInfo;
+
+static const FHIRPatientLazyFieldInfo g_patient_lazy_fields[FHIR_PATIENT_LAZY_FIELD_COUNT] = {
+    [FHIR_PATIENT_LAZY_IDENTIFIER] = { FHIR_PATIENT_MEMBER_IDENTIFIER, "identifier",
+                                       FHIR_PATIENT_BINARY_IDENTIFIER, NULL,
+                                       offsetof(FHIRPatient, identifier), offsetof(FHIRPatient, identifier_count) },
+    [FHIR_PATIENT_LAZY_NAME] = { FHIR_PATIENT_MEMBER_NAME, "name", FHIR_PATIENT_BINARY_NAME, &g_human_name_spec,
+                                 offsetof(FHIRPatient, name), offsetof(FHIRPatient, name_count) },
+    [FHIR_PATIENT_LAZY_TELECOM] = { FHIR_PATIENT_MEMBER_TELECOM, "telecom", FHIR_PATIENT_BINARY_TELECOM,
+                                    &g_contact_point_spec,
+                                    offsetof(FHIRPatient, telecom), offsetof(FHIRPatient, telecom_count) },
+    [FHIR_PATIENT_LAZY_ADDRESS] = { FHIR_PATIENT_MEMBER_ADDRESS, "address", FHIR_PATIENT_BINARY_ADDRESS,
+                                    &g_address_spec,
+                                    offsetof(FHIRPatient, address), offsetof(FHIRPatient, address_count) },
+    [FHIR_PATIENT_LAZY_MANAGING_ORGANIZATION] = { FHIR_PATIENT_MEMBER_MANAGING_ORGANIZATION, "managingOrganization",
+                                                  FHIR_PATIENT_BINARY_MANAGING_ORGANIZATION, &g_reference_spec,
+                                                  offsetof(FHIRPatient, managing_organization), SIZE_MAX }
+};
+
+// Elements of a lazy field: its array, or the address of its single pointer
+static void* const* fhir_patient_field_elements(const FHIRPatient* self, FHIRPatientLazyField field,
+                                                size_t* count) {
+    const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+    void* const* target = (void* const*)((const char*)self + info->array_offset);
+    if (info->count_offset == SIZE_MAX) {
+        *count = *target ? 1 : 0;
+        return target;
+    }
+    *count = *(const size_t*)((const char*)self + info->count_offset);
+    return *(void* const* const*)target;
+}
+
+// Materialization state of a lazy field (zero, so eagerly parsed Patients start ready)
+typedef enum {
+    FHIR_PATIENT_LAZY_READY = 0,
+    FHIR_PATIENT_LAZY_PENDING,
+    FHIR_PATIENT_LAZY_BUSY
+} FHIRPatientLazyState;
+
+static char** fhir_patient_field_string(void* element, const FHIRPatientStructField* field) {
+    return (char**)((char*)element + field->offset);
+}
+
+static size_t* fhir_patient_field_count(void* element, const FHIRPatientStructField* field) {
+    return (size_t*)((char*)element + field->count_offset);
+}
+
+// Cursor over the pointer slots and string bytes of a block
+typedef struct {
+    char** slots;
+    char* bytes;
+} FHIRPatientBlock;
+
+static void* fhir_patient_block_alloc(const FHIRPatientStructSpec* spec, size_t slots, size_t bytes,
+                                      FHIRPatientBlock* block) {
+    // Structs holding pointers are sized to a multiple of pointer alignment
+    char* element = fhir_calloc(1, spec->size + slots * sizeof(char*) + bytes);
+    if (!element) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Patient sub-structure");
+        return NULL;
+    }
+    block->slots = (char**)(element + spec->size);
+    block->bytes = (char*)(block->slots + slots);
+    return element;
+}
+
+static char* fhir_patient_block_copy(FHIRPatientBlock* block, const char* value) {
+    size_t size = strlen(value) + 1;
+    char* copy = block->bytes;
+    memcpy(copy, value, size);
+    block->bytes += size;
+    return copy;
+}
+
+// Count the pointer slots and string bytes one JSON member needs
+static size_t fhir_patient_json_field_size(const FHIRPatientStructField* field, const cJSON* json,
+                                           size_t* slots) {
+    if (field->kind == FHIR_PATIENT_FIELD_UINT) return 0;
+    if (cJSON_IsString(json)) {
+        if (field->kind != FHIR_PATIENT_FIELD_STRING) (*slots)++;
+        return strlen(json->valuestring) + 1;
+    }
+    size_t bytes = 0;
+    if (field->kind != FHIR_PATIENT_FIELD_STRING && cJSON_IsArray(json)) {
+        const cJSON* item;
+        cJSON_ArrayForEach(item, json) {
+            if (cJSON_IsString(item)) {
+                (*slots)++;
+                bytes += strlen(item->valuestring) + 1;
+            }
+        }
+    }
+    return bytes;
+}
+
+static void fhir_patient_json_field_fill(void* element, const FHIRPatientStructField* field,
+                                         const cJSON* json, FHIRPatientBlock* block) {
+    if (field->kind == FHIR_PATIENT_FIELD_UINT) {
+        if (cJSON_IsNumber(json) && json->valuedouble >= 0 && json->valuedouble <= UINT_MAX) {
+            *(unsigned int*)((char*)element + field->offset) = (unsigned int)json->valuedouble;
+        }
+        return;
+    }
+    if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+        if (cJSON_IsString(json)) {
+            *fhir_patient_field_string(element, field) = fhir_patient_block_copy(block, json->valuestring);
+        }
+        return;
+    }
+
+    char** list = block->slots;
+    size_t count = 0;
+    if (cJSON_IsString(json)) {
+        list[count++] = fhir_patient_block_copy(block, json->valuestring);
+    } else if (cJSON_IsArray(json)) {
+        const cJSON* item;
+        cJSON_ArrayForEach(item, json) {
+            if (cJSON_IsString(item)) {
+                list[count++] = fhir_patient_block_copy(block, item->valuestring);
+            }
+        }
+    }
+    if (count > 0) {
+        *(char***)fhir_patient_field_string(element, field) = list;
+        *fhir_patient_field_count(element, field) = count;
+        block->slots += count;
+    }
+}
+
+static void* fhir_patient_struct_from_json(const FHIRPatientStructSpec* spec, const cJSON* json) {
+    const cJSON* members[FHIR_PATIENT_STRUCT_MAX_FIELDS] = {0};
+    size_t slots = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < spec->field_count; i++) {
+        members[i] = cJSON_GetObjectItemCaseSensitive(json, spec->fields[i].key);
+        bytes += fhir_patient_json_field_size(&spec->fields[i], members[i], &slots);
+    }
+
+    FHIRPatientBlock block;
+    void* element = fhir_patient_block_alloc(spec, slots, bytes, &block);
+    if (!element) return NULL;
+    for (size_t i = 0; i < spec->field_count; i++) {
+        fhir_patient_json_field_fill(element, &spec->fields[i], members[i], &block);
+    }
+    return element;
+}
+
+static cJSON* fhir_patient_struct_to_json(const FHIRPatientStructSpec* spec, const void* element) {
+    cJSON* json = cJSON_CreateObject();
+    if (!json) return NULL;
+    for (size_t i = 0; i < spec->field_count; i++) {
+        const FHIRPatientStructField* field = &spec->fields[i];
+        void* source = (void*)element;
+        cJSON* value = NULL;
+        if (field->kind == FHIR_PATIENT_FIELD_UINT) {
+            unsigned int number = *(const unsigned int*)((const char*)element + field->offset);
+            value = number ? cJSON_CreateNumber(number) : NULL;
+        } else if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            const char* string = *fhir_patient_field_string(source, field);
+            value = string ? cJSON_CreateString(string) : NULL;
+        } else {
+            char** list = *(char***)fhir_patient_field_string(source, field);
+            size_t count = *fhir_patient_field_count(source, field);
+            if (list && count > 0) {
+                value = field->kind == FHIR_PATIENT_FIELD_SINGLE_LIST
+                            ? cJSON_CreateString(list[0])
+                            : cJSON_CreateStringArray((const char* const*)list, (int)count);
+            }
+        }
+        if (value) {
+            cJSON_AddItemToObject(json, field->key, value);
+        }
+    }
+    return json;
+}
+
+static void fhir_patient_struct_write_json(const FHIRPatientStructSpec* spec, const void* element,
+                                           FHIRWriter* writer) {
+    fhir_writer_begin_object(writer);
+    for (size_t i = 0; i < spec->field_count; i++) {
+        const FHIRPatientStructField* field = &spec->fields[i];
+        void* source = (void*)element;
+        if (field->kind == FHIR_PATIENT_FIELD_UINT) {
+            unsigned int number = *(const unsigned int*)((const char*)element + field->offset);
+            if (number) {
+                fhir_writer_member_int(writer, field->key, number);
+            }
+        } else if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            const char* string = *fhir_patient_field_string(source, field);
+            if (string) {
+                fhir_writer_member_string(writer, field->key, string);
+            }
+        } else {
+            char** list = *(char***)fhir_patient_field_string(source, field);
+            size_t count = *fhir_patient_field_count(source, field);
+            if (!list || count == 0) continue;
+            if (field->kind == FHIR_PATIENT_FIELD_SINGLE_LIST) {
+                fhir_writer_member_string(writer, field->key, list[0]);
+                continue;
+            }
+            fhir_writer_key(writer, field->key);
+            fhir_writer_begin_array(writer);
+            for (size_t j = 0; j < count; j++) {
+                fhir_writer_string(writer, list[j]);
+            }
+            fhir_writer_end_array(writer);
+        }
+    }
+    fhir_writer_end_object(writer);
+}
+
+static void* fhir_patient_struct_copy(const FHIRPatientStructSpec* spec, const void* source) {
+    void* element = (void*)source;
+    size_t slots = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < spec->field_count; i++) {
+        const FHIRPatientStructField* field = &spec->fields[i];
+        if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            const char* string = *fhir_patient_field_string(element, field);
+            bytes += string ? strlen(string) + 1 : 0;
+        } else if (field->kind != FHIR_PATIENT_FIELD_UINT) {
+            char** list = *(char***)fhir_patient_field_string(element, field);
+            size_t count = list ? *fhir_patient_field_count(element, field) : 0;
+            slots += count;
+            for (size_t j = 0; j < count; j++) {
+                bytes += list[j] ? strlen(list[j]) + 1 : 0;
+            }
+        }
+    }
+    
+    FHIRPatientBlock block;
+    void* copy = fhir_patient_block_alloc(spec, slots, bytes, &block);
+    if (!copy) return NULL;
+    memcpy(copy, source, spec->size);
+    for (size_t i = 0; i < spec->field_count; i++) {
+        const FHIRPatientStructField* field = &spec->fields[i];
+        char** string = fhir_patient_field_string(copy, field);
+        if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            if (*string) *string = fhir_patient_block_copy(&block, *string);
+        } else if (field->kind != FHIR_PATIENT_FIELD_UINT) {
+            char** list = *(char***)string;
+            if (!list) continue;
+            size_t count = *fhir_patient_field_count(copy, field);
+            for (size_t j = 0; j < count; j++) {
+                block.slots[j] = list[j] ? fhir_patient_block_copy(&block, list[j]) : NULL;
+            }
+            *(char***)string = block.slots;
+            block.slots += count;
+        }
+    }
+    return copy;
+}
+
+static void* fhir_patient_copy_human_name(const void* name) {
+    return fhir_patient_struct_copy(&g_human_name_spec, name);
+}
+
+static void* fhir_patient_copy_contact_point(const void* telecom) {
+    return fhir_patient_struct_copy(&g_contact_point_spec, telecom);
+}
+
+static void* fhir_patient_copy_address(const void* address) {
+    return fhir_patient_struct_copy(&g_address_spec, address);
+}
+
+// Append a deep copy, so the Patient does not depend on the caller's strings
+static bool fhir_patient_append_struct(void*** array, size_t* count, const FHIRPatientStructSpec* spec,
+                                       const void* element) {
+    void* copy = fhir_patient_struct_copy(spec, element);
+    if (!copy) return false;
+    
+    if (!fhir_array_add((void**)array, count, &copy, sizeof(void*))) {
+        fhir_free(copy);
+        return false;
+    }
+    return true;
+}
+
+static void fhir_patient_struct_to_binary(const FHIRPatientStructSpec* spec, const void* element,
+                                          FHIRBinaryWriter* writer, uint32_t binary_field) {
+    fhir_binary_begin_message(writer, binary_field);
+    if (!element) {
+        fhir_binary_write_bool(writer, FHIR_PATIENT_BINARY_STRUCT_NONE, true);
+        fhir_binary_end_message(writer);
+        return;
+    }
+    for (size_t i = 0; i < spec->field_count; i++) {
+        const FHIRPatientStructField* field = &spec->fields[i];
+        uint32_t number = (uint32_t)i + 1;
+        void* source = (void*)element;
+        if (field->kind == FHIR_PATIENT_FIELD_UINT) {
+            unsigned int value = *(const unsigned int*)((const char*)element + field->offset);
+            if (value) {
+                fhir_binary_write_uint(writer, number, value);
+            }
+        } else if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            fhir_binary_write_string(writer, number, *fhir_patient_field_string(source, field));
+        } else {
+            char** list = *(char***)fhir_patient_field_string(source, field);
+            size_t count = list ? *fhir_patient_field_count(source, field) : 0;
+            for (size_t j = 0; j < count; j++) {
+                fhir_binary_write_string(writer, number, list[j]);
+            }
+        }
+    }
+    fhir_binary_end_message(writer);
+}
+
+// Decode one sub-structure message; NULL for slots written without one
+static bool fhir_patient_struct_from_binary(const FHIRPatientStructSpec* spec, const FHIRBinaryReader* message,
+                                            void** out) {
+    // First pass sizes the block; only the first value of a single string is kept
+    size_t list_slots[FHIR_PATIENT_STRUCT_MAX_FIELDS] = {0};
+    size_t slots = 0;
+    size_t bytes = 0;
+    uint32_t seen = 0;
+    bool empty_slot = false;
+    FHIRBinaryReader reader;
+    fhir_binary_reader_enter(message, &reader);
+    while (fhir_binary_reader_next(&reader)) {
+        if (reader.field == FHIR_PATIENT_BINARY_STRUCT_NONE) {
+            empty_slot = true;
+        }
+        size_t i = reader.field - 1;
+        if (i >= spec->field_count || reader.wire_type != FHIR_BINARY_WIRE_STRING) continue;
+        if (spec->fields[i].kind == FHIR_PATIENT_FIELD_STRING) {
+            if (seen & (1u << i)) continue;
+            seen |= 1u << i;
+        } else if (spec->fields[i].kind != FHIR_PATIENT_FIELD_UINT) {
+            list_slots[i]++;
+            slots++;
+        } else {
+            continue;
+        }
+        bytes += strlen(reader.string_value) + 1;
+    }
+    *out = NULL;
+    if (reader.failed) return false;
+    if (empty_slot) return true;
+    
+    FHIRPatientBlock block;
+    void* element = fhir_patient_block_alloc(spec, slots, bytes, &block);
+    if (!element) return false;
+    for (size_t i = 0; i < spec->field_count; i++) {
+        if (list_slots[i] > 0) {
+            *(char***)fhir_patient_field_string(element, &spec->fields[i]) = block.slots;
+            block.slots += list_slots[i];
+        }
+    }
+    
+    fhir_binary_reader_enter(message, &reader);
+    while (fhir_binary_reader_next(&reader)) {
+        size_t i = reader.field - 1;
+        if (i >= spec->field_count) continue;
+        const FHIRPatientStructField* field = &spec->fields[i];
+        if (field->kind == FHIR_PATIENT_FIELD_UINT) {
+            if (reader.wire_type == FHIR_BINARY_WIRE_VARINT && reader.uint_value <= UINT_MAX) {
+                *(unsigned int*)((char*)element + field->offset) = (unsigned int)reader.uint_value;
+            }
+        } else if (reader.wire_type != FHIR_BINARY_WIRE_STRING) {
+            continue;
+        } else if (field->kind == FHIR_PATIENT_FIELD_STRING) {
+            char** string = fhir_patient_field_string(element, field);
+            if (!*string) *string = fhir_patient_block_copy(&block, reader.string_value);
+        } else {
+            char** list = *(char***)fhir_patient_field_string(element, field);
+            size_t* count = fhir_patient_field_count(element, field);
+            list[(*count)++] = fhir_patient_block_copy(&block, reader.string_value);
+        }
+    }
+    *out = element;
+    return true;
+}
+
+static void* fhir_patient_identifier_from_json(const cJSON* json) {
+    FHIRIdentifier* identifier = fhir_calloc(1, sizeof(FHIRIdentifier));
+    if (!identifier) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate identifier");
+        return NULL;
+    }
+    // Codes and systems repeat across resources, so they are interned
+    const char* use = fhir_json_get_string(json, "use");
+    const char* system = fhir_json_get_string(json, "system");
+    identifier->use = use ? (char*)fhir_intern(use) : NULL;
+    identifier->system = system ? (char*)fhir_intern(system) : NULL;
+    return identifier;
+}
+
+// Build one lazy field from its JSON member; entries that are not objects stay NULL
+static bool fhir_patient_build_field(FHIRPatient* self, FHIRPatientLazyField field, const cJSON* json) {
+    const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+    void** target = (void**)((char*)self + info->array_offset);
+    
+    if (info->count_offset == SIZE_MAX) {
+        if (cJSON_IsObject(json)) {
+            *target = fhir_patient_struct_from_json(info->spec, json);
+            return *target != NULL;
+        }
+        return true;
+    }
+    
+    int array_size = cJSON_IsArray(json) ? cJSON_GetArraySize(json) : 0;
+    if (array_size == 0) return true;
+    
+    void** elements = fhir_calloc((size_t)array_size, sizeof(void*));
+    if (!elements) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Patient array");
+        return false;
+    }
+    int i = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, json) {
+        if (cJSON_IsObject(item)) {
+            elements[i] = info->spec ? fhir_patient_struct_from_json(info->spec, item)
+                                     : fhir_patient_identifier_from_json(item);
+            if (!elements[i]) {
+                while (i-- > 0) {
+                    fhir_free(elements[i]);
+                }
+                fhir_free(elements);
+                return false;
+            }
+        }
+        i++;
+    }
+    *(void***)target = elements;
+    *(size_t*)((char*)self + info->count_offset) = (size_t)array_size;
+    return true;
+}
+
+static bool fhir_patient_materialize_field(const FHIRPatient* self, FHIRPatientLazyField field) {
+    // Logically const, like the validation cache: the field's value is fixed by the source JSON
+    FHIRPatient* patient = (FHIRPatient*)self;
+    FHIRAtomicInt* state = &patient->lazy_state[field];
+    if (fhir_atomic_load(state) == FHIR_PATIENT_LAZY_READY) {
+        return true;
+    }
+    
+    int expected = FHIR_PATIENT_LAZY_PENDING;
+    if (fhir_atomic_compare_exchange(state, &expected, FHIR_PATIENT_LAZY_BUSY)) {
+        // Lazily parsed Patients never live in an arena, so neither do their fields
+        FHIRArena* previous = fhir_arena_set_current(NULL);
+        bool built = fhir_patient_build_field(patient, field, patient->lazy_members[field]);
+        fhir_arena_set_current(previous);
+        fhir_atomic_store(state, built ? FHIR_PATIENT_LAZY_READY : FHIR_PATIENT_LAZY_PENDING);
+        return built;
+    }
+    
+    // Another thread is building it
+    while ((expected = fhir_atomic_load(state)) == FHIR_PATIENT_LAZY_BUSY) {
+    }
+    return expected == FHIR_PATIENT_LAZY_READY;
+}
+
+bool fhir_patient_materialize(const FHIRPatient* self) {
+    if (!self) return false;
+    
+    for (int field = 0; field < FHIR_PATIENT_LAZY_FIELD_COUNT; field++) {
+        if (!fhir_patient_materialize_field(self, (FHIRPatientLazyField)field)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
 /* Patient Serialization Methods                                             */
 /* ========================================================================== */
 
@@ -218,6 +921,9 @@ cJSON* fhir_patient_to_json(const FHIRPatient* self) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Patient is NULL");
         return NULL;
     }
+    if (!fhir_patient_materialize(self)) {
+        return NULL;
+    }
     
     cJSON* json = cJSON_CreateObject();
     if (!json) {
@@ -274,41 +980,125 @@ cJSON* fhir_patient_to_json(const FHIRPatient* self) {
         }
     }
     
-    // Add name array
-    if (self->name && self->name_count > 0) {
-        cJSON* name_array = cJSON_CreateArray();
-        if (name_array) {
-            for (size_t i = 0; i < self->name_count; i++) {
-                if (self->name[i]) {
-                    cJSON* name_json = cJSON_CreateObject();
-                    if (name_json) {
-                        // Serialize name (simplified)
-                        cJSON_AddItemToArray(name_array, name_json);
-                    }
+    // Add name, telecom, address and managingOrganization
+    for (int field = FHIR_PATIENT_LAZY_NAME; field < FHIR_PATIENT_LAZY_FIELD_COUNT; field++) {
+        const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+        size_t count;
+        void* const* elements = fhir_patient_field_elements(self, (FHIRPatientLazyField)field, &count);
+        if (count == 0) continue;
+        
+        if (info->count_offset == SIZE_MAX) {
+            cJSON* element_json = fhir_patient_struct_to_json(info->spec, elements[0]);
+            if (element_json) {
+                cJSON_AddItemToObject(json, info->key, element_json);
+            }
+            continue;
+        }
+        cJSON* array = cJSON_CreateArray();
+        if (array) {
+            for (size_t i = 0; i < count; i++) {
+                cJSON* element_json = elements[i] ? fhir_patient_struct_to_json(info->spec, elements[i]) : NULL;
+                if (element_json) {
+                    cJSON_AddItemToArray(array, element_json);
                 }
             }
-            cJSON_AddItemToObject(json, "name", name_array);
+            cJSON_AddItemToObject(json, info->key, array);
         }
     }
     
     return json;
 }
 
-bool fhir_patient_from_json(FHIRPatient* self, const cJSON* json) {
-    if (!self || !json) {
+bool fhir_patient_write_json(const FHIRPatient* self, FHIRWriter* writer) {
+    if (!self || !writer) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
         return false;
     }
+    if (!fhir_patient_materialize(self)) {
+        return false;
+    }
+    
+    // Members are written in the same order as fhir_patient_to_json
+    fhir_writer_begin_object(writer);
+    fhir_writer_member_string(writer, "resourceType", "Patient");
+    fhir_writer_member_string(writer, "id", self->base.id);
+    
+    if (self->active) {
+        fhir_writer_member_bool(writer, "active", self->active->value);
+    }
+    
+    if (self->gender != FHIR_PATIENT_GENDER_UNKNOWN) {
+        const char* gender_str = fhir_patient_gender_to_string(self->gender);
+        if (gender_str) {
+            fhir_writer_member_string(writer, "gender", gender_str);
+        }
+    }
+    
+    if (self->birth_date && self->birth_date->value) {
+        fhir_writer_member_string(writer, "birthDate", self->birth_date->value);
+    }
+    
+    // Deceased information (choice type)
+    if (self->deceased_boolean) {
+        fhir_writer_member_bool(writer, "deceasedBoolean", self->deceased_boolean->value);
+    } else if (self->deceased_date_time && self->deceased_date_time->value) {
+        fhir_writer_member_string(writer, "deceasedDateTime", self->deceased_date_time->value);
+    }
+    
+    // Identifiers (simplified, as in to_json)
+    if (self->identifier && self->identifier_count > 0) {
+        fhir_writer_key(writer, "identifier");
+        fhir_writer_begin_array(writer);
+        for (size_t i = 0; i < self->identifier_count; i++) {
+            if (self->identifier[i]) {
+                fhir_writer_begin_object(writer);
+                fhir_writer_end_object(writer);
+            }
+        }
+        fhir_writer_end_array(writer);
+    }
+    
+    for (int field = FHIR_PATIENT_LAZY_NAME; field < FHIR_PATIENT_LAZY_FIELD_COUNT; field++) {
+        const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+        size_t count;
+        void* const* elements = fhir_patient_field_elements(self, (FHIRPatientLazyField)field, &count);
+        if (count == 0) continue;
+        
+        fhir_writer_key(writer, info->key);
+        if (info->count_offset == SIZE_MAX) {
+            fhir_patient_struct_write_json(info->spec, elements[0], writer);
+            continue;
+        }
+        fhir_writer_begin_array(writer);
+        for (size_t i = 0; i < count; i++) {
+            if (elements[i]) {
+                fhir_patient_struct_write_json(info->spec, elements[i], writer);
+            }
+        }
+        fhir_writer_end_array(writer);
+    }
+    
+    // Writer errors are sticky, so checking the last call covers the whole object
+    return fhir_writer_end_object(writer);
+}
+
+// Read the scalars now, and the sub-structures now or (lazy) on first access
+static bool fhir_patient_load(FHIRPatient* self, const cJSON* json, bool lazy) {
+    // Collect all members in one pass
+    const cJSON* members[FHIR_PATIENT_MEMBER_COUNT] = {0};
+    if (!fhir_patient_scan_members(json, members, &self->base)) {
+        return false;
+    }
     
     // Validate resource type
-    const char* resource_type = fhir_json_get_string(json, "resourceType");
-    if (!resource_type || strcmp(resource_type, "Patient") != 0) {
+    const cJSON* resource_type = members[FHIR_PATIENT_MEMBER_RESOURCE_TYPE];
+    if (!cJSON_IsString(resource_type) || strcmp(resource_type->valuestring, "Patient") != 0) {
         FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
         return false;
     }
     
     // Parse active field
-    cJSON* active_json = cJSON_GetObjectItem(json, "active");
+    const cJSON* active_json = members[FHIR_PATIENT_MEMBER_ACTIVE];
     if (active_json && cJSON_IsBool(active_json)) {
         self->active = fhir_malloc(sizeof(FHIRBoolean));
         if (self->active) {
@@ -317,70 +1107,262 @@ bool fhir_patient_from_json(FHIRPatient* self, const cJSON* json) {
     }
     
     // Parse gender
-    const char* gender_str = fhir_json_get_string(json, "gender");
-    if (gender_str) {
-        self->gender = fhir_patient_gender_from_string(gender_str);
-    }
-    
-    // Parse birth date
-    const char* birth_date_str = fhir_json_get_string(json, "birthDate");
-    if (birth_date_str) {
-        if (fhir_validate_date(birth_date_str)) {
-            self->birth_date = fhir_malloc(sizeof(FHIRDate));
-            if (self->birth_date) {
-                self->birth_date->value = fhir_strdup(birth_date_str);
-            }
+    const cJSON* gender_json = members[FHIR_PATIENT_MEMBER_GENDER];
+    if (cJSON_IsString(gender_json)) {
+        self->gender = fhir_patient_gender_from_string(gender_json->valuestring);
+    }
+    
+    // Parse birth date; the parsed form is kept for comparisons
+    const cJSON* birth_date_json = members[FHIR_PATIENT_MEMBER_BIRTH_DATE];
+    FHIRDateTimeValue birth_date_value;
+    if (cJSON_IsString(birth_date_json) &&
+        fhir_datetime_parse(birth_date_json->valuestring, &birth_date_value) &&
+        birth_date_value.precision <= FHIR_DATETIME_PRECISION_DAY) {
+        self->birth_date = fhir_calloc(1, sizeof(FHIRDate));
+        if (self->birth_date) {
+            self->birth_date->value = fhir_strdup(birth_date_json->valuestring);
+            self->birth_date->parsed = birth_date_value;
         }
     }
     
     // Parse deceased information (choice type)
-    cJSON* deceased_bool_json = cJSON_GetObjectItem(json, "deceasedBoolean");
+    const cJSON* deceased_bool_json = members[FHIR_PATIENT_MEMBER_DECEASED_BOOLEAN];
+    const cJSON* deceased_datetime_json = members[FHIR_PATIENT_MEMBER_DECEASED_DATE_TIME];
     if (deceased_bool_json && cJSON_IsBool(deceased_bool_json)) {
         self->deceased_boolean = fhir_malloc(sizeof(FHIRBoolean));
         if (self->deceased_boolean) {
             self->deceased_boolean->value = cJSON_IsTrue(deceased_bool_json);
         }
-    } else {
-        const char* deceased_datetime_str = fhir_json_get_string(json, "deceasedDateTime");
-        if (deceased_datetime_str && fhir_validate_datetime(deceased_datetime_str)) {
-            self->deceased_date_time = fhir_malloc(sizeof(FHIRDateTime));
+    } else if (cJSON_IsString(deceased_datetime_json)) {
+        FHIRDateTimeValue deceased_value;
+        if (fhir_datetime_parse(deceased_datetime_json->valuestring, &deceased_value)) {
+            self->deceased_date_time = fhir_calloc(1, sizeof(FHIRDateTime));
             if (self->deceased_date_time) {
-                self->deceased_date_time->value = fhir_strdup(deceased_datetime_str);
+                self->deceased_date_time->value = fhir_strdup(deceased_datetime_json->valuestring);
+                self->deceased_date_time->parsed = deceased_value;
             }
         }
     }
     
-    // Parse arrays (simplified implementation)
-    cJSON* identifier_array = cJSON_GetObjectItem(json, "identifier");
-    if (identifier_array && cJSON_IsArray(identifier_array)) {
-        int array_size = cJSON_GetArraySize(identifier_array);
-        if (array_size > 0) {
-            self->identifier = fhir_calloc(array_size, sizeof(FHIRIdentifier*));
-            if (self->identifier) {
-                self->identifier_count = array_size;
-                for (int i = 0; i < array_size; i++) {
-                    cJSON* identifier_json = cJSON_GetArrayItem(identifier_array, i);
-                    if (identifier_json && cJSON_IsObject(identifier_json)) {
-                        self->identifier[i] = fhir_malloc(sizeof(FHIRIdentifier));
-                        if (self->identifier[i]) {
-                            // Parse identifier fields (simplified)
-                        }
-                    }
-                }
-            }
+    // Sub-structures; a lazy Patient keeps their members for materialization
+    for (int field = 0; field < FHIR_PATIENT_LAZY_FIELD_COUNT; field++) {
+        const cJSON* member = members[g_patient_lazy_fields[field].member];
+        if (!member) continue;
+        if (lazy) {
+            self->lazy_members[field] = member;
+            fhir_atomic_store(&self->lazy_state[field], FHIR_PATIENT_LAZY_PENDING);
+        } else if (!fhir_patient_build_field(self, (FHIRPatientLazyField)field, member)) {
+            return false;
         }
     }
     
     return true;
 }
 
+bool fhir_patient_from_json(FHIRPatient* self, const cJSON* json) {
+    if (!self || !json) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    return fhir_patient_load(self, json, false);
+}
+
+bool fhir_patient_to_binary(const FHIRPatient* self, FHIRBinaryWriter* writer) {
+    if (!self || !writer) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    if (!fhir_patient_materialize(self)) {
+        return false;
+    }
+    
+    if (self->active) {
+        fhir_binary_write_bool(writer, FHIR_PATIENT_BINARY_ACTIVE, self->active->value);
+    }
+    if (self->gender != FHIR_PATIENT_GENDER_UNKNOWN) {
+        fhir_binary_write_uint(writer, FHIR_PATIENT_BINARY_GENDER, (uint64_t)self->gender);
+    }
+    if (self->birth_date) {
+        fhir_binary_write_string(writer, FHIR_PATIENT_BINARY_BIRTH_DATE, self->birth_date->value);
+    }
+    if (self->deceased_boolean) {
+        fhir_binary_write_bool(writer, FHIR_PATIENT_BINARY_DECEASED_BOOLEAN, self->deceased_boolean->value);
+    } else if (self->deceased_date_time) {
+        fhir_binary_write_string(writer, FHIR_PATIENT_BINARY_DECEASED_DATE_TIME,
+                                 self->deceased_date_time->value);
+    }
+    
+    // One message per slot, so entries that were not objects stay NULL
+    for (size_t i = 0; i < self->identifier_count; i++) {
+        fhir_binary_begin_message(writer, FHIR_PATIENT_BINARY_IDENTIFIER);
+        if (self->identifier[i]) {
+            fhir_binary_write_string(writer, FHIR_PATIENT_BINARY_IDENTIFIER_USE, self->identifier[i]->use);
+            fhir_binary_write_string(writer, FHIR_PATIENT_BINARY_IDENTIFIER_SYSTEM, self->identifier[i]->system);
+        } else {
+            fhir_binary_write_bool(writer, FHIR_PATIENT_BINARY_IDENTIFIER_NONE, true);
+        }
+        fhir_binary_end_message(writer);
+    }
+    for (int field = FHIR_PATIENT_LAZY_NAME; field < FHIR_PATIENT_LAZY_FIELD_COUNT; field++) {
+        const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+        size_t count;
+        void* const* elements = fhir_patient_field_elements(self, (FHIRPatientLazyField)field, &count);
+        for (size_t i = 0; i < count; i++) {
+            fhir_patient_struct_to_binary(info->spec, elements[i], writer, info->binary_field);
+        }
+    }
+    
+    for (size_t i = 0; i < self->base.unknown_member_count; i++) {
+        fhir_binary_write_string(writer, FHIR_PATIENT_BINARY_UNKNOWN_MEMBER, self->base.unknown_members[i]);
+    }
+    
+    // Writer errors are sticky; the caller's finish reports them
+    return !writer->failed;
+}
+
+// Decode one identifier message; NULL for slots written without an identifier
+static bool fhir_patient_identifier_from_binary(const FHIRBinaryReader* field, FHIRIdentifier** out) {
+    FHIRBinaryReader reader;
+    fhir_binary_reader_enter(field, &reader);
+    
+    FHIRIdentifier* identifier = fhir_calloc(1, sizeof(FHIRIdentifier));
+    if (!identifier) {
+        FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate identifier");
+        return false;
+    }
+    bool empty_slot = false;
+    while (fhir_binary_reader_next(&reader)) {
+        // Codes and systems repeat across resources, so they are interned as in from_json
+        if (reader.field == FHIR_PATIENT_BINARY_IDENTIFIER_USE && reader.wire_type == FHIR_BINARY_WIRE_STRING) {
+            identifier->use = (char*)fhir_intern(reader.string_value);
+        } else if (reader.field == FHIR_PATIENT_BINARY_IDENTIFIER_SYSTEM &&
+                   reader.wire_type == FHIR_BINARY_WIRE_STRING) {
+            identifier->system = (char*)fhir_intern(reader.string_value);
+        } else if (reader.field == FHIR_PATIENT_BINARY_IDENTIFIER_NONE) {
+            empty_slot = true;
+        }
+    }
+    if (reader.failed || empty_slot) {
+        fhir_free(identifier);
+        identifier = NULL;
+    }
+    *out = identifier;
+    return !reader.failed;
+}
+
+bool fhir_patient_from_binary(FHIRPatient* self, const FHIRBinaryDocument* document) {
+    if (!self || !document) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Invalid arguments");
+        return false;
+    }
+    
+    // Count the array messages first so each array is allocated once
+    FHIRBinaryReader reader;
+    size_t counts[FHIR_PATIENT_LAZY_FIELD_COUNT] = {0};
+    fhir_binary_reader_init(&reader, document);
+    while (fhir_binary_reader_next(&reader)) {
+        for (int field = 0; field < FHIR_PATIENT_LAZY_MANAGING_ORGANIZATION; field++) {
+            if (reader.field == g_patient_lazy_fields[field].binary_field &&
+                reader.wire_type == FHIR_BINARY_WIRE_MESSAGE) {
+                counts[field]++;
+            }
+        }
+    }
+    if (reader.failed) {
+        return false;
+    }
+    void** arrays[FHIR_PATIENT_LAZY_FIELD_COUNT] = {0};
+    for (int field = 0; field < FHIR_PATIENT_LAZY_MANAGING_ORGANIZATION; field++) {
+        if (counts[field] == 0) continue;
+        const FHIRPatientLazyFieldInfo* info = &g_patient_lazy_fields[field];
+        arrays[field] = fhir_calloc(counts[field], sizeof(void*));
+        if (!arrays[field]) {
+            FHIR_SET_ERROR(FHIR_ERROR_OUT_OF_MEMORY, "Failed to allocate Patient array");
+            return false;
+        }
+        *(void***)((char*)self + info->array_offset) = arrays[field];
+        *(size_t*)((char*)self + info->count_offset) = counts[field];
+        counts[field] = 0;
+    }
+    
+    bool ok = true;
+    fhir_binary_reader_init(&reader, document);
+    while (ok && fhir_binary_reader_next(&reader)) {
+        // Fields with an unexpected wire type are skipped like unknown fields
+        bool is_varint = reader.wire_type == FHIR_BINARY_WIRE_VARINT;
+        bool is_string = reader.wire_type == FHIR_BINARY_WIRE_STRING;
+        switch (reader.field) {
+            case FHIR_PATIENT_BINARY_ACTIVE:
+                if (is_varint && !self->active && (self->active = fhir_malloc(sizeof(FHIRBoolean)))) {
+                    self->active->value = reader.uint_value != 0;
+                }
+                break;
+            case FHIR_PATIENT_BINARY_GENDER:
+                if (is_varint && reader.uint_value <= FHIR_PATIENT_GENDER_OTHER) {
+                    self->gender = (FHIRPatientGender)reader.uint_value;
+                }
+                break;
+            case FHIR_PATIENT_BINARY_BIRTH_DATE:
+                if (is_string && !self->birth_date && (self->birth_date = fhir_calloc(1, sizeof(FHIRDate)))) {
+                    self->birth_date->value = fhir_strdup(reader.string_value);
+                    fhir_datetime_parse(self->birth_date->value, &self->birth_date->parsed);
+                }
+                break;
+            case FHIR_PATIENT_BINARY_DECEASED_BOOLEAN:
+                if (is_varint && !self->deceased_boolean &&
+                    (self->deceased_boolean = fhir_malloc(sizeof(FHIRBoolean)))) {
+                    self->deceased_boolean->value = reader.uint_value != 0;
+                }
+                break;
+            case FHIR_PATIENT_BINARY_DECEASED_DATE_TIME:
+                if (is_string && !self->deceased_date_time &&
+                    (self->deceased_date_time = fhir_calloc(1, sizeof(FHIRDateTime)))) {
+                    self->deceased_date_time->value = fhir_strdup(reader.string_value);
+                    fhir_datetime_parse(self->deceased_date_time->value, &self->deceased_date_time->parsed);
+                }
+                break;
+            case FHIR_PATIENT_BINARY_IDENTIFIER:
+                if (reader.wire_type == FHIR_BINARY_WIRE_MESSAGE) {
+                    ok = fhir_patient_identifier_from_binary(
+                        &reader, &self->identifier[counts[FHIR_PATIENT_LAZY_IDENTIFIER]++]);
+                }
+                break;
+            case FHIR_PATIENT_BINARY_NAME:
+            case FHIR_PATIENT_BINARY_TELECOM:
+            case FHIR_PATIENT_BINARY_ADDRESS:
+                if (reader.wire_type == FHIR_BINARY_WIRE_MESSAGE) {
+                    int field = FHIR_PATIENT_LAZY_NAME + (int)(reader.field - FHIR_PATIENT_BINARY_NAME);
+                    ok = fhir_patient_struct_from_binary(g_patient_lazy_fields[field].spec, &reader,
+                                                         &arrays[field][counts[field]++]);
+                }
+                break;
+            case FHIR_PATIENT_BINARY_MANAGING_ORGANIZATION:
+                if (reader.wire_type == FHIR_BINARY_WIRE_MESSAGE && !self->managing_organization) {
+                    ok = fhir_patient_struct_from_binary(&g_reference_spec, &reader,
+                                                         (void**)&self->managing_organization);
+                }
+                break;
+            case FHIR_PATIENT_BINARY_UNKNOWN_MEMBER:
+                if (is_string) {
+                    ok = fhir_resource_add_unknown_member(&self->base, reader.string_value);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    return ok && !reader.failed;
+}
+
 FHIRPatient* fhir_patient_parse(const char* json_string) {
     if (!json_string) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "JSON string is NULL");
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -394,83 +1376,113 @@ FHIRPatient* fhir_patient_parse(const char* json_string) {
         return NULL;
     }
     
+    FHIRPerfSpan span;
+    fhir_perf_begin(&span, FHIR_PERF_PHASE_DESERIALIZE, FHIR_RESOURCE_TYPE_PATIENT);
+    int previous_type = fhir_memory_set_type(FHIR_RESOURCE_TYPE_PATIENT);
     FHIRPatient* patient = fhir_patient_create(id);
-    if (!patient) {
-        cJSON_Delete(json);
-        return NULL;
-    }
-    
-    if (!fhir_patient_from_json(patient, json)) {
+    if (patient && !fhir_patient_from_json(patient, json)) {
         fhir_patient_destroy(patient);
-        cJSON_Delete(json);
-        return NULL;
+        patient = NULL;
     }
+    fhir_memory_set_type(previous_type);
+    fhir_perf_end(&span, 0, patient != NULL);
     
     cJSON_Delete(json);
     return patient;
-}/* =========
-================================================================= */
-/* Patient Validation Methods                                                */
-/* ========================================================================== */
+}
 
-bool fhir_patient_validate(const FHIRPatient* self) {
-    if (!self) return false;
-    
-    // Use cached validation if available
-    if (self->base.validation_cached) {
-        return self->base.validation_result;
+FHIRPatient* fhir_patient_parse_with_arena(FHIRArena* arena, const char* json_string) {
+    if (!arena) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "Arena is NULL");
+        return NULL;
     }
     
-    char** errors = NULL;
-    size_t error_count = 0;
-    bool is_valid = fhir_patient_validate_internal(self, &errors, &error_count);
+    // The cJSON tree uses its own allocator and is freed before returning
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    FHIRPatient* patient = fhir_patient_parse(json_string);
+    fhir_arena_set_current(previous);
     
-    // Cache validation result
-    FHIRPatient* mutable_self = (FHIRPatient*)self; // Cast away const for caching
-    mutable_self->base.validation_cached = true;
-    mutable_self->base.validation_result = is_valid;
-    mutable_self->base.validation_errors = errors;
-    mutable_self->base.validation_error_count = error_count;
-    
-    return is_valid;
+    return patient;
 }
 
-static bool fhir_patient_validate_internal(const FHIRPatient* self, char*** errors, size_t* error_count) {
-    if (!self || !errors || !error_count) return false;
-    
-    *errors = NULL;
-    *error_count = 0;
-    bool is_valid = true;
+FHIRPatient* fhir_patient_parse_lazy(const char* json_string) {
+    // The tree would outlive an arena reset, so arena parses stay eager
+    if (fhir_arena_get_current()) {
+        return fhir_patient_parse(json_string);
+    }
+    if (!json_string) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_ARGUMENT, "JSON string is NULL");
+        return NULL;
+    }
     
-    // Validate base resource
-    if (!fhir_validate_base_resource("Patient", self->base.id)) {
-        is_valid = false;
-        // Add base validation errors
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
+    if (!json) {
+        FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
+        return NULL;
     }
     
-    // Validate birth date format if present
-    if (self->birth_date && self->birth_date->value) {
-        if (!fhir_validate_date(self->birth_date->value)) {
-            is_valid = false;
-            // Add error to list
-        }
+    const char* id = fhir_json_get_string(json, "id");
+    if (!id) {
+        cJSON_Delete(json);
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "id");
+        return NULL;
     }
     
-    // Validate that deceased choice type has only one value
-    if (self->deceased_boolean && self->deceased_date_time) {
-        is_valid = false;
-        // Add error: "Patient can have either deceasedBoolean or deceasedDateTime, not both"
+    FHIRPatient* patient = fhir_patient_create(id);
+    if (!patient) {
+        cJSON_Delete(json);
+        return NULL;
     }
     
-    // Validate that multiple birth choice type has only one value
-    if (self->multiple_birth_boolean && self->multiple_birth_integer) {
-        is_valid = false;
-        // Add error: "Patient can have either multipleBirthBoolean or multipleBirthInteger, not both"
+    // The Patient owns the tree from here on
+    patient->lazy_json = json;
+    if (!fhir_patient_load(patient, json, true)) {
+        fhir_patient_destroy(patient);
+        return NULL;
     }
     
-    // Additional FHIR-specific validations would go here
+    return patient;
+}
+
+/* ========================================================================== */
+/* Patient Validation Methods                                                */
+/* ========================================================================== */
+
+static bool patient_rule_id(const FHIRResourceBase* base) {
+    return fhir_validate_base_resource("Patient", base->id);
+}
+
+static bool patient_rule_birth_date(const FHIRResourceBase* base) {
+    const FHIRPatient* self = (const FHIRPatient*)base;
+    return !self->birth_date || !self->birth_date->value || fhir_validate_date(self->birth_date->value);
+}
+
+static bool patient_rule_deceased(const FHIRResourceBase* base) {
+    const FHIRPatient* self = (const FHIRPatient*)base;
+    return !(self->deceased_boolean && self->deceased_date_time);
+}
+
+static bool patient_rule_multiple_birth(const FHIRResourceBase* base) {
+    const FHIRPatient* self = (const FHIRPatient*)base;
+    return !(self->multiple_birth_boolean && self->multiple_birth_integer);
+}
+
+// Each rule names the fields it reads, so a setter reruns only the rules it affects
+static const FHIRValidationRule g_patient_rules[] = {
+    { FHIR_PATIENT_DIRTY_ID, patient_rule_id, "Patient id is missing or invalid" },
+    { FHIR_PATIENT_DIRTY_BIRTH_DATE, patient_rule_birth_date, "birthDate is not a valid date" },
+    { FHIR_PATIENT_DIRTY_DECEASED, patient_rule_deceased,
+      "Patient can have either deceasedBoolean or deceasedDateTime, not both" },
+    { FHIR_PATIENT_DIRTY_MULTIPLE_BIRTH, patient_rule_multiple_birth,
+      "Patient can have either multipleBirthBoolean or multipleBirthInteger, not both" },
+};
+
+bool fhir_patient_validate(const FHIRPatient* self) {
+    if (!self) return false;
     
-    return is_valid;
+    // Cached, and safe if other threads validate the same Patient
+    return fhir_resource_validate_rules(&self->base, g_patient_rules,
+                                        sizeof(g_patient_rules) / sizeof(g_patient_rules[0]));
 }
 
 char** fhir_patient_get_validation_errors(const FHIRPatient* self, size_t* count) {
@@ -494,6 +1506,17 @@ bool fhir_patient_equals(const FHIRPatient* self, const FHIRPatient* other) {
     if (self == other) return true;
     if (!self || !other) return false;
     
+    // Equal Patients hash alike, so differing cached hashes settle it
+    uint64_t self_hash, other_hash;
+    if (fhir_resource_get_cached_hash(&self->base, &self_hash) &&
+        fhir_resource_get_cached_hash(&other->base, &other_hash) && self_hash != other_hash) {
+        return false;
+    }
+    if (!fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_IDENTIFIER) ||
+        !fhir_patient_materialize_field(other, FHIR_PATIENT_LAZY_IDENTIFIER)) {
+        return false;
+    }
+    
     // Compare IDs
     if (fhir_strcmp(self->base.id, other->base.id) != 0) return false;
     
@@ -510,6 +1533,19 @@ bool fhir_patient_equals(const FHIRPatient* self, const FHIRPatient* other) {
         if (fhir_strcmp(self->birth_date->value, other->birth_date->value) != 0) return false;
     }
     
+    // Compare identifiers (interned use/system values match by pointer)
+    if (self->identifier_count != other->identifier_count) return false;
+    for (size_t i = 0; i < self->identifier_count; i++) {
+        const FHIRIdentifier* a = self->identifier[i];
+        const FHIRIdentifier* b = other->identifier[i];
+        if (a == b) continue;
+        if (!a || !b) return false;
+        if (!fhir_intern_equals(a->system, b->system) || !fhir_intern_equals(a->use, b->use) ||
+            !fhir_intern_equals(a->value, b->value)) {
+            return false;
+        }
+    }
+    
     // Additional field comparisons would go here
     
     return true;
@@ -535,6 +1571,58 @@ int fhir_patient_compare(const FHIRPatient* self, const FHIRPatient* other) {
     return 0;
 }
 
+uint64_t fhir_patient_hash(const FHIRPatient* self) {
+    if (!self) return 0;
+    
+    // Same fields and order as fhir_patient_equals; keep the two in step
+    FHIRHasher hasher;
+    fhir_hasher_init(&hasher, FHIR_RESOURCE_TYPE_PATIENT);
+    fhir_hasher_string(&hasher, self->base.id);
+    fhir_hasher_u64(&hasher, self->active ? 1u + self->active->value : 0u);
+    fhir_hasher_u64(&hasher, (uint64_t)self->gender);
+    fhir_hasher_string(&hasher, self->birth_date ? self->birth_date->value : NULL);
+    
+    // An identifier that cannot be materialized hashes as absent, as equals then fails anyway
+    bool identifiers = fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_IDENTIFIER);
+    size_t count = identifiers ? self->identifier_count : 0;
+    fhir_hasher_u64(&hasher, count);
+    for (size_t i = 0; i < count; i++) {
+        const FHIRIdentifier* identifier = self->identifier[i];
+        fhir_hasher_string(&hasher, identifier ? identifier->system : NULL);
+        fhir_hasher_string(&hasher, identifier ? identifier->use : NULL);
+        fhir_hasher_string(&hasher, identifier ? identifier->value : NULL);
+    }
+    return fhir_hasher_digest(&hasher);
+}
+
+uint32_t fhir_patient_member_dirty_fields(const char* member) {
+    static const struct {
+        const char* name;
+        uint32_t fields;
+    } members[] = {
+        {"id", FHIR_PATIENT_DIRTY_ID},
+        {"active", FHIR_PATIENT_DIRTY_ACTIVE},
+        {"gender", FHIR_PATIENT_DIRTY_GENDER},
+        {"birthDate", FHIR_PATIENT_DIRTY_BIRTH_DATE},
+        {"deceasedBoolean", FHIR_PATIENT_DIRTY_DECEASED},
+        {"deceasedDateTime", FHIR_PATIENT_DIRTY_DECEASED},
+        {"multipleBirthBoolean", FHIR_PATIENT_DIRTY_MULTIPLE_BIRTH},
+        {"multipleBirthInteger", FHIR_PATIENT_DIRTY_MULTIPLE_BIRTH},
+        {"identifier", FHIR_PATIENT_DIRTY_IDENTIFIER},
+        {"name", FHIR_PATIENT_DIRTY_NAME},
+        {"telecom", FHIR_PATIENT_DIRTY_TELECOM},
+        {"address", FHIR_PATIENT_DIRTY_ADDRESS}
+    };
+    if (!member) return FHIR_DIRTY_ALL;
+    
+    for (size_t i = 0; i < sizeof(members) / sizeof(members[0]); i++) {
+        if (strcmp(members[i].name, member) == 0) {
+            return members[i].fields;
+        }
+    }
+    return 0;
+}
+
 /* ========================================================================== */
 /* Patient String Representation                                             */
 /* ========================================================================== */
@@ -596,27 +1684,83 @@ bool fhir_patient_is_deceased(const FHIRPatient* self) {
 }
 
 int fhir_patient_get_age(const FHIRPatient* self) {
+    return fhir_patient_get_age_at(self, (int64_t)time(NULL) * 1000000);
+}
+
+int fhir_patient_get_age_at(const FHIRPatient* self, int64_t now_us) {
     if (!self || !self->birth_date || !self->birth_date->value) return -1;
     
-    // Parse birth date and calculate age (simplified implementation)
-    // In full implementation, would properly parse date and calculate age
-    return -1; // Placeholder
+    const FHIRDateTimeValue* birth = &self->birth_date->parsed;
+    if (birth->precision == FHIR_DATETIME_PRECISION_NONE) return -1;
+    
+    // A deceased Patient stops aging at the date of death
+    if (self->deceased_date_time &&
+        self->deceased_date_time->parsed.precision != FHIR_DATETIME_PRECISION_NONE &&
+        self->deceased_date_time->parsed.epoch_us < now_us) {
+        now_us = self->deceased_date_time->parsed.epoch_us;
+    }
+    if (now_us < birth->epoch_us) return -1;
+    
+    // Partial birth dates count from their first day
+    int birth_year, birth_month, birth_day, year, month, day;
+    fhir_datetime_to_civil(birth->epoch_us, &birth_year, &birth_month, &birth_day);
+    fhir_datetime_to_civil(now_us, &year, &month, &day);
+    
+    int age = year - birth_year;
+    if (month < birth_month || (month == birth_month && day < birth_day)) age--;
+    return age;
 }
 
 const FHIRHumanName* fhir_patient_get_primary_name(const FHIRPatient* self) {
-    if (!self || !self->name || self->name_count == 0) return NULL;
+    if (!self || !fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_NAME)) return NULL;
+    if (!self->name || self->name_count == 0) return NULL;
     
     // Return first name (simplified)
     return self->name[0];
 }
 
 const FHIRAddress* fhir_patient_get_primary_address(const FHIRPatient* self) {
-    if (!self || !self->address || self->address_count == 0) return NULL;
+    if (!self || !fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_ADDRESS)) return NULL;
+    if (!self->address || self->address_count == 0) return NULL;
     
     // Return first address (simplified)
     return self->address[0];
-}/* =
-========================================================================= */
+}
+
+// Materialize a lazy array field and return it; NULL with a zero count if empty
+static void* const* fhir_patient_get_field(const FHIRPatient* self, FHIRPatientLazyField field,
+                                           size_t* count) {
+    size_t element_count = 0;
+    void* const* elements = NULL;
+    if (self && fhir_patient_materialize_field(self, field)) {
+        elements = fhir_patient_field_elements(self, field, &element_count);
+    }
+    if (count) *count = element_count;
+    return element_count > 0 ? elements : NULL;
+}
+
+FHIRIdentifier* const* fhir_patient_get_identifiers(const FHIRPatient* self, size_t* count) {
+    return (FHIRIdentifier* const*)fhir_patient_get_field(self, FHIR_PATIENT_LAZY_IDENTIFIER, count);
+}
+
+FHIRHumanName* const* fhir_patient_get_names(const FHIRPatient* self, size_t* count) {
+    return (FHIRHumanName* const*)fhir_patient_get_field(self, FHIR_PATIENT_LAZY_NAME, count);
+}
+
+FHIRContactPoint* const* fhir_patient_get_telecoms(const FHIRPatient* self, size_t* count) {
+    return (FHIRContactPoint* const*)fhir_patient_get_field(self, FHIR_PATIENT_LAZY_TELECOM, count);
+}
+
+FHIRAddress* const* fhir_patient_get_addresses(const FHIRPatient* self, size_t* count) {
+    return (FHIRAddress* const*)fhir_patient_get_field(self, FHIR_PATIENT_LAZY_ADDRESS, count);
+}
+
+const FHIRReference* fhir_patient_get_managing_organization(const FHIRPatient* self) {
+    if (!self || !fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_MANAGING_ORGANIZATION)) return NULL;
+    return self->managing_organization;
+}
+
+/* ========================================================================== */
 /* Patient Modification Methods                                              */
 /* ========================================================================== */
 
@@ -633,8 +1777,8 @@ bool fhir_patient_set_active(FHIRPatient* self, bool active) {
     
     self->active->value = active;
     
-    // Clear validation cache
-    self->base.validation_cached = false;
+    // Rerun only the validation rules that read this field
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_ACTIVE);
     
     return true;
 }
@@ -652,8 +1796,8 @@ bool fhir_patient_set_gender(FHIRPatient* self, FHIRPatientGender gender) {
     
     self->gender = gender;
     
-    // Clear validation cache
-    self->base.validation_cached = false;
+    // Rerun only the validation rules that read this field
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_GENDER);
     
     return true;
 }
@@ -666,18 +1810,23 @@ bool fhir_patient_set_birth_date(FHIRPatient* self, const char* birth_date) {
     
     if (!birth_date) {
         // Clear birth date
-        fhir_free(self->birth_date);
-        self->birth_date = NULL;
+        if (self->birth_date) {
+            fhir_free(self->birth_date->value);
+            fhir_free(self->birth_date);
+            self->birth_date = NULL;
+        }
+        fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_BIRTH_DATE);
         return true;
     }
     
-    if (!fhir_validate_date(birth_date)) {
+    FHIRDateTimeValue parsed;
+    if (!fhir_datetime_parse(birth_date, &parsed) || parsed.precision > FHIR_DATETIME_PRECISION_DAY) {
         FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Invalid date format", "birthDate");
         return false;
     }
     
     if (!self->birth_date) {
-        self->birth_date = fhir_malloc(sizeof(FHIRDate));
+        self->birth_date = fhir_calloc(1, sizeof(FHIRDate));
         if (!self->birth_date) return false;
     } else {
         fhir_free(self->birth_date->value);
@@ -689,9 +1838,10 @@ bool fhir_patient_set_birth_date(FHIRPatient* self, const char* birth_date) {
         self->birth_date = NULL;
         return false;
     }
+    self->birth_date->parsed = parsed;
     
-    // Clear validation cache
-    self->base.validation_cached = false;
+    // Rerun only the validation rules that read this field
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_BIRTH_DATE);
     
     return true;
 }
@@ -702,8 +1852,14 @@ bool fhir_patient_add_identifier(FHIRPatient* self, const FHIRIdentifier* identi
         return false;
     }
     
-    return fhir_array_add((void**)&self->identifier, &self->identifier_count, 
-                         identifier, sizeof(FHIRIdentifier*));
+    if (!fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_IDENTIFIER) ||
+        !fhir_resource_detach_field(&self->base, &g_patient_shared_fields[FHIR_PATIENT_SHARED_IDENTIFIER])) {
+        return false;
+    }
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_IDENTIFIER);
+    
+    return fhir_patient_append_copy((void***)&self->identifier, &self->identifier_count,
+                                    identifier, sizeof(FHIRIdentifier));
 }
 
 bool fhir_patient_add_name(FHIRPatient* self, const FHIRHumanName* name) {
@@ -712,8 +1868,13 @@ bool fhir_patient_add_name(FHIRPatient* self, const FHIRHumanName* name) {
         return false;
     }
     
-    return fhir_array_add((void**)&self->name, &self->name_count, 
-                         name, sizeof(FHIRHumanName*));
+    if (!fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_NAME) ||
+        !fhir_resource_detach_field(&self->base, &g_patient_shared_fields[FHIR_PATIENT_SHARED_NAME])) {
+        return false;
+    }
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_NAME);
+    
+    return fhir_patient_append_struct((void***)&self->name, &self->name_count, &g_human_name_spec, name);
 }
 
 bool fhir_patient_add_address(FHIRPatient* self, const FHIRAddress* address) {
@@ -722,8 +1883,13 @@ bool fhir_patient_add_address(FHIRPatient* self, const FHIRAddress* address) {
         return false;
     }
     
-    return fhir_array_add((void**)&self->address, &self->address_count, 
-                         address, sizeof(FHIRAddress*));
+    if (!fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_ADDRESS) ||
+        !fhir_resource_detach_field(&self->base, &g_patient_shared_fields[FHIR_PATIENT_SHARED_ADDRESS])) {
+        return false;
+    }
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_ADDRESS);
+    
+    return fhir_patient_append_struct((void***)&self->address, &self->address_count, &g_address_spec, address);
 }
 
 bool fhir_patient_add_telecom(FHIRPatient* self, const FHIRContactPoint* telecom) {
@@ -732,8 +1898,13 @@ bool fhir_patient_add_telecom(FHIRPatient* self, const FHIRContactPoint* telecom
         return false;
     }
     
-    return fhir_array_add((void**)&self->telecom, &self->telecom_count, 
-                         telecom, sizeof(FHIRContactPoint*));
+    if (!fhir_patient_materialize_field(self, FHIR_PATIENT_LAZY_TELECOM) ||
+        !fhir_resource_detach_field(&self->base, &g_patient_shared_fields[FHIR_PATIENT_SHARED_TELECOM])) {
+        return false;
+    }
+    fhir_resource_mark_dirty(&self->base, FHIR_PATIENT_DIRTY_TELECOM);
+    
+    return fhir_patient_append_struct((void***)&self->telecom, &self->telecom_count, &g_contact_point_spec, telecom);
 }
 
 /* ========================================================================== */
@@ -82,6 +82,53 @@ typedef struct FHIRPatientLink {
     FHIRPatientLinkType type;
 } FHIRPatientLink;
 
+/**
+ * @brief Patient array fields that copy-on-write clones share
+ */
+typedef enum {
+    FHIR_PATIENT_SHARED_IDENTIFIER = 0,
+    FHIR_PATIENT_SHARED_NAME,
+    FHIR_PATIENT_SHARED_TELECOM,
+    FHIR_PATIENT_SHARED_ADDRESS,
+    FHIR_PATIENT_SHARED_PHOTO,
+    FHIR_PATIENT_SHARED_CONTACT,
+    FHIR_PATIENT_SHARED_COMMUNICATION,
+    FHIR_PATIENT_SHARED_GENERAL_PRACTITIONER,
+    FHIR_PATIENT_SHARED_LINK,
+    FHIR_PATIENT_SHARED_FIELD_COUNT
+} FHIRPatientSharedField;
+
+/**
+ * @brief Patient sub-structures that a lazily parsed Patient materializes on first access
+ */
+typedef enum {
+    FHIR_PATIENT_LAZY_IDENTIFIER = 0,
+    FHIR_PATIENT_LAZY_NAME,
+    FHIR_PATIENT_LAZY_TELECOM,
+    FHIR_PATIENT_LAZY_ADDRESS,
+    FHIR_PATIENT_LAZY_MANAGING_ORGANIZATION,
+    FHIR_PATIENT_LAZY_FIELD_COUNT
+} FHIRPatientLazyField;
+
+/**
+ * @brief Dirty bits of the Patient fields, for incremental validation
+ *
+ * Setters mark the fields they change; code that writes a field directly
+ * marks it with fhir_resource_mark_dirty so the rules reading it rerun.
+ */
+typedef enum {
+    FHIR_PATIENT_DIRTY_ID = 1u << 0,
+    FHIR_PATIENT_DIRTY_ACTIVE = 1u << 1,
+    FHIR_PATIENT_DIRTY_GENDER = 1u << 2,
+    FHIR_PATIENT_DIRTY_BIRTH_DATE = 1u << 3,
+    FHIR_PATIENT_DIRTY_DECEASED = 1u << 4,
+    FHIR_PATIENT_DIRTY_MULTIPLE_BIRTH = 1u << 5,
+    FHIR_PATIENT_DIRTY_IDENTIFIER = 1u << 6,
+    FHIR_PATIENT_DIRTY_NAME = 1u << 7,
+    FHIR_PATIENT_DIRTY_TELECOM = 1u << 8,
+    FHIR_PATIENT_DIRTY_ADDRESS = 1u << 9
+} FHIRPatientDirtyField;
+
 /* ========================================================================== */
 /* Patient Resource Structure                                                */
 /* ========================================================================== */
@@ -138,6 +185,14 @@ FHIR_RESOURCE_DEFINE(Patient)
     
     FHIRPatientLink** link;
     size_t link_count;
+    
+    // Copy-on-write state: arrays shared with clones (NULL = privately owned)
+    FHIRSharedArray* shared[FHIR_PATIENT_SHARED_FIELD_COUNT];
+    
+    // Lazy parse state: the source tree, and per FHIRPatientLazyField its member and materialization state
+    cJSON* lazy_json;
+    const cJSON* lazy_members[FHIR_PATIENT_LAZY_FIELD_COUNT];
+    FHIRAtomicInt lazy_state[FHIR_PATIENT_LAZY_FIELD_COUNT];
 };
 
 /* ========================================================================== */
@@ -162,8 +217,22 @@ void fhir_patient_destroy(FHIRPatient* self);
  * @param self Patient to clone
  * @return Cloned Patient or NULL on failure
  */
-FHIRPatient* fhir_patient_clone(const FHIRPatient* self);/* =====
-===================================================================== */
+FHIRPatient* fhir_patient_clone(const FHIRPatient* self);
+
+/**
+ * @brief Clone Patient resource, sharing its arrays copy-on-write
+ *
+ * Identifiers, names, extensions and the other arrays are shared with the
+ * source through reference counts; a clone gets its own copy of an array
+ * only when a modifier such as fhir_patient_add_name touches it. Scalar
+ * fields are copied. Arena-owned patients are deep-copied instead.
+ *
+ * @param self Patient to clone
+ * @return Cloned Patient or NULL on failure
+ */
+FHIRPatient* fhir_patient_clone_cow(const FHIRPatient* self);
+
+/* ========================================================================== */
 /* Patient Serialization Methods                                             */
 /* ========================================================================== */
 
@@ -174,6 +243,38 @@ FHIRPatient* fhir_patient_clone(const FHIRPatient* self);/* =====
  */
 cJSON* fhir_patient_to_json(const FHIRPatient* self);
 
+/**
+ * @brief Stream Patient as compact JSON (virtual method)
+ *
+ * Produces the same document as fhir_patient_to_json without building a
+ * cJSON tree.
+ *
+ * @param self Patient to serialize
+ * @param writer Destination writer
+ * @return true on success, false on failure
+ */
+bool fhir_patient_write_json(const FHIRPatient* self, FHIRWriter* writer);
+
+/**
+ * @brief Encode Patient fields in the compact binary format (virtual method)
+ *
+ * Covers the fields fhir_patient_from_json loads, plus the names of
+ * unrecognized JSON members.
+ *
+ * @param self Patient to encode
+ * @param writer Destination binary writer
+ * @return true on success, false on failure
+ */
+bool fhir_patient_to_binary(const FHIRPatient* self, FHIRBinaryWriter* writer);
+
+/**
+ * @brief Load Patient from a binary document (virtual method)
+ * @param self Patient to populate (created with the document's id)
+ * @param document Document written by fhir_patient_to_binary
+ * @return true on success, false on failure
+ */
+bool fhir_patient_from_binary(FHIRPatient* self, const FHIRBinaryDocument* document);
+
 /**
  * @brief Load Patient from JSON (virtual method)
  * @param self Patient to populate
@@ -189,12 +290,53 @@ bool fhir_patient_from_json(FHIRPatient* self, const cJSON* json);
  */
 FHIRPatient* fhir_patient_parse(const char* json_string);
 
+/**
+ * @brief Parse Patient from JSON string with all allocations in an arena
+ * @param arena Arena that owns the Patient (freed by fhir_arena_reset/destroy)
+ * @param json_string JSON string
+ * @return New Patient or NULL on failure
+ */
+FHIRPatient* fhir_patient_parse_with_arena(FHIRArena* arena, const char* json_string);
+
+/**
+ * @brief Parse Patient from JSON string, deferring its sub-structures
+ * 
+ * Scalars (active, gender, birthDate, deceased[x]) are read now. The Patient
+ * keeps the parsed cJSON tree, and identifier, name, telecom, address and
+ * managingOrganization are built from it on first access through their
+ * getters (fhir_patient_get_names, fhir_patient_get_primary_name, ...) or
+ * fhir_patient_materialize. Until then those struct members are unset, so
+ * read them through the getters. Serialization, cloning, comparison and the
+ * add functions materialize what they need.
+ * 
+ * With an arena current this parses eagerly, as the tree lives outside the arena.
+ * 
+ * @param json_string JSON string
+ * @return New Patient or NULL on failure
+ */
+FHIRPatient* fhir_patient_parse_lazy(const char* json_string);
+
+/**
+ * @brief Build every deferred sub-structure of a lazily parsed Patient
+ * 
+ * Like the validation cache, this is logically const and safe to call from
+ * several threads at once. A no-op for eagerly parsed Patients.
+ * 
+ * @param self Patient to materialize
+ * @return true on success, false on allocation failure
+ */
+bool fhir_patient_materialize(const FHIRPatient* self);
+
 /* ========================================================================== */
 /* Patient Validation Methods                                                */
 /* ========================================================================== */
 
 /**
  * @brief Validate Patient resource (virtual method)
+ *
+ * The result is cached; after a setter only the rules reading the changed
+ * fields are rerun.
+ *
  * @param self Patient to validate
  * @return true if valid, false otherwise
  */
@@ -228,6 +370,28 @@ bool fhir_patient_equals(const FHIRPatient* self, const FHIRPatient* other);
  */
 int fhir_patient_compare(const FHIRPatient* self, const FHIRPatient* other);
 
+/**
+ * @brief Structural hash of a Patient (virtual method)
+ *
+ * Covers exactly the fields fhir_patient_equals compares, in a fixed order,
+ * so equal Patients hash alike. Use fhir_resource_hash for the cached value.
+ *
+ * @param self Patient to hash
+ * @return 64-bit hash
+ */
+uint64_t fhir_patient_hash(const FHIRPatient* self);
+
+/**
+ * @brief Dirty bits of the Patient fields a top-level JSON member loads
+ *
+ * Lets a JSON-level edit (e.g. a patch) mark only the validation rules that
+ * read the changed members. Members no rule reads map to 0.
+ *
+ * @param member JSON member name
+ * @return FHIRPatientDirtyField bits
+ */
+uint32_t fhir_patient_member_dirty_fields(const char* member);
+
 /* ========================================================================== */
 /* Patient String Representation                                             */
 /* ========================================================================== */
@@ -271,6 +435,18 @@ bool fhir_patient_is_deceased(const FHIRPatient* self);
  */
 int fhir_patient_get_age(const FHIRPatient* self);
 
+/**
+ * @brief Get Patient age in whole years at a given time
+ *
+ * Uses the pre-parsed birth date; a partial birth date counts from its first
+ * day, and a deceased Patient's age stops at the date of death.
+ *
+ * @param self Patient to calculate age for
+ * @param now_us Reference time in epoch microseconds
+ * @return Age in years or -1 if birth date not available or after now_us
+ */
+int fhir_patient_get_age_at(const FHIRPatient* self, int64_t now_us);
+
 /**
  * @brief Get Patient's primary name
  * @param self Patient to get name from
@@ -285,6 +461,45 @@ const FHIRHumanName* fhir_patient_get_primary_name(const FHIRPatient* self);
  */
 const FHIRAddress* fhir_patient_get_primary_address(const FHIRPatient* self);
 
+/**
+ * @brief Get Patient identifiers (materialized on first access)
+ * @param self Patient to query
+ * @param count Output number of identifiers (slots can be NULL)
+ * @return Identifier array or NULL if there are none
+ */
+FHIRIdentifier* const* fhir_patient_get_identifiers(const FHIRPatient* self, size_t* count);
+
+/**
+ * @brief Get Patient names (materialized on first access)
+ * @param self Patient to query
+ * @param count Output number of names
+ * @return Name array or NULL if there are none
+ */
+FHIRHumanName* const* fhir_patient_get_names(const FHIRPatient* self, size_t* count);
+
+/**
+ * @brief Get Patient contact points (materialized on first access)
+ * @param self Patient to query
+ * @param count Output number of contact points
+ * @return Contact point array or NULL if there are none
+ */
+FHIRContactPoint* const* fhir_patient_get_telecoms(const FHIRPatient* self, size_t* count);
+
+/**
+ * @brief Get Patient addresses (materialized on first access)
+ * @param self Patient to query
+ * @param count Output number of addresses
+ * @return Address array or NULL if there are none
+ */
+FHIRAddress* const* fhir_patient_get_addresses(const FHIRPatient* self, size_t* count);
+
+/**
+ * @brief Get Patient's managing organization (materialized on first access)
+ * @param self Patient to query
+ * @return Reference or NULL
+ */
+const FHIRReference* fhir_patient_get_managing_organization(const FHIRPatient* self);
+
 /* ========================================================================== */
 /* Patient Modification Methods                                              */
 /* ========================================================================== */
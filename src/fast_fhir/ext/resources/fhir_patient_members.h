@@ -0,0 +1,208 @@
+/**
+ * @file fhir_patient_members.h
+ * @brief Single-pass JSON member dispatch for the FHIR R5 Patient resource
+ * @version 0.1.0
+ * @date 2024-01-01
+ * 
+ * Generated by scripts/generate_resources.py --members; do not edit.
+ * 
+ * from_json walks the object's members once and maps each key to a slot,
+ * instead of one case-insensitive cJSON_GetObjectItem scan per field.
+ */
+
+#ifndef FHIR_PATIENT_MEMBERS_H
+#define FHIR_PATIENT_MEMBERS_H
+
+#include "../common/fhir_resource_base.h"
+#include <stdbool.h>
+#include <string.h>
+#include <cjson/cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Patient JSON members
+ */
+typedef enum {
+    FHIR_PATIENT_MEMBER_RESOURCE_TYPE,
+    FHIR_PATIENT_MEMBER_ID,
+    FHIR_PATIENT_MEMBER_META,
+    FHIR_PATIENT_MEMBER_IMPLICIT_RULES,
+    FHIR_PATIENT_MEMBER_LANGUAGE,
+    FHIR_PATIENT_MEMBER_TEXT,
+    FHIR_PATIENT_MEMBER_CONTAINED,
+    FHIR_PATIENT_MEMBER_EXTENSION,
+    FHIR_PATIENT_MEMBER_MODIFIER_EXTENSION,
+    FHIR_PATIENT_MEMBER_IDENTIFIER,
+    FHIR_PATIENT_MEMBER_ACTIVE,
+    FHIR_PATIENT_MEMBER_NAME,
+    FHIR_PATIENT_MEMBER_TELECOM,
+    FHIR_PATIENT_MEMBER_GENDER,
+    FHIR_PATIENT_MEMBER_BIRTH_DATE,
+    FHIR_PATIENT_MEMBER_DECEASED_BOOLEAN,
+    FHIR_PATIENT_MEMBER_DECEASED_DATE_TIME,
+    FHIR_PATIENT_MEMBER_ADDRESS,
+    FHIR_PATIENT_MEMBER_MARITAL_STATUS,
+    FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_BOOLEAN,
+    FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_INTEGER,
+    FHIR_PATIENT_MEMBER_PHOTO,
+    FHIR_PATIENT_MEMBER_CONTACT,
+    FHIR_PATIENT_MEMBER_COMMUNICATION,
+    FHIR_PATIENT_MEMBER_GENERAL_PRACTITIONER,
+    FHIR_PATIENT_MEMBER_MANAGING_ORGANIZATION,
+    FHIR_PATIENT_MEMBER_LINK,
+    FHIR_PATIENT_MEMBER_COUNT,
+    FHIR_PATIENT_MEMBER_UNKNOWN = FHIR_PATIENT_MEMBER_COUNT
+} FHIRPatientMember;
+
+/**
+ * @brief Map a JSON member name to its FHIRPatientMember (case-sensitive)
+ * @param key Member name
+ * @return Member or FHIR_PATIENT_MEMBER_UNKNOWN
+ */
+static inline FHIRPatientMember fhir_patient_member_lookup(const char* key) {
+    switch (strlen(key)) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_PATIENT_MEMBER_ID;
+            break;
+        case 4:
+            switch (key[0]) {
+                case 'l':
+                    if (memcmp(key, "link", 4) == 0) return FHIR_PATIENT_MEMBER_LINK;
+                    break;
+                case 'm':
+                    if (memcmp(key, "meta", 4) == 0) return FHIR_PATIENT_MEMBER_META;
+                    break;
+                case 'n':
+                    if (memcmp(key, "name", 4) == 0) return FHIR_PATIENT_MEMBER_NAME;
+                    break;
+                case 't':
+                    if (memcmp(key, "text", 4) == 0) return FHIR_PATIENT_MEMBER_TEXT;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(key, "photo", 5) == 0) return FHIR_PATIENT_MEMBER_PHOTO;
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "active", 6) == 0) return FHIR_PATIENT_MEMBER_ACTIVE;
+                    break;
+                case 'g':
+                    if (memcmp(key, "gender", 6) == 0) return FHIR_PATIENT_MEMBER_GENDER;
+                    break;
+            }
+            break;
+        case 7:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "address", 7) == 0) return FHIR_PATIENT_MEMBER_ADDRESS;
+                    break;
+                case 'c':
+                    if (memcmp(key, "contact", 7) == 0) return FHIR_PATIENT_MEMBER_CONTACT;
+                    break;
+                case 't':
+                    if (memcmp(key, "telecom", 7) == 0) return FHIR_PATIENT_MEMBER_TELECOM;
+                    break;
+            }
+            break;
+        case 8:
+            if (memcmp(key, "language", 8) == 0) return FHIR_PATIENT_MEMBER_LANGUAGE;
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'b':
+                    if (memcmp(key, "birthDate", 9) == 0) return FHIR_PATIENT_MEMBER_BIRTH_DATE;
+                    break;
+                case 'c':
+                    if (memcmp(key, "contained", 9) == 0) return FHIR_PATIENT_MEMBER_CONTAINED;
+                    break;
+                case 'e':
+                    if (memcmp(key, "extension", 9) == 0) return FHIR_PATIENT_MEMBER_EXTENSION;
+                    break;
+            }
+            break;
+        case 10:
+            if (memcmp(key, "identifier", 10) == 0) return FHIR_PATIENT_MEMBER_IDENTIFIER;
+            break;
+        case 12:
+            if (memcmp(key, "resourceType", 12) == 0) return FHIR_PATIENT_MEMBER_RESOURCE_TYPE;
+            break;
+        case 13:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "communication", 13) == 0) return FHIR_PATIENT_MEMBER_COMMUNICATION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "implicitRules", 13) == 0) return FHIR_PATIENT_MEMBER_IMPLICIT_RULES;
+                    break;
+                case 'm':
+                    if (memcmp(key, "maritalStatus", 13) == 0) return FHIR_PATIENT_MEMBER_MARITAL_STATUS;
+                    break;
+            }
+            break;
+        case 15:
+            if (memcmp(key, "deceasedBoolean", 15) == 0) return FHIR_PATIENT_MEMBER_DECEASED_BOOLEAN;
+            break;
+        case 16:
+            if (memcmp(key, "deceasedDateTime", 16) == 0) return FHIR_PATIENT_MEMBER_DECEASED_DATE_TIME;
+            break;
+        case 17:
+            if (memcmp(key, "modifierExtension", 17) == 0) return FHIR_PATIENT_MEMBER_MODIFIER_EXTENSION;
+            break;
+        case 19:
+            if (memcmp(key, "generalPractitioner", 19) == 0) return FHIR_PATIENT_MEMBER_GENERAL_PRACTITIONER;
+            break;
+        case 20:
+            switch (key[13]) {
+                case 'B':
+                    if (memcmp(key, "multipleBirthBoolean", 20) == 0) return FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_BOOLEAN;
+                    break;
+                case 'I':
+                    if (memcmp(key, "multipleBirthInteger", 20) == 0) return FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_INTEGER;
+                    break;
+                case 'i':
+                    if (memcmp(key, "managingOrganization", 20) == 0) return FHIR_PATIENT_MEMBER_MANAGING_ORGANIZATION;
+                    break;
+            }
+            break;
+    }
+    return FHIR_PATIENT_MEMBER_UNKNOWN;
+}
+
+/**
+ * @brief Collect the members of a Patient JSON object in one pass
+ * 
+ * Recognized members are stored in items by FHIRPatientMember (later duplicates
+ * win); names of unrecognized members are recorded on the resource.
+ * 
+ * @param json JSON object
+ * @param items Output member table, zero-initialized by the caller
+ * @param self Resource receiving unknown member names
+ * @return true on success, false on allocation failure
+ */
+static inline bool fhir_patient_scan_members(const cJSON* json,
+                                              const cJSON* items[FHIR_PATIENT_MEMBER_COUNT],
+                                              FHIRResourceBase* self) {
+    const cJSON* member;
+    cJSON_ArrayForEach(member, json) {
+        if (!member->string) continue;
+        
+        FHIRPatientMember index = fhir_patient_member_lookup(member->string);
+        if (index != FHIR_PATIENT_MEMBER_UNKNOWN) {
+            items[index] = member;
+        } else if (!fhir_resource_add_unknown_member(self, member->string)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FHIR_PATIENT_MEMBERS_H */
@@ -7,6 +7,7 @@
 
 #include "fhir_practitioner.h"
 #include "../common/fhir_common.h"
+#include "../common/fhir_json_reader.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,7 +16,7 @@
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(Practitioner, practitioner)
+FHIR_RESOURCE_VTABLE_INIT(Practitioner, practitioner, PRACTITIONER)
 
 /* ========================================================================== */
 /* Practitioner Sub-structure Methods                                        */
@@ -69,14 +70,14 @@ FHIRPractitioner* fhir_practitioner_create(const char* id) {
         return NULL;
     }
     
-    FHIRPractitioner* practitioner = fhir_calloc(1, sizeof(FHIRPractitioner));
+    FHIRPractitioner* practitioner = fhir_resource_alloc(&Practitioner_vtable);
     if (!practitioner) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&practitioner->base, &Practitioner_vtable, 
                                 FHIR_RESOURCE_TYPE_PRACTITIONER, id)) {
-        fhir_free(practitioner);
+        fhir_resource_free(&Practitioner_vtable, practitioner);
         return NULL;
     }
     
@@ -106,7 +107,7 @@ void fhir_practitioner_destroy(FHIRPractitioner* self) {
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&Practitioner_vtable, self);
 }
 
 FHIRPractitioner* fhir_practitioner_clone(const FHIRPractitioner* self) {
@@ -298,7 +299,7 @@ FHIRPractitioner* fhir_practitioner_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -3,19 +3,202 @@
  * @brief FHIR R5 PractitionerRole resource C implementation with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
+ *
+ * The codec is the field table below run by common/fhir_schema.c: one pass
+ * over the JSON members with a generated key switch, each value allocated
+ * at its exact size.
  */
 
 #include "fhir_practitionerrole.h"
 #include "../common/fhir_common.h"
-#include <stdlib.h>
-#include <string.h>
+#include "../common/fhir_json_reader.h"
+#include "../common/fhir_schema.h"
+#include "../fhir_datatype_schemas.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ========================================================================== */
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(PractitionerRole, practitionerrole)
+FHIR_RESOURCE_VTABLE_INIT(PractitionerRole, practitionerrole, PRACTITIONER_ROLE)
+
+/* ========================================================================== */
+/* PractitionerRole Schema                                                    */
+/* ========================================================================== */
+
+typedef enum {
+    FHIR_PRACTITIONER_ROLE_FIELD_IDENTIFIER,
+    FHIR_PRACTITIONER_ROLE_FIELD_ACTIVE,
+    FHIR_PRACTITIONER_ROLE_FIELD_PERIOD,
+    FHIR_PRACTITIONER_ROLE_FIELD_PRACTITIONER,
+    FHIR_PRACTITIONER_ROLE_FIELD_ORGANIZATION,
+    FHIR_PRACTITIONER_ROLE_FIELD_CODE,
+    FHIR_PRACTITIONER_ROLE_FIELD_SPECIALTY,
+    FHIR_PRACTITIONER_ROLE_FIELD_LOCATION,
+    FHIR_PRACTITIONER_ROLE_FIELD_HEALTHCARE_SERVICE,
+    FHIR_PRACTITIONER_ROLE_FIELD_CONTACT,
+    FHIR_PRACTITIONER_ROLE_FIELD_CHARACTERISTIC,
+    FHIR_PRACTITIONER_ROLE_FIELD_COMMUNICATION,
+    FHIR_PRACTITIONER_ROLE_FIELD_AVAILABILITY,
+    FHIR_PRACTITIONER_ROLE_FIELD_ENDPOINT,
+} FHIRPractitionerRoleField;
+
+static const FHIRSchemaField g_practitionerrole_fields[] = {
+    { .key = "identifier", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, identifier), .count_offset = offsetof(FHIRPractitionerRole, identifier_count),
+      .schema = &fhir_identifier_schema },
+    { .key = "active", .kind = FHIR_SCHEMA_BOOLEAN, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, active) },
+    { .key = "period", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, period),
+      .schema = &fhir_period_schema },
+    { .key = "practitioner", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, practitioner),
+      .schema = &fhir_reference_schema },
+    { .key = "organization", .kind = FHIR_SCHEMA_COMPLEX, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, organization),
+      .schema = &fhir_reference_schema },
+    { .key = "code", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, code), .count_offset = offsetof(FHIRPractitionerRole, code_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "specialty", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, specialty), .count_offset = offsetof(FHIRPractitionerRole, specialty_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "location", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, location), .count_offset = offsetof(FHIRPractitionerRole, location_count),
+      .schema = &fhir_reference_schema },
+    { .key = "healthcareService", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, healthcare_service), .count_offset = offsetof(FHIRPractitionerRole, healthcare_service_count),
+      .schema = &fhir_reference_schema },
+    { .key = "contact", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, contact) },
+    { .key = "characteristic", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, characteristic), .count_offset = offsetof(FHIRPractitionerRole, characteristic_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "communication", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, communication), .count_offset = offsetof(FHIRPractitionerRole, communication_count),
+      .schema = &fhir_codeableconcept_schema },
+    { .key = "availability", .kind = FHIR_SCHEMA_JSON, .flags = 0,
+      .offset = offsetof(FHIRPractitionerRole, availability) },
+    { .key = "endpoint", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_ARRAY,
+      .offset = offsetof(FHIRPractitionerRole, endpoint), .count_offset = offsetof(FHIRPractitionerRole, endpoint_count),
+      .schema = &fhir_reference_schema },
+};
+
+static int fhir_practitionerrole_field_lookup(const char* key, size_t length) {
+    switch (length) {
+        case 2:
+            if (memcmp(key, "id", 2) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+            break;
+        case 4:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "code", 4) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_CODE;
+                    break;
+                case 'm':
+                    if (memcmp(key, "meta", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 't':
+                    if (memcmp(key, "text", 4) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 6:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "active", 6) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_ACTIVE;
+                    break;
+                case 'p':
+                    if (memcmp(key, "period", 6) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_PERIOD;
+                    break;
+            }
+            break;
+        case 7:
+            if (memcmp(key, "contact", 7) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_CONTACT;
+            break;
+        case 8:
+            switch (key[1]) {
+                case 'a':
+                    if (memcmp(key, "language", 8) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'n':
+                    if (memcmp(key, "endpoint", 8) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_ENDPOINT;
+                    break;
+                case 'o':
+                    if (memcmp(key, "location", 8) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_LOCATION;
+                    break;
+            }
+            break;
+        case 9:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "contained", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 'e':
+                    if (memcmp(key, "extension", 9) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+                case 's':
+                    if (memcmp(key, "specialty", 9) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_SPECIALTY;
+                    break;
+            }
+            break;
+        case 10:
+            if (memcmp(key, "identifier", 10) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_IDENTIFIER;
+            break;
+        case 12:
+            switch (key[0]) {
+                case 'a':
+                    if (memcmp(key, "availability", 12) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_AVAILABILITY;
+                    break;
+                case 'o':
+                    if (memcmp(key, "organization", 12) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_ORGANIZATION;
+                    break;
+                case 'p':
+                    if (memcmp(key, "practitioner", 12) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_PRACTITIONER;
+                    break;
+                case 'r':
+                    if (memcmp(key, "resourceType", 12) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 13:
+            switch (key[0]) {
+                case 'c':
+                    if (memcmp(key, "communication", 13) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_COMMUNICATION;
+                    break;
+                case 'i':
+                    if (memcmp(key, "implicitRules", 13) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+        case 14:
+            if (memcmp(key, "characteristic", 14) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_CHARACTERISTIC;
+            break;
+        case 17:
+            switch (key[0]) {
+                case 'h':
+                    if (memcmp(key, "healthcareService", 17) == 0) return FHIR_PRACTITIONER_ROLE_FIELD_HEALTHCARE_SERVICE;
+                    break;
+                case 'm':
+                    if (memcmp(key, "modifierExtension", 17) == 0) return FHIR_SCHEMA_MEMBER_BASE;
+                    break;
+            }
+            break;
+    }
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+static const FHIRSchema g_practitionerrole_schema = {
+    .name = "PractitionerRole",
+    .size = sizeof(FHIRPractitionerRole),
+    .fields = g_practitionerrole_fields,
+    .field_count = sizeof(g_practitionerrole_fields) / sizeof(g_practitionerrole_fields[0]),
+    .lookup = fhir_practitionerrole_field_lookup
+};
 
 /* ========================================================================== */
 /* PractitionerRole Factory and Lifecycle Methods                             */
@@ -27,47 +210,27 @@ FHIRPractitionerRole* fhir_practitionerrole_create(const char* id) {
         return NULL;
     }
     
-    FHIRPractitionerRole* practitionerrole = fhir_calloc(1, sizeof(FHIRPractitionerRole));
+    FHIRPractitionerRole* practitionerrole = fhir_resource_alloc(&PractitionerRole_vtable);
     if (!practitionerrole) {
         return NULL;
     }
     
-    if (!fhir_resource_base_init(&practitionerrole->base, &PractitionerRole_vtable, 
-                                FHIR_RESOURCE_TYPE_PRACTITIONERROLE, id)) {
-        fhir_free(practitionerrole);
+    if (!fhir_resource_base_init(&practitionerrole->base, &PractitionerRole_vtable,
+                                FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE, id)) {
+        fhir_resource_free(&PractitionerRole_vtable, practitionerrole);
         return NULL;
     }
     
-    // Initialize PractitionerRole-specific defaults
-    practitionerrole->active = fhir_boolean_create(true);
-    
     return practitionerrole;
 }
 
 void fhir_practitionerrole_destroy(FHIRPractitionerRole* self) {
     if (!self) return;
     
-    // Free PractitionerRole-specific fields
-    if (self->active) fhir_boolean_destroy(self->active);
-    if (self->period) fhir_period_destroy(self->period);
-    if (self->practitioner) fhir_reference_destroy(self->practitioner);
-    if (self->organization) fhir_reference_destroy(self->organization);
-    
-    // Free arrays
-    fhir_array_destroy((void**)self->code, self->code_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->specialty, self->specialty_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->location, self->location_count, (FHIRDestroyFunc)fhir_reference_destroy);
-    fhir_array_destroy((void**)self->healthcare_service, self->healthcare_service_count, (FHIRDestroyFunc)fhir_reference_destroy);
-    fhir_array_destroy((void**)self->contact, self->contact_count, (FHIRDestroyFunc)fhir_extendedcontactdetail_destroy);
-    fhir_array_destroy((void**)self->characteristic, self->characteristic_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->communication, self->communication_count, (FHIRDestroyFunc)fhir_codeableconcept_destroy);
-    fhir_array_destroy((void**)self->availability, self->availability_count, (FHIRDestroyFunc)fhir_availability_destroy);
-    fhir_array_destroy((void**)self->endpoint, self->endpoint_count, (FHIRDestroyFunc)fhir_reference_destroy);
-    
-    // Free base resource
+    fhir_schema_clear(&g_practitionerrole_schema, self);
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&PractitionerRole_vtable, self);
 }
 
 FHIRPractitionerRole* fhir_practitionerrole_clone(const FHIRPractitionerRole* self) {
@@ -76,28 +239,11 @@ FHIRPractitionerRole* fhir_practitionerrole_clone(const FHIRPractitionerRole* se
     FHIRPractitionerRole* clone = fhir_practitionerrole_create(self->base.id);
     if (!clone) return NULL;
     
-    // Clone PractitionerRole-specific fields
-    if (self->active) {
-        clone->active = fhir_boolean_clone(self->active);
-    }
-    if (self->period) {
-        clone->period = fhir_period_clone(self->period);
-    }
-    if (self->practitioner) {
-        clone->practitioner = fhir_reference_clone(self->practitioner);
-    }
-    if (self->organization) {
-        clone->organization = fhir_reference_clone(self->organization);
+    if (!fhir_schema_copy(&g_practitionerrole_schema, clone, self)) {
+        fhir_practitionerrole_destroy(clone);
+        return NULL;
     }
     
-    // Clone arrays
-    clone->code = fhir_array_clone((void**)self->code, self->code_count, 
-                                  (FHIRCloneFunc)fhir_codeableconcept_clone, &clone->code_count);
-    clone->specialty = fhir_array_clone((void**)self->specialty, self->specialty_count, 
-                                       (FHIRCloneFunc)fhir_codeableconcept_clone, &clone->specialty_count);
-    clone->location = fhir_array_clone((void**)self->location, self->location_count, 
-                                      (FHIRCloneFunc)fhir_reference_clone, &clone->location_count);
-    
     return clone;
 }
 
@@ -119,36 +265,12 @@ cJSON* fhir_practitionerrole_to_json(const FHIRPractitionerRole* self) {
     
     // Add resource type and id
     if (!fhir_json_add_string(json, "resourceType", "PractitionerRole") ||
-        !fhir_json_add_string(json, "id", self->base.id)) {
+        !fhir_json_add_string(json, "id", self->base.id) ||
+        !fhir_schema_to_json(&g_practitionerrole_schema, self, json)) {
         cJSON_Delete(json);
         return NULL;
     }
     
-    // Add PractitionerRole-specific fields
-    if (self->active) {
-        fhir_json_add_boolean(json, "active", self->active);
-    }
-    if (self->period) {
-        fhir_json_add_period(json, "period", self->period);
-    }
-    if (self->practitioner) {
-        fhir_json_add_reference(json, "practitioner", self->practitioner);
-    }
-    if (self->organization) {
-        fhir_json_add_reference(json, "organization", self->organization);
-    }
-    
-    // Add arrays
-    if (self->code && self->code_count > 0) {
-        fhir_json_add_codeableconcept_array(json, "code", self->code, self->code_count);
-    }
-    if (self->specialty && self->specialty_count > 0) {
-        fhir_json_add_codeableconcept_array(json, "specialty", self->specialty, self->specialty_count);
-    }
-    if (self->location && self->location_count > 0) {
-        fhir_json_add_reference_array(json, "location", self->location, self->location_count);
-    }
-    
     return json;
 }
 
@@ -158,46 +280,7 @@ bool fhir_practitionerrole_from_json(FHIRPractitionerRole* self, const cJSON* js
         return false;
     }
     
-    // Validate resource type
-    const char* resource_type = fhir_json_get_string(json, "resourceType");
-    if (!resource_type || strcmp(resource_type, "PractitionerRole") != 0) {
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_RESOURCE_TYPE, "Invalid resource type", "resourceType");
-        return false;
-    }
-    
-    // Parse PractitionerRole-specific fields
-    const cJSON* active_json = cJSON_GetObjectItem(json, "active");
-    if (active_json) {
-        self->active = fhir_json_parse_boolean(active_json);
-    }
-    
-    const cJSON* period_json = cJSON_GetObjectItem(json, "period");
-    if (period_json) {
-        self->period = fhir_json_parse_period(period_json);
-    }
-    
-    const cJSON* practitioner_json = cJSON_GetObjectItem(json, "practitioner");
-    if (practitioner_json) {
-        self->practitioner = fhir_json_parse_reference(practitioner_json);
-    }
-    
-    const cJSON* organization_json = cJSON_GetObjectItem(json, "organization");
-    if (organization_json) {
-        self->organization = fhir_json_parse_reference(organization_json);
-    }
-    
-    // Parse arrays
-    const cJSON* code_json = cJSON_GetObjectItem(json, "code");
-    if (code_json && cJSON_IsArray(code_json)) {
-        self->code = fhir_json_parse_codeableconcept_array(code_json, &self->code_count);
-    }
-    
-    const cJSON* specialty_json = cJSON_GetObjectItem(json, "specialty");
-    if (specialty_json && cJSON_IsArray(specialty_json)) {
-        self->specialty = fhir_json_parse_codeableconcept_array(specialty_json, &self->specialty_count);
-    }
-    
-    return true;
+    return fhir_schema_load_resource(&g_practitionerrole_schema, self, json);
 }
 
 FHIRPractitionerRole* fhir_practitionerrole_parse(const char* json_string) {
@@ -206,7 +289,7 @@ FHIRPractitionerRole* fhir_practitionerrole_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -247,18 +330,31 @@ bool fhir_practitionerrole_validate(const FHIRPractitionerRole* self) {
         return false;
     }
     
-    // Validate required fields
-    if (!self->practitioner) {
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "practitioner");
-        return false;
-    }
+    return fhir_schema_validate(&g_practitionerrole_schema, self);
+}
+
+bool fhir_practitionerrole_equals(const FHIRPractitionerRole* self, const FHIRPractitionerRole* other) {
+    if (self == other) return true;
+    if (!self || !other) return false;
     
-    if (!self->organization) {
-        FHIR_SET_FIELD_ERROR(FHIR_ERROR_MISSING_REQUIRED_FIELD, "Missing required field", "organization");
-        return false;
-    }
+    if (fhir_strcmp(self->base.id, other->base.id) != 0) return false;
+    return fhir_schema_equals(&g_practitionerrole_schema, self, other);
+}
+
+char* fhir_practitionerrole_to_string(const FHIRPractitionerRole* self) {
+    if (!self) return NULL;
+    
+    const char* display_name = fhir_practitionerrole_get_display_name(self);
+    
+    char* result = fhir_malloc(256);
+    if (!result) return NULL;
+    
+    snprintf(result, 256, "PractitionerRole(id=%s, name=%s, active=%s)",
+             self->base.id ? self->base.id : "unknown",
+             display_name ? display_name : "unknown",
+             fhir_practitionerrole_is_active(self) ? "true" : "false");
     
-    return true;
+    return result;
 }
 
 /* ========================================================================== */
@@ -266,28 +362,22 @@ bool fhir_practitionerrole_validate(const FHIRPractitionerRole* self) {
 /* ========================================================================== */
 
 bool fhir_practitionerrole_is_active(const FHIRPractitionerRole* self) {
-    if (!self || !self->active) return false;
-    return self->active->value;
+    return self && self->active && self->active->value;
 }
 
 const char* fhir_practitionerrole_get_display_name(const FHIRPractitionerRole* self) {
     if (!self) return NULL;
     
-    // Return practitioner reference display if available
-    if (self->practitioner && self->practitioner->display) {
-        return self->practitioner->display->value;
-    }
-    
     return "PractitionerRole";
 }
 
 bool fhir_practitionerrole_register(void) {
     FHIRResourceRegistration registration = {
-        .type = FHIR_RESOURCE_TYPE_PRACTITIONERROLE,
+        .type = FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE,
         .name = "PractitionerRole",
         .vtable = &PractitionerRole_vtable,
         .factory = (FHIRResourceFactory)fhir_practitionerrole_create
     };
     
     return fhir_resource_register_type(&registration);
-}
\ No newline at end of file
+}
@@ -3,8 +3,10 @@
  * @brief FHIR R5 PractitionerRole resource C interface with OOP principles
  * @version 0.1.0
  * @date 2024-01-01
- * 
+ *
  * A specific set of Roles/Locations/specialties/services that a practitioner may perform
+ *
+ * Generated by scripts/generate_resources.py --codecs; do not edit.
  */
 
 #ifndef FHIR_PRACTITIONERROLE_H
@@ -19,21 +21,16 @@
 extern "C" {
 #endif
 
-/**
- * @brief PractitionerRole active_status enumeration
- */
-typedef enum {
-    FHIRPRACTITIONERROLEACTIVESTATUS_ACTIVE = 0,
-    FHIRPRACTITIONERROLEACTIVESTATUS_INACTIVE = 1,
-} FHIRPractitionerRoleActiveStatus;
-
 /**
  * @brief FHIR R5 PractitionerRole resource structure
- * 
+ *
  * A specific set of Roles/Locations/specialties/services that a practitioner may perform
  */
 FHIR_RESOURCE_DEFINE(PractitionerRole)
     // PractitionerRole-specific fields
+    FHIRIdentifier** identifier;
+    size_t identifier_count;
+    
     FHIRBoolean* active;
     
     FHIRPeriod* period;
@@ -54,8 +51,7 @@ FHIR_RESOURCE_DEFINE(PractitionerRole)
     FHIRReference** healthcare_service;
     size_t healthcare_service_count;
     
-    FHIRExtendedContactDetail** contact;
-    size_t contact_count;
+    cJSON* contact;
     
     FHIRCodeableConcept** characteristic;
     size_t characteristic_count;
@@ -63,8 +59,7 @@ FHIR_RESOURCE_DEFINE(PractitionerRole)
     FHIRCodeableConcept** communication;
     size_t communication_count;
     
-    FHIRAvailability** availability;
-    size_t availability_count;
+    cJSON* availability;
     
     FHIRReference** endpoint;
     size_t endpoint_count;
@@ -132,6 +127,21 @@ FHIRPractitionerRole* fhir_practitionerrole_parse(const char* json_string);
  */
 bool fhir_practitionerrole_validate(const FHIRPractitionerRole* self);
 
+/**
+ * @brief Check if two PractitionerRoles are equal (virtual method)
+ * @param self First PractitionerRole
+ * @param other Second PractitionerRole
+ * @return true if equal, false otherwise
+ */
+bool fhir_practitionerrole_equals(const FHIRPractitionerRole* self, const FHIRPractitionerRole* other);
+
+/**
+ * @brief Convert PractitionerRole to string representation (virtual method)
+ * @param self PractitionerRole to convert
+ * @return String representation (must be freed by caller)
+ */
+char* fhir_practitionerrole_to_string(const FHIRPractitionerRole* self);
+
 /* ========================================================================== */
 /* PractitionerRole-Specific Methods                                          */
 /* ========================================================================== */
@@ -160,4 +170,4 @@ bool fhir_practitionerrole_register(void);
 }
 #endif
 
-#endif /* FHIR_PRACTITIONERROLE_H */
\ No newline at end of file
+#endif /* FHIR_PRACTITIONERROLE_H */
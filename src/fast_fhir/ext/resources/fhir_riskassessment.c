@@ -7,6 +7,7 @@
 
 #include "fhir_riskassessment.h"
 #include "../common/fhir_common.h"
+#include "../common/fhir_json_reader.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,7 +16,7 @@
 /* Virtual Function Table                                                     */
 /* ========================================================================== */
 
-FHIR_RESOURCE_VTABLE_INIT(RiskAssessment, riskassessment)
+FHIR_RESOURCE_VTABLE_INIT(RiskAssessment, riskassessment, RISK_ASSESSMENT)
 
 /* ========================================================================== */
 /* RiskAssessment Sub-structure Methods                                      */
@@ -55,14 +56,14 @@ FHIRRiskAssessment* fhir_riskassessment_create(const char* id) {
         return NULL;
     }
     
-    FHIRRiskAssessment* riskassessment = fhir_calloc(1, sizeof(FHIRRiskAssessment));
+    FHIRRiskAssessment* riskassessment = fhir_resource_alloc(&RiskAssessment_vtable);
     if (!riskassessment) {
         return NULL;
     }
     
     if (!fhir_resource_base_init(&riskassessment->base, &RiskAssessment_vtable, 
-                                FHIR_RESOURCE_TYPE_RISKASSESSMENT, id)) {
-        fhir_free(riskassessment);
+                                FHIR_RESOURCE_TYPE_RISK_ASSESSMENT, id)) {
+        fhir_resource_free(&RiskAssessment_vtable, riskassessment);
         return NULL;
     }
     
@@ -97,7 +98,7 @@ void fhir_riskassessment_destroy(FHIRRiskAssessment* self) {
     // Free base resource
     fhir_resource_base_cleanup(&self->base);
     
-    fhir_free(self);
+    fhir_resource_free(&RiskAssessment_vtable, self);
 }
 
 FHIRRiskAssessment* fhir_riskassessment_clone(const FHIRRiskAssessment* self) {
@@ -375,7 +376,7 @@ FHIRRiskAssessment* fhir_riskassessment_parse(const char* json_string) {
         return NULL;
     }
     
-    cJSON* json = cJSON_Parse(json_string);
+    cJSON* json = fhir_json_parse(json_string, strlen(json_string));
     if (!json) {
         FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "Failed to parse JSON");
         return NULL;
@@ -540,7 +541,7 @@ FHIRRiskAssessmentStatus fhir_riskassessment_status_from_string(const char* stat
 
 bool fhir_riskassessment_register(void) {
     FHIRResourceRegistration registration = {
-        .type = FHIR_RESOURCE_TYPE_RISKASSESSMENT,
+        .type = FHIR_RESOURCE_TYPE_RISK_ASSESSMENT,
         .name = "RiskAssessment",
         .vtable = &RiskAssessment_vtable,
         .factory = (FHIRResourceFactory)fhir_riskassessment_create
@@ -1,14 +1,71 @@
 """Fast FHIR parser using C extensions."""
 
+import asyncio
+import collections
+import gzip
 import json
-from typing import Dict, Any, Optional, Union
+from typing import Dict, Any, Iterator, List, Optional, Tuple, Union
 
 try:
-    import fhir_parser_c
+    from . import fhir_parser_c
     HAS_C_EXTENSION = True
 except ImportError:
     HAS_C_EXTENSION = False
 
+try:
+    from . import fhir_ndjson_c
+    HAS_C_NDJSON = True
+except ImportError:
+    HAS_C_NDJSON = False
+
+try:
+    from . import fhir_match_c
+    HAS_C_MATCH = True
+except ImportError:
+    HAS_C_MATCH = False
+
+try:
+    from . import fhir_arrow_c
+    HAS_C_ARROW = True
+except ImportError:
+    HAS_C_ARROW = False
+
+try:
+    from . import fhir_store_c
+    HAS_C_STORE = True
+except ImportError:
+    HAS_C_STORE = False
+
+try:
+    from . import fhir_interval_c
+    HAS_C_INTERVAL = True
+except ImportError:
+    HAS_C_INTERVAL = False
+
+try:
+    from . import fhir_spatial_c
+    HAS_C_SPATIAL = True
+except ImportError:
+    HAS_C_SPATIAL = False
+
+try:
+    from . import fhir_timeseries_c
+    HAS_C_TIMESERIES = True
+except ImportError:
+    HAS_C_TIMESERIES = False
+
+try:
+    from . import fhir_directory_c
+    HAS_C_DIRECTORY = True
+except ImportError:
+    HAS_C_DIRECTORY = False
+
+try:
+    from . import fhir_lazy_c
+    HAS_C_LAZY = True
+except ImportError:
+    HAS_C_LAZY = False
+
 from .parser import FHIRParser
 from .foundation import FHIRResource
 
@@ -39,11 +96,10 @@ class FastFHIRParser(FHIRParser):
             
         if self.use_c_extensions:
             try:
-                # Fast validation using C extension
-                fhir_parser_c.validate_fhir_json(json_string)
-                
-                # Fast resource type extraction
-                resource_type = fhir_parser_c.extract_resource_type(json_string)
+                # Parse once, then validate and extract resourceType from the same tree
+                document = fhir_parser_c.ParsedDocument(json_string)
+                document.validate()
+                resource_type = document.resource_type()
                 
                 if not resource_type:
                     raise ValueError("Missing resourceType in FHIR data")
@@ -72,12 +128,15 @@ class FastFHIRParser(FHIRParser):
         
         return resource_class.from_dict(data)
     
-    def parse_bundle(self, bundle_data: Union[str, Dict[str, Any]]) -> Dict[str, Any]:
+    def parse_bundle(self, bundle_data: Union[str, Dict[str, Any]],
+                     threads: Optional[int] = None) -> Dict[str, Any]:
         """
         Parse FHIR Bundle with C extension acceleration.
         
         Args:
             bundle_data: JSON string or dictionary containing FHIR Bundle
+            threads: Deserialize and validate entries on this many C worker
+                threads (0 uses all online CPUs); entries that fail are skipped
             
         Returns:
             Dictionary with parsed bundle information
@@ -91,6 +150,11 @@ class FastFHIRParser(FHIRParser):
         if bundle_data.get('resourceType') != 'Bundle':
             raise ValueError("Data is not a FHIR Bundle")
         
+        if threads is not None and self.use_c_extensions and HAS_C_NDJSON:
+            resources, errors = fhir_ndjson_c.parse_bundle(json_string, threads=threads)
+            bundle_data = dict(bundle_data, entry=[{'resource': resource} for resource in resources])
+            return super().parse_bundle(bundle_data)
+        
         # Use C extension for fast entry counting if available
         if self.use_c_extensions:
             try:
@@ -102,6 +166,297 @@ class FastFHIRParser(FHIRParser):
         # Use parent class logic for bundle parsing
         return super().parse_bundle(bundle_data)
     
+    def iter_bundle(self, source: Any) -> Iterator[FHIRResource]:
+        """
+        Iterate over the resources of a FHIR Bundle one entry at a time.
+        
+        With the C extension the Bundle is tokenized incrementally, so memory
+        use is bounded by the largest entry rather than the whole Bundle.
+        
+        Args:
+            source: JSON string, bytes-like object (bytes, mmap, ...) or binary/text file object
+            
+        Yields:
+            Parsed FHIR resource objects (unsupported resource types are skipped)
+        """
+        if self.use_c_extensions:
+            resources = fhir_parser_c.iter_bundle_entries(source)
+        else:
+            # Pure Python fallback loads the whole Bundle
+            if hasattr(source, 'read'):
+                bundle_data = json.load(source)
+            else:
+                bundle_data = json.loads(bytes(source) if not isinstance(source, str) else source)
+            if bundle_data.get('resourceType') != 'Bundle':
+                raise ValueError("Data is not a FHIR Bundle")
+            resources = (entry['resource'] for entry in bundle_data.get('entry', [])
+                         if entry.get('resource'))
+        
+        for resource_data in resources:
+            resource_class = self.RESOURCE_TYPES.get(resource_data.get('resourceType'))
+            if resource_class:
+                yield resource_class.from_dict(resource_data)
+    
+    def stream_parser(self, format: str = 'bundle', max_pending: int = 16,
+                      executor: Any = None, threads: int = 1) -> 'AsyncResourceStream':
+        """
+        Create an incremental parser for a body that arrives in chunks.
+        
+        Meant for asyncio servers: feed() the request body chunk by chunk and
+        iterate the parsed resources with ``async for`` while it is still
+        arriving. Parsing runs on a thread pool, so the event loop is not
+        blocked; see AsyncResourceStream.
+        
+        Args:
+            format: 'bundle' for a Bundle JSON body, 'ndjson' for Bulk Data NDJSON
+            max_pending: Parsed batches buffered before feed() waits for the consumer
+            executor: concurrent.futures executor to parse on (None uses the loop's default)
+            threads: C worker threads per NDJSON batch
+            
+        Returns:
+            AsyncResourceStream yielding FHIR resource objects
+        """
+        return AsyncResourceStream(self, format, max_pending, executor, threads)
+    
+    def parse_ndjson(self, source: Any, threads: int = 0,
+                     batch_size: int = 4096) -> Iterator[Tuple[List[FHIRResource], List[Tuple[int, str]]]]:
+        """
+        Parse FHIR Bulk Data NDJSON in batches.
+        
+        With the C extension the file is memory-mapped and each batch of lines
+        is parsed on a worker pool with the GIL released. gzip (.ndjson.gz)
+        and zstd (.ndjson.zst) input is detected and decompressed on
+        background threads while the previous batch parses.
+        
+        Args:
+            source: Path to an NDJSON file, or NDJSON content as bytes,
+                plain or compressed
+            threads: Worker threads (0 uses all online CPUs)
+            batch_size: Lines per batch
+            
+        Yields:
+            (resources, errors) per batch, where errors are (line_number, message) pairs
+        """
+        if self.use_c_extensions and HAS_C_NDJSON:
+            batches = fhir_ndjson_c.NDJSONReader(source, threads=threads, batch_size=batch_size)
+        else:
+            batches = self._parse_ndjson_python(source, batch_size)
+        
+        for resource_dicts, errors in batches:
+            resources = []
+            for resource_data in resource_dicts:
+                resource_class = self.RESOURCE_TYPES.get(resource_data.get('resourceType'))
+                if resource_class:
+                    resources.append(resource_class.from_dict(resource_data))
+            yield resources, errors
+    
+    def parse_lazy(self, resource_data: Union[str, bytes]):
+        """
+        Parse a resource without converting it to Python objects.
+        
+        Members become Python values on first attribute access and are then
+        cached; snake_case names map to FHIR camelCase (birth_date reads
+        birthDate) and absent members read as None. Nested objects are lazy
+        too, so a large Bundle costs one Python object until entries are read.
+        
+        Args:
+            resource_data: JSON string or bytes of one JSON object
+            
+        Returns:
+            fhir_lazy_c.LazyResource with to_dict(), keys() and pickle support
+        """
+        if not (self.use_c_extensions and HAS_C_LAZY):
+            raise RuntimeError("Lazy resources require the fhir_lazy_c extension")
+        return fhir_lazy_c.parse_lazy(resource_data)
+    
+    def parse_native(self, resource_data: Union[str, bytes, Dict[str, Any]]):
+        """
+        Parse one resource into a native C-backed object.
+        
+        Attributes (resource_type, id, active, display_name and, for Patient,
+        gender and birth_date) are read straight from the C structure, so no
+        dict is built unless to_dict() is called.
+        
+        Args:
+            resource_data: JSON string, bytes or dictionary of a registered resource type
+            
+        Returns:
+            fhir_ndjson_c.Resource
+        """
+        if not (self.use_c_extensions and HAS_C_NDJSON):
+            raise RuntimeError("Native resources require the fhir_ndjson_c extension")
+        if isinstance(resource_data, dict):
+            resource_data = json.dumps(resource_data)
+        return fhir_ndjson_c.parse_resource(resource_data)
+    
+    def read_ndjson_arrow(self, source: Any, resource_type: str = 'Patient', threads: int = 0):
+        """
+        Read the resources of one type from an NDJSON file as an Arrow record batch.
+        
+        Resources are parsed and flattened into columns in C, then handed to
+        pyarrow through the Arrow C Data Interface without copying.
+        
+        Args:
+            source: Path to an NDJSON file
+            resource_type: 'Patient' or 'Observation'
+            threads: Worker threads (0 uses all online CPUs)
+            
+        Returns:
+            pyarrow.RecordBatch with one row per resource
+        """
+        if not (self.use_c_extensions and HAS_C_ARROW):
+            raise RuntimeError("Arrow export requires the fhir_arrow_c extension")
+        import pyarrow
+        return pyarrow.record_batch(fhir_arrow_c.read_ndjson(source, resource_type, threads=threads))
+    
+    def find_duplicate_patients(self, source: Any, threads: int = 0, threshold: float = 8.0,
+                                max_block_size: int = 1000) -> List[Tuple[str, str, float]]:
+        """
+        Find candidate duplicate Patients in Bulk Data NDJSON.
+        
+        The NDJSON is parsed on C worker threads and each Patient is added
+        to a C blocking index.
+        Patients sharing a key (identifier, Soundex family name with birth
+        date or postal code, birth date with postal code) are then scored
+        pairwise, so the work grows with the number of Patients rather than
+        its square.
+        
+        Args:
+            source: Path to an NDJSON file, or NDJSON content as bytes
+            threads: Worker threads (0 uses all online CPUs)
+            threshold: Minimum match score of a reported pair
+            max_block_size: Blocks with more Patients are skipped
+            
+        Returns:
+            (id_a, id_b, score) tuples in file order
+        """
+        if not (self.use_c_extensions and HAS_C_MATCH):
+            raise RuntimeError("Patient matching requires the fhir_match_c extension")
+        index = fhir_match_c.MatchIndex(threshold=threshold, max_block_size=max_block_size)
+        index.add_ndjson(source, threads=threads)
+        return index.pairs(threads=threads)
+    
+    def build_resource_store(self, path: str, source: Any, threads: int = 0) -> int:
+        """
+        Build a read-only resource store file from an NDJSON file.
+        
+        Every resource with an id is binary-encoded and indexed by type and id.
+        
+        Args:
+            path: Store file to write
+            source: Path to an NDJSON file
+            threads: Worker threads (0 uses all online CPUs)
+            
+        Returns:
+            Number of resources stored
+        """
+        if not (self.use_c_extensions and HAS_C_STORE):
+            raise RuntimeError("Resource stores require the fhir_store_c extension")
+        return fhir_store_c.build(path, source, threads=threads)
+    
+    def open_resource_store(self, path: str):
+        """
+        Open a store file written by build_resource_store.
+        
+        The file is memory-mapped, so opening is constant-time and forked
+        workers share its pages; each get() decodes one resource.
+        
+        Args:
+            path: Store file path
+            
+        Returns:
+            fhir_store_c.ResourceStore with get(resource_type, id) and len()
+        """
+        if not (self.use_c_extensions and HAS_C_STORE):
+            raise RuntimeError("Resource stores require the fhir_store_c extension")
+        return fhir_store_c.ResourceStore(path)
+    
+    def export_shared_batch(self, resources: List[Any], name: Optional[str] = None):
+        """
+        Binary-encode a batch of resources into a new shared memory segment.
+        
+        Another process attaches to the segment by name and reads it with
+        open_shared_batch. The caller owns the segment: close() it when done
+        and unlink() it once every reader has attached.
+        
+        Args:
+            resources: LazyResources, native resources, dicts or JSON text
+            name: Segment name (None lets the system choose one)
+        
+        Returns:
+            multiprocessing.shared_memory.SharedMemory holding the batch
+        """
+        if not (self.use_c_extensions and HAS_C_STORE):
+            raise RuntimeError("Shared batches require the fhir_store_c extension")
+        from multiprocessing import shared_memory
+        
+        items = []
+        for resource in resources:
+            if isinstance(resource, (str, bytes)):
+                items.append(resource)
+            elif isinstance(resource, dict):
+                items.append(json.dumps(resource))
+            elif hasattr(resource, 'to_binary'):
+                items.append(resource.to_binary())
+            else:
+                items.append(json.dumps(resource.to_dict()))
+        data = fhir_store_c.export_batch(items)
+        segment = shared_memory.SharedMemory(name=name, create=True, size=len(data))
+        segment.buf[:len(data)] = data
+        return segment
+    
+    def open_shared_batch(self, segment: Any):
+        """
+        Read a batch written by export_shared_batch without copying it.
+        
+        Resources are decoded into LazyResources on first access. The batch
+        holds the segment's buffer until release() (or the end of a with
+        block), and the segment cannot be closed before that.
+        
+        Args:
+            segment: SharedMemory or any bytes-like object
+        
+        Returns:
+            fhir_store_c.SharedBatch with len(), indexing and id(index)
+        """
+        if not (self.use_c_extensions and HAS_C_STORE and HAS_C_LAZY):
+            raise RuntimeError("Shared batches require the fhir_store_c and fhir_lazy_c extensions")
+        return fhir_store_c.open_batch(getattr(segment, 'buf', segment),
+                                       fhir_lazy_c.lazy_from_binary)
+    
+    def _parse_ndjson_python(self, source: Any, batch_size: int):
+        """Pure Python fallback for parse_ndjson."""
+        if isinstance(source, (bytes, bytearray, memoryview)):
+            data = bytes(source)
+        else:
+            with open(source, 'rb') as f:
+                data = f.read()
+        if data[:2] == b'\x1f\x8b':
+            data = gzip.decompress(data)
+        elif data[:4] == b'\x28\xb5\x2f\xfd':
+            raise ValueError("zstd NDJSON requires the fhir_ndjson_c extension")
+        lines = data.decode('utf-8').split('\n')
+        
+        resources, errors = [], []
+        for line_number, line in enumerate(lines, start=1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                data = json.loads(line)
+            except ValueError:
+                errors.append((line_number, "Invalid JSON"))
+            else:
+                if isinstance(data, dict) and data.get('resourceType'):
+                    resources.append(data)
+                else:
+                    errors.append((line_number, "Missing required field (resourceType)"))
+            if len(resources) + len(errors) >= batch_size:
+                yield resources, errors
+                resources, errors = [], []
+        if resources or errors:
+            yield resources, errors
+    
     def extract_field_fast(self, json_string: str, field_name: str) -> Any:
         """
         Fast field extraction using C extension.
@@ -125,6 +480,169 @@ class FastFHIRParser(FHIRParser):
             data = json.loads(json_string)
             return data.get(field_name)
     
+    def extract_fields_fast(self, json_string: str, field_names: List[str]) -> Dict[str, Any]:
+        """
+        Fast extraction of several fields from a single parse.
+        
+        Args:
+            json_string: JSON string
+            field_names: Field names to extract
+            
+        Returns:
+            Dictionary mapping each field name to its value (None if not found)
+        """
+        if self.use_c_extensions:
+            try:
+                return fhir_parser_c.extract_fields(json_string, list(field_names))
+            except Exception:
+                pass  # Fallback to JSON parsing
+        
+        data = json.loads(json_string)
+        return {name: data.get(name) for name in field_names}
+    
+    def evaluate_paths(self, expressions: List[Any], resources: List[Any]) -> List[List[List[Any]]]:
+        """
+        Evaluate FHIRPath expressions over resources in one call.
+        
+        Expressions use the extraction subset of FHIRPath (navigation,
+        indexers, where(), first(), last(), ofType(), extension() and '|')
+        and are compiled once; pass fhir_parser_c.CompiledPath objects to
+        reuse compilations across calls.
+        
+        Args:
+            expressions: Expression strings or CompiledPath objects
+            resources: JSON strings or bytes, dicts, or ParsedDocument objects
+            
+        Returns:
+            For each resource, the list of selected values of each expression
+        """
+        if not (self.use_c_extensions and HAS_C_EXTENSION):
+            raise RuntimeError("FHIRPath evaluation requires the fhir_parser_c extension")
+        paths = [expression if isinstance(expression, fhir_parser_c.CompiledPath)
+                 else fhir_parser_c.CompiledPath(expression) for expression in expressions]
+        documents = [json.dumps(resource) if isinstance(resource, dict) else resource
+                     for resource in resources]
+        return fhir_parser_c.evaluate_paths(paths, documents)
+    
+    def extract_search_index(self, resource: Any) -> List[Tuple]:
+        """
+        Extract normalized search parameter index rows from a resource.
+        
+        Rows are tuples starting with the parameter code and type:
+        (code, 'token', system, code), (code, 'string', value),
+        (code, 'date', start_ms, end_ms), (code, 'quantity', value, system, unit)
+        and (code, 'reference', type, id). Open date bounds are None.
+        
+        Args:
+            resource: JSON string, dict or ParsedDocument
+            
+        Returns:
+            Index rows of the built-in search parameters of the resource type
+        """
+        if not (self.use_c_extensions and HAS_C_EXTENSION):
+            raise RuntimeError("Search index extraction requires the fhir_parser_c extension")
+        if isinstance(resource, fhir_parser_c.ParsedDocument):
+            return resource.search_index()
+        if isinstance(resource, dict):
+            resource = json.dumps(resource)
+        return fhir_parser_c.extract_search_index(resource)
+    
+    def build_interval_index(self, resources: List[Any]) -> Any:
+        """
+        Build an interval index over Encounter periods and CarePlan windows.
+        
+        The returned fhir_interval_c.IntervalIndex answers overlapping(),
+        containing() and at() queries per subject reference (or None for
+        every subject) without scanning the resources. Windows are FHIR date
+        strings, epoch milliseconds or None for an open end; entries come back
+        as (resource_type, id, activity, start_ms, end_ms) tuples.
+        
+        Args:
+            resources: Encounter and CarePlan JSON strings, dicts or ParsedDocuments
+            
+        Returns:
+            fhir_interval_c.IntervalIndex holding every period; more can be add()ed
+        """
+        if not (self.use_c_extensions and HAS_C_INTERVAL):
+            raise RuntimeError("Interval indexing requires the fhir_interval_c extension")
+        index = fhir_interval_c.IntervalIndex()
+        for resource in resources:
+            index.add(json.dumps(resource) if isinstance(resource, dict) else resource)
+        index.build()
+        return index
+    
+    def build_spatial_index(self, locations: List[Any]) -> Any:
+        """
+        Build a spatial index over Location positions.
+        
+        The returned fhir_spatial_c.SpatialIndex answers nearest(lat, lon, k)
+        and within(lat, lon, radius_m) queries as (id, meters) tuples, nearest
+        first. Both take an optional open_at=("mon", "09:30") filter on
+        hoursOfOperation. upsert() moves a changed Location and remove() drops
+        one, so the index can follow updates without a rebuild.
+        
+        Args:
+            locations: Location JSON strings, dicts or ParsedDocuments
+            
+        Returns:
+            fhir_spatial_c.SpatialIndex holding every Location with a position
+        """
+        if not (self.use_c_extensions and HAS_C_SPATIAL):
+            raise RuntimeError("Spatial indexing requires the fhir_spatial_c extension")
+        index = fhir_spatial_c.SpatialIndex()
+        for location in locations:
+            index.upsert(json.dumps(location) if isinstance(location, dict) else location)
+        return index
+    
+    def build_directory_index(self, resources: List[Any]) -> Any:
+        """
+        Build a reference graph over provider directory resources.
+        
+        PractitionerRole, OrganizationAffiliation, Organization and Location
+        references become labeled edges between dense node numbers, so the
+        returned fhir_directory_c.DirectoryIndex answers practitioner searches
+        without joining resources by reference at query time:
+        find_practitioners(organization=..., affiliated=True,
+        include_children=True, location=..., specialty=..., code=...) returns
+        (practitioner, role, organization) reference tuples. add() replaces a
+        changed resource; the graph is packed again on the next query.
+        
+        Args:
+            resources: Directory resource JSON strings, dicts or ParsedDocuments
+            
+        Returns:
+            fhir_directory_c.DirectoryIndex holding every resource
+        """
+        if not (self.use_c_extensions and HAS_C_DIRECTORY):
+            raise RuntimeError("Directory indexing requires the fhir_directory_c extension")
+        index = fhir_directory_c.DirectoryIndex()
+        for resource in resources:
+            index.add(json.dumps(resource) if isinstance(resource, dict) else resource)
+        return index
+    
+    def create_timeseries(self, device_metric: Any, subject: Optional[str] = None, capacity: int = 0) -> Any:
+        """
+        Create a sample ring for a DeviceMetric stream.
+        
+        The returned fhir_timeseries_c.TimeSeries keeps (time, value) pairs in
+        contiguous memory instead of one Observation per sample. It answers
+        stats() and downsample() over time windows, and flush() turns the
+        pending samples into Observation NDJSON when they are needed.
+        
+        Args:
+            device_metric: DeviceMetric JSON string, dict or ParsedDocument
+            subject: Patient reference for the flushed Observations
+            capacity: Samples kept before the oldest is overwritten (0 = default)
+            
+        Returns:
+            fhir_timeseries_c.TimeSeries for the metric
+        """
+        if not (self.use_c_extensions and HAS_C_TIMESERIES):
+            raise RuntimeError("Time series buffering requires the fhir_timeseries_c extension")
+        if isinstance(device_metric, dict):
+            device_metric = json.dumps(device_metric)
+        return fhir_timeseries_c.TimeSeries(device_metric, subject, capacity)
+    
     def get_performance_info(self) -> Dict[str, Any]:
         """Get information about parser performance features."""
         return {
@@ -135,6 +653,213 @@ class FastFHIRParser(FHIRParser):
                 'fast_json_validation',
                 'fast_resource_type_extraction',
                 'fast_bundle_entry_counting',
-                'fast_field_extraction'
+                'fast_field_extraction',
+                'parse_once_document',
+                'batch_field_extraction',
+                'streaming_bundle_iteration',
+                'async_stream_ingestion',
+                'parallel_ndjson_parsing',
+                'compressed_ndjson_streaming',
+                'parallel_bundle_parsing',
+                'arrow_export',
+                'mmap_resource_store',
+                'compiled_fhirpath',
+                'search_index_extraction',
+                'period_interval_index',
+                'location_spatial_index',
+                'provider_directory_index',
+                'patient_match_index',
+                'device_metric_timeseries',
+                'native_resource_objects',
+                'lazy_resource_wrappers',
+                'memory_accounting',
+                'performance_counters',
+                'object_pools',
+                'json_patch',
+                'transaction_scheduler',
+                'free_threading',
+                'shared_memory_batches'
             ] if self.use_c_extensions else ['pure_python_fallback']
-        }
\ No newline at end of file
+        }
+
+
+class AsyncResourceStream:
+    """
+    Incremental parser for a Bundle or NDJSON body that arrives in chunks.
+    
+    feed() only splits each chunk at entry or line boundaries on the calling
+    thread (the C Bundle tokenizer keeps just the unfinished entry between
+    chunks), then hands the completed Bundle entries or NDJSON lines to a
+    thread pool as one batch. Parsed batches wait in a queue of at most
+    max_pending; while it is full feed() waits, so a slow consumer slows the
+    upload down instead of buffering it. Consume from a different task than
+    the one feeding:
+    
+        stream = parser.stream_parser('ndjson')
+        
+        async def pump():
+            async for chunk in request.stream():
+                await stream.feed(chunk)
+            await stream.close()
+        
+        task = asyncio.create_task(pump())
+        async for resource in stream:
+            ...
+        await task
+    
+    Resource types without a model are skipped, as in iter_bundle(). NDJSON
+    lines that fail to parse are collected in ``errors`` as
+    (line_number, message) pairs. A malformed Bundle raises ValueError from
+    the iterator, and also from feed() or close() when the C tokenizer
+    detects it.
+    """
+    
+    def __init__(self, parser: FastFHIRParser, format: str = 'bundle', max_pending: int = 16,
+                 executor: Any = None, threads: int = 1):
+        if format not in ('bundle', 'ndjson'):
+            raise ValueError("format must be 'bundle' or 'ndjson'")
+        if max_pending < 1:
+            raise ValueError("max_pending must be at least 1")
+        self.errors: List[Tuple[int, str]] = []
+        self._parser = parser
+        self._format = format
+        self._max_pending = max_pending
+        self._executor = executor
+        self._threads = threads
+        self._queue = None
+        self._closed = False
+        self._done = False
+        self._ready = collections.deque()
+        self._lines = 0
+        self._tail = bytearray()
+        use_c = parser.use_c_extensions and HAS_C_EXTENSION
+        self._bundle_feed = fhir_parser_c.BundleFeed() if format == 'bundle' and use_c else None
+    
+    async def feed(self, chunk: Union[bytes, bytearray, memoryview, str]) -> None:
+        """
+        Add the next chunk of the body; waits while max_pending batches are unconsumed.
+        
+        Args:
+            chunk: Next bytes (or text) of the body, split anywhere
+        """
+        if self._closed:
+            raise ValueError("feed() called after close()")
+        if isinstance(chunk, str):
+            chunk = chunk.encode('utf-8')
+        try:
+            work = self._split(chunk)
+        except ValueError as error:
+            await self._fail(error)
+            raise
+        if work is not None:
+            await self._submit(*work)
+    
+    async def close(self) -> None:
+        """End the body; the iterator stops after the remaining resources."""
+        if self._closed:
+            return
+        self._closed = True
+        try:
+            work = self._finish()
+        except ValueError as error:
+            await self._fail(error)
+            raise
+        if work is not None:
+            await self._submit(*work)
+        await self._get_queue().put(None)
+    
+    def __aiter__(self) -> 'AsyncResourceStream':
+        return self
+    
+    async def __anext__(self) -> FHIRResource:
+        while not self._ready:
+            if self._done:
+                raise StopAsyncIteration
+            batch = await self._get_queue().get()
+            if batch is None:
+                self._done = True
+                raise StopAsyncIteration
+            try:
+                resources, errors = await batch
+            except Exception:
+                self._done = True
+                raise
+            self.errors.extend(errors)
+            self._ready.extend(resources)
+        return self._ready.popleft()
+    
+    def _get_queue(self) -> 'asyncio.Queue':
+        # Created on first use so it belongs to the loop that runs the stream
+        if self._queue is None:
+            self._queue = asyncio.Queue(self._max_pending)
+        return self._queue
+    
+    async def _submit(self, function: Any, *args: Any) -> None:
+        loop = asyncio.get_running_loop()
+        await self._get_queue().put(loop.run_in_executor(self._executor, function, *args))
+    
+    async def _fail(self, error: Exception) -> None:
+        self._closed = True
+        failed = asyncio.get_running_loop().create_future()
+        failed.set_exception(error)
+        await self._get_queue().put(failed)
+    
+    def _split(self, chunk: Any) -> Optional[Tuple[Any, ...]]:
+        """Take the complete entries or lines out of the input so far."""
+        if self._bundle_feed is not None:
+            entries = self._bundle_feed.feed(chunk)
+            return (self._parse_entries, entries) if entries else None
+        if self._format == 'bundle':
+            # Pure Python fallback parses the whole Bundle at close()
+            self._tail += chunk
+            return None
+        
+        chunk = bytes(chunk)
+        newline = chunk.rfind(b'\n')
+        if newline < 0:
+            self._tail += chunk
+            return None
+        lines = bytes(self._tail) + chunk[:newline + 1]
+        self._tail = bytearray(chunk[newline + 1:])
+        first_line = self._lines + 1
+        self._lines += lines.count(b'\n')
+        return self._parse_lines, first_line, lines
+    
+    def _finish(self) -> Optional[Tuple[Any, ...]]:
+        """Take what is left once the input has ended."""
+        if self._bundle_feed is not None:
+            entries = self._bundle_feed.close()
+            return (self._parse_entries, entries) if entries else None
+        tail, self._tail = bytes(self._tail), bytearray()
+        if self._format == 'bundle':
+            return self._parse_bundle, tail
+        return (self._parse_lines, self._lines + 1, tail) if tail.strip() else None
+    
+    def _resources(self, resource_dicts: Any) -> List[FHIRResource]:
+        resources = []
+        for resource_data in resource_dicts:
+            resource_class = self._parser.RESOURCE_TYPES.get(resource_data.get('resourceType'))
+            if resource_class:
+                resources.append(resource_class.from_dict(resource_data))
+        return resources
+    
+    def _parse_entries(self, entries: List[bytes]):
+        return self._resources(json.loads(entry) for entry in entries), []
+    
+    def _parse_bundle(self, body: bytes):
+        bundle_data = json.loads(body)
+        if not isinstance(bundle_data, dict) or bundle_data.get('resourceType') != 'Bundle':
+            raise ValueError("Data is not a FHIR Bundle")
+        return self._resources(entry['resource'] for entry in bundle_data.get('entry', [])
+                               if entry.get('resource')), []
+    
+    def _parse_lines(self, first_line: int, lines: bytes):
+        if self._parser.use_c_extensions and HAS_C_NDJSON:
+            batches = fhir_ndjson_c.NDJSONReader(lines, threads=self._threads)
+        else:
+            batches = self._parser._parse_ndjson_python(lines, 4096)
+        resources, errors = [], []
+        for resource_dicts, batch_errors in batches:
+            resources.extend(self._resources(resource_dicts))
+            errors.extend((first_line - 1 + line_number, message) for line_number, message in batch_errors)
+        return resources, errors
@@ -1,6 +1,7 @@
 """Python wrapper for FHIR R5 Terminology resources implemented in C."""
 
 from typing import Any, Dict, List, Optional, Union
+import base64
 import json
 
 try:
@@ -287,6 +288,39 @@ class FHIRBinary(FHIRFoundationResource):
         self.security_context = None
         self.data = None
     
+    @property
+    def data(self) -> Optional[str]:
+        """Base64 content, taken from the source JSON only when first read."""
+        if self._data is None:
+            if self._data_span is not None:
+                source = self._data_source
+                if isinstance(source, str):
+                    source = source.encode("utf-8")
+                self._data = bytes(memoryview(source).cast("B")[self._data_span]).decode("ascii")
+            elif self._decoded_data is not None:
+                self._data = base64.b64encode(self._decoded_data).decode("ascii")
+        return self._data
+    
+    @data.setter
+    def data(self, value: Optional[str]) -> None:
+        self._data = value
+        self._data_source = None
+        self._data_span = None
+        self._decoded_data = None
+    
+    def data_bytes(self) -> Optional[memoryview]:
+        """Get the decoded content as a read-only memoryview, decoding it once."""
+        if self._decoded_data is None:
+            if self._data_span is not None and HAS_C_FOUNDATION:
+                self._decoded_data = fhir_foundation_c.base64_decode(
+                    self._data_source, None, self._data_span)
+            elif self.data is not None:
+                if HAS_C_FOUNDATION:
+                    self._decoded_data = fhir_foundation_c.base64_decode(self._data)
+                else:
+                    self._decoded_data = memoryview(base64.b64decode(self._data))
+        return self._decoded_data
+    
     def to_dict(self) -> Dict[str, Any]:
         """Convert to dictionary."""
         if self.use_c_extensions:
@@ -313,6 +347,34 @@ class FHIRBinary(FHIRFoundationResource):
         binary.content_type = data.get("contentType")
         binary.data = data.get("data")
         return binary
+    
+    @classmethod
+    def from_json(cls, json_string: Union[str, bytes], decode_data: bool = False) -> 'FHIRBinary':
+        """Create from JSON using C extension if available.
+        
+        The C parser leaves the base64 payload in json_string and records its
+        offsets; data_bytes() decodes it on first use. With decode_data=True it
+        is decoded while parsing instead.
+        """
+        if HAS_C_FOUNDATION:
+            try:
+                fields = fhir_foundation_c.parse_binary(json_string, decode_data)
+                payload = fields.pop("data", None)
+                binary = cls.from_dict(fields)
+                if isinstance(payload, slice):
+                    binary._data_source = json_string
+                    binary._data_span = payload
+                elif isinstance(payload, memoryview):
+                    binary._decoded_data = payload
+                else:
+                    binary.data = payload
+                return binary
+            except:
+                pass
+        
+        # Fallback to Python JSON parsing
+        data = json.loads(json_string)
+        return cls.from_dict(data)
 
 
 class FHIRBundle(FHIRFoundationResource):
@@ -328,6 +390,9 @@ class FHIRBundle(FHIRFoundationResource):
         self.link = []
         self.entry = []
         self.signature = None
+        self._reference_index = None
+        self._indexed_entries = None
+        self._indexed_count = 0
     
     def to_dict(self) -> Dict[str, Any]:
         """Convert to dictionary."""
@@ -396,6 +461,52 @@ class FHIRBundle(FHIRFoundationResource):
         
         self.entry.append(entry)
         self.total = len(self.entry)
+        if self._reference_index is not None and self._indexed_entries is self.entry:
+            self._index_entry(entry)
+            self._indexed_count += 1
+    
+    def _index_entry(self, entry: Dict[str, Any]) -> None:
+        """Add an entry's fullUrl and type/id keys; the first entry with a key wins."""
+        full_url = entry.get("fullUrl")
+        if full_url:
+            self._reference_index.setdefault(full_url, entry)
+        resource = entry.get("resource") or {}
+        if resource.get("resourceType") and resource.get("id"):
+            self._reference_index.setdefault(("type_id", resource["resourceType"], resource["id"]), entry)
+    
+    def build_reference_index(self) -> None:
+        """Index entries by fullUrl and type/id for resolve()."""
+        self._reference_index = {}
+        self._indexed_entries = self.entry
+        for entry in self.entry:
+            self._index_entry(entry)
+        self._indexed_count = len(self.entry)
+    
+    def resolve(self, reference: str) -> Optional[Dict[str, Any]]:
+        """Find the entry a reference points to, or None.
+        
+        Absolute references (urn:uuid:, http://...) match an entry's fullUrl.
+        Relative references ("Patient/123", optionally with /_history/vid)
+        match fullUrl first, then the resource type and id. Local "#id"
+        references point at contained resources and never match an entry.
+        """
+        if not reference or reference.startswith("#"):
+            return None
+        
+        # Rebuild when the entry list was replaced or changed outside add_entry
+        if (self._reference_index is None or self._indexed_entries is not self.entry
+                or self._indexed_count != len(self.entry)):
+            self.build_reference_index()
+        
+        entry = self._reference_index.get(reference)
+        if entry is not None or ":" in reference:
+            return entry
+        
+        path = reference.split("/_history/", 1)[0]
+        resource_type, _, resource_id = path.partition("/")
+        if not resource_id:
+            return None
+        return self._reference_index.get(("type_id", resource_type, resource_id))
     
     def get_resources_by_type(self, resource_type: str) -> List[Dict[str, Any]]:
         """Get all resources of a specific type from the bundle."""
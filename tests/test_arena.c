@@ -0,0 +1,179 @@
+/**
+ * @file test_arena.c
+ * @brief Unit tests for the arena allocator and arena-backed resource parsing
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_common.h"
+#include "../resources/fhir_patient.h"
+#include <stdint.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Arena Allocator Tests                                                      */
+/* ========================================================================== */
+
+bool test_arena_alloc(void) {
+    FHIRArena* arena = fhir_arena_create(256);
+    ASSERT_NOT_NULL(arena);
+
+    void* a = fhir_arena_alloc(arena, 1);
+    void* b = fhir_arena_alloc(arena, 24);
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    ASSERT_EQ(0, (uintptr_t)a % 16);
+    ASSERT_EQ(0, (uintptr_t)b % 16);
+    ASSERT_TRUE(fhir_arena_owns(arena, a));
+    ASSERT_TRUE(fhir_arena_owns(arena, b));
+
+    // Oversized allocation gets its own block
+    void* big = fhir_arena_alloc(arena, 4096);
+    ASSERT_NOT_NULL(big);
+    memset(big, 0xAB, 4096);
+
+    // Small allocations continue in the partially used block
+    void* c = fhir_arena_alloc(arena, 8);
+    ASSERT_NOT_NULL(c);
+
+    FHIRArenaStats stats;
+    fhir_arena_get_stats(arena, &stats);
+    ASSERT_EQ(4, stats.allocation_count);
+    ASSERT_EQ(2, stats.block_count);
+
+    fhir_arena_reset(arena);
+    fhir_arena_get_stats(arena, &stats);
+    ASSERT_EQ(0, stats.allocation_count);
+    ASSERT_EQ(1, stats.block_count);
+    ASSERT_EQ(256, stats.bytes_reserved);
+    ASSERT_FALSE(fhir_arena_owns(arena, a));
+
+    fhir_arena_destroy(arena);
+    return true;
+}
+
+bool test_arena_current(void) {
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+    ASSERT_NULL(fhir_arena_get_current());
+
+    void* heap = fhir_malloc(16);
+
+    ASSERT_NULL(fhir_arena_set_current(arena));
+    ASSERT_TRUE(fhir_arena_get_current() == arena);
+
+    char* str = fhir_strdup("arena string");
+    int* zeroed = fhir_calloc(4, sizeof(int));
+    ASSERT_TRUE(fhir_arena_owns(arena, str));
+    ASSERT_TRUE(fhir_arena_owns(arena, zeroed));
+    ASSERT_EQ(0, zeroed[0] | zeroed[3]);
+
+    // Growing an arena allocation copies the old contents
+    char* grown = fhir_realloc(str, 64);
+    ASSERT_STR_EQ("arena string", grown);
+
+    // Arena memory is ignored by fhir_free; heap memory is still freed
+    fhir_free(grown);
+    fhir_free(heap);
+
+    ASSERT_TRUE(fhir_arena_set_current(NULL) == arena);
+
+    FHIRArenaStats stats;
+    fhir_arena_get_stats(arena, &stats);
+    ASSERT_EQ(3, stats.allocation_count);
+
+    fhir_arena_destroy(arena);
+    return true;
+}
+
+/* ========================================================================== */
+/* Arena Resource Parsing Tests                                               */
+/* ========================================================================== */
+
+bool test_patient_parse_with_arena(void) {
+    const char* json_string = "{"
+        "\"resourceType\": \"Patient\","
+        "\"id\": \"arena-patient\","
+        "\"active\": true,"
+        "\"gender\": \"female\","
+        "\"birthDate\": \"1990-05-01\","
+        "\"identifier\": [{\"system\": \"urn:mrn\", \"value\": \"123\"}]"
+    "}";
+
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+
+    for (int i = 0; i < 100; i++) {
+        FHIRPatient* patient = fhir_patient_parse_with_arena(arena, json_string);
+        ASSERT_NOT_NULL(patient);
+        ASSERT_TRUE(patient->base.arena == arena);
+        ASSERT_TRUE(fhir_arena_owns(arena, patient));
+        ASSERT_TRUE(fhir_arena_owns(arena, patient->base.id));
+        ASSERT_STR_EQ("arena-patient", patient->base.id);
+        ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, patient->gender);
+
+        // Releasing leaves the memory to the arena
+        fhir_resource_release(&patient->base);
+    }
+    ASSERT_NULL(fhir_arena_get_current());
+
+    FHIRArenaStats stats;
+    fhir_arena_get_stats(arena, &stats);
+    ASSERT_TRUE(stats.allocation_count >= 100 * 3);
+
+    fhir_arena_reset(arena);
+
+    // Invalid input leaves the arena usable
+    ASSERT_NULL(fhir_patient_parse_with_arena(arena, "{not json"));
+
+    // Clones made outside the arena live on the heap
+    FHIRPatient* patient = fhir_patient_parse_with_arena(arena, json_string);
+    ASSERT_NOT_NULL(patient);
+    FHIRPatient* clone = fhir_patient_clone(patient);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_NULL(clone->base.arena);
+    ASSERT_FALSE(fhir_arena_owns(arena, clone));
+
+    fhir_arena_destroy(arena);
+    ASSERT_STR_EQ("arena-patient", clone->base.id);
+    fhir_patient_destroy(clone);
+    return true;
+}
+
+bool test_resource_parse_with_arena(void) {
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+
+    cJSON* json = cJSON_Parse("{\"resourceType\": \"Patient\", \"id\": \"generic\"}");
+    ASSERT_NOT_NULL(json);
+
+    FHIRArena* arena = fhir_arena_create(0);
+    FHIRResourceBase* resource = fhir_resource_parse_with_arena(arena, json);
+    ASSERT_NOT_NULL(resource);
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_PATIENT, resource->resource_type);
+    ASSERT_STR_EQ("generic", resource->id);
+    ASSERT_TRUE(fhir_arena_owns(arena, resource));
+
+    cJSON_Delete(json);
+    json = cJSON_Parse("{\"resourceType\": \"Patient\"}");
+    ASSERT_NULL(fhir_resource_parse_with_arena(arena, json));
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, fhir_get_last_error()->code);
+
+    cJSON_Delete(json);
+    fhir_arena_destroy(arena);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_arena_alloc);
+    RUN_TEST(test_arena_current);
+    RUN_TEST(test_patient_parse_with_arena);
+    RUN_TEST(test_resource_parse_with_arena);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file test_arrow.c
+ * @brief Unit tests for the Arrow C Data Interface exporter
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_arrow.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool bit_set(const void* bitmap, int64_t index) {
+    return (((const uint8_t*)bitmap)[index / 8] >> (index % 8)) & 1;
+}
+
+// Compare row i of a UTF-8 array ("u") with expected (NULL for null)
+static bool string_equals(const struct ArrowArray* array, int64_t i, const char* expected) {
+    if (!bit_set(array->buffers[0], i)) return expected == NULL;
+    const int32_t* offsets = array->buffers[1];
+    const char* data = array->buffers[2];
+    size_t length = (size_t)(offsets[i + 1] - offsets[i]);
+    return expected && strlen(expected) == length && memcmp(data + offsets[i], expected, length) == 0;
+}
+
+// Compare row i of a dictionary-encoded array (int32 indices)
+static bool dictionary_equals(const struct ArrowArray* array, int64_t i, const char* expected) {
+    if (!bit_set(array->buffers[0], i)) return expected == NULL;
+    const int32_t* indices = array->buffers[1];
+    return string_equals(array->dictionary, indices[i], expected);
+}
+
+/* ========================================================================== */
+/* Patient Export Tests                                                       */
+/* ========================================================================== */
+
+bool test_arrow_export_patients(void) {
+    FHIRPatient* patients[3];
+    // Lazily parsed, so the export materializes the name and organization
+    patients[0] = fhir_patient_parse_lazy(
+        "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true,\"gender\":\"female\","
+        "\"birthDate\":\"1970-01-01\",\"name\":[{\"family\":\"Doe\",\"given\":[\"Jane\",\"Q\"]}],"
+        "\"managingOrganization\":{\"reference\":\"Organization/1\"}}");
+    patients[1] = fhir_patient_parse(
+        "{\"resourceType\":\"Patient\",\"id\":\"p2\",\"active\":false,\"deceasedBoolean\":true}");
+    patients[2] = fhir_patient_parse("{\"resourceType\":\"Patient\",\"id\":\"p3\"}");
+    for (int i = 0; i < 3; i++) {
+        ASSERT_NOT_NULL(patients[i]);
+    }
+
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    ASSERT_TRUE(fhir_arrow_export_patients((const FHIRPatient* const*)patients, 3, &schema, &array));
+
+    for (int i = 0; i < 3; i++) {
+        fhir_resource_release(&patients[i]->base);
+    }
+
+    // Schema
+    ASSERT_STR_EQ("+s", schema.format);
+    ASSERT_EQ(9, schema.n_children);
+    ASSERT_STR_EQ("id", schema.children[0]->name);
+    ASSERT_STR_EQ("u", schema.children[0]->format);
+    ASSERT_EQ(0, schema.children[0]->flags);
+    ASSERT_STR_EQ("active", schema.children[1]->name);
+    ASSERT_STR_EQ("b", schema.children[1]->format);
+    ASSERT_EQ(ARROW_FLAG_NULLABLE, schema.children[1]->flags);
+    ASSERT_STR_EQ("managing_organization", schema.children[8]->name);
+
+    // Data outlives the source resources
+    ASSERT_EQ(3, array.length);
+    ASSERT_EQ(9, array.n_children);
+    ASSERT_EQ(1, array.n_buffers);
+    ASSERT_TRUE(array.buffers[0] == NULL);
+
+    const struct ArrowArray* id = array.children[0];
+    ASSERT_EQ(0, id->null_count);
+    ASSERT_TRUE(string_equals(id, 0, "p1"));
+    ASSERT_TRUE(string_equals(id, 2, "p3"));
+
+    const struct ArrowArray* active = array.children[1];
+    ASSERT_EQ(1, active->null_count);
+    ASSERT_TRUE(bit_set(active->buffers[0], 0) && bit_set(active->buffers[1], 0));
+    ASSERT_TRUE(bit_set(active->buffers[0], 1) && !bit_set(active->buffers[1], 1));
+    ASSERT_FALSE(bit_set(active->buffers[0], 2));
+
+    ASSERT_TRUE(string_equals(array.children[2], 0, "female"));
+    ASSERT_TRUE(string_equals(array.children[3], 0, "1970-01-01"));
+    ASSERT_TRUE(string_equals(array.children[3], 1, NULL));
+    ASSERT_TRUE(bit_set(array.children[4]->buffers[1], 1));
+    ASSERT_TRUE(string_equals(array.children[6], 0, "Doe"));
+    ASSERT_TRUE(string_equals(array.children[7], 0, "Jane"));
+    ASSERT_TRUE(string_equals(array.children[7], 1, NULL));
+    ASSERT_TRUE(string_equals(array.children[8], 0, "Organization/1"));
+    ASSERT_EQ(2, array.children[8]->null_count);
+
+    schema.release(&schema);
+    array.release(&array);
+    ASSERT_TRUE(schema.release == NULL);
+    ASSERT_TRUE(array.release == NULL);
+
+    // Empty batch
+    ASSERT_TRUE(fhir_arrow_export_patients(NULL, 0, &schema, &array));
+    ASSERT_EQ(0, array.length);
+    ASSERT_EQ(0, array.children[0]->length);
+    schema.release(&schema);
+    array.release(&array);
+
+    ASSERT_FALSE(fhir_arrow_export_patients(NULL, 1, &schema, &array));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    return true;
+}
+
+/* ========================================================================== */
+/* Observation Export Tests                                                   */
+/* ========================================================================== */
+
+bool test_arrow_export_observation_columns(void) {
+    FHIRObservationColumns* columns = fhir_observation_columns_create();
+    ASSERT_NOT_NULL(columns);
+
+    const char* observations[] = {
+        "{\"resourceType\":\"Observation\",\"status\":\"final\","
+        "\"code\":{\"coding\":[{\"system\":\"http://loinc.org\",\"code\":\"8867-4\"}]},"
+        "\"subject\":{\"reference\":\"Patient/1\"},\"effectiveDateTime\":\"1970-01-01T00:00:01Z\","
+        "\"valueQuantity\":{\"value\":72,\"code\":\"/min\"}}",
+        "{\"resourceType\":\"Observation\",\"status\":\"amended\",\"code\":{\"coding\":[{\"code\":\"steps\"}]},"
+        "\"valueInteger\":9000}",
+        "{\"resourceType\":\"Observation\",\"status\":\"preliminary\","
+        "\"code\":{\"coding\":[{\"system\":\"http://loinc.org\",\"code\":\"8867-4\"}]},"
+        "\"subject\":{\"reference\":\"Patient/2\"},\"effectiveDateTime\":\"1970-01-01T00:00:02Z\","
+        "\"valueQuantity\":{\"value\":80,\"code\":\"/min\"}}"
+    };
+    for (int i = 0; i < 3; i++) {
+        cJSON* json = cJSON_Parse(observations[i]);
+        ASSERT_TRUE(fhir_observation_columns_append_json(columns, json));
+        cJSON_Delete(json);
+    }
+
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    ASSERT_TRUE(fhir_arrow_export_observation_columns(columns, NULL, &schema, &array));
+
+    ASSERT_STR_EQ("+s", schema.format);
+    ASSERT_EQ(7, schema.n_children);
+    ASSERT_STR_EQ("tsm:UTC", schema.children[0]->format);
+    ASSERT_STR_EQ("i", schema.children[2]->format);
+    ASSERT_NOT_NULL(schema.children[2]->dictionary);
+    ASSERT_STR_EQ("u", schema.children[2]->dictionary->format);
+    ASSERT_STR_EQ("g", schema.children[3]->format);
+    ASSERT_STR_EQ("c", schema.children[6]->format);
+    ASSERT_EQ(3, array.length);
+
+    const struct ArrowArray* time = array.children[0];
+    ASSERT_EQ(1, time->null_count);
+    ASSERT_TRUE(((const int64_t*)time->buffers[1])[0] == 1000);
+    ASSERT_FALSE(bit_set(time->buffers[0], 1));
+
+    ASSERT_TRUE(dictionary_equals(array.children[1], 0, "http://loinc.org"));
+    ASSERT_TRUE(dictionary_equals(array.children[1], 1, NULL));
+    ASSERT_TRUE(dictionary_equals(array.children[2], 1, "steps"));
+    ASSERT_TRUE(dictionary_equals(array.children[2], 2, "8867-4"));
+    ASSERT_FLOAT_EQ(9000.0, ((const double*)array.children[3]->buffers[1])[1], 1e-9);
+    ASSERT_TRUE(dictionary_equals(array.children[4], 0, "/min"));
+    ASSERT_TRUE(dictionary_equals(array.children[4], 1, NULL));
+    ASSERT_TRUE(dictionary_equals(array.children[5], 2, "Patient/2"));
+
+    const struct ArrowArray* status = array.children[6];
+    ASSERT_EQ(8, status->dictionary->length);
+    ASSERT_TRUE(string_equals(status->dictionary, ((const int8_t*)status->buffers[1])[1], "amended"));
+
+    schema.release(&schema);
+    array.release(&array);
+
+    // Masked rows
+    uint8_t mask[3] = {1, 0, 1};
+    ASSERT_TRUE(fhir_arrow_export_observation_columns(columns, mask, &schema, &array));
+    ASSERT_EQ(2, array.length);
+    ASSERT_EQ(0, array.children[0]->null_count);
+    ASSERT_TRUE(dictionary_equals(array.children[5], 1, "Patient/2"));
+    ASSERT_FLOAT_EQ(80.0, ((const double*)array.children[3]->buffers[1])[1], 1e-9);
+    schema.release(&schema);
+    array.release(&array);
+
+    fhir_observation_columns_destroy(columns);
+    return true;
+}
+
+bool test_arrow_large_batch(void) {
+    // Enough rows to grow the string buffers several times
+    size_t count = 5000;
+    FHIRPatient** patients = malloc(count * sizeof(FHIRPatient*));
+    ASSERT_NOT_NULL(patients);
+    char json[128];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(json, sizeof(json), "{\"resourceType\":\"Patient\",\"id\":\"patient-%zu\"}", i);
+        patients[i] = fhir_patient_parse(json);
+        ASSERT_NOT_NULL(patients[i]);
+    }
+
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    ASSERT_TRUE(fhir_arrow_export_patients((const FHIRPatient* const*)patients, count, &schema, &array));
+    for (size_t i = 0; i < count; i++) {
+        fhir_resource_release(&patients[i]->base);
+    }
+    free(patients);
+
+    ASSERT_TRUE(string_equals(array.children[0], 0, "patient-0"));
+    ASSERT_TRUE(string_equals(array.children[0], 4999, "patient-4999"));
+    ASSERT_EQ((long)count, array.children[2]->null_count);
+
+    schema.release(&schema);
+    array.release(&array);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_arrow_export_patients);
+    RUN_TEST(test_arrow_export_observation_columns);
+    RUN_TEST(test_arrow_large_batch);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,61 @@
+"""Tests for Arrow export with C extensions."""
+
+import json
+import os
+import tempfile
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestArrowExport:
+    """Test cases for Arrow record batch export."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_arrow_export(self):
+        """Test NDJSON resources exported as Arrow record batches through PyCapsules."""
+        fhir_arrow_c = pytest.importorskip("fast_fhir.fhir_arrow_c")
+        
+        lines = [json.dumps({"resourceType": "Patient", "id": f"p{i}", "active": i % 2 == 0})
+                 for i in range(50)]
+        lines.append(json.dumps({"resourceType": "Observation", "id": "o1", "status": "final",
+                                 "code": {"coding": [{"system": "http://loinc.org", "code": "8867-4"}]},
+                                 "effectiveDateTime": "2024-01-01T00:00:00Z",
+                                 "valueQuantity": {"value": 72, "code": "/min"}}))
+        lines.append("{not json")
+        
+        with tempfile.NamedTemporaryFile(suffix=".ndjson", delete=False) as f:
+            f.write("\n".join(lines).encode())
+            path = f.name
+        
+        try:
+            batch = fhir_arrow_c.read_ndjson(path, "Patient", threads=2)
+            assert batch.num_rows == 50
+            schema_capsule, array_capsule = batch.__arrow_c_array__()
+            assert "arrow_schema" in repr(schema_capsule)
+            assert "arrow_array" in repr(array_capsule)
+            assert batch.num_rows == 0
+            with pytest.raises(RuntimeError):
+                batch.__arrow_c_array__()
+            del schema_capsule, array_capsule
+            
+            assert fhir_arrow_c.read_ndjson(path, "Observation").num_rows == 1
+            with pytest.raises(ValueError):
+                fhir_arrow_c.read_ndjson(path, "Encounter")
+            with pytest.raises(OSError):
+                fhir_arrow_c.read_ndjson(path + ".missing")
+            
+            pyarrow = pytest.importorskip("pyarrow")
+            patients = self.parser.read_ndjson_arrow(path)
+            assert patients.num_rows == 50
+            assert patients.column("id").to_pylist()[:2] == ["p0", "p1"]
+            assert patients.column("active").to_pylist()[:2] == [True, False]
+            
+            observations = self.parser.read_ndjson_arrow(path, "Observation")
+            assert observations.column("code").to_pylist() == ["8867-4"]
+            assert observations.column("value").to_pylist() == [72.0]
+            assert observations.schema.field("effective_time").type == pyarrow.timestamp("ms", tz="UTC")
+        finally:
+            os.remove(path)
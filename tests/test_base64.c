@@ -0,0 +1,147 @@
+/**
+ * @file test_base64.c
+ * @brief Unit tests for the streaming base64 codec
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_base64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool decodes_to(const char* text, const char* expected) {
+    uint8_t out[256];
+    size_t written;
+    if (!fhir_base64_decode(text, strlen(text), out, sizeof(out), &written)) return false;
+    return written == strlen(expected) && memcmp(out, expected, written) == 0;
+}
+
+/* ========================================================================== */
+/* Decoding Tests                                                             */
+/* ========================================================================== */
+
+bool test_base64_vectors(void) {
+    // RFC 4648 section 10
+    const char* plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* encoded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    for (size_t i = 0; i < sizeof(plain) / sizeof(plain[0]); i++) {
+        char out[16];
+        size_t length = fhir_base64_encode((const uint8_t*)plain[i], strlen(plain[i]), out);
+        ASSERT_EQ(strlen(encoded[i]), length);
+        ASSERT_MEM_EQ(encoded[i], out, length);
+        ASSERT_EQ(fhir_base64_encoded_length(strlen(plain[i])), length);
+        ASSERT_TRUE(decodes_to(encoded[i], plain[i]));
+    }
+    return true;
+}
+
+bool test_base64_whitespace_and_invalid(void) {
+    ASSERT_TRUE(decodes_to("Zm9v\r\nYmFy", "foobar"));
+    ASSERT_TRUE(decodes_to(" Zm 9v\tYg = =\n", "foob"));
+
+    const char* invalid[] = {"Zm9", "Zg=", "Zg===", "Z===", "=Zg=", "Zg==Zg==", "Zm9v!", "Zm-v", "Zm_v", "Zm9v\x80"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        uint8_t out[16];
+        size_t written;
+        ASSERT_FALSE(fhir_base64_decode(invalid[i], strlen(invalid[i]), out, sizeof(out), &written));
+    }
+
+    // Output capacity is checked
+    uint8_t small[5];
+    size_t written;
+    ASSERT_FALSE(fhir_base64_decode("Zm9vYmFy", 8, small, sizeof(small), &written));
+    return true;
+}
+
+/* ========================================================================== */
+/* Streaming Tests                                                            */
+/* ========================================================================== */
+
+bool test_base64_streaming_round_trip(void) {
+    // Long enough for the SIMD kernels, with every chunk size splitting quads and groups
+    size_t length = 10007;
+    uint8_t* data = malloc(length);
+    char* text = malloc(fhir_base64_encoded_length(length));
+    uint8_t* decoded = malloc(length + 3);
+    ASSERT_NOT_NULL(data);
+    ASSERT_NOT_NULL(text);
+    ASSERT_NOT_NULL(decoded);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(i * 131 + (i >> 7));
+    }
+    size_t text_length = fhir_base64_encode(data, length, text);
+    ASSERT_EQ(fhir_base64_encoded_length(length), text_length);
+
+    bool ok = true;
+    for (size_t chunk = 1; chunk <= 70 && ok; chunk += 3) {
+        // Encode in chunks and compare with the one-shot text
+        FHIRBase64Encoder encoder;
+        fhir_base64_encoder_init(&encoder);
+        char* chunked = malloc(text_length);
+        size_t chunked_length = 0;
+        for (size_t offset = 0; offset < length; offset += chunk) {
+            size_t take = length - offset < chunk ? length - offset : chunk;
+            chunked_length += fhir_base64_encoder_update(&encoder, data + offset, take, chunked + chunked_length);
+        }
+        chunked_length += fhir_base64_encoder_finish(&encoder, chunked + chunked_length);
+        ok = chunked_length == text_length && memcmp(chunked, text, text_length) == 0;
+        free(chunked);
+
+        // Decode in chunks
+        FHIRBase64Decoder decoder;
+        fhir_base64_decoder_init(&decoder);
+        size_t decoded_length = 0;
+        for (size_t offset = 0; offset < text_length && ok; offset += chunk) {
+            size_t take = text_length - offset < chunk ? text_length - offset : chunk;
+            size_t written;
+            ok = fhir_base64_decoder_update(&decoder, text + offset, take, decoded + decoded_length,
+                                            fhir_base64_decoded_max_length(take), &written);
+            decoded_length += written;
+        }
+        ok = ok && fhir_base64_decoder_finish(&decoder) && decoded_length == length &&
+             memcmp(decoded, data, length) == 0;
+    }
+
+    free(data);
+    free(text);
+    free(decoded);
+    ASSERT_TRUE(ok);
+    return true;
+}
+
+bool test_base64_decoder_state(void) {
+    FHIRBase64Decoder decoder;
+    fhir_base64_decoder_init(&decoder);
+    uint8_t out[8];
+    size_t written;
+
+    // A partial quad is carried to the next call
+    ASSERT_TRUE(fhir_base64_decoder_update(&decoder, "Zm9vY", 5, out, sizeof(out), &written));
+    ASSERT_EQ(3, written);
+    ASSERT_FALSE(fhir_base64_decoder_finish(&decoder));
+    ASSERT_TRUE(fhir_base64_decoder_update(&decoder, "g==", 3, out, sizeof(out), &written));
+    ASSERT_EQ(1, written);
+    ASSERT_EQ('b', out[0]);
+    ASSERT_TRUE(fhir_base64_decoder_finish(&decoder));
+
+    // Nothing but whitespace may follow the padding, and a failed decoder stays failed
+    ASSERT_FALSE(fhir_base64_decoder_update(&decoder, "Zg==", 4, out, sizeof(out), &written));
+    ASSERT_FALSE(fhir_base64_decoder_update(&decoder, "", 0, out, sizeof(out), &written));
+    ASSERT_FALSE(fhir_base64_decoder_finish(&decoder));
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    printf("base64 kernel: %s\n", fhir_base64_backend());
+    RUN_TEST(test_base64_vectors);
+    RUN_TEST(test_base64_whitespace_and_invalid);
+    RUN_TEST(test_base64_streaming_round_trip);
+    RUN_TEST(test_base64_decoder_state);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_batch.c
+ * @brief Unit tests for batches handed off through shared memory
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_batch.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static FHIRBatchWriter* build_batch(size_t count) {
+    FHIRBatchWriter* writer = fhir_batch_writer_create();
+    if (!writer) return NULL;
+
+    char json[160];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(json, sizeof(json),
+                 "{\"resourceType\":\"Observation\",\"id\":\"o%zu\",\"status\":\"final\",\"valueInteger\":%zu}",
+                 i, i);
+        cJSON* observation = cJSON_Parse(json);
+        bool ok = fhir_batch_writer_add_json(writer, observation);
+        cJSON_Delete(observation);
+        if (!ok) {
+            fhir_batch_writer_destroy(writer);
+            return NULL;
+        }
+    }
+    return writer;
+}
+
+/* ========================================================================== */
+/* Batch Tests                                                                */
+/* ========================================================================== */
+
+bool test_batch_round_trip(void) {
+    FHIRBatchWriter* writer = build_batch(100);
+    ASSERT_NOT_NULL(writer);
+
+    // Resources without an id or a known type are kept
+    cJSON* anonymous = cJSON_Parse("{\"resourceType\":\"NotAType\",\"note\":\"kept\"}");
+    ASSERT_TRUE(fhir_batch_writer_add_json(writer, anonymous));
+    cJSON_Delete(anonymous);
+    ASSERT_EQ(101, fhir_batch_writer_get_count(writer));
+
+    size_t size = fhir_batch_writer_get_size(writer);
+    uint8_t* buffer = malloc(size);
+    ASSERT_NOT_NULL(buffer);
+    ASSERT_EQ(0, fhir_batch_writer_write(writer, buffer, size - 1));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    ASSERT_EQ(size, fhir_batch_writer_write(writer, buffer, size));
+    fhir_batch_writer_destroy(writer);
+
+    FHIRBatch batch;
+    ASSERT_TRUE(fhir_batch_open(&batch, buffer, size));
+    ASSERT_EQ(101, fhir_batch_get_count(&batch));
+
+    // Documents keep the order they were added in and are read in place
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_batch_get(&batch, 42, &document));
+    ASSERT_STR_EQ("o42", fhir_binary_get_id(&document));
+    ASSERT_TRUE(document.data >= buffer && document.data + document.size <= buffer + size);
+    ASSERT_EQ(0, (size_t)(document.data - buffer) % 8);
+
+    cJSON* json = fhir_batch_get_json(&batch, 7);
+    ASSERT_NOT_NULL(json);
+    ASSERT_STR_EQ("o7", fhir_json_get_string(json, "id"));
+    ASSERT_EQ(7, cJSON_GetObjectItem(json, "valueInteger")->valueint);
+    cJSON_Delete(json);
+
+    ASSERT_TRUE(fhir_batch_get(&batch, 100, &document));
+    ASSERT_NULL(fhir_binary_get_id(&document));
+    json = fhir_batch_get_json(&batch, 100);
+    ASSERT_STR_EQ("kept", fhir_json_get_string(json, "note"));
+    cJSON_Delete(json);
+
+    ASSERT_FALSE(fhir_batch_get(&batch, 101, &document));
+    free(buffer);
+    return true;
+}
+
+bool test_batch_codec_documents(void) {
+    FHIRPatient* patient = fhir_patient_parse("{\"resourceType\":\"Patient\",\"id\":\"pt\",\"gender\":\"female\"}");
+    ASSERT_NOT_NULL(patient);
+    size_t length;
+    uint8_t* encoded = fhir_resource_to_binary(&patient->base, &length);
+    fhir_resource_release(&patient->base);
+    ASSERT_NOT_NULL(encoded);
+
+    FHIRBatchWriter* writer = fhir_batch_writer_create();
+    ASSERT_NOT_NULL(writer);
+    ASSERT_TRUE(fhir_batch_writer_add(writer, encoded, length));
+    ASSERT_FALSE(fhir_batch_writer_add(writer, encoded, length - 1));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+    fhir_free(encoded);
+
+    size_t size = fhir_batch_writer_get_size(writer);
+    uint8_t* buffer = malloc(size);
+    ASSERT_NOT_NULL(buffer);
+    ASSERT_EQ(size, fhir_batch_writer_write(writer, buffer, size));
+    fhir_batch_writer_destroy(writer);
+
+    // Codec documents decode through the registry, not as JSON
+    FHIRBatch batch;
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_batch_open(&batch, buffer, size));
+    ASSERT_NULL(fhir_batch_get_json(&batch, 0));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    ASSERT_TRUE(fhir_batch_get(&batch, 0, &document));
+    FHIRPatient* decoded = (FHIRPatient*)fhir_resource_from_binary(document.data, document.size);
+    ASSERT_NOT_NULL(decoded);
+    ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, decoded->gender);
+    fhir_resource_release(&decoded->base);
+    free(buffer);
+    return true;
+}
+
+bool test_batch_shared_with_child(void) {
+    FHIRBatchWriter* writer = build_batch(1000);
+    ASSERT_NOT_NULL(writer);
+    size_t size = fhir_batch_writer_get_size(writer);
+
+    // A shared anonymous mapping stands in for a shared memory segment
+    void* segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_TRUE(segment != MAP_FAILED);
+
+    pid_t child = fork();
+    ASSERT_TRUE(child >= 0);
+    if (child == 0) {
+        // The child writes the batch; the parent reads it after the child exits
+        bool written = fhir_batch_writer_write(writer, segment, size) == size;
+        _exit(written ? 0 : 1);
+    }
+    int status;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    fhir_batch_writer_destroy(writer);
+
+    FHIRBatch batch;
+    ASSERT_TRUE(fhir_batch_open(&batch, segment, size));
+    ASSERT_EQ(1000, fhir_batch_get_count(&batch));
+    cJSON* json = fhir_batch_get_json(&batch, 999);
+    ASSERT_NOT_NULL(json);
+    ASSERT_STR_EQ("o999", fhir_json_get_string(json, "id"));
+    cJSON_Delete(json);
+
+    munmap(segment, size);
+    return true;
+}
+
+bool test_batch_rejects_bad_input(void) {
+    FHIRBatch batch;
+    ASSERT_FALSE(fhir_batch_open(&batch, "FHBT", 4));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+
+    FHIRBatchWriter* writer = build_batch(3);
+    ASSERT_NOT_NULL(writer);
+    size_t size = fhir_batch_writer_get_size(writer);
+    uint8_t* buffer = malloc(size);
+    ASSERT_NOT_NULL(buffer);
+    ASSERT_EQ(size, fhir_batch_writer_write(writer, buffer, size));
+    fhir_batch_writer_destroy(writer);
+
+    // Truncated batches are rejected on open or when a document is read
+    for (size_t cut = 0; cut < size; cut += 5) {
+        if (fhir_batch_open(&batch, buffer, cut)) {
+            for (size_t i = 0; i < fhir_batch_get_count(&batch); i++) {
+                cJSON_Delete(fhir_batch_get_json(&batch, i));
+            }
+        } else {
+            ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+        }
+    }
+
+    buffer[4] = 9;
+    ASSERT_FALSE(fhir_batch_open(&batch, buffer, size));
+    free(buffer);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_batch_round_trip);
+    RUN_TEST(test_batch_codec_documents);
+    RUN_TEST(test_batch_shared_with_child);
+    RUN_TEST(test_batch_rejects_bad_input);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file test_binary.c
+ * @brief Unit tests for the compact binary resource format
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_binary.h"
+#include "../resources/fhir_patient.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"example\",\"active\":true,\"gender\":\"female\","
+    "\"birthDate\":\"1974-12-25\",\"_birthDate\":{\"extension\":[]},\"deceasedBoolean\":false,"
+    "\"identifier\":[{\"use\":\"usual\",\"system\":\"urn:oid:1.2.36.146.595.217.0.1\"},"
+    "{\"use\":\"official\",\"system\":\"urn:oid:1.2.36.146.595.217.0.1\"},\"not an object\"]}";
+
+static bool points_into(const void* pointer, const void* data, size_t length) {
+    const char* p = pointer;
+    const char* start = data;
+    return p >= start && p < start + length;
+}
+
+/* ========================================================================== */
+/* Resource Codec Tests                                                       */
+/* ========================================================================== */
+
+bool test_binary_patient_round_trip(void) {
+    FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+
+    size_t length;
+    uint8_t* data = fhir_resource_to_binary(&patient->base, &length);
+    ASSERT_NOT_NULL(data);
+    ASSERT_TRUE(length < strlen(PATIENT_JSON) * 2 / 3);
+
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_binary_open(&document, data, length));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_PATIENT, document.resource_type);
+    ASSERT_FALSE(document.flags & FHIR_BINARY_FLAG_JSON);
+    ASSERT_STR_EQ("example", fhir_binary_get_id(&document));
+    ASSERT_EQ(length, document.size);
+
+    FHIRPatient* loaded = (FHIRPatient*)fhir_resource_from_binary(data, length);
+    ASSERT_NOT_NULL(loaded);
+    ASSERT_STR_EQ("example", loaded->base.id);
+    ASSERT_TRUE(loaded->active && loaded->active->value);
+    ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, loaded->gender);
+    ASSERT_STR_EQ("1974-12-25", loaded->birth_date->value);
+    ASSERT_TRUE(loaded->deceased_boolean && !loaded->deceased_boolean->value);
+    ASSERT_EQ(3, loaded->identifier_count);
+    ASSERT_STR_EQ("official", loaded->identifier[1]->use);
+    ASSERT_TRUE(loaded->identifier[0]->system == loaded->identifier[1]->system);
+    ASSERT_NULL(loaded->identifier[2]);
+    ASSERT_EQ(1, loaded->base.unknown_member_count);
+    ASSERT_STR_EQ("_birthDate", loaded->base.unknown_members[0]);
+
+    // Decoded resources own their strings
+    fhir_free(data);
+    cJSON* expected = fhir_resource_to_json(&patient->base);
+    cJSON* actual = fhir_resource_to_json(&loaded->base);
+    ASSERT_TRUE(cJSON_Compare(expected, actual, true));
+    cJSON_Delete(expected);
+    cJSON_Delete(actual);
+
+    fhir_resource_release(&patient->base);
+    fhir_resource_release(&loaded->base);
+    return true;
+}
+
+bool test_binary_json_encoding(void) {
+    const char* text =
+        "{\"resourceType\":\"Basic\",\"id\":\"b1\",\"code\":{\"coding\":[{\"system\":\"s\",\"code\":\"c\"},"
+        "{\"system\":\"s\",\"code\":\"c\"}]},\"n\":[1.5,-2,1e300,null,true,false],\"text\":\"caf\\u00e9\","
+        "\"empty\":{},\"list\":[]}";
+    cJSON* json = cJSON_Parse(text);
+    ASSERT_NOT_NULL(json);
+
+    FHIRBinaryWriter writer;
+    ASSERT_TRUE(fhir_binary_writer_init(&writer, FHIR_RESOURCE_TYPE_BASIC, "b1"));
+    writer.flags |= FHIR_BINARY_FLAG_JSON;
+    ASSERT_TRUE(fhir_binary_write_json_members(&writer, json));
+    size_t length;
+    uint8_t* data = fhir_binary_writer_finish(&writer, &length);
+    ASSERT_NOT_NULL(data);
+
+    // Repeated strings are stored once ("b1" is shared by the header and the id member)
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_binary_open(&document, data, length));
+    ASSERT_EQ(14, document.string_count);
+    ASSERT_EQ(writer.string_count, document.string_count);
+    fhir_binary_writer_cleanup(&writer);
+
+    cJSON* decoded = fhir_binary_to_json(&document);
+    ASSERT_NOT_NULL(decoded);
+    ASSERT_TRUE(cJSON_Compare(json, decoded, true));
+    cJSON_Delete(decoded);
+
+    // In-place reads: strings point into the buffer
+    FHIRBinaryReader reader;
+    fhir_binary_reader_init(&reader, &document);
+    ASSERT_TRUE(fhir_binary_reader_next(&reader));
+    ASSERT_EQ(FHIR_BINARY_JSON_KEY, reader.field);
+    ASSERT_STR_EQ("resourceType", reader.string_value);
+    ASSERT_TRUE(points_into(reader.string_value, data, length));
+    ASSERT_TRUE(fhir_binary_reader_find(&reader, FHIR_BINARY_JSON_OBJECT));
+    FHIRBinaryReader child;
+    fhir_binary_reader_enter(&reader, &child);
+    ASSERT_TRUE(fhir_binary_reader_next(&child));
+    ASSERT_STR_EQ("coding", child.string_value);
+    ASSERT_TRUE(fhir_binary_reader_find(&reader, FHIR_BINARY_JSON_ARRAY));
+    fhir_binary_reader_enter(&reader, &child);
+    ASSERT_TRUE(fhir_binary_reader_next(&child));
+    ASSERT_FLOAT_EQ(1.5, child.double_value, 1e-12);
+
+    // Skipping every field reaches the end cleanly
+    while (fhir_binary_reader_next(&reader)) {}
+    ASSERT_FALSE(reader.failed);
+
+    cJSON_Delete(json);
+    fhir_free(data);
+    return true;
+}
+
+/* ========================================================================== */
+/* Malformed Input Tests                                                      */
+/* ========================================================================== */
+
+bool test_binary_rejects_malformed_input(void) {
+    FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    size_t length;
+    uint8_t* data = fhir_resource_to_binary(&patient->base, &length);
+    ASSERT_NOT_NULL(data);
+    fhir_resource_release(&patient->base);
+
+    // Every truncation fails without reading past the end
+    for (size_t cut = 0; cut < length; cut++) {
+        uint8_t* copy = malloc(cut ? cut : 1);
+        memcpy(copy, data, cut);
+        FHIRResourceBase* resource = fhir_resource_from_binary(copy, cut);
+        ASSERT_NULL(resource);
+        free(copy);
+    }
+
+    uint8_t* copy = malloc(length);
+    memcpy(copy, data, length);
+    copy[4] = FHIR_BINARY_VERSION + 1;
+    ASSERT_NULL(fhir_resource_from_binary(copy, length));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+
+    // Corrupt body bytes decode or fail, but never crash
+    for (size_t i = length - 1; i >= length - 24 && i > FHIR_BINARY_HEADER_SIZE; i--) {
+        memcpy(copy, data, length);
+        copy[i] ^= 0xff;
+        FHIRResourceBase* resource = fhir_resource_from_binary(copy, length);
+        if (resource) {
+            fhir_resource_release(resource);
+        }
+    }
+    free(copy);
+
+    FHIRBinaryWriter writer;
+    ASSERT_TRUE(fhir_binary_writer_init(&writer, FHIR_RESOURCE_TYPE_PATIENT, "x"));
+    fhir_binary_begin_message(&writer, 1);
+    ASSERT_NULL(fhir_binary_writer_finish(&writer, &length));
+    fhir_binary_writer_cleanup(&writer);
+
+    fhir_free(data);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_binary_patient_round_trip);
+    RUN_TEST(test_binary_json_encoding);
+    RUN_TEST(test_binary_rejects_malformed_input);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,434 @@
+/**
+ * @file test_bundle_parallel.c
+ * @brief Unit tests for parallel Bundle entry deserialization
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_bundle_parallel.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char* g_bundle =
+    "{\"resourceType\":\"Bundle\",\"type\":\"transaction\",\"entry\":["
+    "{\"fullUrl\":\"urn:uuid:1\",\"resource\":{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true}},"
+    "{\"fullUrl\":\"urn:uuid:2\",\"resource\":{\"resourceType\":\"Observation\",\"id\":\"o1\"}},"
+    "{\"request\":{\"method\":\"DELETE\",\"url\":\"Patient/old\"}},"
+    "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"bad id\"}},"
+    "{\"resource\":{\"id\":\"no-type\"}},"
+    "{\"fullUrl\":\"urn:uuid:3\",\"resource\":{\"resourceType\":\"Patient\",\"id\":\"p2\",\"gender\":\"female\"}}"
+    "]}";
+
+static void register_types(void) {
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+}
+
+/* ========================================================================== */
+/* Entry Results Tests                                                        */
+/* ========================================================================== */
+
+static bool check_entries(size_t thread_count) {
+    cJSON* json = cJSON_Parse(g_bundle);
+    ASSERT_NOT_NULL(json);
+
+    FHIRParallelBundle* bundle = fhir_parse_bundle_parallel(json, thread_count);
+    ASSERT_NOT_NULL(bundle);
+    ASSERT_EQ(6, bundle->entry_count);
+    ASSERT_EQ(2, bundle->error_count);
+    ASSERT_TRUE(bundle->thread_count >= 1);
+
+    FHIRBundleEntryResult* entries = bundle->entries;
+    ASSERT_STR_EQ("urn:uuid:1", entries[0].full_url);
+    ASSERT_NOT_NULL(entries[0].resource);
+    ASSERT_STR_EQ("p1", entries[0].resource->id);
+
+    // Observation has no registered parser
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_OBSERVATION, entries[1].resource_type);
+    ASSERT_NULL(entries[1].resource);
+    ASSERT_NOT_NULL(entries[1].json);
+    ASSERT_EQ(FHIR_ERROR_NONE, entries[1].error_code);
+
+    // DELETE entry without a resource
+    ASSERT_NULL(entries[2].json);
+    ASSERT_NULL(entries[2].full_url);
+    ASSERT_EQ(FHIR_ERROR_NONE, entries[2].error_code);
+
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, entries[3].error_code);
+    ASSERT_TRUE(strlen(entries[3].error_message) > 0);
+    ASSERT_NULL(entries[3].resource);
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, entries[4].error_code);
+
+    ASSERT_STR_EQ("p2", entries[5].resource->id);
+
+    fhir_parallel_bundle_free(bundle);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_bundle_parallel_single_thread(void) {
+    register_types();
+    return check_entries(1);
+}
+
+bool test_bundle_parallel_worker_pool(void) {
+    register_types();
+    return check_entries(4) && check_entries(0);
+}
+
+bool test_bundle_parallel_order(void) {
+    register_types();
+
+    const size_t count = 5000;
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "resourceType", "Bundle");
+    cJSON* entry_array = cJSON_AddArrayToObject(json, "entry");
+    char id[32];
+    for (size_t i = 0; i < count; i++) {
+        cJSON* entry = cJSON_CreateObject();
+        cJSON* resource = cJSON_AddObjectToObject(entry, "resource");
+        snprintf(id, sizeof(id), "p%zu", i);
+        cJSON_AddStringToObject(resource, "resourceType", "Patient");
+        cJSON_AddStringToObject(resource, "id", id);
+        cJSON_AddItemToArray(entry_array, entry);
+    }
+
+    // Uneven splits force workers to steal from each other
+    size_t thread_counts[] = {1, 3, 7, 64};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        FHIRParallelBundle* bundle = fhir_parse_bundle_parallel(json, thread_counts[t]);
+        ASSERT_NOT_NULL(bundle);
+        ASSERT_EQ(count, bundle->entry_count);
+        ASSERT_EQ(0, bundle->error_count);
+        for (size_t i = 0; i < count; i++) {
+            snprintf(id, sizeof(id), "p%zu", i);
+            ASSERT_NOT_NULL(bundle->entries[i].resource);
+            ASSERT_STR_EQ(id, bundle->entries[i].resource->id);
+        }
+        fhir_parallel_bundle_free(bundle);
+    }
+
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_bundle_parallel_invalid(void) {
+    ASSERT_NULL(fhir_parse_bundle_parallel(NULL, 2));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+
+    cJSON* json = cJSON_Parse("{\"resourceType\":\"Patient\",\"id\":\"p1\"}");
+    ASSERT_NULL(fhir_parse_bundle_parallel(json, 2));
+    cJSON_Delete(json);
+
+    // A Bundle without entries is valid
+    json = cJSON_Parse("{\"resourceType\":\"Bundle\",\"type\":\"batch\"}");
+    FHIRParallelBundle* bundle = fhir_parse_bundle_parallel(json, 4);
+    ASSERT_NOT_NULL(bundle);
+    ASSERT_EQ(0, bundle->entry_count);
+    ASSERT_EQ(1, bundle->thread_count);
+    fhir_parallel_bundle_free(bundle);
+    cJSON_Delete(json);
+    return true;
+}
+
+/* ========================================================================== */
+/* Batch Validation Tests                                                     */
+/* ========================================================================== */
+
+bool test_validate_resources_parallel(void) {
+    enum { COUNT = 1000 };
+    FHIRPatient* patients[COUNT];
+    FHIRResourceBase* resources[COUNT + 1];
+    bool results[COUNT + 1];
+
+    // Every seventh Patient breaks the deceased choice rule
+    for (size_t i = 0; i < COUNT; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "p%zu", i);
+        patients[i] = fhir_patient_create(id);
+        ASSERT_NOT_NULL(patients[i]);
+        if (i % 7 == 0) {
+            patients[i]->deceased_boolean = fhir_calloc(1, sizeof(FHIRBoolean));
+            patients[i]->deceased_date_time = fhir_calloc(1, sizeof(FHIRDateTime));
+        }
+        resources[i] = &patients[i]->base;
+    }
+    resources[COUNT] = NULL;
+
+    size_t broken = (COUNT + 6) / 7;
+    ASSERT_EQ(broken + 1, fhir_validate_resources_parallel(resources, COUNT + 1, 4, results));
+    for (size_t i = 0; i < COUNT; i++) {
+        ASSERT_EQ(i % 7 != 0, results[i]);
+    }
+    ASSERT_FALSE(results[COUNT]);
+
+    // Fixing one field reruns only the rule reading it
+    fhir_free(patients[0]->deceased_date_time);
+    patients[0]->deceased_date_time = NULL;
+    fhir_resource_mark_dirty(resources[0], FHIR_PATIENT_DIRTY_DECEASED);
+    ASSERT_EQ(broken - 1, fhir_validate_resources_parallel(resources, COUNT, 0, results));
+    ASSERT_TRUE(results[0]);
+
+    for (size_t i = 0; i < COUNT; i++) {
+        fhir_patient_destroy(patients[i]);
+    }
+    ASSERT_EQ(0, fhir_validate_resources_parallel(NULL, 0, 2, NULL));
+    return true;
+}
+
+/* ========================================================================== */
+/* Transaction Scheduling Tests                                               */
+/* ========================================================================== */
+
+typedef struct {
+    FHIRAtomicInt sequence;       // Order in which callbacks started
+    FHIRAtomicInt in_flight;
+    FHIRAtomicInt max_in_flight;
+    int started[16];              // Sequence number per entry, -1 if never called
+    const char* fail_id;          // Resource id whose entry fails
+    useconds_t delay;
+} TransactionLog;
+
+static void transaction_log_init(TransactionLog* log) {
+    memset(log, 0, sizeof(*log));
+    fhir_atomic_init(&log->sequence, 0);
+    fhir_atomic_init(&log->in_flight, 0);
+    fhir_atomic_init(&log->max_in_flight, 0);
+    for (size_t i = 0; i < 16; i++) log->started[i] = -1;
+}
+
+static bool record_entry(FHIRTransactionEntryResult* entry, size_t index, void* context) {
+    TransactionLog* log = context;
+    log->started[index] = fhir_atomic_fetch_add_relaxed(&log->sequence, 1);
+
+    int in_flight = fhir_atomic_fetch_add_relaxed(&log->in_flight, 1) + 1;
+    int max = fhir_atomic_load(&log->max_in_flight);
+    while (in_flight > max && !fhir_atomic_compare_exchange(&log->max_in_flight, &max, in_flight)) {
+    }
+    if (log->delay) usleep(log->delay);
+    fhir_atomic_fetch_add_relaxed(&log->in_flight, -1);
+
+    const char* id = entry->resource ? fhir_json_get_string(entry->resource, "id") : NULL;
+    if (log->fail_id && id && strcmp(id, log->fail_id) == 0) {
+        FHIR_SET_ERROR(FHIR_ERROR_VALIDATION_FAILED, "Rejected by server");
+        return false;
+    }
+
+    char location[64];
+    const char* type = entry->resource ? fhir_json_get_string(entry->resource, "resourceType") : "Patient";
+    snprintf(location, sizeof(location), "%s/s%zu/_history/1", type, index);
+    entry->status = strcmp(entry->method, "POST") == 0 ? 201 : 200;
+    return fhir_transaction_entry_set_location(entry, location);
+}
+
+// Results borrow from the Bundle tree, so the caller frees *json after them
+static FHIRTransactionResult* run_transaction_json(const char* text, size_t thread_count, TransactionLog* log,
+                                                   cJSON** json) {
+    *json = cJSON_Parse(text);
+    return *json ? fhir_process_transaction(*json, thread_count, record_entry, log) : NULL;
+}
+
+bool test_transaction_rewrites(void) {
+    static const char* bundle =
+        "{\"resourceType\":\"Bundle\",\"type\":\"transaction\",\"entry\":["
+        "{\"fullUrl\":\"urn:uuid:o1\",\"resource\":{\"resourceType\":\"Observation\",\"id\":\"o1\","
+        "\"subject\":{\"reference\":\"urn:uuid:p1\"},\"performer\":[{\"reference\":\"Practitioner/x\"}]},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Observation\"}},"
+        "{\"fullUrl\":\"urn:uuid:p1\",\"resource\":{\"resourceType\":\"Patient\",\"id\":\"p1\"},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Patient\"}},"
+        "{\"request\":{\"method\":\"GET\",\"url\":\"Observation?subject=urn:uuid:p1\"}}"
+        "]}";
+
+    TransactionLog log;
+    cJSON* json;
+    transaction_log_init(&log);
+    FHIRTransactionResult* result = run_transaction_json(bundle, 4, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(3, result->entry_count);
+    ASSERT_TRUE(result->atomic);
+    ASSERT_EQ(0, result->failed_count);
+    ASSERT_EQ(1, result->rewrite_count);
+
+    // The Observation waits for the Patient it references, the search for the Observation
+    ASSERT_TRUE(log.started[1] < log.started[0]);
+    ASSERT_TRUE(log.started[0] < log.started[2]);
+
+    FHIRTransactionEntryResult* observation = &result->entries[0];
+    ASSERT_EQ(FHIR_TRANSACTION_ENTRY_DONE, observation->state);
+    ASSERT_EQ(201, observation->status);
+    ASSERT_STR_EQ("Observation/s0/_history/1", observation->location);
+    ASSERT_NOT_NULL(observation->rewritten);
+    ASSERT_EQ(1, observation->rewrite_count);
+    ASSERT_EQ(1, observation->rewrites[0].target_entry);
+    ASSERT_STR_EQ("Patient/s1", observation->rewrites[0].target);
+    const cJSON* subject = cJSON_GetObjectItemCaseSensitive(observation->resource, "subject");
+    ASSERT_STR_EQ("Patient/s1", fhir_json_get_string(subject, "reference"));
+
+    // References to nothing in the Bundle are left alone and copied unchanged
+    const cJSON* performer = cJSON_GetArrayItem(cJSON_GetObjectItemCaseSensitive(observation->resource, "performer"), 0);
+    ASSERT_STR_EQ("Practitioner/x", fhir_json_get_string(performer, "reference"));
+    ASSERT_NULL(result->entries[1].rewritten);
+
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_transaction_method_order(void) {
+    // Listed against the processing order: GET, PUT, conditional POST, DELETE
+    static const char* bundle =
+        "{\"resourceType\":\"Bundle\",\"type\":\"transaction\",\"entry\":["
+        "{\"request\":{\"method\":\"GET\",\"url\":\"Patient/1\"}},"
+        "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"1\"},\"request\":{\"method\":\"PUT\",\"url\":\"Patient/1\"}},"
+        "{\"resource\":{\"resourceType\":\"Patient\"},\"request\":{\"method\":\"POST\",\"url\":\"Patient\","
+        "\"ifNoneExist\":\"identifier=x\"}},"
+        "{\"request\":{\"method\":\"DELETE\",\"url\":\"Patient/1\"}},"
+        "{\"request\":{\"method\":\"GET\",\"url\":\"Observation/9\"}}"
+        "]}";
+
+    TransactionLog log;
+    cJSON* json;
+    transaction_log_init(&log);
+    FHIRTransactionResult* result = run_transaction_json(bundle, 4, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(0, result->failed_count + result->skipped_count);
+    ASSERT_TRUE(log.started[3] < log.started[2]);
+    ASSERT_TRUE(log.started[2] < log.started[1]);
+    ASSERT_TRUE(log.started[1] < log.started[0]);
+    ASSERT_TRUE(log.started[4] >= 0);
+    for (size_t i = 0; i < result->entry_count; i++) {
+        ASSERT_EQ(FHIR_TRANSACTION_ENTRY_DONE, result->entries[i].state);
+    }
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_transaction_concurrency(void) {
+    // Unconditional creates are independent of each other
+    char bundle[2048];
+    size_t length = (size_t)snprintf(bundle, sizeof(bundle), "{\"resourceType\":\"Bundle\",\"type\":\"batch\",\"entry\":[");
+    for (int i = 0; i < 8; i++) {
+        length += (size_t)snprintf(bundle + length, sizeof(bundle) - length,
+                                   "%s{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"c%d\"},"
+                                   "\"request\":{\"method\":\"POST\",\"url\":\"Patient\"}}",
+                                   i ? "," : "", i);
+    }
+    snprintf(bundle + length, sizeof(bundle) - length, "]}");
+
+    TransactionLog log;
+    cJSON* json;
+    transaction_log_init(&log);
+    log.delay = 20000;
+    FHIRTransactionResult* result = run_transaction_json(bundle, 4, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(4, result->thread_count);
+    ASSERT_FALSE(result->atomic);
+    ASSERT_EQ(0, result->failed_count);
+    ASSERT_TRUE(fhir_atomic_load(&log.max_in_flight) > 1);
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_transaction_failures(void) {
+    static const char* entries =
+        "\"entry\":["
+        "{\"fullUrl\":\"urn:uuid:a\",\"resource\":{\"resourceType\":\"Patient\",\"id\":\"bad\"},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Patient\"}},"
+        "{\"resource\":{\"resourceType\":\"Observation\",\"subject\":{\"reference\":\"urn:uuid:a\"}},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Observation\"}},"
+        "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"ok\"},\"request\":{\"method\":\"PUT\",\"url\":\"Patient/ok\"}},"
+        "{\"resource\":{\"resourceType\":\"Patient\"}}"
+        "]}";
+    char bundle[1024];
+
+    // A batch skips only what depends on the failure
+    snprintf(bundle, sizeof(bundle), "{\"resourceType\":\"Bundle\",\"type\":\"batch\",%s", entries);
+    TransactionLog log;
+    cJSON* json;
+    transaction_log_init(&log);
+    log.fail_id = "bad";
+    FHIRTransactionResult* result = run_transaction_json(bundle, 1, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(FHIR_TRANSACTION_ENTRY_FAILED, result->entries[0].state);
+    ASSERT_STR_EQ("Rejected by server", result->entries[0].error_message);
+    ASSERT_EQ(FHIR_TRANSACTION_ENTRY_SKIPPED, result->entries[1].state);
+    ASSERT_EQ(-1, log.started[1]);
+    ASSERT_EQ(FHIR_TRANSACTION_ENTRY_DONE, result->entries[2].state);
+    ASSERT_EQ(FHIR_TRANSACTION_ENTRY_FAILED, result->entries[3].state);
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, result->entries[3].error_code);
+    ASSERT_EQ(-1, log.started[3]);
+    ASSERT_EQ(2, result->failed_count);
+    ASSERT_EQ(1, result->skipped_count);
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+
+    // A transaction with an invalid request runs nothing
+    snprintf(bundle, sizeof(bundle), "{\"resourceType\":\"Bundle\",\"type\":\"transaction\",%s", entries);
+    transaction_log_init(&log);
+    result = run_transaction_json(bundle, 2, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(0, fhir_atomic_load(&log.sequence));
+    ASSERT_EQ(1, result->failed_count);
+    ASSERT_EQ(3, result->skipped_count);
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_transaction_invalid(void) {
+    static const char* cycle =
+        "{\"resourceType\":\"Bundle\",\"type\":\"transaction\",\"entry\":["
+        "{\"fullUrl\":\"urn:uuid:a\",\"resource\":{\"resourceType\":\"Patient\",\"link\":[{\"other\":{\"reference\":\"urn:uuid:b\"}}]},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Patient\"}},"
+        "{\"fullUrl\":\"urn:uuid:b\",\"resource\":{\"resourceType\":\"Patient\",\"link\":[{\"other\":{\"reference\":\"urn:uuid:a\"}}]},"
+        "\"request\":{\"method\":\"POST\",\"url\":\"Patient\"}}"
+        "]}";
+
+    TransactionLog log;
+    cJSON* json;
+    transaction_log_init(&log);
+    ASSERT_NULL(run_transaction_json(cycle, 2, &log, &json));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    ASSERT_EQ(0, fhir_atomic_load(&log.sequence));
+    cJSON_Delete(json);
+
+    ASSERT_NULL(run_transaction_json("{\"resourceType\":\"Bundle\",\"type\":\"collection\"}", 2, &log, &json));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    cJSON_Delete(json);
+    ASSERT_NULL(run_transaction_json("{\"resourceType\":\"Patient\"}", 2, &log, &json));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    cJSON_Delete(json);
+
+    // An empty batch succeeds trivially
+    FHIRTransactionResult* result = run_transaction_json("{\"resourceType\":\"Bundle\",\"type\":\"batch\"}", 0, &log, &json);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(0, result->entry_count);
+    fhir_transaction_result_free(result);
+    cJSON_Delete(json);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_bundle_parallel_single_thread);
+    RUN_TEST(test_bundle_parallel_worker_pool);
+    RUN_TEST(test_bundle_parallel_order);
+    RUN_TEST(test_bundle_parallel_invalid);
+    RUN_TEST(test_validate_resources_parallel);
+    RUN_TEST(test_transaction_rewrites);
+    RUN_TEST(test_transaction_method_order);
+    RUN_TEST(test_transaction_concurrency);
+    RUN_TEST(test_transaction_failures);
+    RUN_TEST(test_transaction_invalid);
+
+    TEST_FINALIZE();
+    return 0;
+}
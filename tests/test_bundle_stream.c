@@ -0,0 +1,202 @@
+/**
+ * @file test_bundle_stream.c
+ * @brief Unit tests for the incremental Bundle entry tokenizer
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_bundle_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Strings with brackets and escapes, an entry without a resource and members around the entry array
+static const char* BUNDLE_JSON =
+    "{\"resourceType\":\"Bundle\",\"type\":\"collection\",\"total\":3,\"meta\":{\"tag\":[{\"code\":\"x\"}]},"
+    "\"entry\":[ {\"fullUrl\":\"urn:uuid:1\",\"resource\":{\"resourceType\":\"Patient\",\"id\":\"a\","
+    "\"name\":[{\"text\":\"O\\\"Brien {]\"}],\"active\":true}},"
+    "{\"request\":{\"method\":\"DELETE\",\"url\":\"Patient/gone\"}},\n"
+    "{\"resource\":{\"resourceType\":\"Observation\",\"id\":\"b\",\"valueQuantity\":{\"value\":-1.5e3}},"
+    "\"search\":{\"score\":0.5}},"
+    "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"\\u00e9\"}}],\"signature\":null}";
+
+// Its entry resources, one per line
+static const char* BUNDLE_RESOURCES =
+    "{\"resourceType\":\"Patient\",\"id\":\"a\",\"name\":[{\"text\":\"O\\\"Brien {]\"}],\"active\":true}\n"
+    "{\"resourceType\":\"Observation\",\"id\":\"b\",\"valueQuantity\":{\"value\":-1.5e3}}\n"
+    "{\"resourceType\":\"Patient\",\"id\":\"\\u00e9\"}\n";
+
+// Entry texts of a stream joined by '\n'; returns the final result
+static FHIRBundleStreamResult collect(FHIRBundleStream* stream, char* out, size_t size) {
+    for (;;) {
+        const char* json;
+        size_t length;
+        FHIRBundleStreamResult result = fhir_bundle_stream_next(stream, &json, &length);
+        if (result != FHIR_BUNDLE_STREAM_ENTRY) return result;
+        size_t used = strlen(out);
+        if (used + length + 2 > size) return FHIR_BUNDLE_STREAM_ERROR;
+        memcpy(out + used, json, length);
+        out[used + length] = '\n';
+        out[used + length + 1] = '\0';
+    }
+}
+
+/* ========================================================================== */
+/* Buffer Mode Tests                                                          */
+/* ========================================================================== */
+
+bool test_bundle_stream_buffer_members_after_resource(void) {
+    // The slice ends at the resource's closing brace, not at the end of its entry
+    const char* bundle =
+        "{\"resourceType\":\"Bundle\",\"entry\":["
+        "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"a\"},\"fullUrl\":\"urn:x\","
+        "\"request\":{\"method\":\"PUT\",\"url\":\"Patient/a\"}},"
+        "{\"resource\":{\"resourceType\":\"Patient\",\"id\":\"b\",\"name\":[{\"family\":\"}\"}]} ,"
+        "\"search\":{\"mode\":\"match\"}}]}";
+    FHIRBundleStream* stream = fhir_bundle_stream_create_from_buffer(bundle, strlen(bundle));
+    ASSERT_NOT_NULL(stream);
+
+    const char* json;
+    size_t length;
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ENTRY, fhir_bundle_stream_next(stream, &json, &length));
+    ASSERT_EQ(strlen("{\"resourceType\":\"Patient\",\"id\":\"a\"}"), length);
+    ASSERT_TRUE(memcmp("{\"resourceType\":\"Patient\",\"id\":\"a\"}", json, length) == 0);
+
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ENTRY, fhir_bundle_stream_next(stream, &json, &length));
+    const char* second = "{\"resourceType\":\"Patient\",\"id\":\"b\",\"name\":[{\"family\":\"}\"}]}";
+    ASSERT_EQ(strlen(second), length);
+    ASSERT_TRUE(memcmp(second, json, length) == 0);
+
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_END, fhir_bundle_stream_next(stream, &json, &length));
+    fhir_bundle_stream_destroy(stream);
+    return true;
+}
+
+/* ========================================================================== */
+/* Push Mode Tests                                                            */
+/* ========================================================================== */
+
+bool test_bundle_stream_push_matches_buffer(void) {
+    size_t length = strlen(BUNDLE_JSON);
+    char expected[1024] = "";
+    FHIRBundleStream* buffered = fhir_bundle_stream_create_from_buffer(BUNDLE_JSON, length);
+    ASSERT_NOT_NULL(buffered);
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_END, collect(buffered, expected, sizeof(expected)));
+    fhir_bundle_stream_destroy(buffered);
+    ASSERT_STR_EQ(BUNDLE_RESOURCES, expected);
+
+    // Every chunk size, so every byte of the Bundle is a split point at least once
+    for (size_t chunk = 1; chunk <= length; chunk++) {
+        FHIRBundleStream* stream = fhir_bundle_stream_create_push();
+        ASSERT_NOT_NULL(stream);
+        char actual[1024] = "";
+        for (size_t offset = 0; offset < length; offset += chunk) {
+            size_t count = length - offset < chunk ? length - offset : chunk;
+            ASSERT_TRUE(fhir_bundle_stream_feed(stream, BUNDLE_JSON + offset, count));
+            FHIRBundleStreamResult result = collect(stream, actual, sizeof(actual));
+            ASSERT_TRUE(result == FHIR_BUNDLE_STREAM_NEED_MORE || result == FHIR_BUNDLE_STREAM_END);
+        }
+        fhir_bundle_stream_finish(stream);
+        ASSERT_EQ(FHIR_BUNDLE_STREAM_END, collect(stream, actual, sizeof(actual)));
+        ASSERT_STR_EQ(expected, actual);
+        ASSERT_EQ(length - strlen(",\"signature\":null}"), fhir_bundle_stream_get_offset(stream));
+        fhir_bundle_stream_destroy(stream);
+    }
+    return true;
+}
+
+bool test_bundle_stream_push_errors(void) {
+    const char* json;
+    size_t length;
+
+    // Cut short: waits for more until finished, then fails
+    FHIRBundleStream* stream = fhir_bundle_stream_create_push();
+    ASSERT_NOT_NULL(stream);
+    const char* partial = "{\"resourceType\":\"Bundle\",\"entry\":[{\"resource\":{\"id\":\"a\"";
+    ASSERT_TRUE(fhir_bundle_stream_feed(stream, partial, strlen(partial)));
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_NEED_MORE, fhir_bundle_stream_next(stream, &json, &length));
+    ASSERT_NULL(fhir_bundle_stream_get_error(stream));
+    fhir_bundle_stream_finish(stream);
+    ASSERT_FALSE(fhir_bundle_stream_feed(stream, "}", 1));
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ERROR, fhir_bundle_stream_next(stream, &json, &length));
+    ASSERT_NOT_NULL(fhir_bundle_stream_get_error(stream));
+    fhir_bundle_stream_destroy(stream);
+
+    // Bad structure is reported as soon as it arrives, before the input ends
+    stream = fhir_bundle_stream_create_push();
+    const char* invalid = "{\"resourceType\":\"Bundle\",\"entry\":[{\"resource\":{}} {";
+    ASSERT_TRUE(fhir_bundle_stream_feed(stream, invalid, strlen(invalid)));
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ENTRY, fhir_bundle_stream_next(stream, &json, &length));
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ERROR, fhir_bundle_stream_next(stream, &json, &length));
+    ASSERT_STR_EQ("Expected ',' or ']' in Bundle entry array", fhir_bundle_stream_get_error(stream));
+    fhir_bundle_stream_destroy(stream);
+
+    stream = fhir_bundle_stream_create_push();
+    ASSERT_TRUE(fhir_bundle_stream_feed(stream, "{\"resourceType\":\"Patient\"", 25));
+    ASSERT_EQ(FHIR_BUNDLE_STREAM_ERROR, fhir_bundle_stream_next(stream, &json, &length));
+    fhir_bundle_stream_destroy(stream);
+
+    // Push input is only accepted by push streams
+    stream = fhir_bundle_stream_create_from_buffer(BUNDLE_JSON, strlen(BUNDLE_JSON));
+    ASSERT_FALSE(fhir_bundle_stream_feed(stream, "{", 1));
+    fhir_bundle_stream_destroy(stream);
+    return true;
+}
+
+bool test_bundle_stream_push_large_entry(void) {
+    // One large entry trickled in small chunks, then a small one
+    enum { ITEMS = 20000 };
+    size_t capacity = ITEMS * 16 + 256;
+    char* bundle = malloc(capacity);
+    ASSERT_NOT_NULL(bundle);
+    size_t length = (size_t)snprintf(bundle, capacity, "{\"resourceType\":\"Bundle\",\"entry\":[{\"resource\":{\"v\":[");
+    for (int i = 0; i < ITEMS; i++) {
+        length += (size_t)snprintf(bundle + length, capacity - length, "%s\"%d\"", i ? "," : "", i);
+    }
+    length += (size_t)snprintf(bundle + length, capacity - length, "]}},{\"resource\":{\"id\":\"z\"}}]}");
+    size_t large = length - strlen("}},{\"resource\":{\"id\":\"z\"}}]}") + 1 - strlen("{\"resourceType\":\"Bundle\",\"entry\":[{\"resource\":");
+
+    FHIRBundleStream* stream = fhir_bundle_stream_create_push();
+    ASSERT_NOT_NULL(stream);
+    size_t entries = 0;
+    for (size_t offset = 0; offset < length; offset += 7) {
+        size_t count = length - offset < 7 ? length - offset : 7;
+        ASSERT_TRUE(fhir_bundle_stream_feed(stream, bundle + offset, count));
+
+        const char* json;
+        size_t entry_length;
+        FHIRBundleStreamResult result;
+        while ((result = fhir_bundle_stream_next(stream, &json, &entry_length)) == FHIR_BUNDLE_STREAM_ENTRY) {
+            size_t expected = entries == 0 ? large : strlen("{\"id\":\"z\"}");
+            ASSERT_EQ(expected, entry_length);
+            entries++;
+        }
+        ASSERT_TRUE(result == FHIR_BUNDLE_STREAM_NEED_MORE || result == FHIR_BUNDLE_STREAM_END);
+    }
+    fhir_bundle_stream_finish(stream);
+    const char* json;
+    size_t entry_length;
+    while (fhir_bundle_stream_next(stream, &json, &entry_length) == FHIR_BUNDLE_STREAM_ENTRY) {
+        size_t expected = entries == 0 ? large : strlen("{\"id\":\"z\"}");
+        ASSERT_EQ(expected, entry_length);
+        entries++;
+    }
+    ASSERT_EQ(2, entries);
+
+    fhir_bundle_stream_destroy(stream);
+    free(bundle);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_bundle_stream_buffer_members_after_resource);
+    RUN_TEST(test_bundle_stream_push_matches_buffer);
+    RUN_TEST(test_bundle_stream_push_errors);
+    RUN_TEST(test_bundle_stream_push_large_entry);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,84 @@
+"""Tests for streaming Bundle entries with C extensions."""
+
+import io
+import json
+import mmap
+import tempfile
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+from fast_fhir.resources.patient import Patient
+
+
+class TestBundleStream:
+    """Test cases for Bundle entry streaming."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_iter_bundle(self):
+        """Test streaming iteration over Bundle entries."""
+        bundle = {
+            "resourceType": "Bundle",
+            "id": "stream-bundle",
+            "type": "collection",
+            "entry": [
+                {"fullUrl": "urn:uuid:1", "resource": {"resourceType": "Patient", "id": "p1"}},
+                {"response": {"status": "200"}},
+                {"resource": {"resourceType": "Patient", "id": "p2", "active": True}}
+            ]
+        }
+        bundle_json = json.dumps(bundle)
+        
+        for source in (bundle_json, bundle_json.encode(), io.BytesIO(bundle_json.encode()),
+                       io.StringIO(bundle_json)):
+            resources = list(self.parser.iter_bundle(source))
+            assert [r.id for r in resources] == ["p1", "p2"]
+            assert all(isinstance(r, Patient) for r in resources)
+    
+    def test_iter_bundle_rejects_non_bundle(self):
+        """Test streaming iteration rejects non-Bundle input."""
+        with pytest.raises(ValueError):
+            list(self.parser.iter_bundle(json.dumps({"resourceType": "Patient", "entry": []})))
+    
+    def test_iter_bundle_entries_mmap(self):
+        """Test the C entry iterator over a memory-mapped file."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        
+        entries = [{"resource": {"resourceType": "Patient", "id": f"p{i}"}} for i in range(100)]
+        data = json.dumps({"resourceType": "Bundle", "entry": entries}).encode()
+        
+        with tempfile.TemporaryFile() as f:
+            f.write(data)
+            f.flush()
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                resources = list(fhir_parser_c.iter_bundle_entries(mapped))
+        
+        assert resources == [entry["resource"] for entry in entries]
+    
+    def test_parse_bundle_parallel(self):
+        """Test Bundle entries deserialized and validated on C worker threads."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        
+        entries = [{"fullUrl": f"urn:uuid:{i}",
+                    "resource": {"resourceType": "Patient", "id": f"p{i}", "active": True}}
+                   for i in range(200)]
+        entries.insert(7, {"resource": {"resourceType": "Patient", "id": "bad id"}})
+        entries.insert(9, {"request": {"method": "DELETE", "url": "Patient/old"}})
+        bundle = {"resourceType": "Bundle", "type": "batch", "entry": entries}
+        data = json.dumps(bundle)
+        
+        for threads in (1, 3, 0):
+            resources, errors = fhir_ndjson_c.parse_bundle(data, threads=threads)
+            assert [r["id"] for r in resources] == [f"p{i}" for i in range(200)]
+            assert [index for index, _ in errors] == [7]
+        
+        assert fhir_ndjson_c.parse_bundle(data.encode(), threads=2)[0] == resources
+        with pytest.raises(ValueError):
+            fhir_ndjson_c.parse_bundle('{"resourceType": "Patient", "id": "p1"}')
+        with pytest.raises(ValueError):
+            fhir_ndjson_c.parse_bundle("{not json")
+        
+        result = self.parser.parse_bundle(data, threads=2)
+        assert [r.id for r in result["entry"]] == [f"p{i}" for i in range(200)]
+        assert all(isinstance(r, Patient) for r in result["entry"])
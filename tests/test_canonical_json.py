@@ -0,0 +1,30 @@
+"""Tests for canonical JSON with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestCanonicalJSON:
+    """Test cases for canonical JSON serialization."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_canonical_json(self):
+        """Test canonical JSON with sorted members and normalized numbers."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        fhir_canonical_c = pytest.importorskip("fast_fhir.fhir_canonical_c")
+
+        data = {"resourceType": "Patient", "id": "p1", "gender": "female",
+                "name": [{"given": ["Jane"], "family": "Doe"}]}
+        patient = fhir_ndjson_c.parse_resource(json.dumps(data))
+        expected = json.dumps(data, sort_keys=True, separators=(",", ":"))
+        assert patient.to_json(canonical=True) == expected
+        assert fhir_canonical_c.canonical_json(json.dumps(data, indent=2)) == expected
+
+        assert fhir_canonical_c.canonical_json(b'{"b": [1.50, 2e0, 1e21, -0.0], "a": "\\u00e9"}') == \
+            '{"a":"é","b":[1.5,2,1e+21,0]}'
+        with pytest.raises(ValueError):
+            fhir_canonical_c.canonical_json("{not json")
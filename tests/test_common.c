@@ -7,6 +7,8 @@
 
 #include "test_framework.h"
 #include "../common/fhir_common.h"
+#include <pthread.h>
+#include <stdio.h>
 #include <string.h>
 
 /* ========================================================================== */
@@ -37,6 +39,62 @@ bool test_error_handling_basic(void) {
     return true;
 }
 
+bool test_error_truncation(void) {
+    char long_message[FHIR_ERROR_MESSAGE_MAX * 2];
+    memset(long_message, 'x', sizeof(long_message) - 1);
+    long_message[sizeof(long_message) - 1] = '\0';
+    
+    FHIR_SET_ERROR(FHIR_ERROR_PARSE_FAILED, long_message);
+    const FHIRError* error = fhir_get_last_error();
+    ASSERT_NOT_NULL(error);
+    ASSERT_EQ(FHIR_ERROR_MESSAGE_MAX - 1, strlen(error->message));
+    ASSERT_NULL(error->field);
+    
+    // Re-raising the current error from its own buffer keeps the text
+    FHIR_SET_FIELD_ERROR(FHIR_ERROR_VALIDATION_FAILED, error->message, "id");
+    ASSERT_EQ(FHIR_ERROR_MESSAGE_MAX - 1, strlen(fhir_get_last_error()->message));
+    ASSERT_STR_EQ("id", fhir_get_last_error()->field);
+    
+    fhir_clear_error();
+    return true;
+}
+
+static void* set_error_on_thread(void* arg) {
+    const char* message = (const char*)arg;
+    for (int i = 0; i < 1000; i++) {
+        FHIR_SET_FIELD_ERROR(FHIR_ERROR_INVALID_ARGUMENT, message, message);
+        const FHIRError* error = fhir_get_last_error();
+        if (!error || strcmp(error->message, message) != 0 || strcmp(error->field, message) != 0) {
+            return (void*)1;
+        }
+        fhir_clear_error();
+    }
+    return NULL;
+}
+
+bool test_error_thread_local(void) {
+    FHIR_SET_ERROR(FHIR_ERROR_INVALID_JSON, "main thread");
+    
+    pthread_t threads[4];
+    const char* messages[4] = {"thread 0", "thread 1", "thread 2", "thread 3"};
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, set_error_on_thread, (void*)messages[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        void* result;
+        pthread_join(threads[i], &result);
+        ASSERT_NULL(result);
+    }
+    
+    // Other threads never see or clear this thread's error
+    ASSERT_NOT_NULL(fhir_get_last_error());
+    ASSERT_EQ(FHIR_ERROR_INVALID_JSON, fhir_get_last_error()->code);
+    ASSERT_STR_EQ("main thread", fhir_get_last_error()->message);
+    
+    fhir_clear_error();
+    return true;
+}
+
 bool test_error_code_to_string(void) {
     ASSERT_STR_EQ("No error", fhir_error_code_to_string(FHIR_ERROR_NONE));
     ASSERT_STR_EQ("Invalid argument", fhir_error_code_to_string(FHIR_ERROR_INVALID_ARGUMENT));
@@ -106,6 +164,138 @@ bool test_fhir_calloc(void) {
     return true;
 }
 
+/* ========================================================================== */
+/* String Interning Tests                                                     */
+/* ========================================================================== */
+
+bool test_fhir_intern(void) {
+    fhir_intern_clear();
+    
+    char buffer[] = "http://loinc.org";
+    const char* loinc = fhir_intern("http://loinc.org");
+    ASSERT_NOT_NULL(loinc);
+    ASSERT_TRUE(loinc == fhir_intern(buffer));
+    ASSERT_TRUE(loinc != buffer);
+    
+    // Length-delimited input need not be terminated
+    ASSERT_TRUE(loinc == fhir_intern_n("http://loinc.org|1234", 16));
+    ASSERT_STR_EQ("http", fhir_intern_n("http://loinc.org", 4));
+    ASSERT_TRUE(fhir_intern("http") != loinc);
+    ASSERT_STR_EQ("", fhir_intern(""));
+    
+    ASSERT_TRUE(fhir_intern_equals(loinc, fhir_intern(buffer)));
+    ASSERT_TRUE(fhir_intern_equals(loinc, buffer));
+    ASSERT_FALSE(fhir_intern_equals(loinc, "http://snomed.info/sct"));
+    ASSERT_FALSE(fhir_intern_equals(loinc, NULL));
+    ASSERT_TRUE(fhir_intern_equals(NULL, NULL));
+    
+    ASSERT_NULL(fhir_intern(NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    
+    // Enough distinct strings to grow every shard several times
+    char code[32];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(code, sizeof(code), "code-%d", i);
+        ASSERT_NOT_NULL(fhir_intern(code));
+    }
+    ASSERT_TRUE(loinc == fhir_intern("http://loinc.org"));
+    snprintf(code, sizeof(code), "code-%d", 4321);
+    ASSERT_STR_EQ("code-4321", fhir_intern(code));
+    
+    FHIRInternStats stats;
+    fhir_intern_get_stats(&stats);
+    ASSERT_EQ(5003, stats.string_count);
+    ASSERT_EQ(5009, stats.lookup_count);
+    ASSERT_EQ(6, stats.hit_count);
+    
+    fhir_intern_clear();
+    fhir_intern_get_stats(&stats);
+    ASSERT_EQ(0, stats.string_count);
+    return true;
+}
+
+static void* intern_on_thread(void* arg) {
+    const char** results = arg;
+    char code[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(code, sizeof(code), "urn:oid:2.16.%d", i);
+        results[i] = fhir_intern(code);
+    }
+    return NULL;
+}
+
+bool test_fhir_intern_threads(void) {
+    static const char* results[4][1000];
+    pthread_t threads[4];
+    
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, intern_on_thread, results[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    // Every thread got the same canonical pointers
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_NOT_NULL(results[0][i]);
+        for (int t = 1; t < 4; t++) {
+            ASSERT_TRUE(results[0][i] == results[t][i]);
+        }
+    }
+    
+    FHIRInternStats stats;
+    fhir_intern_get_stats(&stats);
+    ASSERT_EQ(1000, stats.string_count);
+    
+    fhir_intern_clear();
+    return true;
+}
+
+// Stand-in for the pool of another copy of fhir_common.c
+static size_t g_adopted_lookups;
+
+static const char* adopted_intern_n(const char* str, size_t length) {
+    (void)str;
+    (void)length;
+    g_adopted_lookups++;
+    return "adopted";
+}
+
+static void adopted_get_stats(FHIRInternStats* stats) {
+    memset(stats, 0, sizeof(FHIRInternStats));
+    stats->lookup_count = g_adopted_lookups;
+}
+
+static void adopted_clear(void) {
+    g_adopted_lookups = 0;
+}
+
+bool test_fhir_intern_use_pool(void) {
+    static const FHIRInternPool adopted = { adopted_intern_n, adopted_get_stats, adopted_clear };
+    const FHIRInternPool* own = fhir_intern_pool();
+    ASSERT_NOT_NULL(own);
+    const char* loinc = fhir_intern("http://loinc.org");
+    
+    fhir_intern_use_pool(&adopted);
+    ASSERT_TRUE(fhir_intern_pool() == &adopted);
+    ASSERT_STR_EQ("adopted", fhir_intern("http://loinc.org"));
+    ASSERT_STR_EQ("adopted", fhir_intern_n("http", 4));
+    ASSERT_NULL(fhir_intern(NULL));
+    FHIRInternStats stats;
+    fhir_intern_get_stats(&stats);
+    ASSERT_EQ(2, stats.lookup_count);
+    fhir_intern_clear();
+    ASSERT_EQ(0, g_adopted_lookups);
+    
+    // Strings from the own pool survive a round trip through another
+    fhir_intern_use_pool(NULL);
+    ASSERT_TRUE(fhir_intern_pool() == own);
+    ASSERT_TRUE(loinc == fhir_intern("http://loinc.org"));
+    
+    fhir_intern_clear();
+    return true;
+}
+
 /* ========================================================================== */
 /* Array Management Tests                                                     */
 /* ========================================================================== */
@@ -290,6 +480,9 @@ bool test_fhir_validate_date(void) {
     ASSERT_TRUE(fhir_validate_date("2023-01-01"));
     ASSERT_TRUE(fhir_validate_date("2023-12-31"));
     ASSERT_TRUE(fhir_validate_date("1900-01-01"));
+    ASSERT_TRUE(fhir_validate_date("2024-02-29"));    // Leap day
+    ASSERT_TRUE(fhir_validate_date("2023-01"));       // Partial date (month)
+    ASSERT_TRUE(fhir_validate_date("2023"));          // Partial date (year)
     
     // Invalid dates
     ASSERT_FALSE(fhir_validate_date(""));
@@ -298,6 +491,9 @@ bool test_fhir_validate_date(void) {
     ASSERT_FALSE(fhir_validate_date("23-01-01"));     // Wrong year format
     ASSERT_FALSE(fhir_validate_date("2023/01/01"));   // Wrong separator
     ASSERT_FALSE(fhir_validate_date("2023-01-01T"));  // Extra characters
+    ASSERT_FALSE(fhir_validate_date("2023-13-01"));   // Month out of range
+    ASSERT_FALSE(fhir_validate_date("2023-02-29"));   // Not a leap year
+    ASSERT_FALSE(fhir_validate_date("0000"));         // Year zero
     
     return true;
 }
@@ -306,12 +502,139 @@ bool test_fhir_validate_datetime(void) {
     // Valid datetimes
     ASSERT_TRUE(fhir_validate_datetime("2023-01-01T10:30:45"));
     ASSERT_TRUE(fhir_validate_datetime("2023-12-31T23:59:59"));
+    ASSERT_TRUE(fhir_validate_datetime("2023-01-01T10:30:45Z"));
+    ASSERT_TRUE(fhir_validate_datetime("2023-01-01T10:30:45.123456789+14:00"));
+    ASSERT_TRUE(fhir_validate_datetime("2023-01-01T10:30:45-05:30"));
+    ASSERT_TRUE(fhir_validate_datetime("2023-01-01"));         // Partial dateTime (day)
+    ASSERT_TRUE(fhir_validate_datetime("2023-01"));            // Partial dateTime (month)
+    ASSERT_TRUE(fhir_validate_datetime("2023"));               // Partial dateTime (year)
     
     // Invalid datetimes
     ASSERT_FALSE(fhir_validate_datetime(""));
     ASSERT_FALSE(fhir_validate_datetime(NULL));
-    ASSERT_FALSE(fhir_validate_datetime("2023-01-01"));        // Missing time
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T"));       // Missing time
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T10:30"));  // Missing seconds
+    ASSERT_FALSE(fhir_validate_datetime("2023-01T10:30:45"));  // Time on partial date
     ASSERT_FALSE(fhir_validate_datetime("2023-01-01 10:30:45")); // Wrong separator
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T24:00:00")); // Hour out of range
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T10:30:45.")); // Empty fraction
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T10:30:45+14:30")); // Offset out of range
+    ASSERT_FALSE(fhir_validate_datetime("2023-01-01T10:30:45+0500")); // Offset missing colon
+    
+    return true;
+}
+
+bool test_fhir_validate_instant(void) {
+    // Valid instants
+    ASSERT_TRUE(fhir_validate_instant("2023-01-01T10:30:45Z"));
+    ASSERT_TRUE(fhir_validate_instant("2023-01-01T10:30:45.123+01:00"));
+    
+    // Invalid instants
+    ASSERT_FALSE(fhir_validate_instant(NULL));
+    ASSERT_FALSE(fhir_validate_instant("2023-01-01T10:30:45"));  // Missing timezone
+    ASSERT_FALSE(fhir_validate_instant("2023-01-01"));           // Missing time
+    ASSERT_FALSE(fhir_validate_instant("2023-01-01T10:30Z"));    // Missing seconds
+    
+    return true;
+}
+
+bool test_fhir_validate_code(void) {
+    // Valid codes
+    ASSERT_TRUE(fhir_validate_code("active"));
+    ASSERT_TRUE(fhir_validate_code("in progress"));
+    
+    // Invalid codes
+    ASSERT_FALSE(fhir_validate_code(""));
+    ASSERT_FALSE(fhir_validate_code(NULL));
+    ASSERT_FALSE(fhir_validate_code(" active"));     // Leading whitespace
+    ASSERT_FALSE(fhir_validate_code("active "));     // Trailing whitespace
+    ASSERT_FALSE(fhir_validate_code("in  progress")); // Double space
+    ASSERT_FALSE(fhir_validate_code("in\tprogress")); // Tab separator
+    
+    return true;
+}
+
+/* ========================================================================== */
+/* Date/Time Tests                                                            */
+/* ========================================================================== */
+
+bool test_fhir_datetime_parse(void) {
+    FHIRDateTimeValue value;
+    
+    ASSERT_TRUE(fhir_datetime_parse("2024-03-01T10:00:00.25+01:00", &value));
+    ASSERT_TRUE(value.epoch_us == INT64_C(1709283600250000));
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_SECOND + 2, value.precision);
+    ASSERT_EQ(60, value.tz_offset_minutes);
+    ASSERT_TRUE(value.has_timezone);
+    
+    // Partial dates and zone-less times are UTC
+    ASSERT_TRUE(fhir_datetime_parse("2024-02", &value));
+    ASSERT_TRUE(value.epoch_us == INT64_C(1706745600000000));
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_MONTH, value.precision);
+    ASSERT_FALSE(value.has_timezone);
+    ASSERT_TRUE(fhir_datetime_parse("1970-01-01T00:00:01", &value));
+    ASSERT_TRUE(value.epoch_us == 1000000);
+    
+    // Digits past microseconds are truncated
+    ASSERT_TRUE(fhir_datetime_parse("1969-12-31T23:59:59.999999999Z", &value));
+    ASSERT_TRUE(value.epoch_us == -1);
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_MICROSECOND, value.precision);
+    
+    // Same grammar as fhir_validate_datetime
+    ASSERT_FALSE(fhir_datetime_parse("2024-01-01T10:00", &value));
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_NONE, value.precision);
+    ASSERT_FALSE(fhir_datetime_parse("2023-02-29", &value));
+    ASSERT_FALSE(fhir_datetime_parse("2024-01T10:00:00Z", &value));
+    ASSERT_FALSE(fhir_datetime_parse(NULL, &value));
+    
+    return true;
+}
+
+bool test_fhir_datetime_compare(void) {
+    FHIRDateTimeValue year, day, shifted, unparsed;
+    ASSERT_TRUE(fhir_datetime_parse("2024", &year));
+    ASSERT_TRUE(fhir_datetime_parse("2024-01-01", &day));
+    ASSERT_TRUE(fhir_datetime_parse("2024-01-01T00:30:00+01:00", &shifted));
+    fhir_datetime_parse("invalid", &unparsed);
+    
+    // Equal starts order coarser first, offsets are applied
+    ASSERT_TRUE(fhir_datetime_compare(&year, &day) < 0);
+    ASSERT_TRUE(fhir_datetime_compare(&day, &year) > 0);
+    ASSERT_EQ(0, fhir_datetime_compare(&day, &day));
+    ASSERT_TRUE(fhir_datetime_compare(&shifted, &year) < 0);
+    ASSERT_TRUE(fhir_datetime_compare(&unparsed, &shifted) < 0);
+    
+    return true;
+}
+
+bool test_fhir_datetime_ranges(void) {
+    FHIRDateTimeValue february, december, march_first, tenth, leap_day;
+    ASSERT_TRUE(fhir_datetime_parse("2024-02", &february));
+    ASSERT_TRUE(fhir_datetime_parse("2024-12", &december));
+    ASSERT_TRUE(fhir_datetime_parse("2024-03-01", &march_first));
+    ASSERT_TRUE(fhir_datetime_parse("2024-03-01T10:00:00.5Z", &tenth));
+    ASSERT_TRUE(fhir_datetime_parse("2024-02-29T23:00:00Z", &leap_day));
+    
+    ASSERT_TRUE(fhir_datetime_end(&february) == march_first.epoch_us);
+    ASSERT_TRUE(fhir_datetime_end(&december) == INT64_C(1735689600000000));
+    ASSERT_TRUE(fhir_datetime_end(&tenth) - tenth.epoch_us == 100000);
+    
+    // Ranges are half-open
+    ASSERT_FALSE(fhir_datetime_overlaps(&february, &march_first));
+    ASSERT_TRUE(fhir_datetime_overlaps(&february, &leap_day));
+    ASSERT_TRUE(fhir_datetime_overlaps(&march_first, &tenth));
+    ASSERT_FALSE(fhir_datetime_ranges_overlap(0, 10, 10, 20));
+    ASSERT_TRUE(fhir_datetime_ranges_overlap(0, 11, 10, 20));
+    
+    int y, m, d;
+    fhir_datetime_to_civil(leap_day.epoch_us, &y, &m, &d);
+    ASSERT_EQ(2024, y);
+    ASSERT_EQ(2, m);
+    ASSERT_EQ(29, d);
+    fhir_datetime_to_civil(-1, &y, &m, &d);
+    ASSERT_EQ(1969, y);
+    ASSERT_EQ(12, m);
+    ASSERT_EQ(31, d);
     
     return true;
 }
@@ -369,6 +692,8 @@ int main(void) {
     
     // Error handling tests
     RUN_TEST(test_error_handling_basic);
+    RUN_TEST(test_error_truncation);
+    RUN_TEST(test_error_thread_local);
     RUN_TEST(test_error_code_to_string);
     
     // Memory management tests
@@ -376,6 +701,11 @@ int main(void) {
     RUN_TEST(test_fhir_malloc);
     RUN_TEST(test_fhir_calloc);
     
+    // String interning tests
+    RUN_TEST(test_fhir_intern);
+    RUN_TEST(test_fhir_intern_threads);
+    RUN_TEST(test_fhir_intern_use_pool);
+    
     // Array management tests
     RUN_TEST(test_fhir_resize_array);
     RUN_TEST(test_fhir_array_add);
@@ -391,6 +721,13 @@ int main(void) {
     RUN_TEST(test_fhir_validate_id);
     RUN_TEST(test_fhir_validate_date);
     RUN_TEST(test_fhir_validate_datetime);
+    RUN_TEST(test_fhir_validate_instant);
+    RUN_TEST(test_fhir_validate_code);
+    
+    // Date/time tests
+    RUN_TEST(test_fhir_datetime_parse);
+    RUN_TEST(test_fhir_datetime_compare);
+    RUN_TEST(test_fhir_datetime_ranges);
     
     // Resource utilities tests
     RUN_TEST(test_fhir_init_base_resource);
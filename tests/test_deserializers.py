@@ -14,7 +14,7 @@ sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
 
 from fast_fhir.deserializers import (
     FHIRCareProvisionDeserializer, FHIRDeserializationError,
-    deserialize_care_provision_resource,
+    deserialize_care_provision_resource, deserialize_many,
     deserialize_care_plan, deserialize_care_team, deserialize_goal,
     deserialize_service_request, deserialize_nutrition_order,
     deserialize_risk_assessment, deserialize_vision_prescription
@@ -598,6 +598,73 @@ class TestJSONStringDeserialization(unittest.TestCase):
         care_plan = deserialize_care_plan(care_plan_json_str)
         self.assertIsInstance(care_plan, CarePlan)
         self.assertEqual(care_plan.id, "careplan-json-str")
+    
+    def test_c_validation_available(self):
+        """Test that every deserializer module finds the C extension when it is built"""
+        try:
+            from fast_fhir import fhir_parser_c
+        except ImportError:
+            self.skipTest("fhir_parser_c extension not available")
+
+        from fast_fhir.deserializers import deserializers, entities_deserializers, foundation_deserializers
+        for module in (deserializers, entities_deserializers, foundation_deserializers):
+            self.assertTrue(module.HAS_C_VALIDATION, module.__name__)
+        self.assertTrue(FHIRCareProvisionDeserializer().use_c_validation)
+
+    def test_c_structure_validation(self):
+        """Test that JSON strings are checked against the C structure rules"""
+        deserializer = FHIRCareProvisionDeserializer()
+        if not deserializer.use_c_validation:
+            self.skipTest("fhir_parser_c extension not available")
+        
+        missing_subject = json.dumps({"resourceType": "CarePlan", "status": "active", "intent": "plan"})
+        with self.assertRaises(FHIRDeserializationError) as context:
+            deserializer.deserialize(missing_subject)
+        self.assertIn("subject", str(context.exception))
+        
+        bad_eye = json.dumps({
+            "resourceType": "VisionPrescription",
+            "status": "active",
+            "patient": {"reference": "Patient/patient-123"},
+            "prescriber": {"reference": "Practitioner/practitioner-123"},
+            "lensSpecification": [{"eye": "center"}]
+        })
+        with self.assertRaises(FHIRDeserializationError) as context:
+            deserializer.deserialize(bad_eye)
+        self.assertIn("lensSpecification[0].eye", str(context.exception))
+    
+    def test_deserialize_many(self):
+        """Test batch deserialization from lists, NDJSON and JSON arrays"""
+        goals = [
+            {"resourceType": "Goal", "id": f"goal-{i}", "lifecycleStatus": "active",
+             "description": {"text": "Walk daily"}, "subject": {"reference": "Patient/patient-123"}}
+            for i in range(3)
+        ]
+        goals[1].pop("subject")
+        lines = [json.dumps(goal) for goal in goals]
+        
+        deserializer = FHIRCareProvisionDeserializer()
+        if not deserializer.use_c_validation:
+            self.skipTest("fhir_parser_c extension not available")
+        
+        for source in (lines, "\n".join(lines) + "\n", json.dumps(goals).encode()):
+            resources, errors = deserialize_many(source, resource_type="Goal", threads=2)
+            self.assertEqual(len(resources), 3)
+            self.assertIsInstance(resources[0], Goal)
+            self.assertEqual(resources[2].id, "goal-2")
+            self.assertEqual([error["index"] for error in errors], [1])
+            self.assertIsNone(resources[1])
+        
+        resources, errors = deserialize_many("\n".join(lines[:1] + ["{not json"]))
+        self.assertIsInstance(resources[0], Goal)
+        self.assertEqual(errors[0]["index"], 1)
+        self.assertEqual(errors[0]["code"], "Invalid JSON")
+        self.assertEqual(errors[0]["line"], 2)
+        
+        # Dictionaries skip the C parse and go straight to conversion
+        resources, errors = deserialize_many(goals[:1])
+        self.assertIsInstance(resources[0], Goal)
+        self.assertEqual(errors, [])
 
 
 if __name__ == '__main__':
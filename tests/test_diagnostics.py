@@ -0,0 +1,77 @@
+"""Tests for C extension diagnostics."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestDiagnostics:
+    """Test cases for memory statistics, performance counters and object pools."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_memory_stats(self):
+        """Test allocation accounting with per-type attribution."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        fhir_diagnostics_c = pytest.importorskip("fast_fhir.fhir_diagnostics_c")
+
+        previous = fhir_diagnostics_c.enable_memory_stats(True)
+        try:
+            fhir_diagnostics_c.fhir_memory_stats(reset=True)
+            patients = [fhir_ndjson_c.parse_resource(json.dumps(
+                {"resourceType": "Patient", "id": f"p{i}", "name": [{"family": "Doe"}]}))
+                for i in range(10)]
+            stats = fhir_diagnostics_c.fhir_memory_stats()
+            assert stats["enabled"] is True
+            assert stats["allocations"] >= 10
+            assert stats["live_bytes"] > 0
+            assert stats["peak_bytes"] >= stats["live_bytes"]
+            assert stats["by_type"]["Patient"]["allocations"] >= 10
+
+            live = stats["live_bytes"]
+            del patients
+            stats = fhir_diagnostics_c.fhir_memory_stats(thread=True)
+            assert "by_type" in stats
+            assert fhir_diagnostics_c.fhir_memory_stats()["live_bytes"] < live
+        finally:
+            fhir_diagnostics_c.enable_memory_stats(previous)
+    
+    def test_perf_counters(self):
+        """Test per-type performance counters across parse phases."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        fhir_diagnostics_c = pytest.importorskip("fast_fhir.fhir_diagnostics_c")
+
+        previous = fhir_diagnostics_c.enable_perf_counters(True)
+        try:
+            fhir_diagnostics_c.perf_counters(reset=True)
+            for i in range(5):
+                resource = fhir_ndjson_c.parse_resource(json.dumps(
+                    {"resourceType": "Patient", "id": f"p{i}", "gender": "male"}))
+                resource.to_dict()
+            counters = fhir_diagnostics_c.perf_counters(reset=True)
+            patient = counters["Patient"]
+            assert patient["parsed"] == 5
+            assert patient["failures"] == 0
+            assert patient["phases"]["deserialize"]["calls"] == 5
+            assert patient["phases"]["python"]["calls"] == 5
+            assert patient["phases"]["deserialize"]["nanoseconds"] > 0
+            assert fhir_diagnostics_c.perf_counters() == {}
+        finally:
+            fhir_diagnostics_c.enable_perf_counters(previous)
+    
+    def test_trim_object_pools(self):
+        """Test releasing pooled resource structs after a batch."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        fhir_diagnostics_c = pytest.importorskip("fast_fhir.fhir_diagnostics_c")
+
+        resources = [fhir_ndjson_c.parse_resource(json.dumps(
+            {"resourceType": "Patient", "id": f"p{i}"})) for i in range(100)]
+        del resources
+        assert fhir_diagnostics_c.trim_object_pools() > 0
+        assert fhir_diagnostics_c.trim_object_pools() == 0
+
+        # Structs are allocated afresh after a trim
+        resource = fhir_ndjson_c.parse_resource(json.dumps({"resourceType": "Patient", "id": "p"}))
+        assert resource.id == "p"
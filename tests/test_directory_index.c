@@ -0,0 +1,322 @@
+/**
+ * @file test_directory_index.c
+ * @brief Unit tests for the provider directory graph index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_directory_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CARDIOLOGY "{\"coding\":[{\"system\":\"http://snomed.info/sct\",\"code\":\"394579002\"}]}"
+#define DERMATOLOGY "{\"coding\":[{\"system\":\"http://snomed.info/sct\",\"code\":\"394582007\"}]}"
+
+// A network organization with two affiliated participants (one inactive),
+// a hospital with a clinic under it, and a campus with a wing under it
+static const char* g_directory[] = {
+    "{\"resourceType\":\"Organization\",\"id\":\"network\"}",
+    "{\"resourceType\":\"Organization\",\"id\":\"hospital\"}",
+    "{\"resourceType\":\"Organization\",\"id\":\"clinic\",\"partOf\":{\"reference\":\"Organization/hospital\"}}",
+    "{\"resourceType\":\"Organization\",\"id\":\"other\"}",
+    "{\"resourceType\":\"OrganizationAffiliation\",\"id\":\"aff1\","
+    "\"organization\":{\"reference\":\"Organization/network\"},"
+    "\"participatingOrganization\":{\"reference\":\"Organization/hospital\"}}",
+    "{\"resourceType\":\"OrganizationAffiliation\",\"id\":\"aff2\",\"active\":false,"
+    "\"organization\":{\"reference\":\"Organization/network\"},"
+    "\"participatingOrganization\":{\"reference\":\"Organization/other\"}}",
+    "{\"resourceType\":\"Location\",\"id\":\"campus\",\"managingOrganization\":{\"reference\":\"Organization/hospital\"}}",
+    "{\"resourceType\":\"Location\",\"id\":\"wing\",\"partOf\":{\"reference\":\"Location/campus\"}}",
+    "{\"resourceType\":\"PractitionerRole\",\"id\":\"r1\","
+    "\"practitioner\":{\"reference\":\"http://example.org/fhir/Practitioner/p1/_history/2\"},"
+    "\"organization\":{\"reference\":\"Organization/hospital\"},"
+    "\"location\":[{\"reference\":\"Location/wing\"}],"
+    "\"code\":[{\"coding\":[{\"code\":\"doctor\"}]}],\"specialty\":[" CARDIOLOGY "]}",
+    "{\"resourceType\":\"PractitionerRole\",\"id\":\"r2\",\"practitioner\":{\"reference\":\"Practitioner/p2\"},"
+    "\"organization\":{\"reference\":\"Organization/clinic\"},"
+    "\"location\":[{\"reference\":\"Location/campus\"},{\"reference\":\"#contained\"}],\"specialty\":[" CARDIOLOGY "]}",
+    "{\"resourceType\":\"PractitionerRole\",\"id\":\"r3\",\"practitioner\":{\"reference\":\"Practitioner/p3\"},"
+    "\"organization\":{\"reference\":\"Organization/other\"},\"specialty\":[" CARDIOLOGY "]}",
+    "{\"resourceType\":\"PractitionerRole\",\"id\":\"r4\",\"active\":false,"
+    "\"practitioner\":{\"reference\":\"Practitioner/p4\"},"
+    "\"organization\":{\"reference\":\"Organization/hospital\"},\"specialty\":[" DERMATOLOGY "]}",
+    "{\"resourceType\":\"Practitioner\",\"id\":\"p1\"}",
+};
+
+static FHIRDirectoryIndex* build_directory(void) {
+    FHIRDirectoryIndex* index = fhir_directory_index_create();
+    if (!index) return NULL;
+
+    for (size_t i = 0; i < sizeof(g_directory) / sizeof(g_directory[0]); i++) {
+        cJSON* json = cJSON_Parse(g_directory[i]);
+        bool added = json && fhir_directory_index_add_json(index, json);
+        cJSON_Delete(json);
+        if (!added) {
+            fhir_directory_index_destroy(index);
+            return NULL;
+        }
+    }
+    if (!fhir_directory_index_build(index)) {
+        fhir_directory_index_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+// Role ids of the matches, comma-separated
+static void match_roles(const FHIRDirectoryIndex* index, const FHIRDirectoryMatches* matches, char* out,
+                        size_t size) {
+    out[0] = '\0';
+    for (size_t i = 0; i < matches->count; i++) {
+        const char* reference = fhir_directory_index_reference(index, matches->items[i].role);
+        const char* id = strchr(reference, '/') + 1;
+        strncat(out, i ? "," : "", size - strlen(out) - 1);
+        strncat(out, id, size - strlen(out) - 1);
+    }
+}
+
+/* ========================================================================== */
+/* Graph Tests                                                                */
+/* ========================================================================== */
+
+bool test_directory_nodes(void) {
+    FHIRDirectoryIndex* index = build_directory();
+    ASSERT_NOT_NULL(index);
+
+    // 13 resources plus the referenced Practitioners p2-p4
+    ASSERT_EQ(16, fhir_directory_index_node_count(index));
+    ASSERT_EQ(17, fhir_directory_index_edge_count(index));
+    ASSERT_FALSE(fhir_directory_index_needs_build(index));
+
+    uint32_t p1 = fhir_directory_index_find(index, "Practitioner/p1");
+    ASSERT_TRUE(p1 != FHIR_DIRECTORY_NONE);
+    ASSERT_EQ(p1, fhir_directory_index_find(index, "https://other.example/Practitioner/p1"));
+    ASSERT_TRUE(fhir_directory_index_is_loaded(index, p1));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_PRACTITIONER, fhir_directory_index_type(index, p1));
+    ASSERT_STR_EQ("Practitioner/p1", fhir_directory_index_reference(index, p1));
+
+    uint32_t p2 = fhir_directory_index_find(index, "Practitioner/p2");
+    ASSERT_TRUE(p2 != FHIR_DIRECTORY_NONE);
+    ASSERT_FALSE(fhir_directory_index_is_loaded(index, p2));
+    ASSERT_EQ(FHIR_DIRECTORY_NONE, fhir_directory_index_find(index, "Practitioner/missing"));
+    ASSERT_EQ(FHIR_DIRECTORY_NONE, fhir_directory_index_find(index, "#contained"));
+    ASSERT_EQ(FHIR_DIRECTORY_NONE, fhir_directory_index_find(index, "NotAType/x"));
+
+    cJSON* invalid = cJSON_Parse("{\"resourceType\":\"Organization\"}");
+    ASSERT_FALSE(fhir_directory_index_add_json(index, invalid));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    cJSON_Delete(invalid);
+
+    fhir_directory_index_destroy(index);
+    return true;
+}
+
+bool test_directory_traverse(void) {
+    FHIRDirectoryIndex* index = build_directory();
+    ASSERT_NOT_NULL(index);
+
+    FHIRDirectoryNodes nodes;
+    fhir_directory_nodes_init(&nodes);
+
+    // network <- affiliation.organization, affiliation.participatingOrganization -> participant
+    uint32_t network = fhir_directory_index_find(index, "Organization/network");
+    FHIRDirectoryStep steps[2];
+    memset(steps, 0, sizeof(steps));
+    steps[0].edge = FHIR_DIRECTORY_EDGE_ORGANIZATION;
+    steps[0].reverse = true;
+    steps[0].type = FHIR_RESOURCE_TYPE_ORGANIZATION_AFFILIATION;
+    steps[1].edge = FHIR_DIRECTORY_EDGE_PARTICIPATING;
+    ASSERT_TRUE(fhir_directory_index_traverse(index, &network, 1, steps, 2, &nodes));
+    ASSERT_EQ(2, nodes.count);
+    ASSERT_EQ(fhir_directory_index_find(index, "Organization/hospital"), nodes.items[0]);
+    ASSERT_EQ(fhir_directory_index_find(index, "Organization/other"), nodes.items[1]);
+
+    // Transitive partOf keeps the start: campus and wing
+    uint32_t campus = fhir_directory_index_find(index, "Location/campus");
+    FHIRDirectoryStep subtree = { FHIR_DIRECTORY_EDGE_PART_OF, true, true, FHIR_RESOURCE_TYPE_UNKNOWN, NULL, 0 };
+    ASSERT_TRUE(fhir_directory_index_traverse(index, &campus, 1, &subtree, 1, &nodes));
+    ASSERT_EQ(2, nodes.count);
+
+    // Roles at the hospital with a code in any system
+    uint32_t hospital = fhir_directory_index_find(index, "Organization/hospital");
+    FHIRDirectoryStep coded = { FHIR_DIRECTORY_EDGE_ORGANIZATION, true, false, FHIR_RESOURCE_TYPE_PRACTITIONER_ROLE,
+                                "doctor", FHIR_DIRECTORY_CODE_ROLE };
+    ASSERT_TRUE(fhir_directory_index_traverse(index, &hospital, 1, &coded, 1, &nodes));
+    ASSERT_EQ(1, nodes.count);
+    ASSERT_STR_EQ("PractitionerRole/r1", fhir_directory_index_reference(index, nodes.items[0]));
+    coded.code = "unknown";
+    ASSERT_TRUE(fhir_directory_index_traverse(index, &hospital, 1, &coded, 1, &nodes));
+    ASSERT_EQ(0, nodes.count);
+
+    fhir_directory_nodes_cleanup(&nodes);
+    fhir_directory_index_destroy(index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Practitioner Search Tests                                                  */
+/* ========================================================================== */
+
+bool test_directory_find_practitioners(void) {
+    FHIRDirectoryIndex* index = build_directory();
+    ASSERT_NOT_NULL(index);
+
+    FHIRDirectoryQuery query;
+    FHIRDirectoryMatches matches;
+    char roles[128];
+    fhir_directory_matches_init(&matches);
+
+    // Cardiologists at organizations affiliated with the network
+    memset(&query, 0, sizeof(query));
+    query.organization = "Organization/network";
+    query.affiliated = true;
+    query.specialty = "http://snomed.info/sct|394579002";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1", roles);
+    ASSERT_STR_EQ("Practitioner/p1", fhir_directory_index_reference(index, matches.items[0].practitioner));
+    ASSERT_STR_EQ("Organization/hospital", fhir_directory_index_reference(index, matches.items[0].organization));
+
+    // Sub-organizations, then inactive affiliations too
+    query.include_children = true;
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1", roles);
+    query.organization = "Organization/hospital";
+    query.affiliated = false;
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1,r2", roles);
+    query.organization = "Organization/network";
+    query.affiliated = true;
+    query.include_inactive = true;
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1,r3", roles);
+
+    // Any cardiologist at the campus or its wing, by bare code
+    memset(&query, 0, sizeof(query));
+    query.location = "Location/campus";
+    query.specialty = "394579002";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1,r2", roles);
+
+    // Specialty alone reads the posting list; inactive roles are dropped
+    memset(&query, 0, sizeof(query));
+    query.specialty = "394579002";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1,r2,r3", roles);
+    query.specialty = "394582007";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    ASSERT_EQ(0, matches.count);
+    query.include_inactive = true;
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r4", roles);
+
+    // Unknown references and codes match nothing; no filter is an error
+    memset(&query, 0, sizeof(query));
+    query.organization = "Organization/unknown";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    ASSERT_EQ(0, matches.count);
+    memset(&query, 0, sizeof(query));
+    ASSERT_FALSE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    fhir_directory_matches_cleanup(&matches);
+    fhir_directory_index_destroy(index);
+    return true;
+}
+
+bool test_directory_update(void) {
+    FHIRDirectoryIndex* index = build_directory();
+    ASSERT_NOT_NULL(index);
+
+    // r1 moves from the hospital to the clinic
+    cJSON* moved = cJSON_Parse("{\"resourceType\":\"PractitionerRole\",\"id\":\"r1\","
+                               "\"practitioner\":{\"reference\":\"Practitioner/p1\"},"
+                               "\"organization\":{\"reference\":\"Organization/clinic\"}}");
+    ASSERT_NOT_NULL(moved);
+    ASSERT_TRUE(fhir_directory_index_add_json(index, moved));
+    cJSON_Delete(moved);
+    ASSERT_EQ(16, fhir_directory_index_edge_count(index));
+    ASSERT_TRUE(fhir_directory_index_needs_build(index));
+
+    FHIRDirectoryQuery query;
+    FHIRDirectoryMatches matches;
+    char roles[128];
+    memset(&query, 0, sizeof(query));
+    query.organization = "Organization/clinic";
+    fhir_directory_matches_init(&matches);
+    ASSERT_FALSE(fhir_directory_index_find_practitioners(index, &query, &matches));
+
+    ASSERT_TRUE(fhir_directory_index_build(index));
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    match_roles(index, &matches, roles, sizeof(roles));
+    ASSERT_STR_EQ("r1,r2", roles);
+    query.organization = "Organization/hospital";
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    ASSERT_EQ(0, matches.count);
+
+    fhir_directory_matches_cleanup(&matches);
+    fhir_directory_index_destroy(index);
+    return true;
+}
+
+// A generated directory: every role of one organization is found
+bool test_directory_large(void) {
+    const size_t organizations = 200, roles_per_organization = 50;
+    FHIRDirectoryIndex* index = fhir_directory_index_create();
+    ASSERT_NOT_NULL(index);
+
+    char text[512];
+    for (size_t o = 0; o < organizations; o++) {
+        for (size_t r = 0; r < roles_per_organization; r++) {
+            snprintf(text, sizeof(text),
+                     "{\"resourceType\":\"PractitionerRole\",\"id\":\"r%zu-%zu\","
+                     "\"practitioner\":{\"reference\":\"Practitioner/p%zu\"},"
+                     "\"organization\":{\"reference\":\"Organization/o%zu\"},"
+                     "\"specialty\":[{\"coding\":[{\"code\":\"s%zu\"}]}]}",
+                     o, r, (o * 7 + r) % 3000, o, r % 10);
+            cJSON* json = cJSON_Parse(text);
+            ASSERT_NOT_NULL(json);
+            ASSERT_TRUE(fhir_directory_index_add_json(index, json));
+            cJSON_Delete(json);
+        }
+    }
+    ASSERT_TRUE(fhir_directory_index_build(index));
+
+    FHIRDirectoryQuery query;
+    FHIRDirectoryMatches matches;
+    memset(&query, 0, sizeof(query));
+    query.organization = "Organization/o123";
+    query.specialty = "s3";
+    fhir_directory_matches_init(&matches);
+    ASSERT_TRUE(fhir_directory_index_find_practitioners(index, &query, &matches));
+    ASSERT_EQ(roles_per_organization / 10, matches.count);
+    for (size_t i = 0; i < matches.count; i++) {
+        ASSERT_STR_EQ("Organization/o123", fhir_directory_index_reference(index, matches.items[i].organization));
+        if (i > 0) ASSERT_TRUE(matches.items[i - 1].role < matches.items[i].role);
+    }
+
+    fhir_directory_matches_cleanup(&matches);
+    fhir_directory_index_destroy(index);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_directory_nodes);
+    RUN_TEST(test_directory_traverse);
+    RUN_TEST(test_directory_find_practitioners);
+    RUN_TEST(test_directory_update);
+    RUN_TEST(test_directory_large);
+
+    TEST_FINALIZE();
+    return 0;
+}
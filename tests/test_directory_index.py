@@ -0,0 +1,53 @@
+"""Tests for the provider directory index with C extensions."""
+
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestDirectoryIndex:
+    """Test cases for the provider directory index."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_directory_index(self):
+        """Test practitioner searches over the provider directory graph."""
+        pytest.importorskip("fast_fhir.fhir_directory_c")
+        
+        cardiology = {"coding": [{"system": "http://snomed.info/sct", "code": "394579002"}]}
+        resources = [
+            {"resourceType": "Organization", "id": "network"},
+            {"resourceType": "Organization", "id": "hospital"},
+            {"resourceType": "Organization", "id": "clinic", "partOf": {"reference": "Organization/hospital"}},
+            {"resourceType": "OrganizationAffiliation", "id": "aff",
+             "organization": {"reference": "Organization/network"},
+             "participatingOrganization": {"reference": "Organization/hospital"}},
+            {"resourceType": "Location", "id": "campus"},
+            {"resourceType": "PractitionerRole", "id": "r1", "practitioner": {"reference": "Practitioner/p1"},
+             "organization": {"reference": "Organization/hospital"},
+             "location": [{"reference": "Location/campus"}], "specialty": [cardiology]},
+            {"resourceType": "PractitionerRole", "id": "r2", "active": False,
+             "practitioner": {"reference": "Practitioner/p2"},
+             "organization": {"reference": "Organization/clinic"}, "specialty": [cardiology]},
+        ]
+        index = self.parser.build_directory_index(resources)
+        assert len(index) == 9
+        
+        assert index.find_practitioners(organization="Organization/network", affiliated=True,
+                                        specialty="394579002") == [
+            ("Practitioner/p1", "PractitionerRole/r1", "Organization/hospital")]
+        roles = index.find_practitioners(organization="Organization/hospital", include_children=True,
+                                         include_inactive=True)
+        assert [match[1] for match in roles] == ["PractitionerRole/r1", "PractitionerRole/r2"]
+        assert len(index.find_practitioners(location="Location/campus")) == 1
+        assert index.find_practitioners(specialty="http://snomed.info/sct|0") == []
+        
+        index.add('{"resourceType": "PractitionerRole", "id": "r2", '
+                  '"organization": {"reference": "Organization/clinic"}}')
+        assert index.find_practitioners(organization="Organization/clinic") == [
+            (None, "PractitionerRole/r2", "Organization/clinic")]
+        with pytest.raises(ValueError):
+            index.find_practitioners()
+        with pytest.raises(ValueError):
+            index.add('{"resourceType": "Organization"}')
@@ -67,6 +67,171 @@ class TestFastFHIRParser:
         missing = self.parser.extract_field_fast(json_data, "nonexistent")
         assert missing is None
     
+    def test_fast_fields_extraction(self):
+        """Test batch field extraction from a single parse."""
+        json_data = json.dumps({
+            "resourceType": "Patient",
+            "id": "test-123",
+            "active": True,
+            "gender": "male"
+        })
+        
+        fields = self.parser.extract_fields_fast(json_data, ["id", "active", "gender", "nonexistent"])
+        assert fields == {
+            "id": "test-123",
+            "active": True,
+            "gender": "male",
+            "nonexistent": None
+        }
+    
+    def test_parsed_document(self):
+        """Test the parse-once document handle from the C extension."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        
+        bundle_json = json.dumps({
+            "resourceType": "Bundle",
+            "id": "doc-bundle",
+            "type": "collection",
+            "total": 2,
+            "entry": [{"resource": {"resourceType": "Patient", "id": "p1"}},
+                      {"resource": {"resourceType": "Patient", "id": "p2"}}]
+        })
+        
+        document = fhir_parser_c.ParsedDocument(bundle_json)
+        assert document.validate() is True
+        assert document.resource_type() == "Bundle"
+        assert document.entry_count() == 2
+        assert document.extract_field("id") == "doc-bundle"
+        assert document.extract_field("total") == 2
+        assert document.extract_fields(["type", "missing"]) == {"type": "collection", "missing": None}
+        
+        with pytest.raises(ValueError):
+            fhir_parser_c.ParsedDocument("invalid json string")
+    
+    def test_buffer_inputs(self):
+        """Test that bytes-like inputs are parsed in place with an explicit length."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+
+        body = json.dumps({"resourceType": "Patient", "id": "buffer-1", "name": [{"text": "Zoë"}]}).encode()
+        for source in (body, bytearray(body), memoryview(body), memoryview(b"  " + body + b"  ")[2:-2]):
+            assert fhir_parser_c.extract_resource_type(source) == "Patient"
+            assert fhir_parser_c.extract_field(source, "id") == "buffer-1"
+            assert fhir_parser_c.ParsedDocument(source).resource_type() == "Patient"
+
+        # The length bounds the parse, so trailing bytes after the view are never read
+        assert fhir_parser_c.extract_field(memoryview(body + b"garbage")[:len(body)], "id") == "buffer-1"
+        with pytest.raises(ValueError):
+            fhir_parser_c.validate_fhir_json(body[:-1])
+        with pytest.raises(TypeError):
+            fhir_parser_c.extract_resource_type(12)
+    
+    def test_json_backends(self):
+        """Test that every supported JSON parser backend gives the same results."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+
+        backends = fhir_parser_c.json_backends()
+        assert "cjson" in backends and "scalar" in backends
+        original = fhir_parser_c.json_backend()
+        body = json.dumps({"resourceType": "Patient", "id": "b-1", "name": [{"text": "Zoë \"Q\""}]})
+        try:
+            for backend in backends:
+                fhir_parser_c.set_json_backend(backend)
+                assert fhir_parser_c.json_backend() == backend
+                assert fhir_parser_c.extract_field(body, "id") == "b-1"
+                assert fhir_parser_c.ParsedDocument(body).resource_type() == "Patient"
+                with pytest.raises(ValueError):
+                    fhir_parser_c.validate_fhir_json(body + "}")
+            with pytest.raises(ValueError):
+                fhir_parser_c.set_json_backend("simd")
+        finally:
+            fhir_parser_c.set_json_backend(original)
+    
+    def test_resource_type_code(self):
+        """Test the cached resource type name to enum code mapping."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        
+        patient_code = fhir_parser_c.resource_type_code("Patient")
+        assert patient_code != fhir_parser_c.RESOURCE_TYPE_UNKNOWN
+        assert fhir_parser_c.resource_type_code("Patient") == patient_code
+        assert fhir_parser_c.resource_type_code("".join(["Pat", "ient"])) == patient_code
+        
+        codes = {fhir_parser_c.resource_type_code(name)
+                 for name in ("Bundle", "CarePlan", "ValueSet", "VisionPrescription")}
+        assert len(codes) == 4
+        assert all(0 < code < fhir_parser_c.RESOURCE_TYPE_COUNT for code in codes)
+        
+        assert fhir_parser_c.resource_type_code("patient") == fhir_parser_c.RESOURCE_TYPE_UNKNOWN
+        assert fhir_parser_c.resource_type_code("") == fhir_parser_c.RESOURCE_TYPE_UNKNOWN
+        with pytest.raises(TypeError):
+            fhir_parser_c.resource_type_code(b"Patient")
+        
+        document = fhir_parser_c.ParsedDocument(json.dumps({"resourceType": "Bundle"}))
+        assert document.resource_type_code() == fhir_parser_c.resource_type_code("Bundle")
+    
+    def test_parse_from_threads(self):
+        """Test concurrent parsing of large documents, which runs without the GIL."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        from concurrent.futures import ThreadPoolExecutor
+
+        entries = [{"resource": {"resourceType": "Patient", "id": f"p{i}"}} for i in range(200)]
+        bundle_json = json.dumps({"resourceType": "Bundle", "id": "large", "entry": entries})
+
+        def work(_):
+            document = fhir_parser_c.ParsedDocument(bundle_json)
+            return (fhir_parser_c.count_bundle_entries(bundle_json),
+                    document.extract_field("id"),
+                    len(list(fhir_parser_c.iter_bundle_entries(bundle_json))))
+
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            results = list(pool.map(work, range(16)))
+
+        assert results == [(200, "large", 200)] * 16
+    
+    def test_module_isolation(self):
+        """Test that every import of an extension module gets its own types and state."""
+        import importlib
+        import importlib.util
+        import sys
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+
+        spec = importlib.util.find_spec("fast_fhir.fhir_parser_c")
+        copy = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(copy)
+        assert copy.ParsedDocument is not fhir_parser_c.ParsedDocument
+        assert copy.resource_type_code("Patient") == fhir_parser_c.resource_type_code("Patient")
+        assert not isinstance(copy.ParsedDocument('{"resourceType": "Patient"}'), fhir_parser_c.ParsedDocument)
+
+        # Re-executing the module registers its resource types again
+        spec = importlib.util.find_spec("fast_fhir.fhir_ndjson_c")
+        copy = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(copy)
+        assert copy.parse_resource('{"resourceType": "Patient", "id": "a"}').id == "a"
+        assert fhir_ndjson_c.parse_resource('{"resourceType": "Patient", "id": "b"}').id == "b"
+
+        interpreters = None
+        for name in ("_interpreters", "_xxsubinterpreters"):
+            try:
+                interpreters = importlib.import_module(name)
+                break
+            except ImportError:
+                pass
+        if interpreters is None:
+            return
+
+        script = "\n".join([
+            f"import sys; sys.path[:] = {sys.path!r}",
+            "from fast_fhir import fhir_parser_c",
+            "from fast_fhir import fhir_ndjson_c",
+            "assert fhir_parser_c.ParsedDocument('{\"resourceType\": \"Patient\"}').resource_type() == 'Patient'",
+            "assert fhir_ndjson_c.parse_resource('{\"resourceType\": \"Patient\", \"id\": \"c\"}').id == 'c'",
+        ])
+        interpreter = interpreters.create()
+        try:
+            assert interpreters.run_string(interpreter, script) is None
+        finally:
+            interpreters.destroy(interpreter)
+    
     def test_parse_bundle_fast(self):
         """Test fast bundle parsing."""
         bundle_data = {
@@ -102,6 +267,37 @@ class TestFastFHIRParser:
         for entry in result['entry']:
             assert isinstance(entry, Patient)
     
+    def test_native_resource(self):
+        """Test C-backed Resource objects with slot attribute access."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        
+        data = {"resourceType": "Patient", "id": "p1", "active": True, "gender": "female",
+                "birthDate": "1990-02-03", "name": [{"family": "Doe", "given": ["Jane"]}]}
+        patient = self.parser.parse_native(data)
+        assert isinstance(patient, fhir_ndjson_c.Resource)
+        assert (patient.resource_type, patient.id, patient.active) == ("Patient", "p1", True)
+        assert (patient.gender, patient.birth_date) == ("female", "1990-02-03")
+        assert patient.validate()
+        assert patient.to_dict() == data
+        assert json.loads(patient.to_json()) == data
+        assert patient.resource_type is fhir_ndjson_c.parse_resource(b'{"resourceType":"Patient","id":"p2"}').resource_type
+        
+        with pytest.raises(ValueError):
+            fhir_ndjson_c.parse_resource('{"resourceType": "Observation", "id": "o1"}')
+        with pytest.raises(ValueError):
+            fhir_ndjson_c.parse_resource("{not json")
+        with pytest.raises(TypeError):
+            fhir_ndjson_c.parse_resource(42)
+        
+        lines = [json.dumps({"resourceType": "Patient", "id": f"p{i}", "gender": "male"}) for i in range(3)]
+        lines.append('{"resourceType": "Observation", "id": "o1"}')
+        batches = list(fhir_ndjson_c.NDJSONReader("\n".join(lines).encode(), as_resources=True))
+        resources = [r for batch, _ in batches for r in batch]
+        assert [type(r).__name__ for r in resources] == ["Resource"] * 3 + ["dict"]
+        assert [r.gender for r in resources[:3]] == ["male"] * 3
+        with pytest.raises(ValueError):
+            fhir_ndjson_c.NDJSONReader(b"", as_bytes=True, as_resources=True)
+    
     def test_performance_info(self):
         """Test performance information retrieval."""
         info = self.parser.get_performance_info()
@@ -145,4 +341,4 @@ class TestFastFHIRParser:
     def test_missing_resource_type_handling(self):
         """Test handling of missing resourceType with fast parser."""
         with pytest.raises(ValueError, match="Missing resourceType"):
-            self.parser.parse({"id": "test", "active": True})
\ No newline at end of file
+            self.parser.parse({"id": "test", "active": True})
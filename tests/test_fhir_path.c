@@ -0,0 +1,220 @@
+/**
+ * @file test_fhir_path.c
+ * @brief Unit tests for compiled FHIRPath expressions
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_path.h"
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"example\",\"active\":true,"
+    "\"name\":[{\"use\":\"official\",\"family\":\"Chalmers\",\"given\":[\"Peter\",\"James\"]},"
+    "{\"use\":\"usual\",\"given\":[\"Jim\"]},{\"use\":\"old\",\"family\":\"Windsor\","
+    "\"period\":{\"end\":\"2002\"}}],"
+    "\"telecom\":[{\"system\":\"phone\",\"value\":\"555-1\",\"use\":\"work\",\"rank\":1},"
+    "{\"system\":\"email\",\"value\":\"p@example.org\"},{\"system\":\"sms\",\"value\":\"555-2\",\"use\":\"old\"}],"
+    "\"extension\":[{\"url\":\"http://example.org/birthPlace\",\"valueString\":\"Sydney\"},"
+    "{\"url\":\"http://example.org/other\",\"valueBoolean\":false}]}";
+
+static const char* OBSERVATION_JSON =
+    "{\"resourceType\":\"Observation\",\"id\":\"bp\",\"status\":\"final\","
+    "\"code\":{\"coding\":[{\"system\":\"http://snomed.info/sct\",\"code\":\"75367002\"},"
+    "{\"system\":\"http://loinc.org\",\"code\":\"85354-9\"}]},"
+    "\"valueQuantity\":{\"value\":120,\"unit\":\"mmHg\"}}";
+
+// Evaluate expression on json and return the selected node count (-1 on failure)
+static int evaluate(const char* expression, const cJSON* json, FHIRPathResult* result) {
+    FHIRPathProgram* program = fhir_path_compile(expression);
+    if (!program) return -1;
+    bool ok = fhir_path_evaluate(program, json, result);
+    fhir_path_destroy(program);
+    return ok ? (int)result->count : -1;
+}
+
+/* ========================================================================== */
+/* Navigation Tests                                                           */
+/* ========================================================================== */
+
+bool test_fhir_path_navigation(void) {
+    cJSON* patient = cJSON_Parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+
+    // Arrays flatten along the path
+    ASSERT_EQ(2, evaluate("Patient.name.family", patient, &result));
+    ASSERT_STR_EQ("Chalmers", result.items[0]->valuestring);
+    ASSERT_STR_EQ("Windsor", result.items[1]->valuestring);
+    ASSERT_EQ(3, evaluate("name.given", patient, &result));
+    ASSERT_STR_EQ("Jim", result.items[2]->valuestring);
+
+    ASSERT_EQ(1, evaluate("Patient.name[1].given", patient, &result));
+    ASSERT_STR_EQ("Jim", result.items[0]->valuestring);
+    ASSERT_EQ(0, evaluate("name[7]", patient, &result));
+    ASSERT_EQ(1, evaluate("name.given.first()", patient, &result));
+    ASSERT_STR_EQ("Peter", result.items[0]->valuestring);
+    ASSERT_EQ(1, evaluate("name.last().use", patient, &result));
+    ASSERT_STR_EQ("old", result.items[0]->valuestring);
+    ASSERT_EQ(1, evaluate("active", patient, &result));
+    ASSERT_TRUE(cJSON_IsTrue(result.items[0]));
+
+    // Type prefixes filter, missing elements are empty
+    ASSERT_EQ(0, evaluate("Observation.status", patient, &result));
+    ASSERT_EQ(0, evaluate("name.family.missing", patient, &result));
+    ASSERT_EQ(0, evaluate("Patient.nothing", patient, &result));
+    ASSERT_EQ(0, evaluate("name", NULL, &result));
+
+    fhir_path_result_cleanup(&result);
+    cJSON_Delete(patient);
+    return true;
+}
+
+bool test_fhir_path_where(void) {
+    cJSON* patient = cJSON_Parse(PATIENT_JSON);
+    cJSON* observation = cJSON_Parse(OBSERVATION_JSON);
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+
+    ASSERT_EQ(1, evaluate("Observation.code.coding.where(system = 'http://loinc.org').code", observation, &result));
+    ASSERT_STR_EQ("85354-9", result.items[0]->valuestring);
+
+    ASSERT_EQ(1, evaluate("telecom.where(use != 'old' and (system = 'phone' or system = 'sms')).value",
+                          patient, &result));
+    ASSERT_STR_EQ("555-1", result.items[0]->valuestring);
+    ASSERT_EQ(2, evaluate("telecom.where(system = 'sms' or rank = 1)", patient, &result));
+    ASSERT_EQ(1, evaluate("name.where(period.exists()).family", patient, &result));
+    ASSERT_STR_EQ("Windsor", result.items[0]->valuestring);
+    ASSERT_EQ(2, evaluate("name.where(period.empty())", patient, &result));
+
+    // Comparisons hold if any node matches
+    ASSERT_EQ(1, evaluate("name.where(given = 'James').use", patient, &result));
+    ASSERT_STR_EQ("official", result.items[0]->valuestring);
+    ASSERT_EQ(1, evaluate("name.given.where($this = 'Jim')", patient, &result));
+    ASSERT_EQ(1, evaluate("Patient.where(active = true).id", patient, &result));
+    ASSERT_EQ(0, evaluate("Patient.where(active = false)", patient, &result));
+    ASSERT_EQ(1, evaluate("Observation.where(valueQuantity.value = 120).id", observation, &result));
+
+    // Nested where
+    ASSERT_EQ(1, evaluate("Patient.where(name.where(use = 'usual').exists()).id", patient, &result));
+    ASSERT_EQ(0, evaluate("Patient.where(name.where(use = 'maiden').exists())", patient, &result));
+
+    fhir_path_result_cleanup(&result);
+    cJSON_Delete(patient);
+    cJSON_Delete(observation);
+    return true;
+}
+
+bool test_fhir_path_choice_and_extension(void) {
+    cJSON* patient = cJSON_Parse(PATIENT_JSON);
+    cJSON* observation = cJSON_Parse(OBSERVATION_JSON);
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+
+    ASSERT_EQ(1, evaluate("Observation.value.ofType(Quantity).unit", observation, &result));
+    ASSERT_STR_EQ("mmHg", result.items[0]->valuestring);
+    ASSERT_EQ(1, evaluate("(Observation.value as Quantity).value", observation, &result));
+    ASSERT_EQ(120, (int)result.items[0]->valuedouble);
+    ASSERT_EQ(0, evaluate("Observation.value as string", observation, &result));
+
+    ASSERT_EQ(1, evaluate("extension('http://example.org/birthPlace').value.ofType(string)", patient, &result));
+    ASSERT_STR_EQ("Sydney", result.items[0]->valuestring);
+    ASSERT_EQ(0, evaluate("Patient.extension('http://example.org/none')", patient, &result));
+
+    fhir_path_result_cleanup(&result);
+    cJSON_Delete(patient);
+    cJSON_Delete(observation);
+    return true;
+}
+
+bool test_fhir_path_union(void) {
+    cJSON* patient = cJSON_Parse(PATIENT_JSON);
+    cJSON* observation = cJSON_Parse(OBSERVATION_JSON);
+    FHIRPathResult result;
+    fhir_path_result_init(&result);
+
+    // Search parameters shared by several resource types
+    const char* expression = "Patient.id | Observation.code.coding.code | (Observation.status)";
+    ASSERT_EQ(1, evaluate(expression, patient, &result));
+    ASSERT_STR_EQ("example", result.items[0]->valuestring);
+    ASSERT_EQ(3, evaluate(expression, observation, &result));
+    ASSERT_STR_EQ("75367002", result.items[0]->valuestring);
+    ASSERT_STR_EQ("final", result.items[2]->valuestring);
+    ASSERT_EQ(3, evaluate("name.family | name[1].given", patient, &result));
+
+    fhir_path_result_cleanup(&result);
+    cJSON_Delete(patient);
+    cJSON_Delete(observation);
+    return true;
+}
+
+/* ========================================================================== */
+/* Batch And Error Tests                                                      */
+/* ========================================================================== */
+
+bool test_fhir_path_batch(void) {
+    const cJSON* resources[3] = { cJSON_Parse(PATIENT_JSON), NULL, cJSON_Parse(OBSERVATION_JSON) };
+    const char* expressions[] = { "id", "name.given", "code.coding.code" };
+    const FHIRPathProgram* programs[3];
+    for (int i = 0; i < 3; i++) {
+        programs[i] = fhir_path_compile(expressions[i]);
+        ASSERT_NOT_NULL(programs[i]);
+        ASSERT_STR_EQ(expressions[i], fhir_path_get_expression(programs[i]));
+        ASSERT_TRUE(fhir_path_get_instruction_count(programs[i]) > 0);
+    }
+
+    FHIRPathResult results[9];
+    for (int i = 0; i < 9; i++) fhir_path_result_init(&results[i]);
+
+    // Rerunning reuses the result buffers
+    for (int round = 0; round < 2; round++) {
+        ASSERT_TRUE(fhir_path_evaluate_batch(programs, 3, resources, 3, results));
+        ASSERT_EQ(1, results[0].count);
+        ASSERT_EQ(3, results[1].count);
+        ASSERT_EQ(0, results[2].count);
+        for (int i = 3; i < 6; i++) ASSERT_EQ(0, results[i].count);
+        ASSERT_STR_EQ("bp", results[6].items[0]->valuestring);
+        ASSERT_EQ(0, results[7].count);
+        ASSERT_EQ(2, results[8].count);
+    }
+
+    for (int i = 0; i < 9; i++) fhir_path_result_cleanup(&results[i]);
+    for (int i = 0; i < 3; i++) fhir_path_destroy((FHIRPathProgram*)programs[i]);
+    cJSON_Delete((cJSON*)resources[0]);
+    cJSON_Delete((cJSON*)resources[2]);
+    return true;
+}
+
+bool test_fhir_path_compile_errors(void) {
+    const char* invalid[] = {
+        "", "name.", "name[", "name[-1]", "name[1.5]", "name.where(", "name.where(use = )",
+        "name.count()", "name.exists()", "ofType(Quantity)", "name |", "name family",
+        "telecom.where(system = 'phone)", "(((((((((((((((((((((((((((((((((name)))))))))))))))))))))))))))))))))"
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        ASSERT_NULL(fhir_path_compile(invalid[i]));
+        ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+    }
+    ASSERT_NULL(fhir_path_compile("name.count()"));
+    ASSERT_TRUE(strstr(fhir_get_last_error()->message, "offset 5") != NULL);
+
+    ASSERT_NULL(fhir_path_compile(NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_fhir_path_navigation);
+    RUN_TEST(test_fhir_path_where);
+    RUN_TEST(test_fhir_path_choice_and_extension);
+    RUN_TEST(test_fhir_path_union);
+    RUN_TEST(test_fhir_path_batch);
+    RUN_TEST(test_fhir_path_compile_errors);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,43 @@
+"""Tests for compiled FHIRPath with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestFHIRPath:
+    """Test cases for compiled FHIRPath expressions."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_compiled_fhirpath(self):
+        """Test compiled FHIRPath evaluation over single and batched resources."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        
+        observation = {
+            "resourceType": "Observation", "id": "bp", "status": "final",
+            "code": {"coding": [{"system": "http://snomed.info/sct", "code": "75367002"},
+                                {"system": "http://loinc.org", "code": "85354-9"}]},
+            "valueQuantity": {"value": 120.5, "unit": "mmHg"}
+        }
+        patient = {"resourceType": "Patient", "id": "p1", "name": [{"given": ["Ann", "Lee"]}]}
+        
+        path = fhir_parser_c.CompiledPath("Observation.code.coding.where(system = 'http://loinc.org').code")
+        assert path.expression.startswith("Observation.code")
+        assert path.evaluate(json.dumps(observation)) == ["85354-9"]
+        assert path.evaluate(json.dumps(patient).encode()) == []
+        document = fhir_parser_c.ParsedDocument(json.dumps(observation))
+        assert fhir_parser_c.CompiledPath("value.ofType(Quantity)").evaluate(document) == [
+            {"value": 120.5, "unit": "mmHg"}]
+        
+        results = self.parser.evaluate_paths(["id", "name.given", path], [patient, document])
+        assert results == [[["p1"], ["Ann", "Lee"], []], [["bp"], [], ["85354-9"]]]
+        
+        with pytest.raises(ValueError, match="offset"):
+            fhir_parser_c.CompiledPath("name.count()")
+        with pytest.raises(ValueError):
+            path.evaluate("invalid json string")
+        with pytest.raises(TypeError):
+            fhir_parser_c.evaluate_paths(["id"], [json.dumps(patient)])
@@ -0,0 +1,246 @@
+/**
+ * @file test_generated_codecs.c
+ * @brief Unit tests for the schema-driven codecs of generated resources
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_schema.h"
+#include "../resources/fhir_location.h"
+#include "../resources/fhir_organization.h"
+#include "../resources/fhir_practitionerrole.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* ORGANIZATION_JSON =
+    "{\"resourceType\":\"Organization\",\"id\":\"org1\","
+    "\"identifier\":[{\"use\":\"official\",\"system\":\"urn:oid:2.16\",\"value\":\"91654\","
+    "\"period\":{\"start\":\"2020-01-01\"}}],"
+    "\"active\":true,"
+    "\"type\":[{\"coding\":[{\"system\":\"http://terminology.hl7.org/CodeSystem/organization-type\","
+    "\"code\":\"prov\",\"display\":\"Healthcare Provider\"}],\"text\":\"Provider\"}],"
+    "\"name\":\"Burgers University Medical Center\",\"alias\":[\"BUMC\",\"Burgers\"],"
+    "\"description\":\"Teaching *hospital*\","
+    "\"contact\":[{\"telecom\":[{\"system\":\"phone\",\"value\":\"022-655 2300\",\"use\":\"work\"}]}],"
+    "\"partOf\":{\"reference\":\"Organization/parent\",\"display\":\"Burgers Group\"},"
+    "\"endpoint\":[{\"reference\":\"Endpoint/example\"}],"
+    "\"qualification\":[{\"code\":{\"text\":\"Accredited\"}}]}";
+
+/* ========================================================================== */
+/* Generated Resource Tests                                                   */
+/* ========================================================================== */
+
+bool test_organization_round_trip(void) {
+    cJSON* source = cJSON_Parse(ORGANIZATION_JSON);
+    ASSERT_NOT_NULL(source);
+    FHIROrganization* organization = fhir_organization_parse(ORGANIZATION_JSON);
+    ASSERT_NOT_NULL(organization);
+
+    // Every member lands in a typed field, each array sized to its elements
+    ASSERT_TRUE(fhir_organization_is_active(organization));
+    ASSERT_STR_EQ("Burgers University Medical Center", fhir_organization_get_display_name(organization));
+    ASSERT_EQ(1, organization->identifier_count);
+    ASSERT_STR_EQ("91654", organization->identifier[0]->value);
+    ASSERT_STR_EQ("2020-01-01", organization->identifier[0]->period->start->value);
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_DAY, organization->identifier[0]->period->start->parsed.precision);
+    ASSERT_EQ(1, organization->type[0]->coding_count);
+    ASSERT_STR_EQ("prov", organization->type[0]->coding[0]->code);
+    ASSERT_EQ(2, organization->alias_count);
+    ASSERT_STR_EQ("Burgers", organization->alias[1]->value);
+    ASSERT_STR_EQ("Organization/parent", organization->part_of->reference);
+    ASSERT_TRUE(cJSON_IsArray(organization->contact));
+    ASSERT_TRUE(cJSON_IsArray(organization->qualification));
+
+    cJSON* json = fhir_organization_to_json(organization);
+    ASSERT_NOT_NULL(json);
+    ASSERT_TRUE(cJSON_Compare(source, json, true));
+    ASSERT_TRUE(fhir_organization_validate(organization));
+
+    cJSON_Delete(json);
+    cJSON_Delete(source);
+    fhir_organization_destroy(organization);
+    return true;
+}
+
+bool test_clone_is_deep(void) {
+    FHIROrganization* organization = fhir_organization_parse(ORGANIZATION_JSON);
+    ASSERT_NOT_NULL(organization);
+    FHIROrganization* clone = fhir_organization_clone(organization);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_TRUE(fhir_organization_equals(organization, clone));
+    ASSERT_TRUE(clone->identifier[0] != organization->identifier[0]);
+    ASSERT_TRUE(clone->contact != organization->contact);
+
+    // The original can go away without affecting the clone
+    fhir_organization_destroy(organization);
+    ASSERT_STR_EQ("BUMC", clone->alias[0]->value);
+    ASSERT_STR_EQ("Healthcare Provider", clone->type[0]->coding[0]->display);
+
+    FHIROrganization* other = fhir_organization_clone(clone);
+    ASSERT_NOT_NULL(other);
+    other->active->value = false;
+    ASSERT_FALSE(fhir_organization_equals(clone, other));
+
+    fhir_organization_destroy(other);
+    fhir_organization_destroy(clone);
+    return true;
+}
+
+bool test_location_codes(void) {
+    FHIRLocation* location = fhir_location_parse(
+        "{\"resourceType\":\"Location\",\"id\":\"loc1\",\"status\":\"suspended\",\"mode\":\"not-a-mode\","
+        "\"name\":\"South Wing\",\"address\":{\"line\":[\"Galapagosweg 91\",\"Building A\"],"
+        "\"city\":\"Den Burg\",\"postalCode\":\"9105 PZ\"},"
+        "\"position\":{\"longitude\":-83.6945691,\"latitude\":42.25475478},"
+        "\"_name\":{\"extension\":[]}}");
+    ASSERT_NOT_NULL(location);
+
+    // Codes outside the value set are dropped, not mapped to another code
+    ASSERT_EQ(FHIR_LOCATION_STATUS_SUSPENDED, location->status);
+    ASSERT_EQ(FHIR_LOCATION_MODE_NONE, location->mode);
+    ASSERT_FALSE(fhir_location_is_active(location));
+    ASSERT_EQ(2, location->address->line_count);
+    ASSERT_STR_EQ("9105 PZ", location->address->postal_code);
+    ASSERT_NOT_NULL(cJSON_GetObjectItem(location->position, "latitude"));
+
+    // Members the schema does not know are recorded on the resource
+    ASSERT_EQ(1, location->base.unknown_member_count);
+    ASSERT_STR_EQ("_name", location->base.unknown_members[0]);
+
+    cJSON* json = fhir_location_to_json(location);
+    ASSERT_NOT_NULL(json);
+    ASSERT_STR_EQ("suspended", fhir_json_get_string(json, "status"));
+    ASSERT_NULL(cJSON_GetObjectItem(json, "mode"));
+    cJSON_Delete(json);
+    fhir_location_destroy(location);
+    return true;
+}
+
+bool test_mistyped_values_are_skipped(void) {
+    FHIRPractitionerRole* role = fhir_practitionerrole_parse(
+        "{\"resourceType\":\"PractitionerRole\",\"id\":\"pr1\",\"active\":\"yes\","
+        "\"period\":{\"start\":\"2012-01-01\",\"end\":\"not a date\"},"
+        "\"practitioner\":{\"reference\":\"Practitioner/example\"},"
+        "\"code\":[{\"text\":\"Doctor\"},42,{\"text\":\"Nurse\"}],"
+        "\"specialty\":{\"text\":\"not an array\"}}");
+    ASSERT_NOT_NULL(role);
+
+    ASSERT_NULL(role->active);
+    ASSERT_FALSE(fhir_practitionerrole_is_active(role));
+    ASSERT_NOT_NULL(role->period->start);
+    ASSERT_NULL(role->period->end);
+    ASSERT_EQ(0, role->specialty_count);
+
+    // Array entries keep their positions; unreadable ones stay NULL
+    ASSERT_EQ(3, role->code_count);
+    ASSERT_NULL(role->code[1]);
+    ASSERT_STR_EQ("Nurse", role->code[2]->text);
+
+    cJSON* json = fhir_practitionerrole_to_json(role);
+    ASSERT_NOT_NULL(json);
+    ASSERT_EQ(2, cJSON_GetArraySize(cJSON_GetObjectItem(json, "code")));
+    cJSON_Delete(json);
+    fhir_practitionerrole_destroy(role);
+
+    ASSERT_NULL(fhir_practitionerrole_parse("{\"resourceType\":\"Organization\",\"id\":\"pr1\"}"));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    return true;
+}
+
+/* ========================================================================== */
+/* Schema Runtime Tests                                                       */
+/* ========================================================================== */
+
+typedef struct {
+    FHIRResourceBase base;
+    FHIRReference* subject;
+    FHIRBoolean* deceased_boolean;
+    FHIRDateTime* deceased_date_time;
+} TestChoiceResource;
+
+static const FHIRSchemaField g_test_fields[] = {
+    { .key = "subject", .kind = FHIR_SCHEMA_COMPLEX, .flags = FHIR_SCHEMA_REQUIRED,
+      .offset = offsetof(TestChoiceResource, subject), .schema = NULL },
+    { .key = "deceasedBoolean", .kind = FHIR_SCHEMA_BOOLEAN, .choice = 1,
+      .offset = offsetof(TestChoiceResource, deceased_boolean) },
+    { .key = "deceasedDateTime", .kind = FHIR_SCHEMA_DATE_TIME, .choice = 1,
+      .offset = offsetof(TestChoiceResource, deceased_date_time) },
+};
+
+static int test_field_lookup(const char* key, size_t length) {
+    (void)length;
+    if (strcmp(key, "deceasedBoolean") == 0) return 1;
+    if (strcmp(key, "deceasedDateTime") == 0) return 2;
+    if (strcmp(key, "resourceType") == 0 || strcmp(key, "id") == 0) return FHIR_SCHEMA_MEMBER_BASE;
+    return FHIR_SCHEMA_MEMBER_UNKNOWN;
+}
+
+static const FHIRSchema g_test_schema = {
+    .name = "Test",
+    .size = sizeof(TestChoiceResource),
+    .fields = g_test_fields,
+    .field_count = sizeof(g_test_fields) / sizeof(g_test_fields[0]),
+    .lookup = test_field_lookup
+};
+
+static bool load_test_resource(const char* text, TestChoiceResource* resource) {
+    memset(resource, 0, sizeof(*resource));
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_schema_load_resource(&g_test_schema, resource, json);
+    cJSON_Delete(json);
+    return ok;
+}
+
+bool test_choice_types(void) {
+    TestChoiceResource resource;
+    ASSERT_TRUE(load_test_resource("{\"resourceType\":\"Test\",\"deceasedDateTime\":\"2015-02-07T13:28:17-05:00\"}",
+                                   &resource));
+    ASSERT_NULL(resource.deceased_boolean);
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_SECOND, resource.deceased_date_time->parsed.precision);
+    ASSERT_EQ(-300, resource.deceased_date_time->parsed.tz_offset_minutes);
+    fhir_schema_clear(&g_test_schema, &resource);
+
+    // A repeated key replaces the earlier value
+    ASSERT_TRUE(load_test_resource("{\"resourceType\":\"Test\",\"deceasedBoolean\":false,\"deceasedBoolean\":true}",
+                                   &resource));
+    ASSERT_TRUE(resource.deceased_boolean->value);
+    fhir_schema_clear(&g_test_schema, &resource);
+
+    // Two variants of one choice element are rejected
+    ASSERT_FALSE(load_test_resource("{\"resourceType\":\"Test\",\"deceasedBoolean\":true,"
+                                    "\"deceasedDateTime\":\"2015\"}", &resource));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    ASSERT_STR_EQ("deceasedDateTime", fhir_get_last_error()->field);
+    fhir_schema_clear(&g_test_schema, &resource);
+    return true;
+}
+
+bool test_required_fields(void) {
+    TestChoiceResource resource;
+    ASSERT_TRUE(load_test_resource("{\"resourceType\":\"Test\",\"deceasedBoolean\":true}", &resource));
+    ASSERT_FALSE(fhir_schema_validate(&g_test_schema, &resource));
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, fhir_get_last_error()->code);
+    ASSERT_STR_EQ("subject", fhir_get_last_error()->field);
+    fhir_schema_clear(&g_test_schema, &resource);
+
+    // Resource schemas only accept their own resource type
+    ASSERT_FALSE(load_test_resource("{\"resourceType\":\"Other\"}", &resource));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    fhir_schema_clear(&g_test_schema, &resource);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_organization_round_trip);
+    RUN_TEST(test_clone_is_deep);
+    RUN_TEST(test_location_codes);
+    RUN_TEST(test_mistyped_values_are_skipped);
+    RUN_TEST(test_choice_types);
+    RUN_TEST(test_required_fields);
+
+    TEST_FINALIZE();
+    return 0;
+}
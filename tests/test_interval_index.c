@@ -0,0 +1,201 @@
+/**
+ * @file test_interval_index.c
+ * @brief Unit tests for the Encounter/CarePlan period interval index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_interval_index.h"
+#include <string.h>
+
+static const char* ENCOUNTER_JSON =
+    "{\"resourceType\":\"Encounter\",\"id\":\"e1\",\"subject\":{\"reference\":\"Patient/1\"},"
+    "\"period\":{\"start\":\"2024-03-01T08:00:00Z\",\"end\":\"2024-03-03\"}}";
+
+static const char* OPEN_ENCOUNTER_JSON =
+    "{\"resourceType\":\"Encounter\",\"id\":\"e2\",\"subject\":{\"reference\":\"Patient/1\"},"
+    "\"actualPeriod\":{\"start\":\"2024-03-10\"}}";
+
+static const char* CAREPLAN_JSON =
+    "{\"resourceType\":\"CarePlan\",\"id\":\"c1\",\"subject\":{\"reference\":\"Patient/2\"},"
+    "\"period\":{\"start\":\"2024-01\",\"end\":\"2024-06\"},"
+    "\"activity\":[{\"detail\":{\"scheduledPeriod\":{\"start\":\"2024-02-01\",\"end\":\"2024-02-14\"}}},"
+    "{\"detail\":{\"status\":\"scheduled\"}},"
+    "{\"detail\":{\"scheduledPeriod\":{\"start\":\"2024-05-01\",\"end\":\"2024-04-01\"}}},"
+    "{\"detail\":{\"scheduledPeriod\":{\"start\":\"2024-03-01\",\"end\":\"2024-03-02\"}}}]}";
+
+static int64_t instant(const char* text) {
+    FHIRDateTimeValue value;
+    return fhir_datetime_parse(text, &value) ? value.epoch_us : 0;
+}
+
+// Parse, insert and free a resource
+static bool add(FHIRIntervalIndex* index, const char* text, size_t value, size_t* added) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_interval_index_add_json(index, json, value, added);
+    cJSON_Delete(json);
+    return ok;
+}
+
+static bool has_entry(const FHIRIntervalResult* result, const char* id, int activity) {
+    for (size_t i = 0; i < result->count; i++) {
+        if (strcmp(result->items[i]->id, id) == 0 && result->items[i]->activity == activity) return true;
+    }
+    return false;
+}
+
+/* ========================================================================== */
+/* Resource Tests                                                             */
+/* ========================================================================== */
+
+bool test_interval_index_resources(void) {
+    FHIRIntervalIndex* index = fhir_interval_index_create();
+    ASSERT_NOT_NULL(index);
+    size_t added;
+
+    ASSERT_TRUE(add(index, ENCOUNTER_JSON, 0, &added));
+    ASSERT_EQ(1, added);
+    ASSERT_TRUE(add(index, OPEN_ENCOUNTER_JSON, 1, &added));
+    ASSERT_EQ(1, added);
+    // Activities without a scheduledPeriod or with an inverted one add nothing
+    ASSERT_TRUE(add(index, CAREPLAN_JSON, 2, &added));
+    ASSERT_EQ(3, added);
+    ASSERT_EQ(5, fhir_interval_index_count(index));
+
+    ASSERT_FALSE(add(index, "{\"resourceType\":\"Patient\",\"id\":\"p\"}", 3, &added));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_FALSE(fhir_interval_index_add_json(index, NULL, 0, NULL));
+
+    FHIRIntervalResult result;
+    fhir_interval_result_init(&result);
+
+    // The end bound covers its whole day
+    ASSERT_TRUE(fhir_interval_index_at(index, "Patient/1", instant("2024-03-03T23:59:59Z"), &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_STR_EQ("e1", result.items[0]->id);
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_ENCOUNTER, result.items[0]->resource_type);
+    ASSERT_TRUE(fhir_interval_index_at(index, "Patient/1", instant("2024-03-04"), &result));
+    ASSERT_EQ(0, result.count);
+
+    // Open ends reach arbitrarily far
+    ASSERT_TRUE(fhir_interval_index_at(index, "Patient/1", instant("2999-01-01"), &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_STR_EQ("e2", result.items[0]->id);
+    ASSERT_EQ(1, result.items[0]->value);
+    ASSERT_EQ(FHIR_INTERVAL_INDEX_MAX, result.items[0]->end);
+
+    // Subjects are kept apart, NULL queries every subject
+    ASSERT_TRUE(fhir_interval_index_overlapping(index, "Patient/2", instant("2024-02-10"),
+                                                instant("2024-03-01T12:00:00Z"), &result));
+    ASSERT_EQ(3, result.count);
+    ASSERT_TRUE(has_entry(&result, "c1", FHIR_INTERVAL_INDEX_RESOURCE_PERIOD));
+    ASSERT_TRUE(has_entry(&result, "c1", 0));
+    ASSERT_TRUE(has_entry(&result, "c1", 3));
+    ASSERT_TRUE(fhir_interval_index_overlapping(index, NULL, instant("2024-03-01"), instant("2024-03-02"), &result));
+    ASSERT_EQ(3, result.count);
+    ASSERT_TRUE(fhir_interval_index_overlapping(index, "Patient/3", FHIR_INTERVAL_INDEX_MIN,
+                                                FHIR_INTERVAL_INDEX_MAX, &result));
+    ASSERT_EQ(0, result.count);
+
+    // Containment needs the whole window
+    ASSERT_TRUE(fhir_interval_index_containing(index, "Patient/2", instant("2024-02-01"), instant("2024-02-14"), &result));
+    ASSERT_EQ(2, result.count);
+    ASSERT_TRUE(fhir_interval_index_containing(index, "Patient/2", instant("2024-02-01"), instant("2024-02-16"), &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_EQ(FHIR_INTERVAL_INDEX_RESOURCE_PERIOD, result.items[0]->activity);
+
+    fhir_interval_result_cleanup(&result);
+    fhir_interval_index_destroy(index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Query Correctness Tests                                                    */
+/* ========================================================================== */
+
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static size_t brute_force(const FHIRIntervalEntry* entries, size_t count, const char* subject,
+                          int64_t start, int64_t end, bool contain) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (subject && strcmp(entries[i].subject, subject) != 0) continue;
+        bool match = contain ? entries[i].start <= start && entries[i].end >= end
+                             : entries[i].start < end && start < entries[i].end;
+        if (match) matches++;
+    }
+    return matches;
+}
+
+bool test_interval_index_matches_scan(void) {
+    enum { ENTRY_COUNT = 3000, QUERY_COUNT = 400 };
+    static const char* subjects[] = { "Patient/a", "Patient/b", "Patient/c" };
+    static FHIRIntervalEntry entries[ENTRY_COUNT];
+    uint32_t state = 42;
+
+    FHIRIntervalIndex* index = fhir_interval_index_create();
+    FHIRIntervalResult result;
+    fhir_interval_result_init(&result);
+
+    for (size_t i = 0; i < ENTRY_COUNT; i++) {
+        memset(&entries[i], 0, sizeof(entries[i]));
+        entries[i].subject = subjects[next_random(&state) % 3];
+        entries[i].start = (int64_t)(next_random(&state) % 100000);
+        entries[i].end = entries[i].start + 1 + (int64_t)(next_random(&state) % (i % 7 == 0 ? 20000 : 500));
+        entries[i].id = "x";
+        entries[i].value = i;
+        ASSERT_TRUE(fhir_interval_index_insert(index, &entries[i]));
+
+        // Query while part of the index is still pending
+        if (i % 500 == 499) {
+            size_t count = i + 1;
+            for (int q = 0; q < QUERY_COUNT / 8; q++) {
+                const char* subject = q % 4 == 3 ? NULL : subjects[q % 3];
+                int64_t start = (int64_t)(next_random(&state) % 100000);
+                int64_t end = start + 1 + (int64_t)(next_random(&state) % 3000);
+                ASSERT_TRUE(fhir_interval_index_overlapping(index, subject, start, end, &result));
+                ASSERT_EQ(brute_force(entries, count, subject, start, end, false), result.count);
+                ASSERT_TRUE(fhir_interval_index_containing(index, subject, start, end, &result));
+                ASSERT_EQ(brute_force(entries, count, subject, start, end, true), result.count);
+                ASSERT_TRUE(fhir_interval_index_at(index, subject, start, &result));
+                ASSERT_EQ(brute_force(entries, count, subject, start, start + 1, false), result.count);
+            }
+        }
+    }
+
+    ASSERT_TRUE(fhir_interval_index_build(index));
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        const char* subject = subjects[q % 3];
+        int64_t start = (int64_t)(next_random(&state) % 110000) - 5000;
+        int64_t end = start + 1 + (int64_t)(next_random(&state) % 5000);
+        ASSERT_TRUE(fhir_interval_index_overlapping(index, subject, start, end, &result));
+        ASSERT_EQ(brute_force(entries, ENTRY_COUNT, subject, start, end, false), result.count);
+        for (size_t i = 0; i < result.count; i++) {
+            ASSERT_STR_EQ(subject, result.items[i]->subject);
+        }
+    }
+
+    // Empty windows and entries are rejected
+    ASSERT_TRUE(fhir_interval_index_overlapping(index, NULL, 10, 10, &result));
+    ASSERT_EQ(0, result.count);
+    FHIRIntervalEntry empty = { 5, 5, NULL, NULL, FHIR_RESOURCE_TYPE_ENCOUNTER, -1, 0 };
+    ASSERT_FALSE(fhir_interval_index_insert(index, &empty));
+
+    fhir_interval_result_cleanup(&result);
+    fhir_interval_index_destroy(index);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_interval_index_resources);
+    RUN_TEST(test_interval_index_matches_scan);
+
+    TEST_FINALIZE();
+    return 0;
+}
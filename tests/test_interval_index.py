@@ -0,0 +1,47 @@
+"""Tests for the interval index with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestIntervalIndex:
+    """Test cases for the interval index."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_interval_index(self):
+        """Test overlap queries over Encounter and CarePlan periods."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        pytest.importorskip("fast_fhir.fhir_interval_c")
+        
+        resources = [
+            {"resourceType": "Encounter", "id": "e1", "subject": {"reference": "Patient/1"},
+             "period": {"start": "2024-03-01T08:00:00Z", "end": "2024-03-03"}},
+            {"resourceType": "Encounter", "id": "e2", "subject": {"reference": "Patient/1"},
+             "actualPeriod": {"start": "2024-03-10"}},
+            {"resourceType": "CarePlan", "id": "c1", "subject": {"reference": "Patient/2"},
+             "period": {"start": "2024-01", "end": "2024-06"},
+             "activity": [{"detail": {"scheduledPeriod": {"start": "2024-02-01", "end": "2024-02-14"}}}]},
+        ]
+        index = self.parser.build_interval_index(resources)
+        assert len(index) == 4
+        
+        assert index.overlapping("Patient/1", "2024-03-02", "2024-03-12") == [
+            ("Encounter", "e1", None, 1709280000000, 1709510400000),
+            ("Encounter", "e2", None, 1710028800000, None)]
+        assert [entry[1] for entry in index.at("Patient/1", "2030")] == ["e2"]
+        assert sorted(entry[2] is None for entry in index.containing("Patient/2", "2024-02-03", "2024-02-05")) == [False, True]
+        assert len(index.overlapping(None, None, None)) == 4
+        assert index.overlapping("Patient/3", None, None) == []
+        assert len(index.at(None, 1709300000000)) == 2
+        
+        assert index.add(fhir_parser_c.ParsedDocument(json.dumps(
+            {"resourceType": "Encounter", "id": "e3", "period": {"start": "2024-03-01"}}))) == 1
+        assert sorted(entry[1] for entry in index.at(None, "2024-03-02")) == ["c1", "e1", "e3"]
+        with pytest.raises(ValueError):
+            index.add('{"resourceType": "Patient", "id": "p"}')
+        with pytest.raises(ValueError):
+            index.overlapping(None, "not-a-date", None)
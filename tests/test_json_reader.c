@@ -0,0 +1,274 @@
+/**
+ * @file test_json_reader.c
+ * @brief Unit tests for the structural-index JSON parser backends
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_json_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const FHIRJSONBackend g_structural_backends[] = {
+    FHIR_JSON_BACKEND_SCALAR, FHIR_JSON_BACKEND_SSE2, FHIR_JSON_BACKEND_AVX2, FHIR_JSON_BACKEND_NEON
+};
+
+#define BACKEND_COUNT (sizeof(g_structural_backends) / sizeof(g_structural_backends[0]))
+
+// Parse with every supported structural backend and compare against cJSON
+static bool matches_cjson(const char* text, size_t length) {
+    cJSON* expected = cJSON_ParseWithLength(text, length);
+    if (!expected) return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < BACKEND_COUNT && ok; i++) {
+        if (!fhir_json_backend_supported(g_structural_backends[i])) continue;
+        cJSON* actual = fhir_json_parse_with_backend(g_structural_backends[i], text, length);
+        if (!actual || !cJSON_Compare(expected, actual, true)) {
+            printf("\n  %s differs from cJSON on: %.*s\n",
+                   fhir_json_backend_name(g_structural_backends[i]), (int)length, text);
+            ok = false;
+        }
+        cJSON_Delete(actual);
+    }
+    cJSON_Delete(expected);
+    return ok;
+}
+
+static bool rejected_by_all(const char* text) {
+    for (size_t i = 0; i < BACKEND_COUNT; i++) {
+        if (!fhir_json_backend_supported(g_structural_backends[i])) continue;
+        cJSON* json = fhir_json_parse_with_backend(g_structural_backends[i], text, strlen(text));
+        if (json) {
+            printf("\n  %s accepted: %s\n", fhir_json_backend_name(g_structural_backends[i]), text);
+            cJSON_Delete(json);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Parsing Tests                                                              */
+/* ========================================================================== */
+
+bool test_json_reader_documents(void) {
+    const char* documents[] = {
+        "{}", "[]", "\"\"", "0", "-0", "true", "null", "  [1, 2.5, -3e2, 1E-7]  \n",
+        "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true,\"deceasedBoolean\":false,"
+        "\"name\":[{\"family\":\"Chalmers\",\"given\":[\"Peter\",\"James\"]}],\"multipleBirthInteger\":2}",
+        "{\"resourceType\": \"Observation\",\n  \"valueQuantity\": {\"value\": 6.3, \"unit\": \"mmol/l\"},\n"
+        "  \"note\": [{\"text\": \"tab\\there, quote \\\" and slash \\/ and \\\\\"}]}",
+        "{\"text\":\"\\u00e9\\u20ac\\ud83d\\ude00 Zo\xc3\xab\",\"empty\":{},\"list\":[[],[{}]]}",
+        "{\"big\":12345678901234567890,\"exact\":123456789012345,\"small\":-9007199254740993}"
+    };
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+        ASSERT_TRUE(matches_cjson(documents[i], strlen(documents[i])));
+    }
+
+    // The length bounds the parse; the text need not be NUL-terminated
+    const char* padded = "{\"id\":\"a\"}GARBAGE";
+    ASSERT_TRUE(matches_cjson(padded, 10));
+    return true;
+}
+
+bool test_json_reader_block_boundaries(void) {
+    // Backslash runs, escaped quotes and literals straddling the 64-byte block edges
+    char text[512];
+    for (int shift = 0; shift < 70; shift++) {
+        int length = snprintf(text, sizeof(text),
+                              "{\"%*s\":\"%s\\\\\\\\\\\"%s\",\"n\":[true,%d,null],\"e\":\"\\\\\"}",
+                              shift, "k", "x", "yyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyy",
+                              12345 + shift);
+        ASSERT_TRUE(matches_cjson(text, (size_t)length));
+    }
+
+    // A long string of escaped backslashes spanning several blocks
+    size_t length = 0;
+    text[length++] = '[';
+    text[length++] = '"';
+    for (int i = 0; i < 150; i++) {
+        text[length++] = '\\';
+        text[length++] = '\\';
+    }
+    memcpy(text + length, "\\\"\",1]", 6);
+    length += 6;
+    ASSERT_TRUE(matches_cjson(text, length));
+    return true;
+}
+
+bool test_json_reader_invalid(void) {
+    const char* invalid[] = {
+        "", " ", "{", "[1,]", "{\"a\" 1}", "{\"a\":1,}", "tru", "true false", "[1 2]",
+        "\"abc", "{\"a\":\"b\"}x", "01", "1.", ".5", "-", "1e", "+1", "\"\\x\"", "\"\\u12\"",
+        "\"\\ud800\"", "{1:2}", "[,]", "]", "NaN", "[1]]", "\"a\"b", "\\\"a\"", "{\"a\":[1,2}",
+        "{\"a\"}", "{\"a\":}", "[1,,2]"
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        ASSERT_TRUE(rejected_by_all(invalid[i]));
+    }
+
+    // Nesting beyond the limit fails instead of recursing without bound
+    size_t depth = FHIR_JSON_NESTING_LIMIT + 1;
+    char* nested = malloc(depth * 2 + 1);
+    ASSERT_NOT_NULL(nested);
+    memset(nested, '[', depth);
+    memset(nested + depth, ']', depth);
+    nested[depth * 2] = '\0';
+    bool rejected = rejected_by_all(nested);
+    nested[0] = ' ';
+    nested[depth * 2 - 1] = ' ';
+    bool accepted = matches_cjson(nested, depth * 2);
+    free(nested);
+    ASSERT_TRUE(rejected);
+    ASSERT_TRUE(accepted);
+    return true;
+}
+
+/* ========================================================================== */
+/* Structural Index Tests                                                     */
+/* ========================================================================== */
+
+bool test_json_reader_structural_index(void) {
+    const char* text = "{\"a\\\"\": [true, -1],\"b\":\"{,}\"}";
+    const uint32_t expected[] = {0, 1, 5, 6, 8, 9, 13, 15, 17, 18, 19, 21, 22, 23, 27, 28};
+    size_t capacity = strlen(text) + 64;
+    uint32_t* index = malloc(capacity * sizeof(uint32_t));
+    ASSERT_NOT_NULL(index);
+
+    for (size_t i = 0; i < BACKEND_COUNT; i++) {
+        if (!fhir_json_backend_supported(g_structural_backends[i])) continue;
+        size_t count = 0;
+        ASSERT_TRUE(fhir_json_structural_index(g_structural_backends[i], text, strlen(text),
+                                               index, capacity, &count));
+        ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), count);
+        ASSERT_MEM_EQ(expected, index, sizeof(expected));
+    }
+
+    size_t count;
+    ASSERT_FALSE(fhir_json_structural_index(FHIR_JSON_BACKEND_SCALAR, "[\"open", 6, index, capacity, &count));
+    ASSERT_FALSE(fhir_json_structural_index(FHIR_JSON_BACKEND_SCALAR, text, strlen(text), index, 8, &count));
+    ASSERT_FALSE(fhir_json_structural_index(FHIR_JSON_BACKEND_CJSON, text, strlen(text), index, capacity, &count));
+    free(index);
+    return true;
+}
+
+bool test_json_reader_large_document(void) {
+    // Large enough to outgrow the on-stack index
+    size_t capacity = 256 * 1024;
+    char* text = malloc(capacity);
+    ASSERT_NOT_NULL(text);
+    size_t length = (size_t)snprintf(text, capacity, "{\"resourceType\":\"Bundle\",\"entry\":[");
+    for (int i = 0; i < 2000; i++) {
+        length += (size_t)snprintf(text + length, capacity - length,
+                                   "%s{\"resource\":{\"resourceType\":\"Observation\",\"id\":\"o%d\","
+                                   "\"valueQuantity\":{\"value\":%d.25,\"unit\":\"mg\"}}}",
+                                   i ? "," : "", i, i);
+    }
+    length += (size_t)snprintf(text + length, capacity - length, "]}");
+    bool ok = matches_cjson(text, length);
+    free(text);
+    ASSERT_TRUE(ok);
+    return true;
+}
+
+/* ========================================================================== */
+/* Member Span Tests                                                          */
+/* ========================================================================== */
+
+typedef struct {
+    const char* text;
+    char keys[8][16];
+    char values[8][64];
+    int count;
+    int stop_after;
+} MemberCapture;
+
+static bool capture_member(const FHIRJSONMemberSpan* member, void* context) {
+    MemberCapture* capture = context;
+    if (capture->count == capture->stop_after) return false;
+    snprintf(capture->keys[capture->count], sizeof(capture->keys[0]), "%.*s",
+             (int)member->key_length, capture->text + member->key_offset);
+    snprintf(capture->values[capture->count], sizeof(capture->values[0]), "%.*s",
+             (int)member->value_length, capture->text + member->value_offset);
+    capture->count++;
+    return true;
+}
+
+bool test_json_reader_object_members(void) {
+    const char* text = "{ \"resourceType\":\"Binary\", \"data\" : \"SGVs\\/bG8=\",\n"
+                       "  \"meta\":{\"tag\":[1,{\"a\":\"}\"}]}, \"n\": -1.5 , \"e\":[], \"t\":true}  ";
+    MemberCapture capture = {text, {{0}}, {{0}}, 0, -1};
+    ASSERT_TRUE(fhir_json_object_members(text, strlen(text), capture_member, &capture));
+    ASSERT_EQ(6, capture.count);
+    ASSERT_STR_EQ("resourceType", capture.keys[0]);
+    ASSERT_STR_EQ("\"Binary\"", capture.values[0]);
+    ASSERT_STR_EQ("data", capture.keys[1]);
+    ASSERT_STR_EQ("\"SGVs\\/bG8=\"", capture.values[1]);
+    ASSERT_STR_EQ("{\"tag\":[1,{\"a\":\"}\"}]}", capture.values[2]);
+    ASSERT_STR_EQ("-1.5", capture.values[3]);
+    ASSERT_STR_EQ("[]", capture.values[4]);
+    ASSERT_STR_EQ("true", capture.values[5]);
+
+    // A callback returning false stops the walk
+    MemberCapture stopped = {text, {{0}}, {{0}}, 0, 2};
+    ASSERT_FALSE(fhir_json_object_members(text, strlen(text), capture_member, &stopped));
+    ASSERT_EQ(2, stopped.count);
+
+    MemberCapture empty = {"{}", {{0}}, {{0}}, 0, -1};
+    ASSERT_TRUE(fhir_json_object_members("{}", 2, capture_member, &empty));
+    ASSERT_EQ(0, empty.count);
+
+    const char* invalid[] = {"[1]", "{\"a\"}", "{\"a\":1,}", "{\"a\":[1}", "{\"a\":1} 2", "{\"a\":\"x}", "{1:2}"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        MemberCapture ignored = {invalid[i], {{0}}, {{0}}, 0, -1};
+        ASSERT_FALSE(fhir_json_object_members(invalid[i], strlen(invalid[i]), capture_member, &ignored));
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Backend Selection Tests                                                    */
+/* ========================================================================== */
+
+bool test_json_reader_backend_selection(void) {
+    FHIRJSONBackend backend;
+    ASSERT_TRUE(fhir_json_backend_from_name("cjson", &backend));
+    ASSERT_EQ(FHIR_JSON_BACKEND_CJSON, backend);
+    ASSERT_FALSE(fhir_json_backend_from_name("simd", &backend));
+    ASSERT_STR_EQ("avx2", fhir_json_backend_name(FHIR_JSON_BACKEND_AVX2));
+
+    ASSERT_TRUE(fhir_json_set_backend(FHIR_JSON_BACKEND_AUTO));
+    ASSERT_NE(FHIR_JSON_BACKEND_AUTO, fhir_json_get_backend());
+    ASSERT_NE(FHIR_JSON_BACKEND_CJSON, fhir_json_get_backend());
+    ASSERT_TRUE(fhir_json_backend_supported(fhir_json_get_backend()));
+
+    ASSERT_TRUE(fhir_json_set_backend(FHIR_JSON_BACKEND_CJSON));
+    ASSERT_EQ(FHIR_JSON_BACKEND_CJSON, fhir_json_get_backend());
+    cJSON* json = fhir_json_parse("{\"id\":\"x\"}", 10);
+    ASSERT_NOT_NULL(json);
+    ASSERT_STR_EQ("x", fhir_json_get_string(json, "id"));
+    cJSON_Delete(json);
+
+    ASSERT_TRUE(fhir_json_set_backend(FHIR_JSON_BACKEND_SCALAR));
+    ASSERT_EQ(FHIR_JSON_BACKEND_SCALAR, fhir_json_get_backend());
+    ASSERT_TRUE(fhir_json_set_backend(FHIR_JSON_BACKEND_AUTO));
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_json_reader_documents);
+    RUN_TEST(test_json_reader_block_boundaries);
+    RUN_TEST(test_json_reader_invalid);
+    RUN_TEST(test_json_reader_structural_index);
+    RUN_TEST(test_json_reader_large_document);
+    RUN_TEST(test_json_reader_object_members);
+    RUN_TEST(test_json_reader_backend_selection);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * @file test_json_writer.c
+ * @brief Unit tests for the streaming JSON writer and vtable write_json
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_json_writer.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================== */
+/* Writer Tests                                                               */
+/* ========================================================================== */
+
+bool test_writer_buffer(void) {
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 4));  // Forces several reallocations
+
+    fhir_writer_begin_object(&writer);
+    fhir_writer_member_string(&writer, "text", "quote\" slash\\ tab\t line\n bell\x07 caf\xc3\xa9");
+    fhir_writer_member_int(&writer, "count", -42);
+    fhir_writer_member_bool(&writer, "flag", false);
+    fhir_writer_key(&writer, "values");
+    fhir_writer_begin_array(&writer);
+    fhir_writer_double(&writer, 0.1);
+    fhir_writer_double(&writer, 3.0);
+    fhir_writer_null(&writer);
+    fhir_writer_begin_object(&writer);
+    fhir_writer_end_object(&writer);
+    fhir_writer_end_array(&writer);
+    ASSERT_TRUE(fhir_writer_end_object(&writer));
+
+    size_t length;
+    char* text = fhir_writer_take_buffer(&writer, &length);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"text\":\"quote\\\" slash\\\\ tab\\t line\\n bell\\u0007 caf\xc3\xa9\","
+                  "\"count\":-42,\"flag\":false,\"values\":[0.1,3,null,{}]}", text);
+    ASSERT_EQ(strlen(text), length);
+
+    // Output parses back to the same values
+    cJSON* parsed = cJSON_Parse(text);
+    ASSERT_NOT_NULL(parsed);
+    ASSERT_STR_EQ("quote\" slash\\ tab\t line\n bell\x07 caf\xc3\xa9",
+                  cJSON_GetObjectItemCaseSensitive(parsed, "text")->valuestring);
+    cJSON_Delete(parsed);
+    fhir_free(text);
+    return true;
+}
+
+bool test_writer_errors(void) {
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+
+    // Unclosed containers are reported by finish
+    fhir_writer_begin_array(&writer);
+    ASSERT_FALSE(fhir_writer_finish(&writer));
+    ASSERT_EQ(FHIR_ERROR_SERIALIZE_FAILED, fhir_get_last_error()->code);
+
+    // Errors are sticky until reset
+    ASSERT_FALSE(fhir_writer_int(&writer, 1));
+    fhir_writer_reset(&writer);
+    ASSERT_TRUE(fhir_writer_int(&writer, 1));
+
+    // A second top-level value needs a line break in between
+    ASSERT_FALSE(fhir_writer_int(&writer, 2));
+    fhir_writer_reset(&writer);
+    ASSERT_TRUE(fhir_writer_int(&writer, 1) && fhir_writer_end_line(&writer) &&
+                fhir_writer_int(&writer, 2) && fhir_writer_finish(&writer));
+    ASSERT_STR_EQ("1\n2", writer.data);
+
+    fhir_writer_reset(&writer);
+    ASSERT_FALSE(fhir_writer_key(&writer, "top"));
+    fhir_writer_reset(&writer);
+    fhir_writer_begin_object(&writer);
+    ASSERT_FALSE(fhir_writer_member_string(&writer, "id", NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    fhir_writer_cleanup(&writer);
+    return true;
+}
+
+bool test_writer_cjson(void) {
+    const char* source = "{\"resourceType\":\"Bundle\",\"total\":2,\"score\":-1.5e-07,"
+                         "\"entry\":[{\"fullUrl\":\"urn:uuid:1\",\"search\":null},"
+                         "{\"deleted\":true,\"tags\":[]}],\"note\":\"line\\nnext\"}";
+    cJSON* json = cJSON_Parse(source);
+    ASSERT_NOT_NULL(json);
+
+    char* printed = cJSON_PrintUnformatted(json);
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+    ASSERT_TRUE(fhir_writer_cjson(&writer, json));
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    ASSERT_STR_EQ(printed, writer.data);
+
+    fhir_writer_cleanup(&writer);
+    free(printed);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_writer_fd(void) {
+    FILE* file = tmpfile();
+    ASSERT_NOT_NULL(file);
+
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_fd(&writer, fileno(file)));
+
+    // Larger than the staging buffer, so it is drained mid-value
+    size_t count = FHIR_WRITER_FD_BUFFER_SIZE / 4;
+    fhir_writer_begin_array(&writer);
+    for (size_t i = 0; i < count; i++) {
+        fhir_writer_int(&writer, (int64_t)(i % 10));
+    }
+    fhir_writer_end_array(&writer);
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    fhir_writer_cleanup(&writer);
+
+    long size = ftell(file);
+    ASSERT_EQ((long)(2 + count * 2 - 1), size);
+    rewind(file);
+    char head[8] = {0};
+    ASSERT_EQ(7, fread(head, 1, 7, file));
+    ASSERT_STR_EQ("[0,1,2,", head);
+
+    fclose(file);
+    ASSERT_FALSE(fhir_writer_init_fd(&writer, -1));
+    return true;
+}
+
+bool test_writer_canonical(void) {
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 4));
+    ASSERT_TRUE(fhir_writer_set_canonical(&writer, true));
+
+    // Members are sorted at every level, by unescaped name
+    fhir_writer_begin_object(&writer);
+    fhir_writer_key(&writer, "b");
+    fhir_writer_begin_object(&writer);
+    fhir_writer_key(&writer, "y");
+    fhir_writer_null(&writer);
+    fhir_writer_key(&writer, "x");
+    fhir_writer_begin_array(&writer);
+    fhir_writer_begin_object(&writer);
+    fhir_writer_member_int(&writer, "n", 2);
+    fhir_writer_member_int(&writer, "m", 1);
+    fhir_writer_end_object(&writer);
+    fhir_writer_end_array(&writer);
+    fhir_writer_end_object(&writer);
+    fhir_writer_member_int(&writer, "a\"", 3);
+    fhir_writer_member_int(&writer, "a", 2);
+    fhir_writer_member_int(&writer, "", 1);
+    fhir_writer_member_int(&writer, "a\x01", 4);
+    ASSERT_TRUE(fhir_writer_end_object(&writer));
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    ASSERT_STR_EQ("{\"\":1,\"a\":2,\"a\\u0001\":4,\"a\\\"\":3,\"b\":{\"x\":[{\"m\":1,\"n\":2}],\"y\":null}}",
+                  writer.data);
+
+    // Numbers take their shortest round-trip form, as JavaScript prints them
+    static const struct {
+        double value;
+        const char* expected;
+    } numbers[] = {
+        {3.0, "3"}, {-0.0, "0"}, {0.1, "0.1"}, {-123.456, "-123.456"}, {1e20, "100000000000000000000"},
+        {1e21, "1e+21"}, {0.000001, "0.000001"}, {1.5e-7, "1.5e-7"}, {5e-324, "5e-324"},
+        {1.7976931348623157e308, "1.7976931348623157e+308"}, {4.35, "4.35"}, {333333333.33333329, "333333333.3333333"},
+    };
+    for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+        fhir_writer_reset(&writer);
+        ASSERT_TRUE(fhir_writer_double(&writer, numbers[i].value));
+        ASSERT_TRUE(fhir_writer_finish(&writer));
+        ASSERT_STR_EQ(numbers[i].expected, writer.data);
+    }
+
+    // The mode cannot change once output was written
+    ASSERT_FALSE(fhir_writer_set_canonical(&writer, false));
+    fhir_writer_cleanup(&writer);
+
+    // Raw values cannot be canonicalized
+    cJSON* raw = cJSON_CreateRaw("{\"b\": 1, \"a\": 2}");
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+    ASSERT_TRUE(fhir_writer_set_canonical(&writer, true));
+    ASSERT_FALSE(fhir_writer_cjson(&writer, raw));
+    fhir_writer_cleanup(&writer);
+    cJSON_Delete(raw);
+    return true;
+}
+
+typedef struct {
+    char data[256];
+    size_t length;
+    int calls;
+} SinkOutput;
+
+static bool collect_output(void* context, const char* data, size_t length) {
+    SinkOutput* output = context;
+    if (output->length + length >= sizeof(output->data)) {
+        return false;
+    }
+    memcpy(output->data + output->length, data, length);
+    output->length += length;
+    output->calls++;
+    return true;
+}
+
+bool test_writer_sink(void) {
+    SinkOutput output = {{0}, 0, 0};
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_sink(&writer, collect_output, &output));
+    ASSERT_TRUE(fhir_writer_set_canonical(&writer, true));
+
+    // Each canonical value is completed before it reaches the sink
+    for (int i = 0; i < 2; i++) {
+        fhir_writer_begin_object(&writer);
+        fhir_writer_member_int(&writer, "z", i);
+        fhir_writer_member_bool(&writer, "a", i == 0);
+        fhir_writer_end_object(&writer);
+        ASSERT_TRUE(fhir_writer_end_line(&writer));
+    }
+    ASSERT_EQ(0, output.calls);
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    ASSERT_EQ(1, output.calls);
+    ASSERT_STR_EQ("{\"a\":true,\"z\":0}\n{\"a\":false,\"z\":1}\n", output.data);
+    ASSERT_NULL(fhir_writer_take_buffer(&writer, NULL));
+    fhir_writer_cleanup(&writer);
+
+    // A failing sink fails the writer
+    output.length = sizeof(output.data) - 1;
+    ASSERT_TRUE(fhir_writer_init_sink(&writer, collect_output, &output));
+    fhir_writer_string(&writer, "overflow");
+    ASSERT_FALSE(fhir_writer_finish(&writer));
+    fhir_writer_cleanup(&writer);
+
+    ASSERT_FALSE(fhir_writer_init_sink(&writer, NULL, NULL));
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Serialization Tests                                               */
+/* ========================================================================== */
+
+static bool check_same_as_to_json(const FHIRResourceBase* resource) {
+    cJSON* json = fhir_resource_to_json(resource);
+    ASSERT_NOT_NULL(json);
+    char* printed = cJSON_PrintUnformatted(json);
+
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+    ASSERT_TRUE(fhir_resource_write_json(resource, &writer));
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    ASSERT_STR_EQ(printed, writer.data);
+
+    fhir_writer_cleanup(&writer);
+    free(printed);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_patient_write_json(void) {
+    FHIRPatient* patient = fhir_patient_parse("{"
+        "\"resourceType\": \"Patient\","
+        "\"id\": \"writer-patient\","
+        "\"active\": true,"
+        "\"gender\": \"other\","
+        "\"birthDate\": \"1980-02-29\","
+        "\"deceasedDateTime\": \"2020-01-01T10:00:00Z\","
+        "\"identifier\": [{\"system\": \"urn:mrn\", \"value\": \"1\"}, {\"value\": \"2\"}]"
+    "}");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_NOT_NULL(patient->base.vtable->write_json);
+    ASSERT_TRUE(check_same_as_to_json(&patient->base));
+
+    // An empty patient only has the required members
+    FHIRPatient* minimal = fhir_patient_create("minimal");
+    ASSERT_NOT_NULL(minimal);
+    ASSERT_TRUE(check_same_as_to_json(&minimal->base));
+
+    // Resources without a streaming serializer go through to_json
+    FHIRResourceVTable fallback = *minimal->base.vtable;
+    fallback.write_json = NULL;
+    const FHIRResourceVTable* original = minimal->base.vtable;
+    minimal->base.vtable = &fallback;
+    ASSERT_TRUE(check_same_as_to_json(&minimal->base));
+    minimal->base.vtable = original;
+
+    fhir_patient_destroy(patient);
+    fhir_patient_destroy(minimal);
+    return true;
+}
+
+static char* write_canonical(const FHIRResourceBase* resource, const cJSON* tree) {
+    FHIRWriter writer;
+    if (!fhir_writer_init_buffer(&writer, 0) || !fhir_writer_set_canonical(&writer, true)) {
+        return NULL;
+    }
+    bool written = tree ? fhir_writer_cjson(&writer, tree) : fhir_resource_write_json(resource, &writer);
+    char* text = written ? fhir_writer_take_buffer(&writer, NULL) : NULL;
+    fhir_writer_cleanup(&writer);
+    return text;
+}
+
+bool test_patient_canonical_json(void) {
+    FHIRPatient* patient = fhir_patient_parse("{"
+        "\"resourceType\": \"Patient\","
+        "\"id\": \"canonical\","
+        "\"gender\": \"female\","
+        "\"active\": false,"
+        "\"name\": [{\"given\": [\"Ann\"], \"family\": \"Doe\"}]"
+    "}");
+    ASSERT_NOT_NULL(patient);
+
+    char* text = write_canonical(&patient->base, NULL);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"active\":false,\"gender\":\"female\",\"id\":\"canonical\","
+                  "\"name\":[{\"family\":\"Doe\",\"given\":[\"Ann\"]}],\"resourceType\":\"Patient\"}", text);
+
+    // The member order of the source does not matter
+    cJSON* reordered = cJSON_Parse("{\"name\": [{\"family\": \"Doe\", \"given\": [\"Ann\"]}],"
+                                   "\"active\": false, \"resourceType\": \"Patient\","
+                                   "\"gender\": \"female\", \"id\": \"canonical\"}");
+    ASSERT_NOT_NULL(reordered);
+    char* from_tree = write_canonical(NULL, reordered);
+    ASSERT_NOT_NULL(from_tree);
+    ASSERT_STR_EQ(text, from_tree);
+
+    fhir_free(text);
+    fhir_free(from_tree);
+    cJSON_Delete(reordered);
+    fhir_patient_destroy(patient);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_writer_buffer);
+    RUN_TEST(test_writer_errors);
+    RUN_TEST(test_writer_cjson);
+    RUN_TEST(test_writer_fd);
+    RUN_TEST(test_writer_canonical);
+    RUN_TEST(test_writer_sink);
+    RUN_TEST(test_patient_write_json);
+    RUN_TEST(test_patient_canonical_json);
+
+    TEST_FINALIZE();
+    return 0;
+}
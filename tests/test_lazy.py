@@ -0,0 +1,49 @@
+"""Tests for lazily converted resources with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestLazyResource:
+    """Test cases for LazyResource."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_lazy_resource(self):
+        """Test LazyResource members converted on attribute access."""
+        fhir_lazy_c = pytest.importorskip("fast_fhir.fhir_lazy_c")
+        import pickle
+        
+        entries = [{"resource": {"resourceType": "Patient", "id": f"p{i}", "birthDate": "1990-01-01",
+                                 "name": [{"family": f"F{i}", "given": ["A", "B"]}]}}
+                   for i in range(1000)]
+        bundle = {"resourceType": "Bundle", "type": "collection", "entry": entries}
+        lazy = self.parser.parse_lazy(json.dumps(bundle))
+        assert isinstance(lazy, fhir_lazy_c.LazyResource)
+        assert lazy.resource_type == "Bundle"
+        assert len(lazy.entry) == 1000
+        patient = lazy.entry[-1].resource
+        assert (patient.id, patient.birth_date, patient.birthDate) == ("p999", "1990-01-01", "1990-01-01")
+        assert patient.name[0].family == "F999"
+        assert patient.name[0].given[0:2] == ["A", "B"]
+        assert patient.name is patient.name
+        assert patient.gender is None
+        assert "name" in patient and "gender" not in patient
+        assert patient.keys() == ["resourceType", "id", "birthDate", "name"]
+        assert patient.to_dict() == entries[-1]["resource"]
+        with pytest.raises(AttributeError):
+            patient._missing
+        with pytest.raises(IndexError):
+            lazy.entry[1000]
+        
+        restored = pickle.loads(pickle.dumps(patient))
+        assert restored.to_dict() == patient.to_dict()
+        assert pickle.loads(pickle.dumps(patient.name))[0].family == "F999"
+        
+        with pytest.raises(ValueError):
+            fhir_lazy_c.parse_lazy("[1, 2]")
+        with pytest.raises(ValueError):
+            fhir_lazy_c.lazy_from_binary(b"not a document")
@@ -0,0 +1,212 @@
+/**
+ * @file test_lazy_patient.c
+ * @brief Unit tests for lazily parsed Patients
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../resources/fhir_patient.h"
+#include "../common/fhir_binary.h"
+#include "../common/fhir_json_writer.h"
+#include <pthread.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"example\",\"active\":true,\"gender\":\"male\","
+    "\"birthDate\":\"1974-12-25\",\"identifier\":[{\"use\":\"usual\",\"system\":\"urn:oid:1.2.36\"}],"
+    "\"name\":[{\"use\":\"official\",\"family\":\"Chalmers\",\"given\":[\"Peter\",\"James\"]},"
+    "{\"use\":\"usual\",\"given\":[\"Jim\"]},\"not an object\"],"
+    "\"telecom\":[{\"system\":\"phone\",\"value\":\"(03) 5555 6473\",\"use\":\"work\",\"rank\":1}],"
+    "\"address\":[{\"use\":\"home\",\"line\":[\"534 Erewhon St\"],\"city\":\"PleasantVille\","
+    "\"postalCode\":\"3999\"}],\"managingOrganization\":{\"reference\":\"Organization/1\"}}";
+
+#define READER_THREADS 8
+
+/* ========================================================================== */
+/* Materialization Tests                                                      */
+/* ========================================================================== */
+
+bool test_lazy_patient_matches_eager(void) {
+    FHIRPatient* eager = fhir_patient_parse(PATIENT_JSON);
+    FHIRPatient* lazy = fhir_patient_parse_lazy(PATIENT_JSON);
+    ASSERT_NOT_NULL(eager);
+    ASSERT_NOT_NULL(lazy);
+
+    // Scalars are read up front, sub-structures on first access
+    ASSERT_EQ(FHIR_PATIENT_GENDER_MALE, lazy->gender);
+    ASSERT_STR_EQ("1974-12-25", lazy->birth_date->value);
+    ASSERT_NULL(lazy->name);
+    ASSERT_NULL(lazy->managing_organization);
+
+    const FHIRHumanName* name = fhir_patient_get_primary_name(lazy);
+    ASSERT_NOT_NULL(name);
+    ASSERT_STR_EQ("official", name->use);
+    ASSERT_EQ(1, name->family_count);
+    ASSERT_STR_EQ("Chalmers", name->family[0]);
+    ASSERT_EQ(2, name->given_count);
+    ASSERT_STR_EQ("James", name->given[1]);
+    ASSERT_NULL(lazy->address);
+
+    size_t count;
+    FHIRHumanName* const* names = fhir_patient_get_names(lazy, &count);
+    ASSERT_EQ(3, count);
+    ASSERT_TRUE(names[0] == name);
+    ASSERT_NULL(names[2]);
+    FHIRContactPoint* const* telecoms = fhir_patient_get_telecoms(lazy, &count);
+    ASSERT_EQ(1, count);
+    ASSERT_EQ(1, telecoms[0]->rank);
+    ASSERT_STR_EQ("PleasantVille", fhir_patient_get_primary_address(lazy)->city);
+    ASSERT_STR_EQ("Organization/1", fhir_patient_get_managing_organization(lazy)->reference);
+    FHIRPatient* empty = fhir_patient_create("empty");
+    ASSERT_NULL(fhir_patient_get_names(empty, &count));
+    ASSERT_EQ(0, count);
+    fhir_resource_release(&empty->base);
+
+    // Both modes serialize the same, and the lazy one materializes what is left
+    ASSERT_TRUE(fhir_patient_equals(eager, lazy));
+    cJSON* expected = fhir_patient_to_json(eager);
+    cJSON* actual = fhir_patient_to_json(lazy);
+    ASSERT_NOT_NULL(actual);
+    ASSERT_TRUE(cJSON_Compare(expected, actual, true));
+    const cJSON* family = cJSON_GetObjectItem(cJSON_GetArrayItem(cJSON_GetObjectItem(actual, "name"), 0), "family");
+    ASSERT_STR_EQ("Chalmers", cJSON_GetStringValue(family));
+
+    // The streaming writer produces the same document
+    FHIRWriter writer;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+    ASSERT_TRUE(fhir_resource_write_json(&lazy->base, &writer));
+    ASSERT_TRUE(fhir_writer_finish(&writer));
+    char* printed = cJSON_PrintUnformatted(actual);
+    ASSERT_STR_EQ(printed, writer.data);
+    ASSERT_TRUE(strstr(printed, "\"given\":[\"Peter\",\"James\"]") != NULL);
+    cJSON_free(printed);
+    fhir_writer_cleanup(&writer);
+    cJSON_Delete(expected);
+    cJSON_Delete(actual);
+
+    fhir_resource_release(&eager->base);
+    fhir_resource_release(&lazy->base);
+    return true;
+}
+
+typedef struct {
+    FHIRPatient* patient;
+    const FHIRHumanName* name;
+    const FHIRAddress* address;
+    bool materialized;
+} LazyReader;
+
+static void* read_lazy_patient(void* arg) {
+    LazyReader* reader = arg;
+    reader->name = fhir_patient_get_primary_name(reader->patient);
+    reader->address = fhir_patient_get_primary_address(reader->patient);
+    reader->materialized = fhir_patient_materialize(reader->patient);
+    return NULL;
+}
+
+bool test_lazy_patient_concurrent_access(void) {
+    for (int round = 0; round < 50; round++) {
+        FHIRPatient* patient = fhir_patient_parse_lazy(PATIENT_JSON);
+        ASSERT_NOT_NULL(patient);
+
+        pthread_t threads[READER_THREADS];
+        LazyReader readers[READER_THREADS];
+        for (int i = 0; i < READER_THREADS; i++) {
+            readers[i] = (LazyReader){ .patient = patient };
+            ASSERT_EQ(0, pthread_create(&threads[i], NULL, read_lazy_patient, &readers[i]));
+        }
+        for (int i = 0; i < READER_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        // Each field is built once and every reader sees the same one
+        for (int i = 0; i < READER_THREADS; i++) {
+            ASSERT_TRUE(readers[i].materialized);
+            ASSERT_TRUE(readers[i].name == patient->name[0]);
+            ASSERT_TRUE(readers[i].address == patient->address[0]);
+        }
+        fhir_resource_release(&patient->base);
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* Interaction Tests                                                          */
+/* ========================================================================== */
+
+bool test_lazy_patient_binary_round_trip(void) {
+    FHIRPatient* lazy = fhir_patient_parse_lazy(PATIENT_JSON);
+    ASSERT_NOT_NULL(lazy);
+
+    size_t length;
+    uint8_t* data = fhir_resource_to_binary(&lazy->base, &length);
+    ASSERT_NOT_NULL(data);
+    FHIRPatient* loaded = (FHIRPatient*)fhir_resource_from_binary(data, length);
+    ASSERT_NOT_NULL(loaded);
+    fhir_free(data);
+
+    ASSERT_EQ(3, loaded->name_count);
+    ASSERT_NULL(loaded->name[2]);
+    ASSERT_STR_EQ("Peter", loaded->name[0]->given[0]);
+    ASSERT_STR_EQ("3999", loaded->address[0]->postal_code);
+    cJSON* expected = fhir_patient_to_json(lazy);
+    cJSON* actual = fhir_patient_to_json(loaded);
+    ASSERT_TRUE(cJSON_Compare(expected, actual, true));
+    cJSON_Delete(expected);
+    cJSON_Delete(actual);
+
+    fhir_resource_release(&lazy->base);
+    fhir_resource_release(&loaded->base);
+    return true;
+}
+
+bool test_lazy_patient_modify_and_clone(void) {
+    FHIRPatient* patient = fhir_patient_parse_lazy(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+
+    // Added names go after the parsed ones and are copied
+    char text[] = "Added";
+    FHIRHumanName added = { .text = text };
+    ASSERT_TRUE(fhir_patient_add_name(patient, &added));
+    text[0] = 'X';
+    ASSERT_EQ(4, patient->name_count);
+    ASSERT_STR_EQ("Added", patient->name[3]->text);
+
+    FHIRPatient* clone = fhir_patient_clone_cow(patient);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_TRUE(clone->address == patient->address);
+
+    // Detaching deep-copies, so the clone survives its source
+    ASSERT_TRUE(fhir_patient_add_address(clone, patient->address[0]));
+    fhir_resource_release(&patient->base);
+    ASSERT_EQ(2, clone->address_count);
+    ASSERT_STR_EQ("534 Erewhon St", clone->address[0]->line[0]);
+    ASSERT_STR_EQ("PleasantVille", clone->address[1]->city);
+    fhir_resource_release(&clone->base);
+
+    // Under an arena the parse is eager
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    FHIRPatient* arena_patient = fhir_patient_parse_lazy(PATIENT_JSON);
+    fhir_arena_set_current(previous);
+    ASSERT_NOT_NULL(arena_patient);
+    ASSERT_NULL(arena_patient->lazy_json);
+    ASSERT_EQ(3, arena_patient->name_count);
+    fhir_arena_destroy(arena);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_lazy_patient_matches_eager);
+    RUN_TEST(test_lazy_patient_concurrent_access);
+    RUN_TEST(test_lazy_patient_binary_round_trip);
+    RUN_TEST(test_lazy_patient_modify_and_clone);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file test_match_index.c
+ * @brief Unit tests for the Patient matching blocking index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_match_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static FHIRMatchRecord make_record(const char* id, const char* family, const char* given,
+                                   const char* birth_date, const char* gender, const char* postal_code) {
+    FHIRMatchRecord record;
+    memset(&record, 0, sizeof(record));
+    record.id = id;
+    record.family = family;
+    record.given = given;
+    record.birth_date = birth_date;
+    record.gender = gender;
+    record.postal_code = postal_code;
+    return record;
+}
+
+static bool has_pair(const FHIRMatchResult* result, size_t a, size_t b) {
+    for (size_t i = 0; i < result->count; i++) {
+        if (result->items[i].a == a && result->items[i].b == b) return true;
+    }
+    return false;
+}
+
+/* ========================================================================== */
+/* Soundex Tests                                                              */
+/* ========================================================================== */
+
+bool test_soundex_codes(void) {
+    static const char* cases[][2] = {
+        { "Robert", "R163" }, { "Rupert", "R163" }, { "Rubin", "R150" },
+        { "Ashcraft", "A261" }, { "Tymczak", "T522" }, { "Pfister", "P236" },
+        { "Honeyman", "H555" }, { "o'brien", "O165" }, { "Lee", "L000" }
+    };
+    char code[5];
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ASSERT_TRUE(fhir_soundex(cases[i][0], code));
+        ASSERT_STR_EQ(cases[i][1], code);
+    }
+
+    ASSERT_FALSE(fhir_soundex("", code));
+    ASSERT_STR_EQ("", code);
+    ASSERT_FALSE(fhir_soundex("\xe7\x8e\x8b", code));
+    ASSERT_FALSE(fhir_soundex(NULL, code));
+    return true;
+}
+
+/* ========================================================================== */
+/* Scoring Tests                                                              */
+/* ========================================================================== */
+
+bool test_match_scores(void) {
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    FHIRMatchRecord records[] = {
+        make_record("a", "Smith", "John", "1980-04-12", "male", "02139"),
+        make_record("b", "SMITH", "john", "1980-04-12", "male", "02139-4307"),
+        make_record("c", "Smyth", "Jon", "1980-12-04", "male", "02139"),
+        make_record("d", "Smith", "Mary", "1975-01-01", "female", "90210"),
+        make_record("e", "Smith", "John", "1980", NULL, NULL),
+    };
+    for (size_t i = 0; i < 5; i++) {
+        ASSERT_TRUE(fhir_match_index_add(index, &records[i], i * 10));
+    }
+    ASSERT_EQ(5, fhir_match_index_count(index));
+    ASSERT_STR_EQ("c", fhir_match_index_get_id(index, 2));
+    ASSERT_EQ(20, fhir_match_index_get_value(index, 2));
+    ASSERT_NULL(fhir_match_index_get_id(index, 5));
+
+    // Case, punctuation and ZIP+4 normalize away: family 4, given 3, birth 5, gender 0.5, postal 2
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 1) == 14.5);
+    // Phonetic names and a transposed day and month
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 2) == 2.0 + 1.5 + 2.5 + 0.5 + 2.0);
+    // Different given name, birth date, gender and postal code
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 3) == 4.0 - 2.0 - 4.0 - 3.0 - 0.5);
+    // A year-only birth date agrees partially; missing fields are neutral
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 4) == 4.0 + 3.0 + 1.0);
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 9) == 0.0);
+
+    FHIRMatchRecord missing = make_record(NULL, "Smith", NULL, NULL, NULL, NULL);
+    ASSERT_FALSE(fhir_match_index_add(index, &missing, 0));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    fhir_match_index_destroy(index);
+    return true;
+}
+
+bool test_match_identifiers(void) {
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    // Same MRN under a new surname and address: only the identifier block joins them
+    FHIRMatchRecord a = make_record("a", "Garcia", "Maria", "1990-06-01", "female", "10001");
+    a.identifier_system[0] = "urn:mrn";
+    a.identifier_value[0] = "123-45";
+    a.identifier_count = 1;
+    FHIRMatchRecord b = make_record("b", "Lopez", "Maria", "1990-06-01", "female", "60601");
+    b.identifier_system[0] = "urn:mrn";
+    b.identifier_value[0] = "123-45";
+    b.identifier_count = 1;
+    // Same name and birth date but a conflicting MRN
+    FHIRMatchRecord c = make_record("c", "Garcia", "Maria", "1990-06-01", "female", "10001");
+    c.identifier_system[0] = "urn:mrn";
+    c.identifier_value[0] = "999-99";
+    c.identifier_count = 1;
+
+    ASSERT_TRUE(fhir_match_index_add(index, &a, 0));
+    ASSERT_TRUE(fhir_match_index_add(index, &b, 1));
+    ASSERT_TRUE(fhir_match_index_add(index, &c, 2));
+
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 1) == -3.0 + 3.0 + 5.0 + 0.5 - 0.5 + 8.0);
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 2) == 4.0 + 3.0 + 5.0 + 0.5 + 2.0 - 8.0);
+
+    FHIRMatchResult result;
+    fhir_match_result_init(&result);
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, NULL, &result, NULL));
+    ASSERT_EQ(1, result.count);
+    ASSERT_TRUE(has_pair(&result, 0, 1));
+
+    fhir_match_result_cleanup(&result);
+    fhir_match_index_destroy(index);
+    return true;
+}
+
+bool test_match_add_json(void) {
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    cJSON* patient = cJSON_Parse(
+        "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"gender\":\"female\",\"birthDate\":\"1970-02-03\","
+        "\"identifier\":[{\"system\":\"urn:ssn\",\"value\":\"111\"}],"
+        "\"name\":[{\"use\":\"nickname\",\"family\":\"X\"},{\"use\":\"official\",\"family\":\"Doe\",\"given\":[\"Ann\",\"Marie\"]}],"
+        "\"address\":[{\"line\":[\"1 Main St\"],\"postalCode\":\"02139\"}]}");
+    cJSON* twin = cJSON_Parse(
+        "{\"resourceType\":\"Patient\",\"id\":\"p2\",\"gender\":\"female\",\"birthDate\":\"1970-02-03\","
+        "\"name\":[{\"family\":\"Doe\",\"given\":[\"Ann\"]}],"
+        "\"address\":[{\"line\":[\"1 MAIN ST.\"],\"postalCode\":\"02139\"}]}");
+    cJSON* observation = cJSON_Parse("{\"resourceType\":\"Observation\",\"id\":\"o1\"}");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_NOT_NULL(twin);
+    ASSERT_NOT_NULL(observation);
+
+    ASSERT_TRUE(fhir_match_index_add_json(index, patient, 7));
+    ASSERT_TRUE(fhir_match_index_add_json(index, twin, 8));
+    ASSERT_FALSE(fhir_match_index_add_json(index, observation, 9));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_EQ(2, fhir_match_index_count(index));
+
+    // The official name is used, and the address line normalizes
+    ASSERT_TRUE(fhir_match_index_score(index, 0, 1) == 4.0 + 3.0 + 5.0 + 0.5 + 2.0 + 2.0);
+
+    FHIRMatchResult result;
+    fhir_match_result_init(&result);
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, NULL, &result, NULL));
+    ASSERT_EQ(1, result.count);
+    ASSERT_TRUE(result.items[0].score == 16.5);
+
+    fhir_match_result_cleanup(&result);
+    cJSON_Delete(patient);
+    cJSON_Delete(twin);
+    cJSON_Delete(observation);
+    fhir_match_index_destroy(index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Pair Search Tests                                                          */
+/* ========================================================================== */
+
+// Three duplicates of patient 0 (exact, typo in the name, surname changed)
+// among unrelated patients; the pair 0-1 shares every blocking key
+bool test_match_find_pairs(void) {
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    FHIRMatchRecord records[] = {
+        make_record("0", "Johnson", "Emily", "1985-03-15", "female", "30301"),
+        make_record("1", "Johnson", "Emily", "1985-03-15", "female", "30301"),
+        make_record("2", "Jonson", "Emily", "1985-03-15", "female", "30301"),
+        make_record("3", "Williams", "Emily", "1985-03-15", "female", "30301"),
+        make_record("4", "Johnson", "Robert", "1950-07-04", "male", "30301"),
+        make_record("5", "Brown", "Emily", "1985-03-15", "female", "94105"),
+    };
+    for (size_t i = 0; i < 4; i++) {
+        records[i].address_line = "12 Peachtree St";
+    }
+    for (size_t i = 0; i < 6; i++) {
+        ASSERT_TRUE(fhir_match_index_add(index, &records[i], i));
+    }
+
+    FHIRMatchOptions options;
+    fhir_match_options_init(&options);
+    options.thread_count = 1;
+
+    FHIRMatchResult result;
+    FHIRMatchStats stats;
+    fhir_match_result_init(&result);
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, &options, &result, &stats));
+
+    ASSERT_TRUE(has_pair(&result, 0, 1));
+    ASSERT_TRUE(has_pair(&result, 0, 2));
+    ASSERT_TRUE(has_pair(&result, 1, 2));
+    ASSERT_TRUE(has_pair(&result, 0, 3));
+    ASSERT_FALSE(has_pair(&result, 0, 4));
+    ASSERT_FALSE(has_pair(&result, 0, 5));
+    for (size_t i = 0; i < result.count; i++) {
+        ASSERT_TRUE(result.items[i].a < result.items[i].b);
+        ASSERT_TRUE(result.items[i].score >= FHIR_MATCH_DEFAULT_THRESHOLD);
+        ASSERT_TRUE(result.items[i].score == fhir_match_index_score(index, result.items[i].a, result.items[i].b));
+        if (i > 0) {
+            // Sorted and reported once, although 0-1 shares four blocks
+            const FHIRMatchPair* previous = &result.items[i - 1];
+            ASSERT_TRUE(previous->a < result.items[i].a ||
+                        (previous->a == result.items[i].a && previous->b < result.items[i].b));
+        }
+    }
+    ASSERT_TRUE(stats.blocks >= 4);
+    ASSERT_EQ(0, stats.skipped_blocks);
+    ASSERT_TRUE(stats.comparisons > result.count);
+
+    // Capping the block size drops the two blocks of four
+    options.max_block_size = 3;
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, &options, &result, &stats));
+    ASSERT_TRUE(stats.skipped_blocks >= 1);
+    ASSERT_FALSE(has_pair(&result, 0, 3));
+    ASSERT_TRUE(has_pair(&result, 0, 1));
+
+    fhir_match_result_cleanup(&result);
+    fhir_match_index_destroy(index);
+    return true;
+}
+
+// A generated population with planted duplicates: every duplicate is found,
+// and the worker pool returns the same pairs as one thread
+bool test_match_worker_pool(void) {
+    static const char* families[] = { "Miller", "Davis", "Wilson", "Moore", "Taylor", "Anderson",
+                                      "Thomas", "Jackson", "White", "Harris", "Martin", "Clark" };
+    static const char* givens[] = { "James", "Mary", "Linda", "David", "Susan", "Karen", "Paul" };
+    const size_t count = 4000;
+
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    char id[32], birth[16], postal[8];
+    size_t planted = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Every tenth patient repeats the one before it
+        size_t source = i % 10 == 9 ? i - 1 : i;
+        if (source != i) planted++;
+        snprintf(id, sizeof(id), "pat-%zu", i);
+        snprintf(birth, sizeof(birth), "%04zu-%02zu-%02zu", 1930 + source * 7 % 80, 1 + source * 5 % 12,
+                 1 + source * 11 % 28);
+        snprintf(postal, sizeof(postal), "%05zu", 10000 + source * 13 % 300);
+
+        FHIRMatchRecord record = make_record(id, families[source * 3 % 12], givens[source % 7], birth,
+                                             source % 2 ? "male" : "female", postal);
+        ASSERT_TRUE(fhir_match_index_add(index, &record, i));
+    }
+
+    FHIRMatchOptions options;
+    fhir_match_options_init(&options);
+    options.thread_count = 1;
+
+    FHIRMatchResult single, pooled;
+    FHIRMatchStats single_stats, pooled_stats;
+    fhir_match_result_init(&single);
+    fhir_match_result_init(&pooled);
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, &options, &single, &single_stats));
+    options.thread_count = 8;
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, &options, &pooled, &pooled_stats));
+
+    for (size_t i = 9; i < count; i += 10) {
+        ASSERT_TRUE(has_pair(&single, i - 1, i));
+    }
+    ASSERT_TRUE(single.count >= planted);
+    // Blocking keeps the work far below the n^2 / 2 pairs
+    ASSERT_TRUE(single_stats.comparisons < count * 50);
+
+    ASSERT_EQ(single.count, pooled.count);
+    ASSERT_EQ(single_stats.comparisons, pooled_stats.comparisons);
+    ASSERT_EQ(single_stats.blocks, pooled_stats.blocks);
+    ASSERT_TRUE(memcmp(single.items, pooled.items, single.count * sizeof(FHIRMatchPair)) == 0);
+
+    fhir_match_result_cleanup(&single);
+    fhir_match_result_cleanup(&pooled);
+    fhir_match_index_destroy(index);
+    return true;
+}
+
+bool test_match_empty_index(void) {
+    FHIRMatchIndex* index = fhir_match_index_create();
+    ASSERT_NOT_NULL(index);
+
+    FHIRMatchResult result;
+    FHIRMatchStats stats;
+    fhir_match_result_init(&result);
+    ASSERT_TRUE(fhir_match_index_find_pairs(index, NULL, &result, &stats));
+    ASSERT_EQ(0, result.count);
+    ASSERT_EQ(0, stats.blocks);
+    ASSERT_FALSE(fhir_match_index_find_pairs(NULL, NULL, &result, NULL));
+
+    fhir_match_result_cleanup(&result);
+    fhir_match_index_destroy(index);
+    fhir_match_index_destroy(NULL);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_soundex_codes);
+    RUN_TEST(test_match_scores);
+    RUN_TEST(test_match_identifiers);
+    RUN_TEST(test_match_add_json);
+    RUN_TEST(test_match_find_pairs);
+    RUN_TEST(test_match_worker_pool);
+    RUN_TEST(test_match_empty_index);
+
+    TEST_FINALIZE();
+    return 0;
+}
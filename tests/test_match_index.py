@@ -0,0 +1,57 @@
+"""Tests for Patient matching with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestMatchIndex:
+    """Test cases for the Patient matching index."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_match_index(self):
+        """Test Patient duplicates found by the blocking index, also from NDJSON."""
+        fhir_match_c = pytest.importorskip("fast_fhir.fhir_match_c")
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        
+        def patient(id, family, given, birth_date, postal_code):
+            return {"resourceType": "Patient", "id": id, "gender": "female", "birthDate": birth_date,
+                    "name": [{"family": family, "given": [given]}],
+                    "address": [{"postalCode": postal_code}]}
+        
+        patients = [
+            patient("a", "Johnson", "Emily", "1985-03-15", "30301"),
+            patient("b", "Jonson", "Emily", "1985-03-15", "30301-1234"),
+            patient("c", "Johnson", "Robert", "1950-07-04", "30301"),
+            patient("d", "Brown", "Anna", "1985-03-15", "94105"),
+        ]
+        
+        index = fhir_match_c.MatchIndex()
+        assert index.add(json.dumps(patients[0])) == 0
+        assert index.add(fhir_ndjson_c.parse_resource(json.dumps(patients[1]))) == 1
+        with pytest.raises(ValueError):
+            index.add(json.dumps({"resourceType": "Observation", "id": "o1"}))
+        for p in patients[2:]:
+            index.add(json.dumps(p))
+        assert len(index) == 4
+        
+        pairs = index.pairs(threads=2)
+        assert [(a, b) for a, b, _ in pairs] == [("a", "b")]
+        assert pairs[0][2] >= 8.0
+        assert index.stats()["comparisons"] >= 1
+        
+        # Built on the C NDJSON reader's worker threads
+        data = "\n".join(json.dumps(p) for p in patients * 2).encode()
+        streamed = fhir_match_c.MatchIndex(threshold=13.0)
+        assert streamed.add_ndjson(data, threads=2, batch_size=3) == 8
+        assert len(streamed) == 8
+        assert sorted(streamed.pairs()) == [(id, id, 14.5) for id in "abcd"]
+        assert self.parser.find_duplicate_patients(data, threads=2, threshold=13.0) == streamed.pairs()
+        
+        with pytest.raises(AttributeError):
+            index.add(object())
+        with pytest.raises(OSError):
+            streamed.add_ndjson("/nonexistent/patients.ndjson")
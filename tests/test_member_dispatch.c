@@ -0,0 +1,126 @@
+/**
+ * @file test_member_dispatch.c
+ * @brief Unit tests for the generated single-pass JSON member dispatch
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../resources/fhir_patient.h"
+#include "../resources/fhir_patient_members.h"
+#include "../common/fhir_resource_type_lookup.h"
+#include <string.h>
+
+/* ========================================================================== */
+/* Member Lookup Tests                                                        */
+/* ========================================================================== */
+
+bool test_patient_member_lookup(void) {
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_RESOURCE_TYPE, fhir_patient_member_lookup("resourceType"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_ID, fhir_patient_member_lookup("id"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_BIRTH_DATE, fhir_patient_member_lookup("birthDate"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_BOOLEAN, fhir_patient_member_lookup("multipleBirthBoolean"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_MULTIPLE_BIRTH_INTEGER, fhir_patient_member_lookup("multipleBirthInteger"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_MANAGING_ORGANIZATION, fhir_patient_member_lookup("managingOrganization"));
+    
+    // JSON member names are case-sensitive
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_UNKNOWN, fhir_patient_member_lookup("Active"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_UNKNOWN, fhir_patient_member_lookup("_birthDate"));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_UNKNOWN, fhir_patient_member_lookup(""));
+    ASSERT_EQ(FHIR_PATIENT_MEMBER_UNKNOWN, fhir_patient_member_lookup("lin"));
+    
+    return true;
+}
+
+/* ========================================================================== */
+/* from_json Dispatch Tests                                                   */
+/* ========================================================================== */
+
+bool test_patient_from_json_dispatch(void) {
+    cJSON* json = cJSON_Parse("{"
+        "\"resourceType\": \"Patient\","
+        "\"id\": \"dispatch\","
+        "\"birthDate\": \"1970-01-01\","
+        "\"_birthDate\": {\"extension\": [{\"url\": \"http://example.org/accuracy\"}]},"
+        "\"gender\": \"other\","
+        "\"deceasedDateTime\": \"2020-01-01T00:00:00Z\","
+        "\"identifier\": [{\"value\": \"a\"}, {\"value\": \"b\"}],"
+        "\"Active\": true,"
+        "\"active\": false"
+    "}");
+    ASSERT_NOT_NULL(json);
+    
+    FHIRPatient* patient = fhir_patient_create("dispatch");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_TRUE(fhir_patient_from_json(patient, json));
+    
+    ASSERT_NOT_NULL(patient->active);
+    ASSERT_FALSE(patient->active->value);
+    ASSERT_EQ(FHIR_PATIENT_GENDER_OTHER, patient->gender);
+    ASSERT_STR_EQ("1970-01-01", patient->birth_date->value);
+    ASSERT_NOT_NULL(patient->deceased_date_time);
+    ASSERT_EQ(2, patient->identifier_count);
+    
+    // Unknown members are collected in document order
+    ASSERT_EQ(2, patient->base.unknown_member_count);
+    ASSERT_STR_EQ("_birthDate", patient->base.unknown_members[0]);
+    ASSERT_STR_EQ("Active", patient->base.unknown_members[1]);
+    
+    fhir_patient_destroy(patient);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_patient_from_json_wrong_type(void) {
+    cJSON* json = cJSON_Parse("{\"resourceType\": \"Observation\", \"id\": \"x\"}");
+    FHIRPatient* patient = fhir_patient_create("x");
+    ASSERT_FALSE(fhir_patient_from_json(patient, json));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    
+    fhir_patient_destroy(patient);
+    cJSON_Delete(json);
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Type Lookup Tests                                                 */
+/* ========================================================================== */
+
+bool test_resource_type_lookup(void) {
+    // Every enumerated type has a name that maps back to it
+    for (int i = 1; i < FHIR_RESOURCE_TYPE_COUNT; i++) {
+        const char* name = fhir_resource_type_to_string((FHIRResourceType)i);
+        ASSERT_NOT_NULL(name);
+        ASSERT_EQ(i, fhir_resource_type_from_string(name));
+        ASSERT_EQ(i, fhir_resource_type_from_string_n(name, strlen(name)));
+    }
+    
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_CARE_PLAN, fhir_resource_type_from_string("CarePlan"));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_SUBSTANCE_REFERENCE_INFORMATION,
+              fhir_resource_type_from_string("SubstanceReferenceInformation"));
+    
+    // Names are matched exactly, including length
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_PATIENT, fhir_resource_type_from_string_n("Patients", 7));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string("Patients"));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string("patient"));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string("Unknown"));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string("DomainResource"));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string(""));
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, fhir_resource_type_from_string(NULL));
+    
+    // Same answer as the generated lookup used by the Python bindings
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_BUNDLE, fhir_resource_type_lookup("Bundle", 6));
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    
+    RUN_TEST(test_patient_member_lookup);
+    RUN_TEST(test_patient_from_json_dispatch);
+    RUN_TEST(test_patient_from_json_wrong_type);
+    RUN_TEST(test_resource_type_lookup);
+    
+    TEST_FINALIZE();
+    return 0;
+}
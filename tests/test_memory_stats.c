@@ -0,0 +1,172 @@
+/**
+ * @file test_memory_stats.c
+ * @brief Unit tests for allocation accounting in the fhir_* allocators
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_common.h"
+#include "../resources/fhir_patient.h"
+#include <pthread.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"gender\":\"female\",\"birthDate\":\"1980-05-17\","
+    "\"name\":[{\"family\":\"Doe\",\"given\":[\"Jane\"]}]}";
+
+/* ========================================================================== */
+/* Counter Tests                                                              */
+/* ========================================================================== */
+
+bool test_memory_disabled(void) {
+    ASSERT_FALSE(fhir_memory_stats_enabled());
+
+    FHIRMemoryStats before, after;
+    fhir_memory_get_stats(&before);
+    fhir_free(fhir_malloc(64));
+    fhir_memory_get_stats(&after);
+    ASSERT_EQ(before.allocations, after.allocations);
+    ASSERT_EQ(before.frees, after.frees);
+    return true;
+}
+
+bool test_memory_heap_counters(void) {
+    if (!FHIR_MEMORY_STATS) return true;
+
+    ASSERT_FALSE(fhir_memory_stats_set_enabled(true));
+    fhir_memory_stats_reset();
+    FHIRMemoryStats stats;
+    fhir_memory_get_stats(&stats);
+    int64_t start = stats.live_bytes;
+    ASSERT_EQ(0, stats.allocations);
+    ASSERT_EQ(start, stats.peak_bytes);
+
+    char* a = fhir_malloc(100);
+    char* b = fhir_calloc(10, 100);
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    fhir_memory_get_stats(&stats);
+    ASSERT_EQ(2, stats.allocations);
+    ASSERT_TRUE(stats.bytes_allocated >= 1100);
+    ASSERT_EQ(start + (int64_t)stats.bytes_allocated, stats.live_bytes);
+
+    // A reallocation is a free and an allocation
+    a = fhir_realloc(a, 5000);
+    ASSERT_NOT_NULL(a);
+    fhir_memory_get_stats(&stats);
+    ASSERT_EQ(3, stats.allocations);
+    ASSERT_EQ(1, stats.frees);
+
+    fhir_free(a);
+    fhir_free(b);
+    fhir_memory_get_stats(&stats);
+    ASSERT_EQ(3, stats.frees);
+    ASSERT_EQ(stats.bytes_allocated, stats.bytes_freed);
+    ASSERT_EQ(start, stats.live_bytes);
+    ASSERT_TRUE(stats.peak_bytes >= start + 5000 + 1000);
+
+    // The calling thread did all of it
+    FHIRMemoryStats thread;
+    fhir_memory_get_thread_stats(&thread);
+    ASSERT_EQ(stats.allocations, thread.allocations);
+    ASSERT_EQ(stats.bytes_freed, thread.bytes_freed);
+
+    ASSERT_TRUE(fhir_memory_stats_set_enabled(false));
+    fhir_free(fhir_malloc(64));
+    fhir_memory_get_stats(&thread);
+    ASSERT_EQ(stats.allocations, thread.allocations);
+    return true;
+}
+
+static void* allocate_on_thread(void* arg) {
+    for (int i = 0; i < 10; i++) {
+        fhir_free(fhir_malloc(128));
+    }
+    fhir_memory_get_thread_stats(arg);
+    return NULL;
+}
+
+bool test_memory_thread_counters(void) {
+    if (!FHIR_MEMORY_STATS) return true;
+
+    fhir_memory_stats_set_enabled(true);
+    fhir_memory_stats_reset();
+
+    FHIRMemoryStats worker;
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, allocate_on_thread, &worker));
+    pthread_join(thread, NULL);
+    ASSERT_EQ(10, worker.allocations);
+    ASSERT_EQ(10, worker.frees);
+    ASSERT_EQ(0, worker.live_bytes);
+
+    // Process-wide counters include the worker; this thread's do not
+    FHIRMemoryStats stats, own;
+    fhir_memory_get_stats(&stats);
+    fhir_memory_get_thread_stats(&own);
+    ASSERT_EQ(10, stats.allocations);
+    ASSERT_EQ(0, own.allocations);
+
+    fhir_memory_stats_set_enabled(false);
+    return true;
+}
+
+/* ========================================================================== */
+/* Attribution Tests                                                          */
+/* ========================================================================== */
+
+bool test_memory_type_attribution(void) {
+    if (!FHIR_MEMORY_STATS) return true;
+
+    fhir_memory_stats_set_enabled(true);
+    fhir_memory_stats_reset();
+
+    FHIRMemoryTypeStats type_stats;
+    FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    ASSERT_TRUE(fhir_memory_get_type_stats(FHIR_RESOURCE_TYPE_PATIENT, &type_stats));
+    ASSERT_TRUE(type_stats.allocations >= 3);
+    ASSERT_TRUE(type_stats.bytes_allocated >= sizeof(FHIRPatient));
+    size_t heap_allocations = type_stats.allocations;
+
+    // Nothing else is charged to Patient outside its entry points
+    fhir_free(fhir_malloc(64));
+    ASSERT_TRUE(fhir_memory_get_type_stats(FHIR_RESOURCE_TYPE_PATIENT, &type_stats));
+    ASSERT_EQ(heap_allocations, type_stats.allocations);
+    fhir_patient_destroy(patient);
+
+    // Arena-served allocations are attributed and counted as arena allocations
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+    cJSON* json = cJSON_Parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(json);
+    FHIRMemoryStats before, after;
+    fhir_memory_get_stats(&before);
+    ASSERT_NOT_NULL(fhir_resource_parse_with_arena(arena, json));
+    fhir_memory_get_stats(&after);
+    ASSERT_EQ(before.allocations, after.allocations);
+    ASSERT_TRUE(after.arena_allocations - before.arena_allocations >= 3);
+    ASSERT_TRUE(fhir_memory_get_type_stats(FHIR_RESOURCE_TYPE_PATIENT, &type_stats));
+    ASSERT_TRUE(type_stats.allocations >= heap_allocations + 3);
+    cJSON_Delete(json);
+    fhir_arena_destroy(arena);
+
+    ASSERT_FALSE(fhir_memory_get_type_stats(FHIR_RESOURCE_TYPE_COUNT, &type_stats));
+    ASSERT_EQ(0, fhir_memory_set_type(FHIR_RESOURCE_TYPE_UNKNOWN));
+    fhir_memory_stats_set_enabled(false);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_memory_disabled);
+    RUN_TEST(test_memory_heap_counters);
+    RUN_TEST(test_memory_thread_counters);
+    RUN_TEST(test_memory_type_attribution);
+
+    TEST_FINALIZE();
+    return 0;
+}
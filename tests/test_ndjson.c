@@ -0,0 +1,298 @@
+/**
+ * @file test_ndjson.c
+ * @brief Unit tests for the multi-threaded NDJSON reader
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_ndjson.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+static const char* g_ndjson =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true}\n"
+    "\n"
+    "{not json}\r\n"
+    "{\"resourceType\":\"Patient\",\"id\":\"p2\",\"gender\":\"female\"}\r\n"
+    "{\"id\":\"no-type\"}\n"
+    "{\"resourceType\":\"Patient\",\"id\":\"bad id\"}\n"
+    "{\"resourceType\":\"Observation\",\"id\":\"o1\"}\n"
+    "{\"resourceType\":\"Patient\",\"id\":\"p3\"}";
+
+static void register_types(void) {
+    if (fhir_resource_get_instance_size(FHIR_RESOURCE_TYPE_PATIENT) == 0) {
+        fhir_patient_register();
+    }
+}
+
+/* ========================================================================== */
+/* Batch Parsing Tests                                                        */
+/* ========================================================================== */
+
+// Parse data (g_ndjson, plain or compressed) and check the results
+static bool check_batches_of(const char* data, size_t length, size_t thread_count,
+                             size_t batch_size) {
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = thread_count;
+    options.batch_size = batch_size;
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open_buffer(data, length, &options);
+    ASSERT_NOT_NULL(reader);
+
+    size_t typed = 0, untyped = 0, errors = 0, total = 0;
+    size_t error_lines[8];
+    FHIRNDJSONResult* results;
+    size_t count;
+
+    while ((results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            total++;
+            if (results[i].error_code != FHIR_ERROR_NONE) {
+                error_lines[errors++] = results[i].line_number;
+                ASSERT_TRUE(strlen(results[i].error_message) > 0);
+                ASSERT_NULL(results[i].resource);
+            } else if (results[i].resource) {
+                typed++;
+                ASSERT_EQ(FHIR_RESOURCE_TYPE_PATIENT, results[i].resource->resource_type);
+            } else {
+                untyped++;
+                ASSERT_EQ(FHIR_RESOURCE_TYPE_OBSERVATION, results[i].resource_type);
+            }
+        }
+    }
+
+    ASSERT_EQ(7, total);  // Blank line is skipped
+    ASSERT_EQ(3, typed);  // p1, p2, p3
+    ASSERT_EQ(1, untyped);  // Observation has no registered parser
+    ASSERT_EQ(3, errors);
+    ASSERT_EQ(3, error_lines[0]);  // Invalid JSON
+    ASSERT_EQ(5, error_lines[1]);  // Missing resourceType
+    ASSERT_EQ(6, error_lines[2]);  // Invalid id
+
+    ASSERT_FALSE(fhir_ndjson_failed(reader));
+
+    fhir_ndjson_close(reader);
+    return true;
+}
+
+static bool check_batches(size_t thread_count, size_t batch_size) {
+    return check_batches_of(g_ndjson, strlen(g_ndjson), thread_count, batch_size);
+}
+
+bool test_ndjson_single_thread(void) {
+    register_types();
+    return check_batches(1, 3);
+}
+
+bool test_ndjson_worker_pool(void) {
+    register_types();
+    return check_batches(4, 2) && check_batches(3, 100);
+}
+
+bool test_ndjson_strict_types(void) {
+    register_types();
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = 2;
+    options.strict_types = true;
+    options.keep_json = true;
+
+    const char* data = "{\"resourceType\":\"Observation\",\"id\":\"o1\"}\n"
+                       "{\"resourceType\":\"Patient\",\"id\":\"p1\"}\n";
+    FHIRNDJSONReader* reader = fhir_ndjson_open_buffer(data, strlen(data), &options);
+    ASSERT_NOT_NULL(reader);
+
+    size_t count;
+    FHIRNDJSONResult* results = fhir_ndjson_next_batch(reader, &count);
+    ASSERT_NOT_NULL(results);
+    ASSERT_EQ(2, count);
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, results[0].error_code);
+    ASSERT_NULL(results[0].json);
+    ASSERT_EQ(FHIR_ERROR_NONE, results[1].error_code);
+    ASSERT_NOT_NULL(results[1].json);
+
+    // Take ownership of the typed resource
+    FHIRResourceBase* resource = results[1].resource;
+    results[1].resource = NULL;
+    ASSERT_STR_EQ("p1", resource->id);
+
+    ASSERT_NULL(fhir_ndjson_next_batch(reader, &count));
+    ASSERT_EQ(0, count);
+
+    fhir_ndjson_close(reader);
+    fhir_resource_release(resource);
+    return true;
+}
+
+bool test_ndjson_open_file(void) {
+    register_types();
+
+    const char* path = "test_ndjson_input.ndjson";
+    FILE* file = fopen(path, "wb");
+    ASSERT_NOT_NULL(file);
+    fputs(g_ndjson, file);
+    fclose(file);
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open(path, NULL);
+    ASSERT_NOT_NULL(reader);
+    ASSERT_TRUE(fhir_ndjson_get_thread_count(reader) >= 1);
+
+    size_t total = 0, count;
+    while (fhir_ndjson_next_batch(reader, &count) != NULL) {
+        total += count;
+    }
+    ASSERT_EQ(7, total);
+
+    fhir_ndjson_close(reader);
+    remove(path);
+
+    ASSERT_NULL(fhir_ndjson_open("does-not-exist.ndjson", NULL));
+    ASSERT_EQ(FHIR_ERROR_IO, fhir_get_last_error()->code);
+    return true;
+}
+
+/* ========================================================================== */
+/* Compressed Input Tests                                                     */
+/* ========================================================================== */
+
+// gzip data as one member per part, concatenated (as pigz and bgzip write)
+static unsigned char* gzip_members(const char* data, size_t length, size_t parts, size_t* out_length) {
+    size_t capacity = compressBound((uLong)length) + parts * 64;
+    unsigned char* out = malloc(capacity);
+    size_t used = 0;
+
+    for (size_t i = 0; i < parts; i++) {
+        size_t begin = length * i / parts;
+        size_t end = length * (i + 1) / parts;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        stream.next_in = (Bytef*)(data + begin);
+        stream.avail_in = (uInt)(end - begin);
+        stream.next_out = out + used;
+        stream.avail_out = (uInt)(capacity - used);
+        deflate(&stream, Z_FINISH);
+        used = capacity - stream.avail_out;
+        deflateEnd(&stream);
+    }
+
+    *out_length = used;
+    return out;
+}
+
+bool test_ndjson_gzip_members(void) {
+    register_types();
+
+    // Member boundaries fall inside lines
+    size_t length;
+    unsigned char* gz = gzip_members(g_ndjson, strlen(g_ndjson), 3, &length);
+    ASSERT_EQ(FHIR_COMPRESSION_GZIP, fhir_compression_detect(gz, length));
+
+    bool passed = check_batches_of((const char*)gz, length, 1, 3) &&
+                  check_batches_of((const char*)gz, length, 4, 2) &&
+                  check_batches_of((const char*)gz, length, 3, 100);
+    free(gz);
+    return passed;
+}
+
+bool test_ndjson_gzip_many_blocks(void) {
+    register_types();
+
+    // Several decompressed blocks, so lines straddle block boundaries
+    const size_t line_count = 60000;
+    size_t capacity = line_count * 64;
+    char* text = malloc(capacity);
+    size_t length = 0;
+    for (size_t i = 0; i < line_count; i++) {
+        length += (size_t)snprintf(text + length, capacity - length,
+                                   "{\"resourceType\":\"Patient\",\"id\":\"p%zu\"}\n", i);
+    }
+    ASSERT_TRUE(length > 2 * FHIR_DECOMPRESS_BLOCK_SIZE);
+
+    size_t gz_length;
+    unsigned char* gz = gzip_members(text, length, 2, &gz_length);
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = 4;
+    options.batch_size = 3000;
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open_buffer((const char*)gz, gz_length, &options);
+    ASSERT_NOT_NULL(reader);
+
+    size_t total = 0, count;
+    FHIRNDJSONResult* results;
+    char expected[32];
+    while ((results = fhir_ndjson_next_batch(reader, &count)) != NULL) {
+        for (size_t i = 0; i < count; i++, total++) {
+            ASSERT_EQ(total + 1, results[i].line_number);
+            ASSERT_NOT_NULL(results[i].resource);
+            snprintf(expected, sizeof(expected), "p%zu", total);
+            ASSERT_STR_EQ(expected, results[i].resource->id);
+        }
+    }
+    ASSERT_EQ(line_count, total);
+    ASSERT_FALSE(fhir_ndjson_failed(reader));
+
+    fhir_ndjson_close(reader);
+    free(gz);
+    free(text);
+    return true;
+}
+
+bool test_ndjson_gzip_truncated(void) {
+    register_types();
+
+    size_t length;
+    unsigned char* gz = gzip_members(g_ndjson, strlen(g_ndjson), 1, &length);
+
+    FHIRNDJSONReader* reader = fhir_ndjson_open_buffer((const char*)gz, length - 12, NULL);
+    ASSERT_NOT_NULL(reader);
+
+    size_t count;
+    while (fhir_ndjson_next_batch(reader, &count) != NULL) {
+    }
+    ASSERT_TRUE(fhir_ndjson_failed(reader));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+    ASSERT_NULL(fhir_ndjson_next_batch(reader, &count));
+
+    fhir_ndjson_close(reader);
+    free(gz);
+    return true;
+}
+
+bool test_ndjson_zstd_detection(void) {
+    static const unsigned char frame[] = { 0x28, 0xb5, 0x2f, 0xfd, 0x00, 0x00 };
+    ASSERT_EQ(FHIR_COMPRESSION_ZSTD, fhir_compression_detect(frame, sizeof(frame)));
+    ASSERT_EQ(FHIR_COMPRESSION_NONE, fhir_compression_detect(g_ndjson, strlen(g_ndjson)));
+
+    if (!fhir_compression_available(FHIR_COMPRESSION_ZSTD)) {
+        // Built without libzstd: refuse rather than parse compressed bytes as text
+        ASSERT_NULL(fhir_ndjson_open_buffer((const char*)frame, sizeof(frame), NULL));
+        ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    }
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_ndjson_single_thread);
+    RUN_TEST(test_ndjson_worker_pool);
+    RUN_TEST(test_ndjson_strict_types);
+    RUN_TEST(test_ndjson_open_file);
+    RUN_TEST(test_ndjson_gzip_members);
+    RUN_TEST(test_ndjson_gzip_many_blocks);
+    RUN_TEST(test_ndjson_gzip_truncated);
+    RUN_TEST(test_ndjson_zstd_detection);
+
+    TEST_FINALIZE();
+    return 0;
+}
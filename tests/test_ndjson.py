@@ -0,0 +1,88 @@
+"""Tests for NDJSON parsing with C extensions."""
+
+import gzip
+import json
+import os
+import tempfile
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+from fast_fhir.resources.patient import Patient
+
+
+class TestNDJSON:
+    """Test cases for NDJSON parsing."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_parse_ndjson(self):
+        """Test batched NDJSON parsing with per-line errors."""
+        lines = [json.dumps({"resourceType": "Patient", "id": f"p{i}", "active": True})
+                 for i in range(10)]
+        lines.insert(3, "{not json")
+        lines.insert(5, "")
+        data = "\n".join(lines).encode()
+        
+        with tempfile.NamedTemporaryFile(suffix=".ndjson", delete=False) as f:
+            f.write(data)
+            path = f.name
+        
+        try:
+            for source in (path, data):
+                resources, errors = [], []
+                for batch_resources, batch_errors in self.parser.parse_ndjson(source, threads=2, batch_size=4):
+                    resources.extend(batch_resources)
+                    errors.extend(batch_errors)
+                
+                assert [r.id for r in resources] == [f"p{i}" for i in range(10)]
+                assert all(isinstance(r, Patient) for r in resources)
+                assert errors == [(4, "Invalid JSON")]
+        finally:
+            os.remove(path)
+    
+    def test_ndjson_as_bytes(self):
+        """Test NDJSON batches serialized to compact JSON bytes by the C writer."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        
+        lines = [json.dumps({"resourceType": "Patient", "id": "p1", "active": True, "gender": "male"}),
+                 "{not json",
+                 json.dumps({"resourceType": "Observation", "id": "o1", "note": [{"text": "a\nb \u00e9"}]})]
+        data = "\n".join(lines).encode()
+        
+        resources, errors = [], []
+        for batch_resources, batch_errors in fhir_ndjson_c.NDJSONReader(data, threads=1, as_bytes=True):
+            resources.extend(batch_resources)
+            errors.extend(batch_errors)
+        
+        assert all(isinstance(r, bytes) for r in resources)
+        assert resources[0] == b'{"resourceType":"Patient","id":"p1","active":true,"gender":"male"}'
+        compact = json.dumps(json.loads(lines[2]), separators=(",", ":"), ensure_ascii=False)
+        assert resources[1] == compact.encode()
+        assert errors == [(2, "Invalid JSON")]
+    
+    def test_ndjson_gzip(self):
+        """Test multi-member gzip NDJSON decompressed while it is parsed."""
+        fhir_ndjson_c = pytest.importorskip("fast_fhir.fhir_ndjson_c")
+        
+        lines = [json.dumps({"resourceType": "Patient", "id": f"p{i}"}) for i in range(5000)]
+        data = "\n".join(lines).encode()
+        # Two members split inside a line, as pigz and bgzip write them
+        compressed = gzip.compress(data[:70001]) + gzip.compress(data[70001:])
+        
+        with tempfile.NamedTemporaryFile(suffix=".ndjson.gz", delete=False) as f:
+            f.write(compressed)
+            path = f.name
+        
+        try:
+            for source in (path, compressed):
+                resources = []
+                for batch_resources, batch_errors in fhir_ndjson_c.NDJSONReader(source, threads=2, batch_size=1000):
+                    assert batch_errors == []
+                    resources.extend(batch_resources)
+                assert [r["id"] for r in resources] == [f"p{i}" for i in range(5000)]
+        finally:
+            os.remove(path)
+        
+        with pytest.raises(ValueError):
+            list(fhir_ndjson_c.NDJSONReader(compressed[:-20], threads=2))
@@ -0,0 +1,181 @@
+/**
+ * @file test_object_pools.c
+ * @brief Unit tests for the per-type object pools behind resource create/destroy
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_common.h"
+#include "../resources/fhir_patient.h"
+#include <pthread.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"gender\":\"female\",\"birthDate\":\"1980-05-17\"}";
+
+typedef struct {
+    char payload[48];
+} PoolItem;
+
+static FHIRObjectPool g_item_pool = FHIR_OBJECT_POOL_INIT("PoolItem", PoolItem);
+
+/* ========================================================================== */
+/* Pool Tests                                                                 */
+/* ========================================================================== */
+
+bool test_pool_reuse(void) {
+    PoolItem* item = fhir_pool_alloc(&g_item_pool);
+    ASSERT_NOT_NULL(item);
+    memset(item->payload, 0xAB, sizeof(item->payload));
+    fhir_pool_free(&g_item_pool, item);
+
+    // The calling thread gets its own last object back, zeroed
+    PoolItem* again = fhir_pool_alloc(&g_item_pool);
+    ASSERT_NOT_NULL(again);
+    if (FHIR_OBJECT_POOLS) {
+        ASSERT_TRUE(item == again);
+    }
+    for (size_t i = 0; i < sizeof(again->payload); i++) {
+        ASSERT_EQ(0, again->payload[i]);
+    }
+    fhir_pool_free(&g_item_pool, again);
+    fhir_pool_free(&g_item_pool, NULL);
+    return true;
+}
+
+bool test_pool_overflow_and_trim(void) {
+    if (!FHIR_OBJECT_POOLS) return true;
+
+    fhir_pool_trim();
+    PoolItem* items[200];
+    for (int i = 0; i < 200; i++) {
+        items[i] = fhir_pool_alloc(&g_item_pool);
+        ASSERT_NOT_NULL(items[i]);
+    }
+    for (int i = 0; i < 200; i++) {
+        fhir_pool_free(&g_item_pool, items[i]);
+    }
+
+    // The thread cache is bounded; the rest went to the shared list
+    FHIRObjectPoolStats stats;
+    fhir_pool_get_stats(&g_item_pool, &stats);
+    ASSERT_TRUE(stats.thread_objects <= FHIR_OBJECT_POOL_CACHE_SIZE);
+    ASSERT_EQ(200, stats.thread_objects + stats.shared_objects);
+
+    // Everything cached is reused before the heap is touched again
+    size_t heap_allocations = stats.heap_allocations;
+    for (int i = 0; i < 200; i++) {
+        items[i] = fhir_pool_alloc(&g_item_pool);
+    }
+    fhir_pool_get_stats(&g_item_pool, &stats);
+    ASSERT_EQ(heap_allocations, stats.heap_allocations);
+    ASSERT_EQ(0, stats.thread_objects + stats.shared_objects);
+    for (int i = 0; i < 200; i++) {
+        fhir_pool_free(&g_item_pool, items[i]);
+    }
+
+    ASSERT_TRUE(fhir_pool_trim() >= 200 * sizeof(PoolItem));
+    fhir_pool_get_stats(&g_item_pool, &stats);
+    ASSERT_EQ(0, stats.thread_objects + stats.shared_objects);
+    ASSERT_EQ(0, fhir_pool_trim());
+    return true;
+}
+
+static void* churn_on_thread(void* arg) {
+    (void)arg;
+    PoolItem* items[10];
+    for (int i = 0; i < 10; i++) {
+        items[i] = fhir_pool_alloc(&g_item_pool);
+    }
+    for (int i = 0; i < 10; i++) {
+        fhir_pool_free(&g_item_pool, items[i]);
+    }
+    return NULL;
+}
+
+bool test_pool_thread_exit(void) {
+    if (!FHIR_OBJECT_POOLS) return true;
+
+    fhir_pool_trim();
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, churn_on_thread, NULL));
+    pthread_join(thread, NULL);
+
+    // An exited thread's cache is handed to the shared list
+    FHIRObjectPoolStats stats;
+    fhir_pool_get_stats(&g_item_pool, &stats);
+    ASSERT_EQ(10, stats.shared_objects);
+    ASSERT_EQ(0, stats.thread_objects);
+
+    size_t heap_allocations = stats.heap_allocations;
+    fhir_pool_free(&g_item_pool, fhir_pool_alloc(&g_item_pool));
+    fhir_pool_get_stats(&g_item_pool, &stats);
+    ASSERT_EQ(heap_allocations, stats.heap_allocations);
+    fhir_pool_trim();
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Tests                                                             */
+/* ========================================================================== */
+
+bool test_resource_pool(void) {
+    FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    FHIRObjectPool* pool = patient->base.vtable->pool;
+    ASSERT_NOT_NULL(pool);
+    ASSERT_EQ(sizeof(FHIRPatient), pool->object_size);
+    ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, patient->gender);
+    fhir_patient_destroy(patient);
+
+    // A recycled struct starts from the create defaults
+    FHIRPatient* fresh = fhir_patient_create("p2");
+    ASSERT_NOT_NULL(fresh);
+    if (FHIR_OBJECT_POOLS) {
+        ASSERT_TRUE(fresh == patient);
+    }
+    ASSERT_EQ(FHIR_PATIENT_GENDER_UNKNOWN, fresh->gender);
+    ASSERT_NULL(fresh->birth_date);
+    ASSERT_STR_EQ("p2", fresh->base.id);
+    fhir_patient_destroy(fresh);
+    return true;
+}
+
+bool test_resource_pool_arena(void) {
+    FHIRObjectPoolStats before, after;
+    FHIRPatient* probe = fhir_patient_create("probe");
+    ASSERT_NOT_NULL(probe);
+    FHIRObjectPool* pool = probe->base.vtable->pool;
+    fhir_patient_destroy(probe);
+    fhir_pool_get_stats(pool, &before);
+
+    // Arena-backed structs are never cached
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+    FHIRPatient* patient = fhir_patient_parse_with_arena(arena, PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    ASSERT_TRUE(fhir_arena_owns(arena, patient));
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    fhir_patient_destroy(patient);
+    fhir_arena_set_current(previous);
+    fhir_pool_get_stats(pool, &after);
+    ASSERT_EQ(before.thread_objects, after.thread_objects);
+    ASSERT_EQ(before.heap_allocations, after.heap_allocations);
+    fhir_arena_destroy(arena);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_pool_reuse);
+    RUN_TEST(test_pool_overflow_and_trim);
+    RUN_TEST(test_pool_thread_exit);
+    RUN_TEST(test_resource_pool);
+    RUN_TEST(test_resource_pool_arena);
+
+    TEST_FINALIZE();
+    return 0;
+}
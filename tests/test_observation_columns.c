@@ -0,0 +1,235 @@
+/**
+ * @file test_observation_columns.c
+ * @brief Unit tests for the columnar Observation store
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_observation_columns.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOINC "http://loinc.org"
+
+static bool append(FHIRObservationColumns* columns, const char* text) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_observation_columns_append_json(columns, json);
+    cJSON_Delete(json);
+    return ok;
+}
+
+static bool append_heart_rate(FHIRObservationColumns* columns, const char* patient,
+                              const char* time, double value) {
+    char text[512];
+    snprintf(text, sizeof(text),
+             "{\"resourceType\":\"Observation\",\"id\":\"hr\",\"status\":\"final\","
+             "\"code\":{\"coding\":[{\"system\":\"" LOINC "\",\"code\":\"8867-4\"}]},"
+             "\"subject\":{\"reference\":\"%s\"},\"effectiveDateTime\":\"%s\","
+             "\"valueQuantity\":{\"value\":%g,\"unit\":\"beats/min\",\"code\":\"/min\"}}",
+             patient, time, value);
+    return append(columns, text);
+}
+
+/* ========================================================================== */
+/* Time Parsing Tests                                                         */
+/* ========================================================================== */
+
+bool test_columns_parse_time(void) {
+    int64_t millis;
+
+    ASSERT_TRUE(fhir_observation_columns_parse_time("1970-01-01T00:00:00Z", &millis));
+    ASSERT_TRUE(millis == 0);
+    ASSERT_TRUE(fhir_observation_columns_parse_time("2024-03-01T10:00:00.25+01:00", &millis));
+    ASSERT_TRUE(millis == 1709283600250LL);
+    ASSERT_TRUE(fhir_observation_columns_parse_time("2024-02-29", &millis));
+    ASSERT_TRUE(millis == 1709164800000LL);
+    ASSERT_TRUE(fhir_observation_columns_parse_time("2024", &millis));
+    ASSERT_TRUE(millis == 1704067200000LL);
+    ASSERT_TRUE(fhir_observation_columns_parse_time("1969-12-31T23:59:59Z", &millis));
+    ASSERT_TRUE(millis == -1000);
+
+    ASSERT_FALSE(fhir_observation_columns_parse_time("2023-02-29", &millis));
+    ASSERT_FALSE(fhir_observation_columns_parse_time("2024-13", &millis));
+    ASSERT_FALSE(fhir_observation_columns_parse_time("2024-01-01T10:00", &millis));
+    ASSERT_FALSE(fhir_observation_columns_parse_time("2024-01-01 trailing", &millis));
+    return true;
+}
+
+/* ========================================================================== */
+/* Column Tests                                                               */
+/* ========================================================================== */
+
+bool test_columns_append_json(void) {
+    FHIRObservationColumns* columns = fhir_observation_columns_create();
+    ASSERT_NOT_NULL(columns);
+
+    ASSERT_TRUE(append_heart_rate(columns, "Patient/1", "2024-01-01T08:00:00Z", 60));
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"Observation\",\"id\":\"steps\",\"status\":\"amended\","
+        "\"code\":{\"coding\":[{\"code\":\"steps\"}]},\"effectivePeriod\":{\"start\":\"2024-01-02\"},"
+        "\"valueInteger\":9000}"));
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"Observation\",\"id\":\"note\",\"status\":\"bogus\","
+        "\"valueString\":\"text only\"}"));
+    ASSERT_FALSE(append(columns, "{\"resourceType\":\"Patient\",\"id\":\"p1\"}"));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+
+    FHIRObservationColumnView view;
+    fhir_observation_columns_get_view(columns, &view);
+    ASSERT_EQ(3, view.row_count);
+
+    uint32_t heart_rate = fhir_observation_columns_find_code(columns, LOINC, "8867-4");
+    uint32_t steps = fhir_observation_columns_find_code(columns, NULL, "steps");
+    ASSERT_EQ(0, heart_rate);
+    ASSERT_EQ(1, steps);
+    ASSERT_TRUE(fhir_observation_columns_find_code(columns, LOINC, "steps") == FHIR_OBSERVATION_COLUMNS_NONE);
+    ASSERT_EQ(2, fhir_observation_columns_get_code_count(columns));
+
+    const char* system;
+    const char* code;
+    ASSERT_TRUE(fhir_observation_columns_get_code(columns, heart_rate, &system, &code));
+    ASSERT_STR_EQ(LOINC, system);
+    ASSERT_STR_EQ("8867-4", code);
+
+    ASSERT_TRUE(view.effective_time[0] == 1704096000000LL);
+    ASSERT_TRUE(view.effective_time[1] == 1704153600000LL);
+    ASSERT_TRUE(view.effective_time[2] == FHIR_OBSERVATION_COLUMNS_NO_TIME);
+    ASSERT_FLOAT_EQ(60.0, view.value[0], 1e-9);
+    ASSERT_FLOAT_EQ(9000.0, view.value[1], 1e-9);
+    ASSERT_TRUE(isnan(view.value[2]));
+    ASSERT_STR_EQ("/min", fhir_observation_columns_get_unit(columns, view.unit[0]));
+    ASSERT_TRUE(view.unit[1] == FHIR_OBSERVATION_COLUMNS_NONE);
+    ASSERT_STR_EQ("Patient/1", fhir_observation_columns_get_subject(columns, view.subject[0]));
+    ASSERT_TRUE(view.code[2] == FHIR_OBSERVATION_COLUMNS_NONE);
+    ASSERT_EQ(FHIR_OBSERVATION_COLUMN_STATUS_FINAL, view.status[0]);
+    ASSERT_EQ(FHIR_OBSERVATION_COLUMN_STATUS_AMENDED, view.status[1]);
+    ASSERT_EQ(FHIR_OBSERVATION_COLUMN_STATUS_UNKNOWN, view.status[2]);
+
+    fhir_observation_columns_destroy(columns);
+    return true;
+}
+
+bool test_columns_filter_and_aggregate(void) {
+    FHIRObservationColumns* columns = fhir_observation_columns_create();
+    ASSERT_NOT_NULL(columns);
+
+    // 3000 rows (past the initial capacity), one per hour, values 0..99 repeating
+    char time[32];
+    for (int i = 0; i < 3000; i++) {
+        snprintf(time, sizeof(time), "2024-01-%02dT%02d:00:00Z", 1 + i / 24 % 28, i % 24);
+        ASSERT_TRUE(append_heart_rate(columns, i % 2 ? "Patient/odd" : "Patient/even", time, i % 100));
+    }
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"Observation\",\"id\":\"t\",\"status\":\"preliminary\","
+        "\"code\":{\"coding\":[{\"system\":\"" LOINC "\",\"code\":\"8310-5\"}]},"
+        "\"effectiveDateTime\":\"2024-01-01T12:00:00Z\",\"valueQuantity\":{\"value\":37.5}}"));
+
+    FHIRObservationColumnView view;
+    fhir_observation_columns_get_view(columns, &view);
+    ASSERT_EQ(3001, view.row_count);
+
+    uint8_t* mask = malloc(view.row_count);
+    ASSERT_NOT_NULL(mask);
+
+    // Whole table
+    size_t code_count = fhir_observation_columns_get_code_count(columns);
+    ASSERT_EQ(2, code_count);
+    FHIRObservationCodeStats stats[3];
+    fhir_observation_columns_aggregate_by_code(columns, NULL, stats, 3);
+    ASSERT_EQ(3000, stats[0].count);
+    ASSERT_FLOAT_EQ(0.0, stats[0].min, 1e-9);
+    ASSERT_FLOAT_EQ(99.0, stats[0].max, 1e-9);
+    ASSERT_FLOAT_EQ(49.5, stats[0].mean, 1e-9);
+    ASSERT_EQ(1, stats[1].count);
+    ASSERT_FLOAT_EQ(37.5, stats[1].mean, 1e-9);
+    ASSERT_EQ(0, stats[2].count);
+    ASSERT_TRUE(isnan(stats[2].mean));
+
+    // First day only: 24 heart rates with values 0..23 plus the temperature
+    int64_t start, end;
+    ASSERT_TRUE(fhir_observation_columns_parse_time("2024-01-01", &start));
+    ASSERT_TRUE(fhir_observation_columns_parse_time("2024-01-02", &end));
+    ASSERT_EQ(3001, fhir_observation_columns_select_all(columns, mask));
+    size_t selected = fhir_observation_columns_filter_time_range(columns, start, end, mask);
+    // Days repeat every 28 * 24 rows
+    size_t expected_day_one = 24 * ((3000 + 28 * 24 - 1) / (28 * 24)) + 1;
+    ASSERT_EQ(expected_day_one, selected);
+
+    ASSERT_EQ(expected_day_one - 1,
+              fhir_observation_columns_filter_code(columns, fhir_observation_columns_find_code(columns, LOINC, "8867-4"), mask));
+    fhir_observation_columns_aggregate_by_code(columns, mask, stats, code_count);
+    ASSERT_EQ(expected_day_one - 1, stats[0].count);
+    ASSERT_EQ(0, stats[1].count);
+
+    fhir_observation_columns_select_all(columns, mask);
+    ASSERT_EQ(1, fhir_observation_columns_filter_status(columns, FHIR_OBSERVATION_COLUMN_STATUS_PRELIMINARY, mask));
+
+    free(mask);
+    fhir_observation_columns_destroy(columns);
+    return true;
+}
+
+bool test_columns_load_ndjson(void) {
+    const char* path = "test_observation_columns.ndjson";
+    FILE* file = fopen(path, "wb");
+    ASSERT_NOT_NULL(file);
+    for (int i = 0; i < 500; i++) {
+        fprintf(file,
+                "{\"resourceType\":\"Observation\",\"id\":\"o%d\",\"status\":\"final\","
+                "\"code\":{\"coding\":[{\"system\":\"" LOINC "\",\"code\":\"%s\"}]},"
+                "\"effectiveDateTime\":\"2024-05-01\",\"valueQuantity\":{\"value\":%d}}\n",
+                i, i % 2 ? "a" : "b", i);
+        if (i % 100 == 0) {
+            fputs("{\"resourceType\":\"Patient\",\"id\":\"p\"}\n{broken\n", file);
+        }
+    }
+    fclose(file);
+
+    FHIRNDJSONOptions options;
+    fhir_ndjson_options_init(&options);
+    options.thread_count = 3;
+    options.batch_size = 64;
+    options.validate = false;
+
+    FHIRObservationColumns* columns = fhir_observation_columns_create();
+    size_t appended;
+    ASSERT_TRUE(fhir_observation_columns_load_ndjson(columns, path, &options, &appended));
+    ASSERT_EQ(500, appended);
+
+    // Rows keep file order
+    FHIRObservationColumnView view;
+    fhir_observation_columns_get_view(columns, &view);
+    ASSERT_EQ(500, view.row_count);
+    for (size_t i = 0; i < view.row_count; i++) {
+        ASSERT_FLOAT_EQ((double)i, view.value[i], 1e-9);
+    }
+
+    FHIRObservationCodeStats stats[2];
+    fhir_observation_columns_aggregate_by_code(columns, NULL, stats, 2);
+    uint32_t odd = fhir_observation_columns_find_code(columns, LOINC, "a");
+    ASSERT_EQ(250, stats[odd].count);
+    ASSERT_FLOAT_EQ(1.0, stats[odd].min, 1e-9);
+    ASSERT_FLOAT_EQ(499.0, stats[odd].max, 1e-9);
+
+    ASSERT_FALSE(fhir_observation_columns_load_ndjson(columns, "does-not-exist.ndjson", NULL, NULL));
+    ASSERT_EQ(FHIR_ERROR_IO, fhir_get_last_error()->code);
+
+    fhir_observation_columns_destroy(columns);
+    remove(path);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_columns_parse_time);
+    RUN_TEST(test_columns_append_json);
+    RUN_TEST(test_columns_filter_and_aggregate);
+    RUN_TEST(test_columns_load_ndjson);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -248,6 +248,38 @@ bool test_patient_json_serialization(void) {
     return true;
 }
 
+bool test_patient_age(void) {
+    FHIRPatient* patient = fhir_patient_create("patient-age");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_EQ(-1, fhir_patient_get_age(patient));
+    
+    // 2024-05-15T00:00:00Z and 2024-05-14T23:59:59Z
+    const int64_t birthday = INT64_C(1715731200000000);
+    const int64_t day_before = birthday - 1000000;
+    
+    ASSERT_TRUE(fhir_patient_set_birth_date(patient, "1990-05-15"));
+    ASSERT_EQ(FHIR_DATETIME_PRECISION_DAY, patient->birth_date->parsed.precision);
+    ASSERT_EQ(34, fhir_patient_get_age_at(patient, birthday));
+    ASSERT_EQ(33, fhir_patient_get_age_at(patient, day_before));
+    ASSERT_EQ(-1, fhir_patient_get_age_at(patient, 0));
+    ASSERT_TRUE(fhir_patient_get_age(patient) >= 34);
+    
+    // Partial dates count from their first day
+    ASSERT_TRUE(fhir_patient_set_birth_date(patient, "1990"));
+    ASSERT_EQ(34, fhir_patient_get_age_at(patient, day_before));
+    ASSERT_FALSE(fhir_patient_set_birth_date(patient, "1990-05-15T10:00:00Z"));
+    
+    // Parsed values survive cloning
+    FHIRPatient* clone = (FHIRPatient*)fhir_resource_clone((FHIRResourceBase*)patient);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_EQ(34, fhir_patient_get_age_at(clone, day_before));
+    fhir_resource_release((FHIRResourceBase*)clone);
+    
+    fhir_patient_destroy(patient);
+    
+    return true;
+}
+
 /* ========================================================================== */
 /* Resource Factory Tests                                                     */
 /* ========================================================================== */
@@ -286,6 +318,29 @@ bool test_resource_registration_and_factory(void) {
     return true;
 }
 
+bool test_resource_registration_repeated(void) {
+    // Each interpreter importing an extension module registers its types again
+    ASSERT_TRUE(fhir_patient_register());
+    ASSERT_TRUE(fhir_patient_register());
+    
+    // A different implementation of a registered type is refused
+    FHIRResourceRegistration conflicting = {
+        .type = FHIR_RESOURCE_TYPE_PATIENT,
+        .name = "Patient",
+        .vtable = NULL,
+        .factory = NULL
+    };
+    ASSERT_FALSE(fhir_resource_register_type(&conflicting));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    fhir_clear_error();
+    
+    FHIRResourceBase* patient = fhir_resource_create_by_type(FHIR_RESOURCE_TYPE_PATIENT, "repeat");
+    ASSERT_NOT_NULL(patient);
+    fhir_resource_release(patient);
+    
+    return true;
+}
+
 /* ========================================================================== */
 /* Main Test Runner                                                           */
 /* ========================================================================== */
@@ -304,9 +359,11 @@ int main(void) {
     RUN_TEST(test_patient_specific_methods);
     RUN_TEST(test_patient_gender_conversion);
     RUN_TEST(test_patient_json_serialization);
+    RUN_TEST(test_patient_age);
     
     // Resource factory tests
     RUN_TEST(test_resource_registration_and_factory);
+    RUN_TEST(test_resource_registration_repeated);
     
     TEST_FINALIZE();
     return 0;
@@ -0,0 +1,316 @@
+/**
+ * @file test_patch.c
+ * @brief Unit tests for JSON Patch and FHIRPath Patch
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_patch.h"
+#include "../resources/fhir_patient.h"
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true,"
+    "\"name\":[{\"family\":\"Chalmers\",\"given\":[\"Peter\",\"James\"]}],"
+    "\"telecom\":[{\"system\":\"phone\",\"value\":\"555-1\"},{\"system\":\"email\",\"value\":\"p@example.org\"}],"
+    "\"gender\":\"male\",\"birthDate\":\"1974-12-25\"}";
+
+static char* write_json(const cJSON* json) {
+    FHIRWriter writer;
+    if (!fhir_writer_init_buffer(&writer, 0)) return NULL;
+    if (!fhir_writer_cjson(&writer, json)) {
+        fhir_writer_cleanup(&writer);
+        return NULL;
+    }
+    return fhir_writer_take_buffer(&writer, NULL);
+}
+
+static FHIRPatch* compile_text(const char* text) {
+    cJSON* json = cJSON_Parse(text);
+    FHIRPatch* patch = json ? fhir_patch_compile(json) : NULL;
+    cJSON_Delete(json);
+    return patch;
+}
+
+// Apply a patch given as text and return the patched document as text (NULL on failure)
+static char* patch_text(const char* document, const char* patch_json) {
+    FHIRPatch* patch = compile_text(patch_json);
+    cJSON* json = cJSON_Parse(document);
+    char* result = NULL;
+    if (patch && json && fhir_patch_apply(patch, json, NULL)) {
+        result = write_json(json);
+    }
+    cJSON_Delete(json);
+    fhir_patch_destroy(patch);
+    return result;
+}
+
+/* ========================================================================== */
+/* JSON Patch Tests                                                           */
+/* ========================================================================== */
+
+bool test_json_patch_operations(void) {
+    const char* document = "{\"a\":{\"b\":[1,2,3]},\"c\":\"x\",\"d~/e\":true}";
+
+    char* text = patch_text(document,
+        "[{\"op\":\"add\",\"path\":\"/a/b/1\",\"value\":9},"
+        "{\"op\":\"add\",\"path\":\"/a/b/-\",\"value\":4},"
+        "{\"op\":\"replace\",\"path\":\"/c\",\"value\":{\"y\":1}},"
+        "{\"op\":\"remove\",\"path\":\"/d~0~1e\"},"
+        "{\"op\":\"copy\",\"from\":\"/a/b/0\",\"path\":\"/f\"},"
+        "{\"op\":\"move\",\"from\":\"/c/y\",\"path\":\"/a/z\"},"
+        "{\"op\":\"test\",\"path\":\"/a/b\",\"value\":[1,9,2,3,4]}]");
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"a\":{\"b\":[1,9,2,3,4],\"z\":1},\"c\":{},\"f\":1}", text);
+    fhir_free(text);
+
+    // Moving to the same place is a no-op; into a child is not allowed
+    text = patch_text(document, "[{\"op\":\"move\",\"from\":\"/c\",\"path\":\"/c\"}]");
+    ASSERT_NOT_NULL(text);
+    fhir_free(text);
+    ASSERT_NULL(patch_text(document, "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b/0\"}]"));
+    ASSERT_NULL(patch_text(document, "[{\"op\":\"add\",\"path\":\"/a/b/01\",\"value\":0}]"));
+    ASSERT_NULL(patch_text(document, "[{\"op\":\"remove\",\"path\":\"/missing\"}]"));
+    return true;
+}
+
+bool test_json_patch_compile_errors(void) {
+    ASSERT_NULL(compile_text("[{\"op\":\"frobnicate\",\"path\":\"/a\"}]"));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+    ASSERT_NULL(compile_text("[{\"op\":\"add\",\"path\":\"a\",\"value\":1}]"));
+    ASSERT_NULL(compile_text("[{\"op\":\"add\",\"path\":\"/a~2\",\"value\":1}]"));
+    ASSERT_NULL(compile_text("[{\"op\":\"add\",\"path\":\"/a\"}]"));
+    ASSERT_NULL(compile_text("[{\"op\":\"remove\",\"path\":\"\"}]"));
+
+    FHIRPatch* patch = compile_text("[{\"op\":\"test\",\"path\":\"\",\"value\":{}}]");
+    ASSERT_NOT_NULL(patch);
+    ASSERT_EQ(FHIR_PATCH_JSON_PATCH, fhir_patch_get_format(patch));
+    ASSERT_EQ(1, fhir_patch_get_operation_count(patch));
+    fhir_patch_destroy(patch);
+    return true;
+}
+
+bool test_patch_atomic(void) {
+    cJSON* json = cJSON_Parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(json);
+    char* before = write_json(json);
+    ASSERT_NOT_NULL(before);
+
+    // The last operation fails, so the earlier ones are undone
+    FHIRPatch* patch = compile_text(
+        "[{\"op\":\"remove\",\"path\":\"/id\"},"
+        "{\"op\":\"add\",\"path\":\"/name/0/given/0\",\"value\":\"Pete\"},"
+        "{\"op\":\"add\",\"path\":\"/deceasedBoolean\",\"value\":false},"
+        "{\"op\":\"test\",\"path\":\"/gender\",\"value\":\"female\"}]");
+    ASSERT_NOT_NULL(patch);
+    FHIRPatchChanges changes;
+    fhir_patch_changes_init(&changes);
+    ASSERT_FALSE(fhir_patch_apply(patch, json, &changes));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    ASSERT_EQ(0, changes.count);
+
+    char* after = write_json(json);
+    ASSERT_NOT_NULL(after);
+    ASSERT_STR_EQ(before, after);
+    fhir_free(after);
+    fhir_patch_destroy(patch);
+
+    // The change set names each touched top-level member once
+    patch = compile_text(
+        "[{\"op\":\"replace\",\"path\":\"/gender\",\"value\":\"female\"},"
+        "{\"op\":\"add\",\"path\":\"/name/0/given/-\",\"value\":\"J\"},"
+        "{\"op\":\"remove\",\"path\":\"/name/0/family\"}]");
+    ASSERT_NOT_NULL(patch);
+    ASSERT_TRUE(fhir_patch_apply(patch, json, &changes));
+    ASSERT_EQ(2, changes.count);
+    ASSERT_STR_EQ("gender", changes.members[0]);
+    ASSERT_STR_EQ("name", changes.members[1]);
+    fhir_patch_changes_cleanup(&changes);
+    fhir_patch_destroy(patch);
+
+    fhir_free(before);
+    cJSON_Delete(json);
+    return true;
+}
+
+/* ========================================================================== */
+/* FHIRPath Patch Tests                                                       */
+/* ========================================================================== */
+
+#define OPERATION(parts) "{\"name\":\"operation\",\"part\":[" parts "]}"
+#define PARAMETERS(operations) "{\"resourceType\":\"Parameters\",\"parameter\":[" operations "]}"
+
+bool test_fhirpath_patch(void) {
+    char* text = patch_text(PATIENT_JSON, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"replace\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.birthDate\"},"
+                  "{\"name\":\"value\",\"valueDate\":\"1975-01-01\"}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"delete\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.telecom.where(system = 'email')\"}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"insert\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.name[0].given\"},"
+                  "{\"name\":\"index\",\"valueInteger\":0},"
+                  "{\"name\":\"value\",\"valueString\":\"Pete\"}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"move\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.name[0].given\"},"
+                  "{\"name\":\"source\",\"valueInteger\":2},"
+                  "{\"name\":\"destination\",\"valueInteger\":0}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"add\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient\"},"
+                  "{\"name\":\"name\",\"valueString\":\"maritalStatus\"},"
+                  "{\"name\":\"value\",\"part\":[{\"name\":\"text\",\"valueString\":\"Married\"}]}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"insert\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.address\"},"
+                  "{\"name\":\"index\",\"valueInteger\":0},"
+                  "{\"name\":\"value\",\"part\":[{\"name\":\"line\",\"valueString\":\"1 Main St\"},"
+                  "{\"name\":\"line\",\"valueString\":\"Apt 2\"}]}")));
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true,"
+                  "\"name\":[{\"family\":\"Chalmers\",\"given\":[\"James\",\"Pete\",\"Peter\"]}],"
+                  "\"telecom\":[{\"system\":\"phone\",\"value\":\"555-1\"}],"
+                  "\"gender\":\"male\",\"birthDate\":\"1975-01-01\","
+                  "\"maritalStatus\":{\"text\":\"Married\"},"
+                  "\"address\":[{\"line\":[\"1 Main St\",\"Apt 2\"]}]}", text);
+    fhir_free(text);
+
+    // Deleting the last element of a list removes the list
+    text = patch_text(PATIENT_JSON, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"delete\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.name.given[0]\"}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"delete\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.name.given[0]\"}") ","
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"delete\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.photo\"}")));
+    ASSERT_NOT_NULL(text);
+    ASSERT_TRUE(strstr(text, "\"name\":[{\"family\":\"Chalmers\"}]") != NULL);
+    fhir_free(text);
+
+    // Ambiguous targets and existing single elements are errors
+    ASSERT_NULL(patch_text(PATIENT_JSON, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"replace\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.telecom.system\"},"
+                  "{\"name\":\"value\",\"valueCode\":\"fax\"}"))));
+    ASSERT_NULL(patch_text(PATIENT_JSON, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"add\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient\"},"
+                  "{\"name\":\"name\",\"valueString\":\"gender\"},"
+                  "{\"name\":\"value\",\"valueCode\":\"female\"}"))));
+    ASSERT_NULL(compile_text(PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"insert\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Patient.name\"}"))));
+    return true;
+}
+
+/* ========================================================================== */
+/* Serialized Document Tests                                                  */
+/* ========================================================================== */
+
+static char* patch_serialized(const char* document, const char* patch_json, bool canonical) {
+    FHIRPatch* patch = compile_text(patch_json);
+    FHIRWriter writer;
+    char* result = NULL;
+    if (patch && fhir_writer_init_buffer(&writer, 0)) {
+        fhir_writer_set_canonical(&writer, canonical);
+        if (fhir_patch_apply_text(patch, document, strlen(document), &writer)) {
+            result = fhir_writer_take_buffer(&writer, NULL);
+        }
+        fhir_writer_cleanup(&writer);
+    }
+    fhir_patch_destroy(patch);
+    return result;
+}
+
+bool test_patch_apply_text(void) {
+    // Untouched members keep their exact text, including number formatting
+    const char* document =
+        "{ \"resourceType\" : \"Observation\", \"valueQuantity\": {\"value\": 1.50},"
+        " \"status\": \"preliminary\", \"note\": [ {\"text\": \"a\"} ] }";
+    char* text = patch_serialized(document,
+        "[{\"op\":\"replace\",\"path\":\"/status\",\"value\":\"final\"},"
+        "{\"op\":\"add\",\"path\":\"/issued\",\"value\":\"2024-01-01\"}]", false);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"resourceType\":\"Observation\",\"valueQuantity\":{\"value\": 1.50},"
+                  "\"status\":\"final\",\"note\":[ {\"text\": \"a\"} ],\"issued\":\"2024-01-01\"}", text);
+    fhir_free(text);
+
+    // FHIRPath paths reach choice elements through their prefix
+    text = patch_serialized(document, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"replace\"},"
+                  "{\"name\":\"path\",\"valueString\":\"(Observation.value as Quantity).value\"},"
+                  "{\"name\":\"value\",\"valueDecimal\":2}")), false);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"resourceType\":\"Observation\",\"valueQuantity\":{\"value\":2},"
+                  "\"status\":\"preliminary\",\"note\":[ {\"text\": \"a\"} ]}", text);
+    fhir_free(text);
+
+    // A union path or a canonical writer patches the whole document
+    text = patch_serialized(document, PARAMETERS(
+        OPERATION("{\"name\":\"type\",\"valueCode\":\"delete\"},"
+                  "{\"name\":\"path\",\"valueString\":\"Observation.note | Observation.comment\"}")), false);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"resourceType\":\"Observation\",\"valueQuantity\":{\"value\":1.5},"
+                  "\"status\":\"preliminary\"}", text);
+    fhir_free(text);
+    text = patch_serialized(document, "[{\"op\":\"remove\",\"path\":\"/note\"}]", true);
+    ASSERT_NOT_NULL(text);
+    ASSERT_STR_EQ("{\"resourceType\":\"Observation\",\"status\":\"preliminary\","
+                  "\"valueQuantity\":{\"value\":1.5}}", text);
+    fhir_free(text);
+
+    ASSERT_NULL(patch_serialized(document, "[{\"op\":\"remove\",\"path\":\"/issued\"}]", false));
+    ASSERT_NULL(patch_serialized("[1]", "[{\"op\":\"remove\",\"path\":\"/a\"}]", false));
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Tests                                                             */
+/* ========================================================================== */
+
+bool test_resource_patch(void) {
+    FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+    ASSERT_NOT_NULL(patient);
+    ASSERT_TRUE(fhir_patient_validate(patient));
+
+    FHIRPatch* patch = compile_text(
+        "[{\"op\":\"replace\",\"path\":\"/birthDate\",\"value\":\"1980-02-29\"},"
+        "{\"op\":\"add\",\"path\":\"/name/0/given/-\",\"value\":\"J\"},"
+        "{\"op\":\"add\",\"path\":\"/contact\",\"value\":[{\"name\":{\"family\":\"Doe\"}}]}]");
+    ASSERT_NOT_NULL(patch);
+    FHIRPatient* patched = (FHIRPatient*)fhir_resource_patch(&patient->base, patch);
+    ASSERT_NOT_NULL(patched);
+    ASSERT_STR_EQ("1980-02-29", patched->birth_date->value);
+    ASSERT_STR_EQ("1974-12-25", patient->birth_date->value);
+
+    // Only the rules reading the changed members rerun
+    ASSERT_EQ(FHIR_VALIDATION_CACHE_STALE, fhir_atomic_load(&patched->base.validation_state));
+    ASSERT_EQ(FHIR_PATIENT_DIRTY_BIRTH_DATE | FHIR_PATIENT_DIRTY_NAME,
+              (uint32_t)fhir_atomic_load(&patched->base.validation_dirty));
+    ASSERT_TRUE(fhir_patient_validate(patched));
+    fhir_patient_destroy(patched);
+    fhir_patch_destroy(patch);
+
+    // A patch may not change the resource type
+    patch = compile_text("[{\"op\":\"replace\",\"path\":\"/resourceType\",\"value\":\"Group\"}]");
+    ASSERT_NOT_NULL(patch);
+    ASSERT_NULL(fhir_resource_patch(&patient->base, patch));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    fhir_patch_destroy(patch);
+    fhir_patient_destroy(patient);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_json_patch_operations);
+    RUN_TEST(test_json_patch_compile_errors);
+    RUN_TEST(test_patch_atomic);
+    RUN_TEST(test_fhirpath_patch);
+    RUN_TEST(test_patch_apply_text);
+    RUN_TEST(test_resource_patch);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,38 @@
+"""Tests for JSON Patch and FHIRPath Patch with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestPatch:
+    """Test cases for patch application."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_apply_patch(self):
+        """Test JSON Patch and FHIRPath Patch on serialized resources."""
+        fhir_patch_c = pytest.importorskip("fast_fhir.fhir_patch_c")
+
+        document = '{"resourceType":"Patient","id":"p1","name":[{"family":"Doe"}],"gender":"male"}'
+        patched = fhir_patch_c.apply_patch(document, json.dumps([
+            {"op": "replace", "path": "/gender", "value": "female"},
+            {"op": "add", "path": "/name/0/given", "value": ["Jane"]},
+        ]))
+        assert json.loads(patched) == {"resourceType": "Patient", "id": "p1",
+                                       "name": [{"family": "Doe", "given": ["Jane"]}], "gender": "female"}
+
+        parameters = {"resourceType": "Parameters", "parameter": [{"name": "operation", "part": [
+            {"name": "type", "valueCode": "add"},
+            {"name": "path", "valueString": "Patient"},
+            {"name": "name", "valueString": "birthDate"},
+            {"name": "value", "valueDate": "1990-01-01"},
+        ]}]}
+        assert json.loads(fhir_patch_c.apply_patch(document, json.dumps(parameters)))["birthDate"] == "1990-01-01"
+
+        with pytest.raises(ValueError):
+            fhir_patch_c.apply_patch(document, json.dumps([{"op": "test", "path": "/id", "value": "p2"}]))
+        with pytest.raises(ValueError):
+            fhir_patch_c.apply_patch(document, "[{\"op\": \"nope\"}]")
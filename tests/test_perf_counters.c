@@ -0,0 +1,178 @@
+/**
+ * @file test_perf_counters.c
+ * @brief Unit tests for the performance counters, trace callbacks and log macros
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_common.h"
+#include "../resources/fhir_patient.h"
+#include <pthread.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"gender\":\"female\",\"birthDate\":\"1980-05-17\"}";
+
+/* ========================================================================== */
+/* Logging Tests                                                              */
+/* ========================================================================== */
+
+static int g_evaluations;
+
+static int count_evaluation(void) {
+    return ++g_evaluations;
+}
+
+bool test_log_level_check(void) {
+    fhir_set_log_level(FHIR_LOG_LEVEL_FATAL);
+    g_evaluations = 0;
+    FHIR_LOG_DEBUG("not shown %d", count_evaluation());
+    FHIR_LOG_ERROR("not shown %d", count_evaluation());
+    ASSERT_EQ(0, g_evaluations);
+    ASSERT_FALSE(FHIR_LOG_ENABLED(FHIR_LOG_LEVEL_WARN));
+    ASSERT_TRUE(FHIR_LOG_ENABLED(FHIR_LOG_LEVEL_FATAL));
+
+    // Statement-like in unbraced branches
+    if (g_evaluations == 0)
+        FHIR_LOG_INFO("not shown");
+    else
+        FHIR_LOG_INFO("not shown either");
+
+    fhir_set_log_level(FHIR_LOG_LEVEL_INFO);
+    return true;
+}
+
+/* ========================================================================== */
+/* Counter Tests                                                              */
+/* ========================================================================== */
+
+bool test_perf_counters(void) {
+    ASSERT_FALSE(fhir_perf_set_enabled(true));
+    fhir_perf_reset();
+
+    for (int i = 0; i < 5; i++) {
+        FHIRPatient* patient = fhir_patient_parse(PATIENT_JSON);
+        ASSERT_NOT_NULL(patient);
+        ASSERT_TRUE(fhir_resource_validate(&patient->base));
+
+        FHIRWriter writer;
+        ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+        ASSERT_TRUE(fhir_resource_write_json(&patient->base, &writer));
+        fhir_writer_cleanup(&writer);
+        fhir_patient_destroy(patient);
+    }
+    ASSERT_NULL(fhir_patient_parse("{broken"));
+
+    // Tokenizing happens before the type is known
+    FHIRPerfCounters untyped;
+    ASSERT_TRUE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_UNKNOWN, &untyped));
+    ASSERT_EQ(6, untyped.calls[FHIR_PERF_PHASE_TOKENIZE]);
+    ASSERT_EQ(1, untyped.failures);
+    ASSERT_EQ(5 * strlen(PATIENT_JSON) + strlen("{broken"), untyped.bytes);
+
+    FHIRPerfCounters patient;
+    ASSERT_TRUE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_PATIENT, &patient));
+    ASSERT_EQ(5, patient.parsed);
+    ASSERT_EQ(0, patient.failures);
+    ASSERT_EQ(5, patient.calls[FHIR_PERF_PHASE_DESERIALIZE]);
+    ASSERT_EQ(5, patient.calls[FHIR_PERF_PHASE_VALIDATE]);
+    ASSERT_EQ(5, patient.calls[FHIR_PERF_PHASE_SERIALIZE]);
+    ASSERT_EQ(0, patient.calls[FHIR_PERF_PHASE_PYTHON]);
+    ASSERT_TRUE(patient.nanoseconds[FHIR_PERF_PHASE_DESERIALIZE] > 0);
+
+    fhir_perf_reset();
+    ASSERT_TRUE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_PATIENT, &patient));
+    ASSERT_EQ(0, patient.parsed);
+    ASSERT_EQ(0, patient.nanoseconds[FHIR_PERF_PHASE_DESERIALIZE]);
+
+    // Nothing is counted while disabled
+    ASSERT_TRUE(fhir_perf_set_enabled(false));
+    fhir_patient_destroy(fhir_patient_parse(PATIENT_JSON));
+    ASSERT_TRUE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_PATIENT, &patient));
+    ASSERT_EQ(0, patient.parsed);
+
+    ASSERT_FALSE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_COUNT, &patient));
+    ASSERT_STR_EQ("deserialize", fhir_perf_phase_name(FHIR_PERF_PHASE_DESERIALIZE));
+    ASSERT_STR_EQ("unknown", fhir_perf_phase_name(FHIR_PERF_PHASE_COUNT));
+    return true;
+}
+
+static void* parse_on_thread(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 10; i++) {
+        fhir_patient_destroy(fhir_patient_parse(PATIENT_JSON));
+    }
+    return NULL;
+}
+
+bool test_perf_thread_slots(void) {
+    fhir_perf_set_enabled(true);
+    fhir_perf_reset();
+
+    // Short-lived threads in waves; exited threads hand their slots on
+    for (int wave = 0; wave < 10; wave++) {
+        pthread_t threads[4];
+        for (int i = 0; i < 4; i++) {
+            ASSERT_EQ(0, pthread_create(&threads[i], NULL, parse_on_thread, NULL));
+        }
+        for (int i = 0; i < 4; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    FHIRPerfCounters patient;
+    ASSERT_TRUE(fhir_perf_get_counters(FHIR_RESOURCE_TYPE_PATIENT, &patient));
+    ASSERT_EQ(400, patient.parsed);
+    fhir_perf_set_enabled(false);
+    return true;
+}
+
+/* ========================================================================== */
+/* Trace Tests                                                                */
+/* ========================================================================== */
+
+typedef struct {
+    int spans;
+    int deserialized;
+    bool bad_span;
+} TraceLog;
+
+static void record_span(void* context, const FHIRTraceSpan* span) {
+    TraceLog* log = context;
+    log->spans++;
+    if (span->phase == FHIR_PERF_PHASE_DESERIALIZE) {
+        log->deserialized++;
+        log->bad_span |= span->resource_type != FHIR_RESOURCE_TYPE_PATIENT || !span->ok;
+    }
+    log->bad_span |= span->start_ns == 0;
+}
+
+bool test_trace_callback(void) {
+    TraceLog log = {0};
+    fhir_trace_set_callback(record_span, &log);
+
+    // Spans reach the callback with the counters off
+    fhir_patient_destroy(fhir_patient_parse(PATIENT_JSON));
+    ASSERT_EQ(2, log.spans);
+    ASSERT_EQ(1, log.deserialized);
+    ASSERT_FALSE(log.bad_span);
+
+    fhir_trace_set_callback(NULL, NULL);
+    fhir_patient_destroy(fhir_patient_parse(PATIENT_JSON));
+    ASSERT_EQ(2, log.spans);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_log_level_check);
+    RUN_TEST(test_perf_counters);
+    RUN_TEST(test_perf_thread_slots);
+    RUN_TEST(test_trace_callback);
+
+    TEST_FINALIZE();
+    return 0;
+}
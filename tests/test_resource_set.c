@@ -0,0 +1,210 @@
+/**
+ * @file test_resource_set.c
+ * @brief Unit tests for structural hashing and the resource deduplication set
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../common/fhir_hash.h"
+#include "../fhir_resource_set.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <string.h>
+
+static FHIRPatient* make_patient(const char* id, const char* birth_date) {
+    FHIRPatient* patient = fhir_patient_create(id);
+    if (patient && birth_date) {
+        fhir_patient_set_birth_date(patient, birth_date);
+    }
+    return patient;
+}
+
+/* ========================================================================== */
+/* Hasher Tests                                                               */
+/* ========================================================================== */
+
+bool test_hash_vectors(void) {
+    // Reference XXH64 values (seed 0)
+    ASSERT_EQ(UINT64_C(0xEF46DB3751D8E999), fhir_hash64("", 0, 0));
+    ASSERT_EQ(UINT64_C(0xD24EC4F1A98C6E5B), fhir_hash64("a", 1, 0));
+    ASSERT_EQ(UINT64_C(0x44BC2CF5AD770999), fhir_hash64("abc", 3, 0));
+
+    // Chunked input hashes like the whole buffer
+    char data[1000];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (char)(i * 7);
+    }
+    uint64_t whole = fhir_hash64(data, sizeof(data), 42);
+    for (size_t chunk = 1; chunk < 80; chunk += 3) {
+        FHIRHasher hasher;
+        fhir_hasher_init(&hasher, 42);
+        for (size_t offset = 0; offset < sizeof(data); offset += chunk) {
+            size_t take = sizeof(data) - offset < chunk ? sizeof(data) - offset : chunk;
+            fhir_hasher_update(&hasher, data + offset, take);
+        }
+        ASSERT_EQ(whole, fhir_hasher_digest(&hasher));
+    }
+    return true;
+}
+
+bool test_hash_framing(void) {
+    FHIRHasher a, b, c, d;
+    fhir_hasher_init(&a, 0);
+    fhir_hasher_string(&a, "ab");
+    fhir_hasher_string(&a, "c");
+    fhir_hasher_init(&b, 0);
+    fhir_hasher_string(&b, "a");
+    fhir_hasher_string(&b, "bc");
+    ASSERT_NE(fhir_hasher_digest(&a), fhir_hasher_digest(&b));
+
+    fhir_hasher_init(&c, 0);
+    fhir_hasher_string(&c, NULL);
+    fhir_hasher_init(&d, 0);
+    fhir_hasher_string(&d, "");
+    ASSERT_NE(fhir_hasher_digest(&c), fhir_hasher_digest(&d));
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Hash Tests                                                        */
+/* ========================================================================== */
+
+bool test_patient_hash(void) {
+    FHIRPatient* a = make_patient("p1", "1980-05-17");
+    FHIRPatient* b = make_patient("p1", "1980-05-17");
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+
+    // Equal Patients hash alike, and the hash is cached
+    uint64_t hash = 0;
+    ASSERT_FALSE(fhir_resource_get_cached_hash(&a->base, NULL));
+    ASSERT_EQ(fhir_resource_hash(&a->base), fhir_resource_hash(&b->base));
+    ASSERT_TRUE(fhir_resource_get_cached_hash(&a->base, &hash));
+    ASSERT_EQ(fhir_patient_hash(a), hash);
+    ASSERT_TRUE(fhir_patient_equals(a, b));
+
+    // A setter drops the cached hash; the new one differs and equals rejects
+    ASSERT_TRUE(fhir_patient_set_birth_date(b, "1980-05-18"));
+    ASSERT_FALSE(fhir_resource_get_cached_hash(&b->base, NULL));
+    ASSERT_NE(hash, fhir_resource_hash(&b->base));
+    ASSERT_FALSE(fhir_patient_equals(a, b));
+
+    ASSERT_TRUE(fhir_patient_set_birth_date(b, "1980-05-17"));
+    ASSERT_EQ(hash, fhir_resource_hash(&b->base));
+    ASSERT_TRUE(fhir_patient_equals(a, b));
+
+    fhir_patient_destroy(a);
+    fhir_patient_destroy(b);
+    return true;
+}
+
+bool test_serialized_hash_fallback(void) {
+    FHIRPatient* a = make_patient("p1", "1980-05-17");
+    FHIRPatient* b = make_patient("p1", "1980-05-17");
+    FHIRPatient* c = make_patient("p2", "1980-05-17");
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    ASSERT_NOT_NULL(c);
+
+    // A type without a hash method hashes its serialized form
+    FHIRResourceVTable vtable = *a->base.vtable;
+    vtable.hash = NULL;
+    const FHIRResourceVTable* original = a->base.vtable;
+    a->base.vtable = b->base.vtable = c->base.vtable = &vtable;
+
+    ASSERT_EQ(fhir_resource_hash(&a->base), fhir_resource_hash(&b->base));
+    ASSERT_NE(fhir_resource_hash(&a->base), fhir_resource_hash(&c->base));
+
+    a->base.vtable = b->base.vtable = c->base.vtable = original;
+    fhir_patient_destroy(a);
+    fhir_patient_destroy(b);
+    fhir_patient_destroy(c);
+    return true;
+}
+
+/* ========================================================================== */
+/* Set Tests                                                                  */
+/* ========================================================================== */
+
+bool test_resource_set_add_find(void) {
+    enum { DISTINCT = 500 };
+    FHIRResourceSet* set = fhir_resource_set_create(0);
+    ASSERT_NOT_NULL(set);
+
+    // Two separately built copies of every Patient; the set grows several times
+    FHIRPatient* firsts[DISTINCT];
+    for (int copy = 0; copy < 2; copy++) {
+        for (int i = 0; i < DISTINCT; i++) {
+            char id[32];
+            snprintf(id, sizeof(id), "p%d", i);
+            FHIRPatient* patient = make_patient(id, i % 2 ? "1990-01-01" : NULL);
+            ASSERT_NOT_NULL(patient);
+
+            FHIRResourceBase* member = fhir_resource_set_add(set, &patient->base);
+            if (copy == 0) {
+                ASSERT_TRUE(member == &patient->base);
+                firsts[i] = patient;
+            } else {
+                ASSERT_TRUE(member == &firsts[i]->base);
+                ASSERT_TRUE(fhir_resource_set_find(set, &patient->base) == member);
+            }
+            fhir_resource_release(&patient->base);
+        }
+        ASSERT_EQ(DISTINCT, fhir_resource_set_count(set));
+    }
+
+    // Members stay alive while the set holds them
+    ASSERT_TRUE(fhir_resource_set_add(set, &firsts[0]->base) == &firsts[0]->base);
+    ASSERT_EQ(DISTINCT, fhir_resource_set_count(set));
+    ASSERT_EQ(1, fhir_resource_get_ref_count(&firsts[0]->base));
+
+    FHIRPatient* other = make_patient("other", NULL);
+    ASSERT_NULL(fhir_resource_set_find(set, &other->base));
+    fhir_patient_destroy(other);
+
+    ASSERT_NULL(fhir_resource_set_add(set, NULL));
+    fhir_resource_set_free(set);
+    return true;
+}
+
+bool test_resource_dedup(void) {
+    const char* ids[] = {"a", "b", "a", "c", "b", "a", "d"};
+    enum { COUNT = sizeof(ids) / sizeof(ids[0]) };
+    FHIRResourceBase* resources[COUNT + 1];
+    for (size_t i = 0; i < COUNT; i++) {
+        resources[i] = &make_patient(ids[i], NULL)->base;
+        ASSERT_NOT_NULL(resources[i]);
+    }
+    // The same pointer twice is a duplicate too
+    resources[COUNT] = resources[3];
+
+    ASSERT_EQ(4, fhir_resource_dedup(resources, COUNT + 1));
+    ASSERT_STR_EQ("a", resources[0]->id);
+    ASSERT_STR_EQ("b", resources[1]->id);
+    ASSERT_STR_EQ("c", resources[2]->id);
+    ASSERT_STR_EQ("d", resources[3]->id);
+
+    // The tail holds the duplicates, none released
+    for (size_t i = 0; i < COUNT + 1; i++) {
+        ASSERT_EQ(1, fhir_resource_get_ref_count(resources[i]));
+    }
+    for (size_t i = 0; i < COUNT; i++) {
+        fhir_resource_release(resources[i]);
+    }
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_hash_vectors);
+    RUN_TEST(test_hash_framing);
+    RUN_TEST(test_patient_hash);
+    RUN_TEST(test_serialized_hash_fallback);
+    RUN_TEST(test_resource_set_add_find);
+    RUN_TEST(test_resource_dedup);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file test_resource_sharing.c
+ * @brief Unit tests for sharing resources and their data (atomic reference
+ *        counts, the validation cache, copy-on-write clones, interned values)
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../resources/fhir_patient.h"
+#include <pthread.h>
+#include <string.h>
+
+#define SHARING_THREADS 8
+#define SHARING_ITERATIONS 20000
+
+typedef struct {
+    FHIRPatient* patient;
+    pthread_barrier_t* start;
+    bool valid;
+} SharingContext;
+
+/* ========================================================================== */
+/* Reference Counting Tests                                                   */
+/* ========================================================================== */
+
+static void* retain_release_worker(void* arg) {
+    SharingContext* context = arg;
+    pthread_barrier_wait(context->start);
+
+    for (int i = 0; i < SHARING_ITERATIONS; i++) {
+        FHIRResourceBase* shared = fhir_resource_retain(&context->patient->base);
+        context->valid = fhir_resource_get_display_name(shared) != NULL || context->valid;
+        fhir_resource_release(shared);
+    }
+    return NULL;
+}
+
+bool test_shared_ref_count(void) {
+    FHIRPatient* patient = fhir_patient_create("shared");
+    ASSERT_NOT_NULL(patient);
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, SHARING_THREADS);
+    pthread_t threads[SHARING_THREADS];
+    SharingContext contexts[SHARING_THREADS];
+
+    for (int i = 0; i < SHARING_THREADS; i++) {
+        contexts[i] = (SharingContext){ .patient = patient, .start = &start };
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, retain_release_worker, &contexts[i]));
+    }
+    for (int i = 0; i < SHARING_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&start);
+
+    // No increment or decrement was lost
+    ASSERT_EQ(1, fhir_resource_get_ref_count(&patient->base));
+
+    // The last release destroys the resource
+    fhir_resource_retain(&patient->base);
+    fhir_resource_release(&patient->base);
+    ASSERT_EQ(1, fhir_resource_get_ref_count(&patient->base));
+    fhir_resource_release(&patient->base);
+    return true;
+}
+
+/* ========================================================================== */
+/* Validation Cache Tests                                                     */
+/* ========================================================================== */
+
+static void* validate_worker(void* arg) {
+    SharingContext* context = arg;
+    pthread_barrier_wait(context->start);
+
+    const FHIRPatient* patient = context->patient;
+    context->valid = fhir_patient_validate(patient);
+
+    size_t count = 1;
+    fhir_patient_get_validation_errors(patient, &count);
+    context->valid = context->valid && count == 0;
+    return NULL;
+}
+
+bool test_shared_validation_cache(void) {
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, SHARING_THREADS);
+
+    // Each round races every thread to fill the cache of a fresh Patient
+    for (int round = 0; round < 50; round++) {
+        FHIRPatient* patient = fhir_patient_create("validated");
+        ASSERT_NOT_NULL(patient);
+        ASSERT_FALSE(fhir_resource_get_cached_validation(&patient->base, NULL));
+
+        pthread_t threads[SHARING_THREADS];
+        SharingContext contexts[SHARING_THREADS];
+        for (int i = 0; i < SHARING_THREADS; i++) {
+            contexts[i] = (SharingContext){ .patient = patient, .start = &start };
+            ASSERT_EQ(0, pthread_create(&threads[i], NULL, validate_worker, &contexts[i]));
+        }
+        for (int i = 0; i < SHARING_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+            ASSERT_TRUE(contexts[i].valid);
+        }
+
+        bool cached = false;
+        ASSERT_TRUE(fhir_resource_get_cached_validation(&patient->base, &cached));
+        ASSERT_TRUE(cached);
+
+        // Modification drops the cache
+        ASSERT_TRUE(fhir_patient_set_active(patient, true));
+        ASSERT_FALSE(fhir_resource_get_cached_validation(&patient->base, NULL));
+
+        fhir_patient_destroy(patient);
+    }
+
+    pthread_barrier_destroy(&start);
+    return true;
+}
+
+bool test_validation_cache_first_result_wins(void) {
+    FHIRPatient* patient = fhir_patient_create("first-wins");
+    ASSERT_NOT_NULL(patient);
+
+    char** errors = fhir_calloc(1, sizeof(char*));
+    errors[0] = fhir_strdup("first");
+    ASSERT_FALSE(fhir_resource_cache_validation(&patient->base, false, errors, 1));
+
+    // A later result is discarded (and its errors freed)
+    char** late = fhir_calloc(1, sizeof(char*));
+    late[0] = fhir_strdup("late");
+    ASSERT_FALSE(fhir_resource_cache_validation(&patient->base, true, late, 1));
+
+    size_t count = 0;
+    char** cached = fhir_patient_get_validation_errors(patient, &count);
+    ASSERT_EQ(1, count);
+    ASSERT_STR_EQ("first", cached[0]);
+
+    fhir_patient_destroy(patient);
+    return true;
+}
+
+static int g_rule_calls[2];
+
+static bool rule_has_id(const FHIRResourceBase* base) {
+    g_rule_calls[0]++;
+    return base->id != NULL;
+}
+
+static bool rule_is_active(const FHIRResourceBase* base) {
+    g_rule_calls[1]++;
+    const FHIRPatient* patient = (const FHIRPatient*)base;
+    return !patient->active || patient->active->value;
+}
+
+bool test_validation_reruns_dirty_rules(void) {
+    static const FHIRValidationRule rules[] = {
+        { FHIR_PATIENT_DIRTY_ID, rule_has_id, "no id" },
+        { FHIR_PATIENT_DIRTY_ACTIVE, rule_is_active, "inactive" },
+    };
+    FHIRPatient* patient = fhir_patient_create("incremental");
+    ASSERT_NOT_NULL(patient);
+    g_rule_calls[0] = g_rule_calls[1] = 0;
+
+    // The first validation runs every rule, later ones only those reading dirty fields
+    ASSERT_TRUE(fhir_resource_validate_rules(&patient->base, rules, 2));
+    ASSERT_TRUE(fhir_resource_validate_rules(&patient->base, rules, 2));
+    ASSERT_EQ(1, g_rule_calls[0]);
+    ASSERT_EQ(1, g_rule_calls[1]);
+
+    ASSERT_TRUE(fhir_patient_set_active(patient, false));
+    ASSERT_FALSE(fhir_resource_get_cached_validation(&patient->base, NULL));
+    ASSERT_FALSE(fhir_resource_validate_rules(&patient->base, rules, 2));
+    ASSERT_EQ(1, g_rule_calls[0]);
+    ASSERT_EQ(2, g_rule_calls[1]);
+    ASSERT_EQ(1, patient->base.validation_error_count);
+    ASSERT_STR_EQ("inactive", patient->base.validation_errors[0]);
+
+    // A field no rule reads keeps the cached failures
+    ASSERT_TRUE(fhir_patient_set_gender(patient, FHIR_PATIENT_GENDER_FEMALE));
+    ASSERT_FALSE(fhir_resource_validate_rules(&patient->base, rules, 2));
+    ASSERT_EQ(2, g_rule_calls[1]);
+    ASSERT_EQ(1, patient->base.validation_error_count);
+
+    ASSERT_TRUE(fhir_patient_set_active(patient, true));
+    ASSERT_TRUE(fhir_resource_validate_rules(&patient->base, rules, 2));
+    ASSERT_EQ(1, g_rule_calls[0]);
+    ASSERT_EQ(3, g_rule_calls[1]);
+    ASSERT_EQ(0, patient->base.validation_error_count);
+
+    fhir_patient_destroy(patient);
+    return true;
+}
+
+bool test_patient_validation_dirty_fields(void) {
+    FHIRPatient* patient = fhir_patient_create("dirty");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_TRUE(fhir_patient_validate(patient));
+
+    // Fields written directly are marked by the writer
+    patient->deceased_boolean = fhir_calloc(1, sizeof(FHIRBoolean));
+    patient->deceased_date_time = fhir_calloc(1, sizeof(FHIRDateTime));
+    ASSERT_TRUE(fhir_patient_validate(patient));
+    fhir_resource_mark_dirty(&patient->base, FHIR_PATIENT_DIRTY_DECEASED);
+    ASSERT_FALSE(fhir_patient_validate(patient));
+
+    size_t count = 0;
+    char** errors = fhir_patient_get_validation_errors(patient, &count);
+    ASSERT_EQ(1, count);
+    ASSERT_NOT_NULL(strstr(errors[0], "deceasedBoolean"));
+
+    fhir_free(patient->deceased_date_time);
+    patient->deceased_date_time = NULL;
+    fhir_resource_mark_dirty(&patient->base, FHIR_PATIENT_DIRTY_DECEASED);
+    ASSERT_TRUE(fhir_patient_validate(patient));
+
+    // A result published whole cannot be patched, so marking drops it
+    fhir_resource_invalidate_validation(&patient->base);
+    ASSERT_TRUE(fhir_resource_cache_validation(&patient->base, true, NULL, 0));
+    fhir_resource_mark_dirty(&patient->base, FHIR_PATIENT_DIRTY_ACTIVE);
+    ASSERT_EQ(FHIR_VALIDATION_CACHE_EMPTY, fhir_atomic_load(&patient->base.validation_state));
+
+    fhir_patient_destroy(patient);
+    return true;
+}
+
+/* ========================================================================== */
+/* Copy-on-Write Clone Tests                                                  */
+/* ========================================================================== */
+
+static FHIRPatient* create_patient_with_arrays(void) {
+    FHIRPatient* patient = fhir_patient_create("cow-source");
+    if (!patient) return NULL;
+
+    FHIRHumanName name = { .text = "Jane Doe" };
+    FHIRIdentifier identifier = { .system = "urn:mrn" };
+    fhir_patient_add_name(patient, &name);
+    fhir_patient_add_name(patient, &name);
+    fhir_patient_add_identifier(patient, &identifier);
+    fhir_patient_set_gender(patient, FHIR_PATIENT_GENDER_FEMALE);
+    fhir_patient_set_birth_date(patient, "1970-01-01");
+
+    patient->base.extension = fhir_calloc(1, sizeof(FHIRExtension*));
+    patient->base.extension[0] = fhir_calloc(1, sizeof(FHIRExtension));
+    patient->base.extension_count = 1;
+    return patient;
+}
+
+bool test_clone_cow_shares_arrays(void) {
+    FHIRPatient* source = create_patient_with_arrays();
+    ASSERT_NOT_NULL(source);
+
+    FHIRPatient* clone = fhir_patient_clone_cow(source);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_TRUE(clone->name == source->name);
+    ASSERT_TRUE(clone->identifier == source->identifier);
+    ASSERT_TRUE(clone->base.extension == source->base.extension);
+    ASSERT_EQ(2, clone->name_count);
+    ASSERT_EQ(2, fhir_atomic_load(&source->shared[FHIR_PATIENT_SHARED_NAME]->ref_count));
+
+    // Scalars are copied
+    ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, clone->gender);
+    ASSERT_TRUE(clone->birth_date != source->birth_date);
+    ASSERT_STR_EQ("1970-01-01", clone->birth_date->value);
+
+    // A clone of a clone references the same blocks
+    FHIRPatient* second = fhir_patient_clone_cow(clone);
+    ASSERT_NOT_NULL(second);
+    ASSERT_TRUE(second->name == source->name);
+    ASSERT_EQ(3, fhir_atomic_load(&source->shared[FHIR_PATIENT_SHARED_NAME]->ref_count));
+
+    // Modifying the clone copies only the touched array
+    FHIRHumanName added = { .text = "Tenant Name" };
+    ASSERT_TRUE(fhir_patient_add_name(clone, &added));
+    ASSERT_TRUE(clone->name != source->name);
+    ASSERT_NULL(clone->shared[FHIR_PATIENT_SHARED_NAME]);
+    ASSERT_EQ(3, clone->name_count);
+    ASSERT_EQ(2, source->name_count);
+    ASSERT_STR_EQ("Jane Doe", clone->name[0]->text);
+    ASSERT_STR_EQ("Tenant Name", clone->name[2]->text);
+    ASSERT_TRUE(clone->identifier == source->identifier);
+
+    // Destroying the source leaves the shared arrays to the clones
+    fhir_patient_destroy(source);
+    ASSERT_EQ(1, fhir_atomic_load(&second->shared[FHIR_PATIENT_SHARED_NAME]->ref_count));
+    ASSERT_EQ(2, fhir_atomic_load(&second->shared[FHIR_PATIENT_SHARED_IDENTIFIER]->ref_count));
+    ASSERT_STR_EQ("urn:mrn", clone->identifier[0]->system);
+
+    // The last owner takes the array back without copying
+    FHIRHumanName* first_name = second->name[0];
+    ASSERT_TRUE(fhir_patient_add_name(second, &added));
+    ASSERT_NULL(second->shared[FHIR_PATIENT_SHARED_NAME]);
+    ASSERT_TRUE(second->name[0] == first_name);
+    ASSERT_EQ(3, second->name_count);
+
+    fhir_patient_destroy(clone);
+    fhir_patient_destroy(second);
+    return true;
+}
+
+static void* clone_cow_worker(void* arg) {
+    SharingContext* context = arg;
+    pthread_barrier_wait(context->start);
+
+    context->valid = true;
+    for (int i = 0; i < SHARING_ITERATIONS / 10; i++) {
+        FHIRPatient* clone = fhir_patient_clone_cow(context->patient);
+        if (!clone || clone->name != context->patient->name) {
+            context->valid = false;
+        }
+        fhir_patient_destroy(clone);
+    }
+    return NULL;
+}
+
+bool test_clone_cow_concurrent(void) {
+    FHIRPatient* source = create_patient_with_arrays();
+    ASSERT_NOT_NULL(source);
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, SHARING_THREADS);
+    pthread_t threads[SHARING_THREADS];
+    SharingContext contexts[SHARING_THREADS];
+
+    // The first clones race to move the source's arrays into shared blocks
+    for (int i = 0; i < SHARING_THREADS; i++) {
+        contexts[i] = (SharingContext){ .patient = source, .start = &start };
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, clone_cow_worker, &contexts[i]));
+    }
+    for (int i = 0; i < SHARING_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_TRUE(contexts[i].valid);
+    }
+    pthread_barrier_destroy(&start);
+
+    ASSERT_EQ(1, fhir_atomic_load(&source->shared[FHIR_PATIENT_SHARED_NAME]->ref_count));
+    fhir_patient_destroy(source);
+    return true;
+}
+
+bool test_clone_cow_arena(void) {
+    FHIRArena* arena = fhir_arena_create(0);
+    ASSERT_NOT_NULL(arena);
+    FHIRPatient* source = fhir_patient_parse_with_arena(arena,
+        "{\"resourceType\": \"Patient\", \"id\": \"arena-cow\", \"active\": true}");
+    ASSERT_NOT_NULL(source);
+
+    // Arena patients are deep-copied onto the heap
+    FHIRPatient* clone = fhir_patient_clone_cow(source);
+    ASSERT_NOT_NULL(clone);
+    ASSERT_NULL(clone->base.arena);
+    fhir_arena_destroy(arena);
+    ASSERT_STR_EQ("arena-cow", clone->base.id);
+    ASSERT_TRUE(fhir_patient_is_active(clone));
+
+    // Sharing between arena and heap resources is rejected
+    FHIRPatient* heap = fhir_patient_create("heap");
+    arena = fhir_arena_create(0);
+    source = fhir_patient_parse_with_arena(arena, "{\"resourceType\": \"Patient\", \"id\": \"a\"}");
+    ASSERT_FALSE(fhir_resource_share_fields(&source->base, &heap->base, NULL, 0));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    fhir_arena_destroy(arena);
+    fhir_patient_destroy(heap);
+    fhir_patient_destroy(clone);
+    return true;
+}
+
+/* ========================================================================== */
+/* Interned Value Tests                                                       */
+/* ========================================================================== */
+
+bool test_parsed_identifiers_interned(void) {
+    const char* json_string = "{"
+        "\"resourceType\": \"Patient\","
+        "\"id\": \"interned\","
+        "\"identifier\": [{\"use\": \"official\", \"system\": \"urn:oid:1.2.36.146.595.217.0.1\"}]"
+    "}";
+
+    FHIRPatient* first = fhir_patient_parse(json_string);
+    FHIRPatient* second = fhir_patient_parse(json_string);
+    ASSERT_NOT_NULL(first);
+    ASSERT_NOT_NULL(second);
+    ASSERT_STR_EQ("urn:oid:1.2.36.146.595.217.0.1", first->identifier[0]->system);
+    ASSERT_STR_EQ("official", first->identifier[0]->use);
+
+    // Both resources refer to the single pooled copy
+    ASSERT_TRUE(first->identifier[0]->system == second->identifier[0]->system);
+    ASSERT_TRUE(first->identifier[0]->use == second->identifier[0]->use);
+    ASSERT_TRUE(fhir_patient_equals(first, second));
+
+    second->identifier[0]->use = (char*)fhir_intern("secondary");
+    ASSERT_FALSE(fhir_patient_equals(first, second));
+
+    fhir_patient_destroy(first);
+    fhir_patient_destroy(second);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_shared_ref_count);
+    RUN_TEST(test_shared_validation_cache);
+    RUN_TEST(test_validation_cache_first_result_wins);
+    RUN_TEST(test_validation_reruns_dirty_rules);
+    RUN_TEST(test_patient_validation_dirty_fields);
+    RUN_TEST(test_clone_cow_shares_arrays);
+    RUN_TEST(test_clone_cow_concurrent);
+    RUN_TEST(test_clone_cow_arena);
+    RUN_TEST(test_parsed_identifiers_interned);
+
+    TEST_FINALIZE();
+    return 0;
+}
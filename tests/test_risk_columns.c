@@ -0,0 +1,179 @@
+/**
+ * @file test_risk_columns.c
+ * @brief Unit tests for the columnar RiskAssessment scores and cohort kernels
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_risk_columns.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool append(FHIRRiskColumns* columns, const char* text) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_risk_columns_append_json(columns, json);
+    cJSON_Delete(json);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Scoring Tests                                                              */
+/* ========================================================================== */
+
+bool test_risk_columns_scoring(void) {
+    FHIRRiskColumns* columns = fhir_risk_columns_create();
+    ASSERT_NOT_NULL(columns);
+
+    // A zero probabilityDecimal falls back to probabilityRange.high
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"RiskAssessment\",\"subject\":{\"reference\":\"Patient/1\"},\"prediction\":["
+        "{\"probabilityDecimal\":0.2},"
+        "{\"probabilityDecimal\":0,\"probabilityRange\":{\"high\":{\"value\":0.7}}},"
+        "{\"probabilityDecimal\":0.7}]}"));
+    // Only zero risks: no highest prediction, but a threshold of 0 still passes
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"RiskAssessment\",\"prediction\":[{\"qualitativeRisk\":{\"text\":\"low\"}}]}"));
+    ASSERT_TRUE(append(columns, "{\"resourceType\":\"RiskAssessment\",\"status\":\"final\"}"));
+    ASSERT_TRUE(append(columns,
+        "{\"resourceType\":\"RiskAssessment\",\"prediction\":[null,{\"probabilityDecimal\":0.4}]}"));
+    ASSERT_FALSE(append(columns, "{\"resourceType\":\"Observation\"}"));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+
+    FHIRRiskColumnView view;
+    fhir_risk_columns_get_view(columns, &view);
+    ASSERT_EQ(4, view.row_count);
+    ASSERT_FLOAT_EQ(0.7, view.risk[0], 1e-12);
+    ASSERT_EQ(1, view.prediction[0]);
+    ASSERT_STR_EQ("Patient/1", view.subject[0]);
+    ASSERT_FLOAT_EQ(0.0, view.risk[1], 1e-12);
+    ASSERT_EQ(FHIR_RISK_COLUMNS_NO_PREDICTION, view.prediction[1]);
+    ASSERT_TRUE(isnan(view.risk[2]));
+    ASSERT_NULL(view.subject[2]);
+    ASSERT_EQ(1, view.prediction[3]);
+
+    uint8_t mask[4];
+    ASSERT_EQ(2, fhir_risk_columns_high_risk(columns, 0.4, mask));
+    ASSERT_TRUE(mask[0] && !mask[1] && !mask[2] && mask[3]);
+    ASSERT_EQ(3, fhir_risk_columns_high_risk(columns, 0.0, mask));
+    ASSERT_FALSE(mask[2]);
+
+    uint32_t rows[4];
+    ASSERT_EQ(2, fhir_risk_columns_top_k(columns, 2, rows));
+    ASSERT_EQ(0, rows[0]);
+    ASSERT_EQ(3, rows[1]);
+    // Rows without predictions are never ranked
+    ASSERT_EQ(3, fhir_risk_columns_top_k(columns, 4, rows));
+    ASSERT_EQ(1, rows[2]);
+
+    fhir_risk_columns_destroy(columns);
+    return true;
+}
+
+/* ========================================================================== */
+/* Kernel Tests                                                               */
+/* ========================================================================== */
+
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static bool ranks_before(const double* values, uint32_t a, uint32_t b) {
+    return values[a] > values[b] || (values[a] == values[b] && a < b);
+}
+
+bool test_risk_kernels_match_scan(void) {
+    enum { COUNT = 5003 };
+    static double values[COUNT];
+    static uint8_t mask[COUNT];
+    static uint32_t indices[COUNT];
+    uint32_t state = 11;
+
+    // Coarse values force many ties; some rows are NaN
+    for (size_t i = 0; i < COUNT; i++) {
+        values[i] = next_random(&state) % 13 == 0 ? NAN : (double)(next_random(&state) % 200) / 200.0;
+    }
+
+    static const double thresholds[] = { -1.0, 0.0, 0.25, 0.5, 0.995, 1.0, INFINITY };
+    for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+        for (size_t length = COUNT - 3; length <= COUNT; length++) {
+            size_t expected = 0;
+            for (size_t i = 0; i < length; i++) expected += values[i] >= thresholds[t];
+            ASSERT_EQ(expected, fhir_risk_threshold_mask(values, length, thresholds[t], mask));
+            for (size_t i = 0; i < length; i++) ASSERT_EQ(values[i] >= thresholds[t], mask[i]);
+        }
+    }
+
+    static const size_t ks[] = { 1, 2, 7, 100, 4000, COUNT };
+    size_t ranked = 0;
+    for (size_t i = 0; i < COUNT; i++) ranked += !isnan(values[i]);
+    for (size_t t = 0; t < sizeof(ks) / sizeof(ks[0]); t++) {
+        size_t k = ks[t];
+        size_t count = fhir_risk_top_k(values, COUNT, k, indices);
+        ASSERT_EQ(k < ranked ? k : ranked, count);
+
+        // Strictly ordered, and nothing outside ranks before the last one selected
+        static uint8_t selected[COUNT];
+        memset(selected, 0, sizeof(selected));
+        for (size_t i = 0; i < count; i++) {
+            selected[indices[i]] = 1;
+            if (i > 0) ASSERT_TRUE(ranks_before(values, indices[i - 1], indices[i]));
+        }
+        for (uint32_t i = 0; i < COUNT; i++) {
+            if (!selected[i] && !isnan(values[i])) {
+                ASSERT_TRUE(ranks_before(values, indices[count - 1], i));
+            }
+        }
+    }
+
+    ASSERT_EQ(0, fhir_risk_top_k(values, COUNT, 0, indices));
+    return true;
+}
+
+bool test_risk_columns_load_ndjson(void) {
+    const char* path = "test_risk_columns.ndjson";
+    FILE* file = fopen(path, "wb");
+    ASSERT_NOT_NULL(file);
+    for (int i = 0; i < 300; i++) {
+        fprintf(file,
+                "{\"resourceType\":\"RiskAssessment\",\"id\":\"r%d\",\"status\":\"final\","
+                "\"subject\":{\"reference\":\"Patient/%d\"},"
+                "\"prediction\":[{\"probabilityDecimal\":%d.%03d}]}\n",
+                i, i, i == 150 ? 1 : 0, i == 150 ? 0 : i);
+        if (i % 100 == 0) {
+            fputs("{\"resourceType\":\"Patient\",\"id\":\"p\"}\n", file);
+        }
+    }
+    fclose(file);
+
+    FHIRRiskColumns* columns = fhir_risk_columns_create();
+    size_t appended;
+    ASSERT_TRUE(fhir_risk_columns_load_ndjson(columns, path, NULL, &appended));
+    ASSERT_EQ(300, appended);
+
+    uint32_t rows[3];
+    ASSERT_EQ(3, fhir_risk_columns_top_k(columns, 3, rows));
+    FHIRRiskColumnView view;
+    fhir_risk_columns_get_view(columns, &view);
+    ASSERT_STR_EQ("Patient/150", view.subject[rows[0]]);
+    ASSERT_STR_EQ("Patient/299", view.subject[rows[1]]);
+    ASSERT_STR_EQ("Patient/298", view.subject[rows[2]]);
+
+    fhir_risk_columns_destroy(columns);
+    remove(path);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_risk_columns_scoring);
+    RUN_TEST(test_risk_kernels_match_scan);
+    RUN_TEST(test_risk_columns_load_ndjson);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file test_search_index.c
+ * @brief Unit tests for search parameter index extraction
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_search_index.h"
+#include "../resources/fhir_patient.h"
+#include <math.h>
+#include <string.h>
+
+static const char* PATIENT_JSON =
+    "{\"resourceType\":\"Patient\",\"id\":\"p1\",\"active\":true,\"gender\":\"female\","
+    "\"birthDate\":\"1974-12\",\"identifier\":[{\"system\":\"urn:oid:1.2.36\",\"value\":\"12345\"}],"
+    "\"name\":[{\"family\":\"Ch\xC3\xA1lmers\",\"given\":[\"  Peter \",\"JAMES\"]}],"
+    "\"address\":[{\"city\":\"PleasantVille\",\"postalCode\":\"3999\"}],"
+    "\"managingOrganization\":{\"reference\":\"http://example.org/fhir/Organization/1/_history/2\"},"
+    "\"generalPractitioner\":[{\"reference\":\"#contained\"},{\"reference\":\"urn:uuid:1234\"}]}";
+
+static const char* OBSERVATION_JSON =
+    "{\"resourceType\":\"Observation\",\"id\":\"o1\",\"status\":\"final\","
+    "\"code\":{\"coding\":[{\"system\":\"http://loinc.org\",\"code\":\"2339-0\"},{\"code\":\"glucose\"}]},"
+    "\"subject\":{\"reference\":\"Patient/p1\"},\"encounter\":{\"reference\":\"Group/g1\"},"
+    "\"effectiveDateTime\":\"2024-03-01T10:00:00+01:00\","
+    "\"valueQuantity\":{\"value\":95,\"unit\":\"mg/dL\",\"system\":\"http://unitsofmeasure.org\",\"code\":\"mg/dL\"},"
+    "\"component\":[{\"code\":{\"text\":\"no coding\"},\"valueQuantity\":{\"value\":3,\"code\":\"beats\"}}]}";
+
+static const FHIRSearchIndexRow* find_row(const FHIRSearchIndexRows* rows, const char* parameter, size_t nth) {
+    for (size_t i = 0; i < rows->count; i++) {
+        if (strcmp(rows->rows[i].parameter, parameter) == 0 && nth-- == 0) {
+            return &rows->rows[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t count_rows(const FHIRSearchIndexRows* rows, const char* parameter) {
+    size_t count = 0;
+    while (find_row(rows, parameter, count)) count++;
+    return count;
+}
+
+/* ========================================================================== */
+/* Extraction Tests                                                           */
+/* ========================================================================== */
+
+bool test_search_index_patient(void) {
+    cJSON* json = cJSON_Parse(PATIENT_JSON);
+    FHIRSearchIndexRows rows;
+    fhir_search_index_rows_init(&rows);
+    ASSERT_TRUE(fhir_search_index_extract(json, &rows));
+
+    const FHIRSearchIndexRow* row = find_row(&rows, "identifier", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_EQ(FHIR_SEARCH_PARAM_TOKEN, row->type);
+    ASSERT_STR_EQ("urn:oid:1.2.36", row->value.token.system);
+    ASSERT_STR_EQ("12345", row->value.token.code);
+    ASSERT_STR_EQ("true", find_row(&rows, "active", 0)->value.token.code);
+    ASSERT_NULL(find_row(&rows, "gender", 0)->value.token.system);
+
+    // Month precision covers all of December
+    row = find_row(&rows, "birthdate", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_TRUE(row->value.date.start == 155088000000LL);
+    ASSERT_TRUE(row->value.date.end == 157766400000LL);
+    ASSERT_NULL(find_row(&rows, "death-date", 0));
+
+    // Strings are lowercased, accent-folded and trimmed
+    ASSERT_STR_EQ("chalmers", find_row(&rows, "family", 0)->value.string);
+    ASSERT_EQ(2, count_rows(&rows, "given"));
+    ASSERT_STR_EQ("peter", find_row(&rows, "given", 0)->value.string);
+    ASSERT_STR_EQ("james", find_row(&rows, "given", 1)->value.string);
+    ASSERT_EQ(3, count_rows(&rows, "name"));
+    ASSERT_EQ(2, count_rows(&rows, "address"));
+    ASSERT_STR_EQ("pleasantville", find_row(&rows, "address-city", 0)->value.string);
+
+    // Absolute and versioned references reduce to type and id; contained ones are skipped
+    row = find_row(&rows, "organization", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_ORGANIZATION, row->value.reference.type);
+    ASSERT_STR_EQ("Organization", row->value.reference.type_name);
+    ASSERT_STR_EQ("1", row->value.reference.id);
+    ASSERT_EQ(1, count_rows(&rows, "general-practitioner"));
+    row = find_row(&rows, "general-practitioner", 0);
+    ASSERT_EQ(FHIR_RESOURCE_TYPE_UNKNOWN, row->value.reference.type);
+    ASSERT_NULL(row->value.reference.type_name);
+    ASSERT_STR_EQ("urn:uuid:1234", row->value.reference.id);
+
+    fhir_search_index_rows_cleanup(&rows);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_search_index_observation(void) {
+    cJSON* json = cJSON_Parse(OBSERVATION_JSON);
+    FHIRSearchIndexRows rows;
+    fhir_search_index_rows_init(&rows);
+    ASSERT_TRUE(fhir_search_index_extract(json, &rows));
+
+    ASSERT_EQ(2, count_rows(&rows, "code"));
+    ASSERT_STR_EQ("http://loinc.org", find_row(&rows, "code", 0)->value.token.system);
+    ASSERT_STR_EQ("2339-0", find_row(&rows, "code", 0)->value.token.code);
+    ASSERT_NULL(find_row(&rows, "code", 1)->value.token.system);
+    ASSERT_EQ(0, count_rows(&rows, "component-code"));
+
+    // Seconds precision in UTC
+    const FHIRSearchIndexRow* row = find_row(&rows, "date", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_TRUE(row->value.date.start == 1709283600000LL);
+    ASSERT_TRUE(row->value.date.end == 1709283601000LL);
+
+    // 95 mg/dL = 0.95 g/L; unknown units stay as they are
+    row = find_row(&rows, "value-quantity", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_TRUE(fabs(row->value.quantity.value - 0.95) < 1e-12);
+    ASSERT_STR_EQ("g/L", row->value.quantity.unit);
+    ASSERT_STR_EQ(FHIR_SEARCH_INDEX_UCUM_SYSTEM, row->value.quantity.system);
+    row = find_row(&rows, "component-value-quantity", 0);
+    ASSERT_NOT_NULL(row);
+    ASSERT_TRUE(row->value.quantity.value == 3);
+    ASSERT_STR_EQ("beats", row->value.quantity.unit);
+    ASSERT_NULL(row->value.quantity.system);
+
+    // Target types filter references
+    ASSERT_EQ(1, count_rows(&rows, "subject"));
+    ASSERT_STR_EQ("p1", find_row(&rows, "patient", 0)->value.reference.id);
+    ASSERT_EQ(0, count_rows(&rows, "encounter"));
+
+    // Clearing keeps the buffers for the next resource
+    size_t capacity = rows.capacity;
+    fhir_search_index_rows_clear(&rows);
+    ASSERT_EQ(0, rows.count);
+    ASSERT_TRUE(fhir_search_index_extract(json, &rows));
+    ASSERT_EQ(capacity, rows.capacity);
+    ASSERT_STR_EQ("final", find_row(&rows, "status", 0)->value.token.code);
+
+    fhir_search_index_rows_cleanup(&rows);
+    cJSON_Delete(json);
+    return true;
+}
+
+bool test_search_index_dates_and_units(void) {
+    static const char* const encounters[] = {
+        "{\"resourceType\":\"Encounter\",\"id\":\"e1\",\"actualPeriod\":{\"start\":\"2024-02-29\"}}",
+        "{\"resourceType\":\"Encounter\",\"id\":\"e2\",\"actualPeriod\":{\"start\":\"2024\",\"end\":\"2024-01-01T00:00:00.25Z\"}}",
+        "{\"resourceType\":\"Encounter\",\"id\":\"e3\",\"actualPeriod\":{\"start\":\"2023-02-29\"}}",
+        "{\"resourceType\":\"Encounter\",\"id\":\"e4\",\"actualPeriod\":{\"start\":\"1969-12-31T23:59:59-00:30\"}}",
+    };
+    FHIRSearchIndexRows rows;
+    fhir_search_index_rows_init(&rows);
+    for (size_t i = 0; i < 4; i++) {
+        cJSON* json = cJSON_Parse(encounters[i]);
+        ASSERT_TRUE(fhir_search_index_extract(json, &rows));
+        cJSON_Delete(json);
+    }
+
+    ASSERT_EQ(4, count_rows(&rows, "date"));
+    const FHIRSearchIndexRow* open_end = find_row(&rows, "date", 0);
+    ASSERT_TRUE(open_end->value.date.start == 1709164800000LL);
+    ASSERT_TRUE(open_end->value.date.end == FHIR_SEARCH_INDEX_DATE_MAX);
+    const FHIRSearchIndexRow* fraction = find_row(&rows, "date", 1);
+    ASSERT_TRUE(fraction->value.date.start == 1704067200000LL);
+    ASSERT_TRUE(fraction->value.date.end == 1704067200260LL);
+    // Invalid day leaves the start open
+    ASSERT_TRUE(find_row(&rows, "date", 2)->value.date.start == FHIR_SEARCH_INDEX_DATE_MIN);
+    ASSERT_TRUE(find_row(&rows, "date", 3)->value.date.start == 1799000LL);
+    fhir_search_index_rows_cleanup(&rows);
+
+    double value;
+    const char* canonical;
+    ASSERT_TRUE(fhir_search_index_normalize_quantity(98.6, "[degF]", &value, &canonical));
+    ASSERT_STR_EQ("Cel", canonical);
+    ASSERT_TRUE(fabs(value - 37.0) < 1e-9);
+    ASSERT_TRUE(fhir_search_index_normalize_quantity(120, "mm[Hg]", &value, &canonical));
+    ASSERT_STR_EQ("Pa", canonical);
+    ASSERT_FALSE(fhir_search_index_normalize_quantity(1, "furlong", &value, &canonical));
+    return true;
+}
+
+bool test_search_index_load(void) {
+    size_t count;
+    ASSERT_NOT_NULL(fhir_search_index_get_parameters(FHIR_RESOURCE_TYPE_PATIENT, &count));
+    ASSERT_TRUE(count > 10);
+    ASSERT_NULL(fhir_search_index_get_parameters(FHIR_RESOURCE_TYPE_BINARY, &count));
+    ASSERT_EQ(0, count);
+
+    // One parse feeds both the typed resource and the index rows
+    cJSON* json = cJSON_Parse(PATIENT_JSON);
+    FHIRPatient* patient = fhir_patient_create("p1");
+    FHIRSearchIndexRows rows;
+    fhir_search_index_rows_init(&rows);
+    ASSERT_TRUE(fhir_search_index_load(&patient->base, json, &rows));
+    ASSERT_EQ(FHIR_PATIENT_GENDER_FEMALE, patient->gender);
+    ASSERT_STR_EQ("12345", find_row(&rows, "identifier", 0)->value.token.code);
+
+    // Rows stay on the heap while an arena is current
+    FHIRArena* arena = fhir_arena_create(0);
+    FHIRArena* previous = fhir_arena_set_current(arena);
+    ASSERT_TRUE(fhir_search_index_extract(json, &rows));
+    fhir_arena_set_current(previous);
+    fhir_arena_destroy(arena);
+    ASSERT_EQ(4, count_rows(&rows, "given"));
+    ASSERT_STR_EQ("james", find_row(&rows, "given", 3)->value.string);
+
+    cJSON* untyped = cJSON_Parse("{\"resourceType\":\"Basic\",\"id\":\"b1\"}");
+    size_t before = rows.count;
+    ASSERT_TRUE(fhir_search_index_extract(untyped, &rows));
+    ASSERT_EQ(before, rows.count);
+    cJSON_Delete(untyped);
+    ASSERT_FALSE(fhir_search_index_extract(NULL, &rows));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    fhir_search_index_rows_cleanup(&rows);
+    fhir_resource_release(&patient->base);
+    cJSON_Delete(json);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_search_index_patient);
+    RUN_TEST(test_search_index_observation);
+    RUN_TEST(test_search_index_dates_and_units);
+    RUN_TEST(test_search_index_load);
+
+    TEST_FINALIZE();
+    return 0;
+}
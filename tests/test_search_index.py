@@ -0,0 +1,39 @@
+"""Tests for search parameter extraction with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestSearchIndex:
+    """Test cases for search index extraction."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_search_index(self):
+        """Test search parameter index rows extracted in C."""
+        fhir_parser_c = pytest.importorskip("fast_fhir.fhir_parser_c")
+        
+        observation = {
+            "resourceType": "Observation", "id": "o1", "status": "final",
+            "code": {"coding": [{"system": "http://loinc.org", "code": "2339-0"}]},
+            "subject": {"reference": "Patient/p1"},
+            "effectivePeriod": {"start": "2024-03-01"},
+            "valueQuantity": {"value": 95, "system": "http://unitsofmeasure.org", "code": "mg/dL"}
+        }
+        rows = self.parser.extract_search_index(observation)
+        assert ("code", "token", "http://loinc.org", "2339-0") in rows
+        assert ("status", "token", None, "final") in rows
+        assert ("patient", "reference", "Patient", "p1") in rows
+        assert ("date", "date", 1709251200000, None) in rows
+        quantity = next(row for row in rows if row[0] == "value-quantity")
+        assert quantity[1:] == ("quantity", pytest.approx(0.95), "http://unitsofmeasure.org", "g/L")
+        
+        document = fhir_parser_c.ParsedDocument(json.dumps(
+            {"resourceType": "Patient", "id": "p1", "name": [{"family": "Smith"}]}))
+        assert ("family", "string", "smith") in self.parser.extract_search_index(document)
+        assert fhir_parser_c.extract_search_index('{"resourceType": "Basic"}') == []
+        with pytest.raises(ValueError):
+            fhir_parser_c.extract_search_index('{"id": "x"}')
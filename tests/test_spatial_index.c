@@ -0,0 +1,230 @@
+/**
+ * @file test_spatial_index.c
+ * @brief Unit tests for the Location spatial index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_spatial_index.h"
+#include <string.h>
+
+static const char* CLINIC_JSON =
+    "{\"resourceType\":\"Location\",\"id\":\"clinic\","
+    "\"position\":{\"longitude\":-0.1278,\"latitude\":51.5074},"
+    "\"hoursOfOperation\":[{\"daysOfWeek\":[\"mon\",\"tue\",\"wed\",\"thu\",\"fri\"],"
+    "\"openingTime\":\"08:00:00\",\"closingTime\":\"18:00:00\"}]}";
+
+static const char* NIGHT_PHARMACY_JSON =
+    "{\"resourceType\":\"Location\",\"id\":\"pharmacy\","
+    "\"position\":{\"longitude\":-0.1400,\"latitude\":51.5200},"
+    "\"hoursOfOperation\":[{\"availableTime\":[{\"daysOfWeek\":[\"fri\"],"
+    "\"availableStartTime\":\"20:00:00\",\"availableEndTime\":\"02:00:00\"},"
+    "{\"daysOfWeek\":[\"sun\"],\"allDay\":true}]}]}";
+
+static const char* HOSPITAL_JSON =
+    "{\"resourceType\":\"Location\",\"id\":\"hospital\","
+    "\"position\":{\"longitude\":2.3522,\"latitude\":48.8566}}";
+
+// Parse, index and free a resource
+static bool upsert(FHIRSpatialIndex* index, const char* text, size_t value, bool* indexed) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_spatial_index_upsert_json(index, json, value, indexed);
+    cJSON_Delete(json);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Resource Tests                                                             */
+/* ========================================================================== */
+
+bool test_spatial_index_resources(void) {
+    FHIRSpatialIndex* index = fhir_spatial_index_create();
+    ASSERT_NOT_NULL(index);
+    bool indexed;
+
+    ASSERT_TRUE(upsert(index, CLINIC_JSON, 0, &indexed));
+    ASSERT_TRUE(indexed);
+    ASSERT_TRUE(upsert(index, NIGHT_PHARMACY_JSON, 1, &indexed));
+    ASSERT_TRUE(upsert(index, HOSPITAL_JSON, 2, &indexed));
+    ASSERT_EQ(3, fhir_spatial_index_count(index));
+
+    const FHIRSpatialEntry* clinic = fhir_spatial_index_get(index, "clinic");
+    ASSERT_NOT_NULL(clinic);
+    ASSERT_EQ(1, clinic->hours_count);
+    ASSERT_EQ(0x1F, clinic->hours[0].days);
+    ASSERT_EQ(480, clinic->hours[0].open_minute);
+    ASSERT_EQ(2, fhir_spatial_index_get(index, "pharmacy")->hours_count);
+
+    ASSERT_FALSE(upsert(index, "{\"resourceType\":\"Patient\",\"id\":\"p\"}", 3, &indexed));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_FALSE(upsert(index, "{\"resourceType\":\"Location\"}", 3, &indexed));
+
+    FHIRSpatialResult result;
+    fhir_spatial_result_init(&result);
+
+    // London to Paris is about 344 km
+    ASSERT_TRUE(fhir_spatial_index_nearest(index, 51.5074, -0.1278, 3, NULL, &result));
+    ASSERT_EQ(3, result.count);
+    ASSERT_STR_EQ("clinic", result.items[0].entry->id);
+    ASSERT_STR_EQ("pharmacy", result.items[1].entry->id);
+    ASSERT_STR_EQ("hospital", result.items[2].entry->id);
+    ASSERT_TRUE(result.items[2].distance > 340000.0 && result.items[2].distance < 348000.0);
+    ASSERT_EQ(2, result.items[2].entry->value);
+
+    ASSERT_TRUE(fhir_spatial_index_within(index, 51.5074, -0.1278, 5000.0, NULL, &result));
+    ASSERT_EQ(2, result.count);
+
+    // Tuesday 09:00 only the clinic, Saturday 01:00 the pharmacy from Friday night
+    FHIRSpatialOpenAt tuesday = { 1, 9 * 60 };
+    ASSERT_TRUE(fhir_spatial_index_nearest(index, 51.5, -0.1, 5, &tuesday, &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_STR_EQ("clinic", result.items[0].entry->id);
+    FHIRSpatialOpenAt saturday = { 5, 60 };
+    ASSERT_TRUE(fhir_spatial_index_nearest(index, 51.5, -0.1, 5, &saturday, &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_STR_EQ("pharmacy", result.items[0].entry->id);
+    FHIRSpatialOpenAt sunday = { 6, 23 * 60 };
+    ASSERT_TRUE(fhir_spatial_index_within(index, 51.5, -0.1, 10000.0, &sunday, &result));
+    ASSERT_EQ(1, result.count);
+
+    // Moving the hospital to London and dropping the clinic position
+    ASSERT_TRUE(upsert(index, "{\"resourceType\":\"Location\",\"id\":\"hospital\","
+                              "\"position\":{\"longitude\":-0.1280,\"latitude\":51.5080}}", 7, &indexed));
+    ASSERT_TRUE(upsert(index, "{\"resourceType\":\"Location\",\"id\":\"clinic\"}", 0, &indexed));
+    ASSERT_FALSE(indexed);
+    ASSERT_EQ(2, fhir_spatial_index_count(index));
+    ASSERT_TRUE(fhir_spatial_index_nearest(index, 51.5074, -0.1278, 1, NULL, &result));
+    ASSERT_EQ(1, result.count);
+    ASSERT_STR_EQ("hospital", result.items[0].entry->id);
+    ASSERT_EQ(7, result.items[0].entry->value);
+    ASSERT_TRUE(fhir_spatial_index_within(index, 48.8566, 2.3522, 50000.0, NULL, &result));
+    ASSERT_EQ(0, result.count);
+
+    ASSERT_TRUE(fhir_spatial_index_remove(index, "pharmacy"));
+    ASSERT_FALSE(fhir_spatial_index_remove(index, "pharmacy"));
+    ASSERT_NULL(fhir_spatial_index_get(index, "pharmacy"));
+    ASSERT_EQ(1, fhir_spatial_index_count(index));
+
+    fhir_spatial_result_cleanup(&result);
+    fhir_spatial_index_destroy(index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Query Correctness Tests                                                    */
+/* ========================================================================== */
+
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static double random_between(uint32_t* state, double low, double high) {
+    return low + (high - low) * (double)(next_random(state) % 1000000) / 1000000.0;
+}
+
+static size_t brute_force(const FHIRSpatialEntry* entries, const bool* present, size_t count,
+                          double latitude, double longitude, double radius) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (present[i] && fhir_spatial_distance(latitude, longitude, entries[i].latitude,
+                                                entries[i].longitude) <= radius) {
+            matches++;
+        }
+    }
+    return matches;
+}
+
+bool test_spatial_index_matches_scan(void) {
+    enum { ENTRY_COUNT = 2000, QUERY_COUNT = 300 };
+    static FHIRSpatialEntry entries[ENTRY_COUNT];
+    static char ids[ENTRY_COUNT][16];
+    static bool present[ENTRY_COUNT];
+    uint32_t state = 7;
+
+    FHIRSpatialIndex* index = fhir_spatial_index_create();
+    FHIRSpatialResult result;
+    fhir_spatial_result_init(&result);
+
+    // A dense cluster plus points near the poles and the antimeridian
+    for (size_t i = 0; i < ENTRY_COUNT; i++) {
+        memset(&entries[i], 0, sizeof(entries[i]));
+        snprintf(ids[i], sizeof(ids[i]), "loc-%zu", i);
+        entries[i].id = ids[i];
+        if (i % 4 == 0) {
+            entries[i].latitude = random_between(&state, -90.0, 90.0);
+            entries[i].longitude = random_between(&state, -180.0, 180.0);
+        } else if (i % 4 == 1) {
+            entries[i].latitude = random_between(&state, 88.0, 90.0);
+            entries[i].longitude = random_between(&state, -180.0, 180.0);
+        } else if (i % 4 == 2) {
+            entries[i].latitude = random_between(&state, -10.0, 10.0);
+            entries[i].longitude = i % 8 == 2 ? random_between(&state, 179.0, 180.0)
+                                              : random_between(&state, -180.0, -179.0);
+        } else {
+            entries[i].latitude = random_between(&state, 40.0, 41.0);
+            entries[i].longitude = random_between(&state, -74.5, -73.5);
+        }
+        ASSERT_TRUE(fhir_spatial_index_upsert(index, &entries[i]));
+        present[i] = true;
+    }
+
+    // Move and remove a share of the entries
+    for (size_t i = 0; i < ENTRY_COUNT; i += 5) {
+        entries[i].latitude = random_between(&state, 40.0, 41.0);
+        entries[i].longitude = random_between(&state, -74.5, -73.5);
+        ASSERT_TRUE(fhir_spatial_index_upsert(index, &entries[i]));
+    }
+    for (size_t i = 3; i < ENTRY_COUNT; i += 7) {
+        ASSERT_TRUE(fhir_spatial_index_remove(index, ids[i]));
+        present[i] = false;
+    }
+
+    static const double radii[] = { 500.0, 20000.0, 300000.0, 5000000.0, 25000000.0 };
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        double latitude, longitude;
+        if (q % 3 == 0) {
+            latitude = random_between(&state, 40.0, 41.0);
+            longitude = random_between(&state, -74.5, -73.5);
+        } else if (q % 3 == 1) {
+            latitude = random_between(&state, -5.0, 5.0);
+            longitude = q % 2 ? 179.99 : -179.99;
+        } else {
+            latitude = random_between(&state, -90.0, 90.0);
+            longitude = random_between(&state, -180.0, 180.0);
+        }
+        double radius = radii[q % 5];
+
+        ASSERT_TRUE(fhir_spatial_index_within(index, latitude, longitude, radius, NULL, &result));
+        ASSERT_EQ(brute_force(entries, present, ENTRY_COUNT, latitude, longitude, radius), result.count);
+        for (size_t i = 1; i < result.count; i++) {
+            ASSERT_TRUE(result.items[i - 1].distance <= result.items[i].distance);
+        }
+
+        // The k-th nearest is as far as the k-th smallest distance
+        size_t k = 1 + (size_t)(q % 10);
+        ASSERT_TRUE(fhir_spatial_index_nearest(index, latitude, longitude, k, NULL, &result));
+        ASSERT_EQ(k, result.count);
+        double farthest = result.items[k - 1].distance;
+        ASSERT_EQ(brute_force(entries, present, ENTRY_COUNT, latitude, longitude, farthest) >= k, true);
+        ASSERT_TRUE(brute_force(entries, present, ENTRY_COUNT, latitude, longitude, farthest * (1.0 - 1e-12)) < k);
+    }
+
+    ASSERT_FALSE(fhir_spatial_index_within(index, 91.0, 0.0, 10.0, NULL, &result));
+    ASSERT_FALSE(fhir_spatial_index_upsert(index, &(FHIRSpatialEntry){ .id = "bad", .latitude = 0.0, .longitude = 181.0 }));
+
+    fhir_spatial_result_cleanup(&result);
+    fhir_spatial_index_destroy(index);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_spatial_index_resources);
+    RUN_TEST(test_spatial_index_matches_scan);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,47 @@
+"""Tests for the spatial index with C extensions."""
+
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestSpatialIndex:
+    """Test cases for the spatial index."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_spatial_index(self):
+        """Test proximity queries over Location positions."""
+        pytest.importorskip("fast_fhir.fhir_spatial_c")
+        
+        locations = [
+            {"resourceType": "Location", "id": "clinic", "position": {"longitude": -0.1278, "latitude": 51.5074},
+             "hoursOfOperation": [{"daysOfWeek": ["mon", "tue", "wed", "thu", "fri"],
+                                   "openingTime": "08:00:00", "closingTime": "18:00:00"}]},
+            {"resourceType": "Location", "id": "pharmacy", "position": {"longitude": -0.14, "latitude": 51.52}},
+            {"resourceType": "Location", "id": "hospital", "position": {"longitude": 2.3522, "latitude": 48.8566}},
+            {"resourceType": "Location", "id": "virtual"},
+        ]
+        index = self.parser.build_spatial_index(locations)
+        assert len(index) == 3
+        
+        nearest = index.nearest(51.5074, -0.1278, 2)
+        assert [hit[0] for hit in nearest] == ["clinic", "pharmacy"]
+        assert nearest[0][1] == 0.0
+        assert [hit[0] for hit in index.within(51.5074, -0.1278, 400000)] == ["clinic", "pharmacy", "hospital"]
+        assert index.nearest(51.5, -0.1, 5, open_at=("sat", "10:00")) == []
+        assert [hit[0] for hit in index.within(51.5, -0.1, 5000, ("mon", "09:30"))] == ["clinic"]
+        
+        assert index.upsert('{"resourceType": "Location", "id": "hospital", '
+                            '"position": {"longitude": -0.1279, "latitude": 51.5075}}')
+        assert index.nearest(48.8566, 2.3522, 1)[0][1] > 300000
+        assert index.remove("clinic")
+        assert not index.remove("clinic")
+        assert [hit[0] for hit in index.nearest(51.5074, -0.1278, 5)] == ["hospital", "pharmacy"]
+        with pytest.raises(ValueError):
+            index.upsert('{"resourceType": "Patient", "id": "p"}')
+        with pytest.raises(ValueError):
+            index.within(95.0, 0.0, 10.0)
+        with pytest.raises(ValueError):
+            index.nearest(0.0, 0.0, 1, open_at=("someday", "10:00"))
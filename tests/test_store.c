@@ -0,0 +1,215 @@
+/**
+ * @file test_store.c
+ * @brief Unit tests for the memory-mapped resource store
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_store.h"
+#include "../resources/fhir_patient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const char* STORE_PATH = "test_store.fhrs";
+
+static bool build_store(size_t patient_count) {
+    FHIRStoreBuilder* builder = fhir_store_builder_create();
+    ASSERT_NOT_NULL(builder);
+
+    char json[160];
+    // Added in reverse so the builder has to sort
+    for (size_t i = patient_count; i-- > 0;) {
+        snprintf(json, sizeof(json),
+                 "{\"resourceType\":\"Patient\",\"id\":\"p%zu\",\"active\":%s,\"gender\":\"male\"}",
+                 i, i % 2 ? "true" : "false");
+        FHIRPatient* patient = fhir_patient_parse(json);
+        ASSERT_NOT_NULL(patient);
+        ASSERT_TRUE(fhir_store_builder_add(builder, &patient->base));
+        fhir_resource_release(&patient->base);
+    }
+
+    // Reference types without a typed parser are stored as JSON
+    cJSON* practitioner = cJSON_Parse(
+        "{\"resourceType\":\"Practitioner\",\"id\":\"p0\",\"name\":[{\"family\":\"Careful\"}]}");
+    ASSERT_TRUE(fhir_store_builder_add_json(builder, practitioner));
+    cJSON_Delete(practitioner);
+
+    cJSON* anonymous = cJSON_Parse("{\"resourceType\":\"Organization\"}");
+    ASSERT_FALSE(fhir_store_builder_add_json(builder, anonymous));
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, fhir_get_last_error()->code);
+    cJSON_Delete(anonymous);
+
+    ASSERT_EQ(patient_count + 1, fhir_store_builder_get_count(builder));
+    ASSERT_TRUE(fhir_store_builder_write(builder, STORE_PATH));
+    fhir_store_builder_destroy(builder);
+    return true;
+}
+
+/* ========================================================================== */
+/* Store Tests                                                                */
+/* ========================================================================== */
+
+bool test_store_lookup(void) {
+    ASSERT_TRUE(build_store(1000));
+
+    FHIRStore* store = fhir_store_open(STORE_PATH);
+    ASSERT_NOT_NULL(store);
+    ASSERT_EQ(1001, fhir_store_get_count(store));
+
+    FHIRPatient* patient = (FHIRPatient*)fhir_store_get(store, FHIR_RESOURCE_TYPE_PATIENT, "p737");
+    ASSERT_NOT_NULL(patient);
+    ASSERT_STR_EQ("p737", patient->base.id);
+    ASSERT_TRUE(patient->active && patient->active->value);
+    ASSERT_EQ(FHIR_PATIENT_GENDER_MALE, patient->gender);
+
+    // Same id, different type
+    cJSON* practitioner = fhir_store_get_json(store, FHIR_RESOURCE_TYPE_PRACTITIONER, "p0");
+    ASSERT_NOT_NULL(practitioner);
+    ASSERT_STR_EQ("Careful", cJSON_GetArrayItem(cJSON_GetObjectItem(practitioner, "name"), 0)
+                                 ->child->valuestring);
+    cJSON_Delete(practitioner);
+    cJSON* json = fhir_store_get_json(store, FHIR_RESOURCE_TYPE_PATIENT, "p0");
+    ASSERT_NOT_NULL(json);
+    ASSERT_FALSE(cJSON_IsTrue(cJSON_GetObjectItem(json, "active")));
+    cJSON_Delete(json);
+
+    // Misses leave no error
+    ASSERT_NULL(fhir_store_get(store, FHIR_RESOURCE_TYPE_PATIENT, "p1000"));
+    ASSERT_NULL(fhir_get_last_error());
+    ASSERT_NULL(fhir_store_get(store, FHIR_RESOURCE_TYPE_ORGANIZATION, "p0"));
+
+    // Entries are sorted by type, then id
+    FHIRResourceType type;
+    const char* id;
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_store_get_entry(store, 0, &type, &id, &document));
+    ASSERT_TRUE(type == FHIR_RESOURCE_TYPE_PATIENT || type == FHIR_RESOURCE_TYPE_PRACTITIONER);
+    const char* previous = id;
+    for (size_t i = 1; i < fhir_store_get_count(store); i++) {
+        FHIRResourceType next_type;
+        ASSERT_TRUE(fhir_store_get_entry(store, i, &next_type, &id, NULL));
+        ASSERT_TRUE(next_type > type || (next_type == type && strcmp(previous, id) < 0));
+        type = next_type;
+        previous = id;
+    }
+    ASSERT_FALSE(fhir_store_get_entry(store, 1001, NULL, NULL, NULL));
+
+    // Decoded resources outlive the mapping
+    fhir_store_close(store);
+    ASSERT_STR_EQ("p737", patient->base.id);
+    fhir_resource_release(&patient->base);
+    remove(STORE_PATH);
+    return true;
+}
+
+bool test_store_build_from_ndjson(void) {
+    const char* input_path = "test_store_input.ndjson";
+    FILE* file = fopen(input_path, "wb");
+    ASSERT_NOT_NULL(file);
+    fputs("{\"resourceType\":\"Patient\",\"id\":\"a\",\"gender\":\"other\"}\n"
+          "{\"resourceType\":\"Location\",\"id\":\"ward-1\",\"name\":\"Ward 1\"}\n"
+          "{\"resourceType\":\"Location\",\"name\":\"No id\"}\n"
+          "{\"resourceType\":\"NotAType\",\"id\":\"x\"}\n"
+          "not json\n", file);
+    fclose(file);
+
+    FHIRStoreBuilder* builder = fhir_store_builder_create();
+    ASSERT_NOT_NULL(builder);
+    size_t added;
+    ASSERT_TRUE(fhir_store_builder_add_ndjson(builder, input_path, NULL, &added));
+    ASSERT_EQ(2, added);
+    ASSERT_TRUE(fhir_store_builder_write(builder, STORE_PATH));
+    fhir_store_builder_destroy(builder);
+    remove(input_path);
+
+    FHIRStore* store = fhir_store_open(STORE_PATH);
+    ASSERT_NOT_NULL(store);
+    FHIRBinaryDocument document;
+    ASSERT_TRUE(fhir_store_find(store, FHIR_RESOURCE_TYPE_PATIENT, "a", &document));
+    ASSERT_FALSE(document.flags & FHIR_BINARY_FLAG_JSON);
+    cJSON* location = fhir_store_get_json(store, FHIR_RESOURCE_TYPE_LOCATION, "ward-1");
+    ASSERT_NOT_NULL(location);
+    ASSERT_STR_EQ("Ward 1", fhir_json_get_string(location, "name"));
+    cJSON_Delete(location);
+
+    fhir_store_close(store);
+    remove(STORE_PATH);
+    return true;
+}
+
+bool test_store_shared_after_fork(void) {
+    ASSERT_TRUE(build_store(10));
+    FHIRStore* store = fhir_store_open(STORE_PATH);
+    ASSERT_NOT_NULL(store);
+
+    pid_t child = fork();
+    ASSERT_TRUE(child >= 0);
+    if (child == 0) {
+        FHIRBinaryDocument document;
+        bool found = fhir_store_find(store, FHIR_RESOURCE_TYPE_PATIENT, "p3", &document) &&
+                     strcmp(fhir_binary_get_id(&document), "p3") == 0;
+        _exit(found ? 0 : 1);
+    }
+    int status;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    fhir_store_close(store);
+    remove(STORE_PATH);
+    return true;
+}
+
+bool test_store_rejects_bad_input(void) {
+    FHIRStoreBuilder* builder = fhir_store_builder_create();
+    ASSERT_NOT_NULL(builder);
+    cJSON* json = cJSON_Parse("{\"resourceType\":\"Location\",\"id\":\"l1\"}");
+    ASSERT_TRUE(fhir_store_builder_add_json(builder, json));
+    ASSERT_TRUE(fhir_store_builder_add_json(builder, json));
+    cJSON_Delete(json);
+    ASSERT_FALSE(fhir_store_builder_write(builder, STORE_PATH));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    fhir_store_builder_destroy(builder);
+
+    ASSERT_NULL(fhir_store_open("does-not-exist.fhrs"));
+    ASSERT_EQ(FHIR_ERROR_IO, fhir_get_last_error()->code);
+
+    // Truncated files are rejected on open or on lookup
+    ASSERT_TRUE(build_store(3));
+    FILE* file = fopen(STORE_PATH, "rb");
+    ASSERT_NOT_NULL(file);
+    uint8_t contents[4096];
+    size_t length = fread(contents, 1, sizeof(contents), file);
+    fclose(file);
+    for (size_t cut = 0; cut < length; cut += 7) {
+        file = fopen(STORE_PATH, "wb");
+        fwrite(contents, 1, cut, file);
+        fclose(file);
+        FHIRStore* store = fhir_store_open(STORE_PATH);
+        if (store) {
+            FHIRResourceBase* resource = fhir_store_get(store, FHIR_RESOURCE_TYPE_PATIENT, "p2");
+            if (resource) fhir_resource_release(resource);
+            fhir_store_close(store);
+        } else {
+            ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+        }
+    }
+    remove(STORE_PATH);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+    fhir_patient_register();
+
+    RUN_TEST(test_store_lookup);
+    RUN_TEST(test_store_build_from_ndjson);
+    RUN_TEST(test_store_shared_after_fork);
+    RUN_TEST(test_store_rejects_bad_input);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,100 @@
+"""Tests for resource storage with C extensions."""
+
+import json
+import os
+import tempfile
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestResourceStore:
+    """Test cases for the resource store and shared batches."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_resource_store(self):
+        """Test building and reading a memory-mapped resource store."""
+        fhir_store_c = pytest.importorskip("fast_fhir.fhir_store_c")
+        
+        lines = [json.dumps({"resourceType": "Patient", "id": f"p{i}", "gender": "female"})
+                 for i in range(100)]
+        lines.append(json.dumps({"resourceType": "Organization", "id": "o1", "name": "Acme"}))
+        lines.append(json.dumps({"resourceType": "Patient", "gender": "male"}))
+        
+        with tempfile.NamedTemporaryFile(suffix=".ndjson", delete=False) as f:
+            f.write("\n".join(lines).encode())
+            source = f.name
+        path = source + ".fhrs"
+        
+        try:
+            assert self.parser.build_resource_store(path, source) == 101
+            store = self.parser.open_resource_store(path)
+            assert len(store) == 101
+            assert store.get("Patient", "p42") == {"resourceType": "Patient", "id": "p42",
+                                                   "gender": "female"}
+            assert store.get("Organization", "o1")["name"] == "Acme"
+            assert store.get("Patient", "missing") is None
+            with pytest.raises(ValueError):
+                store.get("NotAType", "p1")
+            store.close()
+            with pytest.raises(ValueError):
+                store.get("Patient", "p1")
+            
+            with pytest.raises(OSError):
+                fhir_store_c.ResourceStore(path + ".missing")
+        finally:
+            os.remove(source)
+            if os.path.exists(path):
+                os.remove(path)
+    
+    def test_shared_batch(self):
+        """Test handing a batch to another mapping of a shared memory segment."""
+        pytest.importorskip("fast_fhir.fhir_lazy_c")
+        fhir_store_c = pytest.importorskip("fast_fhir.fhir_store_c")
+        from multiprocessing import shared_memory
+        
+        lazy = self.parser.parse_lazy(json.dumps({"resourceType": "Patient", "id": "p1",
+                                                  "name": [{"family": "Chalmers"}]}))
+        resources = [lazy, {"resourceType": "Observation", "id": "o1", "status": "final"},
+                     '{"resourceType": "Basic"}']
+        segment = self.parser.export_shared_batch(resources)
+        try:
+            # A reader attaches by name, as another process would
+            reader = shared_memory.SharedMemory(name=segment.name)
+            batch = self.parser.open_shared_batch(reader)
+            assert len(batch) == 3
+            assert [batch.id(i) for i in range(3)] == ["p1", "o1", None]
+            assert batch[0].name[0].family == "Chalmers"
+            assert batch[1].status == "final"
+            assert batch[-1].to_dict() == {"resourceType": "Basic"}
+            assert batch[1] is batch[1]
+            with pytest.raises(IndexError):
+                batch[3]
+        
+            # The segment stays exported until the batch is released
+            patient = batch[0]
+            with pytest.raises(BufferError):
+                reader.close()
+            batch.release()
+            reader.close()
+            assert patient.id == "p1"
+            with pytest.raises(ValueError):
+                batch[0]
+        finally:
+            segment.close()
+            segment.unlink()
+        
+        data = fhir_store_c.export_batch([lazy.to_binary()])
+        with pytest.raises(ValueError, match="too small"):
+            fhir_store_c.export_batch([lazy.to_binary()], bytearray(len(data) - 1))
+        target = bytearray(len(data) + 8)
+        assert fhir_store_c.export_batch([lazy.to_binary()], target) == len(data)
+        # Without a loader, items decode to dicts
+        with fhir_store_c.open_batch(target) as batch:
+            assert batch[0] == {"resourceType": "Patient", "id": "p1", "name": [{"family": "Chalmers"}]}
+        with pytest.raises(ValueError):
+            fhir_store_c.open_batch(b"not a batch")
+        with pytest.raises(ValueError):
+            fhir_store_c.export_batch(["[1, 2]"])
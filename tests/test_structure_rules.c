@@ -0,0 +1,200 @@
+/**
+ * @file test_structure_rules.c
+ * @brief Unit tests for table-driven structural validation
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_structure_rules.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool validate(const char* text, const char* resource_type) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = fhir_structure_validate(json, resource_type);
+    cJSON_Delete(json);
+    return ok;
+}
+
+/* ========================================================================== */
+/* Care Provision Tests                                                       */
+/* ========================================================================== */
+
+bool test_structure_care_plan(void) {
+    ASSERT_TRUE(validate(
+        "{\"resourceType\":\"CarePlan\",\"id\":\"cp-1\",\"status\":\"active\",\"intent\":\"plan\","
+        "\"subject\":{\"reference\":\"Patient/1\"},\"title\":null,"
+        "\"activity\":[{\"detail\":{\"status\":\"scheduled\"}},{}]}", NULL));
+
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"CarePlan\",\"status\":\"active\",\"intent\":\"plan\"}", NULL));
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, fhir_get_last_error()->code);
+    ASSERT_STR_EQ("subject", fhir_get_last_error()->field);
+
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"CarePlan\",\"status\":\"finished\",\"intent\":\"plan\","
+        "\"subject\":{}}", NULL));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    ASSERT_STR_EQ("status", fhir_get_last_error()->field);
+
+    // Nested paths name the offending item
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"CarePlan\",\"status\":\"active\",\"intent\":\"plan\",\"subject\":{},"
+        "\"activity\":[{\"detail\":{\"status\":\"scheduled\"}},{\"detail\":{\"status\":\"later\"}}]}", NULL));
+    ASSERT_STR_EQ("activity[1].detail.status", fhir_get_last_error()->field);
+
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"CarePlan\",\"status\":\"active\",\"intent\":\"plan\",\"subject\":{},"
+        "\"goal\":{\"reference\":\"Goal/1\"}}", NULL));
+    ASSERT_STR_EQ("goal", fhir_get_last_error()->field);
+    return true;
+}
+
+bool test_structure_vision_prescription(void) {
+    const char* valid =
+        "{\"resourceType\":\"VisionPrescription\",\"status\":\"active\","
+        "\"patient\":{\"reference\":\"Patient/1\"},\"prescriber\":{\"reference\":\"Practitioner/1\"},"
+        "\"lensSpecification\":[{\"eye\":\"right\",\"sphere\":-2,\"axis\":180,"
+        "\"prism\":[{\"amount\":0.5,\"base\":\"up\"}]}]}";
+    ASSERT_TRUE(validate(valid, NULL));
+    ASSERT_TRUE(validate(valid, "VisionPrescription"));
+
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"VisionPrescription\",\"status\":\"active\",\"patient\":{},\"prescriber\":{},"
+        "\"lensSpecification\":[{\"axis\":90.5}]}", NULL));
+    ASSERT_STR_EQ("lensSpecification[0].axis", fhir_get_last_error()->field);
+
+    ASSERT_FALSE(validate(
+        "{\"resourceType\":\"VisionPrescription\",\"status\":\"active\",\"patient\":{},\"prescriber\":{},"
+        "\"lensSpecification\":[{},{\"prism\":[{\"base\":\"sideways\"}]}]}", NULL));
+    ASSERT_STR_EQ("lensSpecification[1].prism[0].base", fhir_get_last_error()->field);
+    return true;
+}
+
+/* ========================================================================== */
+/* Resource Type Tests                                                        */
+/* ========================================================================== */
+
+bool test_structure_resource_type(void) {
+    // A hint stands in for a missing resourceType but must match a declared one
+    ASSERT_TRUE(validate("{\"status\":\"completed\"}", "Encounter"));
+    ASSERT_FALSE(validate("{\"resourceType\":\"Patient\"}", "Encounter"));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_FALSE(validate("{\"status\":\"completed\"}", NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_FALSE(validate("{\"resourceType\":\"Unsupported\"}", NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    ASSERT_FALSE(validate("[]", NULL));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    ASSERT_TRUE(validate("{\"resourceType\":\"Patient\",\"id\":\"p.1\",\"gender\":\"female\"}", NULL));
+    ASSERT_FALSE(validate("{\"resourceType\":\"Patient\",\"id\":\"p 1\"}", NULL));
+    ASSERT_STR_EQ("id", fhir_get_last_error()->field);
+    ASSERT_FALSE(validate("{\"resourceType\":\"Patient\",\"active\":\"yes\"}", NULL));
+    ASSERT_STR_EQ("active", fhir_get_last_error()->field);
+
+    ASSERT_NOT_NULL(fhir_structure_rules_find("RiskAssessment"));
+    ASSERT_NULL(fhir_structure_rules_find("Bundle"));
+    return true;
+}
+
+/* ========================================================================== */
+/* Batch Tests                                                                */
+/* ========================================================================== */
+
+bool test_structure_split(void) {
+    const char* ndjson = "{\"a\":1}\r\n\n  \n{\"b\":2}";
+    size_t count;
+    FHIRStructureInput* inputs = fhir_structure_split_lines(ndjson, strlen(ndjson), &count);
+    ASSERT_NOT_NULL(inputs);
+    ASSERT_EQ(2, count);
+    ASSERT_EQ(1, inputs[0].line_number);
+    ASSERT_EQ(7, inputs[0].length);
+    ASSERT_EQ(4, inputs[1].line_number);
+    fhir_free(inputs);
+
+    // Brackets and commas inside strings do not split elements
+    const char* array = " [ {\"a\":\"],\\\"[\"} , [1,{\"b\":[]}],\"x\" ] \n";
+    inputs = fhir_structure_split_array(array, strlen(array), &count);
+    ASSERT_NOT_NULL(inputs);
+    ASSERT_EQ(3, count);
+    ASSERT_EQ(0, strncmp("{\"a\":\"],\\\"[\"}", inputs[0].text, inputs[0].length));
+    ASSERT_EQ(0, strncmp("[1,{\"b\":[]}]", inputs[1].text, inputs[1].length));
+    ASSERT_EQ(0, strncmp("\"x\"", inputs[2].text, inputs[2].length));
+    fhir_free(inputs);
+
+    inputs = fhir_structure_split_array("[]", 2, &count);
+    ASSERT_NOT_NULL(inputs);
+    ASSERT_EQ(0, count);
+    fhir_free(inputs);
+
+    ASSERT_NULL(fhir_structure_split_array("[1,]", 4, &count));
+    ASSERT_EQ(FHIR_ERROR_INVALID_JSON, fhir_get_last_error()->code);
+    ASSERT_NULL(fhir_structure_split_array("[1,2", 4, &count));
+    ASSERT_NULL(fhir_structure_split_array("{}", 2, &count));
+    return true;
+}
+
+bool test_structure_batch(void) {
+    enum { COUNT = 1000 };
+    static char texts[COUNT][160];
+    static FHIRStructureInput inputs[COUNT];
+    static FHIRStructureResult results[COUNT];
+
+    for (int i = 0; i < COUNT; i++) {
+        if (i % 7 == 3) {
+            snprintf(texts[i], sizeof(texts[i]), "{\"resourceType\":\"Goal\"");
+        } else if (i % 7 == 5) {
+            snprintf(texts[i], sizeof(texts[i]),
+                     "{\"resourceType\":\"Goal\",\"id\":\"g%d\",\"lifecycleStatus\":\"active\","
+                     "\"description\":{}}", i);
+        } else {
+            snprintf(texts[i], sizeof(texts[i]),
+                     "{\"resourceType\":\"Goal\",\"id\":\"g%d\",\"lifecycleStatus\":\"active\","
+                     "\"description\":{},\"subject\":{\"reference\":\"Patient/%d\"}}", i, i);
+        }
+        inputs[i].text = texts[i];
+        inputs[i].length = strlen(texts[i]);
+        inputs[i].line_number = 0;
+    }
+
+    size_t expected_failures = 0;
+    for (int i = 0; i < COUNT; i++) expected_failures += i % 7 == 3 || i % 7 == 5;
+
+    static const size_t thread_counts[] = { 1, 4, 0 };
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        ASSERT_EQ(expected_failures, fhir_structure_validate_batch(inputs, COUNT, "Goal",
+                                                                   thread_counts[t], results));
+        for (int i = 0; i < COUNT; i++) {
+            if (i % 7 == 3) {
+                ASSERT_EQ(FHIR_ERROR_INVALID_JSON, results[i].error_code);
+                ASSERT_NULL(results[i].json);
+            } else if (i % 7 == 5) {
+                ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, results[i].error_code);
+                ASSERT_STR_EQ("subject", results[i].error_field);
+            } else {
+                ASSERT_EQ(FHIR_ERROR_NONE, results[i].error_code);
+                ASSERT_NOT_NULL(results[i].json);
+            }
+        }
+        fhir_structure_results_clear(results, COUNT);
+    }
+
+    ASSERT_EQ(1, fhir_structure_validate_batch(inputs, 1, "CarePlan", 2, results));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, results[0].error_code);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_structure_care_plan);
+    RUN_TEST(test_structure_vision_prescription);
+    RUN_TEST(test_structure_resource_type);
+    RUN_TEST(test_structure_split);
+    RUN_TEST(test_structure_batch);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,448 @@
+/**
+ * @file test_terminology.c
+ * @brief Unit tests for the compiled terminology index
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_terminology.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TERMINOLOGY_THREADS 8
+#define TERMINOLOGY_CODES 2000
+
+static const char* g_code_system =
+    "{\"resourceType\":\"CodeSystem\",\"url\":\"http://example.org/cs\",\"concept\":["
+    "{\"code\":\"A\",\"display\":\"Alpha\",\"concept\":["
+    "{\"code\":\"A1\",\"display\":\"Alpha one\"},"
+    "{\"code\":\"A2\"}]},"
+    "{\"code\":\"B\",\"display\":\"Beta\"}]}";
+
+static const char* g_value_sets[] = {
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/enum\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/cs\",\"concept\":[{\"code\":\"A\"},{\"code\":\"B\"}]},"
+    "{\"system\":\"http://loinc.org\",\"concept\":[{\"code\":\"1234-5\"}]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/all\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/cs\"}],"
+    "\"exclude\":[{\"system\":\"http://example.org/cs\",\"concept\":[{\"code\":\"A2\"}]}]}}"
+};
+
+static const char* g_concept_map =
+    "{\"resourceType\":\"ConceptMap\",\"url\":\"http://example.org/cm\",\"group\":[{"
+    "\"source\":\"http://example.org/cs\",\"target\":\"http://snomed.info/sct\",\"element\":["
+    "{\"code\":\"A\",\"target\":[{\"code\":\"100\",\"display\":\"Hundred\",\"relationship\":\"equivalent\"},"
+    "{\"code\":\"101\",\"equivalence\":\"wider\"}]},"
+    "{\"code\":\"B\",\"target\":[{\"code\":\"200\"}]}]}]}";
+
+static const char* g_other_map =
+    "{\"resourceType\":\"ConceptMap\",\"url\":\"http://example.org/cm2\",\"group\":[{"
+    "\"source\":\"http://example.org/cs\",\"target\":\"http://loinc.org\",\"element\":["
+    "{\"code\":\"A\",\"target\":[{\"code\":\"9999-9\"}]}]}]}";
+
+static bool add_json(FHIRTerminologyIndex* index, const char* text,
+                     bool (*add)(FHIRTerminologyIndex*, const cJSON*)) {
+    cJSON* json = cJSON_Parse(text);
+    bool ok = json && add(index, json);
+    cJSON_Delete(json);
+    return ok;
+}
+
+static FHIRTerminologyIndex* build_index(void) {
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    if (!index ||
+        !add_json(index, g_code_system, fhir_terminology_add_code_system_json) ||
+        !add_json(index, g_value_sets[0], fhir_terminology_add_value_set_json) ||
+        !add_json(index, g_value_sets[1], fhir_terminology_add_value_set_json) ||
+        !add_json(index, g_concept_map, fhir_terminology_add_concept_map_json) ||
+        !add_json(index, g_other_map, fhir_terminology_add_concept_map_json)) {
+        fhir_terminology_index_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+static bool check_index(const FHIRTerminologyIndex* index) {
+    const char* cs = "http://example.org/cs";
+
+    // Displays, including nested concepts
+    ASSERT_STR_EQ("Alpha", fhir_terminology_lookup_display(index, cs, "A"));
+    ASSERT_STR_EQ("Alpha one", fhir_terminology_lookup_display(index, cs, "A1"));
+    ASSERT_NULL(fhir_terminology_lookup_display(index, cs, "A2"));
+    ASSERT_NULL(fhir_terminology_lookup_display(index, cs, "Z"));
+    ASSERT_NULL(fhir_terminology_lookup_display(index, "http://other.org", "A"));
+
+    // Hierarchy
+    const FHIRTerminologyConcept* child = fhir_terminology_find_concept(index, cs, "A1");
+    ASSERT_NOT_NULL(child);
+    const FHIRTerminologyConcept* parent = fhir_terminology_get_concept(index, child->parent);
+    ASSERT_NOT_NULL(parent);
+    ASSERT_STR_EQ("A", parent->code);
+    ASSERT_EQ(FHIR_TERMINOLOGY_NO_PARENT, parent->parent);
+
+    // Enumerated value set
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/enum", cs, "A"));
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/enum", "http://loinc.org", "1234-5"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/enum", cs, "A1"));
+
+    // Whole-system include with an exclusion
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/all", cs, "A1"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/all", cs, "A2"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/all", cs, "Z"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/none", cs, "A"));
+
+    // Translation through one map, in ConceptMap order
+    const FHIRTerminologyTranslation* results[4];
+    ASSERT_EQ(2, fhir_terminology_translate(index, "http://example.org/cm", cs, "A", results, 4));
+    ASSERT_STR_EQ("100", results[0]->target_code);
+    ASSERT_STR_EQ("Hundred", results[0]->target_display);
+    ASSERT_STR_EQ("equivalent", results[0]->equivalence);
+    ASSERT_STR_EQ("http://snomed.info/sct", results[0]->target_system);
+    ASSERT_STR_EQ("101", results[1]->target_code);
+    ASSERT_STR_EQ("wider", results[1]->equivalence);
+
+    // Translation through every map, truncated output still reports the total
+    ASSERT_EQ(3, fhir_terminology_translate(index, NULL, cs, "A", results, 1));
+    ASSERT_STR_EQ("100", results[0]->target_code);
+    ASSERT_EQ(3, fhir_terminology_translate(index, NULL, cs, "A", results, 4));
+    ASSERT_STR_EQ("9999-9", results[2]->target_code);
+    ASSERT_STR_EQ("http://example.org/cm2", results[2]->concept_map);
+    ASSERT_EQ(0, fhir_terminology_translate(index, "http://example.org/cm2", cs, "B", results, 4));
+    ASSERT_EQ(1, fhir_terminology_translate(index, NULL, cs, "B", NULL, 0));
+    return true;
+}
+
+/* ========================================================================== */
+/* Building and Lookup Tests                                                  */
+/* ========================================================================== */
+
+bool test_terminology_lookups(void) {
+    FHIRTerminologyIndex* index = build_index();
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(check_index(index));
+
+    FHIRTerminologyStats stats;
+    fhir_terminology_index_get_stats(index, &stats);
+    ASSERT_EQ(4, stats.concept_count);
+    ASSERT_EQ(5, stats.value_set_rule_count);
+    ASSERT_EQ(4, stats.translation_count);
+    ASSERT_TRUE(stats.bytes_used > 0);
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+bool test_terminology_add_concept(void) {
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    ASSERT_NOT_NULL(index);
+
+    char code[16];
+    for (int i = 0; i < TERMINOLOGY_CODES; i++) {
+        snprintf(code, sizeof(code), "C%d", i);
+        ASSERT_EQ((size_t)i, fhir_terminology_add_concept(index, "http://example.org/big", code, code,
+                                                          i ? (size_t)i - 1 : FHIR_TERMINOLOGY_NO_PARENT));
+    }
+
+    // Repeated codes keep their first definition; bad parents are rejected
+    ASSERT_EQ(5, fhir_terminology_add_concept(index, "http://example.org/big", "C5", "Other",
+                                              FHIR_TERMINOLOGY_NO_PARENT));
+    ASSERT_STR_EQ("C5", fhir_terminology_lookup_display(index, "http://example.org/big", "C5"));
+    ASSERT_EQ(FHIR_TERMINOLOGY_NO_PARENT,
+              fhir_terminology_add_concept(index, "http://example.org/big", "X", NULL, TERMINOLOGY_CODES));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+
+    for (int i = 0; i < TERMINOLOGY_CODES; i++) {
+        snprintf(code, sizeof(code), "C%d", i);
+        ASSERT_STR_EQ(code, fhir_terminology_lookup_display(index, "http://example.org/big", code));
+    }
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+bool test_terminology_invalid_resources(void) {
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    ASSERT_NOT_NULL(index);
+
+    ASSERT_FALSE(add_json(index, "{\"resourceType\":\"CodeSystem\"}", fhir_terminology_add_code_system_json));
+    ASSERT_EQ(FHIR_ERROR_MISSING_REQUIRED_FIELD, fhir_get_last_error()->code);
+    ASSERT_FALSE(add_json(index, "{\"url\":\"u\",\"concept\":[{\"display\":\"x\"}]}",
+                          fhir_terminology_add_code_system_json));
+    ASSERT_FALSE(add_json(index, "{\"resourceType\":\"ValueSet\"}", fhir_terminology_add_value_set_json));
+    ASSERT_FALSE(add_json(index, "{\"resourceType\":\"ConceptMap\"}", fhir_terminology_add_concept_map_json));
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+/* ========================================================================== */
+/* Persistence Tests                                                          */
+/* ========================================================================== */
+
+bool test_terminology_save_load(void) {
+    char path[] = "/tmp/fhir_terminology_test_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    FHIRTerminologyIndex* index = build_index();
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(fhir_terminology_index_save(index, path));
+    fhir_terminology_index_destroy(index);
+
+    FHIRTerminologyIndex* loaded = fhir_terminology_index_load(path);
+    ASSERT_NOT_NULL(loaded);
+    ASSERT_TRUE(check_index(loaded));
+    fhir_terminology_index_destroy(loaded);
+
+    // Truncated files are rejected
+    ASSERT_EQ(0, truncate(path, 40));
+    ASSERT_NULL(fhir_terminology_index_load(path));
+    ASSERT_EQ(FHIR_ERROR_PARSE_FAILED, fhir_get_last_error()->code);
+
+    remove(path);
+    ASSERT_NULL(fhir_terminology_index_load(path));
+    ASSERT_EQ(FHIR_ERROR_IO, fhir_get_last_error()->code);
+    return true;
+}
+
+/* ========================================================================== */
+/* Expansion Tests                                                            */
+/* ========================================================================== */
+
+// Body structure: finding -> {disorder -> {diabetes -> {type 1, type 2}, asthma}, symptom}
+static const char* g_hierarchy =
+    "{\"resourceType\":\"CodeSystem\",\"url\":\"http://example.org/sct\",\"concept\":["
+    "{\"code\":\"finding\",\"concept\":["
+    "{\"code\":\"disorder\",\"concept\":["
+    "{\"code\":\"diabetes\",\"concept\":[{\"code\":\"t1dm\"},{\"code\":\"t2dm\"}]},"
+    "{\"code\":\"asthma\"}]},"
+    "{\"code\":\"symptom\"}]}]}";
+
+static const char* g_filtered_value_sets[] = {
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/disorders\",\"version\":\"1\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"descendent-of\",\"value\":\"disorder\"}]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/disorders\",\"version\":\"2\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"is-a\",\"value\":\"disorder\"}]}],"
+    "\"exclude\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"is-a\",\"value\":\"diabetes\"}]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/not-diabetes-disorders\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"is-not-a\",\"value\":\"diabetes\"}],"
+    "\"valueSet\":[\"http://example.org/vs/disorders|1\"]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/ancestors\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"generalizes\",\"value\":\"t2dm\"},"
+    "{\"property\":\"code\",\"op\":\"not-in\",\"value\":\"finding, t2dm\"}]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/regex\",\"compose\":{"
+    "\"include\":[{\"system\":\"http://example.org/sct\","
+    "\"filter\":[{\"property\":\"concept\",\"op\":\"regex\",\"value\":\"t.dm\"}]}]}}",
+
+    "{\"resourceType\":\"ValueSet\",\"url\":\"http://example.org/vs/cycle\",\"compose\":{"
+    "\"include\":[{\"valueSet\":[\"http://example.org/vs/cycle\"]}]}}"
+};
+
+static FHIRTerminologyIndex* build_hierarchy_index(void) {
+    FHIRTerminologyIndex* index = fhir_terminology_index_create();
+    if (!index || !add_json(index, g_hierarchy, fhir_terminology_add_code_system_json)) {
+        fhir_terminology_index_destroy(index);
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(g_filtered_value_sets) / sizeof(g_filtered_value_sets[0]); i++) {
+        if (!add_json(index, g_filtered_value_sets[i], fhir_terminology_add_value_set_json)) {
+            fhir_terminology_index_destroy(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+static bool check_expansion(const FHIRTerminologyIndex* index, const char* value_set,
+                            const char* expected) {
+    size_t concepts[16];
+    size_t count;
+    ASSERT_TRUE(fhir_terminology_expand(index, value_set, concepts, 16, &count));
+
+    char codes[128] = "";
+    for (size_t i = 0; i < count && i < 16; i++) {
+        if (i > 0) strcat(codes, ",");
+        strcat(codes, fhir_terminology_get_concept(index, concepts[i])->code);
+    }
+    ASSERT_STR_EQ(expected, codes);
+    return true;
+}
+
+bool test_terminology_filters(void) {
+    FHIRTerminologyIndex* index = build_hierarchy_index();
+    ASSERT_NOT_NULL(index);
+
+    // Plain URLs resolve to the version added last
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/disorders|1", "diabetes,t1dm,t2dm,asthma"));
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/disorders|2", "disorder,asthma"));
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/disorders", "disorder,asthma"));
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/not-diabetes-disorders", "asthma"));
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/ancestors", "disorder,diabetes"));
+
+    const char* sct = "http://example.org/sct";
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/disorders|1", sct, "t1dm"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/disorders", sct, "t1dm"));
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/disorders|3", sct, "asthma"));
+
+    // Unsupported filters and import cycles fail instead of matching nothing
+    ASSERT_FALSE(fhir_terminology_expand(index, "http://example.org/vs/regex", NULL, 0, NULL));
+    ASSERT_EQ(FHIR_ERROR_VALIDATION_FAILED, fhir_get_last_error()->code);
+    ASSERT_FALSE(fhir_terminology_value_set_contains(index, "http://example.org/vs/regex", sct, "t1dm"));
+    ASSERT_FALSE(fhir_terminology_expand(index, "http://example.org/vs/cycle", NULL, 0, NULL));
+    ASSERT_FALSE(fhir_terminology_expand(index, "http://example.org/vs/unknown", NULL, 0, NULL));
+
+    FHIRTerminologyStats stats;
+    fhir_terminology_index_get_stats(index, &stats);
+    ASSERT_EQ(7, stats.concept_count);
+    ASSERT_EQ(6, stats.value_set_count);
+    ASSERT_EQ(4, stats.expansion_count);
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+bool test_terminology_expansion_invalidation(void) {
+    FHIRTerminologyIndex* index = build_hierarchy_index();
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(add_json(index, g_code_system, fhir_terminology_add_code_system_json));
+    ASSERT_TRUE(add_json(index, g_value_sets[1], fhir_terminology_add_value_set_json));
+
+    size_t count;
+    ASSERT_TRUE(fhir_terminology_expand(index, "http://example.org/vs/disorders|1", NULL, 0, &count));
+    ASSERT_EQ(4, count);
+    ASSERT_TRUE(fhir_terminology_expand(index, "http://example.org/vs/all", NULL, 0, &count));
+    ASSERT_EQ(3, count);
+
+    FHIRTerminologyStats stats;
+    fhir_terminology_index_get_stats(index, &stats);
+    ASSERT_EQ(2, stats.expansion_count);
+
+    // A concept of another code system keeps the hierarchy expansion cached
+    ASSERT_NE(FHIR_TERMINOLOGY_NO_PARENT,
+              fhir_terminology_add_concept(index, "http://example.org/cs", "C", NULL, FHIR_TERMINOLOGY_NO_PARENT));
+    fhir_terminology_index_get_stats(index, &stats);
+    ASSERT_EQ(1, stats.expansion_count);
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/all", "http://example.org/cs", "C"));
+
+    // A new disorder invalidates and shows up in the recomputed expansion
+    const FHIRTerminologyConcept* disorder = fhir_terminology_find_concept(index, "http://example.org/sct", "disorder");
+    ASSERT_NOT_NULL(disorder);
+    size_t disorder_index = (size_t)(disorder - fhir_terminology_get_concept(index, 0));
+    ASSERT_NE(FHIR_TERMINOLOGY_NO_PARENT,
+              fhir_terminology_add_concept(index, "http://example.org/sct", "copd", NULL, disorder_index));
+    fhir_terminology_index_get_stats(index, &stats);
+    ASSERT_EQ(1, stats.expansion_count);
+    ASSERT_TRUE(fhir_terminology_value_set_contains(index, "http://example.org/vs/disorders|1",
+                                                    "http://example.org/sct", "copd"));
+    ASSERT_TRUE(check_expansion(index, "http://example.org/vs/disorders|1", "diabetes,t1dm,t2dm,asthma,copd"));
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+bool test_terminology_expansion_save_load(void) {
+    char path[] = "/tmp/fhir_terminology_test_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    FHIRTerminologyIndex* index = build_hierarchy_index();
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(fhir_terminology_index_save(index, path));
+    fhir_terminology_index_destroy(index);
+
+    FHIRTerminologyIndex* loaded = fhir_terminology_index_load(path);
+    remove(path);
+    ASSERT_NOT_NULL(loaded);
+    ASSERT_TRUE(check_expansion(loaded, "http://example.org/vs/disorders|1", "diabetes,t1dm,t2dm,asthma"));
+    ASSERT_TRUE(check_expansion(loaded, "http://example.org/vs/disorders", "disorder,asthma"));
+    ASSERT_TRUE(check_expansion(loaded, "http://example.org/vs/not-diabetes-disorders", "asthma"));
+    ASSERT_TRUE(check_expansion(loaded, "http://example.org/vs/ancestors", "disorder,diabetes"));
+    fhir_terminology_index_destroy(loaded);
+    return true;
+}
+
+/* ========================================================================== */
+/* Concurrency Tests                                                          */
+/* ========================================================================== */
+
+typedef struct {
+    const FHIRTerminologyIndex* index;
+    pthread_barrier_t* start;
+    bool valid;
+} TerminologyContext;
+
+static void* lookup_worker(void* arg) {
+    TerminologyContext* context = arg;
+    pthread_barrier_wait(context->start);
+
+    // The first calls race to compute the same expansions
+    context->valid = true;
+    for (int i = 0; i < 2000 && context->valid; i++) {
+        context->valid = check_index(context->index) &&
+                         fhir_terminology_value_set_contains(context->index, "http://example.org/vs/disorders|1",
+                                                             "http://example.org/sct", "t2dm") &&
+                         !fhir_terminology_value_set_contains(context->index, "http://example.org/vs/disorders",
+                                                              "http://example.org/sct", "t2dm");
+    }
+    return NULL;
+}
+
+bool test_terminology_concurrent_lookups(void) {
+    FHIRTerminologyIndex* index = build_index();
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(add_json(index, g_hierarchy, fhir_terminology_add_code_system_json));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(add_json(index, g_filtered_value_sets[i], fhir_terminology_add_value_set_json));
+    }
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, TERMINOLOGY_THREADS);
+    pthread_t threads[TERMINOLOGY_THREADS];
+    TerminologyContext contexts[TERMINOLOGY_THREADS];
+
+    for (int i = 0; i < TERMINOLOGY_THREADS; i++) {
+        contexts[i] = (TerminologyContext){ .index = index, .start = &start };
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, lookup_worker, &contexts[i]));
+    }
+    for (int i = 0; i < TERMINOLOGY_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&start);
+
+    for (int i = 0; i < TERMINOLOGY_THREADS; i++) {
+        ASSERT_TRUE(contexts[i].valid);
+    }
+
+    fhir_terminology_index_destroy(index);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_terminology_lookups);
+    RUN_TEST(test_terminology_add_concept);
+    RUN_TEST(test_terminology_invalid_resources);
+    RUN_TEST(test_terminology_save_load);
+    RUN_TEST(test_terminology_filters);
+    RUN_TEST(test_terminology_expansion_invalidation);
+    RUN_TEST(test_terminology_expansion_save_load);
+    RUN_TEST(test_terminology_concurrent_lookups);
+
+    TEST_FINALIZE();
+}
@@ -1,6 +1,9 @@
 """Tests for FHIR R5 Terminology resources with C extensions."""
 
+import base64
 import json
+import os
+import tempfile
 import pytest
 from fast_fhir.terminology import (
     FHIRCodeSystem, FHIRValueSet, FHIRConceptMap, FHIRBinary, FHIRBundle,
@@ -252,6 +255,53 @@ class TestFHIRBinary:
         assert binary.content_type == "application/pdf"
         assert binary.data is not None
 
+    def test_binary_data_bytes(self):
+        """Test lazy and eager decoding of Binary.data."""
+        payload = bytes(range(256)) * 40
+        encoded = base64.b64encode(payload).decode("ascii")
+        source = json.dumps({"resourceType": "Binary", "id": "b1",
+                             "contentType": "application/octet-stream", "data": encoded})
+
+        for decode_data in (False, True):
+            binary = FHIRBinary.from_json(source.encode("utf-8"), decode_data=decode_data)
+            assert binary.id == "b1"
+            assert binary.content_type == "application/octet-stream"
+            assert isinstance(binary.data_bytes(), memoryview)
+            assert bytes(binary.data_bytes()) == payload
+            assert binary.data == encoded
+
+        binary.data = "Zm9v"
+        assert bytes(binary.data_bytes()) == b"foo"
+
+    def test_binary_base64_c(self):
+        """Test the C base64 codec and member-span Binary parser."""
+        fhir_foundation_c = pytest.importorskip("fhir_foundation_c")
+        if not hasattr(fhir_foundation_c, "parse_binary"):
+            pytest.skip("parse_binary not available")
+
+        payload = bytes(range(256)) * 40
+        encoded = base64.b64encode(payload).decode("ascii")
+        assert fhir_foundation_c.base64_encode(payload) == encoded
+        assert bytes(fhir_foundation_c.base64_decode(encoded)) == payload
+
+        out = bytearray(16)
+        assert fhir_foundation_c.base64_decode(b"xxZm9vYg==yy", out, slice(2, 10)) == 4
+        assert out[:4] == b"foob"
+        with pytest.raises(ValueError):
+            fhir_foundation_c.base64_decode("Zm9")
+
+        # Attachment with an escaped newline in the payload
+        source = '{"contentType":"text/plain","data":"aGVs\\nbG8=","size":5}'
+        fields = fhir_foundation_c.parse_binary(source)
+        assert fields["contentType"] == "text/plain"
+        assert fields["size"] == 5
+        assert bytes(fields["data"]) == b"hello"
+
+        span = fhir_foundation_c.parse_binary(source, False)["data"]
+        assert source.encode()[span] == b"aGVs\\nbG8="
+        with pytest.raises(ValueError):
+            fhir_foundation_c.parse_binary('{"data":"Zg=="')
+
 
 class TestFHIRBundle:
     """Test FHIR Bundle resource."""
@@ -360,6 +410,57 @@ class TestFHIRBundle:
         
         organizations = bundle.get_resources_by_type("Organization")
         assert len(organizations) == 0
+    
+    def test_bundle_resolve(self):
+        """Test resolving fullUrl, type/id and versioned references."""
+        bundle = FHIRBundle.from_dict({
+            "resourceType": "Bundle",
+            "type": "transaction",
+            "entry": [
+                {"fullUrl": "urn:uuid:61ebe359-bfdc-4613-8bf2-c5e300945f0a",
+                 "resource": {"resourceType": "Patient", "id": "1"}},
+                {"fullUrl": "http://example.org/fhir/Observation/2",
+                 "resource": {"resourceType": "Observation", "id": "2"}},
+                {"resource": {"resourceType": "Patient", "id": "1"}}
+            ]
+        })
+        
+        assert bundle.resolve("urn:uuid:61ebe359-bfdc-4613-8bf2-c5e300945f0a") is bundle.entry[0]
+        assert bundle.resolve("http://example.org/fhir/Observation/2") is bundle.entry[1]
+        assert bundle.resolve("Observation/2") is bundle.entry[1]
+        assert bundle.resolve("Patient/1") is bundle.entry[0]
+        assert bundle.resolve("Patient/1/_history/3") is bundle.entry[0]
+        assert bundle.resolve("Patient/9") is None
+        assert bundle.resolve("#1") is None
+        assert bundle.resolve("urn:uuid:unknown") is None
+        
+        bundle.add_entry({"resourceType": "Practitioner", "id": "5"}, "urn:uuid:p5")
+        assert bundle.resolve("urn:uuid:p5") is bundle.entry[3]
+        assert bundle.resolve("Practitioner/5") is bundle.entry[3]
+        
+        bundle.entry = [{"resource": {"resourceType": "Device", "id": "d"}}]
+        assert bundle.resolve("Device/d") is bundle.entry[0]
+        assert bundle.resolve("Patient/1") is None
+    
+    def test_bundle_resolve_large_transaction(self):
+        """Test resolving every reference of a 50k-entry transaction bundle."""
+        count = 50000
+        entries = []
+        for i in range(count):
+            entries.append({
+                "fullUrl": "urn:uuid:%08d" % i,
+                "resource": {
+                    "resourceType": "Observation",
+                    "id": "o%d" % i,
+                    "subject": {"reference": "urn:uuid:%08d" % ((i + 1) % count)}
+                }
+            })
+        bundle = FHIRBundle.from_dict({"resourceType": "Bundle", "type": "transaction", "entry": entries})
+        
+        for i, entry in enumerate(bundle.entry):
+            target = bundle.resolve(entry["resource"]["subject"]["reference"])
+            assert target is bundle.entry[(i + 1) % count]
+        assert bundle.resolve("Observation/o%d" % (count - 1)) is bundle.entry[-1]
 
 
 class TestTerminologyUtilities:
@@ -408,4 +509,104 @@ class TestCExtensionIntegration:
         result = bundle.to_dict()
         assert result["resourceType"] == "Bundle"
         assert result["id"] == "fallback-bundle"
-        assert result["type"] == "collection"
\ No newline at end of file
+        assert result["type"] == "collection"
+
+class TestCompiledTerminologyIndex:
+    """Test the C terminology index (fast_fhir.fhir_terminology_c)."""
+
+    CODE_SYSTEM = {
+        "resourceType": "CodeSystem",
+        "url": "http://example.org/cs",
+        "concept": [
+            {"code": "A", "display": "Alpha", "concept": [{"code": "A1", "display": "Alpha one"}]},
+            {"code": "B", "display": "Beta"}
+        ]
+    }
+    VALUE_SET = {
+        "resourceType": "ValueSet",
+        "url": "http://example.org/vs",
+        "compose": {
+            "include": [{"system": "http://example.org/cs"}],
+            "exclude": [{"system": "http://example.org/cs", "concept": [{"code": "B"}]}]
+        }
+    }
+    CONCEPT_MAP = {
+        "resourceType": "ConceptMap",
+        "url": "http://example.org/cm",
+        "group": [{
+            "source": "http://example.org/cs",
+            "target": "http://snomed.info/sct",
+            "element": [{"code": "A", "target": [{"code": "100", "equivalence": "equivalent"}]}]
+        }]
+    }
+
+    def _build(self):
+        fhir_terminology_c = pytest.importorskip("fast_fhir.fhir_terminology_c")
+        index = fhir_terminology_c.TerminologyIndex()
+        index.add_code_system(json.dumps(self.CODE_SYSTEM))
+        index.add_value_set(json.dumps(self.VALUE_SET))
+        index.add_concept_map(json.dumps(self.CONCEPT_MAP))
+        return fhir_terminology_c, index
+
+    def _check(self, index):
+        assert index.lookup_display("http://example.org/cs", "A1") == "Alpha one"
+        assert index.lookup_display("http://example.org/cs", "Z") is None
+        assert index.contains_code("http://example.org/vs", "http://example.org/cs", "A1")
+        assert not index.contains_code("http://example.org/vs", "http://example.org/cs", "B")
+
+        targets = index.translate("http://example.org/cs", "A")
+        assert targets == [{
+            "concept_map": "http://example.org/cm",
+            "system": "http://snomed.info/sct",
+            "code": "100",
+            "display": None,
+            "equivalence": "equivalent"
+        }]
+        assert index.translate("http://example.org/cs", "A", concept_map="http://other.org/cm") == []
+
+    def test_lookups(self):
+        _, index = self._build()
+        self._check(index)
+        assert index.stats()["concepts"] == 3
+        assert index.stats()["value_set_rules"] == 2
+        assert index.stats()["translations"] == 1
+
+    def test_expand_with_filters(self):
+        _, index = self._build()
+        index.add_value_set(json.dumps({
+            "resourceType": "ValueSet",
+            "url": "http://example.org/vs/alpha",
+            "version": "1.0",
+            "compose": {"include": [{
+                "system": "http://example.org/cs",
+                "filter": [{"property": "concept", "op": "is-a", "value": "A"}]
+            }]}
+        }))
+
+        assert index.expand("http://example.org/vs/alpha|1.0") == [
+            ("http://example.org/cs", "A"), ("http://example.org/cs", "A1")
+        ]
+        assert index.expand("http://example.org/vs") == [
+            ("http://example.org/cs", "A"), ("http://example.org/cs", "A1")
+        ]
+        assert index.contains_code("http://example.org/vs/alpha", "http://example.org/cs", "A1")
+        assert index.stats()["expansions"] == 2
+        with pytest.raises(ValueError):
+            index.expand("http://example.org/vs/missing")
+
+    def test_save_and_load(self):
+        fhir_terminology_c, index = self._build()
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "terminology.idx")
+            index.save(path)
+            self._check(fhir_terminology_c.TerminologyIndex.load(path))
+
+            with pytest.raises(OSError):
+                fhir_terminology_c.TerminologyIndex.load(os.path.join(directory, "missing.idx"))
+
+    def test_invalid_resources(self):
+        fhir_terminology_c, index = self._build()
+        with pytest.raises(ValueError):
+            index.add_code_system("{not json")
+        with pytest.raises(ValueError):
+            index.add_value_set(json.dumps({"resourceType": "ValueSet"}))
@@ -0,0 +1,189 @@
+/**
+ * @file test_timeseries.c
+ * @brief Unit tests for the DeviceMetric time-series ring
+ * @version 0.1.0
+ * @date 2024-01-01
+ */
+
+#include "test_framework.h"
+#include "../fhir_timeseries.h"
+#include <string.h>
+
+static const char* HEART_RATE_METRIC_JSON =
+    "{\"resourceType\":\"DeviceMetric\",\"id\":\"hr\","
+    "\"type\":{\"coding\":[{\"system\":\"urn:iso:std:iso:11073:10101\",\"code\":\"147842\","
+    "\"display\":\"MDC_ECG_HEART_RATE\"}]},"
+    "\"unit\":{\"coding\":[{\"system\":\"urn:iso:std:iso:11073:10101\",\"code\":\"/min\"}]},"
+    "\"device\":{\"reference\":\"Device/monitor-1\"},\"category\":\"measurement\"}";
+
+#define SECOND INT64_C(1000000)
+#define ORIGIN (INT64_C(1709280000) * SECOND)
+
+static FHIRTimeSeries* heart_rate_series(size_t capacity) {
+    cJSON* json = cJSON_Parse(HEART_RATE_METRIC_JSON);
+    FHIRTimeSeries* series = fhir_timeseries_create_from_json(json, "Patient/1", capacity);
+    cJSON_Delete(json);
+    return series;
+}
+
+/* ========================================================================== */
+/* Ring Tests                                                                 */
+/* ========================================================================== */
+
+bool test_timeseries_ring(void) {
+    FHIRTimeSeries* series = heart_rate_series(4);
+    ASSERT_NOT_NULL(series);
+    ASSERT_STR_EQ("DeviceMetric/hr", fhir_timeseries_info(series)->metric);
+    ASSERT_STR_EQ("Device/monitor-1", fhir_timeseries_info(series)->device);
+    ASSERT_STR_EQ("/min", fhir_timeseries_info(series)->unit_code);
+    ASSERT_EQ(16, sizeof(FHIRTimeSeriesSample));
+
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(fhir_timeseries_push(series, ORIGIN + i * SECOND, 60.0 + i));
+    }
+    ASSERT_EQ(4, fhir_timeseries_count(series));
+    ASSERT_EQ(4, fhir_timeseries_pending(series));
+    ASSERT_EQ(2, fhir_timeseries_dropped(series));
+
+    FHIRTimeSeriesSample sample;
+    ASSERT_TRUE(fhir_timeseries_get(series, 0, &sample));
+    ASSERT_EQ(ORIGIN + 2 * SECOND, sample.timestamp);
+    ASSERT_TRUE(fhir_timeseries_get(series, 3, &sample));
+    ASSERT_TRUE(sample.value == 65.0);
+    ASSERT_FALSE(fhir_timeseries_get(series, 4, &sample));
+
+    // Out-of-order samples are rejected, equal timestamps are not
+    ASSERT_FALSE(fhir_timeseries_push(series, ORIGIN, 1.0));
+    ASSERT_EQ(FHIR_ERROR_INVALID_ARGUMENT, fhir_get_last_error()->code);
+    FHIRTimeSeriesSample batch[] = { { ORIGIN + 5 * SECOND, 70.0 }, { ORIGIN + 6 * SECOND, 71.0 }, { ORIGIN, 0.0 } };
+    ASSERT_EQ(2, fhir_timeseries_push_many(series, batch, 3));
+    ASSERT_EQ(4, fhir_timeseries_dropped(series));
+
+    cJSON* patient = cJSON_Parse("{\"resourceType\":\"Patient\",\"id\":\"p\"}");
+    ASSERT_NULL(fhir_timeseries_create_from_json(patient, NULL, 0));
+    ASSERT_EQ(FHIR_ERROR_INVALID_RESOURCE_TYPE, fhir_get_last_error()->code);
+    cJSON_Delete(patient);
+
+    fhir_timeseries_destroy(series);
+    return true;
+}
+
+/* ========================================================================== */
+/* Window Tests                                                               */
+/* ========================================================================== */
+
+bool test_timeseries_windows(void) {
+    FHIRTimeSeries* series = fhir_timeseries_create(NULL, 1000);
+    ASSERT_NOT_NULL(series);
+
+    // One sample every 100 ms for 150 s wraps the ring; values cycle 0..9
+    for (int i = 0; i < 1500; i++) {
+        ASSERT_TRUE(fhir_timeseries_push(series, ORIGIN + i * (SECOND / 10), (double)(i % 10)));
+    }
+
+    FHIRTimeSeriesStats stats;
+    ASSERT_TRUE(fhir_timeseries_stats(series, ORIGIN + 100 * SECOND, ORIGIN + 101 * SECOND, &stats));
+    ASSERT_EQ(10, stats.count);
+    ASSERT_TRUE(stats.min == 0.0 && stats.max == 9.0 && stats.mean == 4.5);
+    ASSERT_EQ(ORIGIN + 100 * SECOND, stats.first);
+
+    // Only the newest 1000 samples (from 50 s) are held
+    ASSERT_TRUE(fhir_timeseries_stats(series, ORIGIN, ORIGIN + 1000 * SECOND, &stats));
+    ASSERT_EQ(1000, stats.count);
+    ASSERT_EQ(ORIGIN + 50 * SECOND, stats.first);
+    ASSERT_TRUE(fhir_timeseries_stats(series, ORIGIN, ORIGIN + 50 * SECOND, &stats));
+    ASSERT_EQ(0, stats.count);
+
+    FHIRTimeSeriesBucket buckets[8];
+    size_t count = fhir_timeseries_downsample(series, ORIGIN + 145 * SECOND, ORIGIN + 200 * SECOND,
+                                              2 * SECOND, buckets, 8);
+    ASSERT_EQ(3, count);
+    ASSERT_EQ(ORIGIN + 145 * SECOND, buckets[0].start);
+    ASSERT_EQ(20, buckets[0].count);
+    ASSERT_EQ(10, buckets[2].count);
+    ASSERT_TRUE(buckets[2].mean == 4.5 && buckets[2].max == 9.0);
+    ASSERT_EQ(2, fhir_timeseries_downsample(series, ORIGIN, ORIGIN + 200 * SECOND, SECOND, buckets, 2));
+    ASSERT_EQ(0, fhir_timeseries_downsample(series, ORIGIN, ORIGIN + SECOND, 0, buckets, 8));
+
+    fhir_timeseries_destroy(series);
+    return true;
+}
+
+/* ========================================================================== */
+/* Flush Tests                                                                */
+/* ========================================================================== */
+
+static size_t count_lines(const char* text, size_t length) {
+    size_t lines = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\n') lines++;
+    }
+    return lines;
+}
+
+bool test_timeseries_flush(void) {
+    FHIRTimeSeries* series = heart_rate_series(16);
+    ASSERT_TRUE(fhir_timeseries_push(series, ORIGIN, 72.0));
+    ASSERT_TRUE(fhir_timeseries_push(series, ORIGIN + SECOND + 250000, 73.5));
+
+    FHIRWriter writer;
+    size_t written;
+    ASSERT_TRUE(fhir_writer_init_buffer(&writer, 0));
+    ASSERT_TRUE(fhir_timeseries_flush(series, FHIR_TIMESERIES_FLUSH_OBSERVATIONS, &writer, &written));
+    ASSERT_EQ(2, written);
+    ASSERT_EQ(0, fhir_timeseries_pending(series));
+    ASSERT_EQ(2, count_lines(writer.data, writer.length));
+
+    char* newline = memchr(writer.data, '\n', writer.length);
+    cJSON* first = cJSON_ParseWithLength(newline + 1, writer.length - (size_t)(newline + 1 - writer.data));
+    ASSERT_NOT_NULL(first);
+    ASSERT_STR_EQ("2024-03-01T08:00:01.250Z", cJSON_GetObjectItem(first, "effectiveDateTime")->valuestring);
+    ASSERT_STR_EQ("DeviceMetric/hr", cJSON_GetObjectItem(cJSON_GetObjectItem(first, "device"), "reference")->valuestring);
+    ASSERT_STR_EQ("Patient/1", cJSON_GetObjectItem(cJSON_GetObjectItem(first, "subject"), "reference")->valuestring);
+    cJSON* quantity = cJSON_GetObjectItem(first, "valueQuantity");
+    ASSERT_TRUE(cJSON_GetObjectItem(quantity, "value")->valuedouble == 73.5);
+    ASSERT_STR_EQ("http://unitsofmeasure.org", cJSON_GetObjectItem(quantity, "system")->valuestring);
+    cJSON_Delete(first);
+
+    // Already flushed samples are not written again
+    fhir_writer_reset(&writer);
+    ASSERT_TRUE(fhir_timeseries_flush(series, FHIR_TIMESERIES_FLUSH_OBSERVATIONS, &writer, &written));
+    ASSERT_EQ(0, written);
+    ASSERT_EQ(0, writer.length);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(fhir_timeseries_push(series, ORIGIN + (10 + i) * SECOND, 80.0 + i));
+    }
+    ASSERT_TRUE(fhir_timeseries_flush(series, FHIR_TIMESERIES_FLUSH_SAMPLED_DATA, &writer, &written));
+    ASSERT_EQ(1, written);
+    cJSON* batch = cJSON_ParseWithLength(writer.data, writer.length);
+    ASSERT_NOT_NULL(batch);
+    cJSON* period = cJSON_GetObjectItem(batch, "effectivePeriod");
+    ASSERT_STR_EQ("2024-03-01T08:00:10Z", cJSON_GetObjectItem(period, "start")->valuestring);
+    ASSERT_STR_EQ("2024-03-01T08:00:12Z", cJSON_GetObjectItem(period, "end")->valuestring);
+    cJSON* sampled = cJSON_GetObjectItem(batch, "valueSampledData");
+    ASSERT_STR_EQ("0 1000 2000", cJSON_GetObjectItem(sampled, "offsets")->valuestring);
+    ASSERT_STR_EQ("80 81 82", cJSON_GetObjectItem(sampled, "data")->valuestring);
+    ASSERT_STR_EQ("ms", cJSON_GetObjectItem(sampled, "intervalUnit")->valuestring);
+    cJSON_Delete(batch);
+
+    // The flushed samples stay available to window queries
+    FHIRTimeSeriesStats stats;
+    ASSERT_TRUE(fhir_timeseries_stats(series, ORIGIN, ORIGIN + 60 * SECOND, &stats));
+    ASSERT_EQ(5, stats.count);
+
+    fhir_writer_cleanup(&writer);
+    fhir_timeseries_destroy(series);
+    return true;
+}
+
+int main(void) {
+    TEST_INIT();
+
+    RUN_TEST(test_timeseries_ring);
+    RUN_TEST(test_timeseries_windows);
+    RUN_TEST(test_timeseries_flush);
+
+    TEST_FINALIZE();
+    return 0;
+}
@@ -0,0 +1,56 @@
+"""Tests for time series buffers with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestTimeSeries:
+    """Test cases for time series buffers."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_timeseries(self):
+        """Test DeviceMetric sample buffering and Observation flushing."""
+        pytest.importorskip("fast_fhir.fhir_timeseries_c")
+        
+        metric = {"resourceType": "DeviceMetric", "id": "hr",
+                  "type": {"coding": [{"system": "urn:iso:std:iso:11073:10101", "code": "147842"}]},
+                  "unit": {"coding": [{"code": "/min"}]}, "category": "measurement"}
+        series = self.parser.create_timeseries(metric, "Patient/1", capacity=100)
+        assert series.capacity == 100
+        
+        origin = 1709280000000
+        series.extend([(origin + i * 1000, 60 + i % 5) for i in range(120)])
+        series.push("2024-03-01T08:02:00Z", 90)
+        assert len(series) == 100
+        assert series.pending == 100
+        assert series.dropped == 21
+        
+        stats = series.stats(origin + 100000, origin + 110000)
+        assert stats["count"] == 10
+        assert (stats["min"], stats["max"], stats["mean"]) == (60, 64, 62)
+        assert stats["first"] == origin + 100000
+        assert series.stats(None, origin)["count"] == 0
+        assert series.downsample(origin + 110000, origin + 125000, 5000)[0] == (origin + 110000, 5, 60, 64, 62)
+        
+        lines = series.flush().splitlines()
+        assert len(lines) == 100
+        last = json.loads(lines[-1])
+        assert last["effectiveDateTime"] == "2024-03-01T08:02:00Z"
+        assert last["device"] == {"reference": "DeviceMetric/hr"}
+        assert last["valueQuantity"]["value"] == 90
+        assert series.pending == 0 and series.flush() == ""
+        
+        series.push(origin + 121000, 70.5)
+        series.push(origin + 121500, 71)
+        sampled = json.loads(series.flush(sampled=True))
+        assert sampled["valueSampledData"]["offsets"] == "0 500"
+        assert sampled["valueSampledData"]["data"] == "70.5 71"
+        
+        with pytest.raises(ValueError):
+            series.push(origin, 1)
+        with pytest.raises(ValueError):
+            self.parser.create_timeseries({"resourceType": "Patient", "id": "p"})
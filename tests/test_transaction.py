@@ -0,0 +1,59 @@
+"""Tests for transaction Bundle processing with C extensions."""
+
+import json
+import pytest
+from fast_fhir.fast_parser import FastFHIRParser
+
+
+class TestTransaction:
+    """Test cases for transaction scheduling."""
+    
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.parser = FastFHIRParser()
+    
+    def test_process_transaction(self):
+        """Test dependency-ordered transaction entries with reference rewriting."""
+        fhir_transaction_c = pytest.importorskip("fast_fhir.fhir_transaction_c")
+        import threading
+
+        bundle = {"resourceType": "Bundle", "type": "transaction", "entry": [
+            {"fullUrl": "urn:uuid:o1",
+             "resource": {"resourceType": "Observation", "subject": {"reference": "urn:uuid:p1"}},
+             "request": {"method": "POST", "url": "Observation"}},
+            {"fullUrl": "urn:uuid:p1", "resource": {"resourceType": "Patient"},
+             "request": {"method": "POST", "url": "Patient"}},
+            {"request": {"method": "DELETE", "url": "Patient/old"}},
+        ]}
+        lock = threading.Lock()
+        order = []
+
+        def handle(entry):
+            with lock:
+                order.append(entry["index"])
+            if entry["method"] == "DELETE":
+                return None
+            if entry["index"] == 0:
+                assert entry["resource"]["subject"]["reference"] == "Patient/p1"
+            return 201, f"{entry['url']}/{entry['resource']['resourceType'][0].lower()}1/_history/1"
+
+        outcomes = fhir_transaction_c.process_transaction(json.dumps(bundle), handle, threads=4)
+        assert [outcome["state"] for outcome in outcomes] == ["done"] * 3
+        assert order.index(1) < order.index(0)
+        assert outcomes[0]["rewrites"] == [("urn:uuid:p1", "Patient/p1")]
+        assert outcomes[1]["status"] == 201 and outcomes[1]["location"] == "Patient/p1/_history/1"
+        assert outcomes[2]["status"] is None
+
+        # A failing callback aborts the rest of a transaction
+        def reject(entry):
+            raise RuntimeError("rejected")
+
+        outcomes = fhir_transaction_c.process_transaction(json.dumps(bundle), reject, threads=1)
+        assert "failed" in [outcome["state"] for outcome in outcomes]
+        assert all(outcome["state"] != "done" for outcome in outcomes)
+        assert any(outcome["error"] == "rejected" for outcome in outcomes)
+
+        with pytest.raises(ValueError):
+            fhir_transaction_c.process_transaction('{"resourceType": "Bundle", "type": "collection"}', handle)
+        with pytest.raises(TypeError):
+            fhir_transaction_c.process_transaction(json.dumps(bundle), None)